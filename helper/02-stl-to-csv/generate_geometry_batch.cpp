@@ -0,0 +1,376 @@
+#include "pipe_mesh.h"
+#include "GeometryFile.h"
+#include "ParallelLoop.h"
+#include <iomanip>
+#include <sstream>
+#include <mutex>
+#include <thread>
+#include <algorithm>
+
+/**
+ * 一个参数的取值网格
+ *
+ * 命令行中的取值可以写成单个值 "0.8"、列表 "0.6,0.8,1.0"
+ * 或者 "起始:结束:个数" 形式的等间距范围 "0.6:1.0:5"。
+ */
+struct parameter_grid {
+    std::string name;
+    std::vector<double> values;
+};
+
+/**
+ * 解析一个参数的取值
+ *
+ * @param text 命令行中的取值
+ * @param values 解析得到的取值
+ * @return 成功返回true，失败返回false
+ */
+bool parse_grid_values(const std::string& text, std::vector<double>& values) {
+    values.clear();
+    try {
+        std::size_t first_colon = text.find(':');
+        if (first_colon != std::string::npos) {
+            std::size_t second_colon = text.find(':', first_colon + 1);
+            if (second_colon == std::string::npos) {
+                return false;
+            }
+            double start = std::stod(text.substr(0, first_colon));
+            double stop = std::stod(text.substr(first_colon + 1, second_colon - first_colon - 1));
+            int count = std::stoi(text.substr(second_colon + 1));
+            if (count < 1) {
+                return false;
+            }
+            for (int i = 0; i < count; ++i) {
+                values.push_back(count == 1 ? start : start + (stop - start) * i / (count - 1));
+            }
+        } else {
+            std::stringstream stream(text);
+            std::string item;
+            while (std::getline(stream, item, ',')) {
+                values.push_back(std::stod(item));
+            }
+        }
+    } catch (const std::exception&) {
+        return false;
+    }
+    return !values.empty();
+}
+
+/**
+ * 将截面转换为声学仿真使用的轮廓
+ *
+ * 管道路径位于XY平面（矢状面）内，Z轴为横向。轮廓的局部坐标为
+ * (横向坐标, 沿中心线法线的坐标)，中心线法线为切线逆时针旋转90度。
+ * 所有截面的缩放因子为1，表面索引为0。
+ *
+ * @param sections 沿管道路径的截面
+ * @param geo 轮廓、中心线和法线数组
+ */
+void sections_to_geometry(const std::vector<pipe_section>& sections, geometryArrays& geo) {
+    geo = geometryArrays();
+    geo.simplified = false;
+    geo.contourOffsets.push_back(0);
+
+    for (const pipe_section& section : sections) {
+        double length = std::sqrt(section.normal.x() * section.normal.x() +
+            section.normal.y() * section.normal.y());
+        double nx = -section.normal.y() / length + 0.0;
+        double ny = section.normal.x() / length + 0.0;
+
+        geo.centerLine.push_back(section.center.x());
+        geo.centerLine.push_back(section.center.y());
+        geo.normals.push_back(nx);
+        geo.normals.push_back(ny);
+        geo.scalingFactors.push_back(1.0);
+        geo.scalingFactors.push_back(1.0);
+
+        // 投影内圆环，并保证轮廓为逆时针方向
+        std::vector<double> x, y;
+        double area = 0.0;
+        for (const Point& p : section.inner) {
+            Vector d = p - section.center;
+            x.push_back(d.z());
+            y.push_back(d.x() * nx + d.y() * ny);
+        }
+        for (std::size_t j = 0; j < x.size(); ++j) {
+            std::size_t next = (j + 1) % x.size();
+            area += x[j] * y[next] - x[next] * y[j];
+        }
+        for (std::size_t j = 0; j < x.size(); ++j) {
+            std::size_t k = (area >= 0.0) ? j : x.size() - 1 - j;
+            geo.points.push_back(x[k]);
+            geo.points.push_back(y[k]);
+            geo.surfaceIdx.push_back(0);
+        }
+        geo.contourOffsets.push_back(static_cast<uint32_t>(geo.points.size() / 2));
+    }
+}
+
+/**
+ * 将轮廓写入分号分隔的csv几何文件
+ *
+ * 每个截面占两行：第一行为x分量，第二行为y分量，依次为中心线点、
+ * 法线、缩放因子和轮廓点。
+ *
+ * @param geo 轮廓、中心线和法线数组
+ * @param output_filename 输出文件名
+ * @return 成功返回true，失败返回false
+ */
+bool write_geometry_csv(const geometryArrays& geo, const std::string& output_filename) {
+    std::ofstream out(output_filename);
+    if (!out) {
+        return false;
+    }
+    out << std::setprecision(10);
+
+    for (std::size_t i = 0; i + 1 < geo.contourOffsets.size(); ++i) {
+        std::ostringstream line_x, line_y;
+        line_x << std::setprecision(10);
+        line_y << std::setprecision(10);
+        line_x << geo.centerLine[2 * i] << ';' << geo.normals[2 * i] << ';' << geo.scalingFactors[2 * i];
+        line_y << geo.centerLine[2 * i + 1] << ';' << geo.normals[2 * i + 1] << ';' << geo.scalingFactors[2 * i + 1];
+        for (uint32_t j = geo.contourOffsets[i]; j < geo.contourOffsets[i + 1]; ++j) {
+            line_x << ';' << geo.points[2 * j];
+            line_y << ';' << geo.points[2 * j + 1];
+        }
+        out << line_x.str() << '\n' << line_y.str() << '\n';
+    }
+
+    out.close();
+    return !out.fail();
+}
+
+/**
+ * 打印使用说明
+ */
+void print_usage() {
+    std::cout <<
+        "用法: generate_geometry_batch --type elbow|cylinder [参数网格] [选项]\n"
+        "\n"
+        "参数取值可以是单个值、逗号分隔的列表或 起始:结束:个数 形式的范围，\n"
+        "程序为所有取值的组合各生成一个几何。\n"
+        "\n"
+        "弯管参数 (--type elbow):\n"
+        "  --start-inner, --start-outer, --end-inner, --bend-radius,\n"
+        "  --arc-sections, --radial-sections\n"
+        "圆柱体参数 (--type cylinder):\n"
+        "  --inner, --outer, --height, --sections, --axial-sections\n"
+        "\n"
+        "选项:\n"
+        "  --format <列表>      输出格式 stl,geo,csv 的逗号分隔列表（默认：stl）\n"
+        "  --output-dir <目录>  输出目录（必须已存在，默认：当前目录）\n"
+        "  --prefix <名称>      输出文件名前缀（默认：几何类型）\n"
+        "  --threads <个数>     线程数（默认：硬件线程数）\n"
+        "\n"
+        "管道路径位于XY平面内（圆柱体沿X轴，弯管从原点沿-Y方向弯曲），\n"
+        "与声学仿真的矢状面一致，Z轴为横向。输出目录中的 <前缀>_index.csv\n"
+        "列出每个文件对应的参数。" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::string type;
+    std::string output_dir = ".";
+    std::string prefix;
+    bool write_stl = false, write_geo = false, write_csv = false;
+    int num_threads = static_cast<int>(std::thread::hardware_concurrency());
+
+    // 各参数的默认取值，与单个几何的生成程序相同
+    std::vector<parameter_grid> elbow_grid = {
+        {"start-inner", {0.8}}, {"start-outer", {1.0}}, {"end-inner", {0.5}},
+        {"bend-radius", {4.0}}, {"arc-sections", {64}}, {"radial-sections", {48}}
+    };
+    std::vector<parameter_grid> cylinder_grid = {
+        {"inner", {0.8}}, {"outer", {1.0}}, {"height", {5.0}},
+        {"sections", {64}}, {"axial-sections", {16}}
+    };
+    std::vector<std::pair<std::string, std::string>> grid_args;
+
+    // 解析命令行参数
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            print_usage();
+            return 0;
+        }
+        if (arg.compare(0, 2, "--") != 0 || i + 1 >= argc) {
+            std::cerr << "错误：无法识别的参数 " << arg << std::endl;
+            print_usage();
+            return 1;
+        }
+        std::string value = argv[++i];
+        if (arg == "--type") {
+            type = value;
+        } else if (arg == "--output-dir") {
+            output_dir = value;
+        } else if (arg == "--prefix") {
+            prefix = value;
+        } else if (arg == "--threads") {
+            num_threads = std::stoi(value);
+        } else if (arg == "--format") {
+            std::stringstream stream(value);
+            std::string format;
+            while (std::getline(stream, format, ',')) {
+                if (format == "stl") {
+                    write_stl = true;
+                } else if (format == "geo") {
+                    write_geo = true;
+                } else if (format == "csv") {
+                    write_csv = true;
+                } else {
+                    std::cerr << "错误：未知的输出格式 " << format << std::endl;
+                    return 1;
+                }
+            }
+        } else {
+            grid_args.push_back(std::make_pair(arg.substr(2), value));
+        }
+    }
+
+    if (type != "elbow" && type != "cylinder") {
+        print_usage();
+        return 1;
+    }
+    if (!write_stl && !write_geo && !write_csv) {
+        write_stl = true;
+    }
+    if (prefix.empty()) {
+        prefix = type;
+    }
+    num_threads = std::max(1, num_threads);
+
+    // 设置参数网格
+    std::vector<parameter_grid>& grid = (type == "elbow") ? elbow_grid : cylinder_grid;
+    for (const auto& grid_arg : grid_args) {
+        auto it = std::find_if(grid.begin(), grid.end(),
+            [&](const parameter_grid& p) { return p.name == grid_arg.first; });
+        if (it == grid.end()) {
+            std::cerr << "错误：" << type << " 没有参数 --" << grid_arg.first << std::endl;
+            return 1;
+        }
+        if (!parse_grid_values(grid_arg.second, it->values)) {
+            std::cerr << "错误：无法解析 --" << grid_arg.first << " 的取值 " << grid_arg.second << std::endl;
+            return 1;
+        }
+    }
+
+    // 所有取值的组合数，第一个参数变化最慢
+    std::size_t num_variations = 1;
+    for (const parameter_grid& p : grid) {
+        num_variations *= p.values.size();
+    }
+    std::cout << "生成 " << num_variations << " 个" << (type == "elbow" ? "弯管" : "圆柱体")
+              << "，使用 " << num_threads << " 个线程" << std::endl;
+
+    std::vector<std::vector<double>> parameters(num_variations);
+    std::vector<std::string> names(num_variations);
+    std::vector<std::string> status(num_variations);
+    for (std::size_t n = 0; n < num_variations; ++n) {
+        std::size_t rest = n;
+        parameters[n].resize(grid.size());
+        for (std::size_t k = grid.size(); k-- > 0;) {
+            parameters[n][k] = grid[k].values[rest % grid[k].values.size()];
+            rest /= grid[k].values.size();
+        }
+        std::ostringstream name;
+        name << prefix << '_' << std::setw(4) << std::setfill('0') << n;
+        names[n] = name.str();
+    }
+
+    std::mutex output_mutex;
+    parallelLoop(static_cast<int>(num_variations), num_threads, [&](int n) {
+        const std::vector<double>& p = parameters[n];
+        std::string error;
+        std::vector<pipe_section> sections;
+        std::vector<pipe_section> mesh_sections;
+
+        if (type == "elbow") {
+            double start_inner = p[0], start_outer = p[1], end_inner = p[2], bend_radius = p[3];
+            int arc_sections = static_cast<int>(p[4]), radial_sections = static_cast<int>(p[5]);
+            double end_outer = end_inner + (start_outer - start_inner);
+            if (start_inner <= 0 || end_inner <= 0 || start_inner >= start_outer) {
+                error = "内半径必须为正值且小于外半径";
+            } else if (bend_radius <= std::max(start_outer, end_outer)) {
+                error = "弯曲半径必须大于管道外半径";
+            } else if (arc_sections < 1 || radial_sections < 3) {
+                error = "分段数过小";
+            } else {
+                sections = tapered_elbow_sections(start_inner, start_outer, end_inner, end_outer,
+                    bend_radius, arc_sections, radial_sections);
+            }
+        } else {
+            double inner = p[0], outer = p[1], height = p[2];
+            int radial_sections = static_cast<int>(p[3]), axial_sections = static_cast<int>(p[4]);
+            Point center(height / 2.0, 0, 0);
+            Vector axis(1, 0, 0);
+            if (inner <= 0 || inner >= outer) {
+                error = "内半径必须为正值且小于外半径";
+            } else if (height <= 0) {
+                error = "高度必须为正值";
+            } else if (axial_sections < 1 || radial_sections < 3) {
+                error = "分段数过小";
+            } else {
+                sections = hollow_cylinder_sections(inner, outer, height, radial_sections,
+                    axial_sections, center, axis);
+                // 网格与单个圆柱体的生成程序相同，只需要两端的截面
+                mesh_sections = { sections.front(), sections.back() };
+            }
+        }
+
+        std::string base = output_dir + "/" + names[n];
+        if (error.empty() && write_stl) {
+            Mesh mesh = create_pipe_mesh(mesh_sections.empty() ? sections : mesh_sections);
+            if (!write_mesh_to_stl(mesh, base + ".stl")) {
+                error = "无法写入 " + base + ".stl";
+            }
+        }
+        if (error.empty() && (write_geo || write_csv)) {
+            geometryArrays geo;
+            sections_to_geometry(sections, geo);
+            if (write_geo && !writeGeometryFile(base + ".geo", geo)) {
+                error = "无法写入 " + base + ".geo";
+            } else if (write_csv && !write_geometry_csv(geo, base + ".csv")) {
+                error = "无法写入 " + base + ".csv";
+            }
+        }
+
+        status[n] = error.empty() ? "ok" : error;
+        if (!error.empty()) {
+            std::lock_guard<std::mutex> lock(output_mutex);
+            std::cerr << names[n] << ": " << error << std::endl;
+        }
+    }, [&](int done, int total) {
+        std::cout << "\r已完成 " << done << "/" << total << std::flush;
+        return true;
+    });
+    std::cout << std::endl;
+
+    // 写入参数索引文件
+    std::string index_filename = output_dir + "/" + prefix + "_index.csv";
+    std::ofstream index(index_filename);
+    if (!index) {
+        std::cerr << "无法创建索引文件: " << index_filename << std::endl;
+        return 1;
+    }
+    index << "name";
+    for (const parameter_grid& p : grid) {
+        index << ';' << p.name;
+    }
+    index << ";status\n";
+
+    std::size_t num_failed = 0;
+    for (std::size_t n = 0; n < num_variations; ++n) {
+        index << names[n];
+        for (double value : parameters[n]) {
+            index << ';' << value;
+        }
+        index << ';' << status[n] << '\n';
+        if (status[n] != "ok") {
+            num_failed++;
+        }
+    }
+    index.close();
+
+    std::cout << "成功生成 " << (num_variations - num_failed) << " 个几何，失败 "
+              << num_failed << " 个，参数见 '" << index_filename << "'" << std::endl;
+    return (num_failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,362 @@
+#ifndef PIPE_MESH_H
+#define PIPE_MESH_H
+
+#include <CGAL/Exact_predicates_inexact_constructions_kernel.h>
+#include <CGAL/Surface_mesh.h>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <fstream>
+#include <cstdint>
+
+typedef CGAL::Exact_predicates_inexact_constructions_kernel Kernel;
+typedef Kernel::Point_3 Point;
+typedef Kernel::Vector_3 Vector;
+typedef CGAL::Surface_mesh<Point> Mesh;
+
+/**
+ * 管道的一个截面：中心点、沿路径的法线以及内外圆环上的点
+ *
+ * 圆环上的点按 u*cos(theta) + v*sin(theta) 生成，其中 u x v 与法线同向，
+ * create_pipe_mesh 依此确定面的朝向。
+ */
+struct pipe_section {
+    Point center;
+    Vector normal;
+    std::vector<Point> inner;
+    std::vector<Point> outer;
+};
+
+/**
+ * 计算三个点定义的三角形的法向量
+ *
+ * @param p1 第一个点
+ * @param p2 第二个点
+ * @param p3 第三个点
+ * @return 法向量（已标准化）
+ */
+inline Vector compute_normal(const Point& p1, const Point& p2, const Point& p3) {
+    // 计算两个边向量
+    Vector v1(p2.x() - p1.x(), p2.y() - p1.y(), p2.z() - p1.z());
+    Vector v2(p3.x() - p1.x(), p3.y() - p1.y(), p3.z() - p1.z());
+
+    // 计算叉积
+    Vector normal(
+        v1.y() * v2.z() - v1.z() * v2.y(),
+        v1.z() * v2.x() - v1.x() * v2.z(),
+        v1.x() * v2.y() - v1.y() * v2.x()
+    );
+
+    // 标准化法向量
+    double length = std::sqrt(normal.squared_length());
+    if (length > 0) {
+        normal = normal / length;
+    }
+
+    return normal;
+}
+
+/**
+ * 在截面上生成内外圆环
+ *
+ * @param section 要填充的截面（中心和法线已设置）
+ * @param u 截面内的第一个单位向量
+ * @param v 截面内的第二个单位向量，u x v 与截面法线同向
+ * @param inner_radius 内半径
+ * @param outer_radius 外半径
+ * @param radial_sections 圆周上的分段数
+ */
+inline void fill_section_rings(
+    pipe_section& section,
+    const Vector& u,
+    const Vector& v,
+    double inner_radius,
+    double outer_radius,
+    int radial_sections
+) {
+    section.inner.clear();
+    section.outer.clear();
+    for (int j = 0; j < radial_sections; ++j) {
+        double theta = 2.0 * M_PI * j / radial_sections;
+        Vector circle_vec = u * std::cos(theta) + v * std::sin(theta);
+        section.inner.push_back(section.center + circle_vec * inner_radius);
+        section.outer.push_back(section.center + circle_vec * outer_radius);
+    }
+}
+
+/**
+ * 计算中空圆柱体沿轴向的截面
+ *
+ * @param inner_radius 内半径
+ * @param outer_radius 外半径
+ * @param height 高度
+ * @param sections 用于近似圆的段数
+ * @param axial_sections 沿轴向的分段数（网格只需要1段）
+ * @param center 圆柱体中心点
+ * @param axis 圆柱体轴向（从底面指向顶面）
+ * @return 从底面到顶面的 axial_sections + 1 个截面
+ */
+inline std::vector<pipe_section> hollow_cylinder_sections(
+    double inner_radius,
+    double outer_radius,
+    double height,
+    int sections,
+    int axial_sections,
+    const Point& center,
+    const Vector& axis
+) {
+    // 标准化轴向向量
+    Vector normalized_axis = axis / std::sqrt(axis.squared_length());
+
+    // 创建两个正交向量，与轴向垂直
+    Vector v1, v2;
+    if (std::abs(normalized_axis.x()) > std::abs(normalized_axis.y())) {
+        v1 = Vector(normalized_axis.z(), 0, -normalized_axis.x());
+    } else {
+        v1 = Vector(0, normalized_axis.z(), -normalized_axis.y());
+    }
+    v1 = v1 / std::sqrt(v1.squared_length());
+    v2 = CGAL::cross_product(normalized_axis, v1);
+
+    Point bottom_center = center - normalized_axis * (height / 2.0);
+
+    std::vector<pipe_section> result(axial_sections + 1);
+    for (int i = 0; i <= axial_sections; ++i) {
+        double ratio = static_cast<double>(i) / axial_sections;
+        result[i].center = bottom_center + normalized_axis * (height * ratio);
+        result[i].normal = normalized_axis;
+        fill_section_rings(result[i], v1, v2, inner_radius, outer_radius, sections);
+    }
+    return result;
+}
+
+/**
+ * 计算45度渐缩弯管沿圆弧的截面
+ *
+ * 截面垂直于弯管路径，由弯管平面内的径向和弯管平面法线张成。
+ *
+ * @param start_inner_radius 起始点的内半径
+ * @param start_outer_radius 起始点的外半径
+ * @param end_inner_radius 结束点的内半径
+ * @param end_outer_radius 结束点的外半径
+ * @param bend_radius 弯管中心线的弯曲半径
+ * @param sections 沿着圆弧方向的分段数
+ * @param radial_sections 沿着径向的分段数
+ * @param center 弯管中心点
+ * @param start_direction 弯管起始方向
+ * @param bend_plane_normal 弯管平面法线
+ * @return 从起始端到结束端的 sections + 1 个截面
+ */
+inline std::vector<pipe_section> tapered_elbow_sections(
+    double start_inner_radius,
+    double start_outer_radius,
+    double end_inner_radius,
+    double end_outer_radius,
+    double bend_radius,
+    int sections,
+    int radial_sections,
+    const Point& center = Point(0, 0, 0),
+    const Vector& start_direction = Vector(1, 0, 0),
+    const Vector& bend_plane_normal = Vector(0, 0, 1)
+) {
+    // 计算管壁厚度（应该在整个弯管中保持不变）
+    double wall_thickness = start_outer_radius - start_inner_radius;
+    double end_wall_thickness = end_outer_radius - end_inner_radius;
+
+    // 如果起始和结束的壁厚不一致，输出警告并使用起始壁厚
+    if (std::abs(wall_thickness - end_wall_thickness) > 1e-6) {
+        std::cerr << "警告：起始壁厚(" << wall_thickness << ")与结束壁厚("
+                  << end_wall_thickness << ")不一致，将使用起始壁厚。" << std::endl;
+    }
+
+    // 标准化向量
+    Vector norm_start_dir = start_direction / std::sqrt(start_direction.squared_length());
+    Vector norm_plane_normal = bend_plane_normal / std::sqrt(bend_plane_normal.squared_length());
+
+    // 确保平面法线与起始方向垂直（如果它们不是正交的）
+    double dot_product = norm_start_dir * norm_plane_normal;
+    if (std::abs(dot_product) > 1e-6) {
+        // 从平面法线中减去起始方向的分量，使它们正交
+        norm_plane_normal = norm_plane_normal - norm_start_dir * dot_product;
+        norm_plane_normal = norm_plane_normal / std::sqrt(norm_plane_normal.squared_length());
+    }
+
+    // 计算弯管平面的第二个方向向量（垂直于起始方向和平面法线）
+    Vector bend_dir = CGAL::cross_product(norm_plane_normal, norm_start_dir);
+    bend_dir = bend_dir / std::sqrt(bend_dir.squared_length());
+
+    // 计算弯管的控制点（圆心）
+    Point bend_center = center + norm_start_dir * bend_radius;
+
+    // 弯曲角度45度，以弧度表示
+    double total_angle = M_PI / 4.0;
+
+    std::vector<pipe_section> result(sections + 1);
+    for (int i = 0; i <= sections; ++i) {
+        // 计算当前角度和进度比例
+        double angle_ratio = static_cast<double>(i) / sections;
+        double angle = total_angle * angle_ratio;
+
+        // 计算内外半径，基于进度比例
+        double inner_radius = start_inner_radius + (end_inner_radius - start_inner_radius) * angle_ratio;
+        double outer_radius = inner_radius + wall_thickness;
+
+        // 计算当前截面中心点在弯管路径上的位置（从圆心指向截面中心的反方向）
+        Vector path_direction = norm_start_dir * std::cos(angle) + bend_dir * std::sin(angle);
+        result[i].center = bend_center - path_direction * bend_radius;
+
+        // 截面法线沿着路径的切线方向
+        result[i].normal = CGAL::cross_product(path_direction, norm_plane_normal);
+
+        // 截面由径向和平面法线张成，path_direction x plane_normal 即为切线方向
+        fill_section_rings(result[i], path_direction, norm_plane_normal,
+            inner_radius, outer_radius, radial_sections);
+    }
+
+    return result;
+}
+
+/**
+ * 用相邻截面的圆环构建中空管道网格
+ *
+ * 网格包括内外管壁以及两端的环形端面，所有面的法线都指向管壁外侧。
+ *
+ * @param sections 沿管道路径的截面（至少两个）
+ * @return 生成的管道网格
+ */
+inline Mesh create_pipe_mesh(const std::vector<pipe_section>& sections) {
+    Mesh pipe;
+
+    // 添加所有截面的顶点
+    std::vector<std::vector<Mesh::Vertex_index>> inner_vertices(sections.size());
+    std::vector<std::vector<Mesh::Vertex_index>> outer_vertices(sections.size());
+    for (std::size_t i = 0; i < sections.size(); ++i) {
+        for (std::size_t j = 0; j < sections[i].inner.size(); ++j) {
+            inner_vertices[i].push_back(pipe.add_vertex(sections[i].inner[j]));
+            outer_vertices[i].push_back(pipe.add_vertex(sections[i].outer[j]));
+        }
+    }
+    if (sections.size() < 2) {
+        return pipe;
+    }
+
+    const std::size_t last = sections.size() - 1;
+    const std::size_t radial_sections = inner_vertices[0].size();
+
+    // 创建起始端面和结束端面
+    for (std::size_t j = 0; j < radial_sections; ++j) {
+        std::size_t next = (j + 1) % radial_sections;
+        pipe.add_face(
+            inner_vertices[0][j],
+            inner_vertices[0][next],
+            outer_vertices[0][next],
+            outer_vertices[0][j]
+        );
+        pipe.add_face(
+            inner_vertices[last][j],
+            outer_vertices[last][j],
+            outer_vertices[last][next],
+            inner_vertices[last][next]
+        );
+    }
+
+    // 创建面：连接相邻截面之间的顶点形成四边形
+    for (std::size_t i = 0; i < last; ++i) {
+        for (std::size_t j = 0; j < radial_sections; ++j) {
+            std::size_t next = (j + 1) % radial_sections;
+
+            // 创建外侧面
+            pipe.add_face(
+                outer_vertices[i][j],
+                outer_vertices[i][next],
+                outer_vertices[i+1][next],
+                outer_vertices[i+1][j]
+            );
+
+            // 创建内侧面
+            pipe.add_face(
+                inner_vertices[i][j],
+                inner_vertices[i+1][j],
+                inner_vertices[i+1][next],
+                inner_vertices[i][next]
+            );
+        }
+    }
+
+    return pipe;
+}
+
+/**
+ * 写入一个二进制STL三角形（法向量、三个顶点和属性字节计数）
+ */
+inline void write_stl_triangle(std::ofstream& out, const Point& p1, const Point& p2, const Point& p3) {
+    Vector normal = compute_normal(p1, p2, p3);
+    float values[12] = {
+        static_cast<float>(normal.x()), static_cast<float>(normal.y()), static_cast<float>(normal.z()),
+        static_cast<float>(p1.x()), static_cast<float>(p1.y()), static_cast<float>(p1.z()),
+        static_cast<float>(p2.x()), static_cast<float>(p2.y()), static_cast<float>(p2.z()),
+        static_cast<float>(p3.x()), static_cast<float>(p3.y()), static_cast<float>(p3.z())
+    };
+    out.write(reinterpret_cast<const char*>(values), sizeof(values));
+
+    // 写入属性字节计数（通常为0）
+    uint16_t attribute_byte_count = 0;
+    out.write(reinterpret_cast<const char*>(&attribute_byte_count), 2);
+}
+
+/**
+ * 自定义STL写入函数（二进制格式），适用于CGAL 5.0.3
+ *
+ * @param mesh 要写入的网格
+ * @param output_filename 输出文件名
+ * @return 成功返回true，失败返回false
+ */
+inline bool write_mesh_to_stl(const Mesh& mesh, const std::string& output_filename) {
+    std::ofstream out(output_filename, std::ios::binary);
+    if (!out) {
+        std::cerr << "无法创建输出文件: " << output_filename << std::endl;
+        return false;
+    }
+
+    // STL二进制格式头部
+    const char header[80] = "STL generated by CGAL Surface_mesh";
+    out.write(header, 80);
+
+    // 计算要写入的三角形数量
+    // 注意：每个四边形需要拆分为两个三角形
+    uint32_t num_triangles = 0;
+    for (Mesh::Face_index f : mesh.faces()) {
+        int vertex_count = 0;
+        for (auto vd : CGAL::vertices_around_face(mesh.halfedge(f), mesh)) {
+            (void)vd; // 防止未使用警告
+            vertex_count++;
+        }
+        num_triangles += (vertex_count == 4) ? 2 : 1;
+    }
+    out.write(reinterpret_cast<const char*>(&num_triangles), 4);
+
+    // 写入每个三角形
+    std::vector<Point> vertices;
+    for (Mesh::Face_index f : mesh.faces()) {
+        vertices.clear();
+        for (Mesh::Vertex_index v : CGAL::vertices_around_face(mesh.halfedge(f), mesh)) {
+            vertices.push_back(mesh.point(v));
+        }
+
+        // 四边形拆分为 V0, V1, V2 和 V0, V2, V3 两个三角形
+        write_stl_triangle(out, vertices[0], vertices[1], vertices[2]);
+        if (vertices.size() == 4) {
+            write_stl_triangle(out, vertices[0], vertices[2], vertices[3]);
+        }
+    }
+
+    out.close();
+    if (!out) {
+        std::cerr << "导出STL文件失败: " << output_filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#endif // PIPE_MESH_H
@@ -21,8 +21,11 @@
 
 #include "Acoustic3dPage.h"
 #include "ParamSimu3DDialog.h"
+#include "GuiTimings.h"
 //#include "VocalTractDialog.h"
 #include "Backend/SoundLib.h"
+#include "Backend/BatchSimulation.h"
+#include "Backend/ConvergenceStudy.h"
 
 #include <stdio.h>
 #include <math.h>
@@ -64,6 +67,9 @@ static const int IDB_COMPUTE_ACOUSTIC_FIELD       = 6006;
 static const int IDB_LF_PULSE                     = 6007;
 static const int IDB_PLAY_LONG_VOWEL              = 6008;
 static const int IDB_PLAY_NOISE_SOURCE            = 6009;
+static const int IDB_LOAD_TF_LIBRARY              = 6010;
+static const int IDB_PREVIEW_TF                   = 6011;
+static const int IDB_FULL_SWEEP_AFTER_PREVIEW     = 6012;
 
 // Modes picture controls
 static const int IDB_SHOW_LOWER_ORDER_MODE        = 6020;
@@ -94,6 +100,13 @@ static const int IDB_SHOW_INPUT_IMPED_SPEC        = 7010;
 static const int IDB_PREVIOUS_TF                  = 7011;
 static const int IDB_NEXT_TF                      = 7012;
 
+// Events of the background computations
+static const int IDT_TF_PROGRESS                  = 8000;
+static const int IDT_TF_FINISHED                  = 8001;
+static const int IDT_FIELD_PROGRESS               = 8002;
+static const int IDT_FIELD_FINISHED               = 8003;
+static const int IDT_PREVIEW_FINISHED             = 8004;
+
 // ****************************************************************************
 // The event table.
 // ****************************************************************************
@@ -103,6 +116,13 @@ BEGIN_EVENT_TABLE(Acoustic3dPage, wxPanel)
   // Custom event handler for update requests by child widgets.
   EVT_COMMAND(wxID_ANY, updateRequestEvent, Acoustic3dPage::OnUpdateRequest)
 
+  // Events posted by the worker thread of the computations
+  EVT_THREAD(IDT_TF_PROGRESS, Acoustic3dPage::OnTfProgress)
+  EVT_THREAD(IDT_TF_FINISHED, Acoustic3dPage::OnTfFinished)
+  EVT_THREAD(IDT_FIELD_PROGRESS, Acoustic3dPage::OnFieldProgress)
+  EVT_THREAD(IDT_FIELD_FINISHED, Acoustic3dPage::OnFieldFinished)
+  EVT_THREAD(IDT_PREVIEW_FINISHED, Acoustic3dPage::OnPreviewFinished)
+
   // Left side controls
 
   //EVT_BUTTON(IDB_RUN_TEST_JUNCTION, Acoustic3dPage::OnRunTestJunction)
@@ -116,10 +136,12 @@ BEGIN_EVENT_TABLE(Acoustic3dPage, wxPanel)
   EVT_BUTTON(IDB_IMPORT_GEOMETRY, Acoustic3dPage::OnImportGeometry)
   EVT_BUTTON(IDB_COMPUTE_MODES, Acoustic3dPage::OnComputeModes)
   EVT_BUTTON(IDB_COMPUTE_TF, Acoustic3dPage::OnComputeTf)
+  EVT_BUTTON(IDB_PREVIEW_TF, Acoustic3dPage::OnPreviewTf)
   EVT_BUTTON(IDB_COMPUTE_ACOUSTIC_FIELD, Acoustic3dPage::OnComputeAcousticField)
   EVT_BUTTON(IDB_LF_PULSE, Acoustic3dPage::OnLfPulse)
   EVT_BUTTON(IDB_PLAY_LONG_VOWEL, Acoustic3dPage::OnPlayLongVowel)
   EVT_BUTTON(IDB_PLAY_NOISE_SOURCE, Acoustic3dPage::OnPlayNoiseSource)
+  EVT_BUTTON(IDB_LOAD_TF_LIBRARY, Acoustic3dPage::OnLoadTfLibrary)
 
   // Modes picture controls
   EVT_BUTTON(IDB_SHOW_LOWER_ORDER_MODE, Acoustic3dPage::OnShowPrevious)
@@ -157,6 +179,10 @@ END_EVENT_TABLE()
 
 Acoustic3dPage::Acoustic3dPage(wxWindow* parent, VocalTractPicture *picVocalTract) :
   wxPanel(parent, wxID_ANY, wxDefaultPosition, wxDefaultSize, wxCLIP_CHILDREN),
+  m_cancelComputation(false),
+  m_computing(false),
+  m_previewSucceeded(false),
+  m_previewFreqStep(0.),
   m_idxTfPoint(0)
 {
   initVars();
@@ -165,6 +191,16 @@ Acoustic3dPage::Acoustic3dPage(wxWindow* parent, VocalTractPicture *picVocalTrac
   updateWidgets();
 }
 
+// ****************************************************************************
+/// Destructor: stop the computation running in the background.
+// ****************************************************************************
+
+Acoustic3dPage::~Acoustic3dPage()
+{
+  m_cancelComputation = true;
+  if (m_computeThread.joinable()) { m_computeThread.join(); }
+}
+
 // ****************************************************************************
 // ****************************************************************************
 
@@ -174,6 +210,7 @@ Acoustic3dPage::Acoustic3dPage(wxWindow* parent, VocalTractPicture *picVocalTrac
 
 void Acoustic3dPage::updateWidgets()
 {
+  GuiTimer timer("Acoustic3dPage::updateWidgets");
   VocalTract* tract = data->vocalTract;
 
   // display selected options for mode picture
@@ -228,6 +265,15 @@ void Acoustic3dPage::initVars()
   data = Data::getInstance();
   simu3d = Acoustic3dSimulation::getInstance();
   m_tfPoint = simu3d->simuParams().tfPoint[m_idxTfPoint];
+
+  // store the modes and junction matrices in a cache in the temporary 
+  // directory, so that the unchanged segments are not recomputed
+  wxString cacheDir(wxFileName::GetTempDir() + wxFileName::GetPathSeparator() 
+    + "vtl3dModesCache");
+  if (wxDirExists(cacheDir) || wxFileName::Mkdir(cacheDir, wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL))
+  {
+    simu3d->setCacheDirectory(cacheDir.ToStdString());
+  }
 }
 
 // ****************************************************************************
@@ -288,6 +334,14 @@ void Acoustic3dPage::initWidgets(VocalTractPicture* picVocalTract)
   button = new wxButton(this, IDB_COMPUTE_TF, "Compute transfer functions");
   leftSizer->Add(button, 0, wxGROW | wxALL, 3);
 
+  button = new wxButton(this, IDB_PREVIEW_TF, "Preview transfer function");
+  leftSizer->Add(button, 0, wxGROW | wxALL, 3);
+
+  chkFullSweepAfterPreview = new wxCheckBox(this, IDB_FULL_SWEEP_AFTER_PREVIEW, 
+    "Full sweep after preview");
+  chkFullSweepAfterPreview->SetValue(true);
+  leftSizer->Add(chkFullSweepAfterPreview, 0, wxALL, 3);
+
   button = new wxButton(this, IDB_COMPUTE_ACOUSTIC_FIELD, "Compute acoustic field");
   leftSizer->Add(button, 0, wxGROW | wxALL, 3);
 
@@ -302,6 +356,9 @@ void Acoustic3dPage::initWidgets(VocalTractPicture* picVocalTract)
   button = new wxButton(this, IDB_PLAY_NOISE_SOURCE, "Play noise source");
   leftSizer->Add(button, 0, wxGROW | wxALL, 3);
 
+  button = new wxButton(this, IDB_LOAD_TF_LIBRARY, "Load TF library");
+  leftSizer->Add(button, 0, wxGROW | wxALL, 3);
+
 // ****************************************************************
 
   topLevelSizer->Add(leftSizer, 0, wxALL, 5);
@@ -660,124 +717,17 @@ void Acoustic3dPage::OnUpdateRequest(wxCommandEvent& event)
 void Acoustic3dPage::computeModesJunctionAndRadMats(bool precomputeRadMat,
   wxGenericProgressDialog* progressDialog, bool &abort)
 {
-  const struct simulationParameters &simuParams(simu3d->simuParams());
-  int numSeg(simu3d->numberOfSegments());
-  int lastSeg(numSeg - 1);
-  int nbRadFreqs(16);
-
-  ofstream log("log.txt", ofstream::app);
-  std::chrono::duration<double> time;
-
-  if (simuParams.needToComputeModesAndJunctions)
-  {
-    // set mode number to 0 to make sure that it is defined by the maximal cutoff 
-    // frequency when modes are computed
-    for (int i(0); i < numSeg; i++)
+  // the modes, the junction matrices and the radiation impedance are
+  // computed as a task graph in parallel, the progress dialog is updated
+  // from this thread and stops the computation if [Cancel] is pressed
+  progressDialog->Update(0,
+    "Wait until the modes and junction matrices computation finished or press [Cancel]");
+  abort = !simu3d->computeModesJunctionsAndRadiation(precomputeRadMat,
+    [progressDialog](int numDone, int numTot)
     {
-      simu3d->crossSection(i)->setModesNumber(0);
-    }
-
-    //*********************************************************
-    // compute modes
-    //*********************************************************
-
-    auto start = std::chrono::system_clock::now();
-    for (int i(0); i < numSeg; i++)
-    {
-      simu3d->computeMeshAndModes(i);
-
-      // stop if [Cancel] is pressed
-      if (progressDialog->Update(i) == false)
-      {
-        abort = true;
-        break;
-      }
-    }
-    auto end = std::chrono::system_clock::now();
-    time = end - start;
-    log << "Time mesh and modes: " << time.count() << endl;
-
-    //*********************************************************
-    // compute junction matrices
-    //*********************************************************
-
-    if (!abort)
-    {
-      progressDialog->Update(0,
-        "Wait until the junction matrices computation finished or press [Cancel]");
-      start = std::chrono::system_clock::now();
-      for (int i(0); i < numSeg; i++)
-      {
-        simu3d->computeJunctionMatrices(i);
-        log << "Junction segment " << i << " computed" << endl;
-        // stop if [Cancel] is pressed
-        if (progressDialog->Update(i) == false)
-        {
-          abort = true;
-          break;
-        }
-      }
-
-      if (!abort)
-      {
-        simu3d->setNeedToComputeModesAndJunctions(false);
-      }
-
-      end = std::chrono::system_clock::now();
-      time = end - start;
-      log << "Time junction matrices: " << time.count() << endl;
-    }
-
-    //*********************************************************
-    // precompute radiation impedance
-    //*********************************************************
-
-    if (!abort && precomputeRadMat && simu3d->mouthBoundaryCond() == RADIATION)
-    {
-      progressDialog->Update(0, "Precompute radiation impedance");
-      progressDialog->SetRange(nbRadFreqs);
-      start = std::chrono::system_clock::now();
-      simu3d->initCoefInterpRadiationMatrices(nbRadFreqs, lastSeg);
-      for (int i(0); i < nbRadFreqs; i++)
-      {
-        simu3d->addRadMatToInterpolate(nbRadFreqs, lastSeg, i);
-        if (progressDialog->Update(i) == false)
-        {
-          abort = true;
-          break;
-        }
-      }
-      simu3d->computeInterpCoefRadMat(nbRadFreqs, lastSeg);
-
-      end = std::chrono::system_clock::now();
-      time = end - start;
-      log << "Time radiation impedance: " << time.count() << endl;
-    }
-  }
-
-  if (!simu3d->radImpedPrecomputed() && (simu3d->mouthBoundaryCond() == RADIATION)
-    && !abort && precomputeRadMat)
-  {
-    progressDialog->Update(0, "Precompute radiation impedance");
-    progressDialog->SetRange(nbRadFreqs);
-    auto start = std::chrono::system_clock::now();
-    simu3d->initCoefInterpRadiationMatrices(nbRadFreqs, lastSeg);
-    for (int i(0); i < nbRadFreqs; i++)
-    {
-      simu3d->addRadMatToInterpolate(nbRadFreqs, lastSeg, i);
-      if (progressDialog->Update(i) == false)
-      {
-        abort = true;
-        break;
-      }
-    }
-    simu3d->computeInterpCoefRadMat(nbRadFreqs, lastSeg);
-
-    auto end = std::chrono::system_clock::now();
-    time = end - start;
-    log << "Time radiation impedance: " << time.count() << endl;
-  }
-  log.close();
+      progressDialog->SetRange(numTot);
+      return progressDialog->Update(numDone - 1);
+    });
 }
 
 // ****************************************************************************
@@ -785,98 +735,274 @@ void Acoustic3dPage::computeModesJunctionAndRadMats(bool precomputeRadMat,
 
 void Acoustic3dPage::OnComputeTf(wxCommandEvent& event)
 {
+  // only one computation runs in the background at once
+  if (m_computing) { return; }
+
   Data* data = Data::getInstance();
   Acoustic3dSimulation* simu3d = Acoustic3dSimulation::getInstance();
   VocalTract* tract = data->vocalTract;
 
+  // if only the transfer function points have changed since the last sweep,
+  // the transfer functions are re-evaluated from the exit velocities of the
+  // sweep without propagating again
+  if (simu3d->reEvaluateTransferFunctions())
+  {
+    int numPts(simu3d->oldSimuParams().tfPoint.size());
+    if (m_idxTfPoint >= numPts) { m_idxTfPoint = 0; }
+    simu3d->generateSpectraForSynthesis(m_idxTfPoint);
+
+    picSpectrum->setIdxTfPoint(m_idxTfPoint);
+    picSpectrum->Refresh();
+    segPic->setIdxTfPoint(m_idxTfPoint);
+    segPic->Refresh();
+    updateWidgets();
+    return;
+  }
+
   bool abort(false);
-  double freq;
   int numSeg(simu3d->numberOfSegments());
-  int lastSeg(numSeg - 1);
-  struct simulationParameters simuParams(simu3d->simuParams());
 
   // Create the progress dialog
   progressDialog = new wxGenericProgressDialog("Transfer functions progress",
     "Wait until the modes computation finished or press [Cancel]",
     numSeg, NULL,
-    wxPD_CAN_ABORT | wxPD_AUTO_HIDE | wxPD_ELAPSED_TIME);
+    wxPD_CAN_ABORT | wxPD_APP_MODAL | wxPD_AUTO_HIDE | wxPD_ELAPSED_TIME);
 
   // log file
   simu3d->generateLogFileHeader(true);
-  ofstream log("log.txt", ofstream::app);
 
   // for time tracking
-  auto startTot = std::chrono::system_clock::now();
-  auto start = std::chrono::system_clock::now();
-  auto end = std::chrono::system_clock::now();
-  std::chrono::duration<double> timeModes(0.), timeJunctions(0.), timePropa(0.),
-    timeRadImped(0.), timeComputeField(0.), timeExp(0.), time;
+  m_computeStart = std::chrono::system_clock::now();
+  m_timePropa = std::chrono::duration<double>(0.);
+  m_timeComputeField = std::chrono::duration<double>(0.);
+  m_timeExp = std::chrono::duration<double>(0.);
 
   simu3d->precomputationsForTf();
 
   computeModesJunctionAndRadMats(true, progressDialog, abort);
 
-  //*********************************************************
-  // Compute the transfer fucntion for each frequency
-  //*********************************************************
-
   // save the frequency of the acoustic firled computation in order to 
   // restore it after the TF computation
-  double freqField(simu3d->freqAcousticField());
+  m_freqFieldSaved = simu3d->freqAcousticField();
+
+  if (abort)
+  {
+    finishTfComputation(false, true);
+    return;
+  }
+
+  //*********************************************************
+  // Compute the transfer fucntion for each frequency in a
+  // worker thread, the spectrum is updated as the 
+  // frequencies are computed
+  //*********************************************************
 
   int numFreqComputed(simu3d->numFreqComputed());
-  double freqSteps(simu3d->freqSteps());
-  bool computeNoiseSrcTf(simu3d->idxSecNoiseSource() < numSeg - 1);
+  progressDialog->Update(0,
+    "Wait until the transfer functions computation finished or press [Cancel]");
+  progressDialog->SetRange(numFreqComputed);
+
+  // only the pressure and the velocity at the ends of the segments are 
+  // needed for the transfer functions if all their points are outside
+  simu3d->setStoreAxialProfile(!simu3d->tfPointsRadiated());
+
+  // the frequencies computed before a cancelled sweep of the same geometry
+  // are restored from the checkpoint and are not computed again
+  simu3d->startTfCheckpoint(true);
+
+  m_cancelComputation = false;
+  m_computing = true;
+  m_computeThread = thread(&Acoustic3dPage::computeTfWorker, this, tract,
+    numFreqComputed, simu3d->freqSteps(), 
+    simu3d->idxSecNoiseSource() < numSeg - 1);
+}
+
+// ****************************************************************************
+// Quick preview of the glottal transfer function with coarse settings (see 
+// previewSimulationSetup), computed in the worker thread by a simulation of 
+// its own, so that the modes and the transfer functions of the page are kept.
+// The full sweep is then started if it is requested and replaces the preview 
+// when it is finished.
+
+void Acoustic3dPage::OnPreviewTf(wxCommandEvent& event)
+{
+  if (m_computing) { return; }
+
+  if (simu3d->numberOfSegments() == 0)
+  {
+    wxMessageBox("The geometry has not been created.", "Preview");
+    return;
+  }
+
+  // the preview imports the geometry from a file as the batch simulations
+  m_previewGeometryFile = wxFileName::CreateTempFileName("vtl3d");
+  if (!simu3d->exportGeoInCsv(m_previewGeometryFile.ToStdString()))
+  {
+    wxRemoveFile(m_previewGeometryFile);
+    wxMessageBox("The geometry could not be exported.", "Preview");
+    return;
+  }
+
+  struct simulationSetup setup(previewSimulationSetup(getSimulationSetup(*simu3d)));
+
+  wxBeginBusyCursor();
+  m_computing = true;
+  m_computeThread = thread(&Acoustic3dPage::computePreviewWorker, this,
+    m_previewGeometryFile.ToStdString(), setup, m_idxTfPoint);
+}
+
+// ****************************************************************************
+
+void Acoustic3dPage::computePreviewWorker(string geometryFile, 
+  struct simulationSetup setup, int idxTfPoint)
+{
+  Acoustic3dSimulation preview;
+  applySimulationSetup(preview, setup);
+
+  m_previewSucceeded = importGeometryFile(preview, geometryFile);
+  if (m_previewSucceeded)
+  {
+    preview.computeTransferFunction(NULL);
+    preview.transferFunctionMagnitudes(idxTfPoint, GLOTTAL, 
+      m_previewMagnitudes, m_previewFreqStep);
+    m_previewSucceeded = !m_previewMagnitudes.empty();
+  }
+
+  wxQueueEvent(this, new wxThreadEvent(wxEVT_THREAD, IDT_PREVIEW_FINISHED));
+}
+
+// ****************************************************************************
+
+void Acoustic3dPage::OnPreviewFinished(wxThreadEvent& event)
+{
+  m_computeThread.join();
+  m_computing = false;
+  wxEndBusyCursor();
+  wxRemoveFile(m_previewGeometryFile);
+
+  if (!m_previewSucceeded)
+  {
+    wxMessageBox("The preview transfer function could not be computed.", 
+      "Preview");
+    return;
+  }
+
+  picSpectrum->setPreviewTf(m_previewMagnitudes, m_previewFreqStep);
+  picSpectrum->Refresh();
+
+  if (chkFullSweepAfterPreview->GetValue())
+  {
+    wxCommandEvent computeEvent;
+    OnComputeTf(computeEvent);
+  }
+}
+
+// ****************************************************************************
+// Frequency sweep run in the worker thread: a progress event is posted after
+// each frequency and a finished event at the end (with 1 if cancelled).
+
+void Acoustic3dPage::computeTfWorker(VocalTract* tract, int numFreqComputed, 
+  double freqSteps, bool computeNoiseSrcTf)
+{
+  LogStream log;
+  double freq;
   bool needToExtractMatrixF(true);
   Matrix F;
-  if (!abort)
+  std::chrono::duration<double> time;
+  auto start = std::chrono::system_clock::now();
+  auto end = std::chrono::system_clock::now();
+
+  int i(0);
+  for (; (i < numFreqComputed) && !m_cancelComputation; i++)
   {
-    progressDialog->Update(0,
-      "Wait until the transfer functions computation finished or press [Cancel]");
-    progressDialog->SetRange(numFreqComputed);
+    freq = max(0.1, (double)i * freqSteps);
+    if (simu3d->restoreTfFromCheckpoint(i, freq))
+    {
+      wxThreadEvent* progress(new wxThreadEvent(wxEVT_THREAD, IDT_TF_PROGRESS));
+      progress->SetInt(i);
+      wxQueueEvent(this, progress);
+      continue;
+    }
+    log << "frequency " << i + 1 << "/" << numFreqComputed << " f = " << freq
+      << " Hz" << endl;
 
-    for (int i(0); i < numFreqComputed; i++)
+    simu3d->solveWaveProblem(tract, freq, m_timePropa, &m_timeExp);
+
+    //*****************************************************************************
+    //  Compute acoustic pressure 
+    //*****************************************************************************
+
+    start = std::chrono::system_clock::now();
+
+    simu3d->computeGlottalTf(i, freq);
+
+    end = std::chrono::system_clock::now();
+    m_timeComputeField += end - start;
+
+    //*****************************************************************************
+    //  Compute transfer function of the noise source
+    //*****************************************************************************
+
+    if (computeNoiseSrcTf)
     {
-      freq = max(0.1, (double)i * freqSteps);
-      log << "frequency " << i + 1 << "/" << numFreqComputed << " f = " << freq
-        << " Hz" << endl;
+      simu3d->solveWaveProblemNoiseSrc(needToExtractMatrixF, F, freq, &time);
+      simu3d->computeNoiseSrcTf(i);
+    }
+    simu3d->setTfRowComputed(i);
 
-      simu3d->solveWaveProblem(tract, freq, timePropa, &timeExp);
+    wxThreadEvent* progress(new wxThreadEvent(wxEVT_THREAD, IDT_TF_PROGRESS));
+    progress->SetInt(i);
+    wxQueueEvent(this, progress);
+  }
+  log.close();
 
-      //*****************************************************************************
-      //  Compute acoustic pressure 
-      //*****************************************************************************
+  wxThreadEvent* finished(new wxThreadEvent(wxEVT_THREAD, IDT_TF_FINISHED));
+  finished->SetInt((i < numFreqComputed) ? 1 : 0);
+  wxQueueEvent(this, finished);
+}
 
-      start = std::chrono::system_clock::now();
+// ****************************************************************************
+// Update the progress dialog and the spectrum with the frequencies computed
 
-      simu3d->computeGlottalTf(i, freq);
+void Acoustic3dPage::OnTfProgress(wxThreadEvent& event)
+{
+  if ((progressDialog != NULL) && !progressDialog->Update(event.GetInt()))
+  {
+    m_cancelComputation = true;
+  }
+  picSpectrum->Refresh();
+}
 
-      end = std::chrono::system_clock::now();
-      timeComputeField += end - start;
+// ****************************************************************************
 
-      //*****************************************************************************
-      //  Compute transfer function of the noise source
-      //*****************************************************************************
+void Acoustic3dPage::OnTfFinished(wxThreadEvent& event)
+{
+  m_computeThread.join();
+  m_computing = false;
+  simu3d->setStoreAxialProfile(true);
+  simu3d->stopTfCheckpoint();
+  finishTfComputation(true, event.GetInt() != 0);
+}
 
-      if (computeNoiseSrcTf)
-      {
-        simu3d->solveWaveProblemNoiseSrc(needToExtractMatrixF, F, freq, &time);
-        simu3d->computeNoiseSrcTf(i);
-      }
+// ****************************************************************************
+// Close the progress dialog, generate the spectra for the synthesis if the 
+// sweep has been run and log the times of the computation
 
-      if (progressDialog->Update(i) == false)
-      {
-        abort = true;
-        break;
-      }
-    }
+void Acoustic3dPage::finishTfComputation(bool sweepRun, bool abort)
+{
+  LogStream log;
 
-    // destroy progress dialog
-    progressDialog->Destroy();
-    progressDialog = NULL;
+  // destroy progress dialog
+  progressDialog->Destroy();
+  progressDialog = NULL;
 
+  if (sweepRun)
+  {
     if (!abort)
     {
+      // the transfer function of the full sweep replaces the preview
+      picSpectrum->clearPreviewTf();
+
       wxMessageDialog* dial = new wxMessageDialog(NULL,
         wxT("Computation of transfer functions finished"), wxT("Info"), wxOK);
       dial->ShowModal();
@@ -885,23 +1011,16 @@ void Acoustic3dPage::OnComputeTf(wxCommandEvent& event)
     // generate spectra values for negative frequencies
     simu3d->generateSpectraForSynthesis(m_idxTfPoint);
   }
-  else
-  {
-    // destroy progress dialog
-    progressDialog->Destroy();
-    progressDialog = NULL;
-  }
 
   // restore the frequency of the acoustic field
-  simu3d->setAcousticFieldFreq(freqField);
+  simu3d->setAcousticFieldFreq(m_freqFieldSaved);
 
   // print the times of the different parts of the process
-  log << "\nTime propagation: " << timePropa.count() << endl;
-  end = std::chrono::system_clock::now();
-  time = end - startTot;
+  log << "\nTime propagation: " << m_timePropa.count() << endl;
+  std::chrono::duration<double> time(std::chrono::system_clock::now() - m_computeStart);
   log << "\nTransfer function time (sec): " << time.count() << endl;
-  log << "Time acoustic pressure computation: " << timeComputeField.count() << endl;
-  log << "Time matrix exponential: " << timeExp.count() << endl;
+  log << "Time acoustic pressure computation: " << m_timeComputeField.count() << endl;
+  log << "Time matrix exponential: " << m_timeExp.count() << endl;
 
   // print total time in HMS
   int hours(floor(time.count() / 3600.));
@@ -923,12 +1042,14 @@ void Acoustic3dPage::OnComputeTf(wxCommandEvent& event)
 
 void Acoustic3dPage::OnComputeModes(wxCommandEvent& event)
 {
+  if (m_computing) { return; }
+
   Data* data = Data::getInstance();
   Acoustic3dSimulation* simu3d = Acoustic3dSimulation::getInstance();
   VocalTract* tract = data->vocalTract;
 
   simu3d->generateLogFileHeader(true);
-  ofstream log("log.txt", ofstream::app);
+  LogStream log;
   log << "\nStart compute modes" << endl;
 
   int numSeg(simu3d->numberOfSegments());
@@ -937,7 +1058,7 @@ void Acoustic3dPage::OnComputeModes(wxCommandEvent& event)
   progressDialog = new wxGenericProgressDialog("Modes computation progress",
     "Wait until the modes computation finished or press [Cancel]",
     numSeg, NULL,
-    wxPD_CAN_ABORT | wxPD_AUTO_HIDE | wxPD_ELAPSED_TIME);
+    wxPD_CAN_ABORT | wxPD_APP_MODAL | wxPD_AUTO_HIDE | wxPD_ELAPSED_TIME);
 
   for (int i(0); i < numSeg; i++)
   {
@@ -971,6 +1092,9 @@ void Acoustic3dPage::OnComputeModes(wxCommandEvent& event)
 
 void Acoustic3dPage::OnComputeAcousticField(wxCommandEvent& event)
 {
+  // only one computation runs in the background at once
+  if (m_computing) { return; }
+
   // hide the previous field if it exists
   chkShowField->SetValue(false);
   updateWidgets();
@@ -983,54 +1107,115 @@ void Acoustic3dPage::OnComputeAcousticField(wxCommandEvent& event)
   bool abort(false);
   struct simulationParameters simuParams(simu3d->simuParams());
   double freq(simuParams.freqField);
-  std::chrono::duration<double> timePropa(0.), timeExp(0.);
-  int nPtx, nPty;
-  int cnt(0);
 
   // Create the progress dialog
   progressDialog = new wxGenericProgressDialog("Acoustic field progress",
     "Wait until the modes computation finished or press [Cancel]",
     numSeg, NULL,
-    wxPD_CAN_ABORT | wxPD_AUTO_HIDE | wxPD_ELAPSED_TIME);
+    wxPD_CAN_ABORT | wxPD_APP_MODAL | wxPD_AUTO_HIDE | wxPD_ELAPSED_TIME);
 
   // log file
   simu3d->generateLogFileHeader(true);
-  ofstream log("log.txt", ofstream::app);
+  LogStream log;
 
   computeModesJunctionAndRadMats(false, progressDialog, abort);
 
-  if (!abort)
+  if (abort)
   {
-    simu3d->solveWaveProblem(tract, freq, timePropa, &timeExp);
+    log.close();
+    finishFieldComputation(false, true);
+    return;
+  }
+
+  // the field is allocated before starting the worker so that it can be 
+  // displayed while it is computed
+  simu3d->prepareAcousticFieldComputation();
+  log << "Num points on x: " << simu3d->numPtXField() 
+    << " Num points on y: " << simu3d->numPtYField() << endl;
+  log.close();
+
+  progressDialog->Update(0,
+    "Wait until the acoustic field computation finished or press [Cancel]");
+
+  chkShowField->SetValue(true);
+  setPicModeObjectTodisplay(ACOUSTIC_FIELD);
+  updateWidgets();
+
+  m_cancelComputation = false;
+  m_computing = true;
+  m_computeThread = thread(&Acoustic3dPage::computeFieldWorker, this, tract, freq);
+}
 
-    simu3d->prepareAcousticFieldComputation();
-    nPtx = simu3d->numPtXField();
-    nPty = simu3d->numPtYField();
+// ****************************************************************************
+// Computation of the acoustic field run in the worker thread: a progress 
+// event is posted after each tile of the field (with the number of tiles 
+// computed and the total number of tiles) and a finished event at the end
+// (with 1 if cancelled).
+
+void Acoustic3dPage::computeFieldWorker(VocalTract* tract, double freq)
+{
+  LogStream log;
+  std::chrono::duration<double> timePropa(0.), timeExp(0.);
 
-    progressDialog->Update(0,
-      "Wait until the acoustic field computation finished or press [Cancel]");
-    progressDialog->SetRange(nPtx);
-    log << "Num points on x: " << nPtx << " Num points on y: " << nPty << endl;
+  simu3d->solveWaveProblem(tract, freq, timePropa, &timeExp);
 
-    for (int i(0); i < nPtx; i++)
+  bool finished(!m_cancelComputation && simu3d->acousticFieldInPlane(
+    [this, &log](int numDone, int numTot)
     {
-      simu3d->acousticFieldInLine(i);
-      cnt += nPty;
+      log << 100 * numDone / numTot << " % of field points computed" << endl;
+      wxThreadEvent* progress(new wxThreadEvent(wxEVT_THREAD, IDT_FIELD_PROGRESS));
+      progress->SetInt(numDone);
+      progress->SetExtraLong(numTot);
+      wxQueueEvent(this, progress);
+      return !m_cancelComputation;
+    }));
+  log.close();
 
-      log << 100 * cnt / nPtx / nPty << " % of field points computed" << endl;
+  wxThreadEvent* finishedEvent(new wxThreadEvent(wxEVT_THREAD, IDT_FIELD_FINISHED));
+  finishedEvent->SetInt(finished ? 0 : 1);
+  wxQueueEvent(this, finishedEvent);
+}
 
-      // stop if [Cancel] is pressed
-      if (progressDialog->Update(i) == false)
-      {
-        abort = true;
-        break;
-      }
-    }
+// ****************************************************************************
+// Update the progress dialog and, about every 5 % of the tiles, the image of 
+// the field with the tiles already computed
 
-    // destroy progress dialog
-    progressDialog->Destroy();
-    progressDialog = NULL;
+void Acoustic3dPage::OnFieldProgress(wxThreadEvent& event)
+{
+  int numDone(event.GetInt()), numTot(event.GetExtraLong());
 
+  if (progressDialog != NULL)
+  {
+    progressDialog->SetRange(numTot);
+    if (!progressDialog->Update(numDone - 1)) { m_cancelComputation = true; }
+  }
+
+  if (numDone % max(1, numTot / 20) == 0)
+  {
+    simu3d->setFieldImageComputation(true);
+    segPic->Refresh();
+  }
+}
+
+// ****************************************************************************
+
+void Acoustic3dPage::OnFieldFinished(wxThreadEvent& event)
+{
+  m_computeThread.join();
+  m_computing = false;
+  finishFieldComputation(true, event.GetInt() != 0);
+}
+
+// ****************************************************************************
+
+void Acoustic3dPage::finishFieldComputation(bool fieldComputed, bool abort)
+{
+  // destroy progress dialog
+  progressDialog->Destroy();
+  progressDialog = NULL;
+
+  if (fieldComputed)
+  {
     // when a new field have been computed, request the interpolation of the 
     // field to create the field image to display
     simu3d->setFieldImageComputation(true);
@@ -1042,12 +1227,6 @@ void Acoustic3dPage::OnComputeAcousticField(wxCommandEvent& event)
       dial->ShowModal();
     }
   }
-  else
-  {
-    // destroy progress dialog
-    progressDialog->Destroy();
-    progressDialog = NULL;
-  }
 
   // update pictures
   chkShowField->SetValue(true);
@@ -1060,6 +1239,9 @@ void Acoustic3dPage::OnComputeAcousticField(wxCommandEvent& event)
 
 void Acoustic3dPage::OnParamSimuDialog(wxCommandEvent& event)
 {
+  // the simulation is not changed while it runs in the background
+  if (m_computing) { return; }
+
   ParamSimu3DDialog *dialog = ParamSimu3DDialog::getInstance(NULL);
   dialog->SetParent(this);
   dialog->Show(true);
@@ -1080,9 +1262,13 @@ void Acoustic3dPage::OnShapesDialog(wxCommandEvent& event)
 
 void Acoustic3dPage::OnImportGeometry(wxCommandEvent& event)
 {
+  // the simulation is not changed while it runs in the background
+  if (m_computing) { return; }
+
   wxFileName fileName;
   wxString name = wxFileSelector("Import geometry as csv file", fileName.GetPath(),
-    fileName.GetFullName(), ".csv", "Geometry file (*.csv)|*.csv",
+    fileName.GetFullName(), ".csv", 
+    "Geometry file (*.csv)|*.csv|Binary geometry file (*.vtg)|*.vtg|Mesh (*.stl)|*.stl",
     wxFD_OPEN | wxFD_FILE_MUST_EXIST, this);
 
   if (name.size() > 0)
@@ -1138,15 +1324,7 @@ void Acoustic3dPage::OnPlayLongVowel()
 
   data->normalizeAudioAmplitude(Data::MAIN_TRACK);
 
-  if (waveStartPlaying(data->track[Data::MAIN_TRACK]->x, data->track[Data::MAIN_TRACK]->N, false))
-  {
-    wxMilliSleep(duration_ms);
-    waveStopPlaying();
-  }
-  else
-  {
-    wxMessageBox("Playing failed.", "Attention!");
-  }
+  playMainTrackStream(duration_ms);
 }
 
 // ****************************************************************************
@@ -1160,15 +1338,66 @@ void Acoustic3dPage::OnPlayNoiseSource(wxCommandEvent& event)
   int duration_ms = data->synthesizeNoiseSource(simu3d, 0);
   data->normalizeAudioAmplitude(Data::MAIN_TRACK);
 
-  if (waveStartPlaying(data->track[Data::MAIN_TRACK]->x, data->track[Data::MAIN_TRACK]->N, false))
+  playMainTrackStream(duration_ms);
+}
+
+// ****************************************************************************
+// Play the first duration_ms milliseconds of the main track as a stream: 
+// the playback starts with the first block pushed into the queue and stops
+// when its last sample has been played.
+// ****************************************************************************
+
+void Acoustic3dPage::playMainTrackStream(int duration_ms)
+{
+  Data* data = Data::getInstance();
+  int numSamples = min(data->track[Data::MAIN_TRACK]->N,
+    (int)((double)duration_ms * (double)SAMPLING_RATE / 1000.));
+  SampleQueue queue(SAMPLING_RATE);
+
+  if (!waveStartPlayingStream(&queue))
   {
-    wxMilliSleep(duration_ms);
-    waveStopPlaying();
+    wxMessageBox("Playing failed.", "Attention!");
+    return;
   }
-  else
+
+  queue.write(data->track[Data::MAIN_TRACK]->x, numSamples);
+  queue.close();
+  while (waveIsPlayingStream())
   {
-    wxMessageBox("Playing failed.", "Attention!");
+    wxMilliSleep(10);
+  }
+  waveStopPlaying();
+}
+
+// ****************************************************************************
+// Load a library of 3D transfer functions computed offline (see TfLibrary.h):
+// the transfer functions of the shapes selected in the vocal tract shapes 
+// dialog are then interpolated in the library instead of being computed.
+// ****************************************************************************
+
+void Acoustic3dPage::OnLoadTfLibrary(wxCommandEvent& event)
+{
+  wxString name = wxFileSelector("Load a library of 3D transfer functions", "", "", 
+    ".tfl", "Transfer function library (*.tfl)|*.tfl", 
+    wxFD_OPEN | wxFD_FILE_MUST_EXIST, this);
+
+  if (name.size() == 0) { return; }
+
+  if (!readTfLibrary(name.ToStdString(), data->tfLibrary3d))
+  {
+    wxMessageBox("Error loading the transfer function library.", "Error");
+    return;
   }
+
+  if (!data->setTransferFunctionsFromLibrary(simu3d, data->vocalTract))
+  {
+    data->tfLibrary3d.entries.clear();
+    wxMessageBox("The library does not match the spectrum length or the vocal tract model.", 
+      "Error");
+    return;
+  }
+
+  updateWidgets();
 }
 
 // ****************************************************************************
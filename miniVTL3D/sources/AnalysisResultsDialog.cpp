@@ -71,7 +71,7 @@ void AnalysisResultsDialog::updateWidgets()
   double pos_s = 0.0;
   double value;
   double semitones;
-  int i;
+  int i, k;
 
   // ****************************************************************
   // For which time position shall we show the results?
@@ -95,6 +95,19 @@ void AnalysisResultsDialog::updateWidgets()
     grid->SetCellValue(i, 1, wxString::Format("%2.8f", value));
   }
 
+  // ****************************************************************
+  // Formant frequencies.
+  // ****************************************************************
+
+  for (i=0; i < Data::NUM_TRACKS; i++)
+  {
+    for (k=0; k < FormantEstimatorLpc::NUM_FORMANTS; k++)
+    {
+      value = getInterpolatedValue(data->formantSignal[i][k], data->formantTimeStep_s, pos_s);
+      grid->SetCellValue(i, 2 + k, wxString::Format("%2.1f", value));
+    }
+  }
+
   // ****************************************************************
   // Voice quality values.
   // ****************************************************************
@@ -51,6 +51,8 @@ public:
 
 public:
   static AnalysisResultsDialog *getInstance();
+  // True when the dialog was already created (by getInstance()).
+  static bool hasInstance() { return instance != NULL; }
   void updateWidgets();
 
   // **************************************************************************
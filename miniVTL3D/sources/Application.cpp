@@ -22,6 +22,8 @@
 #include "Application.h"
 #include "Data.h"
 #include "IconsXpm.h"
+#include "Backend/Profiler.h"
+#include "GuiTimings.h"
 
 #ifdef WIN32
 #include <windows.h>
@@ -60,6 +62,11 @@ bool Application::OnInit()
   createConsole();
   wxPrintf("=== Console output for VocalTractLab 2.3 (built %s) ===\n\n", __DATE__);
 
+  // Measure the phases of the start-up. They are printed at the end.
+
+  Profiler::getInstance().setEnabled(true);
+  double startTime = Profiler::getInstance().now();
+
   // Init the data class at the very beginning.
   
   Data *data = Data::getInstance();
@@ -71,7 +78,11 @@ bool Application::OnInit()
 
   // Create and show the main window.
 
-  MainWindow *mainWindow = new MainWindow();
+  MainWindow *mainWindow;
+  {
+    ScopedTimer timer("startup/main window");
+    mainWindow = new MainWindow();
+  }
 
   // Set the icon for the main window title bar.
   // The icons shown by Windows on the desktop, in the explorer etc. are
@@ -81,7 +92,10 @@ bool Application::OnInit()
   mainWindow->SetIcon(icon);
 
   SetTopWindow(mainWindow);
-  mainWindow->Show();
+  {
+    ScopedTimer timer("startup/show");
+    mainWindow->Show();
+  }
 
 
   // After the vocal tract page and the vocal tract dialog were 
@@ -96,20 +110,70 @@ bool Application::OnInit()
   // VocalTractShapesDialog::getInstance()->setUpdateRequestReceiver(vocalTractDialog, // Removed
   //  mainWindow->acoustic3dPage);
   // Assuming VocalTractShapesDialog::setUpdateRequestReceiver might have an overload or needs adjustment
-  VocalTractShapesDialog::getInstance()->setUpdateRequestReceiver(nullptr, mainWindow->acoustic3dPage);
-  ParamSimu3DDialog::getInstance()->setUpdateRequestReceiver(mainWindow->acoustic3dPage);
+  // The dialogs are only created when they are used for the first time.
+  VocalTractShapesDialog::setUpdateRequestReceiver(nullptr, mainWindow->acoustic3dPage);
+  ParamSimu3DDialog::setUpdateRequestReceiver(mainWindow->acoustic3dPage);
   // AnnotationDialog::getInstance(NULL)->setUpdateRequestReceiver(NULL); // Removed
 
   // The vocal tract page always handles update requests from the LF pulse dialog.
-  LfPulseDialog::getInstance()->SetParent(mainWindow->acoustic3dPage);
+  LfPulseDialog::setUpdateRequestReceiver(mainWindow->acoustic3dPage);
 
   // Show the vocal tract dialog by default.
   // vocalTractDialog->SetParent(mainWindow); // Removed
   // vocalTractDialog->Show(true); // Removed
 
+  Profiler::getInstance().addTime("startup", startTime, 
+    Profiler::getInstance().now() - startTime);
+  printStartupTimes();
+
   return true;
 }
 
+
+// ****************************************************************************
+/// Prints the times of the start-up phases and disables the profiler again,
+/// which is only enabled on demand for the simulations.
+// ****************************************************************************
+
+void Application::printStartupTimes()
+{
+  Profiler &profiler = Profiler::getInstance();
+  map<string, Profiler::phaseStats> phases = profiler.phases();
+  map<string, Profiler::phaseStats>::iterator it;
+
+  wxPrintf("Start-up times:\n");
+  for (it = phases.begin(); it != phases.end(); ++it)
+  {
+    if (it->first.compare(0, 7, "startup") == 0)
+    {
+      wxPrintf("  %s: %.1f ms\n", it->first.c_str(), it->second.total * 1000.0);
+    }
+  }
+
+  profiler.setEnabled(false);
+  profiler.clear();
+}
+
+
+// ****************************************************************************
+/// Calls the event handlers, measuring their duration in the GUI timings
+/// when they are enabled. A handler which runs the event loop (e.g., a modal
+/// dialog) includes the times of the handlers called meanwhile.
+// ****************************************************************************
+
+void Application::HandleEvent(wxEvtHandler *handler, wxEventFunction func,
+  wxEvent &event) const
+{
+  if (!GuiTimings::getInstance().isEnabled())
+  {
+    wxApp::HandleEvent(handler, func, event);
+    return;
+  }
+
+  GuiTimer timer(GuiTimings::handlerName(handler, event));
+  wxApp::HandleEvent(handler, func, event);
+}
+
 // ****************************************************************************
 // ****************************************************************************
 
@@ -34,6 +34,11 @@ public:
 #endif
 
   void createConsole();
+  void printStartupTimes();
+
+  // Times the event handlers when the GUI timings are enabled
+  virtual void HandleEvent(wxEvtHandler *handler, wxEventFunction func,
+    wxEvent &event) const;
 };
 
 DECLARE_APP(Application)
@@ -111,7 +111,7 @@ void AreaFunctionPicture::draw(wxDC &dc)
 {
   int i;
   VocalTract *tract = Data::getInstance()->vocalTract;
-  TlModel *model = Data::getInstance()->tlModel;
+  TlModel *model = Data::getInstance()->getTlModel();
   Tube::Section *ts = NULL;
   Graph *graph = NULL;
   int lastY;
@@ -0,0 +1,301 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rémi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#include "Acoustic3dApi.h"
+#include "Acoustic3dSimulation.h"
+#include "SimulationParametersFile.h"
+#include <string>
+#include <functional>
+#include <utility>
+
+// ****************************************************************************
+// A simulation and the geometry file it was created from (empty for a 
+// geometry given as arrays).
+// ****************************************************************************
+
+struct Vtl3dSimulation
+{
+  Acoustic3dSimulation simu;
+  string geometryFileName;
+};
+
+// ****************************************************************************
+// Reads the parameters, then imports the geometry set by setGeometry in the 
+// simulation. Returns NULL and deletes the simulation in case of failure.
+
+static Vtl3dSimulation *initSimulation(Vtl3dSimulation *simulation,
+  const char *parameterFileName, 
+  const function<void(Acoustic3dSimulation&)>& setGeometry)
+{
+  Acoustic3dSimulation &simu(simulation->simu);
+
+  struct simulationSetup setup(getSimulationSetup(simu));
+  string error;
+  if ((parameterFileName != NULL) && (string(parameterFileName) != "-") &&
+    !readSimulationParametersFile(parameterFileName, setup, error))
+  {
+    delete simulation;
+    return NULL;
+  }
+  applySimulationSetup(simu, setup);
+
+  // the vocal tract is not used for an imported geometry
+  simu.requestReloadGeometry();
+  simu.setGeometryImported(true);
+  simu.setContourInterpolationMethod(FROM_FILE);
+  setGeometry(simu);
+  if (!simu.importGeometry(NULL) || (simu.numberOfSegments() == 0))
+  {
+    delete simulation;
+    return NULL;
+  }
+
+  // the import sets the bounding box of the field to the one of the geometry
+  if (setup.bboxSpecified)
+  {
+    pair<Point2D, Point2D> bbox(
+      Point2D(setup.simuParams.bbox[0].x(), setup.simuParams.bbox[0].y()),
+      Point2D(setup.simuParams.bbox[1].x(), setup.simuParams.bbox[1].y()));
+    simu.setBoundingBox(bbox);
+  }
+
+  return simulation;
+}
+
+// ****************************************************************************
+
+Vtl3dSimulation *vtl3dCreateSimulation(const char *geometryFileName,
+  const char *parameterFileName)
+{
+  Vtl3dSimulation *simulation = new Vtl3dSimulation;
+  simulation->geometryFileName = geometryFileName;
+
+  return initSimulation(simulation, parameterFileName,
+    [simulation](Acoustic3dSimulation& simu)
+    { simu.setGeometryFile(simulation->geometryFileName); });
+}
+
+// ****************************************************************************
+
+Vtl3dSimulation *vtl3dCreateSimulationFromArrays(int numSections,
+  const double *centerLine, const double *normals, const double *scalingFactors,
+  const int *contourOffsets, const double *points, const int *surfaceIdx,
+  const char *parameterFileName)
+{
+  if ((numSections < 2) || (centerLine == NULL) || (normals == NULL) ||
+    (contourOffsets == NULL) || (points == NULL) || (contourOffsets[0] != 0))
+  {
+    return NULL;
+  }
+  for (int i(0); i < numSections; i++)
+  {
+    if (contourOffsets[i + 1] < contourOffsets[i]) { return NULL; }
+  }
+
+  struct geometryArrays geo;
+  int numPoints(contourOffsets[numSections]);
+  geo.centerLine.assign(centerLine, centerLine + 2 * numSections);
+  geo.normals.assign(normals, normals + 2 * numSections);
+  if (scalingFactors != NULL)
+  {
+    geo.scalingFactors.assign(scalingFactors, scalingFactors + 2 * numSections);
+  }
+  else
+  {
+    geo.scalingFactors.assign(2 * numSections, 1.);
+  }
+  geo.points.assign(points, points + 2 * numPoints);
+  geo.contourOffsets.assign(contourOffsets, contourOffsets + numSections + 1);
+  if (surfaceIdx != NULL)
+  {
+    geo.surfaceIdx.assign(surfaceIdx, surfaceIdx + numPoints);
+  }
+  else
+  {
+    geo.surfaceIdx.assign(numPoints, 0);
+  }
+  geo.simplified = false;
+
+  return initSimulation(new Vtl3dSimulation, parameterFileName,
+    [&geo](Acoustic3dSimulation& simu) { simu.setGeometryArrays(move(geo)); });
+}
+
+// ****************************************************************************
+
+int vtl3dCloseSimulation(Vtl3dSimulation *simulation)
+{
+  if (simulation == NULL) { return 1; }
+  delete simulation;
+  return 0;
+}
+
+// ****************************************************************************
+
+int vtl3dSetCacheDirectory(Vtl3dSimulation *simulation, const char *directory)
+{
+  if (simulation == NULL) { return 1; }
+  simulation->simu.setCacheDirectory((directory == NULL) ? "" : directory);
+  return 0;
+}
+
+// ****************************************************************************
+
+int vtl3dSetLogFile(Vtl3dSimulation *simulation, const char *fileName)
+{
+  if (simulation == NULL) { return 1; }
+  simulation->simu.setLogFile((fileName == NULL) ? "" : fileName);
+  return 0;
+}
+
+// ****************************************************************************
+
+int vtl3dSetNumThreads(Vtl3dSimulation *simulation, int numThreads)
+{
+  if (simulation == NULL) { return 1; }
+
+  struct simulationSetup setup(getSimulationSetup(simulation->simu));
+  setup.simuParams.numThreads = (numThreads > 0) ? numThreads : threadPoolSize();
+  applySimulationSetup(simulation->simu, setup);
+  return 0;
+}
+
+// ****************************************************************************
+
+int vtl3dComputeTransferFunctions(Vtl3dSimulation *simulation)
+{
+  if (simulation == NULL) { return 1; }
+  simulation->simu.computeTransferFunction(NULL);
+  return 0;
+}
+
+// ****************************************************************************
+
+int vtl3dComputeAcousticField(Vtl3dSimulation *simulation, double freq)
+{
+  if (simulation == NULL) { return 1; }
+  simulation->simu.setAcousticFieldFreq(freq);
+  simulation->simu.computeAcousticField(NULL);
+  return 0;
+}
+
+// ****************************************************************************
+
+int vtl3dReEvaluateTransferFunctions(Vtl3dSimulation *simulation,
+  const char *tfPointsFileName)
+{
+  if (simulation == NULL) { return 1; }
+  if ((tfPointsFileName == NULL) ||
+    !simulation->simu.setTFPointsFromCsvFile(tfPointsFileName))
+  {
+    return 2;
+  }
+  if (!simulation->simu.reEvaluateTransferFunctions()) { return 3; }
+  return 0;
+}
+
+// ****************************************************************************
+
+int vtl3dGetFrequencies(Vtl3dSimulation *simulation, const double **freqs,
+  int *numFreqs)
+{
+  if (simulation == NULL) { return 1; }
+
+  const vector<double> &tfFreqs(simulation->simu.tfFreqs());
+  if (tfFreqs.empty()) { return 2; }
+  *freqs = tfFreqs.data();
+  *numFreqs = tfFreqs.size();
+  return 0;
+}
+
+// ****************************************************************************
+
+int vtl3dGetTransferFunctions(Vtl3dSimulation *simulation, int type,
+  const double **data, int *numFreqs, int *numPoints)
+{
+  if (simulation == NULL) { return 1; }
+
+  Acoustic3dSimulation &simu(simulation->simu);
+  if (simu.tfFreqs().empty()) { return 2; }
+
+  const Eigen::MatrixXcd *tf;
+  switch (type)
+  {
+  case 0: tf = &simu.glottalSourceTF(); break;
+  case 1: tf = &simu.noiseSourceTF(); break;
+  case 2: tf = &simu.planeModeInputImpedance(); break;
+  default:
+  {
+    int numSources(simu.noiseSourceSections().size());
+    int idxCondTf(type - 3 - numSources);
+    if ((type < 0) || (idxCondTf >= (1 + numSources) * 
+      (int)simu.extraGlottisBoundaryConds().size())) { return 3; }
+    if (idxCondTf < 0) { tf = &simu.noiseSourcesTf(type - 3); }
+    else { tf = &simu.glottisCondTf(idxCondTf / (1 + numSources), idxCondTf % (1 + numSources)); }
+    break;
+  }
+  }
+
+  // complex<double> is stored as two consecutive double values
+  *data = reinterpret_cast<const double*>(tf->data());
+  *numFreqs = tf->rows();
+  *numPoints = tf->cols();
+  return 0;
+}
+
+// ****************************************************************************
+
+int vtl3dGetAcousticField(Vtl3dSimulation *simulation, const double **data,
+  int *numRows, int *numCols)
+{
+  if (simulation == NULL) { return 1; }
+
+  const Eigen::MatrixXcd &field(simulation->simu.fieldValues());
+  if (field.size() == 0) { return 2; }
+  *data = reinterpret_cast<const double*>(field.data());
+  *numRows = field.rows();
+  *numCols = field.cols();
+  return 0;
+}
+
+// ****************************************************************************
+
+int vtl3dGetModes(Vtl3dSimulation *simulation, int segment, const double **modes,
+  const double **points, int *numPoints, int *numModes)
+{
+  if (simulation == NULL) { return 1; }
+
+  Acoustic3dSimulation &simu(simulation->simu);
+  if ((segment < 0) || (segment >= simu.numberOfSegments())) { return 3; }
+
+  CrossSection2d *section(simu.crossSection(segment));
+  if (!section->areModesComputed() || (section->getModes().size() == 0) ||
+    (section->getPoints().size() != section->getModes().rows()))
+  {
+    return 2;
+  }
+
+  // the coordinates of a vertex are two consecutive double values
+  *modes = section->getModes().data();
+  *points = section->getPoints()[0].data();
+  *numPoints = section->getModes().rows();
+  *numModes = section->getModes().cols();
+  return 0;
+}
@@ -0,0 +1,253 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rémi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#ifndef __ACOUSTIC_3D_API_H__
+#define __ACOUSTIC_3D_API_H__
+
+// ****************************************************************************
+// C-compatible functions of the 3D acoustic simulation, in the same form as
+// the ones of VocalTractLabApi.h (which does not depend on the 3D simulation).
+//
+// The results are not copied: the functions vtl3dGet... return pointers to
+// the memory of the simulation, which remain valid until the next
+// computation or until the simulation is closed. The complex matrices are
+// stored in column-major order with interleaved real and imaginary parts,
+// so that they can be wrapped without copy, e.g. with NumPy:
+//   np.ctypeslib.as_array(data, (2 * numRows * numCols,)).view(np.complex128)
+//     .reshape((numRows, numCols), order='F')
+// The computations do not call back into the caller, so that bindings such
+// as ctypes release the interpreter lock while they run. Several
+// simulations can be computed concurrently in different threads, but a
+// simulation must only be used by one thread at a time.
+// ****************************************************************************
+
+#include "VocalTractLabApi.h"
+
+#ifdef __cplusplus
+extern "C"{ /* start extern "C" */
+#endif
+
+// Opaque handle of a 3D simulation (see vtl3dCreateSimulation()).
+
+typedef struct Vtl3dSimulation Vtl3dSimulation;
+
+// ****************************************************************************
+// Creates a simulation of a geometry file (csv, binary or STL file) with the
+// parameters of a parameter file (see SimulationParametersFile.h).
+//
+// Parameters (in/out):
+// o geometryFileName (in): The geometry file.
+// o parameterFileName (in): The parameter file, or NULL or "-" to keep the
+//     default parameters.
+//
+// Return value: the new simulation, or NULL if the parameter file or the
+// geometry cannot be read.
+// ****************************************************************************
+
+C_EXPORT Vtl3dSimulation *vtl3dCreateSimulation(const char *geometryFileName,
+  const char *parameterFileName);
+
+
+// ****************************************************************************
+// Creates a simulation of a geometry given as arrays, with the same data as
+// a geometry file, so that generated geometries do not need to be written
+// in files. The arrays are copied.
+//
+// Parameters (in/out):
+// o numSections (in): The number of sections N (at least 2).
+// o centerLine (in): The centerline points (x, y) of the sections [2N].
+// o normals (in): The normals (x, y) of the centerline [2N].
+// o scalingFactors (in): The scaling factors of the entrance and the exit of 
+//     the sections [2N], or NULL for no scaling.
+// o contourOffsets (in): The index in points of the first point of the 
+//     contour of each section, and the total number of points P [N + 1].
+// o points (in): The points (x, y) of the contours [2P], in the coordinates 
+//     of the sections as in the csv files.
+// o surfaceIdx (in): The surface index of each contour point [P], or NULL
+//     for the index 0.
+// o parameterFileName (in): The parameter file, or NULL or "-" to keep the
+//     default parameters.
+//
+// Return value: the new simulation, or NULL if the parameter file cannot be
+// read or the arrays do not describe a geometry.
+// ****************************************************************************
+
+C_EXPORT Vtl3dSimulation *vtl3dCreateSimulationFromArrays(int numSections,
+  const double *centerLine, const double *normals, const double *scalingFactors,
+  const int *contourOffsets, const double *points, const int *surfaceIdx,
+  const char *parameterFileName);
+
+
+// ****************************************************************************
+// Releases a simulation created with vtl3dCreateSimulation().
+// Return values:
+// 0: success.
+// 1: The simulation is NULL.
+// ****************************************************************************
+
+C_EXPORT int vtl3dCloseSimulation(Vtl3dSimulation *simulation);
+
+
+// ****************************************************************************
+// Sets the directory of the cache of the modes and junction matrices (NULL
+// or an empty string to disable it) and the number of threads of the
+// frequency sweep, which are taken from the thread pool of the library (all
+// the workers of the pool for numThreads <= 0, see vtlSetThreadPool()).
+// Return values:
+// 0: success.
+// 1: The simulation is NULL.
+// ****************************************************************************
+
+C_EXPORT int vtl3dSetCacheDirectory(Vtl3dSimulation *simulation,
+  const char *directory);
+
+C_EXPORT int vtl3dSetNumThreads(Vtl3dSimulation *simulation, int numThreads);
+
+// ****************************************************************************
+// Sets the log file of the simulation (NULL or an empty string for the log 
+// file of the library), so that the simulations computed at the same time 
+// write separate logs. The log file is cleared when the simulation starts a 
+// computation.
+// Return values:
+// 0: success.
+// 1: The simulation is NULL.
+// ****************************************************************************
+
+C_EXPORT int vtl3dSetLogFile(Vtl3dSimulation *simulation, const char *fileName);
+
+
+// ****************************************************************************
+// Computes the transfer functions at the points of the parameter file, or
+// the acoustic field at the frequency freq (Hz) in the bounding box of the
+// parameter file.
+// Return values:
+// 0: success.
+// 1: The simulation is NULL.
+// ****************************************************************************
+
+C_EXPORT int vtl3dComputeTransferFunctions(Vtl3dSimulation *simulation);
+
+C_EXPORT int vtl3dComputeAcousticField(Vtl3dSimulation *simulation, double freq);
+
+
+// ****************************************************************************
+// Recomputes the transfer functions at the points of a csv file (one point 
+// x, y, z per line, as the points of the parameter file) from the velocities
+// at the exit stored by the last vtl3dComputeTransferFunctions(), without
+// propagating again. All the points must be outside the geometry.
+// Return values:
+// 0: success.
+// 1: The simulation is NULL.
+// 2: The file cannot be read.
+// 3: The transfer functions cannot be re-evaluated (not computed, or some
+//    points are inside the geometry): they must be computed again.
+// ****************************************************************************
+
+C_EXPORT int vtl3dReEvaluateTransferFunctions(Vtl3dSimulation *simulation,
+  const char *tfPointsFileName);
+
+
+// ****************************************************************************
+// Returns the frequencies (Hz) of the transfer functions.
+//
+// Parameters (in/out):
+// o freqs (out): The numFreqs frequencies.
+// o numFreqs (out): The number of frequencies.
+//
+// Function return value:
+// 0: success.
+// 1: The simulation is NULL.
+// 2: The transfer functions have not been computed.
+// ****************************************************************************
+
+C_EXPORT int vtl3dGetFrequencies(Vtl3dSimulation *simulation,
+  const double **freqs, int *numFreqs);
+
+
+// ****************************************************************************
+// Returns a complex matrix of the transfer functions (frequencies x points).
+//
+// Parameters (in/out):
+// o type (in): 0 for the glottal source transfer functions, 1 for the
+//     noise source transfer functions, 2 for the plane mode input
+//     impedance (one column, to multiply by j 2 pi f rho to obtain the
+//     acoustic impedance), k + 3 for the transfer functions of the k-th
+//     additional noise source, then for each extra glottis boundary 
+//     condition, the noise source and the additional noise sources computed
+//     with this condition.
+// o data (out): The complex values (see the top of this file).
+// o numFreqs (out): The number of rows.
+// o numPoints (out): The number of columns.
+//
+// Function return value:
+// 0: success.
+// 1: The simulation is NULL.
+// 2: The transfer functions have not been computed.
+// 3: Wrong type.
+// ****************************************************************************
+
+C_EXPORT int vtl3dGetTransferFunctions(Vtl3dSimulation *simulation, int type,
+  const double **data, int *numFreqs, int *numPoints);
+
+
+// ****************************************************************************
+// Returns the acoustic field of the last computation as a complex matrix of
+// numRows (y) x numCols (x) values.
+//
+// Function return value:
+// 0: success.
+// 1: The simulation is NULL.
+// 2: The field has not been computed (or only written in a stream file).
+// ****************************************************************************
+
+C_EXPORT int vtl3dGetAcousticField(Vtl3dSimulation *simulation,
+  const double **data, int *numRows, int *numCols);
+
+
+// ****************************************************************************
+// Returns the transverse modes of a segment.
+//
+// Parameters (in/out):
+// o segment (in): The index of the segment.
+// o modes (out): The real matrix of the modes (numPoints x numModes,
+//     column-major) at the vertices of the mesh.
+// o points (out): The coordinates (x, y) of the numPoints vertices (cm).
+// o numPoints (out): The number of vertices of the mesh.
+// o numModes (out): The number of modes.
+//
+// Function return value:
+// 0: success.
+// 1: The simulation is NULL.
+// 2: The modes have not been computed.
+// 3: Wrong segment index.
+// ****************************************************************************
+
+C_EXPORT int vtl3dGetModes(Vtl3dSimulation *simulation, int segment,
+  const double **modes, const double **points, int *numPoints, int *numModes);
+
+
+// ****************************************************************************
+
+#ifdef __cplusplus
+} /* end extern "C" */
+#endif
+
+#endif
@@ -24,14 +24,29 @@
 #include "Dsp.h"
 #include "TlModel.h"
 #include "TdsModel.h"
+#include "ParallelLoop.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include "PolygonClipping.h"
+#include "SimdKernels.h"
+#include "VtkWriter.h"
+#include "WaveFile.h"
 #include <algorithm>
+#include <numeric>
 #include <chrono>    // to get the computation time
 #include <ctime>  
 #include <string>
+#include <sstream>
+#include <cstdlib>
+#include <cstdio>
 #include <regex>
+#include <thread>
+#include <atomic>
+#include <mutex>
 
 // for Eigen
 #include <Eigen/Dense>
+#include <unsupported/Eigen/FFT>
 
 // for CGAL
 #include "Delaunay_mesh_vertex_base_with_info_2.h"
@@ -108,6 +123,117 @@ void gaussPointsFromMesh(vector<Point> &pts, vector<double> & areaFaces, const C
   }
 }
 
+// ****************************************************************************
+// Same from the compact arrays of the mesh of a cross-section
+
+void gaussPointsFromMesh(vector<Point>& pts, vector<double>& areaFaces,
+  const vector<array<double, 2>>& points, const vector<array<int, 3>>& triangles)
+{
+  double quadPtCoord[3][2]{ {1. / 6., 1. / 6.}, {2. / 3., 1. / 6.}, {1. / 6., 2. / 3.} };
+
+  pts.clear();
+  pts.reserve(3 * triangles.size());
+  areaFaces.clear();
+  areaFaces.reserve(triangles.size());
+
+  for (const array<int, 3>& face : triangles)
+  {
+    const array<double, 2>& A(points[face[0]]);
+    const array<double, 2>& B(points[face[1]]);
+    const array<double, 2>& C(points[face[2]]);
+
+    // compute the area of the face
+    areaFaces.push_back(abs(A[0] * (B[1] - C[1]) + B[0] * (C[1] - A[1])
+      + C[0] * (A[1] - B[1])) / 2);
+
+    // create the Gauss integration points
+    for (int g(0); g < 3; g++)
+    {
+      pts.push_back(Point(
+        (1 - quadPtCoord[g][0] - quadPtCoord[g][1]) * A[0]
+          + quadPtCoord[g][0] * B[0] + quadPtCoord[g][1] * C[0],
+        (1 - quadPtCoord[g][0] - quadPtCoord[g][1]) * A[1]
+          + quadPtCoord[g][0] * B[1] + quadPtCoord[g][1] * C[1]));
+    }
+  }
+}
+
+// ****************************************************************************
+// Generate the Gauss integration points of a mesh with their weights, the 
+// points of the faces whose area is zero are not generated
+
+void gaussQuadratureFromMesh(vector<Point>& pts, Eigen::VectorXd& weights, 
+  const CDT& cdt)
+{
+  static thread_local vector<Point> facePts;
+  static thread_local vector<double> areaFaces;
+  int numPts(0);
+
+  gaussPointsFromMesh(facePts, areaFaces, cdt);
+
+  pts.clear();
+  pts.reserve(facePts.size());
+  weights.resize(facePts.size());
+  for (int f(0); f < areaFaces.size(); f++)
+  {
+    if (areaFaces[f] != 0.)
+    {
+      for (int g(0); g < 3; g++)
+      {
+        pts.push_back(facePts[3 * f + g]);
+        weights(numPts) = areaFaces[f] / 3.;
+        numPts++;
+      }
+    }
+  }
+  weights.conservativeResize(numPts);
+}
+
+// ****************************************************************************
+// Mesh the inside of a polygon and remove the faces which lie outside of it
+
+void meshPolygon(const Polygon_2& polygon, double spacing, CDT& cdt)
+{
+  cdt.clear();
+  cdt.insert_constraint(polygon.begin(), polygon.end(), true);
+  CGAL::refine_Delaunay_mesh_2(cdt, Criteria(0.125, spacing));
+
+  for (auto itF = cdt.finite_faces_begin();
+    itF != cdt.finite_faces_end(); ++itF)
+  {
+    if (!itF->is_in_domain())
+    {
+      cdt.delete_face(itF);
+    }
+  }
+}
+
+// ****************************************************************************
+// Parse a line of numbers separated by a separator character without 
+// exceptions. The parsing stops at the first empty field, the values 
+// before it are stored in values. Return false if a field is not a number.
+
+bool parseCsvLine(string& line, char separator, vector<double>& values)
+{
+  values.clear();
+
+  // remove the carriage return of the files written on Windows
+  if (!line.empty() && (line.back() == '\r')) { line.pop_back(); }
+
+  const char* str(line.c_str());
+  const char* end(str + line.size());
+  char* next;
+  while ((str < end) && (*str != separator))
+  {
+    values.push_back(strtod(str, &next));
+    if (next == str) { return false; }
+    while ((next < end) && isspace(*next)) { next++; }
+    if ((next < end) && (*next != separator)) { return false; }
+    str = next + 1;
+  }
+  return true;
+}
+
 // ****************************************************************************
 // Check if 2 contours are similar with a distance criterion
 
@@ -131,6 +257,95 @@ bool similarContours(Polygon_2& cont1, Polygon_2& cont2, double minDist)
   return similar;
 }
 
+// ****************************************************************************
+// Intersection of 2 contours, computed in double precision if floatClipping 
+// is true and the configuration is not degenerate, otherwise with the exact 
+// boolean operations of CGAL
+
+void intersectContours(const Polygon_2& cont1, const Polygon_2& cont2,
+  bool floatClipping, Pwh_list_2& intersections)
+{
+  if (floatClipping)
+  {
+    vector<ClipPoint> P, Q;
+    vector<vector<ClipPoint>> pieces;
+    for (auto it = cont1.vertices_begin(); it != cont1.vertices_end(); it++)
+    {
+      P.push_back({ it->x(), it->y() });
+    }
+    for (auto it = cont2.vertices_begin(); it != cont2.vertices_end(); it++)
+    {
+      Q.push_back({ it->x(), it->y() });
+    }
+
+    if (intersectPolygons(P, Q, pieces))
+    {
+      Profiler::getInstance().addCount("floating-point polygon clippings");
+      for (auto& piece : pieces)
+      {
+        Polygon_2 poly;
+        for (auto& pt : piece) { poly.push_back(Point(pt[0], pt[1])); }
+        intersections.push_back(Polygon_with_holes_2(poly));
+      }
+      return;
+    }
+    Profiler::getInstance().addCount("degenerate polygon clippings");
+  }
+  CGAL::intersection(cont1, cont2, back_inserter(intersections));
+}
+
+// ****************************************************************************
+// Smallest power of 2 larger or equal to n (efficient size for the FFT)
+
+int fftSize(int n)
+{
+  int size(1);
+  while (size < n) { size *= 2; }
+  return size;
+}
+
+// ****************************************************************************
+// In place 2D FFT (or inverse FFT) of data stored row by row in a n0 x n1 
+// array, computed by 1D FFTs of the rows and then of the columns
+
+void fft2d(Eigen::FFT<double>& fft, vector<complex<double>>& data, int n0, int n1,
+  bool inverse)
+{
+  vector<complex<double>> in, out;
+
+  in.resize(n1);
+  for (int i(0); i < n0; i++)
+  {
+    for (int j(0); j < n1; j++) { in[j] = data[i * n1 + j]; }
+    if (inverse) { fft.inv(out, in); }
+    else { fft.fwd(out, in); }
+    for (int j(0); j < n1; j++) { data[i * n1 + j] = out[j]; }
+  }
+
+  in.resize(n0);
+  for (int j(0); j < n1; j++)
+  {
+    for (int i(0); i < n0; i++) { in[i] = data[i * n1 + j]; }
+    if (inverse) { fft.inv(out, in); }
+    else { fft.fwd(out, in); }
+    for (int i(0); i < n0; i++) { data[i * n1 + j] = out[i]; }
+  }
+}
+
+// ****************************************************************************
+// Interpolation between two complex values which is linear for the logarithm 
+// of the magnitude and for the phase (following the shortest path), so that 
+// it follows the transfer functions between resonances
+
+complex<double> logInterpolation(complex<double> v0, complex<double> v1, double t)
+{
+  if ((abs(v0) == 0.) || (abs(v1) == 0.))
+  {
+    return (1. - t) * v0 + t * v1;
+  }
+  return v0 * exp(t * log(v1 / v0));
+}
+
 // ****************************************************************************
 // Constructor.
 // ****************************************************************************
@@ -139,6 +354,14 @@ Acoustic3dSimulation::Acoustic3dSimulation()
 // initialise the physical constants
   : m_geometryImported(false),
   m_reloadGeometry(true),
+  m_storeAxialProfile(true),
+  m_logFile(""),
+  m_cacheDirectory(""),
+  m_tfStreamFile(""),
+  m_fieldStreamFile(""),
+  m_resumeTf(false),
+  m_distributedSweepDirectory(""),
+  m_fieldVersion(0),
   m_meshDensity(5.),
   m_idxSecNoiseSource(25), // for /sh/ 212, for vowels 25
   m_glottisBoundaryCond(IFINITE_WAVGUIDE),
@@ -151,6 +374,25 @@ Acoustic3dSimulation::Acoustic3dSimulation()
   m_simuParams.numIntegrationStep = 3;
   m_simuParams.orderMagnusScheme = 2;
   m_simuParams.maxCutOnFreq = 20000.;
+  m_simuParams.freqDependentModes = false;
+  m_simuParams.modesFreqFactor = 2.;
+  m_simuParams.modesFreqMargin = 2000.;
+  m_simuParams.hybridPlaneWave = false;
+  m_simuParams.hybridCrossoverFactor = 0.5;
+  m_simuParams.hybridBlendWidth = 0.2;
+  m_hybridBand[0] = 0.;
+  m_hybridBand[1] = 0.;
+  m_simuParams.shareScaledModes = false;
+  m_simuParams.adaptiveMeshDensity = false;
+  m_simuParams.meshFreqAccuracy = 0.01;
+  m_simuParams.analyticModes = false;
+  m_simuParams.warmStartModes = false;
+  m_simuParams.coarseningTolerance = 0.;
+  m_simuParams.floatPolygonClipping = false;
+  m_simuParams.adaptiveIntegrationStep = false;
+  m_simuParams.integrationStepTolerance = 1e-3;
+  m_simuParams.singlePrecisionPropagation = false;
+  m_simuParams.axialCheckpointInterval = 1;
   m_simuParams.propMethod = MAGNUS;
   m_simuParams.viscoThermalLosses = true;
   m_simuParams.wallLosses = true;
@@ -166,10 +408,15 @@ Acoustic3dSimulation::Acoustic3dSimulation()
   m_simuParams.radImpedPrecomputed = false;
   m_simuParams.radImpedGridDensity = 15.;
   m_simuParams.integrationMethodRadiation = GAUSS;
+  m_simuParams.integrationMethodRadImped = POLAR_GRID;
 
   // for transfer function computation
   m_simuParams.maxComputedFreq = 10000.; // (double)SAMPLING_RATE / 2.;
   m_simuParams.spectrumLgthExponent = 10;
+  m_simuParams.numThreads = threadPoolSize();
+  m_simuParams.memoryBudget = 0.;
+  m_simuParams.adaptiveFreqSampling = false;
+  m_simuParams.adaptiveTfTolerance = 0.5;
   m_simuParams.tfPoint.push_back(Point_3(3., 0., 0.));
 
   // for acoustic field computation
@@ -179,6 +426,8 @@ Acoustic3dSimulation::Acoustic3dSimulation()
   m_simuParams.fieldIndB = true;
   m_simuParams.fieldResolution = 30;
   m_simuParams.fieldResolutionPicture = 30;
+  m_simuParams.progressiveFieldLevels = 0;
+  m_simuParams.fieldRefinementTolerance = 0.02;
   m_simuParams.computeRadiatedField = false;
   m_simuParams.computeFieldImage = true;
 
@@ -188,6 +437,7 @@ Acoustic3dSimulation::Acoustic3dSimulation()
   m_minAmpField = -1.;
   m_maxPhaseField = 0.;
   m_minPhaseField = 0.;
+  m_fieldInMemory = true;
 
   m_numFreq = 1 << (m_simuParams.spectrumLgthExponent - 1);
   m_numFreqPicture = m_numFreq;
@@ -247,6 +497,10 @@ Acoustic3dSimulation::~Acoustic3dSimulation(){}
 
 // ****************************************************************************
 // Static data.
+//
+// The static instance is only a convenience for the GUI, independant 
+// simulations (e.g. for batch processing of several geometries) can be 
+// created with the constructor.
 // ****************************************************************************
 
 Acoustic3dSimulation *Acoustic3dSimulation::instance = NULL;
@@ -269,14 +523,29 @@ Acoustic3dSimulation *Acoustic3dSimulation::getInstance()
 // Set computation parameters
 
 void Acoustic3dSimulation::setSimulationParameters(double meshDensity,
-  int secNoiseSource, struct simulationParameters simuParams, 
+  int secNoiseSource, const struct simulationParameters& simuParams, 
   enum openEndBoundaryCond cond, enum contourInterpolationMethod scalingMethod)
 {
+  bool ambientChanged((simuParams.sndSpeed != m_simuParams.sndSpeed) ||
+    (simuParams.volumicMass != m_simuParams.volumicMass));
+
+  // if the sound speed changes but not the parameters of the mesh and of the
+  // modes, the modes and the junction matrices are kept
+  if ((simuParams.sndSpeed != m_simuParams.sndSpeed) && (meshDensity == m_meshDensity)
+    && (simuParams.maxCutOnFreq == m_simuParams.maxCutOnFreq)
+    && (simuParams.analyticModes == m_simuParams.analyticModes)
+    && !simuParams.adaptiveMeshDensity && !m_simuParams.adaptiveMeshDensity)
+  {
+    rescaleModesSoundSpeed(simuParams.sndSpeed);
+  }
+
   m_meshDensity = meshDensity;
   m_idxSecNoiseSource = secNoiseSource;
   m_mouthBoundaryCond = cond;
   m_contInterpMeth = scalingMethod;
   m_simuParams = simuParams;
+  // the radiation impedance depends on the sound speed and the volumic mass
+  if (ambientChanged) { m_simuParams.radImpedPrecomputed = false; }
 
   m_numFreq = 1 << (m_simuParams.spectrumLgthExponent - 1);
 
@@ -294,19 +563,22 @@ void Acoustic3dSimulation::generateLogFileHeader(bool cleanLog) {
   double freqSteps((double)SAMPLING_RATE / 2. / (double)m_numFreq);
   int numFreqComputed((int)ceil(m_simuParams.maxComputedFreq / freqSteps));
 
-  ofstream log;
   if (cleanLog) {
-    log.open("log.txt", ofstream::out | ofstream::trunc);
-    log.close();
+    Logger::getInstance().clearFile(m_logFile);
   }
 
-  log.open("log.txt", ofstream::app);
+  LogStream log(m_logFile);
 
   // print the date of the simulation
   time_t start_time = std::chrono::system_clock::to_time_t(chrono::system_clock::now());
   log << ctime(&start_time) << endl;
 
-  if (m_geometryImported)
+  if (m_geometryImported && (m_geometryArrays || m_geometryMesh))
+  {
+    log << "Geometry imported from " << (m_geometryArrays ? "arrays" : "a mesh")
+      << " in memory" << endl;
+  }
+  else if (m_geometryImported)
   {
     log << "Geometry imported from csv file:\n  " << m_geometryFile << endl;
   }
@@ -369,6 +641,17 @@ void Acoustic3dSimulation::generateLogFileHeader(bool cleanLog) {
       break;
     }
     log << endl;
+    log << "Radiation impedance integration method: ";
+    switch (m_simuParams.integrationMethodRadImped)
+    {
+    case POLAR_GRID:
+      log << "POLAR_GRID";
+      break;
+    case FFT_CONVOLUTION:
+      log << "FFT_CONVOLUTION";
+      break;
+    }
+    log << endl;
     log << "Radiation impedance precomputed: ";
     if (m_simuParams.radImpedPrecomputed)
     {
@@ -397,6 +680,43 @@ void Acoustic3dSimulation::generateLogFileHeader(bool cleanLog) {
   log << "MODE COMPUTATION PARAMETERS:" << endl;
   log << "Mesh density: " << m_meshDensity << endl;
   log << "Max cut-on frequency: " << m_simuParams.maxCutOnFreq << " Hz" << endl;
+  if (m_simuParams.freqDependentModes)
+  {
+    log << "Coupled modes: cut-on frequency < " << m_simuParams.modesFreqFactor 
+      << " x frequency + " << m_simuParams.modesFreqMargin << " Hz" << endl;
+  }
+  if (m_simuParams.hybridPlaneWave)
+  {
+    log << "Hybrid sweep: plane wave below " << m_simuParams.hybridCrossoverFactor 
+      << " x lowest cut-on frequency, blending band relative width " 
+      << m_simuParams.hybridBlendWidth << endl;
+  }
+  if (m_simuParams.shareScaledModes)
+  {
+    log << "Modes shared between contours identical up to a scaling" << endl;
+  }
+  if (m_simuParams.adaptiveMeshDensity)
+  {
+    log << "Adaptive mesh density, relative eigenfrequency accuracy: " 
+      << m_simuParams.meshFreqAccuracy << endl;
+  }
+  if (m_simuParams.analyticModes)
+  {
+    log << "Analytic modes for circular and rectangular contours" << endl;
+  }
+  if (m_simuParams.warmStartModes)
+  {
+    log << "Eigensolver started from the modes of the previous segment" << endl;
+  }
+  if (m_simuParams.coarseningTolerance > 0.)
+  {
+    log << "Similar slices merged, tolerance: " 
+      << m_simuParams.coarseningTolerance << " cm" << endl;
+  }
+  if (m_simuParams.floatPolygonClipping)
+  {
+    log << "Intersections of the contours computed in double precision" << endl;
+  }
   log << "Compute modes and junction matrices: ";
   if (m_simuParams.needToComputeModesAndJunctions) { log << "YES"; }
   else { log << "NO"; }
@@ -409,6 +729,20 @@ void Acoustic3dSimulation::generateLogFileHeader(bool cleanLog) {
   case MAGNUS:
     log << "MAGNUS order " << m_simuParams.orderMagnusScheme << endl;
     log << "Number of integration steps: " << m_simuParams.numIntegrationStep << endl;
+    if (m_simuParams.adaptiveIntegrationStep)
+    {
+      log << "Adaptive number of integration steps, tolerance: " 
+        << m_simuParams.integrationStepTolerance << endl;
+    }
+    if (m_simuParams.singlePrecisionPropagation)
+    {
+      log << "Single precision propagation along the steps" << endl;
+    }
+    if (m_simuParams.axialCheckpointInterval > 1)
+    {
+      log << "Axial profile stored every " << m_simuParams.axialCheckpointInterval
+        << " integration points" << endl;
+    }
     break;
   case STRAIGHT_TUBES:
     log << "STRAIGHT_TUBES" << endl;
@@ -451,6 +785,21 @@ void Acoustic3dSimulation::generateLogFileHeader(bool cleanLog) {
 
   log << "TRANSFER FUNCTION COMPUTATION PARAMETERS:" << endl;
   log << "Index of noise source section: " << m_idxSecNoiseSource << endl;
+  if (m_noiseSourceSections.size() > 0)
+  {
+    log << "Additional noise source sections:";
+    for (auto sec : m_noiseSourceSections) { log << " " << sec; }
+    log << endl;
+  }
+  if (m_extraGlottisBoundaryConds.size() > 0)
+  {
+    log << "Additional glottis boundary conditions:";
+    for (auto cond : m_extraGlottisBoundaryConds)
+    {
+      log << ((cond == HARD_WALL) ? " HARD_WALL" : " IFINITE_WAVGUIDE");
+    }
+    log << endl;
+  }
   log << "Maximal computed frequency: " << m_simuParams.maxComputedFreq
     << " Hz" << endl;
   log << "Spectrum exponent " << m_simuParams.spectrumLgthExponent << endl;
@@ -458,6 +807,17 @@ void Acoustic3dSimulation::generateLogFileHeader(bool cleanLog) {
     << (double)SAMPLING_RATE / 2. / (double)(1 << (m_simuParams.spectrumLgthExponent - 1))
     << " Hz" << endl;
   log << "Number of simulated frequencies: " << numFreqComputed << endl;
+  log << "Number of threads: " << m_simuParams.numThreads << endl;
+  log << "Vectorised kernels: " << simdTarget() << endl;
+  if (m_simuParams.memoryBudget > 0.)
+  {
+    log << "Memory budget: " << m_simuParams.memoryBudget << " MB" << endl;
+  }
+  if (m_simuParams.adaptiveFreqSampling)
+  {
+    log << "Adaptive frequency sampling with tolerance " 
+      << m_simuParams.adaptiveTfTolerance << " dB" << endl;
+  }
   log << "Transfer function point (cm): " <<  endl;
   for (auto pt : m_simuParams.tfPoint)
   {
@@ -496,6 +856,12 @@ void Acoustic3dSimulation::generateLogFileHeader(bool cleanLog) {
   << " Hz with " << m_simuParams.fieldResolution << " points per cm" << endl;
   log << "Spatial resolution for field picture: " 
     << m_simuParams.fieldResolutionPicture << " points per cm" << endl;
+  if (m_simuParams.progressiveFieldLevels > 0)
+  {
+    log << "Progressive field computation from a grid " 
+      << (1 << m_simuParams.progressiveFieldLevels) << " times coarser, "
+      << "refinement tolerance " << m_simuParams.fieldRefinementTolerance << endl;
+  }
   log << "Bounding box:" << endl;
   log << "min x " << m_simuParams.bbox[0].x() << endl;
   log << "max x " << m_simuParams.bbox[1].x() << endl;
@@ -532,6 +898,7 @@ void Acoustic3dSimulation::addCrossSectionFEM(double area,
   m_crossSections.push_back(unique_ptr< CrossSection2d>(new CrossSection2dFEM(
     ctrLinePt, normal, area, spacing, contours, surfacesIdx,
     length, scalingFactors)));
+  clearSegmentGrid();
 }
 
 // ****************************************************************************
@@ -542,115 +909,476 @@ void Acoustic3dSimulation::addCrossSectionRadiation(Point2D ctrLinePt, Point2D n
   m_crossSections.push_back(unique_ptr< CrossSection2d>(new
     CrossSection2dRadiation(ctrLinePt, normal,
       radius, PMLThickness)));
+  clearSegmentGrid();
+}
+
+// ****************************************************************************
+// Return the spatial index of the segments in the sagittal plane, build it
+// if the geometry changed since the last call
+
+const SegmentGrid& Acoustic3dSimulation::segmentGrid()
+{
+  lock_guard<mutex> lock(m_segmentGridMutex);
+  if (!m_segmentGrid.isBuilt())
+  {
+    vector<CGAL::Bbox_2> boxes;
+    boxes.reserve(m_crossSections.size());
+    for (int i(0); i < m_crossSections.size(); i++)
+    {
+      boxes.push_back(m_crossSections[i]->sagittalBbox());
+    }
+    m_segmentGrid.build(boxes);
+  }
+  return m_segmentGrid;
+}
+
+// ****************************************************************************
+
+void Acoustic3dSimulation::clearSegmentGrid()
+{
+  lock_guard<mutex> lock(m_segmentGridMutex);
+  m_segmentGrid.clear();
 }
 
 // ****************************************************************************
 // create the meshes and compute the propagation modes
 void Acoustic3dSimulation::computeMeshAndModes()
 {
-  //ofstream mesh;
-  ofstream log;
-  log.open("log.txt", ofstream::app);
+  computeMeshAndModes(progressCallback());
+}
 
-  auto start = std::chrono::system_clock::now();
-  auto end = std::chrono::system_clock::now();
-  std::chrono::duration<double> elapsed_seconds = end - start;
+// ****************************************************************************
+// Compute the meshes and the modes of all the segments in parallel. 
+// If shareScaledModes is set, only the largest segment of each group of 
+// segments with contours identical up to a scaling is computed, the mesh 
+// and the modes of the others are obtained by scaling the ones of the 
+// largest segment. If warmStartModes is set, the eigensolver of a segment
+// starts from the modes of the previous one, which must be computed before.
+// The log of each segment is written once all the segments are computed,
+// in the order of the segments.
+
+bool Acoustic3dSimulation::computeMeshAndModes(const progressCallback& progress)
+{
+  int numSec(m_crossSections.size());
+  vector<ostringstream> segLogs(numSec);
+  vector<int> reference(numSec);
+  vector<double> scaling(numSec, 1.);
+  vector<int> computedSegs, scaledSegs, guessIdx, computedTask(numSec, -1);
+
+  iota(reference.begin(), reference.end(), 0);
+  if (m_simuParams.shareScaledModes) { findScaledContours(reference, scaling); }
+  for (int i(0); i < numSec; i++)
+  {
+    if (reference[i] == i) 
+    { 
+      computedTask[i] = computedSegs.size();
+      computedSegs.push_back(i); 
+    }
+    else { scaledSegs.push_back(i); }
+  }
+  findModesGuesses(reference, guessIdx);
 
-  for (int i(0); i < m_crossSections.size(); i++)
+  vector<vector<int>> dependencies(computedSegs.size());
+  for (int n(0); n < computedSegs.size(); n++)
   {
-    start = std::chrono::system_clock::now();
-    m_crossSections[i]->setSpacing(sqrt(m_crossSections[i]->area()) / m_meshDensity);
-    m_crossSections[i]->buildMesh();
-    end = std::chrono::system_clock::now();
-    elapsed_seconds = end - start;
-    log << "Seg " << i << " mesh, nb vertices: "
-      << m_crossSections[i]->numberOfVertices()
-      << " time: " << elapsed_seconds.count() << " s ";
+    if (guessIdx[computedSegs[n]] >= 0)
+    {
+      dependencies[n].push_back(computedTask[guessIdx[computedSegs[n]]]);
+    }
+  }
 
-    start = std::chrono::system_clock::now();
-    m_crossSections[i]->computeModes(m_simuParams);
-    end = std::chrono::system_clock::now();
-    elapsed_seconds = end - start;
-    log << m_crossSections[i]->numberOfModes() 
-      << " modes computed, time: "
-      << elapsed_seconds.count() << " s" << endl;
+  bool finished(parallelTaskGraph(computedSegs.size(), dependencies, 
+    m_simuParams.numThreads, [&](int n) 
+    { 
+      int i(computedSegs[n]);
+      computeMeshAndModes(i, segLogs[i], guessIdx[i]); 
+    }, progress));
+
+  if (finished)
+  {
+    parallelLoop(scaledSegs.size(), m_simuParams.numThreads, [&](int n)
+      {
+        int i(scaledSegs[n]);
+        scaleMeshAndModes(i, reference[i], scaling[i], segLogs[i]);
+      });
   }
 
+  LogStream log(m_logFile);
+  for (int i(0); i < numSec; i++)
+  {
+    log << segLogs[i].str();
+  }
+  if (!finished)
+  {
+    log << "Mesh and modes computation cancelled" << endl;
+  }
   log.close();
+
+  return finished;
 }
 
 // ****************************************************************************
 
 void Acoustic3dSimulation::computeMeshAndModes(int segIdx)
 {
-  ofstream log;
-  log.open("log.txt", ofstream::app);
+  LogStream log(m_logFile);
+  computeMeshAndModes(segIdx, log);
+  log.close();
+}
 
-  // generate mesh
+// ****************************************************************************
+// Segments whose eigensolver starts from the modes of another segment 
+// (guessIdx[i] = -1 for none) if warmStartModes is set: each computed 
+// segment starts from its previous segment if it is computed too. The 
+// segments are split into chains of consecutive segments, one chain per 
+// thread, so that the modes of the chains are still computed in parallel,
+// and the last segment, whose modes are needed first by the radiation 
+// impedance, is not delayed by its chain.
+
+void Acoustic3dSimulation::findModesGuesses(const vector<int>& reference, 
+  vector<int>& guessIdx) const
+{
+  int numSec(m_crossSections.size());
+  guessIdx.assign(numSec, -1);
+  if (!m_simuParams.warmStartModes) { return; }
+
+  vector<int> computedSegs;
+  for (int i(0); i < numSec; i++)
+  {
+    if ((reference[i] == i) && m_crossSections[i]->isFEM()) { computedSegs.push_back(i); }
+  }
+  int numChains(max(1, m_simuParams.numThreads));
+  int chainLength(max(2, (int)ceil((double)computedSegs.size() / numChains)));
+
+  for (int n(1); n < computedSegs.size(); n++)
+  {
+    int i(computedSegs[n]);
+    if ((n % chainLength != 0) && (i != numSec - 1) && 
+      (m_crossSections[i]->numPrevSec() > 0) &&
+      (m_crossSections[i]->prevSec(0) == computedSegs[n - 1]))
+    {
+      guessIdx[i] = computedSegs[n - 1];
+    }
+  }
+}
+
+// ****************************************************************************
+
+void Acoustic3dSimulation::computeMeshAndModes(int segIdx, ostream& log, int guessIdx)
+{
   auto start = std::chrono::system_clock::now();
-  m_crossSections[segIdx]->setSpacing(sqrt(m_crossSections[segIdx]->area()) / m_meshDensity);
-  m_crossSections[segIdx]->buildMesh();
+  m_crossSections[segIdx]->setSpacing(meshSpacing(segIdx));
+  bool isFEM(m_crossSections[segIdx]->isFEM());
+  bool isRadiation(m_crossSections[segIdx]->isRadiation());
+  CacheKey key(m_crossSections[segIdx]->modesCacheKey(m_simuParams));
+
+  // keep the modes if they have already been computed for the same contour
+  // and parameters
+  if (isFEM && m_crossSections[segIdx]->keepComputedModes(key))
+  {
+    log << "Sec " << segIdx << " unchanged, " 
+      << m_crossSections[segIdx]->numberOfModes() << " modes kept" << endl;
+    return;
+  }
+
+  // load the mesh and the modes from the cache if they have already been 
+  // computed for the same contour and parameters (the modes of the radiation
+  // section are only loaded if no section of the process has computed them)
+  bool useCache((m_cacheDirectory != "") && (isFEM || 
+    (isRadiation && !CrossSection2dRadiation::modesMemoised(key))));
+  string cacheFile;
+  if (useCache)
+  {
+    cacheFile = cacheFileName(m_cacheDirectory, "modes", key);
+    if (readCacheFile(cacheFile, [this, segIdx](istream& is) 
+      { return m_crossSections[segIdx]->readModes(is); }))
+    {
+      m_crossSections[segIdx]->setModesComputed(key);
+      if (isRadiation)
+      {
+        static_cast<CrossSection2dRadiation*>(m_crossSections[segIdx].get())->memoiseModes(key);
+      }
+      Profiler::getInstance().addCount("modes loaded from cache");
+      auto end = std::chrono::system_clock::now();
+      std::chrono::duration<double> elapsed_seconds = end - start;
+      log << "Sec " << segIdx << " mesh and " 
+        << m_crossSections[segIdx]->numberOfModes()
+        << " modes loaded from cache, time: " << elapsed_seconds.count() 
+        << " s" << endl;
+      return;
+    }
+  }
+
+  // generate mesh
+  {
+    ScopedTimer timer("meshing/segment " + to_string(segIdx));
+    m_crossSections[segIdx]->buildMesh(!m_simuParams.adaptiveMeshDensity);
+  }
   auto end = std::chrono::system_clock::now();
-  auto elapsed_seconds = end - start;
+  std::chrono::duration<double> elapsed_seconds = end - start;
   log << "Sec " << segIdx << " mesh, nb vertices: "
     << m_crossSections[segIdx]->numberOfVertices()
     << " time: " << elapsed_seconds.count() << " s ";
 
   // compute modes
   start = std::chrono::system_clock::now();
-  m_crossSections[segIdx]->computeModes(m_simuParams);
+  {
+    ScopedTimer timer("mode solve/segment " + to_string(segIdx));
+    if (guessIdx >= 0) { m_crossSections[segIdx]->setModesGuess(*m_crossSections[guessIdx]); }
+    m_crossSections[segIdx]->computeModes(m_simuParams);
+  }
   end = std::chrono::system_clock::now();
   elapsed_seconds = end - start;
   log << m_crossSections[segIdx]->numberOfModes()
     << " modes computed, time: "
     << elapsed_seconds.count() << " s" << endl;
+  if (isFEM) { m_crossSections[segIdx]->setModesComputed(key); }
 
-  log.close();
+  if (useCache && !writeCacheFile(cacheFile, [this, segIdx](ostream& os)
+    { m_crossSections[segIdx]->writeModes(os); }))
+  {
+    log << "Sec " << segIdx << " cannot write cache file " << cacheFile << endl;
+  }
 }
 
 // ****************************************************************************
-// Compute the junction matrices of a given segment
+// Spacing of the mesh of a segment. By default it is proportional to the 
+// size of the cross-section. With the adaptive mesh density, it is set so 
+// that the relative error on the eigenfrequencies of the linear elements,
+// approximately (k h)^2 / 24, is below meshFreqAccuracy at maxCutOnFreq,
+// with a minimal resolution of the contour.
 
-void Acoustic3dSimulation::computeJunctionMatrices(int segIdx)
+double Acoustic3dSimulation::meshSpacing(int segIdx) const
 {
-  int nModes, nModesNext;
-  vector<Matrix> matrixF;
-  Polygon_2 contour, nextContour, intersecCont;
-  double scaling[2];
-  int nextSec;
-  Vector ctlShift;
-  int idxMinArea;
-  Pwh_list_2 intersections;
-  double spacing;
-  vector<Point> pts;
-  vector<double> areaFaces;
-  CDT cdt;
-  Matrix interpolation1, interpolation2;
-  double quadPtWeight = 1. / 3.;
+  // minimal number of elements along the square root of the area
+  const double MIN_ADAPTIVE_MESH_DENSITY(3.);
 
-  if (m_crossSections[segIdx]->numNextSec() > 0)
-  {
-    nModes = m_crossSections[segIdx]->numberOfModes();
+  double size(sqrt(m_crossSections[segIdx]->area()));
 
-    matrixF.clear();
+  if (!m_simuParams.adaptiveMeshDensity) { return size / m_meshDensity; }
 
-    // get the contour of the current cross-section
-    contour.clear();
-    scaling[0] = m_crossSections[segIdx]->scaleOut();
-    Transformation scale(CGAL::SCALING, scaling[0]);
+  double k(2. * M_PI * m_simuParams.maxCutOnFreq / m_simuParams.sndSpeed);
+  double spacing(sqrt(24. * m_simuParams.meshFreqAccuracy) / k);
 
-    // The centerline at the end of the segment can be different from the one 
-    // at the beginning of the next segment
-    nextSec = m_crossSections[segIdx]->nextSec(0);
-    ctlShift = Vector(m_crossSections[nextSec]->ctrLinePtIn(),
-      m_crossSections[segIdx]->ctrLinePtOut());
-    ctlShift = Vector(0., ctlShift * m_crossSections[segIdx]->normalOut());
-    Transformation translate(CGAL::TRANSLATION, ctlShift);
+  return min(spacing, size / MIN_ADAPTIVE_MESH_DENSITY);
+}
 
-    contour = transform(translate, transform(scale, m_crossSections[segIdx]->contour()));
+// ****************************************************************************
+// Find the segments whose contour is the contour of another segment scaled 
+// uniformly (with respect to the centerline point, since the multimodal 
+// matrices depend on the position of the contour), within a tolerance 
+// relative to the size of the contour. For each group of such segments, 
+// reference gives the index of the largest segment of the group and scaling
+// the scaling of its contour to obtain the one of the segment.
+
+void Acoustic3dSimulation::findScaledContours(vector<int>& reference, 
+  vector<double>& scaling)
+{
+  // tolerance on the distance between scaled contour points relative to the
+  // square root of the area of the contour
+  const double SCALED_CONTOUR_TOLERANCE(1e-6);
 
-    // loop over the folowing connected cross-sections
-    for (int ns(0); ns < m_crossSections[segIdx]->numNextSec(); ns++)
+  int numSec(m_crossSections.size());
+  vector<Polygon_2> contours(numSec);
+  vector<vector<int>> surfaces(numSec);
+  vector<double> areas(numSec, 0.);
+  // group of each segment (-1 for radiation segments), and first segment of
+  // each group to which the contours are compared
+  vector<int> group(numSec, -1), firstSegs;
+
+  for (int i(0); i < numSec; i++)
+  {
+    reference[i] = i;
+    scaling[i] = 1.;
+    if (!m_crossSections[i]->isFEM()) { continue; }
+    contours[i] = m_crossSections[i]->contour();
+    surfaces[i] = m_crossSections[i]->surfaceIdx();
+    areas[i] = abs(contours[i].area());
+    if (areas[i] <= 0.) { continue; }
+
+    for (int g(0); g < firstSegs.size(); g++)
+    {
+      int f(firstSegs[g]);
+      if ((contours[f].size() != contours[i].size()) || (surfaces[f] != surfaces[i]))
+      {
+        continue;
+      }
+      double s(sqrt(areas[i] / areas[f]));
+      double tol(SCALED_CONTOUR_TOLERANCE * sqrt(areas[i]));
+      bool similar(true);
+      for (int v(0); (v < contours[i].size()) && similar; v++)
+      {
+        similar = (abs(contours[i][v].x() - s * contours[f][v].x()) < tol) &&
+          (abs(contours[i][v].y() - s * contours[f][v].y()) < tol);
+      }
+      if (similar) { group[i] = g; break; }
+    }
+    if (group[i] < 0)
+    {
+      group[i] = firstSegs.size();
+      firstSegs.push_back(i);
+    }
+  }
+
+  // the reference of a group is its largest segment, so that the scaled 
+  // segments need at most the modes of the reference
+  vector<int> largest(firstSegs);
+  for (int i(0); i < numSec; i++)
+  {
+    if ((group[i] >= 0) && (areas[i] > areas[largest[group[i]]])) 
+    { 
+      largest[group[i]] = i; 
+    }
+  }
+  for (int i(0); i < numSec; i++)
+  {
+    if (group[i] < 0) { continue; }
+    reference[i] = largest[group[i]];
+    scaling[i] = sqrt(areas[i] / areas[reference[i]]);
+  }
+}
+
+// ****************************************************************************
+// Set the mesh and the modes of a segment by scaling the ones of the 
+// reference segment, or compute them if it is not possible
+
+void Acoustic3dSimulation::scaleMeshAndModes(int segIdx, int refIdx, double scaling, 
+  ostream& log)
+{
+  m_crossSections[segIdx]->setSpacing(meshSpacing(segIdx));
+  CacheKey key(m_crossSections[segIdx]->modesCacheKey(m_simuParams));
+
+  if (m_crossSections[segIdx]->keepComputedModes(key))
+  {
+    log << "Sec " << segIdx << " unchanged, " 
+      << m_crossSections[segIdx]->numberOfModes() << " modes kept" << endl;
+    return;
+  }
+
+  if (m_crossSections[segIdx]->copyScaledModes(*m_crossSections[refIdx], scaling, 
+    m_simuParams.maxCutOnFreq))
+  {
+    m_crossSections[segIdx]->setModesComputed(key);
+    Profiler::getInstance().addCount("modes scaled from another segment");
+    log << "Sec " << segIdx << " mesh and " 
+      << m_crossSections[segIdx]->numberOfModes() << " modes scaled from sec "
+      << refIdx << " (scaling " << scaling << ")" << endl;
+  }
+  else
+  {
+    computeMeshAndModes(segIdx, log);
+  }
+}
+
+// ****************************************************************************
+// Key of the cache entry of the junction matrices of a segment: they depend
+// on the modes of the segment and of the following segments, and on the 
+// relative position and scaling of their contours
+
+CacheKey Acoustic3dSimulation::junctionCacheKey(int segIdx) const
+{
+  CacheKey key;
+  int nextSec;
+
+  key.add(m_crossSections[segIdx]->modesCacheKey(m_simuParams));
+  key.add(m_crossSections[segIdx]->isJunction());
+  key.add(m_crossSections[segIdx]->scaleOut());
+  key.add(m_crossSections[segIdx]->ctrLinePtOut().x());
+  key.add(m_crossSections[segIdx]->ctrLinePtOut().y());
+  key.add(m_crossSections[segIdx]->normalOut().x());
+  key.add(m_crossSections[segIdx]->normalOut().y());
+
+  for (int ns(0); ns < m_crossSections[segIdx]->numNextSec(); ns++)
+  {
+    nextSec = m_crossSections[segIdx]->nextSec(ns);
+    if (m_crossSections[nextSec]->isRadiation())
+    {
+      key.add(m_crossSections[nextSec]->radius());
+      key.add(m_crossSections[nextSec]->PMLThickness());
+      key.add(m_crossSections[nextSec]->numberOfModes());
+    }
+    else
+    {
+      key.add(m_crossSections[nextSec]->modesCacheKey(m_simuParams));
+      key.add(m_crossSections[nextSec]->isJunction());
+    }
+    key.add(m_crossSections[nextSec]->scaleIn());
+    key.add(m_crossSections[nextSec]->ctrLinePtIn().x());
+    key.add(m_crossSections[nextSec]->ctrLinePtIn().y());
+  }
+
+  return key;
+}
+
+// ****************************************************************************
+// Compute the junction matrices of a given segment
+
+void Acoustic3dSimulation::computeJunctionMatrices(int segIdx)
+{
+  ScopedTimer timer("junctions/segment " + to_string(segIdx));
+  int nModes, nModesNext;
+  vector<Matrix> matrixF;
+  Polygon_2 contour, nextContour;
+  double scaling[2];
+  int nextSec;
+  Vector ctlShift;
+  int idxMinArea;
+  Pwh_list_2 intersections;
+  double spacing;
+  vector<Point> pts;
+  Eigen::VectorXd weights;
+  CDT cdt;
+  Matrix interpolation1, interpolation2;
+  string cacheFile;
+
+  if (m_crossSections[segIdx]->numNextSec() > 0)
+  {
+    bool isFEM(m_crossSections[segIdx]->isFEM());
+    CacheKey key;
+    if (isFEM)
+    {
+      key = junctionCacheKey(segIdx);
+
+      // keep the junction matrices if neither this segment nor the 
+      // following ones changed since their computation
+      if (m_crossSections[segIdx]->isJunctionUpToDate(key)) { return; }
+    }
+
+    // load the junction matrices from the cache if possible
+    bool useCache((m_cacheDirectory != "") && isFEM);
+    if (useCache)
+    {
+      cacheFile = cacheFileName(m_cacheDirectory, "junction", key);
+      if (readCacheFile(cacheFile, [&matrixF](istream& is)
+        { return readBinary(is, matrixF); }))
+      {
+        m_crossSections[segIdx]->setMatrixF(matrixF);
+        m_crossSections[segIdx]->setJunctionComputed(key);
+        return;
+      }
+    }
+
+    nModes = m_crossSections[segIdx]->numberOfModes();
+
+    matrixF.clear();
+
+    // get the contour of the current cross-section
+    contour.clear();
+    scaling[0] = m_crossSections[segIdx]->scaleOut();
+    Transformation scale(CGAL::SCALING, scaling[0]);
+
+    // The centerline at the end of the segment can be different from the one 
+    // at the beginning of the next segment
+    nextSec = m_crossSections[segIdx]->nextSec(0);
+    ctlShift = Vector(m_crossSections[nextSec]->ctrLinePtIn(),
+      m_crossSections[segIdx]->ctrLinePtOut());
+    ctlShift = Vector(0., ctlShift * m_crossSections[segIdx]->normalOut());
+    Transformation translate(CGAL::TRANSLATION, ctlShift);
+
+    contour = transform(translate, transform(scale, m_crossSections[segIdx]->contour()));
+
+    // loop over the folowing connected cross-sections
+    for (int ns(0); ns < m_crossSections[segIdx]->numNextSec(); ns++)
     {
       nextSec = m_crossSections[segIdx]->nextSec(ns);
       nModesNext = m_crossSections[nextSec]->numberOfModes();
@@ -678,7 +1406,7 @@ void Acoustic3dSimulation::computeJunctionMatrices(int segIdx)
 
       // compute the intersection between the contours of the current
       intersections.clear();
-      if ((typeid(*m_crossSections[nextSec]) == typeid(CrossSection2dRadiation))
+      if (m_crossSections[nextSec]->isRadiation()
         || m_crossSections[segIdx]->isJunction())
       {
         intersections.push_back(Polygon_with_holes_2(contour));
@@ -691,7 +1419,8 @@ void Acoustic3dSimulation::computeJunctionMatrices(int segIdx)
       {
         if (!similarContours(contour, nextContour, MINIMAL_DISTANCE_DIFF_POLYGONS))
         {
-          CGAL::intersection(contour, nextContour, std::back_inserter(intersections));
+          intersectContours(contour, nextContour,
+            m_simuParams.floatPolygonClipping, intersections);
         }
         else
         {
@@ -712,88 +1441,76 @@ void Acoustic3dSimulation::computeJunctionMatrices(int segIdx)
           // Mesh the intersection surfaces and generate integration points
           //////////////////////////////////////////////////////////////
 
-          // mesh the intersection contours
-          intersecCont.clear();
-          pts.clear();
-          areaFaces.clear();
-          cdt.clear();
-          intersecCont = it->outer_boundary();
-          cdt.insert_constraint(intersecCont.begin(), intersecCont.end(), true);
-          CGAL::refine_Delaunay_mesh_2(cdt, Criteria(0.125, spacing));
-
-          // remove the faces which lies outside of the contour
-          for (auto itF = cdt.finite_faces_begin();
-            itF != cdt.finite_faces_end(); ++itF)
-          {
-            if (!itF->is_in_domain())
-            {
-              cdt.delete_face(itF);
-            }
-          }
-
-          gaussPointsFromMesh(pts, areaFaces, cdt);
+          meshPolygon(it->outer_boundary(), spacing, cdt);
+          gaussQuadratureFromMesh(pts, weights, cdt);
 
           //////////////////////////////////////////////////////////////
-          // Interpolate modes
+          // Interpolate the modes and compute scatering matrix F
           //////////////////////////////////////////////////////////////
 
-          // interpolate the modes of the first cross-section
-          interpolation1 = m_crossSections[segIdx]->interpolateModes(pts
-            , 1. / scaling[0], -ctlShift);
-
-          // interpolate the modes of the next cross-section
-          interpolation2 = m_crossSections[nextSec]->interpolateModes(pts
-            , 1. / scaling[1]);
-
-          //////////////////////////////////////////////////////////////
-          // Compute scatering matrix F
-          //////////////////////////////////////////////////////////////
+          // interpolate the modes of both cross-sections at the
+          // integration points, the integrals of all the products of 
+          // modes are then a single weighted matrix product
+          m_crossSections[segIdx]->interpolateModes(pts, 1. / scaling[0], 
+            -ctlShift, interpolation1);
+          m_crossSections[nextSec]->interpolateModes(pts, 1. / scaling[1], 
+            Vector(0., 0.), interpolation2);
 
-          // loop over faces to integrate the modes product
-          for (int f(0); f < areaFaces.size(); f++)
-          {
-            if (areaFaces[f] != 0)
-            {
-              // loop over modes of the first cross-section
-              for (int m(0); m < nModes; m++)
-              {
-                // loop over modes of the next cross-section
-                for (int n(0); n < nModesNext; n++)
-                {
-                  // loop over the Gauss integration points
-                  for (int g(0); g < 3; g++)
-                  {
-                    F(m, n) += areaFaces[f] * interpolation1(f * 3 + g, m) *
-                      interpolation2(f * 3 + g, n) * quadPtWeight
-                      / scaling[0] / scaling[1];
-                  }
-                }
-              }
-            }
-          }
+          F.noalias() += interpolation1.transpose() * 
+            (weights.asDiagonal() * interpolation2) / (scaling[0] * scaling[1]);
         }
       }
       matrixF.push_back(F);
     }
     m_crossSections[segIdx]->setMatrixF(matrixF);
+    if (isFEM) { m_crossSections[segIdx]->setJunctionComputed(key); }
+
+    if (useCache)
+    {
+      writeCacheFile(cacheFile, [&matrixF](ostream& os) { writeBinary(os, matrixF); });
+    }
+  }
+}
+
+// ****************************************************************************
+// Compute the junction matrices of all the segments in parallel. 
+// The cost of a segment depends on the size of the mesh of the intersection 
+// with the next segments, so the segments are scheduled by work stealing.
+
+bool Acoustic3dSimulation::computeAllJunctionMatrices(const progressCallback& progress)
+{
+  int numSec(m_crossSections.size());
+
+  bool finished(parallelLoop(numSec, m_simuParams.numThreads,
+    [this](int i) { computeJunctionMatrices(i); }, progress));
+
+  LogStream log(m_logFile);
+  if (finished)
+  {
+    log << "Junction matrices of " << numSec << " segments computed" << endl;
   }
+  else
+  {
+    log << "Junction matrices computation cancelled" << endl;
+  }
+  log.close();
+
+  return finished;
 }
 
 // ****************************************************************************
 // Compute the junction matrices between the different cross-sections
 void Acoustic3dSimulation::computeJunctionMatrices(bool computeG)
 {
-  Polygon_2 contour, nextContour, intersecCont, prevContour;
+  Polygon_2 contour, nextContour, prevContour;
   Pwh_list_2 intersections, differences;
   vector<Point> pts;
-  vector<double> areaFaces;
+  Eigen::VectorXd weights;
   CDT cdt;
   double spacing, scaling[2], areaDiff;
   Vector u, v, ctlShift;
   Matrix interpolation1, interpolation2;
   int nModes, nModesNext, nextSec, prevSec;
-  double quadPtCoord[3][2]{ {1. / 6., 1. / 6.}, {2. / 3., 1. / 6.}, {1. / 6., 2. / 3.} };
-  double quadPtWeight = 1. / 3.;
   vector<Matrix> matrixF;
   int idxMinArea;
   int tmpNextcontained, tmpPrevContained;
@@ -867,7 +1584,7 @@ void Acoustic3dSimulation::computeJunctionMatrices(bool computeG)
 
         // compute the intersection between the contours of the current
         intersections.clear();
-        if ((typeid(*m_crossSections[nextSec]) == typeid(CrossSection2dRadiation))
+        if (m_crossSections[nextSec]->isRadiation()
           || m_crossSections[i]->isJunction())
         {
           intersections.push_back(Polygon_with_holes_2(contour));
@@ -880,7 +1597,8 @@ void Acoustic3dSimulation::computeJunctionMatrices(bool computeG)
         {
           if (!similarContours(contour, nextContour, MINIMAL_DISTANCE_DIFF_POLYGONS))
           {
-            CGAL::intersection(contour, nextContour, std::back_inserter(intersections));
+            intersectContours(contour, nextContour,
+              m_simuParams.floatPolygonClipping, intersections);
           }
           else
           {
@@ -926,67 +1644,20 @@ void Acoustic3dSimulation::computeJunctionMatrices(bool computeG)
             // Mesh the intersection surfaces and generate integration points
             //////////////////////////////////////////////////////////////
 
-            // mesh the intersection contours
-            intersecCont.clear();
-            pts.clear();
-            areaFaces.clear();
-            cdt.clear();
-            intersecCont = it->outer_boundary();
-            cdt.insert_constraint(intersecCont.begin(), intersecCont.end(), true);
-            CGAL::refine_Delaunay_mesh_2(cdt, Criteria(0.125, spacing));
-
-            // remove the faces which lies outside of the contour
-            for (auto itF = cdt.finite_faces_begin();
-              itF != cdt.finite_faces_end(); ++itF)
-            {
-              if (!itF->is_in_domain())
-              {
-                cdt.delete_face(itF);
-              }
-            }
-
-            gaussPointsFromMesh(pts, areaFaces, cdt);
+            meshPolygon(it->outer_boundary(), spacing, cdt);
+            gaussQuadratureFromMesh(pts, weights, cdt);
 
             //////////////////////////////////////////////////////////////
-            // Interpolate modes
+            // Interpolate the modes and compute scatering matrix F
             //////////////////////////////////////////////////////////////
 
-            // interpolate the modes of the first cross-section
-            interpolation1 = m_crossSections[i]->interpolateModes(pts
-              ,1. / scaling[0], -ctlShift
-            );
-
-            // interpolate the modes of the next cross-section
-            interpolation2 = m_crossSections[nextSec]->interpolateModes(pts
-              ,1. / scaling[1]
-            );
-
-            //////////////////////////////////////////////////////////////
-            // Compute scatering matrix F
-            //////////////////////////////////////////////////////////////
+            m_crossSections[i]->interpolateModes(pts, 1. / scaling[0], 
+              -ctlShift, interpolation1);
+            m_crossSections[nextSec]->interpolateModes(pts, 1. / scaling[1], 
+              Vector(0., 0.), interpolation2);
 
-            // loop over faces to integrate the modes product
-            for (int f(0); f < areaFaces.size(); f++)
-            {
-              if (areaFaces[f] != 0)
-              {
-                // loop over modes of the first cross-section
-                for (int m(0); m < nModes; m++)
-                {
-                  // loop over modes of the next cross-section
-                  for (int n(0); n < nModesNext; n++)
-                  {
-                    // loop over the Gauss integration points
-                    for (int g(0); g < 3; g++)
-                    {
-                      F(m, n) += areaFaces[f] * interpolation1(f * 3 + g,m) *
-                        interpolation2(f * 3 + g,n) * quadPtWeight
-                             / scaling[0] / scaling[1];
-                    }
-                  }
-                }
-              }
-            }
+            F.noalias() += interpolation1.transpose() * 
+              (weights.asDiagonal() * interpolation2) / (scaling[0] * scaling[1]);
           }
         }
         matrixF.push_back(F);
@@ -1057,36 +1728,17 @@ void Acoustic3dSimulation::computeJunctionMatrices(bool computeG)
             }
           }
 
-          gaussPointsFromMesh(pts, areaFaces, cdt);
+          gaussQuadratureFromMesh(pts, weights, cdt);
 
-          interpolation1 = m_crossSections[i]->interpolateModes(pts, scaling[0]);
+          m_crossSections[i]->interpolateModes(pts, scaling[0], 
+            Vector(0., 0.), interpolation1);
 
           //////////////////////////////////////////////////////////////
           // Compute matrix G
           //////////////////////////////////////////////////////////////
 
-          // loop over faces to integrate the modes product
-          for (int f(0); f < areaFaces.size(); f++)
-          {
-            if (areaFaces[f] != 0)
-            {
-              // loop over modes
-              for (int m(0); m < nModes; m++)
-              {
-                // loop over modes
-                for (int n(m); n < nModes; n++)
-                {
-                  // loop over the Gauss integration points
-                  for (int g(0); g < 3; g++)
-                  {
-                    Ge(m, n) += areaFaces[f] * interpolation1(f * 3 + g, m) *
-                      interpolation1(f * 3 + g, n) * quadPtWeight;
-                  }
-                  if (m != n) { Ge(n, m) = Ge(m, n); }
-                }
-              }
-            }
-          }
+          Ge.noalias() += interpolation1.transpose() * 
+            (weights.asDiagonal() * interpolation1);
         }
 
         Ge = (Matrix::Identity(nModes, nModes) - Ge).fullPivLu().inverse();
@@ -1193,33 +1845,12 @@ void Acoustic3dSimulation::computeJunctionMatrices(bool computeG)
           }
 
           // generate the integration points
-          gaussPointsFromMesh(pts, areaFaces, cdt);
+          gaussQuadratureFromMesh(pts, weights, cdt);
 
-          // interpolate the propagation modes
-          interpolation2 = m_crossSections[i]->interpolateModes(pts);
-
-          // loop over the faces to integrate the modes product
-          for (int f(0); f < areaFaces.size(); f++)
-          {
-            if (areaFaces[f] != 0.)
-            {
-              // loop over modes
-              for (int m(0); m < nModes; m++)
-              {
-                // loop over modes
-                for (int n(m); n < nModes; n++)
-                {
-                  // loop over Gauss integration points
-                  for (int g(0); g < 3; g++)
-                  {
-                    Gs(m, n) += areaFaces[f] * interpolation2(f * 3 + g, m)
-                      * interpolation2(f * 3 + g,n) * quadPtWeight;
-                  }
-                  if (m != n) { Gs(n, m) = Gs(m, n); }
-                }
-              }
-            }
-          }
+          // interpolate the propagation modes and integrate their products
+          m_crossSections[i]->interpolateModes(pts, interpolation2);
+          Gs.noalias() += interpolation2.transpose() * 
+            (weights.asDiagonal() * interpolation2);
         }
         Gs = (Matrix::Identity(nModes, nModes) - Gs).fullPivLu().inverse();
         m_crossSections[i]->setMatrixGstart(Gs);
@@ -1230,24 +1861,24 @@ void Acoustic3dSimulation::computeJunctionMatrices(bool computeG)
 
 // **************************************************************************
 // Propagate the impedance and admittance up to the other end of the geometry
-// taking into account branches
-
-void Acoustic3dSimulation::propagateImpedAdmitBranch(vector< Eigen::MatrixXcd> Q0, double freq,
-  vector<int> startSections, vector<int> endSections, double direction)
+// taking into account branches. The segments are gathered in groups (a 
+// segment, or the segments connected to the same segment) which are ordered
+// so that a group is propagated once all the groups connected upstream have
+// been propagated. The groups whose upstream groups are all propagated form 
+// a wave and are independent, so the groups of a wave are propagated in 
+// parallel (the waves join at the junction segments). The groups are
+// propagated sequentially if a propagation workspace is bound to the thread,
+// since the frequencies are then already computed in parallel.
+
+void Acoustic3dSimulation::propagateImpedAdmitBranch(const vector<Eigen::MatrixXcd>& Q0, double freq,
+  const vector<int>& startSections, const vector<int>& endSections, double direction)
 {
   bool addSegsToList, isNotEndSeg, isNotInList;
-  int m, n, idx, mn, ns;
+  int ns;
   vector<int> prevSegs, nextSegs;
   vector<vector<int>> segToProp;
-  vector<Matrix> Ftmp;
-  Eigen::MatrixXcd Qout, Qini;
-  Matrix F;
-  complex<double> wallInterfaceAdmit(1i * 2. * M_PI * freq *
-    m_simuParams.thermalBndSpecAdm / m_simuParams.sndSpeed);
 
-  std::chrono::duration<double> time;
-
-  ofstream log("log.txt", ofstream::app);
+  LogStream log(m_logFile);
   log << "Start branches" << endl;
 
   // initialise the list of segment lists to propagate
@@ -1257,215 +1888,55 @@ void Acoustic3dSimulation::propagateImpedAdmitBranch(vector< Eigen::MatrixXcd> Q
     segToProp.back().push_back(it);
   }
 
-  // while there are non propagated segments in the list
+  //***********************************************************************
+  // build the ordered list of the groups of segments to propagate
+  //***********************************************************************
+
   ns = 0;
   while (ns < segToProp.size())
   {
-    log << "ns = " << ns << endl;
-    log << "Segs ";
+    // add the following connected segments to list of segments to propagate
     for (auto it : segToProp[ns])
     {
-      log << it << "  ";
-    }
-    log << endl;
-
-    // if the segment is an initial segment
-    if (ns < startSections.size())
-    {
-      if (m_crossSections[segToProp[ns][0]]->computeImpedance())
-      {
-        m_crossSections[segToProp[ns][0]]->propagateMagnus(Q0[ns], m_simuParams, freq, direction, IMPEDANCE, &time);
-      }
-      else
+      // check if the segment is an end segment
+      isNotEndSeg = true;
+      for (auto endSec : endSections)
       {
-        m_crossSections[segToProp[ns][0]]->propagateMagnus(Q0[ns], m_simuParams, freq, direction, ADMITTANCE, &time);
+        if (it == endSec) { isNotEndSeg = false; break; }
       }
-    }
-    else
-    {
-      // get the list of previous sections
+
+      // get the indexes of the next connected segments
       if (direction > 0)
       {
-        prevSegs = m_crossSections[segToProp[ns][0]]->prevSections();
+        nextSegs = m_crossSections[it]->nextSections();
       }
       else
       {
-        prevSegs = m_crossSections[segToProp[ns][0]]->nextSections();
-      }
-      log << "Prevsegs: ";
-      for (auto it : prevSegs)
-      {
-        log << it << "  ";
+        nextSegs = m_crossSections[it]->prevSections();
       }
-      log << endl;
 
-      //***********************************
-      // if the previous segment is larger
-      //***********************************
-
-      if (m_crossSections[segToProp[ns][0]]->area() < m_crossSections[prevSegs[0]]->area())
-      {
-        // in this case there can be only one segment connected to the current segment
+      // check if there are connected segments 
+      if (nextSegs.size() > 0) {
 
-        // Get the mode matching matrices
-        if (direction > 0)
-        {
-          Ftmp = m_crossSections[prevSegs[0]]->getMatrixF();
-        }
-        else
-        {
-          // for each segment of the segment group
-          Ftmp.clear();
-          for (auto it : segToProp[ns])
-          {
-            Ftmp.push_back(m_crossSections[it]->getMatrixF()[0].transpose());
-          }
-        }
-        // determine the dimension m,n of the concatenated mode matching matrix
-        m = Ftmp[0].rows();
-        n = 0;
-        for (auto it : Ftmp) { n += it.cols(); }
-        F.resize(m, n);
-        // concatenate the mode matching matrices
-        for (auto it : Ftmp) { F << it; }
-
-        // get the output impedance of the previous segment
-        // if the admittance have been computed in this segment
-        if (!m_crossSections[prevSegs[0]]->computeImpedance())
-        {
-          // compute the corresponding impedance
-          Qout = m_crossSections[prevSegs[0]]->Yin().fullPivLu().inverse();
-        }
-        else
+        // Check if the next segments are already in the list of segments 
+        // to propagate
+        isNotInList = true;
+        for (int i(ns); i < segToProp.size(); i++)
         {
-          Qout = m_crossSections[prevSegs[0]]->Zin();
+          if (segToProp[i][0] == nextSegs[0]) { isNotInList = false; break; }
         }
 
-        log << "F\n" << F << endl << endl;
-
-        // Compute the input impedance
-        Qini = F.transpose() * Qout * F;
-
-        log << "Qini\n" << Qini.cwiseAbs() << endl << endl;
-
-        // propagate the impedance in each of the connected tube
-        idx = 0;
-        for (auto it : segToProp[ns])
+        if (isNotEndSeg && isNotInList)
         {
-          // get the number of modes
-          mn = m_crossSections[it]->numberOfModes();
-          // propagate the impedance, the initial impedance of each connected
-          // tube is a submatrix of Qini
-          m_crossSections[it]->propagateMagnus(Qini.block(idx, idx, mn, mn),
-            m_simuParams, freq, direction, IMPEDANCE, &time);
-          m_crossSections[it]->setComputImpedance(true);
-          idx += mn;
-        }
-      }
-
-      //***************************************
-      // if the previous segment(s) is smaller
-      //***************************************
+          // check if the connected segments can be added to the list
+          //
+          // it is necessary to check only for the first segment of the 
+          // list since either there is only one segment connected to several
+          // others, or there is several segments, but connected to the same
 
-      else 
-      {
-        //get the mode matching matrices
-        Ftmp.clear();
-        if (direction > 0)
-        {
-          for (auto it : prevSegs)
+          if (nextSegs.size() > 1)
           {
-            Ftmp.push_back(m_crossSections[it]->getMatrixF()[0].transpose());
-          }
-        }
-        else
-        {
-          Ftmp = m_crossSections[segToProp[ns][0]]->getMatrixF();
-        }
-        // determine the dimension m,n of the concatenated mode matching matrix
-        m = Ftmp[0].rows();
-        n = 0;
-        for (auto it : Ftmp) { n += it.cols(); }
-        F.resize(m, n);
-        // concatenate the mode matching matrices
-        for (auto it : Ftmp) { F << it; }
-
-        log << "F\n" << F << endl << endl;
-
-        // build the output admittance matrix of all the previous segments
-        Qout.setZero(n, n);
-        idx = 0;
-        for (auto it : prevSegs)
-        {
-          // get the mode number of the previous segment
-          mn = m_crossSections[it]->numberOfModes();
-          if (m_crossSections[it]->computeImpedance())
-          {
-            Qout.block(idx, idx, mn, mn) =
-              m_crossSections[it]->Zin().fullPivLu().inverse();
-          }
-          else
-          {
-            Qout.block(idx, idx, mn, mn) = m_crossSections[it]->Yin();
-          }
-          idx += mn;
-        }
-
-        log << "Qout\n" << Qout.cwiseAbs() << endl << endl;
-
-        // compute the input admittance matrix
-        Qini = F * Qout * F.transpose();
-        m_crossSections[segToProp[ns][0]]->propagateMagnus(Qini, m_simuParams, freq,
-          direction, ADMITTANCE, &time);
-        m_crossSections[segToProp[ns][0]]->setComputImpedance(false);
-      }
-    }
-
-    //***********************************************************************
-    // add the following connected segments to list of segments to propagate
-    //***********************************************************************
-
-    for (auto it : segToProp[ns])
-    {
-      // check if the segment is an end segment
-      isNotEndSeg = true;
-      for (auto endSec : endSections)
-      {
-        if (it == endSec) { isNotEndSeg = false; break; }
-      }
-
-      // get the indexes of the next connected segments
-      if (direction > 0)
-      {
-        nextSegs = m_crossSections[it]->nextSections();
-      }
-      else
-      {
-        nextSegs = m_crossSections[it]->prevSections();
-      }
-
-      // check if there are connected segments 
-      if (nextSegs.size() > 0) {
-
-        // Check if the next segments are already in the list of segments 
-        // to propagate
-        isNotInList = true;
-        for (int i(ns); i < segToProp.size(); i++)
-        {
-          if (segToProp[i][0] == nextSegs[0]) { isNotInList = false; break; }
-        }
-
-        if (isNotEndSeg && isNotInList)
-        {
-          // check if the connected segments can be added to the list
-          //
-          // it is necessary to check only for the first segment of the 
-          // list since either there is only one segment connected to several
-          // others, or there is several segments, but connected to the same
-
-          if (nextSegs.size() > 1)
-          {
-            addSegsToList = true;
+            addSegsToList = true;
           }
           else
           {
@@ -1505,9 +1976,242 @@ void Acoustic3dSimulation::propagateImpedAdmitBranch(vector< Eigen::MatrixXcd> Q
     }
     if (ns < segToProp.size()) { ns++; }
   }
+
+  //***********************************************************************
+  // gather the groups in waves of independent groups
+  //***********************************************************************
+
+  int numGroups(segToProp.size()), numWaves(0);
+  vector<int> wave(numGroups, 0);
+  map<int, int> groupOfSeg;
+  for (int g(0); g < numGroups; g++)
+  {
+    if (g >= startSections.size())
+    {
+      if (direction > 0)
+      {
+        prevSegs = m_crossSections[segToProp[g][0]]->prevSections();
+      }
+      else
+      {
+        prevSegs = m_crossSections[segToProp[g][0]]->nextSections();
+      }
+      for (auto prevSeg : prevSegs)
+      {
+        auto it = groupOfSeg.find(prevSeg);
+        if (it != groupOfSeg.end()) { wave[g] = max(wave[g], wave[it->second] + 1); }
+      }
+    }
+    for (auto seg : segToProp[g]) { groupOfSeg[seg] = g; }
+    numWaves = max(numWaves, wave[g] + 1);
+  }
+
+  //***********************************************************************
+  // propagate the waves
+  //***********************************************************************
+
+  int numThreads((PropagationWorkspace::current() == NULL) ? m_simuParams.numThreads : 1);
+  vector<ostringstream> groupLogs(numGroups);
+  for (int w(0); w < numWaves; w++)
+  {
+    vector<int> groups;
+    for (int g(0); g < numGroups; g++)
+    {
+      if (wave[g] == w) { groups.push_back(g); }
+    }
+    parallelLoop(groups.size(), numThreads, [&](int i)
+      {
+        int g(groups[i]);
+        propagateBranchGroup(Q0, freq, segToProp[g], g, g < startSections.size(),
+          direction, groupLogs[g]);
+      });
+  }
+
+  // the logs are written in the order of the groups
+  for (int g(0); g < numGroups; g++)
+  {
+    log << groupLogs[g].str();
+  }
   log.close();
 }
 
+// **************************************************************************
+// Propagate the impedance or the admittance in a group of segments of a 
+// geometry with branches, from the quantities of the segments connected
+// upstream (or from Q0[idxGroup] for an initial group)
+
+void Acoustic3dSimulation::propagateBranchGroup(const vector<Eigen::MatrixXcd>& Q0,
+  double freq, const vector<int>& group, int idxGroup, bool isStartGroup, 
+  double direction, ostream& log)
+{
+  int m, n, idx, mn;
+  vector<int> prevSegs;
+  vector<Matrix> Ftmp;
+  Eigen::MatrixXcd Qout, Qini;
+  Matrix F;
+  std::chrono::duration<double> time;
+
+  log << "group = " << idxGroup << endl;
+  log << "Segs ";
+  for (auto it : group)
+  {
+    log << it << "  ";
+  }
+  log << endl;
+
+  // if the segment is an initial segment
+  if (isStartGroup)
+  {
+    if (m_crossSections[group[0]]->computeImpedance())
+    {
+      m_crossSections[group[0]]->propagateMagnus(Q0[idxGroup], m_simuParams, freq, direction, IMPEDANCE, &time);
+    }
+    else
+    {
+      m_crossSections[group[0]]->propagateMagnus(Q0[idxGroup], m_simuParams, freq, direction, ADMITTANCE, &time);
+    }
+  }
+  else
+  {
+    // get the list of previous sections
+    if (direction > 0)
+    {
+      prevSegs = m_crossSections[group[0]]->prevSections();
+    }
+    else
+    {
+      prevSegs = m_crossSections[group[0]]->nextSections();
+    }
+    log << "Prevsegs: ";
+    for (auto it : prevSegs)
+    {
+      log << it << "  ";
+    }
+    log << endl;
+
+    //***********************************
+    // if the previous segment is larger
+    //***********************************
+
+    if (m_crossSections[group[0]]->area() < m_crossSections[prevSegs[0]]->area())
+    {
+      // in this case there can be only one segment connected to the current segment
+
+      // Get the mode matching matrices
+      if (direction > 0)
+      {
+        Ftmp = m_crossSections[prevSegs[0]]->getMatrixF();
+      }
+      else
+      {
+        // for each segment of the segment group
+        Ftmp.clear();
+        for (auto it : group)
+        {
+          Ftmp.push_back(m_crossSections[it]->getMatrixF()[0].transpose());
+        }
+      }
+      // determine the dimension m,n of the concatenated mode matching matrix
+      m = Ftmp[0].rows();
+      n = 0;
+      for (const auto& it : Ftmp) { n += it.cols(); }
+      F.resize(m, n);
+      // concatenate the mode matching matrices
+      for (const auto& it : Ftmp) { F << it; }
+
+      // get the output impedance of the previous segment
+      // if the admittance have been computed in this segment
+      if (!m_crossSections[prevSegs[0]]->computeImpedance())
+      {
+        // compute the corresponding impedance
+        Qout = m_crossSections[prevSegs[0]]->Yin().fullPivLu().inverse();
+      }
+      else
+      {
+        Qout = m_crossSections[prevSegs[0]]->Zin();
+      }
+
+      log << "F\n" << F << endl << endl;
+
+      // Compute the input impedance
+      Qini = F.transpose() * Qout * F;
+
+      log << "Qini\n" << Qini.cwiseAbs() << endl << endl;
+
+      // propagate the impedance in each of the connected tube
+      idx = 0;
+      for (auto it : group)
+      {
+        // get the number of modes
+        mn = m_crossSections[it]->numberOfModes();
+        // propagate the impedance, the initial impedance of each connected
+        // tube is a submatrix of Qini
+        m_crossSections[it]->propagateMagnus(Qini.block(idx, idx, mn, mn),
+          m_simuParams, freq, direction, IMPEDANCE, &time);
+        m_crossSections[it]->setComputImpedance(true);
+        idx += mn;
+      }
+    }
+
+    //***************************************
+    // if the previous segment(s) is smaller
+    //***************************************
+
+    else 
+    {
+      //get the mode matching matrices
+      Ftmp.clear();
+      if (direction > 0)
+      {
+        for (auto it : prevSegs)
+        {
+          Ftmp.push_back(m_crossSections[it]->getMatrixF()[0].transpose());
+        }
+      }
+      else
+      {
+        Ftmp = m_crossSections[group[0]]->getMatrixF();
+      }
+      // determine the dimension m,n of the concatenated mode matching matrix
+      m = Ftmp[0].rows();
+      n = 0;
+      for (const auto& it : Ftmp) { n += it.cols(); }
+      F.resize(m, n);
+      // concatenate the mode matching matrices
+      for (const auto& it : Ftmp) { F << it; }
+
+      log << "F\n" << F << endl << endl;
+
+      // build the output admittance matrix of all the previous segments
+      Qout.setZero(n, n);
+      idx = 0;
+      for (auto it : prevSegs)
+      {
+        // get the mode number of the previous segment
+        mn = m_crossSections[it]->numberOfModes();
+        if (m_crossSections[it]->computeImpedance())
+        {
+          Qout.block(idx, idx, mn, mn) =
+            m_crossSections[it]->Zin().fullPivLu().inverse();
+        }
+        else
+        {
+          Qout.block(idx, idx, mn, mn) = m_crossSections[it]->Yin();
+        }
+        idx += mn;
+      }
+
+      log << "Qout\n" << Qout.cwiseAbs() << endl << endl;
+
+      // compute the input admittance matrix
+      Qini = F * Qout * F.transpose();
+      m_crossSections[group[0]]->propagateMagnus(Qini, m_simuParams, freq,
+        direction, ADMITTANCE, &time);
+      m_crossSections[group[0]]->setComputImpedance(false);
+    }
+  }
+}
+
 // **************************************************************************
 // Propagate the impedance and admittance up to the other end of the geometry
 
@@ -1534,20 +2238,7 @@ void Acoustic3dSimulation::propagateImpedAdmit(Eigen::MatrixXcd & startImped,
   Eigen::MatrixXcd & startAdmit, double freq, int startSection, int endSection,
   std::chrono::duration<double> *time, int direction)
 {
-  Eigen::MatrixXcd prevImped;
-  Eigen::MatrixXcd prevAdmit;
-  vector<Matrix> F;
-  Matrix G;
-  int numSec(m_crossSections.size()), nI, nPs;
-  int prevSec;
-  double areaRatio;
-  complex<double> wallInterfaceAdmit(1i*2.*M_PI*freq* 
-    m_simuParams.thermalBndSpecAdm/m_simuParams.sndSpeed);
-  vector<Eigen::MatrixXcd> inputImped;
-
-  // set the initial impedance and admittance matrices
-  m_crossSections[startSection]->clearImpedance();
-  m_crossSections[startSection]->clearAdmittance();
+  int numSec(m_crossSections.size());
 
   // set the propagation direction of the first section
   m_crossSections[startSection]->setZdir(direction);
@@ -1556,29 +2247,75 @@ void Acoustic3dSimulation::propagateImpedAdmit(Eigen::MatrixXcd & startImped,
   switch(m_simuParams.propMethod)
   {
   case MAGNUS:
+    // the impedance and admittance matrices of the previous frequency are
+    // overwritten in place
     m_crossSections[startSection]->propagateMagnus(startAdmit, m_simuParams,
       freq, (double)direction, ADMITTANCE, time);
-    inputImped.clear();
-    for (auto it : m_crossSections[startSection]->Y())
-    {
-      inputImped.push_back(it.fullPivLu().inverse());
-    }
-    m_crossSections[startSection]->setImpedance(inputImped);
+    setImpedanceFromAdmittance(startSection);
     break;
   case STRAIGHT_TUBES:
+    m_crossSections[startSection]->clearImpedance();
+    m_crossSections[startSection]->clearAdmittance();
     m_crossSections[startSection]->propagateImpedAdmitStraight(startImped, startAdmit,
       freq, m_simuParams, 100.,
       m_crossSections[max(0, min(numSec, startSection+direction))]->area());
     break;
   }
 
+  // propagate in the following sections
+  propagateImpedAdmitSections(freq, startSection + direction, endSection, time, direction);
+}
+
+// ****************************************************************************
+// Set the impedance of a section propagated with the Magnus scheme from the
+// admittance at each integration point
+
+void Acoustic3dSimulation::setImpedanceFromAdmittance(int idxSec)
+{
+  junctionWorkspace& ws(junctionWork());
+  const vector<Eigen::MatrixXcd>& Y(m_crossSections[idxSec]->Y());
+  int numPt(Y.size());
+
+  ws.inputImped.resize(numPt);
+  for (int pt(0); pt < numPt; pt++)
+  {
+    ws.fullLu.compute(Y[pt]);
+    ws.inputImped[pt] = ws.fullLu.inverse();
+  }
+  m_crossSections[idxSec]->setImpedance(ws.inputImped);
+}
+
+// ****************************************************************************
+// Propagate the impedance and the admittance from the junction entering the 
+// section firstSection up to endSection. The previous section must have been
+// propagated already, so that a propagation can be continued further.
+
+void Acoustic3dSimulation::propagateImpedAdmitSections(double freq, int firstSection,
+  int endSection, std::chrono::duration<double>* time, int direction)
+{
+  // the work matrices keep their storage from one frequency to the next
+  junctionWorkspace& ws(junctionWork());
+  Eigen::MatrixXcd& prevImped(ws.prevImped);
+  Eigen::MatrixXcd& prevAdmit(ws.prevAdmit);
+  Matrix& G(ws.G);
+  int numSec(m_crossSections.size()), nI, nPs;
+  int prevSec;
+  double areaRatio;
+  complex<double> wallInterfaceAdmit(1i*2.*M_PI*freq* 
+    m_simuParams.thermalBndSpecAdm/m_simuParams.sndSpeed);
+  Profiler& profiler(Profiler::getInstance());
+
   // loop over sections
-  for (int i(startSection + direction); i != (endSection + direction); i += direction)
+  for (int i(firstSection); i != (endSection + direction); i += direction)
   {
 
     prevSec = i - direction;
-    m_crossSections[i]->clearImpedance();
-    m_crossSections[i]->clearAdmittance();
+    // the Magnus scheme overwrites the impedance and the admittance in place
+    if (m_simuParams.propMethod == STRAIGHT_TUBES)
+    {
+      m_crossSections[i]->clearImpedance();
+      m_crossSections[i]->clearAdmittance();
+    }
     m_crossSections[i]->setZdir(direction);
     m_crossSections[i]->setYdir(direction);
 
@@ -1586,35 +2323,37 @@ void Acoustic3dSimulation::propagateImpedAdmit(Eigen::MatrixXcd & startImped,
     nPs = m_crossSections[prevSec]->numberOfModes();
 
     // Extract the scaterring matrix and its complementary
-    F.clear();
+    const vector<Matrix>& F(m_crossSections[(direction == -1) ? i : prevSec]->getMatrixF());
     if (direction == -1)
     {
-      F = m_crossSections[i]->getMatrixF();
       if (m_crossSections[i]->area() > m_crossSections[prevSec]->area())
       {
-        G = Matrix::Identity(nI, nI) - F[0] * F[0].transpose();
+        G.setIdentity(nI, nI);
+        G.noalias() -= F[0] * F[0].transpose();
       }
       else
       {
-        G = Matrix::Identity(nPs, nPs) - F[0].transpose() * F[0];
+        G.setIdentity(nPs, nPs);
+        G.noalias() -= F[0].transpose() * F[0];
       }
     }
     else
     {
-      F = m_crossSections[prevSec]->getMatrixF();
       if (m_crossSections[i]->area() > m_crossSections[prevSec]->area())
       {
-        G = Matrix::Identity(nI, nI) - F[0].transpose() * F[0];
+        G.setIdentity(nI, nI);
+        G.noalias() -= F[0].transpose() * F[0];
       }
       else
       {
-        G = Matrix::Identity(nPs, nPs) - F[0] * F[0].transpose();
+        G.setIdentity(nPs, nPs);
+        G.noalias() -= F[0] * F[0].transpose();
       }
     }
 
-    prevImped = Eigen::MatrixXcd::Zero(m_crossSections[i]->numberOfModes(),
+    prevImped.setZero(m_crossSections[i]->numberOfModes(),
       m_crossSections[i]->numberOfModes());
-    prevAdmit = Eigen::MatrixXcd::Zero(m_crossSections[i]->numberOfModes(),
+    prevAdmit.setZero(m_crossSections[i]->numberOfModes(),
       m_crossSections[i]->numberOfModes());
     
     switch (m_simuParams.propMethod)
@@ -1628,46 +2367,40 @@ void Acoustic3dSimulation::propagateImpedAdmit(Eigen::MatrixXcd & startImped,
            (m_crossSections[prevSec]->area() * 
             pow(m_crossSections[prevSec]->scaleIn(), 2)))
         {
+          ws.product.noalias() =
+            (pow(m_crossSections[i]->scaleOut(), 2) /
+              pow(m_crossSections[prevSec]->scaleIn(), 2)) *
+            F[0] * m_crossSections[prevSec]->Yin();
+          prevAdmit.noalias() += ws.product * (F[0].transpose());
           if (m_simuParams.junctionLosses)
           {
-            prevAdmit +=
-              (pow(m_crossSections[i]->scaleOut(), 2) /
-                pow(m_crossSections[prevSec]->scaleIn(), 2)) *
-              F[0] * m_crossSections[prevSec]->Yin()
-              * (F[0].transpose()) - wallInterfaceAdmit * G;
-          }
-          else
-          {
-            prevAdmit +=
-              (pow(m_crossSections[i]->scaleOut(), 2) /
-                pow(m_crossSections[prevSec]->scaleIn(), 2)) *
-              F[0] * m_crossSections[prevSec]->Yin()
-              * (F[0].transpose());
+            prevAdmit -= wallInterfaceAdmit * G;
           }
         }
       // case of an expansion: area(i) < area(ps)
         else
         {
+          ws.product.noalias() =
+            (pow(m_crossSections[prevSec]->scaleIn(), 2) /
+              pow(m_crossSections[i]->scaleOut(), 2)) *
+            F[0] * m_crossSections[prevSec]->Zin();
           if (m_simuParams.junctionLosses)
           {
-            prevImped +=
-              (pow(m_crossSections[prevSec]->scaleIn(), 2) /
-                pow(m_crossSections[i]->scaleOut(), 2)) *
-              F[0] * m_crossSections[prevSec]->Zin()
-              * (Matrix::Identity(nPs, nPs) -
-                wallInterfaceAdmit *
-                G * m_crossSections[prevSec]->Zin()).inverse()
-              * (F[0].transpose());
+            ws.product2.noalias() = wallInterfaceAdmit *
+              G * m_crossSections[prevSec]->Zin();
+            ws.inverse = Matrix::Identity(nPs, nPs) - ws.product2;
+            ws.lu.compute(ws.inverse);
+            ws.inverse = ws.lu.inverse();
+            ws.product2.noalias() = ws.product * ws.inverse;
+            prevImped.noalias() += ws.product2 * (F[0].transpose());
           }
           else
           {
-            prevImped +=
-              (pow(m_crossSections[prevSec]->scaleIn(), 2) /
-                pow(m_crossSections[i]->scaleOut(), 2)) *
-              F[0] * m_crossSections[prevSec]->Zin()
-              * (F[0].transpose());
+            prevImped.noalias() += ws.product * (F[0].transpose());
           }
-        prevAdmit += prevImped.fullPivLu().inverse();
+        ws.fullLu.compute(prevImped);
+        ws.inverse = ws.fullLu.inverse();
+        prevAdmit += ws.inverse;
         }
       }
       else
@@ -1678,44 +2411,41 @@ void Acoustic3dSimulation::propagateImpedAdmit(Eigen::MatrixXcd & startImped,
            (m_crossSections[prevSec]->area() * 
             pow(m_crossSections[prevSec]->scaleOut(), 2)))
         {
+          ws.product.noalias() =
+            (pow(m_crossSections[i]->scaleIn(), 2) /
+              pow(m_crossSections[prevSec]->scaleOut(), 2)) *
+              (F[0].transpose()) *
+            m_crossSections[prevSec]->Yout();
+          prevAdmit.noalias() += ws.product * F[0];
           if (m_simuParams.junctionLosses)
           {
-            prevAdmit +=
-              (pow(m_crossSections[i]->scaleIn(), 2) /
-                pow(m_crossSections[prevSec]->scaleOut(), 2)) *
-                (F[0].transpose()) *
-              m_crossSections[prevSec]->Yout() * F[0]
-              + wallInterfaceAdmit * G;
-          }
-          else
-          {
-            prevAdmit +=
-              (pow(m_crossSections[i]->scaleIn(), 2) /
-                pow(m_crossSections[prevSec]->scaleOut(), 2)) *
-                (F[0].transpose()) *
-              m_crossSections[prevSec]->Yout() * F[0];
+            prevAdmit += wallInterfaceAdmit * G;
           }
         }
       // case of an expansion: area(i) < area(ps)
         else
         {
+          ws.product.noalias() =
+            (pow(m_crossSections[prevSec]->scaleOut(), 2) /
+              pow(m_crossSections[i]->scaleIn(), 2)) *
+              F[0].transpose() * m_crossSections[prevSec]->Zout();
           if (m_simuParams.junctionLosses)
           {
-            prevImped +=
-              (pow(m_crossSections[prevSec]->scaleOut(), 2) /
-                pow(m_crossSections[i]->scaleIn(), 2)) *
-                F[0].transpose() * m_crossSections[prevSec]->Zout()
-              * (Matrix::Identity(nPs, nPs) + wallInterfaceAdmit *
-                G*m_crossSections[prevSec]->Zout()).inverse() * F[0];
+            ws.product2.noalias() = wallInterfaceAdmit *
+              G*m_crossSections[prevSec]->Zout();
+            ws.inverse = Matrix::Identity(nPs, nPs) + ws.product2;
+            ws.lu.compute(ws.inverse);
+            ws.inverse = ws.lu.inverse();
+            ws.product2.noalias() = ws.product * ws.inverse;
+            prevImped.noalias() += ws.product2 * F[0];
           }
           else
           {
-            prevImped +=
-              (pow(m_crossSections[prevSec]->scaleOut(), 2) /
-                pow(m_crossSections[i]->scaleIn(), 2)) *
-                F[0].transpose() * m_crossSections[prevSec]->Zout() * F[0];
+            prevImped.noalias() += ws.product * F[0];
           }
-        prevAdmit += prevImped.fullPivLu().inverse();
+        ws.fullLu.compute(prevImped);
+        ws.inverse = ws.fullLu.inverse();
+        prevAdmit += ws.inverse;
         }
       }
 
@@ -1768,16 +2498,12 @@ void Acoustic3dSimulation::propagateImpedAdmit(Eigen::MatrixXcd & startImped,
     }
 
     // propagate admittance in the section
+    double start(profiler.isEnabled() ? profiler.now() : 0.);
     switch (m_simuParams.propMethod) {
     case MAGNUS:
       m_crossSections[i]->propagateMagnus(prevAdmit, m_simuParams,
         freq, (double)direction, ADMITTANCE, time);
-      inputImped.clear();
-      for (auto it : m_crossSections[i]->Y())
-      {
-        inputImped.push_back(it.fullPivLu().inverse());
-      }
-      m_crossSections[i]->setImpedance(inputImped);
+      setImpedanceFromAdmittance(i);
       break;
     case STRAIGHT_TUBES:
       m_crossSections[i]->propagateImpedAdmitStraight(prevImped, prevAdmit,
@@ -1785,6 +2511,11 @@ void Acoustic3dSimulation::propagateImpedAdmit(Eigen::MatrixXcd & startImped,
         m_crossSections[max(0,min(numSec, i + direction))]->area());
       break;
     }
+    if (profiler.isEnabled())
+    {
+      profiler.addTime("admittance propagation/segment " + to_string(i),
+        profiler.now() - start);
+    }
   }
 }
 
@@ -1814,17 +2545,22 @@ void Acoustic3dSimulation::propagateVelocityPress(Eigen::MatrixXcd &startVelocit
   Eigen::MatrixXcd& startPressure, double freq, int startSection, 
   int endSection, std::chrono::duration<double> *time, int direction)
 {
-  Eigen::MatrixXcd prevVelo(startVelocity), prevPress(startPressure);
-  vector<Eigen::MatrixXcd> tmpQ, P, Y;
-  vector<Matrix> F;
-  Matrix G;
+  // the work matrices keep their storage from one frequency to the next
+  junctionWorkspace& ws(junctionWork());
+  Eigen::MatrixXcd& prevVelo(ws.prevVelo);
+  Eigen::MatrixXcd& prevPress(ws.prevPress);
+  prevVelo = startVelocity;
+  prevPress = startPressure;
+  vector<Eigen::MatrixXcd>& tmpQ(ws.axialVelocity);
+  Matrix& G(ws.G);
   int numSec(m_crossSections.size());
-  int numX(m_simuParams.numIntegrationStep);
+  int numX(m_simuParams.numIntegrationStep), numPt;
   int nextSec, nI, nNs;
-  Eigen::MatrixXcd pressure;
-  double areaRatio, tau, scaling;
+  double areaRatio;
   complex<double> wallInterfaceAdmit(1i * 2. * M_PI * freq * 
     m_simuParams.thermalBndSpecAdm / m_simuParams.sndSpeed);
+  Profiler& profiler(Profiler::getInstance());
+  double start;
   
   // loop over sections
   for (int i(startSection); i != (endSection); i += direction)
@@ -1832,39 +2568,38 @@ void Acoustic3dSimulation::propagateVelocityPress(Eigen::MatrixXcd &startVelocit
 
     nextSec = i + direction;
 
-    m_crossSections[i]->clearAxialVelocity();
-    m_crossSections[i]->clearAcPressure();
+    // the Magnus scheme overwrites the pressure and the velocity in place
+    if (m_simuParams.propMethod == STRAIGHT_TUBES)
+    {
+      m_crossSections[i]->clearAxialVelocity();
+      m_crossSections[i]->clearAcPressure();
+    }
     m_crossSections[i]->setQdir(direction);
     m_crossSections[i]->setPdir(direction);
+    m_crossSections[i]->setStoreAxialProfile(m_storeAxialProfile);
     nI = m_crossSections[i]->numberOfModes();
     nNs = m_crossSections[nextSec]->numberOfModes();
 
     // propagate axial velocity and acoustic pressure in the section
+    start = profiler.isEnabled() ? profiler.now() : 0.;
     switch (m_simuParams.propMethod) {
     case MAGNUS:
       m_crossSections[i]->propagateMagnus(prevPress, m_simuParams,
         freq, (double)direction, PRESSURE, time);
-      tmpQ.clear(); P.clear(); Y.clear();
-      P = m_crossSections[i]->P();
-      Y = m_crossSections[i]->Y();
-      numX = Y.size();
-      for (int pt(0); pt < numX; pt++ )
       {
-        if (numX > 1) {
-          if (direction == 1) {
-            tau = (double)pt / (double)(numX - 1);
-          }
-          else
-          {
-            tau = (double)(numX - 1 - pt) / (double)(numX - 1);
-          }
-        }
-        else
+        // the pressure is stored only at the ends of the segment if the
+        // axial profile is not stored, and at the checkpoints if it is, 
+        // while the admittance is always stored at each integration point
+        const vector<Eigen::MatrixXcd>& P(m_crossSections[i]->P());
+        const vector<Eigen::MatrixXcd>& Y(m_crossSections[i]->Y());
+        int interval(m_crossSections[i]->checkpointInterval());
+        numX = Y.size();
+        numPt = P.size();
+        tmpQ.resize(numPt);
+        for (int pt(0); pt < numPt; pt++)
         {
-          tau = 1.;
+          tmpQ[pt].noalias() = Y[(pt == numPt - 1) ? 0 : numX - 1 - pt * interval] * P[pt];
         }
-        scaling = m_crossSections[i]->scaling(tau);
-        tmpQ.push_back(Y[numX - 1 - pt] * P[pt]);
       }
       m_crossSections[i]->setAxialVelocity(tmpQ);
       break;
@@ -1874,36 +2609,43 @@ void Acoustic3dSimulation::propagateVelocityPress(Eigen::MatrixXcd &startVelocit
         m_crossSections[nextSec]->area());
       break;
     }
+    if (profiler.isEnabled())
+    {
+      profiler.addTime("pressure propagation/segment " + to_string(i),
+        profiler.now() - start);
+    }
 
     // get the scattering matrix 
-    F.clear();
+    const vector<Matrix>& F(m_crossSections[(direction == 1) ? i : nextSec]->getMatrixF());
     if (direction == 1)
     {
-      F = m_crossSections[i]->getMatrixF();
       if (m_crossSections[i]->area() > m_crossSections[nextSec]->area())
       {
-        G = Matrix::Identity(nI, nI) - F[0] * F[0].transpose();
+        G.setIdentity(nI, nI);
+        G.noalias() -= F[0] * F[0].transpose();
       }
       else
       {
-        G = Matrix::Identity(nNs, nNs) - F[0].transpose() * F[0];
+        G.setIdentity(nNs, nNs);
+        G.noalias() -= F[0].transpose() * F[0];
       }
     }
     else
     {
-      F = m_crossSections[nextSec]->getMatrixF();
       if (m_crossSections[i]->area() > m_crossSections[nextSec]->area())
       {
-        G = Matrix::Identity(nI, nI) - F[0].transpose() * F[0];
+        G.setIdentity(nI, nI);
+        G.noalias() -= F[0].transpose() * F[0];
       }
       else
       {
-        G = Matrix::Identity(nNs, nNs) - F[0] * F[0].transpose();
+        G.setIdentity(nNs, nNs);
+        G.noalias() -= F[0] * F[0].transpose();
       }
     }
 
-    prevVelo = Eigen::MatrixXcd::Zero(m_crossSections[nextSec]->numberOfModes(), 1);
-    prevPress = Eigen::MatrixXcd::Zero(m_crossSections[nextSec]->numberOfModes(), 1);
+    prevVelo.setZero(m_crossSections[nextSec]->numberOfModes(), 1);
+    prevPress.setZero(m_crossSections[nextSec]->numberOfModes(), 1);
     switch (m_simuParams.propMethod)
     {
     case MAGNUS:
@@ -1915,11 +2657,12 @@ void Acoustic3dSimulation::propagateVelocityPress(Eigen::MatrixXcd &startVelocit
             (m_crossSections[nextSec]->area() *
              pow(m_crossSections[nextSec]->scaleOut(), 2)))
               {
-                prevPress += F[0] *
-                    m_crossSections[i]->Pin()
+                ws.product.noalias() = F[0] *
+                    m_crossSections[i]->Pin();
+                prevPress += ws.product
                   * m_crossSections[i]->scaleIn()
                   / m_crossSections[nextSec]->scaleOut();
-                prevVelo +=
+                prevVelo.noalias() +=
                   m_crossSections[nextSec]->Yout() * prevPress;
               }
           // if the section expends: area(i) < area(ns)
@@ -1927,21 +2670,22 @@ void Acoustic3dSimulation::propagateVelocityPress(Eigen::MatrixXcd &startVelocit
           {
             if (m_simuParams.junctionLosses)
             {
-              prevVelo +=
-                (Matrix::Identity(nNs, nNs) + wallInterfaceAdmit *
-                  G * m_crossSections[nextSec]->Zin()).inverse() *
-                F[0] * m_crossSections[i]->Qin()
-                * m_crossSections[nextSec]->scaleOut()
-                / m_crossSections[i]->scaleIn();
+              ws.product2.noalias() = wallInterfaceAdmit *
+                G * m_crossSections[nextSec]->Zin();
+              ws.inverse = Matrix::Identity(nNs, nNs) + ws.product2;
+              ws.lu.compute(ws.inverse);
+              ws.inverse = ws.lu.inverse();
+              ws.product2.noalias() = ws.inverse * F[0];
+              ws.product.noalias() = ws.product2 * m_crossSections[i]->Qin();
             }
             else
             {
-              prevVelo +=
-                F[0] * m_crossSections[i]->Qin()
-                * m_crossSections[nextSec]->scaleOut()
-                / m_crossSections[i]->scaleIn();
+              ws.product.noalias() = F[0] * m_crossSections[i]->Qin();
             }
-              prevPress +=
+            prevVelo += ws.product
+              * m_crossSections[nextSec]->scaleOut()
+              / m_crossSections[i]->scaleIn();
+              prevPress.noalias() +=
               m_crossSections[nextSec]->Zout() * prevVelo;
           }
       }
@@ -1953,12 +2697,13 @@ void Acoustic3dSimulation::propagateVelocityPress(Eigen::MatrixXcd &startVelocit
             (m_crossSections[nextSec]->area() *
              pow(m_crossSections[nextSec]->scaleIn(), 2)))
           {
-            prevPress += 
+            ws.product.noalias() =
                 (F[0].transpose()) *
-              m_crossSections[i]->Pout()
+              m_crossSections[i]->Pout();
+            prevPress += ws.product
               * m_crossSections[i]->scaleOut()
               / m_crossSections[nextSec]->scaleIn();
-            prevVelo +=
+            prevVelo.noalias() +=
               m_crossSections[nextSec]->Yin() * prevPress;
           }
           // if the section expends: area(i) < area(ns)
@@ -1966,21 +2711,23 @@ void Acoustic3dSimulation::propagateVelocityPress(Eigen::MatrixXcd &startVelocit
           {
             if (m_simuParams.junctionLosses)
             {
-              prevVelo +=
-                (Matrix::Identity(nNs, nNs) - wallInterfaceAdmit *
-                  G * m_crossSections[nextSec]->Zin()).inverse() *
-                (F[0].transpose()) * m_crossSections[i]->Qout()
-                * m_crossSections[nextSec]->scaleIn()
-                / m_crossSections[i]->scaleOut();
+              ws.product2.noalias() = wallInterfaceAdmit *
+                G * m_crossSections[nextSec]->Zin();
+              ws.inverse = Matrix::Identity(nNs, nNs) - ws.product2;
+              ws.lu.compute(ws.inverse);
+              ws.inverse = ws.lu.inverse();
+              ws.product2.noalias() = ws.inverse * (F[0].transpose());
+              ws.product.noalias() = ws.product2 * m_crossSections[i]->Qout();
             }
             else
             {
-              prevVelo +=
-                  (F[0].transpose()) * m_crossSections[i]->Qout()
-                * m_crossSections[nextSec]->scaleIn()
-                / m_crossSections[i]->scaleOut();
+              ws.product.noalias() =
+                  (F[0].transpose()) * m_crossSections[i]->Qout();
             }
-          prevPress += m_crossSections[nextSec]->Zin() * prevVelo;
+            prevVelo += ws.product
+              * m_crossSections[nextSec]->scaleIn()
+              / m_crossSections[i]->scaleOut();
+          prevPress.noalias() += m_crossSections[nextSec]->Zin() * prevVelo;
           }
       }
 
@@ -2035,35 +2782,33 @@ void Acoustic3dSimulation::propagateVelocityPress(Eigen::MatrixXcd &startVelocit
   }
 
   // propagate in the last section
-  m_crossSections[endSection]->clearAxialVelocity();
-  m_crossSections[endSection]->clearAcPressure();
+  if (m_simuParams.propMethod == STRAIGHT_TUBES)
+  {
+    m_crossSections[endSection]->clearAxialVelocity();
+    m_crossSections[endSection]->clearAcPressure();
+  }
   m_crossSections[endSection]->setQdir(direction);
   m_crossSections[endSection]->setPdir(direction);
+  m_crossSections[endSection]->setStoreAxialProfile(m_storeAxialProfile);
+  start = profiler.isEnabled() ? profiler.now() : 0.;
   switch (m_simuParams.propMethod) {
   case MAGNUS:
     m_crossSections[endSection]->propagateMagnus(prevPress, m_simuParams,
       freq, (double)direction, PRESSURE, time);
-    tmpQ.clear(); P.clear(); Y.clear();
-    Y = m_crossSections[endSection]->Y();
-    P = m_crossSections[endSection]->P();
-    numX = Y.size();
-    for (int pt(0); pt < numX; pt++)
-    {
-      if (numX > 1) {
-        if (direction == 1) {
-          tau = (double)pt / (double)(numX - 1);
-        }
-        else
-        {
-          tau = (double)(numX - 1 - pt) / (double)(numX - 1);
-        }
-      }
-      else
+    {
+      // the pressure is stored only at the ends of the segment if the
+      // axial profile is not stored, and at the checkpoints if it is, 
+      // while the admittance is always stored at each integration point
+      const vector<Eigen::MatrixXcd>& P(m_crossSections[endSection]->P());
+      const vector<Eigen::MatrixXcd>& Y(m_crossSections[endSection]->Y());
+      int interval(m_crossSections[endSection]->checkpointInterval());
+      numX = Y.size();
+      numPt = P.size();
+      tmpQ.resize(numPt);
+      for (int pt(0); pt < numPt; pt++)
       {
-        tau = 1.;
+        tmpQ[pt].noalias() = Y[(pt == numPt - 1) ? 0 : numX - 1 - pt * interval] * P[pt];
       }
-      scaling = m_crossSections[endSection]->scaling(tau);
-      tmpQ.push_back(Y[numX - 1 - pt] * P[pt]);
     }
     m_crossSections[endSection]->setAxialVelocity(tmpQ);
     break;
@@ -2072,6 +2817,11 @@ void Acoustic3dSimulation::propagateVelocityPress(Eigen::MatrixXcd &startVelocit
       prevPress, freq, m_simuParams, 100.);
     break;
   }
+  if (profiler.isEnabled())
+  {
+    profiler.addTime("pressure propagation/segment " + to_string(endSection),
+      profiler.now() - start);
+  }
 }
 
 // **************************************************************************
@@ -2081,45 +2831,269 @@ void Acoustic3dSimulation::propagateVelocityPress(Eigen::MatrixXcd &startVelocit
 
 Eigen::VectorXcd Acoustic3dSimulation::acousticField(vector<Point_3> queryPt)
 {
-  Eigen::VectorXcd field(queryPt.size()); 
-  
-  for (int i(0); i < queryPt.size(); i++)
-  {
-    field(i) = acousticField(queryPt[i]);
-  }  
-
-  return(field);
+  return(acousticField(queryPt, m_simuParams.freqField));
 }
 
 // ****************************************************************************
 
-complex<double> Acoustic3dSimulation::acousticField(Point_3 queryPt)
+Eigen::VectorXcd Acoustic3dSimulation::acousticField(vector<Point_3> queryPt, double freq)
 {
-  bool ptFound(false);
-  int numSec(m_crossSections.size());
-  Point_3 outPt;
-  complex<double> field(NAN, NAN);
+  radiationSource radSrc;
+  return(acousticField(queryPt, freq, radSrc));
+}
 
-  Vector vec, endNormal(m_crossSections.back()->normalOut());
-  Point endCenterLine(m_crossSections.back()->ctrLinePtOut());
-  double angle;
+// ****************************************************************************
+// Compute the acoustic field at a set of points for the frequency freq. 
+// All the radiated points are computed at once with the quadrature of the 
+// exit plane radSrc, which is generated if it has not been built yet.
+
+Eigen::VectorXcd Acoustic3dSimulation::acousticField(const vector<Point_3>& queryPt,
+  double freq, radiationSource& radSrc)
+{
+  int nbPts(queryPt.size());
+  Eigen::VectorXcd field(nbPts);
+  field.setConstant(complex<double>(NAN, NAN));
   vector<Point_3> radPts;
+  vector<int> idxRadPts;
+  Point_3 radPt;
   Eigen::VectorXcd radPress;
-  radPts.reserve(1);
-  radPts.push_back(Point_3());
 
-  // check if the point is in the radiation domain
-  vec = Vector(endCenterLine, Point(queryPt.x(), queryPt.z()));
-  // for straight segments
-  if (abs(m_crossSections.back()->circleArcAngle()) <= MINIMAL_DISTANCE)
+  for (int i(0); i < nbPts; i++)
   {
-    double length(m_crossSections.back()->ctrLinePtOut().x()
-        - m_crossSections.back()->ctrLinePtIn().x());
-    if (signbit(vec.x() * length))
+    if (!isRadiatedPoint(queryPt[i], radPt))
     {
-      angle = -1.;
+      field(i) = interiorAcousticField(queryPt[i]);
     }
-    else
+    else if (m_simuParams.computeRadiatedField)
+    {
+      radPts.push_back(radPt);
+      idxRadPts.push_back(i);
+    }
+  }
+
+  if (radPts.size() > 0)
+  {
+    if (!radSrc.built)
+    {
+      radiationSourceQuadrature(radSrc, freq, m_crossSections.size() - 1);
+    }
+    RayleighSommerfeldIntegral(radPts, radPress, radSrc);
+    for (int i(0); i < idxRadPts.size(); i++)
+    {
+      field(idxRadPts[i]) = radPress(i);
+    }
+  }
+
+  return(field);
+}
+
+// ****************************************************************************
+// Compute the acoustic field at a set of points with the Green's matrix of 
+// the radiation built for these points: the radiated pressure is a single
+// matrix-vector product with the velocity modes at the exit
+
+Eigen::VectorXcd Acoustic3dSimulation::acousticField(const vector<Point_3>& queryPt,
+  const radiationKernel& kernel)
+{
+  Eigen::VectorXcd field(Eigen::VectorXcd::Constant(queryPt.size(), 
+    complex<double>(NAN, NAN)));
+
+  for (auto i : kernel.idxInteriorPts)
+  {
+    field(i) = interiorAcousticField(queryPt[i]);
+  }
+
+  if (kernel.idxRadPts.size() > 0)
+  {
+    Eigen::VectorXcd radPress(kernel.green * m_crossSections.back()->Qout());
+    for (int i(0); i < kernel.idxRadPts.size(); i++)
+    {
+      field(kernel.idxRadPts[i]) = radPress(i);
+    }
+  }
+
+  return(field);
+}
+
+// ****************************************************************************
+// Locate the points of the field grid (the point of the column i and of the 
+// row j has the index j * nx + i) in the segments and interpolate the modes 
+// of each segment at all its points at once
+
+void Acoustic3dSimulation::buildFieldBasis(fieldBasis& basis)
+{
+  vector<Point_3> queryPts;
+  queryPts.reserve(m_nPtx * m_nPty);
+  for (int j(0); j < m_nPty; j++)
+  {
+    for (int i(0); i < m_nPtx; i++)
+    {
+      queryPts.push_back(Point_3(m_lx * (double)i / (double)(m_nPtx - 1) 
+        + m_simuParams.bbox[0].x(), 0.,
+        m_ly * (double)j / (double)(m_nPty - 1) + m_simuParams.bbox[0].y()));
+    }
+  }
+  buildFieldBasis(queryPts, basis);
+}
+
+// ****************************************************************************
+// Same as above for any set of points (in 3D), processed by blocks of 
+// consecutive points
+
+void Acoustic3dSimulation::buildFieldBasis(const vector<Point_3>& queryPts,
+  fieldBasis& basis)
+{
+  ScopedTimer timer("field basis");
+  const int BLOCK_SIZE(256);
+  int numPts(queryPts.size());
+  vector<int> segOfPts(numPts, -1);
+  vector<Point_3> localPts(numPts);
+  vector<char> radiated(numPts, false);
+
+  parallelLoop((numPts + BLOCK_SIZE - 1) / BLOCK_SIZE, m_simuParams.numThreads, 
+    [&](int b)
+    {
+      Point_3 queryPt, outPt;
+      for (int n(b * BLOCK_SIZE); n < min(numPts, (b + 1) * BLOCK_SIZE); n++)
+      {
+        queryPt = queryPts[n];
+        if (isRadiatedPoint(queryPt, outPt))
+        {
+          radiated[n] = m_simuParams.computeRadiatedField;
+          localPts[n] = outPt;
+          continue;
+        }
+        for (int s : segmentGrid().candidates(queryPt.x(), queryPt.z()))
+        {
+          if (m_crossSections[s]->getCoordinateFromCartesianPt(queryPt, outPt, false))
+          {
+            segOfPts[n] = s;
+            localPts[n] = outPt;
+            break;
+          }
+        }
+      }
+    });
+
+  // group the points by segment
+  basis = fieldBasis();
+  basis.numPts = numPts;
+  vector<int> groupOfSeg(m_crossSections.size(), -1);
+  for (int n(0); n < numPts; n++)
+  {
+    if (radiated[n])
+    {
+      basis.radPts.push_back(localPts[n]);
+      basis.idxRadPts.push_back(n);
+    }
+    else if (segOfPts[n] >= 0)
+    {
+      int& g(groupOfSeg[segOfPts[n]]);
+      if (g < 0)
+      {
+        g = basis.segments.size();
+        basis.segments.push_back(segOfPts[n]);
+        basis.idxPts.push_back(vector<int>());
+        basis.localPts.push_back(vector<Point_3>());
+      }
+      basis.idxPts[g].push_back(n);
+      basis.localPts[g].push_back(localPts[n]);
+    }
+  }
+
+  basis.modes.resize(basis.segments.size());
+  parallelLoop(basis.segments.size(), m_simuParams.numThreads, [&](int g)
+    {
+      vector<Point> pts;
+      pts.reserve(basis.localPts[g].size());
+      for (auto& pt : basis.localPts[g]) { pts.push_back(Point(pt.y(), pt.z())); }
+      m_crossSections[basis.segments[g]]->interpolateModes(pts, basis.modes[g]);
+    });
+}
+
+// ****************************************************************************
+// Compute the acoustic field at the points of a basis for the frequency at 
+// which the wave problem has been solved. The radiated points are computed 
+// with the quadrature of the exit plane radSrc, which is generated if it has
+// not been built yet.
+
+Eigen::VectorXcd Acoustic3dSimulation::acousticField(const fieldBasis& basis, 
+  double freq, radiationSource& radSrc)
+{
+  Eigen::VectorXcd field(Eigen::VectorXcd::Constant(basis.numPts, 
+    complex<double>(NAN, NAN)));
+
+  // the segments use the propagation workspace of the calling thread
+  PropagationWorkspace* workspace(PropagationWorkspace::current());
+  parallelLoop(basis.segments.size(), m_simuParams.numThreads, [&](int g)
+    {
+      PropagationWorkspace* previous(PropagationWorkspace::current());
+      PropagationWorkspace::setCurrent(workspace);
+      Eigen::VectorXcd segField;
+      m_crossSections[basis.segments[g]]->interiorField(basis.localPts[g], 
+        basis.modes[g], m_simuParams, m_simuParams.fieldPhysicalQuantity, segField);
+      for (int i(0); i < basis.idxPts[g].size(); i++)
+      {
+        field(basis.idxPts[g][i]) = segField(i);
+      }
+      PropagationWorkspace::setCurrent(previous);
+    });
+
+  if (basis.radPts.size() > 0)
+  {
+    Eigen::VectorXcd radPress;
+    if (!radSrc.built)
+    {
+      radiationSourceQuadrature(radSrc, freq, m_crossSections.size() - 1);
+    }
+    RayleighSommerfeldIntegral(basis.radPts, radPress, radSrc);
+    for (int i(0); i < basis.idxRadPts.size(); i++)
+    {
+      field(basis.idxRadPts[i]) = radPress(i);
+    }
+  }
+
+  return(field);
+}
+
+// ****************************************************************************
+
+complex<double> Acoustic3dSimulation::acousticField(Point_3 queryPt)
+{
+  return(acousticField(queryPt, m_simuParams.freqField));
+}
+
+// ****************************************************************************
+// Compute the acoustic field at a point for the frequency freq (the frequency
+// is only used for the radiated field)
+
+complex<double> Acoustic3dSimulation::acousticField(Point_3 queryPt, double freq)
+{
+  return(acousticField(vector<Point_3>(1, queryPt), freq)(0));
+}
+
+// ****************************************************************************
+// Check if a point is in the radiation domain, and if it is the case, give 
+// its coordinates with respect to the exit of the last segment
+
+bool Acoustic3dSimulation::isRadiatedPoint(Point_3 queryPt, Point_3& radPt)
+{
+  Vector vec, endNormal(m_crossSections.back()->normalOut());
+  Point endCenterLine(m_crossSections.back()->ctrLinePtOut());
+  double angle;
+
+  // check if the point is in the radiation domain
+  vec = Vector(endCenterLine, Point(queryPt.x(), queryPt.z()));
+  // for straight segments
+  if (abs(m_crossSections.back()->circleArcAngle()) <= MINIMAL_DISTANCE)
+  {
+    double length(m_crossSections.back()->ctrLinePtOut().x()
+        - m_crossSections.back()->ctrLinePtIn().x());
+    if (signbit(vec.x() * length))
+    {
+      angle = -1.;
+    }
+    else
     {
       angle = 1.;
     }  
@@ -2139,30 +3113,29 @@ complex<double> Acoustic3dSimulation::acousticField(Point_3 queryPt)
     }
   }
 
-  if (angle <= 0.)
+  if (angle <= 0.) { return false; }
+
+  radPt = Point_3(vec.x(), queryPt.y(), vec.y());
+  return true;
+}
+
+// ****************************************************************************
+// Compute the acoustic field at a point inside the geometry (NAN if the 
+// point is not inside any segment)
+
+complex<double> Acoustic3dSimulation::interiorAcousticField(Point_3 queryPt)
+{
+  Point_3 outPt;
+
+  // only test the segments whose bounding box contains the point
+  for (int s : segmentGrid().candidates(queryPt.x(), queryPt.z()))
   {
-    for (int s(0); s < numSec; s++)
-    {
-      if (m_crossSections[s]->getCoordinateFromCartesianPt(queryPt, outPt, false))
-      {
-        ptFound = true;
-        field = m_crossSections[s]->interiorField(outPt, m_simuParams);
-        break;
-      }
-    }
-    if (!ptFound)
+    if (m_crossSections[s]->getCoordinateFromCartesianPt(queryPt, outPt, false))
     {
-      field = complex<double>(NAN, NAN);
+      return(m_crossSections[s]->interiorField(outPt, m_simuParams));
     }
   }
-  else if (m_simuParams.computeRadiatedField)
-  {
-    radPts[0] = Point_3(vec.x(), queryPt.y(), vec.y());
-    RayleighSommerfeldIntegral(radPts, radPress, m_simuParams.freqField, numSec - 1);
-    field = radPress(0);
-  }
-
-  return(field);
+  return(complex<double>(NAN, NAN));
 }
 
 // **************************************************************************
@@ -2174,7 +3147,7 @@ bool Acoustic3dSimulation::findSegmentContainingPoint(Point queryPt, int& idxSeg
   Point_3 outPt;
   bool segFound(false);
 
-  for (int i(0); i < m_crossSections.size(); i++)
+  for (int i : segmentGrid().candidates(queryPt.x(), queryPt.y()))
   {
     if (m_crossSections[i]->getCoordinateFromCartesianPt(
       Point_3(queryPt.x(), 0., queryPt.y()), outPt, true))
@@ -2204,12 +3177,33 @@ void Acoustic3dSimulation::prepareAcousticFieldComputation()
   m_nPtx = round(m_lx * (double)m_simuParams.fieldResolution);
   m_nPty = round(m_ly * (double)m_simuParams.fieldResolution);
 
-  m_field.resize(m_nPty, m_nPtx);
-  m_field.setConstant(NAN);
+  // if the field is written in a stream file and it exceeds the memory 
+  // budget, it is only written in the file
+  double fieldMemory((double)m_nPtx * (double)m_nPty * sizeof(complex<double>) / 1048576.);
+  m_fieldInMemory = (m_fieldStreamFile == "") || (m_simuParams.memoryBudget <= 0.) ||
+    (fieldMemory <= m_simuParams.memoryBudget);
+  if (!m_fieldInMemory)
+  {
+    LogStream log(m_logFile);
+    log << "The acoustic field (" << fieldMemory << " MB) exceeds the memory budget, "
+      << "it is only written in " << m_fieldStreamFile << endl;
+  }
+
+  lock_guard<mutex> lock(m_resultsMutex);
+  if (m_fieldInMemory)
+  {
+    m_field.resize(m_nPty, m_nPtx);
+    m_field.setConstant(NAN);
+  }
+  else
+  {
+    m_field.resize(0, 0);
+  }
   m_maxAmpField = 0.;
   m_minAmpField = 100.;
   m_maxPhaseField = 0.;
   m_minPhaseField = 0.;
+  m_fieldVersion++;
 }
 
 // **************************************************************************
@@ -2235,6 +3229,7 @@ void Acoustic3dSimulation::acousticFieldInLine(int idxLine)
     m_maxPhaseField = max(m_maxPhaseField, arg(m_field(j, idxLine)));
     m_minPhaseField = min(m_minPhaseField, arg(m_field(j, idxLine)));
   }
+  m_fieldVersion++;
 }
 
 // **************************************************************************
@@ -2242,113 +3237,634 @@ void Acoustic3dSimulation::acousticFieldInLine(int idxLine)
 
 void Acoustic3dSimulation::acousticFieldInPlane()
 {
-  int cnt(0);
+  LogStream log(m_logFile);
+  acousticFieldInPlane([&log](int numDone, int numTot)
+    {
+      log << 100 * numDone / numTot << " % of field points computed" << endl;
+      return true;
+    });
+  log.close();
+}
 
-  ofstream log("log.txt", ofstream::app);
+// **************************************************************************
+// Extract the acoustic field in a plane in parallel. The plane is divided in 
+// square tiles of points which are computed independently. Each tile is 
+// copied in the field and merged in its extrema under the results mutex, so
+// that the field can be displayed while it is computed.
+// The progress is reported as a number of tiles computed.
+// Returns false if the computation has been cancelled.
+
+bool Acoustic3dSimulation::acousticFieldInPlane(const progressCallback& progress)
+{
+  const int TILE_SIZE(16);
+  ScopedTimer timer("field evaluation");
 
   prepareAcousticFieldComputation();
 
-  for (int i(0); i < m_nPtx; i++)
+  // compute the quantities derived from the propagation before sharing the
+  // cross-sections between the threads
+  for (int i(0); i < m_crossSections.size(); i++)
+  {
+    m_crossSections[i]->prepareInteriorField(m_simuParams.fieldPhysicalQuantity,
+      m_simuParams);
+  }
+  // the threads use the same propagation workspace as the calling thread
+  PropagationWorkspace* workspace(PropagationWorkspace::current());
+  // the quadrature of the exit plane is shared by all the tiles
+  radiationSource radSrc;
+  if (m_simuParams.computeRadiatedField)
   {
-    acousticFieldInLine(i);
-    cnt += m_nPty;
+    radiationSourceQuadrature(radSrc, m_simuParams.freqField, 
+      m_crossSections.size() - 1);
+  }
 
-    log << 100 * cnt / m_nPtx / m_nPty << " % of field points computed" << endl;
+  // the progressive computation needs the whole field in memory
+  if ((m_simuParams.progressiveFieldLevels > 0) && m_fieldInMemory && 
+    (m_nPtx > 1) && (m_nPty > 1))
+  {
+    return acousticFieldInPlaneProgressive(radSrc, progress);
   }
 
-  log.close();
-}
+  int numTilesX((m_nPtx + TILE_SIZE - 1) / TILE_SIZE);
+  int numTilesY((m_nPty + TILE_SIZE - 1) / TILE_SIZE);
 
-// **************************************************************************
-// Solve the wave problem at a given frequency
+  // the complex field is written in the stream file tile by tile, the 
+  // points which are not computed yet are NaN
+  if (m_fieldStreamFile != "")
+  {
+    if (!m_fieldStream.openArray(m_fieldStreamFile, m_nPty, m_nPtx))
+    {
+      LogStream log(m_logFile);
+      log << "Cannot open the file " << m_fieldStreamFile << endl;
+      log.close();
+    }
+  }
 
-void Acoustic3dSimulation::solveWaveProblem(VocalTract* tract, double freq, 
-  bool precomputeRadImped, std::chrono::duration<double> &time,
-  std::chrono::duration<double> *timeExp)
-{
-  int numSec(m_crossSections.size()); 
-  int lastSec(numSec - 1);
+  bool finished(parallelLoop(numTilesX * numTilesY, m_simuParams.numThreads,
+    [&](int t)
+    {
+      PropagationWorkspace* previous(PropagationWorkspace::current());
+      PropagationWorkspace::setCurrent(workspace);
+      int iStart((t % numTilesX) * TILE_SIZE);
+      int jStart((t / numTilesX) * TILE_SIZE);
+      int iEnd(min(iStart + TILE_SIZE, m_nPtx)), jEnd(min(jStart + TILE_SIZE, m_nPty));
+      vector<Point_3> queryPts;
+      queryPts.reserve(TILE_SIZE * TILE_SIZE);
 
-  ofstream log("log.txt", ofstream::app);
+      // generate cartesian coordinates points to search
+      for (int i(iStart); i < iEnd; i++)
+      {
+        for (int j(jStart); j < jEnd; j++)
+        {
+          queryPts.push_back(Point_3(m_lx * (double)i / (double)(m_nPtx - 1) 
+            + m_simuParams.bbox[0].x(), 0.,
+            m_ly * (double)j / (double)(m_nPty - 1) + m_simuParams.bbox[0].y()));
+        }
+      }
 
-  // for time tracking
-  auto start = std::chrono::system_clock::now();
-  auto end = std::chrono::system_clock::now();
-  std::chrono::duration<double> elapsed_seconds;
+      Eigen::VectorXcd field(acousticField(queryPts, m_simuParams.freqField, radSrc));
 
-  //******************************************************
-  // Compute the modes and junction matrices if necessary 
-  //******************************************************
+      {
+        lock_guard<mutex> lock(m_resultsMutex);
+        int idx(0);
+        for (int i(iStart); i < iEnd; i++)
+        {
+          for (int j(jStart); j < jEnd; j++)
+          {
+            if (m_fieldInMemory) { m_field(j, i) = field(idx); }
+
+            // compute the minimal and maximal amplitude and phase of the field
+            m_maxAmpField = max(m_maxAmpField, abs(field(idx)));
+            m_minAmpField = min(m_minAmpField, abs(field(idx)));
+            m_maxPhaseField = max(m_maxPhaseField, arg(field(idx)));
+            m_minPhaseField = min(m_minPhaseField, arg(field(idx)));
+            idx++;
+          }
+        }
+      }
+
+      if (m_fieldStream.isOpen())
+      {
+        vector<complex<double>> tileRow(iEnd - iStart);
+        for (int j(jStart); j < jEnd; j++)
+        {
+          for (int i(iStart); i < iEnd; i++) 
+          { 
+            tileRow[i - iStart] = field((i - iStart) * (jEnd - jStart) + j - jStart); 
+          }
+          m_fieldStream.writeValues(j, iStart, tileRow.data(), tileRow.size());
+        }
+      }
+      PropagationWorkspace::setCurrent(previous);
+    }, progress));
+
+  m_fieldStream.close();
+
+  return finished;
+}
 
-  if (m_simuParams.needToComputeModesAndJunctions)
+// **************************************************************************
+// Extract the acoustic field in a plane progressively. The field is first 
+// computed on a grid 2^progressiveFieldLevels times coarser than the field 
+// grid, then each level halves the spacing of the grid. A cell of the 
+// previous level is refined if some of its corners are outside the geometry
+// and some are not, or if the field varies between its corners by more than
+// fieldRefinementTolerance times the maximal amplitude of the field, else 
+// the new points of the cell are interpolated bilinearly. The field is 
+// completed by interpolation and published after each level, so that it 
+// can be displayed at once and the computation cancelled as soon as the 
+// picture is accurate enough.
+// The progress is reported as a number of points of the field grid.
+// Returns false if the computation has been cancelled.
+
+bool Acoustic3dSimulation::acousticFieldInPlaneProgressive(
+  radiationSource& radSrc, const progressCallback& progress)
+{
+  const int BLOCK_SIZE(256);
+  LogStream log(m_logFile);
+  PropagationWorkspace* workspace(PropagationWorkspace::current());
+  int numPts(m_nPtx * m_nPty), numComputed(0);
+
+  // positions of the grid of spacing step along an axis of n points and 
+  // index of the cell of the grid containing each point of the axis
+  auto gridPositions = [](int n, int step)
   {
-    // set mode number to 0 to make sure that it is defined by the maximal cutoff 
-    // frequency when modes are computed
-    for (int i(0); i < m_crossSections.size(); i++)
+    vector<int> pos;
+    for (int i(0); i < n - 1; i += step) { pos.push_back(i); }
+    pos.push_back(n - 1);
+    return pos;
+  };
+  auto cellIndexes = [](int n, const vector<int>& pos)
+  {
+    vector<int> cell(n, pos.size() - 2);
+    for (int c(0); c < pos.size() - 1; c++)
     {
-      m_crossSections[i]->setModesNumber(0);
+      for (int i(pos[c]); i < pos[c + 1]; i++) { cell[i] = c; }
     }
+    return cell;
+  };
 
-    // compute modes
-    start = std::chrono::system_clock::now();
-    for (int i(0); i < m_crossSections.size(); i++)
+  // the values on the current grid are known, the state of a point is 0 if
+  // its value is not known, 1 if it is computed and 2 if it is interpolated
+  vector<complex<double>> values(numPts, complex<double>(NAN, NAN));
+  vector<char> state(numPts, 0);
+  int step(1 << min(m_simuParams.progressiveFieldLevels, 16));
+  vector<int> posX(gridPositions(m_nPtx, step)), posY(gridPositions(m_nPty, step));
+  vector<int> cellX(cellIndexes(m_nPtx, posX)), cellY(cellIndexes(m_nPty, posY));
+  auto interpolate = [&](int i, int j)
+  {
+    int i0(posX[cellX[i]]), i1(posX[cellX[i] + 1]);
+    int j0(posY[cellY[j]]), j1(posY[cellY[j] + 1]);
+    double u((double)(i - i0) / (double)(i1 - i0));
+    double v((double)(j - j0) / (double)(j1 - j0));
+    return (1. - v) * ((1. - u) * values[j0 * m_nPtx + i0] + u * values[j0 * m_nPtx + i1])
+      + v * ((1. - u) * values[j1 * m_nPtx + i0] + u * values[j1 * m_nPtx + i1]);
+  };
+
+  vector<int> toCompute;
+  for (int j : posY)
+  {
+    for (int i : posX) { toCompute.push_back(j * m_nPtx + i); }
+  }
+
+  double maxAmp(0.);
+  while (true)
+  {
+    // compute the points of the level
+    bool finished(parallelLoop((toCompute.size() + BLOCK_SIZE - 1) / BLOCK_SIZE, 
+      m_simuParams.numThreads, [&](int b)
+      {
+        PropagationWorkspace* previous(PropagationWorkspace::current());
+        PropagationWorkspace::setCurrent(workspace);
+        int start(b * BLOCK_SIZE), end(min((int)toCompute.size(), start + BLOCK_SIZE));
+        vector<Point_3> queryPts;
+        queryPts.reserve(end - start);
+        for (int n(start); n < end; n++)
+        {
+          int i(toCompute[n] % m_nPtx), j(toCompute[n] / m_nPtx);
+          queryPts.push_back(Point_3(m_lx * (double)i / (double)(m_nPtx - 1)
+            + m_simuParams.bbox[0].x(), 0.,
+            m_ly * (double)j / (double)(m_nPty - 1) + m_simuParams.bbox[0].y()));
+        }
+        Eigen::VectorXcd field(acousticField(queryPts, m_simuParams.freqField, radSrc));
+        for (int n(start); n < end; n++) { values[toCompute[n]] = field(n - start); }
+        PropagationWorkspace::setCurrent(previous);
+      }, [&](int numDone, int)
+      {
+        return !progress || progress(numComputed + 
+          min((int)toCompute.size(), numDone * BLOCK_SIZE), numPts);
+      }));
+    if (!finished) { return false; }
+    numComputed += toCompute.size();
+    for (int idx : toCompute)
     {
-      computeMeshAndModes(i);
+      state[idx] = 1;
+      if (!isnan(values[idx].real())) { maxAmp = max(maxAmp, abs(values[idx])); }
     }
-    end = std::chrono::system_clock::now();
-    elapsed_seconds = end - start;
-    log << "Time mesh and modes: " << elapsed_seconds.count() << endl;
 
-    // compute junction matrices
-    start = std::chrono::system_clock::now();
-    for (int i(0); i < m_crossSections.size(); i++)
+    // publish the field completed by interpolation on the current grid
     {
-      computeJunctionMatrices(i);
-      log << "Junction segment " << i << " computed" << endl;
+      lock_guard<mutex> lock(m_resultsMutex);
+      for (int j(0); j < m_nPty; j++)
+      {
+        for (int i(0); i < m_nPtx; i++)
+        {
+          m_field(j, i) = (state[j * m_nPtx + i] != 0) ? values[j * m_nPtx + i] :
+            interpolate(i, j);
+        }
+      }
+      for (int idx : toCompute)
+      {
+        m_maxAmpField = max(m_maxAmpField, abs(values[idx]));
+        m_minAmpField = min(m_minAmpField, abs(values[idx]));
+        m_maxPhaseField = max(m_maxPhaseField, arg(values[idx]));
+        m_minPhaseField = min(m_minPhaseField, arg(values[idx]));
+      }
+      m_fieldVersion++;
     }
-    //computeJunctionMatrices(false);
-    end = std::chrono::system_clock::now();
-    elapsed_seconds = end - start;
-    log << "Time junction matrices: " << elapsed_seconds.count() << endl;
+    log << "Level of spacing " << step << ": " << toCompute.size() 
+      << " points computed (" << numComputed << " / " << numPts << ")" << endl;
+    if (step == 1) { break; }
 
-    if (precomputeRadImped && (m_mouthBoundaryCond == RADIATION))
+    // select the cells of the current grid to refine
+    int numCellsX(posX.size() - 1);
+    vector<char> refined(numCellsX * (posY.size() - 1), false);
+    for (int cy(0); cy < posY.size() - 1; cy++)
     {
-      start = std::chrono::system_clock::now();
-      preComputeRadiationMatrices(16, lastSec);
-      end = std::chrono::system_clock::now();
-      elapsed_seconds = end - start;
-      log << "Time radiation impedance: " << elapsed_seconds.count() << endl;
+      for (int cx(0); cx < numCellsX; cx++)
+      {
+        int corners[4] = { posY[cy] * m_nPtx + posX[cx], posY[cy] * m_nPtx + posX[cx + 1],
+          posY[cy + 1] * m_nPtx + posX[cx], posY[cy + 1] * m_nPtx + posX[cx + 1] };
+        int numComputedCorners(0), numOutside(0);
+        complex<double> mean(0.);
+        for (int idx : corners)
+        {
+          if (state[idx] == 1) { numComputedCorners++; }
+          if (isnan(values[idx].real())) { numOutside++; }
+          else { mean += values[idx] / 4.; }
+        }
+        // the cells interpolated at the previous level are not refined
+        if ((numComputedCorners < 4) || (numOutside == 4)) { continue; }
+        bool refine(numOutside > 0);
+        for (int idx : corners)
+        {
+          refine = refine || (abs(values[idx] - mean) > 
+            m_simuParams.fieldRefinementTolerance * maxAmp);
+        }
+        refined[cy * numCellsX + cx] = refine;
+      }
     }
 
-    m_simuParams.needToComputeModesAndJunctions = false;
+    // the new points are computed if one of the cells they belong to is 
+    // refined, else they are interpolated
+    step /= 2;
+    vector<int> newPosX(gridPositions(m_nPtx, step)), newPosY(gridPositions(m_nPty, step));
+    toCompute.clear();
+    for (int j : newPosY)
+    {
+      for (int i : newPosX)
+      {
+        int idx(j * m_nPtx + i);
+        if (state[idx] != 0) { continue; }
+        bool refine(false);
+        for (int cy(cellY[j]); cy >= max(0, cellY[j] - 1); cy--)
+        {
+          for (int cx(cellX[i]); cx >= max(0, cellX[i] - 1); cx--)
+          {
+            refine = refine || ((posY[cy] <= j) && (j <= posY[cy + 1]) &&
+              (posX[cx] <= i) && (i <= posX[cx + 1]) && refined[cy * numCellsX + cx]);
+          }
+        }
+        if (refine) { toCompute.push_back(idx); }
+        else
+        {
+          values[idx] = interpolate(i, j);
+          state[idx] = 2;
+        }
+      }
+    }
+    posX = newPosX;
+    posY = newPosY;
+    cellX = cellIndexes(m_nPtx, posX);
+    cellY = cellIndexes(m_nPty, posY);
   }
 
-  if (precomputeRadImped && !m_simuParams.radImpedPrecomputed 
-    && (m_mouthBoundaryCond == RADIATION))
+  // write the final field in the stream file
+  if (m_fieldStreamFile != "")
   {
-    start = std::chrono::system_clock::now();
-    preComputeRadiationMatrices(16, lastSec);
-    end = std::chrono::system_clock::now();
-    elapsed_seconds = end - start;
-    log << "Time radiation impedance: " << elapsed_seconds.count() << endl;
+    if (!m_fieldStream.openArray(m_fieldStreamFile, m_nPty, m_nPtx))
+    {
+      log << "Cannot open the file " << m_fieldStreamFile << endl;
+    }
+    else
+    {
+      for (int j(0); j < m_nPty; j++)
+      {
+        m_fieldStream.writeValues(j, 0, values.data() + j * m_nPtx, m_nPtx);
+      }
+      m_fieldStream.close();
+    }
   }
-
-  // Actually solve the wave problem
-  solveWaveProblem(tract, freq, time, timeExp);
-
   log.close();
+
+  return true;
 }
 
 // **************************************************************************
+// Compute the modes, the junction matrices and the radiation impedance, then
+// the integration steps
 
-void Acoustic3dSimulation::solveWaveProblem(VocalTract* tract, double freq,
-  std::chrono::duration<double>& time, std::chrono::duration<double>* timeExp)
+void Acoustic3dSimulation::computeModesJunctionsAndRadiation(bool precomputeRadImped)
 {
-  int numSec(m_crossSections.size());
-  int lastSec(numSec - 1);
-  int mn;
+  computeModesJunctionsAndRadiation(precomputeRadImped, progressCallback());
 
-  m_lastFreqComputed = freq;
+  computeIntegrationSteps();
+
+  logMemoryFootprint("modes and junctions");
+}
+
+// **************************************************************************
+// Compute the meshes and the modes, the junction matrices and the radiation 
+// impedance of the last segment (if precomputeRadImped is set) as a task 
+// graph (see parallelTaskGraph) rather than in successive phases: the 
+// junction matrices of a segment are computed as soon as the modes of the 
+// segment and of its following segments are, the scaled modes as soon as 
+// the modes of their reference segment are, and the radiation impedance as 
+// soon as the modes of the last segment are. The modes of the last segment
+// are computed first, so that the radiation impedance, which is usually the
+// longest task, runs in parallel with the modes of the other segments.
+// The progress callback receives the number of tasks finished.
+// Returns false if the computation has been cancelled by the progress callback.
+
+bool Acoustic3dSimulation::computeModesJunctionsAndRadiation(bool precomputeRadImped,
+  const progressCallback& progress)
+{
+  int numSec(m_crossSections.size());
+  int lastSec(numSec - 1);
+  bool computeRadiation(precomputeRadImped && (m_mouthBoundaryCond == RADIATION));
+  bool finished(true);
+
+  LogStream log(m_logFile);
+
+  // for time tracking
+  auto start = std::chrono::system_clock::now();
+  std::chrono::duration<double> elapsed_seconds;
+
+  if (m_simuParams.needToComputeModesAndJunctions && (numSec > 0))
+  {
+    // set mode number to 0 to make sure that it is defined by the maximal cutoff 
+    // frequency when modes are computed
+    for (int i(0); i < numSec; i++)
+    {
+      m_crossSections[i]->setModesNumber(0);
+    }
+
+    vector<int> reference(numSec), guessIdx;
+    vector<double> scaling(numSec, 1.);
+    iota(reference.begin(), reference.end(), 0);
+    if (m_simuParams.shareScaledModes) { findScaledContours(reference, scaling); }
+    findModesGuesses(reference, guessIdx);
+
+    //******************************************************
+    // tasks: the modes of the segments, starting with the 
+    // last segment and its reference, the radiation
+    // impedance and the junction matrices of the segments
+    //******************************************************
+
+    vector<int> modesOrder;
+    if (reference[lastSec] != lastSec) { modesOrder.push_back(reference[lastSec]); }
+    modesOrder.push_back(lastSec);
+    for (int i(0); i < numSec; i++)
+    {
+      if ((i != lastSec) && (i != reference[lastSec])) { modesOrder.push_back(i); }
+    }
+    vector<int> modesTask(numSec);
+    for (int t(0); t < numSec; t++) { modesTask[modesOrder[t]] = t; }
+
+    int radiationTask(computeRadiation ? numSec : -1);
+    int firstJunctionTask(computeRadiation ? numSec + 1 : numSec);
+    int numTasks(firstJunctionTask + numSec);
+    vector<vector<int>> dependencies(numTasks);
+
+    for (int i(0); i < numSec; i++)
+    {
+      if (reference[i] != i) { dependencies[modesTask[i]].push_back(modesTask[reference[i]]); }
+      if (guessIdx[i] >= 0) { dependencies[modesTask[i]].push_back(modesTask[guessIdx[i]]); }
+
+      vector<int>& junctionDeps(dependencies[firstJunctionTask + i]);
+      junctionDeps.push_back(modesTask[i]);
+      for (int ns(0); ns < m_crossSections[i]->numNextSec(); ns++)
+      {
+        junctionDeps.push_back(modesTask[m_crossSections[i]->nextSec(ns)]);
+      }
+    }
+    if (computeRadiation) { dependencies[radiationTask].push_back(modesTask[lastSec]); }
+
+    vector<ostringstream> segLogs(numSec);
+    std::chrono::duration<double> timeRadiation(0.);
+
+    finished = parallelTaskGraph(numTasks, dependencies, m_simuParams.numThreads, 
+      [&](int t)
+      {
+        if (t < numSec)
+        {
+          int i(modesOrder[t]);
+          if (reference[i] == i) { computeMeshAndModes(i, segLogs[i], guessIdx[i]); }
+          else { scaleMeshAndModes(i, reference[i], scaling[i], segLogs[i]); }
+        }
+        else if (t == radiationTask)
+        {
+          auto startRad = std::chrono::system_clock::now();
+          preComputeRadiationMatrices(16, lastSec, progressCallback());
+          timeRadiation = std::chrono::system_clock::now() - startRad;
+        }
+        else
+        {
+          computeJunctionMatrices(t - firstJunctionTask);
+        }
+      }, progress);
+
+    for (int i(0); i < numSec; i++)
+    {
+      log << segLogs[i].str();
+    }
+    elapsed_seconds = std::chrono::system_clock::now() - start;
+    if (finished)
+    {
+      log << "Time mesh, modes and junction matrices of " << numSec << " segments";
+      if (computeRadiation) { log << " and radiation impedance"; }
+      log << ": " << elapsed_seconds.count() << endl;
+      if (computeRadiation) 
+      { 
+        log << "Time radiation impedance: " << timeRadiation.count() << endl; 
+      }
+      m_simuParams.needToComputeModesAndJunctions = false;
+    }
+    else
+    {
+      log << "Modes and junction matrices computation cancelled" << endl;
+    }
+  }
+
+  if (finished && computeRadiation && !m_simuParams.radImpedPrecomputed)
+  {
+    start = std::chrono::system_clock::now();
+    finished = preComputeRadiationMatrices(16, lastSec, progress);
+    elapsed_seconds = std::chrono::system_clock::now() - start;
+    log << "Time radiation impedance: " << elapsed_seconds.count() << endl;
+  }
+
+  log.close();
+
+  return finished;
+}
+
+// **************************************************************************
+// Report the memory of the segments (mesh, modes, junction and propagation
+// matrices, propagation state), of the interpolation of the radiation 
+// matrices and of the acoustic field, and the resident memory of the 
+// process. The peak of each segment is recorded in the profiler.
+
+void Acoustic3dSimulation::logMemoryFootprint(const string& stage)
+{
+  const double MB(1048576.);
+  Profiler& profiler(Profiler::getInstance());
+  size_t segments(0), maxSegment(0), radiation(0), field;
+  size_t memoisedModes(CrossSection2dRadiation::memoisedModesFootprint());
+  int idxMaxSegment(-1);
+
+  for (int i(0); i < m_crossSections.size(); i++)
+  {
+    size_t bytes(m_crossSections[i]->memoryFootprint());
+    profiler.addMemory("segments/segment " + to_string(i), bytes);
+    segments += bytes;
+    if (bytes > maxSegment) { maxSegment = bytes; idxMaxSegment = i; }
+  }
+  for (auto& sample : m_radiationSamples) { radiation += sample.size() * sizeof(complex<double>); }
+  radiation += m_radiationInterpCoefs.size() * sizeof(complex<double>);
+  {
+    lock_guard<mutex> lock(m_resultsMutex);
+    field = m_field.size() * sizeof(complex<double>);
+  }
+
+  profiler.addMemory(stage + "/segments", segments);
+  profiler.addMemory(stage + "/radiation matrices", radiation);
+  profiler.addMemory(stage + "/acoustic field", field);
+  profiler.addMemory(stage + "/memoised radiation modes", memoisedModes);
+  profiler.addMemory(stage + "/process", residentMemory());
+  profiler.addMemory("process peak", peakResidentMemory());
+
+  LogStream log(m_logFile);
+  log << "Memory after " << stage << " (MB): segments " << segments / MB;
+  if (idxMaxSegment >= 0)
+  {
+    log << " (max " << maxSegment / MB << " in segment " << idxMaxSegment << ")";
+  }
+  log << ", radiation matrices " << radiation / MB
+    << ", acoustic field " << field / MB 
+    << ", memoised radiation modes " << memoisedModes / MB
+    << ", process " << residentMemory() / MB 
+    << " (peak " << peakResidentMemory() / MB << ")" << endl;
+}
+
+// **************************************************************************
+// Collect the costs of the segments from the phases of the profiler named 
+// after the segments
+
+vector<segmentCost> Acoustic3dSimulation::segmentCosts() const
+{
+  map<string, Profiler::phaseStats> phases(Profiler::getInstance().phases());
+  auto total = [&phases](const string& phase)
+  {
+    auto it(phases.find(phase));
+    return (it == phases.end()) ? 0. : it->second.total;
+  };
+  auto mean = [&phases](const string& phase)
+  {
+    auto it(phases.find(phase));
+    return (it == phases.end()) ? 0. : it->second.total / (double)it->second.calls;
+  };
+
+  vector<segmentCost> costs(m_crossSections.size());
+  for (int i(0); i < m_crossSections.size(); i++)
+  {
+    string segment("/segment " + to_string(i));
+    costs[i].meshFaces = m_crossSections[i]->numberOfFaces();
+    costs[i].modes = m_crossSections[i]->numberOfModes();
+    costs[i].modeSolve = total("mode solve" + segment);
+    costs[i].junctions = total("junctions" + segment);
+    costs[i].propagation = mean("admittance propagation" + segment) +
+      mean("pressure propagation" + segment);
+  }
+  return costs;
+}
+
+// **************************************************************************
+// Set the number of integration points of the Magnus scheme of each segment:
+// with adaptiveIntegrationStep it is estimated at the highest frequency 
+// computed, otherwise all the segments use numIntegrationStep
+
+void Acoustic3dSimulation::computeIntegrationSteps()
+{
+  int numSec(m_crossSections.size());
+
+  if (!m_simuParams.adaptiveIntegrationStep || (m_simuParams.propMethod != MAGNUS))
+  {
+    for (int i(0); i < numSec; i++) { m_crossSections[i]->setNumIntegrationStep(0); }
+    return;
+  }
+
+  double freq(max(m_simuParams.maxComputedFreq, m_simuParams.freqField));
+  vector<int> numSteps(numSec);
+  parallelLoop(numSec, m_simuParams.numThreads, [&](int i)
+    {
+      numSteps[i] = m_crossSections[i]->adaptiveIntegrationStep(m_simuParams, freq);
+    });
+
+  int total(0);
+  for (int i(0); i < numSec; i++)
+  {
+    m_crossSections[i]->setNumIntegrationStep(numSteps[i]);
+    total += numSteps[i] - 1;
+  }
+
+  LogStream log(m_logFile);
+  log << "Adaptive integration: " << total << " steps in " << numSec 
+    << " segments (" << numSec * (m_simuParams.numIntegrationStep - 1) 
+    << " with a constant number of steps)" << endl;
+}
+
+// **************************************************************************
+// Solve the wave problem at a given frequency
+
+void Acoustic3dSimulation::solveWaveProblem(VocalTract* tract, double freq, 
+  bool precomputeRadImped, std::chrono::duration<double> &time,
+  std::chrono::duration<double> *timeExp)
+{
+  computeModesJunctionsAndRadiation(precomputeRadImped);
+
+  // Actually solve the wave problem
+  solveWaveProblem(tract, freq, time, timeExp);
+}
+
+// **************************************************************************
+
+void Acoustic3dSimulation::solveWaveProblem(VocalTract* tract, double freq,
+  std::chrono::duration<double>& time, std::chrono::duration<double>* timeExp)
+{
+  int numSec(m_crossSections.size());
+  int lastSec(numSec - 1);
+  int mn;
+  // the propagators of the Magnus scheme computed for the admittance are 
+  // inverted for the pressure instead of being computed again
+  MagnusPropagatorScope propagatorScope;
+
+  // when a propagation workspace is bound, several frequencies are being
+  // computed at the same time by different threads
+  if (PropagationWorkspace::current() == NULL)
+  {
+    m_lastFreqComputed = freq;
+  }
 
   //******************************************************
   // Set sources parameters
@@ -2356,10 +3872,16 @@ void Acoustic3dSimulation::solveWaveProblem(VocalTract* tract, double freq,
 
   auto start = std::chrono::system_clock::now();
 
+  // the source and boundary matrices are work matrices of the thread, which
+  // keep their storage from one frequency to the next
+  junctionWorkspace& ws(junctionWork());
+
   // generate mode amplitude source matrices
   mn = m_crossSections[0]->numberOfModes();
-  Eigen::MatrixXcd inputVelocity(Eigen::MatrixXcd::Zero(mn, 1));
-  Eigen::MatrixXcd inputPressure(Eigen::MatrixXcd::Zero(mn, 1));
+  Eigen::MatrixXcd& inputVelocity(ws.inputVelocity);
+  Eigen::MatrixXcd& inputPressure(ws.inputPressure);
+  inputVelocity.setZero(mn, 1);
+  inputPressure.setZero(mn, 1);
 
   //******************************************************
   // Propagate impedance, admittance, velocity and pressure
@@ -2367,7 +3889,8 @@ void Acoustic3dSimulation::solveWaveProblem(VocalTract* tract, double freq,
 
   // get the radiation impedance matrix
   mn = m_crossSections.back()->numberOfModes();
-  Eigen::MatrixXcd radImped, radAdmit;
+  Eigen::MatrixXcd& radImped(ws.radImped);
+  Eigen::MatrixXcd& radAdmit(ws.radAdmit);
   switch (m_mouthBoundaryCond)
   {
   case RADIATION:
@@ -2377,12 +3900,14 @@ void Acoustic3dSimulation::solveWaveProblem(VocalTract* tract, double freq,
     radAdmit.setZero(mn, mn);
     radAdmit.diagonal() = Eigen::VectorXcd::Constant(mn, complex<double>(
       pow(m_crossSections[lastSec]->scaleOut(), 2), 0.));
-    radImped = radAdmit.inverse();
+    ws.lu.compute(radAdmit);
+    radImped = ws.lu.inverse();
     break;
   case ZERO_PRESSURE:
     radAdmit.setZero(mn, mn);
     radAdmit.diagonal() = Eigen::VectorXcd::Constant(mn, complex<double>(1e10, 0.));
-    radImped = radAdmit.inverse();
+    ws.lu.compute(radAdmit);
+    radImped = ws.lu.inverse();
     break;
   }
 
@@ -2393,7 +3918,7 @@ void Acoustic3dSimulation::solveWaveProblem(VocalTract* tract, double freq,
   inputVelocity(0, 0) = -1i * 2. * M_PI * freq * m_simuParams.volumicMass
     * pow(m_crossSections[0]->scaleIn(), 3)
     * m_crossSections[0]->area();
-  inputPressure = m_crossSections[0]->Zin() * inputVelocity;
+  inputPressure.noalias() = m_crossSections[0]->Zin() * inputVelocity;
 
   // propagate velocity and pressure
   propagateVelocityPress(inputVelocity, inputPressure, freq, 0, lastSec, timeExp);
@@ -2430,10 +3955,24 @@ void Acoustic3dSimulation::precomputationsForTf()
   // resize the transfer function matrix
   m_glottalSourceTF.resize(m_numFreqComputed, m_simuParams.tfPoint.size());
   m_noiseSourceTF.resize(m_numFreqComputed, m_simuParams.tfPoint.size());
+  m_noiseSourcesTF.assign(m_noiseSourceSections.size(), 
+    Eigen::MatrixXcd::Constant(m_numFreqComputed, m_simuParams.tfPoint.size(),
+      complex<double>(NAN, NAN)));
+  m_glottisCondsTF.assign(m_extraGlottisBoundaryConds.size() * 
+    (1 + m_noiseSourceSections.size()), Eigen::MatrixXcd::Constant(m_numFreqComputed, 
+      m_simuParams.tfPoint.size(), complex<double>(NAN, NAN)));
 
   // resize the plane mode input impedance vector
   m_planeModeInputImpedance.resize(m_numFreqComputed, 1);
 
+  // the exit velocities of the sweep are kept to re-evaluate the transfer
+  // functions at other points (the key is set once the modes are computed)
+  m_exitVelocities.assign(m_numFreqComputed, vector<Eigen::VectorXcd>());
+  m_tfRowInterpolated.assign(m_numFreqComputed, 0);
+  m_exitVelocitiesKey = CacheKey();
+
+  m_tfKernel.built = false;
+
   m_oldSimuParams = m_simuParams;
 }
 
@@ -2442,12 +3981,13 @@ void Acoustic3dSimulation::precomputationsForTf()
 void Acoustic3dSimulation::solveWaveProblemNoiseSrc(bool &needToExtractMatrixF, Matrix &F,
   double freq, std::chrono::duration<double>* time)
 {
-  //Matrix F;
-  Eigen::MatrixXcd inputPressureNoise, upStreamImpAdm, radImped, radAdmit,
-    prevPress, prevVelo;
+  junctionWorkspace& ws(junctionWork());
+  Eigen::MatrixXcd& upStreamImpAdm(ws.downStreamImpAdm);
+  Eigen::MatrixXcd& radImped(ws.radImped);
+  Eigen::MatrixXcd& radAdmit(ws.radAdmit);
   int lastSec(m_crossSections.size() - 1);
 
-  ofstream log("log.txt", ofstream::app);
+  LogStream log(m_logFile);
 
   if (m_idxSecNoiseSource < lastSec)
   {
@@ -2460,80 +4000,251 @@ void Acoustic3dSimulation::solveWaveProblemNoiseSrc(bool &needToExtractMatrixF,
       log << "Matrix F extracted" << endl;
     }
 
-    // generate mode amplitude matrices for the secondary source
-    inputPressureNoise.setZero(
-      m_crossSections[m_idxSecNoiseSource]->numberOfModes(), 1);
-    inputPressureNoise(0, 0) = complex<double>(1., 0.);
-
-    // save the input impedance of the upstream part
-    // if the section expends
-    if ((pow(m_crossSections[m_idxSecNoiseSource + 1]->scaleIn(), 2) *
-      m_crossSections[m_idxSecNoiseSource + 1]->area()) >
-      (pow(m_crossSections[m_idxSecNoiseSource]->scaleOut(), 2) *
-        m_crossSections[m_idxSecNoiseSource]->area()))
-    {
-      upStreamImpAdm = m_crossSections[m_idxSecNoiseSource]->Zout();
-    }
-    // if the section contracts
-    else
-    {
-      upStreamImpAdm = m_crossSections[m_idxSecNoiseSource]->Yout();
-    }
-
-    // set glottis boundary condition
-    switch (m_glottisBoundaryCond)
-    {
-    case HARD_WALL:
-    {
-      int mn(m_crossSections[0]->numberOfModes());
-      radImped.setZero(mn, mn);
-      radImped.diagonal().setConstant(100000.);
-      radAdmit.setZero(mn, mn);
-      radAdmit.diagonal().setConstant(1. / 100000.);
-      break;
-    }
-    case IFINITE_WAVGUIDE:
-    {
-      m_crossSections[0]->characteristicImpedance(radImped, freq, m_simuParams);
-      m_crossSections[0]->characteristicAdmittance(radAdmit, freq, m_simuParams);
-      break;
-    }
-    }
+    // save the impedance or the admittance at the exit of the noise source
+    // section before it is overwritten
+    upStreamImpAdm = noiseSourceDownStreamImpAdm(m_idxSecNoiseSource);
 
     // propagate impedance and admittance from the glottis to the location
     // of the second sound source
+    glottisImpedanceAdmittance(radImped, radAdmit, freq);
     propagateImpedAdmit(radImped, radAdmit, freq, 0, m_idxSecNoiseSource, time);
 
-    // compute the pressure and the velocity at the entrance of the next section
-    // if the section expends
-    if ((pow(m_crossSections[m_idxSecNoiseSource + 1]->scaleIn(), 2) *
-      m_crossSections[m_idxSecNoiseSource + 1]->area()) >
-      (pow(m_crossSections[m_idxSecNoiseSource]->scaleOut(), 2) *
-        m_crossSections[m_idxSecNoiseSource]->area()))
+    propagateNoiseSource(m_idxSecNoiseSource, F, upStreamImpAdm, freq, time);
+  }
+  log.close();
+}
+
+// **************************************************************************
+// Compute the transfer functions at the points m_tfPoints of several noise
+// sources located at the exit of the sections idxSecSources (the row k of 
+// tf corresponds to the source k). The sources are processed by increasing 
+// section index, so that the impedance propagated from the glottis up to a 
+// source is continued up to the next one instead of being propagated again 
+// from the glottis: it only overwrites the impedance and the admittance of 
+// sections upstream of the source processed, which are not used to 
+// propagate the pressure of this source and of the next ones. The field is
+// computed with the radiation kernel of m_tfPoints at the frequency freq.
+
+void Acoustic3dSimulation::solveWaveProblemNoiseSrc(const vector<int>& idxSecSources,
+  double freq, const radiationKernel& kernel, Eigen::MatrixXcd& tf, 
+  std::chrono::duration<double>* time, vector<Eigen::VectorXcd>* exitVelocities)
+{
+  vector<Eigen::MatrixXcd> tfs;
+  solveWaveProblemNoiseSrc(idxSecSources, 
+    vector<enum openEndBoundaryCond>(1, m_glottisBoundaryCond), freq, kernel, 
+    tfs, time, exitVelocities);
+  tf.swap(tfs[0]);
+}
+
+// **************************************************************************
+// Same for several glottis boundary conditions: tfs[c] contains the transfer
+// functions of the sources with the condition glottisConds[c], and the exit
+// velocities are given condition by condition. The impedances downstream of
+// the sources, propagated from the exit, are saved before the first 
+// condition overwrites them, so that only the propagation from the glottis 
+// up to the sources and the propagation of the sources are repeated for 
+// each condition.
+
+void Acoustic3dSimulation::solveWaveProblemNoiseSrc(const vector<int>& idxSecSources,
+  const vector<enum openEndBoundaryCond>& glottisConds, double freq,
+  const radiationKernel& kernel, vector<Eigen::MatrixXcd>& tfs, 
+  std::chrono::duration<double>* time, vector<Eigen::VectorXcd>* exitVelocities)
+{
+  MagnusPropagatorScope propagatorScope;
+  junctionWorkspace& ws(junctionWork());
+  vector<Eigen::MatrixXcd>& downStreamImpAdm(ws.sourcesDownStreamImpAdm);
+  Eigen::MatrixXcd& radImped(ws.radImped);
+  Eigen::MatrixXcd& radAdmit(ws.radAdmit);
+  int lastSec(m_crossSections.size() - 1);
+  int numSources(idxSecSources.size());
+  vector<int> order(numSources);
+
+  tfs.assign(glottisConds.size(), Eigen::MatrixXcd::Constant(numSources, 
+    m_tfPoints.size(), complex<double>(NAN, NAN)));
+  if (exitVelocities != NULL) 
+  { 
+    exitVelocities->assign(glottisConds.size() * numSources, Eigen::VectorXcd()); 
+  }
+
+  iota(order.begin(), order.end(), 0);
+  sort(order.begin(), order.end(), [&idxSecSources](int a, int b)
+    { return idxSecSources[a] < idxSecSources[b]; });
+
+  // save the impedance or the admittance at the exit of the source sections
+  // before they are overwritten
+  downStreamImpAdm.resize(numSources);
+  for (int k(0); k < numSources; k++)
+  {
+    if ((idxSecSources[k] >= 0) && (idxSecSources[k] < lastSec))
     {
-      prevVelo = (F.transpose()) * ((freq * upStreamImpAdm + freq *
-        m_crossSections[m_idxSecNoiseSource]->Zout()).householderQr()
-        .solve(inputPressureNoise));
-      prevPress = freq *
-        m_crossSections[m_idxSecNoiseSource + 1]->Zin() * prevVelo;
+      downStreamImpAdm[k] = noiseSourceDownStreamImpAdm(idxSecSources[k]);
     }
-    // if the section contracts
-    else
+  }
+
+  for (int c(0); c < glottisConds.size(); c++)
+  {
+    Eigen::MatrixXcd& tf(tfs[c]);
+    int prevSec(-1), prevSource(-1);
+
+    for (auto k : order)
     {
-      prevPress = (F.transpose()) * ((upStreamImpAdm +
-        m_crossSections[m_idxSecNoiseSource]->Yout()).householderQr()
-        .solve(-m_crossSections[m_idxSecNoiseSource]->Yout() *
-          inputPressureNoise));
+      int idxSec(idxSecSources[k]);
+      int idxVelo(c * numSources + k);
+      if ((idxSec < 0) || (idxSec >= lastSec)) { continue; }
+      if (idxSec == prevSec)
+      {
+        tf.row(k) = tf.row(prevSource);
+        if (exitVelocities != NULL) 
+        { 
+          (*exitVelocities)[idxVelo] = (*exitVelocities)[c * numSources + prevSource]; 
+        }
+        continue;
+      }
+
+      // propagate the impedance up to the source section
+      if (prevSec < 0)
+      {
+        glottisImpedanceAdmittance(glottisConds[c], radImped, radAdmit, freq);
+        propagateImpedAdmit(radImped, radAdmit, freq, 0, idxSec, time);
+      }
+      else
+      {
+        propagateImpedAdmitSections(freq, prevSec + 1, idxSec, time, 1);
+      }
+
+      propagateNoiseSource(idxSec, m_crossSections[idxSec]->getMatrixF()[0],
+        downStreamImpAdm[k], freq, time);
+      tf.row(k) = acousticField(m_tfPoints, kernel).transpose();
+      if (exitVelocities != NULL) { (*exitVelocities)[idxVelo] = m_crossSections.back()->Qout(); }
 
-      prevVelo =
-        m_crossSections[m_idxSecNoiseSource + 1]->Yin() * prevPress;
+      prevSec = idxSec;
+      prevSource = k;
     }
+  }
+}
+
+// **************************************************************************
+// Impedance and admittance of the glottis boundary condition 
+
+void Acoustic3dSimulation::glottisImpedanceAdmittance(Eigen::MatrixXcd& imped,
+  Eigen::MatrixXcd& admit, double freq)
+{
+  glottisImpedanceAdmittance(m_glottisBoundaryCond, imped, admit, freq);
+}
+
+// **************************************************************************
 
-    // propagate the pressure and the velocity in the upstream part
-    propagateVelocityPress(prevVelo, prevPress, freq,
-      min(m_idxSecNoiseSource + 1, lastSec), lastSec, time);
+void Acoustic3dSimulation::glottisImpedanceAdmittance(enum openEndBoundaryCond cond,
+  Eigen::MatrixXcd& imped, Eigen::MatrixXcd& admit, double freq)
+{
+  switch (cond)
+  {
+  case HARD_WALL:
+  {
+    int mn(m_crossSections[0]->numberOfModes());
+    imped.setZero(mn, mn);
+    imped.diagonal().setConstant(100000.);
+    admit.setZero(mn, mn);
+    admit.diagonal().setConstant(1. / 100000.);
+    break;
+  }
+  case IFINITE_WAVGUIDE:
+  {
+    m_crossSections[0]->characteristicImpedance(imped, freq, m_simuParams);
+    m_crossSections[0]->characteristicAdmittance(admit, freq, m_simuParams);
+    break;
+  }
+  }
+}
+
+// **************************************************************************
+// Work matrices of the junctions of the calling thread: those of the 
+// propagation workspace bound to the thread during a parallel sweep
+
+junctionWorkspace& Acoustic3dSimulation::junctionWork()
+{
+  PropagationWorkspace* workspace(PropagationWorkspace::current());
+  return (workspace == NULL) ? m_junctionWork : workspace->junctions();
+}
+
+// **************************************************************************
+// Check if the junction at the exit of the section idxSec is an expansion
+
+bool Acoustic3dSimulation::isExpansionAtExit(int idxSec)
+{
+  return ((pow(m_crossSections[idxSec + 1]->scaleIn(), 2) *
+    m_crossSections[idxSec + 1]->area()) >
+    (pow(m_crossSections[idxSec]->scaleOut(), 2) *
+      m_crossSections[idxSec]->area()));
+}
+
+// **************************************************************************
+// Impedance (expansion) or admittance (contraction) at the exit of a noise 
+// source section, looking towards the exit of the geometry
+
+const Eigen::MatrixXcd& Acoustic3dSimulation::noiseSourceDownStreamImpAdm(int idxSec)
+{
+  if (isExpansionAtExit(idxSec))
+  {
+    return m_crossSections[idxSec]->Zout();
+  }
+  else
+  {
+    return m_crossSections[idxSec]->Yout();
   }
-  log.close();
+}
+
+// **************************************************************************
+// Propagate the pressure and the velocity generated by a noise source located
+// at the exit of the section idxSec up to the exit of the geometry. The 
+// impedance must have been propagated from the glottis up to the section 
+// idxSec, and downStreamImpAdm is the impedance or the admittance at the exit
+// of the section looking towards the exit of the geometry.
+
+void Acoustic3dSimulation::propagateNoiseSource(int idxSec, const Matrix& F,
+  const Eigen::MatrixXcd& downStreamImpAdm, double freq, 
+  std::chrono::duration<double>* time)
+{
+  junctionWorkspace& ws(junctionWork());
+  Eigen::MatrixXcd& inputPressureNoise(ws.inputPressureNoise);
+  Eigen::MatrixXcd& prevPress(ws.sourcePress);
+  Eigen::MatrixXcd& prevVelo(ws.sourceVelo);
+  int lastSec(m_crossSections.size() - 1);
+
+  // generate mode amplitude matrices for the secondary source
+  inputPressureNoise.setZero(m_crossSections[idxSec]->numberOfModes(), 1);
+  inputPressureNoise(0, 0) = complex<double>(1., 0.);
+
+  // compute the pressure and the velocity at the entrance of the next section
+  // if the section expends
+  if (isExpansionAtExit(idxSec))
+  {
+    ws.product = freq * downStreamImpAdm + freq *
+      m_crossSections[idxSec]->Zout();
+    ws.qr.compute(ws.product);
+    ws.solution = ws.qr.solve(inputPressureNoise);
+    prevVelo.noalias() = (F.transpose()) * ws.solution;
+    prevPress.noalias() = freq *
+      m_crossSections[idxSec + 1]->Zin() * prevVelo;
+  }
+  // if the section contracts
+  else
+  {
+    ws.product = downStreamImpAdm +
+      m_crossSections[idxSec]->Yout();
+    ws.qr.compute(ws.product);
+    ws.product2.noalias() = -m_crossSections[idxSec]->Yout() *
+        inputPressureNoise;
+    ws.solution = ws.qr.solve(ws.product2);
+    prevPress.noalias() = (F.transpose()) * ws.solution;
+
+    prevVelo.noalias() =
+      m_crossSections[idxSec + 1]->Yin() * prevPress;
+  }
+
+  // propagate the pressure and the velocity in the upstream part
+  propagateVelocityPress(prevVelo, prevPress, freq,
+    min(idxSec + 1, lastSec), lastSec, time);
 }
 
 // **************************************************************************
@@ -2541,38 +4252,1261 @@ void Acoustic3dSimulation::solveWaveProblemNoiseSrc(bool &needToExtractMatrixF,
 void Acoustic3dSimulation::computeGlottalTf(int idxFreq, double freq)
 {
   m_simuParams.freqField = freq;
-  m_glottalSourceTF.row(idxFreq) = acousticField(m_tfPoints);
+  // the kernel is kept for the noise source transfer function
+  buildRadiationKernel(m_tfPoints, freq, m_tfKernel);
+  Eigen::VectorXcd tf(acousticField(m_tfPoints, m_tfKernel));
+
+  // the transfer functions can be displayed while they are computed
+  lock_guard<mutex> lock(m_resultsMutex);
+  m_glottalSourceTF.row(idxFreq) = tf;
+  m_exitVelocities[idxFreq].assign(1, m_crossSections.back()->Qout());
   m_planeModeInputImpedance(idxFreq, 0) = m_crossSections[0]->Zin()(0, 0);
   m_tfFreqs.push_back(freq);
 }
 
 // **************************************************************************
 
+bool Acoustic3dSimulation::restoreTfFromCheckpoint(int idxFreq, double freq)
+{
+  if (!isTfRowComputed(idxFreq)) { return false; }
+
+  lock_guard<mutex> lock(m_resultsMutex);
+  m_tfFreqs.push_back(freq);
+  return true;
+}
+
+// **************************************************************************
+
 void Acoustic3dSimulation::computeNoiseSrcTf(int idxFreq)
 {
-  m_noiseSourceTF.row(idxFreq) = acousticField(m_tfPoints);
+  Eigen::VectorXcd tf;
+  if (m_tfKernel.built && (m_tfKernel.freq == m_simuParams.freqField))
+  {
+    tf = acousticField(m_tfPoints, m_tfKernel);
+  }
+  else
+  {
+    tf = acousticField(m_tfPoints);
+  }
+
+  lock_guard<mutex> lock(m_resultsMutex);
+  m_noiseSourceTF.row(idxFreq) = tf;
+  m_exitVelocities[idxFreq].resize(2);
+  m_exitVelocities[idxFreq][1] = m_crossSections.back()->Qout();
 }
 
 // **************************************************************************
+// Check if all the points of the transfer functions are in the radiation 
+// domain, in which case the field inside the segments is not needed
 
-void Acoustic3dSimulation::generateSpectraForSynthesis(int tfIdx)
+bool Acoustic3dSimulation::tfPointsRadiated()
 {
-  spectrum.reset(2 * m_numFreq);
-  spectrumNoise.reset(2 * m_numFreq);
+  Point_3 radPt;
+  for (auto& pt : m_tfPoints)
+  {
+    if (!isRadiatedPoint(pt, radPt)) { return false; }
+  }
+  return true;
+}
 
+// **************************************************************************
+// Recompute the transfer functions at the points of the simulation 
+// parameters from the amplitudes of the velocity modes at the exit stored
+// by the last frequency sweep: the radiated pressure only depends on them,
+// so that the propagation is not needed again. It requires that all the 
+// points are radiated and that the geometry and the parameters other than
+// the points are the ones of the sweep. The frequencies interpolated by the
+// adaptive sweep are interpolated again, and the sweep must not have been
+// completed from a checkpoint or by other processes (their frequencies have
+// no exit velocities). The transfer functions are left unchanged if they 
+// cannot be re-evaluated.
+
+bool Acoustic3dSimulation::reEvaluateTransferFunctions()
+{
+  LogStream log(m_logFile);
+  ScopedTimer timer("transfer function re-evaluation");
+
+  // the number of frequencies is the one precomputationsForTf would set
+  if ((m_numFreqComputed == 0) || (m_exitVelocities.size() != m_numFreqComputed) ||
+    (m_freqSteps != (double)SAMPLING_RATE / 2. / (double)m_numFreq) ||
+    ((int)ceil(m_simuParams.maxComputedFreq / m_freqSteps) != m_numFreqComputed) ||
+    (tfCheckpointKey(false) != m_exitVelocitiesKey))
+  {
+    return false;
+  }
+
+  // all the frequencies are either computed or interpolated between 
+  // computed ones
+  if (m_exitVelocities[0].empty() || m_exitVelocities.back().empty()) { return false; }
+  for (int i(0); i < m_numFreqComputed; i++)
+  {
+    if (m_exitVelocities[i].empty() && !m_tfRowInterpolated[i]) { return false; }
+  }
+
+  vector<Point_3> tfPoints(movePointFromExitLandmarkToGeoLandmark(m_simuParams.tfPoint));
+  Point_3 radPt;
+  if (!m_simuParams.computeRadiatedField) { return false; }
+  for (auto& pt : tfPoints)
+  {
+    if (!isRadiatedPoint(pt, radPt)) { return false; }
+  }
+
+  int numPts(tfPoints.size());
+  Eigen::MatrixXcd nanTf(Eigen::MatrixXcd::Constant(m_numFreqComputed, numPts,
+    complex<double>(NAN, NAN)));
+  Eigen::MatrixXcd glottalTF(nanTf), noiseTF(nanTf);
+  vector<Eigen::MatrixXcd> noiseSourcesTF(m_noiseSourcesTF.size(), nanTf);
+  vector<Eigen::MatrixXcd> glottisCondsTF(m_glottisCondsTF.size(), nanTf);
+  int numNoiseSources(1 + m_noiseSourcesTF.size());
+
+  vector<int> idxFreqs;
   for (int i(0); i < m_numFreqComputed; i++)
   {
-    spectrum.setValue(i, m_glottalSourceTF(i, tfIdx));
-    spectrumNoise.setValue(i, m_noiseSourceTF(i, tfIdx));
+    if (!m_exitVelocities[i].empty()) { idxFreqs.push_back(i); }
+  }
+
+  // the radiation kernel of the new points is built for each frequency, 
+  // the velocities of all the sources are multiplied by it
+  int numThreads(max(1, min(m_simuParams.numThreads, (int)idxFreqs.size())));
+  vector<radiationKernel> kernels(numThreads);
+  parallelSweep(idxFreqs.size(), numThreads, [&](int n, int t)
+    {
+      int i(idxFreqs[n]);
+      radiationKernel& kernel(kernels[t]);
+      buildRadiationKernel(tfPoints, max(0.1, (double)i * m_freqSteps), kernel);
+
+      const vector<Eigen::VectorXcd>& velocities(m_exitVelocities[i]);
+      for (int s(0); s < velocities.size(); s++)
+      {
+        if (velocities[s].size() == 0) { continue; }
+        Eigen::MatrixXcd& tf((s == 0) ? glottalTF : ((s == 1) ? noiseTF :
+          ((s <= numNoiseSources) ? noiseSourcesTF[s - 2] : 
+            glottisCondsTF[s - 1 - numNoiseSources])));
+        Eigen::VectorXcd radPress(kernel.green * velocities[s]);
+        for (int k(0); k < kernel.idxRadPts.size(); k++)
+        {
+          tf(i, kernel.idxRadPts[k]) = radPress(k);
+        }
+      }
+    });
+
+  {
+    lock_guard<mutex> lock(m_resultsMutex);
+    m_tfPoints = tfPoints;
+    m_glottalSourceTF = glottalTF;
+    m_noiseSourceTF = noiseTF;
+    m_noiseSourcesTF = noiseSourcesTF;
+    m_glottisCondsTF = glottisCondsTF;
+
+    // the frequencies interpolated by the adaptive sweep (the input 
+    // impedance, which does not depend on the points, is unchanged)
+    int prevIdx(0);
+    for (int i(1); i < m_numFreqComputed; i++)
+    {
+      if (!m_exitVelocities[i].empty())
+      {
+        interpolateTfRows(prevIdx, i);
+        prevIdx = i;
+      }
+    }
+  }
+  m_tfKernel.built = false;
+  m_oldSimuParams.tfPoint = m_simuParams.tfPoint;
+
+  log << "Transfer functions re-evaluated at " << numPts << " point(s) for "
+    << idxFreqs.size() << " / " << m_numFreqComputed << " frequencies" << endl;
+  log.close();
+  return true;
+}
+
+// **************************************************************************
+
+void Acoustic3dSimulation::mirroredSpectrum(const Eigen::MatrixXcd& tf, int tfIdx,
+  ComplexSignal& s) const
+{
+  s.reset(2 * m_numFreq);
+
+  for (int i(0); i < m_numFreqComputed; i++)
+  {
+    s.setValue(i, tf(i, tfIdx));
+  }
+
+  for (int i(m_numFreq); i < 2 * m_numFreq; i++)
+  {
+    s.re[i] = s.re[2 * m_numFreq - i - 1];
+    s.im[i] = -s.im[2 * m_numFreq - i - 1];
+  }
+}
+
+// **************************************************************************
+
+void Acoustic3dSimulation::generateSpectraForSynthesis(int tfIdx)
+{
+  mirroredSpectrum(m_glottalSourceTF, tfIdx, spectrum);
+  mirroredSpectrum(m_noiseSourceTF, tfIdx, spectrumNoise);
+}
+
+// **************************************************************************
+// Impulse responses of the glottal and noise source transfer functions at 
+// all the transfer function points. Each task builds the mirrored spectrum 
+// of a point and a source and computes its inverse FFT, as done for the 
+// synthesis from the spectra of generateSpectraForSynthesis().
+
+bool Acoustic3dSimulation::computeImpulseResponses(vector<vector<double>>& glottalIR,
+  vector<vector<double>>& noiseIR)
+{
+  lock_guard<mutex> lock(m_resultsMutex);
+
+  glottalIR.clear();
+  noiseIR.clear();
+
+  // the inverse FFT needs a spectrum of 2 ^ exponent samples
+  int exponent(0);
+  while ((1 << exponent) < 2 * m_numFreq) { exponent++; }
+  int numPts(m_glottalSourceTF.cols());
+  if ((m_numFreqComputed == 0) || ((1 << exponent) != 2 * m_numFreq) ||
+    (numPts == 0) || (m_noiseSourceTF.cols() != numPts) ||
+    (m_glottalSourceTF.rows() < m_numFreqComputed) || 
+    (m_noiseSourceTF.rows() < m_numFreqComputed))
+  {
+    return false;
+  }
+
+  glottalIR.assign(numPts, vector<double>(m_numFreq));
+  noiseIR.assign(numPts, vector<double>(m_numFreq));
+
+  int numTasks(2 * numPts);
+  int numThreads(max(1, min(m_simuParams.numThreads, numTasks)));
+  parallelLoopIndexed(numTasks, numThreads, [&](int n, int)
+    {
+      int pt(n % numPts);
+      bool noise(n >= numPts);
+      vector<double>& ir(noise ? noiseIR[pt] : glottalIR[pt]);
+
+      ComplexSignal s;
+      mirroredSpectrum(noise ? m_noiseSourceTF : m_glottalSourceTF, pt, s);
+      complexIFFT(s, exponent, true);
+      for (int i(0); i < m_numFreq; i++) { ir[i] = s.re[i]; }
+    });
+
+  return true;
+}
+
+// **************************************************************************
+// Replace the transfer functions by transfer functions computed at the 
+// frequencies of a sweep with a spectrum of 2 ^ spectrumLgthExponent samples,
+// which must be the one of the current parameters. The spectra for the 
+// synthesis are generated from the first point, the input impedance and the
+// transfer functions of the noise sources are cleared.
+
+bool Acoustic3dSimulation::setTransferFunctions(const vector<double>& freqs,
+  const Eigen::MatrixXcd& glottalTF, const Eigen::MatrixXcd& noiseTF,
+  int spectrumLgthExponent)
+{
+  if ((spectrumLgthExponent != m_simuParams.spectrumLgthExponent) ||
+    (freqs.size() == 0) || (freqs.size() > m_numFreq) || 
+    (glottalTF.rows() != freqs.size()) || (noiseTF.rows() != freqs.size()) ||
+    (glottalTF.cols() == 0) || (noiseTF.cols() != glottalTF.cols()))
+  {
+    return false;
+  }
+
+  lock_guard<mutex> lock(m_resultsMutex);
+
+  m_numFreqPicture = m_numFreq;
+  m_oldSimuParams.spectrumLgthExponent = spectrumLgthExponent;
+  m_freqSteps = (double)SAMPLING_RATE / 2. / (double)m_numFreq;
+  m_numFreqComputed = freqs.size();
+  m_tfFreqs = freqs;
+  m_glottalSourceTF = glottalTF;
+  m_noiseSourceTF = noiseTF;
+  m_noiseSourcesTF.clear();
+  m_glottisCondsTF.clear();
+  m_planeModeInputImpedance = Eigen::MatrixXcd::Constant(m_numFreqComputed, 1,
+    complex<double>(NAN, NAN));
+  // these transfer functions cannot be re-evaluated at other points
+  m_exitVelocities.clear();
+
+  generateSpectraForSynthesis(0);
+
+  return true;
+}
+
+// **************************************************************************
+// Parallel sweep engine: run task(n, t) for n = 0 ... numTasks - 1 on
+// numThreads threads of the pool, t being the index of the thread. With more
+// than one thread, each thread binds its own propagation workspace, so that 
+// the propagated quantities are not stored in the cross-sections, which are 
+// shared and only read. With one thread the tasks run in the calling thread 
+// and the cross-sections keep the quantities of the last task.
+
+void Acoustic3dSimulation::parallelSweep(int numTasks, int numThreads,
+  const function<void(int, int)>& task)
+{
+  if (numThreads <= 1)
+  {
+    for (int n(0); n < numTasks; n++) { task(n, 0); }
+    return;
+  }
+
+  vector<PropagationWorkspace> workspaces(numThreads);
+  parallelLoopIndexed(numTasks, numThreads, [&](int n, int t)
+    {
+      PropagationWorkspace* previous(PropagationWorkspace::current());
+      PropagationWorkspace::setCurrent(&workspaces[t]);
+      task(n, t);
+      PropagationWorkspace::setCurrent(previous);
+    });
+}
+
+// **************************************************************************
+// Number of threads used to sweep numTasks frequencies
+
+int Acoustic3dSimulation::sweepThreads(int numTasks) const
+{
+  int numThreads(max(1, min(m_simuParams.numThreads, numTasks)));
+  if ((m_simuParams.memoryBudget <= 0.) || (numThreads == 1)) { return numThreads; }
+
+  // each thread of the sweep holds the propagation state of all the 
+  // segments in its workspace, the number of threads is reduced so that 
+  // the workspaces fit in the memory left by the data of the simulation
+  double workspaceMemory(0.), dataMemory(0.);
+  for (auto& cs : m_crossSections)
+  {
+    workspaceMemory += cs->propagationFootprint(m_simuParams, m_storeAxialProfile);
+    dataMemory += cs->memoryFootprint();
+  }
+  workspaceMemory /= 1048576.;
+  dataMemory /= 1048576.;
+  int maxThreads(max(1, (int)floor((m_simuParams.memoryBudget - dataMemory) 
+    / max(workspaceMemory, 1e-6))));
+  if (maxThreads < numThreads)
+  {
+    LogStream log(m_logFile);
+    log << "Memory budget: frequency sweep reduced from " << numThreads << " to " 
+      << maxThreads << " thread(s) (" << workspaceMemory << " MB per thread)" << endl;
+    numThreads = maxThreads;
+  }
+  return numThreads;
+}
+
+// **************************************************************************
+// Blending band of the hybrid sweep: the lowest cut-on frequency of the 
+// higher order modes of all the segments multiplied by hybridCrossoverFactor
+// is the upper limit of the band, whose relative width is hybridBlendWidth.
+// Only the Magnus method couples a frequency dependent number of modes.
+
+void Acoustic3dSimulation::setHybridBand(ostream& log)
+{
+  m_hybridBand[0] = 0.;
+  m_hybridBand[1] = 0.;
+  if (!m_simuParams.hybridPlaneWave || (m_simuParams.propMethod != MAGNUS)) { return; }
+
+  double minCutOn(INFINITY);
+  for (auto& cs : m_crossSections)
+  {
+    if (cs->isFEM() && (cs->numberOfModes() > 1))
+    {
+      minCutOn = min(minCutOn, cs->eigenFrequency(1));
+    }
+  }
+  // without higher order modes the multimodal solution is the plane wave one
+  if (!isfinite(minCutOn)) { return; }
+
+  m_hybridBand[1] = m_simuParams.hybridCrossoverFactor * minCutOn;
+  m_hybridBand[0] = max(0., 1. - m_simuParams.hybridBlendWidth) * m_hybridBand[1];
+  log << "Hybrid sweep: plane wave below " << m_hybridBand[0] 
+    << " Hz, multimodal above " << m_hybridBand[1] << " Hz (lowest cut-on " 
+    << minCutOn << " Hz)" << endl;
+}
+
+// **************************************************************************
+// Weight of the multimodal solution in the hybrid sweep: 0 below the 
+// blending band, 1 above it (and if the hybrid sweep is not used) and linear
+// within the band
+
+double Acoustic3dSimulation::hybridWeight(double freq) const
+{
+  if ((m_hybridBand[1] <= 0.) || (freq >= m_hybridBand[1])) { return 1.; }
+  if (freq <= m_hybridBand[0]) { return 0.; }
+  return (freq - m_hybridBand[0]) / (m_hybridBand[1] - m_hybridBand[0]);
+}
+
+// **************************************************************************
+// Compute the transfer functions at the frequency index i and write them in
+// the rows of the transfer function matrices corresponding to the frequency
+// index. The radiation kernel and the noise transfer functions are work
+// variables of the calling thread.
+
+void Acoustic3dSimulation::computeTfAtFrequency(VocalTract* tract, int i,
+  radiationKernel& kernel, vector<Eigen::MatrixXcd>& noiseTfs, ostream& log, mutex& logMutex,
+  std::chrono::duration<double>& timePropa, std::chrono::duration<double>& timeComputeField,
+  std::chrono::duration<double>& timeExp)
+{
+  double freq(max(0.1, (double)i * m_freqSteps));
+  bool computeNoiseSrcTf(m_idxSecNoiseSource < (int)m_crossSections.size() - 1);
+  // the main noise source comes first, then the additional ones
+  vector<int> noiseSources(1, m_idxSecNoiseSource);
+  noiseSources.insert(noiseSources.end(), m_noiseSourceSections.begin(),
+    m_noiseSourceSections.end());
+  // the glottis boundary condition of the simulation comes first, then the
+  // extra ones
+  vector<enum openEndBoundaryCond> glottisConds(1, m_glottisBoundaryCond);
+  glottisConds.insert(glottisConds.end(), m_extraGlottisBoundaryConds.begin(),
+    m_extraGlottisBoundaryConds.end());
+  std::chrono::duration<double> time(0.);
+  // the propagators of the Magnus scheme are shared by the glottal and the 
+  // noise sources
+  MagnusPropagatorScope propagatorScope;
+
+  {
+    lock_guard<mutex> lock(logMutex);
+    log << "frequency " << i + 1 << "/" << m_numFreqComputed << " f = " << freq
+      << " Hz" << endl;
+  }
+
+  // hybrid sweep: only the plane mode is coupled below the blending band,
+  // and both solutions are computed and blended linearly within it
+  double weight(hybridWeight(freq));
+  vector<bool> planeWavePasses;
+  if (weight < 1.) { planeWavePasses.push_back(true); }
+  if (weight > 0.) { planeWavePasses.push_back(false); }
+  vector<Eigen::MatrixXcd*> mats{ &m_glottalSourceTF, &m_noiseSourceTF,
+    &m_planeModeInputImpedance };
+  for (auto& tf : m_noiseSourcesTF) { mats.push_back(&tf); }
+  for (auto& tf : m_glottisCondsTF) { mats.push_back(&tf); }
+  vector<Eigen::RowVectorXcd> planeWaveRows;
+  vector<Eigen::VectorXcd> exitVelocities, planeWaveVelocities;
+
+  for (int pass(0); pass < planeWavePasses.size(); pass++)
+  {
+    PlaneWaveScope planeWave(planeWavePasses[pass]);
+
+    auto prevTimeExp(timeExp);
+    {
+      ScopedTimer timer("propagation/frequency " + to_string(i));
+      solveWaveProblem(tract, freq, timePropa, &timeExp);
+    }
+    Profiler::getInstance().addTime("magnus exponential/frequency " + to_string(i),
+      (timeExp - prevTimeExp).count());
+
+    //***************************************************************************
+    //  Compute acoustic pressure
+    //***************************************************************************
+
+    auto start = std::chrono::system_clock::now();
+
+    {
+      ScopedTimer timer("tf extraction/frequency " + to_string(i));
+      // the kernel of the radiation is shared by the glottal and the noise
+      // sources transfer functions
+      buildRadiationKernel(m_tfPoints, freq, kernel);
+      m_glottalSourceTF.row(i) = acousticField(m_tfPoints, kernel);
+      m_planeModeInputImpedance(i, 0) = m_crossSections[0]->Zin()(0, 0);
+    }
+    exitVelocities.assign(1, m_crossSections.back()->Qout());
+
+    auto end = std::chrono::system_clock::now();
+    timeComputeField += end - start;
+
+    //***************************************************************************
+    //  Compute transfer function of the noise source
+    //***************************************************************************
+
+    if (computeNoiseSrcTf || (noiseSources.size() > 1) || (glottisConds.size() > 1))
+    {
+      ScopedTimer timer("noise source/frequency " + to_string(i));
+      vector<Eigen::VectorXcd> noiseExitVelocities;
+      solveWaveProblemNoiseSrc(noiseSources, glottisConds, freq, kernel, noiseTfs, 
+        &time, &noiseExitVelocities);
+      if (computeNoiseSrcTf) { m_noiseSourceTF.row(i) = noiseTfs[0].row(0); }
+      for (int k(1); k < noiseSources.size(); k++)
+      {
+        m_noiseSourcesTF[k - 1].row(i) = noiseTfs[0].row(k);
+      }
+      for (int c(1); c < glottisConds.size(); c++)
+      {
+        for (int k(0); k < noiseSources.size(); k++)
+        {
+          m_glottisCondsTF[(c - 1) * noiseSources.size() + k].row(i) = noiseTfs[c].row(k);
+        }
+      }
+      exitVelocities.insert(exitVelocities.end(), noiseExitVelocities.begin(),
+        noiseExitVelocities.end());
+    }
+
+    // keep the plane wave solution to blend it with the multimodal one
+    if (planeWavePasses.size() > 1)
+    {
+      if (pass == 0)
+      {
+        planeWaveRows.clear();
+        for (auto m : mats) { planeWaveRows.push_back(m->row(i)); }
+        planeWaveVelocities = exitVelocities;
+      }
+      else
+      {
+        for (int m(0); m < mats.size(); m++)
+        {
+          mats[m]->row(i) = (1. - weight) * planeWaveRows[m] + weight * mats[m]->row(i);
+        }
+        for (int s(0); s < exitVelocities.size(); s++)
+        {
+          if (exitVelocities[s].size() == planeWaveVelocities[s].size())
+          {
+            exitVelocities[s] = (1. - weight) * planeWaveVelocities[s] + 
+              weight * exitVelocities[s];
+          }
+        }
+      }
+    }
+  }
+
+  // each thread writes the element of its frequency
+  m_exitVelocities[i] = exitVelocities;
+
+  if (m_tfStream.isOpen()) { streamTfRow(i); }
+  setTfRowComputed(i);
+}
+
+// **************************************************************************
+// Compute the transfer functions for a set of frequency indexes, distributed
+// on the threads by the parallel sweep engine
+
+void Acoustic3dSimulation::computeTfAtFrequencies(VocalTract* tract,
+  const vector<int>& idxFreqs, ostream& log, std::chrono::duration<double>& timePropa,
+  std::chrono::duration<double>& timeComputeField, std::chrono::duration<double>& timeExp)
+{
+  mutex logMutex;
+
+  // the frequencies restored from the checkpoint are not computed again
+  vector<int> idxToCompute;
+  for (auto i : idxFreqs)
+  {
+    if (!isTfRowComputed(i)) { idxToCompute.push_back(i); }
+  }
+  int numThreads(sweepThreads(idxToCompute.size()));
+
+  setHybridBand(log);
+
+  // work variables and times of each thread
+  vector<radiationKernel> kernels(numThreads);
+  vector<vector<Eigen::MatrixXcd>> noiseTfs(numThreads);
+  vector<std::chrono::duration<double>> threadTimePropa(numThreads,
+    std::chrono::duration<double>(0.));
+  vector<std::chrono::duration<double>> threadTimeField(threadTimePropa),
+    threadTimeExp(threadTimePropa);
+
+  parallelSweep(idxToCompute.size(), numThreads, [&](int n, int t)
+    {
+      computeTfAtFrequency(tract, idxToCompute[n], kernels[t], noiseTfs[t], log, logMutex,
+        threadTimePropa[t], threadTimeField[t], threadTimeExp[t]);
+    });
+
+  for (int t(0); t < numThreads; t++)
+  {
+    timePropa += threadTimePropa[t];
+    timeComputeField += threadTimeField[t];
+    timeExp += threadTimeExp[t];
+  }
+}
+
+// **************************************************************************
+// Adaptive frequency sweep: the transfer functions are first computed on a 
+// coarse grid, then the intervals between two computed frequencies are split 
+// by computing their middle frequency while the interpolation error estimated
+// in the interval is larger than the tolerance. The frequencies which are not
+// computed are interpolated between the closest computed ones, so that the
+// transfer functions are given on the same uniform grid as by the full sweep.
+// Returns the number of frequencies computed.
+
+int Acoustic3dSimulation::adaptiveFrequencySweep(VocalTract* tract, ostream& log,
+  std::chrono::duration<double>& timePropa, std::chrono::duration<double>& timeComputeField,
+  std::chrono::duration<double>& timeExp)
+{
+  // spacing of the frequencies of the coarse grid (Hz), small enough
+  // to see the curvature of the transfer functions around the resonances
+  const double COARSE_GRID_SPACING(200.);
+
+  int lastIdx(m_numFreqComputed - 1);
+  int coarseStep(max(1, (int)(COARSE_GRID_SPACING / m_freqSteps)));
+  int numComputed(0);
+  vector<bool> computed(m_numFreqComputed, false);
+  vector<int> idxFreqs;
+  vector<pair<int, int>> intervals, newIntervals;
+
+  //*****************************************************************
+  // coarse grid
+  //*****************************************************************
+
+  for (int i(0); i < lastIdx; i += coarseStep) { idxFreqs.push_back(i); }
+  idxFreqs.push_back(lastIdx);
+  computeTfAtFrequencies(tract, idxFreqs, log, timePropa, timeComputeField, timeExp);
+  numComputed += idxFreqs.size();
+  for (int i(0); i < idxFreqs.size(); i++)
+  {
+    computed[idxFreqs[i]] = true;
+    if (i > 0) { intervals.push_back(pair<int, int>(idxFreqs[i - 1], idxFreqs[i])); }
+  }
+
+  //*****************************************************************
+  // refinement: the middle frequencies of all the intervals to split
+  // are computed at once to keep all the threads busy
+  //*****************************************************************
+
+  while (intervals.size() > 0)
+  {
+    idxFreqs.clear();
+    newIntervals.clear();
+    for (auto itv : intervals)
+    {
+      if ((itv.second - itv.first > 1) && (tfInterpolationError(computed,
+        itv.first, itv.second) > m_simuParams.adaptiveTfTolerance))
+      {
+        int mid((itv.first + itv.second) / 2);
+        idxFreqs.push_back(mid);
+        newIntervals.push_back(pair<int, int>(itv.first, mid));
+        newIntervals.push_back(pair<int, int>(mid, itv.second));
+      }
+    }
+    if (idxFreqs.size() == 0) { break; }
+
+    computeTfAtFrequencies(tract, idxFreqs, log, timePropa, timeComputeField, timeExp);
+    numComputed += idxFreqs.size();
+    for (auto i : idxFreqs) { computed[i] = true; }
+    intervals = newIntervals;
+  }
+
+  //*****************************************************************
+  // interpolate the frequencies which have not been computed
+  //*****************************************************************
+
+  int prevIdx(0);
+  for (int i(1); i <= lastIdx; i++)
+  {
+    if (computed[i])
+    {
+      interpolateTfRows(prevIdx, i);
+      for (int j(prevIdx + 1); j < i; j++) { m_tfRowInterpolated[j] = 1; }
+      if (m_tfStream.isOpen())
+      {
+        for (int j(prevIdx + 1); j < i; j++) { streamTfRow(j); }
+      }
+      prevIdx = i;
+    }
+  }
+
+  log << "Adaptive frequency sweep: " << numComputed << " / " 
+    << m_numFreqComputed << " frequencies computed" << endl;
+  Profiler::getInstance().addCount("adaptive sweep computed frequencies", numComputed);
+
+  return numComputed;
+}
+
+// **************************************************************************
+// Estimate the error of the interpolation of the transfer functions and of 
+// the input impedance in the middle of an interval between two computed 
+// frequencies, as the difference between the interpolation from the bounds
+// of the interval and the cubic interpolation from the bounds and their 
+// neighbouring computed frequencies. Both interpolations are done on the 
+// logarithm of the values (continuous phase), and the difference is expressed
+// in dB so that it accounts for the errors of magnitude and of phase 
+// (1 rad corresponds to 8.7 dB).
+
+double Acoustic3dSimulation::tfInterpolationError(const vector<bool>& computed, 
+  int idxStart, int idxEnd)
+{
+  bool noiseSrcTfComputed(m_idxSecNoiseSource < (int)m_crossSections.size() - 1);
+  vector<int> idxPts;
+  double maxError(0.);
+
+  // computed frequencies used for the cubic interpolation
+  for (int i(idxStart - 1); i >= 0; i--)
+  {
+    if (computed[i]) { idxPts.push_back(i); break; }
+  }
+  idxPts.push_back(idxStart);
+  idxPts.push_back(idxEnd);
+  for (int i(idxEnd + 1); i < computed.size(); i++)
+  {
+    if (computed[i]) { idxPts.push_back(i); break; }
+  }
+  // split the interval until a cubic interpolation is possible
+  if (idxPts.size() < 3) { return INFINITY; }
+  int posStart(idxPts[0] == idxStart ? 0 : 1);
+  double mid((double)(idxStart + idxEnd) / 2.);
+
+  auto error = [&](const Eigen::MatrixXcd& tf, int col)
+  {
+    // logarithm of the values with a continuous phase
+    vector<complex<double>> logVal(idxPts.size());
+    for (int i(0); i < idxPts.size(); i++)
+    {
+      if (abs(tf(idxPts[i], col)) == 0.) { return (double)INFINITY; }
+      logVal[i] = ((i == 0) ? log(tf(idxPts[0], col)) :
+        logVal[i - 1] + log(tf(idxPts[i], col) / tf(idxPts[i - 1], col)));
+    }
+
+    // Lagrange interpolation on all the points
+    complex<double> interp(0.);
+    for (int i(0); i < idxPts.size(); i++)
+    {
+      double weight(1.);
+      for (int j(0); j < idxPts.size(); j++)
+      {
+        if (j != i) { weight *= (mid - idxPts[j]) / (double)(idxPts[i] - idxPts[j]); }
+      }
+      interp += weight * logVal[i];
+    }
+
+    return 20. / log(10.) * abs(interp - 
+      0.5 * (logVal[posStart] + logVal[posStart + 1]));
+  };
+
+  for (int j(0); j < m_glottalSourceTF.cols(); j++)
+  {
+    maxError = max(maxError, error(m_glottalSourceTF, j));
+    if (noiseSrcTfComputed)
+    {
+      maxError = max(maxError, error(m_noiseSourceTF, j));
+    }
+    for (auto& tf : m_noiseSourcesTF)
+    {
+      maxError = max(maxError, error(tf, j));
+    }
+    for (auto& tf : m_glottisCondsTF)
+    {
+      maxError = max(maxError, error(tf, j));
+    }
+  }
+  maxError = max(maxError, error(m_planeModeInputImpedance, 0));
+
+  return maxError;
+}
+
+// **************************************************************************
+// Interpolate the transfer functions and the input impedance for the 
+// frequencies strictly between two computed frequencies
+
+void Acoustic3dSimulation::interpolateTfRows(int idxStart, int idxEnd)
+{
+  for (int i(idxStart + 1); i < idxEnd; i++)
+  {
+    double t((double)(i - idxStart) / (double)(idxEnd - idxStart));
+    for (int j(0); j < m_glottalSourceTF.cols(); j++)
+    {
+      m_glottalSourceTF(i, j) = logInterpolation(m_glottalSourceTF(idxStart, j),
+        m_glottalSourceTF(idxEnd, j), t);
+      m_noiseSourceTF(i, j) = logInterpolation(m_noiseSourceTF(idxStart, j),
+        m_noiseSourceTF(idxEnd, j), t);
+      for (auto& tf : m_noiseSourcesTF)
+      {
+        tf(i, j) = logInterpolation(tf(idxStart, j), tf(idxEnd, j), t);
+      }
+      for (auto& tf : m_glottisCondsTF)
+      {
+        tf(i, j) = logInterpolation(tf(idxStart, j), tf(idxEnd, j), t);
+      }
+    }
+    m_planeModeInputImpedance(i, 0) = logInterpolation(
+      m_planeModeInputImpedance(idxStart, 0), m_planeModeInputImpedance(idxEnd, 0), t);
+  }
+}
+
+// **************************************************************************
+// Open the NPY file in which the transfer functions are written during the
+// frequency sweep. Each row contains the frequency, the real and imaginary 
+// parts of the input impedance (as in zin.txt), then of the glottal source 
+// and of the noise source transfer functions at each transfer function point,
+// then of the transfer functions of the additional noise sources, and 
+// finally of the noise sources with the extra glottis boundary conditions.
+
+bool Acoustic3dSimulation::openTfStream()
+{
+  int numPts(m_glottalSourceTF.cols());
+  int numCols(3 + 2 * numPts * (2 + (int)m_noiseSourcesTF.size() + 
+    (int)m_glottisCondsTF.size()));
+  return m_tfStream.openRows(m_tfStreamFile, numCols);
+}
+
+// **************************************************************************
+// Write the transfer functions of a frequency index in the NPY file (the 
+// rows are written in the order in which the frequencies are computed)
+
+void Acoustic3dSimulation::streamTfRow(int idx)
+{
+  double freq(max(0.1, (double)idx * m_freqSteps));
+  complex<double> zin(1i * 2. * M_PI * freq * m_simuParams.volumicMass *
+    m_planeModeInputImpedance(idx, 0));
+  vector<double> row;
+  row.reserve(3 + 2 * m_glottalSourceTF.cols() * (2 + m_noiseSourcesTF.size() +
+    m_glottisCondsTF.size()));
+
+  row.push_back(freq);
+  row.push_back(zin.real());
+  row.push_back(zin.imag());
+  auto addTf = [&row, idx](const Eigen::MatrixXcd& tf)
+  {
+    for (int p(0); p < tf.cols(); p++)
+    {
+      row.push_back(tf(idx, p).real());
+      row.push_back(tf(idx, p).imag());
+    }
+  };
+  addTf(m_glottalSourceTF);
+  addTf(m_noiseSourceTF);
+  for (auto& tf : m_noiseSourcesTF) { addTf(tf); }
+  for (auto& tf : m_glottisCondsTF) { addTf(tf); }
+
+  m_tfStream.appendRow(row);
+}
+
+// **************************************************************************
+// Checkpoint of the frequency sweep: the rows of the transfer functions and
+// of the input impedance computed are written in a file of the cache 
+// directory whose key depends on the geometry and on all the parameters of 
+// the propagation, so that it is only restored for the same sweep. The 
+// modes, the junction matrices and the radiation impedance are restored 
+// from their own cache entries.
+
+CacheKey Acoustic3dSimulation::tfCheckpointKey(bool withTfPoints) const
+{
+  CacheKey key;
+
+  for (int i(0); i < m_crossSections.size(); i++)
+  {
+    key.add(junctionCacheKey(i));
+    key.add(m_crossSections[i]->numberOfModes());
+    key.add(m_crossSections[i]->length());
+    key.add(m_crossSections[i]->curvRadius());
+    key.add(m_crossSections[i]->circleArcAngle());
+    key.add(m_crossSections[i]->area());
+    key.add(m_crossSections[i]->scaleIn());
+  }
+
+  key.add(m_simuParams.temperature);
+  key.add(m_simuParams.volumicMass);
+  key.add(m_simuParams.sndSpeed);
+  key.add(m_simuParams.numIntegrationStep);
+  key.add(m_simuParams.orderMagnusScheme);
+  key.add(m_simuParams.freqDependentModes);
+  key.add(m_simuParams.modesFreqFactor);
+  key.add(m_simuParams.modesFreqMargin);
+  key.add(m_simuParams.hybridPlaneWave);
+  key.add(m_simuParams.hybridCrossoverFactor);
+  key.add(m_simuParams.hybridBlendWidth);
+  key.add(m_simuParams.adaptiveIntegrationStep);
+  key.add(m_simuParams.integrationStepTolerance);
+  key.add(m_simuParams.singlePrecisionPropagation);
+  key.add(&m_simuParams.viscousBndSpecAdm, sizeof(complex<double>));
+  key.add(&m_simuParams.thermalBndSpecAdm, sizeof(complex<double>));
+  key.add((int)m_simuParams.propMethod);
+  key.add(m_simuParams.percentageLosses);
+  key.add(m_simuParams.viscoThermalLosses);
+  key.add(m_simuParams.wallLosses);
+  key.add(m_simuParams.constantWallImped);
+  key.add(&m_simuParams.wallAdmit, sizeof(complex<double>));
+  key.add(m_simuParams.curved);
+  key.add(m_simuParams.varyingArea);
+  key.add(m_simuParams.junctionLosses);
+  key.add(m_simuParams.radImpedGridDensity);
+  key.add((int)m_simuParams.integrationMethodRadiation);
+  key.add((int)m_simuParams.integrationMethodRadImped);
+  key.add(m_simuParams.adaptiveFreqSampling);
+  key.add(m_simuParams.adaptiveTfTolerance);
+  key.add(m_numFreqComputed);
+  key.add(m_freqSteps);
+  if (withTfPoints)
+  {
+    for (auto& pt : m_simuParams.tfPoint)
+    {
+      key.add(pt.x());
+      key.add(pt.y());
+      key.add(pt.z());
+    }
+  }
+  key.add((int)m_glottisBoundaryCond);
+  for (auto cond : m_extraGlottisBoundaryConds) { key.add((int)cond); }
+  key.add((int)m_mouthBoundaryCond);
+  key.add(m_idxSecNoiseSource);
+  for (auto sec : m_noiseSourceSections) { key.add(sec); }
+
+  return key;
+}
+
+// **************************************************************************
+// Files of rows of the transfer functions and of the input impedance (of 
+// the checkpoints and of the blocks of the distributed sweep): the indexes
+// of the rows are followed by the real and imaginary parts of the rows of 
+// each matrix
+
+bool Acoustic3dSimulation::writeTfRows(const string& fileName, const vector<int>& rows)
+{
+  return writeCacheFile(fileName, [this, &rows](ostream& os)
+    {
+      auto writeRows = [&os, &rows](const Eigen::MatrixXcd& mat)
+      {
+        Eigen::MatrixXcd selected(rows.size(), mat.cols());
+        for (int r(0); r < rows.size(); r++) { selected.row(r) = mat.row(rows[r]); }
+        writeBinary(os, Eigen::MatrixXd(selected.real()));
+        writeBinary(os, Eigen::MatrixXd(selected.imag()));
+      };
+
+      writeBinary(os, m_numFreqComputed);
+      writeBinary(os, rows);
+      writeRows(m_glottalSourceTF);
+      writeRows(m_noiseSourceTF);
+      writeRows(m_planeModeInputImpedance);
+      for (auto& tf : m_noiseSourcesTF) { writeRows(tf); }
+      for (auto& tf : m_glottisCondsTF) { writeRows(tf); }
+    });
+}
+
+// **************************************************************************
+
+bool Acoustic3dSimulation::readTfRows(const string& fileName, vector<int>& rows)
+{
+  int numFreqs;
+  // glottal and noise source transfer functions, input impedance, 
+  // additional noise sources and extra glottis conditions transfer functions
+  vector<Eigen::MatrixXcd*> mats{ &m_glottalSourceTF, &m_noiseSourceTF, 
+    &m_planeModeInputImpedance };
+  for (auto& tf : m_noiseSourcesTF) { mats.push_back(&tf); }
+  for (auto& tf : m_glottisCondsTF) { mats.push_back(&tf); }
+  vector<Eigen::MatrixXcd> values(mats.size());
+
+  bool success(readCacheFile(fileName, 
+    [this, &numFreqs, &rows, &mats, &values](istream& is)
+    {
+      Eigen::MatrixXd re, im;
+      if (!readBinary(is, numFreqs) || (numFreqs != m_numFreqComputed) || 
+        !readBinary(is, rows)) 
+      { 
+        return false; 
+      }
+      for (auto i : rows)
+      {
+        if ((i < 0) || (i >= m_numFreqComputed)) { return false; }
+      }
+      for (int m(0); m < mats.size(); m++)
+      {
+        if (!readBinary(is, re) || !readBinary(is, im) || (re.rows() != rows.size()) ||
+          (re.cols() != mats[m]->cols()) || (im.rows() != re.rows()) || 
+          (im.cols() != re.cols()))
+        {
+          return false;
+        }
+        values[m] = re.cast<complex<double>>() + 1i * im.cast<complex<double>>();
+      }
+      return true;
+    }));
+
+  // the results are only modified if the whole file is valid
+  if (success)
+  {
+    lock_guard<mutex> lock(m_resultsMutex);
+    for (int m(0); m < mats.size(); m++)
+    {
+      for (int r(0); r < rows.size(); r++) { mats[m]->row(rows[r]) = values[m].row(r); }
+    }
+  }
+  else
+  {
+    rows.clear();
+  }
+  return success;
+}
+
+// **************************************************************************
+
+bool Acoustic3dSimulation::writeTfCheckpoint()
+{
+  vector<int> rows;
+  for (int i(0); i < m_tfRowComputed.size(); i++)
+  {
+    if (m_tfRowComputed[i]) { rows.push_back(i); }
+  }
+  return writeTfRows(m_tfCheckpointFile, rows);
+}
+
+// **************************************************************************
+
+bool Acoustic3dSimulation::readTfCheckpoint()
+{
+  vector<int> rows;
+  if (!readTfRows(m_tfCheckpointFile, rows)) { return false; }
+  for (auto i : rows) { m_tfRowComputed[i] = 1; }
+  return true;
+}
+
+// **************************************************************************
+
+int Acoustic3dSimulation::startTfCheckpoint(bool resume)
+{
+  // the modes are computed when the sweep starts
+  m_exitVelocitiesKey = tfCheckpointKey(false);
+
+  m_tfRowComputed.clear();
+  m_tfCheckpointFile = "";
+  if (m_cacheDirectory == "") { return 0; }
+
+  m_tfCheckpointFile = cacheFileName(m_cacheDirectory, "tf", tfCheckpointKey());
+  m_tfRowComputed.assign(m_numFreqComputed, 0);
+  m_lastTfCheckpoint = std::chrono::system_clock::now();
+
+  if (resume && readTfCheckpoint())
+  {
+    return count(m_tfRowComputed.begin(), m_tfRowComputed.end(), 1);
+  }
+  return 0;
+}
+
+// **************************************************************************
+// The checkpoint is written by the thread which computed the frequency, the
+// rows marked before have been written by the other threads before they
+// were marked under the lock
+
+void Acoustic3dSimulation::setTfRowComputed(int idx)
+{
+  if (m_tfRowComputed.empty()) { return; }
+
+  lock_guard<mutex> lock(m_tfCheckpointMutex);
+  m_tfRowComputed[idx] = 1;
+  auto now(std::chrono::system_clock::now());
+  if (std::chrono::duration<double>(now - m_lastTfCheckpoint).count() 
+    > TF_CHECKPOINT_INTERVAL)
+  {
+    if (!writeTfCheckpoint())
+    {
+      LogStream log(m_logFile);
+      log << "Cannot write the checkpoint " << m_tfCheckpointFile << endl;
+    }
+    m_lastTfCheckpoint = now;
+  }
+}
+
+// **************************************************************************
+// Write the last checkpoint at the end of the sweep (complete or not)
+
+void Acoustic3dSimulation::stopTfCheckpoint()
+{
+  lock_guard<mutex> lock(m_tfCheckpointMutex);
+  if (find(m_tfRowComputed.begin(), m_tfRowComputed.end(), 1) != m_tfRowComputed.end())
+  {
+    writeTfCheckpoint();
+  }
+  m_tfRowComputed.clear();
+  m_tfCheckpointFile = "";
+}
+
+// **************************************************************************
+// Distributed frequency sweep: the processes (e.g. on several nodes) share 
+// the directory m_distributedSweepDirectory and the cache directory. The 
+// root computes the modes, the junction matrices and the radiation 
+// impedance, which the workers read from the cache, and then writes the 
+// ready file. Each process claims the blocks of frequencies one after the 
+// other by creating their lock file and writes the rows computed in the 
+// file of the block, which the root gathers. The files of the blocks are 
+// kept, so that an interrupted sweep is resumed by running it again.
+
+static string readyFileName(const string& directory)
+{
+  return directory + "/tfready.bin";
+}
+
+// **************************************************************************
+
+string Acoustic3dSimulation::frequencyBlockFile(const CacheKey& key, int block,
+  bool claim) const
+{
+  return cacheFileName(m_distributedSweepDirectory, 
+    (claim ? "tfclaim" : "tfblock") + to_string(block), key);
+}
+
+// **************************************************************************
+
+void Acoustic3dSimulation::computeFrequencyBlock(VocalTract* tract, 
+  const CacheKey& key, int block, ostream& log, 
+  std::chrono::duration<double>& timePropa, 
+  std::chrono::duration<double>& timeComputeField, std::chrono::duration<double>& timeExp)
+{
+  vector<int> idxFreqs;
+  for (int i(block * DISTRIBUTED_SWEEP_BLOCK_SIZE); 
+    i < min(m_numFreqComputed, (block + 1) * DISTRIBUTED_SWEEP_BLOCK_SIZE); i++)
+  {
+    idxFreqs.push_back(i);
+  }
+  computeTfAtFrequencies(tract, idxFreqs, log, timePropa, timeComputeField, timeExp);
+
+  if (!writeTfRows(frequencyBlockFile(key, block, false), idxFreqs))
+  {
+    log << "Cannot write the file of the block " << block << endl;
+  }
+}
+
+// **************************************************************************
+
+bool Acoustic3dSimulation::computeTransferFunctionBlocks(VocalTract* tract)
+{
+  LogStream log(m_logFile);
+  std::chrono::duration<double> timePropa(0.), timeComputeField(0.), timeExp(0.);
+  string rootKey;
+  auto readRootKey = [&rootKey](istream& is)
+  {
+    vector<char> str;
+    if (!readBinary(is, str)) { return false; }
+    rootKey.assign(str.begin(), str.end());
+    return true;
+  };
+
+  precomputationsForTf();
+
+  // the modes, junction matrices and radiation impedance are read from the
+  // cache once the root has computed them
+  log << "Distributed sweep: waiting for the root" << endl;
+  while (!readCacheFile(readyFileName(m_distributedSweepDirectory), readRootKey))
+  {
+    this_thread::sleep_for(std::chrono::duration<double>(DISTRIBUTED_SWEEP_POLL_INTERVAL));
+  }
+  computeModesJunctionsAndRadiation(true);
+
+  CacheKey key(tfCheckpointKey());
+  if (key.str() != rootKey)
+  {
+    log << "Distributed sweep: the geometry or the parameters differ from the "
+      << "ones of the root" << endl;
+    log.close();
+    return false;
+  }
+
+  m_storeAxialProfile = !tfPointsRadiated();
+  int numBlocks((m_numFreqComputed + DISTRIBUTED_SWEEP_BLOCK_SIZE - 1) 
+    / DISTRIBUTED_SWEEP_BLOCK_SIZE);
+  int numComputed(0);
+  for (int b(0); b < numBlocks; b++)
+  {
+    if (createLockFile(frequencyBlockFile(key, b, true)))
+    {
+      computeFrequencyBlock(tract, key, b, log, timePropa, timeComputeField, timeExp);
+      numComputed++;
+    }
+  }
+  m_storeAxialProfile = true;
+
+  log << "Distributed sweep: " << numComputed << " / " << numBlocks 
+    << " blocks computed by this process" << endl;
+  log << "Time propagation (summed over threads): " << timePropa.count() << endl;
+  log.close();
+  return true;
+}
+
+// **************************************************************************
+
+void Acoustic3dSimulation::distributedFrequencySweep(VocalTract* tract, ostream& log,
+  std::chrono::duration<double>& timePropa, std::chrono::duration<double>& timeComputeField,
+  std::chrono::duration<double>& timeExp)
+{
+  CacheKey key(tfCheckpointKey());
+  int numBlocks((m_numFreqComputed + DISTRIBUTED_SWEEP_BLOCK_SIZE - 1) 
+    / DISTRIBUTED_SWEEP_BLOCK_SIZE);
+  vector<bool> gathered(numBlocks, false);
+  int numGathered(0), numComputed(0);
+  vector<int> rows;
+
+  if (m_simuParams.adaptiveFreqSampling)
+  {
+    log << "Distributed sweep: the adaptive frequency sampling is not used" << endl;
+  }
+
+  // the blocks computed by a previous run are kept, the claims of the 
+  // others are released since their process was interrupted
+  for (int b(0); b < numBlocks; b++)
+  {
+    if (readTfRows(frequencyBlockFile(key, b, false), rows))
+    {
+      gathered[b] = true;
+      numGathered++;
+      if (m_tfStream.isOpen())
+      {
+        for (auto i : rows) { streamTfRow(i); }
+      }
+    }
+    else
+    {
+      remove(frequencyBlockFile(key, b, true).c_str());
+    }
+  }
+  if (numGathered > 0)
+  {
+    log << "Distributed sweep: " << numGathered << " / " << numBlocks 
+      << " blocks restored" << endl;
+  }
+
+  string keyStr(key.str());
+  writeCacheFile(readyFileName(m_distributedSweepDirectory), [&keyStr](ostream& os)
+    { writeBinary(os, vector<char>(keyStr.begin(), keyStr.end())); });
+
+  //*****************************************************************
+  // the root computes blocks as the workers
+  //*****************************************************************
+
+  for (int b(0); b < numBlocks; b++)
+  {
+    if (!gathered[b] && createLockFile(frequencyBlockFile(key, b, true)))
+    {
+      computeFrequencyBlock(tract, key, b, log, timePropa, timeComputeField, timeExp);
+      gathered[b] = true;
+      numGathered++;
+      numComputed++;
+    }
   }
 
-  for (int i(m_numFreq); i < 2 * m_numFreq; i++)
+  //*****************************************************************
+  // gather the blocks of the workers, the blocks which are not 
+  // written after the timeout are computed by the root
+  //*****************************************************************
+
+  auto lastGathered(std::chrono::system_clock::now());
+  while (numGathered < numBlocks)
   {
-    spectrum.re[i] = spectrum.re[2 * m_numFreq - i - 1];
-    spectrum.im[i] = -spectrum.im[2 * m_numFreq - i - 1];
-    spectrumNoise.re[i] = spectrumNoise.re[2 * m_numFreq - i - 1];
-    spectrumNoise.im[i] = -spectrumNoise.im[2 * m_numFreq - i - 1];
+    for (int b(0); b < numBlocks; b++)
+    {
+      if (!gathered[b] && readTfRows(frequencyBlockFile(key, b, false), rows))
+      {
+        gathered[b] = true;
+        numGathered++;
+        lastGathered = std::chrono::system_clock::now();
+        if (m_tfStream.isOpen())
+        {
+          for (auto i : rows) { streamTfRow(i); }
+        }
+      }
+    }
+
+    if (numGathered == numBlocks) { break; }
+    if (std::chrono::duration<double>(std::chrono::system_clock::now() - 
+      lastGathered).count() > DISTRIBUTED_SWEEP_TIMEOUT)
+    {
+      for (int b(0); b < numBlocks; b++)
+      {
+        if (!gathered[b])
+        {
+          log << "Distributed sweep: block " << b << " computed by the root" << endl;
+          computeFrequencyBlock(tract, key, b, log, timePropa, timeComputeField, timeExp);
+          gathered[b] = true;
+          numGathered++;
+          numComputed++;
+        }
+      }
+    }
+    else
+    {
+      this_thread::sleep_for(std::chrono::duration<double>(DISTRIBUTED_SWEEP_POLL_INTERVAL));
+    }
   }
+
+  log << "Distributed sweep: " << numComputed << " / " << numBlocks 
+    << " blocks computed by the root" << endl;
 }
 
 // **************************************************************************
@@ -2580,76 +5514,123 @@ void Acoustic3dSimulation::generateSpectraForSynthesis(int tfIdx)
 
 void Acoustic3dSimulation::computeTransferFunction(VocalTract* tract)
 {
-  double freq;
-  Matrix F;
-
-  bool needToExtractMatrixF(true);
-
-  ofstream log("log.txt", ofstream::app);
+  LogStream log(m_logFile);
+  ScopedTimer timer("transfer function");
 
   // for time tracking
   auto startTot = std::chrono::system_clock::now();
-  auto start = std::chrono::system_clock::now();
   auto end = std::chrono::system_clock::now();
   std::chrono::duration<double> timePropa(0.), timeComputeField(0.), timeExp(0.), time;
 
   precomputationsForTf();
 
-  // loop over frequencies
+  // the ready file of a previous distributed sweep is removed, so that the
+  // workers wait until the modes, junction matrices and radiation impedance
+  // are computed
+  bool distributed(m_distributedSweepDirectory != "");
+  if (distributed) { remove(readyFileName(m_distributedSweepDirectory).c_str()); }
+
+  // the modes, junction matrices and radiation impedance are shared by all 
+  // the frequencies, so they are computed before the frequency loop
+  computeModesJunctionsAndRadiation(true);
+
+  // the characteristic impedances and the boundary admittances of the 
+  // sections are tabulated at the frequencies of the sweep
+  vector<double> sweepFreqs(m_numFreqComputed);
   for (int i(0); i < m_numFreqComputed; i++)
   {
-    freq = max(0.1, (double)i * m_freqSteps);
-    log << "frequency " << i + 1 << "/" << m_numFreqComputed << " f = " << freq
-      << " Hz" << endl;
-
-    solveWaveProblem(tract, freq, true, timePropa, &timeExp);
+    sweepFreqs[i] = max(0.1, (double)i * m_freqSteps);
+  }
+  {
+    ScopedTimer timerTables("sweep tables");
+    for (auto& sec : m_crossSections) { sec->precomputeSweepTables(sweepFreqs, m_simuParams); }
+  }
 
-    //*****************************************************************************
-    //  Compute acoustic pressure 
-    //*****************************************************************************
+  // the transfer functions only need the pressure and the velocity at the
+  // ends of the segments if all their points are outside
+  m_storeAxialProfile = !tfPointsRadiated();
 
-    start = std::chrono::system_clock::now();
+  // the transfer functions are written in the stream file as soon as each
+  // frequency is computed, so that they are kept if the sweep is interrupted
+  if ((m_tfStreamFile != "") && !openTfStream())
+  {
+    log << "Cannot open the file " << m_tfStreamFile << endl;
+  }
 
-    computeGlottalTf(i, freq);
+  // the frequencies computed before an interruption of the sweep are 
+  // restored from the checkpoint (and written first in the stream file)
+  // (the blocks of the distributed sweep are their own checkpoints)
+  int numRestored(distributed ? 0 : startTfCheckpoint(m_resumeTf));
+  if (numRestored > 0)
+  {
+    log << numRestored << " / " << m_numFreqComputed 
+      << " frequencies restored from the checkpoint" << endl;
+    if (m_tfStream.isOpen())
+    {
+      for (int i(0); i < m_numFreqComputed; i++)
+      {
+        if (isTfRowComputed(i)) { streamTfRow(i); }
+      }
+    }
+  }
 
-    end = std::chrono::system_clock::now();
-    timeComputeField += end - start;
+  log << "Frequency sweep on " 
+    << max(1, min(m_simuParams.numThreads, m_numFreqComputed)) << " thread(s)" << endl;
 
-    //*****************************************************************************
-    //  Compute transfer function of the noise source
-    //*****************************************************************************
+  if (distributed)
+  {
+    distributedFrequencySweep(tract, log, timePropa, timeComputeField, timeExp);
+  }
+  else if (m_simuParams.adaptiveFreqSampling)
+  {
+    adaptiveFrequencySweep(tract, log, timePropa, timeComputeField, timeExp);
+  }
+  else
+  {
+    vector<int> idxFreqs(m_numFreqComputed);
+    for (int i(0); i < m_numFreqComputed; i++) { idxFreqs[i] = i; }
+    computeTfAtFrequencies(tract, idxFreqs, log, timePropa, timeComputeField, timeExp);
+  }
 
-    solveWaveProblemNoiseSrc(needToExtractMatrixF, F, freq, &time);
+  m_storeAxialProfile = true;
+  m_tfStream.close();
+  stopTfCheckpoint();
+  logMemoryFootprint("transfer function");
+  for (auto& sec : m_crossSections) { sec->precomputeSweepTables(vector<double>(), m_simuParams); }
 
-    if (m_idxSecNoiseSource < m_crossSections.size() - 1)
-    {
-      computeNoiseSrcTf(i);
-    }
+  // set the computed frequencies
+  for (int i(0); i < m_numFreqComputed; i++)
+  {
+    m_tfFreqs.push_back(max(0.1, (double)i * m_freqSteps));
   }
 
-  log << "\nTime propagation: " << timePropa.count() << endl;
+  log << "\nTime propagation (summed over threads): " << timePropa.count() << endl;
 
   // generate spectra values for negative frequencies
   generateSpectraForSynthesis(0);
 
-  // Export plane mode input impedance
-  ofstream prop;
-  prop.open("zin.txt");
-  for (int i(0); i < m_numFreqComputed; i++)
+  // Export plane mode input impedance (it is in the stream file if any)
+  if (m_tfStreamFile == "")
   {
-    prop << m_tfFreqs[i] << "  "
-      << abs(1i * 2. * M_PI * m_tfFreqs[i] * m_simuParams.volumicMass *
-        m_planeModeInputImpedance(i, 0)) << "  "
-      << arg(1i * 2. * M_PI * m_tfFreqs[i] * m_simuParams.volumicMass *
-        m_planeModeInputImpedance(i, 0)) << endl;
+    ofstream prop;
+    prop.open("zin.txt");
+    for (int i(0); i < m_numFreqComputed; i++)
+    {
+      prop << m_tfFreqs[i] << "  "
+        << abs(1i * 2. * M_PI * m_tfFreqs[i] * m_simuParams.volumicMass *
+          m_planeModeInputImpedance(i, 0)) << "  "
+        << arg(1i * 2. * M_PI * m_tfFreqs[i] * m_simuParams.volumicMass *
+          m_planeModeInputImpedance(i, 0)) << endl;
+    }
+    prop.close();
   }
-  prop.close();
 
   end = std::chrono::system_clock::now();
   time = end - startTot;
   log << "\nTransfer function time (sec): " << time.count() << endl;
-  log << "Time acoustic pressure computation: " << timeComputeField.count() << endl;
-  log << "Time matrix exponential: " << timeExp.count() << endl;
+  log << "Time acoustic pressure computation (summed over threads): " 
+    << timeComputeField.count() << endl;
+  log << "Time matrix exponential (summed over threads): " << timeExp.count() << endl;
 
   // print total time in HMS
   int hours(floor(time.count() / 3600.));
@@ -2662,6 +5643,69 @@ void Acoustic3dSimulation::computeTransferFunction(VocalTract* tract)
   log.close();
 }
 
+// ****************************************************************************
+// Compare the transfer functions and the input impedance obtained with the 
+// single precision propagation to the double precision ones at numFreqs 
+// frequencies spread over the computed range. The deviations are written in
+// the log file and the maximal one (dB) is returned. The transfer functions
+// are left as computed in the precision set in the simulation parameters.
+
+double Acoustic3dSimulation::singlePrecisionDeviation(VocalTract* tract, int numFreqs)
+{
+  LogStream log(m_logFile);
+  std::chrono::duration<double> timePropa(0.), timeComputeField(0.), timeExp(0.);
+  bool singlePrecision(m_simuParams.singlePrecisionPropagation);
+
+  precomputationsForTf();
+  computeModesJunctionsAndRadiation(true);
+  m_storeAxialProfile = !tfPointsRadiated();
+
+  vector<int> idxFreqs;
+  int step(max(1, m_numFreqComputed / max(1, numFreqs)));
+  for (int i(step / 2); i < m_numFreqComputed; i += step) { idxFreqs.push_back(i); }
+
+  // the same frequencies are computed in both precisions
+  Eigen::MatrixXcd tf[2], zin[2];
+  for (int p(0); p < 2; p++)
+  {
+    m_simuParams.singlePrecisionPropagation = (p == 1);
+    computeTfAtFrequencies(tract, idxFreqs, log, timePropa, timeComputeField, timeExp);
+    tf[p] = m_glottalSourceTF;
+    zin[p] = m_planeModeInputImpedance;
+  }
+  m_simuParams.singlePrecisionPropagation = singlePrecision;
+  m_storeAxialProfile = true;
+
+  auto dB = [](complex<double> v) { return 20. * log10(max(abs(v), 1e-300)); };
+  double maxDevTf(0.), maxDevZin(0.);
+  log << "\nSingle precision propagation deviation (dB):" << endl;
+  for (auto i : idxFreqs)
+  {
+    double devTf(0.);
+    for (int j(0); j < tf[0].cols(); j++)
+    {
+      devTf = max(devTf, abs(dB(tf[1](i, j)) - dB(tf[0](i, j))));
+    }
+    double devZin(abs(dB(zin[1](i, 0)) - dB(zin[0](i, 0))));
+    log << max(0.1, (double)i * m_freqSteps) << " Hz  tf " << devTf 
+      << "  zin " << devZin << endl;
+    maxDevTf = max(maxDevTf, devTf);
+    maxDevZin = max(maxDevZin, devZin);
+  }
+  log << "Maximal deviation: tf " << maxDevTf << " dB  zin " << maxDevZin 
+    << " dB" << endl;
+  log.close();
+
+  // keep the results of the precision set in the simulation parameters
+  if (!singlePrecision)
+  {
+    m_glottalSourceTF = tf[0];
+    m_planeModeInputImpedance = zin[0];
+  }
+
+  return max(maxDevTf, maxDevZin);
+}
+
 // ****************************************************************************
 // Run a simulation at a specific frequency and compute the aoustic field 
 
@@ -2670,7 +5714,7 @@ void Acoustic3dSimulation::computeAcousticField(VocalTract* tract)
   double freq(m_simuParams.freqField);
 
   generateLogFileHeader(true);
-  ofstream log("log.txt", ofstream::app);
+  LogStream log(m_logFile);
 
   // for time tracking
   auto start = std::chrono::system_clock::now();
@@ -2679,6 +5723,7 @@ void Acoustic3dSimulation::computeAcousticField(VocalTract* tract)
   solveWaveProblem(tract, freq, false, elapsed_seconds, &timeExp);
 
   acousticFieldInPlane();
+  logMemoryFootprint("acoustic field");
 
   auto end = std::chrono::system_clock::now();
   elapsed_seconds = end - start;
@@ -2692,6 +5737,131 @@ void Acoustic3dSimulation::computeAcousticField(VocalTract* tract)
   log.close();
 }
 
+// ****************************************************************************
+// Compute the acoustic field in the bounding box at several frequencies. The
+// points are located in the segments and the modes are interpolated once, 
+// then the field of each frequency is obtained from the propagated 
+// amplitudes. The fields are written one after the other in the NPY file 
+// (complex array of freqs.size() * ny rows and nx columns), and the field of 
+// the last frequency is kept as the current field.
+
+bool Acoustic3dSimulation::computeAcousticFieldSpectrum(VocalTract* tract, 
+  const vector<double>& freqs, const string& fileName)
+{
+  ScopedTimer timer("field spectrum");
+  generateLogFileHeader(true);
+  LogStream log(m_logFile);
+  std::chrono::duration<double> time, timeExp;
+
+  computeModesJunctionsAndRadiation(false);
+  prepareAcousticFieldComputation();
+  fieldBasis basis;
+  buildFieldBasis(basis);
+
+  NpyWriter writer;
+  if (!writer.openArray(fileName, freqs.size() * m_nPty, m_nPtx))
+  {
+    log << "Cannot open the file " << fileName << endl;
+    return false;
+  }
+
+  Eigen::VectorXcd field;
+  for (int f(0); f < freqs.size(); f++)
+  {
+    solveWaveProblem(tract, freqs[f], time, &timeExp);
+    radiationSource radSrc;
+    field = acousticField(basis, freqs[f], radSrc);
+    for (int j(0); j < m_nPty; j++)
+    {
+      writer.writeValues(f * m_nPty + j, 0, field.data() + j * m_nPtx, m_nPtx);
+    }
+    log << "Acoustic field at " << freqs[f] << " Hz computed (" << f + 1 
+      << " / " << freqs.size() << ")" << endl;
+  }
+  writer.close();
+
+  if (freqs.size() > 0)
+  {
+    lock_guard<mutex> lock(m_resultsMutex);
+    for (int n(0); n < field.size(); n++)
+    {
+      if (m_fieldInMemory) { m_field(n / m_nPtx, n % m_nPtx) = field(n); }
+      m_maxAmpField = max(m_maxAmpField, abs(field(n)));
+      m_minAmpField = min(m_minAmpField, abs(field(n)));
+      m_maxPhaseField = max(m_maxPhaseField, arg(field(n)));
+      m_minPhaseField = min(m_minPhaseField, arg(field(n)));
+    }
+    m_fieldVersion++;
+  }
+
+  return true;
+}
+
+// ****************************************************************************
+// Compute the acoustic field in a box. The slices of the box are gathered 
+// in chunks of at most FIELD_VOLUME_CHUNK_SIZE points, whose basis is built 
+// and evaluated before the next chunk, so that the memory does not grow 
+// with the number of slices. The quadrature of the exit plane is shared by 
+// all the chunks.
+
+bool Acoustic3dSimulation::computeAcousticFieldVolume(VocalTract* tract, 
+  double freq, Point_3 pMin, Point_3 pMax, const array<int, 3>& numPts, 
+  const string& fileName)
+{
+  ScopedTimer timer("field volume");
+  generateLogFileHeader(true);
+  LogStream log(m_logFile);
+  std::chrono::duration<double> time, timeExp;
+
+  int nx(max(1, numPts[0])), ny(max(1, numPts[1])), nz(max(1, numPts[2]));
+  auto coord = [](double min, double max, int n, int i)
+    { return (n == 1) ? min : min + (max - min) * (double)i / (double)(n - 1); };
+
+  NpyWriter writer;
+  if (!writer.openArray(fileName, nz * ny, nx))
+  {
+    log << "Cannot open the file " << fileName << endl;
+    return false;
+  }
+
+  computeModesJunctionsAndRadiation(false);
+  solveWaveProblem(tract, freq, time, &timeExp);
+
+  int slicesPerChunk(max(1, FIELD_VOLUME_CHUNK_SIZE / (nx * ny)));
+  radiationSource radSrc;
+  fieldBasis basis;
+  vector<Point_3> queryPts;
+  Eigen::VectorXcd field;
+  for (int k0(0); k0 < nz; k0 += slicesPerChunk)
+  {
+    int k1(min(nz, k0 + slicesPerChunk));
+    queryPts.clear();
+    for (int k(k0); k < k1; k++)
+    {
+      for (int j(0); j < ny; j++)
+      {
+        for (int i(0); i < nx; i++)
+        {
+          queryPts.push_back(Point_3(coord(pMin.x(), pMax.x(), nx, i),
+            coord(pMin.y(), pMax.y(), ny, j), coord(pMin.z(), pMax.z(), nz, k)));
+        }
+      }
+    }
+
+    buildFieldBasis(queryPts, basis);
+    field = acousticField(basis, freq, radSrc);
+    for (int r(0); r < (k1 - k0) * ny; r++)
+    {
+      writer.writeValues(k0 * ny + r, 0, field.data() + r * nx, nx);
+    }
+    log << "Acoustic field of the slices " << k0 << " to " << k1 - 1 
+      << " computed (" << nz << " slices)" << endl;
+  }
+  writer.close();
+
+  return true;
+}
+
 // ****************************************************************************
 // Run a simulation for a concatenation of cylinders
 
@@ -2731,7 +5901,7 @@ void Acoustic3dSimulation::coneConcatenationSimulation(string fileName)
   //m_simuParams.sndSpeed = 34400;
 
   generateLogFileHeader(true);
-  ofstream log("log.txt", ofstream::app);
+  LogStream log(m_logFile);
   log << "\nStart cylinder concatenation simulation" << endl;
   if (reverse) { log << "Propagation direction reversed" << endl; }
   log << "Geometry from file " << fileName << endl;
@@ -2896,10 +6066,16 @@ void Acoustic3dSimulation::coneConcatenationSimulation(string fileName)
   // solve wave problem
   //*********************
 
-  computeMeshAndModes();
+  {
+    ScopedTimer timer("cone concatenation/modes");
+    computeMeshAndModes();
+  }
   log << "Modes computed" << endl;
 
-  computeJunctionMatrices(false);
+  {
+    ScopedTimer timer("cone concatenation/junctions");
+    computeJunctionMatrices(false);
+  }
   log << "Junctions computed" << endl;
 
   // initialize input pressure and velocity vectors
@@ -2910,17 +6086,31 @@ void Acoustic3dSimulation::coneConcatenationSimulation(string fileName)
   freqMax = 10000.;
   m_numFreq = 501;
   idxStr = fileName.find_last_of("/\\");
-  str = fileName.substr(0, idxStr + 1) + "tfMM.txt"; 
-  ofs.open(str);
   // define the coordinate of the point where the acoustic field is computed
   // for transfer fucntion computation
   if (reverse) { ptOut = Point(0., shifts[0] * rads[0]); }
   else { ptOut = Point(0., shifts.back() * rads.back()); }
   log << "Point for transfer function computation " << ptOut << endl;
-  for (int i(0); i < m_numFreq; i++)
+
+  // the frequencies are solved by the parallel sweep engine, the particle 
+  // velocity, the pressure and the admittance of each frequency are stored 
+  // and written in the order of the frequencies
+  vector<array<complex<double>, 3>> tfValues(m_numFreq);
+  mutex logMutex;
+  int numThreads(sweepThreads(m_numFreq));
+  log << "Frequency sweep on " << numThreads << " thread(s)" << endl;
+  parallelSweep(m_numFreq, numThreads, [&](int i, int)
   {
-    freq = max(0.1, freqMax * (double)i / (double)(m_numFreq - 1));
-    log << "f = " << freq << " Hz" << endl;
+    double freq(max(0.1, freqMax * (double)i / (double)(m_numFreq - 1)));
+    Eigen::MatrixXcd radImped, radAdmit;
+    Eigen::MatrixXcd inputVelocity(Eigen::MatrixXcd::Zero(mn, 1)), inputPressure;
+    complex<double> pout, vout, yin;
+    std::chrono::duration<double> time(0.);
+    ScopedTimer timer("cone concatenation/frequency " + to_string(i));
+    {
+      lock_guard<mutex> lock(logMutex);
+      log << "f = " << freq << " Hz" << endl;
+    }
 
     if (reverse)
     {
@@ -2980,14 +6170,21 @@ void Acoustic3dSimulation::coneConcatenationSimulation(string fileName)
 
     }
 
-    // write result in a text file
-    ofs << freq << "  "
-      << "  " << abs(vout) // modulus of particle velocity
-      << "  " << arg(vout) // phase of particle velocity
-      << "  " << abs(pout) // modulus of acoustic pressure
-      << "  " << arg(pout) // phase of acoustic pressure
-      << "  " << abs(yin)  // modulus of the input impedance
-      << "  " << arg(yin)  // phase of the input impedance
+    tfValues[i] = { vout, pout, yin };
+  });
+
+  // write result in a text file
+  str = fileName.substr(0, idxStr + 1) + "tfMM.txt"; 
+  ofs.open(str);
+  for (int i(0); i < m_numFreq; i++)
+  {
+    ofs << max(0.1, freqMax * (double)i / (double)(m_numFreq - 1)) << "  "
+      << "  " << abs(tfValues[i][0]) // modulus of particle velocity
+      << "  " << arg(tfValues[i][0]) // phase of particle velocity
+      << "  " << abs(tfValues[i][1]) // modulus of acoustic pressure
+      << "  " << arg(tfValues[i][1]) // phase of acoustic pressure
+      << "  " << abs(tfValues[i][2])  // modulus of the input impedance
+      << "  " << arg(tfValues[i][2])  // phase of the input impedance
       << endl;
   }
   ofs.close();
@@ -3108,7 +6305,7 @@ void Acoustic3dSimulation::runTest(enum testType tType, string fileName)
   string line, str;
   char separator(';');
   stringstream strs, txtField;
-  ofstream log("log.txt", ofstream::app);
+  LogStream log(m_logFile);
   log << "\nStart test" << endl;
 
   Polygon_2 contour;
@@ -3415,23 +6612,40 @@ void Acoustic3dSimulation::runTest(enum testType tType, string fileName)
   
     freqMax = 2500.;
     nbFreqs = 1500;
-    ofs.open("imp.txt");
-    ofs2.open("freqs.txt");
-    ofs3.open("rad.txt");
-    for (int i(0); i < nbFreqs; i++)
     {
-      // get the output impedance
-      freq = max(0.1, freqMax*(double)i/(double)(nbFreqs - 1));
-      log << "f = " << freq << " Hz" << endl;
-      
-      interpolateRadiationImpedance(radImped, freq, 0);
-      ofs3 << radImped.imag() << endl;
-  
-      // Propagate impedance
-      m_crossSections[0]->propagateMagnus(radImped, m_simuParams, freq, -1., IMPEDANCE, &elapsedTime);
-  
-      ofs2 << freq << endl;
-      ofs << m_crossSections[0]->Zin().cwiseAbs() << endl;
+      // the frequencies are solved by the parallel sweep engine and the 
+      // results are written in the order of the frequencies
+      vector<Eigen::MatrixXd> radImag(nbFreqs), zinAbs(nbFreqs);
+      mutex logMutex;
+      parallelSweep(nbFreqs, sweepThreads(nbFreqs), [&](int i, int)
+      {
+        ScopedTimer timer("test discontinuity/frequency " + to_string(i));
+        double freq(max(0.1, freqMax * (double)i / (double)(nbFreqs - 1)));
+        Eigen::MatrixXcd radImped;
+        std::chrono::duration<double> time(0.);
+        {
+          lock_guard<mutex> lock(logMutex);
+          log << "f = " << freq << " Hz" << endl;
+        }
+
+        // get the output impedance
+        interpolateRadiationImpedance(radImped, freq, 0);
+        radImag[i] = radImped.imag();
+
+        // Propagate impedance
+        m_crossSections[0]->propagateMagnus(radImped, m_simuParams, freq, -1., IMPEDANCE, &time);
+        zinAbs[i] = m_crossSections[0]->Zin().cwiseAbs();
+      });
+
+      ofs.open("imp.txt");
+      ofs2.open("freqs.txt");
+      ofs3.open("rad.txt");
+      for (int i(0); i < nbFreqs; i++)
+      {
+        ofs3 << radImag[i] << endl;
+        ofs2 << max(0.1, freqMax * (double)i / (double)(nbFreqs - 1)) << endl;
+        ofs << zinAbs[i] << endl;
+      }
     }
     ofs3.close();
     ofs2.close();
@@ -3536,55 +6750,74 @@ void Acoustic3dSimulation::runTest(enum testType tType, string fileName)
     log << "pointComputeField " << pointComputeField << endl;
 
     freqMax = m_simuParams.maxComputedFreq;
-    ofs.open("press.txt");
     m_numFreq = 2001;
-    for (int i(0); i < m_numFreq; i++)
     {
-      freq = max(0.1, freqMax*(double)i/(double)(m_numFreq - 1));
-      log << "f = " << freq << " Hz" << endl;
-
-      if (m_mouthBoundaryCond == RADIATION) 
+      // the frequencies are solved by the parallel sweep engine and the 
+      // results are written in the order of the frequencies
+      vector<complex<double>> results(m_numFreq);
+      mutex logMutex;
+      parallelSweep(m_numFreq, sweepThreads(m_numFreq), [&](int i, int)
       {
-        interpolateRadiationImpedance(radImped, freq, 0);
-      }
+        ScopedTimer timer("test elephant trunk/frequency " + to_string(i));
+        double freq(max(0.1, freqMax * (double)i / (double)(m_numFreq - 1)));
+        Eigen::MatrixXcd imped(radImped), velocity(inputVelocity), pressure;
+        Eigen::VectorXcd radPress;
+        std::chrono::duration<double> time(0.);
+        {
+          lock_guard<mutex> lock(logMutex);
+          log << "f = " << freq << " Hz" << endl;
+        }
 
-      ofs2 << characImped.real() << endl;
-      ofs3 << characImped.imag() << endl;
+        if (m_mouthBoundaryCond == RADIATION) 
+        {
+          interpolateRadiationImpedance(imped, freq, 0);
+        }
 
-      //log << "Radiation impedance interpolated" << endl;
-  
-      switch (m_mouthBoundaryCond)
-      {
-      case RADIATION:
-        m_crossSections[0]->propagateMagnus(radImped, m_simuParams, freq, -1., IMPEDANCE, &elapsedTime);
-        break;
-      case ADMITTANCE_1:
-        m_crossSections[0]->propagateMagnus(radAdmit, m_simuParams, freq, -1., ADMITTANCE, &elapsedTime);
-        break;
-      }
+        switch (m_mouthBoundaryCond)
+        {
+        case RADIATION:
+          m_crossSections[0]->propagateMagnus(imped, m_simuParams, freq, -1., IMPEDANCE, &time);
+          break;
+        case ADMITTANCE_1:
+          m_crossSections[0]->propagateMagnus(radAdmit, m_simuParams, freq, -1., ADMITTANCE, &time);
+          break;
+        }
 
-      // propagate velocity or pressure
-      inputVelocity(0, 0) = -1i * 2. * M_PI * freq * m_simuParams.volumicMass;
+        // propagate velocity or pressure
+        velocity(0, 0) = -1i * 2. * M_PI * freq * m_simuParams.volumicMass;
 
-      switch (m_mouthBoundaryCond)
+        switch (m_mouthBoundaryCond)
+        {
+        case RADIATION:
+          m_crossSections[0]->propagateMagnus(velocity, m_simuParams, freq, 1., VELOCITY, &time);
+          // compute radiated pressure
+          RayleighSommerfeldIntegral(radPts, radPress, freq, 0);
+          spectrum.setValue(i, radPress(0, 0));
+          results[i] = radPress(0);
+          break;
+        case ADMITTANCE_1:
+          pressure = m_crossSections[0]->Yin().inverse() * velocity;
+          m_crossSections[0]->propagateMagnus(pressure, m_simuParams, freq, 1., PRESSURE, &time);
+          results[i] = m_crossSections[0]->area() * pow(m_crossSections[0]->scaleIn(), 2) * 1e5 *
+            acousticField(pointComputeField);
+          break;
+        }
+      });
+
+      // export result
+      ofs.open("press.txt");
+      for (int i(0); i < m_numFreq; i++)
       {
-      case RADIATION:
-        m_crossSections[0]->propagateMagnus(inputVelocity, m_simuParams, freq, 1., VELOCITY, &elapsedTime);
-        // compute radiated pressure
-        RayleighSommerfeldIntegral(radPts, radPress, freq, 0);
-        spectrum.setValue(i, radPress(0, 0));
-        ofs << abs(1e5 * radPress(0) / 2. / M_PI) << "  "
-          << arg(1e5 * radPress(0) / 2. / M_PI) << "  " << endl;
-        break;
-      case ADMITTANCE_1:
-        inputPressure = m_crossSections[0]->Yin().inverse() * inputVelocity;
-        m_crossSections[0]->propagateMagnus(inputPressure, m_simuParams, freq, 1., PRESSURE, &elapsedTime);
-        result = m_crossSections[0]->area() * pow(m_crossSections[0]->scaleIn(), 2) * 1e5 *
-          acousticField(pointComputeField);
-        // export result
-        ofs << freq << "  " << abs(result) << "  "
-          << arg(result) << "  " << endl;
-        break;
+        if (m_mouthBoundaryCond == RADIATION)
+        {
+          ofs << abs(1e5 * results[i] / 2. / M_PI) << "  "
+            << arg(1e5 * results[i] / 2. / M_PI) << "  " << endl;
+        }
+        else
+        {
+          ofs << max(0.1, freqMax * (double)i / (double)(m_numFreq - 1)) << "  " 
+            << abs(results[i]) << "  " << arg(results[i]) << "  " << endl;
+        }
       }
     }
     ofs.close();
@@ -3775,12 +7008,14 @@ void Acoustic3dSimulation::runTest(enum testType tType, string fileName)
 void Acoustic3dSimulation::cleanAcousticField()
 {
   m_field.resize(0, 0);
+  m_fieldVersion++;
 }
 
 // ****************************************************************************
 
 double Acoustic3dSimulation::maxAmpField()
 {
+  lock_guard<mutex> lock(m_resultsMutex);
   if (m_simuParams.showAmplitude)
   {
     return m_maxAmpField;
@@ -3795,6 +7030,7 @@ double Acoustic3dSimulation::maxAmpField()
 
 double Acoustic3dSimulation::minAmpField()
 {
+  lock_guard<mutex> lock(m_resultsMutex);
   if (m_simuParams.showAmplitude)
   {
     return m_minAmpField;
@@ -3895,7 +7131,7 @@ Point_3 Acoustic3dSimulation::movePointFromExitLandmarkToGeoLandmark(Point_3 pt)
 
 bool Acoustic3dSimulation::setTFPointsFromCsvFile(string fileName)
 {
-  ofstream log("log.txt", ofstream::app);
+  LogStream log(m_logFile);
   log << "Start transfer function points extraction" << endl;
 
   ifstream inputFile(fileName);
@@ -3971,21 +7207,29 @@ bool Acoustic3dSimulation::setTFPointsFromCsvFile(string fileName)
 void Acoustic3dSimulation::RayleighSommerfeldIntegral(vector<Point_3> points,
   Eigen::VectorXcd& radPress, double freq, int radSecIdx)
 {
-  int nbPts(points.size());
-  double quadPtCoord[3][2]{ {1. / 6., 1. / 6.}, {2. / 3., 1. / 6.}, {1. / 6., 2. / 3.} };
+  radiationSource radSrc;
+  radiationSourceQuadrature(radSrc, freq, radSecIdx);
+  RayleighSommerfeldIntegral(points, radPress, radSrc);
+}
+
+// ****************************************************************************
+// Generate the integration points and weights of the exit plane of a segment
+// used to compute the Rayleigh-Sommerfeld integral, with the scaling of the 
+// radiated points and the signed wave number of the Green's function
+
+void Acoustic3dSimulation::radiationQuadraturePoints(double freq, int radSecIdx,
+  vector<Point>& intPts, vector<double>& weights, double& pointScaling, 
+  double& waveNumber)
+{
   double quadPtWeight = 1. / 3.;
-  vector<Point> gaussPts;
-  vector<double> areaFaces;
-  double r, k(2.*M_PI*freq/m_simuParams.sndSpeed), scaling;
+  double k(2.*M_PI*freq/m_simuParams.sndSpeed), scaling;
+
+  intPts.clear();
+  weights.clear();
 
   // get scaling
   scaling = m_crossSections[radSecIdx]->scaleOut();
 
-  // get velocity mode amplitude (v_x = j * q / w / rho)
-  auto Vm = m_crossSections[radSecIdx]->Qout();
-
-  radPress = Eigen::VectorXcd::Zero(nbPts);
-
   switch (m_simuParams.integrationMethodRadiation)
   {
     //////////////
@@ -4001,8 +7245,7 @@ void Acoustic3dSimulation::RayleighSommerfeldIntegral(vector<Point_3> points,
     double dS(pow(spacing, 2));
 
     // generate the grid
-    Polygon_2 contour(m_crossSections[radSecIdx]->contour());
-    vector<Point> cartGrid;
+    const Polygon_2& contour(m_crossSections[radSecIdx]->contour());
     Point pt;
     double xmin(contour.bbox().xmin());
     double ymin(contour.bbox().ymin());
@@ -4015,82 +7258,223 @@ void Acoustic3dSimulation::RayleighSommerfeldIntegral(vector<Point_3> points,
         pt = Point(xmin + i * spacing, ymin + j * spacing);
         if (contour.has_on_bounded_side(pt))
         {
-          cartGrid.push_back(pt);
+          intPts.push_back(pt);
+          weights.push_back(dS);
         }
       }
     }
 
-    // Interpolate the propagation modes on the cartesian grid
-    Matrix intCartGrid(m_crossSections[radSecIdx]->interpolateModes(cartGrid));
+    pointScaling = 1.;
+    waveNumber = k * scaling;
+    break;
+  }
+
+    //////////
+    // GAUSS
+    //////////
+
+  case GAUSS:
+  {
+    vector<double> areaFaces;
+
+    // get quadrature points
+    gaussPointsFromMesh(intPts, areaFaces, m_crossSections[radSecIdx]->getPoints(),
+      m_crossSections[radSecIdx]->getTriangles());
+    for (int f(0); f < areaFaces.size(); f++)
+    {
+      for (int g(0); g < 3; g++)
+      {
+        weights.push_back(areaFaces[f] * quadPtWeight);
+      }
+    }
+
+    // the radiated points are scaled
+    pointScaling = 1. / scaling;
+    waveNumber = -k * scaling;
+    break;
+  }
+  }
+}
+
+// ****************************************************************************
+// Generate the quadrature of the exit plane of a segment used to compute the
+// Rayleigh-Sommerfeld integral: positions of the integration points and
+// amplitudes gathering the integration weights and the modal velocity. 
+// It depends only on the frequency, thus it can be shared by all the 
+// radiated points.
+
+void Acoustic3dSimulation::radiationSourceQuadrature(radiationSource& radSrc,
+  double freq, int radSecIdx)
+{
+  vector<Point> intPts;
+  vector<double> weights;
+  double scaling(m_crossSections[radSecIdx]->scaleOut());
+
+  radiationQuadraturePoints(freq, radSecIdx, intPts, weights, radSrc.pointScaling,
+    radSrc.waveNumber);
+
+  // get velocity mode amplitude (v_x = j * q / w / rho) and compute the sum
+  // of the modes weighted by it at each integration point
+  Eigen::VectorXcd velocity(intPts.size());
+  if (intPts.size() > 0)
+  {
+    Matrix intModes;
+    m_crossSections[radSecIdx]->interpolateModes(intPts, intModes);
+    velocity = intModes.cast<complex<double>>() * m_crossSections[radSecIdx]->Qout();
+  }
+
+  int nbSrc(intPts.size());
+  radSrc.y.resize(nbSrc);
+  radSrc.z.resize(nbSrc);
+  radSrc.ampRe.resize(nbSrc);
+  radSrc.ampIm.resize(nbSrc);
+  for (int c(0); c < nbSrc; c++)
+  {
+    complex<double> amp(-weights[c] * velocity(c) / scaling / 2. / M_PI);
+    radSrc.y[c] = intPts[c].x();
+    radSrc.z[c] = intPts[c].y();
+    radSrc.ampRe[c] = amp.real();
+    radSrc.ampIm[c] = amp.imag();
+  }
+  radSrc.built = true;
+}
+
+// ****************************************************************************
+// Compute the Rayleigh-Sommerfeld integral of a source quadrature for a set
+// of points. The points are processed by blocks small enough so that their
+// coordinates and the accumulated pressures stay in the cache while looping 
+// over the integration points, and the inner loop only works on contiguous 
+// arrays of doubles so that it can be vectorised.
+
+void Acoustic3dSimulation::RayleighSommerfeldIntegral(const vector<Point_3>& points,
+  Eigen::VectorXcd& radPress, const radiationSource& radSrc)
+{
+  const int BLOCK_SIZE(64);
+  int nbPts(points.size());
+  int nbSrc(radSrc.y.size());
+  double px2[BLOCK_SIZE], py[BLOCK_SIZE], pz[BLOCK_SIZE];
+  double accRe[BLOCK_SIZE], accIm[BLOCK_SIZE];
+  double dy, dz, r, ph, kr(radSrc.waveNumber), sc(radSrc.pointScaling);
+
+  radPress = Eigen::VectorXcd::Zero(nbPts);
+
+  for (int start(0); start < nbPts; start += BLOCK_SIZE)
+  {
+    int nb(min(BLOCK_SIZE, nbPts - start));
+    for (int p(0); p < nb; p++)
+    {
+      px2[p] = pow(points[start + p].x() * sc, 2);
+      py[p] = points[start + p].y() * sc;
+      pz[p] = points[start + p].z() * sc;
+      accRe[p] = 0.;
+      accIm[p] = 0.;
+    }
 
     // loop over the integration points
-    for (int c(0); c < cartGrid.size(); c++)
+    for (int c(0); c < nbSrc; c++)
+    {
+      double y(radSrc.y[c]), z(radSrc.z[c]);
+      double aRe(radSrc.ampRe[c]), aIm(radSrc.ampIm[c]);
+      // loop over the points of the block
+      for (int p(0); p < nb; p++)
+      {
+        dy = py[p] - y;
+        dz = pz[p] - z;
+        r = sqrt(px2[p] + dy * dy + dz * dz);
+        ph = kr * r;
+        accRe[p] += (aRe * cos(ph) - aIm * sin(ph)) / r;
+        accIm[p] += (aRe * sin(ph) + aIm * cos(ph)) / r;
+      }
+    }
+
+    for (int p(0); p < nb; p++)
+    {
+      radPress(start + p) = complex<double>(accRe[p], accIm[p]);
+    }
+  }
+}
+
+// ****************************************************************************
+// Build the Green's matrix giving the pressure radiated at the points 
+// queryPt from the amplitudes of the velocity modes at the exit of the last 
+// segment. The Rayleigh-Sommerfeld kernel between the points and the 
+// integration points is computed by blocks of points and multiplied by the 
+// amplitudes of the modes at the integration points, so that the 
+// trigonometric functions are evaluated once for all the computations of 
+// the field at these points and at this frequency.
+
+void Acoustic3dSimulation::buildRadiationKernel(const vector<Point_3>& queryPt,
+  double freq, radiationKernel& kernel)
+{
+  const int BLOCK_SIZE(64);
+  int radSecIdx(m_crossSections.size() - 1);
+  int mn(m_crossSections[radSecIdx]->numberOfModes());
+  double scaling(m_crossSections[radSecIdx]->scaleOut());
+  double sc, kr;
+  vector<Point> intPts;
+  vector<double> weights;
+  vector<Point_3> radPts;
+  Point_3 radPt;
+
+  // separate the radiated points from the points inside the geometry
+  kernel.idxRadPts.clear();
+  kernel.idxInteriorPts.clear();
+  for (int i(0); i < queryPt.size(); i++)
+  {
+    if (!isRadiatedPoint(queryPt[i], radPt))
     {
-      // loop over the transverse modes
-      for (int m(0); m < m_crossSections[radSecIdx]->numberOfModes(); m++)
-      {
-        // loop over points
-        for (int p(0); p < nbPts; p++)
-        {
-          r = sqrt(CGAL::squared_distance(points[p],
-            Point_3(0., cartGrid[c].x(), cartGrid[c].y())));
-          radPress(p) -= Vm(m) * intCartGrid(c, m) * exp(1i * k * scaling * r) * dS / scaling / r;
-        }
-      }
+      kernel.idxInteriorPts.push_back(i);
     }
-    break;
+    else if (m_simuParams.computeRadiatedField)
+    {
+      radPts.push_back(radPt);
+      kernel.idxRadPts.push_back(i);
+    }
+  }
+  int nbPts(radPts.size());
+  kernel.green.setZero(nbPts, mn);
+  kernel.freq = freq;
+  kernel.built = true;
+  if (nbPts == 0) { return; }
+
+  // amplitudes of the modes at the integration points, multiplied by the
+  // integration weights
+  radiationQuadraturePoints(freq, radSecIdx, intPts, weights, sc, kr);
+  int nbSrc(intPts.size());
+  if (nbSrc == 0) { return; }
+  Matrix intModes;
+  m_crossSections[radSecIdx]->interpolateModes(intPts, intModes);
+  Eigen::MatrixXcd modesAmp(intModes.cast<complex<double>>());
+  for (int c(0); c < nbSrc; c++)
+  {
+    modesAmp.row(c) *= -weights[c] / scaling / 2. / M_PI;
   }
 
-    //////////
-    // GAUSS
-    //////////
+  // scaled coordinates of the points
+  vector<double> x2(nbPts), yPts(nbPts), zPts(nbPts), dist(BLOCK_SIZE);
+  for (int p(0); p < nbPts; p++)
+  {
+    x2[p] = pow(radPts[p].x() * sc, 2);
+    yPts[p] = radPts[p].y() * sc;
+    zPts[p] = radPts[p].z() * sc;
+  }
 
-    // compute Guauss integral
-  case GAUSS:
+  // Green's function between the points and the integration points
+  Eigen::MatrixXcd greenFunc(min(BLOCK_SIZE, nbPts), nbSrc);
+  for (int start(0); start < nbPts; start += BLOCK_SIZE)
+  {
+    int nb(min(BLOCK_SIZE, nbPts - start));
+    for (int c(0); c < nbSrc; c++)
     {
-      // get quadrature points
-      gaussPointsFromMesh(gaussPts, areaFaces,
-        m_crossSections[radSecIdx]->triangulation());
-
-      // interpolate modes
-      Matrix interpolatedModes = m_crossSections[radSecIdx]->
-        interpolateModes(gaussPts);
-
-      // scale the position of the integration points
-      Transformation3 scale(CGAL::SCALING, 1. / scaling);
-      for (int i(0); i < points.size(); i++)
-      {
-        points[i] = scale(points[i]);
-      }
-      
-      // loop over the faces of the mesh
-      for (int f(0); f < areaFaces.size(); f++)
+      pointDistances(&x2[start], &yPts[start], &zPts[start], intPts[c].x(),
+        intPts[c].y(), dist.data(), nb);
+      for (int p(0); p < nb; p++)
       {
-        // loop over the modes
-        for (int m(0); m < m_crossSections[radSecIdx]->numberOfModes(); m++)
-        {
-          // loop over points
-          for (int p(0); p < nbPts; p++)
-          {
-            // loop over Gauss integration points
-            for (int g(0); g < 3; g++)
-            {
-              // compute distance r between gauss point and the point
-              r = sqrt(CGAL::squared_distance(points[p],
-                Point_3(0., gaussPts[f * 3 + g].x(), gaussPts[f * 3 + g].y())));
-
-              // compute integral
-              radPress(p) -= areaFaces[f] * quadPtWeight *
-                Vm(m) * interpolatedModes(f * 3 + g, m) * exp(-1i * k * scaling * r) / scaling / r;
-            }
-          }
-        }
+        greenFunc(p, c) = polar(1. / dist[p], kr * dist[p]);
       }
-      break;
     }
+    kernel.green.middleRows(start, nb).noalias() = greenFunc.topRows(nb) * modesAmp;
   }
-
-  radPress /= 2 * M_PI;
 }
 
 // ****************************************************************************
@@ -4195,6 +7579,12 @@ void Acoustic3dSimulation::createContour(double inputUpProf[VocalTract::NUM_PROF
     }
   }
 
+  // select the samples needed to describe the profiles, the samples in the
+  // flat regions between them are not inserted in the polygons
+  bool keepSample[VocalTract::NUM_PROFILE_SAMPLES];
+  VocalTract::getAdaptiveProfileSamples(inputUpProf, inputLoProf, 
+    upperProfileSurface, lowerProfileSurface, keepSample);
+
   // initialize the first elements of the temporary profiles
   temporaryUpProf[0] = inputUpProf[0];
   temporaryLoProf[0] = inputLoProf[0];
@@ -4233,9 +7623,12 @@ void Acoustic3dSimulation::createContour(double inputUpProf[VocalTract::NUM_PROF
           for (int pt(idxBig); pt < (i + 1); pt++)
           {
             // insert new point in the polygon
-            tempPoly.push_back(Point(pt * VocalTract::PROFILE_SAMPLE_LENGTH -
-              VocalTract::PROFILE_LENGTH / 2, temporaryUpProf[pt]));
-            tempSufIdx.push_back(upperProfileSurface[pt]);
+            if (keepSample[pt])
+            {
+              tempPoly.push_back(Point(pt * VocalTract::PROFILE_SAMPLE_LENGTH -
+                VocalTract::PROFILE_LENGTH / 2, temporaryUpProf[pt]));
+              tempSufIdx.push_back(upperProfileSurface[pt]);
+            }
 
             // check if it is necessary to add an intermediate point
             if ((pt != (VocalTract::NUM_PROFILE_SAMPLES - 1)) &&
@@ -4313,6 +7706,9 @@ void Acoustic3dSimulation::createContour(double inputUpProf[VocalTract::NUM_PROF
 
       for (int p(i - 1); p > idxBig; p--)
       {
+        // skip the samples in the flat regions
+        if (!keepSample[p]) { continue; }
+
         vecNextPt = Vector(Point(0., 0.), Point(p * VocalTract::PROFILE_SAMPLE_LENGTH -
           VocalTract::PROFILE_LENGTH / 2, temporaryLoProf[p]));
 
@@ -4518,6 +7914,12 @@ void Acoustic3dSimulation::createUniqueContour(double inputUpProf[VocalTract::NU
     }
   }
 
+  // select the samples needed to describe the profiles, the samples in the
+  // flat regions between them are not inserted in the polygons
+  bool keepSample[VocalTract::NUM_PROFILE_SAMPLES];
+  VocalTract::getAdaptiveProfileSamples(inputUpProf, inputLoProf, 
+    upperProfileSurface, lowerProfileSurface, keepSample);
+
   // initialize the first elements of the temporary profiles
   temporaryUpProf[0] = inputUpProf[0];
   temporaryLoProf[0] = inputLoProf[0];
@@ -4556,9 +7958,12 @@ void Acoustic3dSimulation::createUniqueContour(double inputUpProf[VocalTract::NU
           for (int pt(idxBig); pt < (i + 1); pt++)
           {
             // insert new point in the polygon
-            tempPoly.push_back(Point(pt * VocalTract::PROFILE_SAMPLE_LENGTH -
-              VocalTract::PROFILE_LENGTH / 2, temporaryUpProf[pt]));
-            tempSufIdx.push_back(upperProfileSurface[pt]);
+            if (keepSample[pt])
+            {
+              tempPoly.push_back(Point(pt * VocalTract::PROFILE_SAMPLE_LENGTH -
+                VocalTract::PROFILE_LENGTH / 2, temporaryUpProf[pt]));
+              tempSufIdx.push_back(upperProfileSurface[pt]);
+            }
 
             // check if it is necessary to add an intermediate point
             if ((pt != (VocalTract::NUM_PROFILE_SAMPLES - 1)) &&
@@ -4636,6 +8041,9 @@ void Acoustic3dSimulation::createUniqueContour(double inputUpProf[VocalTract::NU
 
       for (int p(i - 1); p > idxBig; p--)
       {
+        // skip the samples in the flat regions
+        if (!keepSample[p]) { continue; }
+
         vecNextPt = Vector(Point(0., 0.), Point(p * VocalTract::PROFILE_SAMPLE_LENGTH -
           VocalTract::PROFILE_LENGTH / 2, temporaryLoProf[p]));
 
@@ -4791,7 +8199,7 @@ void Acoustic3dSimulation::mergeContours(vector<Polygon_2>& vecPoly,
   vector<vector<int>> &surfaceIdx)
 {
   Polygon_2 poly, hull;
-  ofstream log("log.txt", ofstream::app);
+  LogStream log(m_logFile);
 
   for (int j(0); j < vecPoly.size(); j++)
   {
@@ -4822,7 +8230,7 @@ void Acoustic3dSimulation::mergeContours(vector<Polygon_2>& vecPoly,
 
 void Acoustic3dSimulation::makeContourConvexHull(Polygon_2& poly, vector<int>& surfaceIdx)
 {
-  ofstream log("log.txt", ofstream::app);
+  LogStream log(m_logFile);
 
   Polygon_2 hull;
 
@@ -4909,36 +8317,41 @@ void Acoustic3dSimulation::getCurvatureAngleShift(Point2D P1, Point2D P2,
 void Acoustic3dSimulation::extractContours(VocalTract* tract, vector<vector<Polygon_2>>& contours,
   vector<vector<vector<int>>>& surfaceIdx, vector<Point2D>& centerLine, vector<Point2D>& normals)
 {
-  // for cross profile data extraction
-  double upperProfile[VocalTract::NUM_PROFILE_SAMPLES];
-  double lowerProfile[VocalTract::NUM_PROFILE_SAMPLES];
-  int upperProfileSurface[VocalTract::NUM_PROFILE_SAMPLES];
-  int lowerProfileSurface[VocalTract::NUM_PROFILE_SAMPLES];
-  Tube::Articulator articulator;
-
-  // for contour data
-  vector<double> areas, spacings;
-  vector<Polygon_2> tmpContours;
-  vector<vector<int>> tmpSurfacesIdx;
-
-
-  for (int i(0); i < VocalTract::NUM_CENTERLINE_POINTS; i++)
+  const int numPts(VocalTract::NUM_CENTERLINE_POINTS);
+  vector<vector<Polygon_2>> tmpContours(numPts);
+  vector<vector<vector<int>>> tmpSurfacesIdx(numPts);
+
+  // the surfaces are only read by the profile extraction once their 
+  // intersections are prepared, so that the centerline points can be 
+  // processed in parallel
+  tract->prepareIntersections();
+
+  parallelLoop(numPts, m_simuParams.numThreads, [&](int i)
+    {
+      // for cross profile data extraction
+      double upperProfile[VocalTract::NUM_PROFILE_SAMPLES];
+      double lowerProfile[VocalTract::NUM_PROFILE_SAMPLES];
+      int upperProfileSurface[VocalTract::NUM_PROFILE_SAMPLES];
+      int lowerProfileSurface[VocalTract::NUM_PROFILE_SAMPLES];
+      Tube::Articulator articulator;
+      vector<double> areas, spacings;
+
+      // extract the data of the cross-section
+      tract->getCrossProfiles(tract->centerLine[i].point, tract->centerLine[i].normal,
+        upperProfile, lowerProfile, upperProfileSurface, lowerProfileSurface, true, articulator);
+
+      // create the corresponding contours
+      // FIXME: createUniqueContour is used to avoid creating branches,
+      // but in the future, if handling branches becomes possible, 
+      // createContour should be used instead
+      createUniqueContour(upperProfile, lowerProfile, upperProfileSurface,
+        lowerProfileSurface, areas, spacings, tmpContours[i], tmpSurfacesIdx[i]);
+    });
+
+  for (int i(0); i < numPts; i++)
   {
-    // extract the data of the cross-section
-    tract->getCrossProfiles(tract->centerLine[i].point, tract->centerLine[i].normal,
-      upperProfile, lowerProfile, upperProfileSurface, lowerProfileSurface, true, articulator);
-
-    // create the corresponding contours
-    tmpContours.clear();
-    tmpSurfacesIdx.clear();
-    // FIXME: createUniqueContour is used to avoid creating branches,
-    // but in the future, if handling branches becomes possible, 
-    // createContour should be used instead
-    createUniqueContour(upperProfile, lowerProfile, upperProfileSurface,
-      lowerProfileSurface, areas, spacings, tmpContours, tmpSurfacesIdx);
-
-    contours.push_back(tmpContours);
-    surfaceIdx.push_back(tmpSurfacesIdx);
+    contours.push_back(tmpContours[i]);
+    surfaceIdx.push_back(tmpSurfacesIdx[i]);
     centerLine.push_back(tract->centerLine[i].point);
     normals.push_back(tract->centerLine[i].normal);
   }
@@ -4948,172 +8361,536 @@ void Acoustic3dSimulation::extractContours(VocalTract* tract, vector<vector<Poly
 // Extract the contours, the surface indexes, the centerline and the normals
 // from a csv file 
 
-bool Acoustic3dSimulation::extractContoursFromCsvFile(
+bool Acoustic3dSimulation::extractContoursFromCsvFile(string fileName,
   vector<vector<Polygon_2>>& contours, vector<vector<vector<int>>>& surfaceIdx,
   vector<Point2D>& centerLine, vector<Point2D>& normals,
   vector<pair<double, double>>& scalingFactors, bool simplifyContours)
 {
   //******************************************************************
   // Extract the centerline, centerline normals and the contours
-  // from the csv file
+  // from the csv file, line by line
   //******************************************************************
 
   vector<Polygon_2> tmpCont;
-  vector<int> tmpIdx;
-  vector<vector<int>> tmpVecIdx;
-  string line, coordX, coordY;
+  string lineX, lineY;
+  vector<double> valuesX, valuesY;
   char separator(';');
-  Cost cost;                // for contour simplification
-  int idxCont(0);
-  Point2D ctlPt, normalVec;
-  pair<double, double> scalings;
-  double x, y;
+  Point2D normalVec;
   bool abort(false);
-  ifstream geoFile(m_geometryFile);
+  ifstream geoFile(fileName);
 
-  ofstream log("log.txt", ofstream::app);
+  LogStream log(m_logFile);
 
-  //*************************************************************
-  // Lambda expression to convert from string to double failsafe
-  //*************************************************************
+  // check if the file is opened
+  if (!geoFile.is_open())
+  {
+    log << "Cannot open " << fileName << endl;  
+    log.close();
+    return false;
+  }
+  // check if the file is empty
+  else if (geoFile.peek() == ifstream::traits_type::eof())
+  {
+    log.close();
+    return false;
+  }
 
-  auto strToDouble = [&](const string& str, double& result)
+  // each section is described by a line of x components followed by a 
+  // line of y components: centerline point, normal, scaling factors 
+  // and contour points
+  while (getline(geoFile, lineX))
   {
-    try
+    if (!getline(geoFile, lineY)) { abort = true; break; }
+
+    if (!parseCsvLine(lineX, separator, valuesX) ||
+      !parseCsvLine(lineY, separator, valuesY))
     {
-      result = stod(str);
+      log << "Warning: could not convert the values of contour " 
+        << tmpCont.size() << " to numbers" << endl;
+      abort = true;
+      break;
+    }
+
+    // check if there is at least 3 points in the contour
+    if ((valuesX.size() < 6) || (valuesY.size() < valuesX.size())) 
+    { 
+      abort = true; 
+      break; 
     }
-    catch (const std::invalid_argument& ia)
+
+    centerLine.push_back(Point2D(valuesX[0], valuesY[0]));
+    normalVec = Point2D(valuesX[1], valuesY[1]);
+    normalVec.normalize();
+    normals.push_back(normalVec);
+    scalingFactors.push_back(pair<double, double>(valuesX[2], valuesY[2]));
+
+    tmpCont.push_back(Polygon_2());
+    for (int i(3); i < valuesX.size(); i++)
     {
-      log << "Warning: " << ia.what() << " could not convert string \"" 
-        << str << "\" to number" << endl;
-      if (str != "\r")
-      {
-        abort = true;
-      }
+      tmpCont.back().push_back(Point(valuesX[i], valuesY[i]));
     }
-  };
 
-  //*************************************************************
+    log << "Contour " << tmpCont.size() - 1 << " extracted" << endl;
+  }
 
-  // check if the file is opened
-  if (!geoFile.is_open())
+  // at least two contours must be given to create a proper geometry
+  if (tmpCont.size() < 2) { abort = true; }
+  if (abort)
   {
-    log << "Cannot open " << m_geometryFile << endl;  
+    log << "Importation failed" << endl;
     log.close();
     return false;
   }
-  // check if the file is empty
-  else if (geoFile.peek() != ifstream::traits_type::eof())
-  {
-    while (getline(geoFile, line))
-    {
-      // extract the line corresponding to the x components
-      stringstream lineX(line);
-
-      // extract the line corresponding to the y components
-      if (!getline(geoFile, line)) { abort = true; break; };
-      stringstream lineY(line);
-
-      // extract the centerline point
-      if (!getline(lineX, coordX, separator)) { abort = true; break; };
-      if (!getline(lineY, coordY, separator)) { abort = true; break; };
-      strToDouble(coordX, ctlPt.x);
-      strToDouble(coordY, ctlPt.y);
-
-      // extract the normal to the centerline
-      if (!getline(lineX, coordX, separator) || abort) { abort = true; break; };
-      if (!getline(lineY, coordY, separator) || abort) { abort = true; break; };
-      strToDouble(coordX, normalVec.x);
-      strToDouble(coordY, normalVec.y);
-      normalVec.normalize();
-
-      // extract the scaling factors
-      if (!getline(lineX, coordX, separator) || abort) { abort = true; break; };
-      if (!getline(lineY, coordY, separator) || abort) { abort = true; break; };
-      strToDouble(coordX, scalings.first);
-      strToDouble(coordY, scalings.second);
-
-      // initialize contours
-      tmpCont.clear();
-      tmpCont.push_back(Polygon_2());
-
-      // extract contour
-      while (getline(lineX, coordX, separator) && (coordX.length() > 0))
-      {
-        if (!getline(lineY, coordY, separator)) { abort = true; break; };
-        strToDouble(coordX, x);
-        strToDouble(coordY, y);
-        if (abort) { break; }
-        tmpCont.back().push_back(Point(x, y));
-      }
-      if (abort) { break; }
-      
-      // check if there is at least 3 points in each contour
-      for (int i(0); i < tmpCont.size(); i++)
-      {
-        if (tmpCont[i].size() < 3) 
-        {
-          abort = true;
-          break; 
-        }
-      }
-      if (abort) { break; }
 
-      // if nothing failed before, add the centerline, normal and scaling factors
-      centerLine.push_back(ctlPt);
-      normals.push_back(normalVec);
-      scalingFactors.push_back(scalings);
+  //******************************************************************
+  // Simplify the contours in parallel
+  //******************************************************************
 
+  parallelLoop(tmpCont.size(), m_simuParams.numThreads, [&](int i)
+    {
       // remove the last point if it is identical to the first point
-      auto itFirst = tmpCont.back().vertices_begin();
-      auto itLast = tmpCont.back().vertices_end() - 1;
+      auto itFirst = tmpCont[i].vertices_begin();
+      auto itLast = tmpCont[i].vertices_end() - 1;
       if (*itFirst == *itLast)
       {
-        tmpCont.back().erase(itLast);
+        tmpCont[i].erase(itLast);
       }
 
       // if requested, simplify the contour removing points which are close
-      if (simplifyContours && (tmpCont.back().size() > 10))
+      if (simplifyContours && (tmpCont[i].size() > 10))
       {
-        tmpCont.back() = CGAL::Polyline_simplification_2::simplify(
-          tmpCont.back(), cost, Stop(0.5));
+        Cost cost;
+        tmpCont[i] = CGAL::Polyline_simplification_2::simplify(
+          tmpCont[i], cost, Stop(0.5));
       }
+    });
+
+  // add the contours and generate the surface indexes (all zero since 
+  // there is no clue about the surface type)
+  for (int i(0); i < tmpCont.size(); i++)
+  {
+    contours.push_back(vector<Polygon_2>(1, tmpCont[i]));
+    surfaceIdx.push_back(vector<vector<int>>(1, vector<int>(tmpCont[i].size(), 0)));
+  }
+
+  log << "Importation successful" << endl;
+  log.close();
+  return true;
+}
+
+//*****************************************************************************
+// Extract the contours, the surface indexes, the centerline and the normals
+// from a binary geometry file mapped in memory
+
+bool Acoustic3dSimulation::extractContoursFromBinaryFile(string fileName,
+  vector<vector<Polygon_2>>& contours, vector<vector<vector<int>>>& surfaceIdx,
+  vector<Point2D>& centerLine, vector<Point2D>& normals,
+  vector<pair<double, double>>& scalingFactors, bool simplifyContours)
+{
+  MappedGeometryFile geoFile;
+  string error;
+
+  if (!geoFile.open(fileName, error))
+  {
+    LogStream log(m_logFile);
+    log << error << endl;
+    log.close();
+    return false;
+  }
+
+  return extractContoursFromArrays(geoFile.numSections(), geoFile.centerLine(),
+    geoFile.normals(), geoFile.scalingFactors(), geoFile.points(),
+    geoFile.contourOffsets(), geoFile.surfaceIdx(), geoFile.contoursSimplified(),
+    contours, surfaceIdx, centerLine, normals, scalingFactors, simplifyContours);
+}
+
+//*****************************************************************************
+// Extract the contours, the surface indexes, the centerline and the normals
+// from the arrays of a geometry given in memory (see setGeometryArrays), 
+// after checking the sizes of the arrays
+
+bool Acoustic3dSimulation::extractContoursFromArrays(const struct geometryArrays& geo,
+  vector<vector<Polygon_2>>& contours, vector<vector<vector<int>>>& surfaceIdx,
+  vector<Point2D>& centerLine, vector<Point2D>& normals,
+  vector<pair<double, double>>& scalingFactors, bool simplifyContours)
+{
+  size_t numSections(geo.centerLine.size() / 2);
+  bool consistent((geo.centerLine.size() == 2 * numSections) &&
+    (geo.normals.size() == 2 * numSections) &&
+    (geo.scalingFactors.size() == 2 * numSections) &&
+    (geo.contourOffsets.size() == numSections + 1) &&
+    (geo.points.size() == 2 * geo.surfaceIdx.size()));
+  for (size_t i(0); consistent && (i < numSections); i++)
+  {
+    consistent = (geo.contourOffsets[i] <= geo.contourOffsets[i + 1]);
+  }
+  consistent = consistent && (geo.contourOffsets[0] == 0) &&
+    (geo.contourOffsets[numSections] == geo.surfaceIdx.size());
+  if (!consistent)
+  {
+    LogStream log(m_logFile);
+    log << "Inconsistent sizes of the geometry arrays" << endl;
+    log << "Importation failed" << endl;
+    log.close();
+    return false;
+  }
+
+  return extractContoursFromArrays((int)numSections, geo.centerLine.data(),
+    geo.normals.data(), geo.scalingFactors.data(), geo.points.data(),
+    geo.contourOffsets.data(), geo.surfaceIdx.data(), geo.simplified,
+    contours, surfaceIdx, centerLine, normals, scalingFactors, simplifyContours);
+}
+
+//*****************************************************************************
+// Extract the contours, the surface indexes, the centerline and the normals
+// from arrays laid out as in a binary geometry file (see GeometryFile.h)
+
+bool Acoustic3dSimulation::extractContoursFromArrays(int numSections, 
+  const double* ctl, const double* nml, const double* scl, const double* pts,
+  const uint32_t* offsets, const int32_t* idx, bool simplified,
+  vector<vector<Polygon_2>>& contours, vector<vector<vector<int>>>& surfaceIdx,
+  vector<Point2D>& centerLine, vector<Point2D>& normals,
+  vector<pair<double, double>>& scalingFactors, bool simplifyContours)
+{
+  Cost cost;                // for contour simplification
+  Point2D normalVec;
+  Polygon_2 contour;
+  vector<int> tmpIdx;
 
-      // Add the contour to the contour list
-      contours.push_back(tmpCont);
+  LogStream log(m_logFile);
+
+  // at least two contours with at least 3 points each must be given 
+  // to create a proper geometry
+  bool abort(numSections < 2);
+  for (int i(0); !abort && (i < numSections); i++)
+  {
+    abort = (offsets[i + 1] - offsets[i] < 3);
+  }
+  if (abort)
+  {
+    log << "Importation failed" << endl;
+    log.close();
+    return false;
+  }
 
-      // generate the surface indexes (all zero since there is no clue 
-      // about the surface type)
-      tmpIdx.clear();
-      tmpIdx.assign(tmpCont.back().size(), 0);
-      tmpVecIdx.clear();
-      tmpVecIdx.push_back(tmpIdx);
-      surfaceIdx.push_back(tmpVecIdx);
+  for (int i(0); i < numSections; i++)
+  {
+    centerLine.push_back(Point2D(ctl[2 * i], ctl[2 * i + 1]));
+    normalVec = Point2D(nml[2 * i], nml[2 * i + 1]);
+    normalVec.normalize();
+    normals.push_back(normalVec);
+    scalingFactors.push_back(pair<double, double>(scl[2 * i], scl[2 * i + 1]));
 
-      log << "Contour " << idxCont << " extracted" << endl;
-      idxCont++;
+    // build the contour directly from the arrays
+    contour.clear();
+    tmpIdx.clear();
+    for (uint32_t j(offsets[i]); j < offsets[i + 1]; j++)
+    {
+      contour.push_back(Point(pts[2 * j], pts[2 * j + 1]));
+      tmpIdx.push_back(idx[j]);
     }
-    // at least two contours must be given to create a proper geometry
-    if (contours.size() < 2) { abort = true; }
-    if (abort)
+
+    // remove the last point if it is identical to the first point
+    if (*contour.vertices_begin() == *(contour.vertices_end() - 1))
     {
-      log << "Importation failed" << endl;
-      log.close();
-      return false;
+      contour.erase(contour.vertices_end() - 1);
+      tmpIdx.pop_back();
     }
-    else
+
+    // if requested, simplify the contour removing points which are close,
+    // unless it has been done before writing the arrays
+    if (simplifyContours && !simplified && (contour.size() > 10))
     {
-      log << "Importation successful" << endl;
-      log.close();
-      return true;
+      contour = CGAL::Polyline_simplification_2::simplify(contour, cost, Stop(0.5));
+      // the simplification does not keep track of the surfaces
+      tmpIdx.assign(contour.size(), 0);
     }
+
+    contours.push_back(vector<Polygon_2>(1, contour));
+    surfaceIdx.push_back(vector<vector<int>>(1, tmpIdx));
   }
-  else
+
+  log << numSections << " contours extracted" << endl;
+  log << "Importation successful" << endl;
+  log.close();
+  return true;
+}
+
+//*****************************************************************************
+// Extract the contours, the surface indexes, the centerline and the normals
+// by slicing the triangle mesh of an STL file (see MeshSlicer.h)
+
+bool Acoustic3dSimulation::extractContoursFromStlFile(string fileName,
+  vector<vector<Polygon_2>>& contours, vector<vector<vector<int>>>& surfaceIdx,
+  vector<Point2D>& centerLine, vector<Point2D>& normals,
+  vector<pair<double, double>>& scalingFactors, bool simplifyContours)
+{
+  TriangleMesh mesh;
+  string error;
+
+  if (!mesh.readStl(fileName, error))
+  {
+    LogStream log(m_logFile);
+    log << error << endl;
+    log.close();
+    return false;
+  }
+  mesh.transform(m_meshSlicingOptions.scale, m_meshSlicingOptions.lateralAxis);
+
+  return extractContoursFromMesh(mesh, contours, surfaceIdx, centerLine, 
+    normals, scalingFactors, simplifyContours);
+}
+
+//*****************************************************************************
+// Extract the contours, the surface indexes, the centerline and the normals
+// from a triangle mesh: the centerline is traced through the lumen of the 
+// mesh, then the sections are sliced in parallel
+
+bool Acoustic3dSimulation::extractContoursFromMesh(const TriangleMesh& mesh,
+  vector<vector<Polygon_2>>& contours, vector<vector<vector<int>>>& surfaceIdx,
+  vector<Point2D>& centerLine, vector<Point2D>& normals,
+  vector<pair<double, double>>& scalingFactors, bool simplifyContours)
+{
+  vector<Point2D> tmpCenterLine, tmpNormals;
+  vector<vector<Point2D>> sections;
+  LogStream log(m_logFile);
+
+  MeshSlicer slicer(mesh, m_meshSlicingOptions.maxGap);
+  if (!slicer.traceCenterLine(m_meshSlicingOptions, tmpCenterLine, tmpNormals) ||
+    !slicer.sliceAll(tmpCenterLine, tmpNormals, m_simuParams.numThreads, sections))
+  {
+    log << "Cannot slice the mesh (" << mesh.numTriangles() << " triangles, "
+      << tmpCenterLine.size() << " sections found)" << endl;
+    log << "Importation failed" << endl;
+    log.close();
+    return false;
+  }
+
+  vector<Polygon_2> tmpCont(sections.size());
+  parallelLoop(sections.size(), m_simuParams.numThreads, [&](int i)
+    {
+      for (const Point2D& P : sections[i])
+      {
+        tmpCont[i].push_back(Point(P.x, P.y));
+      }
+
+      // if requested, simplify the contour removing points which are close
+      if (simplifyContours && (tmpCont[i].size() > 10))
+      {
+        Cost cost;
+        tmpCont[i] = CGAL::Polyline_simplification_2::simplify(
+          tmpCont[i], cost, Stop(0.5));
+      }
+    });
+
+  // the surface indexes are all zero since there is no clue about the 
+  // surface type
+  for (int i(0); i < tmpCont.size(); i++)
   {
+    centerLine.push_back(tmpCenterLine[i]);
+    normals.push_back(tmpNormals[i]);
+    scalingFactors.push_back(pair<double, double>(1., 1.));
+    contours.push_back(vector<Polygon_2>(1, tmpCont[i]));
+    surfaceIdx.push_back(vector<vector<int>>(1, vector<int>(tmpCont[i].size(), 0)));
+  }
+
+  log << mesh.numTriangles() << " triangles sliced into " << tmpCont.size() 
+    << " contours" << endl;
+  log << "Importation successful" << endl;
   log.close();
+  return true;
+}
+
+//*****************************************************************************
+// Convert a csv geometry file into the binary format. The contours are 
+// simplified as in the importation of the csv file so that it is not 
+// necessary to simplify them when the binary file is imported.
+
+bool Acoustic3dSimulation::convertGeometryCsvToBinary(string csvFile, 
+  string binaryFile)
+{
+  vector<vector<Polygon_2>> contours;
+  vector<vector<vector<int>>> surfaceIdx;
+  vector<Point2D> centerLine;
+  vector<Point2D> normals;
+  vector<pair<double, double>> scalingFactors;
+
+  if (!extractContoursFromCsvFile(csvFile, contours, surfaceIdx, centerLine,
+    normals, scalingFactors, true))
+  {
     return false;
   }
+
+  struct geometryArrays geo;
+  geo.simplified = true;
+  geo.contourOffsets.push_back(0);
+  for (int i(0); i < contours.size(); i++)
+  {
+    geo.centerLine.push_back(centerLine[i].x);
+    geo.centerLine.push_back(centerLine[i].y);
+    geo.normals.push_back(normals[i].x);
+    geo.normals.push_back(normals[i].y);
+    geo.scalingFactors.push_back(scalingFactors[i].first);
+    geo.scalingFactors.push_back(scalingFactors[i].second);
+    for (auto pt : contours[i].back())
+    {
+      geo.points.push_back(pt.x());
+      geo.points.push_back(pt.y());
+    }
+    geo.surfaceIdx.insert(geo.surfaceIdx.end(), surfaceIdx[i].back().begin(),
+      surfaceIdx[i].back().end());
+    geo.contourOffsets.push_back(geo.points.size() / 2);
+  }
+
+  LogStream log(m_logFile);
+  bool success(writeGeometryFile(binaryFile, geo));
+  if (success)
+  {
+    log << "Geometry " << csvFile << " converted to " << binaryFile << endl;
+  }
+  else
+  {
+    log << "Cannot write " << binaryFile << endl;
+  }
+  log.close();
+  return success;
+}
+
+// ****************************************************************************
+// Merge the runs of consecutive slices whose contours are identical, up to a
+// scaling, to the contour of the first slice of the run, into this slice: 
+// the segment of the merged slice extends to the start of the next run and
+// its scaling varies linearly along it. A run is merged if its slices have a
+// single contour, the same surfaces, and if neither the contours nor their
+// scaling along the centerline deviate from the merged segment by more than
+// coarseningTolerance. The last slice, the slices of area lower than minArea
+// and the bends of the curved geometries are not merged.
+
+int Acoustic3dSimulation::coarsenSlices(vector<vector<Polygon_2>>& contours,
+  vector<vector<vector<int>>>& surfaceIdx, vector<Point2D>& centerLine,
+  vector<Point2D>& normals, vector<pair<double, double>>& scalingFactors,
+  vector<double>& totAreas, vector<array<double, 4>>& bboxes, double minArea)
+{
+  const double tol(m_simuParams.coarseningTolerance);
+  int numSlices(contours.size()), numRemoved(0);
+  bool fromFile(m_contInterpMeth == FROM_FILE);
+  bool withScaling(scalingFactors.size() == numSlices);
+
+  // scaling of the single contour of the slice k relative to the one of the
+  // slice a (negative if it is not identical up to this scaling)
+  auto relativeScaling = [&](int a, int k)
+  {
+    if ((contours[k].size() != 1) || (surfaceIdx[k] != surfaceIdx[a]) ||
+      (contours[k][0].size() != contours[a][0].size()) || (totAreas[k] <= minArea))
+    {
+      return -1.;
+    }
+    const Polygon_2& ca(contours[a][0]), & ck(contours[k][0]);
+    double r(sqrt(totAreas[k] / totAreas[a]));
+    for (int v(0); v < ca.size(); v++)
+    {
+      if ((abs(ck[v].x() - r * ca[v].x()) > tol) || 
+        (abs(ck[v].y() - r * ca[v].y()) > tol))
+      {
+        return -1.;
+      }
+    }
+    return r;
+  };
+
+  // check if the slices a to b can be merged in the slice a, with the scaling
+  // factors of the merged segment
+  auto mergeable = [&](int a, int b, pair<double, double>& merged)
+  {
+    if ((contours[a].size() != 1) || (totAreas[a] <= minArea) ||
+      (totAreas[b + 1] <= minArea)) 
+    { 
+      return false; 
+    }
+    double size(sqrt(totAreas[a]));
+
+    // position of the slices along the centerline and their scaling
+    vector<double> pos(b - a + 2, 0.), scale(b - a + 1);
+    for (int k(a); k <= b; k++)
+    {
+      pos[k - a + 1] = pos[k - a] + centerLine[k].getDistanceFrom(centerLine[k + 1]);
+      scale[k - a] = relativeScaling(a, k);
+      if (scale[k - a] < 0.) { return false; }
+    }
+    double L(pos.back());
+    if (L <= 0.) { return false; }
+
+    // the centerline of the curved geometries must be straight
+    if (m_simuParams.curved)
+    {
+      double dirX(centerLine[b + 1].x - centerLine[a].x), 
+        dirY(centerLine[b + 1].y - centerLine[a].y);
+      double norm(sqrt(pow(dirX, 2) + pow(dirY, 2)));
+      for (int k(a + 1); k <= b + 1; k++)
+      {
+        double dx(centerLine[k].x - centerLine[a].x), dy(centerLine[k].y - centerLine[a].y);
+        if ((abs(dx * dirY - dy * dirX) > tol * norm) ||
+          (size * normals[k].getDistanceFrom(normals[a]) > tol))
+        {
+          return false;
+        }
+      }
+    }
+
+    // scaling at the ends of the merged segment and samples of the scaling 
+    // of the slices along it
+    vector<pair<double, double>> samples;
+    if (fromFile && withScaling)
+    {
+      merged = { scalingFactors[a].first, scale[b - a] * scalingFactors[b].second };
+      for (int k(a); k <= b; k++)
+      {
+        samples.push_back({ pos[k - a], scale[k - a] * scalingFactors[k].first });
+        samples.push_back({ pos[k - a + 1], scale[k - a] * scalingFactors[k].second });
+      }
+    }
+    else
+    {
+      merged = { 1., m_simuParams.varyingArea ? 
+        sqrt(totAreas[b + 1] / totAreas[a]) : 1. };
+      for (int k(a); k <= b; k++) { samples.push_back({ pos[k - a], scale[k - a] }); }
+    }
+    for (auto& s : samples)
+    {
+      double linear(merged.first + (merged.second - merged.first) * s.first / L);
+      if (size * abs(s.second - linear) > tol) { return false; }
+    }
+    return true;
+  };
+
+  // greedy merge of the longest runs, the last slice is kept
+  for (int a(0); a < (int)contours.size() - 2; a++)
+  {
+    pair<double, double> merged, candidate;
+    int b(a);
+    while ((b + 2 < (int)contours.size()) && mergeable(a, b + 1, candidate))
+    {
+      b++;
+      merged = candidate;
+    }
+    if (b == a) { continue; }
+
+    if (fromFile && withScaling) { scalingFactors[a] = merged; }
+    int first(a + 1), last(b + 1);
+    contours.erase(contours.begin() + first, contours.begin() + last);
+    surfaceIdx.erase(surfaceIdx.begin() + first, surfaceIdx.begin() + last);
+    centerLine.erase(centerLine.begin() + first, centerLine.begin() + last);
+    normals.erase(normals.begin() + first, normals.begin() + last);
+    totAreas.erase(totAreas.begin() + first, totAreas.begin() + last);
+    bboxes.erase(bboxes.begin() + first, bboxes.begin() + last);
+    if (withScaling)
+    {
+      scalingFactors.erase(scalingFactors.begin() + first, scalingFactors.begin() + last);
+    }
+    numRemoved += last - first;
+  }
+
+  return numRemoved;
 }
 
 //*************************************************************************
@@ -5147,7 +8924,7 @@ bool Acoustic3dSimulation::createCrossSections(VocalTract* tract,
   Vector shiftVec;
 
   ofstream ofs;
-  ofstream log("log.txt", ofstream::app);
+  LogStream log(m_logFile);
   log << "Start cross-section creation" << endl;
 
 
@@ -5155,8 +8932,31 @@ bool Acoustic3dSimulation::createCrossSections(VocalTract* tract,
   {
     std::cout << "[A3DS_DEBUG_CREATE_CS] Path: CSV Geometry. m_geometryFile: " << (geoFile.empty() ? "EMPTY" : geoFile.c_str()) << std::endl;
     log << "[A3DS_DEBUG_CREATE_CS] Path: CSV Geometry. m_geometryFile: " << (geoFile.empty() ? "EMPTY" : geoFile.c_str()) << std::endl;
-    if ( !extractContoursFromCsvFile(contours, surfaceIdx, centerLine, 
-      normals, vecScalingFactors, true))
+    bool extracted;
+    if (m_geometryArrays)
+    {
+      extracted = extractContoursFromArrays(*m_geometryArrays, contours, surfaceIdx,
+        centerLine, normals, vecScalingFactors, true);
+    }
+    else if (m_geometryMesh)
+    {
+      extracted = extractContoursFromMesh(*m_geometryMesh, contours, surfaceIdx,
+        centerLine, normals, vecScalingFactors, true);
+    }
+    else if (isStlFile(m_geometryFile))
+    {
+      extracted = extractContoursFromStlFile(m_geometryFile, contours, surfaceIdx,
+        centerLine, normals, vecScalingFactors, true);
+    }
+    else
+    {
+      extracted = (isBinaryGeometryFile(m_geometryFile) ?
+        extractContoursFromBinaryFile(m_geometryFile, contours, surfaceIdx, 
+          centerLine, normals, vecScalingFactors, true) :
+        extractContoursFromCsvFile(m_geometryFile, contours, surfaceIdx, 
+          centerLine, normals, vecScalingFactors, true));
+    }
+    if (!extracted)
     {
       // CSV导入失败的日志（如果extractContoursFromCsvFile内部没有充分日志的话）
       std::cout << "[A3DS_DEBUG_CREATE_CS] extractContoursFromCsvFile FAILED." << std::endl;
@@ -5321,6 +9121,18 @@ bool Acoustic3dSimulation::createCrossSections(VocalTract* tract,
     }
   }
 
+  //**********************************************************************
+  // Merge the runs of similar slices of the imported geometries
+  //**********************************************************************
+
+  if (m_geometryImported && (m_simuParams.coarseningTolerance > 0.))
+  {
+    int numRemoved(coarsenSlices(contours, surfaceIdx, centerLine, normals,
+      vecScalingFactors, totAreas, bboxes, MINIMAL_AREA));
+    nbCont = contours.size();
+    log << numRemoved << " slices merged, " << nbCont << " slices left" << endl;
+  }
+
   //**********************************************************************
   // Add an intermediate centerline point and normal before the last ones
   //**********************************************************************
@@ -5383,7 +9195,9 @@ bool Acoustic3dSimulation::createCrossSections(VocalTract* tract,
   // Create the cross-sections
   //*******************************************
 
-  // clear cross-sections before 
+  // clear cross-sections before (the previous ones are kept to reuse the
+  // modes of the unchanged segments)
+  vector<unique_ptr<CrossSection2d>> oldCrossSections(std::move(m_crossSections));
   m_crossSections.clear();
 
   // compute the curvatur parameters of the first cross-section
@@ -5598,7 +9412,8 @@ bool Acoustic3dSimulation::createCrossSections(VocalTract* tract,
             {
               // compute the intersections of both contours
               intersections.clear();
-              CGAL::intersection(prevCont, cont, back_inserter(intersections));
+              intersectContours(prevCont, cont,
+                m_simuParams.floatPolygonClipping, intersections);
 
               // loop over the intersection polygons created
               for (auto pol = intersections.begin();
@@ -5841,11 +9656,114 @@ bool Acoustic3dSimulation::createCrossSections(VocalTract* tract,
   //}
   //ofs.close();
 
+  reuseUnchangedCrossSections(oldCrossSections);
+
   std::cout << "[A3DS_DEBUG_CREATE_CS] createCrossSections EXIT" << std::endl;
   return true;
   log.close();
 }
 
+//*************************************************************************
+// Copy the modes and the junction matrices of the cross-sections of the 
+// previous geometry to the new cross-sections having the same contour,
+// so that only the modified segments and the junctions next to them are 
+// recomputed
+
+void Acoustic3dSimulation::reuseUnchangedCrossSections(
+  const vector<unique_ptr<CrossSection2d>>& oldCrossSections)
+{
+  int numSec(m_crossSections.size());
+  int numOldSec(oldCrossSections.size());
+  int numReused(0);
+  int idxOld;
+
+  for (int i(0); i < numSec; i++)
+  {
+    if (!m_crossSections[i]->isFEM()) { continue; }
+    CacheKey key(m_crossSections[i]->modesCacheKey(m_simuParams));
+
+    // search first the section with the same index, since in most cases 
+    // the segmentation of the geometry does not change
+    for (int j(0); j < numOldSec; j++)
+    {
+      idxOld = (i + j) % numOldSec;
+      if (oldCrossSections[idxOld]->isFEM()
+        && oldCrossSections[idxOld]->areModesComputed()
+        && (oldCrossSections[idxOld]->computedModesKey() == key))
+      {
+        m_crossSections[i]->copyModesAndJunction(*oldCrossSections[idxOld]);
+        numReused++;
+        break;
+      }
+    }
+  }
+
+  LogStream log(m_logFile);
+  log << "Modes of " << numReused << " / " << numSec 
+    << " cross-sections reused from the previous geometry" << endl;
+  log.close();
+}
+
+//*************************************************************************
+// Keep the modes and the junction matrices of the cross-sections when the 
+// sound speed changes: the eigenvalues of the modes, the multimodal matrices
+// and the junction matrices only depend on the geometry, so that only the 
+// eigenfrequencies are scaled. The number of modes is kept, even if a mode 
+// crosses the maximal cut-on frequency with the new sound speed. The dirty 
+// tracking keys are updated to the new sound speed, so that the modes and 
+// the junction matrices which were up to date are not recomputed.
+
+void Acoustic3dSimulation::rescaleModesSoundSpeed(double sndSpeed)
+{
+  int numSec(m_crossSections.size());
+  double factor(sndSpeed / m_simuParams.sndSpeed);
+  vector<char> modesUpToDate(numSec, 0), junctionUpToDate(numSec, 0);
+  int numRescaled(0);
+
+  // the key of the modes is computed before the modes with a number of 
+  // modes set to 0 (see computeModesJunctionsAndRadiation), the one of the
+  // junction matrices with the number of modes computed
+  auto modesKey = [this](int i)
+  {
+    int numModes(m_crossSections[i]->numberOfModes());
+    m_crossSections[i]->setModesNumber(0);
+    CacheKey key(m_crossSections[i]->modesCacheKey(m_simuParams));
+    m_crossSections[i]->setModesNumber(numModes);
+    return key;
+  };
+
+  for (int i(0); i < numSec; i++)
+  {
+    if (!m_crossSections[i]->isFEM()) { continue; }
+    modesUpToDate[i] = m_crossSections[i]->areModesComputed() &&
+      (m_crossSections[i]->computedModesKey() == modesKey(i));
+    junctionUpToDate[i] = (m_crossSections[i]->numNextSec() > 0) &&
+      m_crossSections[i]->isJunctionUpToDate(junctionCacheKey(i));
+  }
+
+  m_simuParams.sndSpeed = sndSpeed;
+
+  for (int i(0); i < numSec; i++)
+  {
+    if (!modesUpToDate[i]) { continue; }
+    m_crossSections[i]->scaleEigenFrequencies(factor);
+    m_crossSections[i]->setModesComputed(modesKey(i));
+    numRescaled++;
+  }
+  for (int i(0); i < numSec; i++)
+  {
+    if (junctionUpToDate[i]) { m_crossSections[i]->setJunctionComputed(junctionCacheKey(i)); }
+  }
+
+  if (numRescaled > 0)
+  {
+    LogStream log(m_logFile);
+    log << "Modes of " << numRescaled << " / " << numSec
+      << " cross-sections rescaled to the sound speed " << sndSpeed << endl;
+    log.close();
+  }
+}
+
 //*************************************************************************
 // Update the bounding box in the sagittal plane (X, Z)
 
@@ -5920,7 +9838,7 @@ bool Acoustic3dSimulation::importGeometry(VocalTract* tract)
 
   if (m_reloadGeometry)
   {
-    ofstream log("log.txt", ofstream::app);
+    LogStream log(m_logFile);
     log << "[Acoustic3dSim_DEBUG] importGeometry: m_reloadGeometry is true." << std::endl;
 
     auto start = std::chrono::system_clock::now();
@@ -6026,6 +9944,7 @@ complex<double> Acoustic3dSimulation::interpolateTransferFunction(double freq, i
 void Acoustic3dSimulation::interpolateTransferFunction(vector<double>& freq, int idxPt, 
   enum tfType type, vector<complex<double>>& interpolatedValues)
 {
+  lock_guard<mutex> lock(m_resultsMutex);
   interpolatedValues.clear();
   interpolatedValues.reserve(freq.size());
 
@@ -6037,6 +9956,52 @@ void Acoustic3dSimulation::interpolateTransferFunction(vector<double>& freq, int
   }
 }
 
+//*************************************************************************
+
+void Acoustic3dSimulation::transferFunctionMagnitudes(int idxPt, enum tfType type,
+  vector<double>& magnitudes, double& freqStep)
+{
+  lock_guard<mutex> lock(m_resultsMutex);
+  freqStep = (double)SAMPLING_RATE / 2. / (double)m_numFreqPicture;
+  magnitudes.clear();
+
+  Eigen::MatrixXcd* inputTf;
+  switch (type)
+  {
+  case GLOTTAL:
+    inputTf = &m_glottalSourceTF;
+    break;
+  case NOISE:
+    inputTf = &m_noiseSourceTF;
+    break;
+  case INPUT_IMPED:
+    inputTf = &m_planeModeInputImpedance;
+    idxPt = 0;
+    break;
+  }
+
+  if ((inputTf->rows() == 0) || (inputTf->cols() == 0) || (m_tfFreqs.size() == 0))
+  {
+    return;
+  }
+  idxPt = max(0, min((int)inputTf->cols() - 1, idxPt));
+
+  int numFreqs(min((int)inputTf->rows(), (int)m_tfFreqs.size()));
+  magnitudes.resize(numFreqs);
+  for (int i(0); i < numFreqs; i++)
+  {
+    double freq((double)i * freqStep);
+    if ((freq >= m_tfFreqs[0]) && (freq <= m_tfFreqs.back()))
+    {
+      magnitudes[i] = abs((*inputTf)(i, idxPt));
+    }
+    else
+    {
+      magnitudes[i] = NAN;
+    }
+  }
+}
+
 //*************************************************************************
 // Interpolate the acoustic field
 
@@ -6045,7 +10010,7 @@ double Acoustic3dSimulation::interpolateAcousticField(Point querryPt)
   double field;
 
   // check if the point is inside the bounding box
-  if ((querryPt.x() > m_simuParams.bbox[0].x()) &&
+  if ((m_field.size() > 0) && (querryPt.x() > m_simuParams.bbox[0].x()) &&
     (querryPt.x() < m_simuParams.bbox[1].x()) &&
     (querryPt.y() > m_simuParams.bbox[0].y()) &&
     (querryPt.y() < m_simuParams.bbox[1].y()))
@@ -6074,57 +10039,110 @@ double Acoustic3dSimulation::interpolateAcousticField(Point querryPt)
 }
 
 //*************************************************************************
-// Interpolate the acoustic field
+// Build the images of the field if it has been modified since they were
+// built (called with m_resultsMutex locked)
 
-void Acoustic3dSimulation::interpolateAcousticField(Vec &coordX, Vec &coordY, Matrix &field)
+void Acoustic3dSimulation::updateFieldImagePyramid()
 {
-  auto start = std::chrono::system_clock::now();
-  auto end = std::chrono::system_clock::now();
-  std::chrono::duration<double> time = end - end;
+  unsigned version(m_fieldVersion);
+  if ((m_fieldPyramid.version == version) && !m_fieldPyramid.amplitude.empty())
+  {
+    return;
+  }
 
-  int nx(coordX.size());
-  int ny(coordY.size());
-  int iMin, jMin;
-  double dx(1. / (double)m_simuParams.fieldResolutionPicture);
-  complex<double> interpolatedField;
+  m_fieldPyramid.amplitude.clear();
+  m_fieldPyramid.phase.clear();
+  m_fieldPyramid.dB.clear();
+  m_fieldPyramid.version = version;
+  int rows(m_field.rows() - 1), cols(m_field.cols() - 1);
+  if ((rows < 1) || (cols < 1)) { return; }
 
-  field.resize(ny, nx);
+  Eigen::MatrixXcd level(0.25 * (m_field.topLeftCorner(rows, cols) +
+    m_field.topRightCorner(rows, cols) + m_field.bottomLeftCorner(rows, cols) +
+    m_field.bottomRightCorner(rows, cols)));
 
-  for (int i(0); i < ny; i++)
+  while (true)
   {
-    for (int j(0); j < nx; j++)
+    m_fieldPyramid.amplitude.push_back(level.cwiseAbs());
+    m_fieldPyramid.phase.push_back(level.array().arg().real().matrix());
+    m_fieldPyramid.dB.push_back(20. * m_fieldPyramid.amplitude.back().array().log10().matrix());
+
+    rows = level.rows() / 2;
+    cols = level.cols() / 2;
+    if ((rows < 1) || (cols < 1)) { break; }
+
+    Eigen::MatrixXcd next(rows, cols);
+    for (int j(0); j < cols; j++)
     {
-      if ((coordX(j) > m_simuParams.bboxLastFieldComputed[0].x()) &&
-        (coordX(j) < m_simuParams.bboxLastFieldComputed[1].x()) &&
-        (coordY(i) > m_simuParams.bboxLastFieldComputed[0].y()) &&
-        (coordY(i) < m_simuParams.bboxLastFieldComputed[1].y()))
+      for (int i(0); i < rows; i++)
       {
-        iMin = min((int)m_field.rows() - 2,
-          (int)floor((coordY(i) - m_simuParams.bboxLastFieldComputed[0].y()) / dx));
-        jMin = min((int)m_field.cols() - 2,
-          (int)floor((coordX(j) - m_simuParams.bboxLastFieldComputed[0].x()) / dx));
+        next(i, j) = 0.25 * (level(2 * i, 2 * j) + level(2 * i + 1, 2 * j) +
+          level(2 * i, 2 * j + 1) + level(2 * i + 1, 2 * j + 1));
+      }
+    }
+    level = next;
+  }
+}
 
-        start = std::chrono::system_clock::now();
+//*************************************************************************
+// Sample the image of the field (amplitude, amplitude in dB or phase) at 
+// the points of a grid: the level of the pyramid used is the one whose 
+// cells are the largest ones which are not larger than the spacing of the 
+// grid, so that zooming, panning or resizing the picture only samples the
+// images
 
-        interpolatedField = (m_field(iMin, jMin) + m_field(iMin, jMin + 1)
-          + m_field(iMin + 1, jMin) + m_field(iMin + 1, jMin + 1)) / 4.;
+void Acoustic3dSimulation::interpolateAcousticField(Vec &coordX, Vec &coordY, Matrix &field)
+{
+  int nx(coordX.size());
+  int ny(coordY.size());
+  double dx(1. / (double)m_simuParams.fieldResolutionPicture);
+  const Point* bbox(m_simuParams.bboxLastFieldComputed);
+
+  lock_guard<mutex> lock(m_resultsMutex);
+  field.setConstant(ny, nx, NAN);
+  updateFieldImagePyramid();
+  if (m_fieldPyramid.amplitude.empty()) { return; }
+
+  double spacing(max((nx > 1) ? abs(coordX(1) - coordX(0)) : 0.,
+    (ny > 1) ? abs(coordY(1) - coordY(0)) : 0.));
+  int level(0);
+  while ((level + 1 < m_fieldPyramid.amplitude.size()) && 
+    (dx * (double)(2 << level) <= spacing))
+  {
+    level++;
+  }
+  double cellSize(dx * (double)(1 << level));
 
-        if (m_simuParams.showAmplitude)
-        {
-          field(i, j) = abs(interpolatedField);
-        }
-        else
-        {
-          field(i, j) = arg(interpolatedField);
-        }
+  const Matrix& image(m_simuParams.showAmplitude ? 
+    (m_simuParams.fieldIndB ? m_fieldPyramid.dB[level] : 
+      m_fieldPyramid.amplitude[level]) : m_fieldPyramid.phase[level]);
 
-        end = std::chrono::system_clock::now();
-        time += end - start;
-      }
-      else
-      {
-        field(i, j) = NAN;
-      }
+  // the grid is regular, so the cells of its rows and columns are located 
+  // once (-1 outside of the field)
+  vector<int> idxRows(ny, -1), idxCols(nx, -1);
+  for (int i(0); i < ny; i++)
+  {
+    if ((coordY(i) > bbox[0].y()) && (coordY(i) < bbox[1].y()))
+    {
+      idxRows[i] = min((int)image.rows() - 1, 
+        (int)floor((coordY(i) - bbox[0].y()) / cellSize));
+    }
+  }
+  for (int j(0); j < nx; j++)
+  {
+    if ((coordX(j) > bbox[0].x()) && (coordX(j) < bbox[1].x()))
+    {
+      idxCols[j] = min((int)image.cols() - 1, 
+        (int)floor((coordX(j) - bbox[0].x()) / cellSize));
+    }
+  }
+
+  for (int j(0); j < nx; j++)
+  {
+    if (idxCols[j] < 0) { continue; }
+    for (int i(0); i < ny; i++)
+    {
+      if (idxRows[i] >= 0) { field(i, j) = image(idxRows[i], idxCols[j]); }
     }
   }
 }
@@ -6200,12 +10218,76 @@ bool Acoustic3dSimulation::exportGeoInCsv(string fileName)
   of.close();
 }
 
+//*************************************************************************
+// Export the geometry extracted in the binary geometry format, with the 
+// same data as the CSV file plus the surface indexes
+
+bool Acoustic3dSimulation::exportGeoInBinary(string fileName)
+{
+  struct geometryArrays geo;
+  Point Pt;
+  Vector N;
+  vector<int> surfIdx;
+  int lastSeg(m_crossSections.size() - 1);
+
+  // the contours of the segments have been simplified when they were created
+  geo.simplified = true;
+  geo.contourOffsets.push_back(0);
+
+  for (int i(0); i <= lastSeg; i++)
+  {
+    // the junction segments are
+    // skipped since they are added in the geometry creation process
+    if (!m_crossSections[i]->isJunction())
+    {
+      // for the last segment, the centerline point and normal
+      // are taken at the exit
+      if (i == lastSeg)
+      {
+        Pt = m_crossSections[i]->ctrLinePtOut();
+        N = m_crossSections[i]->normalOut();
+      }
+      else
+      {
+        Pt = Point(m_crossSections[i]->ctrLinePt().x,
+          m_crossSections[i]->ctrLinePt().y);
+        N = Vector(m_crossSections[i]->normal().x,
+          m_crossSections[i]->normal().y);
+      }
+
+      geo.centerLine.push_back(Pt.x());
+      geo.centerLine.push_back(Pt.y());
+      geo.normals.push_back(N.x());
+      geo.normals.push_back(N.y());
+      geo.scalingFactors.push_back(m_crossSections[i]->scaleIn());
+      geo.scalingFactors.push_back(m_crossSections[i]->scaleOut());
+
+      for (auto pt : m_crossSections[i]->contour())
+      {
+        geo.points.push_back(m_crossSections[i]->scaleIn() * pt.x());
+        geo.points.push_back(m_crossSections[i]->scaleIn() * pt.y());
+      }
+
+      // the surface indexes are only known for the FEM segments
+      surfIdx = m_crossSections[i]->surfaceIdx();
+      if (surfIdx.size() != m_crossSections[i]->contour().size())
+      {
+        surfIdx.assign(m_crossSections[i]->contour().size(), 0);
+      }
+      geo.surfaceIdx.insert(geo.surfaceIdx.end(), surfIdx.begin(), surfIdx.end());
+      geo.contourOffsets.push_back(geo.points.size() / 2);
+    }
+  }
+
+  return writeGeometryFile(fileName, geo);
+}
+
 //*************************************************************************
 // Export the transfer functions in a text file
 
 bool Acoustic3dSimulation::exportTransferFucntions(string fileName, enum tfType type)
 {
-  ofstream log("log.txt", ofstream::app);
+  LogStream log(m_logFile);
   log << "Export transfer function to file:" << endl;
   log << fileName << endl;
 
@@ -6243,7 +10325,212 @@ bool Acoustic3dSimulation::exportTransferFucntions(string fileName, enum tfType
 
   log.close();
 
-  // FIXME: Check if the file have been successfully opened
+  // FIXME: Check if the file have been successfully opened
+  return true;
+}
+
+//*************************************************************************
+// Export the impulse responses at all the transfer function points, one 
+// channel per point and source. The wave file is normalised with a common
+// gain, so that the relative levels of the channels are kept.
+
+bool Acoustic3dSimulation::exportImpulseResponses(string fileName)
+{
+  LogStream log(m_logFile);
+  log << "Export impulse responses to file:" << endl;
+  log << fileName << endl;
+
+  vector<vector<double>> glottalIR, noiseIR;
+  if (!computeImpulseResponses(glottalIR, noiseIR))
+  {
+    log << "No transfer functions to compute the impulse responses" << endl;
+    log.close();
+    return false;
+  }
+
+  int numChannels(2 * glottalIR.size());
+  int numSamples(glottalIR[0].size());
+  vector<double> samples(numChannels * numSamples);
+  double maxAmp(0.);
+  for (int c(0); c < numChannels; c++)
+  {
+    const vector<double>& ir((c < glottalIR.size()) ? glottalIR[c] : 
+      noiseIR[c - glottalIR.size()]);
+    for (int i(0); i < numSamples; i++)
+    {
+      samples[i * numChannels + c] = ir[i];
+      maxAmp = max(maxAmp, abs(ir[i]));
+    }
+  }
+
+  bool success(true);
+  string extension(fileName.size() > 4 ? fileName.substr(fileName.size() - 4) : "");
+  transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+  if (extension == ".wav")
+  {
+    double gain((maxAmp > 0.) ? 0.99 / maxAmp : 1.);
+    for (auto& x : samples) { x *= gain; }
+
+    WaveFileWriter wave;
+    success = wave.open(fileName, SAMPLING_RATE, numChannels) &&
+      wave.writeSamples(samples.data(), numSamples);
+    success = wave.close() && success;
+    log << "Gain of the wave file: " << gain << endl;
+  }
+  else
+  {
+    FILE* file(fopen(fileName.c_str(), "wb"));
+    success = (file != NULL);
+    if (success)
+    {
+      vector<float> values(samples.begin(), samples.end());
+      success = (fwrite(values.data(), sizeof(float), values.size(), file) ==
+        values.size());
+      success = (fclose(file) == 0) && success;
+    }
+  }
+
+  log << numChannels << " channels of " << numSamples << " samples" 
+    << (success ? "" : " could not be written") << endl;
+  log.close();
+
+  return success;
+}
+
+//*************************************************************************
+// Fit a rational model with numPoles poles to the transfer function of the
+// point idxPt at the computed frequencies, with the sampling rate of the 
+// synthesis, the delay (in samples) being removed before the fit
+
+bool Acoustic3dSimulation::fitTransferFunction(enum tfType type, int idxPt,
+  int numPoles, int delay, struct rationalModel& model)
+{
+  lock_guard<mutex> lock(m_resultsMutex);
+
+  Eigen::MatrixXcd* inputTf;
+  switch (type)
+  {
+  case GLOTTAL:
+    inputTf = &m_glottalSourceTF;
+    break;
+  case NOISE:
+    inputTf = &m_noiseSourceTF;
+    break;
+  case INPUT_IMPED:
+    inputTf = &m_planeModeInputImpedance;
+    idxPt = 0;
+    break;
+  }
+  if ((idxPt < 0) || (idxPt >= inputTf->cols())) { return false; }
+
+  int numFreqs(min((int)m_tfFreqs.size(), (int)inputTf->rows()));
+  vector<double> freqs;
+  vector<complex<double>> values;
+  freqs.reserve(numFreqs);
+  values.reserve(numFreqs);
+  for (int i(0); i < numFreqs; i++)
+  {
+    complex<double> value((*inputTf)(i, idxPt));
+    if (isfinite(value.real()) && isfinite(value.imag()))
+    {
+      freqs.push_back(m_tfFreqs[i]);
+      values.push_back(value);
+    }
+  }
+
+  return fitRationalModel(freqs, values, (double)SAMPLING_RATE, numPoles, delay,
+    true, model);
+}
+
+//*************************************************************************
+// Export the rational model of a transfer function in a text file (see 
+// writeRationalModel)
+
+bool Acoustic3dSimulation::exportRationalModel(string fileName, enum tfType type,
+  int idxPt, int numPoles, int delay)
+{
+  LogStream log(m_logFile);
+  log << "Export rational model of the transfer function to file:" << endl;
+  log << fileName << endl;
+
+  struct rationalModel model;
+  if (!fitTransferFunction(type, idxPt, numPoles, delay, model)) 
+  {
+    log << "The rational model could not be fitted" << endl;
+    return false;
+  }
+  log << numPoles << " poles, relative error " << model.relError << endl;
+
+  return writeRationalModel(fileName, model);
+}
+
+//*************************************************************************
+// Export the transfer functions of the additional noise sources in a text 
+// file: each line contains the frequency, then the magnitude and the phase 
+// at each transfer function point for each section of m_noiseSourceSections
+
+bool Acoustic3dSimulation::exportNoiseSourcesTransferFunctions(string fileName)
+{
+  LogStream log(m_logFile);
+  log << "Export noise sources transfer functions to file:" << endl;
+  log << fileName << endl;
+
+  ofstream ofs;
+  ofs.open(fileName, ofstream::out | ofstream::trunc);
+  if (!ofs.is_open()) { return false; }
+
+  for (int i(0); i < m_tfFreqs.size(); i++)
+  {
+    ofs << m_tfFreqs[i] << "  ";
+    for (auto& tf : m_noiseSourcesTF)
+    {
+      for (int p(0); p < tf.cols(); p++)
+      {
+        ofs << abs(tf(i, p)) << "  " << arg(tf(i, p)) << "  ";
+      }
+    }
+    ofs << endl;
+  }
+  ofs.close();
+
+  log.close();
+
+  return true;
+}
+
+//*************************************************************************
+// Export the noise sources transfer functions computed with the extra 
+// glottis boundary conditions in a text file: each line contains the 
+// frequency, then for each condition of m_extraGlottisBoundaryConds, for the
+// main noise source and each section of m_noiseSourceSections, the magnitude
+// and the phase at each transfer function point
+
+bool Acoustic3dSimulation::exportGlottisConditionsTransferFunctions(string fileName)
+{
+  LogStream log(m_logFile);
+  log << "Export glottis boundary conditions transfer functions to file:" << endl;
+  log << fileName << endl;
+
+  ofstream ofs;
+  ofs.open(fileName, ofstream::out | ofstream::trunc);
+  if (!ofs.is_open()) { return false; }
+
+  for (int i(0); i < m_tfFreqs.size(); i++)
+  {
+    ofs << m_tfFreqs[i] << "  ";
+    for (auto& tf : m_glottisCondsTF)
+    {
+      for (int p(0); p < tf.cols(); p++)
+      {
+        ofs << abs(tf(i, p)) << "  " << arg(tf(i, p)) << "  ";
+      }
+    }
+    ofs << endl;
+  }
+  ofs.close();
+
+  log.close();
+
   return true;
 }
 
@@ -6252,10 +10539,16 @@ bool Acoustic3dSimulation::exportTransferFucntions(string fileName, enum tfType
 
 bool Acoustic3dSimulation::exportAcousticField(string fileName)
 {
-  ofstream log("log.txt", ofstream::app);
+  LogStream log(m_logFile);
   log << "Export acoustic field to file:" << endl;
   log << fileName << endl;
 
+  if (!m_fieldInMemory)
+  {
+    log << "The acoustic field has only been written in " << m_fieldStreamFile << endl;
+    return false;
+  }
+
   ofstream ofs;
   ofs.open(fileName, ofstream::out | ofstream::trunc);
 
@@ -6278,49 +10571,311 @@ bool Acoustic3dSimulation::exportAcousticField(string fileName)
 }
 
 //*************************************************************************
-// Interpolate the radiation and admittance matrices with splines
+// Export the meshes, the modes and the acoustic field in binary VTK files.
+// The mesh of each segment is placed in the plane of its entrance: the 
+// first coordinate of the contours is the lateral one (y) and the second 
+// one is along the normal of the segment in the sagittal plane (x, z). The 
+// files of the segments are written in parallel and named after fileName, 
+// which lists them with the field.
+
+bool Acoustic3dSimulation::exportVtk(string fileName)
+{
+  LogStream log(m_logFile);
+  log << "Export meshes, modes and field to VTK files:" << endl;
+  log << fileName << endl;
 
-void Acoustic3dSimulation::preComputeRadiationMatrices(int nbRadFreqs, int idxRadSec) {
+  string baseName(fileName.substr(0, fileName.rfind(".vtm")));
+  string dirName, localName(baseName);
+  size_t sep(baseName.find_last_of("/\\"));
+  if (sep != string::npos)
+  {
+    dirName = baseName.substr(0, sep + 1);
+    localName = baseName.substr(sep + 1);
+  }
 
-  // initialize coefficient structures
-  initCoefInterpRadiationMatrices(nbRadFreqs, idxRadSec);
+  int numSec(m_crossSections.size());
+  vector<string> blockNames, blockFiles;
+  vector<int> exportedSecs;
+  for (int i(0); i < numSec; i++)
+  {
+    if (m_crossSections[i]->getPoints().empty()) { continue; }
+    exportedSecs.push_back(i);
+    blockNames.push_back("segment " + to_string(i));
+    blockFiles.push_back(localName + "_segment" + to_string(i) + ".vtu");
+  }
+  bool exportField(m_fieldInMemory && (m_field.size() > 0) && (m_nPtx > 1)
+    && (m_nPty > 1));
+  if (exportField)
+  {
+    blockNames.push_back("acoustic field");
+    blockFiles.push_back(localName + "_field.vti");
+  }
+
+  // the last task writes the acoustic field
+  atomic<bool> success(true);
+  parallelLoop(exportedSecs.size() + (exportField ? 1 : 0), 
+    m_simuParams.numThreads, [&](int n)
+    {
+      bool ok;
+      if (n < exportedSecs.size())
+      {
+        CrossSection2d* sec(m_crossSections[exportedSecs[n]].get());
+        const vector<array<double, 2>>& pts(sec->getPoints());
+        const Matrix& modes(sec->getModes());
+        double sc(sec->scaleIn());
+
+        vector<array<double, 3>> points(pts.size());
+        for (int p(0); p < pts.size(); p++)
+        {
+          points[p] = { sec->ctrLinePt().x + sc * pts[p][1] * sec->normal().x,
+            sc * pts[p][0], sec->ctrLinePt().y + sc * pts[p][1] * sec->normal().y };
+        }
 
-  // loop over a few frequencies
-  for (int i(0); i < nbRadFreqs; i++)
+        vector<vtkDataArray> pointData;
+        if (modes.rows() == pts.size())
+        {
+          for (int m(0); m < modes.cols(); m++)
+          {
+            pointData.push_back({ "mode " + to_string(m), 1,
+              vector<double>(modes.col(m).data(), modes.col(m).data() + modes.rows()) });
+          }
+        }
+        vector<vtkDataArray> cellData(1, { "segment", 1,
+          vector<double>(sec->getTriangles().size(), (double)exportedSecs[n]) });
+
+        ok = writeVtkTriangleMesh(dirName + blockFiles[n], points,
+          sec->getTriangles(), pointData, cellData);
+      }
+      else
+      {
+        // the field is computed in the plane y = 0, its rows are along z
+        int numPts(m_nPtx * m_nPty);
+        vector<vtkDataArray> pointData = { { "magnitude", 1, vector<double>(numPts) },
+          { "phase", 1, vector<double>(numPts) }, 
+          { "pressure", 2, vector<double>(2 * numPts) } };
+        for (int j(0); j < m_nPty; j++)
+        {
+          for (int i(0); i < m_nPtx; i++)
+          {
+            complex<double> value(m_field(j, i));
+            pointData[0].values[j * m_nPtx + i] = abs(value);
+            pointData[1].values[j * m_nPtx + i] = arg(value);
+            pointData[2].values[2 * (j * m_nPtx + i)] = value.real();
+            pointData[2].values[2 * (j * m_nPtx + i) + 1] = value.imag();
+          }
+        }
+        ok = writeVtkImageData(dirName + blockFiles[n], { m_nPtx, 1, m_nPty },
+          { m_simuParams.bbox[0].x(), 0., m_simuParams.bbox[0].y() },
+          { m_lx / (double)(m_nPtx - 1), 1., m_ly / (double)(m_nPty - 1) }, 
+          pointData);
+      }
+      if (!ok) { success = false; }
+    });
+
+  if (success && !writeVtkMultiBlock(fileName, blockNames, blockFiles))
   {
-    addRadMatToInterpolate(nbRadFreqs, idxRadSec, i);
+    success = false;
   }
+  if (!success) { log << "Cannot write the VTK files" << endl; }
+  log.close();
 
-  computeInterpCoefRadMat(nbRadFreqs, idxRadSec);
+  return success;
 }
 
 //*************************************************************************
+// Interpolate the radiation and admittance matrices with splines
 
-void Acoustic3dSimulation::initCoefInterpRadiationMatrices(int nbRadFreqs, int idxRadSec)
+void Acoustic3dSimulation::preComputeRadiationMatrices(int nbRadFreqs, int idxRadSec) 
 {
-  int mn(m_crossSections[idxRadSec]->numberOfModes());
-  m_radiationFreqs.clear();
-  m_radiationFreqs.reserve(nbRadFreqs);
+  preComputeRadiationMatrices(nbRadFreqs, idxRadSec, progressCallback());
+}
 
-  // initialize coefficient structures
-  //        a       |        b       |        c       |       d       
-  // Zr  Zi  Ir  Ii | Zr  Zi  Ir  Ii | Zr  Zi  Ir  Ii | Zr  Zi  Ir  Ii    
-  // 0   1   2   3  | 4   5   6   7  | 8   9   10  11 | 12  13  14  15
-  m_radiationMatrixInterp.clear();
-  for (int m(0); m < 16; m++)
+//*************************************************************************
+// Precompute the radiation impedance with an adaptive frequency sampling:
+// the impedance is first computed at nbRadFreqs / 2 + 1 frequencies, then
+// each interval is split in two as long as the interpolated impedance at its
+// middle differs from the computed one by more than the tolerance. The 
+// computed frequencies are saved in the cache if it is enabled.
+// Returns false if the computation has been cancelled by the progress callback.
+
+bool Acoustic3dSimulation::preComputeRadiationMatrices(int nbRadFreqs, int idxRadSec,
+  const progressCallback& progress)
+{
+  ScopedTimer timer("radiation impedance");
+  int numInitFreqs(max(4, nbRadFreqs / 2 + 1));
+  int maxNumFreqs((numInitFreqs - 1) * (1 << RADIATION_MAX_REFINEMENTS) + 1);
+  double radFreqSteps((double)SAMPLING_RATE / 2. / (double)(numInitFreqs - 1));
+  double minInterval(radFreqSteps / (double)(1 << RADIATION_MAX_REFINEMENTS));
+  map<double, Eigen::MatrixXcd> radImped;
+  vector<double> freqs, midFreqs;
+  vector<Eigen::MatrixXcd> impeds;
+  Eigen::MatrixXcd interpImped;
+  int numRefined;
+
+  LogStream log(m_logFile);
+
+  // load the radiation impedance from the cache
+  string cacheFile;
+  if (m_cacheDirectory != "")
   {
-    m_radiationMatrixInterp.push_back(vector<vector<vector<double>>>());
-    for (int i(0); i < mn; i++) {
+    cacheFile = cacheFileName(m_cacheDirectory, "radiation",
+      radiationCacheKey(nbRadFreqs, idxRadSec));
+    if (readCacheFile(cacheFile, [&freqs, &radImped](istream& is)
+      {
+        vector<Eigen::MatrixXd> re, im;
+        if (!(readBinary(is, freqs) && readBinary(is, re) && readBinary(is, im))
+          || (re.size() != freqs.size()) || (im.size() != freqs.size())
+          || (freqs.size() < 4)) { return false; }
+        for (int i(0); i < freqs.size(); i++)
+        {
+          radImped[freqs[i]] = re[i].cast<complex<double>>()
+            + 1i * im[i].cast<complex<double>>();
+        }
+        return true;
+      }))
+    {
+      setRadMatToInterpolate(radImped, idxRadSec);
+      log << "Radiation impedance at " << radImped.size() 
+        << " frequencies loaded from cache" << endl;
+      log.close();
+      return true;
+    }
+    radImped.clear();
+  }
 
-      m_radiationMatrixInterp.back().push_back(vector<vector<double>>());
+  // compute the impedance at the initial frequencies
+  for (int i(0); i < numInitFreqs; i++)
+  {
+    freqs.push_back(max(500., (double)i * radFreqSteps));
+  }
+  radiationImpedance(impeds, freqs, RADIATION_GRID_DENSITY, idxRadSec);
+  for (int i(0); i < numInitFreqs; i++) { radImped[freqs[i]] = impeds[i]; }
+  log << "Radiation impedance computed at " << numInitFreqs << " frequencies" << endl;
+  if (progress && !progress(radImped.size(), maxNumFreqs)) 
+  { 
+    m_simuParams.radImpedPrecomputed = false;
+    log.close();
+    return false; 
+  }
 
-      for (int j(0); j < mn; j++)
+  // refine the intervals which are not well interpolated
+  midFreqs.clear();
+  for (auto it = radImped.begin(); next(it) != radImped.end(); it++)
+  {
+    midFreqs.push_back(0.5 * (it->first + next(it)->first));
+  }
+  while (midFreqs.size() > 0)
+  {
+    setRadMatToInterpolate(radImped, idxRadSec);
+    radiationImpedance(impeds, midFreqs, RADIATION_GRID_DENSITY, idxRadSec);
+
+    freqs = midFreqs;
+    midFreqs.clear();
+    numRefined = 0;
+    for (int i(0); i < freqs.size(); i++)
+    {
+      interpolateRadiationImpedance(interpImped, freqs[i], idxRadSec);
+      radImped[freqs[i]] = impeds[i];
+
+      // if the interpolation error is too large, check the two new intervals
+      auto it = radImped.find(freqs[i]);
+      double interval(next(it)->first - it->first);
+      if (((impeds[i] - interpImped).norm() > RADIATION_INTERPOLATION_TOLERANCE 
+        * impeds[i].norm()) && (interval > 1.5 * minInterval))
       {
-        m_radiationMatrixInterp.back().back().push_back(vector<double>());
-        m_radiationMatrixInterp.back().back().back().reserve(nbRadFreqs);
+        midFreqs.push_back(0.5 * (prev(it)->first + it->first));
+        midFreqs.push_back(0.5 * (it->first + next(it)->first));
+        numRefined++;
       }
     }
+    log << "Radiation impedance computed at " << freqs.size() 
+      << " additional frequencies, " << numRefined << " intervals refined" << endl;
+
+    if (progress && !progress(radImped.size(), maxNumFreqs)) 
+    { 
+      m_simuParams.radImpedPrecomputed = false;
+      log.close();
+      return false;
+    }
+  }
+  setRadMatToInterpolate(radImped, idxRadSec);
+
+  // save the impedance in the cache
+  if (m_cacheDirectory != "")
+  {
+    writeCacheFile(cacheFile, [&radImped](ostream& os)
+      {
+        vector<double> freqs;
+        vector<Eigen::MatrixXd> re, im;
+        for (auto it : radImped)
+        {
+          freqs.push_back(it.first);
+          re.push_back(it.second.real());
+          im.push_back(it.second.imag());
+        }
+        writeBinary(os, freqs);
+        writeBinary(os, re);
+        writeBinary(os, im);
+      });
+  }
+
+  log.close();
+  return true;
+}
+
+//*************************************************************************
+// Key of the cache entry of the radiation impedance: it depends on the modes
+// and the scaling of the radiating section, and on the sampling parameters
+
+CacheKey Acoustic3dSimulation::radiationCacheKey(int nbRadFreqs, int idxRadSec) const
+{
+  CacheKey key;
+  key.add(m_crossSections[idxRadSec]->modesCacheKey(m_simuParams));
+  key.add(m_crossSections[idxRadSec]->numberOfModes());
+  key.add(m_crossSections[idxRadSec]->scaleOut());
+  key.add(m_crossSections[idxRadSec]->area());
+  key.add(m_simuParams.sndSpeed);
+  key.add(nbRadFreqs);
+  key.add(RADIATION_GRID_DENSITY);
+  key.add(RADIATION_INTERPOLATION_TOLERANCE);
+  key.add(RADIATION_MAX_REFINEMENTS);
+  key.add((int)m_simuParams.integrationMethodRadImped);
+  return key;
+}
+
+//*************************************************************************
+// Compute the interpolation coefficients of the radiation impedance and 
+// admittance from their values at the given frequencies
+
+void Acoustic3dSimulation::setRadMatToInterpolate(
+  const map<double, Eigen::MatrixXcd>& radImped, int idxRadSec)
+{
+  int nbRadFreqs(radImped.size());
+  int mn(m_crossSections[idxRadSec]->numberOfModes());
+  Eigen::MatrixXcd radAdmit(mn, mn);
+  Eigen::VectorXcd sample(2 * mn * mn);
+
+  initCoefInterpRadiationMatrices(nbRadFreqs, idxRadSec);
+  for (auto it : radImped)
+  {
+    m_radiationFreqs.push_back(it.first);
+    radAdmit = it.second.inverse();
+    sample.head(mn * mn) = Eigen::Map<const Eigen::VectorXcd>(it.second.data(), mn * mn);
+    sample.tail(mn * mn) = Eigen::Map<const Eigen::VectorXcd>(radAdmit.data(), mn * mn);
+    m_radiationSamples.push_back(sample);
   }
+  computeInterpCoefRadMat(nbRadFreqs, idxRadSec);
+}
+
+//*************************************************************************
+
+void Acoustic3dSimulation::initCoefInterpRadiationMatrices(int nbRadFreqs, int idxRadSec)
+{
+  m_radiationFreqs.clear();
+  m_radiationFreqs.reserve(nbRadFreqs);
+  m_radiationSamples.clear();
+  m_radiationSamples.reserve(nbRadFreqs);
+  m_radiationInterpCoefs.resize(0, 0);
 }
 
 //*************************************************************************
@@ -6331,25 +10886,18 @@ void Acoustic3dSimulation::addRadMatToInterpolate(int nbRadFreqs, int idxRadSec,
   double freq(max(500., (double)idxRadFreq * radFreqSteps));
   int mn(m_crossSections[idxRadSec]->numberOfModes());
   Eigen::MatrixXcd radImped(mn, mn), radAdmit(mn, mn);
+  Eigen::VectorXcd sample(2 * mn * mn);
 
-  ofstream log("log.txt", ofstream::app);
+  LogStream log(m_logFile);
 
   m_radiationFreqs.push_back(freq);
 
   radiationImpedance(radImped, freq, 15., idxRadSec);
   radAdmit = radImped.inverse();
 
-  // Create first spline coefficient
-  for (int m(0); m < mn; m++)
-  {
-    for (int n(0); n < mn; n++)
-    {
-      m_radiationMatrixInterp[0][m][n].push_back(radImped(m, n).real());
-      m_radiationMatrixInterp[1][m][n].push_back(radImped(m, n).imag());
-      m_radiationMatrixInterp[2][m][n].push_back(radAdmit(m, n).real());
-      m_radiationMatrixInterp[3][m][n].push_back(radAdmit(m, n).imag());
-    }
-  }
+  sample.head(mn * mn) = Eigen::Map<const Eigen::VectorXcd>(radImped.data(), mn * mn);
+  sample.tail(mn * mn) = Eigen::Map<const Eigen::VectorXcd>(radAdmit.data(), mn * mn);
+  m_radiationSamples.push_back(sample);
 
   log << "Freq " << freq << " Hz " << idxRadFreq + 1 << " over " << nbRadFreqs << endl;
 
@@ -6357,112 +10905,97 @@ void Acoustic3dSimulation::addRadMatToInterpolate(int nbRadFreqs, int idxRadSec,
 }
 
 //*************************************************************************
+// Compute the coefficients of the natural cubic splines interpolating the 
+// entries of the radiation impedance and admittance. The system giving the 
+// coefficients of degree 2 only depends on the frequencies, so it is 
+// factorised once and solved for all the entries at the same time.
 
 void Acoustic3dSimulation::computeInterpCoefRadMat(int nbRadFreqs, int idxRadSec)
 {
   vector<double> stepRadFreqs;
   stepRadFreqs.reserve(nbRadFreqs - 1);
-  int mn(m_crossSections[idxRadSec]->numberOfModes());
-  vector<double>* a, * b, * c, * d;
-  Matrix A(Matrix::Zero(nbRadFreqs - 2, nbRadFreqs - 2)), imped(mn, mn);
-  Eigen::VectorXd R(Eigen::VectorXd::Zero(nbRadFreqs - 2)), B;
+  int numEntries(m_radiationSamples[0].size());
+  Eigen::MatrixXcd A(Eigen::MatrixXcd::Zero(nbRadFreqs - 2, nbRadFreqs - 2));
+  Eigen::MatrixXcd R(nbRadFreqs - 2, numEntries), C(nbRadFreqs, numEntries);
+  const vector<Eigen::VectorXcd>& a(m_radiationSamples);
 
   for (int i(0); i < nbRadFreqs - 1; i++)
   {
     stepRadFreqs.push_back(m_radiationFreqs[i + 1] - m_radiationFreqs[i]);
   }
 
-  // compute the spline coefficients
-  for (int m(0); m < 4; m++)
-  {
-    for (int i(0); i < mn; i++)
-    {
-      for (int j(0); j < mn; j++)
-      {
-        A.setZero(nbRadFreqs - 2, nbRadFreqs - 2);
-        R.setZero(nbRadFreqs - 2);
-
-        a = &m_radiationMatrixInterp[m][i][j];
-        b = &m_radiationMatrixInterp[m + 4][i][j];
-        c = &m_radiationMatrixInterp[m + 8][i][j];
-        d = &m_radiationMatrixInterp[m + 12][i][j];
-
-        // build matrice A and vector R to solve the equation A * c = R
-        // in order to find the coefficient c of the spline
-        A(0, 0) = 2 * (stepRadFreqs[0] + stepRadFreqs[1]);
-        A(0, 1) = stepRadFreqs[1];
-        R(0) = 3. * ((*a)[2] - (*a)[1]) / stepRadFreqs[1]
-          - 3 * ((*a)[1] - (*a)[0]) / stepRadFreqs[0];
+  // build matrice A and the right hand sides R to solve the equation 
+  // A * c = R in order to find the coefficients c of the splines
+  A(0, 0) = 2 * (stepRadFreqs[0] + stepRadFreqs[1]);
+  A(0, 1) = stepRadFreqs[1];
+  R.row(0) = (3. * (a[2] - a[1]) / stepRadFreqs[1]
+    - 3. * (a[1] - a[0]) / stepRadFreqs[0]).transpose();
 
-        for (int f(1); f < nbRadFreqs - 3; f++)
-        {
-          A(f, f - 1) = stepRadFreqs[f];
-          A(f, f) = 2. * (stepRadFreqs[f] + stepRadFreqs[f + 1]);
-          A(f, f + 1) = stepRadFreqs[f + 1];
-          R(f) = 3. * ((*a)[f + 2] - (*a)[f + 1]) / stepRadFreqs[f + 1]
-            - 3. * ((*a)[f + 1] - (*a)[f]) / stepRadFreqs[f];
-        }
-
-        A(nbRadFreqs - 3, nbRadFreqs - 4) = stepRadFreqs[nbRadFreqs - 3];
-        A(nbRadFreqs - 3, nbRadFreqs - 3) = 2. * (stepRadFreqs[nbRadFreqs - 3] + stepRadFreqs[nbRadFreqs - 2]);
-        R(nbRadFreqs - 3) = 3. * ((*a)[nbRadFreqs - 1] - (*a)[nbRadFreqs - 2])
-          / stepRadFreqs[nbRadFreqs - 2]
-          - 3. * ((*a)[nbRadFreqs - 2] - (*a)[nbRadFreqs - 3])
-          / stepRadFreqs[nbRadFreqs - 3];
-
-        // compute c coefficient
-        B = A.householderQr().solve(R);
-        (*c).push_back(0.);
-        for (int f(0); f < B.rows(); f++)
-        {
-          (*c).push_back(B(f));
-        }
-        (*c).push_back(0.);
+  for (int f(1); f < nbRadFreqs - 3; f++)
+  {
+    A(f, f - 1) = stepRadFreqs[f];
+    A(f, f) = 2. * (stepRadFreqs[f] + stepRadFreqs[f + 1]);
+    A(f, f + 1) = stepRadFreqs[f + 1];
+    R.row(f) = (3. * (a[f + 2] - a[f + 1]) / stepRadFreqs[f + 1]
+      - 3. * (a[f + 1] - a[f]) / stepRadFreqs[f]).transpose();
+  }
 
-        // compute b coefficient
-        for (int f(0); f < nbRadFreqs - 1; f++)
-        {
-          (*b).push_back(((*a)[f + 1] - (*a)[f])
-            / stepRadFreqs[f] - stepRadFreqs[f] *
-            ((*c)[f + 1] + 2. * (*c)[f]) / 3.);
-          (*d).push_back(((*c)[f + 1] - (*c)[f]) / 3. / stepRadFreqs[f]);
-        }
-      }
-    }
+  A(nbRadFreqs - 3, nbRadFreqs - 4) = stepRadFreqs[nbRadFreqs - 3];
+  A(nbRadFreqs - 3, nbRadFreqs - 3) = 2. * (stepRadFreqs[nbRadFreqs - 3] + stepRadFreqs[nbRadFreqs - 2]);
+  R.row(nbRadFreqs - 3) = (3. * (a[nbRadFreqs - 1] - a[nbRadFreqs - 2])
+    / stepRadFreqs[nbRadFreqs - 2]
+    - 3. * (a[nbRadFreqs - 2] - a[nbRadFreqs - 3])
+    / stepRadFreqs[nbRadFreqs - 3]).transpose();
+
+  // compute the c coefficients (zero at both ends)
+  C.row(0).setZero();
+  C.middleRows(1, nbRadFreqs - 2) = A.householderQr().solve(R);
+  C.row(nbRadFreqs - 1).setZero();
+
+  // compute the b and d coefficients
+  m_radiationInterpCoefs.resize(numEntries, 4 * (nbRadFreqs - 1));
+  for (int f(0); f < nbRadFreqs - 1; f++)
+  {
+    m_radiationInterpCoefs.col(4 * f) = a[f];
+    m_radiationInterpCoefs.col(4 * f + 1) = (a[f + 1] - a[f]) / stepRadFreqs[f]
+      - stepRadFreqs[f] * (C.row(f + 1) + 2. * C.row(f)).transpose() / 3.;
+    m_radiationInterpCoefs.col(4 * f + 2) = C.row(f).transpose();
+    m_radiationInterpCoefs.col(4 * f + 3) = (C.row(f + 1) - C.row(f)).transpose()
+      / 3. / stepRadFreqs[f];
   }
   m_simuParams.radImpedPrecomputed = true;
 }
 
 //*************************************************************************
-// Interpolate the radiation impedance matrix at a given frequency
+// Evaluate the splines of numEntries consecutive entries of the radiation 
+// impedance and admittance at a given frequency (Horner scheme on the 
+// contiguous coefficients of the interval containing the frequency)
 
-void Acoustic3dSimulation::interpolateRadiationImpedance(Eigen::MatrixXcd& imped, 
-   double freq, int idxRadSec)
+void Acoustic3dSimulation::interpolateRadiationEntries(double freq, int firstEntry, 
+  int numEntries, Eigen::VectorXcd& values) const
 {
   // find the index corresponding to the coefficient to use for this frequency
-  int nbRadFreqs(m_radiationMatrixInterp[0][0][0].size());
+  int nbRadFreqs(m_radiationFreqs.size());
   int idx(nbRadFreqs - 2);
   while ((m_radiationFreqs[idx] > freq) && (idx > 0)) { idx--; }
   idx = max(0, idx);
 
-  // get number of modes of the radiating section
-  int mn(m_crossSections[idxRadSec]->numberOfModes());
+  double df(freq - m_radiationFreqs[idx]);
+  auto coef = [&](int k) 
+    { return m_radiationInterpCoefs.col(4 * idx + k).segment(firstEntry, numEntries); };
+  values = coef(0) + df * (coef(1) + df * (coef(2) + df * coef(3)));
+}
 
-  imped.setZero(mn, mn);
-  for (int m(0); m < mn; m++)
-  {
-    for (int n(0); n < mn; n++)
-    {
-      imped(m, n) = complex<double>(m_radiationMatrixInterp[0][m][n][idx] +
-        m_radiationMatrixInterp[4][m][n][idx] * (freq - m_radiationFreqs[idx]) +
-        m_radiationMatrixInterp[8][m][n][idx] * pow(freq - m_radiationFreqs[idx], 2) +
-        m_radiationMatrixInterp[12][m][n][idx] * pow(freq - m_radiationFreqs[idx], 3), 
-        (m_radiationMatrixInterp[1][m][n][idx] +
-        m_radiationMatrixInterp[5][m][n][idx] * (freq - m_radiationFreqs[idx]) +
-        m_radiationMatrixInterp[9][m][n][idx] * pow(freq - m_radiationFreqs[idx], 2) +
-        m_radiationMatrixInterp[13][m][n][idx] * pow(freq - m_radiationFreqs[idx], 3)));
-    }
-  }
+//*************************************************************************
+// Interpolate the radiation impedance matrix at a given frequency
+
+void Acoustic3dSimulation::interpolateRadiationImpedance(Eigen::MatrixXcd& imped, 
+   double freq, int idxRadSec)
+{
+  int mn(m_crossSections[idxRadSec]->numberOfModes());
+  Eigen::VectorXcd values;
+  interpolateRadiationEntries(freq, 0, mn * mn, values);
+  imped = Eigen::Map<const Eigen::MatrixXcd>(values.data(), mn, mn);
 }
 
 //*************************************************************************
@@ -6471,30 +11004,24 @@ void Acoustic3dSimulation::interpolateRadiationImpedance(Eigen::MatrixXcd& imped
 void Acoustic3dSimulation::interpolateRadiationAdmittance(Eigen::MatrixXcd& admit, 
   double freq, int idxRadSec)
 {
-  // find the index corresponding to the coefficient to use for this frequency
-  int nbRadFreqs(m_radiationMatrixInterp[0][0][0].size());
-  int idx(nbRadFreqs - 2);
-  while ((m_radiationFreqs[idx] > freq) && (idx > 0)) { idx--; }
-  idx = max(0, idx);
-
-  // get number of modes of the radiating section
   int mn(m_crossSections[idxRadSec]->numberOfModes());
+  Eigen::VectorXcd values;
+  interpolateRadiationEntries(freq, mn * mn, mn * mn, values);
+  admit = Eigen::Map<const Eigen::MatrixXcd>(values.data(), mn, mn);
+}
 
-  admit.setZero(mn, mn);
-  for (int m(0); m < mn; m++)
-  {
-    for (int n(0); n < mn; n++)
-    {
-      admit(m, n) = complex<double>(m_radiationMatrixInterp[2][m][n][idx] +
-        m_radiationMatrixInterp[6][m][n][idx] * (freq - m_radiationFreqs[idx]) +
-        m_radiationMatrixInterp[10][m][n][idx] * pow(freq - m_radiationFreqs[idx], 2) +
-        m_radiationMatrixInterp[14][m][n][idx] * pow(freq - m_radiationFreqs[idx], 3),
-        (m_radiationMatrixInterp[3][m][n][idx] +
-        m_radiationMatrixInterp[7][m][n][idx] * (freq - m_radiationFreqs[idx]) +
-        m_radiationMatrixInterp[11][m][n][idx] * pow(freq - m_radiationFreqs[idx], 2) +
-        m_radiationMatrixInterp[15][m][n][idx] * pow(freq - m_radiationFreqs[idx], 3)));
-    }
-  }
+//*************************************************************************
+// Interpolate the radiation impedance and admittance matrices at a given 
+// frequency in one pass over the coefficients
+
+void Acoustic3dSimulation::interpolateRadiationMatrices(Eigen::MatrixXcd& imped,
+  Eigen::MatrixXcd& admit, double freq, int idxRadSec)
+{
+  int mn(m_crossSections[idxRadSec]->numberOfModes());
+  Eigen::VectorXcd& values(junctionWork().radValues);
+  interpolateRadiationEntries(freq, 0, 2 * mn * mn, values);
+  imped = Eigen::Map<const Eigen::MatrixXcd>(values.data(), mn, mn);
+  admit = Eigen::Map<const Eigen::MatrixXcd>(values.data() + mn * mn, mn, mn);
 }
 
 //*************************************************************************
@@ -6505,10 +11032,33 @@ void Acoustic3dSimulation::interpolateRadiationAdmittance(Eigen::MatrixXcd& admi
 void Acoustic3dSimulation::radiationImpedance(Eigen::MatrixXcd& imped, double freq, 
   double gridDensity, int idxRadSec)
 {
+  vector<Eigen::MatrixXcd> impeds;
+  radiationImpedance(impeds, vector<double>(1, freq), gridDensity, idxRadSec);
+  imped = impeds[0];
+}
+
+//*************************************************************************
+// Compute the radiation impedance at several frequencies: the grids and 
+// the interpolation of the modes on them do not depend on the frequency, 
+// so they are computed only once for all the frequencies. The points of the
+// cartesian grid are processed in parallel by blocks, each block summing its
+// contribution in its own matrices, which are then added in the order of the
+// blocks so that the result does not depend on the number of threads.
+
+void Acoustic3dSimulation::radiationImpedance(vector<Eigen::MatrixXcd>& imped,
+  const vector<double>& freqs, double gridDensity, int idxRadSec)
+{
+  if (m_simuParams.integrationMethodRadImped == FFT_CONVOLUTION)
+  {
+    radiationImpedanceFFT(imped, freqs, gridDensity, idxRadSec);
+    return;
+  }
+
+  const int BLOCK_SIZE(32);
   int mn(m_crossSections[idxRadSec]->numberOfModes());
+  int numFreqs(freqs.size());
 
-  imped = Eigen::MatrixXcd::Zero(mn, mn);
-  Eigen::MatrixXcd integral2(mn, mn);
+  imped.assign(numFreqs, Eigen::MatrixXcd::Zero(mn, mn));
 
   //******************************
   // generate cartesian grid
@@ -6521,7 +11071,7 @@ void Acoustic3dSimulation::radiationImpedance(Eigen::MatrixXcd& imped, double fr
     / gridDensity);
 
   //Transformation scale(CGAL::SCALING, scaling);
-  Polygon_2 contour(m_crossSections[idxRadSec]->contour());
+  const Polygon_2& contour(m_crossSections[idxRadSec]->contour());
   vector<Point> cartGrid;
   Point pt;
   double xmin(contour.bbox().xmin());
@@ -6543,99 +11093,256 @@ void Acoustic3dSimulation::radiationImpedance(Eigen::MatrixXcd& imped, double fr
   // Interpolate the propagation modes on the cartesian grid
   Matrix intCartGrid(m_crossSections[idxRadSec]->interpolateModes(cartGrid));
 
-  // loop over the points of the cartesian grid
-  for (int c(0); c < cartGrid.size(); c++)
+  // contributions of the blocks of points of the cartesian grid
+  int numPts(cartGrid.size());
+  int numBlocks((numPts + BLOCK_SIZE - 1) / BLOCK_SIZE);
+  vector<vector<Eigen::MatrixXcd>> blockImped(numBlocks,
+    vector<Eigen::MatrixXcd>(numFreqs, Eigen::MatrixXcd::Zero(mn, mn)));
+
+  parallelLoop(numBlocks, m_simuParams.numThreads, [&](int b)
+    {
+      Eigen::VectorXcd phase, integral2(mn);
+      Matrix intPolGrid;
+      vector<Eigen::MatrixXcd>& blockSum(blockImped[b]);
+
+      // loop over the points of the block
+      for (int c(b * BLOCK_SIZE); c < min(numPts, (b + 1) * BLOCK_SIZE); c++)
+      {
+
+        //******************************
+        // generate polar grid
+        //******************************
+
+        //FIXME: don't work for lines intersecting several times the polygon
+
+        int numDirections;
+        double angleSpacing, direction;
+        vector<Point> polGrid;
+        vector<double> radius;
+        int cnt, nbPts(0);
+        double r, sumH;
+        Point pt, ptToAdd;
+
+        // get center point from the cartesian grid
+        pt = cartGrid[c];
+
+        // estimate the ratio [number of direction] / [number of point]
+        numDirections = 50;
+        angleSpacing = 2. * M_PI / (double)numDirections;
+        for (int i(0); i < numDirections; i++)
+        {
+          direction = (double)i * angleSpacing - M_PI;
+          cnt = 0;
+          r = (0.5 + (double)cnt) * spacing;
+          ptToAdd = Point(r * cos(direction) + pt.x(), r * sin(direction) + pt.y());
+          while (contour.has_on_bounded_side(ptToAdd))
+          {
+            nbPts++;
+            cnt++;
+            r = (0.5 + (double)cnt) * spacing;
+            ptToAdd = Point(r * cos(direction) + pt.x(), r * sin(direction) + pt.y());
+          }
+        }
+
+        // Rough estimate of the number of needed directions
+        numDirections = cartGrid.size() * numDirections / nbPts;
+
+        // generate angles of the polar grid
+        angleSpacing = 2. * M_PI / (double)numDirections;
+        for (int i(0); i < numDirections; i++)
+        {
+          direction = (double)i * angleSpacing - M_PI;
+
+          // generate the points of the polar grid for each direction
+          cnt = 0;
+          r = (0.5 + (double)cnt) * spacing;
+          ptToAdd = Point(r * cos(direction) + pt.x(), r * sin(direction) + pt.y());
+          while (contour.has_on_bounded_side(ptToAdd))
+          {
+            polGrid.push_back(ptToAdd);
+            radius.push_back(r);
+            cnt++;
+            r = (0.5 + (double)cnt) * spacing;
+            ptToAdd = Point(r * cos(direction) + pt.x(), r * sin(direction) + pt.y());
+          } 
+        }
+
+        // interpolate the polar grid
+        m_crossSections[idxRadSec]->interpolateModes(polGrid, intPolGrid);
+
+        //******************************
+        // Compute first integral
+        //******************************
+
+        sumH = 0;
+        for (int p(0); p < polGrid.size(); p++)
+        {
+          sumH += radius[p];
+        }
+
+        // loop over the frequencies
+        phase.resize(polGrid.size());
+        for (int f(0); f < numFreqs; f++)
+        {
+          for (int p(0); p < polGrid.size(); p++)
+          {
+            phase(p) = exp(-1i * 2. * M_PI * freqs[f] * scaling * radius[p] / m_simuParams.sndSpeed);
+          }
+
+          // sum over the points of the polar grid for each mode, the product
+          // with the modes at the cartesian grid point is then separable
+          integral2 = intPolGrid.transpose().cast<complex<double>>() * phase;
+          blockSum[f] += - integral2 * intCartGrid.row(c).cast<complex<double>>()
+            / sumH / 2. / M_PI / (double)cartGrid.size() / scaling;
+        }
+      }
+    });
+
+  for (int f(0); f < numFreqs; f++)
   {
+    for (int b(0); b < numBlocks; b++) { imped[f] += blockImped[b][f]; }
+    imped[f] *= pow(m_crossSections[idxRadSec]->area(), 2);
+  }
+}
 
-    //******************************
-    // generate polar grid
-    //******************************
+//*************************************************************************
+// Compute the radiation impedance at several frequencies on the cartesian 
+// grid only: the double integral of the modes weighted by the Green 
+// function is a discrete convolution of the modes with the Green function 
+// sampled on the grid, which is computed by FFT on a zero-padded grid.
+// The singular term of each cell is replaced by the integral of the Green
+// function over the cell. This costs O(N log N) per mode and frequency 
+// instead of O(N^2) for the polar grid method.
+
+void Acoustic3dSimulation::radiationImpedanceFFT(vector<Eigen::MatrixXcd>& imped,
+  const vector<double>& freqs, double gridDensity, int idxRadSec)
+{
+  int mn(m_crossSections[idxRadSec]->numberOfModes());
+  int numFreqs(freqs.size());
 
-    //FIXME: don't work for lines intersecting several times the polygon
+  imped.assign(numFreqs, Eigen::MatrixXcd::Zero(mn, mn));
 
-    int numDirections;
-    double angleSpacing, direction;
-    vector<Point> polGrid;
-    vector<double> radius;
-    int cnt, nbPts(0);
-    double r, sumH;
-    Point ptToAdd;
+  //******************************
+  // generate cartesian grid
+  //******************************
 
-    // get center point from the cartesian grid
-    pt = cartGrid[c];
+  double scaling(m_crossSections[idxRadSec]->scaleOut());
+  double spacing(sqrt(m_crossSections[idxRadSec]->area()) 
+    / gridDensity);
 
-    // estimate the ratio [number of direction] / [number of point]
-    numDirections = 50;
-    angleSpacing = 2. * M_PI / (double)numDirections;
-    for (int i(0); i < numDirections; i++)
+  const Polygon_2& contour(m_crossSections[idxRadSec]->contour());
+  vector<Point> cartGrid;
+  vector<int> idxPadGrid;
+  Point pt;
+  double xmin(contour.bbox().xmin());
+  double ymin(contour.bbox().ymin());
+  int nx(ceil((contour.bbox().xmax() - xmin) / spacing));
+  int ny(ceil((contour.bbox().ymax() - ymin) / spacing));
+  // the linear convolution of 2 grids of n points has 2n - 1 points
+  int nxPad(fftSize(2 * nx - 1)), nyPad(fftSize(2 * ny - 1));
+  for (int i(0); i < nx; i++)
+  {
+    for (int j(0); j < ny; j++)
     {
-      direction = (double)i * angleSpacing - M_PI;
-      cnt = 0;
-      r = (0.5 + (double)cnt) * spacing;
-      ptToAdd = Point(r * cos(direction) + pt.x(), r * sin(direction) + pt.y());
-      while (contour.has_on_bounded_side(ptToAdd))
+      pt = Point(xmin + i * spacing, ymin + j * spacing);
+      if (contour.has_on_bounded_side(pt))
       {
-        nbPts++;
-        cnt++;
-        r = (0.5 + (double)cnt) * spacing;
-        ptToAdd = Point(r * cos(direction) + pt.x(), r * sin(direction) + pt.y());
+        cartGrid.push_back(pt);
+        idxPadGrid.push_back(i * nyPad + j);
       }
     }
+  }
+  int nbPts(cartGrid.size());
+  if (nbPts == 0) { return; }
 
-    // Rough estimate of the number of needed directions
-    numDirections = cartGrid.size() * numDirections / nbPts;
+  // area associated with each point of the grid
+  double dS(m_crossSections[idxRadSec]->area() / (double)nbPts);
 
-    // generate angles of the polar grid
-    angleSpacing = 2. * M_PI / (double)numDirections;
-    for (int i(0); i < numDirections; i++)
-    {
-      direction = (double)i * angleSpacing - M_PI;
+  // Interpolate the propagation modes on the cartesian grid
+  Matrix intCartGrid;
+  m_crossSections[idxRadSec]->interpolateModes(cartGrid, intCartGrid);
 
-      // generate the points of the polar grid for each direction
-      cnt = 0;
-      r = (0.5 + (double)cnt) * spacing;
-      ptToAdd = Point(r * cos(direction) + pt.x(), r * sin(direction) + pt.y());
-      while (contour.has_on_bounded_side(ptToAdd))
-      {
-        polGrid.push_back(ptToAdd);
-        radius.push_back(r);
-        cnt++;
-        r = (0.5 + (double)cnt) * spacing;
-        ptToAdd = Point(r * cos(direction) + pt.x(), r * sin(direction) + pt.y());
-      } 
+  // the FFT of the modes on the padded grid does not depend on the frequency
+  Eigen::FFT<double> fft;
+  vector<vector<complex<double>>> modesFFT(mn, 
+    vector<complex<double>>(nxPad * nyPad, 0.));
+  for (int m(0); m < mn; m++)
+  {
+    for (int c(0); c < nbPts; c++)
+    {
+      modesFFT[m][idxPadGrid[c]] = intCartGrid(c, m);
     }
+    fft2d(fft, modesFFT[m], nxPad, nyPad, false);
+  }
 
-    // interpolate the polar grid
-    Matrix intPolGrid(m_crossSections[idxRadSec]->interpolateModes(polGrid));
-
-    //******************************
-    // Compute first integral
-    //******************************
-
-    sumH = 0;
-    integral2.setZero();
+  // the frequencies are independent and computed in parallel, each thread
+  // with its own FFT and work arrays
+  int numThreads(max(1, min(m_simuParams.numThreads, numFreqs)));
+  vector<Eigen::FFT<double>> threadFft(numThreads);
+  vector<vector<complex<double>>> threadGreen(numThreads), threadConv(numThreads);
+  vector<Eigen::MatrixXcd> threadConvGrid(numThreads);
+
+  parallelLoopIndexed(numFreqs, numThreads, [&](int f, int t)
+    {
+      Eigen::FFT<double>& fft(threadFft[t]);
+      vector<complex<double>>& green(threadGreen[t]), & conv(threadConv[t]);
+      Eigen::MatrixXcd& convGrid(threadConvGrid[t]);
+      green.resize(nxPad * nyPad);
+      conv.resize(nxPad * nyPad);
+      convGrid.resize(nbPts, mn);
+      int di, dj;
+      double k, r;
+
+      k = 2. * M_PI * freqs[f] * scaling / m_simuParams.sndSpeed;
+
+      //******************************
+      // sample the Green function
+      //******************************
+
+      // the negative offsets between the grid points are wrapped at the end
+      // of the padded grid
+      for (int i(0); i < nxPad; i++)
+      {
+        di = (i < nx) ? i : i - nxPad;
+        for (int j(0); j < nyPad; j++)
+        {
+          dj = (j < ny) ? j : j - nyPad;
+          if ((abs(di) >= nx) || (abs(dj) >= ny))
+          {
+            green[i * nyPad + j] = 0.;
+          }
+          else if ((di == 0) && (dj == 0))
+          {
+            // mean of the Green function over a square cell of area dS, the
+            // cell area of the other terms
+            green[i * nyPad + j] = 4. * log(1. + sqrt(2.)) / sqrt(dS) - 1i * k;
+          }
+          else
+          {
+            r = spacing * sqrt((double)(di * di + dj * dj));
+            green[i * nyPad + j] = exp(-1i * k * r) / r;
+          }
+        }
+      }
+      fft2d(fft, green, nxPad, nyPad, false);
 
-    // loop over the points of the polar grid
-    for (int p(0); p < polGrid.size(); p++)
-    {
-      sumH += radius[p];
+      //******************************
+      // convolve the modes
+      //******************************
 
-      // loop over the modes
       for (int m(0); m < mn; m++)
       {
-        // loop over the modes
-        for (int n(0); n < mn; n++)
+        multiplyComplex(modesFFT[m].data(), green.data(), conv.data(), nxPad * nyPad);
+        fft2d(fft, conv, nxPad, nyPad, true);
+        for (int c(0); c < nbPts; c++)
         {
-          integral2(m, n) += intPolGrid(p, m) * intCartGrid(c, n) *
-            exp(-1i * 2. * M_PI * freq * scaling * radius[p] / m_simuParams.sndSpeed);
+          convGrid(c, m) = conv[idxPadGrid[c]];
         }
       }
-    }
-
-    imped += - integral2 / sumH / 2. / M_PI / cartGrid.size() / scaling;
-  }
 
-  imped *= pow(m_crossSections[idxRadSec]->area(),2);
+      imped[f] = - convGrid.transpose() * intCartGrid.cast<complex<double>>()
+        * pow(dS, 2) / 2. / M_PI / scaling;
+    });
 }
 
 //*************************************************************************
@@ -6646,8 +11353,7 @@ void Acoustic3dSimulation::getRadiationImpedanceAdmittance(Eigen::MatrixXcd& imp
 {
   if (m_simuParams.radImpedPrecomputed)
   {
-    interpolateRadiationImpedance(imped, freq, idxRadSec);
-    interpolateRadiationAdmittance(admit, freq, idxRadSec);
+    interpolateRadiationMatrices(imped, admit, freq, idxRadSec);
   }
   else
   {
@@ -25,7 +25,18 @@
 #include "CrossSection2d.h"
 #include "VocalTract.h"
 #include "Signal.h"
+#include "ParallelLoop.h"
+#include "SegmentGrid.h"
+#include "Logger.h"
+#include "GeometryFile.h"
+#include "MeshSlicer.h"
+#include "NpyWriter.h"
+#include "RationalFit.h"
 #include <vector>
+#include <fstream>
+#include <atomic>
+#include <mutex>
+#include <array>
 
 // for CGAL
 #include <CGAL/Exact_predicates_inexact_constructions_kernel.h>
@@ -67,6 +78,105 @@ enum tfType {
   INPUT_IMPED
 };
 
+// **************************************************************************
+// Quadrature of the exit plane of a segment used to compute the radiated 
+// field with the Rayleigh-Sommerfeld integral (stored as separated arrays so 
+// that the integral can be vectorised)
+// **************************************************************************
+
+struct radiationSource
+{
+  vector<double> y;
+  vector<double> z;
+  // amplitudes of the integration points (weights times velocity)
+  vector<double> ampRe;
+  vector<double> ampIm;
+  // scaling applied to the radiated points
+  double pointScaling;
+  // signed wave number of the Green's function
+  double waveNumber;
+  bool built;
+
+  radiationSource() : pointScaling(1.), waveNumber(0.), built(false) {}
+};
+
+// **************************************************************************
+// Green's matrix giving the pressure radiated at a set of points from the 
+// amplitudes of the velocity modes at the exit, for one frequency. It is 
+// shared by all the computations of the field at these points and at this 
+// frequency (transfer functions of the glottal and of the noise sources).
+// **************************************************************************
+
+struct radiationKernel
+{
+  // indexes of the points in the radiation domain and inside the geometry
+  vector<int> idxRadPts;
+  vector<int> idxInteriorPts;
+  // radiated pressure = green * Qout
+  Eigen::MatrixXcd green;
+  double freq;
+  bool built;
+
+  radiationKernel() : freq(0.), built(false) {}
+};
+
+// **************************************************************************
+// Part of the acoustic field on a grid of points which does not depend on 
+// the frequency: the points inside the geometry are grouped by segment with
+// their local coordinates and the amplitudes of the modes at their position,
+// so that the field of a segment is a single matrix product with the 
+// amplitudes propagated along it. The radiated points are kept with their 
+// coordinates relative to the exit.
+// **************************************************************************
+
+struct fieldBasis
+{
+  int numPts;
+  vector<int> segments;
+  // indexes and local coordinates of the points of each segment
+  vector<vector<int>> idxPts;
+  vector<vector<Point_3>> localPts;
+  vector<Matrix> modes;
+  vector<Point_3> radPts;
+  vector<int> idxRadPts;
+
+  fieldBasis() : numPts(0) {}
+};
+
+// **************************************************************************
+// Images of the amplitude, the phase and the amplitude in dB of the last 
+// acoustic field computed at several resolutions, from which the pictures 
+// of the field are sampled whatever their zoom. The level 0 holds the 
+// average of the 4 points of each cell of the field, each next level the 
+// average of 2 x 2 cells of the previous level.
+// **************************************************************************
+
+struct fieldImagePyramid
+{
+  unsigned version;             // version of the field of the images
+  vector<Matrix> amplitude;
+  vector<Matrix> phase;
+  vector<Matrix> dB;
+
+  fieldImagePyramid() : version(0) {}
+};
+
+// **************************************************************************
+// Cost of a segment: the size of its mesh, its number of modes, the time of
+// the computation of its modes and of its junctions, and the mean time of its
+// propagation at one frequency (admittance and pressure), in s. The times 
+// are measured by the profiler and are 0 if it was disabled.
+// **************************************************************************
+
+struct segmentCost
+{
+  int meshFaces;
+  int modes;
+  double modeSolve;
+  double junctions;
+  double propagation;
+};
+
 class Acoustic3dSimulation
 {
 // **************************************************************************
@@ -75,20 +185,71 @@ class Acoustic3dSimulation
 
 public:
 
+  Acoustic3dSimulation();
   ~Acoustic3dSimulation();
+  // instance shared by the GUI
   static Acoustic3dSimulation *getInstance();
 
   // set simulation parameters
   void setBoundarySpecificAdmittance();
   void setSimulationParameters(double meshDensity, int secNoiseSource,
-    struct simulationParameters simuParams,
+    const struct simulationParameters& simuParams,
     enum openEndBoundaryCond cond, enum contourInterpolationMethod scalingMethod);
   void setIdxSecNoiseSource(int idx) { m_idxSecNoiseSource = idx; }
+  // additional noise source positions whose transfer functions are computed
+  // in the same frequency sweep as the one of m_idxSecNoiseSource
+  void setNoiseSourceSections(const vector<int>& sections) { m_noiseSourceSections = sections; }
+  // additional glottis boundary conditions (HARD_WALL or IFINITE_WAVGUIDE)
+  // whose noise sources transfer functions are computed in the same 
+  // frequency sweep, from the impedance propagated from the exit once
+  void setExtraGlottisBoundaryConds(const vector<enum openEndBoundaryCond>& conds)
+    { m_extraGlottisBoundaryConds = conds; }
   void setGeometryImported(bool isImported) { m_geometryImported = isImported; }
-  void setGeometryFile(string fileName) { m_geometryFile = fileName; }
+  // if false, the pressure and the velocity are kept only at the ends of the 
+  // segments (enough for the transfer functions, not for the interior field)
+  void setStoreAxialProfile(bool store) { m_storeAxialProfile = store; }
+  // an STL file (extension .stl) is sliced with the mesh slicing options
+  void setGeometryFile(string fileName) 
+    { m_geometryFile = fileName; m_geometryMesh.reset(); m_geometryArrays.reset(); }
+  // mesh sliced instead of the geometry file (coordinates in cm, the 
+  // lateral axis being z, see TriangleMesh::transform())
+  void setGeometryMesh(const TriangleMesh& mesh)
+    { m_geometryMesh.reset(new TriangleMesh(mesh)); m_geometryArrays.reset(); }
+  // arrays of a geometry (as in a binary geometry file, see GeometryFile.h)
+  // imported instead of the geometry file, e.g. from a generator of 
+  // geometries, without writing and parsing a file
+  void setGeometryArrays(struct geometryArrays geo)
+  {
+    m_geometryArrays.reset(new geometryArrays(move(geo)));
+    m_geometryMesh.reset();
+  }
+  void setMeshSlicingOptions(const struct meshSlicingOptions& options)
+    { m_meshSlicingOptions = options; }
+  // log file of the simulation (empty for the log file of the program)
+  void setLogFile(string fileName) { m_logFile = fileName; }
+  // directory of the cache of the modes and junction matrices (empty to disable it)
+  void setCacheDirectory(string directory) { m_cacheDirectory = directory; }
+  // NPY files in which the transfer functions and the acoustic field are 
+  // written while they are computed (empty to disable them)
+  void setTfStreamFile(string fileName) { m_tfStreamFile = fileName; }
+  void setFieldStreamFile(string fileName) { m_fieldStreamFile = fileName; }
+  // the frequencies computed by an interrupted sweep of the same geometry
+  // with the same parameters are restored from the checkpoint of the cache
+  // directory instead of being computed again
+  void setResumeTransferFunction(bool resume) { m_resumeTf = resume; }
+  // directory shared by the processes of a distributed frequency sweep
+  // (empty for a sweep computed by this process only): the root gathers 
+  // the transfer functions in computeTransferFunction, the workers compute 
+  // blocks of frequencies in computeTransferFunctionBlocks
+  void setDistributedSweepDirectory(string directory) 
+    { m_distributedSweepDirectory = directory; }
   void setContourInterpolationMethod(enum contourInterpolationMethod method);
   void requestReloadGeometry() { m_reloadGeometry = true; }
   void requestModesAndJunctionComputation() { m_simuParams.needToComputeModesAndJunctions = true; }
+  // copy the modes and the junction matrices of the cross-sections of a 
+  // simulation of the same geometry (e.g. for several parameter variants)
+  void copyModesAndJunctions(const Acoustic3dSimulation& reference)
+    { reuseUnchangedCrossSections(reference.m_crossSections); }
   void setNeedToComputeModesAndJunctions(bool val) { m_simuParams.needToComputeModesAndJunctions = val; }
 
   void generateLogFileHeader(bool cleanLog);
@@ -97,16 +258,48 @@ public:
   void extractContours(VocalTract* tract, 
     vector<vector<Polygon_2>>& contours, vector<vector<vector<int>>>& surfaceIdx,
     vector<Point2D>& centerLine, vector<Point2D>& normals);
-  bool extractContoursFromCsvFile(
+  bool extractContoursFromCsvFile(string fileName,
+    vector<vector<Polygon_2>>& contours, vector<vector<vector<int>>>& surfaceIdx,
+    vector<Point2D>& centerLine, vector<Point2D>& normals, 
+    vector<pair<double, double>>& scalingFactors, bool simplifyContours);
+  bool extractContoursFromBinaryFile(string fileName,
+    vector<vector<Polygon_2>>& contours, vector<vector<vector<int>>>& surfaceIdx,
+    vector<Point2D>& centerLine, vector<Point2D>& normals, 
+    vector<pair<double, double>>& scalingFactors, bool simplifyContours);
+  bool extractContoursFromArrays(const struct geometryArrays& geo,
+    vector<vector<Polygon_2>>& contours, vector<vector<vector<int>>>& surfaceIdx,
+    vector<Point2D>& centerLine, vector<Point2D>& normals, 
+    vector<pair<double, double>>& scalingFactors, bool simplifyContours);
+  // contours of numSections sections stored in arrays laid out as in a binary
+  // geometry file (the arrays of a mapped file or of a geometryArrays)
+  bool extractContoursFromArrays(int numSections, const double* ctl,
+    const double* nml, const double* scl, const double* pts,
+    const uint32_t* offsets, const int32_t* idx, bool simplified,
     vector<vector<Polygon_2>>& contours, vector<vector<vector<int>>>& surfaceIdx,
     vector<Point2D>& centerLine, vector<Point2D>& normals, 
     vector<pair<double, double>>& scalingFactors, bool simplifyContours);
+  bool extractContoursFromStlFile(string fileName,
+    vector<vector<Polygon_2>>& contours, vector<vector<vector<int>>>& surfaceIdx,
+    vector<Point2D>& centerLine, vector<Point2D>& normals, 
+    vector<pair<double, double>>& scalingFactors, bool simplifyContours);
+  bool extractContoursFromMesh(const TriangleMesh& mesh,
+    vector<vector<Polygon_2>>& contours, vector<vector<vector<int>>>& surfaceIdx,
+    vector<Point2D>& centerLine, vector<Point2D>& normals, 
+    vector<pair<double, double>>& scalingFactors, bool simplifyContours);
+  // convert a csv geometry file into the binary format (see GeometryFile.h)
+  bool convertGeometryCsvToBinary(string csvFile, string binaryFile);
   void addCrossSectionFEM(double areas, double spacing,
     Polygon_2 contours, vector<int> surfacesIdx,
     double length, Point2D ctrLinePt, Point2D normal,
     double scalingFactors[2]);
   void addCrossSectionRadiation(Point2D ctrLinePt, Point2D normal,
     double radius, double PMLThickness);
+  // merge the runs of similar slices of an imported geometry (see 
+  // coarseningTolerance), returns the number of slices removed
+  int coarsenSlices(vector<vector<Polygon_2>>& contours, 
+    vector<vector<vector<int>>>& surfaceIdx, vector<Point2D>& centerLine, 
+    vector<Point2D>& normals, vector<pair<double, double>>& scalingFactors,
+    vector<double>& totAreas, vector<array<double, 4>>& bboxes, double minArea);
   bool createCrossSections(VocalTract* tract, bool createRadSection);
   void updateBoundingBox();
   void setBoundingBox(pair<Point2D, Point2D> &bbox);
@@ -114,22 +307,29 @@ public:
 
   // For transverse modes and junction matrices computation
   void computeMeshAndModes();
+  bool computeMeshAndModes(const progressCallback& progress);
   void computeMeshAndModes(int segIdx);
   void computeJunctionMatrices(int segIdx);
+  bool computeAllJunctionMatrices(const progressCallback& progress = progressCallback());
   void computeJunctionMatrices(bool computeG);
 
   // For radiation impedance computation
   void preComputeRadiationMatrices(int nbRadFreqs, int idxRadSec);
+  bool preComputeRadiationMatrices(int nbRadFreqs, int idxRadSec, 
+    const progressCallback& progress);
   void initCoefInterpRadiationMatrices(int nbRadFreqs, int idxRadSec);
   void addRadMatToInterpolate(int nbRadFreqs, int idxRadSec, int idxRadFreq);
   void computeInterpCoefRadMat(int nbRadFreqs, int idxRadSec);
 
-  void propagateImpedAdmitBranch(vector< Eigen::MatrixXcd> Q0, double freq,
-    vector<int> startSections, vector<int> endSections, double direction);
+  void propagateImpedAdmitBranch(const vector<Eigen::MatrixXcd>& Q0, double freq,
+    const vector<int>& startSections, const vector<int>& endSections, double direction);
   void propagateImpedAdmit(Eigen::MatrixXcd& startImped, Eigen::MatrixXcd& startAdmit, 
     double freq, int startSection, int endSection, std::chrono::duration<double> *time, int direction);
   void propagateImpedAdmit(Eigen::MatrixXcd& startImped, Eigen::MatrixXcd& startAdmit,
     double freq, int startSection, int endSection, std::chrono::duration<double> *time);
+  void setImpedanceFromAdmittance(int idxSec);
+  void propagateImpedAdmitSections(double freq, int firstSection, int endSection,
+    std::chrono::duration<double>* time, int direction);
   void propagateVelocityPress(Eigen::MatrixXcd &startVelocity, Eigen::MatrixXcd &startPressure, 
     double freq, int startSection, int endSection, std::chrono::duration<double> *time, int direction);
   void propagateVelocityPress(Eigen::MatrixXcd& startVelocity, Eigen::MatrixXcd& startPressure,
@@ -141,25 +341,108 @@ public:
   bool setTFPointsFromCsvFile(string fileName);
   void RayleighSommerfeldIntegral(vector<Point_3> points,
     Eigen::VectorXcd &radPress, double freq, int radSecIdx);
+  void radiationSourceQuadrature(radiationSource& radSrc, double freq, int radSecIdx);
+  void buildRadiationKernel(const vector<Point_3>& queryPt, double freq,
+    radiationKernel& kernel);
+  void RayleighSommerfeldIntegral(const vector<Point_3>& points,
+    Eigen::VectorXcd& radPress, const radiationSource& radSrc);
   void setAcousticFieldFreq(double freq) {m_simuParams.freqField = freq;}
   complex<double> acousticField(Point_3 queryPt);
+  complex<double> acousticField(Point_3 queryPt, double freq);
   bool findSegmentContainingPoint(Point queryPt, int &idxSeg);
   Eigen::VectorXcd acousticField(vector<Point_3> queryPt);
+  Eigen::VectorXcd acousticField(vector<Point_3> queryPt, double freq);
+  Eigen::VectorXcd acousticField(const vector<Point_3>& queryPt, double freq,
+    radiationSource& radSrc);
+  Eigen::VectorXcd acousticField(const vector<Point_3>& queryPt, 
+    const radiationKernel& kernel);
+  // basis of the field on the grid of the bounding box (prepared by 
+  // prepareAcousticFieldComputation) or at any points, and field computed 
+  // from it
+  void buildFieldBasis(fieldBasis& basis);
+  void buildFieldBasis(const vector<Point_3>& queryPts, fieldBasis& basis);
+  Eigen::VectorXcd acousticField(const fieldBasis& basis, double freq,
+    radiationSource& radSrc);
   void prepareAcousticFieldComputation();
   void acousticFieldInLine(int idxLine);
   void acousticFieldInPlane();
+  bool acousticFieldInPlane(const progressCallback& progress);
+  bool acousticFieldInPlaneProgressive(radiationSource& radSrc, 
+    const progressCallback& progress);
   void precomputationsForTf();
+  // worker of the distributed frequency sweep (false if its geometry or its
+  // parameters differ from the ones of the root)
+  bool computeTransferFunctionBlocks(VocalTract* tract);
+  // checkpoint of the frequency sweep in the cache directory (to start after
+  // precomputationsForTf and the computation of the modes): the rows of the 
+  // last checkpoint are restored if resume is true, returns their number
+  int startTfCheckpoint(bool resume);
+  bool isTfRowComputed(int idx) const
+    { return (idx < m_tfRowComputed.size()) && m_tfRowComputed[idx]; }
+  // mark a frequency as computed, the checkpoint is written if the last one
+  // is older than TF_CHECKPOINT_INTERVAL
+  void setTfRowComputed(int idx);
+  void stopTfCheckpoint();
+  void computeModesJunctionsAndRadiation(bool precomputeRadImped);
+  bool computeModesJunctionsAndRadiation(bool precomputeRadImped,
+    const progressCallback& progress);
+  void computeIntegrationSteps();
+  // write the memory of the data of the simulation and of the process in 
+  // the log and record their peaks in the profiler
+  void logMemoryFootprint(const string& stage);
+  // costs of the segments recorded in the profiler
+  vector<segmentCost> segmentCosts() const;
   void solveWaveProblem(VocalTract* tract, double freq, bool precomputeRadImped,
     std::chrono::duration<double>& time, std::chrono::duration<double> *timeExp);
   void solveWaveProblem(VocalTract* tract, double freq,
     std::chrono::duration<double>& time, std::chrono::duration<double>* timeExp);
   void solveWaveProblemNoiseSrc(bool &needToExtractMatrixF, Matrix& F, double freq,
     std::chrono::duration<double>* time);
+  void solveWaveProblemNoiseSrc(const vector<int>& idxSecSources, double freq,
+    const radiationKernel& kernel, Eigen::MatrixXcd& tf, 
+    std::chrono::duration<double>* time, 
+    vector<Eigen::VectorXcd>* exitVelocities = NULL);
+  void solveWaveProblemNoiseSrc(const vector<int>& idxSecSources, 
+    const vector<enum openEndBoundaryCond>& glottisConds, double freq,
+    const radiationKernel& kernel, vector<Eigen::MatrixXcd>& tfs, 
+    std::chrono::duration<double>* time, 
+    vector<Eigen::VectorXcd>* exitVelocities = NULL);
   void computeGlottalTf(int idxFreq, double freq);
+  // add a frequency restored from the checkpoint as computeGlottalTf does
+  // (false if it is not in the checkpoint)
+  bool restoreTfFromCheckpoint(int idxFreq, double freq);
   void computeNoiseSrcTf(int idxFreq);
+  bool tfPointsRadiated();
+  // recompute the transfer functions at new radiated points from the exit
+  // velocities of the last sweep, without propagating again (false if the
+  // geometry or the parameters have changed since the sweep)
+  bool reEvaluateTransferFunctions();
   void generateSpectraForSynthesis(int tfIdx);
+  // impulse responses of the glottal and noise source transfer functions at
+  // all the transfer function points (the inverse FFTs of the spectra 
+  // generated for the synthesis), computed in parallel over the points, of 
+  // 2 ^ (spectrumLgthExponent - 1) samples (false without transfer functions)
+  bool computeImpulseResponses(vector<vector<double>>& glottalIR,
+    vector<vector<double>>& noiseIR);
   void computeTransferFunction(VocalTract* tract);
+  // transfer functions obtained otherwise (e.g. interpolated in a library,
+  // see TfLibrary.h), for a spectrum of the given length
+  bool setTransferFunctions(const vector<double>& freqs, 
+    const Eigen::MatrixXcd& glottalTF, const Eigen::MatrixXcd& noiseTF,
+    int spectrumLgthExponent);
+  double singlePrecisionDeviation(VocalTract* tract, int numFreqs);
   void computeAcousticField(VocalTract* tract);
+  // field on the grid of the bounding box at several frequencies, written 
+  // in a NPY file of freqs.size() * ny rows and nx columns
+  bool computeAcousticFieldSpectrum(VocalTract* tract, const vector<double>& freqs,
+    const string& fileName);
+  // field at the frequency freq on a regular grid of numPts[0] x numPts[1] x
+  // numPts[2] points of the box between the corners pMin and pMax, computed
+  // by slices of constant z and written in a NPY file of numPts[2] * 
+  // numPts[1] rows and numPts[0] columns (the row k * numPts[1] + j holds 
+  // the points of the indexes j along y and k along z)
+  bool computeAcousticFieldVolume(VocalTract* tract, double freq, Point_3 pMin,
+    Point_3 pMax, const array<int, 3>& numPts, const string& fileName);
   void coneConcatenationSimulation(string fileName);
   void runTest(enum testType tType, string fileName);
   void cleanAcousticField();
@@ -171,11 +454,33 @@ public:
   complex<double> interpolateTransferFunction(double freq, int idxPt, enum tfType type);
   void interpolateTransferFunction(vector<double> &freq, int idxPt, enum tfType type, 
     vector<complex<double>> &interpolatedValues);
+  // magnitude of a transfer function at the frequencies k * freqStep (NAN 
+  // outside of the frequencies computed), as interpolated above
+  void transferFunctionMagnitudes(int idxPt, enum tfType type,
+    vector<double> &magnitudes, double &freqStep);
   double interpolateAcousticField(Point querryPt);
   void interpolateAcousticField(Vec &coordX, Vec &coordY, Matrix &field);
   bool exportGeoInCsv(string fileName);
+  bool exportGeoInBinary(string fileName);
   bool exportTransferFucntions(string fileName, enum tfType type);
+  bool exportNoiseSourcesTransferFunctions(string fileName);
+  bool exportGlottisConditionsTransferFunctions(string fileName);
+  // stable pole-residue model of a computed transfer function, which can be
+  // realised as a cascade of second-order sections (see RationalFit.h)
+  bool fitTransferFunction(enum tfType type, int idxPt, int numPoles, int delay,
+    struct rationalModel& model);
+  bool exportRationalModel(string fileName, enum tfType type, int idxPt,
+    int numPoles, int delay);
+  // export the impulse responses above with one channel per point and 
+  // source (the glottal source at all the points, then the noise source), 
+  // either in a 16 bit wave file (.wav) normalised with a common gain, or in
+  // a binary file of interleaved 32 bit floats
+  bool exportImpulseResponses(string fileName);
   bool exportAcousticField(string fileName);
+  // binary VTK files of the meshes of the segments placed in 3D at their 
+  // entrance, with the modes at their vertices, and of the acoustic field
+  // if it is in memory, gathered in the collection fileName (.vtm)
+  bool exportVtk(string fileName);
 
 
 // **************************************************************************
@@ -186,6 +491,8 @@ public:
   enum contourInterpolationMethod contInterpMeth() const {return m_contInterpMeth;}
   bool isReloadGeometryRequested() const { return m_reloadGeometry; }
   bool isGeometryImported() const { return m_geometryImported; }
+  string logFile() const { return m_logFile; }
+  string cacheDirectory() const { return m_cacheDirectory; }
   int sectionNumber() const;
   double soundSpeed() const;
   bool viscoThermalLosses() const { return m_simuParams.viscoThermalLosses; }
@@ -197,6 +504,15 @@ public:
   int spectrumLgthExponent() const { return m_simuParams.spectrumLgthExponent; }
   int oldSpectrumLgthExponent() const { return m_oldSimuParams.spectrumLgthExponent; }
   int idxSecNoiseSource() const { return m_idxSecNoiseSource; }
+  const vector<int>& noiseSourceSections() const { return m_noiseSourceSections; }
+  const Eigen::MatrixXcd& noiseSourcesTf(int idx) const { return m_noiseSourcesTF[idx]; }
+  const vector<enum openEndBoundaryCond>& extraGlottisBoundaryConds() const 
+    { return m_extraGlottisBoundaryConds; }
+  // transfer function of the noise source idxSource (0 for the main one, 
+  // then the ones of m_noiseSourceSections) with the extra glottis boundary 
+  // condition idxCond
+  const Eigen::MatrixXcd& glottisCondTf(int idxCond, int idxSource) const 
+    { return m_glottisCondsTF[idxCond * (1 + m_noiseSourceSections.size()) + idxSource]; }
   pair<Point2D, Point2D> maxCSBoundingBox() const { return m_maxCSBoundingBox; }
   pair<Point2D, Point2D> bboxSagittalPlane() const 
   { 
@@ -221,6 +537,13 @@ public:
   int numFreqComputed() const { return m_numFreqComputed; }
   double freqSteps() const { return m_freqSteps; }
   double lastFreqComputed() const { return m_lastFreqComputed; }
+  const vector<double>& tfFreqs() const { return m_tfFreqs; }
+  const Eigen::MatrixXcd& glottalSourceTF() const { return m_glottalSourceTF; }
+  const Eigen::MatrixXcd& noiseSourceTF() const { return m_noiseSourceTF; }
+  const Eigen::MatrixXcd& planeModeInputImpedance() const { return m_planeModeInputImpedance; }
+  // acoustic field of the last computation (empty if it has only been
+  // written in the stream file)
+  const Eigen::MatrixXcd& fieldValues() const { return m_field; }
 
 // **************************************************************************
 /// Public data
@@ -238,6 +561,9 @@ private:
   static Acoustic3dSimulation *instance;
 
   vector<unique_ptr<CrossSection2d>> m_crossSections;
+  // spatial index of the segments in the sagittal plane, built on demand
+  SegmentGrid m_segmentGrid;
+  mutex m_segmentGridMutex;
 
   struct simulationParameters m_simuParams;
   struct simulationParameters m_oldSimuParams;
@@ -245,7 +571,17 @@ private:
   // simulation parameters
   bool m_geometryImported;
   bool m_reloadGeometry;
+  bool m_storeAxialProfile;
   string m_geometryFile;
+  unique_ptr<TriangleMesh> m_geometryMesh;
+  unique_ptr<struct geometryArrays> m_geometryArrays;
+  struct meshSlicingOptions m_meshSlicingOptions;
+  string m_logFile;
+  string m_cacheDirectory;
+  string m_tfStreamFile;
+  string m_fieldStreamFile;
+  bool m_resumeTf;
+  string m_distributedSweepDirectory;
   contourInterpolationMethod m_contInterpMeth;
   double m_meshDensity;
   // the number of frequencies is 2 ^ (spectrumLgthExponent - 1)
@@ -253,10 +589,17 @@ private:
   int m_numFreqPicture;
   double m_lastFreqComputed;
   int m_idxSecNoiseSource;
+  vector<int> m_noiseSourceSections;
   openEndBoundaryCond m_glottisBoundaryCond;
+  vector<enum openEndBoundaryCond> m_extraGlottisBoundaryConds;
   openEndBoundaryCond m_mouthBoundaryCond;
-  vector<vector<vector<vector<double>>>> m_radiationMatrixInterp;
+  // radiation impedance and admittance at m_radiationFreqs (entries of the 
+  // impedance followed by the entries of the admittance, column-major)
+  vector<Eigen::VectorXcd> m_radiationSamples;
   vector<double> m_radiationFreqs;
+  // coefficients of their cubic splines: the column 4 * f + k holds the 
+  // coefficients of degree k of the interval f for all the entries
+  Eigen::MatrixXcd m_radiationInterpCoefs;
   double m_freqSteps;
   int m_numFreqComputed;
   vector<double> m_tfFreqs;
@@ -278,12 +621,52 @@ private:
   // simulation outputs
   Eigen::MatrixXcd m_glottalSourceTF;
   Eigen::MatrixXcd m_noiseSourceTF;
+  // radiation kernel of the transfer function points for the last frequency
+  // computed with computeGlottalTf
+  radiationKernel m_tfKernel;
+  // transfer functions of the noise sources of m_noiseSourceSections
+  vector<Eigen::MatrixXcd> m_noiseSourcesTF;
+  // transfer functions of the main and additional noise sources for each
+  // condition of m_extraGlottisBoundaryConds (condition by condition)
+  vector<Eigen::MatrixXcd> m_glottisCondsTF;
+  // amplitudes of the velocity modes at the exit of the last segment for 
+  // each frequency computed by the sweep: the glottal source, the noise 
+  // source and the noise sources of m_noiseSourceSections, then the noise
+  // sources with each extra glottis boundary condition (empty if not
+  // computed), and the frequencies interpolated by the adaptive sweep
+  vector<vector<Eigen::VectorXcd>> m_exitVelocities;
+  vector<char> m_tfRowInterpolated;
+  // key of the sweep of the exit velocities without the points
+  CacheKey m_exitVelocitiesKey;
+  // blending band of the hybrid sweep (Hz): only the plane mode is coupled 
+  // below the first frequency, all the modes above the second one (0 if
+  // the hybrid sweep is not used)
+  double m_hybridBand[2];
   Eigen::MatrixXcd m_planeModeInputImpedance;
   Eigen::MatrixXcd m_field;
+  // incremented each time the field is modified
+  atomic<unsigned> m_fieldVersion;
+  struct fieldImagePyramid m_fieldPyramid;
+  // false if the last field computed has only been written in the stream 
+  // file because it exceeded the memory budget
+  bool m_fieldInMemory;
   double m_maxAmpField;
   double m_minAmpField;
   double m_maxPhaseField;
   double m_minPhaseField;
+  // protects the transfer functions and the acoustic field, which are read 
+  // by the GUI while they are computed in a worker thread
+  mutex m_resultsMutex;
+  NpyWriter m_tfStream;
+  NpyWriter m_fieldStream;
+  // checkpoint of the frequency sweep: frequencies whose transfer functions
+  // are computed (empty if no checkpoint is written)
+  string m_tfCheckpointFile;
+  vector<char> m_tfRowComputed;
+  mutex m_tfCheckpointMutex;
+  std::chrono::system_clock::time_point m_lastTfCheckpoint;
+  // work matrices of the junctions when no propagation workspace is bound
+  junctionWorkspace m_junctionWork;
 
 // **************************************************************************
 // Private functions.
@@ -291,7 +674,10 @@ private:
 
 private:
 
-  Acoustic3dSimulation();
+  // spectrum of 2 * m_numFreq samples of the transfer function of the point
+  // tfIdx, with the values of the negative frequencies mirrored
+  void mirroredSpectrum(const Eigen::MatrixXcd& tf, int tfIdx, ComplexSignal& s) const;
+
   Point ctrLinePtOut(Point ctrLinePtIn, Vector normalIn, double circleArcAngle, 
     double curvatureRadius, double length);
 
@@ -319,9 +705,86 @@ private:
   // for radiation impedance 
   void interpolateRadiationImpedance(Eigen::MatrixXcd& imped, double freq, int idxRadSec); 
   void interpolateRadiationAdmittance(Eigen::MatrixXcd& admit, double freq, int idxRadSec);
+  void interpolateRadiationMatrices(Eigen::MatrixXcd& imped, Eigen::MatrixXcd& admit,
+    double freq, int idxRadSec);
+  void interpolateRadiationEntries(double freq, int firstEntry, int numEntries,
+    Eigen::VectorXcd& values) const;
   void radiationImpedance(Eigen::MatrixXcd& imped, double freq, double gridDensity, int idxRadSec);
+  void radiationImpedance(vector<Eigen::MatrixXcd>& imped, const vector<double>& freqs,
+    double gridDensity, int idxRadSec);
+  void radiationImpedanceFFT(vector<Eigen::MatrixXcd>& imped,
+    const vector<double>& freqs, double gridDensity, int idxRadSec);
+  void setRadMatToInterpolate(const map<double, Eigen::MatrixXcd>& radImped, int idxRadSec);
+  CacheKey radiationCacheKey(int nbRadFreqs, int idxRadSec) const;
   void getRadiationImpedanceAdmittance(Eigen::MatrixXcd& imped, Eigen::MatrixXcd& admit, 
     double freq, int idxRadSec);
+
+  void computeMeshAndModes(int segIdx, ostream& log, int guessIdx = -1);
+  double meshSpacing(int segIdx) const;
+  void findScaledContours(vector<int>& reference, vector<double>& scaling);
+  void findModesGuesses(const vector<int>& reference, vector<int>& guessIdx) const;
+  void scaleMeshAndModes(int segIdx, int refIdx, double scaling, ostream& log);
+  CacheKey junctionCacheKey(int segIdx) const;
+  void reuseUnchangedCrossSections(
+    const vector<unique_ptr<CrossSection2d>>& oldCrossSections);
+  void rescaleModesSoundSpeed(double sndSpeed);
+  const SegmentGrid& segmentGrid();
+  bool isRadiatedPoint(Point_3 queryPt, Point_3& radPt);
+  complex<double> interiorAcousticField(Point_3 queryPt);
+  void clearSegmentGrid();
+  void updateFieldImagePyramid();
+
+  // for the parallel frequency sweep
+  // parallel sweep engine of the frequency loops
+  void parallelSweep(int numTasks, int numThreads, const function<void(int, int)>& task);
+  int sweepThreads(int numTasks) const;
+  void setHybridBand(ostream& log);
+  double hybridWeight(double freq) const;
+  void computeTfAtFrequency(VocalTract* tract, int i, radiationKernel& kernel,
+    vector<Eigen::MatrixXcd>& noiseTfs, ostream& log, mutex& logMutex,
+    std::chrono::duration<double>& timePropa, std::chrono::duration<double>& timeComputeField,
+    std::chrono::duration<double>& timeExp);
+  void computeTfAtFrequencies(VocalTract* tract, const vector<int>& idxFreqs,
+    ostream& log, std::chrono::duration<double>& timePropa, 
+    std::chrono::duration<double>& timeComputeField, std::chrono::duration<double>& timeExp);
+  // for the adaptive frequency sweep
+  int adaptiveFrequencySweep(VocalTract* tract, ostream& log,
+    std::chrono::duration<double>& timePropa, std::chrono::duration<double>& timeComputeField,
+    std::chrono::duration<double>& timeExp);
+  double tfInterpolationError(const vector<bool>& computed, int idxStart, int idxEnd);
+  void interpolateTfRows(int idxStart, int idxEnd);
+  bool openTfStream();
+  void streamTfRow(int idx);
+  CacheKey tfCheckpointKey(bool withTfPoints = true) const;
+  bool writeTfRows(const string& fileName, const vector<int>& rows);
+  bool readTfRows(const string& fileName, vector<int>& rows);
+  bool writeTfCheckpoint();
+  bool readTfCheckpoint();
+  // for the distributed frequency sweep
+  string frequencyBlockFile(const CacheKey& key, int block, bool claim) const;
+  void computeFrequencyBlock(VocalTract* tract, const CacheKey& key, int block,
+    ostream& log, std::chrono::duration<double>& timePropa, 
+    std::chrono::duration<double>& timeComputeField, std::chrono::duration<double>& timeExp);
+  void distributedFrequencySweep(VocalTract* tract, ostream& log,
+    std::chrono::duration<double>& timePropa, std::chrono::duration<double>& timeComputeField,
+    std::chrono::duration<double>& timeExp);
+  void propagateBranchGroup(const vector<Eigen::MatrixXcd>& Q0, double freq,
+    const vector<int>& group, int idxGroup, bool isStartGroup, double direction,
+    ostream& log);
+  void radiationQuadraturePoints(double freq, int radSecIdx, vector<Point>& intPts,
+    vector<double>& weights, double& pointScaling, double& waveNumber);
+  // for the noise sources
+  void glottisImpedanceAdmittance(Eigen::MatrixXcd& imped, Eigen::MatrixXcd& admit,
+    double freq);
+  void glottisImpedanceAdmittance(enum openEndBoundaryCond cond, 
+    Eigen::MatrixXcd& imped, Eigen::MatrixXcd& admit, double freq);
+  bool isExpansionAtExit(int idxSec);
+  const Eigen::MatrixXcd& noiseSourceDownStreamImpAdm(int idxSec);
+  // work matrices of the junctions of the calling thread
+  junctionWorkspace& junctionWork();
+  void propagateNoiseSource(int idxSec, const Matrix& F,
+    const Eigen::MatrixXcd& downStreamImpAdm, double freq, 
+    std::chrono::duration<double>* time);
 };
 
 #endif
@@ -0,0 +1,237 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#include "BatchSimulation.h"
+#include "Logger.h"
+#include <set>
+#include <chrono>
+#include <algorithm>
+
+// ****************************************************************************
+// Name of a file without its directory and its extension
+
+static string fileStem(const string& fileName)
+{
+  size_t start(fileName.find_last_of("/\\"));
+  start = (start == string::npos) ? 0 : start + 1;
+  size_t end(fileName.find_last_of('.'));
+  if ((end == string::npos) || (end < start)) { end = fileName.size(); }
+  return fileName.substr(start, end - start);
+}
+
+// ****************************************************************************
+// Log file of the simulation writing a NPY file: the concurrent simulations
+// each have their own log, next to their transfer functions
+
+static string batchLogFileName(const string& tfFile)
+{
+  size_t end(tfFile.find_last_of('.'));
+  return tfFile.substr(0, end) + ".log";
+}
+
+// ****************************************************************************
+
+bool importGeometryFile(Acoustic3dSimulation& simu, const string& geometryFile)
+{
+  simu.requestReloadGeometry();
+  simu.setGeometryImported(true);
+  simu.setContourInterpolationMethod(FROM_FILE);
+  simu.setGeometryFile(geometryFile);
+  return simu.importGeometry(NULL) && (simu.numberOfSegments() > 0);
+}
+
+// ****************************************************************************
+
+vector<string> batchTfFileNames(const vector<string>& geometryFiles,
+  const string& outputDirectory)
+{
+  vector<string> names;
+  set<string> usedNames;
+  string directory(outputDirectory);
+
+  if ((directory != "") && (directory.back() != '/') && (directory.back() != '\\'))
+  {
+    directory += "/";
+  }
+
+  for (int i(0); i < geometryFiles.size(); i++)
+  {
+    string name(fileStem(geometryFiles[i]));
+    if (usedNames.count(name) > 0) { name += "_" + to_string(i); }
+    usedNames.insert(name);
+    names.push_back(directory + name + ".npy");
+  }
+
+  return names;
+}
+
+// ****************************************************************************
+
+vector<struct batchResult> computeBatchTransferFunctions(
+  const vector<string>& geometryFiles, const struct simulationSetup& setup,
+  const string& outputDirectory, const string& cacheDirectory,
+  int numConcurrent, const progressCallback& progress)
+{
+  int numGeo(geometryFiles.size());
+  vector<string> tfFiles(batchTfFileNames(geometryFiles, outputDirectory));
+  vector<struct batchResult> results(numGeo);
+
+  numConcurrent = max(1, min(numConcurrent, numGeo));
+
+  // the threads of the setup are shared by the concurrent simulations
+  struct simulationSetup geoSetup(setup);
+  geoSetup.simuParams.numThreads = max(1, setup.simuParams.numThreads / numConcurrent);
+
+  LogStream log;
+  log << "Batch of " << numGeo << " geometries, " << numConcurrent 
+    << " concurrent simulation(s) on " << geoSetup.simuParams.numThreads 
+    << " thread(s) each" << endl;
+  log.close();
+
+  for (int i(0); i < numGeo; i++)
+  {
+    results[i].geometryFile = geometryFiles[i];
+    results[i].tfFile = tfFiles[i];
+    results[i].success = false;
+    results[i].time = 0.;
+  }
+
+  parallelLoop(numGeo, numConcurrent, [&](int i)
+    {
+      auto start = chrono::steady_clock::now();
+      LogStream geoLog;
+
+      Acoustic3dSimulation simu;
+      simu.setCacheDirectory(cacheDirectory);
+      simu.setTfStreamFile(tfFiles[i]);
+      simu.setLogFile(batchLogFileName(tfFiles[i]));
+      applySimulationSetup(simu, geoSetup);
+
+      if (!importGeometryFile(simu, geometryFiles[i]))
+      {
+        geoLog << "Batch: cannot import the geometry " << geometryFiles[i] << endl;
+        geoLog.close();
+        return;
+      }
+
+      simu.computeTransferFunction(NULL);
+
+      results[i].success = true;
+      results[i].time = chrono::duration<double>(
+        chrono::steady_clock::now() - start).count();
+      geoLog << "Batch: transfer functions of " << geometryFiles[i] 
+        << " written in " << tfFiles[i] << ", time: " << results[i].time 
+        << " s" << endl;
+      geoLog.close();
+    }, progress);
+
+  // the radiation modes are only shared by the geometries of the batch
+  CrossSection2dRadiation::clearMemoisedModes();
+
+  return results;
+}
+
+// ****************************************************************************
+
+vector<struct batchResult> computeParameterVariantsTransferFunctions(
+  const string& geometryFile, const struct simulationSetup& setup,
+  const vector<struct simulationSetup>& variants, const vector<string>& variantNames,
+  const string& outputDirectory, const string& cacheDirectory,
+  int numConcurrent, const progressCallback& progress)
+{
+  int numVar(variants.size());
+  vector<string> tfFiles(batchTfFileNames(variantNames, outputDirectory));
+  vector<struct batchResult> results(numVar);
+
+  numConcurrent = max(1, min(numConcurrent, numVar));
+
+  for (int i(0); i < numVar; i++)
+  {
+    results[i].geometryFile = variantNames[i];
+    results[i].tfFile = tfFiles[i];
+    results[i].success = false;
+    results[i].time = 0.;
+  }
+
+  // the modes and the junction matrices shared by the variants are computed
+  // with all the threads of the setup
+  Acoustic3dSimulation reference;
+  reference.setCacheDirectory(cacheDirectory);
+  applySimulationSetup(reference, setup);
+  if (!importGeometryFile(reference, geometryFile))
+  {
+    LogStream log;
+    log << "Variants: cannot import the geometry " << geometryFile << endl;
+    log.close();
+    return results;
+  }
+  reference.computeModesJunctionsAndRadiation(false);
+
+  // the threads are then shared by the concurrent simulations
+  struct simulationSetup varSetup(setup);
+  varSetup.simuParams.numThreads = max(1, setup.simuParams.numThreads / numConcurrent);
+
+  LogStream log;
+  log << numVar << " parameter variants of " << geometryFile << ", " 
+    << numConcurrent << " concurrent simulation(s) on " 
+    << varSetup.simuParams.numThreads << " thread(s) each" << endl;
+  log.close();
+
+  parallelLoop(numVar, numConcurrent, [&](int i)
+    {
+      auto start = chrono::steady_clock::now();
+      LogStream varLog;
+
+      Acoustic3dSimulation simu;
+      simu.setCacheDirectory(cacheDirectory);
+      simu.setTfStreamFile(tfFiles[i]);
+      simu.setLogFile(batchLogFileName(tfFiles[i]));
+      applySimulationSetup(simu, varSetup);
+      if (!importGeometryFile(simu, geometryFile))
+      {
+        varLog << "Variants: cannot import the geometry " << geometryFile << endl;
+        varLog.close();
+        return;
+      }
+
+      // the parameters of the variant are set once the modes of the base 
+      // setup are copied, so that they are only recomputed if the variant
+      // changes the parameters of the modes
+      simu.copyModesAndJunctions(reference);
+      struct simulationSetup variant(variants[i]);
+      variant.simuParams.numThreads = varSetup.simuParams.numThreads;
+      applySimulationSetup(simu, variant);
+
+      simu.computeTransferFunction(NULL);
+
+      results[i].success = true;
+      results[i].time = chrono::duration<double>(
+        chrono::steady_clock::now() - start).count();
+      varLog << "Variants: transfer functions of " << variantNames[i]
+        << " written in " << tfFiles[i] << ", time: " << results[i].time
+        << " s" << endl;
+      varLog.close();
+    }, progress);
+
+  CrossSection2dRadiation::clearMemoisedModes();
+
+  return results;
+}
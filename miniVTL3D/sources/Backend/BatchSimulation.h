@@ -0,0 +1,91 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#ifndef __BATCH_SIMULATION_H__
+#define __BATCH_SIMULATION_H__
+
+#include "SimulationParametersFile.h"
+#include "ParallelLoop.h"
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// ****************************************************************************
+// Computation of the transfer functions of a list of geometry files (csv or
+// binary) with the same simulation setup, for the generation of datasets.
+// The geometries are distributed over numConcurrent simulations running in 
+// parallel, each using a share of the threads of the setup. The modes, 
+// junction matrices and radiation impedances are shared through the cache 
+// directory, so that the radiation impedance is computed only once for the 
+// geometries with the same exit contour. The transfer functions of each 
+// geometry are written in a NPY file of the output directory while they are 
+// computed (see Acoustic3dSimulation::setTfStreamFile). The log of the 
+// simulation of each geometry is written next to its NPY file with the 
+// extension .log, the progress of the batch in the log file of the program.
+// ****************************************************************************
+
+// import a geometry file in a simulation (the vocal tract is not used for an
+// imported geometry), false if it has no segment
+bool importGeometryFile(Acoustic3dSimulation& simu, const string& geometryFile);
+
+struct batchResult
+{
+  string geometryFile;
+  string tfFile;        // NPY file of the transfer functions
+  bool success;
+  double time;          // computation time (s)
+};
+
+// NPY file of the transfer functions of each geometry in the output 
+// directory, named after the geometry file (suffixed with the index of the 
+// geometry if several geometry files have the same name)
+vector<string> batchTfFileNames(const vector<string>& geometryFiles,
+  const string& outputDirectory);
+
+// the progress callback receives the number of geometries computed, 
+// returning false cancels the geometries which are not started
+vector<struct batchResult> computeBatchTransferFunctions(
+  const vector<string>& geometryFiles, const struct simulationSetup& setup,
+  const string& outputDirectory, const string& cacheDirectory, 
+  int numConcurrent, const progressCallback& progress = progressCallback());
+
+// ****************************************************************************
+// Computation of the transfer functions of one geometry for several variants
+// of the setup differing by the physical parameters which do not change the 
+// modes (losses, wall admittance, temperature, boundary conditions), e.g. for 
+// Monte-Carlo studies. The modes and the junction matrices are computed once
+// with the base setup and copied to the simulations of the variants, which 
+// run in parallel like the geometries of a batch. The modes are rescaled for 
+// the variants with another sound speed (see 
+// Acoustic3dSimulation::setSimulationParameters). The transfer functions of 
+// each variant are written in the NPY file named after the variant name in 
+// the output directory (batchResult::geometryFile is the variant name), and 
+// their logs in the files with the extension .log.
+// ****************************************************************************
+
+vector<struct batchResult> computeParameterVariantsTransferFunctions(
+  const string& geometryFile, const struct simulationSetup& setup,
+  const vector<struct simulationSetup>& variants, const vector<string>& variantNames,
+  const string& outputDirectory, const string& cacheDirectory, 
+  int numConcurrent, const progressCallback& progress = progressCallback());
+
+#endif
@@ -53,5 +53,42 @@ const double SYNTHETIC_SPEECH_BANDWIDTH_HZ = 12000.0;
 const double MINIMAL_DISTANCE = 1e-14;
 const double MINIMAL_DISTANCE_DIFF_POLYGONS = 1.e-4;
 
+// ****************************************************************************
+// Constants for the radiation impedance precomputation
+// ****************************************************************************
+
+const double RADIATION_GRID_DENSITY = 15.;
+// maximal relative error of the interpolation of the radiation impedance
+// between two frequencies, else a frequency is added between them
+const double RADIATION_INTERPOLATION_TOLERANCE = 1.e-2;
+// maximal number of refinements of the initial frequency intervals
+const int RADIATION_MAX_REFINEMENTS = 3;
+
+// ****************************************************************************
+// Constants for the checkpoints of the frequency sweep
+// ****************************************************************************
+
+// minimal time (s) between two checkpoints of the transfer functions
+const double TF_CHECKPOINT_INTERVAL = 60.;
+
+// ****************************************************************************
+// Constants for the distributed frequency sweep
+// ****************************************************************************
+
+// number of frequencies of the blocks handed out to the processes
+const int DISTRIBUTED_SWEEP_BLOCK_SIZE = 32;
+// time (s) between two checks of the files written by the other processes
+const double DISTRIBUTED_SWEEP_POLL_INTERVAL = 1.;
+// time (s) without any block written after which the root computes the
+// blocks claimed by processes which did not write them
+const double DISTRIBUTED_SWEEP_TIMEOUT = 3600.;
+
+// ****************************************************************************
+// Constants for the acoustic field in a volume
+// ****************************************************************************
+
+// maximal number of points whose field basis is kept in memory at once
+const int FIELD_VOLUME_CHUNK_SIZE = 65536;
+
 #endif
 
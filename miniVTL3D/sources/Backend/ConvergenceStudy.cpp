@@ -0,0 +1,393 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#include "ConvergenceStudy.h"
+#include "BatchSimulation.h"
+#include "RationalFit.h"
+#include "Constants.h"
+#include "Logger.h"
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <iomanip>
+
+// poles of the rational model whose bandwidth is larger are not formants
+static const double MAX_FORMANT_BANDWIDTH = 1000.;
+// coarsest values of the settings
+static const double MIN_STUDY_MESH_DENSITY = 1.;
+static const double MIN_STUDY_RAD_GRID_DENSITY = 1.;
+static const int NUM_STUDY_SETTINGS = 5;
+// settings of the preview
+static const double PREVIEW_MESH_DENSITY = 3.;
+static const double PREVIEW_MAX_CUT_ON_FREQ = 3000.;
+static const double PREVIEW_RAD_GRID_DENSITY = 2.;
+static const int PREVIEW_MIN_SPECTRUM_LGTH_EXPONENT = 8;
+
+// ****************************************************************************
+
+struct convergenceStudyParameters defaultConvergenceStudyParameters(
+  const struct simulationSetup& setup)
+{
+  struct convergenceStudyParameters params;
+  params.maxFreq = min(5000., setup.simuParams.maxComputedFreq);
+  // frequency step of about 43 Hz
+  params.spectrumLgthExponent = 10;
+  params.numFormants = 4;
+  params.numLevels = 3;
+  params.formantTolerance = 1.;
+  params.bandwidthTolerance = 5.;
+  params.magnitudeTolerance = 1.;
+  return params;
+}
+
+// ****************************************************************************
+
+struct solverSettings getSolverSettings(const struct simulationSetup& setup)
+{
+  struct solverSettings settings;
+  settings.meshDensity = setup.meshDensity;
+  settings.maxCutOnFreq = setup.simuParams.maxCutOnFreq;
+  settings.numIntegrationStep = setup.simuParams.numIntegrationStep;
+  settings.orderMagnusScheme = setup.simuParams.orderMagnusScheme;
+  settings.radImpedGridDensity = setup.simuParams.radImpedGridDensity;
+  return settings;
+}
+
+// ****************************************************************************
+
+void setSolverSettings(struct simulationSetup& setup,
+  const struct solverSettings& settings)
+{
+  setup.meshDensity = settings.meshDensity;
+  setup.simuParams.maxCutOnFreq = settings.maxCutOnFreq;
+  setup.simuParams.numIntegrationStep = settings.numIntegrationStep;
+  setup.simuParams.orderMagnusScheme = settings.orderMagnusScheme;
+  setup.simuParams.radImpedGridDensity = settings.radImpedGridDensity;
+}
+
+// ****************************************************************************
+
+struct simulationSetup previewSimulationSetup(const struct simulationSetup& setup)
+{
+  struct simulationSetup preview(setup);
+  struct simulationParameters& p(preview.simuParams);
+
+  preview.meshDensity = min(setup.meshDensity, PREVIEW_MESH_DENSITY);
+  p.adaptiveMeshDensity = false;
+  p.maxCutOnFreq = min(p.maxCutOnFreq, PREVIEW_MAX_CUT_ON_FREQ);
+  p.propMethod = STRAIGHT_TUBES;
+  p.radImpedGridDensity = min(p.radImpedGridDensity, PREVIEW_RAD_GRID_DENSITY);
+  p.radImpedPrecomputed = false;
+  p.needToComputeModesAndJunctions = true;
+  p.spectrumLgthExponent = min(p.spectrumLgthExponent, 
+    max(PREVIEW_MIN_SPECTRUM_LGTH_EXPONENT, p.spectrumLgthExponent - 2));
+  p.adaptiveFreqSampling = false;
+  return preview;
+}
+
+// ****************************************************************************
+// Divide the setting idxSetting by 2 (the order of the Magnus scheme goes 
+// from 4 to 2), false if it cannot be coarsened further
+
+static bool coarsenSetting(struct solverSettings& settings, int idxSetting,
+  double minCutOnFreq)
+{
+  switch (idxSetting)
+  {
+  case 0:
+    if (settings.meshDensity / 2. < MIN_STUDY_MESH_DENSITY) { return false; }
+    settings.meshDensity /= 2.;
+    return true;
+  case 1:
+    if (settings.maxCutOnFreq / 2. < minCutOnFreq) { return false; }
+    settings.maxCutOnFreq /= 2.;
+    return true;
+  case 2:
+    if (settings.numIntegrationStep < 2) { return false; }
+    settings.numIntegrationStep /= 2;
+    return true;
+  case 3:
+    if (settings.orderMagnusScheme != 4) { return false; }
+    settings.orderMagnusScheme = 2;
+    return true;
+  default:
+    if (settings.radImpedGridDensity / 2. < MIN_STUDY_RAD_GRID_DENSITY) { return false; }
+    settings.radImpedGridDensity /= 2.;
+    return true;
+  }
+}
+
+// ****************************************************************************
+// Compute the transfer function of the probe band with the settings of the
+// run, its formants and the times of the computation
+
+static bool computeStudyRun(const string& geometryFile,
+  const struct simulationSetup& probeSetup, const struct convergenceStudyParameters& params,
+  int numSweepFreqs, struct convergenceRun& run, vector<double>& freqs)
+{
+  struct simulationSetup runSetup(probeSetup);
+  setSolverSettings(runSetup, run.settings);
+
+  run.success = false;
+  run.withinTolerance = false;
+  run.formants.clear();
+  run.bandwidths.clear();
+  run.magnitudes.clear();
+
+  Acoustic3dSimulation simu;
+  applySimulationSetup(simu, runSetup);
+  if (!importGeometryFile(simu, geometryFile)) { return false; }
+
+  auto start = chrono::steady_clock::now();
+  simu.computeModesJunctionsAndRadiation(true);
+  auto startSweep = chrono::steady_clock::now();
+  simu.computeTransferFunction(NULL);
+  auto end = chrono::steady_clock::now();
+
+  freqs = simu.tfFreqs();
+  const Eigen::MatrixXcd& tf(simu.glottalSourceTF());
+  if (freqs.empty() || (tf.cols() == 0)) { return false; }
+
+  run.modesTime = chrono::duration<double>(startSweep - start).count();
+  run.freqTime = chrono::duration<double>(end - startSweep).count() / freqs.size();
+  run.predictedSweepTime = run.modesTime + run.freqTime * numSweepFreqs;
+
+  run.magnitudes.resize(freqs.size());
+  for (int i(0); i < freqs.size(); i++)
+  {
+    run.magnitudes[i] = 20. * log10(abs(tf(i, 0)));
+  }
+
+  // the propagation delay to the transfer function point is not fitted
+  const Point_3& pt(runSetup.simuParams.tfPoint[0]);
+  double distance(sqrt(pow(pt.x(), 2) + pow(pt.y(), 2) + pow(pt.z(), 2)));
+  int delay((int)round(distance / runSetup.simuParams.sndSpeed * SAMPLING_RATE));
+
+  struct rationalModel model;
+  if (!simu.fitTransferFunction(GLOTTAL, 0, 2 * (params.numFormants + 2), 
+    delay, model))
+  {
+    return false;
+  }
+
+  vector<pair<double, double>> formants;
+  for (auto& pole : model.complexPoles)
+  {
+    double freq(arg(pole) * SAMPLING_RATE / 2. / M_PI);
+    double bandwidth(-log(abs(pole)) * SAMPLING_RATE / M_PI);
+    if ((freq > 0.) && (freq < params.maxFreq) && (bandwidth < MAX_FORMANT_BANDWIDTH))
+    {
+      formants.push_back(make_pair(freq, bandwidth));
+    }
+  }
+  sort(formants.begin(), formants.end());
+  for (int i(0); i < min((int)formants.size(), params.numFormants); i++)
+  {
+    run.formants.push_back(formants[i].first);
+    run.bandwidths.push_back(formants[i].second);
+  }
+
+  run.success = true;
+  return true;
+}
+
+// ****************************************************************************
+// Deviations of a run from the reference (infinite if a formant of the 
+// reference is missing)
+
+static void setDeviations(struct convergenceRun& run, 
+  const struct convergenceRun& reference, const struct convergenceStudyParameters& params)
+{
+  run.formantDeviation = 0.;
+  run.bandwidthDeviation = 0.;
+  run.magnitudeDeviation = 0.;
+
+  if (!run.success || (run.formants.size() < reference.formants.size()) ||
+    (run.magnitudes.size() != reference.magnitudes.size()))
+  {
+    run.formantDeviation = INFINITY;
+    run.bandwidthDeviation = INFINITY;
+    run.magnitudeDeviation = INFINITY;
+    run.withinTolerance = false;
+    return;
+  }
+
+  for (int i(0); i < reference.formants.size(); i++)
+  {
+    run.formantDeviation = max(run.formantDeviation, 100. * 
+      abs(run.formants[i] - reference.formants[i]) / reference.formants[i]);
+    run.bandwidthDeviation = max(run.bandwidthDeviation, 100. *
+      abs(run.bandwidths[i] - reference.bandwidths[i]) / reference.bandwidths[i]);
+  }
+
+  for (int i(0); i < reference.magnitudes.size(); i++)
+  {
+    run.magnitudeDeviation += pow(run.magnitudes[i] - reference.magnitudes[i], 2);
+  }
+  run.magnitudeDeviation = sqrt(run.magnitudeDeviation / reference.magnitudes.size());
+
+  run.withinTolerance = (run.formantDeviation <= params.formantTolerance) &&
+    (run.bandwidthDeviation <= params.bandwidthTolerance) &&
+    (run.magnitudeDeviation <= params.magnitudeTolerance);
+}
+
+// ****************************************************************************
+
+bool computeConvergenceStudy(const string& geometryFile,
+  const struct simulationSetup& setup, const struct convergenceStudyParameters& params,
+  struct convergenceStudy& study, const progressCallback& progress)
+{
+  study.freqs.clear();
+  study.runs.clear();
+  study.recommended = -1;
+
+  // the probe band is computed at all its frequencies, so that the runs
+  // are compared at the same frequencies
+  struct simulationSetup probeSetup(setup);
+  probeSetup.simuParams.maxComputedFreq = params.maxFreq;
+  probeSetup.simuParams.spectrumLgthExponent = params.spectrumLgthExponent;
+  probeSetup.simuParams.adaptiveFreqSampling = false;
+
+  double sweepFreqStep((double)SAMPLING_RATE / 2. / 
+    (double)(1 << (setup.simuParams.spectrumLgthExponent - 1)));
+  int numSweepFreqs((int)ceil(setup.simuParams.maxComputedFreq / sweepFreqStep));
+  // the order of the Magnus scheme has only one coarser level
+  int maxRuns(1 + (NUM_STUDY_SETTINGS - 1) * max(0, params.numLevels - 1) + 1);
+
+  LogStream log;
+  log << "Convergence study of " << geometryFile << ", probe band 0 - " 
+    << params.maxFreq << " Hz" << endl;
+  log.close();
+
+  struct convergenceRun reference;
+  reference.settings = getSolverSettings(setup);
+  if (!computeStudyRun(geometryFile, probeSetup, params, numSweepFreqs, 
+    reference, study.freqs) || reference.formants.empty())
+  {
+    log << "Convergence study: the reference could not be computed" << endl;
+    log.close();
+    return false;
+  }
+  setDeviations(reference, reference, params);
+  study.runs.push_back(reference);
+  study.recommended = 0;
+  if (progress && !progress(study.runs.size(), maxRuns)) { return true; }
+
+  // each setting is coarsened while the run stays within the tolerance,
+  // starting from the coarsest accepted values of the previous settings
+  struct solverSettings accepted(reference.settings);
+  for (int s(0); s < NUM_STUDY_SETTINGS; s++)
+  {
+    for (int level(1); level < params.numLevels; level++)
+    {
+      struct convergenceRun run;
+      run.settings = accepted;
+      if (!coarsenSetting(run.settings, s, setup.simuParams.maxComputedFreq)) { break; }
+
+      vector<double> freqs;
+      computeStudyRun(geometryFile, probeSetup, params, numSweepFreqs, run, freqs);
+      setDeviations(run, reference, params);
+      study.runs.push_back(run);
+
+        log << "Convergence study run " << study.runs.size() - 1 << ": formants " 
+        << run.formantDeviation << " %, bandwidths " << run.bandwidthDeviation 
+        << " %, magnitude " << run.magnitudeDeviation << " dB" 
+        << (run.withinTolerance ? " (accepted)" : "") << endl;
+      log.close();
+
+      if (run.withinTolerance)
+      {
+        accepted = run.settings;
+        study.recommended = study.runs.size() - 1;
+      }
+      if (progress && !progress(study.runs.size(), maxRuns)) { return true; }
+      if (!run.withinTolerance) { break; }
+    }
+  }
+
+  return true;
+}
+
+// ****************************************************************************
+
+void writeConvergenceStudy(ostream& os, const struct convergenceStudy& study,
+  const struct convergenceStudyParameters& params)
+{
+  os << "Probe band: 0 - " << params.maxFreq << " Hz, " << study.freqs.size()
+    << " frequencies" << endl;
+  os << "Tolerance: formants " << params.formantTolerance << " %, bandwidths "
+    << params.bandwidthTolerance << " %, magnitude " << params.magnitudeTolerance
+    << " dB" << endl;
+  if (!study.runs.empty())
+  {
+    os << "Reference formants (Hz):";
+    for (int i(0); i < study.runs[0].formants.size(); i++)
+    {
+      os << " " << round(study.runs[0].formants[i]) << " (" 
+        << round(study.runs[0].bandwidths[i]) << ")";
+    }
+    os << endl;
+  }
+  os << endl;
+
+  os << "run  meshDensity  maxCutOnFreq  numIntegrationStep  orderMagnusScheme"
+    << "  radImpedGridDensity  formants(%)  bandwidths(%)  magnitude(dB)"
+    << "  modes(s)  frequency(s)  sweep(s)" << endl;
+  for (int i(0); i < study.runs.size(); i++)
+  {
+    const struct convergenceRun& run(study.runs[i]);
+    os << setw(3) << i << (i == study.recommended ? "*" : " ")
+      << setw(12) << run.settings.meshDensity
+      << setw(14) << run.settings.maxCutOnFreq
+      << setw(20) << run.settings.numIntegrationStep
+      << setw(19) << run.settings.orderMagnusScheme
+      << setw(21) << run.settings.radImpedGridDensity;
+    if (run.success)
+    {
+      os << setw(13) << setprecision(3) << run.formantDeviation
+        << setw(15) << run.bandwidthDeviation
+        << setw(15) << run.magnitudeDeviation
+        << setw(10) << run.modesTime
+        << setw(14) << run.freqTime
+        << setw(10) << run.predictedSweepTime << setprecision(6);
+    }
+    else
+    {
+      os << "  failed";
+    }
+    os << endl;
+  }
+  os << endl;
+
+  if (study.recommended < 0)
+  {
+    os << "No recommendation: the reference could not be computed" << endl;
+    return;
+  }
+  const struct convergenceRun& best(study.runs[study.recommended]);
+  os << "Recommended (run " << study.recommended << "): meshDensity = "
+    << best.settings.meshDensity << ", maxCutOnFreq = " << best.settings.maxCutOnFreq
+    << ", numIntegrationStep = " << best.settings.numIntegrationStep
+    << ", orderMagnusScheme = " << best.settings.orderMagnusScheme
+    << ", radImpedGridDensity = " << best.settings.radImpedGridDensity << endl;
+  os << "Predicted time of the full sweep: " << best.predictedSweepTime 
+    << " s (reference " << study.runs[0].predictedSweepTime << " s)" << endl;
+}
@@ -0,0 +1,130 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#ifndef __CONVERGENCE_STUDY_H__
+#define __CONVERGENCE_STUDY_H__
+
+#include "SimulationParametersFile.h"
+#include "ParallelLoop.h"
+#include <string>
+#include <vector>
+#include <iostream>
+
+using namespace std;
+
+// ****************************************************************************
+// Convergence study of the solver settings of a geometry, to choose the 
+// cheapest settings whose transfer function stays within a tolerance of the
+// one computed with the settings of the setup (the reference, which should
+// thus be accurate).
+//
+// The glottal source transfer function at the first transfer function point
+// is computed on a probe band (0 to maxFreq, with the frequency step of
+// spectrumLgthExponent), which is cheaper than the full sweep. Its formant 
+// frequencies and bandwidths are the poles of a rational model fitted to the
+// samples (see RationalFit.h), with the propagation delay to the point.
+//
+// The settings are coarsened one after the other (mesh density, maximal
+// cut-on frequency, number of integration steps, order of the Magnus scheme
+// and grid density of the radiation impedance), each one divided by 2 at 
+// each level while the transfer function stays within the tolerance, the 
+// settings already coarsened keeping their coarsest accepted value. Every 
+// run is thus a combination of the accepted settings, and the last accepted 
+// run is the recommended configuration. The maximal cut-on frequency is not
+// decreased below the maximal frequency of the full sweep, whose higher 
+// modes are not tested by the probe band.
+//
+// The runtime of the full sweep of the setup is predicted from the time of
+// the modes, junctions and radiation impedance and from the time per 
+// frequency of the probe band (without the adaptive frequency sampling).
+// ****************************************************************************
+
+// settings varied by the study
+struct solverSettings
+{
+  double meshDensity;
+  double maxCutOnFreq;
+  int numIntegrationStep;
+  int orderMagnusScheme;
+  double radImpedGridDensity;
+};
+
+struct convergenceStudyParameters
+{
+  double maxFreq;               // upper frequency of the probe band (Hz)
+  int spectrumLgthExponent;     // frequency step of the probe band (see simulationParameters)
+  int numFormants;              // number of formants compared
+  int numLevels;                // maximal number of coarsening levels of each setting
+  // tolerances on the deviations from the reference
+  double formantTolerance;      // formant frequencies (%)
+  double bandwidthTolerance;    // formant bandwidths (%)
+  double magnitudeTolerance;    // rms deviation of the magnitude of the tf (dB)
+};
+
+struct convergenceRun
+{
+  struct solverSettings settings;
+  bool success;                 // false if the geometry or the fit failed
+  vector<double> formants;      // Hz
+  vector<double> bandwidths;    // Hz
+  vector<double> magnitudes;    // dB, at the frequencies of the probe band
+  // maximal deviations of the formants from the reference
+  double formantDeviation;      // %
+  double bandwidthDeviation;    // %
+  double magnitudeDeviation;    // rms deviation (dB)
+  bool withinTolerance;
+  double modesTime;             // modes, junctions and radiation impedance (s)
+  double freqTime;              // mean time per frequency of the probe band (s)
+  double predictedSweepTime;    // predicted time of the full sweep of the setup (s)
+};
+
+struct convergenceStudy
+{
+  vector<double> freqs;         // frequencies of the probe band
+  vector<struct convergenceRun> runs;   // the reference first
+  int recommended;              // index of the recommended run (-1 if none)
+};
+
+struct convergenceStudyParameters defaultConvergenceStudyParameters(
+  const struct simulationSetup& setup);
+
+struct solverSettings getSolverSettings(const struct simulationSetup& setup);
+void setSolverSettings(struct simulationSetup& setup,
+  const struct solverSettings& settings);
+
+// setup of a quick preview of the transfer functions before the full sweep:
+// straight tubes with the plane mode and the first higher modes only, coarse
+// mesh and radiation impedance grid, and frequency step 4 times larger
+struct simulationSetup previewSimulationSetup(const struct simulationSetup& setup);
+
+// the progress callback receives the number of runs done and the maximal 
+// number of runs, returning false stops the study (the recommendation is the
+// cheapest run accepted so far); returns false if the reference could not be
+// computed
+bool computeConvergenceStudy(const string& geometryFile,
+  const struct simulationSetup& setup, const struct convergenceStudyParameters& params,
+  struct convergenceStudy& study, const progressCallback& progress = progressCallback());
+
+// table of the runs and recommendation
+void writeConvergenceStudy(ostream& os, const struct convergenceStudy& study,
+  const struct convergenceStudyParameters& params);
+
+#endif
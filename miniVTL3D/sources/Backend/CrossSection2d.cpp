@@ -22,6 +22,9 @@
 #include "CrossSection2d.h"
 #include "Constants.h"
 #include "Tube.h"
+#include "SparseEigenSolver.h"
+#include "Logger.h"
+#include "ParallelLoop.h"
 #include <iostream>
 #include <Eigen/Core>
 #include <chrono>    // to get the computation time
@@ -45,6 +48,7 @@
 #include <CGAL/squared_distance_2.h>
 #include <CGAL/natural_neighbor_coordinates_2.h>
 #include <CGAL/interpolation_functions.h>
+#include <CGAL/function_objects.h>
 #include <CGAL/point_generators_2.h>
 #include <CGAL/algorithm.h>
 #include <CGAL/Origin.h>
@@ -52,6 +56,7 @@
 // typedef for eigen
 typedef Eigen::MatrixXd Matrix;
 typedef Eigen::Triplet<complex<double>> Triplet;
+typedef Eigen::Triplet<double> TripletD;
 typedef Eigen::SparseMatrix<complex<double>> SparseMatC;
 
 // typedef for CGAL
@@ -85,6 +90,9 @@ typedef CGAL::Data_access<Point_value_map>        Value_access;
 // ****************************************************************************
 
 const double NON_SENS_VALUE = 1e14;
+// relative tolerance on the distances used to detect the circular and 
+// rectangular contours whose modes are computed analytically
+const double ANALYTIC_CONTOUR_TOLERANCE = 1e-2;
 
 
 // ****************************************************************************
@@ -210,30 +218,225 @@ void BesselJDerivativeZero(int v, int n, map<double, pair<int,int>> &zeros)
   }
 }
 
+// ****************************************************************************
+// Check if a contour is a circle: its vertices and the middles of its edges
+// must be at the same distance of its centroid, up to the relative 
+// tolerance ANALYTIC_CONTOUR_TOLERANCE (which excludes the polygons with 
+// too few vertices)
+
+static bool isCircularContour(const Polygon_2& contour, Point2D& center, 
+  double& radius)
+{
+  int numPts((int)contour.size());
+  double area(0.), cross, dist;
+
+  if (numPts < 3) { return false; }
+
+  // centroid of the polygon
+  center.set(0., 0.);
+  for (int i(0); i < numPts; i++)
+  {
+    const Point& P(contour.vertex(i));
+    const Point& Q(contour.vertex((i + 1) % numPts));
+    cross = P.x() * Q.y() - Q.x() * P.y();
+    area += cross;
+    center += Point2D((P.x() + Q.x()) * cross, (P.y() + Q.y()) * cross);
+  }
+  if (abs(area) < MINIMAL_DISTANCE) { return false; }
+  center /= 3. * area;
+
+  // mean distance of the vertices to the centroid
+  radius = 0.;
+  for (int i(0); i < numPts; i++)
+  {
+    radius += Point2D(contour.vertex(i).x() - center.x, 
+      contour.vertex(i).y() - center.y).magnitude();
+  }
+  radius /= numPts;
+
+  for (int i(0); i < numPts; i++)
+  {
+    const Point& P(contour.vertex(i));
+    const Point& Q(contour.vertex((i + 1) % numPts));
+    dist = Point2D(P.x() - center.x, P.y() - center.y).magnitude();
+    if (abs(dist - radius) > ANALYTIC_CONTOUR_TOLERANCE * radius) { return false; }
+    dist = Point2D(0.5 * (P.x() + Q.x()) - center.x, 
+      0.5 * (P.y() + Q.y()) - center.y).magnitude();
+    if (abs(dist - radius) > ANALYTIC_CONTOUR_TOLERANCE * radius) { return false; }
+  }
+  return true;
+}
+
+// ****************************************************************************
+// Check if a contour is a rectangle: once the vertices lying on the edges 
+// are removed, it must have 4 corners with right angles. The rectangle is
+// described by its center, the unit vector of its first side and the half
+// lengths of its sides.
+
+static bool isRectangularContour(const Polygon_2& contour, Point2D& center, 
+  Point2D& axis, double halfSides[2])
+{
+  int numPts((int)contour.size());
+  vector<Point2D> corners;
+  Point2D prevEdge, nextEdge;
+  double norms;
+
+  // extract the corners
+  for (int i(0); i < numPts; i++)
+  {
+    const Point& P(contour.vertex((i + numPts - 1) % numPts));
+    const Point& Q(contour.vertex(i));
+    const Point& R(contour.vertex((i + 1) % numPts));
+    prevEdge.set(Q.x() - P.x(), Q.y() - P.y());
+    nextEdge.set(R.x() - Q.x(), R.y() - Q.y());
+    norms = prevEdge.magnitude() * nextEdge.magnitude();
+    if (norms < MINIMAL_DISTANCE) { return false; }
+    if (abs(prevEdge.x * nextEdge.y - prevEdge.y * nextEdge.x) > 
+      ANALYTIC_CONTOUR_TOLERANCE * norms)
+    {
+      corners.push_back(Point2D(Q.x(), Q.y()));
+    }
+  }
+  if (corners.size() != 4) { return false; }
+
+  // check the angles
+  center.set(0., 0.);
+  for (int i(0); i < 4; i++)
+  {
+    prevEdge = corners[i] - corners[(i + 3) % 4];
+    nextEdge = corners[(i + 1) % 4] - corners[i];
+    if (abs(scalarProduct(prevEdge, nextEdge)) > ANALYTIC_CONTOUR_TOLERANCE *
+      prevEdge.magnitude() * nextEdge.magnitude())
+    {
+      return false;
+    }
+    center += corners[i] / 4.;
+  }
+
+  axis = corners[1] - corners[0];
+  halfSides[0] = 0.5 * axis.magnitude();
+  axis.normalize();
+  halfSides[1] = 0.5 * (corners[2] - corners[1]).magnitude();
+  return true;
+}
+
+// ****************************************************************************
+/// Propagation workspace
+// ****************************************************************************
+
+thread_local PropagationWorkspace* PropagationWorkspace::m_current = NULL;
+
+// ****************************************************************************
+/// Magnus propagator scope
+// ****************************************************************************
+
+thread_local long MagnusPropagatorScope::m_current = 0;
+atomic<long> MagnusPropagatorScope::m_lastScope(0);
+
+MagnusPropagatorScope::MagnusPropagatorScope() : m_outer(m_current == 0)
+{
+  if (m_outer) { m_current = ++m_lastScope; }
+}
+
+MagnusPropagatorScope::~MagnusPropagatorScope()
+{
+  if (m_outer) { m_current = 0; }
+}
+
+// ****************************************************************************
+/// Plane wave scope
+// ****************************************************************************
+
+thread_local bool PlaneWaveScope::m_active = false;
+
+PlaneWaveScope::PlaneWaveScope(bool open) : m_previous(m_active)
+{
+  if (open) { m_active = true; }
+}
+
+PlaneWaveScope::~PlaneWaveScope()
+{
+  m_active = m_previous;
+}
+
+// **************************************************************************
+// Get the propagation state of a cross-section, the directions of 
+// propagation are initialised with the ones of the cross-section
+
+propagationState& PropagationWorkspace::state(const CrossSection2d* cs, 
+  const propagationState& initState)
+{
+  auto it = m_states.find(cs);
+  if (it == m_states.end())
+  {
+    propagationState newState;
+    for (int i(0); i < 4; i++) { newState.direction[i] = initState.direction[i]; }
+    newState.computeImpedance = initState.computeImpedance;
+    newState.storeAxialProfile = initState.storeAxialProfile;
+    it = m_states.insert(make_pair(cs, newState)).first;
+  }
+  return it->second;
+}
+
+// **************************************************************************
+// Get the propagation state of the workspace bound to the thread, or
+// the own state of the cross-section if there is no workspace bound
+
+propagationState& CrossSection2d::state() const
+{
+  PropagationWorkspace* workspace(PropagationWorkspace::current());
+  if (workspace == NULL)
+  {
+    return m_state;
+  }
+  else
+  {
+    return workspace->state(this, m_state);
+  }
+}
+
 // ****************************************************************************
 /// Constructors
 // ****************************************************************************
 
 CrossSection2d::CrossSection2d()
 {
+  m_type = EMPTY_SECTION;
   m_ctrLinePt = Point2D(0., 0.);
   m_normal = Point2D(0., 1.);
+  m_scalingFactors[0] = 1.;
+  m_scalingFactors[1] = 1.;
   m_modesNumber = 0;
-  setZdir(-1);
-  setYdir(-1);
-  setQdir(1);
-  setPdir(1);
+  m_numIntegrationStep = 0;
+  m_state.direction[0] = -1;
+  m_state.direction[1] = -1;
+  m_state.direction[2] = 1;
+  m_state.direction[3] = 1;
+  m_state.computeImpedance = false;
+  m_state.storeAxialProfile = true;
+  m_modesComputed = false;
+  m_computedModesNumber = 0;
+  m_junctionComputed = false;
 }
 
 CrossSection2d::CrossSection2d(Point2D ctrLinePt, Point2D normal)
-  : m_ctrLinePt(ctrLinePt),
+  : m_type(EMPTY_SECTION),
+  m_ctrLinePt(ctrLinePt),
   m_normal(normal),
-  m_modesNumber(0)
+  m_modesNumber(0),
+  m_numIntegrationStep(0),
+  m_modesComputed(false),
+  m_computedModesNumber(0),
+  m_junctionComputed(false)
 {
-  setZdir(-1);
-  setYdir(-1);
-  setQdir(1);
-  setPdir(1);
+  m_scalingFactors[0] = 1.;
+  m_scalingFactors[1] = 1.;
+  m_state.direction[0] = -1;
+  m_state.direction[1] = -1;
+  m_state.direction[2] = 1;
+  m_state.direction[3] = 1;
+  m_state.computeImpedance = false;
+  m_state.storeAxialProfile = true;
 }
 
 CrossSection2dFEM::CrossSection2dFEM(Point2D ctrLinePt, Point2D normal,
@@ -247,6 +450,7 @@ double inLength, double scalingFactors[2])
   m_surfaceIdx(surfacesIdx)
   
   {
+    m_type = FEM_SECTION;
     for (int i(0); i < 2; i++) { m_scalingFactors[i] = scalingFactors[i]; }
     m_area = area;
     // compute perimeter
@@ -267,6 +471,7 @@ CrossSection2dRadiation::CrossSection2dRadiation(
   m_radius(radius),
   m_PMLThickness(PMLThickness)
   {
+  m_type = RADIATION_SECTION;
   m_area = M_PI * pow(radius, 2);
   }
 
@@ -283,6 +488,82 @@ CrossSection2dFEM::~CrossSection2dFEM() {}
 void CrossSection2dFEM::setJunctionSection(bool junction)
 { m_junctionSection = junction; }
 
+// ****************************************************************************
+// Dirty tracking of the modes and the junction matrices
+
+void CrossSection2d::setModesComputed(const CacheKey& key)
+{
+  m_modesKey = key;
+  m_computedModesNumber = m_modesNumber;
+  m_modesComputed = true;
+}
+
+void CrossSection2d::setJunctionComputed(const CacheKey& key)
+{
+  m_junctionKey = key;
+  m_junctionComputed = true;
+}
+
+bool CrossSection2d::keepComputedModes(const CacheKey& key)
+{
+  if (m_modesComputed && (m_modesKey == key))
+  {
+    m_modesNumber = m_computedModesNumber;
+    return true;
+  }
+  else
+  {
+    return false;
+  }
+}
+
+// ****************************************************************************
+// Memory of the coefficients of a list of matrices
+
+template <class MatrixType>
+static size_t matricesBytes(const vector<MatrixType>& matrices)
+{
+  size_t bytes(0);
+  for (auto& m : matrices) { bytes += m.size() * sizeof(typename MatrixType::Scalar); }
+  return bytes;
+}
+
+// ****************************************************************************
+// Memory of the propagation state of the cross-section
+
+size_t CrossSection2d::memoryFootprint() const
+{
+  return matricesBytes(m_state.impedance) + matricesBytes(m_state.admittance)
+    + matricesBytes(m_state.axialVelocity) + matricesBytes(m_state.acPressure)
+    + matricesBytes(m_state.magnus.propagators);
+}
+
+// ****************************************************************************
+// Estimate the memory of the propagation state of the cross-section: the 
+// impedance and the admittance are stored at each integration point, as well
+// as the pressure and the velocity at the checkpoints if the axial profile is
+// stored, and the Magnus scheme keeps the propagator of each step
+
+size_t CrossSection2d::propagationFootprint(
+  const struct simulationParameters& simuParams, bool storeAxialProfile) const
+{
+  size_t numX(max(2, numIntegrationStep(simuParams)));
+  size_t mn(m_modesNumber);
+  size_t bytes(numX * mn * mn * sizeof(complex<double>) * 2);
+  if (storeAxialProfile)
+  {
+    size_t interval((simuParams.propMethod == MAGNUS) ? 
+      min(max(1, simuParams.axialCheckpointInterval), (int)numX - 1) : 1);
+    bytes += ((numX - 2 + interval) / interval + 1) * mn * mn * 
+      sizeof(complex<double>) * 2;
+  }
+  if (simuParams.propMethod == MAGNUS)
+  {
+    bytes += (numX - 1) * 4 * mn * mn * sizeof(complex<double>);
+  }
+  return bytes;
+}
+
 // ****************************************************************************
 // Add the index of a previous section
 
@@ -320,7 +601,7 @@ void CrossSection2dFEM::setCurvatureAngle(double angle) {
 // ****************************************************************************
 // A simple mesh without constraint
 
-void CrossSection2dFEM::buildMesh()
+void CrossSection2dFEM::buildMesh(bool smooth)
 {
   int idx;
   m_points.clear();
@@ -331,22 +612,29 @@ void CrossSection2dFEM::buildMesh()
   array<int, 3> tempTri;
   array<int, 2> tempSeg;
 
-  m_mesh.clear();
-  m_mesh.insert_constraint(m_contour.vertices_begin(), m_contour.vertices_end(), true);
+  // the triangulation of the mesh generator is only kept during the meshing,
+  // the mesh is then stored in the compact arrays
+  CDT mesh;
+  mesh.insert_constraint(m_contour.vertices_begin(), m_contour.vertices_end(), true);
 
-  Mesher mesher(m_mesh);
+  Mesher mesher(mesh);
 
   mesher.set_criteria(Criteria(0.125, m_spacing));
 
   mesher.refine_mesh();
 
-  CGAL::lloyd_optimize_mesh_2(m_mesh,
-    CGAL::parameters::max_iteration_number = 10);
+  // the smoothing can be skipped when the spacing is set to reach a given 
+  // accuracy since it can lengthen the edges
+  if (smooth)
+  {
+    CGAL::lloyd_optimize_mesh_2(mesh,
+      CGAL::parameters::max_iteration_number = 10);
+  }
 
   // store the point coordinates and attribute indexes to the vertexes
   idx = 0;
-  for (auto it = m_mesh.finite_vertices_begin();
-    it != m_mesh.finite_vertices_end(); ++it)
+  for (auto it = mesh.finite_vertices_begin();
+    it != mesh.finite_vertices_end(); ++it)
   {
     pts[0] = it->point().x();
     pts[1] = it->point().y();
@@ -355,7 +643,7 @@ void CrossSection2dFEM::buildMesh()
     idx++;
   }
 
-  for (auto it = m_mesh.constrained_edges_begin(); it != m_mesh.constrained_edges_end(); it++)
+  for (auto it = mesh.constrained_edges_begin(); it != mesh.constrained_edges_end(); it++)
   {
     // store the indexes of the points of the mesh which form the segments
     // of its contour
@@ -366,13 +654,13 @@ void CrossSection2dFEM::buildMesh()
 
   // remove the faces which lies outside of the contour and extract the 
   // triangles indexes
-  for (Finite_faces_iterator it = m_mesh.finite_faces_begin();
-    it != m_mesh.finite_faces_end(); ++it)
+  for (Finite_faces_iterator it = mesh.finite_faces_begin();
+    it != mesh.finite_faces_end(); ++it)
   {
     // if the face is outside of the contour remove it
     if (!it->is_in_domain())
     {
-      m_mesh.delete_face(it);
+      mesh.delete_face(it);
     }
     else
     {
@@ -384,19 +672,24 @@ void CrossSection2dFEM::buildMesh()
       m_triangles.push_back(tempTri);
     }
   }
+
+  m_triangulation.reset();
+  buildInterpolator();
 }
 
 // ****************************************************************************
 /// Modes computation
 // ****************************************************************************
 
-void CrossSection2dFEM::computeModes(struct simulationParameters simuParams)
+void CrossSection2dFEM::computeModes(const struct simulationParameters& simuParams)
 {
   // declare variables
   bool different;
   int numVert, numSurf, numTri, idxM, idxN, ptIdx, idx, meshContSurfIdx;
-  Matrix mass, massY, stiffness, stiffnessY, B, C, E, DN;
-  vector<Matrix> R, KR2, RY, DR;
+  SparseMatD mass, massY, stiffness, stiffnessY, B;
+  vector<SparseMatD> R, RY;
+  vector<TripletD> massTri, massYTri, stiffnessTri, stiffnessYTri, BTri;
+  vector<vector<TripletD>> RTri, RYTri;
   double signFirstMode, faceArea, dist, oldDist, segLength, maxWaveNumber;
   Point2D midSeg;
 
@@ -420,21 +713,22 @@ void CrossSection2dFEM::computeModes(struct simulationParameters simuParams)
   // accounting for the wall losses DR and K2R
   // **************************************************************************
 
-  // initialize the matrices
-  numVert = (int)m_mesh.number_of_vertices();
-  mass = Matrix::Zero(numVert, numVert);
-  massY = Matrix::Zero(numVert, numVert);
-  stiffness = Matrix::Zero(numVert, numVert);
-  stiffnessY = Matrix::Zero(numVert, numVert);
-  B = Matrix::Zero(numVert, numVert);
-  numTri = (int)m_mesh.number_of_faces();
+  // initialize the matrices (assembled as sparse matrices from triplets,
+  // each face contributes 9 elements)
+  numVert = (int)m_points.size();
+  numTri = (int)m_triangles.size();
+  massTri.reserve(9 * numTri);
+  massYTri.reserve(9 * numTri);
+  stiffnessTri.reserve(9 * numTri);
+  stiffnessYTri.reserve(9 * numTri);
+  BTri.reserve(9 * numTri);
 
   // determine the number of different surfaces on the contours
   numSurf = 1;
-  R.clear();
-  R.push_back(Matrix::Zero(numVert, numVert));
-  RY.clear();
-  RY.push_back(Matrix::Zero(numVert, numVert));
+  RTri.clear();
+  RTri.push_back(vector<TripletD>());
+  RYTri.clear();
+  RYTri.push_back(vector<TripletD>());
   m_surfIdxList.clear();
   m_surfIdxList.push_back(m_surfaceIdx[0]);
   
@@ -455,8 +749,8 @@ void CrossSection2dFEM::computeModes(struct simulationParameters simuParams)
     // if not add it to the list of surface types and initialize a new submatrix
     if (different) { 
       m_surfIdxList.push_back(m_surfaceIdx[ptIdx]);
-      R.push_back(Matrix::Zero(numVert, numVert));
-      RY.push_back(Matrix::Zero(numVert, numVert));
+      RTri.push_back(vector<TripletD>());
+      RYTri.push_back(vector<TripletD>());
       numSurf++;
     }
   }
@@ -519,30 +813,45 @@ void CrossSection2dFEM::computeModes(struct simulationParameters simuParams)
         idxM = m_meshContourSeg[s][j];
         idxN = m_meshContourSeg[s][k];
 
-        R[idx](idxM, idxN) += (1. + (double)(j == k)) * segLength / 6.;
+        RTri[idx].push_back(TripletD(idxM, idxN, 
+          (1. + (double)(j == k)) * segLength / 6.));
 
         if ((j == k) && (k == 0))
         {
           // L*(Yn + 3Ym)/12
-          RY[idx](idxM, idxN) += segLength * (m_points[m_meshContourSeg[s][k]][1] +
-            3 * m_points[m_meshContourSeg[s][j]][1]) / 12.;
+          RYTri[idx].push_back(TripletD(idxM, idxN, 
+            segLength * (m_points[m_meshContourSeg[s][k]][1] +
+            3 * m_points[m_meshContourSeg[s][j]][1]) / 12.));
         }
         else if ((j == k) && (k == 1))
         {
           // L*(3Yn + Ym)/12
-          RY[idx](idxM, idxN) += segLength * (3 * m_points[m_meshContourSeg[s][k]][1] +
-            m_points[m_meshContourSeg[s][j]][1]) / 12.;
+          RYTri[idx].push_back(TripletD(idxM, idxN, 
+            segLength * (3 * m_points[m_meshContourSeg[s][k]][1] +
+            m_points[m_meshContourSeg[s][j]][1]) / 12.));
         }
         else
         {
           // L*(Yn + Ym)/12
-          RY[idx](idxM, idxN) += segLength * ( m_points[m_meshContourSeg[s][k]][1] +
-            m_points[m_meshContourSeg[s][j]][1]) / 12.;
+          RYTri[idx].push_back(TripletD(idxM, idxN, 
+            segLength * ( m_points[m_meshContourSeg[s][k]][1] +
+            m_points[m_meshContourSeg[s][j]][1]) / 12.));
         }
       }
     }
   }
 
+  // build the sparse surface matrices (duplicated elements are summed)
+  R.clear();
+  RY.clear();
+  for (int s(0); s < numSurf; s++)
+  {
+    R.push_back(SparseMatD(numVert, numVert));
+    R.back().setFromTriplets(RTri[s].begin(), RTri[s].end());
+    RY.push_back(SparseMatD(numVert, numVert));
+    RY.back().setFromTriplets(RYTri[s].begin(), RYTri[s].end());
+  }
+
   //ofstream matrixR;
   //matrixR.open("matrixR.txt");
   //for (int i(0); i < R.size(); i++)
@@ -565,24 +874,23 @@ void CrossSection2dFEM::computeModes(struct simulationParameters simuParams)
 // **************************************************************************
 
   // loop over the faces
-  for (CDT::Finite_faces_iterator it = m_mesh.finite_faces_begin() ;
-    it != m_mesh.finite_faces_end(); ++it)
+  for (const array<int, 3>& face : m_triangles)
   {
-    faceArea = 0.5 * abs(it->vertex(0)->point().x() *
-      (it->vertex(1)->point().y() - it->vertex(2)->point().y())
-      + it->vertex(1)->point().x() *
-      (it->vertex(2)->point().y() - it->vertex(0)->point().y())
-      + it->vertex(2)->point().x() *
-      (it->vertex(0)->point().y() - it->vertex(1)->point().y()));
+    faceArea = 0.5 * abs(m_points[face[0]][0] *
+      (m_points[face[1]][1] - m_points[face[2]][1])
+      + m_points[face[1]][0] *
+      (m_points[face[2]][1] - m_points[face[0]][1])
+      + m_points[face[2]][0] *
+      (m_points[face[0]][1] - m_points[face[1]][1]));
 
     // compute the Jacobian of the isoparametric transformation
     J[0][0] = 0.; J[0][1] = 0.; J[1][0] = 0.; J[1][1] = 0.;
     for (int p(0); p < 3; p++)
     {
-      J[0][0] += (it->vertex(p)->point().x()) * dSdr[p];
-      J[0][1] += (it->vertex(p)->point().y()) * dSdr[p];
-      J[1][0] += (it->vertex(p)->point().x()) * dSds[p];
-      J[1][1] += (it->vertex(p)->point().y()) * dSds[p];
+      J[0][0] += (m_points[face[p]][0]) * dSdr[p];
+      J[0][1] += (m_points[face[p]][1]) * dSdr[p];
+      J[1][0] += (m_points[face[p]][0]) * dSds[p];
+      J[1][1] += (m_points[face[p]][1]) * dSds[p];
     }
     detJ = J[0][0] * J[1][1] - J[0][1] * J[1][0];
     quadPtWeightDetJ = quadPtWeight * detJ / 2.;
@@ -602,8 +910,8 @@ void CrossSection2dFEM::computeModes(struct simulationParameters simuParams)
       // loop over face points
       for (int p(0); p < 3; p++)
       {
-        Xrs[q] += (it->vertex(p)->point().x()) * S[q][p];
-        Yrs[q] += (it->vertex(p)->point().y()) * S[q][p];
+        Xrs[q] += (m_points[face[p]][0]) * S[q][p];
+        Yrs[q] += (m_points[face[p]][1]) * S[q][p];
       }
     }
 
@@ -613,47 +921,131 @@ void CrossSection2dFEM::computeModes(struct simulationParameters simuParams)
       // loop over points of the face
       for (int k(0); k < 3; k++)
       {
-        idxM = it->vertex(j)->info();
-        idxN = it->vertex(k)->info();
+        idxM = face[j];
+        idxN = face[k];
 
         // compute mass matrix
-        mass(idxM, idxN) += (1. + (int)(j == k)) * faceArea / 12;
+        massTri.push_back(TripletD(idxM, idxN, (1. + (int)(j == k)) * faceArea / 12));
 
-          
         // loop over quadrature points
+        double valMassY(0.), valStiffnessY(0.), valB(0.);
         for (int q(0); q < 3; q++)
         {
           // compute the matrix necessary to build matrix C (almost identical to mass matrix)
-          massY(idxM, idxN) += Yrs[q] * S[q][j] * S[q][k] * quadPtWeightDetJ;
+          valMassY += Yrs[q] * S[q][j] * S[q][k] * quadPtWeightDetJ;
 
           // compute the matrix necessary to build matrix D (almost identical to stiffness matrix)
-          stiffnessY(idxM, idxN) += Yrs[q] * (dSdx[j] * dSdx[k] + dSdy[j] * dSdy[k]) * quadPtWeightDetJ;
+          valStiffnessY += Yrs[q] * (dSdx[j] * dSdx[k] + dSdy[j] * dSdy[k]) * quadPtWeightDetJ;
 
           // compute matrix necessary to build matrix E
-          B(idxM, idxN) += (Xrs[q] * S[q][j] * dSdx[k] + Yrs[q] * S[q][j] * dSdy[k]) * quadPtWeightDetJ;
+          valB += (Xrs[q] * S[q][j] * dSdx[k] + Yrs[q] * S[q][j] * dSdy[k]) * quadPtWeightDetJ;
         }
+        massYTri.push_back(TripletD(idxM, idxN, valMassY));
+        stiffnessYTri.push_back(TripletD(idxM, idxN, valStiffnessY));
+        BTri.push_back(TripletD(idxM, idxN, valB));
 
         // compute stiffness matrix
-        stiffness(idxM, idxN) += ((
-          it->vertex((j + 1) % 3)->point().y() -      // bm
-          it->vertex((j + 2) % 3)->point().y()) *      // bm
-          (it->vertex((k + 1) % 3)->point().y() -      // bn
-          it->vertex((k + 2) % 3)->point().y()) +      // bn
-          (it->vertex((j + 2) % 3)->point().x() -      // cm
-          it->vertex((j + 1) % 3)->point().x()) *      // cm
-          (it->vertex((k + 2) % 3)->point().x() -      // cn
-          it->vertex((k + 1) % 3)->point().x())      // cn
-          ) / faceArea / 4;
+        stiffnessTri.push_back(TripletD(idxM, idxN, ((
+          m_points[face[(j + 1) % 3]][1] -      // bm
+          m_points[face[(j + 2) % 3]][1]) *      // bm
+          (m_points[face[(k + 1) % 3]][1] -      // bn
+          m_points[face[(k + 2) % 3]][1]) +      // bn
+          (m_points[face[(j + 2) % 3]][0] -      // cm
+          m_points[face[(j + 1) % 3]][0]) *      // cm
+          (m_points[face[(k + 2) % 3]][0] -      // cn
+          m_points[face[(k + 1) % 3]][0])      // cn
+          ) / faceArea / 4));
       }
     }
   }
 
+  mass.resize(numVert, numVert);
+  mass.setFromTriplets(massTri.begin(), massTri.end());
+  massY.resize(numVert, numVert);
+  massY.setFromTriplets(massYTri.begin(), massYTri.end());
+  stiffness.resize(numVert, numVert);
+  stiffness.setFromTriplets(stiffnessTri.begin(), stiffnessTri.end());
+  stiffnessY.resize(numVert, numVert);
+  stiffnessY.setFromTriplets(stiffnessYTri.begin(), stiffnessYTri.end());
+  B.resize(numVert, numVert);
+  B.setFromTriplets(BTri.begin(), BTri.end());
+
   // **************************************************************************
   // Compute modes
   // **************************************************************************
 
-  // solve eigen problem
-  Eigen::GeneralizedSelfAdjointEigenSolver<Matrix> eigenSolver(stiffness, mass);
+  // solve eigen problem: only the modes below the maximal cut-on frequency 
+  // (or the number of modes previously specified) are computed with a 
+  // sparse shift-invert solver. The dense solver is used for small meshes
+  // or if the sparse solver does not converge
+  maxWaveNumber = pow(2 * M_PI * simuParams.maxCutOnFreq / simuParams.sndSpeed, 2);
+  Eigen::VectorXd eigenValues;
+  Matrix eigenVectors;
+  bool solved(false);
+
+  // the modes of the circular and rectangular contours are known 
+  // analytically, they are normalized with the mass matrix as the 
+  // eigenvectors of the FEM problem
+  if (simuParams.analyticModes && 
+    computeAnalyticModes(maxWaveNumber, eigenValues, eigenVectors))
+  {
+    for (int i(0); i < eigenVectors.cols(); i++)
+    {
+      eigenVectors.col(i) /= sqrt(eigenVectors.col(i).dot(mass * eigenVectors.col(i)));
+    }
+    solved = true;
+  }
+
+  if (!solved && (numVert > SPARSE_EIGEN_SOLVER_MIN_VERTICES))
+  {
+    // estimate the number of modes with Weyl's law for the Neumann problem
+    double perim(0.);
+    for (auto itE = m_contour.edges_begin(); itE != m_contour.edges_end(); itE++)
+    {
+      perim += sqrt(itE->squared_length());
+    }
+    int numModesEstimate((int)ceil(abs(m_contour.area()) * maxWaveNumber / 4. / M_PI
+      + perim * sqrt(maxWaveNumber) / 4. / M_PI) + 1);
+
+    // the dense solver needs about 5 dense matrices of the size of the mesh,
+    // if they exceed the memory budget the sparse solver is tried again 
+    // with a larger subspace instead
+    double denseMemory(5. * pow((double)numVert, 2) * sizeof(double) / 1048576.);
+    int numTrials(((simuParams.memoryBudget > 0.) && 
+      (denseMemory > simuParams.memoryBudget)) ? 2 : 1);
+
+    // the modes of the neighbouring cross-section start the subspace
+    const Matrix* guess((m_modesGuess.rows() == numVert) ? &m_modesGuess : nullptr);
+    for (int t(0); (t < numTrials) && !solved; t++)
+    {
+      if (m_modesNumber == 0)
+      {
+        solved = sparseGeneralizedEigenSolve(stiffness, mass, maxWaveNumber,
+          1, numModesEstimate * (t + 1), eigenValues, eigenVectors, guess);
+      }
+      else
+      {
+        solved = sparseGeneralizedEigenSolve(stiffness, mass, 0.,
+          m_modesNumber, m_modesNumber * (t + 1), eigenValues, eigenVectors, guess);
+      }
+    }
+    if (!solved && (numTrials > 1))
+    {
+      LogStream log;
+      log << "The sparse eigensolver did not converge, the dense solver needs " 
+        << denseMemory << " MB which exceeds the memory budget" << endl;
+    }
+  }
+  m_modesGuess.resize(0, 0);
+  if (!solved)
+  {
+    Matrix denseStiffness(stiffness);
+    Matrix denseMass(mass);
+    Eigen::GeneralizedSelfAdjointEigenSolver<Matrix> eigenSolver(
+      denseStiffness, denseMass);
+    eigenValues = eigenSolver.eigenvalues();
+    eigenVectors = eigenSolver.eigenvectors();
+  }
 
   m_eigenFreqs.clear();
   if (m_modesNumber == 0)
@@ -661,11 +1053,9 @@ void CrossSection2dFEM::computeModes(struct simulationParameters simuParams)
   // cut-on frequency and determine the number of modes
   {
     idx = 0;
-    maxWaveNumber = pow(2 * M_PI * simuParams.maxCutOnFreq / simuParams.sndSpeed, 2);
-    while ((eigenSolver.eigenvalues()[idx] < maxWaveNumber)
-      && (idx < eigenSolver.eigenvalues().size()))
+    while ((idx < eigenValues.size()) && (eigenValues[idx] < maxWaveNumber))
     {
-      m_eigenFreqs.push_back(sqrt(eigenSolver.eigenvalues()[idx]) * simuParams.sndSpeed / 2. / M_PI);
+      m_eigenFreqs.push_back(sqrt(abs(eigenValues[idx])) * simuParams.sndSpeed / 2. / M_PI);
       idx++;
     }
     m_modesNumber = idx;
@@ -676,7 +1066,7 @@ void CrossSection2dFEM::computeModes(struct simulationParameters simuParams)
     m_eigenFreqs.reserve(m_modesNumber);
     for (int i(0); i < m_modesNumber; i++)
     {
-      m_eigenFreqs.push_back(sqrt(eigenSolver.eigenvalues()[i])* simuParams.sndSpeed / 2. / M_PI);
+      m_eigenFreqs.push_back(sqrt(abs(eigenValues[i]))* simuParams.sndSpeed / 2. / M_PI);
     }
   }
 
@@ -689,7 +1079,7 @@ void CrossSection2dFEM::computeModes(struct simulationParameters simuParams)
   m_eigenFreqs[0] = 0.;
 
   // get the sign of the first mode to set them all positiv later
-  if (eigenSolver.eigenvectors().col(0)[0] > 0)
+  if (eigenVectors.col(0)[0] > 0)
   {
     signFirstMode = 1.;
   }
@@ -699,7 +1089,7 @@ void CrossSection2dFEM::computeModes(struct simulationParameters simuParams)
   }
 
   // extract modes matrix
-  m_modes = eigenSolver.eigenvectors().block(0, 0, numVert , m_modesNumber );
+  m_modes = eigenVectors.block(0, 0, numVert , m_modesNumber );
   for (int m(0); m < m_modesNumber; m++)
   {
     // multiply all modes by the sign of the first mode
@@ -715,18 +1105,9 @@ void CrossSection2dFEM::computeModes(struct simulationParameters simuParams)
   // **************************************************************************
 
   // compute matrices C, DN and E
-  m_C = Matrix::Zero(m_modesNumber, m_modesNumber);
-  m_DN = Matrix::Zero(m_modesNumber, m_modesNumber);
-  m_E = Matrix::Zero(m_modesNumber, m_modesNumber);
-  for (int m(0); m < m_modesNumber; m++)
-  {
-    for (int n(0); n < m_modesNumber; n++)
-    {
-      m_C(m, n) = (m_modes.col(m)).transpose() * massY * m_modes.col(n);
-      m_DN(m,n) = (m_modes.col(m)).transpose() * stiffnessY * m_modes.col(n);
-      m_E(m,n) = (m_modes.col(m)).transpose() * B * m_modes.col(n);
-    }
-  }
+  m_C = m_modes.transpose() * (massY * m_modes);
+  m_DN = m_modes.transpose() * (stiffnessY * m_modes);
+  m_E = m_modes.transpose() * (B * m_modes);
 
   // compute matrices DR and KR2
   m_DR.clear(); 
@@ -734,16 +1115,8 @@ void CrossSection2dFEM::computeModes(struct simulationParameters simuParams)
   // loop over surfaces
   for (int s(0); s < m_surfIdxList.size(); s++)
   {
-    m_DR.push_back(Matrix::Zero(m_modesNumber, m_modesNumber));
-    m_KR2.push_back(Matrix::Zero(m_modesNumber, m_modesNumber));
-    for (int m(0); m < m_modesNumber; m++)
-    {
-      for (int n(0); n < m_modesNumber; n++)
-      {
-        m_DR.back()(m,n) = (m_modes.col(m)).transpose() * RY[s] * m_modes.col(n);
-        m_KR2.back()(m,n) = (m_modes.col(m)).transpose() * R[s] * m_modes.col(n);
-      }
-    }
+    m_DR.push_back(m_modes.transpose() * (RY[s] * m_modes));
+    m_KR2.push_back(m_modes.transpose() * (R[s] * m_modes));
   }
 
   // **************************************************************************
@@ -829,6 +1202,111 @@ void CrossSection2dFEM::computeModes(struct simulationParameters simuParams)
   //matrixKR2.close();
 }
 
+// **************************************************************************
+// Compute the modes of a circular or rectangular contour from their 
+// closed-form expressions instead of solving the FEM eigenproblem.
+// The eigenvalues are the squared wavenumbers of the modes, sorted in 
+// ascending order, and the eigenvectors are the values of the modes at the 
+// mesh points (not normalized). All the modes with a squared wavenumber 
+// lower than maxWaveNumber are computed, and at least m_modesNumber modes.
+// Return false if the contour is neither a circle nor a rectangle.
+
+bool CrossSection2dFEM::computeAnalyticModes(double maxWaveNumber,
+  Eigen::VectorXd& eigenValues, Matrix& eigenVectors) const
+{
+  // a mode is described by its wavenumber and two indexes: for a circle 
+  // the order of the Bessel function (negative for the sine modes), for a
+  // rectangle the number of half wavelengths along each side
+  struct analyticMode
+  {
+    double waveNumber;
+    int m;
+    int n;
+  };
+
+  Point2D center, axis, normal, vec;
+  double radius, halfSides[2], limit(maxWaveNumber), zMax, angle;
+  bool circle;
+  vector<analyticMode> modes;
+
+  if (isCircularContour(m_contour, center, radius)) { circle = true; }
+  else if (isRectangularContour(m_contour, center, axis, halfSides)) { circle = false; }
+  else { return false; }
+  normal.set(-axis.y, axis.x);
+
+  // list the modes with a squared wavenumber lower than the limit, which 
+  // is increased until the number of modes previously specified is reached
+  do
+  {
+    modes.clear();
+    if (circle)
+    {
+      // the wavenumbers are the zeros of the derivatives of the Bessel 
+      // functions (the first zero of J'v is larger than v)
+      map<double, pair<int, int>> zeros;
+      zMax = radius * sqrt(limit);
+      for (int v(0); v <= (int)zMax; v++)
+      {
+        BesselJDerivativeZero(v, max(1, (int)ceil(zMax / M_PI - 0.5 * v + 0.75) + 1),
+          zeros);
+      }
+      for (auto z : zeros)
+      {
+        if (z.first > zMax) { break; }
+        modes.push_back({ z.first / radius, z.second.first, z.second.second });
+        if (z.second.first > 0)
+        {
+          modes.push_back({ z.first / radius, -z.second.first, z.second.second });
+        }
+      }
+    }
+    else
+    {
+      for (int p(0); p * M_PI / 2. / halfSides[0] <= sqrt(limit); p++)
+      {
+        for (int q(0); q * M_PI / 2. / halfSides[1] <= sqrt(limit); q++)
+        {
+          double k(sqrt(pow(p * M_PI / 2. / halfSides[0], 2) + 
+            pow(q * M_PI / 2. / halfSides[1], 2)));
+          if (k * k <= limit) { modes.push_back({ k, p, q }); }
+        }
+      }
+    }
+    limit *= 2.;
+  } while ((m_modesNumber > 0) && (modes.size() < m_modesNumber));
+
+  stable_sort(modes.begin(), modes.end(),
+    [](const analyticMode& a, const analyticMode& b) 
+    { return a.waveNumber < b.waveNumber; });
+
+  // evaluate the modes at the mesh points
+  eigenValues.resize(modes.size());
+  eigenVectors.resize(m_points.size(), modes.size());
+  for (int i(0); i < modes.size(); i++)
+  {
+    eigenValues(i) = pow(modes[i].waveNumber, 2);
+    for (int p(0); p < m_points.size(); p++)
+    {
+      vec.set(m_points[p][0] - center.x, m_points[p][1] - center.y);
+      if (circle)
+      {
+        angle = abs(modes[i].m) * atan2(vec.y, vec.x);
+        eigenVectors(p, i) = cyl_bessel_j(abs(modes[i].m), 
+          modes[i].waveNumber * vec.magnitude()) *
+          ((modes[i].m >= 0) ? cos(angle) : sin(angle));
+      }
+      else
+      {
+        eigenVectors(p, i) = 
+          cos(modes[i].m * M_PI * (scalarProduct(vec, axis) / halfSides[0] + 1.) / 2.) *
+          cos(modes[i].n * M_PI * (scalarProduct(vec, normal) / halfSides[1] + 1.) / 2.);
+      }
+    }
+  }
+
+  return true;
+}
+
 // **************************************************************************
 // Return the zeros of the derivative of the Bessel functions of the 
 // first kind Jn, as well as order the corresponding Bessel function 
@@ -837,7 +1315,7 @@ void CrossSection2dFEM::computeModes(struct simulationParameters simuParams)
 // The zeros are from the work of Curtis and Beattie (1957)
 // More precise and more zero could be obtained using boost library
 
-void CrossSection2dRadiation::setBesselParam(struct simulationParameters simuParams)
+void CrossSection2dRadiation::setBesselParam(const struct simulationParameters& simuParams)
 {
   int mu(0), estimateModeNumber, nZeros(30);
   double fc;
@@ -869,6 +1347,10 @@ void CrossSection2dRadiation::setBesselParam(struct simulationParameters simuPar
   estimateModeNumber = zeros.size()*2;
 
   // reserve necessary space 
+  m_BesselZeros.clear();
+  m_BesselOrder.clear();
+  m_degeneration.clear();
+  m_normModes.clear();
   m_BesselZeros.reserve(estimateModeNumber);
   m_BesselOrder.reserve(estimateModeNumber);
   m_degeneration.reserve(estimateModeNumber);
@@ -905,12 +1387,16 @@ void CrossSection2dRadiation::setBesselParam(struct simulationParameters simuPar
 // **************************************************************************
 // Compute the mode parameters and propagation matrice of a radiation section
 
-void CrossSection2dRadiation::computeModes(struct simulationParameters simuParams)
+void CrossSection2dRadiation::computeModes(const struct simulationParameters& simuParams)
 {
   using namespace boost::math;
 
-  complex<double> Q1, Q2, avAl(20. * exp(1i * M_PI / 4.)), CPML, DPML;
-  int m(0), n(0);
+  // take the modes of a radiation section with the same dimensions if they
+  // have already been computed
+  CacheKey key(modesCacheKey(simuParams));
+  if (restoreMemoisedModes(key)) { return; }
+
+  complex<double> avAl(20. * exp(1i * M_PI / 4.));
 
   setBesselParam(simuParams);
 
@@ -949,103 +1435,108 @@ void CrossSection2dRadiation::computeModes(struct simulationParameters simuParam
     return bet;
   };
 
-  // expression of the term to integrate in CPML
-  auto integral1 = [&, this](const double& r)
+  // integral of a complex function over the PML
+  auto integratePML = [this](const function<complex<double>(double)>& f)
   {
-    complex<double> al = alpha(r);
-    complex<double> bet = beta(r);
-
-    // return the value of the expression to integrate
-    return (al * bet - 1.) *
-      cyl_bessel_j(m_BesselOrder[m], r * m_BesselZeros[m] / m_radius) *
-      cyl_bessel_j(m_BesselOrder[n], r * m_BesselZeros[n] / m_radius) * r;
+    double err;
+    double re = boost::math::quadrature::gauss<double, 15>::integrate(
+      [&f](double rr) { return std::real(f(rr)); },
+      m_radius - m_PMLThickness, m_radius, &err);
+    double im = boost::math::quadrature::gauss<double, 15>::integrate(
+      [&f](double rr) { return std::imag(f(rr)); },
+      m_radius - m_PMLThickness, m_radius, &err);
+    return complex<double>(re, im);
   };
 
-  // expression of the first term to integrate in DPML
-  auto integral21 = [&, this](const double& r)
+  // coefficients of the matrices CPML and DPML of the modes m and n
+  auto computePMLCoefficients = [&, this](int m, int n, 
+    complex<double>& CPML, complex<double>& DPML)
   {
-    complex<double> al = alpha(r);
-    complex<double> bet = beta(r);
-
-    // return the value of the expression to integrate
-    return (bet / al - 1.) * (0.25 *
-      (cyl_bessel_j(m_BesselOrder[m] - 1, r * m_BesselZeros[m] / m_radius) -
-      cyl_bessel_j(m_BesselOrder[m] + 1, r * m_BesselZeros[m] / m_radius))*
-      (cyl_bessel_j(m_BesselOrder[n] - 1, r * m_BesselZeros[n] / m_radius) -
-      cyl_bessel_j(m_BesselOrder[n] + 1, r * m_BesselZeros[n] / m_radius))
-       * r);
-  };
+    // expression of the term to integrate in CPML
+    auto integral1 = [&, this](double r)
+    {
+      complex<double> al = alpha(r);
+      complex<double> bet = beta(r);
 
-  // expression of the second term to integrate in DPML
-  auto integral22 = [&, this](const double& r)
-  {
-    complex<double> al = alpha(r);
-    complex<double> bet = beta(r);
+      // return the value of the expression to integrate
+      return (al * bet - 1.) *
+        cyl_bessel_j(m_BesselOrder[m], r * m_BesselZeros[m] / m_radius) *
+        cyl_bessel_j(m_BesselOrder[n], r * m_BesselZeros[n] / m_radius) * r;
+    };
 
-    // return the value of the expression to integrate
-    return (al / bet - 1.) * (
-      cyl_bessel_j(m_BesselOrder[m], r * m_BesselZeros[m] / m_radius) *
-      cyl_bessel_j(m_BesselOrder[n], r * m_BesselZeros[n] / m_radius)
-       / r);
+    // expression of the first term to integrate in DPML
+    auto integral21 = [&, this](double r)
+    {
+      complex<double> al = alpha(r);
+      complex<double> bet = beta(r);
+
+      // return the value of the expression to integrate
+      return (bet / al - 1.) * (0.25 *
+        (cyl_bessel_j(m_BesselOrder[m] - 1, r * m_BesselZeros[m] / m_radius) -
+        cyl_bessel_j(m_BesselOrder[m] + 1, r * m_BesselZeros[m] / m_radius))*
+        (cyl_bessel_j(m_BesselOrder[n] - 1, r * m_BesselZeros[n] / m_radius) -
+        cyl_bessel_j(m_BesselOrder[n] + 1, r * m_BesselZeros[n] / m_radius))
+         * r);
+    };
+
+    // expression of the second term to integrate in DPML
+    auto integral22 = [&, this](double r)
+    {
+      complex<double> al = alpha(r);
+      complex<double> bet = beta(r);
+
+      // return the value of the expression to integrate
+      return (al / bet - 1.) * (
+        cyl_bessel_j(m_BesselOrder[m], r * m_BesselZeros[m] / m_radius) *
+        cyl_bessel_j(m_BesselOrder[n], r * m_BesselZeros[n] / m_radius)
+         / r);
+    };
+
+    complex<double> Q1(integratePML(integral1));
+    CPML = (double)(m == n) + m_normModes[m] * m_normModes[n] * 
+      (1. + (double)(0 == m_BesselOrder[m])) * M_PI * Q1;
+
+    Q1 = integratePML(integral21);
+    complex<double> Q2(integratePML(integral22));
+    DPML = (double)(m == n) * pow(m_BesselZeros[m] / m_radius, 2) + 
+      m_normModes[m] * m_normModes[n]  *
+      (1. + (double)(0 == m_BesselOrder[m])) * M_PI * (
+        m_BesselZeros[m] * m_BesselZeros[n] * Q1 / pow(m_radius, 2)
+        + pow(m_BesselOrder[m], 2) * Q2);
   };
 
   //***********************************************
   // Build matrices CPML and DPML
   //***********************************************
 
-  vector<Triplet> tripletCPML, tripletDPML;
-
-  // Compute matrices CPML and DPML
-  for (; m < m_modesNumber; m++)
+  // only the modes with the same Bessel order are coupled
+  vector<pair<int, int>> modePairs;
+  for (int m(0); m < m_modesNumber; m++)
   {
-    n = 0;
-    for (; n < m_modesNumber; n++)
+    for (int n(0); n < m_modesNumber; n++)
     {
-      if (m_BesselOrder[m] == m_BesselOrder[n])
-      {
-        // compute the matrices CPML
-        // Attempting to match a 4-argument overload if 3-argument one is problematic
-        double err1;
-        auto int1_real = [&](double rr){ return std::real(integral1(rr)); };
-        auto int1_imag = [&](double rr){ return std::imag(integral1(rr)); };
-        double q1_real = boost::math::quadrature::gauss<double, 15>::integrate(int1_real,
-          m_radius - m_PMLThickness, m_radius, &err1);
-        double q1_imag = boost::math::quadrature::gauss<double, 15>::integrate(int1_imag,
-          m_radius - m_PMLThickness, m_radius, &err1);
-        Q1 = complex<double>(q1_real, q1_imag);
-
-        CPML = (double)(m == n) + m_normModes[m] * m_normModes[n] * 
-          (1. + (double)(0 == m_BesselOrder[m])) * M_PI * Q1;
-        tripletCPML.push_back(Triplet(m, n, CPML));
-
-        // compute the matrices DPML
-        double error_estimate_Q1_integral21;
-        double error_estimate_Q2_integral22;
-        auto int21_real = [&](double rr){ return std::real(integral21(rr)); };
-        auto int21_imag = [&](double rr){ return std::imag(integral21(rr)); };
-        auto int22_real = [&](double rr){ return std::real(integral22(rr)); };
-        auto int22_imag = [&](double rr){ return std::imag(integral22(rr)); };
-        double q21_real = boost::math::quadrature::gauss<double, 15>::integrate(int21_real,
-          m_radius - m_PMLThickness, m_radius, &error_estimate_Q1_integral21);
-        double q21_imag = boost::math::quadrature::gauss<double, 15>::integrate(int21_imag,
-          m_radius - m_PMLThickness, m_radius, &error_estimate_Q1_integral21);
-        Q1 = complex<double>(q21_real, q21_imag);
-        double q22_real = boost::math::quadrature::gauss<double, 15>::integrate(int22_real,
-          m_radius - m_PMLThickness, m_radius, &error_estimate_Q2_integral22);
-        double q22_imag = boost::math::quadrature::gauss<double, 15>::integrate(int22_imag,
-          m_radius - m_PMLThickness, m_radius, &error_estimate_Q2_integral22);
-        Q2 = complex<double>(q22_real, q22_imag);
-
-        DPML = (double)(m == n) * pow(m_BesselZeros[m] / m_radius, 2) + 
-          m_normModes[m] * m_normModes[n]  *
-          (1. + (double)(0 == m_BesselOrder[m])) * M_PI * (
-            m_BesselZeros[m] * m_BesselZeros[n] * Q1 / pow(m_radius, 2)
-            + pow(m_BesselOrder[m], 2) * Q2);
-        tripletDPML.push_back(Triplet(m, n, DPML));
-      }
+      if (m_BesselOrder[m] == m_BesselOrder[n]) { modePairs.push_back({ m, n }); }
     }
   }
 
+  // the integrals of the pairs of modes are independent and are computed 
+  // by the threads of the pool
+  vector<complex<double>> coefCPML(modePairs.size()), coefDPML(modePairs.size());
+  parallelLoop(modePairs.size(), simuParams.numThreads, [&](int p)
+    {
+      computePMLCoefficients(modePairs[p].first, modePairs[p].second,
+        coefCPML[p], coefDPML[p]);
+    });
+
+  vector<Triplet> tripletCPML, tripletDPML;
+  tripletCPML.reserve(modePairs.size());
+  tripletDPML.reserve(modePairs.size());
+  for (int p(0); p < modePairs.size(); p++)
+  {
+    tripletCPML.push_back(Triplet(modePairs[p].first, modePairs[p].second, coefCPML[p]));
+    tripletDPML.push_back(Triplet(modePairs[p].first, modePairs[p].second, coefDPML[p]));
+  }
+
   m_CPML.resize(m_modesNumber, m_modesNumber);
   m_CPML.setFromTriplets(tripletCPML.begin(), tripletCPML.end());
   m_DPML.resize(m_modesNumber, m_modesNumber);
@@ -1063,6 +1554,124 @@ void CrossSection2dRadiation::computeModes(struct simulationParameters simuParam
   m_eigVal = eig.eigenvalues();
   m_eigVec = eig.eigenvectors();
   m_invEigVec = m_eigVec.inverse();
+
+  memoiseModes(key);
+}
+
+// **************************************************************************
+// Modes of the radiation sections computed in the process: they only depend
+// on the dimensions of the section, so that the sections of the successive
+// geometries, which have generally the same radius, share them. The least
+// recently used modes are released when the memo exceeds its maximal size.
+
+// maximal memory of the memoised modes (bytes)
+static const size_t MAX_MEMOISED_RADIATION_MODES = 268435456;
+
+struct radiationModesMemo
+{
+  // most recently used first
+  list<pair<string, shared_ptr<const CrossSection2dRadiation>>> entries;
+  map<string, list<pair<string, shared_ptr<const CrossSection2dRadiation>>>::iterator> index;
+  size_t bytes = 0;
+  mutex memoMutex;
+};
+
+static radiationModesMemo& modesMemo()
+{
+  static radiationModesMemo memo;
+  return memo;
+}
+
+bool CrossSection2dRadiation::modesMemoised(const CacheKey& key)
+{
+  radiationModesMemo& memo(modesMemo());
+  lock_guard<mutex> lock(memo.memoMutex);
+  return memo.index.count(key.str()) > 0;
+}
+
+void CrossSection2dRadiation::memoiseModes(const CacheKey& key) const
+{
+  // the memoised section only holds the modes, not the propagation state
+  shared_ptr<CrossSection2dRadiation> sec(new CrossSection2dRadiation(
+    ctrLinePt(), normal(), m_radius, m_PMLThickness));
+  sec->copyRadiationModes(*this);
+
+  radiationModesMemo& memo(modesMemo());
+  lock_guard<mutex> lock(memo.memoMutex);
+  auto it(memo.index.find(key.str()));
+  if (it != memo.index.end())
+  {
+    memo.bytes -= it->second->second->memoryFootprint();
+    memo.entries.erase(it->second);
+  }
+  memo.entries.push_front(make_pair(key.str(), sec));
+  memo.index[key.str()] = memo.entries.begin();
+  memo.bytes += sec->memoryFootprint();
+
+  // the modes which have just been computed are always kept
+  while ((memo.bytes > MAX_MEMOISED_RADIATION_MODES) && (memo.entries.size() > 1))
+  {
+    memo.bytes -= memo.entries.back().second->memoryFootprint();
+    memo.index.erase(memo.entries.back().first);
+    memo.entries.pop_back();
+  }
+}
+
+bool CrossSection2dRadiation::restoreMemoisedModes(const CacheKey& key)
+{
+  shared_ptr<const CrossSection2dRadiation> sec;
+  {
+    radiationModesMemo& memo(modesMemo());
+    lock_guard<mutex> lock(memo.memoMutex);
+    auto it(memo.index.find(key.str()));
+    if (it == memo.index.end()) { return false; }
+    memo.entries.splice(memo.entries.begin(), memo.entries, it->second);
+    sec = it->second->second;
+  }
+  copyRadiationModes(*sec);
+  return true;
+}
+
+size_t CrossSection2dRadiation::memoisedModesFootprint()
+{
+  radiationModesMemo& memo(modesMemo());
+  lock_guard<mutex> lock(memo.memoMutex);
+  return memo.bytes;
+}
+
+void CrossSection2dRadiation::clearMemoisedModes()
+{
+  radiationModesMemo& memo(modesMemo());
+  lock_guard<mutex> lock(memo.memoMutex);
+  memo.entries.clear();
+  memo.index.clear();
+  memo.bytes = 0;
+}
+
+// **************************************************************************
+// Memory of the modes, the PML matrices and the propagation state
+
+size_t CrossSection2dRadiation::memoryFootprint() const
+{
+  return CrossSection2d::memoryFootprint()
+    + (m_eigVec.size() + m_invEigVec.size() + m_eigVal.size()) * sizeof(complex<double>)
+    + (m_CPML.nonZeros() + m_DPML.nonZeros()) * (sizeof(complex<double>) + sizeof(int))
+    + (m_BesselZeros.size() + m_normModes.size()) * sizeof(double)
+    + m_BesselOrder.size() * sizeof(int);
+}
+
+void CrossSection2dRadiation::copyRadiationModes(const CrossSection2dRadiation& sec)
+{
+  m_BesselZeros = sec.m_BesselZeros;
+  m_BesselOrder = sec.m_BesselOrder;
+  m_degeneration = sec.m_degeneration;
+  m_normModes = sec.m_normModes;
+  m_CPML = sec.m_CPML;
+  m_DPML = sec.m_DPML;
+  m_eigVec = sec.m_eigVec;
+  m_invEigVec = sec.m_invEigVec;
+  m_eigVal = sec.m_eigVal;
+  m_modesNumber = sec.m_modesNumber;
 }
 
 // **************************************************************************
@@ -1070,6 +1679,9 @@ void CrossSection2dRadiation::computeModes(struct simulationParameters simuParam
 
 void CrossSection2dFEM::selectModes(vector<int> modesIdx)
 {
+  // the modes no longer correspond to the ones computed
+  setDirty();
+
   int nPt = m_modes.rows();
   m_modesNumber = modesIdx.size();
   Matrix tmpModes(nPt, m_modesNumber);
@@ -1121,104 +1733,477 @@ void CrossSection2dFEM::selectModes(vector<int> modesIdx)
 }
 
 // **************************************************************************
-// Interpolate the propagation modes
-Matrix CrossSection2dFEM::interpolateModes(vector<Point> pts)
+// Key of the cache entry of the mesh and the modes: they depend only on the 
+// contour, the mesh spacing, the number of modes required and the maximal 
+// cut-on frequency
+
+CacheKey CrossSection2dFEM::modesCacheKey(const struct simulationParameters& simuParams) const
 {
-  int numPts = pts.size();
-  Matrix interpolation(numPts, m_modesNumber);
-  vector<Point> points;
-  vector<Point_value_map> values;
-  values.reserve(m_modesNumber);
-  Point_value_map tempValues;
-  Delaunay_triangulation T;
-  Coord_type l_value;
-  vector< pair< Point, Coord_type > > coords;
-  Coord_type norm;
-  bool ptNotFound(false);
+  CacheKey key;
 
-  ofstream log;
-  log.open("log.txt", ofstream::app);
+  for (auto it = m_contour.vertices_begin(); it != m_contour.vertices_end(); it++)
+  {
+    key.add(it->x());
+    key.add(it->y());
+  }
+  for (int i(0); i < m_surfaceIdx.size(); i++)
+  {
+    key.add(m_surfaceIdx[i]);
+  }
+  key.add(m_spacing);
+  key.add(m_modesNumber);
+  key.add(simuParams.maxCutOnFreq);
+  key.add(simuParams.sndSpeed);
+  key.add(simuParams.adaptiveMeshDensity);
+  key.add(simuParams.analyticModes);
+
+  return key;
+}
+
+// **************************************************************************
+// Key of the cache entry of the modes of a radiation section: they depend 
+// only on its radius, the thickness of the PML, the sound speed and the 
+// maximal cut-on frequency
 
-  // insert triangulation points
-  int numTriPts(m_points.size());
-  for (int i(0); i < numTriPts; ++i)
+CacheKey CrossSection2dRadiation::modesCacheKey(
+  const struct simulationParameters& simuParams) const
+{
+  CacheKey key;
+
+  // to distinguish the entries from the ones of the FEM cross-sections
+  key.add("radiation", 9);
+  key.add(m_radius);
+  key.add(m_PMLThickness);
+  key.add(simuParams.maxCutOnFreq);
+  key.add(simuParams.sndSpeed);
+
+  return key;
+}
+
+// **************************************************************************
+// Write the Bessel parameters, the PML matrices and the eigen decomposition
+// of a radiation section
+
+void CrossSection2dRadiation::writeModes(ostream& os) const
+{
+  vector<int> degeneration(m_degeneration.begin(), m_degeneration.end());
+
+  writeBinary(os, m_modesNumber);
+  writeBinary(os, m_BesselZeros);
+  writeBinary(os, m_BesselOrder);
+  writeBinary(os, degeneration);
+  writeBinary(os, m_normModes);
+  writeBinary(os, Eigen::MatrixXcd(m_CPML));
+  writeBinary(os, Eigen::MatrixXcd(m_DPML));
+  writeBinary(os, m_eigVec);
+  writeBinary(os, m_invEigVec);
+  writeBinary(os, Eigen::MatrixXcd(m_eigVal));
+}
+
+// **************************************************************************
+// Read the modes written by writeModes, they also become available to the
+// other radiation sections of the process
+
+bool CrossSection2dRadiation::readModes(istream& is)
+{
+  vector<int> degeneration;
+  Eigen::MatrixXcd CPML, DPML, eigVal;
+  if (!(readBinary(is, m_modesNumber) && readBinary(is, m_BesselZeros)
+    && readBinary(is, m_BesselOrder) && readBinary(is, degeneration)
+    && readBinary(is, m_normModes) && readBinary(is, CPML)
+    && readBinary(is, DPML) && readBinary(is, m_eigVec)
+    && readBinary(is, m_invEigVec) && readBinary(is, eigVal)))
+  {
+    return false;
+  }
+  if ((m_BesselZeros.size() != m_modesNumber) || (m_BesselOrder.size() != m_modesNumber)
+    || (degeneration.size() != m_modesNumber) || (m_normModes.size() != m_modesNumber)
+    || (CPML.rows() != m_modesNumber) || (DPML.rows() != m_modesNumber)
+    || (m_eigVec.rows() != m_modesNumber) || (m_invEigVec.rows() != m_modesNumber)
+    || (eigVal.size() != m_modesNumber))
   {
-    points.push_back(Point(m_points[i][0], m_points[i][1]));
-    T.insert(points.back());
+    return false;
   }
 
-  // create the point values maps
-  for (int m(0); m < m_modesNumber; m++)
+  m_degeneration.assign(degeneration.begin(), degeneration.end());
+  m_CPML = CPML.sparseView();
+  m_DPML = DPML.sparseView();
+  m_eigVal = Eigen::Map<Eigen::VectorXcd>(eigVal.data(), eigVal.size());
+
+  return true;
+}
+
+// **************************************************************************
+// Write the mesh, the modes and the matrices of the multimodal formulation
+
+void CrossSection2dFEM::writeModes(ostream& os) const
+{
+  writeBinary(os, m_points);
+  writeBinary(os, m_triangles);
+  writeBinary(os, m_meshContourSeg);
+  writeBinary(os, m_surfIdxList);
+  writeBinary(os, m_modesNumber);
+  writeBinary(os, m_eigenFreqs);
+  writeBinary(os, m_modes);
+  writeBinary(os, m_maxAmplitude);
+  writeBinary(os, m_minAmplitude);
+  writeBinary(os, m_C);
+  writeBinary(os, m_DN);
+  writeBinary(os, m_E);
+  writeBinary(os, m_DR);
+  writeBinary(os, m_KR2);
+}
+
+// **************************************************************************
+// Read the mesh and the modes written by writeModes and rebuild the 
+// triangulation from the mesh points and the contour segments
+
+bool CrossSection2dFEM::readModes(istream& is)
+{
+  if (!(readBinary(is, m_points) && readBinary(is, m_triangles)
+    && readBinary(is, m_meshContourSeg) && readBinary(is, m_surfIdxList)
+    && readBinary(is, m_modesNumber) && readBinary(is, m_eigenFreqs)
+    && readBinary(is, m_modes) && readBinary(is, m_maxAmplitude)
+    && readBinary(is, m_minAmplitude) && readBinary(is, m_C)
+    && readBinary(is, m_DN) && readBinary(is, m_E)
+    && readBinary(is, m_DR) && readBinary(is, m_KR2)))
   {
-    tempValues.clear();
-    for (int i(0); i < numTriPts; ++i)
+    return false;
+  }
+  if ((m_modes.rows() != m_points.size()) || (m_modes.cols() != m_modesNumber))
+  {
+    return false;
+  }
+
+  m_triangulation.reset();
+  buildInterpolator();
+
+  return true;
+}
+
+// **************************************************************************
+// Triangulation of the mesh, rebuilt from the compact arrays at the first 
+// call after the mesh has changed: the points of the mesh and the segments
+// of the contour are inserted and the faces outside of the contour removed.
+// It is not used by the simulation, and must not be called from several 
+// threads at the same time.
+
+const CDT& CrossSection2dFEM::triangulation() const
+{
+  if (m_triangulation) { return *m_triangulation; }
+
+  shared_ptr<CDT> mesh(new CDT());
+  vector<CDT::Vertex_handle> vertices;
+  vertices.reserve(m_points.size());
+  for (int i(0); i < m_points.size(); i++)
+  {
+    vertices.push_back(mesh->insert(Point(m_points[i][0], m_points[i][1])));
+    vertices.back()->info() = i;
+  }
+  for (int s(0); s < m_meshContourSeg.size(); s++)
+  {
+    mesh->insert_constraint(vertices[m_meshContourSeg[s][0]], 
+      vertices[m_meshContourSeg[s][1]]);
+  }
+
+  for (Finite_faces_iterator it = mesh->finite_faces_begin();
+    it != mesh->finite_faces_end(); ++it)
+  {
+    if (m_contour.has_on_unbounded_side(CGAL::centroid(mesh->triangle(it))))
     {
-      tempValues.insert(make_pair(points[i], m_modes(i, m)));
+      mesh->delete_face(it);
     }
-    values.push_back(tempValues);
   }
 
-  // insert points to interpolate
-  for (int i(0); i < numPts; i++)
+  m_triangulation = mesh;
+  return *m_triangulation;
+}
+
+// **************************************************************************
+// Copy the mesh, the modes and the junction matrices of a cross-section 
+// with the same contour and their dirty tracking keys
+
+void CrossSection2dFEM::copyModesAndJunction(const CrossSection2d& cs)
+{
+  const CrossSection2dFEM& sec(static_cast<const CrossSection2dFEM&>(cs));
+
+  m_triangulation = sec.m_triangulation;
+  m_points = sec.m_points;
+  m_triangles = sec.m_triangles;
+  m_meshContourSeg = sec.m_meshContourSeg;
+  m_interpolator = sec.m_interpolator;
+  m_surfIdxList = sec.m_surfIdxList;
+  m_modesNumber = sec.m_modesNumber;
+  m_eigenFreqs = sec.m_eigenFreqs;
+  m_modes = sec.m_modes;
+  m_maxAmplitude = sec.m_maxAmplitude;
+  m_minAmplitude = sec.m_minAmplitude;
+  m_C = sec.m_C;
+  m_DN = sec.m_DN;
+  m_E = sec.m_E;
+  m_DR = sec.m_DR;
+  m_KR2 = sec.m_KR2;
+  m_F = sec.m_F;
+
+  m_modesComputed = sec.m_modesComputed;
+  m_computedModesNumber = sec.m_computedModesNumber;
+  m_modesKey = sec.m_modesKey;
+  m_junctionComputed = sec.m_junctionComputed;
+  m_junctionKey = sec.m_junctionKey;
+}
+
+// **************************************************************************
+// Set the mesh and the modes from those of a cross-section whose contour is
+// the one of this cross-section divided by scaling (scaling <= 1). With the 
+// coordinates multiplied by scaling, the modes normalised on the section and
+// the eigenfrequencies are divided by scaling, and the multimodal matrices 
+// are multiplied by the power of scaling given by their integrands: 
+// C by scaling, DN and KR2 by 1 / scaling, E and DR are unchanged.
+// Only the modes below the maximal cut-on frequency are kept if the number 
+// of modes is not specified. Returns false if the cross-section has not
+// enough modes.
+
+bool CrossSection2dFEM::copyScaledModes(const CrossSection2d& cs, double scaling,
+  double maxCutOnFreq)
+{
+  const CrossSection2dFEM& sec(static_cast<const CrossSection2dFEM&>(cs));
+  int numModes(m_modesNumber);
+
+  if (numModes == 0)
   {
-    // it happens sometimes that the points of the intersection polygon lie slightly 
-    // outside of the contour, in this case bring it back on the boundary
-    if (m_contour.has_on_unbounded_side(pts[i]))
+    // a larger section could have more modes below the cut-on frequency
+    if (scaling > 1. + MINIMAL_DISTANCE) { return false; }
+    numModes = 1;
+    while ((numModes < sec.m_modesNumber) && 
+      (sec.m_eigenFreqs[numModes] / scaling < maxCutOnFreq)) { numModes++; }
+  }
+  else if (numModes > sec.m_modesNumber) { return false; }
+
+  // scale the mesh
+  m_triangulation.reset();
+  m_points = sec.m_points;
+  for (auto& pt : m_points) { pt[0] *= scaling; pt[1] *= scaling; }
+  m_triangles = sec.m_triangles;
+  m_meshContourSeg = sec.m_meshContourSeg;
+  m_surfIdxList = sec.m_surfIdxList;
+
+  // scale the modes
+  m_modesNumber = numModes;
+  m_eigenFreqs.assign(sec.m_eigenFreqs.begin(), sec.m_eigenFreqs.begin() + numModes);
+  m_maxAmplitude.assign(sec.m_maxAmplitude.begin(), sec.m_maxAmplitude.begin() + numModes);
+  m_minAmplitude.assign(sec.m_minAmplitude.begin(), sec.m_minAmplitude.begin() + numModes);
+  for (int m(0); m < numModes; m++)
+  {
+    m_eigenFreqs[m] /= scaling;
+    m_maxAmplitude[m] /= scaling;
+    m_minAmplitude[m] /= scaling;
+  }
+  m_modes = sec.m_modes.leftCols(numModes) / scaling;
+
+  // scale the multimodal matrices
+  m_C = sec.m_C.topLeftCorner(numModes, numModes) * scaling;
+  m_DN = sec.m_DN.topLeftCorner(numModes, numModes) / scaling;
+  m_E = sec.m_E.topLeftCorner(numModes, numModes);
+  m_DR.clear();
+  m_KR2.clear();
+  for (int s(0); s < sec.m_KR2.size(); s++)
+  {
+    m_DR.push_back(sec.m_DR[s].topLeftCorner(numModes, numModes));
+    m_KR2.push_back(sec.m_KR2[s].topLeftCorner(numModes, numModes) / scaling);
+  }
+
+  buildInterpolator();
+
+  return true;
+}
+
+// **************************************************************************
+// Interpolate the modes of a neighbouring cross-section at the points of the
+// mesh, to start the sparse eigensolver. The points outside of the contour 
+// of the neighbouring cross-section are set to 0, the subspace iteration 
+// correcting the guess anyway.
+
+void CrossSection2dFEM::setModesGuess(CrossSection2d& cs)
+{
+  m_modesGuess.resize(0, 0);
+  if (!cs.isFEM() || (cs.numberOfModes() == 0) || m_points.empty()) { return; }
+
+  const Polygon_2& contour(cs.contour());
+  vector<Point> pts;
+  vector<int> ptsIdx;
+  pts.reserve(m_points.size());
+  ptsIdx.reserve(m_points.size());
+  for (int i(0); i < m_points.size(); i++)
+  {
+    Point pt(m_points[i][0], m_points[i][1]);
+    if (!contour.has_on_unbounded_side(pt))
     {
-      pts[i] = bringBackPointInsideContour(m_contour, pts[i], m_spacing);
+      pts.push_back(pt);
+      ptsIdx.push_back(i);
     }
   }
+  if (pts.empty()) { return; }
+
+  Matrix interpolation;
+  cs.interpolateModes(pts, interpolation);
+  m_modesGuess = Matrix::Zero(m_points.size(), interpolation.cols());
+  for (int i(0); i < ptsIdx.size(); i++)
+  {
+    if (interpolation.row(i).allFinite())
+    {
+      m_modesGuess.row(ptsIdx[i]) = interpolation.row(i);
+    }
+  }
+}
+
+// **************************************************************************
+// Scale the eigenfrequencies for a new sound speed, the modes and the 
+// multimodal matrices are unchanged
+
+void CrossSection2dFEM::scaleEigenFrequencies(double factor)
+{
+  for (auto& f : m_eigenFreqs) { f *= factor; }
+}
+
+// **************************************************************************
+// Interpolate the propagation modes
+Matrix CrossSection2dFEM::interpolateModes(vector<Point> pts)
+{
+  Matrix interpolation;
+  interpolateModes(pts, interpolation);
+  return interpolation;
+}
+
+// **************************************************************************
+// Interpolate the propagation modes at a set of points with the natural
+// neighbor coordinates. The triangulation of the mesh points is built once 
+// and each interpolated mode value is a combination of the rows of m_modes.
+
+void CrossSection2dFEM::interpolateModes(const vector<Point>& pts, 
+  Matrix& interpolation)
+{
+  int numPts(pts.size());
+  typedef pair<Interpolation_triangulation::Vertex_handle, Coord_type> neighbor;
+  // reused between the calls of a thread to avoid allocations
+  static thread_local vector<neighbor> coords;
+  Coord_type norm;
+  Point pt;
+  Interpolation_triangulation::Face_handle hint;
+
+  if ((interpolation.rows() != numPts) || (interpolation.cols() != m_modesNumber))
+  {
+    interpolation.resize(numPts, m_modesNumber);
+  }
+  if (!m_interpolator) 
+  { 
+    interpolation.setConstant(NAN);
+    return; 
+  }
 
-  // interpolate the field
+  Interpolation_triangulation* triangulation(m_interpolator->acquire());
   for (int i(0); i < numPts; ++i)
   {
+    // it happens sometimes that the points of the intersection polygon lie slightly 
+    // outside of the contour, in this case bring it back on the boundary
+    pt = pts[i];
+    if (m_contour.has_on_unbounded_side(pt))
+    {
+      pt = bringBackPointInsideContour(m_contour, pt, m_spacing);
+    }
+
     // check if the point is inside the contour
-    if (m_contour.has_on_unbounded_side(pts[i]))
+    if (m_contour.has_on_unbounded_side(pt))
     {
-      log << "Error interpolating: point outside of the contour" << endl;
+      // the rows of the points which cannot be interpolated are NAN
       interpolation.row(i).setConstant(NAN); 
-      ptNotFound = true;
     }
     else
     {
-      //Coordinate_vector:
+      // the consecutive points are usually close, so the location starts
+      // from the face of the previous point
       coords.clear();
-      auto res = CGAL::natural_neighbor_coordinates_2(T, pts[i], std::back_inserter(coords));
+      auto res = CGAL::natural_neighbor_coordinates_2(*triangulation, 
+        pt, std::back_inserter(coords), CGAL::Identity<neighbor>(), hint);
       norm = res.second;
 
-      for (int m(0); m < m_modesNumber; ++m)
+      // linear interpolant
+      interpolation.row(i).setZero();
+      for (int j(0); j < coords.size(); j++)
       {
-        //linear interpolant:
-        l_value = CGAL::linear_interpolation(coords.begin(), coords.end(),
-          norm, Value_access(values[m]));
-        interpolation(i,m) = (double)l_value;
+        interpolation.row(i) += (coords[j].second / norm) * 
+          m_modes.row(coords[j].first->info()).head(m_modesNumber);
       }
+      if (coords.size() > 0) { hint = coords[0].first->face(); }
     }
   }
+  m_interpolator->release(triangulation);
+}
 
-  //// if a point have not been found export the points and contour
-  //if (ptNotFound)
-  //{
-  //  ofstream os("points.txt");
-  //  for (int i(0); i < pts.size(); i++)
-  //  {
-  //    os << pts[i].x() << "  " << pts[i].y() << endl;
-  //  }
-  //  os.close();
-  //  os.open("cont.txt");
-  //  auto it = m_contour.begin();
-  //  for (; it != m_contour.end(); it++)
-  //  {
-  //    os << it->x() << "  " << it->y() << endl;
-  //  }
-  //  it = m_contour.begin();
-  //  os << it->x() << "  " << it->y() << endl;
-  //  os.close();
-  //}
+// **************************************************************************
+// Build the Delaunay triangulation of the mesh points used for the 
+// interpolation of the modes
 
-  log.close();
-  
-  return interpolation;
+void CrossSection2dFEM::buildInterpolator()
+{
+  vector<pair<Point, int>> points;
+  points.reserve(m_points.size());
+  for (int i(0); i < m_points.size(); i++)
+  {
+    points.push_back(make_pair(Point(m_points[i][0], m_points[i][1]), i));
+  }
+
+  m_interpolator = shared_ptr<modesInterpolator>(new modesInterpolator());
+  m_interpolator->triangulation.insert(points.begin(), points.end());
+}
+
+// **************************************************************************
+// Copy of the triangulation for an interpolation: the copies are kept to be
+// reused by the next interpolations
+
+Interpolation_triangulation* modesInterpolator::acquire()
+{
+  lock_guard<mutex> lock(poolMutex);
+  if (available.empty())
+  {
+    copies.push_back(triangulation);
+    return &copies.back();
+  }
+  Interpolation_triangulation* T(available.back());
+  available.pop_back();
+  return T;
+}
+
+void modesInterpolator::release(Interpolation_triangulation* T)
+{
+  lock_guard<mutex> lock(poolMutex);
+  available.push_back(T);
+}
+
+// **************************************************************************
+// Memory of the mesh, the modes, the junction and propagation matrices and 
+// the propagation state
+
+size_t CrossSection2dFEM::memoryFootprint() const
+{
+  size_t bytes(CrossSection2d::memoryFootprint());
+  bytes += m_points.size() * sizeof(array<double, 2>) 
+    + m_triangles.size() * sizeof(array<int, 3>)
+    + m_meshContourSeg.size() * sizeof(array<int, 2>);
+  if (m_triangulation)
+  {
+    bytes += m_triangulation->number_of_vertices() * sizeof(CDT::Vertex)
+      + m_triangulation->number_of_faces() * sizeof(CDT::Face);
+  }
+  bytes += (m_modes.size() + m_Gstart.size() + m_Gend.size() + m_C.size()
+    + m_DN.size() + m_E.size()) * sizeof(double);
+  bytes += matricesBytes(m_F) + matricesBytes(m_DR) + matricesBytes(m_KR2);
+  if (m_sweepTables)
+  {
+    bytes += (m_sweepTables->characImped.size() + m_sweepTables->characAdmit.size()
+      + m_sweepTables->wallAdmit.size() + m_sweepTables->bndSpecAdm.size())
+      * sizeof(complex<double>);
+  }
+  return bytes;
 }
 
 // **************************************************************************
@@ -1245,6 +2230,25 @@ Matrix CrossSection2d::interpolateModes(vector<Point> pts, double scaling, Vecto
   return(interpolateModes(pts));
 }
 
+// **************************************************************************
+// Batched version of the interpolation with a scaling and a translation of 
+// the mesh: the transformed points are stored in a buffer kept by the thread
+// and the interpolation matrix is only resized if necessary
+
+void CrossSection2d::interpolateModes(const vector<Point>& pts, double scaling,
+  const Vector& translation, Matrix& interpolation)
+{
+  static thread_local vector<Point> transformedPts;
+  Transformation scale(CGAL::SCALING, scaling);
+  Transformation translate(CGAL::TRANSLATION, translation);
+
+  transformedPts.resize(pts.size());
+  for (int i(0); i < pts.size(); i++) {
+    transformedPts[i] = scale(translate(pts[i]));
+  }
+  interpolateModes(transformedPts, interpolation);
+}
+
 // **************************************************************************
 // Compute mode amplitude for the radiation cross-section
 
@@ -1299,51 +2303,51 @@ Matrix CrossSection2dRadiation::interpolateModes(vector<Point> pts)
 
 // **************************************************************************
 // Functions to set and get impedance, and admittance
-void CrossSection2d::setZin(Eigen::MatrixXcd imped) { 
-  if (m_impedance.size() == 0)
+void CrossSection2d::setZin(const Eigen::MatrixXcd& imped) { 
+  if (state().impedance.size() == 0)
   {
-    m_impedance.push_back(imped);
+    state().impedance.push_back(imped);
   }
   else
   {
-    if (Zdir() == 1) { m_impedance.back() = imped; }
-    else { m_impedance[0] = imped; }
+    if (Zdir() == 1) { state().impedance.back() = imped; }
+    else { state().impedance[0] = imped; }
   }
 }
 
-void CrossSection2d::setZout(Eigen::MatrixXcd imped) {
-  if (m_impedance.size() == 0)
+void CrossSection2d::setZout(const Eigen::MatrixXcd& imped) {
+  if (state().impedance.size() == 0)
   {
-    m_impedance.push_back(imped);
+    state().impedance.push_back(imped);
   }
   else
   {
-    if (Zdir() == 1) { m_impedance[0] = imped; }
-    else { m_impedance.back() = imped; }
+    if (Zdir() == 1) { state().impedance[0] = imped; }
+    else { state().impedance.back() = imped; }
   }
 }
 
-void CrossSection2d::setYin(Eigen::MatrixXcd admit) {
-  if (m_admittance.size() == 0)
+void CrossSection2d::setYin(const Eigen::MatrixXcd& admit) {
+  if (state().admittance.size() == 0)
   {
-    m_admittance.push_back(admit);
+    state().admittance.push_back(admit);
   }
   else
   {
-    if (Ydir() == 1) { m_admittance.back() = admit; }
-    else { m_admittance[0] = admit; }
+    if (Ydir() == 1) { state().admittance.back() = admit; }
+    else { state().admittance[0] = admit; }
   }
 }
 
-void CrossSection2d::setYout(Eigen::MatrixXcd admit) {
-  if (m_admittance.size() == 0)
+void CrossSection2d::setYout(const Eigen::MatrixXcd& admit) {
+  if (state().admittance.size() == 0)
   {
-    m_admittance.push_back(admit);
+    state().admittance.push_back(admit);
   }
   else
   {
-    if (Ydir() == 1) { m_admittance[0] = admit; }
-    else { m_admittance.back() = admit; }
+    if (Ydir() == 1) { state().admittance[0] = admit; }
+    else { state().admittance.back() = admit; }
   }
 }
 
@@ -1352,9 +2356,15 @@ void CrossSection2d::setYout(Eigen::MatrixXcd admit) {
 
 void CrossSection2dFEM::characteristicImpedance(
   Eigen::MatrixXcd& characImped,
-  double freq, struct simulationParameters simuParams)
+  double freq, const struct simulationParameters& simuParams)
 {
   characImped = Eigen::MatrixXcd::Zero(m_modesNumber, m_modesNumber);
+  int idx(sweepTableIndex(freq));
+  if (idx >= 0)
+  {
+    characImped.diagonal() = m_sweepTables->characImped.col(idx);
+    return;
+  }
   double k(2 * M_PI * freq / simuParams.sndSpeed);
   complex<double> diag;
 
@@ -1382,7 +2392,7 @@ void CrossSection2dFEM::characteristicImpedance(
 }
 
 void CrossSection2dRadiation::characteristicImpedance(
-  Eigen::MatrixXcd& characImped, double freq, struct simulationParameters simuParams)
+  Eigen::MatrixXcd& characImped, double freq, const struct simulationParameters& simuParams)
 {
   double k2(pow(2 * M_PI * freq / simuParams.sndSpeed,2));
   SparseMatC Id(m_modesNumber, m_modesNumber);
@@ -1399,9 +2409,15 @@ void CrossSection2dRadiation::characteristicImpedance(
 // Compute characteristic admittance
 
 void CrossSection2dFEM::characteristicAdmittance(
-  Eigen::MatrixXcd& admit, double freq, struct simulationParameters simuParams)
+  Eigen::MatrixXcd& admit, double freq, const struct simulationParameters& simuParams)
 {
   admit = Eigen::MatrixXcd::Zero(m_modesNumber, m_modesNumber);
+  int idx(sweepTableIndex(freq));
+  if (idx >= 0)
+  {
+    admit.diagonal() = m_sweepTables->characAdmit.col(idx);
+    return;
+  }
   double k(2 * M_PI * freq / simuParams.sndSpeed);
   complex<double> diag;
 
@@ -1431,7 +2447,7 @@ void CrossSection2dFEM::characteristicAdmittance(
 }
 
 void CrossSection2dRadiation::characteristicAdmittance(
-  Eigen::MatrixXcd& admit, double freq, struct simulationParameters simuParams)
+  Eigen::MatrixXcd& admit, double freq, const struct simulationParameters& simuParams)
 {
   double k2(pow(2 * M_PI * freq / simuParams.sndSpeed,2));
 
@@ -1443,8 +2459,11 @@ void CrossSection2dRadiation::characteristicAdmittance(
 // Compute wall admittance
 
 complex<double> CrossSection2dFEM::getWallAdmittance(
-  struct simulationParameters simuParams, double freq)
+  const struct simulationParameters& simuParams, double freq)
 {
+  int idx(sweepTableIndex(freq));
+  if (idx >= 0) { return m_sweepTables->wallAdmit(idx); }
+
   if (simuParams.wallLosses)
   {
     return(-simuParams.percentageLosses*(-simuParams.volumicMass * simuParams.sndSpeed *
@@ -1455,191 +2474,847 @@ complex<double> CrossSection2dFEM::getWallAdmittance(
   }
   else
   {
-    return(complex<double>(0., 0.));
+    return(complex<double>(0., 0.));
+  }
+}
+
+// **************************************************************************
+// Compute boundary specific admittance for visco thermal losses
+
+void CrossSection2dFEM::getSpecificBndAdm(const struct simulationParameters& simuParams, double freq, 
+  Eigen::VectorXcd& bndSpecAdm)
+{
+  int idx(sweepTableIndex(freq));
+  if (idx >= 0)
+  {
+    bndSpecAdm = m_sweepTables->bndSpecAdm.col(idx);
+    return;
+  }
+
+  if (simuParams.viscoThermalLosses)
+  {
+    bndSpecAdm.resize(m_modesNumber);
+    bndSpecAdm.setZero();
+    double k(2. * M_PI * freq / simuParams.sndSpeed);
+    for (int m(0); m < m_modesNumber; m++)
+    {
+      bndSpecAdm(m) = simuParams.percentageLosses * (
+        ((1. - pow(2 * M_PI * m_eigenFreqs[m] / simuParams.sndSpeed, 2) / pow(k, 2)) *
+        simuParams.viscousBndSpecAdm + simuParams.thermalBndSpecAdm) * sqrt(freq));
+    }
+  }
+  else if (simuParams.constantWallImped)
+  {
+    bndSpecAdm.resize(m_modesNumber);
+    bndSpecAdm.setConstant(simuParams.percentageLosses * simuParams.wallAdmit);
+  }
+  else
+  {
+    bndSpecAdm.resize(m_modesNumber);
+    bndSpecAdm.setZero();
+  }
+}
+
+// **************************************************************************
+// Tabulate the characteristic impedance and admittance, the wall admittance
+// and the boundary specific admittance at the frequencies of a sweep: the
+// square roots of all the modes and frequencies are computed at once
+
+void CrossSection2dFEM::precomputeSweepTables(const vector<double>& freqs,
+  const struct simulationParameters& simuParams)
+{
+  m_sweepTables.reset();
+  if (freqs.empty()) { return; }
+
+  int mn(m_modesNumber), nf(freqs.size());
+  shared_ptr<sweepTables> tables(new sweepTables);
+  tables->freqs = freqs;
+
+  Eigen::ArrayXd f(Eigen::Map<const Eigen::ArrayXd>(freqs.data(), nf));
+  Eigen::ArrayXd k2((2. * M_PI * f / simuParams.sndSpeed).square());
+  Eigen::ArrayXd kt2(mn);
+  for (int i(0); i < mn; i++)
+  {
+    kt2(i) = pow(2 * M_PI * m_eigenFreqs[i] / simuParams.sndSpeed, 2);
+  }
+  // difference of the squared wave numbers (modes x frequencies)
+  Eigen::ArrayXXd dk2(kt2.replicate(1, nf) - k2.transpose().replicate(mn, 1));
+
+  switch (simuParams.propMethod)
+  {
+  case MAGNUS:
+    tables->characAdmit = dk2.cast<complex<double>>().sqrt().matrix();
+    tables->characImped = tables->characAdmit.cwiseInverse();
+    break;
+  case STRAIGHT_TUBES:
+  {
+    Eigen::ArrayXXcd kn((-dk2).cast<complex<double>>().sqrt());
+    Eigen::ArrayXcd omegaRho((simuParams.volumicMass * 2 * M_PI * f).cast<complex<double>>());
+    tables->characAdmit = ((kn * m_area).rowwise() / omegaRho.transpose()).matrix();
+    tables->characImped = tables->characAdmit.cwiseInverse();
+    // propagation factors of all the modes and frequencies at once
+    tables->tubeCos = (kn * m_length).cos().matrix();
+    tables->tubeSin = (1i * (kn * m_length).sin()).matrix();
+    break;
+  }
+  }
+
+  tables->wallAdmit.resize(nf);
+  for (int j(0); j < nf; j++)
+  {
+    tables->wallAdmit(j) = getWallAdmittance(simuParams, freqs[j]);
+  }
+
+  if (simuParams.viscoThermalLosses)
+  {
+    Eigen::ArrayXXcd ratio((1. - kt2.replicate(1, nf) / 
+      k2.transpose().replicate(mn, 1)).cast<complex<double>>());
+    Eigen::ArrayXcd sqrtFreq(f.sqrt().cast<complex<double>>());
+    tables->bndSpecAdm = (simuParams.percentageLosses * (ratio * 
+      simuParams.viscousBndSpecAdm + simuParams.thermalBndSpecAdm)).rowwise() *
+      sqrtFreq.transpose();
+  }
+  else if (simuParams.constantWallImped)
+  {
+    tables->bndSpecAdm.setConstant(mn, nf, 
+      simuParams.percentageLosses * simuParams.wallAdmit);
+  }
+  else
+  {
+    tables->bndSpecAdm.setZero(mn, nf);
+  }
+
+  m_sweepTables = tables;
+}
+
+// **************************************************************************
+// Column of a frequency in the sweep tables (-1 if it is not one of the 
+// frequencies of the sweep or if the modes have changed since)
+
+int CrossSection2dFEM::sweepTableIndex(double freq) const
+{
+  if (!m_sweepTables || (m_sweepTables->characImped.rows() != m_modesNumber)) 
+  { 
+    return -1; 
+  }
+  const vector<double>& freqs(m_sweepTables->freqs);
+  auto it(lower_bound(freqs.begin(), freqs.end(), freq));
+  if ((it == freqs.end()) || (*it != freq)) { return -1; }
+  return it - freqs.begin();
+}
+
+// **************************************************************************
+// Return the curvature
+
+double CrossSection2dFEM::curvature(bool curved) 
+{ 
+  if (curved) { return  1. / m_curvatureRadius; }
+  else { return 0.; }
+}
+
+// **************************************************************************
+// Set the area variation profile type
+void CrossSection2dFEM::setAreaVariationProfileType(enum areaVariationProfile profile)
+{
+  m_areaProfile = profile;
+}
+
+// **************************************************************************
+// scaling function
+
+double CrossSection2dFEM::scaling(double tau)
+{
+  switch (m_areaProfile)
+  {
+  case LINEAR:
+    return (m_scalingFactors[1] - m_scalingFactors[0]) * tau
+      + m_scalingFactors[0];
+    break;
+  case GAUSSIAN:
+    return (1. + 0.75*exp(-pow(0.3*(tau - 0.5),2)/2./pow(0.04,2)));
+    break;
+  case ELEPHANT:
+    return (0.25*(1 + 9.*pow(tau, 2) - 6.*pow(tau, 3))); // l = [0.25 1]
+    break;
+  }
+}
+
+// **************************************************************************
+// The scaling is constant if it varies linearly between two equal factors
+
+bool CrossSection2dFEM::constantScaling() const
+{
+  return (m_areaProfile == LINEAR) && (m_scalingFactors[0] == m_scalingFactors[1]);
+}
+
+// **************************************************************************
+// derivative of the scaling function
+ 
+double CrossSection2dFEM::scalingDerivative(double tau)
+{
+  // compute the length of the section
+  double al;
+  if (abs(m_circleArcAngle) < MINIMAL_DISTANCE)
+  {
+      al = m_length;
+  }
+  else
+  {
+      al = abs(m_circleArcAngle) * abs(m_curvatureRadius);
+  }
+
+  switch (m_areaProfile)
+  {
+  case LINEAR:
+    return((m_scalingFactors[1] - m_scalingFactors[0])/ al); 
+    break;
+  case GAUSSIAN:
+    return(-0.75*0.09*(tau - 0.5)*
+       exp(-pow(0.3*(tau - 0.5),2)/2./pow(0.04,2))
+       /pow(0.04, 2)/30.);
+    break;
+  case ELEPHANT:
+    return (9.*tau*(1. - tau)/16.95/2.); // l = [0.25 1]
+  }
+}
+
+// **************************************************************************
+// Number of modes coupled in the Magnus scheme at a given frequency. The 
+// modes being sorted by increasing cut-on frequency, the coupled modes are 
+// the first ones.
+
+int CrossSection2dFEM::numCoupledModes(double freq, 
+  const struct simulationParameters& simuParams) const
+{
+  if (PlaneWaveScope::active()) { return min(1, m_modesNumber); }
+  if (!simuParams.freqDependentModes) { return m_modesNumber; }
+
+  double maxFreq(simuParams.modesFreqFactor * freq + simuParams.modesFreqMargin);
+  int num(1);
+  while ((num < m_modesNumber) && (m_eigenFreqs[num] < maxFreq)) { num++; }
+  return num;
+}
+
+// **************************************************************************
+// Conversion of the matrices to and from the precision of the propagation 
+// along the Magnus steps (nothing is copied in double precision)
+
+// only the propagators actually used (idxPropagator[i] == i) are converted
+static const vector<Eigen::MatrixXcd>& propagatorsToStepPrecision(
+  const vector<Eigen::MatrixXcd>& propagators, const vector<int>&,
+  vector<Eigen::MatrixXcd>&)
+{
+  return propagators;
+}
+
+static const vector<Eigen::MatrixXcf>& propagatorsToStepPrecision(
+  const vector<Eigen::MatrixXcd>& propagators, const vector<int>& idxPropagator,
+  vector<Eigen::MatrixXcf>& buffer)
+{
+  buffer.resize(propagators.size());
+  for (int i(0); i < idxPropagator.size(); i++)
+  {
+    if (idxPropagator[i] == i) { buffer[i] = propagators[i].cast<complex<float>>(); }
+  }
+  return buffer;
+}
+
+// impedance or admittance of the points of the segment, from which the 
+// pressure or the velocity is propagated
+static const vector<Eigen::MatrixXcd>& coefficientsToStepPrecision(
+  const vector<Eigen::MatrixXcd>& coefficients, vector<Eigen::MatrixXcd>&)
+{
+  return coefficients;
+}
+
+static const vector<Eigen::MatrixXcf>& coefficientsToStepPrecision(
+  const vector<Eigen::MatrixXcd>& coefficients, vector<Eigen::MatrixXcf>& buffer)
+{
+  buffer.resize(coefficients.size());
+  for (int i(0); i < coefficients.size(); i++)
+  {
+    buffer[i] = coefficients[i].cast<complex<float>>();
+  }
+  return buffer;
+}
+
+// propagated quantity: in double precision, the recursion is done in place 
+// in Q, in single precision, only its first point is converted before the 
+// recursion and the other points are converted back after it
+static vector<Eigen::MatrixXcd>& profileToStepPrecision(
+  vector<Eigen::MatrixXcd>& Q, vector<Eigen::MatrixXcd>&)
+{
+  return Q;
+}
+
+static vector<Eigen::MatrixXcf>& profileToStepPrecision(
+  vector<Eigen::MatrixXcd>& Q, vector<Eigen::MatrixXcf>& buffer)
+{
+  buffer.resize(Q.size());
+  buffer[0] = Q[0].cast<complex<float>>();
+  return buffer;
+}
+
+static void profileFromStepPrecision(const vector<Eigen::MatrixXcd>&,
+  vector<Eigen::MatrixXcd>&)
+{
+}
+
+static void profileFromStepPrecision(const vector<Eigen::MatrixXcf>& profile,
+  vector<Eigen::MatrixXcd>& Q)
+{
+  for (int i(1); i < Q.size(); i++) { Q[i] = profile[i].cast<complex<double>>(); }
+}
+
+// **************************************************************************
+// Propagate a quantity over the step i of the Magnus scheme with the 
+// propagator omega of the step, from its value prev at the point i: the 
+// value at the point i + 1 is stored in ws.step. coefficient is the 
+// admittance (pressure) or the impedance (velocity) at the point numX - 1 - i,
+// it is not used for the impedance and the admittance.
+
+template <class MatrixType>
+static void magnusStep(const MatrixType& omega, int mn,
+  enum physicalQuantity quant, const MatrixType* coefficient, const MatrixType& prev,
+  magnusStepWorkspace<MatrixType>& ws)
+{
+  switch (quant)
+  {
+  case IMPEDANCE:
+    ws.numerator.noalias() = omega.block(0, 0, mn, mn) * prev;
+    ws.numerator += omega.block(0, mn, mn, mn);
+    ws.denominator.noalias() = omega.block(mn, 0, mn, mn) * prev;
+    ws.denominator += omega.block(mn, mn, mn, mn);
+    ws.lu.compute(ws.denominator);
+    ws.inverse = ws.lu.inverse();
+    ws.step.noalias() = ws.numerator * ws.inverse;
+    break;
+  case ADMITTANCE:
+    ws.numerator.noalias() = omega.block(mn, mn, mn, mn) * prev;
+    ws.numerator += omega.block(mn, 0, mn, mn);
+    ws.denominator.noalias() = omega.block(0, mn, mn, mn) * prev;
+    ws.denominator += omega.block(0, 0, mn, mn);
+    ws.lu.compute(ws.denominator);
+    ws.inverse = ws.lu.inverse();
+    ws.step.noalias() = ws.numerator * ws.inverse;
+    break;
+  case PRESSURE:
+    ws.numerator.noalias() = omega.block(0, mn, mn, mn) * (*coefficient);
+    ws.numerator += omega.block(0, 0, mn, mn);
+    ws.step.noalias() = ws.numerator * prev;
+    break;
+  case VELOCITY:
+    ws.numerator.noalias() = omega.block(mn, 0, mn, mn) * (*coefficient);
+    ws.numerator += omega.block(mn, mn, mn, mn);
+    ws.step.noalias() = ws.numerator * prev;
+  }
+}
+
+// **************************************************************************
+// Propagate a quantity along the steps of the Magnus scheme with the 
+// propagators of the steps. The recursion is done in the precision of 
+// MatrixType and the result is stored in double precision in Q, at the 
+// points multiple of storeInterval and at the last point.
+
+template <class MatrixType>
+static void propagateMagnusSteps(const vector<Eigen::MatrixXcd>& propagatorsDouble,
+  const vector<int>& idxPropagator, int numX, int mn, enum physicalQuantity quant,
+  int storeInterval, propagationState& st, vector<Eigen::MatrixXcd>& Q,
+  magnusStepWorkspace<MatrixType>& ws)
+{
+  int iPrev, iNext;
+  const vector<MatrixType>& propagators(propagatorsToStepPrecision(
+    propagatorsDouble, idxPropagator, ws.propagators));
+  vector<MatrixType>& profile(profileToStepPrecision(Q, ws.profile));
+  const vector<MatrixType>* coefficients(NULL);
+  if (quant == PRESSURE)
+  {
+    coefficients = &coefficientsToStepPrecision(st.admittance, ws.coefficients);
+  }
+  else if (quant == VELOCITY)
+  {
+    coefficients = &coefficientsToStepPrecision(st.impedance, ws.coefficients);
+  }
+  ws.numerator.resize(mn, mn);
+  ws.denominator.resize(mn, mn);
+  ws.inverse.resize(mn, mn);
+
+  for (int i(0); i < numX - 1; i++)
+  {
+    // compute the propagated quantity at the next point (the points between
+    // two stored ones are written in the slot of the next stored point, 
+    // which is overwritten at each step until it is reached)
+    iPrev = (i + storeInterval - 1) / storeInterval;
+    iNext = (i + storeInterval) / storeInterval;
+    magnusStep(propagators[idxPropagator[i]], mn, quant,
+      (coefficients == NULL) ? NULL : &(*coefficients)[numX - 1 - i],
+      profile[iPrev], ws);
+    profile[iNext].swap(ws.step);
+  }
+  profileFromStepPrecision(profile, Q);
+}
+
+// **************************************************************************
+// Compute the matrix KR2 at this frequency and the blocks of the matrices 
+// of the Magnus scheme which do not depend on the scaling, restricted to 
+// the na coupled modes
+
+void CrossSection2dFEM::prepareMagnusBlocks(const struct simulationParameters& simuParams,
+  double freq, int na, magnusWorkspace& ws)
+{
+  int mn(m_modesNumber);
+  double curv(curvature(simuParams.curved));
+  Eigen::VectorXcd bndSpecAdm(Eigen::VectorXcd::Zero(mn));
+
+  // compute wall admittance
+  complex<double> wallAdmittance(getWallAdmittance(simuParams, freq));
+
+  // compute boundary specific admittance
+  getSpecificBndAdm(simuParams, freq, bndSpecAdm);
+
+  // compute matrix KR2: the sum of the matrices of the boundary segments
+  // is multiplied once by their admittance
+  ws.KR2.setZero(mn, mn);
+  if (m_KR2.size() > 0)
+  {
+    ws.sumKR2 = m_KR2[0];
+    for (int s(1); s < m_KR2.size(); s++) { ws.sumKR2 += m_KR2[s]; }
+    ws.KR2.noalias() = ws.sumKR2.cast<complex<double>>() *
+      (bndSpecAdm.array() + wallAdmittance).matrix().asDiagonal();
+  }
+
+  // frequency independent blocks of the matrices of the coupled modes
+  ws.eigenWaveNumbers2.resize(mn);
+  for (int j(0); j < mn; j++)
+  {
+    ws.eigenWaveNumbers2(j) = pow(2 * M_PI * m_eigenFreqs[j] / simuParams.sndSpeed, 2);
+  }
+  ws.E = m_E.topLeftCorner(na, na).cast<complex<double>>();
+  ws.ET = ws.E.transpose();
+  ws.curvC = (curv * m_C.topLeftCorner(na, na)).cast<complex<double>>();
+  ws.curvDN = (curv * m_DN.topLeftCorner(na, na)).cast<complex<double>>();
+}
+
+// **************************************************************************
+// Matrix of the Magnus scheme of the na coupled modes for the scaling l and 
+// its derivative dl: the blocks are written in place from the precomputed 
+// blocks, with K2 = diag(eigenWaveNumbers2) - (k l)^2 I + i k l KR2.
+// The terms of the curvature, of the area variation and of the losses are 
+// only formed if the corresponding template parameter is true.
+
+template <bool curved, bool varyingArea, bool lossy, class CoupledMatrix>
+static void buildMagnusMatrixKernel(double k, double curv, double l,
+  double dl, int na, const magnusWorkspace& ws, CoupledMatrix& A)
+{
+  double kl2(pow(k * l, 2));
+  A.resize(2 * na, 2 * na);
+  if (varyingArea)
+  {
+    A.topLeftCorner(na, na) = (dl / l) * ws.E;
+    A.bottomRightCorner(na, na) = (-dl / l) * ws.ET;
+  }
+  else
+  {
+    A.topLeftCorner(na, na).setZero();
+    A.bottomRightCorner(na, na).setZero();
+  }
+  if (curved)
+  {
+    A.topRightCorner(na, na) = (-1. / l) * ws.curvC;
+    A.bottomLeftCorner(na, na) = (l * kl2) * ws.curvC - l * ws.curvDN;
+  }
+  else
+  {
+    A.topRightCorner(na, na).setZero();
+    A.bottomLeftCorner(na, na).setZero();
+  }
+  A.topRightCorner(na, na).diagonal().array() += 1. / pow(l, 2);
+  if (lossy)
+  {
+    A.bottomLeftCorner(na, na) += (1i * k * l) * ws.KR2.topLeftCorner(na, na);
+  }
+  A.bottomLeftCorner(na, na).diagonal().array() += 
+    ws.eigenWaveNumbers2.head(na).array() - kl2;
+}
+
+// **************************************************************************
+// Matrix of the Magnus scheme of the na coupled modes with all its terms
+
+void CrossSection2dFEM::buildMagnusMatrix(double k, double curv, double l,
+  double dl, int na, const magnusWorkspace& ws, Eigen::MatrixXcd& A) const
+{
+  buildMagnusMatrixKernel<true, true, true>(k, curv, l, dl, na, ws, A);
+}
+
+// **************************************************************************
+// Number of integration points of the Magnus scheme needed in this segment
+// at the frequency freq. The difference between the exponents of the order 4 
+// and order 2 schemes on a step is an estimate of the local error of the 
+// order 2 scheme: the number of steps is doubled until the sum of these 
+// estimates over the segment is lower than the tolerance, or until the 
+// maximal number of points simuParams.numIntegrationStep is reached.
+
+int CrossSection2dFEM::adaptiveIntegrationStep(
+  const struct simulationParameters& simuParams, double freq)
+{
+  int maxNumX(max(2, simuParams.numIntegrationStep));
+  if ((m_length == 0.) || (m_modesNumber == 0)) { return maxNumX; }
+
+  double al(length());
+  double curv(curvature(simuParams.curved));
+  double k(2 * M_PI * freq / simuParams.sndSpeed);
+  int na(numCoupledModes(freq, simuParams));
+  magnusWorkspace ws;
+  Eigen::MatrixXcd A0, A1, Am, diff;
+  prepareMagnusBlocks(simuParams, freq, na, ws);
+
+  for (int numX(2); numX < maxNumX; numX = 2 * numX - 1)
+  {
+    double dX(al / (double)(numX - 1));
+    double error(0.);
+    for (int i(0); (i < numX - 1) && (error <= simuParams.integrationStepTolerance); i++)
+    {
+      double tau0(((double)i + 0.5 - sqrt(3) / 6.) / (double)(numX - 1));
+      double tau1(((double)i + 0.5 + sqrt(3) / 6.) / (double)(numX - 1));
+      double taum(((double)i + 0.5) / (double)(numX - 1));
+      buildMagnusMatrix(k, curv, scaling(tau0), scalingDerivative(tau0), na, ws, A0);
+      buildMagnusMatrix(k, curv, scaling(tau1), scalingDerivative(tau1), na, ws, A1);
+      buildMagnusMatrix(k, curv, scaling(taum), scalingDerivative(taum), na, ws, Am);
+      diff.noalias() = A1 * A0;
+      diff.noalias() -= A0 * A1;
+      diff *= sqrt(3) * dX / 12.;
+      diff += 0.5 * (A0 + A1) - Am;
+      error += dX * diff.norm();
+    }
+    if (error <= simuParams.integrationStepTolerance) { return numX; }
+  }
+  return maxNumX;
+}
+
+// **************************************************************************
+// Kernels computing the propagators of the steps of the Magnus scheme, 
+// specialised at compile time on the order of the scheme and on the terms 
+// present in the matrices (curvature, area variation, losses), so that the 
+// configuration is not tested at each step. When the coupled modes are few,
+// their matrices have a bounded size and are stored on the stack.
+
+// maximal size of the matrices of the coupled modes stored on the stack
+static const int MAX_SMALL_MAGNUS_SIZE(16);
+typedef Eigen::Matrix<complex<double>, Eigen::Dynamic, Eigen::Dynamic,
+  Eigen::ColMajor, MAX_SMALL_MAGNUS_SIZE, MAX_SMALL_MAGNUS_SIZE> smallMagnusMatrix;
+
+struct magnusKernelParameters
+{
+  double k;         // wavenumber
+  double curv;      // curvature
+  double dX;        // integration step (signed)
+  double direction; // direction of the propagation
+  int numX;         // number of integration points
+  int na;           // number of coupled modes
+};
+
+typedef void (*magnusKernel)(CrossSection2dFEM&, const magnusKernelParameters&,
+  magnusWorkspace&);
+
+// 2 x 2 matrix of an uncoupled mode (diagonal terms of the full matrix)
+template <bool curved, bool varyingArea, bool lossy>
+static Eigen::Matrix2cd uncoupledMagnusMatrix(const CrossSection2dFEM& sec, 
+  int j, double k, double curv, double l, double dl, const magnusWorkspace& ws)
+{
+  double kl2(pow(k * l, 2));
+  complex<double> e(varyingArea ? (dl / l) * sec.getMatrixE()(j, j) : 0.);
+  complex<double> K2(ws.eigenWaveNumbers2(j) - kl2);
+  double c(0.);
+  if (curved)
+  {
+    c = curv * l * sec.getMatrixC()(j, j);
+    K2 += curv * l * (sec.getMatrixC()(j, j) * kl2 - sec.getMatrixD()(j, j));
+  }
+  if (lossy) { K2 += 1i * k * l * ws.KR2(j, j); }
+  Eigen::Matrix2cd A;
+  A << e, (1. - c) / pow(l, 2), K2, -e;
+  return A;
+}
+
+// propagator of all the modes from the exponentials of the coupled 
+// and uncoupled modes
+template <class CoupledMatrix>
+static void assembleMagnusPropagator(const CoupledMatrix& expCoupled,
+  const vector<Eigen::Matrix2cd>& expUncoupled, int na, int mn, 
+  Eigen::MatrixXcd& omega)
+{
+  if (na == mn) { omega = expCoupled; return; }
+  omega.setZero(2 * mn, 2 * mn);
+  omega.block(0, 0, na, na) = expCoupled.block(0, 0, na, na);
+  omega.block(0, mn, na, na) = expCoupled.block(0, na, na, na);
+  omega.block(mn, 0, na, na) = expCoupled.block(na, 0, na, na);
+  omega.block(mn, mn, na, na) = expCoupled.block(na, na, na, na);
+  for (int j(na); j < mn; j++)
+  {
+    omega(j, j) = expUncoupled[j - na](0, 0);
+    omega(j, mn + j) = expUncoupled[j - na](0, 1);
+    omega(mn + j, j) = expUncoupled[j - na](1, 0);
+    omega(mn + j, mn + j) = expUncoupled[j - na](1, 1);
   }
 }
 
-// **************************************************************************
-// Compute boundary specific admittance for visco thermal losses
-
-void CrossSection2dFEM::getSpecificBndAdm(struct simulationParameters simuParams, double freq, 
-  Eigen::VectorXcd& bndSpecAdm)
+// Propagators of the steps: they only depend on the frequency and on the 
+// scaling, not on the propagated quantity. A step whose scaling is the same
+// as the one of the previous step uses the propagator of the previous step.
+// With a constant scaling the two points of the order 4 scheme give the same
+// matrix, so that the commutator vanishes and the order 2 exponential is used.
+template <int order, bool curved, bool varyingArea, bool lossy, class CoupledMatrix>
+static void computeMagnusPropagators(CrossSection2dFEM& sec,
+  const magnusKernelParameters& p, magnusWorkspace& ws, CoupledMatrix& A0,
+  CoupledMatrix& A1, CoupledMatrix& expA, CoupledMatrix& commutator)
 {
-  if (simuParams.viscoThermalLosses)
+  int numX(p.numX), na(p.na), mn(sec.numberOfModes());
+  double k(p.k), curv(p.curv), dX(p.dX);
+  vector<Eigen::Matrix2cd>& B0(ws.B0), & B1(ws.B1), & expB(ws.expB);
+  // position of the points of the scheme relative to the middle of the step,
+  // direction of the integration and sign of the scaling derivative
+  double offset((order == 2) ? 0. : sqrt(3) / 6.);
+  bool reversed((order == 2) ? (p.direction < 0.) : (dX < 0.));
+  double dlSign((order == 2) ? -sec.Ydir() : 1.);
+  // scaling parameters of the last matrix exponential computed
+  double prevL0(NAN), prevL1(NAN), prevDl0(NAN), prevDl1(NAN);
+  double tau0, tau1, l0, l1(NAN), dl0, dl1(NAN);
+
+  for (int i(0); i < numX - 1; i++)
   {
-    bndSpecAdm.resize(m_modesNumber);
-    bndSpecAdm.setZero();
-    double k(2. * M_PI * freq / simuParams.sndSpeed);
-    for (int m(0); m < m_modesNumber; m++)
+    if (reversed)
     {
-      bndSpecAdm(m) = simuParams.percentageLosses * (
-        ((1. - pow(2 * M_PI * m_eigenFreqs[m] / simuParams.sndSpeed, 2) / pow(k, 2)) *
-        simuParams.viscousBndSpecAdm + simuParams.thermalBndSpecAdm) * sqrt(freq));
+      tau0 = ((double)(numX - i) - 1.5 + offset) / (double)(numX - 1);
+      tau1 = ((double)(numX - i) - 1.5 - offset) / (double)(numX - 1);
+    }
+    else
+    {
+      tau0 = ((double)i + 0.5 - offset) / (double)(numX - 1);
+      tau1 = ((double)i + 0.5 + offset) / (double)(numX - 1);
+    }
+    l0 = sec.scaling(tau0);
+    dl0 = dlSign * sec.scalingDerivative(tau0);
+    if (order == 4)
+    {
+      l1 = sec.scaling(tau1);
+      dl1 = sec.scalingDerivative(tau1);
+    }
+
+    // the propagator of the previous step is reused if the scaling did not change
+    if ((l0 == prevL0) && (dl0 == prevDl0) && 
+      ((order == 2) || ((l1 == prevL1) && (dl1 == prevDl1))))
+    {
+      ws.idxPropagator[i] = ws.idxPropagator[i - 1];
+      continue;
+    }
+    prevL0 = l0;
+    prevDl0 = dl0;
+    prevL1 = l1;
+    prevDl1 = dl1;
+
+    buildMagnusMatrixKernel<curved, varyingArea, lossy>(k, curv, l0, dl0, na, ws, A0);
+    for (int j(na); j < mn; j++)
+    {
+      B0[j - na] = uncoupledMagnusMatrix<curved, varyingArea, lossy>(
+        sec, j, k, curv, l0, dl0, ws);
+    }
+
+    if ((order == 2) || !varyingArea)
+    {
+      expA = (dX * A0).exp();
+      for (int j(na); j < mn; j++) { expB[j - na] = (dX * B0[j - na]).exp(); }
+    }
+    else
+    {
+      buildMagnusMatrixKernel<curved, varyingArea, lossy>(k, curv, l1, dl1, na, ws, A1);
+      for (int j(na); j < mn; j++)
+      {
+        B1[j - na] = uncoupledMagnusMatrix<curved, varyingArea, lossy>(
+          sec, j, k, curv, l1, dl1, ws);
+      }
+      commutator.noalias() = A1 * A0;
+      commutator.noalias() -= A0 * A1;
+      expA = (0.5 * dX * (A0 + A1) + sqrt(3) * pow(dX, 2) * commutator / 12.).exp();
+      for (int j(na); j < mn; j++)
+      {
+        const Eigen::Matrix2cd& b0(B0[j - na]), b1(B1[j - na]);
+        expB[j - na] = (0.5 * dX * (b0 + b1) + sqrt(3) * pow(dX, 2) * (b1 * b0 - b0 * b1) / 12.).exp();
+      }
     }
+    assembleMagnusPropagator(expA, expB, na, mn, ws.propagators[i]);
+    ws.idxPropagator[i] = i;
   }
-  else if (simuParams.constantWallImped)
+}
+
+// the work matrices of the coupled modes are on the stack if they are small 
+// enough, those of the workspace otherwise
+template <int order, bool curved, bool varyingArea, bool lossy>
+static void runMagnusKernel(CrossSection2dFEM& sec, const magnusKernelParameters& p,
+  magnusWorkspace& ws)
+{
+  if (2 * p.na <= MAX_SMALL_MAGNUS_SIZE)
   {
-    bndSpecAdm.resize(m_modesNumber);
-    bndSpecAdm.setConstant(simuParams.percentageLosses * simuParams.wallAdmit);
+    smallMagnusMatrix A0, A1, expA, commutator;
+    computeMagnusPropagators<order, curved, varyingArea, lossy>(sec, p, ws,
+      A0, A1, expA, commutator);
   }
   else
   {
-    bndSpecAdm.resize(m_modesNumber);
-    bndSpecAdm.setZero();
+    computeMagnusPropagators<order, curved, varyingArea, lossy>(sec, p, ws,
+      ws.A0, ws.A1, ws.expA, ws.commutator);
   }
 }
 
-// **************************************************************************
-// Return the curvature
-
-double CrossSection2dFEM::curvature(bool curved) 
-{ 
-  if (curved) { return  1. / m_curvatureRadius; }
-  else { return 0.; }
-}
-
-// **************************************************************************
-// Set the area variation profile type
-void CrossSection2dFEM::setAreaVariationProfileType(enum areaVariationProfile profile)
+// kernel of the configuration, selected once per propagation
+static magnusKernel selectMagnusKernel(int order, bool curved, bool varyingArea,
+  bool lossy)
 {
-  m_areaProfile = profile;
+  // indexed by (order 4, curved, varying area, lossy)
+  static const magnusKernel kernels[16] = {
+    &runMagnusKernel<2, false, false, false>, &runMagnusKernel<2, false, false, true>,
+    &runMagnusKernel<2, false, true, false>, &runMagnusKernel<2, false, true, true>,
+    &runMagnusKernel<2, true, false, false>, &runMagnusKernel<2, true, false, true>,
+    &runMagnusKernel<2, true, true, false>, &runMagnusKernel<2, true, true, true>,
+    &runMagnusKernel<4, false, false, false>, &runMagnusKernel<4, false, false, true>,
+    &runMagnusKernel<4, false, true, false>, &runMagnusKernel<4, false, true, true>,
+    &runMagnusKernel<4, true, false, false>, &runMagnusKernel<4, true, false, true>,
+    &runMagnusKernel<4, true, true, false>, &runMagnusKernel<4, true, true, true>
+  };
+  return kernels[8 * (order == 4) + 4 * curved + 2 * varyingArea + lossy];
 }
 
 // **************************************************************************
-// scaling function
-
-double CrossSection2dFEM::scaling(double tau)
+// Reuse the propagators of the steps computed in the same scope for the same
+// frequency and steps: those of the same direction as they are, those of the
+// opposite direction inverted, the step i of a direction being the step 
+// numX - 2 - i of the other one with the opposite exponent. The propagators 
+// are computed again (false is returned) if one of the inverses is badly 
+// conditioned, as with strongly evanescent modes on long steps.
+
+// minimal reciprocal condition number of a propagator to be inverted
+static const double MIN_PROPAGATOR_RCOND(1e-6);
+
+static bool reuseMagnusPropagators(const magnusPropagatorKey& key,
+  magnusWorkspace& ws)
 {
-  switch (m_areaProfile)
-  {
-  case LINEAR:
-    return (m_scalingFactors[1] - m_scalingFactors[0]) * tau
-      + m_scalingFactors[0];
-    break;
-  case GAUSSIAN:
-    return (1. + 0.75*exp(-pow(0.3*(tau - 0.5),2)/2./pow(0.04,2)));
-    break;
-  case ELEPHANT:
-    return (0.25*(1 + 9.*pow(tau, 2) - 6.*pow(tau, 3))); // l = [0.25 1]
-    break;
-  }
-}
+  if (key.sameAs(ws.key)) { return true; }
 
-// **************************************************************************
-// derivative of the scaling function
- 
-double CrossSection2dFEM::scalingDerivative(double tau)
-{
-  // compute the length of the section
-  double al;
-  if (abs(m_circleArcAngle) < MINIMAL_DISTANCE)
+  if (key.sameAs(ws.otherKey) || key.reverseOf(ws.key))
   {
-      al = m_length;
+    ws.propagators.swap(ws.otherPropagators);
+    ws.idxPropagator.swap(ws.idxOtherPropagator);
+    swap(ws.key, ws.otherKey);
+    if (key.sameAs(ws.key)) { return true; }
   }
   else
   {
-      al = abs(m_circleArcAngle) * abs(m_curvatureRadius);
+    return false;
   }
 
-  switch (m_areaProfile)
+  // invert the propagators of the other direction 
+  int numSteps(key.numX - 1);
+  const vector<Eigen::MatrixXcd>& other(ws.otherPropagators);
+  const vector<int>& idxOther(ws.idxOtherPropagator);
+  ws.propagators.resize(numSteps);
+  ws.idxPropagator.resize(numSteps);
+  ws.key = magnusPropagatorKey();
+  for (int i(0); i < numSteps; i++)
   {
-  case LINEAR:
-    return((m_scalingFactors[1] - m_scalingFactors[0])/ al); 
-    break;
-  case GAUSSIAN:
-    return(-0.75*0.09*(tau - 0.5)*
-       exp(-pow(0.3*(tau - 0.5),2)/2./pow(0.04,2))
-       /pow(0.04, 2)/30.);
-    break;
-  case ELEPHANT:
-    return (9.*tau*(1. - tau)/16.95/2.); // l = [0.25 1]
+    int j(idxOther[numSteps - 1 - i]);
+    if ((i > 0) && (j == idxOther[numSteps - i]))
+    {
+      ws.idxPropagator[i] = ws.idxPropagator[i - 1];
+      continue;
+    }
+    ws.inverseLu.compute(other[j]);
+    if (ws.inverseLu.rcond() < MIN_PROPAGATOR_RCOND) { return false; }
+    ws.propagators[i] = ws.inverseLu.inverse();
+    ws.idxPropagator[i] = i;
   }
+  ws.key = key;
+  return true;
 }
 
 // **************************************************************************
 // Propagate impedance, admittance, pressure or velocity using the 
-// order 2 or 4 Magnu-Moebius scheme
-void CrossSection2dFEM::propagateMagnus(Eigen::MatrixXcd Q0, struct simulationParameters simuParams,
+// order 2 or 4 Magnu-Moebius scheme. The modes which are not coupled at this
+// frequency (see numCoupledModes) are propagated with the diagonal terms 
+// of the matrices only, so that the matrix exponentials are computed on the 
+// coupled modes, while the propagated quantities keep the size of all modes.
+void CrossSection2dFEM::propagateMagnus(const Eigen::MatrixXcd& Q0, const struct simulationParameters& simuParams,
   double freq, double direction, enum physicalQuantity quant, std::chrono::duration<double> *time)
 {
   // track time
   auto startTot = std::chrono::system_clock::now();
 
-  int numX(simuParams.numIntegrationStep);
+  int numX(numIntegrationStep(simuParams));
   int mn(m_modesNumber);
   double al(length()); // arc length
   double dX; // (direction * al / (double)(numX - 1));
   double curv(curvature(simuParams.curved));
   double k(2 * M_PI * freq / simuParams.sndSpeed);
-  double tau, l0, l1, dl0, dl1;
-  // parameters of the coefficient l evolution
-  Eigen::MatrixXcd A0(2 * mn, 2 * mn), A1(2 * mn, 2 * mn), omega(2 * mn, 2 * mn);
-  Eigen::MatrixXcd K2(Eigen::MatrixXcd::Zero(mn, mn));
-  complex<double> wallAdmittance;
-  Eigen::VectorXcd bndSpecAdm(Eigen::VectorXcd::Zero(mn));
-
-  if (m_length == 0.)
+  // number of modes coupled in the Magnus scheme at this frequency, the 
+  // higher modes propagate as uncoupled evanescent modes
+  int na(numCoupledModes(freq, simuParams));
+  // the work matrices are those of the propagation state, they keep their
+  // storage from one call to the next (resize does not reallocate if the 
+  // size does not change)
+  propagationState& st(state());
+  magnusWorkspace& ws(st.magnus);
+  // propagators of the steps (a step whose scaling is the same as the one of
+  // the previous step uses the propagator of the previous step)
+  vector<Eigen::MatrixXcd>& propagators(ws.propagators);
+  vector<int>& idxPropagator(ws.idxPropagator);
+  propagators.resize(max(0, numX - 1));
+  idxPropagator.resize(max(0, numX - 1));
+  ws.B0.resize(mn - na);
+  ws.B1.resize(mn - na);
+  ws.expB.resize(mn - na);
+  // propagated quantity
+  vector<Eigen::MatrixXcd>* Q(NULL);
+  // the impedance and the admittance are always stored along the segment 
+  // since they are needed to propagate the pressure and the velocity, which
+  // are only stored at the ends if the axial profile is not needed, and 
+  // at the checkpoints if it is (see axialProfile())
+  int storeInterval(1);
+  if ((quant == PRESSURE) || (quant == VELOCITY))
   {
-    switch (quant) {
-    case IMPEDANCE:
-      m_impedance.clear();
-      m_impedance.push_back(Q0);
-      break;
-    case ADMITTANCE:
-      m_admittance.clear();
-      m_admittance.push_back(Q0);
-      break;
-    case PRESSURE:
-      m_acPressure.clear();
-      m_acPressure.push_back(Q0);
-      break;
-    case VELOCITY:
-      m_axialVelocity.clear();
-      m_axialVelocity.push_back(Q0);
-      break;
+    if (!st.storeAxialProfile) { storeInterval = max(1, numX - 1); }
+    else
+    {
+      storeInterval = min(max(1, simuParams.axialCheckpointInterval), max(1, numX - 1));
     }
+    st.checkpointInterval = (m_length == 0.) ? 1 : storeInterval;
+    st.checkpointedQuantity = quant;
   }
-  else
+
+  switch (quant) {
+  case IMPEDANCE:
+    Q = &st.impedance;
+    dX = -al / (double)(numX - 1);
+    break;
+  case ADMITTANCE:
+    Q = &st.admittance;
+    dX = -al / (double)(numX - 1);
+    break;
+  case PRESSURE:
+    Q = &st.acPressure;
+    dX = al / (double)(numX - 1);
+    break;
+  case VELOCITY:
+    Q = &st.axialVelocity;
+    dX = al / (double)(numX - 1);
+    break;
+  }
+
+  // the matrices already stored are overwritten in place instead of 
+  // being freed and allocated again
+  Q->resize((m_length == 0.) ? 1 : (numX - 2 + storeInterval) / storeInterval + 1);
+  (*Q)[0] = Q0;
+
+  if (m_length != 0.)
   {
-    switch (quant) {
-    case IMPEDANCE:
-      m_impedance.clear();
-      m_impedance.reserve(numX);
-      m_impedance.push_back(Q0);
-      dX = -al / (double)(numX - 1);
-      break;
-    case ADMITTANCE:
-      m_admittance.clear();
-      m_admittance.reserve(numX);
-      m_admittance.push_back(Q0);
-      dX = -al / (double)(numX - 1);
-      break;
-    case PRESSURE:
-      m_acPressure.clear();
-      m_acPressure.reserve(numX);
-      m_acPressure.push_back(Q0);
-      dX = al / (double)(numX - 1);
-      break;
-    case VELOCITY:
-      m_axialVelocity.clear();
-      m_acPressure.reserve(numX);
-      m_axialVelocity.push_back(Q0);
-      dX = al / (double)(numX - 1);
-      break;
-    }
-
-    // compute wall admittance
-    wallAdmittance = getWallAdmittance(simuParams, freq);
-
-    // compute boundary specific admittance
-    getSpecificBndAdm(simuParams, freq, bndSpecAdm);
-
-    // compute matrix KR2
-    Eigen::MatrixXcd KR2(Eigen::MatrixXcd::Zero(mn, mn));
-    for (int s(0); s < m_KR2.size(); s++)
-    {
-      KR2 += m_KR2[s] * bndSpecAdm.asDiagonal() + wallAdmittance * m_KR2[s];
-    }
+    prepareMagnusBlocks(simuParams, freq, na, ws);
 
     // track time
     auto start = std::chrono::system_clock::now();
@@ -1647,185 +3322,106 @@ void CrossSection2dFEM::propagateMagnus(Eigen::MatrixXcd Q0, struct simulationPa
     std::chrono::duration<double> elapsed_preComp, matricesMag, propag, tot;
     elapsed_preComp = end - startTot;
 
-      // discretize X axis
-      for (int i(0); i < numX - 1; i++)
-      {
-
-        switch (simuParams.orderMagnusScheme)
-        {
-      //****************************
-      // Magnus scheme order 2
-      //****************************
-
-      case 2:
-
-        if (direction < 0.)
-        {
-          tau = ((double)(numX - i) - 1.5) / (double)(numX - 1);
-        }
-        else
-        {
-          tau = ((double)(i)+0.5) / (double)(numX - 1);
-        }
-        l0 = scaling(tau);
-        dl0 = - Ydir() * scalingDerivative(tau);
-
-        // build matrix K2
-        K2.setZero(mn, mn);
-        for (int j(0); j < mn; j++)
-        {
-          K2(j, j) = pow(2 * M_PI * m_eigenFreqs[j] / simuParams.sndSpeed, 2) - pow(k * l0, 2);
-        }
-        K2 += 1i * k * l0 * KR2;
+    //*************************************************************
+    // Propagators of the steps: they only depend on the frequency and
+    // on the scaling, not on the propagated quantity, so that they are 
+    // all computed before the propagation by the kernel specialised on
+    // the order of the scheme, the curvature, the area variation and 
+    // the losses, unless those of a previous propagation of the scope
+    // can be reused
+    //*************************************************************
+
+    start = std::chrono::system_clock::now();
+
+    magnusPropagatorKey key;
+    key.scope = MagnusPropagatorScope::current();
+    key.freq = freq;
+    key.dX = dX;
+    key.direction = direction;
+    key.numX = numX;
+    key.numCoupledModes = na;
+    key.order = simuParams.orderMagnusScheme;
+    if (!reuseMagnusPropagators(key, ws))
+    {
+      propagators.resize(max(0, numX - 1));
+      idxPropagator.resize(max(0, numX - 1));
+      magnusKernelParameters params = { k, curv, dX, direction, numX, na };
+      selectMagnusKernel(simuParams.orderMagnusScheme, curv != 0.,
+        !constantScaling(), !ws.KR2.isZero(0.))(*this, params, ws);
+      ws.key = key;
+    }
 
-        // build matrix A0
-        omega << ((dl0 / l0)* m_E),
-          (Eigen::MatrixXcd::Identity(mn, mn) - curv * l0 * m_C) / pow(l0, 2),
-          (K2 + curv * l0 * (m_C * pow(k * l0, 2) - m_DN
-            )),
-          (-(dl0 / l0) * m_E.transpose());
+    end = std::chrono::system_clock::now();
+    matricesMag += end - start;
+    *time += end - start;
 
-        start = std::chrono::system_clock::now();
+    //*************************************************************
+    // Propagation of the quantity along the steps
+    //*************************************************************
 
-        omega = (dX * omega).exp();
+    start = std::chrono::system_clock::now();
 
-        end = std::chrono::system_clock::now();
-        *time += end - start;
-        start = std::chrono::system_clock::now();
+    if (simuParams.singlePrecisionPropagation)
+    {
+      propagateMagnusSteps(propagators, idxPropagator, numX, mn, quant,
+        storeInterval, st, *Q, ws.singleSteps);
+    }
+    else
+    {
+      propagateMagnusSteps(propagators, idxPropagator, numX, mn, quant,
+        storeInterval, st, *Q, ws.doubleSteps);
+    }
+    if ((quant == PRESSURE) || (quant == VELOCITY)) { st.checkpointKey = key; }
 
-        break;
+    // track time
+    end = std::chrono::system_clock::now();
+    propag += end - start;
+    tot = end - startTot;
+  }
+}
 
-      //****************************
-      // Magnus scheme order 4
-      //****************************
-
-      case 4:
-
-          //*******************************
-          // first point of Magnus scheme
-          //*******************************
-
-          if (dX < 0.) {
-            tau = ((double)(numX - i) - 1.5 + sqrt(3) / 6.) / (double)(numX - 1);
-          }
-          else
-          {
-            tau = (double)(i + 0.5 - sqrt(3) / 6.) / (double)(numX - 1);
-          }
-          l0 = scaling(tau);
-          dl0 = scalingDerivative(tau);
-
-          // build matrix K2
-          K2.setZero(mn, mn);
-          for (int j(0); j < mn; j++)
-          {
-            K2(j, j) = pow(2 * M_PI * m_eigenFreqs[j] / simuParams.sndSpeed, 2) - pow(k * l0, 2);
-          }
-          K2 += 1i * k * l0 * KR2;
-
-          // build matrix A0
-          A0 << ((dl0 / l0) * m_E),
-            (Eigen::MatrixXcd::Identity(mn, mn) - curv * l0 * m_C) / pow(l0, 2),
-            (K2 + curv * l0 * (m_C * pow(k * l0, 2) - m_DN)),
-            (-(dl0 / l0) * m_E.transpose());
-
-            //*******************************
-            // second point of Magnus scheme
-            //*******************************
-
-          if (dX < 0.)
-          {
-            tau = ((double)(numX - i) - 1.5 - sqrt(3) / 6.) / (double)(numX - 1);
-          }
-          else
-          {
-            tau = (double)(i + 0.5 + sqrt(3) / 6.) / (double)(numX - 1);
-          }
-          l1 = scaling(tau);
-          dl1 = scalingDerivative(tau);
-
-          // build matrix K
-          K2.setZero(mn, mn);
-          for (int j(0); j < mn; j++)
-          {
-            K2(j, j) = pow(2 * M_PI * m_eigenFreqs[j] / simuParams.sndSpeed, 2) - pow(k * l1, 2);
-          }
-          K2 += 1i * k * l1 * KR2;
-          // build matrix A1
-          A1 << ((dl1 / l1) * m_E),
-            (Eigen::MatrixXcd::Identity(mn, mn) - curv * l1 * m_C) / pow(l1, 2),
-            (K2 + curv * l1 * (m_C * pow(k * l1, 2) - m_DN)),
-            (-(dl1 / l1) * m_E.transpose());
-
-            //*******************************
-            // compute matrix omega
-            //*******************************
-
-            // tract time  
-          start = std::chrono::system_clock::now();
-
-          omega = (0.5 * dX * (A0 + A1) + sqrt(3) * pow(dX, 2) * (A1 * A0 - A0 * A1) / 12.).exp();
-
-          // tract time
-          end = std::chrono::system_clock::now();
-          matricesMag += end - start;
-          start = std::chrono::system_clock::now();
-
-          break;
-        }
+// **************************************************************************
+// Diagonal propagation factors of the straight tube method. At the 
+// frequencies of a sweep they are read from the sweep tables, where they are
+// computed for all the modes and frequencies at once.
 
-      // compute the propagated quantity at the next point
-      switch (quant)
-      {
-      case IMPEDANCE:
-        m_impedance.push_back((omega.block(0, 0, mn, mn) * m_impedance.back() +
-          omega.block(0, mn, mn, mn)) *
-          ((omega.block(mn, 0, mn, mn) * m_impedance.back() +
-            omega.block(mn, mn, mn, mn)).inverse()));
-        break;
-      case ADMITTANCE:
-        m_admittance.push_back((omega.block(mn, 0, mn, mn) +
-          omega.block(mn, mn, mn, mn) * m_admittance.back()) *
-          ((omega.block(0, 0, mn, mn) +
-            omega.block(0, mn, mn, mn) * m_admittance.back()).inverse()));
-        break;
-      case PRESSURE:
-        m_acPressure.push_back((omega.block(0, 0, mn, mn) + omega.block(0, mn, mn, mn) *
-            m_admittance[numX - 1 - i])* m_acPressure.back());
-        break;
-      case VELOCITY:
-          m_axialVelocity.push_back((omega.block(mn, 0, mn, mn)* m_impedance[numX - 1 - i] +
-            omega.block(mn, mn, mn, mn))* m_axialVelocity.back());
-      }
+void CrossSection2dFEM::straightTubeFactors(double freq, 
+  const struct simulationParameters& simuParams, Eigen::VectorXcd& cosL,
+  Eigen::VectorXcd& jSinL) const
+{
+  int idx(sweepTableIndex(freq));
+  if ((idx >= 0) && (m_sweepTables->tubeCos.cols() > 0))
+  {
+    cosL = m_sweepTables->tubeCos.col(idx);
+    jSinL = m_sweepTables->tubeSin.col(idx);
+    return;
+  }
 
-      // track time
-      end = std::chrono::system_clock::now();
-      propag += end - start;
-    }
-  // track time
-  tot = end - startTot;
+  double k(2 * M_PI * freq / simuParams.sndSpeed);
+  complex<double> kn;
+  cosL.resize(m_modesNumber);
+  jSinL.resize(m_modesNumber);
+  for (int i(0); i < m_modesNumber; i++)
+  {
+    kn = sqrt(pow(k, 2) - complex<double>(pow(2 * M_PI * m_eigenFreqs[i] / simuParams.sndSpeed, 2)));
+    cosL(i) = cos(kn * m_length);
+    jSinL(i) = 1i * sin(kn * m_length);
   }
 }
 
 // **************************************************************************
-// Propagate the admittance along the cross-section in a straight tube
+// Propagate the admittance along the cross-section in a straight tube. The
+// propagation matrices being diagonal in the basis of the modes, they are
+// applied as scalings of the rows and columns, so that only the inverses
+// of the junction relations are full matrix operations.
 
-void CrossSection2dFEM::propagateImpedAdmitStraight(Eigen::MatrixXcd Z0,
-  Eigen::MatrixXcd Y0, double freq, struct simulationParameters simuParams,
+void CrossSection2dFEM::propagateImpedAdmitStraight(const Eigen::MatrixXcd& Z0,
+  const Eigen::MatrixXcd& Y0, double freq, const struct simulationParameters& simuParams,
   double prevArea, double nextArea)
 {
-  double volMass(simuParams.volumicMass);
   int mn(m_modesNumber);
-  Eigen::MatrixXcd 
-    iD2(Eigen::MatrixXcd::Zero(mn,mn)), 
-    iD3(Eigen::MatrixXcd::Zero(mn, mn)), 
-    D1(Eigen::MatrixXcd::Zero(mn, mn)),
-    D2(Eigen::MatrixXcd::Zero(mn, mn)),
-    Zc(mn, mn);
-  Matrix I(Matrix::Identity(mn, mn));
-  complex<double> kn, j(0., 1.), diag;
-  double k(2 * M_PI * freq / simuParams.sndSpeed);
-  Eigen::MatrixXcd Yc;
+  Eigen::MatrixXcd Yc, M, result;
+  Eigen::VectorXcd cosL, jSinL, yc, zc, a, b;
   characteristicAdmittance(Yc, freq, simuParams);
 
   ofstream log;
@@ -1839,32 +3435,23 @@ void CrossSection2dFEM::propagateImpedAdmitStraight(Eigen::MatrixXcd Z0,
 
   if (m_length == 0.)
   {
-    m_admittance.push_back(Y0);
-    m_impedance.push_back(Z0);
+    state().admittance.push_back(Y0);
+    state().impedance.push_back(Z0);
   }
   else
   {
     // set the initial admittance
-    m_admittance.push_back(Y0);
-    m_impedance.push_back(Z0);
-
-    // compute propagation matrices
-    // loop over modes
-    for (int i(0); i < m_modesNumber; i++)
-    {
-      kn = sqrt(pow(k, 2) - complex<double>(pow(2 * M_PI * m_eigenFreqs[i] / simuParams.sndSpeed, 2)));
-
-      diag = 1. / (j * sin(kn * m_length));
-      iD2(i, i) = diag;
-      diag = 1. / (j * tan(kn * m_length));
-      iD3(i, i) = diag;
-
-      diag = cos(kn * m_length);
-      D1(i, i) = diag;
-      diag = j * sin(kn * m_length);
-      D2(i, i) = diag;
-    }
-    Zc = Yc.inverse();
+    state().admittance.push_back(Y0);
+    state().impedance.push_back(Z0);
+
+    // diagonal propagation matrices: iD2 = 1 / (j sin(kn L)) and 
+    // iD3 = 1 / (j tan(kn L))
+    straightTubeFactors(freq, simuParams, cosL, jSinL);
+    Eigen::VectorXcd iD2(jSinL.cwiseInverse());
+    Eigen::VectorXcd iD3(cosL.cwiseProduct(iD2));
+    // the characteristic admittance is diagonal
+    yc = Yc.diagonal();
+    zc = yc.cwiseInverse();
 
     // if the junction with the previous section is a contraction
     if (m_area > prevArea)
@@ -1872,16 +3459,29 @@ void CrossSection2dFEM::propagateImpedAdmitStraight(Eigen::MatrixXcd Z0,
       // if the junction with the next section is a contraction
       if (nextArea > m_area)
       {
-        m_admittance.push_back(iD3 * Yc - iD2 * Yc *
-        (m_admittance.back() + iD3 * Yc).inverse() * iD2 * Yc);
-        m_impedance.push_back(m_admittance.back().fullPivLu().inverse());
+        // Y = iD3 Yc - iD2 Yc (Y0 + iD3 Yc)^-1 iD2 Yc
+        a = iD3.cwiseProduct(yc);
+        b = iD2.cwiseProduct(yc);
+        M = state().admittance.back();
+        M.diagonal() += a;
+        result = -(b.asDiagonal() * M.inverse() * b.asDiagonal());
+        result.diagonal() += a;
+        state().admittance.push_back(result);
+        state().impedance.push_back(state().admittance.back().fullPivLu().inverse());
       }
       // if the junction with the next section is an expansion
       else
       {
-        m_impedance.push_back(iD3 * Zc - iD2 * Zc * m_admittance.back() *
-          (I + iD3*Zc * m_admittance.back()).inverse() * iD2*Zc);
-        m_admittance.push_back(m_impedance.back().fullPivLu().inverse());
+        // Z = iD3 Zc - iD2 Zc Y0 (I + iD3 Zc Y0)^-1 iD2 Zc
+        a = iD3.cwiseProduct(zc);
+        b = iD2.cwiseProduct(zc);
+        M = a.asDiagonal() * state().admittance.back();
+        M.diagonal().array() += 1.;
+        result = -(b.asDiagonal() * state().admittance.back() * M.inverse() * 
+          b.asDiagonal());
+        result.diagonal() += a;
+        state().impedance.push_back(result);
+        state().admittance.push_back(state().impedance.back().fullPivLu().inverse());
       }
     }
     // if the junction with the previous section is an expansion
@@ -1890,83 +3490,89 @@ void CrossSection2dFEM::propagateImpedAdmitStraight(Eigen::MatrixXcd Z0,
       // if the junction with the next section is a contraction
       if (nextArea > m_area)
       {
-        m_admittance.push_back(iD3*Yc - iD2*Yc * m_impedance.back() *
-          (I + iD3 * Yc * m_impedance.back()).inverse() * iD2 * Yc);
-        m_impedance.push_back(m_admittance.back().fullPivLu().inverse());
+        // Y = iD3 Yc - iD2 Yc Z0 (I + iD3 Yc Z0)^-1 iD2 Yc
+        a = iD3.cwiseProduct(yc);
+        b = iD2.cwiseProduct(yc);
+        M = a.asDiagonal() * state().impedance.back();
+        M.diagonal().array() += 1.;
+        result = -(b.asDiagonal() * state().impedance.back() * M.inverse() * 
+          b.asDiagonal());
+        result.diagonal() += a;
+        state().admittance.push_back(result);
+        state().impedance.push_back(state().admittance.back().fullPivLu().inverse());
       }
       // if the junction with the next section is an expansion
       else
       {
-        m_impedance.push_back(iD3 * Zc - iD2 * Zc *
-          (m_impedance.back() + iD3*Zc).inverse() * iD2 * Zc);
-        m_admittance.push_back(m_impedance.back().fullPivLu().inverse());
+        // Z = iD3 Zc - iD2 Zc (Z0 + iD3 Zc)^-1 iD2 Zc
+        a = iD3.cwiseProduct(zc);
+        b = iD2.cwiseProduct(zc);
+        M = state().impedance.back();
+        M.diagonal() += a;
+        result = -(b.asDiagonal() * M.inverse() * b.asDiagonal());
+        result.diagonal() += a;
+        state().impedance.push_back(result);
+        state().admittance.push_back(state().impedance.back().fullPivLu().inverse());
       }
     }
   }
 }
 
 void CrossSection2dRadiation::propagateImpedAdmitStraight(
-  Eigen::MatrixXcd Z0,
-  Eigen::MatrixXcd Y0, double freq, struct simulationParameters simuParams,
+  const Eigen::MatrixXcd& Z0,
+  const Eigen::MatrixXcd& Y0, double freq, const struct simulationParameters& simuParams,
   double prevArea, double nextArea)
 {
-  m_impedance.push_back(Z0);
-  m_admittance.push_back(Y0);
+  state().impedance.push_back(Z0);
+  state().admittance.push_back(Y0);
 }
 
 // **************************************************************************
 // Propagate the axial velocity along the cross-section for a straight tube
 
-void CrossSection2dFEM::propagatePressureVelocityStraight(Eigen::MatrixXcd V0,
-  Eigen::MatrixXcd P0, double freq, struct simulationParameters simuParams,
+void CrossSection2dFEM::propagatePressureVelocityStraight(const Eigen::MatrixXcd& V0,
+  const Eigen::MatrixXcd& P0, double freq, const struct simulationParameters& simuParams,
   double nextArea)
 {
-  double volMass(simuParams.volumicMass);
-  int mn(m_modesNumber);
-  Eigen::MatrixXcd D1(Eigen::MatrixXcd::Zero(mn, mn)),
-    D2(Eigen::MatrixXcd::Zero(mn, mn)), Zend;
-  complex<double> kn, j(0., 1.), diag;
-  double k(2 * M_PI * freq / simuParams.sndSpeed);
-  Eigen::MatrixXcd Yc;
+  Eigen::MatrixXcd Yc, M;
+  Eigen::VectorXcd cosL, jSinL;
   characteristicAdmittance(Yc, freq, simuParams);
+  // both quantities are stored at the ends
+  state().checkpointInterval = 1;
 
   if (m_length == 0.)
   {
-    m_axialVelocity.push_back(V0);
-    m_acPressure.push_back(P0);
+    state().axialVelocity.push_back(V0);
+    state().acPressure.push_back(P0);
   }
   else
   {
     // initalise velocity
-    m_axialVelocity.push_back(V0);
-    m_acPressure.push_back(P0);
-
-    // compute propagation matrices
-    // loop over modes
-    for (int i(0); i < mn; i++)
-    {
-      kn = sqrt(pow(k, 2) - complex<double>(pow(2 * M_PI * m_eigenFreqs[i] / simuParams.sndSpeed, 2)));
+    state().axialVelocity.push_back(V0);
+    state().acPressure.push_back(P0);
 
-      diag = cos(kn * m_length);
-      D1(i, i) = diag;
-      diag = j * sin(kn * m_length);
-      D2(i, i) = diag;
-    }
+    // diagonal propagation matrices D1 = cos(kn L) and D2 = j sin(kn L)
+    straightTubeFactors(freq, simuParams, cosL, jSinL);
 
     // if the section expends
     if (nextArea > m_area)
     {
-      m_axialVelocity.push_back(
-      (D2 * Yc * m_impedance[0] + D1).householderQr().solve(m_axialVelocity.back()));
-      m_acPressure.push_back(m_impedance[0] * m_axialVelocity.back());
+      // (D2 Yc Z + D1) V = V0
+      M = jSinL.cwiseProduct(Yc.diagonal()).asDiagonal() * state().impedance[0];
+      M.diagonal() += cosL;
+      state().axialVelocity.push_back(
+        M.householderQr().solve(state().axialVelocity.back()));
+      state().acPressure.push_back(state().impedance[0] * state().axialVelocity.back());
     }
     // if the section contracts
     else
     {
-      m_acPressure.push_back(
-      (D1 + D2* Yc.inverse()*m_admittance[0]).householderQr().
-        solve(m_acPressure.back()));
-      m_axialVelocity.push_back(m_admittance[0] * m_acPressure.back());
+      // (D1 + D2 Yc^-1 Y) P = P0
+      M = jSinL.cwiseQuotient(Yc.diagonal()).asDiagonal() * state().admittance[0];
+      M.diagonal() += cosL;
+      state().acPressure.push_back(
+        M.householderQr().solve(state().acPressure.back()));
+      state().axialVelocity.push_back(state().admittance[0] * state().acPressure.back());
     }
   }
 }
@@ -1974,19 +3580,19 @@ void CrossSection2dFEM::propagatePressureVelocityStraight(Eigen::MatrixXcd V0,
 // **************************************************************************
 
 void CrossSection2dRadiation::propagatePressureVelocityStraight(
-  Eigen::MatrixXcd V0,
-  Eigen::MatrixXcd P0, double freq, struct simulationParameters simuParams,
+  const Eigen::MatrixXcd& V0,
+  const Eigen::MatrixXcd& P0, double freq, const struct simulationParameters& simuParams,
   double nextArea)
 {
-  m_axialVelocity.push_back(V0);
-  m_acPressure.push_back(P0);
+  state().axialVelocity.push_back(V0);
+  state().acPressure.push_back(P0);
 }
 
 // **************************************************************************
 // compute the amplitude of the pressure modes at a given distance from the exit
 
 void CrossSection2dRadiation::radiatePressure(double distance, double freq,
-  struct simulationParameters simuParams, Eigen::MatrixXcd &pressAmp)
+  const struct simulationParameters& simuParams, Eigen::MatrixXcd &pressAmp)
 {
   complex<double> j(0., 1.);
   double k2(pow(2 * M_PI * freq / simuParams.sndSpeed, 2));
@@ -1999,7 +3605,7 @@ void CrossSection2dRadiation::radiatePressure(double distance, double freq,
   }
 
   pressAmp = m_eigVec * propa.asDiagonal() * m_invEigVec 
-    * m_acPressure[0];
+    * state().acPressure[0];
 }
 
 // **************************************************************************
@@ -2012,6 +3618,69 @@ void CrossSection2dRadiation::radiatePressure(double distance, double freq,
 // if the option useBbox is set to true, it is checked if the point lies inside 
 // the bounding box of the contour instead of the contour itself
 
+CGAL::Bbox_2 CrossSection2dFEM::sagittalBbox()
+{
+  const int NUM_SAMPLES(33);
+  CGAL::Bbox_2 bbox;
+  if (length() <= 0.) { return bbox; }
+
+  // the extreme points of the segment are obtained by mapping the extreme z
+  // coordinates of the contour along the center line (inverse 
+  // transformation of getCoordinateFromCartesianPt)
+  auto contBbox(m_contour.bbox());
+  double zExt[2] = { contBbox.ymin(), contBbox.ymax() };
+  Point ctl(m_ctrLinePt.x, m_ctrLinePt.y);
+  double x, sc, r, maxR(0.), margin(m_spacing);
+
+  // if there is no curvature 
+  if (abs(m_circleArcAngle) < MINIMAL_DISTANCE)
+  {
+    for (int i(0); i < NUM_SAMPLES; i++)
+    {
+      x = length() * (double)i / (double)(NUM_SAMPLES - 1);
+      sc = scaling(x / length());
+      for (int j(0); j < 2; j++)
+      {
+        bbox += Point(ctl.x() + x, zExt[j] * sc).bbox();
+      }
+    }
+  }
+  else
+  {
+    double R(abs(m_curvatureRadius));
+    Point C(ctl.x() + m_curvatureRadius * m_normal.x, ctl.y()
+      + m_curvatureRadius * m_normal.y);
+    double argCtl(atan2(ctl.y() - C.y(), ctl.x() - C.x()));
+    double dir(1.);
+    if (((m_curvatureRadius < 0.) && (m_curvatureRadius * m_circleArcAngle > 0.))
+      || ((m_curvatureRadius > 0.) && (m_curvatureRadius * m_circleArcAngle < 0.)))
+    {
+      dir = -1.;
+    }
+
+    for (int i(0); i < NUM_SAMPLES; i++)
+    {
+      x = length() * (double)i / (double)(NUM_SAMPLES - 1);
+      sc = scaling(x / length());
+      for (int j(0); j < 2; j++)
+      {
+        if (m_curvatureRadius < 0.) { r = max(0., R + zExt[j] * sc); }
+        else { r = max(0., R - zExt[j] * sc); }
+        maxR = max(maxR, r);
+        bbox += Point(C.x() + r * cos(argCtl + dir * x / R),
+          C.y() + r * sin(argCtl + dir * x / R)).bbox();
+      }
+    }
+    // the arc between two samples goes out of the box at most by its sagitta
+    margin += maxR * (1. - cos(0.5 * abs(m_circleArcAngle) / (double)(NUM_SAMPLES - 1)));
+  }
+
+  return CGAL::Bbox_2(bbox.xmin() - margin, bbox.ymin() - margin,
+    bbox.xmax() + margin, bbox.ymax() + margin);
+}
+
+// **************************************************************************
+
 bool CrossSection2dFEM::getCoordinateFromCartesianPt(Point_3 pt, Point_3 &ptOut, bool useBbox)
 {
   bool isInside(false);
@@ -2109,7 +3778,7 @@ complex<double> CrossSection2dFEM::pout(Point pt)
 {
   vector<Point> pts;
   pts.push_back(pt);
-  if (m_acPressure.size() == 0)
+  if (state().acPressure.size() == 0)
   {
     return((interpolateModes(pts) * Zout() * Qout())(0, 0));
   }
@@ -2133,13 +3802,13 @@ complex<double> CrossSection2dFEM::qout(Point pt)
   return((interpolateModes(pts) * Qout())(0,0));
 }
 // **************************************************************************
-complex<double> CrossSection2dFEM::p(Point_3 pt, struct simulationParameters simuParams)
+complex<double> CrossSection2dFEM::p(Point_3 pt, const struct simulationParameters& simuParams)
 {
   return(interiorField(pt, simuParams, PRESSURE));
 }
 
 // **************************************************************************
-complex<double> CrossSection2dFEM::q(Point_3 pt, struct simulationParameters simuParams)
+complex<double> CrossSection2dFEM::q(Point_3 pt, const struct simulationParameters& simuParams)
 {
   return(interiorField(pt, simuParams, VELOCITY));
 }
@@ -2147,16 +3816,16 @@ complex<double> CrossSection2dFEM::q(Point_3 pt, struct simulationParameters sim
 // **************************************************************************
 // Compute the pressure or the velocity inside
 
-complex<double> CrossSection2dFEM::interiorField(Point_3 pt, struct simulationParameters simuParams,
+complex<double> CrossSection2dFEM::interiorField(Point_3 pt, const struct simulationParameters& simuParams,
           enum physicalQuantity quant)
 {
   // get arc length
   double al(length());
-  int numX(simuParams.numIntegrationStep);
+  int numX(numIntegrationStep(simuParams));
   double dx = al/(double)(numX - 1); // distance btw pts
 
   // locate indexes of previous and following points
-  int nPt(m_impedance.size()-1);
+  int nPt(state().impedance.size()-1);
   double x_dx(pt.x() / dx);
   int idx[2] = {min((int)floor(x_dx), numX - 2),
     min((int)ceil(x_dx), numX - 1)};
@@ -2168,6 +3837,20 @@ complex<double> CrossSection2dFEM::interiorField(Point_3 pt, struct simulationPa
   auto correctIdxIfBackwardProp = [&idx, nPt](double dir)
   {if (dir == -1) { for (int i(0); i < 2; i++) { idx[i] = nPt - idx[i]; } }};
 
+  // amplitudes of the pressure or the velocity at the two points, integrated
+  // again from the previous checkpoint if they are not stored
+  vector<Eigen::MatrixXcd> profile;
+  auto amplitudes = [&](const vector<Eigen::MatrixXcd>& stored) 
+    -> const Eigen::MatrixXcd* 
+  {
+    if (checkpointInterval() == 1) { return &stored[0]; }
+    int first(min(idx[0], idx[1]));
+    axialProfile(quant, first, max(idx[0], idx[1]), profile);
+    for (int i(0); i < 2; i++) { idx[i] -= first; }
+    return &profile[0];
+  };
+  const Eigen::MatrixXcd* A;
+
   // interpolate quantity
   double x_0((double)(idx[0])*dx );
   Eigen::MatrixXcd Q;
@@ -2177,20 +3860,11 @@ complex<double> CrossSection2dFEM::interiorField(Point_3 pt, struct simulationPa
       case PRESSURE:
         // if the propagation direction is backward, reverse the indexes
         correctIdxIfBackwardProp(Pdir());
-        // if the pressure amplitudes have not been computed
-        if (m_acPressure.size() == 0)
-        {
-          int numStep(m_impedance.size());
-          for (int i(0); i < numStep; i++)
-          {
-            m_acPressure.push_back(m_impedance[numStep - 1 -i] * 
-                m_axialVelocity[i]);
-          }
-        }
+        prepareInteriorField(quant, simuParams);
+        A = amplitudes(state().acPressure);
 
         // interpolate the amplitudes
-        Q = (pt.x() - x_0)*(m_acPressure[idx[1]] - m_acPressure[idx[0]])/dx 
-        + m_acPressure[idx[0]];
+        Q = (pt.x() - x_0)*(A[idx[1]] - A[idx[0]])/dx + A[idx[0]];
 
       return((interpolateModes(pts) * Q)(0,0));
         break;
@@ -2198,54 +3872,29 @@ complex<double> CrossSection2dFEM::interiorField(Point_3 pt, struct simulationPa
         // if the propagation direction is backward, reverse the indexes
         correctIdxIfBackwardProp(Qdir());
         if (Qdir() == -1) { for (auto it : idx) { it = nPt - it; } }
-        // if the velocity have not been computed
-        if (m_axialVelocity.size() == 0)
-        {
-          int numStep(m_admittance.size());
-          for (int i(0); i < numStep; i++)
-          {
-            m_axialVelocity.push_back(m_admittance[numStep - 1 - i] *
-                m_acPressure[i]);
-          }
-        }
+        prepareInteriorField(quant, simuParams);
+        A = amplitudes(state().axialVelocity);
         // interpolate the amplitudes
-        Q = (pt.x() - x_0)*(m_axialVelocity[idx[1]] - m_axialVelocity[idx[0]])/dx 
-        + m_axialVelocity[idx[0]];
+        Q = (pt.x() - x_0)*(A[idx[1]] - A[idx[0]])/dx + A[idx[0]];
       return((interpolateModes(pts) * Q)(0,0));
         break;
       case IMPEDANCE:
         // if the propagation direction is backward, reverse the indexes
         correctIdxIfBackwardProp(Zdir());
-        // if the impedance have not been computed
-        if (m_impedance.size() == 0)
-        {
-          int numStep(m_admittance.size());
-          for (int i(0); i < numStep; i++)
-          {
-            m_impedance.push_back(m_admittance[i].fullPivLu().inverse());
-          }
-        }
+        prepareInteriorField(quant, simuParams);
         // interpolate the amplitudes
-        Q = (pt.x() - x_0)*(m_impedance[idx[1]] - m_impedance[idx[0]])/dx 
-        + m_impedance[idx[0]];
+        Q = (pt.x() - x_0)*(state().impedance[idx[1]] - state().impedance[idx[0]])/dx 
+        + state().impedance[idx[0]];
         modes = interpolateModes(pts);
         return((modes.completeOrthogonalDecomposition().pseudoInverse() * Q * modes)(0, 0));
         break;
       case ADMITTANCE:
         // if the propagation direction is backward, reverse the indexes
         correctIdxIfBackwardProp(Ydir());
-        // if the admittance have not been computed
-        if (m_admittance.size() == 0)
-        {
-          int numStep(m_impedance.size());
-          for (int i(0); i < numStep; i++)
-          {
-            m_admittance.push_back(m_impedance[i].fullPivLu().inverse());
-          }
-        }
+        prepareInteriorField(quant, simuParams);
         // interpolate the amplitudes
-        Q = (pt.x() - x_0)*(m_admittance[idx[1]] - m_admittance[idx[0]])/dx 
-        + m_admittance[idx[0]];
+        Q = (pt.x() - x_0)*(state().admittance[idx[1]] - state().admittance[idx[0]])/dx 
+        + state().admittance[idx[0]];
         modes = interpolateModes(pts).transpose();
         return((modes.completeOrthogonalDecomposition().pseudoInverse() * 
               Q.transpose() * modes)(0, 0));
@@ -2253,13 +3902,191 @@ complex<double> CrossSection2dFEM::interiorField(Point_3 pt, struct simulationPa
      }
 }
 
+// **************************************************************************
+// Compute the amplitudes of the quantity along the segment if they have not
+// been computed yet (they are derived from the propagated quantities, at the
+// checkpoints only if the propagated quantity is only stored there). If the
+// segment has been propagated again since the propagation of the pressure or
+// the velocity, the propagators of its steps are computed again, since they
+// are needed to integrate between the checkpoints.
+
+void CrossSection2dFEM::prepareInteriorField(enum physicalQuantity quant,
+  const struct simulationParameters& simuParams)
+{
+  propagationState& st(state());
+  int numStep, interval(st.checkpointInterval), numSlots;
+
+  if ((interval > 1) && !st.magnus.key.sameSteps(st.checkpointKey))
+  {
+    const magnusPropagatorKey& key(st.checkpointKey);
+    magnusWorkspace& ws(st.magnus);
+    double curv(curvature(simuParams.curved));
+    ws.propagators.resize(max(0, key.numX - 1));
+    ws.idxPropagator.resize(max(0, key.numX - 1));
+    ws.B0.resize(m_modesNumber - key.numCoupledModes);
+    ws.B1.resize(m_modesNumber - key.numCoupledModes);
+    ws.expB.resize(m_modesNumber - key.numCoupledModes);
+    prepareMagnusBlocks(simuParams, key.freq, key.numCoupledModes, ws);
+    magnusKernelParameters params = { 2 * M_PI * key.freq / simuParams.sndSpeed,
+      curv, key.dX, key.direction, key.numX, key.numCoupledModes };
+    selectMagnusKernel(key.order, curv != 0., !constantScaling(), 
+      !ws.KR2.isZero(0.))(*this, params, ws);
+    ws.key = key;
+  }
+
+  switch (quant)
+  {
+  case PRESSURE:
+    // if the pressure amplitudes have not been computed
+    if (st.acPressure.size() == 0)
+    {
+      numStep = st.impedance.size();
+      numSlots = st.axialVelocity.size();
+      for (int i(0); i < numSlots; i++)
+      {
+        st.acPressure.push_back(st.impedance[numStep - 1 - 
+          min(i * interval, numStep - 1)] * st.axialVelocity[i]);
+      }
+    }
+    break;
+  case VELOCITY:
+    // if the velocity have not been computed
+    if (st.axialVelocity.size() == 0)
+    {
+      numStep = st.admittance.size();
+      numSlots = st.acPressure.size();
+      for (int i(0); i < numSlots; i++)
+      {
+        st.axialVelocity.push_back(st.admittance[numStep - 1 - 
+          min(i * interval, numStep - 1)] * st.acPressure[i]);
+      }
+    }
+    break;
+  case IMPEDANCE:
+    // if the impedance have not been computed
+    if (state().impedance.size() == 0)
+    {
+      numStep = state().admittance.size();
+      for (int i(0); i < numStep; i++)
+      {
+        state().impedance.push_back(state().admittance[i].fullPivLu().inverse());
+      }
+    }
+    break;
+  case ADMITTANCE:
+    // if the admittance have not been computed
+    if (state().admittance.size() == 0)
+    {
+      numStep = state().impedance.size();
+      for (int i(0); i < numStep; i++)
+      {
+        state().admittance.push_back(state().impedance[i].fullPivLu().inverse());
+      }
+    }
+    break;
+  }
+}
+
 // **************************************************************************
 
-complex<double> CrossSection2dFEM::interiorField(Point_3 pt, struct simulationParameters simuParams)
+complex<double> CrossSection2dFEM::interiorField(Point_3 pt, const struct simulationParameters& simuParams)
 {
   return(interiorField(pt, simuParams, simuParams.fieldPhysicalQuantity));
 }
 
+// **************************************************************************
+// Compute the pressure or the velocity at several points from the amplitudes
+// of the modes at their position: the field at all the integration points of 
+// the segment is obtained by a single matrix product and interpolated along
+// the segment as in interiorField. The impedance and the admittance, which 
+// are not linear in the amplitudes of the modes, are computed point by point.
+
+void CrossSection2dFEM::interiorField(const vector<Point_3>& pts, const Matrix& modes,
+  const struct simulationParameters& simuParams, enum physicalQuantity quant,
+  Eigen::VectorXcd& field)
+{
+  int numPts(pts.size());
+  field.resize(numPts);
+
+  if ((quant != PRESSURE) && (quant != VELOCITY))
+  {
+    for (int i(0); i < numPts; i++) { field(i) = interiorField(pts[i], simuParams, quant); }
+    return;
+  }
+
+  prepareInteriorField(quant, simuParams);
+  int dir((quant == PRESSURE) ? Pdir() : Qdir());
+  int numX(numIntegrationStep(simuParams));
+  // amplitudes at all the integration points, integrated again between 
+  // the checkpoints if they are not all stored
+  vector<Eigen::MatrixXcd> profile;
+  if (checkpointInterval() > 1) { axialProfile(quant, 0, numX - 1, profile); }
+  const vector<Eigen::MatrixXcd>& amp((checkpointInterval() > 1) ? profile :
+    ((quant == PRESSURE) ? state().acPressure : state().axialVelocity));
+  double dx(length() / (double)(numX - 1));
+  int nPt(state().impedance.size() - 1);
+
+  // field of the points at each integration point of the segment
+  Eigen::MatrixXcd ampSteps(modes.cols(), amp.size());
+  for (int s(0); s < amp.size(); s++) { ampSteps.col(s) = amp[s].col(0); }
+  Eigen::MatrixXcd fieldSteps(modes * ampSteps);
+
+  for (int i(0); i < numPts; i++)
+  {
+    double x_dx(pts[i].x() / dx);
+    int idx[2] = { min((int)floor(x_dx), numX - 2), min((int)ceil(x_dx), numX - 1) };
+    double w(x_dx - (double)idx[0]);
+    if (dir == -1) { for (int j(0); j < 2; j++) { idx[j] = nPt - idx[j]; } }
+    field(i) = (1. - w) * fieldSteps(i, idx[0]) + w * fieldSteps(i, idx[1]);
+  }
+}
+
+// **************************************************************************
+// Amplitudes of the pressure or the velocity at the integration points 
+// firstStep to lastStep (in the order of the propagation) when the propagated
+// quantity is only stored at the checkpoints: it is integrated again with 
+// the propagators of the steps from the checkpoint preceding firstStep, and
+// set back to the stored value at each checkpoint reached, so that the 
+// amplitudes at the checkpoints are those of the propagation. The other 
+// quantity is derived with the impedance or the admittance of the points.
+
+void CrossSection2dFEM::axialProfile(enum physicalQuantity quant, int firstStep,
+  int lastStep, vector<Eigen::MatrixXcd>& profile) const
+{
+  const propagationState& st(state());
+  const magnusWorkspace& ws(st.magnus);
+  int interval(st.checkpointInterval);
+  int numX(st.checkpointKey.numX);
+  int mn(m_modesNumber);
+  enum physicalQuantity propagated(st.checkpointedQuantity);
+  const vector<Eigen::MatrixXcd>& checkpoints((propagated == PRESSURE) ?
+    st.acPressure : st.axialVelocity);
+  // coefficients relating the other quantity to the propagated one
+  const vector<Eigen::MatrixXcd>& coefficients((propagated == PRESSURE) ?
+    st.admittance : st.impedance);
+  magnusStepWorkspace<Eigen::MatrixXcd> stepWs;
+  stepWs.numerator.resize(mn, mn);
+  stepWs.denominator.resize(mn, mn);
+  stepWs.inverse.resize(mn, mn);
+  Eigen::MatrixXcd value;
+
+  profile.resize(lastStep - firstStep + 1);
+  for (int s((firstStep / interval) * interval); s <= lastStep; s++)
+  {
+    if (s % interval == 0) { value = checkpoints[s / interval]; }
+    else if (s == numX - 1) { value = checkpoints.back(); }
+    else
+    {
+      magnusStep(ws.propagators[ws.idxPropagator[s - 1]], mn, propagated,
+        &coefficients[numX - s], value, stepWs);
+      value.swap(stepWs.step);
+    }
+    if (s < firstStep) { continue; }
+    if (quant == propagated) { profile[s - firstStep] = value; }
+    else { profile[s - firstStep].noalias() = coefficients[numX - 1 - s] * value; }
+  }
+}
+
 // **************************************************************************
 // accessors
 
@@ -2273,67 +4100,69 @@ Point2D CrossSection2d::normal() const { return(m_normal); }
 Vector CrossSection2d::normalIn() const { return(Vector(m_normal.x, m_normal.y)); }
 double CrossSection2d::area() const { return(m_area); }
 //******************************************************
-Eigen::MatrixXcd CrossSection2d::Zin() const
+const Eigen::MatrixXcd& CrossSection2d::Zin() const
 {
-  if (Zdir() == 1) {return m_impedance[0];}
-  else { return m_impedance.back(); }
+  if (Zdir() == 1) {return state().impedance[0];}
+  else { return state().impedance.back(); }
 }
 //******************************************************
-Eigen::MatrixXcd CrossSection2d::Zout() const
+const Eigen::MatrixXcd& CrossSection2d::Zout() const
 {
-  if (Zdir() == 1) {return m_impedance.back();}
-  else { return m_impedance[0]; }
+  if (Zdir() == 1) {return state().impedance.back();}
+  else { return state().impedance[0]; }
 }
 //******************************************************
-Eigen::MatrixXcd CrossSection2d::Yin() const
+const Eigen::MatrixXcd& CrossSection2d::Yin() const
 {
-  if (Ydir() == 1) { return m_admittance[0]; }
-  else { return m_admittance.back(); }
+  if (Ydir() == 1) { return state().admittance[0]; }
+  else { return state().admittance.back(); }
 }
 //******************************************************
-Eigen::MatrixXcd CrossSection2d::Yout() const
+const Eigen::MatrixXcd& CrossSection2d::Yout() const
 {
-  if (Ydir() == 1) {return m_admittance.back();}
-  else { return m_admittance[0]; }
+  if (Ydir() == 1) {return state().admittance.back();}
+  else { return state().admittance[0]; }
 }
 //******************************************************
-Eigen::MatrixXcd  CrossSection2d::Qin() const
+const Eigen::MatrixXcd& CrossSection2d::Qin() const
 {
-  if (Qdir() == 1) { return m_axialVelocity[0]; }
-  else { return m_axialVelocity.back(); }
+  if (Qdir() == 1) { return state().axialVelocity[0]; }
+  else { return state().axialVelocity.back(); }
 }
 //******************************************************
 Eigen::MatrixXcd CrossSection2d::Qout() const
 {
-  if (m_axialVelocity.size() == 0)
+  if (state().axialVelocity.size() == 0)
   {
     return Yout() * Pout();
   }
   else if (Qdir() == 1) 
   {
-    return m_axialVelocity.back(); 
+    return state().axialVelocity.back(); 
   }
   else 
-  { return m_axialVelocity[0]; 
+  { return state().axialVelocity[0]; 
   }
 }
 //******************************************************
-Eigen::MatrixXcd CrossSection2d::Pin() const
+const Eigen::MatrixXcd& CrossSection2d::Pin() const
 {
-  if (Pdir() == 1) { return m_acPressure[0]; }
-  else { return m_acPressure.back(); }
+  if (Pdir() == 1) { return state().acPressure[0]; }
+  else { return state().acPressure.back(); }
 }
 //******************************************************
-Eigen::MatrixXcd CrossSection2d::Pout() const
+const Eigen::MatrixXcd& CrossSection2d::Pout() const
 {
-  if (m_acPressure.size() == 0)
+  static const Eigen::MatrixXcd empty;
+
+  if (state().acPressure.size() == 0)
   {
-    return Eigen::MatrixXcd();
+    return empty;
   }
   else
   {
-    if (Pdir() == 1) { return m_acPressure.back(); }
-    else { return m_acPressure[0]; }
+    if (Pdir() == 1) { return state().acPressure.back(); }
+    else { return state().acPressure[0]; }
   }
 }
 //******************************************************
@@ -2410,21 +4239,19 @@ double CrossSection2dFEM::length() const {
 
 vector<double> CrossSection2dFEM::intersectionsArea() const { return m_intersectionsArea; }
 double CrossSection2dFEM::spacing() const { return m_spacing; }
-int CrossSection2dFEM::numberOfVertices() const { return m_mesh.number_of_vertices(); }
-int CrossSection2dFEM::numberOfFaces() const { return m_mesh.number_of_faces(); }
-CDT CrossSection2dFEM::triangulation() const { return m_mesh; }
-Polygon_2 CrossSection2dFEM::contour() const { return m_contour; }
+int CrossSection2dFEM::numberOfVertices() const { return m_points.size(); }
+int CrossSection2dFEM::numberOfFaces() const { return m_triangles.size(); }
+const Polygon_2& CrossSection2dFEM::contour() const { return m_contour; }
 bool CrossSection2dFEM::isJunction() const { return m_junctionSection; }
 vector<int> CrossSection2dFEM::surfaceIdx() const { return m_surfaceIdx; }
 double CrossSection2dFEM::eigenFrequency(int idxMode) const { return m_eigenFreqs[idxMode]; }
-vector<array<double, 2>> CrossSection2dFEM::getPoints() const { return m_points; }
-vector<array<int, 3>> CrossSection2dFEM::getTriangles() const { return m_triangles; }
-Matrix CrossSection2dFEM::getModes() const { return m_modes; }
+const vector<array<double, 2>>& CrossSection2dFEM::getPoints() const { return m_points; }
+const vector<array<int, 3>>& CrossSection2dFEM::getTriangles() const { return m_triangles; }
+const Matrix& CrossSection2dFEM::getModes() const { return m_modes; }
 double CrossSection2dFEM::getMaxAmplitude(int idxMode) const { return m_maxAmplitude[idxMode]; }
 double CrossSection2dFEM::getMinAmplitude(int idxMode) const { return m_minAmplitude[idxMode]; }
-vector<Matrix> CrossSection2dFEM::getMatrixF() const { return m_F; }
-Matrix CrossSection2dFEM::getMatrixGStart() const { return m_Gstart; }
-Matrix CrossSection2dFEM::getMatrixGEnd() const { return m_Gend; }
+const Matrix& CrossSection2dFEM::getMatrixGStart() const { return m_Gstart; }
+const Matrix& CrossSection2dFEM::getMatrixGEnd() const { return m_Gend; }
 
 // ****************************************************************************
 // Operator overload
@@ -26,8 +26,14 @@
 #include <chrono>    // to get the computation time
 #include <ctime>  
 #include <vector>
+#include <map>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <atomic>
 #include <boost/bimap.hpp>
 #include "Geometry.h"
+#include "ModesCache.h"
 
 // for eigen
 #include <Eigen/Dense>
@@ -38,6 +44,7 @@
 #include "Delaunay_mesh_vertex_base_with_info_2.h"
 #include <CGAL/Constrained_Delaunay_triangulation_2.h>
 #include <CGAL/Delaunay_triangulation_2.h>
+#include <CGAL/Triangulation_vertex_base_with_info_2.h>
 #include <CGAL/Delaunay_mesh_face_base_2.h>
 #include <CGAL/Boolean_set_operations_2.h>
 
@@ -60,6 +67,25 @@ typedef CGAL::Vector_2<K>                Vector;
 
 typedef CGAL::Polygon_2<K>                          Polygon_2;
 
+// Delaunay triangulation of the mesh points, the vertices store the index 
+// of the point, used to interpolate the modes
+typedef CGAL::Triangulation_vertex_base_with_info_2<int, K>   VbInterp;
+typedef CGAL::Triangulation_data_structure_2<VbInterp>        TdsInterp;
+typedef CGAL::Delaunay_triangulation_2<K, TdsInterp>          Interpolation_triangulation;
+
+struct modesInterpolator
+{
+  // triangulation of the mesh points, copied for each concurrent interpolation
+  Interpolation_triangulation triangulation;
+  // the point location is not thread safe (the walk uses a random generator),
+  // so each concurrent interpolation uses a copy of its own
+  mutex poolMutex;
+  list<Interpolation_triangulation> copies;
+  vector<Interpolation_triangulation*> available;
+  Interpolation_triangulation* acquire();
+  void release(Interpolation_triangulation* T);
+};
+
 enum propagationMethod {
   MAGNUS,
   STRAIGHT_TUBES
@@ -78,11 +104,24 @@ enum areaVariationProfile {
   ELEPHANT
 };
 
+// closed set of the kinds of cross-sections, so that the propagation loops
+// test the kind of a section without run time type information
+enum crossSectionType {
+  EMPTY_SECTION,      // no mesh nor modes
+  FEM_SECTION,        // modes of a contour computed by finite elements
+  RADIATION_SECTION   // radiation domain surrounded by a PML
+};
+
 enum integrationMethodRadiation {
   DISCRETE,
   GAUSS
 };
 
+enum integrationMethodRadImped {
+  POLAR_GRID,       // reference method (polar grid around each point)
+  FFT_CONVOLUTION   // convolution on the cartesian grid computed by FFT
+};
+
 struct simulationParameters
 {
   double temperature;
@@ -91,6 +130,62 @@ struct simulationParameters
   int numIntegrationStep;
   int orderMagnusScheme;
   double maxCutOnFreq;
+  // frequency dependent number of coupled modes in the propagation: only the 
+  // modes with cut-on frequency lower than modesFreqFactor * freq + 
+  // modesFreqMargin are coupled, the others propagate independently
+  bool freqDependentModes;
+  double modesFreqFactor;
+  double modesFreqMargin;
+  // hybrid sweep: below hybridCrossoverFactor times the lowest cut-on
+  // frequency of the higher order modes of all the segments, only the plane
+  // mode is coupled along the segments, the higher order modes propagating
+  // independently (Magnus method only). The plane wave and the multimodal 
+  // solutions are blended linearly over the band of relative width 
+  // hybridBlendWidth below the crossover.
+  bool hybridPlaneWave;
+  double hybridCrossoverFactor;
+  double hybridBlendWidth;
+  // the cross-sections whose contours are identical up to a scaling share
+  // the mesh and the modes of the largest one, scaled analytically
+  bool shareScaledModes;
+  // the mesh spacing of each cross-section is set to reach the relative 
+  // accuracy meshFreqAccuracy on the eigenfrequencies up to maxCutOnFreq 
+  // instead of being proportional to the size of the cross-section
+  bool adaptiveMeshDensity;
+  double meshFreqAccuracy;
+  // the modes of the circular and rectangular cross-sections are computed 
+  // from their closed-form expressions instead of the FEM eigenproblem
+  bool analyticModes;
+  // the sparse eigensolver of each cross-section starts from the modes of 
+  // the previous one interpolated on its mesh instead of a random subspace
+  // (the cross-sections are then computed in chains, one chain per thread)
+  bool warmStartModes;
+  // the runs of consecutive slices of an imported geometry whose contours 
+  // are identical up to a scaling varying linearly along the centerline are
+  // merged into one segment, if the merged segment deviates by less than
+  // coarseningTolerance (cm) from the slices (0 to keep all the slices)
+  double coarseningTolerance;
+  // the intersections of the contours (junctions and creation of the
+  // contours of imported geometries) are computed in double precision, the
+  // exact CGAL computation is only used for the degenerate cases
+  bool floatPolygonClipping;
+  // the number of integration points of each segment is set from an 
+  // estimate of the error of the Magnus scheme (lower than 
+  // integrationStepTolerance), numIntegrationStep is then the maximal number
+  // of points (the acoustic field inside a segment is interpolated between
+  // its integration points)
+  bool adaptiveIntegrationStep;
+  double integrationStepTolerance;
+  // the impedance, admittance, pressure and velocity are propagated along 
+  // the Magnus steps in single precision (the propagators are still computed
+  // in double precision)
+  bool singlePrecisionPropagation;
+  // if > 1, the pressure and the velocity propagated by the Magnus scheme 
+  // are only stored every axialCheckpointInterval integration points of the
+  // segments (the checkpoints) when the axial profile is stored, the field 
+  // between two checkpoints being integrated again from the previous one 
+  // when it is computed
+  int axialCheckpointInterval;
   complex<double> viscousBndSpecAdm;
   complex<double> thermalBndSpecAdm;
   enum propagationMethod propMethod;
@@ -106,11 +201,19 @@ struct simulationParameters
   bool radImpedPrecomputed;
   double radImpedGridDensity;
   enum integrationMethodRadiation integrationMethodRadiation;
+  enum integrationMethodRadImped integrationMethodRadImped;
 
   // for transfer function computation
   double maxComputedFreq;
   int spectrumLgthExponent;
   vector<Point_3> tfPoint;
+  int numThreads;             // number of threads used for the frequency sweep
+  // memory budget in MB (0 for no limit): the number of threads of the 
+  // frequency sweep is reduced and the dense eigensolver is not used for 
+  // the meshes whose matrices would exceed it
+  double memoryBudget;
+  bool adaptiveFreqSampling;  // solve only the frequencies needed to interpolate the tf
+  double adaptiveTfTolerance; // maximal interpolation error of the adaptive sweep (dB)
 
   // for acoustic field computation
   double freqField;
@@ -121,10 +224,245 @@ struct simulationParameters
   Point bboxLastFieldComputed[2];
   int fieldResolution;        // number of points per cm
   int fieldResolutionPicture; // number of points per cm of the last field computation
+  int progressiveFieldLevels; // number of coarser grids computed first (0 for none)
+  double fieldRefinementTolerance; // relative variation of a cell above which it is refined
   bool computeRadiatedField;
   bool computeFieldImage;
 };
 
+/////////////////////////////////////////////////////////////////////////////
+// Propagation state of a cross-section: impedance, admittance, axial velocity
+// and acoustic pressure computed for one frequency
+/////////////////////////////////////////////////////////////////////////////
+
+// work matrices of the propagation along the steps of the Magnus scheme,
+// in double (Eigen::MatrixXcd) or single (Eigen::MatrixXcf) precision
+template <class MatrixType>
+struct magnusStepWorkspace
+{
+  // propagators converted to the precision of the propagation
+  vector<MatrixType> propagators;
+  MatrixType numerator, denominator, inverse, step;
+  // propagated quantity and impedance or admittance of the segment in the
+  // precision of the propagation, converted once before the recursion (not
+  // used in double precision)
+  vector<MatrixType> profile, coefficients;
+  Eigen::PartialPivLU<MatrixType> lu;
+};
+
+// what the propagators of the steps of a segment were computed for: they 
+// are only reused within the same propagator scope (see MagnusPropagatorScope),
+// and never if the scope is 0
+struct magnusPropagatorKey
+{
+  long scope = 0;
+  double freq = 0.;
+  double dX = 0.;
+  double direction = 0.;
+  int numX = 0;
+  int numCoupledModes = 0;
+  int order = 0;
+
+  bool sameAs(const magnusPropagatorKey& key) const
+  {
+    return (scope != 0) && (scope == key.scope) && (freq == key.freq) && 
+      (numX == key.numX) && (numCoupledModes == key.numCoupledModes) && 
+      (order == key.order) && (dX == key.dX) && (direction == key.direction);
+  }
+
+  // same steps, whatever the scope
+  bool sameSteps(const magnusPropagatorKey& key) const
+  {
+    return (freq == key.freq) && (numX == key.numX) && 
+      (numCoupledModes == key.numCoupledModes) && (order == key.order) && 
+      (dX == key.dX) && (direction == key.direction);
+  }
+
+  // same steps traversed in the opposite direction
+  bool reverseOf(const magnusPropagatorKey& key) const
+  {
+    return (scope != 0) && (scope == key.scope) && (freq == key.freq) && 
+      (numX == key.numX) && (numCoupledModes == key.numCoupledModes) && 
+      (order == key.order) && (dX == -key.dX) && (direction == -key.direction);
+  }
+};
+
+// work matrices of the Magnus scheme, kept from one propagation to the next 
+// so that they are not reallocated at each integration step
+struct magnusWorkspace
+{
+  Eigen::MatrixXcd A0, A1, expA, commutator, KR2;
+  // blocks of the matrices of the coupled modes which do not depend on the
+  // frequency nor on the scaling, formed once per propagation
+  Eigen::MatrixXcd E, ET, curvC, curvDN;
+  Eigen::MatrixXd sumKR2;
+  Eigen::VectorXd eigenWaveNumbers2;
+  // propagators of the steps of the segment
+  vector<Eigen::MatrixXcd> propagators;
+  vector<int> idxPropagator;
+  // propagators of the other direction of the last propagations, kept to be
+  // reused or inverted, and the keys of both sets of propagators
+  vector<Eigen::MatrixXcd> otherPropagators;
+  vector<int> idxOtherPropagator;
+  magnusPropagatorKey key, otherKey;
+  Eigen::PartialPivLU<Eigen::MatrixXcd> inverseLu;
+  magnusStepWorkspace<Eigen::MatrixXcd> doubleSteps;
+  magnusStepWorkspace<Eigen::MatrixXcf> singleSteps;
+  vector<Eigen::Matrix2cd> B0, B1, expB;
+};
+
+// work matrices of the propagation of one frequency through the junctions 
+// of the segments, from the boundary conditions at the ends of the geometry
+// (or at a noise source) to the other end, kept from one frequency to the 
+// next so that the steady state of a sweep does not allocate them again
+// (the assignment of a matrix of the same size reuses its storage)
+struct junctionWorkspace
+{
+  // boundary conditions at the exit, the glottis and the noise sources
+  Eigen::MatrixXcd radImped, radAdmit, inputVelocity, inputPressure;
+  Eigen::MatrixXcd downStreamImpAdm, inputPressureNoise, sourceVelo, sourcePress;
+  vector<Eigen::MatrixXcd> sourcesDownStreamImpAdm;
+  Eigen::VectorXcd radValues;
+  // impedance, admittance, pressure and velocity entering a section
+  Eigen::MatrixXcd prevImped, prevAdmit, prevVelo, prevPress;
+  // complementary of the scattering matrix of a junction
+  Matrix G;
+  // intermediate products and inverses of the junction relations
+  Eigen::MatrixXcd product, product2, inverse, solution;
+  Eigen::PartialPivLU<Eigen::MatrixXcd> lu;
+  Eigen::FullPivLU<Eigen::MatrixXcd> fullLu;
+  Eigen::HouseholderQR<Eigen::MatrixXcd> qr;
+  // impedances and axial velocities along a section
+  vector<Eigen::MatrixXcd> inputImped, axialVelocity;
+};
+
+// diagonal quantities of the modes of a cross-section at the frequencies of
+// a sweep, computed once before the sweep and shared by the copies of the
+// cross-section
+struct sweepTables
+{
+  vector<double> freqs;
+  // characteristic impedance and admittance (modes x frequencies)
+  Eigen::MatrixXcd characImped, characAdmit;
+  // wall admittance (frequencies) and boundary specific admittance 
+  // (modes x frequencies)
+  Eigen::VectorXcd wallAdmit;
+  Eigen::MatrixXcd bndSpecAdm;
+  // diagonal propagation factors of the straight tube method, cos(kn L) and 
+  // j sin(kn L) (modes x frequencies)
+  Eigen::MatrixXcd tubeCos, tubeSin;
+};
+
+struct propagationState
+{
+  vector<Eigen::MatrixXcd> impedance;
+  vector<Eigen::MatrixXcd> admittance;
+  vector<Eigen::MatrixXcd> axialVelocity;
+  vector<Eigen::MatrixXcd> acPressure;
+  int direction[4]; // 0 dir Z | 1 dir Y | 2 dir Q | dir P
+  bool computeImpedance;
+  // if false, only the values at the ends of the segment are kept for the 
+  // pressure and the velocity (enough for the transfer functions)
+  bool storeAxialProfile;
+  // the pressure and the velocity are stored at the integration points 
+  // 0, checkpointInterval, 2 checkpointInterval... and at the last one, 
+  // checkpointedQuantity being the propagated one (the other one is derived
+  // from it) and checkpointKey the propagators of its steps
+  int checkpointInterval = 1;
+  enum physicalQuantity checkpointedQuantity = PRESSURE;
+  magnusPropagatorKey checkpointKey;
+  magnusWorkspace magnus;
+};
+
+class CrossSection2d;
+
+/////////////////////////////////////////////////////////////////////////////
+// classe Propagation workspace
+//
+// Holds the propagation states of the cross-sections of a geometry and the
+// work matrices of the junctions, so that several frequencies can be 
+// propagated at the same time through the same cross-sections: the modes 
+// and the junction matrices are shared and only read, while each thread 
+// binds its own workspace. When no workspace is bound to the thread, the 
+// cross-sections use their own propagation state.
+/////////////////////////////////////////////////////////////////////////////
+
+class PropagationWorkspace
+{
+public:
+
+  // state of a cross-section, created from its own state (directions only)
+  // the first time it is accessed
+  propagationState& state(const CrossSection2d* cs, const propagationState& initState);
+  junctionWorkspace& junctions() { return m_junctions; }
+  void clear() { m_states.clear(); m_junctions = junctionWorkspace(); }
+
+  // bind the workspace to the calling thread (NULL to unbind)
+  static void setCurrent(PropagationWorkspace* workspace) { m_current = workspace; }
+  static PropagationWorkspace* current() { return m_current; }
+
+private:
+
+  map<const CrossSection2d*, propagationState> m_states;
+  junctionWorkspace m_junctions;
+  static thread_local PropagationWorkspace* m_current;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// classe Magnus propagator scope
+//
+// Within a scope, the propagators of the steps of the Magnus scheme computed
+// for a segment are reused when the segment is propagated again at the same
+// frequency in the calling thread: as they are in the same direction (e.g.
+// impedance then admittance), inverted in the opposite direction (e.g. 
+// admittance then pressure). The geometry, the modes and the parameters must
+// not change within a scope. A scope opened inside another one of the same 
+// thread belongs to the outer one.
+/////////////////////////////////////////////////////////////////////////////
+
+class MagnusPropagatorScope
+{
+public:
+
+  MagnusPropagatorScope();
+  ~MagnusPropagatorScope();
+
+  // scope of the calling thread, 0 if none is open
+  static long current() { return m_current; }
+
+private:
+
+  bool m_outer;
+  static thread_local long m_current;
+  static atomic<long> m_lastScope;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// classe Plane wave scope
+//
+// Within a scope, the propagations of the calling thread only couple the 
+// plane mode along the segments: the higher order modes propagate 
+// independently, so that they still account for the junctions, as with the
+// frequency dependent modes. It is used below the cut-on frequencies of the 
+// higher order modes, where the plane mode is the only propagative one.
+/////////////////////////////////////////////////////////////////////////////
+
+class PlaneWaveScope
+{
+public:
+
+  // the scope is only opened if open is true
+  PlaneWaveScope(bool open = true);
+  ~PlaneWaveScope();
+
+  static bool active() { return m_active; }
+
+private:
+
+  bool m_previous;
+  static thread_local bool m_active;
+};
+
 /////////////////////////////////////////////////////////////////////////////
 // classe Cross section 2d
 /////////////////////////////////////////////////////////////////////////////
@@ -137,90 +475,163 @@ public:
   CrossSection2d();
   CrossSection2d(Point2D ctrLinePt, Point2D normal);
   ~CrossSection2d();
+  // deep copy of the cross-section (each thread of a sweep works on its own copy)
+  virtual unique_ptr<CrossSection2d> clone() const
+  { return unique_ptr<CrossSection2d>(new CrossSection2d(*this)); }
 
   // cross section parameters
   virtual void setJunctionSection(bool junction) { ; }
-  void setComputImpedance(bool imp) { m_computeImpedance = imp; }
+  void setComputImpedance(bool imp) { state().computeImpedance = imp; }
+  void setStoreAxialProfile(bool store) { state().storeAxialProfile = store; }
   void setPreviousSection(int prevSec);
   void setPrevSects(vector<int> prevSects) { m_previousSections = prevSects; }
   void setNextSection(int nextSec);
   void setNextSects(vector<int> nextSects) { m_nextSections = nextSects; }
   void clearPrevSects() { m_previousSections.clear(); }
   void clearNextSects() { m_nextSections.clear(); }
-  void setZdir(int dir) { m_direction[0] = dir; }
-  void setYdir(int dir) { m_direction[1] = dir; }
-  void setQdir(int dir) { m_direction[2] = dir; }
-  void setPdir(int dir) { m_direction[3] = dir; }
+  void setZdir(int dir) { state().direction[0] = dir; }
+  void setYdir(int dir) { state().direction[1] = dir; }
+  void setQdir(int dir) { state().direction[2] = dir; }
+  void setPdir(int dir) { state().direction[3] = dir; }
   virtual void setCurvatureRadius(double radius) { ; }
   virtual void setCurvatureAngle(double angle) { ; }
 
   // cross section mesh and modes
   virtual void setSpacing(double spacing) { ; }
-  virtual void buildMesh() { ; }
+  virtual void buildMesh(bool smooth = true) { ; }
   void setModesNumber(int nb) { m_modesNumber = nb; }
-  virtual void computeModes(struct simulationParameters simuParams) { ; }
+  virtual void computeModes(const struct simulationParameters& simuParams) { ; }
   virtual void selectModes(vector<int> modesIdx) { ; }
   virtual Matrix interpolateModes(vector<Point> pts) { return Matrix(); }
   Matrix interpolateModes(vector<Point> pts, double scaling);
   Matrix interpolateModes(vector<Point> pts, double scaling, Vector translation);
-
-  // scatering  matrices 
+  // batched version: the interpolation matrix is only resized if necessary
+  virtual void interpolateModes(const vector<Point>& pts, Matrix& interpolation)
+    { interpolation = interpolateModes(pts); }
+  void interpolateModes(const vector<Point>& pts, double scaling, 
+    const Vector& translation, Matrix& interpolation);
+
+  // cache of the mesh and the modes
+  virtual CacheKey modesCacheKey(const struct simulationParameters& simuParams) const 
+    { return CacheKey(); }
+  virtual void writeModes(ostream& os) const { ; }
+  virtual bool readModes(istream& is) { return false; }
+  // copy the mesh, the modes and the junction matrices of an identical
+  // cross-section of a previous geometry
+  virtual void copyModesAndJunction(const CrossSection2d& cs) { ; }
+  // set the mesh and the modes from those of a cross-section whose contour 
+  // is the one of this cross-section divided by scaling
+  virtual bool copyScaledModes(const CrossSection2d& cs, double scaling,
+    double maxCutOnFreq) { return false; }
+  // start the iterative eigensolver of the next computation of the modes 
+  // from the modes of a neighbouring cross-section interpolated on the mesh
+  virtual void setModesGuess(CrossSection2d& cs) { ; }
+  // multiply the eigenfrequencies by factor when the sound speed changes 
+  // (the eigenvalues of the modes only depend on the geometry)
+  virtual void scaleEigenFrequencies(double factor) { ; }
+
+  // memory (bytes) of the data stored in the cross-section, and estimate of
+  // the memory of the propagation state needed by a propagation workspace
+  virtual size_t memoryFootprint() const;
+  size_t propagationFootprint(const struct simulationParameters& simuParams,
+    bool storeAxialProfile) const;
+
+  // dirty tracking: the modes and the junction matrices are recomputed only
+  // if the key of the data they depend on changed since their computation
+  void setModesComputed(const CacheKey& key);
+  void setJunctionComputed(const CacheKey& key);
+  void setDirty() { m_modesComputed = false; m_junctionComputed = false; }
+  // if the modes have been computed for this key, restore their number 
+  // (which may have been reset to 0) and return true
+  bool keepComputedModes(const CacheKey& key);
+  bool isJunctionUpToDate(const CacheKey& key) const
+    { return m_junctionComputed && (m_junctionKey == key); }
+  bool areModesComputed() const { return m_modesComputed; }
+  CacheKey computedModesKey() const { return m_modesKey; }
+
+  // scatering  matrices (only stored by the FEM sections)
   virtual void setMatrixF(vector<Matrix> & F) { ; }
   virtual void setMatrixE(Matrix & E) {;}
-  virtual void setMatrixGstart(Matrix Gs) { ; }
-  virtual void setMatrixGend(Matrix Ge) { ; }
+  virtual void setMatrixGstart(const Matrix& Gs) { ; }
+  virtual void setMatrixGend(const Matrix& Ge) { ; }
 
   // impedance, admittance, acoustic pressure and axial velocity
-  void setImpedance(vector<Eigen::MatrixXcd> inputImped) { m_impedance = inputImped; }
-  void setZin(Eigen::MatrixXcd imped);
-  void setZout(Eigen::MatrixXcd imped);
-  void clearImpedance() { m_impedance.clear(); }
-  void setAdmittance(vector<Eigen::MatrixXcd> inputAdmit) { m_admittance = inputAdmit; }
-  void setYin(Eigen::MatrixXcd admit);
-  void setYout(Eigen::MatrixXcd admit);
-  void clearAdmittance() { m_admittance.clear(); }
+  void setImpedance(const vector<Eigen::MatrixXcd>& inputImped) { state().impedance = inputImped; }
+  void setZin(const Eigen::MatrixXcd& imped);
+  void setZout(const Eigen::MatrixXcd& imped);
+  void clearImpedance() { state().impedance.clear(); }
+  void setAdmittance(const vector<Eigen::MatrixXcd>& inputAdmit) { state().admittance = inputAdmit; }
+  void setYin(const Eigen::MatrixXcd& admit);
+  void setYout(const Eigen::MatrixXcd& admit);
+  void clearAdmittance() { state().admittance.clear(); }
   virtual void characteristicImpedance(
-    Eigen::MatrixXcd & characImped, double freq, struct simulationParameters simuParams) {;}
+    Eigen::MatrixXcd & characImped, double freq, const struct simulationParameters& simuParams) {;}
   virtual void characteristicAdmittance(
-    Eigen::MatrixXcd& admit, double freq, struct simulationParameters simuParams) {;}
+    Eigen::MatrixXcd& admit, double freq, const struct simulationParameters& simuParams) {;}
   virtual complex<double> getWallAdmittance( 
-    struct simulationParameters simuParams, double freq) { return complex<double>(); }
-  virtual void getSpecificBndAdm(struct simulationParameters simuParams, double freq, 
+    const struct simulationParameters& simuParams, double freq) { return complex<double>(); }
+  virtual void getSpecificBndAdm(const struct simulationParameters& simuParams, double freq, 
     Eigen::VectorXcd& bndSpecAdm) {;}
-  void setAxialVelocity(vector<Eigen::MatrixXcd> inputVelocity) { m_axialVelocity = inputVelocity; }
-  void clearAxialVelocity() { m_axialVelocity.clear(); }
-  void setAcPressure(vector<Eigen::MatrixXcd> inputPressure) { m_acPressure = inputPressure; }
-  void clearAcPressure() { m_acPressure.clear(); }
+  // tabulate the quantities above at the frequencies of a sweep (the tables
+  // are removed if freqs is empty), the other frequencies are computed
+  virtual void precomputeSweepTables(const vector<double>& freqs,
+    const struct simulationParameters& simuParams) {;}
+  void setAxialVelocity(const vector<Eigen::MatrixXcd>& inputVelocity) { state().axialVelocity = inputVelocity; }
+  void clearAxialVelocity() { state().axialVelocity.clear(); }
+  void setAcPressure(const vector<Eigen::MatrixXcd>& inputPressure) { state().acPressure = inputPressure; }
+  void clearAcPressure() { state().acPressure.clear(); }
 
   // propagation 
   virtual double scaling(double tau){return 1.;}
   virtual double scalingDerivative(double tau){return 1.;}
   virtual void setAreaVariationProfileType(enum areaVariationProfile profile){;}
-  virtual void propagateMagnus(Eigen::MatrixXcd Q0, struct simulationParameters simuParams,
+  // number of integration points of the Magnus scheme in this segment 
+  // (numIntegrationStep of the simulation parameters if it is not set)
+  void setNumIntegrationStep(int num) { m_numIntegrationStep = num; }
+  int numIntegrationStep(const struct simulationParameters& simuParams) const
+  {
+    return (m_numIntegrationStep > 0) ? m_numIntegrationStep : simuParams.numIntegrationStep;
+  }
+  virtual int adaptiveIntegrationStep(const struct simulationParameters& simuParams, 
+    double freq) { return simuParams.numIntegrationStep; }
+  virtual void propagateMagnus(const Eigen::MatrixXcd& Q0, const struct simulationParameters& simuParams,
     double freq, double direction, enum physicalQuantity quant, std::chrono::duration<double> *time) {;}
-  virtual void propagateImpedAdmitStraight(Eigen::MatrixXcd Z0,
-    Eigen::MatrixXcd Y0, double freq, struct simulationParameters simuParams,
+  virtual void propagateImpedAdmitStraight(const Eigen::MatrixXcd& Z0,
+    const Eigen::MatrixXcd& Y0, double freq, const struct simulationParameters& simuParams,
     double prevArea, double nextArea) {;}
-  virtual void propagatePressureVelocityStraight(Eigen::MatrixXcd V0,
-    Eigen::MatrixXcd P0, double freq, struct simulationParameters simuParams, double nextArea) {;}
+  virtual void propagatePressureVelocityStraight(const Eigen::MatrixXcd& V0,
+    const Eigen::MatrixXcd& P0, double freq, const struct simulationParameters& simuParams, double nextArea) {;}
 
   // for acoustic field computation
   virtual bool getCoordinateFromCartesianPt(Point_3 pt, Point_3 &ptOut, bool useBbox){return bool();}
+  // bounding box of the points of the segment in the sagittal plane (x, z)
+  virtual CGAL::Bbox_2 sagittalBbox() { return CGAL::Bbox_2(); }
   virtual void radiatePressure(double distance, double freq,
-    struct simulationParameters simuParams, Eigen::MatrixXcd& pressAmp) { ; }
+    const struct simulationParameters& simuParams, Eigen::MatrixXcd& pressAmp) { ; }
   virtual complex<double> pin(Point pt) {return complex<double>();}
   virtual complex<double> pout(Point pt) {return complex<double>();}
   virtual complex<double> qin(Point pt) {return complex<double>();}
   virtual complex<double> qout(Point pt) {return complex<double>();}
-  virtual complex<double> p(Point_3 pt, struct simulationParameters simuParams)
+  virtual complex<double> p(Point_3 pt, const struct simulationParameters& simuParams)
     {return complex<double>();}
-  virtual complex<double> q(Point_3 pt, struct simulationParameters simuParams)
+  virtual complex<double> q(Point_3 pt, const struct simulationParameters& simuParams)
     {return complex<double>();}
-  virtual complex<double> interiorField(Point_3 pt, struct simulationParameters simuParams,
+  virtual complex<double> interiorField(Point_3 pt, const struct simulationParameters& simuParams,
           enum physicalQuantity quant)
     {return complex<double>();}
-  virtual complex<double> interiorField(Point_3 pt, struct simulationParameters simuParams)
+  virtual complex<double> interiorField(Point_3 pt, const struct simulationParameters& simuParams)
     {return complex<double>();}
+  // compute the data needed by interiorField (before calling it from several threads)
+  virtual void prepareInteriorField(enum physicalQuantity quant,
+    const struct simulationParameters& simuParams) { ; }
+  // field at points given in local coordinates, the amplitudes of the modes
+  // at their position in the cross-section (rows of modes) being known
+  virtual void interiorField(const vector<Point_3>& pts, const Matrix& modes,
+    const struct simulationParameters& simuParams, enum physicalQuantity quant,
+    Eigen::VectorXcd& field)
+  {
+    field.setConstant(pts.size(), complex<double>(NAN, NAN));
+  }
 
   // **************************************************************************
   // accessors
@@ -231,7 +642,10 @@ public:
   vector<int> prevSections() const { return m_previousSections; }
   int nextSec(int idx) const;
   vector<int> nextSections() const { return m_nextSections; }
-  bool computeImpedance() const { return m_computeImpedance; }
+  bool computeImpedance() const { return state().computeImpedance; }
+  bool storeAxialProfile() const { return state().storeAxialProfile; }
+  // interval between the integration points where P() and Q() are stored
+  int checkpointInterval() const { return state().checkpointInterval; }
   Point2D ctrLinePt() const;
   Point ctrLinePtIn() const;
   virtual Point ctrLinePtOut() const { return Point(); }
@@ -241,9 +655,15 @@ public:
 
   double area() const;
   int numberOfModes() const { return m_modesNumber; }
+  crossSectionType type() const { return m_type; }
+  bool isFEM() const { return m_type == FEM_SECTION; }
+  bool isRadiation() const { return m_type == RADIATION_SECTION; }
 
-  virtual double scaleIn() const { return 1.;  }
-  virtual double scaleOut() const { return 1.; }
+  // the accessors called for each section at each frequency of the 
+  // propagation are not virtual, so that they can be inlined
+  double scaleIn() const { return m_scalingFactors[0];  }
+  double scaleOut() const { return m_scalingFactors[1]; }
+  const vector<Matrix>& getMatrixF() const { return m_F; }
   virtual double length() const { return 0.; }
   virtual vector<double> intersectionsArea() const { return vector<double>(0); }
   virtual double curvature() { return 0.; }
@@ -251,59 +671,79 @@ public:
   virtual double spacing() const { return 0.; }
   virtual int numberOfVertices() const { return 0; }
   virtual int numberOfFaces() const { return 0; }
-  virtual CDT triangulation() const { return CDT(); }
-  virtual Polygon_2 contour() const { return Polygon_2(); }
+  // the mesh, modes and matrices are returned by reference to avoid copying 
+  // them at each frequency, the references are valid until they are modified
+  virtual const CDT& triangulation() const { static const CDT empty; return empty; }
+  virtual const Polygon_2& contour() const { static const Polygon_2 empty; return empty; }
   virtual bool isJunction() const { return bool(); }
   virtual vector<int> surfaceIdx() const { return vector<int>(); }
   virtual double eigenFrequency(int idxMode) const { return 0.; }
-  virtual vector<array<double, 2>> getPoints() const { return vector<array<double, 2>>(); }
-  virtual vector<array<int, 3>> getTriangles() const { return vector<array<int, 3>>(); }
-  virtual Matrix getModes() const { return Matrix(); }
+  virtual const vector<array<double, 2>>& getPoints() const 
+  { 
+    static const vector<array<double, 2>> empty; return empty; 
+  }
+  virtual const vector<array<int, 3>>& getTriangles() const 
+  { 
+    static const vector<array<int, 3>> empty; return empty; 
+  }
+  virtual const Matrix& getModes() const { static const Matrix empty; return empty; }
   virtual double getMaxAmplitude(int idxMode) const { return 0.; }
   virtual double getMinAmplitude(int idxMode) const { return 0.; }
-  virtual vector<Matrix> getMatrixF() const { return vector<Matrix>(); }
-  virtual Matrix getMatrixGStart() const { return Matrix(); }
-  virtual Matrix getMatrixGEnd() const { return Matrix(); }
-  virtual Matrix getMatrixC() const { return Matrix(); }
-  virtual Matrix getMatrixD() const { return Matrix(); }
-  virtual Matrix getMatrixE() const {return Matrix();}
-  virtual Matrix getMatrixKR2(int idx) const { return Matrix(); }
-  virtual vector<Matrix> getMatrixKR2() const { return vector<Matrix>(); }
+  virtual const Matrix& getMatrixGStart() const { static const Matrix empty; return empty; }
+  virtual const Matrix& getMatrixGEnd() const { static const Matrix empty; return empty; }
+  virtual const Matrix& getMatrixC() const { static const Matrix empty; return empty; }
+  virtual const Matrix& getMatrixD() const { static const Matrix empty; return empty; }
+  virtual const Matrix& getMatrixE() const { static const Matrix empty; return empty; }
+  virtual const Matrix& getMatrixKR2(int idx) const { static const Matrix empty; return empty; }
+  virtual const vector<Matrix>& getMatrixKR2() const 
+  { 
+    static const vector<Matrix> empty; return empty; 
+  }
   virtual double curvRadius() const { return double(); }
   virtual double radius() const { return double(); }
   virtual double PMLThickness() const { return double(); }
 
-  int Zdir() const { return m_direction[0]; }
-  int Ydir() const { return m_direction[1]; }
-  int Qdir() const { return m_direction[2]; }
-  int Pdir() const { return m_direction[3]; }
-  vector<Eigen::MatrixXcd> Z() const { return m_impedance; }
-  Eigen::MatrixXcd Zin() const;
-  Eigen::MatrixXcd Zout() const;
-  vector<Eigen::MatrixXcd> Y() const { return m_admittance; }
-  Eigen::MatrixXcd Yin() const;
-  Eigen::MatrixXcd Yout() const;
-  vector<Eigen::MatrixXcd> Q() const { return m_axialVelocity; }
-  Eigen::MatrixXcd Qin() const; 
+  int Zdir() const { return state().direction[0]; }
+  int Ydir() const { return state().direction[1]; }
+  int Qdir() const { return state().direction[2]; }
+  int Pdir() const { return state().direction[3]; }
+  const vector<Eigen::MatrixXcd>& Z() const { return state().impedance; }
+  const Eigen::MatrixXcd& Zin() const;
+  const Eigen::MatrixXcd& Zout() const;
+  const vector<Eigen::MatrixXcd>& Y() const { return state().admittance; }
+  const Eigen::MatrixXcd& Yin() const;
+  const Eigen::MatrixXcd& Yout() const;
+  const vector<Eigen::MatrixXcd>& Q() const { return state().axialVelocity; }
+  const Eigen::MatrixXcd& Qin() const; 
+  // computed from the admittance and the pressure if the velocity is not stored
   Eigen::MatrixXcd Qout() const;
-  vector<Eigen::MatrixXcd> P() const { return m_acPressure; }
-  Eigen::MatrixXcd Pin() const;
-  Eigen::MatrixXcd Pout() const;
+  const vector<Eigen::MatrixXcd>& P() const { return state().acPressure; }
+  const Eigen::MatrixXcd& Pin() const;
+  const Eigen::MatrixXcd& Pout() const;
 
 protected:
 
+  // propagation state of the workspace bound to the thread, or own state
+  propagationState& state() const;
+
+  crossSectionType m_type;
   vector<int> m_previousSections;
   vector<int> m_nextSections;
   Point2D m_ctrLinePt;
   Point2D m_normal;
   double m_area;
+  double m_scalingFactors[2];     // scaling of the contour at the entrance and the exit
+  vector<Matrix> m_F;             // mode coupling matrices, empty for the radiation sections
   int m_modesNumber;
-  int m_direction[4]; // 0 dir Z | 1 dir Y | 2 dir Q | dir P
-  vector<Eigen::MatrixXcd> m_impedance;
-  vector<Eigen::MatrixXcd> m_admittance;
-  vector<Eigen::MatrixXcd> m_axialVelocity;
-  vector<Eigen::MatrixXcd> m_acPressure;
-  bool m_computeImpedance;
+  int m_numIntegrationStep;
+  mutable propagationState m_state;
+
+  // dirty tracking
+  bool m_modesComputed;
+  int m_computedModesNumber;
+  CacheKey m_modesKey;
+  bool m_junctionComputed;
+  CacheKey m_junctionKey;
 
 };
 
@@ -311,7 +751,7 @@ protected:
 // classe Cross section 2d FEM
 /////////////////////////////////////////////////////////////////////////////
 
-class CrossSection2dFEM : public CrossSection2d
+class CrossSection2dFEM final : public CrossSection2d
 {
   // **************************************************************************
   // Public functions.
@@ -323,62 +763,83 @@ public:
     double area, double spacing, Polygon_2 contour, vector<int> surfacesIdx,
     double inLength, double scalingFactors[2]);
   ~CrossSection2dFEM();
+  unique_ptr<CrossSection2d> clone() const
+  { return unique_ptr<CrossSection2d>(new CrossSection2dFEM(*this)); }
 
   void setJunctionSection(bool junction);
   void setCurvatureRadius(double radius);
   void setCurvatureAngle(double angle);
 
   void setSpacing(double spacing) { m_spacing = spacing; }
-  void buildMesh();
-  void computeModes(struct simulationParameters simuParams);
+  void buildMesh(bool smooth = true);
+  void computeModes(const struct simulationParameters& simuParams);
   void selectModes(vector<int> modesIdx);
   Matrix interpolateModes(vector<Point> pts);
+  void interpolateModes(const vector<Point>& pts, Matrix& interpolation);
+  CacheKey modesCacheKey(const struct simulationParameters& simuParams) const;
+  void writeModes(ostream& os) const;
+  bool readModes(istream& is);
+  void copyModesAndJunction(const CrossSection2d& cs);
+  bool copyScaledModes(const CrossSection2d& cs, double scaling, double maxCutOnFreq);
+  void setModesGuess(CrossSection2d& cs);
+  void scaleEigenFrequencies(double factor);
+  size_t memoryFootprint() const;
   void setMatrixF(vector<Matrix> & F) { m_F = F; }
   void setMatrixE(Matrix & E) {m_E = E;}
   // Set the area of the intersection with the following contour
-  void setMatrixGstart(Matrix & Gs){ m_Gstart = Gs; }
-  void setMatrixGend(Matrix Ge) {m_Gend = Ge;}
+  void setMatrixGstart(const Matrix& Gs){ m_Gstart = Gs; }
+  void setMatrixGend(const Matrix& Ge) {m_Gend = Ge;}
   void characteristicImpedance(Eigen::MatrixXcd& characImped, 
-    double freq, struct simulationParameters simuParams);
+    double freq, const struct simulationParameters& simuParams);
   void characteristicAdmittance(Eigen::MatrixXcd& admit, 
-    double freq, struct simulationParameters simuParams);
-  complex<double> getWallAdmittance(struct simulationParameters simuParams, double freq);
-  void getSpecificBndAdm(struct simulationParameters simuParams, double freq, 
+    double freq, const struct simulationParameters& simuParams);
+  complex<double> getWallAdmittance(const struct simulationParameters& simuParams, double freq);
+  void getSpecificBndAdm(const struct simulationParameters& simuParams, double freq, 
     Eigen::VectorXcd& bndSpecAdm);
+  void precomputeSweepTables(const vector<double>& freqs,
+    const struct simulationParameters& simuParams);
 
   // propagation
   double curvature(bool curved);
   void setAreaVariationProfileType(enum areaVariationProfile profile);
   double scaling(double tau);
   double scalingDerivative(double tau);
-  void propagateMagnus(Eigen::MatrixXcd Q0, struct simulationParameters simuParams,
+  // true if the scaling does not vary along the segment
+  bool constantScaling() const;
+  int numCoupledModes(double freq, const struct simulationParameters& simuParams) const;
+  int adaptiveIntegrationStep(const struct simulationParameters& simuParams, double freq);
+  void propagateMagnus(const Eigen::MatrixXcd& Q0, const struct simulationParameters& simuParams,
     double freq, double direction, enum physicalQuantity quant, std::chrono::duration<double> *time);
-  void propagateImpedAdmitStraight(Eigen::MatrixXcd Z0,
-    Eigen::MatrixXcd Y0, double freq, struct simulationParameters simuParams,
+  void propagateImpedAdmitStraight(const Eigen::MatrixXcd& Z0,
+    const Eigen::MatrixXcd& Y0, double freq, const struct simulationParameters& simuParams,
     double prevArea, double nextArea);
-  void propagatePressureVelocityStraight(Eigen::MatrixXcd V0,
-    Eigen::MatrixXcd P0, double freq, struct simulationParameters simuParams,
+  void propagatePressureVelocityStraight(const Eigen::MatrixXcd& V0,
+    const Eigen::MatrixXcd& P0, double freq, const struct simulationParameters& simuParams,
     double nextArea);
 
   // for acoustic field computation
   bool getCoordinateFromCartesianPt(Point_3 pt, Point_3 &ptOut, bool useBbox);
+  CGAL::Bbox_2 sagittalBbox();
   complex<double> pin(Point pt); 
   complex<double> pout(Point pt); 
   complex<double> qin(Point pt); 
   complex<double> qout(Point pt);
-  complex<double> p(Point_3 pt, struct simulationParameters simuParams);
-  complex<double> q(Point_3 pt, struct simulationParameters simuParams);
-  complex<double> interiorField(Point_3 pt, struct simulationParameters simuParams,
+  complex<double> p(Point_3 pt, const struct simulationParameters& simuParams);
+  complex<double> q(Point_3 pt, const struct simulationParameters& simuParams);
+  complex<double> interiorField(Point_3 pt, const struct simulationParameters& simuParams,
           enum physicalQuantity quant);
-  complex<double> interiorField(Point_3 pt, struct simulationParameters simuParams);
+  complex<double> interiorField(Point_3 pt, const struct simulationParameters& simuParams);
+  void interiorField(const vector<Point_3>& pts, const Matrix& modes,
+    const struct simulationParameters& simuParams, enum physicalQuantity quant,
+    Eigen::VectorXcd& field);
+  void prepareInteriorField(enum physicalQuantity quant,
+    const struct simulationParameters& simuParams);
 
   // **************************************************************************
   // accessors
 
   Point ctrLinePtOut() const;
   Vector normalOut() const;
-  double scaleIn() const { return m_scalingFactors[0];  }
-  double scaleOut() const { return m_scalingFactors[1]; }
   double length() const;
   double curvRadius() const { return m_curvatureRadius; }
   vector<double> intersectionsArea() const;
@@ -386,24 +847,23 @@ public:
   double spacing() const;
   int numberOfVertices() const;
   int numberOfFaces() const;
-  CDT triangulation() const;
-  Polygon_2 contour() const;
+  const CDT& triangulation() const;
+  const Polygon_2& contour() const;
   bool isJunction() const;
   vector<int> surfaceIdx() const;
   double eigenFrequency(int idxMode) const;
-  vector<array<double, 2>> getPoints() const;
-  vector<array<int, 3>> getTriangles() const;
-  Matrix getModes() const;
+  const vector<array<double, 2>>& getPoints() const;
+  const vector<array<int, 3>>& getTriangles() const;
+  const Matrix& getModes() const;
   double getMaxAmplitude(int idxMode) const;
   double getMinAmplitude(int idxMode) const;
-  vector<Matrix> getMatrixF() const;
-  Matrix getMatrixGStart() const;
-  Matrix getMatrixGEnd() const;
-  Matrix getMatrixC() const { return m_C; }
-  Matrix getMatrixD() const { return m_DN; }
-  Matrix getMatrixE() const {return m_E;}
-  Matrix getMatrixKR2(int idx) const { return m_KR2[idx]; }
-  vector<Matrix> getMatrixKR2() const { return m_KR2; }
+  const Matrix& getMatrixGStart() const;
+  const Matrix& getMatrixGEnd() const;
+  const Matrix& getMatrixC() const { return m_C; }
+  const Matrix& getMatrixD() const { return m_DN; }
+  const Matrix& getMatrixE() const {return m_E;}
+  const Matrix& getMatrixKR2(int idx) const { return m_KR2[idx]; }
+  const vector<Matrix>& getMatrixKR2() const { return m_KR2; }
 
 
   // **************************************************************************
@@ -412,14 +872,41 @@ public:
 
 private:
 
+  // build the triangulation used to interpolate the modes
+  void buildInterpolator();
+  // closed-form modes of the circular and rectangular contours at the mesh 
+  // points (false if the contour has another shape)
+  bool computeAnalyticModes(double maxWaveNumber, Eigen::VectorXd& eigenValues,
+    Matrix& eigenVectors) const;
+  // blocks and matrices of the Magnus scheme
+  void prepareMagnusBlocks(const struct simulationParameters& simuParams,
+    double freq, int na, magnusWorkspace& ws);
+  void buildMagnusMatrix(double k, double curv, double l, double dl, int na,
+    const magnusWorkspace& ws, Eigen::MatrixXcd& A) const;
+  // amplitudes of the pressure or the velocity at the integration points 
+  // firstStep ... lastStep (in the order of the propagation), integrated 
+  // again from the previous checkpoint when they are not stored
+  void axialProfile(enum physicalQuantity quant, int firstStep, int lastStep,
+    vector<Eigen::MatrixXcd>& profile) const;
+  // column of freq in the sweep tables, -1 if it is not tabulated
+  int sweepTableIndex(double freq) const;
+  // diagonal propagation factors cos(kn L) and j sin(kn L) of the straight
+  // tube method, from the sweep tables if freq is tabulated
+  void straightTubeFactors(double freq, const struct simulationParameters& simuParams,
+    Eigen::VectorXcd& cosL, Eigen::VectorXcd& jSinL) const;
+
   enum areaVariationProfile m_areaProfile;
-  double m_scalingFactors[2];
   double m_curvatureRadius;
   double m_circleArcAngle;
-  CDT m_mesh;
+  // the mesh is stored in the compact arrays, the triangulation is only
+  // rebuilt from them when it is requested (see triangulation())
+  mutable shared_ptr<const CDT> m_triangulation;
   vector<array<double, 2>> m_points;
   vector<array<int, 3>> m_triangles;
   vector<array<int, 2>> m_meshContourSeg;
+  // built once from the mesh points and shared by the copies of the section
+  shared_ptr<modesInterpolator> m_interpolator;
+  shared_ptr<const sweepTables> m_sweepTables;
   Polygon_2 m_contour;
   double m_perimeter;
   bool m_junctionSection;
@@ -431,9 +918,11 @@ private:
   double m_spacing;
   vector<double> m_eigenFreqs;
   Matrix m_modes;
+  // initial subspace of the sparse eigensolver (vertices x modes), used by
+  // the next computation of the modes only
+  Matrix m_modesGuess;
   vector<double> m_maxAmplitude;
   vector<double> m_minAmplitude;
-  vector<Matrix> m_F;
   Matrix m_Gstart;
   Matrix m_Gend;
   Matrix m_C;
@@ -448,7 +937,7 @@ private:
 // classe Cross section 2d radiation
 /////////////////////////////////////////////////////////////////////////////
 
-class CrossSection2dRadiation : public CrossSection2d
+class CrossSection2dRadiation final : public CrossSection2d
 {
 // **************************************************************************
 // Public functions.
@@ -458,38 +947,53 @@ public:
 
   CrossSection2dRadiation(Point2D ctrLinePt, Point2D normal, double radius, double PMLThickness);
   ~CrossSection2dRadiation() { ; }
+  unique_ptr<CrossSection2d> clone() const
+  { return unique_ptr<CrossSection2d>(new CrossSection2dRadiation(*this)); }
+  size_t memoryFootprint() const;
 
-  void computeModes(struct simulationParameters simuParams);
+  // the modes are computed once for all the radiation sections of the 
+  // process with the same dimensions
+  void computeModes(const struct simulationParameters& simuParams);
   void selectModes(vector<int> modesIdx) { ; }
   Matrix interpolateModes(vector<Point> pts);
 
+  // cache of the modes
+  CacheKey modesCacheKey(const struct simulationParameters& simuParams) const;
+  void writeModes(ostream& os) const;
+  bool readModes(istream& is);
+  // modes of the process already computed for a cache key
+  static bool modesMemoised(const CacheKey& key);
+  void memoiseModes(const CacheKey& key) const;
+  // memory (bytes) of the memoised modes, and release of the memoised modes
+  // at the end of a batch or a server session
+  static size_t memoisedModesFootprint();
+  static void clearMemoisedModes();
+
   void characteristicImpedance(
-    Eigen::MatrixXcd& characImped, double freq, struct simulationParameters simuParams);
+    Eigen::MatrixXcd& characImped, double freq, const struct simulationParameters& simuParams);
   void characteristicAdmittance(Eigen::MatrixXcd &admit, 
-    double freq, struct simulationParameters simuParams);
-  complex<double> getWallAdmittance(struct simulationParameters simuParams,
+    double freq, const struct simulationParameters& simuParams);
+  complex<double> getWallAdmittance(const struct simulationParameters& simuParams,
     double freq) {return complex<double>(); }
-  void getSpecificBndAdm(struct simulationParameters simuParams, double freq,
+  void getSpecificBndAdm(const struct simulationParameters& simuParams, double freq,
     Eigen::VectorXcd& bndSpecAdm) {;}
 
   // propagation
-  void propagateMagnus(Eigen::MatrixXcd Q0, struct simulationParameters simuParams,
+  void propagateMagnus(const Eigen::MatrixXcd& Q0, const struct simulationParameters& simuParams,
     double freq, double direction, enum physicalQuantity quant, std::chrono::duration<double> *time) {;}
-  void propagateImpedAdmitStraight(Eigen::MatrixXcd Z0,
-    Eigen::MatrixXcd Y0, double freq, struct simulationParameters simuParams,
+  void propagateImpedAdmitStraight(const Eigen::MatrixXcd& Z0,
+    const Eigen::MatrixXcd& Y0, double freq, const struct simulationParameters& simuParams,
     double prevArea, double nextArea);
-  void propagatePressureVelocityStraight(Eigen::MatrixXcd V0,
-    Eigen::MatrixXcd P0, double freq, struct simulationParameters simuParams,
+  void propagatePressureVelocityStraight(const Eigen::MatrixXcd& V0,
+    const Eigen::MatrixXcd& P0, double freq, const struct simulationParameters& simuParams,
     double nextArea);
   // to get the amplitude of the pressure modes at a given distance from the exit
   void radiatePressure(double distance, double freq, 
-    struct simulationParameters simuParams, Eigen::MatrixXcd& pressAmp);
+    const struct simulationParameters& simuParams, Eigen::MatrixXcd& pressAmp);
 
   // **************************************************************************
   // Accessors
 
-  double scaleIn() const { return 1.; }
-  double scaleOut() const { return 1.; }
   double radius() const { return m_radius; }
   double PMLThickness() const { return m_PMLThickness; }
   double BesselZero(int m) const { return m_BesselZeros[m]; }
@@ -517,7 +1021,9 @@ private:
 // Private functions.
 // **************************************************************************
 
-  void setBesselParam(struct simulationParameters simuParams);
+  void setBesselParam(const struct simulationParameters& simuParams);
+  bool restoreMemoisedModes(const CacheKey& key);
+  void copyRadiationModes(const CrossSection2dRadiation& sec);
 };
 
 // Print cross-section parameters
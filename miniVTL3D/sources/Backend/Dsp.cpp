@@ -20,7 +20,10 @@
 // ****************************************************************************
 
 #include "Dsp.h"
+#include "SimdKernels.h"
 #include <cmath>
+#include <atomic>
+#include <mutex>
 
 // Reference frequency for the conversion between Hz and st.
 static const double REFERENCE_FREQUENCY = 1.0;
@@ -237,81 +240,166 @@ void realIDFT(ComplexSignal& freqSignal, Signal& timeSignal, int length, bool no
 }
 
 // ****************************************************************************
-// Calc. the complex fast FT of the signal s with the length
-// N = 2^lengthExponent.
-// The resulting signal is written back to s.
+/// The tables of a FFT of the length N = 2^lengthExponent: the pairs of 
+/// indices that are swapped by the bit reversal, and the twiddle factors of
+/// all stages. The twiddle factors exp(-i*pi*j/M), j = 0 ... M-1, of the stage
+/// with the butterfly distance M are stored consecutively from the index M-1.
 // ****************************************************************************
 
-void complexFFT(ComplexSignal& s, int lengthExponent, bool normalize)
+struct FftPlan
+{
+  std::vector<int> swapA;
+  std::vector<int> swapB;
+  std::vector<double> twiddleRe;
+  std::vector<double> twiddleIm;
+};
+
+static const int MAX_FFT_LENGTH_EXPONENT = 30;
+
+// ****************************************************************************
+/// Returns the tables of the FFT of the length 2^lengthExponent. They are
+/// calculated at the first call for each length and kept until the end of
+/// the program. The function may be called from several threads.
+// ****************************************************************************
+
+static const FftPlan *getFftPlan(int lengthExponent)
 {
-  int i, j, k;
+  static std::atomic<FftPlan*> plans[MAX_FFT_LENGTH_EXPONENT + 1];
+  static std::mutex planMutex;
+
+  FftPlan *plan = plans[lengthExponent].load(std::memory_order_acquire);
+  if (plan != NULL) { return plan; }
+
+  std::lock_guard<std::mutex> lock(planMutex);
+  plan = plans[lengthExponent].load(std::memory_order_relaxed);
+  if (plan != NULL) { return plan; }
 
   int N = 1 << lengthExponent;
-  s.setMinLength(N);
+  int i, j, k, M;
+  double angle;
 
-  // Bit reordering.
-  double tr, ti;
-  int nm1 = N - 1;
-  int nd2 = N / 2;
+  plan = new FftPlan();
+
+  // Bit reversal.
 
-  j = nd2;
-  for (i=1; i <= N-2; i++)
+  j = 0;
+  for (i=0; i < N - 1; i++)
   {
     if (i < j)
     {
-      tr = s.re[j];
-      ti = s.im[j];
-      s.re[j] = s.re[i];
-      s.im[j] = s.im[i];
-      s.re[i] = tr;
-      s.im[i] = ti;
+      plan->swapA.push_back(i);
+      plan->swapB.push_back(j);
     }
-    k = nd2;
-
-    while (k <= j)
+    k = N / 2;
+    while ((k >= 1) && (k <= j))
     {
       j-= k;
       k/= 2;
     }
     j+= k;
-  }   // next i
+  }
 
+  // Twiddle factors.
 
-  // ****************************************************************
+  plan->twiddleRe.resize(N > 1 ? N - 1 : 1);
+  plan->twiddleIm.resize(N > 1 ? N - 1 : 1);
+  for (M=1; M < N; M*= 2)
+  {
+    for (j=0; j < M; j++)
+    {
+      angle = M_PI*(double)j / (double)M;
+      plan->twiddleRe[M - 1 + j] = cos(angle);
+      plan->twiddleIm[M - 1 + j] = -sin(angle);
+    }
+  }
+
+  plans[lengthExponent].store(plan, std::memory_order_release);
+  return plan;
+}
 
-  int l, le, le2;
-  double ur, ui;
-  double sr, si;
-  int jm1, ip;
+// ****************************************************************************
+/// Butterflies of one stage of a radix-2 FFT with the butterfly distance M
+/// on the N values of re[] and im[]. The inner loop runs over consecutive 
+/// values and twiddle factors, so that it can be vectorized (and it is 
+/// compiled for the instruction sets of CPU_DISPATCH).
+// ****************************************************************************
 
-  for (l=1; l <= lengthExponent; l++)
+CPU_DISPATCH
+static void fftStage(double *re, double *im, int N, int M, 
+  const double *twiddleRe, const double *twiddleIm)
+{
+  int i, j;
+  double tr, ti;
+  double *re1, *im1, *re2, *im2;
+
+  for (i=0; i < N; i+= 2*M)
   {
-    le  = 1 << l;
-    le2 = le / 2;
-    ur  = 1.0;
-    ui  = 0.0;
-    sr  = cos(M_PI / (double)le2);
-    si  = -sin(M_PI / (double)le2);
-
-    for (j=1; j <= le2; j++)
+    re1 = &re[i];
+    im1 = &im[i];
+    re2 = &re[i + M];
+    im2 = &im[i + M];
+    for (j=0; j < M; j++)
     {
-      jm1 = j - 1;
-      for (i=jm1; i <= nm1; i+=le)
-      {
-        ip = i + le2;
-        tr = s.re[ip]*ur - s.im[ip]*ui;
-        ti = s.re[ip]*ui + s.im[ip]*ur;
-        s.re[ip] = s.re[i] - tr;
-        s.im[ip] = s.im[i] - ti;
-        s.re[i]+= tr;
-        s.im[i]+= ti;
-      }   // next i
-      
-      tr = ur;
-      ur = tr*sr - ui*si;
-      ui = tr*si + ui*sr;
-    }   // next j
-  }   // next l
+      tr = re2[j]*twiddleRe[j] - im2[j]*twiddleIm[j];
+      ti = re2[j]*twiddleIm[j] + im2[j]*twiddleRe[j];
+      re2[j] = re1[j] - tr;
+      im2[j] = im1[j] - ti;
+      re1[j]+= tr;
+      im1[j]+= ti;
+    }
+  }
+}
+
+// ****************************************************************************
+// Calc. the complex fast FT of the signal s with the length
+// N = 2^lengthExponent.
+// The resulting signal is written back to s.
+// The bit reversal and the twiddle factors come from tables that are 
+// calculated once per length.
+// ****************************************************************************
+
+void complexFFT(ComplexSignal& s, int lengthExponent, bool normalize)
+{
+  int i, M;
+  double tr, ti;
+
+  int N = 1 << lengthExponent;
+  s.setMinLength(N);
+  if (N < 2) { return; }
+
+  const FftPlan *plan = getFftPlan(lengthExponent);
+  double *re = s.re;
+  double *im = s.im;
+
+  // Bit reordering.
+
+  int numSwaps = (int)plan->swapA.size();
+  for (i=0; i < numSwaps; i++)
+  {
+    tr = re[plan->swapA[i]];
+    ti = im[plan->swapA[i]];
+    re[plan->swapA[i]] = re[plan->swapB[i]];
+    im[plan->swapA[i]] = im[plan->swapB[i]];
+    re[plan->swapB[i]] = tr;
+    im[plan->swapB[i]] = ti;
+  }
+
+  // The first stage has only trivial twiddle factors.
+
+  for (i=0; i < N; i+= 2)
+  {
+    tr = re[i + 1];
+    ti = im[i + 1];
+    re[i + 1] = re[i] - tr;
+    im[i + 1] = im[i] - ti;
+    re[i]+= tr;
+    im[i]+= ti;
+  }
+
+  for (M=2; M < N; M*= 2)
+  {
+    fftStage(re, im, N, M, &plan->twiddleRe[M - 1], &plan->twiddleIm[M - 1]);
+  }
 
   // Normalize the results? *****************************************
 
@@ -319,8 +407,8 @@ void complexFFT(ComplexSignal& s, int lengthExponent, bool normalize)
   {
     for (i=0; i < N; i++) 
     { 
-      s.re[i]/= (double)N;
-      s.im[i]/= (double)N;
+      re[i]/= (double)N;
+      im[i]/= (double)N;
     }    
   }
 }
@@ -447,7 +535,7 @@ void realFFT(ComplexSignal& s, int lengthExponent, bool normalize)
   int N = 1 << lengthExponent;
   s.setMinLength(N);
 
-  int i, j, im, ip2, ipm, jm1, ip;
+  int i, im, ip2, ipm;
 
   // ******************************************************
   
@@ -463,7 +551,6 @@ void realFFT(ComplexSignal& s, int lengthExponent, bool normalize)
 
   // ******************************************************
 
-  int nm1 = N - 1;
   int nd2 = N / 2;
   int n4  = (N/4) - 1;
 
@@ -492,34 +579,10 @@ void realFFT(ComplexSignal& s, int lengthExponent, bool normalize)
 
   // ******************************************************
 
-  int l   = lengthExponent;
-  int le  = 1 << l;
-  int le2 = le / 2;
-  double ur = 1.0;
-  double ui = 0.0;
-  double sr = cos(M_PI / (double)le2);
-  double si = -sin(M_PI / (double)le2);
-  double ti;
-  double tr;
-
-  for (j=1; j <= le2; j++)
-  {
-    jm1 = j - 1;
-    for (i=jm1; i <= nm1; i+=le)
-    {
-      ip = i + le2;
-      tr = s.re[ip]*ur - s.im[ip]*ui;
-      ti = s.re[ip]*ui + s.im[ip]*ur;
-      s.re[ip] = s.re[i] - tr;
-      s.im[ip] = s.im[i] - ti;
-      s.re[i]+= tr;
-      s.im[i]+= ti;
-    }   // next i
-      
-    tr = ur;
-    ur = tr*sr - ui*si;
-    ui = tr*si + ui*sr;
-  }   // next j
+  // The last stage of the FFT of the length N combines the halves.
+
+  const FftPlan *plan = getFftPlan(lengthExponent);
+  fftStage(s.re, s.im, N, nd2, &plan->twiddleRe[nd2 - 1], &plan->twiddleIm[nd2 - 1]);
 
   // Normalize the result?
 
@@ -1160,5 +1223,166 @@ double semitonesToHertz(double freq_st)
   return REFERENCE_FREQUENCY*pow(2, freq_st / 12.0);
 }
 
+// ****************************************************************************
+// ****************************************************************************
+
+FftConvolver::FftConvolver()
+{
+  blockLengthExponent = 0;
+  blockLength = 0;
+  numPartitions = 0;
+  pos = 0;
+}
+
+// ****************************************************************************
+/// Sets the impulse response (its first impulseResponseLength samples) and
+/// the block length 2^blockLengthExponent, and clears the buffers.
+// ****************************************************************************
+
+void FftConvolver::init(const Signal& impulseResponse, int impulseResponseLength, 
+  int blockLengthExponent)
+{
+  int i, p;
+
+  if (blockLengthExponent < 1) { blockLengthExponent = 1; }
+  if (impulseResponseLength > impulseResponse.N) { impulseResponseLength = impulseResponse.N; }
+  if (impulseResponseLength < 1) { impulseResponseLength = 1; }
+
+  this->blockLengthExponent = blockLengthExponent;
+  blockLength = 1 << blockLengthExponent;
+  numPartitions = (impulseResponseLength + blockLength - 1) / blockLength;
+
+  int fftLength = 2*blockLength;
+  work.reset(fftLength);
+  partitionRe.assign(numPartitions*fftLength, 0.0);
+  partitionIm.assign(numPartitions*fftLength, 0.0);
+
+  // The spectra of the zero-padded partitions of the impulse response.
+
+  for (p=0; p < numPartitions; p++)
+  {
+    for (i=0; i < fftLength; i++)
+    {
+      work.re[i] = 0.0;
+      work.im[i] = 0.0;
+    }
+    for (i=0; (i < blockLength) && (p*blockLength + i < impulseResponseLength); i++)
+    {
+      work.re[i] = impulseResponse.x[p*blockLength + i];
+    }
+    complexFFT(work, blockLengthExponent + 1, false);
+    for (i=0; i < fftLength; i++)
+    {
+      partitionRe[p*fftLength + i] = work.re[i];
+      partitionIm[p*fftLength + i] = work.im[i];
+    }
+  }
+
+  resetBuffers();
+}
+
+// ****************************************************************************
+/// Clears the input history, as if the signal was zero before the next block.
+// ****************************************************************************
+
+void FftConvolver::resetBuffers()
+{
+  pos = 0;
+  delayLineRe.assign(numPartitions*2*blockLength, 0.0);
+  delayLineIm.assign(numPartitions*2*blockLength, 0.0);
+  lastInput.assign(blockLength, 0.0);
+}
+
+// ****************************************************************************
+/// Convolves the next blockLength input samples and writes the blockLength
+/// corresponding output samples.
+// ****************************************************************************
+
+void FftConvolver::processBlock(const double *input, double *output)
+{
+  int i, p;
+  int fftLength = 2*blockLength;
+  double *re, *im;
+  const double *hRe, *hIm;
+
+  if (numPartitions < 1) { return; }
+
+  // The spectrum of the last two input blocks goes into the newest slot
+  // of the delay line.
+
+  for (i=0; i < blockLength; i++)
+  {
+    work.re[i] = lastInput[i];
+    work.re[blockLength + i] = input[i];
+    lastInput[i] = input[i];
+  }
+  for (i=0; i < fftLength; i++) { work.im[i] = 0.0; }
+  complexFFT(work, blockLengthExponent + 1, false);
+
+  pos = (pos + 1) % numPartitions;
+  for (i=0; i < fftLength; i++)
+  {
+    delayLineRe[pos*fftLength + i] = work.re[i];
+    delayLineIm[pos*fftLength + i] = work.im[i];
+  }
+
+  // Sum of the products of the partition spectra with the delayed input
+  // spectra. The input is real, so that only the bins up to the Nyquist 
+  // frequency are needed and the others are their complex conjugates.
+
+  for (i=0; i <= blockLength; i++)
+  {
+    work.re[i] = 0.0;
+    work.im[i] = 0.0;
+  }
+
+  for (p=0; p < numPartitions; p++)
+  {
+    re = &delayLineRe[((pos - p + numPartitions) % numPartitions)*fftLength];
+    im = &delayLineIm[((pos - p + numPartitions) % numPartitions)*fftLength];
+    hRe = &partitionRe[p*fftLength];
+    hIm = &partitionIm[p*fftLength];
+    multiplyAccumulateSplit(re, im, hRe, hIm, work.re, work.im, blockLength + 1);
+  }
+
+  for (i=1; i < blockLength; i++)
+  {
+    work.re[fftLength - i] = work.re[i];
+    work.im[fftLength - i] = -work.im[i];
+  }
+
+  // The second half of the circular convolution is the linear convolution.
+
+  complexIFFT(work, blockLengthExponent + 1, true);
+  for (i=0; i < blockLength; i++) { output[i] = work.re[blockLength + i]; }
+}
+
+// ****************************************************************************
+/// Convolves numSamples input samples that follow the previous ones (or 
+/// zeros after init() or resetBuffers()). The last incomplete block is
+/// padded with zeros, so numSamples should be a multiple of the block length
+/// when the signal continues in a later call.
+// ****************************************************************************
+
+void FftConvolver::convolve(const double *input, double *output, int numSamples)
+{
+  int i, k;
+  std::vector<double> in(blockLength), out(blockLength);
+
+  for (i=0; i < numSamples; i+= blockLength)
+  {
+    if (i + blockLength <= numSamples)
+    {
+      processBlock(&input[i], &output[i]);
+    }
+    else
+    {
+      for (k=0; k < blockLength; k++) { in[k] = (i + k < numSamples) ? input[i + k] : 0.0; }
+      processBlock(&in[0], &out[0]);
+      for (k=0; i + k < numSamples; k++) { output[i + k] = out[k]; }
+    }
+  }
+}
+
 
 // ****************************************************************************
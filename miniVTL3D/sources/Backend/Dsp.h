@@ -24,6 +24,7 @@
 
 #include "Signal.h"
 #include <complex>
+#include <vector>
 
 typedef std::complex<double> ComplexValue;
 
@@ -82,5 +83,42 @@ inline double MelToHz(double m) { return BarkToHz(m/100.0); }
 double hertzToSemitones(double freq_Hz);
 double semitonesToHertz(double freq_st);
 
+// ****************************************************************************
+/// Fast convolution of a signal with a fixed impulse response by uniformly
+/// partitioned overlap-save. The impulse response is split into partitions
+/// of blockLength samples whose spectra are calculated once. The signal is
+/// processed block by block: the spectrum of each input block is stored in a
+/// frequency-domain delay line and multiplied with the spectra of the 
+/// partitions, so that one FFT and one inverse FFT of length 2*blockLength
+/// are needed per block.
+// ****************************************************************************
+
+class FftConvolver
+{
+  public:
+    FftConvolver();
+    void init(const Signal& impulseResponse, int impulseResponseLength, 
+      int blockLengthExponent);
+    void resetBuffers();
+
+    void processBlock(const double *input, double *output);
+    void convolve(const double *input, double *output, int numSamples);
+
+    int getBlockLength() const { return blockLength; }
+
+  private:
+    int blockLengthExponent;
+    int blockLength;
+    int numPartitions;
+    int pos;                            ///< Slot of the newest input spectrum
+
+    std::vector<double> partitionRe;    ///< Spectra of the partitions
+    std::vector<double> partitionIm;
+    std::vector<double> delayLineRe;    ///< Spectra of the last input blocks
+    std::vector<double> delayLineIm;
+    std::vector<double> lastInput;      ///< Previous input block
+    ComplexSignal work;
+};
+
 
 #endif
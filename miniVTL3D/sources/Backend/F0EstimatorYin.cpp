@@ -22,7 +22,9 @@
 #include "F0EstimatorYin.h"
 #include <limits>
 #include <cmath>
+#include <thread>
 #include "Constants.h"
+#include "ParallelLoop.h"
 
 // Static constants.
 
@@ -43,6 +45,8 @@ F0EstimatorYin::F0EstimatorYin()
 
   differenceFunctionThreshold = 0.1;
   timeStep_s = 0.01;
+  numThreads = max(1, (int)thread::hardware_concurrency());
+  streamLookAhead_s = 0.1;
 
   // ****************************************************************
   // Init the private variables.
@@ -51,6 +55,7 @@ F0EstimatorYin::F0EstimatorYin()
   firstRoiSample = 0;
   numRoiSamples = 0;
   firstChunkSample = 0;
+  initStream();
 
   // ****************************************************************
   // Create a Hann window over the 30 ms region in the center of a
@@ -159,10 +164,6 @@ void F0EstimatorYin::init(Signal16 *signal, int firstRoiSample, int numRoiSample
 
 bool F0EstimatorYin::processChunk(int numChunkSamples)
 {
-  double frame[FRAME_LENGTH];
-  double df[INTEGRATION_LENGTH];
-  double ndf[INTEGRATION_LENGTH];
-  int centerPos_pt;
   int i;
 
   int lastChunkSample = firstChunkSample + numChunkSamples - 1;
@@ -172,21 +173,19 @@ bool F0EstimatorYin::processChunk(int numChunkSamples)
   }
   int firstFrame = (int)(firstChunkSample / ((double)SAMPLING_RATE*INTERNAL_TIME_STEP_S));
   int lastFrame = (int)((lastChunkSample) / ((double)SAMPLING_RATE*INTERNAL_TIME_STEP_S));
+  // The last samples of the signal may not complete a frame.
+  if (lastFrame > (int)frames.size() - 1) { lastFrame = (int)frames.size() - 1; }
 
 //  printf("Processing frames %d to %d\n", firstFrame, lastFrame);
 
   // ****************************************************************
   // Calculate one frame every ms to enable step 6 in the YIN-paper.
+  // The frames are independent and are distributed on the threads
+  // of the pool (see ParallelLoop.h).
   // ****************************************************************
 
-  for (i=firstFrame; i <= lastFrame; i++)
-  {
-    centerPos_pt = (int)(i*INTERNAL_TIME_STEP_S*(double)SAMPLING_RATE);
-    getFrameSignal(&filteredSignal, centerPos_pt, frame);
-    calcNdf(frame, df, ndf);
-
-    getFrameData(frame, df, ndf, frames[i]);
-  }
+  int numFrames = lastFrame - firstFrame + 1;
+  parallelLoop(numFrames, numThreads, [&](int k) { processFrame(firstFrame + k); });
 
   // ****************************************************************
   // Increment the internal chunk start position and return true,
@@ -205,6 +204,26 @@ bool F0EstimatorYin::processChunk(int numChunkSamples)
 }
 
 
+// ****************************************************************************
+/// Calculates the NDF, the pitch candidates and the other properties of the
+/// frame with the given index. This function only writes into frames[i] and 
+/// may be called for different frames at the same time.
+// ****************************************************************************
+
+void F0EstimatorYin::processFrame(int frameIndex)
+{
+  double frame[FRAME_LENGTH];
+  double df[INTEGRATION_LENGTH];
+  double ndf[INTEGRATION_LENGTH];
+
+  int centerPos_pt = (int)(frameIndex*INTERNAL_TIME_STEP_S*(double)SAMPLING_RATE);
+  getFrameSignal(&filteredSignal, centerPos_pt, frame);
+  calcNdf(frame, df, ndf);
+
+  getFrameData(frame, df, ndf, frames[frameIndex]);
+}
+
+
 // ****************************************************************************
 /// After the whole input signal was processed (processChunk(...)==0), this
 /// function returns a vector with the F0 estimates every timeStep_s seconds
@@ -237,6 +256,301 @@ vector<double> F0EstimatorYin::finish()
 }
 
 
+// ****************************************************************************
+/// Starts the estimation for a stream of samples, e.g., from a microphone or
+/// a file that is read block by block. The stream is passed in blocks of any
+/// length to processStream(...), which returns the F0 values that are 
+/// decided so far, every timeStep_s seconds from the beginning of the stream
+/// on. The Viterbi search then decides the frame streamLookAhead_s seconds
+/// before the current frame by tracing back the best path from there, 
+/// instead of tracing back from the end of the signal as in finish().
+/// Hence, the value at the time t is returned as soon as the samples up to
+/// about t + streamLookAhead_s + 27 ms are passed, and only the frames of 
+/// the look-ahead and the samples of a frame are kept in memory.
+/// finishStream(...) returns the remaining values at the end of the stream.
+/// Unlike in init(...), the frames at the ends of the stream get zeros 
+/// instead of the samples at the other end of the signal.
+// ****************************************************************************
+
+void F0EstimatorYin::initStream()
+{
+  streamSignal.clear();
+  streamFirstSample = 0;
+  streamNumSamples = 0;
+  streamFirstFrame = 0;
+  streamNextFrame = 0;
+  streamNextPathFrame = 0;
+  streamNextValue = 0;
+  streamLookAheadFrames = max(0, (int)(streamLookAhead_s / INTERNAL_TIME_STEP_S + 0.5));
+  frames.clear();
+}
+
+
+// ****************************************************************************
+/// Processes the next numSamples samples of the stream started with 
+/// initStream() and appends the new F0 values to f0Values.
+// ****************************************************************************
+
+void F0EstimatorYin::processStream(const double *samples, int numSamples, 
+  vector<double> &f0Values)
+{
+  // The transition costs of a frame use the rms amplitude 10 ms ahead.
+  const int NUM_FOLLOWING_FRAMES = (int)(0.02 / INTERNAL_TIME_STEP_S) / 2;
+
+  if (numSamples < 1)
+  {
+    return;
+  }
+
+  // ****************************************************************
+  // Filter the new samples, continuing with the state of the filter
+  // after the previous samples.
+  // ****************************************************************
+
+  if (streamNumSamples == 0)
+  {
+    filter->resetBuffers(samples[0]);
+  }
+  int oldLength = (int)streamSignal.size();
+  streamSignal.resize(oldLength + numSamples);
+  filter->process(samples, &streamSignal[oldLength], numSamples);
+  streamNumSamples+= numSamples;
+
+  // ****************************************************************
+  // Calculate the frames whose samples are complete and extend the
+  // best paths by the frames whose transition costs are known.
+  // ****************************************************************
+
+  int lastFrame = streamNextFrame - 1;
+  while (getFrameCenter(lastFrame + 1) + INTEGRATION_LENGTH - 1 <= streamNumSamples)
+  {
+    lastFrame++;
+  }
+  calcStreamFrames(lastFrame);
+
+  while (streamNextPathFrame + NUM_FOLLOWING_FRAMES < streamNextFrame)
+  {
+    extendStreamPath();
+  }
+
+  addStreamValues(streamNextPathFrame - 1 - streamLookAheadFrames, -1, f0Values);
+
+  // ****************************************************************
+  // Remove the frames and samples that are no longer needed.
+  // ****************************************************************
+
+  int firstFrame = streamNextPathFrame - max(streamLookAheadFrames, NUM_FOLLOWING_FRAMES) - 1;
+  if (firstFrame > streamFirstFrame)
+  {
+    frames.erase(frames.begin(), frames.begin() + (firstFrame - streamFirstFrame));
+    streamFirstFrame = firstFrame;
+  }
+
+  int firstSample = getFrameCenter(streamNextFrame) - INTEGRATION_LENGTH;
+  if (firstSample > streamFirstSample)
+  {
+    streamSignal.erase(streamSignal.begin(), streamSignal.begin() + (firstSample - streamFirstSample));
+    streamFirstSample = firstSample;
+  }
+}
+
+
+// ****************************************************************************
+/// Processes the remaining frames at the end of the stream and appends the 
+/// remaining F0 values to f0Values, so that there are as many values for
+/// the stream as finish() returns for a signal of the same length.
+// ****************************************************************************
+
+void F0EstimatorYin::finishStream(vector<double> &f0Values)
+{
+  int k, m;
+
+  int numFrames = (int)((double)streamNumSamples / (double)(SAMPLING_RATE*INTERNAL_TIME_STEP_S));
+  calcStreamFrames(numFrames - 1);
+
+  while (streamNextPathFrame < numFrames)
+  {
+    extendStreamPath();
+  }
+
+  // ****************************************************************
+  // Decide the frames of the last look-ahead with the best path to
+  // the last frame.
+  // ****************************************************************
+
+  if (numFrames > 0)
+  {
+    FrameData *fd = &frames[numFrames - 1 - streamFirstFrame];
+    m = 0;
+    for (k=1; k < fd->numPitchCandidates; k++)
+    {
+      if (fd->lowestPathCost[k] < fd->lowestPathCost[m])
+      {
+        m = k;
+      }
+    }
+
+    int firstFrame = max(0, numFrames - streamLookAheadFrames);
+    for (k=numFrames - 1; (k >= firstFrame) && (m != -1); k--)
+    {
+      frames[k - streamFirstFrame].finalCandidate = m;
+      m = frames[k - streamFirstFrame].bestPrevCandidate[m];
+    }
+  }
+
+  int numF0Values = (int)(streamNumSamples / ((double)SAMPLING_RATE * timeStep_s));
+  addStreamValues(numFrames - 1, numF0Values, f0Values);
+}
+
+
+// ****************************************************************************
+/// Returns the sample of the center of the frame with the given index.
+// ****************************************************************************
+
+int F0EstimatorYin::getFrameCenter(int frameIndex)
+{
+  return (int)(frameIndex*INTERNAL_TIME_STEP_S*(double)SAMPLING_RATE);
+}
+
+
+// ****************************************************************************
+/// Returns the filtered samples of the stream in the frame around the sample
+/// at centerPos. The samples outside of the stream are zero.
+// ****************************************************************************
+
+void F0EstimatorYin::getStreamFrameSignal(int centerPos, double *frame)
+{
+  int i, k;
+  for (i = 0; i < FRAME_LENGTH; i++)
+  {
+    k = centerPos - INTEGRATION_LENGTH + i;
+    frame[i] = ((k >= 0) && (k < streamNumSamples)) ? streamSignal[k - streamFirstSample] : 0.0;
+  }
+}
+
+
+// ****************************************************************************
+/// Appends the frames from streamNextFrame to lastFrame of the stream to the
+/// frames, calculated in parallel like in processChunk(...).
+// ****************************************************************************
+
+void F0EstimatorYin::calcStreamFrames(int lastFrame)
+{
+  int numNewFrames = lastFrame - streamNextFrame + 1;
+  if (numNewFrames < 1)
+  {
+    return;
+  }
+
+  int firstIndex = (int)frames.size();
+  frames.resize(firstIndex + numNewFrames);
+
+  parallelLoop(numNewFrames, numThreads, [&](int k)
+    {
+      double frame[FRAME_LENGTH];
+      double df[INTEGRATION_LENGTH];
+      double ndf[INTEGRATION_LENGTH];
+
+      getStreamFrameSignal(getFrameCenter(streamNextFrame + k), frame);
+      calcNdf(frame, df, ndf);
+      getFrameData(frame, df, ndf, frames[firstIndex + k]);
+      frames[firstIndex + k].finalCandidate = -1;
+    });
+
+  streamNextFrame = lastFrame + 1;
+}
+
+
+// ****************************************************************************
+/// Extends the best paths by the frame streamNextPathFrame and decides the
+/// frame streamLookAheadFrames frames before it by tracing back the best
+/// path to there. The path costs are shifted so that the lowest one is zero,
+/// which changes no decision but keeps the costs bounded.
+// ****************************************************************************
+
+void F0EstimatorYin::extendStreamPath()
+{
+  int i = streamNextPathFrame - streamFirstFrame;
+  FrameData *fd = &frames[i];
+  int k, m;
+
+  if (streamNextPathFrame == 0)
+  {
+    for (k=0; k < fd->numPitchCandidates; k++)
+    {
+      fd->lowestPathCost[k] = getLocalCost(i, k);
+      fd->bestPrevCandidate[k] = -1;    // There is no prev. frame.
+    }
+  }
+  else
+  {
+    calcPathCosts(i);
+  }
+
+  m = 0;   // The best candidate in this frame.
+  for (k=1; k < fd->numPitchCandidates; k++)
+  {
+    if (fd->lowestPathCost[k] < fd->lowestPathCost[m])
+    {
+      m = k;
+    }
+  }
+
+  double lowestPathCost = fd->lowestPathCost[m];
+  for (k=0; k < fd->numPitchCandidates; k++)
+  {
+    fd->lowestPathCost[k]-= lowestPathCost;
+  }
+
+  if (streamNextPathFrame >= streamLookAheadFrames)
+  {
+    for (k=i; k > i - streamLookAheadFrames; k--)
+    {
+      m = frames[k].bestPrevCandidate[m];
+    }
+    frames[i - streamLookAheadFrames].finalCandidate = m;
+  }
+
+  streamNextPathFrame++;
+}
+
+
+// ****************************************************************************
+/// Appends the F0 values from streamNextValue on to f0Values. When numValues
+/// is -1, the values up to the decided frame lastFrame are appended. 
+/// Otherwise, the values up to numValues are appended and the frames after 
+/// lastFrame are replaced by lastFrame, as in getFinalF0(...).
+// ****************************************************************************
+
+void F0EstimatorYin::addStreamValues(int lastFrame, int numValues, vector<double> &f0Values)
+{
+  int frameIndex;
+
+  while ((numValues == -1) || (streamNextValue < numValues))
+  {
+    frameIndex = (int)((double)streamNextValue*timeStep_s/INTERNAL_TIME_STEP_S + 0.5);
+    if (frameIndex > lastFrame)
+    {
+      if (numValues == -1)
+      {
+        return;
+      }
+      frameIndex = lastFrame;
+    }
+
+    if (frameIndex < 0)
+    {
+      f0Values.push_back(0.0);
+    }
+    else
+    {
+      f0Values.push_back(getFinalF0(frames[frameIndex - streamFirstFrame]));
+    }
+    streamNextValue++;
+  }
+}
+
+
 // ****************************************************************************
 /// Returns the samples of the frame of length FRAME_LENGTH around the sample
 /// at centerPos in the given signal.
@@ -272,28 +586,88 @@ void F0EstimatorYin::getFrameSignal(Signal *signal, int centerPos, double *frame
 // ****************************************************************************
 /// This function calculates the NDF directly via the equation in the appendix 
 /// of the YIN paper, and not via the cross-correlation function.
+/// The integration window of each lag tau is centered in the frame, i.e., it
+/// starts at (INTEGRATION_LENGTH - 1 - tau) / 2. For the even lags 2m, the
+/// compared samples are then at the distance m on both sides of a common
+/// position, and the same holds for the odd lags 2m+1 with an offset of one 
+/// sample. The sums are therefore accumulated for all lags of a parity at 
+/// once, with consecutive samples in both directions, which can be 
+/// vectorized. Four window positions are processed per pass to reduce the
+/// loads and stores of the sums. Each sum is still accumulated in the order
+/// of the window positions, so that the result is the same as with one loop
+/// over the window per lag.
 // ****************************************************************************
 
 void F0EstimatorYin::calcNdf(double *frame, double *df, double *ndf)
 {
-  int tau, k;
-  int startPos;
+  const int NUM_EVEN_LAGS = (INTEGRATION_LENGTH + 1) / 2;
+  const int NUM_ODD_LAGS = INTEGRATION_LENGTH / 2;
+  const int EVEN_START_POS = (INTEGRATION_LENGTH - 1) / 2;
+  const int ODD_START_POS = (INTEGRATION_LENGTH - 2) / 2;
+
+  double evenDf[NUM_EVEN_LAGS];
+  double oddDf[NUM_ODD_LAGS];
+  int tau, k, m;
   double sum;
-  double d;
+  double d, d0, d1, d2, d3;
+  double *center;
+
+  for (m=0; m < NUM_EVEN_LAGS; m++) { evenDf[m] = 0.0; }
+  for (m=0; m < NUM_ODD_LAGS; m++) { oddDf[m] = 0.0; }
+
+  for (k=0; k + 3 < INTEGRATION_LENGTH; k+= 4)
+  {
+    // Lag 2m: the samples at EVEN_START_POS + k - m and + k + m.
+    center = &frame[EVEN_START_POS + k];
+    for (m=0; m < NUM_EVEN_LAGS; m++)
+    {
+      d0 = center[-m] - center[m];
+      d1 = center[1 - m] - center[1 + m];
+      d2 = center[2 - m] - center[2 + m];
+      d3 = center[3 - m] - center[3 + m];
+      sum = evenDf[m] + d0*d0;
+      sum+= d1*d1;
+      sum+= d2*d2;
+      evenDf[m] = sum + d3*d3;
+    }
+
+    // Lag 2m+1: the samples at ODD_START_POS + k - m and + k + m + 1.
+    center = &frame[ODD_START_POS + k];
+    for (m=0; m < NUM_ODD_LAGS; m++)
+    {
+      d0 = center[-m] - center[m + 1];
+      d1 = center[1 - m] - center[m + 2];
+      d2 = center[2 - m] - center[m + 3];
+      d3 = center[3 - m] - center[m + 4];
+      sum = oddDf[m] + d0*d0;
+      sum+= d1*d1;
+      sum+= d2*d2;
+      oddDf[m] = sum + d3*d3;
+    }
+  }
 
-  for (tau=0; tau < INTEGRATION_LENGTH; tau++)
+  // The remaining window positions.
+
+  for (; k < INTEGRATION_LENGTH; k++)
   {
-    sum = 0.0;
-    startPos = (INTEGRATION_LENGTH - 1 - tau) / 2;
-    for (k=0; k < INTEGRATION_LENGTH; k++)
+    center = &frame[EVEN_START_POS + k];
+    for (m=0; m < NUM_EVEN_LAGS; m++)
     {
-      d = frame[startPos + k] - frame[startPos + k + tau];
-      sum+= d*d;
+      d = center[-m] - center[m];
+      evenDf[m]+= d*d;
     }
 
-    df[tau] = sum;
+    center = &frame[ODD_START_POS + k];
+    for (m=0; m < NUM_ODD_LAGS; m++)
+    {
+      d = center[-m] - center[m + 1];
+      oddDf[m]+= d*d;
+    }
   }
 
+  for (m=0; m < NUM_EVEN_LAGS; m++) { df[2*m] = evenDf[m]; }
+  for (m=0; m < NUM_ODD_LAGS; m++) { df[2*m + 1] = oddDf[m]; }
+
   // Calculate the normalized difference function
 
   ndf[0] = 1.0;
@@ -542,12 +916,6 @@ void F0EstimatorYin::findBestPitchPath()
   }
 
   int i, k, m;
-  double localCost;
-  double transitionCost;
-  double lowestPathCost;
-  int bestPrevCandidate;
-  int numCurrCandidates;
-  int numPrevCandidates;
 
   // ****************************************************************
   // Initialize the search with the candidates of the first frame.
@@ -565,33 +933,7 @@ void F0EstimatorYin::findBestPitchPath()
 
   for (i=1; i < numFrames; i++)
   {
-    numCurrCandidates = frames[i].numPitchCandidates;
-
-    for (k=0; k < numCurrCandidates; k++)
-    {
-      // Get the local cost for the frame i and candidate k
-      localCost = getLocalCost(i, k);
-
-      // Find the minimum of the path cost from each of the 
-      // candidates of the previous frame.
-
-      numPrevCandidates = frames[i-1].numPitchCandidates;
-      lowestPathCost = numeric_limits<double>::max();
-      bestPrevCandidate = -1;
-
-      for (m=0; m < numPrevCandidates; m++)
-      {
-        transitionCost = getTransitionCost(i-1, m, i, k);
-        if (frames[i-1].lowestPathCost[m] + transitionCost + localCost < lowestPathCost)
-        {
-          lowestPathCost = frames[i-1].lowestPathCost[m] + transitionCost + localCost;
-          bestPrevCandidate = m;          
-        }
-      }
-
-      frames[i].lowestPathCost[k] = lowestPathCost;
-      frames[i].bestPrevCandidate[k] = bestPrevCandidate;
-    }
+    calcPathCosts(i);
   }
 
   // ****************************************************************
@@ -626,6 +968,49 @@ void F0EstimatorYin::findBestPitchPath()
 }
 
 
+// ****************************************************************************
+/// Calculates the lowest path costs up to the candidates of the frame with
+/// the given index from the path costs of the previous frame.
+// ****************************************************************************
+
+void F0EstimatorYin::calcPathCosts(int frameIndex)
+{
+  int i = frameIndex;
+  int k, m;
+  double localCost;
+  double transitionCost;
+  double lowestPathCost;
+  int bestPrevCandidate;
+  int numCurrCandidates = frames[i].numPitchCandidates;
+  int numPrevCandidates = frames[i-1].numPitchCandidates;
+
+  for (k=0; k < numCurrCandidates; k++)
+  {
+    // Get the local cost for the frame i and candidate k
+    localCost = getLocalCost(i, k);
+
+    // Find the minimum of the path cost from each of the 
+    // candidates of the previous frame.
+
+    lowestPathCost = numeric_limits<double>::max();
+    bestPrevCandidate = -1;
+
+    for (m=0; m < numPrevCandidates; m++)
+    {
+      transitionCost = getTransitionCost(i-1, m, i, k);
+      if (frames[i-1].lowestPathCost[m] + transitionCost + localCost < lowestPathCost)
+      {
+        lowestPathCost = frames[i-1].lowestPathCost[m] + transitionCost + localCost;
+        bestPrevCandidate = m;          
+      }
+    }
+
+    frames[i].lowestPathCost[k] = lowestPathCost;
+    frames[i].bestPrevCandidate[k] = bestPrevCandidate;
+  }
+}
+
+
 // ****************************************************************************
 /// Returns the path cost for the transition from (prevFrame, prevCandidate)
 /// to (currFrame, currCandidate).
@@ -818,14 +1203,25 @@ double F0EstimatorYin::getFinalF0(double t_s)
     frameIndex = (int)frames.size() - 1;
   }
 
-  int finalCandidate = frames[frameIndex].finalCandidate;
+  return getFinalF0(frames[frameIndex]);
+}
+
+
+// ****************************************************************************
+/// Returns the F0 of the final candidate of the given frame, or 0 when the
+/// frame is unvoiced.
+// ****************************************************************************
+
+double F0EstimatorYin::getFinalF0(const FrameData &fd)
+{
+  int finalCandidate = fd.finalCandidate;
   if (finalCandidate == -1)
   {
     return 0.0;
   }
 
   const double EPSILON = 0.0000001;
-  double T0 = frames[frameIndex].pitchCandidateT0[finalCandidate];
+  double T0 = fd.pitchCandidateT0[finalCandidate];
   double f0 = 0.0;
 
   if (fabs(T0) < EPSILON)
@@ -900,12 +1296,7 @@ void F0EstimatorYin::fitParabola(double *f, int rawTau, double &accurateTau, dou
 void F0EstimatorYin::filterSignal(double *inputSignal, double *outputSignal, int N)
 {
   filter->resetBuffers(inputSignal[0]);
-  int i;
-
-  for (i=0; i < N; i++)
-  {
-    outputSignal[i] = filter->getOutputSample(inputSignal[i]);
-  }
+  filter->process(inputSignal, outputSignal, N);
 }
 
 // ****************************************************************************
@@ -49,6 +49,10 @@ public:
 
   double differenceFunctionThreshold;
   double timeStep_s;
+  /// Number of threads that process the frames of a chunk in parallel
+  int numThreads;
+  /// Look-ahead of the Viterbi decisions in the streaming mode in s
+  double streamLookAhead_s;
 
   struct FrameData
   {
@@ -66,6 +70,7 @@ public:
     int finalCandidate;       ///< Index in pitch candidates
   };
 
+  /// All frames of the signal, or the recent frames in the streaming mode
   vector<FrameData> frames;
 
   // **************************************************************************
@@ -79,6 +84,10 @@ public:
   bool processChunk(int numChunkSamples);
   vector<double> finish();
 
+  void initStream();
+  void processStream(const double *samples, int numSamples, vector<double> &f0Values);
+  void finishStream(vector<double> &f0Values);
+
   void getFrameSignal(Signal16 *signal, int centerPos, double *frame);
   void getFrameSignal(Signal *signal, int centerPos, double *frame);
   void calcNdf(double *frame, double *df, double *ndf);
@@ -109,13 +118,37 @@ private:
   int numRoiSamples;
   int firstChunkSample;
 
+  // State of the streaming mode. The indices of the samples and frames
+  // are counted from the beginning of the stream.
+
+  /// The filtered samples from streamFirstSample on
+  vector<double> streamSignal;
+  int streamFirstSample;
+  /// Number of samples received so far
+  int streamNumSamples;
+  /// Index of frames[0]
+  int streamFirstFrame;
+  /// Next frame to be calculated
+  int streamNextFrame;
+  /// Next frame of the Viterbi search
+  int streamNextPathFrame;
+  /// Next F0 value to be returned
+  int streamNextValue;
+  int streamLookAheadFrames;
 
   // **************************************************************************
   // Private functions.
   // **************************************************************************
 
 private:
-
+  void processFrame(int frameIndex);
+  void calcPathCosts(int frameIndex);
+  double getFinalF0(const FrameData &fd);
+  int getFrameCenter(int frameIndex);
+  void getStreamFrameSignal(int centerPos, double *frame);
+  void calcStreamFrames(int lastFrame);
+  void extendStreamPath();
+  void addStreamValues(int lastFrame, int numValues, vector<double> &f0Values);
 };
 
 #endif
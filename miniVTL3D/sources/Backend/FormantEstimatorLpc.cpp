@@ -0,0 +1,504 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#include "FormantEstimatorLpc.h"
+#include <limits>
+#include <cmath>
+#include <thread>
+#include <algorithm>
+#include "ParallelLoop.h"
+
+// Formant candidates below this frequency are ignored.
+static const double MIN_FORMANT_FREQ_HZ = 90.0;
+// The pre-emphasis raises the spectrum by 6 dB/octave above this frequency.
+static const double PRE_EMPHASIS_FREQ_HZ = 50.0;
+
+
+// ****************************************************************************
+/// Constructor.
+// ****************************************************************************
+
+FormantEstimatorLpc::FormantEstimatorLpc()
+{
+  // ****************************************************************
+  // Init the public variables.
+  // ****************************************************************
+
+  timeStep_s = 0.01;
+  windowLength_s = 0.025;
+  maxBandwidth_Hz = 600.0;
+  silenceThreshold_dB = 40.0;
+  referenceFrequency_Hz[0] = 500.0;
+  referenceFrequency_Hz[1] = 1500.0;
+  referenceFrequency_Hz[2] = 2500.0;
+  frequencyWeight = 1.0;
+  bandwidthWeight = 1.0;
+  transitionWeight = 1.0;
+  numThreads = max(1, (int)thread::hardware_concurrency());
+
+  // ****************************************************************
+  // Init the private variables.
+  // ****************************************************************
+
+  firstRoiSample = 0;
+  numRoiSamples = 0;
+  firstChunkSample = 0;
+}
+
+
+// ****************************************************************************
+/// This function initializes the estimation process and performs the
+/// pre-processing operations (downsampling and pre-emphasis).
+/// firstRoiSample and numRoiSamples define the region of interest in signal,
+/// for which the formants shall be estimated. No formants are returned for
+/// the rest of the signal.
+// ****************************************************************************
+
+void FormantEstimatorLpc::init(Signal16 *signal, int firstRoiSample, int numRoiSamples)
+{
+  this->firstRoiSample = firstRoiSample;
+  this->numRoiSamples = numRoiSamples;
+  firstChunkSample = firstRoiSample;
+
+  int i;
+  int signalLength = signal->N;
+  const double samplingRate = (double)SAMPLING_RATE / (double)DECIMATION;
+
+  // ****************************************************************
+  // Low-pass filter the whole input signal below the new Nyquist
+  // frequency and downsample it.
+  // ****************************************************************
+
+  vector<double> origSignal(signalLength);
+  vector<double> filteredSignal(signalLength);
+  
+  for (i=0; i < signalLength; i++)
+  {
+    origSignal[i] = (double)signal->x[i];
+  }
+
+  if (signalLength > 0)
+  {
+    IirFilter lowPass;
+    lowPass.createChebyshev(0.9*0.5 / (double)DECIMATION, false, 8);
+    lowPass.resetBuffers(origSignal[0]);
+    lowPass.process(origSignal.data(), filteredSignal.data(), signalLength);
+  }
+
+  int numDownsampledSamples = signalLength / DECIMATION;
+  downsampledSignal.reset(numDownsampledSamples);
+
+  // Pre-emphasis.
+
+  double alpha = exp(-2.0*M_PI*PRE_EMPHASIS_FREQ_HZ / samplingRate);
+  double prevSample = 0.0;
+  for (i=0; i < numDownsampledSamples; i++)
+  {
+    double sample = filteredSignal[i*DECIMATION];
+    downsampledSignal.x[i] = sample - alpha*prevSample;
+    prevSample = sample;
+  }
+
+  // ****************************************************************
+  // Hann window of the frames.
+  // ****************************************************************
+
+  int windowLength = max(LPC_ORDER + 1, (int)(windowLength_s*samplingRate));
+  window.resize(windowLength);
+  for (i=0; i < windowLength; i++)
+  {
+    window[i] = 0.5*(1.0 - cos(2.0*M_PI*i / (windowLength-1)));
+  }
+
+  // ****************************************************************
+  // Reset all frames to frames without formant candidates.
+  // ****************************************************************
+
+  int numFrames = (int)((double)signalLength / ((double)SAMPLING_RATE*timeStep_s));
+  frames.resize(numFrames);
+  
+  for (i=0; i < numFrames; i++)
+  {
+    frames[i].numCandidates = 0;
+    frames[i].rmsAmplitude = 0.0;
+  }
+}
+
+
+// ****************************************************************************
+/// This function allows to process the formant estimation in one or more 
+/// chunks of data such that the calling GUI can stay reactive.
+/// Call this function one or several times after init(...) to analyze the
+/// frames of the next chunk of samples.
+///
+/// \return true, if all samples in the region of interest were processed.
+/// If false is returned, processChunk(...) should be called again for the
+/// remaining samples, before the estimation is finished with finish(...).
+// ****************************************************************************
+
+bool FormantEstimatorLpc::processChunk(int numChunkSamples)
+{
+  int lastChunkSample = firstChunkSample + numChunkSamples - 1;
+  if (lastChunkSample > firstRoiSample + numRoiSamples - 1)
+  {
+    lastChunkSample = firstRoiSample + numRoiSamples - 1;    
+  }
+  int firstFrame = (int)ceil(firstChunkSample / ((double)SAMPLING_RATE*timeStep_s));
+  int lastFrame = (int)(lastChunkSample / ((double)SAMPLING_RATE*timeStep_s));
+  // The last samples of the signal may not complete a frame.
+  if (lastFrame > (int)frames.size() - 1) { lastFrame = (int)frames.size() - 1; }
+
+  // ****************************************************************
+  // The frames are independent and are distributed on the threads
+  // of the pool (see ParallelLoop.h).
+  // ****************************************************************
+
+  int numFrames = lastFrame - firstFrame + 1;
+  if (numFrames > 0)
+  {
+    parallelLoop(numFrames, numThreads, [&](int k) { processFrame(firstFrame + k); });
+  }
+
+  // ****************************************************************
+  // Increment the internal chunk start position and return true,
+  // when the whole ROI was processed.
+  // ****************************************************************
+
+  firstChunkSample+= numChunkSamples;
+  if (firstChunkSample >= firstRoiSample + numRoiSamples)
+  {
+    return true;
+  }
+  else
+  {
+    return false;
+  }
+}
+
+
+// ****************************************************************************
+/// Calculates the formant candidates of the frame with the given index. 
+/// This function only writes into frames[i] and may be called for different
+/// frames at the same time.
+// ****************************************************************************
+
+void FormantEstimatorLpc::processFrame(int frameIndex)
+{
+  int i;
+  int frameLength = (int)window.size();
+  vector<double> frame(frameLength);
+
+  int centerPos_pt = (int)(frameIndex*timeStep_s*(double)SAMPLING_RATE) / DECIMATION;
+  int firstPos_pt = centerPos_pt - frameLength / 2;
+
+  for (i=0; i < frameLength; i++)
+  {
+    int pos = firstPos_pt + i;
+    if ((pos >= 0) && (pos < downsampledSignal.N))
+    {
+      frame[i] = downsampledSignal.x[pos] * window[i];
+    }
+    else
+    {
+      frame[i] = 0.0;
+    }
+  }
+
+  getFrameData(frame.data(), frameLength, frames[frameIndex]);
+}
+
+
+// ****************************************************************************
+/// Calculates the rms amplitude and the formant candidates of a windowed 
+/// frame of the downsampled signal. The candidates are the roots of the LPC
+/// polynomial in the upper half plane with a bandwidth below maxBandwidth_Hz.
+// ****************************************************************************
+
+void FormantEstimatorLpc::getFrameData(const double *frameSignal, int frameLength, 
+  FrameData &fd)
+{
+  const double samplingRate = (double)SAMPLING_RATE / (double)DECIMATION;
+  int i, k;
+  double sum = 0.0;
+
+  for (i=0; i < frameLength; i++)
+  {
+    sum+= frameSignal[i]*frameSignal[i];
+  }
+  fd.rmsAmplitude = sqrt(sum / (double)frameLength);
+  fd.numCandidates = 0;
+
+  if (fd.rmsAmplitude <= 0.0)
+  {
+    return;
+  }
+
+  // ****************************************************************
+  // Find the roots of the LPC polynomial.
+  // ****************************************************************
+
+  double lpcCoeff[LPC_ORDER + 1];
+  // One more coefficient and root for getPolynomRoots() with odd orders.
+  double polynomCoeff[LPC_ORDER + 2];
+  ComplexValue roots[LPC_ORDER + 2];
+  int N = LPC_ORDER;
+
+  getLPCCoefficients(frameSignal, frameLength, lpcCoeff, LPC_ORDER);
+  LPCToPolynomCoefficients(lpcCoeff, polynomCoeff, LPC_ORDER);
+  getPolynomRoots(polynomCoeff, N, roots);
+
+  // ****************************************************************
+  // Keep the roots with positive frequencies and small bandwidths,
+  // sorted by frequency.
+  // ****************************************************************
+
+  for (i=0; i < N; i++)
+  {
+    double r = abs(roots[i]);
+    if ((roots[i].imag() <= 0.0) || (r >= 1.0) || (r <= 0.0))
+    {
+      continue;
+    }
+
+    double freq = arg(roots[i])*samplingRate / (2.0*M_PI);
+    double bandwidth = -log(r)*samplingRate / M_PI;
+
+    if ((freq < MIN_FORMANT_FREQ_HZ) || (freq > 0.5*samplingRate - 50.0) ||
+      (bandwidth > maxBandwidth_Hz) || (fd.numCandidates >= MAX_CANDIDATES))
+    {
+      continue;
+    }
+
+    k = fd.numCandidates;
+    while ((k > 0) && (fd.candidateFrequency_Hz[k-1] > freq))
+    {
+      fd.candidateFrequency_Hz[k] = fd.candidateFrequency_Hz[k-1];
+      fd.candidateBandwidth_Hz[k] = fd.candidateBandwidth_Hz[k-1];
+      k--;
+    }
+    fd.candidateFrequency_Hz[k] = freq;
+    fd.candidateBandwidth_Hz[k] = bandwidth;
+    fd.numCandidates++;
+  }
+}
+
+
+// ****************************************************************************
+/// After the whole input signal was processed (processChunk(...)==true), 
+/// this function returns the vectors with the estimates of F1, F2, F3 every
+/// timeStep_s seconds from the beginning of the input signal on. The values
+/// of silent frames and of frames with too few candidates are zero.
+// ****************************************************************************
+
+void FormantEstimatorLpc::finish(vector<double> formantValues[NUM_FORMANTS])
+{
+  findBestFormantPaths(formantValues);
+}
+
+
+// ****************************************************************************
+/// Cost of the assignment of the given candidates to the formants.
+// ****************************************************************************
+
+double FormantEstimatorLpc::getLocalCost(const FrameData &fd, const int *candidates)
+{
+  int k;
+  double cost = 0.0;
+
+  for (k=0; k < NUM_FORMANTS; k++)
+  {
+    double freq = fd.candidateFrequency_Hz[candidates[k]];
+    cost+= frequencyWeight*fabs(freq - referenceFrequency_Hz[k]) / referenceFrequency_Hz[k];
+    cost+= bandwidthWeight*fd.candidateBandwidth_Hz[candidates[k]] / freq;
+  }
+
+  return cost;
+}
+
+
+// ****************************************************************************
+/// Cost of the changes of the formant frequencies between two frames.
+// ****************************************************************************
+
+double FormantEstimatorLpc::getTransitionCost(const FrameData &prevFd, 
+  const int *prevCandidates, const FrameData &fd, const int *candidates)
+{
+  int k;
+  double cost = 0.0;
+
+  for (k=0; k < NUM_FORMANTS; k++)
+  {
+    cost+= fabs(log(fd.candidateFrequency_Hz[candidates[k]] / 
+      prevFd.candidateFrequency_Hz[prevCandidates[k]]));
+  }
+
+  return transitionWeight*cost;
+}
+
+
+// ****************************************************************************
+/// Appends the NUM_FORMANTS candidate indices of all assignments of 
+/// numCandidates candidates in ascending order to the formants.
+// ****************************************************************************
+
+static void getAssignments(int numCandidates, vector<int> &assignments)
+{
+  const int K = FormantEstimatorLpc::NUM_FORMANTS;
+  int index[K];
+  int k;
+
+  assignments.clear();
+  if (numCandidates < K)
+  {
+    return;
+  }
+
+  for (k=0; k < K; k++) { index[k] = k; }
+
+  while (true)
+  {
+    assignments.insert(assignments.end(), index, index + K);
+
+    // Increment the last index that can still be incremented.
+    k = K - 1;
+    while ((k >= 0) && (index[k] == numCandidates - K + k)) { k--; }
+    if (k < 0) { break; }
+    index[k]++;
+    for (k = k + 1; k < K; k++) { index[k] = index[k-1] + 1; }
+  }
+}
+
+
+// ****************************************************************************
+/// Selects the candidates of the formants with the Viterbi algorithm, for
+/// each section of consecutive frames with enough candidates that are not
+/// silent.
+// ****************************************************************************
+
+void FormantEstimatorLpc::findBestFormantPaths(vector<double> formantValues[NUM_FORMANTS])
+{
+  const int K = NUM_FORMANTS;
+  int numFrames = (int)frames.size();
+  int i, j, k, s, t;
+
+  for (k=0; k < K; k++)
+  {
+    formantValues[k].assign(numFrames, 0.0);
+  }
+
+  // ****************************************************************
+  // Rms amplitude below which a frame is silent.
+  // ****************************************************************
+
+  double maxRms = 0.0;
+  for (i=0; i < numFrames; i++)
+  {
+    maxRms = max(maxRms, frames[i].rmsAmplitude);
+  }
+  double minRms = maxRms*pow(10.0, -silenceThreshold_dB / 20.0);
+
+  auto isValidFrame = [&](int frameIndex)
+  {
+    return (frames[frameIndex].numCandidates >= K) && 
+      (frames[frameIndex].rmsAmplitude > 0.0) &&
+      (frames[frameIndex].rmsAmplitude >= minRms);
+  };
+
+  // ****************************************************************
+  // Process the sections of valid frames.
+  // ****************************************************************
+
+  vector<vector<int>> assignments;
+  vector<vector<double>> pathCost;
+  vector<vector<int>> bestPrevAssignment;
+
+  i = 0;
+  while (i < numFrames)
+  {
+    if (!isValidFrame(i))
+    {
+      i++;
+      continue;
+    }
+
+    int firstFrame = i;
+    while ((i < numFrames) && (isValidFrame(i))) { i++; }
+    int numSectionFrames = i - firstFrame;
+
+    assignments.resize(numSectionFrames);
+    pathCost.resize(numSectionFrames);
+    bestPrevAssignment.resize(numSectionFrames);
+
+    for (j=0; j < numSectionFrames; j++)
+    {
+      const FrameData &fd = frames[firstFrame + j];
+      getAssignments(fd.numCandidates, assignments[j]);
+      int numStates = (int)assignments[j].size() / K;
+      pathCost[j].assign(numStates, 0.0);
+      bestPrevAssignment[j].assign(numStates, -1);
+
+      for (s=0; s < numStates; s++)
+      {
+        const int *candidates = &assignments[j][s*K];
+        double localCost = getLocalCost(fd, candidates);
+
+        if (j == 0)
+        {
+          pathCost[j][s] = localCost;
+          continue;
+        }
+
+        // Find the best predecessor.
+        const FrameData &prevFd = frames[firstFrame + j - 1];
+        int numPrevStates = (int)assignments[j-1].size() / K;
+        double minCost = numeric_limits<double>::max();
+        for (t=0; t < numPrevStates; t++)
+        {
+          double cost = pathCost[j-1][t] + 
+            getTransitionCost(prevFd, &assignments[j-1][t*K], fd, candidates);
+          if (cost < minCost)
+          {
+            minCost = cost;
+            bestPrevAssignment[j][s] = t;
+          }
+        }
+        pathCost[j][s] = minCost + localCost;
+      }
+    }
+
+    // Backtracking from the best final assignment.
+
+    j = numSectionFrames - 1;
+    s = (int)(min_element(pathCost[j].begin(), pathCost[j].end()) - pathCost[j].begin());
+
+    for (; j >= 0; j--)
+    {
+      const FrameData &fd = frames[firstFrame + j];
+      for (k=0; k < K; k++)
+      {
+        formantValues[k][firstFrame + j] = fd.candidateFrequency_Hz[assignments[j][s*K + k]];
+      }
+      s = bestPrevAssignment[j][s];
+    }
+  }
+}
+
+// ****************************************************************************
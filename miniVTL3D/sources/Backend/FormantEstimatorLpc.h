@@ -0,0 +1,122 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#ifndef __FORMANT_ESTIMATOR_LPC_H__
+#define __FORMANT_ESTIMATOR_LPC_H__
+
+#include <vector>
+#include "Dsp.h"
+#include "Signal.h"
+#include "IirFilter.h"
+#include "Constants.h"
+
+using namespace std;
+
+
+// ****************************************************************************
+// This class estimates the tracks of the formants F1, F2, F3 from a given 
+// signal. The signal is downsampled and pre-emphasized, and the formant
+// candidates of each frame are the roots of the LPC polynomial with a 
+// small bandwidth. The frames are analyzed in parallel. Then a dynamic
+// programming search selects the candidates of the formants in each frame, 
+// so that the tracks are close to typical formant frequencies and vary 
+// smoothly over time.
+// ****************************************************************************
+
+class FormantEstimatorLpc
+{
+  // **************************************************************************
+  // Public data.
+  // **************************************************************************
+
+public:
+  static const int NUM_FORMANTS = 3;
+  /// The signal is analyzed at SAMPLING_RATE / DECIMATION (11025 Hz)
+  static const int DECIMATION = 4;
+  static const int LPC_ORDER = 12;
+  static const int MAX_CANDIDATES = LPC_ORDER / 2;
+
+  double timeStep_s;
+  double windowLength_s;
+  /// Candidates with a greater bandwidth are not considered as formants
+  double maxBandwidth_Hz;
+  /// Frames more than this below the loudest frame are considered silent
+  double silenceThreshold_dB;
+  /// Typical frequencies of the formants (of a neutral vowel)
+  double referenceFrequency_Hz[NUM_FORMANTS];
+  /// Weights of the costs of the deviations from the reference 
+  /// frequencies, of the bandwidths, and of the frequency changes
+  double frequencyWeight;
+  double bandwidthWeight;
+  double transitionWeight;
+  /// Number of threads that process the frames of a chunk in parallel
+  int numThreads;
+
+  struct FrameData
+  {
+    int numCandidates;
+    /// The candidates are sorted in ascending order of frequency
+    double candidateFrequency_Hz[MAX_CANDIDATES];
+    double candidateBandwidth_Hz[MAX_CANDIDATES];
+    double rmsAmplitude;
+  };
+
+  vector<FrameData> frames;
+
+  // **************************************************************************
+  // Public functions.
+  // **************************************************************************
+
+public:
+  FormantEstimatorLpc();
+
+  void init(Signal16 *signal, int firstRoiSample, int numRoiSamples);
+  bool processChunk(int numChunkSamples);
+  void finish(vector<double> formantValues[NUM_FORMANTS]);
+
+  void getFrameData(const double *frameSignal, int frameLength, FrameData &fd);
+
+  // **************************************************************************
+  // Private data.
+  // **************************************************************************
+
+private:
+  Signal downsampledSignal;
+  vector<double> window;
+  int firstRoiSample;
+  int numRoiSamples;
+  int firstChunkSample;
+
+  // **************************************************************************
+  // Private functions.
+  // **************************************************************************
+
+private:
+  void processFrame(int frameIndex);
+  double getLocalCost(const FrameData &fd, const int *candidates);
+  double getTransitionCost(const FrameData &prevFd, const int *prevCandidates,
+    const FrameData &fd, const int *candidates);
+  void findBestFormantPaths(vector<double> formantValues[NUM_FORMANTS]);
+};
+
+#endif
+
+// ****************************************************************************
@@ -1221,17 +1221,24 @@ void Triangle3D::set(Point3D P0, Point3D P1, Point3D P2)
 
 // ****************************************************************************
 
+Point3D Triangle3D::getNormal() const
+{
+	return Point3D((P[1].y - P[0].y) * (P[2].z - P[0].z) -
+		(P[1].z - P[0].z) * (P[2].y - P[0].y),
+		(P[1].z - P[0].z) * (P[2].x - P[0].x) -
+		(P[1].x - P[0].x) * (P[2].z - P[0].z),
+		(P[1].x - P[0].x) * (P[2].y - P[0].y) -
+		(P[1].y - P[0].y) * (P[2].x - P[0].x));
+}
+
+// ****************************************************************************
+
 string Triangle3D::stringSTLformat()
 {
 
 	// compute normal to the triangle
-	double normal[3];
-	normal[0] = (P[1].y - P[0].y) * (P[2].z - P[0].z) -
-		(P[1].z - P[0].z) * (P[2].y - P[0].y);
-	normal[1] = (P[1].z - P[0].z) * (P[2].x - P[0].x) -
-		(P[1].x - P[0].x) * (P[2].z - P[0].z);
-	normal[2] = (P[1].x - P[0].x) * (P[2].y - P[0].y) -
-		(P[1].y - P[0].y) * (P[2].x - P[0].x);
+	Point3D N(getNormal());
+	double normal[3] = { N.x, N.y, N.z };
 
 	// generate the text corresponding to the STL expression for creating the triangle
 	ostringstream streamTextSTL;
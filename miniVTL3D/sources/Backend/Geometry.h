@@ -271,6 +271,9 @@ public:
 	Triangle3D(Point3D P0, Point3D P1, Point3D P2);
 
 	void set(Point3D P0, Point3D P1, Point3D P2);
+	Point3D getPoint(int i) const { return P[i]; }
+	// normal to the triangle (not normalized)
+	Point3D getNormal() const;
 	std::string stringSTLformat();
 
 private:
@@ -0,0 +1,286 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#include "GeometryFile.h"
+#include <fstream>
+#include <algorithm>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// magic number at the beginning of the binary geometry files
+static const char GEOMETRY_MAGIC[8] = { 'V', 'T', 'L', '3', 'D', 'G', 'E', 'O' };
+
+// size of the header (magic, version, flags, numbers of sections and points)
+static const size_t GEOMETRY_HEADER_SIZE = 8 + 4 * sizeof(uint32_t);
+
+// ****************************************************************************
+
+static size_t geometryFileSize(size_t numSections, size_t numPoints)
+{
+  return GEOMETRY_HEADER_SIZE + (6 * numSections + 2 * numPoints) * sizeof(double)
+    + (numSections + 1) * sizeof(uint32_t) + numPoints * sizeof(int32_t);
+}
+
+// ****************************************************************************
+
+template <typename T>
+static void writeArray(ofstream& ofs, const vector<T>& vec)
+{
+  if (vec.size() > 0)
+  {
+    ofs.write((const char*)vec.data(), vec.size() * sizeof(T));
+  }
+}
+
+// ****************************************************************************
+// Write a binary geometry file
+
+bool writeGeometryFile(const string& fileName, const struct geometryArrays& geo)
+{
+  size_t numSections(geo.centerLine.size() / 2);
+  size_t numPoints(geo.points.size() / 2);
+
+  // check the consistency of the arrays
+  if ((geo.normals.size() != 2 * numSections) ||
+    (geo.scalingFactors.size() != 2 * numSections) ||
+    (geo.contourOffsets.size() != numSections + 1) ||
+    (geo.contourOffsets.front() != 0) || (geo.contourOffsets.back() != numPoints) ||
+    (geo.surfaceIdx.size() != numPoints))
+  {
+    return false;
+  }
+
+  ofstream ofs(fileName, ios::binary | ios::trunc);
+  if (!ofs.is_open()) { return false; }
+
+  int32_t version(GEOMETRY_FILE_VERSION);
+  uint32_t flags(geo.simplified ? GEOMETRY_FILE_SIMPLIFIED : 0);
+  uint32_t header[3] = { flags, (uint32_t)numSections, (uint32_t)numPoints };
+  ofs.write(GEOMETRY_MAGIC, 8);
+  ofs.write((const char*)&version, sizeof(version));
+  ofs.write((const char*)header, sizeof(header));
+  writeArray(ofs, geo.centerLine);
+  writeArray(ofs, geo.normals);
+  writeArray(ofs, geo.scalingFactors);
+  writeArray(ofs, geo.points);
+  writeArray(ofs, geo.contourOffsets);
+  writeArray(ofs, geo.surfaceIdx);
+
+  ofs.close();
+  return !ofs.fail();
+}
+
+// ****************************************************************************
+
+bool isBinaryGeometryFile(const string& fileName)
+{
+  ifstream ifs(fileName, ios::binary);
+  char magic[8];
+  ifs.read(magic, 8);
+  return ifs && equal(magic, magic + 8, GEOMETRY_MAGIC);
+}
+
+// ****************************************************************************
+// Memory mapping of a binary geometry file
+// ****************************************************************************
+
+MappedGeometryFile::MappedGeometryFile() :
+  m_data(NULL),
+  m_size(0),
+#ifdef _WIN32
+  m_file(INVALID_HANDLE_VALUE),
+  m_mapping(NULL),
+#else
+  m_file(-1),
+#endif
+  m_flags(0),
+  m_numSections(0),
+  m_numPoints(0),
+  m_centerLine(NULL),
+  m_normals(NULL),
+  m_scalingFactors(NULL),
+  m_points(NULL),
+  m_contourOffsets(NULL),
+  m_surfaceIdx(NULL)
+{
+}
+
+// ****************************************************************************
+
+MappedGeometryFile::~MappedGeometryFile()
+{
+  close();
+}
+
+// ****************************************************************************
+// Map the file and check its header, its size and the contour offsets
+
+bool MappedGeometryFile::open(const string& fileName, string& error)
+{
+  close();
+
+  //****************************************************
+  // map the file
+  //****************************************************
+
+#ifdef _WIN32
+  m_file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  LARGE_INTEGER fileSize;
+  if ((m_file == INVALID_HANDLE_VALUE) || !GetFileSizeEx(m_file, &fileSize))
+  {
+    error = "Cannot open " + fileName;
+    close();
+    return false;
+  }
+  m_size = (size_t)fileSize.QuadPart;
+  if (m_size < GEOMETRY_HEADER_SIZE)
+  {
+    error = fileName + " is not a binary geometry file";
+    close();
+    return false;
+  }
+  m_mapping = CreateFileMappingA(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (m_mapping != NULL)
+  {
+    m_data = (const char*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+  }
+#else
+  m_file = ::open(fileName.c_str(), O_RDONLY);
+  struct stat fileStat;
+  if ((m_file < 0) || (fstat(m_file, &fileStat) != 0))
+  {
+    error = "Cannot open " + fileName;
+    close();
+    return false;
+  }
+  m_size = (size_t)fileStat.st_size;
+  if (m_size < GEOMETRY_HEADER_SIZE)
+  {
+    error = fileName + " is not a binary geometry file";
+    close();
+    return false;
+  }
+  void* data(mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, m_file, 0));
+  if (data != MAP_FAILED) { m_data = (const char*)data; }
+#endif
+
+  if (m_data == NULL)
+  {
+    error = "Cannot map " + fileName;
+    close();
+    return false;
+  }
+
+  //****************************************************
+  // check the header and the size of the file
+  //****************************************************
+
+  int32_t version;
+  uint32_t header[3];
+  copy(m_data + 8, m_data + 12, (char*)&version);
+  copy(m_data + 12, m_data + GEOMETRY_HEADER_SIZE, (char*)header);
+
+  if (!equal(m_data, m_data + 8, GEOMETRY_MAGIC))
+  {
+    error = fileName + " is not a binary geometry file";
+    close();
+    return false;
+  }
+  if (version != GEOMETRY_FILE_VERSION)
+  {
+    error = fileName + " has not the version of the binary geometry format";
+    close();
+    return false;
+  }
+  if (m_size != geometryFileSize(header[1], header[2]))
+  {
+    error = fileName + " is truncated or corrupted";
+    close();
+    return false;
+  }
+
+  m_flags = header[0];
+  m_numSections = (int)header[1];
+  m_numPoints = (int)header[2];
+
+  // the arrays of doubles come first so that they are all aligned
+  const char* ptr(m_data + GEOMETRY_HEADER_SIZE);
+  m_centerLine = (const double*)ptr;
+  m_normals = m_centerLine + 2 * m_numSections;
+  m_scalingFactors = m_normals + 2 * m_numSections;
+  m_points = m_scalingFactors + 2 * m_numSections;
+  m_contourOffsets = (const uint32_t*)(m_points + 2 * m_numPoints);
+  m_surfaceIdx = (const int32_t*)(m_contourOffsets + m_numSections + 1);
+
+  // check the contour offsets
+  bool validOffsets((m_contourOffsets[0] == 0) && 
+    (m_contourOffsets[m_numSections] == (uint32_t)m_numPoints));
+  for (int i(0); validOffsets && (i < m_numSections); i++)
+  {
+    validOffsets = (m_contourOffsets[i] <= m_contourOffsets[i + 1]);
+  }
+  if (!validOffsets)
+  {
+    error = fileName + " has invalid contour offsets";
+    close();
+    return false;
+  }
+
+  return true;
+}
+
+// ****************************************************************************
+
+void MappedGeometryFile::close()
+{
+#ifdef _WIN32
+  if (m_data != NULL) { UnmapViewOfFile(m_data); }
+  if (m_mapping != NULL) { CloseHandle(m_mapping); }
+  if (m_file != INVALID_HANDLE_VALUE) { CloseHandle(m_file); }
+  m_mapping = NULL;
+  m_file = INVALID_HANDLE_VALUE;
+#else
+  if (m_data != NULL) { munmap((void*)m_data, m_size); }
+  if (m_file >= 0) { ::close(m_file); }
+  m_file = -1;
+#endif
+
+  m_data = NULL;
+  m_size = 0;
+  m_flags = 0;
+  m_numSections = 0;
+  m_numPoints = 0;
+  m_centerLine = NULL;
+  m_normals = NULL;
+  m_scalingFactors = NULL;
+  m_points = NULL;
+  m_contourOffsets = NULL;
+  m_surfaceIdx = NULL;
+}
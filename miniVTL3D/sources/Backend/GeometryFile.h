@@ -0,0 +1,128 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#ifndef __GEOMETRY_FILE_H__
+#define __GEOMETRY_FILE_H__
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+// version of the binary geometry format, to increment when the layout of 
+// the files changes
+const int GEOMETRY_FILE_VERSION = 1;
+
+// ****************************************************************************
+// Binary geometry file, alternative to the semicolon separated csv file.
+// It contains the same data (centerline points, normals, scaling factors 
+// and one contour per section) plus the surface indexes of the contour 
+// points, stored as contiguous arrays in native (little endian) byte order:
+//
+//   char[8]   magic "VTL3DGEO"
+//   int32     version
+//   uint32    flags (bit 0: the contours are already simplified)
+//   uint32    number of sections N
+//   uint32    total number of contour points P
+//   double    centerline points      [2N] (x, y)
+//   double    normals                [2N] (x, y)
+//   double    scaling factors        [2N] (in, out)
+//   double    contour points         [2P] (x, y)
+//   uint32    index of the first point of each contour [N + 1]
+//   int32     surface indexes        [P]
+//
+// The file is mapped in memory to be read, so that the contours are built 
+// directly from the mapped arrays without any parsing.
+// ****************************************************************************
+
+const uint32_t GEOMETRY_FILE_SIMPLIFIED = 1;
+
+// Arrays of a geometry, used to write a file
+struct geometryArrays
+{
+  vector<double> centerLine;
+  vector<double> normals;
+  vector<double> scalingFactors;
+  vector<double> points;
+  vector<uint32_t> contourOffsets;  // N + 1 values, the first one is 0
+  vector<int32_t> surfaceIdx;
+  bool simplified;
+};
+
+bool writeGeometryFile(const string& fileName, const struct geometryArrays& geo);
+
+// true if the file starts with the magic number of the binary format
+bool isBinaryGeometryFile(const string& fileName);
+
+// ****************************************************************************
+// Read-only memory mapping of a binary geometry file
+// ****************************************************************************
+
+class MappedGeometryFile
+{
+public:
+
+  MappedGeometryFile();
+  ~MappedGeometryFile();
+
+  // map the file and check its header and size
+  bool open(const string& fileName, string& error);
+  void close();
+
+  int numSections() const { return m_numSections; }
+  int numPoints() const { return m_numPoints; }
+  bool contoursSimplified() const { return (m_flags & GEOMETRY_FILE_SIMPLIFIED) != 0; }
+  const double* centerLine() const { return m_centerLine; }
+  const double* normals() const { return m_normals; }
+  const double* scalingFactors() const { return m_scalingFactors; }
+  const double* points() const { return m_points; }
+  const uint32_t* contourOffsets() const { return m_contourOffsets; }
+  const int32_t* surfaceIdx() const { return m_surfaceIdx; }
+
+private:
+
+  // not copyable since it owns the mapping
+  MappedGeometryFile(const MappedGeometryFile&);
+  MappedGeometryFile& operator=(const MappedGeometryFile&);
+
+  const char* m_data;
+  size_t m_size;
+#ifdef _WIN32
+  void* m_file;
+  void* m_mapping;
+#else
+  int m_file;
+#endif
+
+  uint32_t m_flags;
+  int m_numSections;
+  int m_numPoints;
+  const double* m_centerLine;
+  const double* m_normals;
+  const double* m_scalingFactors;
+  const double* m_points;
+  const uint32_t* m_contourOffsets;
+  const int32_t* m_surfaceIdx;
+};
+
+#endif
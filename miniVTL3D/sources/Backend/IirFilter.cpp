@@ -30,6 +30,7 @@
 
 IirFilter::IirFilter()
 {
+  numSections = 0;
   resetBuffers();
   createUnityFilter();
 }
@@ -50,6 +51,14 @@ void IirFilter::resetBuffers(double initialValue)
     outputBuffer[i] = initialValue;
   }
 
+  for (i=0; i < MAX_IIR_SECTIONS; i++)
+  {
+    section[i].x1 = initialValue;
+    section[i].x2 = initialValue;
+    section[i].y1 = initialValue;
+    section[i].y2 = initialValue;
+  }
+
   pos = 0;
 }
 
@@ -62,6 +71,25 @@ double IirFilter::getOutputSample(double nextInputSample)
 {
   int i;
 
+  if (numSections >= 0)
+  {
+    double x = nextInputSample;
+    double y;
+    Section *s;
+
+    for (i=0; i < numSections; i++)
+    {
+      s = &section[i];
+      y = s->a0*x + s->a1*s->x1 + s->a2*s->x2 + s->b1*s->y1 + s->b2*s->y2;
+      s->x2 = s->x1;
+      s->x1 = x;
+      s->y2 = s->y1;
+      s->y1 = y;
+      x = y;
+    }
+    return x;
+  }
+
   inputBuffer[pos & IIR_BUFFER_MASK] = nextInputSample;
 
   double sum = a[0]*nextInputSample;
@@ -78,6 +106,61 @@ double IirFilter::getOutputSample(double nextInputSample)
   return sum;
 }
 
+// ****************************************************************************
+/// Filters numSamples samples of the input signal into the output signal 
+/// (which may be the same array as the input signal). The result is the same
+/// as with getOutputSample(...) for each sample, but the sections are 
+/// processed one after the other over the whole block with their 
+/// coefficients and states in local variables.
+// ****************************************************************************
+
+void IirFilter::process(const double *input, double *output, int numSamples)
+{
+  int i, k;
+
+  if (numSections < 0)
+  {
+    for (k=0; k < numSamples; k++) { output[k] = getOutputSample(input[k]); }
+    return;
+  }
+
+  if ((numSections == 0) && (output != input))
+  {
+    for (k=0; k < numSamples; k++) { output[k] = input[k]; }
+  }
+
+  for (i=0; i < numSections; i++)
+  {
+    const double *x = (i == 0) ? input : output;
+    double a0 = section[i].a0;
+    double a1 = section[i].a1;
+    double a2 = section[i].a2;
+    double b1 = section[i].b1;
+    double b2 = section[i].b2;
+    double x1 = section[i].x1;
+    double x2 = section[i].x2;
+    double y1 = section[i].y1;
+    double y2 = section[i].y2;
+    double x0, y;
+
+    for (k=0; k < numSamples; k++)
+    {
+      x0 = x[k];
+      y = a0*x0 + a1*x1 + a2*x2 + b1*y1 + b2*y2;
+      x2 = x1;
+      x1 = x0;
+      y2 = y1;
+      y1 = y;
+      output[k] = y;
+    }
+
+    section[i].x1 = x1;
+    section[i].x2 = x2;
+    section[i].y1 = y1;
+    section[i].y2 = y2;
+  }
+}
+
 // ******************************************************************************
 // Returns the complex value of the transfer function at the given frequency.
 // The freqRatio is the frequency devided by the sampling rate, i.e., it is 0.5 
@@ -90,6 +173,19 @@ ComplexValue IirFilter::getFrequencyResponse(double freqRatio)
   ComplexValue z = std::exp(ComplexValue(0.0, 2.0*M_PI*freqRatio));
   ComplexValue factor = 1.0;
 
+  if (numSections >= 0)
+  {
+    ComplexValue z1 = 1.0 / z;
+    ComplexValue z2 = z1*z1;
+    ComplexValue response = 1.0;
+    for (i=0; i < numSections; i++)
+    {
+      response*= (section[i].a0 + section[i].a1*z1 + section[i].a2*z2) /
+        (1.0 - section[i].b1*z1 - section[i].b2*z2);
+    }
+    return response;
+  }
+
   ComplexValue numerator = a[0];
   ComplexValue denominator = 1.0;
 
@@ -149,6 +245,18 @@ void IirFilter::setGain(double gain)
   int i;
 
   for (i=0; i <= order; i++) { a[i]*= gain; }
+
+  if (numSections == 0)
+  {
+    addSection(gain, 0.0, 0.0, 0.0, 0.0);
+  }
+  else
+  if (numSections > 0)
+  {
+    section[0].a0*= gain;
+    section[0].a1*= gain;
+    section[0].a2*= gain;
+  }
 }
 
 // ****************************************************************************
@@ -167,6 +275,80 @@ void IirFilter::setCoefficients(const double *A, const double *B, const int newO
     a[i] = A[i];
     b[i] = B[i];
   }
+
+  // Arbitrary coefficients are not factorized into sections.
+  numSections = -1;
+}
+
+// ****************************************************************************
+// Sets the filter to the cascade of the given second-order sections, with the
+// coefficients a0, a1, a2 of the section i in A[3*i], A[3*i+1], A[3*i+2] and
+// b1, b2 in B[2*i], B[2*i+1]. The recursion coefficients are the product of
+// the sections. Returns false if there are more than MAX_IIR_SECTIONS
+// sections.
+// ****************************************************************************
+
+bool IirFilter::setSections(const double *A, const double *B, const int newNumSections)
+{
+  if ((newNumSections < 0) || (newNumSections > MAX_IIR_SECTIONS)) { return false; }
+
+  double ta[MAX_IIR_ORDER+1];
+  double tb[MAX_IIR_ORDER+1];
+  int i, j;
+
+  createUnityFilter();
+
+  // The polynomials of the sections are multiplied by convolution, with the
+  // denominators in the form 1 - b1*z^(-1) - b2*z^(-2).
+
+  for (i=0; i < newNumSections; i++)
+  {
+    addSection(A[3*i], A[3*i+1], A[3*i+2], B[2*i], B[2*i+1]);
+
+    for (j=0; j <= order; j++)
+    {
+      ta[j] = a[j];
+      tb[j] = (j == 0) ? 1.0 : -b[j];
+    }
+    ta[order+1] = ta[order+2] = 0.0;
+    tb[order+1] = tb[order+2] = 0.0;
+    order+= 2;
+
+    for (j=0; j <= order; j++)
+    {
+      a[j] = A[3*i]*ta[j];
+      b[j] = tb[j];
+      if (j >= 1)
+      {
+        a[j]+= A[3*i+1]*ta[j-1];
+        b[j]-= B[2*i]*tb[j-1];
+      }
+      if (j >= 2)
+      {
+        a[j]+= A[3*i+2]*ta[j-2];
+        b[j]-= B[2*i+1]*tb[j-2];
+      }
+    }
+    for (j=1; j <= order; j++) { b[j] = -b[j]; }
+    b[0] = 1.0;
+  }
+
+  return true;
+}
+
+// ****************************************************************************
+// Returns the coefficients a0, a1, a2, b1, b2 of the given section.
+// ****************************************************************************
+
+void IirFilter::getSection(int index, double *coefs) const
+{
+  if ((index < 0) || (index >= numSections)) { return; }
+
+  coefs[0] = section[index].a0;
+  coefs[1] = section[index].a1;
+  coefs[2] = section[index].a2;
+  coefs[3] = section[index].b1;
+  coefs[4] = section[index].b2;
 }
 
 // ****************************************************************************
@@ -237,6 +419,22 @@ bool IirFilter::combineWithFilter(const IirFilter *f, bool cascade)
 
   order+= f->order;
 
+  // A cascade of two cascades of sections is again a cascade of sections.
+  // A parallel combination has no simple section representation.
+
+  if ((cascade) && (numSections >= 0) && (f->numSections >= 0) && 
+      (numSections + f->numSections <= MAX_IIR_SECTIONS))
+  {
+    for (i=0; i < f->numSections; i++)
+    {
+      section[numSections++] = f->section[i];
+    }
+  }
+  else
+  {
+    numSections = -1;
+  }
+
   return true;
 }
 
@@ -252,6 +450,23 @@ void IirFilter::createUnityFilter()
   order = 0;
 }
 
+// ****************************************************************************
+// Appends a second-order section to the cascade with a cleared state.
+// ****************************************************************************
+
+void IirFilter::addSection(double a0, double a1, double a2, double b1, double b2)
+{
+  if ((numSections < 0) || (numSections >= MAX_IIR_SECTIONS)) { return; }
+
+  Section *s = &section[numSections++];
+  s->a0 = a0;
+  s->a1 = a1;
+  s->a2 = a2;
+  s->b1 = b1;
+  s->b2 = b2;
+  s->x1 = s->x2 = s->y1 = s->y2 = 0.0;
+}
+
 // ****************************************************************************
 // The cutoff-frequency ratio is the cutoff frequency devided by the
 // sampling rate, i.e., it is 0.5 for the Nyquist frequency (note that this 
@@ -266,6 +481,8 @@ void IirFilter::createSinglePoleLowpass(double cutoffFreqRatio)
   order = 1;
   a[0] = 1.0 - x;
   b[1] = x;
+
+  addSection(a[0], 0.0, 0.0, b[1], 0.0);
 }
 
 // ****************************************************************************
@@ -283,6 +500,8 @@ void IirFilter::createSinglePoleHighpass(double cutoffFreqRatio)
   a[0] = 0.5*(1.0 + x);
   a[1] = -a[0];
   b[1] = x;
+
+  addSection(a[0], a[1], 0.0, b[1], 0.0);
 }
 
 // ****************************************************************************
@@ -313,6 +532,8 @@ void IirFilter::createSecondOrderLowpass(double freqRatio, double Q)
   a[0] = K*K / denominator;
   a[1] = 2.0*a[0];
   a[2] = a[0];
+
+  addSection(a[0], a[1], a[2], b[1], b[2]);
 }
 
 // ****************************************************************************
@@ -352,6 +573,7 @@ void IirFilter::createChebyshev(double cutoffFreqRatio, bool isHighpass, int num
   }
   a[2] = 1.0;
   b[2] = 1.0;
+  numSections = 0;
 
   // numPoles/2 mal die Hauptschleife durchlaufen.
 
@@ -410,6 +632,14 @@ void IirFilter::createChebyshev(double cutoffFreqRatio, bool isHighpass, int num
 
     // Ende der Subroutine.
 
+    // Each stage is also a section of the cascade, normalized to a unity 
+    // gain at 0 Hz (low-pass) or at the Nyquist frequency (high-pass).
+    if (isHighpass)
+      { temp = (a0 - a1 + a2) / (1.0 + b1 - b2); }
+    else
+      { temp = (a0 + a1 + a2) / (1.0 - b1 - b2); }
+    addSection(a0 / temp, a1 / temp, a2 / temp, b1, b2);
+
     // Die berechneten Koeffizienten zur Kaskade addieren
     for (i=0; i <= MAX_IIR_ORDER; i++)
     {
@@ -467,7 +697,8 @@ void IirFilter::createChebyshev(double cutoffFreqRatio, bool isHighpass, int num
 
 
 // ****************************************************************************
-// Set all filter coefficients to zero (except b0).
+// Set all filter coefficients to zero (except b0), and clear the cascade of
+// sections.
 // ****************************************************************************
 
 void IirFilter::clearCoefficients()
@@ -475,6 +706,7 @@ void IirFilter::clearCoefficients()
   int i;
 
   order = 0;
+  numSections = 0;
   for (i=0; i <= MAX_IIR_ORDER; i++)
   {
     a[i] = 0.0;
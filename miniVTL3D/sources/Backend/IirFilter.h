@@ -26,6 +26,7 @@
 #include "Signal.h"
 
 const int MAX_IIR_ORDER = 32;
+const int MAX_IIR_SECTIONS = MAX_IIR_ORDER / 2;
 const int IIR_BUFFER_MASK   = 63; 
 const int IIR_BUFFER_LENGTH = 64;
 
@@ -42,6 +43,11 @@ typedef std::complex<double> ComplexValue;
 ///
 /// y[n] = a0*x[n] + a1*x[n-1] + a2*x[n-2] + ... + b1*y[n-1] + b2*y[n-2] + ...
 ///
+/// The filters created by the create...() functions and their cascades are
+/// additionally represented as a cascade of second-order sections, which
+/// is used for the filtering, because it is numerically safe also for high
+/// orders and low cutoff frequencies. Filters set by setCoefficients(...) or
+/// combined in parallel are filtered with the above recursion formula.
 // ****************************************************************************
 
 class IirFilter
@@ -51,12 +57,19 @@ class IirFilter
     void resetBuffers(double initialValue = 0.0);
 
     double getOutputSample(double nextInputSample);
+    void process(const double *input, double *output, int numSamples);
+    bool hasSections() const { return (numSections >= 0); }
     ComplexValue getFrequencyResponse(double freqRatio);
     void getFrequencyResponse(ComplexSignal *spectrum, int spectrumLength);
     void getFrequencyResponse(ComplexSignal *spectrum, int spectrumLength, int SR, double F0);
 
     void setGain(double gain);
     void setCoefficients(const double *A, const double *B, const int newOrder);
+    // Cascade of second-order sections with the coefficients a0, a1, a2 of
+    // each section in A and b1, b2 in B.
+    bool setSections(const double *A, const double *B, const int newNumSections);
+    int numberOfSections() const { return numSections; }
+    void getSection(int index, double *coefs) const;
     bool combineWithFilter(const IirFilter *f, bool cascade);
 
     // Creation of some simple filters.
@@ -73,11 +86,23 @@ public:
     int order;
 
 private:
+    /// Second-order section in direct form I:
+    /// y[n] = a0*x[n] + a1*x[n-1] + a2*x[n-2] + b1*y[n-1] + b2*y[n-2].
+    struct Section
+    {
+      double a0, a1, a2, b1, b2;
+      double x1, x2, y1, y2;
+    };
+
     int pos;
     double inputBuffer[IIR_BUFFER_LENGTH];
     double outputBuffer[IIR_BUFFER_LENGTH];
+    /// Number of sections, or -1 if the filter has no section representation
+    int numSections;
+    Section section[MAX_IIR_SECTIONS];
 
     void clearCoefficients();
+    void addSection(double a0, double a1, double a2, double b1, double b2);
 };
 
 
@@ -20,15 +20,15 @@
 // ****************************************************************************
 
 #include "LfPulse.h"
-#include <random>
 
 
 // ****************************************************************************
 /// Constructor. Sets the default parameter values.
 // ****************************************************************************
 
-LfPulse::LfPulse()
+LfPulse::LfPulse() : randomNumberGenerator(std::random_device{}())
 {
+  tablesValid = false;
   resetParams();
 }
 
@@ -52,8 +52,73 @@ void LfPulse::resetParams()
 
 void LfPulse::getPulse(Signal& s, int numSamples, bool getDerivative)
 {
-  const double MIN_TA = 0.01;   // Don't make is smaller!
   s.reset(numSamples);
+  
+  if ((tablesValid == false) || (OQ != tableOQ) || (SQ != tableSQ) || (TL != tableTL))
+  {
+    updateShapeTables();
+  }
+
+  // ****************************************************************
+  // Resample the tabulated shape with linear interpolation and scale
+  // it with the amplitude.
+  // ****************************************************************
+
+  Signal &table = getDerivative ? derivativeTable : flowTable;
+  double *atTe = getDerivative ? derivativeAtTe : flowAtTe;
+  double step = (double)SHAPE_TABLE_LENGTH / (double)s.N;
+  double pos, ratio, left, right;
+  int i, k;
+
+  for (i=0; i < s.N; i++)
+  {
+    pos = (double)i*step;
+    k = (int)pos;
+    ratio = pos - (double)k;
+    left = table.x[k];
+    right = table.x[k+1];
+    if (k == teIndex)
+    {
+      if ((double)i / (double)s.N <= OQ) { right = atTe[1]; } else { left = atTe[0]; }
+    }
+    s.x[i] = AMP*(left + ratio*(right - left));
+  }
+
+  // ****************************************************************
+  // Add noise to the glottal flow waveform.
+  // ****************************************************************
+
+  if (getDerivative == false)
+  {
+    // inputSample is a random number with the standard deviation
+    // 1/sqrt(12) and range limited to [-1.0, 1.0]
+    std::normal_distribution<double> normalDistribution(0.0, 1.0 / sqrt(12.0));
+    double noiseFactor = pow(10, -SNR / 20.);
+    double inputSample;
+
+    for (i=0; i < s.N; i++)
+    {
+      do
+      {
+        inputSample = normalDistribution(randomNumberGenerator);
+      } while ((inputSample < -1.0) || (inputSample > 1.0));
+      s.x[i] *= (1. + noiseFactor * inputSample);
+    }
+  }
+}
+
+
+// ****************************************************************************
+/// Calculates the tables of the flow and of its derivative for a unit 
+/// amplitude and the current parameters OQ, SQ and TL.
+// ****************************************************************************
+
+void LfPulse::updateShapeTables()
+{
+  const double MIN_TA = 0.01;   // Don't make is smaller!
+
+  flowTable.reset(SHAPE_TABLE_LENGTH + 1);
+  derivativeTable.reset(SHAPE_TABLE_LENGTH + 1);
 
   // ****************************************************************
   // Transform the parameters OQ, SQ and TL into the times te, tp and
@@ -69,75 +134,77 @@ void LfPulse::getPulse(Signal& s, int numSamples, bool getDerivative)
 
   double epsilon = getEpsilon(ta, te);
   double alpha   = getAlpha(tp, te, ta, epsilon);
-  double B       = getB(AMP, tp, alpha);
+  double B       = getB(1.0, tp, alpha);
 
   double w = 3.1415926 / tp;
   double t;
 
   int i;
 
+  teIndex = (int)(te*(double)SHAPE_TABLE_LENGTH);
+  if ((teIndex < 0) || (teIndex >= SHAPE_TABLE_LENGTH)) { teIndex = -1; }
+
   // ****************************************************************
   // Calculate the first derivative of the glottal flow.
   // ****************************************************************
 
-  if (getDerivative)
-  {
-    double c1 = (B*exp(alpha*te)*sin(w*te)) / (epsilon*ta);
-    double c2 = exp(-epsilon*(T0 - te));
+  double c1 = (B*exp(alpha*te)*sin(w*te)) / (epsilon*ta);
+  double c2 = exp(-epsilon*(T0 - te));
 
-    for (i=0; i < s.N; i++)
+  for (i=0; i <= SHAPE_TABLE_LENGTH; i++)
+  {
+    t = (double)i / (double)SHAPE_TABLE_LENGTH;
+    if (t <= te)
     {
-      t = (double)i / (double)s.N;
-      if (t <= te)
-      {
-        s.x[i] = B*exp(alpha*t)*sin(w*t);
-      }
-      else
-      {
-        s.x[i] = c1*(exp(-epsilon*(t-te)) - c2);
-      }
+      derivativeTable.x[i] = B*exp(alpha*t)*sin(w*t);
     }
+    else
+    {
+      derivativeTable.x[i] = c1*(exp(-epsilon*(t-te)) - c2);
+    }
+  }
+
+  if (teIndex >= 0)
+  {
+    t = (double)teIndex / (double)SHAPE_TABLE_LENGTH;
+    derivativeAtTe[0] = c1*(exp(-epsilon*(t-te)) - c2);
+    t = (double)(teIndex+1) / (double)SHAPE_TABLE_LENGTH;
+    derivativeAtTe[1] = B*exp(alpha*t)*sin(w*t);
   }
-  else
 
   // ****************************************************************
   // Calculate the glottal flow waveform.
   // ****************************************************************
 
-  {
-    double u1_te = (B*(exp(alpha*te)*(alpha*sin(w*te) - w*cos(w*te)) + w)) / (w*w + alpha*alpha);
-    double preFactor = (B*exp(alpha*te)*sin(w*te)*exp(epsilon*te)) / (epsilon*ta);
-    double F2_te = preFactor*(-exp(-epsilon*te)/epsilon - te*exp(-epsilon*T0));
-
-	// to generate noise
-	std::random_device rd{};
-	std::mt19937 randomNumberGenerator{ rd() };
-	// inputSample is a random number with the standard deviation
-	// 1/sqrt(12) and range limited to [-1.0, 1.0]
-	std::normal_distribution<double> normalDistribution(0.0, 1.0 / sqrt(12.0));
-	double inputSample;
+  double u1_te = (B*(exp(alpha*te)*(alpha*sin(w*te) - w*cos(w*te)) + w)) / (w*w + alpha*alpha);
+  double preFactor = (B*exp(alpha*te)*sin(w*te)*exp(epsilon*te)) / (epsilon*ta);
+  double F2_te = preFactor*(-exp(-epsilon*te)/epsilon - te*exp(-epsilon*T0));
 
-    for (i=0; i < s.N; i++)
+  for (i=0; i <= SHAPE_TABLE_LENGTH; i++)
+  {
+    t = (double)i / (double)SHAPE_TABLE_LENGTH;
+    if (t <= te)
     {
-      t = (double)i / (double)s.N;
-      if (t <= te)
-      {
-        s.x[i] = (B*(exp(alpha*t)*(alpha*sin(w*t) - w*cos(w*t)) + w)) / (w*w + alpha*alpha);
-      }
-      else
-      {
-        s.x[i] = u1_te + preFactor*(-exp(-epsilon*t)/epsilon - t*exp(-epsilon*T0)) - F2_te;
-      }
-
-	  // add noise 
-	  inputSample = 0.0;
-	  do
-	  {
-		  inputSample = normalDistribution(randomNumberGenerator);
-	  } while ((inputSample < -1.0) || (inputSample > 1.0));
-	  s.x[i] *= (1. + pow(10, -SNR / 20.) * inputSample);
+      flowTable.x[i] = (B*(exp(alpha*t)*(alpha*sin(w*t) - w*cos(w*t)) + w)) / (w*w + alpha*alpha);
+    }
+    else
+    {
+      flowTable.x[i] = u1_te + preFactor*(-exp(-epsilon*t)/epsilon - t*exp(-epsilon*T0)) - F2_te;
     }
   }
+
+  if (teIndex >= 0)
+  {
+    t = (double)teIndex / (double)SHAPE_TABLE_LENGTH;
+    flowAtTe[0] = u1_te + preFactor*(-exp(-epsilon*t)/epsilon - t*exp(-epsilon*T0)) - F2_te;
+    t = (double)(teIndex+1) / (double)SHAPE_TABLE_LENGTH;
+    flowAtTe[1] = (B*(exp(alpha*t)*(alpha*sin(w*t) - w*cos(w*t)) + w)) / (w*w + alpha*alpha);
+  }
+
+  tableOQ = OQ;
+  tableSQ = SQ;
+  tableTL = TL;
+  tablesValid = true;
 }
 
 
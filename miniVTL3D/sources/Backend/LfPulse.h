@@ -23,10 +23,16 @@
 #define __LF_PULSE_H__
 
 #include "Signal.h"
+#include <random>
 
 // ****************************************************************************
 /// This class represents the model of glottal flow introduced by Liljencrants
 /// and Fant.
+/// The pulse shape for the current parameters OQ, SQ and TL is tabulated 
+/// for a unit amplitude and a period of 1, and each pulse is resampled from 
+/// the table. The tables are only recalculated when one of these parameters
+/// changes, so that F0 and AMP can change from period to period without 
+/// solving for epsilon and alpha again.
 // ****************************************************************************
 
 class LfPulse
@@ -43,6 +49,9 @@ public:
   double TL;      // [0, 0.2] Spectral tilt
   double SNR;	  // [0.0, 50.0] Signal to noise ratio
 
+  /// Number of intervals of the tabulated pulse shapes
+  static const int SHAPE_TABLE_LENGTH = 4096;
+
   // **************************************************************************
   // Public functions.
   // **************************************************************************
@@ -57,9 +66,30 @@ public:
   // **************************************************************************
 
 private:
+  void updateShapeTables();
   double getEpsilon(double ta, double te);
   double getAlpha(double tp, double te, double ta, double epsilon);
   double getB(double AMP, double tp, double alpha);
+
+  // **************************************************************************
+  // Private data.
+  // **************************************************************************
+
+private:
+  /// Flow and flow derivative for a unit amplitude at the times 
+  /// i/SHAPE_TABLE_LENGTH, i = 0 ... SHAPE_TABLE_LENGTH
+  Signal flowTable;
+  Signal derivativeTable;
+  /// Table interval that contains te (-1 if none). As the derivative of the 
+  /// flow has a kink at te, this interval is interpolated with the 
+  /// return phase at its start ([0]) or the opening phase at its end ([1]).
+  int teIndex;
+  double flowAtTe[2];
+  double derivativeAtTe[2];
+  /// Shape parameters the tables were calculated for
+  double tableOQ, tableSQ, tableTL;
+  bool tablesValid;
+  std::mt19937 randomNumberGenerator;
 };
 
 #endif
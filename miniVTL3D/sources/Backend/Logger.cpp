@@ -0,0 +1,301 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#include "Logger.h"
+#include <cstdio>
+#include <algorithm>
+
+// maximal number of lines waiting to be written
+static const int LOG_BUFFER_CAPACITY = 100000;
+// number of lines kept in memory
+static const int LOG_NUM_RECENT_LINES = 1000;
+// default maximal size of the log file (in bytes)
+static const long LOG_MAX_FILE_SIZE = 100000000;
+// maximal number of log files kept open by the writer thread
+static const int LOG_MAX_OPEN_FILES = 64;
+
+// ****************************************************************************
+// Logger
+// ****************************************************************************
+
+// ****************************************************************************
+// Constructor.
+
+Logger::Logger() :
+  m_fileName("log.txt"),
+  m_maxFileSize(LOG_MAX_FILE_SIZE),
+  m_writing(false),
+  m_stop(false),
+  m_level(LOG_INFO)
+{
+  m_writer = thread(&Logger::writerLoop, this);
+}
+
+// ****************************************************************************
+// Destructor: write the pending lines and stop the writer thread
+
+Logger::~Logger()
+{
+  {
+    lock_guard<mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_pendingCond.notify_one();
+  m_writer.join();
+}
+
+// ****************************************************************************
+
+Logger& Logger::getInstance()
+{
+  static Logger logger;
+  return logger;
+}
+
+// ****************************************************************************
+// Set the log file of the program, the pending lines of the empty sink are 
+// written in the previous file
+
+void Logger::setFile(const string& fileName)
+{
+  flush();
+  {
+    lock_guard<mutex> lock(m_mutex);
+    m_fileName = fileName;
+  }
+}
+
+// ****************************************************************************
+
+string Logger::file()
+{
+  lock_guard<mutex> lock(m_mutex);
+  return m_fileName;
+}
+
+// ****************************************************************************
+
+void Logger::setMaxFileSize(long size)
+{
+  lock_guard<mutex> lock(m_mutex);
+  m_maxFileSize = size;
+}
+
+// ****************************************************************************
+// Add a line to the ring buffer
+
+void Logger::write(enum logLevel level, const string& line, const string& sink)
+{
+  if (!isEnabled(level)) { return; }
+
+  {
+    lock_guard<mutex> lock(m_mutex);
+    if (m_pending.size() >= LOG_BUFFER_CAPACITY)
+    {
+      m_numDropped[m_pending.front().fileName]++;
+      m_pending.pop_front();
+    }
+    m_pending.push_back({ sink.empty() ? m_fileName : sink, line });
+
+    if (m_recent.size() >= LOG_NUM_RECENT_LINES) { m_recent.pop_front(); }
+    m_recent.push_back(line);
+  }
+  m_pendingCond.notify_one();
+}
+
+// ****************************************************************************
+// Delete the content of the file of the sink and its pending lines, the 
+// lines of the other sinks are kept
+
+void Logger::clearFile(const string& sink)
+{
+  {
+    lock_guard<mutex> lock(m_mutex);
+    string fileName(sink.empty() ? m_fileName : sink);
+    m_pending.erase(remove_if(m_pending.begin(), m_pending.end(),
+      [&fileName](const logLine& line) { return line.fileName == fileName; }),
+      m_pending.end());
+    m_numDropped.erase(fileName);
+    m_truncatedFiles.insert(fileName);
+  }
+  m_pendingCond.notify_one();
+  flush();
+}
+
+// ****************************************************************************
+
+void Logger::flush()
+{
+  unique_lock<mutex> lock(m_mutex);
+  m_writtenCond.wait(lock, [this]() 
+    { return m_pending.empty() && m_truncatedFiles.empty() && !m_writing; });
+}
+
+// ****************************************************************************
+
+vector<string> Logger::recentLines()
+{
+  lock_guard<mutex> lock(m_mutex);
+  return vector<string>(m_recent.begin(), m_recent.end());
+}
+
+// ****************************************************************************
+// Loop of the writer thread: take all the pending lines at once and write 
+// them without holding the lock
+
+void Logger::writerLoop()
+{
+  deque<logLine> lines;
+  map<string, long> numDropped;
+  set<string> truncatedFiles;
+  long maxFileSize;
+
+  unique_lock<mutex> lock(m_mutex);
+  while (true)
+  {
+    m_pendingCond.wait(lock, [this]() 
+      { return m_stop || !m_truncatedFiles.empty() || !m_pending.empty(); });
+    if (m_stop && m_truncatedFiles.empty() && m_pending.empty()) { break; }
+
+    lines.swap(m_pending);
+    numDropped.swap(m_numDropped);
+    truncatedFiles.swap(m_truncatedFiles);
+    maxFileSize = m_maxFileSize;
+    m_writing = true;
+    lock.unlock();
+
+    for (auto& fileName : truncatedFiles) { openFile(fileName, true); }
+
+    for (auto& dropped : numDropped)
+    {
+      writeToFile(dropped.first, to_string(dropped.second) + 
+        " log lines dropped", maxFileSize);
+    }
+    for (auto& line : lines) { writeToFile(line.fileName, line.text, maxFileSize); }
+    for (auto& file : m_files) { file.second.stream.flush(); }
+    lines.clear();
+    numDropped.clear();
+    truncatedFiles.clear();
+
+    lock.lock();
+    m_writing = false;
+    m_writtenCond.notify_all();
+  }
+
+  m_files.clear();
+}
+
+// ****************************************************************************
+// Open a log file for appending (or truncate it), the files which are open
+// are closed if there are too many of them
+
+Logger::logFile& Logger::openFile(const string& fileName, bool truncate)
+{
+  auto it(m_files.find(fileName));
+  if ((it != m_files.end()) && !truncate) { return it->second; }
+
+  if (it != m_files.end()) { m_files.erase(it); }
+  else if (m_files.size() >= LOG_MAX_OPEN_FILES) { m_files.clear(); }
+
+  logFile& file(m_files[fileName]);
+  file.stream.open(fileName, truncate ? (ofstream::out | ofstream::trunc)
+    : (ofstream::out | ofstream::app));
+  file.size = file.stream.is_open() ? (long)file.stream.tellp() : 0;
+  return file;
+}
+
+// ****************************************************************************
+// Write a line in a file and rotate the file if it is too large
+
+void Logger::writeToFile(const string& fileName, const string& line, 
+  long maxFileSize)
+{
+  logFile& file(openFile(fileName, false));
+  if (!file.stream.is_open()) { return; }
+
+  if ((maxFileSize > 0) && (file.size + (long)line.size() + 1 > maxFileSize))
+  {
+    file.stream.close();
+    string oldFile(fileName + ".old");
+    remove(oldFile.c_str());
+    rename(fileName.c_str(), oldFile.c_str());
+    file.stream.open(fileName, ofstream::out | ofstream::trunc);
+    file.size = 0;
+  }
+
+  file.stream << line << '\n';
+  file.size += line.size() + 1;
+}
+
+// ****************************************************************************
+// LogStream
+// ****************************************************************************
+
+// ****************************************************************************
+// Constructors.
+
+LogStream::LogStream(enum logLevel level) :
+  ostream(NULL),
+  m_buffer("", level)
+{
+  rdbuf(&m_buffer);
+  if (!Logger::getInstance().isEnabled(level)) { setstate(ios::badbit); }
+}
+
+// ****************************************************************************
+
+LogStream::LogStream(const string& sink, enum logLevel level) :
+  ostream(NULL),
+  m_buffer(sink, level)
+{
+  rdbuf(&m_buffer);
+  if (!Logger::getInstance().isEnabled(level)) { setstate(ios::badbit); }
+}
+
+// ****************************************************************************
+// Destructor: send the last line if it has not been terminated
+
+LogStream::~LogStream()
+{
+  m_buffer.pubsync();
+}
+
+// ****************************************************************************
+// Send the complete lines of the buffer to the logger
+
+int LogStream::LogBuffer::sync()
+{
+  string text(str());
+  size_t start(0), end;
+
+  while ((end = text.find('\n', start)) != string::npos)
+  {
+    Logger::getInstance().write(m_level, text.substr(start, end - start), m_sink);
+    start = end + 1;
+  }
+  // a text without end of line is sent when the stream is destroyed or flushed
+  if (start < text.size())
+  {
+    Logger::getInstance().write(m_level, text.substr(start), m_sink);
+  }
+  str("");
+  return 0;
+}
@@ -0,0 +1,159 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#ifndef __LOGGER_H__
+#define __LOGGER_H__
+
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <deque>
+#include <vector>
+#include <map>
+#include <set>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+using namespace std;
+
+// ****************************************************************************
+// Levels of the log messages. A message is written if its level is lower
+// or equal to the level of the logger, LOG_NONE turns off the log.
+// ****************************************************************************
+
+enum logLevel {
+  LOG_NONE,
+  LOG_ERROR,
+  LOG_INFO,
+  LOG_DEBUG
+};
+
+// ****************************************************************************
+// Log of the simulations shared by the whole program.
+// The lines are stored in a bounded ring buffer and written to the log files 
+// by a background thread which keeps the files open, so that writing a line 
+// does not cost any system call. Each line goes to the file of its sink: the
+// file of the simulation which writes it, or the log file of the program if 
+// the sink is empty, so that simulations running at the same time keep 
+// separate logs. If the buffer is full, the oldest pending lines are dropped 
+// and their number is reported in their file. The files are rotated (renamed
+// with the extension .old) when they exceed a maximal size.
+// ****************************************************************************
+
+class Logger
+{
+public:
+
+  static Logger& getInstance();
+  ~Logger();
+
+  // log file of the program, used by the empty sink
+  void setFile(const string& fileName);
+  string file();
+  void setLevel(enum logLevel level) { m_level = level; }
+  enum logLevel level() const { return (enum logLevel)m_level.load(); }
+  bool isEnabled(enum logLevel level) const
+    { return (level != LOG_NONE) && (level <= m_level); }
+  // maximal size of the log file in bytes (0 for no limit)
+  void setMaxFileSize(long size);
+
+  void write(enum logLevel level, const string& line, const string& sink = "");
+  // delete the content of the log file of the sink, the other files are kept
+  void clearFile(const string& sink = "");
+  // wait until all the pending lines are written in the file
+  void flush();
+  // last lines written (kept in memory even if the file is not written)
+  vector<string> recentLines();
+
+private:
+
+  Logger();
+  struct logLine
+  {
+    string fileName;
+    string text;
+  };
+
+  struct logFile
+  {
+    ofstream stream;
+    long size;
+  };
+
+  void writerLoop();
+  logFile& openFile(const string& fileName, bool truncate);
+  void writeToFile(const string& fileName, const string& line, long maxFileSize);
+
+  mutex m_mutex;
+  condition_variable m_pendingCond;
+  condition_variable m_writtenCond;
+  deque<logLine> m_pending;
+  deque<string> m_recent;
+  map<string, long> m_numDropped;
+  set<string> m_truncatedFiles;
+  string m_fileName;
+  long m_maxFileSize;
+  bool m_writing;
+  bool m_stop;
+  atomic<int> m_level;
+
+  // only accessed by the writer thread
+  map<string, logFile> m_files;
+
+  thread m_writer;
+};
+
+// ****************************************************************************
+// Output stream sending each line (terminated by endl or flush) to the 
+// logger. It can replace an ofstream opened on the log file. The sink is the
+// log file of the simulation owning the stream (empty for the log file of 
+// the program). If the level is disabled the stream is in a failed state so 
+// that nothing is formatted.
+// ****************************************************************************
+
+class LogStream : public ostream
+{
+public:
+
+  LogStream(enum logLevel level = LOG_INFO);
+  LogStream(const string& sink, enum logLevel level = LOG_INFO);
+  ~LogStream();
+  void close() { flush(); }
+
+private:
+
+  class LogBuffer : public stringbuf
+  {
+  public:
+    LogBuffer(const string& sink, enum logLevel level) : 
+      m_sink(sink), m_level(level) {}
+    virtual int sync();
+  private:
+    string m_sink;
+    enum logLevel m_level;
+  };
+
+  LogBuffer m_buffer;
+};
+
+#endif
@@ -0,0 +1,244 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#include "MeshFile.h"
+#include <cstdarg>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+
+// size of the buffer written to the file at once
+static const size_t BUFFER_SIZE = 1 << 20;
+
+// ****************************************************************************
+// ****************************************************************************
+
+BufferedTextFile::BufferedTextFile() : m_file(NULL), m_position(0), 
+  m_failed(false)
+{
+}
+
+// ****************************************************************************
+
+BufferedTextFile::~BufferedTextFile()
+{
+  close();
+}
+
+// ****************************************************************************
+
+bool BufferedTextFile::open(const string& fileName, bool binary)
+{
+  close();
+  // the text files are opened in text mode like the streams (the line ends
+  // are converted on Windows), position() and writeAt() count bytes so they
+  // are meant for the binary files
+  m_file = fopen(fileName.c_str(), binary ? "wb" : "w");
+  m_buffer.clear();
+  m_buffer.reserve(BUFFER_SIZE + 1024);
+  m_position = 0;
+  m_failed = false;
+  return (m_file != NULL);
+}
+
+// ****************************************************************************
+
+void BufferedTextFile::print(const char* format, ...)
+{
+  if (m_file == NULL) { return; }
+
+  char line[512];
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(line, sizeof(line), format, args);
+  va_end(args);
+
+  if (length < 0) 
+  { 
+    m_failed = true;
+    return; 
+  }
+
+  if (length < (int)sizeof(line))
+  {
+    write(line, length);
+  }
+  else
+  {
+    // long line: format it again in a buffer of the right size
+    string longLine(length + 1, '\0');
+    va_start(args, format);
+    vsnprintf(&longLine[0], longLine.size(), format, args);
+    va_end(args);
+    write(longLine.data(), length);
+  }
+}
+
+// ****************************************************************************
+
+void BufferedTextFile::write(const void* data, size_t numBytes)
+{
+  if (m_file == NULL) { return; }
+
+  m_buffer.append((const char*)data, numBytes);
+  m_position += (long)numBytes;
+  if (m_buffer.size() >= BUFFER_SIZE) { flush(); }
+}
+
+// ****************************************************************************
+
+void BufferedTextFile::flush()
+{
+  if ((m_file != NULL) && (!m_buffer.empty()))
+  {
+    if (fwrite(m_buffer.data(), 1, m_buffer.size(), m_file) != m_buffer.size())
+    {
+      m_failed = true;
+    }
+    m_buffer.clear();
+  }
+}
+
+// ****************************************************************************
+
+bool BufferedTextFile::writeAt(long position, const void* data, size_t numBytes)
+{
+  if (m_file == NULL) { return false; }
+
+  flush();
+  if ((fseek(m_file, position, SEEK_SET) != 0) ||
+    (fwrite(data, 1, numBytes, m_file) != numBytes) ||
+    (fseek(m_file, 0, SEEK_END) != 0))
+  {
+    m_failed = true;
+  }
+  return !m_failed;
+}
+
+// ****************************************************************************
+
+bool BufferedTextFile::close()
+{
+  if (m_file == NULL) { return false; }
+
+  flush();
+  if (fclose(m_file) != 0) { m_failed = true; }
+  m_file = NULL;
+  m_buffer.clear();
+  m_buffer.shrink_to_fit();
+
+  return !m_failed;
+}
+
+// ****************************************************************************
+// ****************************************************************************
+
+StlFileWriter::StlFileWriter() : m_binary(false), m_numTriangles(0)
+{
+}
+
+// ****************************************************************************
+
+bool StlFileWriter::open(const string& fileName, const string& solidName, 
+  bool binary)
+{
+  m_binary = binary;
+  m_numTriangles = 0;
+
+  if (!m_file.open(fileName, m_binary)) { return false; }
+
+  if (m_binary)
+  {
+    // 80 bytes header (which must not begin with "solid") and the number
+    // of triangles, set when the file is closed
+    char header[80];
+    memset(header, 0, sizeof(header));
+    string title("binary STL " + solidName);
+    memcpy(header, title.data(), min(title.size(), sizeof(header)));
+    m_file.write(header, sizeof(header));
+
+    uint32_t numTriangles(0);
+    m_file.write(&numTriangles, sizeof(numTriangles));
+  }
+  else
+  {
+    m_file.print("solid %s\n", solidName.c_str());
+  }
+
+  return true;
+}
+
+// ****************************************************************************
+// Add a triangle. The ASCII files have the same text as 
+// Triangle3D::stringSTLformat(), the binary files have the unit normal.
+
+void StlFileWriter::addTriangle(const Triangle3D& triangle)
+{
+  Point3D normal(triangle.getNormal());
+  Point3D P[3] = { triangle.getPoint(0), triangle.getPoint(1), 
+    triangle.getPoint(2) };
+
+  if (m_binary)
+  {
+    // little endian floats, like all the platforms the program runs on
+    float values[12];
+    double length(normal.magnitude());
+    if (length > 0.) { normal = normal * (1. / length); }
+
+    values[0] = (float)normal.x;
+    values[1] = (float)normal.y;
+    values[2] = (float)normal.z;
+    for (int i(0); i < 3; i++)
+    {
+      values[3 + 3 * i] = (float)P[i].x;
+      values[4 + 3 * i] = (float)P[i].y;
+      values[5 + 3 * i] = (float)P[i].z;
+    }
+    uint16_t attributes(0);
+    m_file.write(values, sizeof(values));
+    m_file.write(&attributes, sizeof(attributes));
+  }
+  else
+  {
+    m_file.print("facet normal %e %e %e\n\touter loop\n"
+      "\tvertex %e %e %e\n\tvertex %e %e %e\n\tvertex %e %e %e\n"
+      "\tendloop\nendfacet\n",
+      normal.x, normal.y, normal.z,
+      P[0].x, P[0].y, P[0].z, P[1].x, P[1].y, P[1].z, P[2].x, P[2].y, P[2].z);
+  }
+
+  m_numTriangles++;
+}
+
+// ****************************************************************************
+
+bool StlFileWriter::close()
+{
+  if (!m_file.isOpen()) { return false; }
+
+  if (m_binary)
+  {
+    uint32_t numTriangles((uint32_t)m_numTriangles);
+    m_file.writeAt(80, &numTriangles, sizeof(numTriangles));
+  }
+
+  return m_file.close();
+}
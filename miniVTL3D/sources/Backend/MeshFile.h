@@ -0,0 +1,100 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#ifndef __MESH_FILE_H__
+#define __MESH_FILE_H__
+
+#include "Geometry.h"
+#include <string>
+#include <cstdio>
+
+using namespace std;
+
+// ****************************************************************************
+// Buffered writers for the mesh files of the vocal tract surfaces. 
+//
+// BufferedTextFile formats the lines with printf-like format strings into a
+// large buffer, which is written to the file by blocks. "%g" gives the same 
+// text as the default formatting of a double in an ostream, so that the 
+// files are the same as the ones written with streams, without the cost of
+// the stream formatting and of flushing each line with endl.
+//
+// StlFileWriter writes triangles in the ASCII or in the binary STL format.
+// The number of triangles of a binary file is set when it is closed.
+// ****************************************************************************
+
+class BufferedTextFile
+{
+public:
+
+  BufferedTextFile();
+  ~BufferedTextFile();
+
+  bool open(const string& fileName, bool binary = false);
+  bool isOpen() const { return m_file != NULL; }
+  // formatted text like printf
+  void print(const char* format, ...);
+  void write(const void* data, size_t numBytes);
+  // flush the buffer and close the file; returns false if writing failed
+  bool close();
+
+  // position in the file after the buffered data
+  long position() const { return m_position; }
+  // write data at a position already written (flushes the buffer)
+  bool writeAt(long position, const void* data, size_t numBytes);
+
+private:
+
+  // not copyable since it owns the file
+  BufferedTextFile(const BufferedTextFile&);
+  BufferedTextFile& operator=(const BufferedTextFile&);
+
+  void flush();
+
+  FILE* m_file;
+  string m_buffer;
+  long m_position;
+  bool m_failed;
+};
+
+// ****************************************************************************
+
+class StlFileWriter
+{
+public:
+
+  StlFileWriter();
+
+  // solidName is the name in the ASCII header, or in the 80 bytes header 
+  // of a binary file
+  bool open(const string& fileName, const string& solidName, bool binary);
+  void addTriangle(const Triangle3D& triangle);
+  int numTriangles() const { return m_numTriangles; }
+  bool close();
+
+private:
+
+  BufferedTextFile m_file;
+  bool m_binary;
+  int m_numTriangles;
+};
+
+#endif
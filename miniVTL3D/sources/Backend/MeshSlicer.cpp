@@ -0,0 +1,786 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#include "MeshSlicer.h"
+#include "ParallelLoop.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+
+// maximal number of triangles of a leaf of the hierarchy
+static const int LEAF_SIZE = 8;
+// two successive contour points closer than this are merged (cm)
+static const double MINIMAL_POINT_DISTANCE = 1e-9;
+
+// ****************************************************************************
+// Signed area, centroid and inclusion of the origin of a closed contour
+
+static double signedArea(const vector<Point2D>& contour)
+{
+  double area(0.);
+  for (int i(0); i < (int)contour.size(); i++)
+  {
+    const Point2D& A(contour[i]);
+    const Point2D& B(contour[(i + 1) % contour.size()]);
+    area += A.x * B.y - B.x * A.y;
+  }
+  return area / 2.;
+}
+
+// ****************************************************************************
+
+static Point2D centroid(const vector<Point2D>& contour)
+{
+  double area(signedArea(contour));
+  Point2D C(0., 0.);
+  if (area == 0.) { return C; }
+
+  for (int i(0); i < (int)contour.size(); i++)
+  {
+    const Point2D& A(contour[i]);
+    const Point2D& B(contour[(i + 1) % contour.size()]);
+    double cross(A.x * B.y - B.x * A.y);
+    C.x += (A.x + B.x) * cross;
+    C.y += (A.y + B.y) * cross;
+  }
+  return C * (1. / (6. * area));
+}
+
+// ****************************************************************************
+
+static bool containsOrigin(const vector<Point2D>& contour)
+{
+  bool inside(false);
+  for (int i(0), j((int)contour.size() - 1); i < (int)contour.size(); j = i++)
+  {
+    const Point2D& A(contour[i]);
+    const Point2D& B(contour[j]);
+    if (((A.y > 0.) != (B.y > 0.)) && (0. < (B.x - A.x) * (0. - A.y) / (B.y - A.y) + A.x))
+    {
+      inside = !inside;
+    }
+  }
+  return inside;
+}
+
+// ****************************************************************************
+
+static bool boxContainsOrigin(const vector<Point2D>& contour)
+{
+  double minX(contour[0].x), maxX(minX), minY(contour[0].y), maxY(minY);
+  for (const Point2D& P : contour)
+  {
+    minX = min(minX, P.x);
+    maxX = max(maxX, P.x);
+    minY = min(minY, P.y);
+    maxY = max(maxY, P.y);
+  }
+  return ((minX <= 0.) && (maxX >= 0.) && (minY <= 0.) && (maxY >= 0.));
+}
+
+// ****************************************************************************
+// ****************************************************************************
+
+bool isStlFile(const string& fileName)
+{
+  if (fileName.size() < 4) { return false; }
+
+  string extension(fileName.substr(fileName.size() - 4));
+  transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+  return (extension == ".stl");
+}
+
+// ****************************************************************************
+// ****************************************************************************
+
+size_t point3DHash::operator()(const Point3D& P) const
+{
+  hash<double> h;
+  size_t seed(h(P.x));
+  seed ^= h(P.y) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+  seed ^= h(P.z) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+  return seed;
+}
+
+// ****************************************************************************
+// ****************************************************************************
+
+TriangleMesh::TriangleMesh()
+{
+}
+
+// ****************************************************************************
+
+void TriangleMesh::clear()
+{
+  m_vertices.clear();
+  m_triangles.clear();
+  m_vertexIdx.clear();
+}
+
+// ****************************************************************************
+
+int TriangleMesh::addVertex(const Point3D& P)
+{
+  auto it = m_vertexIdx.find(P);
+  if (it != m_vertexIdx.end()) { return it->second; }
+
+  m_vertices.push_back(P);
+  m_vertexIdx[P] = (int)m_vertices.size() - 1;
+  return (int)m_vertices.size() - 1;
+}
+
+// ****************************************************************************
+
+void TriangleMesh::addTriangle(const Point3D& A, const Point3D& B, 
+  const Point3D& C)
+{
+  int idx[3] = { addVertex(A), addVertex(B), addVertex(C) };
+
+  // the degenerated triangles do not cross any plane
+  if ((idx[0] == idx[1]) || (idx[1] == idx[2]) || (idx[0] == idx[2])) 
+  { 
+    return; 
+  }
+  m_triangles.insert(m_triangles.end(), idx, idx + 3);
+}
+
+// ****************************************************************************
+// The vertices stay merged since the transformation is the same for all.
+
+void TriangleMesh::transform(double scale, int lateralAxis)
+{
+  m_vertexIdx.clear();
+  for (int i(0); i < (int)m_vertices.size(); i++)
+  {
+    Point3D& P(m_vertices[i]);
+    switch (lateralAxis)
+    {
+    case 0: P.set(P.y, P.z, P.x); break;
+    case 1: P.set(P.z, P.x, P.y); break;
+    default: break;
+    }
+    P *= scale;
+    m_vertexIdx[P] = i;
+  }
+}
+
+// ****************************************************************************
+
+void TriangleMesh::boundingBox(Point3D& minCorner, Point3D& maxCorner) const
+{
+  minCorner.set(0., 0., 0.);
+  maxCorner.set(0., 0., 0.);
+  if (m_vertices.empty()) { return; }
+
+  minCorner = maxCorner = m_vertices[0];
+  for (const Point3D& P : m_vertices)
+  {
+    minCorner.set(min(minCorner.x, P.x), min(minCorner.y, P.y), min(minCorner.z, P.z));
+    maxCorner.set(max(maxCorner.x, P.x), max(maxCorner.y, P.y), max(maxCorner.z, P.z));
+  }
+}
+
+// ****************************************************************************
+// Read an STL file. It is binary if its size matches the number of triangles
+// of the header (some binary files begin with "solid" too), otherwise it is
+// read as an ASCII file.
+
+bool TriangleMesh::readStl(const string& fileName, string& error)
+{
+  clear();
+
+  ifstream file(fileName, ios::binary);
+  if (!file.is_open())
+  {
+    error = "Cannot open " + fileName;
+    return false;
+  }
+  string data((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+  file.close();
+
+  uint32_t numBinaryTriangles(0);
+  if (data.size() >= 84) 
+  { 
+    memcpy(&numBinaryTriangles, &data[80], sizeof(numBinaryTriangles)); 
+  }
+
+  if ((data.size() >= 84) && (data.size() == 84 + 50 * (size_t)numBinaryTriangles))
+  {
+    float values[12];
+    for (uint32_t t(0); t < numBinaryTriangles; t++)
+    {
+      // normal and 3 vertices, followed by 2 bytes of attributes
+      memcpy(values, &data[84 + 50 * (size_t)t], sizeof(values));
+      addTriangle(Point3D(values[3], values[4], values[5]),
+        Point3D(values[6], values[7], values[8]),
+        Point3D(values[9], values[10], values[11]));
+    }
+  }
+  else
+  {
+    // the vertices are read 3 by 3 whatever the facet structure
+    Point3D P[3];
+    int numPoints(0);
+    const char* text(data.c_str());
+    const char* pos(strstr(text, "vertex"));
+    char* end;
+
+    while (pos != NULL)
+    {
+      pos += 6;
+      double x(strtod(pos, &end));
+      double y(strtod(end, &end));
+      double z(strtod(end, &end));
+      if (end == pos) 
+      { 
+        error = "Invalid vertex in " + fileName;
+        clear();
+        return false;
+      }
+      P[numPoints++].set(x, y, z);
+      if (numPoints == 3)
+      {
+        addTriangle(P[0], P[1], P[2]);
+        numPoints = 0;
+      }
+      pos = strstr(end, "vertex");
+    }
+  }
+
+  if (numTriangles() == 0)
+  {
+    error = "No triangle in " + fileName;
+    return false;
+  }
+  return true;
+}
+
+// ****************************************************************************
+// ****************************************************************************
+
+MeshSlicer::MeshSlicer(const TriangleMesh& mesh, double maxGap) : m_mesh(mesh),
+  m_maxGap(maxGap)
+{
+  int numTriangles(mesh.numTriangles());
+  vector<Point3D> centers(numTriangles);
+
+  for (int t(0); t < numTriangles; t++)
+  {
+    m_order.push_back(t);
+    centers[t] = (mesh.vertex(mesh.triangleVertex(t, 0)) + 
+      mesh.vertex(mesh.triangleVertex(t, 1)) + 
+      mesh.vertex(mesh.triangleVertex(t, 2))) / 3.;
+  }
+
+  m_nodes.reserve(2 * numTriangles / LEAF_SIZE + 1);
+  if (numTriangles > 0) { buildNode(0, numTriangles, centers); }
+
+  Point3D minCorner, maxCorner;
+  mesh.boundingBox(minCorner, maxCorner);
+  m_lateralCenter = (minCorner.z + maxCorner.z) / 2.;
+}
+
+// ****************************************************************************
+// Build the node of the triangles m_order[first ... first + count - 1], 
+// splitting them at the median of the longest axis of the box of their 
+// centers. Returns the index of the node.
+
+int MeshSlicer::buildNode(int first, int count, vector<Point3D>& centers)
+{
+  int idx((int)m_nodes.size());
+  m_nodes.push_back(bvhNode());
+
+  Point3D minCorner(m_mesh.vertex(m_mesh.triangleVertex(m_order[first], 0)));
+  Point3D maxCorner(minCorner);
+  Point3D minCenter(centers[m_order[first]]), maxCenter(minCenter);
+  for (int i(first); i < first + count; i++)
+  {
+    for (int j(0); j < 3; j++)
+    {
+      const Point3D& P(m_mesh.vertex(m_mesh.triangleVertex(m_order[i], j)));
+      minCorner.set(min(minCorner.x, P.x), min(minCorner.y, P.y), min(minCorner.z, P.z));
+      maxCorner.set(max(maxCorner.x, P.x), max(maxCorner.y, P.y), max(maxCorner.z, P.z));
+    }
+    const Point3D& C(centers[m_order[i]]);
+    minCenter.set(min(minCenter.x, C.x), min(minCenter.y, C.y), min(minCenter.z, C.z));
+    maxCenter.set(max(maxCenter.x, C.x), max(maxCenter.y, C.y), max(maxCenter.z, C.z));
+  }
+  m_nodes[idx].minCorner = minCorner;
+  m_nodes[idx].maxCorner = maxCorner;
+  m_nodes[idx].first = first;
+  m_nodes[idx].count = count;
+  m_nodes[idx].left = -1;
+  m_nodes[idx].right = -1;
+
+  if (count <= LEAF_SIZE) { return idx; }
+
+  // split along the longest axis
+  Point3D extent(maxCenter - minCenter);
+  int axis((extent.x >= extent.y) && (extent.x >= extent.z) ? 0 : 
+    (extent.y >= extent.z ? 1 : 2));
+  auto coord = [axis](const Point3D& P) 
+    { return (axis == 0 ? P.x : (axis == 1 ? P.y : P.z)); };
+  int half(count / 2);
+  nth_element(m_order.begin() + first, m_order.begin() + first + half,
+    m_order.begin() + first + count, [&](int a, int b) 
+    { return coord(centers[a]) < coord(centers[b]); });
+
+  int left(buildNode(first, half, centers));
+  int right(buildNode(first + half, count - half, centers));
+  m_nodes[idx].left = left;
+  m_nodes[idx].right = right;
+
+  return idx;
+}
+
+// ****************************************************************************
+// Intersect the plane with the triangles of the boxes it crosses, then chain
+// the segments into contours through the edges they cross. The intersection 
+// point of an edge is computed from its vertex of smallest index, so that 
+// the two triangles of the edge give exactly the same point. The open 
+// chains (at the holes of the mesh) are dropped.
+
+void MeshSlicer::slice(Point2D P, Point2D N, vector<vector<Point2D>>& contours) const
+{
+  contours.clear();
+  if (m_nodes.empty()) { return; }
+
+  N.normalize();
+  // normal of the plane: tangent to the centerline
+  Point2D T(N.y, -N.x);
+  auto distance = [&](const Point3D& Q) { return (Q.x - P.x) * T.x + (Q.y - P.y) * T.y; };
+
+  // segments between two crossed edges, the edges being given by their 
+  // vertex indexes (smallest first)
+  vector<array<int, 4>> segments;
+
+  vector<int> stack(1, 0);
+  while (!stack.empty())
+  {
+    const bvhNode& node(m_nodes[stack.back()]);
+    stack.pop_back();
+
+    // skip the boxes which do not cross the plane
+    double center(distance((node.minCorner + node.maxCorner) / 2.));
+    double radius((abs(T.x) * (node.maxCorner.x - node.minCorner.x) + 
+      abs(T.y) * (node.maxCorner.y - node.minCorner.y)) / 2.);
+    if (abs(center) > radius) { continue; }
+
+    if (node.left >= 0)
+    {
+      stack.push_back(node.left);
+      stack.push_back(node.right);
+      continue;
+    }
+
+    for (int i(node.first); i < node.first + node.count; i++)
+    {
+      int t(m_order[i]);
+      int v[3];
+      bool positive[3];
+      for (int j(0); j < 3; j++)
+      {
+        v[j] = m_mesh.triangleVertex(t, j);
+        // the points on the plane are on the positive side
+        positive[j] = (distance(m_mesh.vertex(v[j])) >= 0.);
+      }
+      if ((positive[0] == positive[1]) && (positive[1] == positive[2])) { continue; }
+
+      array<int, 4> seg;
+      int numEdges(0);
+      for (int j(0); j < 3; j++)
+      {
+        int a(v[j]), b(v[(j + 1) % 3]);
+        if (positive[j] != positive[(j + 1) % 3])
+        {
+          seg[2 * numEdges] = min(a, b);
+          seg[2 * numEdges + 1] = max(a, b);
+          numEdges++;
+        }
+      }
+      segments.push_back(seg);
+    }
+  }
+
+  //*********************************************************
+  // chain the segments through their edges
+  //*********************************************************
+
+  auto edgeKey = [&](int a, int b) 
+    { return (uint64_t)a * (uint64_t)m_mesh.numVertices() + (uint64_t)b; };
+  // segments of each edge (a closed manifold mesh has 2 per edge)
+  unordered_map<uint64_t, pair<int, int>> edgeSegments;
+  edgeSegments.reserve(2 * segments.size());
+  for (int s(0); s < (int)segments.size(); s++)
+  {
+    for (int e(0); e < 2; e++)
+    {
+      auto it = edgeSegments.insert(make_pair(edgeKey(segments[s][2 * e], 
+        segments[s][2 * e + 1]), make_pair(s, -1)));
+      if (!it.second) { it.first->second.second = s; }
+    }
+  }
+
+  auto edgePoint = [&](int a, int b)
+  {
+    double da(distance(m_mesh.vertex(a))), db(distance(m_mesh.vertex(b)));
+    Point3D Q(m_mesh.vertex(a) + (m_mesh.vertex(b) - m_mesh.vertex(a)) * (da / (da - db)));
+    // coordinates in the section
+    return Point2D(Q.z - m_lateralCenter, (Q.x - P.x) * N.x + (Q.y - P.y) * N.y);
+  };
+
+  vector<bool> used(segments.size(), false);
+
+  // add the points of the edges from the edge e of the segment s until the 
+  // chain comes back to the other edge of s (returns true) or ends
+  auto walk = [&](int s, int e, vector<Point2D>& points)
+  {
+    uint64_t startKey(edgeKey(segments[s][2 * (1 - e)], segments[s][3 - 2 * e]));
+    while (true)
+    {
+      used[s] = true;
+      int a(segments[s][2 * e]), b(segments[s][2 * e + 1]);
+      points.push_back(edgePoint(a, b));
+      uint64_t key(edgeKey(a, b));
+      if (key == startKey) { return true; }
+
+      const pair<int, int>& adjacent(edgeSegments[key]);
+      int next(adjacent.first == s ? adjacent.second : adjacent.first);
+      if ((next < 0) || used[next]) { return false; }
+      // continue with the other edge of the next segment
+      e = (edgeKey(segments[next][0], segments[next][1]) == key ? 1 : 0);
+      s = next;
+    }
+  };
+
+  vector<vector<Point2D>> closedChains, openChains;
+  vector<Point2D> forward, backward;
+  for (int s0(0); s0 < (int)segments.size(); s0++)
+  {
+    if (used[s0]) { continue; }
+
+    forward.clear();
+    if (walk(s0, 1, forward)) 
+    { 
+      closedChains.push_back(forward); 
+      continue;
+    }
+    // the chain is open: add its part before s0
+    backward.clear();
+    walk(s0, 0, backward);
+    reverse(backward.begin(), backward.end());
+    backward.insert(backward.end(), forward.begin(), forward.end());
+    openChains.push_back(backward);
+  }
+
+  //*********************************************************
+  // join the open chains (e.g. at the missing triangles of a 
+  // mesh which is not watertight) when the gaps between their 
+  // ends are smaller than the maximal gap
+  //*********************************************************
+
+  auto gap = [](const Point2D& A, const Point2D& B) 
+    { return sqrt((A.x - B.x) * (A.x - B.x) + (A.y - B.y) * (A.y - B.y)); };
+  while (!openChains.empty())
+  {
+    vector<Point2D> chain(openChains.back());
+    openChains.pop_back();
+    while (true)
+    {
+      // closing the chain itself, or appending another chain in its 
+      // direction (1) or reversed (2)
+      double minGap(chain.size() >= 3 ? gap(chain.back(), chain.front()) : HUGE_VAL);
+      int best(-1), join(0);
+      for (int j(0); j < (int)openChains.size(); j++)
+      {
+        if (gap(chain.back(), openChains[j].front()) < minGap)
+        {
+          minGap = gap(chain.back(), openChains[j].front());
+          best = j;
+          join = 1;
+        }
+        if (gap(chain.back(), openChains[j].back()) < minGap)
+        {
+          minGap = gap(chain.back(), openChains[j].back());
+          best = j;
+          join = 2;
+        }
+      }
+      if (minGap > m_maxGap) { break; }
+      if (join == 0)
+      {
+        closedChains.push_back(chain);
+        break;
+      }
+      if (join == 2) { reverse(openChains[best].begin(), openChains[best].end()); }
+      chain.insert(chain.end(), openChains[best].begin(), openChains[best].end());
+      openChains.erase(openChains.begin() + best);
+    }
+  }
+
+  for (auto& contour : closedChains)
+  {
+    // remove the duplicated points of the vertices lying on the plane
+    vector<Point2D> cleaned;
+    for (const Point2D& Q : contour)
+    {
+      if (cleaned.empty() || (abs(Q.x - cleaned.back().x) + 
+        abs(Q.y - cleaned.back().y) > MINIMAL_POINT_DISTANCE))
+      {
+        cleaned.push_back(Q);
+      }
+    }
+    while ((cleaned.size() > 1) && (abs(cleaned[0].x - cleaned.back().x) + 
+      abs(cleaned[0].y - cleaned.back().y) <= MINIMAL_POINT_DISTANCE))
+    {
+      cleaned.pop_back();
+    }
+    if (cleaned.size() < 3) { continue; }
+
+    if (signedArea(cleaned) < 0.) { reverse(cleaned.begin(), cleaned.end()); }
+    contours.push_back(cleaned);
+  }
+}
+
+// ****************************************************************************
+
+bool MeshSlicer::sectionContour(Point2D P, Point2D N, vector<Point2D>& contour) const
+{
+  vector<vector<Point2D>> contours;
+  double minArea(0.);
+  int idx(-1);
+
+  contour.clear();
+  slice(P, N, contours);
+  for (int i(0); i < (int)contours.size(); i++)
+  {
+    double area(signedArea(contours[i]));
+    if (containsOrigin(contours[i]) && ((idx < 0) || (area < minArea)))
+    {
+      idx = i;
+      minArea = area;
+    }
+  }
+
+  // if the point is on a wall splitting the lumen (e.g. the epiglottis), 
+  // take the largest contour whose bounding box contains it
+  bool around(idx >= 0);
+  double maxArea(0.);
+  for (int i(0); !around && (i < (int)contours.size()); i++)
+  {
+    double area(signedArea(contours[i]));
+    if (boxContainsOrigin(contours[i]) && (area > maxArea))
+    {
+      idx = i;
+      maxArea = area;
+    }
+  }
+  if (idx < 0) { return false; }
+
+  contour = contours[idx];
+  return true;
+}
+
+// ****************************************************************************
+// If no direction is given, the centerline begins at an open end of the 
+// mesh: the lowest group of boundary edges (edges of a single triangle). A 
+// closed mesh (e.g. a pipe with walls of finite thickness) begins at the end
+// of the longest axis of its bounding box in the sagittal plane which has 
+// the smallest coordinate.
+
+void MeshSlicer::initialPosition(const struct meshSlicingOptions& options, 
+  Point2D& P, Point2D& T) const
+{
+  if ((options.direction.x != 0.) || (options.direction.y != 0.))
+  {
+    P = options.start;
+    T = options.direction;
+    T.normalize();
+    return;
+  }
+
+  Point3D minCorner, maxCorner;
+  m_mesh.boundingBox(minCorner, maxCorner);
+  Point2D meshCenter((minCorner.x + maxCorner.x) / 2., (minCorner.y + maxCorner.y) / 2.);
+
+  //*********************************************************
+  // group the boundary edges by connected vertices
+  //*********************************************************
+
+  unordered_map<uint64_t, int> edgeCount;
+  auto edgeKey = [&](int a, int b) 
+    { return (uint64_t)min(a, b) * (uint64_t)m_mesh.numVertices() + (uint64_t)max(a, b); };
+  for (int t(0); t < m_mesh.numTriangles(); t++)
+  {
+    for (int j(0); j < 3; j++)
+    {
+      edgeCount[edgeKey(m_mesh.triangleVertex(t, j), m_mesh.triangleVertex(t, (j + 1) % 3))]++;
+    }
+  }
+
+  vector<int> group(m_mesh.numVertices(), -1);
+  function<int(int)> root = [&](int v) 
+    { return (group[v] == v ? v : (group[v] = root(group[v]))); };
+  for (auto& edge : edgeCount)
+  {
+    if (edge.second != 1) { continue; }
+    int a((int)(edge.first / m_mesh.numVertices()));
+    int b((int)(edge.first % m_mesh.numVertices()));
+    if (group[a] < 0) { group[a] = a; }
+    if (group[b] < 0) { group[b] = b; }
+    group[root(a)] = root(b);
+  }
+
+  // sums of the coordinates of each group of boundary vertices 
+  // (number, x, y, x^2, xy, y^2)
+  unordered_map<int, array<double, 6>> ends;
+  for (int v(0); v < m_mesh.numVertices(); v++)
+  {
+    if (group[v] < 0) { continue; }
+    double x(m_mesh.vertex(v).x), y(m_mesh.vertex(v).y);
+    array<double, 6> values = { { 1., x, y, x * x, x * y, y * y } };
+    auto it = ends.find(root(v));
+    if (it == ends.end()) 
+    { 
+      ends[root(v)] = values; 
+    }
+    else
+    {
+      for (int k(0); k < 6; k++) { it->second[k] += values[k]; }
+    }
+  }
+
+  if (!ends.empty())
+  {
+    const array<double, 6>* lowest(NULL);
+    for (auto& end : ends)
+    {
+      Point2D C(end.second[1] / end.second[0], end.second[2] / end.second[0]);
+      if ((lowest == NULL) || (C.y < P.y) || ((C.y == P.y) && (C.x < P.x))) 
+      { 
+        P = C; 
+        lowest = &end.second;
+      }
+    }
+    // the end is in a plane containing the lateral axis, so that its 
+    // vertices are on a line of the sagittal plane: the direction is 
+    // orthogonal to its principal axis, towards the inside of the mesh
+    const array<double, 6>& s(*lowest);
+    double varX(s[3] / s[0] - P.x * P.x), covXY(s[4] / s[0] - P.x * P.y),
+      varY(s[5] / s[0] - P.y * P.y);
+    double angle(0.5 * atan2(2. * covXY, varX - varY));
+    T.set(-sin(angle), cos(angle));
+    if ((meshCenter.x - P.x) * T.x + (meshCenter.y - P.y) * T.y < 0.) { T = -1. * T; }
+    // go half a step inside the mesh
+    P = P + (options.step / 2.) * T;
+  }
+  else if (maxCorner.x - minCorner.x >= maxCorner.y - minCorner.y)
+  {
+    T.set(1., 0.);
+    P.set(minCorner.x + options.step / 2., meshCenter.y);
+  }
+  else
+  {
+    T.set(0., 1.);
+    P.set(meshCenter.x, minCorner.y + options.step / 2.);
+  }
+
+  // center the point on the largest contour of the section
+  vector<vector<Point2D>> contours;
+  Point2D N(T);
+  N.turnLeft();
+  slice(P, N, contours);
+  double maxArea(0.);
+  int idx(-1);
+  for (int i(0); i < (int)contours.size(); i++)
+  {
+    if (signedArea(contours[i]) > maxArea)
+    {
+      maxArea = signedArea(contours[i]);
+      idx = i;
+    }
+  }
+  if (idx >= 0) { P = P + centroid(contours[idx]).y * N; }
+}
+
+// ****************************************************************************
+// At each step, the point is moved along the centerline direction, centered 
+// on the lumen of its section, and the direction is updated with the new 
+// centered point. The section is then computed again with the updated 
+// direction, so that the plane stays orthogonal to the lumen in the bends.
+
+bool MeshSlicer::traceCenterLine(const struct meshSlicingOptions& options,
+  vector<Point2D>& centerLine, vector<Point2D>& normals) const
+{
+  Point2D P, T, N, prevP, C;
+  vector<Point2D> contour;
+
+  centerLine.clear();
+  normals.clear();
+  initialPosition(options, P, T);
+
+  for (int i(0); i < options.maxSections; i++)
+  {
+    for (int iter(0); iter < 2; iter++)
+    {
+      N = T;
+      N.turnLeft();
+      if (!sectionContour(P, N, contour)) { break; }
+      C = centroid(contour);
+      P = P + C.y * N;
+      if ((i > 0) && ((P - prevP).magnitude() > 0.))
+      {
+        T = (P - prevP).normalize();
+      }
+    }
+    if (contour.empty()) { break; }
+
+    centerLine.push_back(P);
+    normals.push_back(N);
+    prevP = P;
+    P = P + options.step * T;
+  }
+
+  return (centerLine.size() >= 2);
+}
+
+// ****************************************************************************
+
+bool MeshSlicer::sliceAll(const vector<Point2D>& centerLine, 
+  const vector<Point2D>& normals, int numThreads, 
+  vector<vector<Point2D>>& contours) const
+{
+  vector<char> found(centerLine.size(), 0);
+  contours.assign(centerLine.size(), vector<Point2D>());
+
+  parallelLoop((int)centerLine.size(), numThreads, [&](int i)
+    {
+      found[i] = sectionContour(centerLine[i], normals[i], contours[i]);
+    });
+
+  return (find(found.begin(), found.end(), 0) == found.end());
+}
@@ -0,0 +1,167 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#ifndef __MESH_SLICER_H__
+#define __MESH_SLICER_H__
+
+#include "Geometry.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+using namespace std;
+
+// ****************************************************************************
+// Slicing of a closed triangle mesh (e.g. an STL file) into the centerline, 
+// normals and cross-section contours used to create the segments of the 3D 
+// acoustic simulation, without going through a csv geometry file.
+//
+// The x-y plane of the mesh is the sagittal plane and z is the lateral axis.
+// A section is the intersection of the mesh with the plane which contains 
+// the lateral axis and the normal N of a centerline point P. Its contour 
+// points have the same coordinates as the ones of the csv files: 
+// (z - lateral center of the mesh, distance from P along N).
+// ****************************************************************************
+
+struct meshSlicingOptions
+{
+  double scale;           // factor applied to the coordinates of the mesh
+                          // (e.g. 0.1 for a mesh in mm, the sections are in cm)
+  double step;            // distance between the sections along the centerline (cm)
+  double maxGap;          // maximal gap closed in the contours of a mesh which
+                          // is not watertight (cm)
+  int maxSections;
+  // axis of the mesh (0: x, 1: y, 2: z) which is the lateral axis, the two
+  // others (in circular order) being the axes of the sagittal plane
+  int lateralAxis;
+  // first centerline point and direction of the centerline in the sagittal
+  // plane (after the permutation of the axes); if the direction is zero, 
+  // they are estimated from the mesh (see MeshSlicer::traceCenterLine())
+  Point2D start;
+  Point2D direction;
+
+  meshSlicingOptions() : scale(1.), step(0.1), maxGap(0.02), maxSections(1000),
+    lateralAxis(2), start(0., 0.), direction(0., 0.) {}
+};
+
+// true if the file has the extension .stl (whatever the case)
+bool isStlFile(const string& fileName);
+
+// hash of the exact coordinates of a point, to merge the vertices
+struct point3DHash
+{
+  size_t operator()(const Point3D& P) const;
+};
+
+// ****************************************************************************
+// Triangle mesh with shared vertices. The vertices of the triangles added 
+// are merged when their coordinates are identical, so that the contours of 
+// the sections can be chained through the edges.
+// ****************************************************************************
+
+class TriangleMesh
+{
+public:
+
+  TriangleMesh();
+
+  // read an ASCII or binary STL file
+  bool readStl(const string& fileName, string& error);
+  void addTriangle(const Point3D& A, const Point3D& B, const Point3D& C);
+  void clear();
+  // multiply the coordinates by scale and permute the axes so that the 
+  // lateral axis becomes the z axis
+  void transform(double scale, int lateralAxis);
+
+  int numVertices() const { return (int)m_vertices.size(); }
+  int numTriangles() const { return (int)m_triangles.size() / 3; }
+  const Point3D& vertex(int i) const { return m_vertices[i]; }
+  // index of the vertex j (0, 1 or 2) of the triangle t
+  int triangleVertex(int t, int j) const { return m_triangles[3 * t + j]; }
+  void boundingBox(Point3D& minCorner, Point3D& maxCorner) const;
+
+private:
+
+  int addVertex(const Point3D& P);
+
+  vector<Point3D> m_vertices;
+  vector<int> m_triangles;
+  // vertex indexes by coordinates (to merge the vertices)
+  unordered_map<Point3D, int, point3DHash> m_vertexIdx;
+};
+
+// ****************************************************************************
+// Plane-mesh intersections accelerated by a bounding volume hierarchy of
+// the triangles: only the triangles of the boxes crossed by a plane are 
+// intersected with it.
+// ****************************************************************************
+
+class MeshSlicer
+{
+public:
+
+  // the open chains of the sections are joined when their ends are closer 
+  // than maxGap
+  MeshSlicer(const TriangleMesh& mesh, double maxGap = 0.);
+
+  // closed contours of the intersection of the mesh with the plane of the
+  // section of the centerline point P and normal N (in the coordinates of
+  // the section, counterclockwise)
+  void slice(Point2D P, Point2D N, vector<vector<Point2D>>& contours) const;
+  // contour of the section lumen: the contour of smallest area containing 
+  // the centerline point, or else the largest one whose bounding box 
+  // contains it (false if there is none)
+  bool sectionContour(Point2D P, Point2D N, vector<Point2D>& contour) const;
+
+  // follow the lumen of the mesh from the start of the options, a section 
+  // per step, until the plane leaves the mesh
+  bool traceCenterLine(const struct meshSlicingOptions& options,
+    vector<Point2D>& centerLine, vector<Point2D>& normals) const;
+  // contours of all the sections in parallel (false if one is missing)
+  bool sliceAll(const vector<Point2D>& centerLine, const vector<Point2D>& normals,
+    int numThreads, vector<vector<Point2D>>& contours) const;
+
+  double lateralCenter() const { return m_lateralCenter; }
+
+private:
+
+  struct bvhNode
+  {
+    Point3D minCorner;
+    Point3D maxCorner;
+    int left;             // indexes of the children, -1 for a leaf
+    int right;
+    int first;            // first triangle of a leaf in m_order
+    int count;
+  };
+
+  int buildNode(int first, int count, vector<Point3D>& centers);
+  void initialPosition(const struct meshSlicingOptions& options, 
+    Point2D& P, Point2D& T) const;
+
+  const TriangleMesh& m_mesh;
+  vector<bvhNode> m_nodes;
+  vector<int> m_order;      // triangle indexes ordered by leaves
+  double m_maxGap;
+  double m_lateralCenter;
+};
+
+#endif
@@ -0,0 +1,631 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#include "ModesCache.h"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <thread>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// magic number at the beginning of the cache files
+static const char CACHE_MAGIC[8] = { 'V', 'T', 'L', '3', 'D', 'C', 'H', 'E' };
+
+// magic number at the beginning of the pack files
+static const char PACK_MAGIC[8] = { 'V', 'T', 'L', '3', 'D', 'P', 'C', 'K' };
+
+// alignment of the entries in the pack files
+static const size_t PACK_ALIGNMENT = 64;
+
+// types of the entries which are packed (the checkpoints of the sweeps are 
+// still changing when the pack is written)
+static const char* PACK_TYPES[3] = { "modes_", "junction_", "radiation_" };
+
+// ****************************************************************************
+// Read-only memory mapping of a pack file
+// ****************************************************************************
+
+class MappedCachePack
+{
+public:
+
+  MappedCachePack();
+  ~MappedCachePack();
+
+  // map the file and read its index
+  bool open(const string& fileName, string& error);
+  // the data of an entry, NULL if it is not in the pack
+  const char* find(const string& name, size_t& size) const;
+
+private:
+
+  // not copyable since it owns the mapping
+  MappedCachePack(const MappedCachePack&);
+  MappedCachePack& operator=(const MappedCachePack&);
+
+  const char* m_data;
+  size_t m_size;
+#ifdef _WIN32
+  void* m_file;
+  void* m_mapping;
+#else
+  int m_file;
+#endif
+  // offset and size of the entries
+  map<string, pair<size_t, size_t>> m_entries;
+};
+
+// the pack mapped by mapCachePack()
+static mutex s_packMutex;
+static shared_ptr<const MappedCachePack> s_pack;
+
+// ****************************************************************************
+// Input stream buffer reading a memory area in place
+
+class memoryStreamBuffer : public streambuf
+{
+public:
+  memoryStreamBuffer(const char* data, size_t size)
+  {
+    char* begin(const_cast<char*>(data));
+    setg(begin, begin, begin + size);
+  }
+};
+
+// ****************************************************************************
+// Name of a file without its directory
+
+static string baseName(const string& fileName)
+{
+  size_t pos(fileName.find_last_of("/\\"));
+  return (pos == string::npos) ? fileName : fileName.substr(pos + 1);
+}
+
+// ****************************************************************************
+// Cache key
+// ****************************************************************************
+
+CacheKey::CacheKey() : m_hash(14695981039346656037ULL)
+{
+  add(MODES_CACHE_VERSION);
+}
+
+// ****************************************************************************
+
+void CacheKey::add(const void* data, size_t size)
+{
+  const unsigned char* bytes((const unsigned char*)data);
+  for (size_t i(0); i < size; i++)
+  {
+    m_hash ^= bytes[i];
+    m_hash *= 1099511628211ULL;
+  }
+}
+
+// ****************************************************************************
+
+string CacheKey::str() const
+{
+  ostringstream os;
+  os << hex << setw(16) << setfill('0') << m_hash;
+  return os.str();
+}
+
+// ****************************************************************************
+// Cache files
+// ****************************************************************************
+
+string cacheFileName(const string& directory, const string& type,
+  const CacheKey& key)
+{
+  return directory + "/" + type + "_" + key.str() + ".bin";
+}
+
+// ****************************************************************************
+
+static bool readCacheStream(istream& is, const function<bool(istream&)>& read)
+{
+  char magic[8];
+  int version;
+  is.read(magic, 8);
+  if (!is || !equal(magic, magic + 8, CACHE_MAGIC)) { return false; }
+  if (!readBinary(is, version) || (version != MODES_CACHE_VERSION)) { return false; }
+
+  return read(is);
+}
+
+// ****************************************************************************
+
+bool readCacheFile(const string& fileName, const function<bool(istream&)>& read)
+{
+  shared_ptr<const MappedCachePack> pack;
+  {
+    lock_guard<mutex> lock(s_packMutex);
+    pack = s_pack;
+  }
+
+  size_t size;
+  const char* data(pack ? pack->find(baseName(fileName), size) : NULL);
+  if (data != NULL)
+  {
+    memoryStreamBuffer buffer(data, size);
+    istream is(&buffer);
+    return readCacheStream(is, read);
+  }
+
+  ifstream is(fileName, ios::binary);
+  if (!is.is_open()) { return false; }
+  return readCacheStream(is, read);
+}
+
+// ****************************************************************************
+// Replace a file by a temporary file
+
+static bool replaceFile(const string& tmpName, const string& fileName)
+{
+  // the rename fails on some systems if the entry already exists: it is
+  // then replaced (its content is the same if it has been written by
+  // another thread, or older for the checkpoints), else the temporary file
+  // is simply removed
+  bool success(rename(tmpName.c_str(), fileName.c_str()) == 0);
+  if (!success)
+  {
+    remove(fileName.c_str());
+    success = (rename(tmpName.c_str(), fileName.c_str()) == 0);
+  }
+  if (!success) { remove(tmpName.c_str()); }
+  return success;
+}
+
+// ****************************************************************************
+
+bool writeCacheFile(const string& fileName, const function<void(ostream&)>& write)
+{
+  ostringstream tmpName;
+  tmpName << fileName << "." << this_thread::get_id() << ".tmp";
+
+  ofstream os(tmpName.str(), ios::binary);
+  if (!os.is_open()) { return false; }
+  os.write(CACHE_MAGIC, 8);
+  writeBinary(os, MODES_CACHE_VERSION);
+  write(os);
+  bool success((bool)os);
+  os.close();
+
+  if (!success)
+  {
+    remove(tmpName.str().c_str());
+    return false;
+  }
+  return replaceFile(tmpName.str(), fileName);
+}
+
+// ****************************************************************************
+
+bool createLockFile(const string& fileName)
+{
+#ifdef _WIN32
+  HANDLE file(CreateFileA(fileName.c_str(), GENERIC_WRITE, 0, NULL, CREATE_NEW,
+    FILE_ATTRIBUTE_NORMAL, NULL));
+  if (file == INVALID_HANDLE_VALUE) { return false; }
+  CloseHandle(file);
+#else
+  int file(open(fileName.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644));
+  if (file < 0) { return false; }
+  close(file);
+#endif
+  return true;
+}
+
+// ****************************************************************************
+// Shared pack of the cache entries
+// ****************************************************************************
+
+// The pack file is made of the magic number, the version, the number of
+// entries, the index of the entries (length and characters of the name, 
+// offset and size of the data) and the data of the entries, which are the 
+// contents of the cache files, each starting at a multiple of 
+// PACK_ALIGNMENT.
+
+static bool listPackedFiles(const string& directory, vector<string>& names)
+{
+#ifdef _WIN32
+  WIN32_FIND_DATAA data;
+  HANDLE find(FindFirstFileA((directory + "/*.bin").c_str(), &data));
+  if (find == INVALID_HANDLE_VALUE) { return false; }
+  do { names.push_back(data.cFileName); } while (FindNextFileA(find, &data));
+  FindClose(find);
+#else
+  DIR* dir(opendir(directory.c_str()));
+  if (dir == NULL) { return false; }
+  struct dirent* entry;
+  while ((entry = readdir(dir)) != NULL) { names.push_back(entry->d_name); }
+  closedir(dir);
+#endif
+
+  names.erase(remove_if(names.begin(), names.end(), [](const string& name)
+    {
+      bool packed(false);
+      for (const char* type : PACK_TYPES)
+      {
+        packed = packed || (name.compare(0, strlen(type), type) == 0);
+      }
+      return !packed || (name.size() < 4) 
+        || (name.compare(name.size() - 4, 4, ".bin") != 0);
+    }), names.end());
+  sort(names.begin(), names.end());
+  return true;
+}
+
+// ****************************************************************************
+
+bool writeCachePack(const string& directory, const string& packFile,
+  string& error)
+{
+  vector<string> names;
+  if (!listPackedFiles(directory, names))
+  {
+    error = "Cannot list the cache directory " + directory;
+    return false;
+  }
+
+  // read the entries which have the current version
+  vector<string> contents;
+  vector<string> packedNames;
+  for (auto& name : names)
+  {
+    ifstream is(directory + "/" + name, ios::binary);
+    ostringstream content;
+    content << is.rdbuf();
+    string data(content.str());
+    int version;
+    if ((data.size() < 8 + sizeof(version))
+      || !equal(CACHE_MAGIC, CACHE_MAGIC + 8, data.begin())) { continue; }
+    copy(data.begin() + 8, data.begin() + 8 + sizeof(version), (char*)&version);
+    if (version != MODES_CACHE_VERSION) { continue; }
+    packedNames.push_back(name);
+    contents.push_back(data);
+  }
+
+  // place the entries after the index
+  size_t offset(8 + 2 * sizeof(int));
+  for (auto& name : packedNames) { offset += sizeof(int) + name.size() + 2 * sizeof(uint64_t); }
+  vector<uint64_t> offsets;
+  for (auto& content : contents)
+  {
+    offset = (offset + PACK_ALIGNMENT - 1) / PACK_ALIGNMENT * PACK_ALIGNMENT;
+    offsets.push_back(offset);
+    offset += content.size();
+  }
+
+  ostringstream tmpName;
+  tmpName << packFile << "." << this_thread::get_id() << ".tmp";
+  ofstream os(tmpName.str(), ios::binary);
+  if (!os.is_open())
+  {
+    error = "Cannot write " + packFile;
+    return false;
+  }
+
+  os.write(PACK_MAGIC, 8);
+  writeBinary(os, MODES_CACHE_VERSION);
+  writeBinary(os, (int)packedNames.size());
+  for (int i(0); i < packedNames.size(); i++)
+  {
+    uint64_t size(contents[i].size());
+    writeBinary(os, (int)packedNames[i].size());
+    os.write(packedNames[i].data(), packedNames[i].size());
+    os.write((const char*)&offsets[i], sizeof(uint64_t));
+    os.write((const char*)&size, sizeof(uint64_t));
+  }
+  for (int i(0); i < contents.size(); i++)
+  {
+    while ((uint64_t)os.tellp() < offsets[i]) { os.put(0); }
+    os.write(contents[i].data(), contents[i].size());
+  }
+  bool success((bool)os);
+  os.close();
+
+  if (!success || !replaceFile(tmpName.str(), packFile))
+  {
+    if (!success) { remove(tmpName.str().c_str()); }
+    error = "Cannot write " + packFile;
+    return false;
+  }
+  return true;
+}
+
+// ****************************************************************************
+
+bool mapCachePack(const string& packFile, string& error)
+{
+  shared_ptr<MappedCachePack> pack(new MappedCachePack);
+  if (!pack->open(packFile, error)) { return false; }
+
+  lock_guard<mutex> lock(s_packMutex);
+  s_pack = pack;
+  return true;
+}
+
+// ****************************************************************************
+
+void unmapCachePack()
+{
+  lock_guard<mutex> lock(s_packMutex);
+  s_pack.reset();
+}
+
+// ****************************************************************************
+
+MappedCachePack::MappedCachePack() : m_data(NULL), m_size(0),
+#ifdef _WIN32
+  m_file(INVALID_HANDLE_VALUE), m_mapping(NULL)
+#else
+  m_file(-1)
+#endif
+{
+}
+
+// ****************************************************************************
+
+MappedCachePack::~MappedCachePack()
+{
+#ifdef _WIN32
+  if (m_data != NULL) { UnmapViewOfFile(m_data); }
+  if (m_mapping != NULL) { CloseHandle(m_mapping); }
+  if (m_file != INVALID_HANDLE_VALUE) { CloseHandle(m_file); }
+#else
+  if (m_data != NULL) { munmap((void*)m_data, m_size); }
+  if (m_file >= 0) { ::close(m_file); }
+#endif
+}
+
+// ****************************************************************************
+// Map the file read-only and shared, and check its index
+
+bool MappedCachePack::open(const string& fileName, string& error)
+{
+#ifdef _WIN32
+  m_file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  LARGE_INTEGER fileSize;
+  if ((m_file == INVALID_HANDLE_VALUE) || !GetFileSizeEx(m_file, &fileSize))
+  {
+    error = "Cannot open " + fileName;
+    return false;
+  }
+  m_size = (size_t)fileSize.QuadPart;
+  if (m_size > 0)
+  {
+    m_mapping = CreateFileMappingA(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (m_mapping != NULL)
+    {
+      m_data = (const char*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+    }
+  }
+#else
+  m_file = ::open(fileName.c_str(), O_RDONLY);
+  struct stat fileStat;
+  if ((m_file < 0) || (fstat(m_file, &fileStat) != 0))
+  {
+    error = "Cannot open " + fileName;
+    return false;
+  }
+  m_size = (size_t)fileStat.st_size;
+  if (m_size > 0)
+  {
+    void* data(mmap(NULL, m_size, PROT_READ, MAP_SHARED, m_file, 0));
+    if (data != MAP_FAILED) { m_data = (const char*)data; }
+  }
+#endif
+
+  if (m_data == NULL)
+  {
+    error = "Cannot map " + fileName;
+    return false;
+  }
+
+  //****************************************************
+  // read the index
+  //****************************************************
+
+  memoryStreamBuffer buffer(m_data, m_size);
+  istream is(&buffer);
+  char magic[8];
+  int version, numEntries, length;
+  uint64_t offsetAndSize[2];
+  string name;
+
+  is.read(magic, 8);
+  if (!is || !equal(magic, magic + 8, PACK_MAGIC))
+  {
+    error = fileName + " is not a cache pack";
+    return false;
+  }
+  if (!readBinary(is, version) || (version != MODES_CACHE_VERSION))
+  {
+    error = fileName + " has not the version of the cache";
+    return false;
+  }
+  if (!readBinary(is, numEntries) || (numEntries < 0))
+  {
+    error = fileName + " is truncated or corrupted";
+    return false;
+  }
+  for (int i(0); i < numEntries; i++)
+  {
+    if (!readBinary(is, length) || (length < 0) || ((size_t)length > m_size))
+    {
+      error = fileName + " is truncated or corrupted";
+      return false;
+    }
+    name.resize(length);
+    is.read(&name[0], length);
+    is.read((char*)offsetAndSize, sizeof(offsetAndSize));
+    if (!is || (offsetAndSize[0] > m_size) || (offsetAndSize[1] > m_size - offsetAndSize[0]))
+    {
+      error = fileName + " is truncated or corrupted";
+      return false;
+    }
+    m_entries[name] = pair<size_t, size_t>(offsetAndSize[0], offsetAndSize[1]);
+  }
+
+  return true;
+}
+
+// ****************************************************************************
+
+const char* MappedCachePack::find(const string& name, size_t& size) const
+{
+  auto it(m_entries.find(name));
+  if (it == m_entries.end()) { return NULL; }
+  size = it->second.second;
+  return m_data + it->second.first;
+}
+
+// ****************************************************************************
+// Binary input/output
+// ****************************************************************************
+
+void writeBinary(ostream& os, int value)
+{
+  os.write((const char*)&value, sizeof(value));
+}
+
+// ****************************************************************************
+
+void writeBinary(ostream& os, double value)
+{
+  os.write((const char*)&value, sizeof(value));
+}
+
+// ****************************************************************************
+
+void writeBinary(ostream& os, const Eigen::MatrixXd& mat)
+{
+  writeBinary(os, (int)mat.rows());
+  writeBinary(os, (int)mat.cols());
+  if (mat.size() > 0)
+  {
+    os.write((const char*)mat.data(), mat.size() * sizeof(double));
+  }
+}
+
+// ****************************************************************************
+
+void writeBinary(ostream& os, const vector<Eigen::MatrixXd>& mats)
+{
+  writeBinary(os, (int)mats.size());
+  for (int i(0); i < mats.size(); i++)
+  {
+    writeBinary(os, mats[i]);
+  }
+}
+
+// ****************************************************************************
+// the complex values are written as their interleaved real and imaginary 
+// parts in column-major order
+
+void writeBinary(ostream& os, const Eigen::MatrixXcd& mat)
+{
+  writeBinary(os, (int)mat.rows());
+  writeBinary(os, (int)mat.cols());
+  if (mat.size() > 0)
+  {
+    os.write((const char*)mat.data(), mat.size() * sizeof(complex<double>));
+  }
+}
+
+// ****************************************************************************
+
+bool readBinary(istream& is, int& value)
+{
+  is.read((char*)&value, sizeof(value));
+  return (bool)is;
+}
+
+// ****************************************************************************
+
+bool readBinary(istream& is, double& value)
+{
+  is.read((char*)&value, sizeof(value));
+  return (bool)is;
+}
+
+// ****************************************************************************
+
+bool readBinary(istream& is, Eigen::MatrixXd& mat)
+{
+  int rows, cols;
+  if (!readBinary(is, rows) || !readBinary(is, cols) 
+    || (rows < 0) || (cols < 0)) { return false; }
+  mat.resize(rows, cols);
+  if (mat.size() > 0)
+  {
+    is.read((char*)mat.data(), mat.size() * sizeof(double));
+  }
+  return (bool)is;
+}
+
+// ****************************************************************************
+
+bool readBinary(istream& is, vector<Eigen::MatrixXd>& mats)
+{
+  int size;
+  if (!readBinary(is, size) || (size < 0)) { return false; }
+  mats.resize(size);
+  for (int i(0); i < size; i++)
+  {
+    if (!readBinary(is, mats[i])) { return false; }
+  }
+  return true;
+}
+
+// ****************************************************************************
+
+bool readBinary(istream& is, Eigen::MatrixXcd& mat)
+{
+  int rows, cols;
+  if (!readBinary(is, rows) || !readBinary(is, cols) 
+    || (rows < 0) || (cols < 0)) { return false; }
+  mat.resize(rows, cols);
+  if (mat.size() > 0)
+  {
+    is.read((char*)mat.data(), mat.size() * sizeof(complex<double>));
+  }
+  return (bool)is;
+}
@@ -0,0 +1,142 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#ifndef __MODES_CACHE_H__
+#define __MODES_CACHE_H__
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include <Eigen/Dense>
+
+using namespace std;
+
+// version of the format of the cache files, to increment when the content
+// of the files or the way the cached data are computed change
+const int MODES_CACHE_VERSION = 1;
+
+// ****************************************************************************
+// Key of an entry of the cache of the modes and the junction matrices:
+// 64 bits FNV-1a hash of all the parameters on which the cached data depend.
+// ****************************************************************************
+
+class CacheKey
+{
+public:
+
+  CacheKey();
+  void add(const void* data, size_t size);
+  void add(double value) { add(&value, sizeof(value)); }
+  void add(int value) { add(&value, sizeof(value)); }
+  void add(bool value) { add((int)value); }
+  void add(const CacheKey& key) { add(&key.m_hash, sizeof(key.m_hash)); }
+  bool operator==(const CacheKey& key) const { return m_hash == key.m_hash; }
+  bool operator!=(const CacheKey& key) const { return m_hash != key.m_hash; }
+  // hexadecimal representation of the hash (used in the file names)
+  string str() const;
+
+private:
+
+  uint64_t m_hash;
+};
+
+// ****************************************************************************
+// Cache files
+// ****************************************************************************
+
+// path of the cache file of a given type of data ("modes", "junction"...)
+string cacheFileName(const string& directory, const string& type, 
+  const CacheKey& key);
+
+// Read a cache file with the function read, returns false if the file
+// does not exist, has not the right version or if read fails
+bool readCacheFile(const string& fileName, const function<bool(istream&)>& read);
+
+// Write a cache file with the function write. The data are first written in 
+// a temporary file which is then renamed, so that several threads or 
+// processes can write the same entry without corrupting it.
+bool writeCacheFile(const string& fileName, const function<void(ostream&)>& write);
+
+// Create an empty file if it does not exist yet, atomically for all the 
+// processes sharing the directory: false if it already exists (used to hand
+// out the blocks of the distributed frequency sweep)
+bool createLockFile(const string& fileName);
+
+// ****************************************************************************
+// Shared pack of the cache entries
+// ****************************************************************************
+
+// Write the modes, junction and radiation entries of a cache directory in a
+// single pack file (atomically, like the cache files).
+bool writeCachePack(const string& directory, const string& packFile, 
+  string& error);
+
+// Map a pack file read-only for the whole process: readCacheFile() then 
+// reads the entries of the pack from the mapping instead of the cache files,
+// without opening or reading any file. Since the mapping is shared, the 
+// processes running on the same geometry (e.g., the workers of a 
+// distributed sweep) hold a single copy of the pre-computed modes, junction
+// matrices and radiation impedances in memory. The entries missing in the
+// pack are still read from and written to the cache directory.
+bool mapCachePack(const string& packFile, string& error);
+// The pack stays mapped until the readers using it have finished
+void unmapCachePack();
+
+// ****************************************************************************
+// Binary input/output of the cached data
+// ****************************************************************************
+
+void writeBinary(ostream& os, int value);
+void writeBinary(ostream& os, double value);
+void writeBinary(ostream& os, const Eigen::MatrixXd& mat);
+void writeBinary(ostream& os, const vector<Eigen::MatrixXd>& mats);
+void writeBinary(ostream& os, const Eigen::MatrixXcd& mat);
+bool readBinary(istream& is, int& value);
+bool readBinary(istream& is, double& value);
+bool readBinary(istream& is, Eigen::MatrixXd& mat);
+bool readBinary(istream& is, vector<Eigen::MatrixXd>& mats);
+bool readBinary(istream& is, Eigen::MatrixXcd& mat);
+
+// vectors of plain data (double, int, array<double, 2>...)
+template<typename T> void writeBinary(ostream& os, const vector<T>& vec)
+{
+  writeBinary(os, (int)vec.size());
+  if (vec.size() > 0)
+  {
+    os.write((const char*)vec.data(), vec.size() * sizeof(T));
+  }
+}
+
+template<typename T> bool readBinary(istream& is, vector<T>& vec)
+{
+  int size;
+  if (!readBinary(is, size) || (size < 0)) { return false; }
+  vec.resize(size);
+  if (size > 0)
+  {
+    is.read((char*)vec.data(), size * sizeof(T));
+  }
+  return (bool)is;
+}
+
+#endif
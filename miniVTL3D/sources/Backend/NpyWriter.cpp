@@ -0,0 +1,152 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#include "NpyWriter.h"
+#include <sstream>
+#include <limits>
+
+// total size of the header, which is left constant when the shape of the
+// array is updated (it must be a multiple of 64 bytes)
+static const int NPY_HEADER_SIZE = 128;
+
+// ****************************************************************************
+
+NpyWriter::NpyWriter() : m_complex(false), m_numRows(0), m_numCols(0)
+{
+}
+
+// ****************************************************************************
+
+NpyWriter::~NpyWriter()
+{
+  close();
+}
+
+// ****************************************************************************
+// Create an array with numCols real columns to which rows are appended
+
+bool NpyWriter::openRows(const string& fileName, int numCols)
+{
+  lock_guard<mutex> lock(m_mutex);
+
+  if (m_file.is_open()) { m_file.close(); }
+  m_complex = false;
+  m_numRows = 0;
+  m_numCols = numCols;
+
+  m_file.open(fileName, ios::out | ios::binary | ios::trunc);
+  if (!m_file.is_open()) { return false; }
+  writeHeader();
+  m_file.flush();
+
+  return (bool)m_file;
+}
+
+// ****************************************************************************
+// Create a complex array of numRows x numCols values set to NaN
+
+bool NpyWriter::openArray(const string& fileName, int numRows, int numCols)
+{
+  lock_guard<mutex> lock(m_mutex);
+
+  if (m_file.is_open()) { m_file.close(); }
+  m_complex = true;
+  m_numRows = numRows;
+  m_numCols = numCols;
+
+  m_file.open(fileName, ios::out | ios::binary | ios::trunc);
+  if (!m_file.is_open()) { return false; }
+  writeHeader();
+  vector<complex<double>> nanRow(numCols, complex<double>(
+    numeric_limits<double>::quiet_NaN(), numeric_limits<double>::quiet_NaN()));
+  for (int i(0); i < numRows; i++)
+  {
+    m_file.write((const char*)nanRow.data(), numCols * sizeof(complex<double>));
+  }
+  m_file.flush();
+
+  return (bool)m_file;
+}
+
+// ****************************************************************************
+// Append a row of a real array and update the number of rows of the header
+
+void NpyWriter::appendRow(const vector<double>& row)
+{
+  lock_guard<mutex> lock(m_mutex);
+
+  if (!m_file.is_open() || m_complex || (row.size() != m_numCols)) { return; }
+
+  m_file.seekp(0, ios::end);
+  m_file.write((const char*)row.data(), m_numCols * sizeof(double));
+  m_numRows++;
+  writeHeader();
+  m_file.flush();
+}
+
+// ****************************************************************************
+
+void NpyWriter::writeValues(int row, int col, const complex<double>* values, 
+  int count)
+{
+  lock_guard<mutex> lock(m_mutex);
+
+  if (!m_file.is_open() || !m_complex || (row < 0) || (row >= m_numRows) 
+    || (col < 0) || (col + count > m_numCols)) { return; }
+
+  m_file.seekp(NPY_HEADER_SIZE + ((long long)row * m_numCols + col) 
+    * sizeof(complex<double>));
+  m_file.write((const char*)values, count * sizeof(complex<double>));
+  m_file.flush();
+}
+
+// ****************************************************************************
+
+void NpyWriter::close()
+{
+  lock_guard<mutex> lock(m_mutex);
+
+  if (m_file.is_open()) { m_file.close(); }
+}
+
+// ****************************************************************************
+// Write the magic string, the version and the description of the array at 
+// the beginning of the file. The description is padded with spaces so that 
+// the size of the header does not depend on the shape.
+
+void NpyWriter::writeHeader()
+{
+  stringstream dict;
+  dict << "{'descr': '" << (m_complex ? "<c16" : "<f8") 
+    << "', 'fortran_order': False, 'shape': (" << m_numRows << ", " 
+    << m_numCols << "), }";
+  string header(dict.str());
+  // 6 bytes of magic string, 2 of version and 2 of header length
+  header.resize(NPY_HEADER_SIZE - 10 - 1, ' ');
+  header += '\n';
+  unsigned short headerLength(header.size());
+
+  m_file.seekp(0);
+  m_file.write("\x93NUMPY\x01\x00", 8);
+  m_file.put((char)(headerLength & 0xFF));
+  m_file.put((char)(headerLength >> 8));
+  m_file.write(header.data(), header.size());
+}
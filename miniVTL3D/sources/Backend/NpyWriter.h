@@ -0,0 +1,72 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#ifndef __NPY_WRITER_H__
+#define __NPY_WRITER_H__
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <complex>
+#include <mutex>
+
+using namespace std;
+
+// ****************************************************************************
+// Writer of 2D arrays in the NPY format of numpy (version 1.0, C order, 
+// little endian values), which can be read or memory mapped with 
+// numpy.load(fileName, mmap_mode='r').
+// The array is written while it is computed, so that the values already 
+// computed can be read if the computation is not finished:
+// - openRows creates a real array with a fixed number of columns, to which 
+//   rows are appended; the number of rows of the header is updated after 
+//   each row.
+// - openArray creates a complex array of fixed size filled with NaN, whose 
+//   values are then overwritten at their positions.
+// The writing functions can be called from several threads at once.
+// ****************************************************************************
+
+class NpyWriter
+{
+public:
+
+  NpyWriter();
+  ~NpyWriter();
+  bool openRows(const string& fileName, int numCols);
+  bool openArray(const string& fileName, int numRows, int numCols);
+  bool isOpen() const { return m_file.is_open(); }
+  void appendRow(const vector<double>& row);
+  // write count consecutive values of a row starting at the column col
+  void writeValues(int row, int col, const complex<double>* values, int count);
+  void close();
+
+private:
+
+  void writeHeader();
+
+  ofstream m_file;
+  mutex m_mutex;
+  bool m_complex;
+  long long m_numRows;
+  int m_numCols;
+};
+
+#endif
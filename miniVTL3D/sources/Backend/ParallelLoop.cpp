@@ -0,0 +1,519 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#include "ParallelLoop.h"
+#include <algorithm>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// ****************************************************************************
+// A loop run by the pool: each participant calls run(slot) with its own 
+// slot between 0 and numSlots - 1
+
+struct poolJob
+{
+  function<void(int)> run;
+  int numSlots;
+  int nextSlot;
+  int numActive;
+};
+
+// ****************************************************************************
+// Pool of worker threads. The workers are detached and never destroyed, so 
+// that the pool can be used until the end of the program. A worker joins the
+// most recent job which has a free slot, so that the inner loops, which 
+// block the tasks of the outer ones, are finished first.
+
+class ThreadPool
+{
+public:
+  static ThreadPool& getInstance();
+
+  void setSettings(const threadPoolSettings& settings);
+  threadPoolSettings settings();
+  int size();
+
+  // the participant of the slot 0 is the calling thread if callerWorks, 
+  // finish removes the job and waits until its participants have left
+  void start(poolJob& job, bool callerWorks);
+  void finish(poolJob& job);
+
+  // true if the calling thread is running a task of a loop
+  static bool isInTask() { return m_taskDepth > 0; }
+  static void enterTask() { m_taskDepth++; }
+  static void leaveTask() { m_taskDepth--; }
+
+private:
+  ThreadPool();
+  int numWorkers() const;
+  poolJob* findJob();
+  void workerLoop(int idxWorker);
+  static void pinThread(int idxWorker, bool pin);
+
+  mutex m_mutex;
+  condition_variable m_jobCond, m_leaveCond;
+  deque<poolJob*> m_jobs;
+  threadPoolSettings m_settings;
+  int m_numStarted;
+  int m_affinityVersion;
+  static thread_local int m_taskDepth;
+};
+
+thread_local int ThreadPool::m_taskDepth = 0;
+
+// ****************************************************************************
+
+ThreadPool& ThreadPool::getInstance()
+{
+  static ThreadPool* instance(new ThreadPool());
+  return *instance;
+}
+
+// ****************************************************************************
+
+ThreadPool::ThreadPool()
+{
+  m_settings.numWorkers = 0;
+  m_settings.pinWorkers = false;
+  m_settings.nested = NESTED_IDLE_WORKERS;
+  m_numStarted = 0;
+  m_affinityVersion = 0;
+}
+
+// ****************************************************************************
+
+void ThreadPool::setSettings(const threadPoolSettings& settings)
+{
+  lock_guard<mutex> lock(m_mutex);
+  if (settings.pinWorkers != m_settings.pinWorkers) { m_affinityVersion++; }
+  m_settings = settings;
+  m_jobCond.notify_all();
+}
+
+// ****************************************************************************
+
+threadPoolSettings ThreadPool::settings()
+{
+  lock_guard<mutex> lock(m_mutex);
+  return m_settings;
+}
+
+// ****************************************************************************
+
+int ThreadPool::size()
+{
+  lock_guard<mutex> lock(m_mutex);
+  return numWorkers();
+}
+
+// ****************************************************************************
+
+int ThreadPool::numWorkers() const
+{
+  return (m_settings.numWorkers > 0) ? m_settings.numWorkers :
+    max(1, (int)thread::hardware_concurrency());
+}
+
+// ****************************************************************************
+
+void ThreadPool::start(poolJob& job, bool callerWorks)
+{
+  lock_guard<mutex> lock(m_mutex);
+  job.nextSlot = callerWorks ? 1 : 0;
+  job.numActive = 0;
+  // the workers which are not needed yet are started at the first loop 
+  // which could use them, those above the number of workers stay idle
+  int numNeeded(min(numWorkers(), job.numSlots - job.nextSlot));
+  for (; m_numStarted < numNeeded; m_numStarted++)
+  {
+    thread(&ThreadPool::workerLoop, this, m_numStarted).detach();
+  }
+  if (job.nextSlot < job.numSlots)
+  {
+    m_jobs.push_back(&job);
+    m_jobCond.notify_all();
+  }
+}
+
+// ****************************************************************************
+
+void ThreadPool::finish(poolJob& job)
+{
+  unique_lock<mutex> lock(m_mutex);
+  auto it(find(m_jobs.begin(), m_jobs.end(), &job));
+  if (it != m_jobs.end()) { m_jobs.erase(it); }
+  m_leaveCond.wait(lock, [&]() { return job.numActive == 0; });
+}
+
+// ****************************************************************************
+
+poolJob* ThreadPool::findJob()
+{
+  for (auto it(m_jobs.rbegin()); it != m_jobs.rend(); it++)
+  {
+    if ((*it)->nextSlot < (*it)->numSlots) { return *it; }
+  }
+  return NULL;
+}
+
+// ****************************************************************************
+
+void ThreadPool::workerLoop(int idxWorker)
+{
+  int affinityVersion(0);
+  bool pinned(false);
+  unique_lock<mutex> lock(m_mutex);
+  while (true)
+  {
+    poolJob* job(NULL);
+    m_jobCond.wait(lock, [&]() 
+      {
+        job = (idxWorker < numWorkers()) ? findJob() : NULL;
+        return (job != NULL) || (affinityVersion != m_affinityVersion);
+      });
+
+    if (affinityVersion != m_affinityVersion)
+    {
+      affinityVersion = m_affinityVersion;
+      if (pinned != m_settings.pinWorkers)
+      {
+        pinned = m_settings.pinWorkers;
+        pinThread(idxWorker, pinned);
+      }
+      if (job == NULL) { continue; }
+    }
+
+    int slot(job->nextSlot++);
+    job->numActive++;
+    lock.unlock();
+
+    enterTask();
+    job->run(slot);
+    leaveTask();
+
+    lock.lock();
+    if (--job->numActive == 0) { m_leaveCond.notify_all(); }
+  }
+}
+
+// ****************************************************************************
+// Bind the calling thread to the logical core idxWorker (modulo the number
+// of cores) or to all the cores
+
+void ThreadPool::pinThread(int idxWorker, bool pin)
+{
+  int numCores(max(1, (int)thread::hardware_concurrency()));
+#ifdef _WIN32
+  DWORD_PTR processMask, systemMask;
+  if (!GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask)) { return; }
+  SetThreadAffinityMask(GetCurrentThread(), 
+    pin ? ((DWORD_PTR)1 << (idxWorker % min(numCores, 64))) : processMask);
+#elif defined(__linux__)
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  for (int c(0); c < numCores; c++)
+  {
+    if (!pin || (c == idxWorker % numCores)) { CPU_SET(c, &cpus); }
+  }
+  pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+#endif
+}
+
+// ****************************************************************************
+
+void setThreadPoolSettings(const threadPoolSettings& settings)
+{
+  ThreadPool::getInstance().setSettings(settings);
+}
+
+// ****************************************************************************
+
+threadPoolSettings getThreadPoolSettings()
+{
+  return ThreadPool::getInstance().settings();
+}
+
+// ****************************************************************************
+
+int threadPoolSize()
+{
+  return ThreadPool::getInstance().size();
+}
+
+// ****************************************************************************
+// Queue of tasks of a thread: the owner takes its tasks from the front and 
+// the other threads steal from the back
+
+struct taskQueue
+{
+  deque<int> tasks;
+  mutex queueMutex;
+};
+
+// ****************************************************************************
+// Get the next task of the thread idxThread, steal it from another thread if 
+// its own queue is empty. Returns false if there is no task left.
+
+static bool nextTask(vector<taskQueue>& queues, int idxThread, int& task)
+{
+  int numThreads(queues.size());
+
+  {
+    lock_guard<mutex> lock(queues[idxThread].queueMutex);
+    if (!queues[idxThread].tasks.empty())
+    {
+      task = queues[idxThread].tasks.front();
+      queues[idxThread].tasks.pop_front();
+      return true;
+    }
+  }
+
+  for (int t(1); t < numThreads; t++)
+  {
+    taskQueue& victim(queues[(idxThread + t) % numThreads]);
+    lock_guard<mutex> lock(victim.queueMutex);
+    if (!victim.tasks.empty())
+    {
+      task = victim.tasks.back();
+      victim.tasks.pop_back();
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// ****************************************************************************
+// Number of threads of a loop and whether the calling thread runs tasks: a
+// nested loop is run by the calling thread, in sequence if the policy says 
+// so, and the progress of the outermost loop is reported by the calling 
+// thread.
+
+static int loopThreads(int numTasks, int numThreads, const progressCallback& progress,
+  bool& callerWorks)
+{
+  bool nested(ThreadPool::isInTask());
+  callerWorks = !progress || nested;
+  numThreads = max(1, min(numThreads, numTasks));
+  if (nested && (ThreadPool::getInstance().settings().nested == NESTED_SEQUENTIAL))
+  {
+    numThreads = 1;
+  }
+  return numThreads;
+}
+
+// ****************************************************************************
+
+bool parallelLoop(int numTasks, int numThreads, const function<void(int)>& task,
+  const progressCallback& progress)
+{
+  return parallelLoopIndexed(numTasks, numThreads, 
+    [&task](int i, int) { task(i); }, progress);
+}
+
+// ****************************************************************************
+
+bool parallelLoopIndexed(int numTasks, int numThreads, 
+  const function<void(int, int)>& task, const progressCallback& progress)
+{
+  atomic<bool> cancel(false);
+  int numDone(0), numReported(0);
+  mutex doneMutex;
+  condition_variable doneCond;
+  bool callerWorks;
+
+  if (numTasks <= 0) { return true; }
+  numThreads = loopThreads(numTasks, numThreads, progress, callerWorks);
+
+  // a single thread runs the tasks in the calling thread
+  if (callerWorks && (numThreads == 1))
+  {
+    for (int i(0); i < numTasks; i++) { task(i, 0); }
+    return !progress || progress(numTasks, numTasks);
+  }
+
+  // distribute contiguous blocks of tasks to the threads
+  vector<taskQueue> queues(numThreads);
+  for (int i(0); i < numTasks; i++)
+  {
+    queues[(long)i * numThreads / numTasks].tasks.push_back(i);
+  }
+
+  poolJob job;
+  job.numSlots = numThreads;
+  job.run = [&](int idxThread)
+  {
+    int i;
+    while (!cancel && nextTask(queues, idxThread, i))
+    {
+      task(i, idxThread);
+      {
+        lock_guard<mutex> lock(doneMutex);
+        numDone++;
+      }
+      doneCond.notify_one();
+    }
+  };
+
+  ThreadPool& pool(ThreadPool::getInstance());
+  pool.start(job, callerWorks);
+  if (callerWorks)
+  {
+    ThreadPool::enterTask();
+    job.run(0);
+    ThreadPool::leaveTask();
+    pool.finish(job);
+    return !progress || progress(numTasks, numTasks);
+  }
+
+  // report the progress from the calling thread
+  unique_lock<mutex> lock(doneMutex);
+  while (numReported < numTasks)
+  {
+    doneCond.wait(lock, [&]() { return numDone > numReported; });
+    numReported = numDone;
+    lock.unlock();
+    if (progress && !progress(numReported, numTasks))
+    {
+      cancel = true;
+      break;
+    }
+    lock.lock();
+  }
+  if (lock.owns_lock()) { lock.unlock(); }
+
+  pool.finish(job);
+
+  return !cancel;
+}
+
+// ****************************************************************************
+
+bool parallelTaskGraph(int numTasks, const vector<vector<int>>& dependencies,
+  int numThreads, const function<void(int)>& task, const progressCallback& progress)
+{
+  bool cancel(false);
+  int numDone(0), numReported(0), numRunning(0);
+  mutex graphMutex;
+  condition_variable readyCond, doneCond;
+  bool callerWorks;
+
+  if (numTasks <= 0) { return true; }
+  numThreads = loopThreads(numTasks, numThreads, progress, callerWorks);
+
+  // tasks depending on each task and number of unfinished dependencies
+  vector<vector<int>> dependents(numTasks);
+  vector<int> numWaiting(numTasks, 0);
+  for (int i(0); i < numTasks; i++)
+  {
+    for (int d : dependencies[i])
+    {
+      dependents[d].push_back(i);
+      numWaiting[i]++;
+    }
+  }
+  deque<int> ready;
+  for (int i(0); i < numTasks; i++)
+  {
+    if (numWaiting[i] == 0) { ready.push_back(i); }
+  }
+
+  poolJob job;
+  job.numSlots = numThreads;
+  job.run = [&](int)
+  {
+    unique_lock<mutex> lock(graphMutex);
+    while (true)
+    {
+      // wait for a ready task, the workers stop when no task is ready nor
+      // running, i.e. when all the tasks are finished or cancelled
+      readyCond.wait(lock, [&]() 
+        { return cancel || !ready.empty() || (numRunning == 0); });
+      if (cancel || ready.empty()) { break; }
+
+      int i(ready.front());
+      ready.pop_front();
+      numRunning++;
+      lock.unlock();
+
+      task(i);
+
+      lock.lock();
+      numRunning--;
+      numDone++;
+      for (int k(dependents[i].size() - 1); k >= 0; k--)
+      {
+        if (--numWaiting[dependents[i][k]] == 0) { ready.push_front(dependents[i][k]); }
+      }
+      readyCond.notify_all();
+      doneCond.notify_one();
+    }
+    // wake up the other workers so that they stop as well
+    readyCond.notify_all();
+  };
+
+  ThreadPool& pool(ThreadPool::getInstance());
+  pool.start(job, callerWorks);
+  if (callerWorks)
+  {
+    ThreadPool::enterTask();
+    job.run(0);
+    ThreadPool::leaveTask();
+    pool.finish(job);
+    return !progress || progress(numTasks, numTasks);
+  }
+
+  // report the progress from the calling thread
+  unique_lock<mutex> lock(graphMutex);
+  while (numReported < numTasks)
+  {
+    doneCond.wait(lock, [&]() 
+      { return (numDone > numReported) || (ready.empty() && (numRunning == 0)); });
+    if (numDone == numReported) { break; }
+    numReported = numDone;
+    lock.unlock();
+    if (progress && !progress(numReported, numTasks))
+    {
+      lock.lock();
+      cancel = true;
+      readyCond.notify_all();
+      break;
+    }
+    lock.lock();
+  }
+  lock.unlock();
+
+  pool.finish(job);
+
+  return !cancel;
+}
@@ -0,0 +1,102 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#ifndef __PARALLEL_LOOP_H__
+#define __PARALLEL_LOOP_H__
+
+#include <functional>
+#include <vector>
+
+using namespace std;
+
+// ****************************************************************************
+// Progress callback: receives the number of finished tasks and the total
+// number of tasks. Returning false cancels the remaining tasks.
+// ****************************************************************************
+
+typedef function<bool(int, int)> progressCallback;
+
+// ****************************************************************************
+// Shared pool of threads
+// The loops below run on a pool of worker threads shared by the whole 
+// backend, which are created at the first loop instead of at each loop. The
+// calling thread takes part in the tasks, except if it reports the progress.
+// A loop started from a task of another loop is nested: according to the 
+// nested parallelism policy, its tasks are either run in sequence by the 
+// calling thread, or shared with the workers of the pool which are idle, so 
+// that the inner loops only use the threads left free by the outer ones.
+// The progress of a nested loop is only reported once it is finished.
+// ****************************************************************************
+
+enum nestedParallelism { NESTED_SEQUENTIAL, NESTED_IDLE_WORKERS };
+
+struct threadPoolSettings
+{
+  int numWorkers;                 // number of worker threads (one per hardware thread for <= 0)
+  bool pinWorkers;                // bind the worker k to the logical core k
+  enum nestedParallelism nested;  // policy of the nested loops
+};
+
+void setThreadPoolSettings(const threadPoolSettings& settings);
+threadPoolSettings getThreadPoolSettings();
+// number of worker threads of the pool
+int threadPoolSize();
+
+// ****************************************************************************
+// Run task(i) for i = 0 ... numTasks - 1 on numThreads threads.
+// The tasks are scheduled by work stealing: each thread starts with a 
+// contiguous block of tasks and, once its block is finished, steals the last 
+// pending tasks of the other threads, so that tasks of very different 
+// durations are balanced. The progress callback
+// (if any) is always called from the calling thread, which makes it possible 
+// to update a GUI from it.
+// Returns false if the loop has been cancelled by the progress callback.
+// ****************************************************************************
+
+bool parallelLoop(int numTasks, int numThreads, const function<void(int)>& task,
+  const progressCallback& progress = progressCallback());
+
+// ****************************************************************************
+// Same as parallelLoop, task(i, t) receiving the index t < numThreads of the
+// thread running it, e.g. to use work variables of this thread.
+// ****************************************************************************
+
+bool parallelLoopIndexed(int numTasks, int numThreads, 
+  const function<void(int, int)>& task,
+  const progressCallback& progress = progressCallback());
+
+// ****************************************************************************
+// Run task(i) for i = 0 ... numTasks - 1 on numThreads threads, the task i
+// starting only once the tasks of dependencies[i] are finished. The tasks 
+// without dependencies are started in increasing order of index, and the 
+// tasks whose dependencies have just been finished are started before them,
+// so that the results of a task are used while they are in the cache and
+// the tasks of the critical path should have the lowest indexes. The 
+// dependency graph must be acyclic. The progress callback is called from 
+// the calling thread as with parallelLoop.
+// Returns false if the tasks have been cancelled by the progress callback.
+// ****************************************************************************
+
+bool parallelTaskGraph(int numTasks, const vector<vector<int>>& dependencies,
+  int numThreads, const function<void(int)>& task,
+  const progressCallback& progress = progressCallback());
+
+#endif
@@ -127,17 +127,154 @@ void PoleZeroPlan::sortLocations(vector<Location> &origList, vector<Location> &s
 }
 
 
+// ****************************************************************************
+/// Multiplies the spectrum of the cache by the factor of a pole or a zero
+/// (and its conjugate). For a pole p, the factor is 
+/// |p|^2 / ((s-p)(s-p*)) = |p|^2 / D with D = |p|^2 - w^2 + j*2*pi*bw*w 
+/// for s = jw, and the factor of a zero is the inverse. The real operations
+/// on the separate arrays of the real and imaginary parts can be vectorized.
+// ****************************************************************************
+
+void PoleZeroPlan::multiplyLocationFactor(SpectrumCache &cache, const Location &location, 
+  bool isPole)
+{
+  int k;
+  double F0 = (double)SAMPLING_RATE / (double)cache.spectrumLength;
+  double sigma = location.bw_Hz*M_PI;
+  double omega = 2.0*M_PI*location.freq_Hz;
+  double squaredMagnitude = sigma*sigma + omega*omega;
+  double *re = cache.re.data();
+  double *im = cache.im.data();
+
+  for (k=0; k < cache.numHarmonics; k++)
+  {
+    double w = 2.0*M_PI*k*F0;
+    double dRe = squaredMagnitude - w*w;
+    double dIm = 2.0*sigma*w;
+    double fRe, fIm;
+
+    if (isPole)
+    {
+      // |p|^2 / D = |p|^2 * conj(D) / |D|^2
+      double scale = squaredMagnitude / (dRe*dRe + dIm*dIm);
+      fRe = scale*dRe;
+      fIm = -scale*dIm;
+    }
+    else
+    {
+      fRe = dRe / squaredMagnitude;
+      fIm = dIm / squaredMagnitude;
+    }
+
+    double x = re[k]*fRe - im[k]*fIm;
+    im[k] = re[k]*fIm + im[k]*fRe;
+    re[k] = x;
+  }
+}
+
+
+// ****************************************************************************
+/// Replaces the factor of a pole or zero at oldLocation by the factor at 
+/// newLocation in the spectrum of the cache, i.e., multiplies the spectrum
+/// by the ratio of the new and old factors. Returns false, without changing
+/// the spectrum, if the old factor is zero somewhere (a zero without 
+/// bandwidth on a harmonic), so that it cannot be divided out.
+// ****************************************************************************
+
+bool PoleZeroPlan::replaceLocationFactor(SpectrumCache &cache, const Location &oldLocation, 
+  const Location &newLocation, bool isPole)
+{
+  int k;
+  double F0 = (double)SAMPLING_RATE / (double)cache.spectrumLength;
+  double oldSigma = oldLocation.bw_Hz*M_PI;
+  double oldOmega = 2.0*M_PI*oldLocation.freq_Hz;
+  double oldSquaredMagnitude = oldSigma*oldSigma + oldOmega*oldOmega;
+  double newSigma = newLocation.bw_Hz*M_PI;
+  double newOmega = 2.0*M_PI*newLocation.freq_Hz;
+  double newSquaredMagnitude = newSigma*newSigma + newOmega*newOmega;
+  double *re = cache.re.data();
+  double *im = cache.im.data();
+
+  // For a pole, the ratio is (|pNew|^2 / |pOld|^2) * dOld / dNew, and for
+  // a zero, it is the inverse. Both are written as scale * a / b.
+  double scale = isPole ? newSquaredMagnitude / oldSquaredMagnitude :
+    oldSquaredMagnitude / newSquaredMagnitude;
+
+  if (!isPole)
+  {
+    for (k=0; k < cache.numHarmonics; k++)
+    {
+      double w = 2.0*M_PI*k*F0;
+      double dRe = oldSquaredMagnitude - w*w;
+      double dIm = 2.0*oldSigma*w;
+      if (dRe*dRe + dIm*dIm <= 1.0e-20*oldSquaredMagnitude*oldSquaredMagnitude)
+      {
+        return false;
+      }
+    }
+  }
+
+  for (k=0; k < cache.numHarmonics; k++)
+  {
+    double w = 2.0*M_PI*k*F0;
+    double oldRe = oldSquaredMagnitude - w*w;
+    double oldIm = 2.0*oldSigma*w;
+    double newRe = newSquaredMagnitude - w*w;
+    double newIm = 2.0*newSigma*w;
+
+    double aRe = isPole ? oldRe : newRe;
+    double aIm = isPole ? oldIm : newIm;
+    double bRe = isPole ? newRe : oldRe;
+    double bIm = isPole ? newIm : oldIm;
+
+    // ratio = scale * a * conj(b) / |b|^2
+    double s = scale / (bRe*bRe + bIm*bIm);
+    double fRe = s*(aRe*bRe + aIm*bIm);
+    double fIm = s*(aIm*bRe - aRe*bIm);
+
+    double x = re[k]*fRe - im[k]*fIm;
+    im[k] = re[k]*fIm + im[k]*fRe;
+    re[k] = x;
+  }
+
+  return true;
+}
+
+
+// ****************************************************************************
+/// Calculates the spectrum of the cache from all locations.
+// ****************************************************************************
+
+void PoleZeroPlan::calcSpectrum(SpectrumCache &cache)
+{
+  int i;
+
+  cache.poles = poles;
+  cache.zeros = zeros;
+  cache.re.assign(cache.numHarmonics, 1.0);
+  cache.im.assign(cache.numHarmonics, 0.0);
+  cache.numIncrementalUpdates = 0;
+
+  for (i=0; i < (int)poles.size(); i++)
+  {
+    multiplyLocationFactor(cache, poles[i], true);
+  }
+
+  for (i=0; i < (int)zeros.size(); i++)
+  {
+    multiplyLocationFactor(cache, zeros[i], false);
+  }
+}
+
+
 // ****************************************************************************
 // Create a spectrum from the PZ-plan.
+// The spectrum of the previous call with the same spectrum length is 
+// updated for the changed poles and zeros only.
 // ****************************************************************************
 
 void PoleZeroPlan::getPoleZeroSpectrum(ComplexSignal *spectrum, int spectrumLength, double upperFrequencyLimit)
 {
-  ComplexValue s;
-  ComplexValue pole, conjugatePole;
-  ComplexValue zero, conjugateZero;
-  ComplexValue numerator;
-  ComplexValue denominator;
   int i, k;
   double F0 = (double)SAMPLING_RATE / (double)spectrumLength;
   int numHarmonics = (int)(upperFrequencyLimit / F0);
@@ -146,35 +283,86 @@ void PoleZeroPlan::getPoleZeroSpectrum(ComplexSignal *spectrum, int spectrumLeng
   { 
     numHarmonics = spectrumLength/2 - 1; 
   }
+  if (numHarmonics < 0)
+  {
+    numHarmonics = 0;
+  }
   spectrum->reset(spectrumLength);
 
   // ****************************************************************
-  // Run through all discrete frequencies.
+  // Find the cached spectrum of this length.
   // ****************************************************************
 
-  for (k=0; k < numHarmonics; k++)
+  SpectrumCache *cache = NULL;
+  for (i=0; i < (int)spectrumCache.size(); i++)
+  {
+    if ((spectrumCache[i].spectrumLength == spectrumLength) && 
+      (spectrumCache[i].numHarmonics == numHarmonics))
+    {
+      cache = &spectrumCache[i];
+    }
+  }
+
+  // ****************************************************************
+  // Update the cached spectrum with the changed locations, or 
+  // recalculate it when locations were added or removed, or after
+  // many updates.
+  // ****************************************************************
+
+  if (cache == NULL)
   {
-    s = ComplexValue(0, 2.0*M_PI*k*F0);
-    numerator = ComplexValue(1.0, 0.0);
-    denominator = ComplexValue(1.0, 0.0);
+    if ((int)spectrumCache.size() >= MAX_CACHED_SPECTRA)
+    {
+      spectrumCache.erase(spectrumCache.begin());
+    }
+    spectrumCache.push_back(SpectrumCache());
+    cache = &spectrumCache.back();
+    cache->spectrumLength = spectrumLength;
+    cache->numHarmonics = numHarmonics;
+    calcSpectrum(*cache);
+  }
+  else if ((cache->poles.size() != poles.size()) || (cache->zeros.size() != zeros.size()) ||
+    (cache->numIncrementalUpdates >= MAX_INCREMENTAL_UPDATES))
+  {
+    calcSpectrum(*cache);
+  }
+  else
+  {
+    bool ok = true;
 
-    for (i=0; i < (int)poles.size(); i++)
+    for (i=0; (i < (int)poles.size()) && (ok); i++)
     {
-      pole          = ComplexValue(-poles[i].bw_Hz*M_PI,  2.0*M_PI*poles[i].freq_Hz);
-      conjugatePole = ComplexValue(-poles[i].bw_Hz*M_PI, -2.0*M_PI*poles[i].freq_Hz);
-      numerator     = numerator*pole*conjugatePole;
-      denominator   = denominator*(s-pole)*(s-conjugatePole);
+      if ((poles[i].freq_Hz != cache->poles[i].freq_Hz) || (poles[i].bw_Hz != cache->poles[i].bw_Hz))
+      {
+        ok = replaceLocationFactor(*cache, cache->poles[i], poles[i], true);
+        cache->poles[i] = poles[i];
+        cache->numIncrementalUpdates++;
+      }
     }
 
-    for (i=0; i < (int)zeros.size(); i++)
+    for (i=0; (i < (int)zeros.size()) && (ok); i++)
     {
-      zero          = ComplexValue(-zeros[i].bw_Hz*M_PI,  2.0*M_PI*zeros[i].freq_Hz);
-      conjugateZero = ComplexValue(-zeros[i].bw_Hz*M_PI, -2.0*M_PI*zeros[i].freq_Hz);
-      numerator     = numerator*(s-zero)*(s-conjugateZero);
-      denominator   = denominator*zero*conjugateZero;
+      if ((zeros[i].freq_Hz != cache->zeros[i].freq_Hz) || (zeros[i].bw_Hz != cache->zeros[i].bw_Hz))
+      {
+        ok = replaceLocationFactor(*cache, cache->zeros[i], zeros[i], false);
+        cache->zeros[i] = zeros[i];
+        cache->numIncrementalUpdates++;
+      }
     }
 
-    spectrum->setValue(k, numerator/denominator);
+    if (!ok)
+    {
+      calcSpectrum(*cache);
+    }
+  }
+
+  // ****************************************************************
+  // Copy the discrete frequencies.
+  // ****************************************************************
+
+  for (k=0; k < numHarmonics; k++)
+  {
+    spectrum->setValue(k, cache->re[k], cache->im[k]);
   }
 
   // Generate the negative frequencies in the spectrum.
@@ -197,10 +385,26 @@ void PoleZeroPlan::getHigherPoleCorrection(ComplexSignal *spectrum, int spectrum
   double F0 = (double)SAMPLING_RATE / (double)spectrumLength;
   int numHarmonics = spectrumLength/2;
 
-  spectrum->reset(spectrumLength);
-  
   int numPoles = (int)poles.size();
 
+  // ****************************************************************
+  // The correction only depends on the number of poles, so that it
+  // does not change while the poles are moved.
+  // ****************************************************************
+
+  for (i=0; i < (int)higherPoleCorrectionCache.size(); i++)
+  {
+    HigherPoleCorrectionCache &cache = higherPoleCorrectionCache[i];
+    if ((cache.spectrumLength == spectrumLength) && (cache.numPoles == numPoles) &&
+      (cache.effectiveLength_cm == effectiveLength_cm))
+    {
+      *spectrum = cache.spectrum;
+      return;
+    }
+  }
+
+  spectrum->reset(spectrumLength);
+
   // ****************************************************************
   // Calc. the coefficients a and b.
   // ****************************************************************
@@ -239,6 +443,19 @@ void PoleZeroPlan::getHigherPoleCorrection(ComplexSignal *spectrum, int spectrum
 
   // Generate the negative frequencies in the spectrum.
   generateNegativeFrequencies(spectrum);
+
+  // Keep the result for the next calls.
+
+  if ((int)higherPoleCorrectionCache.size() >= MAX_CACHED_SPECTRA)
+  {
+    higherPoleCorrectionCache.erase(higherPoleCorrectionCache.begin());
+  }
+  HigherPoleCorrectionCache cache;
+  cache.spectrumLength = spectrumLength;
+  cache.effectiveLength_cm = effectiveLength_cm;
+  cache.numPoles = numPoles;
+  cache.spectrum = *spectrum;
+  higherPoleCorrectionCache.push_back(cache);
 }
 
 // ****************************************************************************
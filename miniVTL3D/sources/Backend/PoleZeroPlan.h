@@ -53,6 +53,44 @@ public:
   void sortLocations(vector<Location> &origList, vector<Location> &sortedList);
   void getPoleZeroSpectrum(ComplexSignal *spectrum, int spectrumLength, double upperFrequencyLimit);
   void getHigherPoleCorrection(ComplexSignal *spectrum, int spectrumLength, double effectiveLength_cm);
+
+private:
+  // Number of incremental updates of a cached spectrum after which it is
+  // recalculated from all locations, so that rounding errors cannot add up.
+  static const int MAX_INCREMENTAL_UPDATES = 200;
+  // Number of spectrum lengths for which the spectra are cached
+  static const int MAX_CACHED_SPECTRA = 4;
+
+  // The spectrum of the locations of the last call of getPoleZeroSpectrum()
+  // for a given spectrum length, as the product of the factors of the poles
+  // and zeros. When a few locations changed (e.g., while a pole is dragged),
+  // the spectrum is multiplied by the ratios of the new and old factors.
+  struct SpectrumCache
+  {
+    int spectrumLength;
+    int numHarmonics;
+    vector<Location> poles;
+    vector<Location> zeros;
+    vector<double> re;
+    vector<double> im;
+    int numIncrementalUpdates;
+  };
+
+  struct HigherPoleCorrectionCache
+  {
+    int spectrumLength;
+    double effectiveLength_cm;
+    int numPoles;
+    ComplexSignal spectrum;
+  };
+
+  vector<SpectrumCache> spectrumCache;
+  vector<HigherPoleCorrectionCache> higherPoleCorrectionCache;
+
+  void multiplyLocationFactor(SpectrumCache &cache, const Location &location, bool isPole);
+  bool replaceLocationFactor(SpectrumCache &cache, const Location &oldLocation, 
+    const Location &newLocation, bool isPole);
+  void calcSpectrum(SpectrumCache &cache);
 };
 
 // ****************************************************************************
@@ -0,0 +1,370 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#include "PolygonClipping.h"
+#include <algorithm>
+#include <cmath>
+
+// tolerance on the distances relative to the size of the polygons under 
+// which a vertex is considered on an edge of the other polygon
+static const double CLIPPING_RELATIVE_TOLERANCE = 1e-9;
+
+// vertex or intersection point of the linked list of a polygon
+struct clipNode
+{
+  ClipPoint pt;
+  int next, prev;
+  bool isIntersection;
+  // the polygon enters the other one at this intersection
+  bool entry;
+  // same intersection in the list of the other polygon
+  int neighbor;
+  bool visited;
+};
+
+// intersection of the edge edgeP of P with the edge edgeQ of Q
+struct clipIntersection
+{
+  ClipPoint pt;
+  int edgeP, edgeQ;
+  double alphaP, alphaQ;
+  int nodeP, nodeQ;
+};
+
+// ****************************************************************************
+
+static double cross(double ax, double ay, double bx, double by)
+{
+  return ax * by - ay * bx;
+}
+
+// ****************************************************************************
+
+double polygonArea(const vector<ClipPoint>& poly)
+{
+  double area(0.);
+  int n(poly.size());
+  for (int i(0); i < n; i++)
+  {
+    const ClipPoint& a(poly[i]), & b(poly[(i + 1) % n]);
+    area += cross(a[0], a[1], b[0], b[1]);
+  }
+  return area / 2.;
+}
+
+// ****************************************************************************
+// Distance from a point to the boundary of a polygon
+
+static double distanceToBoundary(const ClipPoint& p, const vector<ClipPoint>& poly)
+{
+  double dist(HUGE_VAL);
+  int n(poly.size());
+  for (int i(0); i < n; i++)
+  {
+    const ClipPoint& a(poly[i]), & b(poly[(i + 1) % n]);
+    double ex(b[0] - a[0]), ey(b[1] - a[1]);
+    double len2(ex * ex + ey * ey);
+    double t((len2 > 0.) ? ((p[0] - a[0]) * ex + (p[1] - a[1]) * ey) / len2 : 0.);
+    t = max(0., min(1., t));
+    dist = min(dist, hypot(p[0] - a[0] - t * ex, p[1] - a[1] - t * ey));
+  }
+  return dist;
+}
+
+// ****************************************************************************
+// Point in polygon test by the crossing number (the point must not be on 
+// the boundary)
+
+static bool isInside(const ClipPoint& p, const vector<ClipPoint>& poly)
+{
+  bool inside(false);
+  int n(poly.size());
+  for (int i(0), j(n - 1); i < n; j = i++)
+  {
+    if (((poly[i][1] > p[1]) != (poly[j][1] > p[1])) &&
+      (p[0] < (poly[j][0] - poly[i][0]) * (p[1] - poly[i][1]) /
+        (poly[j][1] - poly[i][1]) + poly[i][0]))
+    {
+      inside = !inside;
+    }
+  }
+  return inside;
+}
+
+// ****************************************************************************
+// Remove the consecutive duplicated vertices and the closing vertex
+
+static void removeDuplicates(const vector<ClipPoint>& in, double tol, 
+  vector<ClipPoint>& out)
+{
+  out.clear();
+  for (auto& p : in)
+  {
+    if (out.empty() || (hypot(p[0] - out.back()[0], p[1] - out.back()[1]) > tol))
+    {
+      out.push_back(p);
+    }
+  }
+  while ((out.size() > 1) && 
+    (hypot(out[0][0] - out.back()[0], out[0][1] - out.back()[1]) <= tol))
+  {
+    out.pop_back();
+  }
+}
+
+// ****************************************************************************
+// Set the entry flags of the intersections of a list: the status inside or 
+// outside of the other polygon changes at each intersection. Return false 
+// if all the vertices are on the boundary of the other polygon.
+
+static bool setEntryFlags(vector<clipNode>& nodes, int numVertices, 
+  const vector<ClipPoint>& poly, const vector<ClipPoint>& other, double tol)
+{
+  // the vertices are the first nodes of the list
+  int start(-1);
+  for (int i(0); (i < numVertices) && (start < 0); i++)
+  {
+    if (distanceToBoundary(poly[i], other) > tol) { start = i; }
+  }
+  if (start < 0) { return false; }
+
+  bool inside(isInside(poly[start], other));
+  int idx(nodes[start].next);
+  while (idx != start)
+  {
+    if (nodes[idx].isIntersection)
+    {
+      nodes[idx].entry = !inside;
+      inside = !inside;
+    }
+    idx = nodes[idx].next;
+  }
+  return true;
+}
+
+// ****************************************************************************
+// Build the linked list of the vertices of a polygon followed by its 
+// intersections: the vertices are the first nodes, the intersections are
+// inserted along the edges by increasing parameter
+
+static void buildList(const vector<ClipPoint>& poly, 
+  vector<clipIntersection>& inters, bool isP, vector<clipNode>& nodes)
+{
+  int n(poly.size());
+  nodes.clear();
+  for (int i(0); i < n; i++)
+  {
+    nodes.push_back({ poly[i], -1, -1, false, false, -1, false });
+  }
+
+  // intersections of each edge by increasing parameter
+  vector<vector<int>> edgeInters(n);
+  for (int k(0); k < inters.size(); k++)
+  {
+    edgeInters[isP ? inters[k].edgeP : inters[k].edgeQ].push_back(k);
+  }
+
+  int prev(0);
+  for (int i(0); i < n; i++)
+  {
+    auto& list(edgeInters[i]);
+    sort(list.begin(), list.end(), [&](int a, int b)
+      { 
+        return isP ? (inters[a].alphaP < inters[b].alphaP) : 
+          (inters[a].alphaQ < inters[b].alphaQ); 
+      });
+
+    if (i > 0) { nodes[prev].next = i; nodes[i].prev = prev; prev = i; }
+    for (int k : list)
+    {
+      int idx(nodes.size());
+      nodes.push_back({ inters[k].pt, -1, prev, true, false, -1, false });
+      nodes[prev].next = idx;
+      prev = idx;
+      if (isP) { inters[k].nodeP = idx; } else { inters[k].nodeQ = idx; }
+    }
+  }
+  nodes[prev].next = 0;
+  nodes[0].prev = prev;
+}
+
+// ****************************************************************************
+
+bool intersectPolygons(const vector<ClipPoint>& inP, const vector<ClipPoint>& inQ,
+  vector<vector<ClipPoint>>& result)
+{
+  result.clear();
+
+  // tolerance relative to the size of the polygons
+  double xMin(HUGE_VAL), xMax(-HUGE_VAL), yMin(HUGE_VAL), yMax(-HUGE_VAL);
+  for (auto poly : { &inP, &inQ })
+  {
+    for (auto& p : *poly)
+    {
+      xMin = min(xMin, p[0]); xMax = max(xMax, p[0]);
+      yMin = min(yMin, p[1]); yMax = max(yMax, p[1]);
+    }
+  }
+  double tol(CLIPPING_RELATIVE_TOLERANCE * max(xMax - xMin, yMax - yMin));
+
+  vector<ClipPoint> P, Q;
+  removeDuplicates(inP, tol, P);
+  removeDuplicates(inQ, tol, Q);
+  int nP(P.size()), nQ(Q.size());
+  if ((nP < 3) || (nQ < 3)) { return false; }
+
+  //*********************************************
+  // Intersections of the edges
+  //*********************************************
+
+  vector<clipIntersection> inters;
+  for (int i(0); i < nP; i++)
+  {
+    const ClipPoint& p0(P[i]), & p1(P[(i + 1) % nP]);
+    double rx(p1[0] - p0[0]), ry(p1[1] - p0[1]), lr(hypot(rx, ry));
+
+    for (int j(0); j < nQ; j++)
+    {
+      const ClipPoint& q0(Q[j]), & q1(Q[(j + 1) % nQ]);
+      double sx(q1[0] - q0[0]), sy(q1[1] - q0[1]), ls(hypot(sx, sy));
+
+      // quick rejection with the bounding boxes of the edges
+      if ((max(p0[0], p1[0]) < min(q0[0], q1[0]) - tol) ||
+        (max(q0[0], q1[0]) < min(p0[0], p1[0]) - tol) ||
+        (max(p0[1], p1[1]) < min(q0[1], q1[1]) - tol) ||
+        (max(q0[1], q1[1]) < min(p0[1], p1[1]) - tol))
+      {
+        continue;
+      }
+
+      double dx(q0[0] - p0[0]), dy(q0[1] - p0[1]);
+      double d(cross(rx, ry, sx, sy));
+
+      if (abs(d) <= CLIPPING_RELATIVE_TOLERANCE * lr * ls)
+      {
+        // parallel edges: degenerate if they are on the same line and overlap
+        if (abs(cross(dx, dy, rx, ry)) <= tol * lr)
+        {
+          double t0((dx * rx + dy * ry) / (lr * lr));
+          double t1(((q1[0] - p0[0]) * rx + (q1[1] - p0[1]) * ry) / (lr * lr));
+          double ae(tol / lr);
+          if ((max(t0, t1) >= -ae) && (min(t0, t1) <= 1. + ae)) { return false; }
+        }
+        continue;
+      }
+
+      double alphaP(cross(dx, dy, sx, sy) / d);
+      double alphaQ(cross(dx, dy, rx, ry) / d);
+      double aeP(tol / lr), aeQ(tol / ls);
+      if ((alphaP < -aeP) || (alphaP > 1. + aeP) || 
+        (alphaQ < -aeQ) || (alphaQ > 1. + aeQ))
+      {
+        continue;
+      }
+
+      // a vertex on an edge of the other polygon
+      if ((alphaP <= aeP) || (alphaP >= 1. - aeP) || 
+        (alphaQ <= aeQ) || (alphaQ >= 1. - aeQ))
+      {
+        return false;
+      }
+
+      inters.push_back({ { p0[0] + alphaP * rx, p0[1] + alphaP * ry }, 
+        i, j, alphaP, alphaQ, -1, -1 });
+    }
+  }
+
+  //*********************************************
+  // No crossing: one polygon contains the other
+  // or they are disjoint
+  //*********************************************
+
+  if (inters.empty())
+  {
+    for (auto pair : { make_pair(&P, &Q), make_pair(&Q, &P) })
+    {
+      const vector<ClipPoint>& inner(*pair.first), & outer(*pair.second);
+      int idx(-1);
+      for (int i(0); (i < inner.size()) && (idx < 0); i++)
+      {
+        if (distanceToBoundary(inner[i], outer) > tol) { idx = i; }
+      }
+      if (idx < 0) { return false; }
+      if (isInside(inner[idx], outer))
+      {
+        result.push_back(inner);
+        if (polygonArea(result.back()) < 0.) { reverse(result.back().begin(), result.back().end()); }
+        return true;
+      }
+    }
+    return true;
+  }
+
+  //*********************************************
+  // Build the lists and traverse them
+  //*********************************************
+
+  vector<clipNode> nodes[2];
+  buildList(P, inters, true, nodes[0]);
+  buildList(Q, inters, false, nodes[1]);
+  for (auto& inter : inters)
+  {
+    nodes[0][inter.nodeP].neighbor = inter.nodeQ;
+    nodes[1][inter.nodeQ].neighbor = inter.nodeP;
+  }
+  if (!setEntryFlags(nodes[0], nP, P, Q, tol) || 
+    !setEntryFlags(nodes[1], nQ, Q, P, tol))
+  {
+    return false;
+  }
+
+  for (auto& inter : inters)
+  {
+    if (nodes[0][inter.nodeP].visited) { continue; }
+
+    vector<ClipPoint> poly;
+    int list(0), idx(inter.nodeP);
+    poly.push_back(nodes[0][idx].pt);
+    do
+    {
+      nodes[list][idx].visited = true;
+      nodes[1 - list][nodes[list][idx].neighbor].visited = true;
+      bool forward(nodes[list][idx].entry);
+      do
+      {
+        idx = forward ? nodes[list][idx].next : nodes[list][idx].prev;
+        poly.push_back(nodes[list][idx].pt);
+        // a polygon cannot have more vertices than the two lists
+        if (poly.size() > nodes[0].size() + nodes[1].size()) { return false; }
+      } while (!nodes[list][idx].isIntersection);
+      idx = nodes[list][idx].neighbor;
+      list = 1 - list;
+    } while (!nodes[list][idx].visited);
+
+    vector<ClipPoint> cleaned;
+    removeDuplicates(poly, tol, cleaned);
+    if (cleaned.size() < 3) { continue; }
+    if (polygonArea(cleaned) < 0.) { reverse(cleaned.begin(), cleaned.end()); }
+    result.push_back(cleaned);
+  }
+
+  return true;
+}
@@ -0,0 +1,53 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#ifndef __POLYGON_CLIPPING_H__
+#define __POLYGON_CLIPPING_H__
+
+#include <vector>
+#include <array>
+
+using namespace std;
+
+// ****************************************************************************
+// Intersection of two simple polygons in double precision (Greiner-Hormann 
+// algorithm), used instead of the exact boolean operations of CGAL to 
+// compute the overlap of the contours of the junctions. The intersection of
+// two simple polygons has no hole, it is a list of simple polygons.
+//
+// The algorithm only handles the proper crossings of the edges: it fails
+// (returns false) if a vertex lies on an edge of the other polygon, if two
+// edges overlap or if a polygon has less than 3 vertices, so that the 
+// caller can use an exact method for these degenerate cases.
+// ****************************************************************************
+
+typedef array<double, 2> ClipPoint;
+
+// Compute the intersection of the polygons P and Q (of any orientation): the
+// polygons of the result are counterclockwise. Return false for the 
+// degenerate cases.
+bool intersectPolygons(const vector<ClipPoint>& P, const vector<ClipPoint>& Q,
+  vector<vector<ClipPoint>>& result);
+
+// Signed area of a polygon (positive if it is counterclockwise)
+double polygonArea(const vector<ClipPoint>& poly);
+
+#endif
@@ -0,0 +1,408 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#include "Profiler.h"
+#include <fstream>
+#include <algorithm>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#include <sys/resource.h>
+#endif
+
+// ****************************************************************************
+// Independant functions
+// ****************************************************************************
+
+// ****************************************************************************
+// Escape a string to write it in a JSON file
+
+static string jsonString(const string& str)
+{
+  string out("\"");
+  for (char c : str)
+  {
+    switch (c)
+    {
+    case '"': out += "\\\""; break;
+    case '\\': out += "\\\\"; break;
+    case '\n': out += "\\n"; break;
+    default: out += c;
+    }
+  }
+  return out + "\"";
+}
+
+// ****************************************************************************
+// Node of the tree of the phases, built from the hierarchical names
+
+struct phaseNode
+{
+  Profiler::phaseStats stats;
+  bool measured;
+  map<string, phaseNode> children;
+
+  phaseNode() : stats({ 0., 0., 0., 0 }), measured(false) {}
+};
+
+// ****************************************************************************
+// Total time of a node: its own time if it has been measured, the sum of 
+// the times of its children otherwise
+
+static double totalTime(const phaseNode& node)
+{
+  if (node.measured) { return node.stats.total; }
+  double total(0.);
+  for (auto& child : node.children) { total += totalTime(child.second); }
+  return total;
+}
+
+// ****************************************************************************
+
+static void writeNode(ostream& os, const phaseNode& node, const string& indent)
+{
+  os << "{ \"time\": " << totalTime(node);
+  if (node.measured)
+  {
+    os << ", \"calls\": " << node.stats.calls 
+      << ", \"min\": " << node.stats.min
+      << ", \"max\": " << node.stats.max;
+  }
+  if (!node.children.empty())
+  {
+    os << ", \"children\": {" << endl;
+    int cnt(0);
+    for (auto& child : node.children)
+    {
+      os << indent << "  " << jsonString(child.first) << ": ";
+      writeNode(os, child.second, indent + "  ");
+      if (++cnt < node.children.size()) { os << ","; }
+      os << endl;
+    }
+    os << indent << "}";
+  }
+  os << " }";
+}
+
+// ****************************************************************************
+// Profiler
+// ****************************************************************************
+
+// ****************************************************************************
+// Constructor.
+
+Profiler::Profiler() :
+  m_enabled(false),
+  m_origin(chrono::steady_clock::now())
+{}
+
+// ****************************************************************************
+
+Profiler& Profiler::getInstance()
+{
+  static Profiler profiler;
+  return profiler;
+}
+
+// ****************************************************************************
+
+void Profiler::clear()
+{
+  lock_guard<mutex> lock(m_mutex);
+  m_phases.clear();
+  m_counters.clear();
+  m_memory.clear();
+  m_events.clear();
+  m_threads.clear();
+  m_origin = chrono::steady_clock::now();
+}
+
+// ****************************************************************************
+
+double Profiler::now() const
+{
+  return chrono::duration<double>(chrono::steady_clock::now() - m_origin).count();
+}
+
+// ****************************************************************************
+
+void Profiler::addTime(const string& phase, double start, double duration)
+{
+  if (!m_enabled) { return; }
+  lock_guard<mutex> lock(m_mutex);
+  addStats(phase, duration);
+  m_events.push_back({ phase, start, duration, threadIndex() });
+}
+
+// ****************************************************************************
+
+void Profiler::addTime(const string& phase, double duration)
+{
+  if (!m_enabled) { return; }
+  lock_guard<mutex> lock(m_mutex);
+  addStats(phase, duration);
+}
+
+// ****************************************************************************
+
+void Profiler::addCount(const string& counter, long count)
+{
+  if (!m_enabled) { return; }
+  lock_guard<mutex> lock(m_mutex);
+  m_counters[counter] += count;
+}
+
+// ****************************************************************************
+
+void Profiler::addMemory(const string& quantity, size_t bytes)
+{
+  if (!m_enabled) { return; }
+  lock_guard<mutex> lock(m_mutex);
+  size_t& peak(m_memory[quantity]);
+  peak = max(peak, bytes);
+}
+
+// ****************************************************************************
+
+map<string, Profiler::phaseStats> Profiler::phases()
+{
+  lock_guard<mutex> lock(m_mutex);
+  return m_phases;
+}
+
+// ****************************************************************************
+
+map<string, long> Profiler::counters()
+{
+  lock_guard<mutex> lock(m_mutex);
+  return m_counters;
+}
+
+// ****************************************************************************
+
+map<string, size_t> Profiler::memory()
+{
+  lock_guard<mutex> lock(m_mutex);
+  return m_memory;
+}
+
+// ****************************************************************************
+// Export the statistics of the phases as a tree, the counters and the peak
+// memory (bytes)
+
+bool Profiler::exportJson(const string& fileName)
+{
+  ofstream ofs(fileName);
+  if (!ofs.is_open()) { return false; }
+
+  phaseNode root;
+  map<string, long> counters;
+  map<string, size_t> memory;
+  {
+    lock_guard<mutex> lock(m_mutex);
+    for (auto& phase : m_phases)
+    {
+      // go down the tree following the levels of the name
+      phaseNode* node(&root);
+      size_t start(0), end;
+      do
+      {
+        end = phase.first.find('/', start);
+        node = &node->children[phase.first.substr(start, end - start)];
+        start = end + 1;
+      } while (end != string::npos);
+      node->stats = phase.second;
+      node->measured = true;
+    }
+    counters = m_counters;
+    memory = m_memory;
+  }
+
+  ofs << "{" << endl << "  \"phases\": ";
+  writeNode(ofs, root, "  ");
+  ofs << "," << endl << "  \"counters\": {";
+  int cnt(0);
+  for (auto& counter : counters)
+  {
+    ofs << (cnt++ > 0 ? ", " : " ") << jsonString(counter.first) << ": " 
+      << counter.second;
+  }
+  ofs << " }," << endl << "  \"memory\": {";
+  cnt = 0;
+  for (auto& quantity : memory)
+  {
+    ofs << (cnt++ > 0 ? ", " : " ") << jsonString(quantity.first) << ": " 
+      << quantity.second;
+  }
+  ofs << " }" << endl << "}" << endl;
+  ofs.close();
+
+  return true;
+}
+
+// ****************************************************************************
+// Export the recorded phases in the Chrome trace event format (the times
+// are in microseconds)
+
+bool Profiler::exportChromeTrace(const string& fileName)
+{
+  ofstream ofs(fileName);
+  if (!ofs.is_open()) { return false; }
+
+  vector<traceEvent> events;
+  {
+    lock_guard<mutex> lock(m_mutex);
+    events = m_events;
+  }
+
+  ofs << "{ \"traceEvents\": [" << endl;
+  ofs.precision(15);
+  for (int i(0); i < events.size(); i++)
+  {
+    // the category is the first level of the name
+    string category(events[i].name.substr(0, events[i].name.find('/')));
+    ofs << "  { \"name\": " << jsonString(events[i].name)
+      << ", \"cat\": " << jsonString(category)
+      << ", \"ph\": \"X\", \"pid\": 0, \"tid\": " << events[i].thread
+      << ", \"ts\": " << events[i].start * 1e6
+      << ", \"dur\": " << events[i].duration * 1e6 << " }";
+    if (i < events.size() - 1) { ofs << ","; }
+    ofs << endl;
+  }
+  ofs << "] }" << endl;
+  ofs.close();
+
+  return true;
+}
+
+// ****************************************************************************
+
+void Profiler::addStats(const string& phase, double duration)
+{
+  auto it(m_phases.find(phase));
+  if (it == m_phases.end())
+  {
+    m_phases[phase] = { duration, duration, duration, 1 };
+  }
+  else
+  {
+    it->second.total += duration;
+    it->second.min = min(it->second.min, duration);
+    it->second.max = max(it->second.max, duration);
+    it->second.calls++;
+  }
+}
+
+// ****************************************************************************
+// Index of the calling thread in the order of the first record
+
+int Profiler::threadIndex()
+{
+  auto it(m_threads.find(this_thread::get_id()));
+  if (it != m_threads.end()) { return it->second; }
+  int idx(m_threads.size());
+  m_threads[this_thread::get_id()] = idx;
+  return idx;
+}
+
+// ****************************************************************************
+// Memory of the process
+// ****************************************************************************
+
+// ****************************************************************************
+
+size_t residentMemory()
+{
+#if defined(_WIN32)
+  PROCESS_MEMORY_COUNTERS counters;
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+  {
+    return counters.WorkingSetSize;
+  }
+  return 0;
+#elif defined(__linux__)
+  // the second field of statm is the number of resident pages
+  ifstream ifs("/proc/self/statm");
+  size_t size(0), resident(0);
+  if (!(ifs >> size >> resident)) { return 0; }
+  return resident * (size_t)sysconf(_SC_PAGESIZE);
+#else
+  return 0;
+#endif
+}
+
+// ****************************************************************************
+
+size_t peakResidentMemory()
+{
+#if defined(_WIN32)
+  PROCESS_MEMORY_COUNTERS counters;
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+  {
+    return counters.PeakWorkingSetSize;
+  }
+  return 0;
+#elif defined(__unix__) || defined(__APPLE__)
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) { return 0; }
+#if defined(__APPLE__)
+  return (size_t)usage.ru_maxrss;
+#else
+  // in kilobytes on Linux and BSD
+  return (size_t)usage.ru_maxrss * 1024;
+#endif
+#else
+  return 0;
+#endif
+}
+
+// ****************************************************************************
+// ScopedTimer
+// ****************************************************************************
+
+// ****************************************************************************
+// Constructor.
+
+ScopedTimer::ScopedTimer(const string& phase) :
+  m_enabled(Profiler::getInstance().isEnabled())
+{
+  if (m_enabled)
+  {
+    m_phase = phase;
+    m_start = Profiler::getInstance().now();
+  }
+}
+
+// ****************************************************************************
+
+ScopedTimer::~ScopedTimer()
+{
+  if (m_enabled)
+  {
+    Profiler& profiler(Profiler::getInstance());
+    profiler.addTime(m_phase, m_start, profiler.now() - m_start);
+    profiler.addMemory(m_phase, residentMemory());
+  }
+}
@@ -0,0 +1,135 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#ifndef __PROFILER_H__
+#define __PROFILER_H__
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace std;
+
+// ****************************************************************************
+// Registry of the computation times and counters of the simulation phases.
+// The phases are named hierarchically with '/' separating the levels, for 
+// example "modes/segment 12" or "propagation/frequency 100", so that the 
+// times can be broken down by segment or by frequency. The times are 
+// measured with a monotonic clock. 
+// The registry can be exported as JSON (aggregated statistics) or in the 
+// Chrome trace event format (timeline of each thread, readable with 
+// chrome://tracing or Perfetto). It is disabled by default and then costs
+// only the test of a flag.
+// The memory is recorded as the peak (in bytes) of each named quantity: the
+// resident memory of the process at the end of the phases measured by a 
+// ScopedTimer, and the footprints of the data of the simulation.
+// ****************************************************************************
+
+class Profiler
+{
+public:
+
+  struct phaseStats
+  {
+    double total;
+    double min;
+    double max;
+    long calls;
+  };
+
+  static Profiler& getInstance();
+
+  void setEnabled(bool enabled) { m_enabled = enabled; }
+  bool isEnabled() const { return m_enabled; }
+  void clear();
+
+  // time elapsed since the creation of the profiler in seconds
+  double now() const;
+  // record a phase which started at the time start (given by now())
+  void addTime(const string& phase, double start, double duration);
+  // accumulate a duration without recording it in the timeline
+  void addTime(const string& phase, double duration);
+  void addCount(const string& counter, long count = 1);
+  // keep the maximum of the values recorded for a quantity
+  void addMemory(const string& quantity, size_t bytes);
+
+  map<string, phaseStats> phases();
+  map<string, long> counters();
+  map<string, size_t> memory();
+
+  bool exportJson(const string& fileName);
+  bool exportChromeTrace(const string& fileName);
+
+private:
+
+  struct traceEvent
+  {
+    string name;
+    double start;
+    double duration;
+    int thread;
+  };
+
+  Profiler();
+  void addStats(const string& phase, double duration);
+  int threadIndex();
+
+  atomic<bool> m_enabled;
+  chrono::steady_clock::time_point m_origin;
+  mutex m_mutex;
+  map<string, phaseStats> m_phases;
+  map<string, long> m_counters;
+  map<string, size_t> m_memory;
+  vector<traceEvent> m_events;
+  map<thread::id, int> m_threads;
+};
+
+// ****************************************************************************
+// Current and peak resident memory of the process in bytes (0 if it cannot 
+// be obtained on this platform)
+// ****************************************************************************
+
+size_t residentMemory();
+size_t peakResidentMemory();
+
+// ****************************************************************************
+// Measure the time of a phase from the construction to the destruction
+// ****************************************************************************
+
+class ScopedTimer
+{
+public:
+
+  ScopedTimer(const string& phase);
+  ~ScopedTimer();
+
+private:
+
+  string m_phase;
+  double m_start;
+  bool m_enabled;
+};
+
+#endif
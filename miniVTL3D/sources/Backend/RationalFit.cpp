@@ -0,0 +1,371 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#include "RationalFit.h"
+#include <Eigen/Dense>
+#include <Eigen/Eigenvalues>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+// damping of the starting poles relative to their frequency
+static const double STARTING_POLES_DAMPING = 0.01;
+
+// ****************************************************************************
+// Values at z of the basis functions of the poles: 1 / (z - a) for a real
+// pole a and, for a pair of complex poles p, conj(p), the functions
+// 1 / (z - p) + 1 / (z - conj(p)) and i / (z - p) - i / (z - conj(p)), whose
+// real coefficients c1, c2 give the residue c1 + i c2 of p
+
+static void poleBasis(complex<double> z, const vector<double>& realPoles,
+  const vector<complex<double>>& complexPoles, Eigen::VectorXcd& phi)
+{
+  int numReal(realPoles.size());
+  phi.resize(numReal + 2 * complexPoles.size());
+  for (int k(0); k < numReal; k++) { phi(k) = 1. / (z - realPoles[k]); }
+  for (int k(0); k < complexPoles.size(); k++)
+  {
+    complex<double> f1(1. / (z - complexPoles[k])), f2(1. / (z - conj(complexPoles[k])));
+    phi(numReal + 2 * k) = f1 + f2;
+    phi(numReal + 2 * k + 1) = complex<double>(0., 1.) * (f1 - f2);
+  }
+}
+
+// ****************************************************************************
+// Real state-space realisation (A, b) of the basis functions: the basis
+// function k is the entry k of (z I - A)^-1 b
+
+static void poleStateSpace(const vector<double>& realPoles,
+  const vector<complex<double>>& complexPoles, Eigen::MatrixXd& A, Eigen::VectorXd& b)
+{
+  int numReal(realPoles.size());
+  int n(numReal + 2 * complexPoles.size());
+  A.setZero(n, n);
+  b.setZero(n);
+  for (int k(0); k < numReal; k++)
+  {
+    A(k, k) = realPoles[k];
+    b(k) = 1.;
+  }
+  for (int k(0); k < complexPoles.size(); k++)
+  {
+    int j(numReal + 2 * k);
+    A(j, j) = complexPoles[k].real();
+    A(j, j + 1) = complexPoles[k].imag();
+    A(j + 1, j) = -complexPoles[k].imag();
+    A(j + 1, j + 1) = complexPoles[k].real();
+    b(j) = 2.;
+  }
+}
+
+// ****************************************************************************
+// Sort the eigenvalues of a real matrix into real values and complex values
+// with a positive imaginary part (their conjugates are also eigenvalues).
+// If stabilize is true, the values outside the unit circle are reflected
+// into it.
+
+static void splitRoots(const Eigen::VectorXcd& roots, bool stabilize,
+  vector<double>& realRoots, vector<complex<double>>& complexRoots)
+{
+  realRoots.clear();
+  complexRoots.clear();
+  for (int k(0); k < roots.size(); k++)
+  {
+    complex<double> r(roots(k));
+    if (stabilize && (abs(r) > 1.)) { r = 1. / conj(r); }
+    if (r.imag() == 0.) { realRoots.push_back(r.real()); }
+    else if (r.imag() > 0.) { complexRoots.push_back(r); }
+  }
+}
+
+// ****************************************************************************
+// Least squares solution with the columns scaled to a unit norm
+
+static Eigen::VectorXd scaledLeastSquares(Eigen::MatrixXd& M, const Eigen::VectorXd& rhs)
+{
+  Eigen::VectorXd scaling(M.cols());
+  for (int j(0); j < M.cols(); j++)
+  {
+    scaling(j) = M.col(j).norm();
+    if (scaling(j) == 0.) { scaling(j) = 1.; }
+    M.col(j) /= scaling(j);
+  }
+  Eigen::VectorXd x(M.colPivHouseholderQr().solve(rhs));
+  return x.cwiseQuotient(scaling);
+}
+
+// ****************************************************************************
+
+bool fitRationalModel(const vector<double>& freqs,
+  const vector<complex<double>>& values, double samplingRate, int numPoles,
+  int delay, bool relativeWeighting, struct rationalModel& model,
+  int numIterations)
+{
+  int numSamples(freqs.size());
+  // the problem must be overdetermined
+  if ((numPoles < 1) || (numSamples != values.size()) || (numSamples <= numPoles))
+  {
+    return false;
+  }
+
+  // samples at z, without the delay, and their weights
+  Eigen::VectorXcd z(numSamples), H(numSamples);
+  Eigen::VectorXd weights(numSamples);
+  double fmin(freqs[0]), fmax(freqs[0]);
+  for (int i(0); i < numSamples; i++)
+  {
+    z(i) = polar(1., 2. * M_PI * freqs[i] / samplingRate);
+    H(i) = values[i] * pow(z(i), delay);
+    weights(i) = (relativeWeighting && (abs(H(i)) > 0.)) ? 1. / abs(H(i)) : 1.;
+    fmin = min(fmin, freqs[i]);
+    fmax = max(fmax, freqs[i]);
+  }
+
+  // starting poles: weakly damped pairs spread over the band of the samples
+  // and a real pole if the number of poles is odd
+  vector<double> realPoles;
+  vector<complex<double>> complexPoles;
+  int numPairs(numPoles / 2);
+  for (int k(0); k < numPairs; k++)
+  {
+    double f(fmin + (fmax - fmin) * (k + 0.5) / (double)numPairs);
+    double omega(2. * M_PI * f / samplingRate);
+    complexPoles.push_back(exp(complex<double>(-STARTING_POLES_DAMPING * omega, omega)));
+  }
+  if (numPoles % 2 == 1) { realPoles.push_back(0.5); }
+
+  Eigen::VectorXcd phi;
+  Eigen::MatrixXd A, M;
+  Eigen::VectorXd b, rhs, x;
+
+  //*******************************************************
+  // relocation of the poles: the zeros of the weighting
+  // function sigma(z) = 1 + sum c_k phi_k(z), with
+  // sigma H = d + sum r_k phi_k, are the new poles
+  //*******************************************************
+
+  for (int it(0); it < numIterations; it++)
+  {
+    M.setZero(2 * numSamples, 2 * numPoles + 1);
+    rhs.resize(2 * numSamples);
+    for (int i(0); i < numSamples; i++)
+    {
+      poleBasis(z(i), realPoles, complexPoles, phi);
+      Eigen::VectorXcd row(2 * numPoles + 1);
+      row.head(numPoles) = phi;
+      row(numPoles) = 1.;
+      row.tail(numPoles) = -H(i) * phi;
+      M.row(2 * i) = weights(i) * row.real().transpose();
+      M.row(2 * i + 1) = weights(i) * row.imag().transpose();
+      rhs(2 * i) = weights(i) * H(i).real();
+      rhs(2 * i + 1) = weights(i) * H(i).imag();
+    }
+    x = scaledLeastSquares(M, rhs);
+
+    poleStateSpace(realPoles, complexPoles, A, b);
+    Eigen::MatrixXd zerosMatrix(A - b * x.tail(numPoles).transpose());
+    Eigen::EigenSolver<Eigen::MatrixXd> solver(zerosMatrix, false);
+    if (solver.info() != Eigen::Success) { return false; }
+    splitRoots(solver.eigenvalues(), true, realPoles, complexPoles);
+  }
+
+  //*******************************************************
+  // residues and direct term of the final poles
+  //*******************************************************
+
+  M.setZero(2 * numSamples, numPoles + 1);
+  rhs.resize(2 * numSamples);
+  for (int i(0); i < numSamples; i++)
+  {
+    poleBasis(z(i), realPoles, complexPoles, phi);
+    Eigen::VectorXcd row(numPoles + 1);
+    row.head(numPoles) = phi;
+    row(numPoles) = 1.;
+    M.row(2 * i) = weights(i) * row.real().transpose();
+    M.row(2 * i + 1) = weights(i) * row.imag().transpose();
+    rhs(2 * i) = weights(i) * H(i).real();
+    rhs(2 * i + 1) = weights(i) * H(i).imag();
+  }
+  x = scaledLeastSquares(M, rhs);
+
+  int numReal(realPoles.size());
+  model.realPoles = realPoles;
+  model.complexPoles = complexPoles;
+  model.realResidues.assign(x.data(), x.data() + numReal);
+  model.complexResidues.clear();
+  for (int k(0); k < complexPoles.size(); k++)
+  {
+    model.complexResidues.push_back(complex<double>(x(numReal + 2 * k),
+      x(numReal + 2 * k + 1)));
+  }
+  model.direct = x(numPoles);
+  model.delay = delay;
+  model.samplingRate = samplingRate;
+
+  double error(0.), energy(0.);
+  for (int i(0); i < numSamples; i++)
+  {
+    error += norm(values[i] - rationalModelResponse(model, freqs[i]));
+    energy += norm(values[i]);
+  }
+  model.relError = (energy > 0.) ? sqrt(error / energy) : sqrt(error);
+
+  return true;
+}
+
+// ****************************************************************************
+
+complex<double> rationalModelResponse(const struct rationalModel& model, double freq)
+{
+  complex<double> z(polar(1., 2. * M_PI * freq / model.samplingRate));
+  complex<double> H(model.direct);
+  for (int k(0); k < model.realPoles.size(); k++)
+  {
+    H += model.realResidues[k] / (z - model.realPoles[k]);
+  }
+  for (int k(0); k < model.complexPoles.size(); k++)
+  {
+    H += model.complexResidues[k] / (z - model.complexPoles[k])
+      + conj(model.complexResidues[k]) / (z - conj(model.complexPoles[k]));
+  }
+  return H * pow(z, -model.delay);
+}
+
+// ****************************************************************************
+// Group the roots by pairs forming real second-order polynomials: the complex
+// roots with their conjugate, then the real roots two by two (a single real
+// root is completed by 0)
+
+static vector<pair<complex<double>, complex<double>>> rootPairs(
+  const vector<double>& realRoots, const vector<complex<double>>& complexRoots)
+{
+  vector<pair<complex<double>, complex<double>>> pairs;
+  for (auto& r : complexRoots) { pairs.push_back({ r, conj(r) }); }
+  for (int k(0); k < realRoots.size(); k += 2)
+  {
+    pairs.push_back({ realRoots[k], (k + 1 < realRoots.size()) ? realRoots[k + 1] : 0. });
+  }
+  // sorted by frequency, so that each pole pair is grouped with the zeros
+  // closest to it in frequency
+  sort(pairs.begin(), pairs.end(), [](const pair<complex<double>, complex<double>>& a,
+    const pair<complex<double>, complex<double>>& b)
+    { return arg(a.first) < arg(b.first); });
+  return pairs;
+}
+
+// ****************************************************************************
+// The zeros of d + c^T (z I - A)^-1 b are the eigenvalues of A - b c^T / d,
+// so that H(z) = d prod (1 - zeros z^-1) / prod (1 - poles z^-1)
+
+bool rationalModelToFilter(const struct rationalModel& model, IirFilter& filter)
+{
+  int numReal(model.realPoles.size());
+  int numPoles(numReal + 2 * model.complexPoles.size());
+  if (numPoles > MAX_IIR_ORDER) { return false; }
+
+  Eigen::MatrixXd A;
+  Eigen::VectorXd b, c(numPoles);
+  poleStateSpace(model.realPoles, model.complexPoles, A, b);
+  for (int k(0); k < numReal; k++) { c(k) = model.realResidues[k]; }
+  for (int k(0); k < model.complexPoles.size(); k++)
+  {
+    c(numReal + 2 * k) = model.complexResidues[k].real();
+    c(numReal + 2 * k + 1) = model.complexResidues[k].imag();
+  }
+
+  // a model without direct term has a zero at infinity, which is
+  // approximated by a very large zero
+  double d(model.direct);
+  if (abs(d) < 1e-12 * max(1., c.cwiseAbs().maxCoeff()))
+  {
+    d = 1e-12 * max(1., c.cwiseAbs().maxCoeff());
+  }
+  Eigen::MatrixXd zerosMatrix(A - b * c.transpose() / d);
+  Eigen::EigenSolver<Eigen::MatrixXd> solver(zerosMatrix, false);
+  if (solver.info() != Eigen::Success) { return false; }
+  vector<double> realZeros;
+  vector<complex<double>> complexZeros;
+  splitRoots(solver.eigenvalues(), false, realZeros, complexZeros);
+
+  auto polePairs(rootPairs(model.realPoles, model.complexPoles));
+  auto zeroPairs(rootPairs(realZeros, complexZeros));
+  int numSections(max(polePairs.size(), zeroPairs.size()));
+  polePairs.resize(numSections, { 0., 0. });
+  zeroPairs.resize(numSections, { 0., 0. });
+
+  vector<double> num(3 * numSections), den(2 * numSections);
+  for (int s(0); s < numSections; s++)
+  {
+    num[3 * s] = 1.;
+    num[3 * s + 1] = -(zeroPairs[s].first + zeroPairs[s].second).real();
+    num[3 * s + 2] = (zeroPairs[s].first * zeroPairs[s].second).real();
+    den[2 * s] = (polePairs[s].first + polePairs[s].second).real();
+    den[2 * s + 1] = -(polePairs[s].first * polePairs[s].second).real();
+  }
+  for (int j(0); j < 3; j++) { num[j] *= d; }
+
+  return filter.setSections(num.data(), den.data(), numSections);
+}
+
+// ****************************************************************************
+
+bool writeRationalModel(const string& fileName, const struct rationalModel& model)
+{
+  ofstream ofs(fileName);
+  if (!ofs.is_open()) { return false; }
+  ofs.precision(17);
+
+  ofs << "# H(z) = z^-delay [direct + sum residue / (z - pole)], the conjugates of"
+    << " the complex poles and residues are implied" << endl;
+  ofs << "samplingRate " << model.samplingRate << endl;
+  ofs << "delay " << model.delay << endl;
+  ofs << "direct " << model.direct << endl;
+  ofs << "relError " << model.relError << endl;
+  ofs << "realPoles " << model.realPoles.size() << endl;
+  for (int k(0); k < model.realPoles.size(); k++)
+  {
+    ofs << model.realPoles[k] << " " << model.realResidues[k] << endl;
+  }
+  ofs << "complexPoles " << model.complexPoles.size() << endl;
+  for (int k(0); k < model.complexPoles.size(); k++)
+  {
+    ofs << model.complexPoles[k].real() << " " << model.complexPoles[k].imag() << " "
+      << model.complexResidues[k].real() << " " << model.complexResidues[k].imag() << endl;
+  }
+
+  // coefficients of the sections: y[n] = a0 x[n] + a1 x[n-1] + a2 x[n-2]
+  // + b1 y[n-1] + b2 y[n-2]
+  IirFilter filter;
+  if (rationalModelToFilter(model, filter))
+  {
+    int numSections(filter.numberOfSections());
+    ofs << "sections " << numSections << "   # a0 a1 a2 b1 b2" << endl;
+    double coefs[5];
+    for (int s(0); s < numSections; s++)
+    {
+      filter.getSection(s, coefs);
+      ofs << coefs[0] << " " << coefs[1] << " " << coefs[2] << " "
+        << coefs[3] << " " << coefs[4] << endl;
+    }
+  }
+
+  return ofs.good();
+}
@@ -0,0 +1,81 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#ifndef __RATIONAL_FIT_H__
+#define __RATIONAL_FIT_H__
+
+#include "IirFilter.h"
+#include <complex>
+#include <vector>
+
+using namespace std;
+
+// ****************************************************************************
+// Stable rational model of a sampled frequency response (e.g. a transfer
+// function of the 3D simulation), obtained by vector fitting (Gustavsen and
+// Semlyen, 1999) in the z-plane:
+//
+// H(z) = z^(-delay) [direct + sum_k residues[k] / (z - poles[k])]
+//
+// with z = exp(2 i pi f / samplingRate). The poles are relocated iteratively,
+// starting from poles spread over the band of the samples, and the unstable
+// poles are reflected into the unit circle. The complex poles and residues come
+// in conjugate pairs (only the one with a positive imaginary part is stored),
+// so that the impulse response is real and the model can be realised as a
+// cascade of second-order sections (IirFilter), which allows a sample by
+// sample filtering instead of a block convolution.
+// The pure delay (in samples) is not fitted: it should be given when the
+// transfer function includes a propagation delay, e.g. to a point far from
+// the mouth, which would otherwise need many poles.
+// ****************************************************************************
+
+struct rationalModel
+{
+  vector<double> realPoles;
+  vector<double> realResidues;
+  vector<complex<double>> complexPoles;
+  vector<complex<double>> complexResidues;
+  double direct;
+  int delay;
+  double samplingRate;
+  double relError;      // relative rms error on the fitted samples
+};
+
+// numPoles is the total number of poles (counting both poles of a pair), the
+// relative error of the fit is weighted by 1 / |H| if relativeWeighting is
+// true, so that the valleys of the spectrum are fitted as well as the peaks
+bool fitRationalModel(const vector<double>& freqs,
+  const vector<complex<double>>& values, double samplingRate, int numPoles,
+  int delay, bool relativeWeighting, struct rationalModel& model,
+  int numIterations = 20);
+
+complex<double> rationalModelResponse(const struct rationalModel& model, double freq);
+
+// cascade of second-order sections with the poles and the zeros of the model,
+// the delay is not included (false if the model has more than MAX_IIR_ORDER
+// poles)
+bool rationalModelToFilter(const struct rationalModel& model, IirFilter& filter);
+
+// text file with the delay, the direct term, the poles and the residues, and
+// the coefficients of the second-order sections
+bool writeRationalModel(const string& fileName, const struct rationalModel& model);
+
+#endif
@@ -0,0 +1,316 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and R�mi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+
+#include "RealTimeSynthesizer.h"
+#include "GeometricGlottis.h"
+#include "TriangularGlottis.h"
+#include "TwoMassModel.h"
+#include <chrono>
+#include <cstring>
+
+// Flag of the middle snapshot when it was written after the last read
+static const int FRESH_SNAPSHOT = 4;
+
+
+// ****************************************************************************
+/// Constructor.
+// ****************************************************************************
+
+RealTimeSynthesizer::RealTimeSynthesizer()
+{
+  vocalTract = new VocalTract();
+  glottis = NULL;
+  tdsModel = new TdsModel();
+  queue = NULL;
+
+  middleSnapshot = 1;
+  backSnapshot = 0;
+  frontSnapshot = 2;
+
+  running = false;
+  degradationLevel = 0;
+  numOverruns = 0;
+}
+
+
+// ****************************************************************************
+/// Destructor.
+// ****************************************************************************
+
+RealTimeSynthesizer::~RealTimeSynthesizer()
+{
+  stop();
+
+  delete vocalTract;
+  delete glottis;
+  delete tdsModel;
+  delete queue;
+}
+
+
+// ****************************************************************************
+/// Starts the real-time synthesis with copies of the given models, whose 
+/// current parameters are the initial ones. Returns false if the glottis 
+/// model is unknown or the playback cannot be started.
+// ****************************************************************************
+
+bool RealTimeSynthesizer::start(VocalTract *tract, Glottis *glottis, TdsModel *tdsModel)
+{
+  stop();
+
+  delete this->glottis;
+  this->glottis = copyGlottis(glottis);
+  if (this->glottis == NULL)
+  {
+    return false;
+  }
+  vocalTract->copyModelFrom(tract);
+  this->tdsModel->options = tdsModel->options;
+
+  synthesizer.init(this->glottis, vocalTract, this->tdsModel);
+  synthesizer.setTemporalCoherence(true);
+  numOverruns = 0;
+  setDegradationLevel(0);
+
+  // The initial parameters are in the front snapshot.
+  setParams(tract, glottis);
+  frontSnapshot = middleSnapshot.exchange(frontSnapshot) & ~FRESH_SNAPSHOT;
+
+  // A new queue, because the previous one was aborted by its playback.
+  delete queue;
+  queue = new SampleQueue(SAMPLING_RATE / 4);
+  if (!waveStartPlayingStream(queue))
+  {
+    return false;
+  }
+
+  running = true;
+  audioThread = thread(&RealTimeSynthesizer::run, this);
+
+  return true;
+}
+
+
+// ****************************************************************************
+/// Stops the synthesis and the playback. When another sound was played in
+/// the meantime, the audio thread has already stopped (its queue was 
+/// aborted), and that sound is not stopped.
+// ****************************************************************************
+
+void RealTimeSynthesizer::stop()
+{
+  if (audioThread.joinable())
+  {
+    if (running)
+    {
+      running = false;
+      // Aborts the queue, so that the audio thread does not wait for space.
+      waveStopPlaying();
+    }
+    audioThread.join();
+  }
+}
+
+
+// ****************************************************************************
+/// Passes the current parameters of the vocal tract and glottis to the 
+/// audio thread (called by the GUI thread, never blocks).
+// ****************************************************************************
+
+void RealTimeSynthesizer::setParams(VocalTract *tract, Glottis *glottis)
+{
+  int i;
+  ParameterSnapshot &s = snapshot[backSnapshot];
+
+  for (i = 0; i < VocalTract::NUM_PARAMS; i++)
+  {
+    s.tractParams[i] = tract->param[i].x;
+  }
+  for (i = 0; (i < (int)glottis->controlParam.size()) && (i < Glottis::MAX_CONTROL_PARAMS); i++)
+  {
+    s.glottisParams[i] = glottis->controlParam[i].x;
+  }
+
+  backSnapshot = middleSnapshot.exchange(backSnapshot | FRESH_SNAPSHOT) & ~FRESH_SNAPSHOT;
+}
+
+
+// ****************************************************************************
+/// The audio thread: synthesizes chunks of Synthesizer::NUM_CHUNCK_SAMPLES
+/// samples as long as less than LATENCY_MS of samples are waiting to be 
+/// played, and adapts the degradation level to the real-time factor of the
+/// synthesis.
+// ****************************************************************************
+
+void RealTimeSynthesizer::run()
+{
+  // Smoothing of the real-time factor (synthesis time / chunk duration), and
+  // its values above which the degradation level is increased and below 
+  // which it is decreased.
+  const double RTF_SMOOTHING = 0.1;
+  const double MAX_RTF = 0.8;
+  const double MIN_RTF = 0.3;
+  // Number of successive chunks below MIN_RTF before decreasing the level.
+  const int NUM_RECOVERY_CHUNKS = 400;
+
+  const int numChunkSamples = Synthesizer::NUM_CHUNCK_SAMPLES;
+  const int latencySamples = LATENCY_MS * SAMPLING_RATE / 1000;
+  const double chunkDuration_s = (double)numChunkSamples / (double)SAMPLING_RATE;
+
+  vector<double> audio;
+  vector<signed short> samples(numChunkSamples);
+  double geometryParams[VocalTract::NUM_PARAMS];
+  Tube tube;
+  double rtf = 0.0;
+  int numChunksSinceGeometry = 0;
+  int numRecoveryChunks = 0;
+  int i;
+
+  // The first call of add() only sets the initial state.
+
+  ParameterSnapshot *params = &snapshot[frontSnapshot];
+  for (i = 0; i < VocalTract::NUM_PARAMS; i++)
+  {
+    vocalTract->param[i].x = geometryParams[i] = params->tractParams[i];
+  }
+  vocalTract->calculateAll();
+  vocalTract->getTube(&tube);
+  synthesizer.add(params->glottisParams, &tube, 0, audio);
+
+  while (running)
+  {
+    if (queue->size() >= latencySamples)
+    {
+      this_thread::sleep_for(chrono::milliseconds(1));
+      continue;
+    }
+    bool isStarving = (queue->size() < numChunkSamples);
+
+    auto start = chrono::steady_clock::now();
+
+    if (middleSnapshot.load() & FRESH_SNAPSHOT)
+    {
+      frontSnapshot = middleSnapshot.exchange(frontSnapshot) & ~FRESH_SNAPSHOT;
+      params = &snapshot[frontSnapshot];
+    }
+
+    // Recompute the geometry only when the vocal tract changed, and at 
+    // most every 2^level chunks.
+
+    numChunksSinceGeometry++;
+    if ((numChunksSinceGeometry >= (1 << degradationLevel)) &&
+      (memcmp(geometryParams, params->tractParams, sizeof(geometryParams)) != 0))
+    {
+      for (i = 0; i < VocalTract::NUM_PARAMS; i++)
+      {
+        vocalTract->param[i].x = geometryParams[i] = params->tractParams[i];
+      }
+      vocalTract->calculateAll();
+      vocalTract->getTube(&tube);
+      numChunksSinceGeometry = 0;
+    }
+
+    synthesizer.add(params->glottisParams, &tube, numChunkSamples, audio);
+
+    for (i = 0; i < numChunkSamples; i++)
+    {
+      double value = audio[i] * 32767.0;
+      if (value > 32767.0) { value = 32767.0; }
+      if (value < -32768.0) { value = -32768.0; }
+      samples[i] = (signed short)value;
+    }
+
+    // The queue is aborted when the playback is stopped.
+    if (!queue->write(&samples[0], numChunkSamples))
+    {
+      break;
+    }
+
+    // ****************************************************************
+    // Adapt the degradation level.
+    // ****************************************************************
+
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    rtf = (1.0 - RTF_SMOOTHING) * rtf + RTF_SMOOTHING * elapsed.count() / chunkDuration_s;
+
+    if ((rtf > MAX_RTF) || ((isStarving) && (elapsed.count() > chunkDuration_s)))
+    {
+      numOverruns++;
+      if (degradationLevel < MAX_DEGRADATION_LEVEL)
+      {
+        setDegradationLevel(degradationLevel + 1);
+        rtf = 0.5 * (MAX_RTF + MIN_RTF);
+      }
+      numRecoveryChunks = 0;
+    }
+    else if ((rtf < MIN_RTF) && (degradationLevel > 0))
+    {
+      numRecoveryChunks++;
+      if (numRecoveryChunks >= NUM_RECOVERY_CHUNKS)
+      {
+        setDegradationLevel(degradationLevel - 1);
+        numRecoveryChunks = 0;
+      }
+    }
+    else
+    {
+      numRecoveryChunks = 0;
+    }
+  }
+
+  queue->close();
+  running = false;
+}
+
+
+// ****************************************************************************
+// ****************************************************************************
+
+void RealTimeSynthesizer::setDegradationLevel(int level)
+{
+  degradationLevel = level;
+  synthesizer.setControlRate(1 << level);
+}
+
+
+// ****************************************************************************
+/// Returns a new copy of the glottis model, or NULL if its type is unknown.
+// ****************************************************************************
+
+Glottis *RealTimeSynthesizer::copyGlottis(Glottis *glottis)
+{
+  if (GeometricGlottis *g = dynamic_cast<GeometricGlottis*>(glottis))
+  {
+    return new GeometricGlottis(*g);
+  }
+  if (TriangularGlottis *g = dynamic_cast<TriangularGlottis*>(glottis))
+  {
+    return new TriangularGlottis(*g);
+  }
+  if (TwoMassModel *g = dynamic_cast<TwoMassModel*>(glottis))
+  {
+    return new TwoMassModel(*g);
+  }
+  return NULL;
+}
+
+// ****************************************************************************
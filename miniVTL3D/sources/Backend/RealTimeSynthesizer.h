@@ -0,0 +1,118 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and R�mi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+
+#ifndef __REAL_TIME_SYNTHESIZER_H__
+#define __REAL_TIME_SYNTHESIZER_H__
+
+#include "Synthesizer.h"
+#include "SoundLib.h"
+#include <atomic>
+#include <thread>
+
+using namespace std;
+
+// ****************************************************************************
+/// Real-time articulatory synthesis: a dedicated audio thread synthesizes the
+/// speech signal chunk by chunk with a Synthesizer on copies of the vocal 
+/// tract, glottis and TDS models, and streams it to the sound output.
+/// The GUI passes the current parameters with setParams() through a 
+/// lock-free triple buffer, so that neither thread ever waits for the other.
+/// The synthesis runs at most about LATENCY_MS ahead of the playback. When 
+/// it cannot keep up, the geometry of the vocal tract is recomputed and the 
+/// tube is updated less often (degradation levels), instead of letting the 
+/// playback run out of samples.
+// ****************************************************************************
+
+class RealTimeSynthesizer
+{
+  // **************************************************************************
+  // Public data.
+  // **************************************************************************
+
+public:
+  /// Duration of the samples synthesized ahead of the playback
+  static const int LATENCY_MS = 40;
+  /// At level L, the vocal tract geometry is recomputed at most every 2^L 
+  /// chunks and the tube is interpolated every 2^L samples
+  static const int MAX_DEGRADATION_LEVEL = 4;
+
+  // **************************************************************************
+  // Public functions.
+  // **************************************************************************
+
+public:
+  RealTimeSynthesizer();
+  ~RealTimeSynthesizer();
+
+  bool start(VocalTract *tract, Glottis *glottis, TdsModel *tdsModel);
+  void stop();
+  bool isRunning() { return running; }
+
+  void setParams(VocalTract *tract, Glottis *glottis);
+
+  int getDegradationLevel() { return degradationLevel; }
+  int getNumOverruns() { return numOverruns; }
+
+  // **************************************************************************
+  // Private data.
+  // **************************************************************************
+
+private:
+  struct ParameterSnapshot
+  {
+    double tractParams[VocalTract::NUM_PARAMS];
+    double glottisParams[Glottis::MAX_CONTROL_PARAMS];
+  };
+
+  // Models of the audio thread (owned by this class)
+  VocalTract *vocalTract;
+  Glottis *glottis;
+  TdsModel *tdsModel;
+  Synthesizer synthesizer;
+
+  // Triple buffer of the parameters: the GUI writes the back snapshot and 
+  // swaps it with the middle one, the audio thread swaps the middle one 
+  // with the front one when it is fresh.
+  ParameterSnapshot snapshot[3];
+  atomic<int> middleSnapshot;
+  int backSnapshot;
+  int frontSnapshot;
+
+  SampleQueue *queue;
+  thread audioThread;
+  atomic<bool> running;
+  atomic<int> degradationLevel;
+  atomic<int> numOverruns;
+
+  // **************************************************************************
+  // Private functions.
+  // **************************************************************************
+
+private:
+  void run();
+  void setDegradationLevel(int level);
+  static Glottis *copyGlottis(Glottis *glottis);
+};
+
+#endif
+
+// ****************************************************************************
@@ -0,0 +1,124 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#include "SegmentGrid.h"
+#include <algorithm>
+#include <cmath>
+
+// maximal number of cells of the grid
+static const int MAX_NUM_CELLS = 1000000;
+
+// ****************************************************************************
+
+SegmentGrid::SegmentGrid() : m_built(false), m_cellSize(1.)
+{
+  m_origin[0] = 0.;
+  m_origin[1] = 0.;
+  m_numCells[0] = 0;
+  m_numCells[1] = 0;
+}
+
+// ****************************************************************************
+
+void SegmentGrid::clear()
+{
+  m_cells.clear();
+  m_numCells[0] = 0;
+  m_numCells[1] = 0;
+  m_built = false;
+}
+
+// ****************************************************************************
+// Build the grid: the size of the cells is the median of the smallest 
+// dimension of the boxes, so that a cell intersects only a few boxes
+
+void SegmentGrid::build(const vector<CGAL::Bbox_2>& boxes)
+{
+  CGAL::Bbox_2 totBox;
+  vector<double> sizes;
+  int idxMin[2], idxMax[2];
+
+  clear();
+
+  for (int i(0); i < boxes.size(); i++)
+  {
+    if ((boxes[i].xmin() > boxes[i].xmax()) || (boxes[i].ymin() > boxes[i].ymax()))
+    {
+      continue;
+    }
+    totBox += boxes[i];
+    sizes.push_back(max(min(boxes[i].xmax() - boxes[i].xmin(), 
+      boxes[i].ymax() - boxes[i].ymin()), 1e-6));
+  }
+
+  m_built = true;
+  if (sizes.size() == 0) { return; }
+
+  nth_element(sizes.begin(), sizes.begin() + sizes.size() / 2, sizes.end());
+  m_cellSize = sizes[sizes.size() / 2];
+  double lx(totBox.xmax() - totBox.xmin()), ly(totBox.ymax() - totBox.ymin());
+  if ((lx / m_cellSize + 1.) * (ly / m_cellSize + 1.) > (double)MAX_NUM_CELLS)
+  {
+    m_cellSize = sqrt(lx * ly / (double)MAX_NUM_CELLS) + 1e-6;
+  }
+  m_origin[0] = totBox.xmin();
+  m_origin[1] = totBox.ymin();
+  m_numCells[0] = (int)floor(lx / m_cellSize) + 1;
+  m_numCells[1] = (int)floor(ly / m_cellSize) + 1;
+  m_cells.resize(m_numCells[0] * m_numCells[1]);
+
+  // add the index of each box to the cells it intersects (in increasing order)
+  for (int i(0); i < boxes.size(); i++)
+  {
+    if ((boxes[i].xmin() > boxes[i].xmax()) || (boxes[i].ymin() > boxes[i].ymax()))
+    {
+      continue;
+    }
+    idxMin[0] = (int)floor((boxes[i].xmin() - m_origin[0]) / m_cellSize);
+    idxMin[1] = (int)floor((boxes[i].ymin() - m_origin[1]) / m_cellSize);
+    idxMax[0] = min(m_numCells[0] - 1, (int)floor((boxes[i].xmax() - m_origin[0]) / m_cellSize));
+    idxMax[1] = min(m_numCells[1] - 1, (int)floor((boxes[i].ymax() - m_origin[1]) / m_cellSize));
+    for (int cx(max(0, idxMin[0])); cx <= idxMax[0]; cx++)
+    {
+      for (int cy(max(0, idxMin[1])); cy <= idxMax[1]; cy++)
+      {
+        m_cells[cx * m_numCells[1] + cy].push_back(i);
+      }
+    }
+  }
+}
+
+// ****************************************************************************
+
+const vector<int>& SegmentGrid::candidates(double x, double y) const
+{
+  if (!(m_numCells[0] > 0)) { return m_noCandidate; }
+
+  double cx(floor((x - m_origin[0]) / m_cellSize));
+  double cy(floor((y - m_origin[1]) / m_cellSize));
+  if (!((cx >= 0.) && (cx < (double)m_numCells[0]) 
+    && (cy >= 0.) && (cy < (double)m_numCells[1])))
+  {
+    return m_noCandidate;
+  }
+
+  return m_cells[(int)cx * m_numCells[1] + (int)cy];
+}
@@ -0,0 +1,59 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#ifndef __SEGMENT_GRID_H__
+#define __SEGMENT_GRID_H__
+
+#include <vector>
+#include <CGAL/Bbox_2.h>
+
+using namespace std;
+
+// ****************************************************************************
+// Uniform grid over the bounding boxes of the segments in the sagittal plane
+// used to find quickly the segments which can contain a point: each cell 
+// stores the indexes of the segments whose bounding box intersects it.
+// ****************************************************************************
+
+class SegmentGrid
+{
+public:
+
+  SegmentGrid();
+  void build(const vector<CGAL::Bbox_2>& boxes);
+  void clear();
+  bool isBuilt() const { return m_built; }
+
+  // indexes (in increasing order) of the segments whose bounding box 
+  // may contain the point (x, y)
+  const vector<int>& candidates(double x, double y) const;
+
+private:
+
+  bool m_built;
+  double m_origin[2];
+  double m_cellSize;
+  int m_numCells[2];
+  vector<vector<int>> m_cells;
+  vector<int> m_noCandidate;
+};
+
+#endif
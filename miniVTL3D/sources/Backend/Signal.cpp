@@ -37,9 +37,39 @@ ComplexSignal::ComplexSignal(int length)
   re = NULL;
   im = NULL;
   N = 0;
+  capacity = 0;
   if (length > 0) { reset(length); }
 }
 
+// ****************************************************************************
+// Copy constructor.
+// ****************************************************************************
+
+ComplexSignal::ComplexSignal(const ComplexSignal& s)
+{
+  re = NULL;
+  im = NULL;
+  N = 0;
+  capacity = 0;
+  *this = s;
+}
+
+// ****************************************************************************
+// Move constructor: takes over the memory of s, which becomes empty.
+// ****************************************************************************
+
+ComplexSignal::ComplexSignal(ComplexSignal&& s)
+{
+  re = s.re;
+  im = s.im;
+  N = s.N;
+  capacity = s.capacity;
+  s.re = NULL;
+  s.im = NULL;
+  s.N = 0;
+  s.capacity = 0;
+}
+
 // ****************************************************************************
 // Destructor.
 // ****************************************************************************
@@ -55,19 +85,15 @@ ComplexSignal::~ComplexSignal()
 
 void ComplexSignal::reset(int length)
 {
-  if (N != length)
+  if (length < 0) { length = 0; }
+  if (length > capacity)
   {
-    if (re != NULL) { delete[] re; }
-    if (im != NULL) { delete[] im; }
-    N = length;
-    re = NULL;
-    im = NULL;
-    if (N > 0) 
-    { 
-      re = new double[N]; 
-      im = new double[N]; 
-    }
+    dispose();
+    re = allocateSignalValues<double>(length); 
+    im = allocateSignalValues<double>(length); 
+    capacity = length;
   }
+  N = length;
 
   if (N > 0) { setZero(); }
 }
@@ -80,16 +106,17 @@ void ComplexSignal::dispose()
 {
   if (re != NULL)
   {
-    delete[] re;
+    freeSignalValues(re);
     re = NULL;
   }
   if (im != NULL)
   {
-    delete[] im;
+    freeSignalValues(im);
     im = NULL;
   }
 
   N = 0;
+  capacity = 0;
 }
 
 // ****************************************************************************
@@ -113,18 +140,32 @@ void ComplexSignal::setZero()
 
 void ComplexSignal::setNewLength(int newLength)
 {
-  if (newLength != N)
+  int i;
+
+  if (newLength < 0) { newLength = 0; }
+  if (newLength > capacity)
+  {
+    // Copy the values into larger memory blocks.
+    double *newRe = allocateSignalValues<double>(newLength);
+    double *newIm = allocateSignalValues<double>(newLength);
+    if (N > 0) 
+    { 
+      memcpy(newRe, re, N*sizeof(double));
+      memcpy(newIm, im, N*sizeof(double));
+    }
+    int oldN = N;
+    dispose();
+    re = newRe;
+    im = newIm;
+    N = oldN;
+    capacity = newLength;
+  }
+
+  for (i=N; i < newLength; i++)
   {
-    ComplexSignal copy = *this;
-    reset(newLength);
-  
-    int length = newLength;
-    if (copy.N < length) { length = copy.N; }
-
-    // Werte rberkopieren ********************************
-    memcpy(re, copy.re, length*sizeof(double));
-    memcpy(im, copy.im, length*sizeof(double));
+    re[i] = im[i] = 0.0;
   }
+  N = newLength;
 }
 
 // ****************************************************************************
@@ -248,17 +289,63 @@ double ComplexSignal::getImaginaryPart(int pos)
 // Operators.
 // ****************************************************************************
 
-void ComplexSignal::operator=(ComplexSignal& s)
+ComplexSignal& ComplexSignal::operator=(const ComplexSignal& s)
 {
-  reset(s.N);
-  if (re != NULL) 
+  if (&s == this) { return *this; }
+
+  if (s.N > capacity) { reset(s.N); }
+  N = s.N;
+  if (N > 0) 
   { 
     memcpy(re, s.re, N*sizeof(double)); 
-  }
-  if (im != NULL) 
-  { 
     memcpy(im, s.im, N*sizeof(double)); 
   }
+  return *this;
+}
+
+// ****************************************************************************
+
+ComplexSignal& ComplexSignal::operator=(ComplexSignal&& s)
+{
+  if (&s == this) { return *this; }
+
+  dispose();
+  re = s.re;
+  im = s.im;
+  N = s.N;
+  capacity = s.capacity;
+  s.re = NULL;
+  s.im = NULL;
+  s.N = 0;
+  s.capacity = 0;
+  return *this;
+}
+
+// ****************************************************************************
+// Views of length real or imaginary parts from startPos on (until the end of 
+// the signal for length < 0). The range is limited to the signal.
+// ****************************************************************************
+
+SignalView<double> ComplexSignal::getRealView(int startPos, int length)
+{
+  SignalView<double> view;
+
+  if (startPos < 0) { startPos = 0; }
+  if (startPos > N) { startPos = N; }
+  if ((length < 0) || (startPos + length > N)) { length = N - startPos; }
+
+  view.x = re + startPos;
+  view.N = length;
+  return view;
+}
+
+// ****************************************************************************
+
+SignalView<double> ComplexSignal::getImaginaryView(int startPos, int length)
+{
+  SignalView<double> view = getRealView(startPos, length);
+  view.x = im + (view.x - re);
+  return view;
 }
 
 // ****************************************************************************
@@ -24,18 +24,73 @@
 
 #include <complex>
 #include <cstring>
+#include <cstdlib>
+#include <new>
+#ifdef _WIN32
+  #include <malloc.h>
+#endif
 
 typedef std::complex<double> ComplexValue;
 
+// Alignment of the signal values in bytes (a cache line, and enough for
+// all SIMD instruction sets).
+const int SIGNAL_ALIGNMENT = 64;
+
 template<class ElementType> class TemplateSignal;
 
 typedef TemplateSignal<double>       Signal;
 typedef TemplateSignal<signed short> Signal16;
 typedef TemplateSignal<int>          Signal32;
 
+// ****************************************************************************
+/// Allocates numValues values aligned on SIGNAL_ALIGNMENT bytes. The memory
+/// is not initialized and must be freed with freeSignalValues().
+// ****************************************************************************
+
+template<class ElementType> ElementType* allocateSignalValues(int numValues)
+{
+  void *p = NULL;
+  size_t numBytes = (size_t)numValues*sizeof(ElementType);
+#ifdef _WIN32
+  p = _aligned_malloc(numBytes, SIGNAL_ALIGNMENT);
+#else
+  if (posix_memalign(&p, SIGNAL_ALIGNMENT, numBytes) != 0) { p = NULL; }
+#endif
+  if (p == NULL) { throw std::bad_alloc(); }
+  return (ElementType*)p;
+}
+
+// ****************************************************************************
+
+inline void freeSignalValues(void *p)
+{
+#ifdef _WIN32
+  _aligned_free(p);
+#else
+  free(p);
+#endif
+}
+
+// ****************************************************************************
+/// Non-owning view of a range of consecutive signal values.
+// ****************************************************************************
+
+template<class ElementType> struct SignalView
+{
+  ElementType* x;
+  int N;
+
+  ElementType& operator[](int index) const { return x[index]; }
+  ElementType* begin() const { return x; }
+  ElementType* end() const { return x + N; }
+};
+
 
 // ****************************************************************************
 // Template for signals with different element types.
+// The values are aligned on SIGNAL_ALIGNMENT bytes. A signal keeps its memory
+// when it gets shorter, so that a later reset() or setNewLength() up to the
+// capacity does not allocate.
 // ****************************************************************************
 
 template<class ElementType> class TemplateSignal
@@ -45,6 +100,8 @@ template<class ElementType> class TemplateSignal
     ElementType* x;      // The values
 
     TemplateSignal(int length = 0);
+    TemplateSignal(const TemplateSignal<ElementType>& s);
+    TemplateSignal(TemplateSignal<ElementType>&& s);
     ~TemplateSignal();
 
     void reset(int length);
@@ -59,12 +116,19 @@ template<class ElementType> class TemplateSignal
 
     void writeTo(TemplateSignal<ElementType>& s, int startPos, bool wrap=true);
 
+    int getCapacity() const { return capacity; }
+    SignalView<ElementType> getView(int startPos = 0, int length = -1);
+
     // Operators **************************************************************
 
-    void operator=(TemplateSignal<ElementType>& s);
+    TemplateSignal<ElementType>& operator=(const TemplateSignal<ElementType>& s);
+    TemplateSignal<ElementType>& operator=(TemplateSignal<ElementType>&& s);
     void operator+=(TemplateSignal<ElementType>& s);
     void operator*=(TemplateSignal<ElementType>& s);
     void operator*=(double factor);
+
+  private:
+    int capacity;        // Number of allocated values
 };
 
 
@@ -80,6 +144,8 @@ class ComplexSignal
     double* im;     // Imaginary value parts
 
     ComplexSignal(int length = 0);
+    ComplexSignal(const ComplexSignal& s);
+    ComplexSignal(ComplexSignal&& s);
     ~ComplexSignal();
 
     void reset(int length);
@@ -97,12 +163,20 @@ class ComplexSignal
     double getRealPart(int pos);
     double getImaginaryPart(int pos);
 
+    int getCapacity() const { return capacity; }
+    SignalView<double> getRealView(int startPos = 0, int length = -1);
+    SignalView<double> getImaginaryView(int startPos = 0, int length = -1);
+
     // Operators **************************************************************
 
-    void operator=(ComplexSignal& s);
+    ComplexSignal& operator=(const ComplexSignal& s);
+    ComplexSignal& operator=(ComplexSignal&& s);
     void operator+=(ComplexSignal& s);
     void operator*=(ComplexSignal& s);
     void operator*=(double factor);
+
+  private:
+    int capacity;   // Number of allocated values of re[] and im[]
 };
 
 
@@ -119,9 +193,36 @@ template<class ElementType> TemplateSignal<ElementType>::TemplateSignal(int leng
 {
   x = NULL;
   N = 0;
+  capacity = 0;
   if (length > 0) { reset(length); }
 }
 
+// ****************************************************************************
+// Copy constructor.
+// ****************************************************************************
+
+template<class ElementType> TemplateSignal<ElementType>::TemplateSignal(const TemplateSignal<ElementType>& s)
+{
+  x = NULL;
+  N = 0;
+  capacity = 0;
+  *this = s;
+}
+
+// ****************************************************************************
+// Move constructor: takes over the memory of s, which becomes empty.
+// ****************************************************************************
+
+template<class ElementType> TemplateSignal<ElementType>::TemplateSignal(TemplateSignal<ElementType>&& s)
+{
+  x = s.x;
+  N = s.N;
+  capacity = s.capacity;
+  s.x = NULL;
+  s.N = 0;
+  s.capacity = 0;
+}
+
 // ****************************************************************************
 // Destructor.
 // ****************************************************************************
@@ -137,13 +238,16 @@ template<class ElementType> TemplateSignal<ElementType>::~TemplateSignal()
 
 template<class ElementType> void TemplateSignal<ElementType>::reset(int length)
 {
-  if (N != length)
+  if (length < 0) { length = 0; }
+  if (length > capacity)
   {
-    if (x != NULL) { delete[] x; }
-    N = length;
+    if (x != NULL) { freeSignalValues(x); }
     x = NULL;
-    if (N > 0) { x = new ElementType[N]; }
+    capacity = 0;
+    x = allocateSignalValues<ElementType>(length);
+    capacity = length;
   }
+  N = length;
 
   // Initialize with zeros.
   if (N > 0) { setZero(); }
@@ -157,10 +261,11 @@ template<class ElementType> void TemplateSignal<ElementType>::dispose()
 {
   if (x != NULL)
   {
-    delete[] x;
+    freeSignalValues(x);
     x = NULL;
   }
   N = 0;
+  capacity = 0;
 }
 
 // ****************************************************************************
@@ -181,17 +286,21 @@ template<class ElementType> void TemplateSignal<ElementType>::setZero()
 
 template<class ElementType> void TemplateSignal<ElementType>::setNewLength(int newLength)
 {
-  if (newLength != N)
-  {
-    TemplateSignal<ElementType> copy = *this;
-    reset(newLength);
-  
-    int length = newLength;
-    if (copy.N < length) { length = copy.N; }
+  int i;
 
-    // Copy values.
-    memcpy(x, copy.x, length*sizeof(ElementType));
+  if (newLength < 0) { newLength = 0; }
+  if (newLength > capacity)
+  {
+    // Copy the values into a larger memory block.
+    ElementType *newX = allocateSignalValues<ElementType>(newLength);
+    if (N > 0) { memcpy(newX, x, N*sizeof(ElementType)); }
+    if (x != NULL) { freeSignalValues(x); }
+    x = newX;
+    capacity = newLength;
   }
+
+  for (i=N; i < newLength; i++) { x[i] = (ElementType)0; }
+  N = newLength;
 }
 
 // ****************************************************************************
@@ -298,17 +407,58 @@ template<class ElementType> void TemplateSignal<ElementType>::writeTo(TemplateSi
 
 }
 
+// ****************************************************************************
+// Returns a view of length values from startPos on (until the end of the 
+// signal for length < 0). The range is limited to the signal.
+// ****************************************************************************
+
+template<class ElementType> SignalView<ElementType> TemplateSignal<ElementType>::getView(int startPos, int length)
+{
+  SignalView<ElementType> view;
+
+  if (startPos < 0) { startPos = 0; }
+  if (startPos > N) { startPos = N; }
+  if ((length < 0) || (startPos + length > N)) { length = N - startPos; }
+
+  view.x = x + startPos;
+  view.N = length;
+  return view;
+}
+
 // ****************************************************************************
 // This signal becomes the copy of the signal on the right side of the "=".
 // ****************************************************************************
 
-template<class ElementType> void TemplateSignal<ElementType>::operator=(TemplateSignal<ElementType>& s)
+template<class ElementType> TemplateSignal<ElementType>& TemplateSignal<ElementType>::operator=(const TemplateSignal<ElementType>& s)
 {
-  reset(s.N);
-  if (x != NULL) 
+  if (&s == this) { return *this; }
+
+  if (s.N > capacity) { reset(s.N); }
+  N = s.N;
+  if (N > 0) 
   { 
     memcpy(x, s.x, N*sizeof(ElementType)); 
   }
+  return *this;
+}
+
+// ****************************************************************************
+// This signal takes over the memory of the signal on the right side of the 
+// "=", which becomes empty.
+// ****************************************************************************
+
+template<class ElementType> TemplateSignal<ElementType>& TemplateSignal<ElementType>::operator=(TemplateSignal<ElementType>&& s)
+{
+  if (&s == this) { return *this; }
+
+  dispose();
+  x = s.x;
+  N = s.N;
+  capacity = s.capacity;
+  s.x = NULL;
+  s.N = 0;
+  s.capacity = 0;
+  return *this;
 }
 
 // ****************************************************************************
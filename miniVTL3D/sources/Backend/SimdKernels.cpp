@@ -0,0 +1,88 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+
+#include "SimdKernels.h"
+#include <cmath>
+
+// ****************************************************************************
+
+string simdTarget()
+{
+#if defined(__GNUC__) && defined(__x86_64__) && defined(__linux__) && !defined(NO_CPU_DISPATCH)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) { return "avx512f"; }
+  if (__builtin_cpu_supports("avx2")) { return "avx2"; }
+  if (__builtin_cpu_supports("sse4.2")) { return "sse4.2"; }
+#endif
+  return "generic";
+}
+
+// ****************************************************************************
+
+CPU_DISPATCH
+void multiplyComplex(const complex<double>* a, const complex<double>* b,
+  complex<double>* c, int n)
+{
+  const double* pa(reinterpret_cast<const double*>(a));
+  const double* pb(reinterpret_cast<const double*>(b));
+  double* pc(reinterpret_cast<double*>(c));
+  double re, im;
+
+  for (int i(0); i < n; i++)
+  {
+    re = pa[2 * i] * pb[2 * i] - pa[2 * i + 1] * pb[2 * i + 1];
+    im = pa[2 * i] * pb[2 * i + 1] + pa[2 * i + 1] * pb[2 * i];
+    pc[2 * i] = re;
+    pc[2 * i + 1] = im;
+  }
+}
+
+// ****************************************************************************
+
+CPU_DISPATCH
+void multiplyAccumulateSplit(const double* aRe, const double* aIm,
+  const double* bRe, const double* bIm, double* cRe, double* cIm, int n)
+{
+  for (int i(0); i < n; i++)
+  {
+    cRe[i] += aRe[i] * bRe[i] - aIm[i] * bIm[i];
+    cIm[i] += aRe[i] * bIm[i] + aIm[i] * bRe[i];
+  }
+}
+
+// ****************************************************************************
+// The square roots are only vectorized if the file is compiled without 
+// math errno (see CMakeLists.txt), the argument is never negative.
+
+CPU_DISPATCH
+void pointDistances(const double* x2, const double* y, const double* z,
+  double y0, double z0, double* r, int n)
+{
+  double dy, dz;
+
+  for (int i(0); i < n; i++)
+  {
+    dy = y[i] - y0;
+    dz = z[i] - z0;
+    r[i] = sqrt(x2[i] + dy * dy + dz * dz);
+  }
+}
@@ -0,0 +1,70 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+
+#ifndef __SIMD_KERNELS_H__
+#define __SIMD_KERNELS_H__
+
+#include <complex>
+#include <string>
+
+using namespace std;
+
+// ****************************************************************************
+// Kernels of the hot loops on complex values. With GCC or Clang on x86-64 
+// Linux, the functions declared with CPU_DISPATCH are compiled for AVX-512, 
+// AVX2, SSE4.2 and the generic target, and the version matching the CPU is
+// selected when the program is loaded, so that the same binary uses the 
+// widest vectors available. With the other compilers (or if NO_CPU_DISPATCH
+// is defined) only the generic version is compiled.
+// The complex values are handled as pairs of double values, so that the 
+// products are not checked for infinite and NaN values as the ones of 
+// complex<double>.
+// ****************************************************************************
+
+#if defined(__GNUC__) && defined(__x86_64__) && defined(__linux__) && !defined(NO_CPU_DISPATCH)
+#define CPU_DISPATCH __attribute__((target_clones("avx512f", "avx2", "sse4.2", "default")))
+#else
+#define CPU_DISPATCH
+#endif
+
+// Instruction set of the versions selected on this CPU ("avx512f", "avx2",
+// "sse4.2" or "generic").
+
+string simdTarget();
+
+// c[i] = a[i] * b[i] for i = 0 ... n - 1 (c can be a or b).
+
+void multiplyComplex(const complex<double>* a, const complex<double>* b,
+  complex<double>* c, int n);
+
+// c[i] += a[i] * b[i] for i = 0 ... n - 1, with the real and imaginary parts
+// in separate arrays.
+
+void multiplyAccumulateSplit(const double* aRe, const double* aIm,
+  const double* bRe, const double* bIm, double* cRe, double* cIm, int n);
+
+// r[i] = sqrt(x2[i] + (y[i] - y0)^2 + (z[i] - z0)^2) for i = 0 ... n - 1.
+
+void pointDistances(const double* x2, const double* y, const double* z,
+  double y0, double z0, double* r, int n);
+
+#endif
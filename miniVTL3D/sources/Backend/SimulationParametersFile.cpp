@@ -0,0 +1,441 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#include "SimulationParametersFile.h"
+#include "Constants.h"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cmath>
+
+// ****************************************************************************
+// Names of the values of the enumerations used in the parameter file
+
+static const char* propagationMethodNames[] = { "MAGNUS", "STRAIGHT_TUBES" };
+static const char* physicalQuantityNames[] = { "IMPEDANCE", "ADMITTANCE", 
+  "PRESSURE", "VELOCITY" };
+static const char* integrationMethodRadiationNames[] = { "DISCRETE", "GAUSS" };
+static const char* integrationMethodRadImpedNames[] = { "POLAR_GRID", 
+  "FFT_CONVOLUTION" };
+static const char* openEndBoundaryCondNames[] = { "RADIATION", 
+  "IFINITE_WAVGUIDE", "HARD_WALL", "ADMITTANCE_1", "ZERO_PRESSURE" };
+
+// ****************************************************************************
+// Get the index of the name of an enumeration value (-1 if not found)
+
+static int enumIndex(const string& value, const char* names[], int numNames)
+{
+  for (int i(0); i < numNames; i++)
+  {
+    if (value == names[i]) { return i; }
+  }
+  return -1;
+}
+
+// ****************************************************************************
+
+static string trim(const string& str)
+{
+  size_t first(str.find_first_not_of(" \t\r"));
+  if (first == string::npos) { return ""; }
+  size_t last(str.find_last_not_of(" \t\r"));
+  return str.substr(first, last - first + 1);
+}
+
+// ****************************************************************************
+// Read the values of a line, the whole value must be consumed
+
+template <typename T>
+static bool readValue(istringstream& iss, T& val)
+{
+  iss >> val;
+  return !iss.fail();
+}
+
+static bool readValue(istringstream& iss, bool& val)
+{
+  string str;
+  iss >> str;
+  if ((str == "true") || (str == "1")) { val = true; }
+  else if ((str == "false") || (str == "0")) { val = false; }
+  else { return false; }
+  return true;
+}
+
+static bool readEnd(istringstream& iss)
+{
+  string rest;
+  iss >> rest;
+  return rest.empty();
+}
+
+// ****************************************************************************
+// Setup corresponding to the current parameters of a simulation
+
+struct simulationSetup getSimulationSetup(const Acoustic3dSimulation& simu)
+{
+  struct simulationSetup setup;
+  setup.meshDensity = simu.meshDensity();
+  setup.idxSecNoiseSource = simu.idxSecNoiseSource();
+  setup.noiseSourceSections = simu.noiseSourceSections();
+  setup.extraGlottisBoundaryConds = simu.extraGlottisBoundaryConds();
+  setup.mouthBoundaryCond = simu.mouthBoundaryCond();
+  setup.simuParams = simu.simuParams();
+  setup.bboxSpecified = false;
+  return setup;
+}
+
+// ****************************************************************************
+// Set the parameters of a simulation using an imported geometry 
+
+void applySimulationSetup(Acoustic3dSimulation& simu,
+  const struct simulationSetup& setup)
+{
+  simu.setSimulationParameters(setup.meshDensity, setup.idxSecNoiseSource,
+    setup.simuParams, setup.mouthBoundaryCond, FROM_FILE);
+  simu.setNoiseSourceSections(setup.noiseSourceSections);
+  simu.setExtraGlottisBoundaryConds(setup.extraGlottisBoundaryConds);
+}
+
+// ****************************************************************************
+// Read a parameter file. The setup is modified only if the whole file is 
+// valid, otherwise the error message gives the faulty line.
+
+bool readSimulationParametersFile(const string& fileName,
+  struct simulationSetup& setup, string& error)
+{
+  ifstream ifs(fileName);
+  if (!ifs.is_open())
+  {
+    error = "Cannot open the parameter file " + fileName;
+    return false;
+  }
+
+  struct simulationSetup newSetup(setup);
+  struct simulationParameters& p(newSetup.simuParams);
+  bool temperatureGiven(false), sndSpeedGiven(false), tfPointGiven(false),
+    noiseSourceGiven(false), glottisCondGiven(false);
+  string line;
+  int numLine(0);
+
+  while (getline(ifs, line))
+  {
+    numLine++;
+    line = line.substr(0, line.find('#'));
+    if (trim(line).empty()) { continue; }
+
+    stringstream lineError;
+    lineError << fileName << ", line " << numLine << ": ";
+
+    size_t posEq(line.find('='));
+    if (posEq == string::npos)
+    {
+      error = lineError.str() + "missing '='";
+      return false;
+    }
+    string key(trim(line.substr(0, posEq)));
+    string value(trim(line.substr(posEq + 1)));
+    istringstream iss(value);
+    bool ok(true);
+    int idx;
+    string name;
+
+    if (key == "meshDensity") { ok = readValue(iss, newSetup.meshDensity); }
+    else if (key == "idxSecNoiseSource") { ok = readValue(iss, newSetup.idxSecNoiseSource); }
+    else if (key == "noiseSourceSection")
+    {
+      ok = readValue(iss, idx) && (idx >= 0);
+      if (ok)
+      {
+        // the sections of the file replace the current ones
+        if (!noiseSourceGiven) { newSetup.noiseSourceSections.clear(); }
+        newSetup.noiseSourceSections.push_back(idx);
+        noiseSourceGiven = true;
+      }
+    }
+    else if (key == "extraGlottisBoundaryCond")
+    {
+      ok = readValue(iss, name) && ((idx = enumIndex(name, openEndBoundaryCondNames, 5)) >= 0)
+        && ((idx == HARD_WALL) || (idx == IFINITE_WAVGUIDE));
+      if (ok)
+      {
+        // the conditions of the file replace the current ones
+        if (!glottisCondGiven) { newSetup.extraGlottisBoundaryConds.clear(); }
+        newSetup.extraGlottisBoundaryConds.push_back((enum openEndBoundaryCond)idx);
+        glottisCondGiven = true;
+      }
+    }
+    else if (key == "mouthBoundaryCond")
+    {
+      ok = readValue(iss, name) && ((idx = enumIndex(name, openEndBoundaryCondNames, 5)) >= 0);
+      if (ok) { newSetup.mouthBoundaryCond = (enum openEndBoundaryCond)idx; }
+    }
+    else if (key == "temperature")
+    {
+      ok = readValue(iss, p.temperature);
+      temperatureGiven = true;
+      sndSpeedGiven = false;
+    }
+    else if (key == "sndSpeed")
+    {
+      ok = readValue(iss, p.sndSpeed);
+      sndSpeedGiven = true;
+      temperatureGiven = false;
+    }
+    else if (key == "numIntegrationStep") { ok = readValue(iss, p.numIntegrationStep); }
+    else if (key == "orderMagnusScheme") { ok = readValue(iss, p.orderMagnusScheme); }
+    else if (key == "maxCutOnFreq") { ok = readValue(iss, p.maxCutOnFreq); }
+    else if (key == "freqDependentModes") { ok = readValue(iss, p.freqDependentModes); }
+    else if (key == "modesFreqFactor") { ok = readValue(iss, p.modesFreqFactor); }
+    else if (key == "modesFreqMargin") { ok = readValue(iss, p.modesFreqMargin); }
+    else if (key == "hybridPlaneWave") { ok = readValue(iss, p.hybridPlaneWave); }
+    else if (key == "hybridCrossoverFactor") 
+    { 
+      ok = readValue(iss, p.hybridCrossoverFactor) && (p.hybridCrossoverFactor > 0.); 
+    }
+    else if (key == "hybridBlendWidth") 
+    { 
+      ok = readValue(iss, p.hybridBlendWidth) && (p.hybridBlendWidth >= 0.); 
+    }
+    else if (key == "shareScaledModes") { ok = readValue(iss, p.shareScaledModes); }
+    else if (key == "adaptiveMeshDensity") { ok = readValue(iss, p.adaptiveMeshDensity); }
+    else if (key == "meshFreqAccuracy") { ok = readValue(iss, p.meshFreqAccuracy); }
+    else if (key == "analyticModes") { ok = readValue(iss, p.analyticModes); }
+    else if (key == "warmStartModes") { ok = readValue(iss, p.warmStartModes); }
+    else if (key == "coarseningTolerance") { ok = readValue(iss, p.coarseningTolerance); }
+    else if (key == "floatPolygonClipping") { ok = readValue(iss, p.floatPolygonClipping); }
+    else if (key == "adaptiveIntegrationStep") { ok = readValue(iss, p.adaptiveIntegrationStep); }
+    else if (key == "integrationStepTolerance") { ok = readValue(iss, p.integrationStepTolerance); }
+    else if (key == "singlePrecisionPropagation") { ok = readValue(iss, p.singlePrecisionPropagation); }
+    else if (key == "axialCheckpointInterval") { ok = readValue(iss, p.axialCheckpointInterval); }
+    else if (key == "propMethod")
+    {
+      ok = readValue(iss, name) && ((idx = enumIndex(name, propagationMethodNames, 2)) >= 0);
+      if (ok) { p.propMethod = (enum propagationMethod)idx; }
+    }
+    else if (key == "percentageLosses") { ok = readValue(iss, p.percentageLosses); }
+    else if (key == "viscoThermalLosses") { ok = readValue(iss, p.viscoThermalLosses); }
+    else if (key == "wallLosses") { ok = readValue(iss, p.wallLosses); }
+    else if (key == "constantWallImped") { ok = readValue(iss, p.constantWallImped); }
+    else if (key == "wallAdmit")
+    {
+      double re, im;
+      ok = readValue(iss, re) && readValue(iss, im);
+      if (ok) { p.wallAdmit = complex<double>(re, im); }
+    }
+    else if (key == "curved") { ok = readValue(iss, p.curved); }
+    else if (key == "varyingArea") { ok = readValue(iss, p.varyingArea); }
+    else if (key == "junctionLosses") { ok = readValue(iss, p.junctionLosses); }
+    else if (key == "radImpedGridDensity") { ok = readValue(iss, p.radImpedGridDensity); }
+    else if (key == "integrationMethodRadiation")
+    {
+      ok = readValue(iss, name) && ((idx = enumIndex(name, integrationMethodRadiationNames, 2)) >= 0);
+      if (ok) { p.integrationMethodRadiation = (enum integrationMethodRadiation)idx; }
+    }
+    else if (key == "integrationMethodRadImped")
+    {
+      ok = readValue(iss, name) && ((idx = enumIndex(name, integrationMethodRadImpedNames, 2)) >= 0);
+      if (ok) { p.integrationMethodRadImped = (enum integrationMethodRadImped)idx; }
+    }
+    else if (key == "maxComputedFreq") { ok = readValue(iss, p.maxComputedFreq); }
+    else if (key == "spectrumLgthExponent") { ok = readValue(iss, p.spectrumLgthExponent); }
+    else if (key == "tfPoint")
+    {
+      double x, y, z;
+      ok = readValue(iss, x) && readValue(iss, y) && readValue(iss, z);
+      if (ok)
+      {
+        // the points of the file replace the current ones
+        if (!tfPointGiven) { p.tfPoint.clear(); }
+        p.tfPoint.push_back(Point_3(x, y, z));
+        tfPointGiven = true;
+      }
+    }
+    else if (key == "numThreads") { ok = readValue(iss, p.numThreads); }
+    else if (key == "memoryBudget") { ok = readValue(iss, p.memoryBudget); }
+    else if (key == "adaptiveFreqSampling") { ok = readValue(iss, p.adaptiveFreqSampling); }
+    else if (key == "adaptiveTfTolerance") { ok = readValue(iss, p.adaptiveTfTolerance); }
+    else if (key == "freqField") { ok = readValue(iss, p.freqField); }
+    else if (key == "fieldPhysicalQuantity")
+    {
+      ok = readValue(iss, name) && ((idx = enumIndex(name, physicalQuantityNames, 4)) >= 0);
+      if (ok) { p.fieldPhysicalQuantity = (enum physicalQuantity)idx; }
+    }
+    else if (key == "showAmplitude") { ok = readValue(iss, p.showAmplitude); }
+    else if (key == "fieldIndB") { ok = readValue(iss, p.fieldIndB); }
+    else if (key == "bbox")
+    {
+      double xmin, ymin, xmax, ymax;
+      ok = readValue(iss, xmin) && readValue(iss, ymin) && readValue(iss, xmax)
+        && readValue(iss, ymax) && (xmin < xmax) && (ymin < ymax);
+      if (ok)
+      {
+        p.bbox[0] = Point(xmin, ymin);
+        p.bbox[1] = Point(xmax, ymax);
+        newSetup.bboxSpecified = true;
+      }
+    }
+    else if (key == "fieldResolution") { ok = readValue(iss, p.fieldResolution); }
+    else if (key == "progressiveFieldLevels") { ok = readValue(iss, p.progressiveFieldLevels); }
+    else if (key == "fieldRefinementTolerance") { ok = readValue(iss, p.fieldRefinementTolerance); }
+    else if (key == "computeRadiatedField") { ok = readValue(iss, p.computeRadiatedField); }
+    else
+    {
+      error = lineError.str() + "unknown parameter " + key;
+      return false;
+    }
+
+    if (!ok || !readEnd(iss))
+    {
+      error = lineError.str() + "invalid value \"" + value + "\" for " + key;
+      return false;
+    }
+  }
+
+  //***************************************************************
+  // Check the values and deduce the properties of the air
+  //***************************************************************
+
+  if ((newSetup.meshDensity <= 0.) || (p.numIntegrationStep < 1) ||
+    (p.orderMagnusScheme < 1) || (p.orderMagnusScheme > 4) ||
+    (p.maxCutOnFreq <= 0.) || (p.maxComputedFreq <= 0.) ||
+    (p.modesFreqFactor < 0.) || (p.modesFreqMargin < 0.) ||
+    (p.spectrumLgthExponent < 1) || (p.spectrumLgthExponent > 20) ||
+    (p.radImpedGridDensity <= 0.) || (p.fieldResolution < 1) ||
+    (p.progressiveFieldLevels < 0) || (p.fieldRefinementTolerance < 0.) ||
+    (p.numThreads < 1) || (p.memoryBudget < 0.) || (p.adaptiveTfTolerance <= 0.) || 
+    (p.tfPoint.size() == 0))
+  {
+    error = fileName + ": parameter out of range";
+    return false;
+  }
+
+  if (temperatureGiven)
+  {
+    p.volumicMass = STATIC_PRESSURE_CGS * MOLECULAR_MASS / (GAS_CONSTANT *
+      (p.temperature + KELVIN_SHIFT));
+    p.sndSpeed = sqrt(ADIABATIC_CONSTANT * STATIC_PRESSURE_CGS / p.volumicMass);
+  }
+  else if (sndSpeedGiven)
+  {
+    p.volumicMass = ADIABATIC_CONSTANT * STATIC_PRESSURE_CGS / pow(p.sndSpeed, 2);
+    p.temperature = pow(p.sndSpeed, 2) * MOLECULAR_MASS /
+      GAS_CONSTANT / ADIABATIC_CONSTANT - KELVIN_SHIFT;
+  }
+  p.needToComputeModesAndJunctions = true;
+  p.radImpedPrecomputed = false;
+
+  setup = newSetup;
+  return true;
+}
+
+// ****************************************************************************
+// Write all the parameters of a setup in a file readable by 
+// readSimulationParametersFile
+
+bool writeSimulationParametersFile(const string& fileName,
+  const struct simulationSetup& setup)
+{
+  ofstream ofs(fileName);
+  if (!ofs.is_open()) { return false; }
+
+  const struct simulationParameters& p(setup.simuParams);
+  auto boolStr = [](bool val) { return (val ? "true" : "false"); };
+
+  ofs << setprecision(12);
+  ofs << "# Parameters of the 3D acoustic simulation" << endl;
+  ofs << "meshDensity = " << setup.meshDensity << endl;
+  ofs << "idxSecNoiseSource = " << setup.idxSecNoiseSource << endl;
+  for (auto sec : setup.noiseSourceSections)
+  {
+    ofs << "noiseSourceSection = " << sec << endl;
+  }
+  for (auto cond : setup.extraGlottisBoundaryConds)
+  {
+    ofs << "extraGlottisBoundaryCond = " << openEndBoundaryCondNames[cond] << endl;
+  }
+  ofs << "mouthBoundaryCond = " << openEndBoundaryCondNames[setup.mouthBoundaryCond] << endl;
+  ofs << "temperature = " << p.temperature << "   # deduces sndSpeed and volumicMass" << endl;
+  ofs << "numIntegrationStep = " << p.numIntegrationStep << endl;
+  ofs << "orderMagnusScheme = " << p.orderMagnusScheme << endl;
+  ofs << "maxCutOnFreq = " << p.maxCutOnFreq << endl;
+  ofs << "freqDependentModes = " << boolStr(p.freqDependentModes) << endl;
+  ofs << "modesFreqFactor = " << p.modesFreqFactor << endl;
+  ofs << "modesFreqMargin = " << p.modesFreqMargin << endl;
+  ofs << "hybridPlaneWave = " << boolStr(p.hybridPlaneWave) << endl;
+  ofs << "hybridCrossoverFactor = " << p.hybridCrossoverFactor << endl;
+  ofs << "hybridBlendWidth = " << p.hybridBlendWidth << endl;
+  ofs << "shareScaledModes = " << boolStr(p.shareScaledModes) << endl;
+  ofs << "adaptiveMeshDensity = " << boolStr(p.adaptiveMeshDensity) << endl;
+  ofs << "meshFreqAccuracy = " << p.meshFreqAccuracy << endl;
+  ofs << "analyticModes = " << boolStr(p.analyticModes) << endl;
+  ofs << "warmStartModes = " << boolStr(p.warmStartModes) << endl;
+  ofs << "coarseningTolerance = " << p.coarseningTolerance << endl;
+  ofs << "floatPolygonClipping = " << boolStr(p.floatPolygonClipping) << endl;
+  ofs << "adaptiveIntegrationStep = " << boolStr(p.adaptiveIntegrationStep) << endl;
+  ofs << "integrationStepTolerance = " << p.integrationStepTolerance << endl;
+  ofs << "singlePrecisionPropagation = " << boolStr(p.singlePrecisionPropagation) << endl;
+  ofs << "axialCheckpointInterval = " << p.axialCheckpointInterval << endl;
+  ofs << "propMethod = " << propagationMethodNames[p.propMethod] << endl;
+  ofs << "percentageLosses = " << p.percentageLosses << endl;
+  ofs << "viscoThermalLosses = " << boolStr(p.viscoThermalLosses) << endl;
+  ofs << "wallLosses = " << boolStr(p.wallLosses) << endl;
+  ofs << "constantWallImped = " << boolStr(p.constantWallImped) << endl;
+  ofs << "wallAdmit = " << p.wallAdmit.real() << " " << p.wallAdmit.imag() << endl;
+  ofs << "curved = " << boolStr(p.curved) << endl;
+  ofs << "varyingArea = " << boolStr(p.varyingArea) << endl;
+  ofs << "junctionLosses = " << boolStr(p.junctionLosses) << endl;
+  ofs << "radImpedGridDensity = " << p.radImpedGridDensity << endl;
+  ofs << "integrationMethodRadiation = " 
+    << integrationMethodRadiationNames[p.integrationMethodRadiation] << endl;
+  ofs << "integrationMethodRadImped = " 
+    << integrationMethodRadImpedNames[p.integrationMethodRadImped] << endl;
+
+  ofs << endl << "# transfer function" << endl;
+  ofs << "maxComputedFreq = " << p.maxComputedFreq << endl;
+  ofs << "spectrumLgthExponent = " << p.spectrumLgthExponent << endl;
+  for (auto pt : p.tfPoint)
+  {
+    ofs << "tfPoint = " << pt.x() << " " << pt.y() << " " << pt.z() << endl;
+  }
+  ofs << "numThreads = " << p.numThreads << endl;
+  ofs << "memoryBudget = " << p.memoryBudget << "   # MB, 0 for no limit" << endl;
+  ofs << "adaptiveFreqSampling = " << boolStr(p.adaptiveFreqSampling) << endl;
+  ofs << "adaptiveTfTolerance = " << p.adaptiveTfTolerance << "   # dB" << endl;
+
+  ofs << endl << "# acoustic field" << endl;
+  ofs << "freqField = " << p.freqField << endl;
+  ofs << "fieldPhysicalQuantity = " << physicalQuantityNames[p.fieldPhysicalQuantity] << endl;
+  ofs << "showAmplitude = " << boolStr(p.showAmplitude) << endl;
+  ofs << "fieldIndB = " << boolStr(p.fieldIndB) << endl;
+  if (setup.bboxSpecified)
+  {
+    ofs << "bbox = " << p.bbox[0].x() << " " << p.bbox[0].y() << " "
+      << p.bbox[1].x() << " " << p.bbox[1].y() << endl;
+  }
+  ofs << "fieldResolution = " << p.fieldResolution << endl;
+  ofs << "progressiveFieldLevels = " << p.progressiveFieldLevels << endl;
+  ofs << "fieldRefinementTolerance = " << p.fieldRefinementTolerance << endl;
+  ofs << "computeRadiatedField = " << boolStr(p.computeRadiatedField) << endl;
+
+  ofs.close();
+  return true;
+}
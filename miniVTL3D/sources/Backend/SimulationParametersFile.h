@@ -0,0 +1,74 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#ifndef __SIMULATION_PARAMETERS_FILE_H__
+#define __SIMULATION_PARAMETERS_FILE_H__
+
+#include "Acoustic3dSimulation.h"
+#include <string>
+
+using namespace std;
+
+// ****************************************************************************
+// Text file of the parameters of a 3D simulation, used by the command line 
+// driver. Each line has the form
+//
+//   key = value    # comment
+//
+// where the keys are the names of the fields of simulationParameters, plus
+// meshDensity, idxSecNoiseSource and mouthBoundaryCond, with the units of
+// simulationParameters (CGS, e.g. sndSpeed in cm/s). The enumerations are
+// written with the names of their values (e.g. propMethod = MAGNUS), the 
+// booleans as true/false, the complex numbers as "re im", the points as 
+// "x y z" and the bounding box as "xmin ymin xmax ymax". The key tfPoint can 
+// be repeated to define several points, and the key noiseSourceSection to 
+// define additional noise source positions computed in the same frequency 
+// sweep as the one of idxSecNoiseSource, and the key extraGlottisBoundaryCond
+// to define glottis boundary conditions (HARD_WALL or IFINITE_WAVGUIDE) whose
+// noise sources transfer functions are computed in the same sweep as the
+// ones of the glottis boundary condition. The keys which are not given keep 
+// their current value. If temperature or sndSpeed is given, the other one 
+// and the volumic mass are deduced from it as in the parameter dialog.
+// ****************************************************************************
+
+struct simulationSetup
+{
+  double meshDensity;
+  int idxSecNoiseSource;
+  vector<int> noiseSourceSections;
+  vector<enum openEndBoundaryCond> extraGlottisBoundaryConds;
+  enum openEndBoundaryCond mouthBoundaryCond;
+  struct simulationParameters simuParams;
+  bool bboxSpecified;       // true if the bounding box is given in the file
+};
+
+// setup corresponding to the current parameters of a simulation
+struct simulationSetup getSimulationSetup(const Acoustic3dSimulation& simu);
+// set the parameters of a simulation using an imported geometry 
+void applySimulationSetup(Acoustic3dSimulation& simu, 
+  const struct simulationSetup& setup);
+
+bool readSimulationParametersFile(const string& fileName, 
+  struct simulationSetup& setup, string& error);
+bool writeSimulationParametersFile(const string& fileName, 
+  const struct simulationSetup& setup);
+
+#endif
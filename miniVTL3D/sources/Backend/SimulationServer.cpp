@@ -0,0 +1,470 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#include "SimulationServer.h"
+#include "SimulationParametersFile.h"
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <cstring>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+// ****************************************************************************
+// Modification time and size of a file, empty if the file does not exist
+
+static string fileStamp(const string& fileName)
+{
+  struct stat fileStat;
+  if (stat(fileName.c_str(), &fileStat) != 0) { return ""; }
+  stringstream stamp;
+  stamp << (long long)fileStat.st_mtime << ":" << (long long)fileStat.st_size;
+  return stamp.str();
+}
+
+// ****************************************************************************
+// Reply line of a successful job
+
+static string okReply(std::chrono::system_clock::time_point start)
+{
+  std::chrono::duration<double> elapsed(std::chrono::system_clock::now() - start);
+  stringstream reply;
+  reply << "OK " << elapsed.count() << " s";
+  return reply.str();
+}
+
+// ****************************************************************************
+
+SimulationServer::SimulationServer(int capacity) :
+  m_capacity(max(1, capacity)),
+  m_hits(0),
+  m_misses(0),
+  m_stopped(false)
+{
+}
+
+// ****************************************************************************
+// Return the entry of a key, which is created (empty) if it is not cached,
+// and evict the least recently used entries beyond the capacity (the
+// entries used by a job are released at the end of the job)
+
+template <typename T>
+shared_ptr<SimulationServer::cacheEntry<T>> SimulationServer::cacheLookup(
+  lruCache<T>& cache, const string& key)
+{
+  lock_guard<mutex> lock(m_cacheMutex);
+
+  auto found(cache.index.find(key));
+  if (found != cache.index.end())
+  {
+    cache.entries.splice(cache.entries.begin(), cache.entries, found->second);
+    return cache.entries.front().second;
+  }
+
+  cache.entries.push_front({ key, make_shared<cacheEntry<T>>() });
+  cache.index[key] = cache.entries.begin();
+  while ((int)cache.entries.size() > m_capacity)
+  {
+    cache.index.erase(cache.entries.back().first);
+    cache.entries.pop_back();
+  }
+  return cache.entries.front().second;
+}
+
+// ****************************************************************************
+
+template <typename T>
+void SimulationServer::cacheRemove(lruCache<T>& cache, const string& key)
+{
+  lock_guard<mutex> lock(m_cacheMutex);
+
+  auto found(cache.index.find(key));
+  if (found != cache.index.end())
+  {
+    cache.entries.erase(found->second);
+    cache.index.erase(found);
+  }
+}
+
+// ****************************************************************************
+// Set the parameters and import the geometry of a simulation, in the same
+// way as the command line driver
+
+bool SimulationServer::loadSimulation(Acoustic3dSimulation& simu,
+  const string& geometryFile, const string& paramFile, string& error)
+{
+  struct simulationSetup setup(getSimulationSetup(simu));
+  if ((paramFile != "-") && !readSimulationParametersFile(paramFile, setup, error))
+  {
+    return false;
+  }
+  applySimulationSetup(simu, setup);
+
+  // the vocal tract is not used for an imported geometry
+  simu.requestReloadGeometry();
+  simu.setGeometryImported(true);
+  simu.setContourInterpolationMethod(FROM_FILE);
+  simu.setGeometryFile(geometryFile);
+  if (!simu.importGeometry(NULL) || (simu.numberOfSegments() == 0))
+  {
+    error = "Cannot import the geometry " + geometryFile;
+    return false;
+  }
+
+  // the import sets the bounding box of the field to the one of the geometry
+  if (setup.bboxSpecified)
+  {
+    pair<Point2D, Point2D> bbox(
+      Point2D(setup.simuParams.bbox[0].x(), setup.simuParams.bbox[0].y()),
+      Point2D(setup.simuParams.bbox[1].x(), setup.simuParams.bbox[1].y()));
+    simu.setBoundingBox(bbox);
+  }
+  return true;
+}
+
+// ****************************************************************************
+
+string SimulationServer::synthesize(const string& speakerFile,
+  const string& sequenceFile, const string& wavFile)
+{
+  auto start(std::chrono::system_clock::now());
+
+  string stamp(fileStamp(speakerFile));
+  if (stamp == "") { return "ERROR Cannot open " + speakerFile; }
+
+  shared_ptr<cacheEntry<speaker>> entry(cacheLookup(m_speakers, speakerFile));
+  lock_guard<mutex> lock(entry->inUse);
+
+  if (entry->value && (entry->stamp == stamp)) { m_hits++; }
+  else
+  {
+    m_misses++;
+    entry->value.reset();
+    VtlContext* context(vtlCreateContext(speakerFile.c_str()));
+    if (context == NULL)
+    {
+      cacheRemove(m_speakers, speakerFile);
+      return "ERROR Cannot load the speaker " + speakerFile;
+    }
+    entry->value.reset(new speaker(context));
+    entry->stamp = stamp;
+  }
+
+  if (vtlTractSequenceToAudioCtx(entry->value->context, sequenceFile.c_str(),
+    wavFile.c_str(), NULL, NULL) != 0)
+  {
+    return "ERROR Cannot synthesize " + sequenceFile + " into " + wavFile;
+  }
+  return okReply(start);
+}
+
+// ****************************************************************************
+// Log file of a job, next to its output file: the jobs running at the same 
+// time each have their own log
+
+static string jobLogFileName(const string& outputFile)
+{
+  size_t end(outputFile.find_last_of('.'));
+  size_t dir(outputFile.find_last_of("/\\"));
+  if ((end != string::npos) && (dir != string::npos) && (end < dir))
+  {
+    end = string::npos;
+  }
+  return outputFile.substr(0, end) + ".log";
+}
+
+// ****************************************************************************
+// The simulation of a geometry is kept with its modes, junction matrices and
+// radiation impedance, which are not computed again by the next jobs
+
+shared_ptr<SimulationServer::cacheEntry<Acoustic3dSimulation>> 
+  SimulationServer::lockSimulation(const string& geometryFile, 
+  const string& paramFile, unique_lock<mutex>& lock, string& error)
+{
+  string stamp(fileStamp(geometryFile) + "|" +
+    ((paramFile == "-") ? string("-") : fileStamp(paramFile)));
+  string key(geometryFile + "|" + paramFile);
+
+  shared_ptr<cacheEntry<Acoustic3dSimulation>> entry(cacheLookup(m_simulations, key));
+  lock = unique_lock<mutex>(entry->inUse);
+
+  if (entry->value && (entry->stamp == stamp)) { m_hits++; }
+  else
+  {
+    m_misses++;
+    entry->value.reset(new Acoustic3dSimulation);
+    if (!loadSimulation(*entry->value, geometryFile, paramFile, error))
+    {
+      entry->value.reset();
+      cacheRemove(m_simulations, key);
+      lock.unlock();
+      return nullptr;
+    }
+    entry->stamp = stamp;
+  }
+  return entry;
+}
+
+// ****************************************************************************
+
+string SimulationServer::transferFunction(const string& geometryFile,
+  const string& paramFile, const string& outputFile, const string& type)
+{
+  auto start(std::chrono::system_clock::now());
+
+  enum tfType tf;
+  if (type == "glottal") { tf = GLOTTAL; }
+  else if (type == "noise") { tf = NOISE; }
+  else if (type == "imped") { tf = INPUT_IMPED; }
+  else { return "ERROR Unknown transfer function " + type; }
+
+  // the entry outlives the lock of its mutex
+  shared_ptr<cacheEntry<Acoustic3dSimulation>> entry;
+  unique_lock<mutex> lock;
+  string error;
+  entry = lockSimulation(geometryFile, paramFile, lock, error);
+  if (!entry) { return "ERROR " + error; }
+
+  Acoustic3dSimulation& simu(*entry->value);
+  simu.setLogFile(jobLogFileName(outputFile));
+  simu.computeTransferFunction(NULL);
+  if (!simu.exportTransferFucntions(outputFile, tf))
+  {
+    return "ERROR Cannot export the transfer function in " + outputFile;
+  }
+  return okReply(start);
+}
+
+// ****************************************************************************
+
+string SimulationServer::acousticField(const string& geometryFile,
+  const string& paramFile, double freq, const string& outputFile)
+{
+  auto start(std::chrono::system_clock::now());
+
+  // the entry outlives the lock of its mutex
+  shared_ptr<cacheEntry<Acoustic3dSimulation>> entry;
+  unique_lock<mutex> lock;
+  string error;
+  entry = lockSimulation(geometryFile, paramFile, lock, error);
+  if (!entry) { return "ERROR " + error; }
+
+  Acoustic3dSimulation& simu(*entry->value);
+  simu.setLogFile(jobLogFileName(outputFile));
+  simu.setAcousticFieldFreq(freq);
+  simu.computeAcousticField(NULL);
+  if (!simu.exportAcousticField(outputFile))
+  {
+    return "ERROR Cannot export the acoustic field in " + outputFile;
+  }
+  return okReply(start);
+}
+
+// ****************************************************************************
+
+string SimulationServer::handleRequest(const string& request, bool& closeConnection)
+{
+  stringstream line(request);
+  vector<string> args;
+  string arg;
+  while (line >> quoted(arg)) { args.push_back(arg); }
+  closeConnection = false;
+  if (args.empty()) { return "ERROR Empty request"; }
+
+  const string& command(args[0]);
+  int numArgs(args.size() - 1);
+
+  if ((command == "quit") || (command == "shutdown"))
+  {
+    closeConnection = true;
+    if (command == "shutdown") { m_stopped = true; }
+    return "OK";
+  }
+
+  try
+  {
+    if ((command == "synthesize") && (numArgs == 3))
+    {
+      return synthesize(args[1], args[2], args[3]);
+    }
+    else if ((command == "tf") && ((numArgs == 3) || (numArgs == 4)))
+    {
+      return transferFunction(args[1], args[2], args[3],
+        (numArgs == 4) ? args[4] : string("glottal"));
+    }
+    else if ((command == "field") && (numArgs == 4))
+    {
+      return acousticField(args[1], args[2], atof(args[3].c_str()), args[4]);
+    }
+    else if ((command == "stats") && (numArgs == 0))
+    {
+      lock_guard<mutex> lock(m_cacheMutex);
+      stringstream reply;
+      reply << "OK speakers " << m_speakers.entries.size()
+        << " simulations " << m_simulations.entries.size()
+        << " capacity " << m_capacity
+        << " hits " << m_hits << " misses " << m_misses;
+      return reply.str();
+    }
+    else if ((command == "clear") && (numArgs == 0))
+    {
+      // the entries used by running jobs are released at the end of the jobs
+      lock_guard<mutex> lock(m_cacheMutex);
+      m_speakers.entries.clear();
+      m_speakers.index.clear();
+      m_simulations.entries.clear();
+      m_simulations.index.clear();
+      CrossSection2dRadiation::clearMemoisedModes();
+      return "OK";
+    }
+  }
+  catch (std::string st)
+  {
+    return "ERROR " + st;
+  }
+  catch (std::exception& e)
+  {
+    return string("ERROR ") + e.what();
+  }
+
+  return "ERROR Unknown request " + request;
+}
+
+// ****************************************************************************
+
+void SimulationServer::serveStream(istream& input, ostream& output)
+{
+  string request;
+  bool closeConnection(false);
+  while (!closeConnection && !m_stopped && getline(input, request))
+  {
+    if (!request.empty() && (request.back() == '\r')) { request.pop_back(); }
+    if (request.find_first_not_of(" \t") == string::npos) { continue; }
+    output << handleRequest(request, closeConnection) << endl;
+  }
+}
+
+// ****************************************************************************
+
+#ifndef _WIN32
+
+// Answer the jobs of a connected client: the lines are read from the socket
+// and the replies sent back as soon as they are computed (the socket is 
+// polled so that the connection is closed when the server stops)
+
+static void serveClient(SimulationServer* server, int client)
+{
+  string buffer;
+  char data[4096];
+  bool closeConnection(false);
+  while (!closeConnection && !server->isStopped())
+  {
+    struct pollfd pending = { client, POLLIN, 0 };
+    if (poll(&pending, 1, 200) <= 0) { continue; }
+    ssize_t numRead(recv(client, data, sizeof(data), 0));
+    if (numRead <= 0) { break; }
+    buffer.append(data, numRead);
+
+    size_t end;
+    while (!closeConnection && ((end = buffer.find('\n')) != string::npos))
+    {
+      string request(buffer.substr(0, end));
+      buffer.erase(0, end + 1);
+      if (!request.empty() && (request.back() == '\r')) { request.pop_back(); }
+      if (request.find_first_not_of(" \t") == string::npos) { continue; }
+
+      string reply(server->handleRequest(request, closeConnection) + "\n");
+      if (send(client, reply.data(), reply.size(), MSG_NOSIGNAL) < 0)
+      {
+        closeConnection = true;
+      }
+    }
+  }
+  close(client);
+}
+
+#endif
+
+// ****************************************************************************
+
+bool SimulationServer::run(const string& address, string& error)
+{
+  if (address == "-")
+  {
+    serveStream(cin, cout);
+    return true;
+  }
+
+#ifdef _WIN32
+  error = "The local sockets are not available on Windows: use the address -";
+  return false;
+#else
+  struct sockaddr_un socketAddress;
+  if (address.size() >= sizeof(socketAddress.sun_path))
+  {
+    error = "The socket path " + address + " is too long";
+    return false;
+  }
+
+  int listener(socket(AF_UNIX, SOCK_STREAM, 0));
+  if (listener < 0)
+  {
+    error = "Cannot create the socket";
+    return false;
+  }
+  memset(&socketAddress, 0, sizeof(socketAddress));
+  socketAddress.sun_family = AF_UNIX;
+  strcpy(socketAddress.sun_path, address.c_str());
+  unlink(address.c_str());
+  if ((::bind(listener, (struct sockaddr*)&socketAddress, sizeof(socketAddress)) != 0) ||
+    (listen(listener, SOMAXCONN) != 0))
+  {
+    error = "Cannot listen on the socket " + address;
+    close(listener);
+    return false;
+  }
+
+  // the listener is polled so that the shutdown requested by a client stops
+  // the server
+  vector<thread> clients;
+  while (!m_stopped)
+  {
+    struct pollfd pending = { listener, POLLIN, 0 };
+    if (poll(&pending, 1, 200) <= 0) { continue; }
+    int client(accept(listener, NULL, NULL));
+    if (client >= 0) { clients.push_back(thread(serveClient, this, client)); }
+  }
+
+  close(listener);
+  unlink(address.c_str());
+  for (auto& client : clients) { client.join(); }
+  return true;
+#endif
+}
@@ -0,0 +1,145 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#ifndef __SIMULATION_SERVER_H__
+#define __SIMULATION_SERVER_H__
+
+#include "Acoustic3dSimulation.h"
+#include "VocalTractLabApi.h"
+#include <string>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <iostream>
+
+using namespace std;
+
+// ****************************************************************************
+// Long-running server of the simulations, which keeps the speakers and the
+// simulations of the geometries loaded between the jobs, so that the jobs
+// do not pay again the loading of the speaker file, the import of the
+// geometry and the computation of the modes, junction matrices and
+// radiation impedance when they share them.
+//
+// The jobs are sent as text lines, one job per line, with the arguments
+// separated by spaces (file names containing spaces can be quoted):
+//   synthesize speaker.speaker tractSequence.txt output.wav
+//   tf geometry.csv parameters.txt output.txt [glottal|noise|imped]
+//   field geometry.csv parameters.txt freq output.txt
+//   stats      the number of cached entries, of hits and of misses
+//   clear      release all the cached entries and the memoised radiation modes
+//   quit       close the connection
+//   shutdown   close the connection and stop the server
+// Each job is answered with one line starting with "OK" or "ERROR",
+// followed by the elapsed time or the error message. The parameter file "-"
+// keeps the default parameters. The library writes its messages on the
+// standard output, so that the clients of the standard input and output
+// skip the lines which do not start with "OK" or "ERROR".
+//
+// The speakers are cached by file name and the simulations by geometry and
+// parameter file names, in least recently used caches of a given capacity.
+// A cached entry is reloaded when one of its files was modified. The jobs
+// of the same entry run one after the other, the other jobs run
+// concurrently, and all the computations share the thread pool of the
+// library (see ParallelLoop.h). The log of the simulation of each job is
+// written next to its output file, with the extension .log.
+// ****************************************************************************
+
+class SimulationServer
+{
+public:
+  // capacity: maximal number of cached speakers and of cached simulations
+  SimulationServer(int capacity);
+
+  // handle a job line and return the reply line (without end of line),
+  // closeConnection is set for "quit" and "shutdown"
+  string handleRequest(const string& request, bool& closeConnection);
+
+  // answer the jobs read from the input stream until "quit", "shutdown" or
+  // the end of the stream
+  void serveStream(istream& input, ostream& output);
+
+  // serve the jobs of the standard input if address is "-", otherwise of
+  // the clients of the local (Unix domain) socket with the path address,
+  // each client in its own thread, until a client sends "shutdown"
+  // (the sockets are not available on Windows)
+  bool run(const string& address, string& error);
+
+  bool isStopped() const { return m_stopped; }
+
+private:
+  // a cached speaker or simulation: the mutex is held by the job using it,
+  // the stamp identifies the version of the files it was loaded from
+  template <typename T>
+  struct cacheEntry
+  {
+    mutex inUse;
+    string stamp;
+    unique_ptr<T> value;
+  };
+
+  // least recently used cache (the most recent entry first)
+  template <typename T>
+  struct lruCache
+  {
+    list<pair<string, shared_ptr<cacheEntry<T>>>> entries;
+    map<string, typename list<pair<string, shared_ptr<cacheEntry<T>>>>::iterator> index;
+  };
+
+  struct speaker
+  {
+    VtlContext* context;
+    speaker(VtlContext* ctx) : context(ctx) {}
+    ~speaker() { vtlCloseContext(context); }
+  };
+
+  template <typename T>
+  shared_ptr<cacheEntry<T>> cacheLookup(lruCache<T>& cache, const string& key);
+  template <typename T>
+  void cacheRemove(lruCache<T>& cache, const string& key);
+
+  bool loadSimulation(Acoustic3dSimulation& simu, const string& geometryFile,
+    const string& paramFile, string& error);
+  // the cached simulation of a geometry and a parameter file, locked for
+  // the job, which is loaded if it is not cached or its files were modified
+  shared_ptr<cacheEntry<Acoustic3dSimulation>> lockSimulation(
+    const string& geometryFile, const string& paramFile,
+    unique_lock<mutex>& lock, string& error);
+
+  string synthesize(const string& speakerFile, const string& sequenceFile,
+    const string& wavFile);
+  string transferFunction(const string& geometryFile, const string& paramFile,
+    const string& outputFile, const string& type);
+  string acousticField(const string& geometryFile, const string& paramFile,
+    double freq, const string& outputFile);
+
+  int m_capacity;
+  mutex m_cacheMutex;
+  lruCache<speaker> m_speakers;
+  lruCache<Acoustic3dSimulation> m_simulations;
+  atomic<int> m_hits;
+  atomic<int> m_misses;
+  atomic<bool> m_stopped;
+};
+
+#endif
@@ -22,6 +22,99 @@
 #include "SoundLib.h"
 #include <cstdio>
 #include <memory>
+#include <algorithm>
+#include <thread>
+#include <chrono>
+
+// The streams are played from a ring of STREAM_NUM_BUFFERS buffers of 
+// STREAM_BUFFER_LENGTH samples (about 23 ms at 44100 Hz), which a thread 
+// refills from the queue of samples every STREAM_POLL_INTERVAL_MS ms.
+
+namespace
+{
+  const int STREAM_NUM_BUFFERS = 4;
+  const int STREAM_BUFFER_LENGTH = 1024;
+  const int STREAM_POLL_INTERVAL_MS = 5;
+}
+
+
+// ----------------------------------------------------------------------------
+// Queue of samples of the streams.
+// ----------------------------------------------------------------------------
+
+SampleQueue::SampleQueue(int capacity) :
+  buffer(max(capacity, 1)),
+  readPos(0),
+  writePos(0),
+  closed(false),
+  aborted(false)
+{
+}
+
+// ****************************************************************************
+// Pushes as many of the numSamples samples as there is free space for and 
+// returns their number (producer thread only).
+// ****************************************************************************
+
+int SampleQueue::push(const signed short *data, int numSamples)
+{
+  size_t write = writePos.load(memory_order_relaxed);
+  size_t read = readPos.load(memory_order_acquire);
+  int n = min(numSamples, (int)(buffer.size() - (write - read)));
+
+  for (int i = 0; i < n; i++)
+  {
+    buffer[(write + i) % buffer.size()] = data[i];
+  }
+  writePos.store(write + n, memory_order_release);
+
+  return n;
+}
+
+// ****************************************************************************
+// Pushes all the samples, waiting for free space if necessary. Returns false
+// if the playback aborted the queue before.
+// ****************************************************************************
+
+bool SampleQueue::write(const signed short *data, int numSamples)
+{
+  while (numSamples > 0)
+  {
+    if (aborted)
+    {
+      return false;
+    }
+    int n = push(data, numSamples);
+    data += n;
+    numSamples -= n;
+    if (numSamples > 0)
+    {
+      this_thread::sleep_for(chrono::milliseconds(STREAM_POLL_INTERVAL_MS));
+    }
+  }
+
+  return true;
+}
+
+// ****************************************************************************
+// Pops at most maxSamples samples and returns their number (consumer thread 
+// only).
+// ****************************************************************************
+
+int SampleQueue::pop(signed short *data, int maxSamples)
+{
+  size_t read = readPos.load(memory_order_relaxed);
+  size_t write = writePos.load(memory_order_acquire);
+  int n = min(maxSamples, (int)(write - read));
+
+  for (int i = 0; i < n; i++)
+  {
+    data[i] = buffer[(read + i) % buffer.size()];
+  }
+  readPos.store(read + n, memory_order_release);
+
+  return n;
+}
 
 
 // ----------------------------------------------------------------------------
@@ -42,6 +135,8 @@ namespace
     virtual ~SoundWinMM();
     virtual bool init(int samplingRate);
     virtual bool startPlayingWave(signed short *data, int numSamples, bool loop);
+    virtual bool startPlayingStream(SampleQueue *queue);
+    virtual bool isPlayingStream();
     virtual bool stopPlaying();
     virtual bool startRecordingWave(signed short *data, int numSamples);
     virtual bool stopRecording();
@@ -49,6 +144,7 @@ namespace
   private:
     void initWaveformInputDevice(WAVEFORMATEX format);
     void initWaveformOutputDevice(WAVEFORMATEX format);
+    void feedStream();
 
     WAVEFORMATEX waveformat;
     WAVEHDR waveOutHdr;
@@ -60,6 +156,15 @@ namespace
     bool isRecording;
     bool playingInitialized;
     bool recordingInitialized;
+
+    // Playback of streams
+    WAVEHDR streamHdr[STREAM_NUM_BUFFERS];
+    vector<signed short> streamData[STREAM_NUM_BUFFERS];
+    bool streamHdrQueued[STREAM_NUM_BUFFERS];
+    SampleQueue *streamQueue;
+    thread streamThread;
+    atomic<bool> streamRunning;
+    bool isStreaming;
   };
 }
 
@@ -75,8 +180,16 @@ SoundWinMM::SoundWinMM() :
   isPlaying(false),
   isRecording(false),
   playingInitialized(false),
-  recordingInitialized(false)
+  recordingInitialized(false),
+  streamQueue(NULL),
+  streamRunning(false),
+  isStreaming(false)
 {
+  for (int k = 0; k < STREAM_NUM_BUFFERS; k++)
+  {
+    streamData[k].resize(STREAM_BUFFER_LENGTH);
+    streamHdrQueued[k] = false;
+  }
 }
 
 // ****************************************************************************
@@ -145,6 +258,7 @@ void SoundWinMM::initWaveformOutputDevice(WAVEFORMATEX format)
 
 SoundWinMM::~SoundWinMM()
 {
+  if (isStreaming) { stopPlaying(); }
   if (playingInitialized) { waveOutClose(hWaveOut); }
   if (recordingInitialized) { waveInClose(hWaveIn); }
 }
@@ -188,14 +302,120 @@ bool SoundWinMM::stopPlaying()
 {
   if (playingInitialized == false) { return false; }
 
+  if (isStreaming)
+  {
+    // The producer must not wait for the samples that will not be played.
+    streamQueue->abort();
+    streamRunning = false;
+    if (streamThread.joinable()) { streamThread.join(); }
+  }
+
   waveOutReset(hWaveOut);     // Stoppt die Wiedergabe
-  waveOutUnprepareHeader(hWaveOut, &waveOutHdr, sizeof(WAVEHDR));
+
+  if (isStreaming)
+  {
+    for (int k = 0; k < STREAM_NUM_BUFFERS; k++)
+    {
+      if (streamHdrQueued[k])
+      {
+        waveOutUnprepareHeader(hWaveOut, &streamHdr[k], sizeof(WAVEHDR));
+        streamHdrQueued[k] = false;
+      }
+    }
+    streamQueue = NULL;
+    isStreaming = false;
+  }
+  else
+  {
+    waveOutUnprepareHeader(hWaveOut, &waveOutHdr, sizeof(WAVEHDR));
+  }
 
   isPlaying = false;
 
   return true;
 }
 
+// ****************************************************************************
+// Starts to play back the samples of the queue as they are pushed into it.
+// ****************************************************************************
+
+bool SoundWinMM::startPlayingStream(SampleQueue *queue)
+{
+  if ((playingInitialized == false) || (queue == NULL)) { return false; }
+
+  if (isPlaying) { stopPlaying(); }
+
+  streamQueue = queue;
+  isStreaming = true;
+  isPlaying = true;
+  streamRunning = true;
+  streamThread = thread(&SoundWinMM::feedStream, this);
+
+  return true;
+}
+
+// ****************************************************************************
+// Returns true until all the samples of a closed queue have been played.
+// ****************************************************************************
+
+bool SoundWinMM::isPlayingStream()
+{
+  return isStreaming && streamRunning;
+}
+
+// ****************************************************************************
+// Thread writing the blocks of the queue to the output device in the 
+// buffers which have already been played.
+// ****************************************************************************
+
+void SoundWinMM::feedStream()
+{
+  while (streamRunning)
+  {
+    int numQueued = 0;
+
+    for (int k = 0; k < STREAM_NUM_BUFFERS; k++)
+    {
+      if ((streamHdrQueued[k]) && (streamHdr[k].dwFlags & WHDR_DONE))
+      {
+        waveOutUnprepareHeader(hWaveOut, &streamHdr[k], sizeof(WAVEHDR));
+        streamHdrQueued[k] = false;
+      }
+
+      // Only full blocks are written, except the last one of the stream.
+      if ((!streamHdrQueued[k]) && ((streamQueue->size() >= STREAM_BUFFER_LENGTH) ||
+        (streamQueue->isClosed() && (streamQueue->size() > 0))))
+      {
+        int n = streamQueue->pop(&streamData[k][0], STREAM_BUFFER_LENGTH);
+
+        streamHdr[k].lpData = (LPSTR)&streamData[k][0];
+        streamHdr[k].dwBufferLength = n*2;
+        streamHdr[k].dwBytesRecorded = 0;
+        streamHdr[k].dwUser = 0;
+        streamHdr[k].dwFlags = 0;
+        streamHdr[k].dwLoops = 1;
+        streamHdr[k].lpNext = NULL;
+        streamHdr[k].reserved = 0;
+
+        waveOutPrepareHeader(hWaveOut, &streamHdr[k], sizeof(WAVEHDR));
+        waveOutWrite(hWaveOut, &streamHdr[k], sizeof(WAVEHDR));
+        streamHdrQueued[k] = true;
+      }
+
+      if (streamHdrQueued[k]) { numQueued++; }
+    }
+
+    if ((numQueued == 0) && (streamQueue->isFinished()))
+    {
+      break;
+    }
+
+    this_thread::sleep_for(chrono::milliseconds(STREAM_POLL_INTERVAL_MS));
+  }
+
+  streamRunning = false;
+}
+
 // ****************************************************************************
 // Starts recording into a ring buffer.
 // ****************************************************************************
@@ -277,11 +497,15 @@ namespace
     virtual ~SoundOpenAL();
     virtual bool init(int samplingRate);
     virtual bool startPlayingWave(signed short *data, int numSamples, bool loop);
+    virtual bool startPlayingStream(SampleQueue *queue);
+    virtual bool isPlayingStream();
     virtual bool stopPlaying();
     virtual bool startRecordingWave(signed short *data, int numSamples);
     virtual bool stopRecording();
 
   private:
+    void feedStream();
+
     ALCcontext *ctx;
     ALCdevice *devCapture;
     ALCvoid *dataCapture;
@@ -292,6 +516,13 @@ namespace
     bool isPlaying;
     bool isRecording;
     bool isInitialized;
+
+    // Playback of streams
+    ALuint streamBufs[STREAM_NUM_BUFFERS];
+    SampleQueue *streamQueue;
+    thread streamThread;
+    atomic<bool> streamRunning;
+    bool isStreaming;
   };
 }
 
@@ -309,7 +540,10 @@ SoundOpenAL::SoundOpenAL() :
   hasCaptureExt(false),
   isPlaying(false),
   isRecording(false),
-  isInitialized(false)
+  isInitialized(false),
+  streamQueue(NULL),
+  streamRunning(false),
+  isStreaming(false)
 {
 }
 
@@ -374,6 +608,13 @@ bool SoundOpenAL::init(int samplingRate)
     return false;
   }
 
+  alGenBuffers(STREAM_NUM_BUFFERS, streamBufs);
+  if (alGetError() != AL_NO_ERROR)
+  {
+    fprintf(stderr, "Failed to create the sound buffers of streams.\n");
+    return false;
+  }
+
   isInitialized = true;
 
   return true;
@@ -390,8 +631,9 @@ SoundOpenAL::~SoundOpenAL()
   {
     stopPlaying();
     stopRecording();
-    alDeleteBuffers(1, &buf);
     alDeleteSources(1, &src);
+    alDeleteBuffers(1, &buf);
+    alDeleteBuffers(STREAM_NUM_BUFFERS, streamBufs);
     dev = alcGetContextsDevice(ctx);
     alcMakeContextCurrent(NULL);
     alcDestroyContext(ctx);
@@ -462,7 +704,18 @@ bool SoundOpenAL::stopPlaying()
 
   if (isPlaying)
   {
-    ALuint tmpBuf;
+    ALuint tmpBufs[STREAM_NUM_BUFFERS];
+    ALint numProcessed = 0;
+
+    if (isStreaming)
+    {
+      // The producer must not wait for the samples that will not be played.
+      streamQueue->abort();
+      streamRunning = false;
+      if (streamThread.joinable()) { streamThread.join(); }
+      streamQueue = NULL;
+      isStreaming = false;
+    }
 
     alSourceStop(src);
 
@@ -473,7 +726,9 @@ bool SoundOpenAL::stopPlaying()
       return false;
     }
 
-    alSourceUnqueueBuffers(src, 1, &tmpBuf);
+    // All the queued buffers are processed once the source is stopped.
+    alGetSourcei(src, AL_BUFFERS_PROCESSED, &numProcessed);
+    alSourceUnqueueBuffers(src, numProcessed, tmpBufs);
     if (alGetError() != AL_NO_ERROR)
     {
       fprintf(stderr, "Failed to remove sound buffer from queue.\n");
@@ -486,6 +741,107 @@ bool SoundOpenAL::stopPlaying()
   return true;
 }
 
+// ****************************************************************************
+// Starts to play back the samples of the queue as they are pushed into it.
+// ****************************************************************************
+
+bool SoundOpenAL::startPlayingStream(SampleQueue *queue)
+{
+  if ((!isInitialized) || (queue == NULL))
+  {
+    return false;
+  }
+
+  if (!stopPlaying())
+  {
+    return false;
+  }
+
+  alSourcei(src, AL_LOOPING, AL_FALSE);
+  if (alGetError() != AL_NO_ERROR)
+  {
+    fprintf(stderr, "Failed to unset looping mode.\n");
+    return false;
+  }
+
+  streamQueue = queue;
+  isStreaming = true;
+  isPlaying = true;
+  streamRunning = true;
+  streamThread = thread(&SoundOpenAL::feedStream, this);
+
+  return true;
+}
+
+// ****************************************************************************
+// Returns true until all the samples of a closed queue have been played.
+// ****************************************************************************
+
+bool SoundOpenAL::isPlayingStream()
+{
+  return isStreaming && streamRunning;
+}
+
+// ****************************************************************************
+// Thread refilling the buffers already played with the blocks of the queue,
+// and (re)starting the source when it ran out of samples.
+// ****************************************************************************
+
+void SoundOpenAL::feedStream()
+{
+  vector<signed short> block(STREAM_BUFFER_LENGTH);
+  vector<ALuint> freeBufs(streamBufs, streamBufs + STREAM_NUM_BUFFERS);
+
+  while (streamRunning)
+  {
+    ALint numProcessed = 0;
+    ALint numQueued = 0;
+    ALint state;
+
+    alGetSourcei(src, AL_BUFFERS_PROCESSED, &numProcessed);
+    for (int k = 0; k < numProcessed; k++)
+    {
+      ALuint tmpBuf;
+      alSourceUnqueueBuffers(src, 1, &tmpBuf);
+      freeBufs.push_back(tmpBuf);
+    }
+
+    // Only full blocks are queued, except the last one of the stream.
+    while ((!freeBufs.empty()) && ((streamQueue->size() >= STREAM_BUFFER_LENGTH) ||
+      (streamQueue->isClosed() && (streamQueue->size() > 0))))
+    {
+      int n = streamQueue->pop(&block[0], STREAM_BUFFER_LENGTH);
+      alBufferData(freeBufs.back(), AL_FORMAT_MONO16, &block[0], n * 2, samplingRate);
+      alSourceQueueBuffers(src, 1, &freeBufs.back());
+      if (alGetError() != AL_NO_ERROR)
+      {
+        fprintf(stderr, "Failed to queue sound buffer for playing.\n");
+        streamRunning = false;
+        return;
+      }
+      freeBufs.pop_back();
+    }
+
+    alGetSourcei(src, AL_SOURCE_STATE, &state);
+    if (state != AL_PLAYING)
+    {
+      alGetSourcei(src, AL_BUFFERS_QUEUED, &numQueued);
+      if (numQueued > 0)
+      {
+        alSourcePlay(src);
+      }
+      else if (streamQueue->isFinished())
+      {
+        break;
+      }
+    }
+
+    this_thread::sleep_for(chrono::milliseconds(STREAM_POLL_INTERVAL_MS));
+  }
+
+  streamRunning = false;
+}
+
 // ****************************************************************************
 // Starts recording into a ring buffer.
 // ****************************************************************************
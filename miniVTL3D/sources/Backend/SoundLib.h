@@ -23,11 +23,50 @@
 #define __SOUND_LIB__
 
 #include <string>
+#include <vector>
+#include <atomic>
 #include "Signal.h"
 #include "Dsp.h"
 
 using namespace std;
 
+// ****************************************************************************
+// Lock-free queue of samples between a single producer thread (e.g. a 
+// synthesis) and the playback of a stream (see startPlayingStream()).
+// The producer pushes its samples block by block and closes the queue at 
+// the end of the signal; the playback stops when the queue is finished, 
+// and aborts the queue when it is stopped so that the producer does not 
+// wait for free space forever. The queue must remain valid until 
+// stopPlaying() is called.
+// ****************************************************************************
+
+class SampleQueue
+{
+public:
+  SampleQueue(int capacity);
+
+  // Producer side
+  int push(const signed short *data, int numSamples);
+  bool write(const signed short *data, int numSamples);
+  void close() { closed = true; }
+
+  // Consumer side
+  int pop(signed short *data, int maxSamples);
+  void abort() { aborted = true; }
+
+  int size() const { return (int)(writePos - readPos); }
+  bool isClosed() const { return closed; }
+  bool isAborted() const { return aborted; }
+  bool isFinished() const { return closed && (size() == 0); }
+
+private:
+  vector<signed short> buffer;
+  atomic<size_t> readPos;
+  atomic<size_t> writePos;
+  atomic<bool> closed;
+  atomic<bool> aborted;
+};
+
 // ****************************************************************************
 
 class SoundInterface
@@ -36,6 +75,8 @@ public:
   virtual ~SoundInterface() {}
   virtual bool init(int samplingRate) = 0;
   virtual bool startPlayingWave(signed short *data, int numSamples, bool loop = false) = 0;
+  virtual bool startPlayingStream(SampleQueue *queue) = 0;
+  virtual bool isPlayingStream() = 0;
   virtual bool stopPlaying() = 0;
   virtual bool startRecordingWave(signed short *data, int numSamples) = 0;
   virtual bool stopRecording() = 0;
@@ -57,6 +98,16 @@ inline bool waveStartPlaying(signed short *data, int numSamples, bool loop)
   return SoundInterface::getInstance()->startPlayingWave(data, numSamples, loop);
 }
 
+inline bool waveStartPlayingStream(SampleQueue *queue)
+{
+  return SoundInterface::getInstance()->startPlayingStream(queue);
+}
+
+inline bool waveIsPlayingStream()
+{
+  return SoundInterface::getInstance()->isPlayingStream();
+}
+
 inline bool waveStopPlaying()
 {
   return SoundInterface::getInstance()->stopPlaying();
@@ -0,0 +1,146 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#include "SparseEigenSolver.h"
+#include <Eigen/SparseCholesky>
+#include <Eigen/Eigenvalues>
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+using namespace std;
+
+// maximal number of iterations of the subspace iteration
+static const int MAX_ITERATIONS = 300;
+// relative residual to reach for the wanted eigenpairs
+static const double RESIDUAL_TOLERANCE = 1e-10;
+
+// ****************************************************************************
+
+bool sparseGeneralizedEigenSolve(const SparseMatD& K, const SparseMatD& M,
+  double maxEigenValue, int minNumEig, int numEigEstimate,
+  Eigen::VectorXd& eigVal, Eigen::MatrixXd& eigVec,
+  const Eigen::MatrixXd* initialSubspace)
+{
+  int n(K.rows());
+  int numWanted, numConverged;
+  double res, scale;
+  Eigen::MatrixXd X, KX, MX, Kr, Mr;
+  Eigen::VectorXd theta;
+
+  // shift of the spectrum: K - sigma M is positive definite even if K is 
+  // singular (zero eigenvalue of the plane mode) 
+  double sigma(-max(1e-3, 0.05 * maxEigenValue));
+
+  // factorise the shifted operator
+  SparseMatD shifted(K - sigma * M);
+  Eigen::SimplicialLDLT<SparseMatD> solver(shifted);
+  if (solver.info() != Eigen::Success) { return false; }
+
+  // size of the subspace, large enough to separate the wanted eigenvalues
+  // from the following ones
+  int numEig(max(max(minNumEig, numEigEstimate), 1));
+  int p(min(n, max(2 * numEig, numEig + 8)));
+
+  // deterministic pseudo random starting subspace, whose first vectors are
+  // the ones of the initial subspace if it is given
+  mt19937 gen(1);
+  uniform_real_distribution<double> distrib(-1., 1.);
+  X.resize(n, p);
+  int numInit(0);
+  if ((initialSubspace != nullptr) && (initialSubspace->rows() == n))
+  {
+    numInit = min((int)initialSubspace->cols(), p);
+    X.leftCols(numInit) = initialSubspace->leftCols(numInit);
+  }
+  for (int j(numInit); j < p; j++)
+  {
+    for (int i(0); i < n; i++) { X(i, j) = distrib(gen); }
+  }
+  // orthonormalise the initial vectors, which can be close to dependent
+  if (numInit > 0)
+  {
+    Eigen::HouseholderQR<Eigen::MatrixXd> qr(X);
+    X = qr.householderQ() * Eigen::MatrixXd::Identity(n, p);
+  }
+
+  for (int it(0); it < MAX_ITERATIONS; it++)
+  {
+    // apply the shift-invert operator
+    MX = M * X;
+    X = solver.solve(MX);
+
+    // Rayleigh-Ritz projection
+    KX = K * X;
+    MX = M * X;
+    Kr = X.transpose() * KX;
+    Mr = X.transpose() * MX;
+    Kr = 0.5 * (Kr + Kr.transpose()).eval();
+    Mr = 0.5 * (Mr + Mr.transpose()).eval();
+    Eigen::GeneralizedSelfAdjointEigenSolver<Eigen::MatrixXd> ritz(Kr, Mr);
+    if (ritz.info() != Eigen::Success) { return false; }
+    theta = ritz.eigenvalues();
+    X = X * ritz.eigenvectors();
+    KX = KX * ritz.eigenvectors();
+    MX = MX * ritz.eigenvectors();
+
+    // number of wanted eigenpairs
+    numWanted = 0;
+    while ((numWanted < p) && ((theta(numWanted) < maxEigenValue) || 
+      (numWanted < minNumEig)))
+    {
+      numWanted++;
+    }
+
+    // if the subspace is too small to be sure to get all of the wanted
+    // eigenvalues, enlarge it and continue with the current Ritz vectors
+    if ((numWanted > p - max(4, p / 4)) && (p < n))
+    {
+      int newP(min(n, 2 * p));
+      X.conservativeResize(n, newP);
+      for (int j(p); j < newP; j++)
+      {
+        for (int i(0); i < n; i++) { X(i, j) = distrib(gen); }
+      }
+      p = newP;
+      continue;
+    }
+
+    // check the convergence of the wanted eigenpairs
+    numConverged = 0;
+    for (int j(0); j < numWanted; j++)
+    {
+      scale = KX.col(j).norm() + (abs(theta(j)) + abs(sigma)) * MX.col(j).norm();
+      res = (KX.col(j) - theta(j) * MX.col(j)).norm();
+      if (res <= RESIDUAL_TOLERANCE * scale) { numConverged++; }
+      else { break; }
+    }
+
+    if (numConverged == numWanted)
+    {
+      eigVal = theta.head(numWanted);
+      eigVec = X.leftCols(numWanted);
+      return true;
+    }
+  }
+
+  return false;
+}
@@ -0,0 +1,60 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#ifndef __SPARSE_EIGEN_SOLVER_H__
+#define __SPARSE_EIGEN_SOLVER_H__
+
+#include <Eigen/Dense>
+#include <Eigen/Sparse>
+
+typedef Eigen::SparseMatrix<double> SparseMatD;
+
+// below this number of vertices the dense eigensolver is used
+const int SPARSE_EIGEN_SOLVER_MIN_VERTICES = 200;
+
+// ****************************************************************************
+// Compute the smallest eigenvalues and the corresponding eigenvectors of the 
+// generalized eigenproblem K x = lambda M x, where K is sparse symmetric 
+// positive semi-definite and M sparse symmetric positive definite (FEM 
+// stiffness and mass matrices).
+//
+// All the eigenpairs with an eigenvalue lower than maxEigenValue are computed,
+// and at least minNumEig of them. numEigEstimate is an estimation of the number
+// of eigenvalues to compute (to size the subspace, it is increased if needed).
+// 
+// The eigenpairs are obtained by a shift-invert subspace iteration with a 
+// Rayleigh-Ritz projection at each iteration, so that only a sparse 
+// factorisation of K - sigma M is needed. The eigenvalues are returned in 
+// ascending order and the eigenvectors are M-normalised, like with the dense 
+// Eigen::GeneralizedSelfAdjointEigenSolver.
+// If initialSubspace is given, its columns (e.g. the modes of a similar 
+// problem interpolated on this mesh) start the subspace instead of random 
+// vectors, which reduces the number of iterations when they are close to 
+// the wanted eigenvectors.
+// Returns false if the iteration did not converge.
+// ****************************************************************************
+
+bool sparseGeneralizedEigenSolve(const SparseMatD& K, const SparseMatD& M,
+  double maxEigenValue, int minNumEig, int numEigEstimate,
+  Eigen::VectorXd& eigVal, Eigen::MatrixXd& eigVec,
+  const Eigen::MatrixXd* initialSubspace = nullptr);
+
+#endif
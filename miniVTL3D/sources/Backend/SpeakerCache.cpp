@@ -0,0 +1,393 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#include "SpeakerCache.h"
+#include <fstream>
+#include <cstring>
+
+// ****************************************************************************
+// Layout of the snapshot (native byte order):
+//
+//   magic "VTLSPKC1", version, speaker hash, sizeof(Anatomy), NUM_PARAMS
+//   the raw Anatomy structure
+//   NUM_PARAMS x (abbr, min, max, neutral, x, limitedX)
+//   number of shapes, then (name, NUM_PARAMS values) per shape
+//   selected glottis, number of glottis models, then per glottis model:
+//     name, number of static params, their values, number of control 
+//     params, number of shapes, then (name, control param values) per shape
+//
+// Strings are stored as a 32 bit length followed by the chars.
+// ****************************************************************************
+
+static const char SPEAKER_CACHE_MAGIC[8] = { 'V', 'T', 'L', 'S', 'P', 'K', 'C', '1' };
+static const int32_t SPEAKER_CACHE_VERSION = 1;
+
+// ****************************************************************************
+/// Sequential reader of the bytes of a snapshot. All reads fail once the 
+/// end of the data was passed.
+// ****************************************************************************
+
+class SpeakerCacheReader
+{
+public:
+  SpeakerCacheReader(const string &data) : data(data), pos(0), ok(true) {}
+
+  bool read(void *value, size_t numBytes)
+  {
+    if ((ok == false) || (pos + numBytes > data.size()))
+    {
+      ok = false;
+      return false;
+    }
+    memcpy(value, data.data() + pos, numBytes);
+    pos += numBytes;
+    return true;
+  }
+
+  template<typename T> bool read(T &value) { return read(&value, sizeof(T)); }
+
+  bool readString(string &st)
+  {
+    uint32_t length = 0;
+    if ((read(length) == false) || (pos + length > data.size()))
+    {
+      ok = false;
+      return false;
+    }
+    st.assign(data, pos, length);
+    pos += length;
+    return true;
+  }
+
+  bool atEnd() const { return ok && (pos == data.size()); }
+
+  const string &data;
+  size_t pos;
+  bool ok;
+};
+
+// ****************************************************************************
+
+template<typename T> static void writeValue(ostream &os, const T &value)
+{
+  os.write((const char*)&value, sizeof(T));
+}
+
+static void writeString(ostream &os, const string &st)
+{
+  writeValue(os, (uint32_t)st.size());
+  os.write(st.data(), st.size());
+}
+
+
+// ****************************************************************************
+/// Returns the 64 bit FNV-1a hash of the given speaker file text.
+// ****************************************************************************
+
+uint64_t speakerFileHash(const string &speakerText)
+{
+  uint64_t hash = 14695981039346656037ULL;
+  size_t i;
+  for (i=0; i < speakerText.size(); i++)
+  {
+    hash ^= (unsigned char)speakerText[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+
+// ****************************************************************************
+/// Writes the snapshot of the speaker data currently in the vocal tract and
+/// glottis models into the given file. speakerHash is the hash of the 
+/// speaker file text the data were read from.
+// ****************************************************************************
+
+bool writeSpeakerCache(const string &cacheFileName, uint64_t speakerHash,
+  VocalTract *vocalTract, Glottis *glottis[], int numGlottisModels, 
+  int selectedGlottis)
+{
+  int i, k;
+
+  ofstream os(cacheFileName.c_str(), ios::binary);
+  if (!os)
+  {
+    return false;
+  }
+
+  os.write(SPEAKER_CACHE_MAGIC, sizeof(SPEAKER_CACHE_MAGIC));
+  writeValue(os, SPEAKER_CACHE_VERSION);
+  writeValue(os, speakerHash);
+  writeValue(os, (uint32_t)sizeof(VocalTract::Anatomy));
+  writeValue(os, (int32_t)VocalTract::NUM_PARAMS);
+
+  // ****************************************************************
+  // Vocal tract model.
+  // ****************************************************************
+
+  os.write((const char*)&vocalTract->anatomy, sizeof(VocalTract::Anatomy));
+
+  for (i=0; i < VocalTract::NUM_PARAMS; i++)
+  {
+    VocalTract::Param &p = vocalTract->param[i];
+    writeString(os, p.abbr);
+    writeValue(os, p.min);
+    writeValue(os, p.max);
+    writeValue(os, p.neutral);
+    writeValue(os, p.x);
+    writeValue(os, p.limitedX);
+  }
+
+  writeValue(os, (int32_t)vocalTract->shapes.size());
+  for (i=0; i < (int)vocalTract->shapes.size(); i++)
+  {
+    writeString(os, vocalTract->shapes[i].name);
+    os.write((const char*)vocalTract->shapes[i].param, 
+      sizeof(vocalTract->shapes[i].param));
+  }
+
+  // ****************************************************************
+  // Glottis models.
+  // ****************************************************************
+
+  writeValue(os, (int32_t)selectedGlottis);
+  writeValue(os, (int32_t)numGlottisModels);
+
+  for (i=0; i < numGlottisModels; i++)
+  {
+    Glottis *g = glottis[i];
+    writeString(os, g->getName());
+
+    writeValue(os, (int32_t)g->staticParam.size());
+    for (k=0; k < (int)g->staticParam.size(); k++)
+    {
+      writeValue(os, g->staticParam[k].x);
+    }
+
+    writeValue(os, (int32_t)g->controlParam.size());
+    writeValue(os, (int32_t)g->shape.size());
+    for (k=0; k < (int)g->shape.size(); k++)
+    {
+      writeString(os, g->shape[k].name);
+      os.write((const char*)g->shape[k].controlParam.data(), 
+        g->controlParam.size() * sizeof(double));
+    }
+  }
+
+  os.close();
+  return !os.fail();
+}
+
+
+// ****************************************************************************
+/// Restores the speaker data from the snapshot in the given file into the
+/// vocal tract and glottis models, if the snapshot was made from a speaker 
+/// file text with the hash speakerHash and for the same models. The models
+/// are only changed when the whole snapshot is valid. Like after reading a 
+/// speaker file, the reference surfaces and the glottis geometries are 
+/// recalculated, but the vocal tract is not: call calculateAll() to do so.
+// ****************************************************************************
+
+bool readSpeakerCache(const string &cacheFileName, uint64_t speakerHash,
+  VocalTract *vocalTract, Glottis *glottis[], int numGlottisModels, 
+  int &selectedGlottis)
+{
+  int i, k;
+
+  // ****************************************************************
+  // Read the whole file at once.
+  // ****************************************************************
+
+  ifstream is(cacheFileName.c_str(), ios::binary);
+  if (!is)
+  {
+    return false;
+  }
+  string data;
+  is.seekg(0, ios::end);
+  streamoff fileSize = is.tellg();
+  is.seekg(0, ios::beg);
+  if (fileSize <= 0)
+  {
+    return false;
+  }
+  data.resize((size_t)fileSize);
+  is.read(&data[0], data.size());
+  if ((size_t)is.gcount() != data.size())
+  {
+    return false;
+  }
+  is.close();
+
+  // ****************************************************************
+  // Check the header.
+  // ****************************************************************
+
+  SpeakerCacheReader reader(data);
+  char magic[8];
+  int32_t version = 0;
+  uint64_t hash = 0;
+  uint32_t anatomySize = 0;
+  int32_t numParams = 0;
+
+  reader.read(magic, sizeof(magic));
+  reader.read(version);
+  reader.read(hash);
+  reader.read(anatomySize);
+  reader.read(numParams);
+
+  if ((reader.ok == false) || 
+      (memcmp(magic, SPEAKER_CACHE_MAGIC, sizeof(magic)) != 0) ||
+      (version != SPEAKER_CACHE_VERSION) || (hash != speakerHash) ||
+      (anatomySize != sizeof(VocalTract::Anatomy)) || 
+      (numParams != VocalTract::NUM_PARAMS))
+  {
+    return false;
+  }
+
+  // ****************************************************************
+  // Read all data into temporary variables first.
+  // ****************************************************************
+
+  VocalTract::Anatomy anatomy;
+  VocalTract::Param param[VocalTract::NUM_PARAMS];
+  vector<VocalTract::Shape> shapes;
+
+  reader.read(&anatomy, sizeof(anatomy));
+  for (i=0; i < VocalTract::NUM_PARAMS; i++)
+  {
+    reader.readString(param[i].abbr);
+    reader.read(param[i].min);
+    reader.read(param[i].max);
+    reader.read(param[i].neutral);
+    reader.read(param[i].x);
+    reader.read(param[i].limitedX);
+  }
+
+  int32_t numShapes = 0;
+  reader.read(numShapes);
+  if ((reader.ok == false) || (numShapes < 0) || 
+      ((size_t)numShapes > data.size()))
+  {
+    return false;
+  }
+  shapes.resize(numShapes);
+  for (i=0; i < numShapes; i++)
+  {
+    reader.readString(shapes[i].name);
+    reader.read(shapes[i].param, sizeof(shapes[i].param));
+  }
+
+  int32_t selected = 0;
+  int32_t numModels = 0;
+  reader.read(selected);
+  reader.read(numModels);
+  if ((reader.ok == false) || (numModels != numGlottisModels))
+  {
+    return false;
+  }
+
+  vector< vector<double> > staticParamValues(numGlottisModels);
+  vector< vector<Glottis::Shape> > glottisShapes(numGlottisModels);
+
+  for (i=0; i < numGlottisModels; i++)
+  {
+    Glottis *g = glottis[i];
+    string name;
+    int32_t numStaticParams = 0;
+    int32_t numControlParams = 0;
+    int32_t numGlottisShapes = 0;
+
+    reader.readString(name);
+    reader.read(numStaticParams);
+    if ((reader.ok == false) || (name != g->getName()) || 
+        (numStaticParams != (int)g->staticParam.size()))
+    {
+      return false;
+    }
+
+    staticParamValues[i].resize(numStaticParams);
+    for (k=0; k < numStaticParams; k++)
+    {
+      reader.read(staticParamValues[i][k]);
+    }
+
+    reader.read(numControlParams);
+    reader.read(numGlottisShapes);
+    if ((reader.ok == false) || 
+        (numControlParams != (int)g->controlParam.size()) ||
+        (numGlottisShapes < 0) || ((size_t)numGlottisShapes > data.size()))
+    {
+      return false;
+    }
+
+    glottisShapes[i].resize(numGlottisShapes);
+    for (k=0; k < numGlottisShapes; k++)
+    {
+      Glottis::Shape &s = glottisShapes[i][k];
+      reader.readString(s.name);
+      s.controlParam.resize(numControlParams);
+      reader.read(s.controlParam.data(), numControlParams * sizeof(double));
+    }
+  }
+
+  if (reader.atEnd() == false)
+  {
+    return false;
+  }
+
+  // ****************************************************************
+  // Everything was read: set the data of the models and calculate
+  // the derived data as readAnatomyXml() and Glottis::readFromXml().
+  // ****************************************************************
+
+  vocalTract->anatomy = anatomy;
+  for (i=0; i < VocalTract::NUM_PARAMS; i++)
+  {
+    VocalTract::Param &p = vocalTract->param[i];
+    p.abbr     = param[i].abbr;
+    p.min      = param[i].min;
+    p.max      = param[i].max;
+    p.neutral  = param[i].neutral;
+    p.x        = param[i].x;
+    p.limitedX = param[i].limitedX;
+  }
+  vocalTract->shapes.swap(shapes);
+  vocalTract->initReferenceSurfaces();
+
+  for (i=0; i < numGlottisModels; i++)
+  {
+    Glottis *g = glottis[i];
+    for (k=0; k < (int)g->staticParam.size(); k++)
+    {
+      g->staticParam[k].x = staticParamValues[i][k];
+    }
+    g->shape.swap(glottisShapes[i]);
+
+    g->resetMotion();
+    g->calcGeometry();
+    g->clearUnsavedChanges();
+  }
+
+  selectedGlottis = selected;
+
+  return true;
+}
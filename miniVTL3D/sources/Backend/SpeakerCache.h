@@ -0,0 +1,57 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#ifndef __SPEAKER_CACHE_H__
+#define __SPEAKER_CACHE_H__
+
+#include "VocalTract.h"
+#include "Glottis.h"
+#include <string>
+#include <cstdint>
+
+using namespace std;
+
+// ****************************************************************************
+// Binary snapshot of the data that are read from a speaker file: the 
+// anatomy, the parameter ranges and the shapes of the vocal tract model, and
+// the static parameters and shapes of the glottis models.
+//
+// Restoring a snapshot replaces the parsing of the XML text and the reading
+// of the element tree, which dominate the loading of a speaker for short
+// scripted syntheses. The snapshot is only valid for the speaker file text
+// it was made from: it contains a hash of this text and is ignored when the
+// hash, the version of the format or the layout of the data differ. The
+// derived data (reference surfaces, glottis geometry) are not stored but 
+// recalculated when the snapshot is restored.
+// ****************************************************************************
+
+// 64 bit FNV-1a hash of the text of a speaker file
+uint64_t speakerFileHash(const string &speakerText);
+
+bool writeSpeakerCache(const string &cacheFileName, uint64_t speakerHash,
+  VocalTract *vocalTract, Glottis *glottis[], int numGlottisModels, 
+  int selectedGlottis);
+
+bool readSpeakerCache(const string &cacheFileName, uint64_t speakerHash,
+  VocalTract *vocalTract, Glottis *glottis[], int numGlottisModels, 
+  int &selectedGlottis);
+
+#endif
@@ -22,6 +22,9 @@
 #include "Splines.h"
 #include <cstdio>
 #include <cmath>
+#include <algorithm>
+
+using namespace std;
 
 // ----------------------------------------------------------------------------
 // Base class for all 3D splines.
@@ -67,6 +70,7 @@ void Spline3D::reset(int newNumPoints)
     w[i] = 1.0;         // Default-Gewicht
   }
   pointsChanged = true;
+  arcLengthChanged = true;
 }
 
 // ****************************************************************************
@@ -85,6 +89,7 @@ void Spline3D::setPoints(int newNumPoints, const Point3D *points)
     w[i] = 1.0;         // Default-Gewicht
   }
   pointsChanged = true;
+  arcLengthChanged = true;
 }
 
 
@@ -104,6 +109,7 @@ void Spline3D::setPoints(int newNumPoints, const Point3D *points, const double *
     w[i] = weights[i];
   }
   pointsChanged = true;
+  arcLengthChanged = true;
 }
 
 // ****************************************************************************
@@ -116,6 +122,7 @@ void Spline3D::setPoint(int index, Point3D point, double weight)
   P[index] = point;
   w[index] = weight;
   pointsChanged = true;
+  arcLengthChanged = true;
 }
 
 // ****************************************************************************
@@ -131,6 +138,7 @@ void Spline3D::addPoint(Point3D point, double weight)
 
   numPoints++;
   pointsChanged = true;
+  arcLengthChanged = true;
 }
 
 // ****************************************************************************
@@ -191,62 +199,80 @@ Point3D Spline3D::getPoint(double t)
 }
 
 // ****************************************************************************
-// The parameter t with 0 <= t <= 1 is the ratio of the curve length between
-// the beginning and the seeked position and the total length of the curve.
-// Returned is a value u that can be directly passed as curve parameter to 
-// getPoint() or getTangent().
+// Returns the points at the relative positions t[0..numValues-1].
 // ****************************************************************************
 
-double Spline3D::getUniformParam(double t)
+void Spline3D::getPoints(int numValues, const double *t, Point3D *points)
+{
+  for (int i=0; i < numValues; i++) { points[i] = getPoint(t[i]); }
+}
+
+// ****************************************************************************
+// Calc. the normalized arc length of the curve at ARC_LENGTH_TABLE_SIZE 
+// equidistant curve parameters.
+// ****************************************************************************
+
+void Spline3D::calculateArcLengthTable()
 {
   const double EPSILON = 0.000001;
-  const int N = 100;
-  Point3D P[N];
+  const int N = ARC_LENGTH_TABLE_SIZE;
   double s[N];
-  double pos[N];
+  Point3D Q[N];
   int i;
-  double l;
 
-  // N Punkte auf der Kurve in nichtgleichfoermigen Abstaenden berechnen.
+  for (i=0; i < N; i++) { s[i] = (double)i / (double)(N-1); }
+  getPoints(N, s, Q);
 
-  for (i=0; i < N; i++)
+  arcLength[0] = 0.0;
+  for (i=1; i < N; i++)
   {
-    s[i] = (double)i / (double)(N-1);
-    P[i] = getPoint(s[i]);
-    if (i == 0)
-    {
-      pos[i] = 0.0;
-    }
-    else
-    {
-      pos[i] = pos[i-1] + (P[i] - P[i-1]).magnitude();
-    }
+    arcLength[i] = arcLength[i-1] + (Q[i] - Q[i-1]).magnitude();
   }
 
-  // Alle Positionen auf die Gesamtlaenge normieren.
-
-  l = pos[N-1];
+  double l = arcLength[N-1];
   if (l < EPSILON) { l = EPSILON; }
+  for (i=0; i < N; i++) { arcLength[i]/= l; }
+
+  arcLengthChanged = false;
+}
+
+// ****************************************************************************
+// The parameter t with 0 <= t <= 1 is the ratio of the curve length between
+// the beginning and the seeked position and the total length of the curve.
+// Returned is a value u that can be directly passed as curve parameter to 
+// getPoint() or getTangent().
+// ****************************************************************************
+
+double Spline3D::getUniformParam(double t)
+{
+  const double EPSILON = 0.000001;
+  const int N = ARC_LENGTH_TABLE_SIZE;
+  const double *pos = arcLength;
+  double l;
+
+  // Die Bogenlaengen an N Punkten der Kurve werden nur nach einer 
+  // Aenderung der Kontrollpunkte neu berechnet.
 
-  for (i=0; i < N; i++) { pos[i]/= l; }
+  if (arcLengthChanged) { calculateArcLengthTable(); }
 
-  // Zwischen welche beiden Positionen faellt t ?
+  // Zwischen welche beiden Positionen faellt t ? Gesucht ist das letzte
+  // Intervall [pos[k], pos[k+1]], das t enthaelt.
 
   if (t < 0.0) { t = 0.0; }
   if (t > 1.0) { t = 1.0; }
 
-  int k = -1;
+  int k = (int)(upper_bound(pos, pos + N-1, t) - pos) - 1;
   double ratio = 0.0;
 
-  for (i=0; i < N-1; i++) 
-  { 
-    if ((t >= pos[i]) && (t <= pos[i+1])) 
-    { 
-      k = i; 
-      l = pos[i+1] - pos[i];
-      if (l < EPSILON) { l = EPSILON; }
-      ratio = (t - pos[i]) / l;
-    }
+  if ((k >= 0) && (t <= pos[k+1]))
+  {
+    l = pos[k+1] - pos[k];
+    if (l < EPSILON) { l = EPSILON; }
+    ratio = (t - pos[k]) / l;
+  }
+  else
+  {
+    k = -1;
   }
 
   if (k == -1)
@@ -265,7 +291,7 @@ double Spline3D::getUniformParam(double t)
 
   // Den neuen Parameter u ableiten.
 
-  double u = s[k] + ratio*(s[k+1] - s[k]);
+  double u = ((double)k + ratio) / (double)(N-1);
   return u;
 }
 
@@ -794,6 +820,7 @@ void LineStrip2D::calculateParams()
   {
     for (i=1; i < numPoints; i++) { pos[i]/= length; }
   }
+  pointsChanged = false;
 }
 
 // ----------------------------------------------------------------------------
@@ -958,6 +985,7 @@ void LineStrip3D::calculateParams()
   {
     for (i=1; i < numPoints; i++) { pos[i]/= length; }
   }
+  pointsChanged = false;
 }
 
 // ----------------------------------------------------------------------------
@@ -992,22 +1020,55 @@ Point3D BezierCurve3D::getPoint(double t)
   Point3D Q(0.0, 0.0, 0.0);
   if (numPoints < 2) { return Q; }
 
+  // Horner-Schema fuer Zaehler und Nenner.
+
   int i;
   int n = numPoints-1;
-  double f = 1.0;       // f = t^i
-  double denominator = 0.0;
+  double denominator = B[n];
+  Q = A[n];
 
-  for (i=0; i <= n; i++)
+  for (i=n-1; i >= 0; i--)
   {
-    Q+= A[i]*f;
-    denominator+= B[i]*f;
-    f*= t;
+    Q = Q*t + A[i];
+    denominator = denominator*t + B[i];
   }
 
   Q/= denominator;
   return Q;
 }
 
+// ****************************************************************************
+// Returns the points on the curve at t[0..numValues-1] with 0 <= t <= 1.
+// ****************************************************************************
+
+void BezierCurve3D::getPoints(int numValues, const double *t, Point3D *points)
+{
+  if (pointsChanged) { calculateCoeff(); }
+
+  int i, k;
+  int n = numPoints-1;
+  double denominator;
+  Point3D Q;
+
+  for (k=0; k < numValues; k++)
+  {
+    if (numPoints < 2) 
+    { 
+      points[k].set(0.0, 0.0, 0.0); 
+      continue;
+    }
+
+    Q = A[n];
+    denominator = B[n];
+    for (i=n-1; i >= 0; i--)
+    {
+      Q = Q*t[k] + A[i];
+      denominator = denominator*t[k] + B[i];
+    }
+    points[k] = Q / denominator;
+  }
+}
+
 // ****************************************************************************
 // Calc. the coefficients in front of the powers of t of the Bernstein polynoms
 // B_(k,n)(t) = (n ueber k)*t^k*(1-t)^(n-k) 
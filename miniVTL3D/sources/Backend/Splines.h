@@ -49,6 +49,7 @@ public:
   Point3D getControlPoint(int index);
   Point3D getControlPoint(int index, double &weight);
   virtual Point3D getPoint(double t);
+  virtual void getPoints(int numValues, const double *t, Point3D *points);
   virtual Point3D getTangent(double t);
   double getUniformParam(double t);
   double getIntersection(const Point3D planePoint, const Point3D planeNormal, double tMin, double tMax);
@@ -60,6 +61,16 @@ protected:
   double  w[MAX_SPLINE_POINTS];     // weights
   int  numPoints;
   bool pointsChanged;
+
+private:
+  // Normalized arc length of the curve at ARC_LENGTH_TABLE_SIZE equidistant
+  // curve parameters for getUniformParam(), recalculated when the control
+  // points changed.
+  static const int ARC_LENGTH_TABLE_SIZE = 100;
+  double arcLength[ARC_LENGTH_TABLE_SIZE];
+  bool arcLengthChanged;
+
+  void calculateArcLengthTable();
 };
 
 // ****************************************************************************
@@ -94,6 +105,7 @@ public:
   BezierCurve3D(int newNumPoints, const Point3D *points, const double *weights);
 
   Point3D getPoint(double t);
+  void getPoints(int numValues, const double *t, Point3D *points);
 
 private:
   void getBernsteinCoeff(int i, int n, double *coeff);
@@ -20,7 +20,11 @@
 // ****************************************************************************
 
 #include "Surface.h"
+#include "MeshFile.h"
+#include "ParallelLoop.h"
+#include <algorithm>
 #include <cmath>
+#include <climits>
 #include <iostream>
 #include <fstream>
 
@@ -48,6 +52,7 @@ Surface::Surface()
   sequence = NULL;
 
   creaseAngle_deg = STANDARD_CREASE_ANGLE_DEGREE;
+  normalsValid = false;
   init(0, 0);
 }
 
@@ -67,6 +72,7 @@ Surface::Surface(int ribs, int ribPoints)
   sequence = NULL;
 
   creaseAngle_deg = STANDARD_CREASE_ANGLE_DEGREE;
+  normalsValid = false;
   init(ribs, ribPoints);
 }
 
@@ -95,6 +101,9 @@ void Surface::clear()
   numTriangles = 0;
   numVertices  = 0;
   numEdges     = 0;
+
+  normalVertexCoord.clear();
+  normalsValid = false;
 }
 
 // ****************************************************************************
@@ -219,7 +228,6 @@ void Surface::init(int ribs, int ribPoints)
 
   for (i=0; i < numVertices; i++)
   {
-    vertex[i].reserved = 0;
     vertex[i].numAssociates = 0;
 
     for (j=0; j < NUM_ASSOCIATED_TRIANGLES; j++)
@@ -247,12 +255,6 @@ void Surface::init(int ribs, int ribPoints)
   	triangle[i].distance = 0.0;
     sequence[i] = i;
   }
-
-  for (i=0; i < numEdges; i++)
-  {
-    edge[i].isIntersected = false;
-    edge[i].intersection.set(0.0, 0.0);
-  }
 }
 
 // ****************************************************************************
@@ -274,6 +276,8 @@ void Surface::swapTriangleOrientation()
     triangle[i].vertex[2] = k;
   }
 
+  invalidateNormals();
+
   // Die an einen Vertex grenzenden Dreiecke neu ermitteln.
 
   for (i=0; i < numVertices; i++)
@@ -302,21 +306,100 @@ void Surface::swapTriangleOrientation()
 // ****************************************************************************
 /// @brief Calculates the normalized normal vectors of the triangles and at the 
 /// vertices.
+///
+/// When the vertices did not move since the last call (e.g., the upper jaw
+/// when only the tongue changed), the normals are kept. Large surfaces are
+/// processed in blocks of triangles and vertices on the thread pool.
 // ****************************************************************************
 
 void Surface::calculateNormals()
 {
-  int i, j, k;
+  if (!verticesMovedSinceNormals())
+  {
+    return;
+  }
+
+  double cosCreaseAngle = cos(creaseAngle_deg*3.1415/180.0);
+
+  if (numTriangles < MIN_PARALLEL_NORMAL_TRIANGLES)
+  {
+    calculatePlaneNormals(0, numTriangles - 1);
+    calculateCornerNormals(0, numVertices - 1, cosCreaseAngle);
+  }
+  else
+  {
+    const int BLOCK_SIZE = 1024;
+    int numThreads = threadPoolSize();
+
+    parallelLoop((numTriangles + BLOCK_SIZE - 1) / BLOCK_SIZE, numThreads, [&](int b)
+      {
+        calculatePlaneNormals(b*BLOCK_SIZE, min((b + 1)*BLOCK_SIZE, numTriangles) - 1);
+      });
+
+    // Each corner of a triangle belongs to a single vertex, so that the
+    // blocks of vertices write disjoint corner normals.
+    parallelLoop((numVertices + BLOCK_SIZE - 1) / BLOCK_SIZE, numThreads, [&](int b)
+      {
+        calculateCornerNormals(b*BLOCK_SIZE, min((b + 1)*BLOCK_SIZE, numVertices) - 1, 
+          cosCreaseAngle);
+      });
+  }
+
+  normalVertexCoord.resize(numVertices);
+  for (int i=0; i < numVertices; i++)
+  {
+    normalVertexCoord[i] = vertex[i].coord;
+  }
+  normalCreaseAngle_deg = creaseAngle_deg;
+  normalsValid = true;
+}
+
+// ****************************************************************************
+/// @brief Returns true if the normals must be calculated again, because the 
+/// vertices or the crease angle changed or the normals were changed since
+/// the last calculation.
+// ****************************************************************************
+
+bool Surface::verticesMovedSinceNormals()
+{
+  int i;
+
+  if ((normalsValid == false) || (normalCreaseAngle_deg != creaseAngle_deg) ||
+    ((int)normalVertexCoord.size() != numVertices))
+  {
+    return true;
+  }
+
+  for (i=0; i < numVertices; i++)
+  {
+    const Point3D &P = vertex[i].coord;
+    const Point3D &Q = normalVertexCoord[i];
+    if ((P.x != Q.x) || (P.y != Q.y) || (P.z != Q.z))
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// ****************************************************************************
+/// @brief Calculates the plane normals and areas of the triangles 
+/// firstTriangle ... lastTriangle and initializes their corner normals.
+// ****************************************************************************
+
+void Surface::calculatePlaneNormals(int firstTriangle, int lastTriangle)
+{
+  int i, k;
 
   // Die Normalen aller Flchen berechnen und auf die Eckpunkte bertragen.
 
   int p0, p1, p2;
   Point3D v0;
   Point3D v1;
-  double cosAngle;
   double length;
 
-  for (i=0; i < numTriangles; i++)
+  for (i=firstTriangle; i <= lastTriangle; i++)
   {
     p0 = triangle[i].vertex[0];
     p1 = triangle[i].vertex[1];
@@ -341,15 +424,25 @@ void Surface::calculateNormals()
       triangle[i].cornerNormal[k] = triangle[i].area*triangle[i].planeNormal;
     }
   }
+}
+
+// ****************************************************************************
+/// @brief Calculates the normalized corner normals at the vertices
+/// firstVertex ... lastVertex from the plane normals of the triangles.
+// ****************************************************************************
+
+void Surface::calculateCornerNormals(int firstVertex, int lastVertex, double cosCreaseAngle)
+{
+  int i, j, k;
 
   // Die Eckpunktnormalen jedes Punktes in jedem Dreieck berechnen.
 
   Point3D planeNormal0, planeNormal1;
   Point3D *cornerNormal0, *cornerNormal1;
   double area0, area1;
-  double cosCreaseAngle = cos(creaseAngle_deg*3.1415/180.0);
+  double cosAngle;
 
-  for (i=0; i < numVertices; i++)
+  for (i=firstVertex; i <= lastVertex; i++)
   {
     // Jedes Zweierprchen von Dreiecken an diesem Punkt berprfen.
     for (j=0; j < vertex[i].numAssociates-1; j++)
@@ -376,15 +469,12 @@ void Surface::calculateNormals()
         }
       }
     }
-  }
 
-  // Alle Eckpunktnormalen auf die Lnge 1 bringen.
+    // Die Eckpunktnormalen dieses Punktes auf die Lnge 1 bringen.
 
-  for (i=0; i < numTriangles; i++)
-  {
-    for (k=0; k < 3; k++)
+    for (j=0; j < vertex[i].numAssociates; j++)
     {
-      triangle[i].cornerNormal[k].normalize();
+      triangle[ vertex[i].associatedTriangle[j] ].cornerNormal[ vertex[i].associatedCorner[j] ].normalize();
     }
   }
 }
@@ -423,6 +513,9 @@ void Surface::setNormal(int rib, int ribPoint, Point3D normal)
   {
     triangle[ vertex[adr].associatedTriangle[i] ].cornerNormal[ vertex[adr].associatedCorner[i] ] = normal;
   }
+
+  // The normals are no longer those of the vertices.
+  normalsValid = false;
 }
 
 // ****************************************************************************
@@ -447,17 +540,16 @@ Point3D Surface::getNormal(int rib, int ribPoint)
 }
 
 // ****************************************************************************
-/// @brief Calculates the order, in which the triangles must be painted
-/// according to the painters algorithm and writes the results into \a sequence
-/// (Triangles with the smallest z-coord. are painted first).
+/// @brief Calculates the z-value of the center point of each triangle 
+/// transformed with the matrix \a matrix and writes it into the member 
+/// \a distance of the triangle.
 /// 
-/// Therefore, the center points of all triangles are transformed with the matrix
-/// \a matrix and sorted. Attention: The matrix elements must be passed in 
-/// transposed form: Row 1:[m0, m4, m8, m12]; Row 2:[m1, m5, m9, m13]; ect.
+/// The matrix elements must be passed in transposed form like for 
+/// calculatePaintSequence().
 /// @param matrix The transposed transformation (model/view) matrix.
 // ****************************************************************************
 
-void Surface::calculatePaintSequence(double matrix[16])
+void Surface::calculateDistances(double matrix[16])
 {
   int i;
   Point3D M;
@@ -478,6 +570,27 @@ void Surface::calculatePaintSequence(double matrix[16])
     w = matrix[3]*M.x + matrix[7]*M.y + matrix[11]*M.z + matrix[15];
 
     triangle[i].distance = z/w;
+  }
+}
+
+// ****************************************************************************
+/// @brief Calculates the order, in which the triangles must be painted
+/// according to the painters algorithm and writes the results into \a sequence
+/// (Triangles with the smallest z-coord. are painted first).
+/// 
+/// Therefore, the center points of all triangles are transformed with the matrix
+/// \a matrix and sorted. Attention: The matrix elements must be passed in 
+/// transposed form: Row 1:[m0, m4, m8, m12]; Row 2:[m1, m5, m9, m13]; ect.
+/// @param matrix The transposed transformation (model/view) matrix.
+// ****************************************************************************
+
+void Surface::calculatePaintSequence(double matrix[16])
+{
+  int i;
+
+  calculateDistances(matrix);
+  for (i=0; i < numTriangles; i++)
+  {
     sequence[i] = i;
   }
 
@@ -548,8 +661,8 @@ void Surface::reversePaintSequence()
 
 bool Surface::saveAsObjFile(const string &fileName)
 {
-  ofstream file(fileName);
-  if (!file) 
+  BufferedTextFile file;
+  if (!file.open(fileName)) 
   { 
     return false; 
   }
@@ -564,10 +677,8 @@ bool Surface::saveAsObjFile(const string &fileName)
 
   for (i=0; i < numVertices; i++)
   {
-    file << "v  "
-      << (double)vertex[i].coord.x << "  " 
-      << (double)vertex[i].coord.y << "  " 
-      << (double)vertex[i].coord.z << endl;
+    file.print("v  %g  %g  %g\n", (double)vertex[i].coord.x, 
+      (double)vertex[i].coord.y, (double)vertex[i].coord.z);
   }
 
   // ****************************************************************
@@ -577,10 +688,8 @@ bool Surface::saveAsObjFile(const string &fileName)
   for (i=0; i < numVertices; i++)
   {
     normal = getNormal(vertex[i].rib, vertex[i].ribPoint);
-    file << "vn  "
-      << (double)normal.x << "  " 
-      << (double)normal.y << "  " 
-      << (double)normal.z << endl;
+    file.print("vn  %g  %g  %g\n", (double)normal.x, (double)normal.y, 
+      (double)normal.z);
   }
 
   // ****************************************************************
@@ -589,16 +698,15 @@ bool Surface::saveAsObjFile(const string &fileName)
 
   for (i=0; i < numTriangles; i++)
   {
-    file << "f  "
-      << (int)(triangle[i].vertex[0] + 1) << "//" << (int)(triangle[i].vertex[0] + 1) << "  " 
-      << (int)(triangle[i].vertex[1] + 1) << "//" << (int)(triangle[i].vertex[1] + 1) << "  " 
-      << (int)(triangle[i].vertex[2] + 1) << "//" << (int)(triangle[i].vertex[2] + 1) << endl;
+    file.print("f  %d//%d  %d//%d  %d//%d\n", 
+      (int)(triangle[i].vertex[0] + 1), (int)(triangle[i].vertex[0] + 1), 
+      (int)(triangle[i].vertex[1] + 1), (int)(triangle[i].vertex[1] + 1), 
+      (int)(triangle[i].vertex[2] + 1), (int)(triangle[i].vertex[2] + 1));
   }
 
-  file << endl;
+  file.print("\n");
 
-  // The file is closed automatically.
-  return true;
+  return file.close();
 }
 
 // ****************************************************************************
@@ -725,24 +833,33 @@ void Surface::prepareIntersections()
 /// with the intersecting plane parameters.
 /// The function returns false, when \a MAX_ENTRIES is smaller than the actual
 /// necessary number of entries.
-/// @param indexList The list to be filled with the triangle indices. Triangles
-/// may occur multiple times in the list, when they overlap muliple tiles.
+/// @param indexList The list to be filled with the triangle indices. Each
+/// triangle occurs only once in the list, even when it overlaps multiple tiles.
 /// @param numEntries Returns the number of list entries.
 /// @param MAX_ENTRIES The maximal number of entries to be put in the list.
 // ****************************************************************************
   
 bool Surface::getTriangleList(int *indexList, int &numEntries, int MAX_ENTRIES)
 {
-  int i;
+  return getTriangleList(intersection, indexList, numEntries, MAX_ENTRIES);
+}
+
+// ****************************************************************************
+/// @brief Returns a list with all triangles that are possibly interesected 
+/// by the intersecting plane of the given intersection state, defined by
+/// the call of prepareIntersection(Point2D Q, Point2D v, IntersectionState &state).
+// ****************************************************************************
+
+bool Surface::getTriangleList(IntersectionState &state, int *indexList, 
+  int &numEntries, int MAX_ENTRIES) const
+{
   double x, y;
   int tileX, tileY;         // Index of the current tile
   double nextBorderX, nextBorderY;
   double deltaX, deltaY;
-  Tile *t = NULL;
-  int *source;
 
-  Point2D Q = linePoint;
-  Point2D v = lineVector;
+  Point2D Q = state.linePoint;
+  Point2D v = state.lineVector;
 
   numEntries = 0;
 
@@ -771,13 +888,9 @@ bool Surface::getTriangleList(int *indexList, int &numEntries, int MAX_ENTRIES)
 
       for (tileX=0; tileX < numTilesX; tileX++)
       {
-        if ((tileY >= 0) && (tileY < numTilesY))
+        if (!appendTileTriangles(tileX, tileY, state, indexList, numEntries, MAX_ENTRIES))
         {
-          t = &tile[tileX][tileY];
-          if (numEntries + t->numTriangles > MAX_ENTRIES) { return false; }
-          source = &t->triangle[0];
-          for (i=t->numTriangles-1; i >= 0; i--) { *indexList++ = *source++; }
-          numEntries+= t->numTriangles;
+          return false;
         }
 
         if (y + deltaY > nextBorderY)
@@ -785,13 +898,9 @@ bool Surface::getTriangleList(int *indexList, int &numEntries, int MAX_ENTRIES)
           tileY++;
           nextBorderY+= tileHeight;
 
-          if ((tileY >= 0) && (tileY < numTilesY))
+          if (!appendTileTriangles(tileX, tileY, state, indexList, numEntries, MAX_ENTRIES))
           {
-            t = &tile[tileX][tileY];
-            if (numEntries + t->numTriangles > MAX_ENTRIES) { return false; }
-            source = &t->triangle[0];
-            for (i=t->numTriangles-1; i >= 0; i--) { *indexList++ = *source++; }
-            numEntries+= t->numTriangles;
+            return false;
           }
         }
 
@@ -807,27 +916,19 @@ bool Surface::getTriangleList(int *indexList, int &numEntries, int MAX_ENTRIES)
 
       for (tileX=0; tileX < numTilesX; tileX++)
       {
-        if ((tileY >= 0) && (tileY < numTilesY))
+        if (!appendTileTriangles(tileX, tileY, state, indexList, numEntries, MAX_ENTRIES))
         {
-          t = &tile[tileX][tileY];
-          if (numEntries + t->numTriangles > MAX_ENTRIES) { return false; }
-          source = &t->triangle[0];
-          for (i=t->numTriangles-1; i >= 0; i--) { *indexList++ = *source++; }
-          numEntries+= t->numTriangles;
+          return false;
         }
 
         if (y + deltaY < nextBorderY)
         {
           tileY--;
           nextBorderY-= tileHeight;
-          t = &tile[tileX][tileY];
 
-          if ((tileY >= 0) && (tileY < numTilesY))
+          if (!appendTileTriangles(tileX, tileY, state, indexList, numEntries, MAX_ENTRIES))
           {
-            if (numEntries + t->numTriangles > MAX_ENTRIES) { return false; }
-            source = &t->triangle[0];
-            for (i=t->numTriangles-1; i >= 0; i--) { *indexList++ = *source++; }
-            numEntries+= t->numTriangles;
+            return false;
           }
         }
 
@@ -861,13 +962,9 @@ bool Surface::getTriangleList(int *indexList, int &numEntries, int MAX_ENTRIES)
 
       for (tileY=0; tileY < numTilesY; tileY++)
       {
-        if ((tileX >= 0) && (tileX < numTilesX))
+        if (!appendTileTriangles(tileX, tileY, state, indexList, numEntries, MAX_ENTRIES))
         {
-          t = &tile[tileX][tileY];
-          if (numEntries + t->numTriangles > MAX_ENTRIES) { return false; }
-          source = &t->triangle[0];
-          for (i=t->numTriangles-1; i >= 0; i--) { *indexList++ = *source++; }
-          numEntries+= t->numTriangles;
+          return false;
         }
 
         if (x + deltaX > nextBorderX)
@@ -875,13 +972,9 @@ bool Surface::getTriangleList(int *indexList, int &numEntries, int MAX_ENTRIES)
           tileX++;
           nextBorderX+= tileWidth;
 
-          if ((tileX >= 0) && (tileX < numTilesX))
+          if (!appendTileTriangles(tileX, tileY, state, indexList, numEntries, MAX_ENTRIES))
           {
-            t = &tile[tileX][tileY];
-            if (numEntries + t->numTriangles > MAX_ENTRIES) { return false; }
-            source = &t->triangle[0];
-            for (i=t->numTriangles-1; i >= 0; i--) { *indexList++ = *source++; }
-            numEntries+= t->numTriangles;
+            return false;
           }
         }
 
@@ -897,13 +990,9 @@ bool Surface::getTriangleList(int *indexList, int &numEntries, int MAX_ENTRIES)
 
       for (tileY=0; tileY < numTilesY; tileY++)
       {
-        if ((tileX >= 0) && (tileX < numTilesX))
+        if (!appendTileTriangles(tileX, tileY, state, indexList, numEntries, MAX_ENTRIES))
         {
-          t = &tile[tileX][tileY];
-          if (numEntries + t->numTriangles > MAX_ENTRIES) { return false; }
-          source = &t->triangle[0];
-          for (i=t->numTriangles-1; i >= 0; i--) { *indexList++ = *source++; }
-          numEntries+= t->numTriangles;
+          return false;
         }
 
         if (x + deltaX < nextBorderX)
@@ -911,13 +1000,9 @@ bool Surface::getTriangleList(int *indexList, int &numEntries, int MAX_ENTRIES)
           tileX--;
           nextBorderX-= tileWidth;
 
-          if ((tileX >= 0) && (tileX < numTilesX))
+          if (!appendTileTriangles(tileX, tileY, state, indexList, numEntries, MAX_ENTRIES))
           {
-            t = &tile[tileX][tileY];
-            if (numEntries + t->numTriangles > MAX_ENTRIES) { return false; }
-            source = &t->triangle[0];
-            for (i=t->numTriangles-1; i >= 0; i--) { *indexList++ = *source++; }
-            numEntries+= t->numTriangles;
+            return false;
           }
         }
 
@@ -929,6 +1014,38 @@ bool Surface::getTriangleList(int *indexList, int &numEntries, int MAX_ENTRIES)
   return true;
 }
 
+// ****************************************************************************
+/// @brief Appends the triangles of the given tile, that are not yet in the
+/// list of the current intersection, to the triangle list. Tiles outside of
+/// the grid are ignored. Returns false, when the list is full.
+// ****************************************************************************
+
+bool Surface::appendTileTriangles(int tileX, int tileY, IntersectionState &state,
+  int *&indexList, int &numEntries, int MAX_ENTRIES) const
+{
+  if ((tileX < 0) || (tileX >= numTilesX) || (tileY < 0) || (tileY >= numTilesY))
+  {
+    return true;
+  }
+
+  const Tile *t = &tile[tileX][tileY];
+  int i, index;
+
+  for (i=0; i < t->numTriangles; i++)
+  {
+    index = t->triangle[i];
+    if (state.triangleListed[index] != state.stamp)
+    {
+      if (numEntries >= MAX_ENTRIES) { return false; }
+      state.triangleListed[index] = state.stamp;
+      *indexList++ = index;
+      numEntries++;
+    }
+  }
+
+  return true;
+}
+
 // ****************************************************************************
 /// @brief Prepares the intersection of the surface with the given intersecting
 /// plane/line. This function must be called before
@@ -940,16 +1057,38 @@ bool Surface::getTriangleList(int *indexList, int &numEntries, int MAX_ENTRIES)
 // ****************************************************************************
   
 void Surface::prepareIntersection(Point2D Q, Point2D v)
+{
+  prepareIntersection(Q, v, intersection);
+}
+
+// ****************************************************************************
+/// @brief Prepares the intersection of the surface with the given intersecting
+/// plane/line in the given intersection state.
+// ****************************************************************************
+
+void Surface::prepareIntersection(Point2D Q, Point2D v, IntersectionState &state) const
 {
   const double EPSILON = 0.000001;
-  int i;
 
-  for (i=0; i < numVertices; i++) { vertex[i].wasTested = false; }
-  for (i=0; i < numEdges; i++)    { edge[i].wasTested = false; }
+  // Only reset the arrays for a new size of the surface (or before the 
+  // stamp overflows), otherwise a new stamp invalidates the old tests.
+
+  if (((int)state.vertexTested.size() != numVertices) || ((int)state.edgeTested.size() != numEdges) ||
+    ((int)state.triangleListed.size() != numTriangles) || (state.stamp == INT_MAX))
+  {
+    state.vertexTested.assign(numVertices, 0);
+    state.vertexSide.assign(numVertices, 0);
+    state.edgeTested.assign(numEdges, 0);
+    state.edgeIntersected.assign(numEdges, false);
+    state.edgeIntersection.resize(numEdges);
+    state.triangleListed.assign(numTriangles, 0);
+    state.stamp = 0;
+  }
+  state.stamp++;
 
   v.normalize();            // Normalisierung ist wichtig !
-  lineVector = v;           // Fr getTriangleIntersection merken
-  linePoint = Q;
+  state.lineVector = v;     // Fr getTriangleIntersection merken
+  state.linePoint = Q;
 
   // Einen Normaleneinheitsvektor bilden, der senkrecht (90 nach links
   // gedreht) auf v steht.
@@ -960,8 +1099,8 @@ void Surface::prepareIntersection(Point2D Q, Point2D v)
   // Abstand EPSILON links bzw. rechts der Gerade Q+t*v auf der Hhe von
   // P liegen.
 
-  leftLinePoint  = Q + EPSILON*n;
-  rightLinePoint = Q - EPSILON*n;
+  state.leftLinePoint  = Q + EPSILON*n;
+  state.rightLinePoint = Q - EPSILON*n;
 }
 
 // ****************************************************************************
@@ -978,6 +1117,17 @@ void Surface::prepareIntersection(Point2D Q, Point2D v)
 // ****************************************************************************
   
 bool Surface::getTriangleIntersection(int index, Point2D &P0, Point2D &P1, Point2D &n)
+{
+  return getTriangleIntersection(index, P0, P1, n, intersection);
+}
+
+// ****************************************************************************
+/// @brief Returns the intersection data for a single triangle with the 
+/// intersecting plane of the given intersection state.
+// ****************************************************************************
+
+bool Surface::getTriangleIntersection(int index, Point2D &P0, Point2D &P1, Point2D &n,
+  IntersectionState &state) const
 {
   int e0, e1, e2;   // Die 3 Kanten des Dreiecks
 
@@ -988,9 +1138,9 @@ bool Surface::getTriangleIntersection(int index, Point2D &P0, Point2D &P1, Point
   int numIntersections = 0;
   Point2D Q[3];
 
-  if (getEdgeIntersection(e0)) { Q[numIntersections++] = edge[e0].intersection; }
-  if (getEdgeIntersection(e1)) { Q[numIntersections++] = edge[e1].intersection; }
-  if (getEdgeIntersection(e2)) { Q[numIntersections++] = edge[e2].intersection; }
+  if (getEdgeIntersection(e0, state)) { Q[numIntersections++] = state.edgeIntersection[e0]; }
+  if (getEdgeIntersection(e1, state)) { Q[numIntersections++] = state.edgeIntersection[e1]; }
+  if (getEdgeIntersection(e2, state)) { Q[numIntersections++] = state.edgeIntersection[e2]; }
 
   if (numIntersections < 2) { return false; }
 
@@ -1009,7 +1159,7 @@ bool Surface::getTriangleIntersection(int index, Point2D &P0, Point2D &P1, Point
   // ****************************************************************
 
   n.x = normal.z;
-  n.y = normal.x*lineVector.x + normal.y*lineVector.y;
+  n.y = normal.x*state.lineVector.x + normal.y*state.lineVector.y;
 
   // Bei zwei Schnittpunkten P0 und P1 zurckgeben.
 
@@ -1054,16 +1204,16 @@ bool Surface::getTriangleIntersection(int index, Point2D &P0, Point2D &P1, Point
 /// the intersecting plane. Do not call this function explicitely!
 // ****************************************************************************
 
-bool Surface::getEdgeIntersection(int edgeIndex)
+bool Surface::getEdgeIntersection(int edgeIndex, IntersectionState &state) const
 {
-  if (edge[edgeIndex].wasTested) { return edge[edgeIndex].isIntersected; }
+  if (state.edgeTested[edgeIndex] == state.stamp) { return state.edgeIntersected[edgeIndex]; }
 
   // The edge must be tested for an intersection.
 
   Point2D w;
   double d;
 
-  edge[edgeIndex].wasTested = true;
+  state.edgeTested[edgeIndex] = state.stamp;
 
   int v0 = edge[edgeIndex].vertex[0];
   int v1 = edge[edgeIndex].vertex[1];
@@ -1075,46 +1225,46 @@ bool Surface::getEdgeIntersection(int edgeIndex)
   // auf der Schnittebene liegt (res = 0).
   // ****************************************************************
 
-  if (vertex[v0].wasTested == false)
+  if (state.vertexTested[v0] != state.stamp)
   {
-    vertex[v0].wasTested = true;
-    vertex[v0].reserved = 0;
-
-    w.x = vertex[v0].coord.x - leftLinePoint.x;
-    w.y = vertex[v0].coord.y - leftLinePoint.y;
-    d = w.x*lineVector.y - w.y*lineVector.x;
-    if (d < 0.0) { vertex[v0].reserved = -1; }
-
-    w.x = vertex[v0].coord.x - rightLinePoint.x;
-    w.y = vertex[v0].coord.y - rightLinePoint.y;
-    d = w.x*lineVector.y - w.y*lineVector.x;
-    if (d > 0.0) { vertex[v0].reserved = 1; }
+    state.vertexTested[v0] = state.stamp;
+    state.vertexSide[v0] = 0;
+
+    w.x = vertex[v0].coord.x - state.leftLinePoint.x;
+    w.y = vertex[v0].coord.y - state.leftLinePoint.y;
+    d = w.x*state.lineVector.y - w.y*state.lineVector.x;
+    if (d < 0.0) { state.vertexSide[v0] = -1; }
+
+    w.x = vertex[v0].coord.x - state.rightLinePoint.x;
+    w.y = vertex[v0].coord.y - state.rightLinePoint.y;
+    d = w.x*state.lineVector.y - w.y*state.lineVector.x;
+    if (d > 0.0) { state.vertexSide[v0] = 1; }
   }
 
   // Is the second vertex left or right from the intersection line ?
 
-  if (vertex[v1].wasTested == false)
+  if (state.vertexTested[v1] != state.stamp)
   {
-    vertex[v1].wasTested = true;
-    vertex[v1].reserved = 0;
-
-    w.x = vertex[v1].coord.x - leftLinePoint.x;
-    w.y = vertex[v1].coord.y - leftLinePoint.y;
-    d = w.x*lineVector.y - w.y*lineVector.x;
-    if (d < 0.0) { vertex[v1].reserved = -1; }
-
-    w.x = vertex[v1].coord.x - rightLinePoint.x;
-    w.y = vertex[v1].coord.y - rightLinePoint.y;
-    d = w.x*lineVector.y - w.y*lineVector.x;
-    if (d > 0.0) { vertex[v1].reserved = 1; }
+    state.vertexTested[v1] = state.stamp;
+    state.vertexSide[v1] = 0;
+
+    w.x = vertex[v1].coord.x - state.leftLinePoint.x;
+    w.y = vertex[v1].coord.y - state.leftLinePoint.y;
+    d = w.x*state.lineVector.y - w.y*state.lineVector.x;
+    if (d < 0.0) { state.vertexSide[v1] = -1; }
+
+    w.x = vertex[v1].coord.x - state.rightLinePoint.x;
+    w.y = vertex[v1].coord.y - state.rightLinePoint.y;
+    d = w.x*state.lineVector.y - w.y*state.lineVector.x;
+    if (d > 0.0) { state.vertexSide[v1] = 1; }
   }
 
   // Test the edge for an intersection.
 
-  edge[edgeIndex].isIntersected = false;
+  state.edgeIntersected[edgeIndex] = false;
 
-  if (((vertex[v0].reserved >= 0) && (vertex[v1].reserved <= 0)) ||
-      ((vertex[v0].reserved <= 0) && (vertex[v1].reserved >= 0)))
+  if (((state.vertexSide[v0] >= 0) && (state.vertexSide[v1] <= 0)) ||
+      ((state.vertexSide[v0] <= 0) && (state.vertexSide[v1] >= 0)))
   {
     // Den Schnittpunkt der Kante mit der Schnittebene genau bestimmen.
     const double EPSILON = 0.000001;
@@ -1125,26 +1275,26 @@ bool Surface::getEdgeIntersection(int edgeIndex)
     P = vertex[v0].coord;
     u = vertex[v1].coord - P;
 
-    R.x = P.x - linePoint.x;
-    R.y = P.y - linePoint.y;
+    R.x = P.x - state.linePoint.x;
+    R.y = P.y - state.linePoint.y;
     R.z = P.z;
 
-    denominator = -u.x*lineVector.y + u.y*lineVector.x;
+    denominator = -u.x*state.lineVector.y + u.y*state.lineVector.x;
 
     if (denominator != 0.0)
     {
       // Liegt der Parameter d der Kante zwischen -EPSILON und 1+EPSILON ?
-      d = (-lineVector.x*R.y + lineVector.y*R.x) / denominator;
+      d = (-state.lineVector.x*R.y + state.lineVector.y*R.x) / denominator;
       if ((d >= -EPSILON) && (d < 1.0+EPSILON))
       {
-        edge[edgeIndex].isIntersected = true;
-        edge[edgeIndex].intersection.x = (lineVector.x*(u.y*R.z - u.z*R.y) + lineVector.y*(u.z*R.x - u.x*R.z)) / denominator;
-        edge[edgeIndex].intersection.y = (-u.x*R.y + u.y*R.x) / denominator;
+        state.edgeIntersected[edgeIndex] = true;
+        state.edgeIntersection[edgeIndex].x = (state.lineVector.x*(u.y*R.z - u.z*R.y) + state.lineVector.y*(u.z*R.x - u.x*R.z)) / denominator;
+        state.edgeIntersection[edgeIndex].y = (-u.x*R.y + u.y*R.x) / denominator;
       }
     }
   }
 
-  return edge[edgeIndex].isIntersected;
+  return state.edgeIntersected[edgeIndex];
 }
 
 // ****************************************************************************
@@ -25,6 +25,7 @@
 #include "Geometry.h"
 #include <fstream>
 #include <string>
+#include <vector>
 
 using namespace std;
 
@@ -59,6 +60,9 @@ public:
   /// The default angle that separates between smooth shading and an edge
   static const double STANDARD_CREASE_ANGLE_DEGREE;
 
+  /// Min. number of triangles for which the normals are calculated in parallel
+  static const int MIN_PARALLEL_NORMAL_TRIANGLES = 4096;
+
   // ****************************************************************
   /// A vertex of the surface.
   // ****************************************************************
@@ -71,8 +75,6 @@ public:
     int numAssociates;
     int associatedTriangle[NUM_ASSOCIATED_TRIANGLES];
     int associatedCorner[NUM_ASSOCIATED_TRIANGLES];
-    int reserved;         // Vertex position in relation to a line: -1=left, +1=right, 0=on the line
-	  bool wasTested;       // Was the vertext position in relation to an intersection line tested ?
   };
 
   // ****************************************************************
@@ -96,9 +98,35 @@ public:
   struct Edge
   {
     int vertex[2];          ///< Indices of the two vertices.
-    bool isIntersected;     ///< Was the edge intersected by the intersecting plane?
-	  bool wasTested; 		    ///< Was the edge already tested for an intersection?
-    Point2D intersection;   ///< Projection of the intersection point on the intersecting plane.
+  };
+
+  // ****************************************************************
+  /// @brief The state of the intersection of the surface with a 
+  /// plane/line.
+  ///
+  /// The surface is only read when an intersection is computed with an
+  /// explicit state, so that several intersections of the same surface
+  /// can be computed concurrently, each with its own state.
+  /// The tests of the vertices, edges and triangles are marked with the 
+  /// stamp of the current intersection, so that preparing a new 
+  /// intersection does not need to reset the arrays.
+  // ****************************************************************
+
+  struct IntersectionState
+  {
+    Point2D linePoint;        ///< Origin of the intersecting plane/line (in the xy-plane).
+    Point2D leftLinePoint;    ///< The line origin moved to the left (with resprect to the line) by a tiny amount.
+    Point2D rightLinePoint;   ///< The line origin moved to the right (with resprect to the line) by a tiny amount.
+    Point2D lineVector;       ///< Normalized vector specifying the direction of the intersecting line.
+    int stamp;                      ///< Stamp of the current intersection.
+    vector<int> vertexTested;       ///< Stamp of the intersection, for which the vertex position in relation to the line was tested
+    vector<int> vertexSide;         ///< Vertex position in relation to the line: -1=left, +1=right, 0=on the line
+    vector<int> edgeTested;         ///< Stamp of the intersection, for which the edge was tested
+    vector<char> edgeIntersected;   ///< Was the edge intersected by the intersecting plane?
+    vector<Point2D> edgeIntersection; ///< Projection of the intersection point on the intersecting plane.
+    vector<int> triangleListed;     ///< Stamp of the intersection, for which the triangle was put into the triangle list
+
+    IntersectionState() : stamp(0) {}
   };
 
   // ****************************************************************
@@ -195,8 +223,12 @@ public:
   Point3D getNormal(int rib, int ribPoint);
 
   void swapTriangleOrientation();
+  // Calculates the normals, if the vertices moved since the last call.
   void calculateNormals();
+  // Forces the next call of calculateNormals() to calculate the normals.
+  void invalidateNormals() { normalsValid = false; }
   void flipNormals();
+  void calculateDistances(double matrix[16]);
   void calculatePaintSequence(double matrix[16]);
   void reversePaintSequence();
 
@@ -219,6 +251,15 @@ public:
   // Returns the intersection data for a single triangle.
   bool getTriangleIntersection(int index, Point2D &P0, Point2D &P1, Point2D &n);
 
+  // The same functions with an explicit intersection state, they can be
+  // called concurrently with different states once prepareIntersections()
+  // has been called.
+  void prepareIntersection(Point2D Q, Point2D v, IntersectionState &state) const;
+  bool getTriangleList(IntersectionState &state, int *indexList, 
+    int &numEntries, int MAX_ENTRIES) const;
+  bool getTriangleIntersection(int index, Point2D &P0, Point2D &P1, Point2D &n, 
+    IntersectionState &state) const;
+
   void appendToFile(std::ofstream &file);
   void readFromFile(std::ifstream &file, bool initialize);
 
@@ -227,13 +268,24 @@ public:
   // **************************************************************************
 
 private:
-  Point2D linePoint;        ///< Origin of the intersecting plane/line (in the xy-plane).
-  Point2D leftLinePoint;    ///< The line origin moved to the left (with resprect to the line) by a tiny amount.
-  Point2D rightLinePoint;   ///< The line origin moved to the right (with resprect to the line) by a tiny amount.
-  Point2D lineVector;       ///< Normalized vector specifying the direction of the intersecting line.
+  IntersectionState intersection;   ///< State of the intersections without explicit state.
+
+  /// Vertex coordinates at the last calculation of the normals.
+  vector<Point3D> normalVertexCoord;
+  /// Crease angle at the last calculation of the normals.
+  double normalCreaseAngle_deg;
+  /// Are the normals those calculated for normalVertexCoord (they are
+  /// invalidated when they are changed with setNormal())?
+  bool normalsValid;
+
+  bool verticesMovedSinceNormals();
+  void calculatePlaneNormals(int firstTriangle, int lastTriangle);
+  void calculateCornerNormals(int firstVertex, int lastVertex, double cosCreaseAngle);
 
   void quickSort(int firstIndex, int lastIndex);
-  bool getEdgeIntersection(int edgeIndex);
+  bool getEdgeIntersection(int edgeIndex, IntersectionState &state) const;
+  bool appendTileTriangles(int tileX, int tileY, IntersectionState &state,
+    int *&indexList, int &numEntries, int MAX_ENTRIES) const;
 };
 
 // ****************************************************************************
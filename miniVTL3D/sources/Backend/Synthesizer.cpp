@@ -20,6 +20,7 @@
 // ****************************************************************************
 
 #include "Synthesizer.h"
+#include "TractSequenceFile.h"
 
 
 // ****************************************************************************
@@ -40,6 +41,8 @@ Synthesizer::Synthesizer()
   outputPressureFilter.createChebyshev((double)SYNTHETIC_SPEECH_BANDWIDTH_HZ / (double)SAMPLING_RATE, false, 8);
 
   initialShapesSet = false;
+  controlRate = 1;
+  temporalCoherence = false;
 
   for (i = 0; i < Glottis::MAX_CONTROL_PARAMS; i++)
   {
@@ -85,6 +88,12 @@ void Synthesizer::reset()
 
   outputPressureFilter.resetBuffers();
 
+  // The previous center line belongs to the previous synthesis.
+  if ((vocalTract != NULL) && (temporalCoherence))
+  {
+    vocalTract->setTemporalCoherence(true);
+  }
+
   initialShapesSet = false;
 
   int i;
@@ -114,7 +123,6 @@ void Synthesizer::add(double *newGlottisParams, double *newTractParams,
     return;
   }
 
-  static Tube tube;
   int i;
 
   // Calculate the vocal tract with the new parameters.
@@ -126,10 +134,10 @@ void Synthesizer::add(double *newGlottisParams, double *newTractParams,
   vocalTract->calculateAll();
 
   // Transform the vocal tract model into a tube.
-  vocalTract->getTube(&tube);
+  vocalTract->getTube(&tractTube);
 
   // Synthesize the new audio samples based on the tube model.
-  add(newGlottisParams, &tube, numSamples, audio);
+  add(newGlottisParams, &tractTube, numSamples, audio);
 }
 
 
@@ -182,6 +190,11 @@ void Synthesizer::add(double *newGlottisParams, Tube *newTube,
   double mouthFlow_cm3_s;
   double nostrilFlow_cm3_s;
   double skinFlow_cm3_s;
+  bool tubeChanged;
+
+  // For a constant tube shape (e.g., a static vowel), the tube needs to
+  // be set only once.
+  bool isTubeConstant = (prevTube == *newTube);
 
   // ****************************************************************
   // Run through all new samples.
@@ -193,10 +206,16 @@ void Synthesizer::add(double *newGlottisParams, Tube *newTube,
     ratio1 = 1.0 - ratio;
 
     // ****************************************************************
-    // Interpolate the tube.
+    // Interpolate the tube (only every controlRate samples; the tube
+    // is kept in between).
     // ****************************************************************
 
-    tube.interpolate(&prevTube, newTube, ratio);
+    tubeChanged = false;
+    if (((i % controlRate) == 0) && ((i == 0) || (isTubeConstant == false)))
+    {
+      tube.interpolate(&prevTube, newTube, ratio);
+      tubeChanged = true;
+    }
 
     // ****************************************************************
     // Interpolate the glottis geometry.
@@ -226,7 +245,8 @@ void Synthesizer::add(double *newGlottisParams, Tube *newTube,
       filtering = true;
     }
 
-    tdsModel->setTube(&tube, filtering);
+    // Between the updates of the tube, only the glottis changes.
+    tdsModel->setTube(&tube, filtering, !tubeChanged);
     tdsModel->setFlowSource(0.0, -1);
     tdsModel->setPressureSource(glottis->controlParam[Glottis::PRESSURE].x, Tube::FIRST_TRACHEA_SECTION);
 
@@ -261,6 +281,42 @@ void Synthesizer::add(double *newGlottisParams, Tube *newTube,
 }
 
 
+// ****************************************************************************
+/// Sets the number of samples between two updates of the tube geometry
+/// in add(). With the default value 1, the tube is interpolated for each 
+/// sample. With greater values, the supraglottal tube (and therefore the
+/// components of the corresponding sections of the TDS model) are updated
+/// at this control rate, while the glottis is still updated for each 
+/// sample, which speeds up the synthesis.
+// ****************************************************************************
+
+void Synthesizer::setControlRate(int numSamples)
+{
+  if (numSamples < 1)
+  {
+    numSamples = 1;
+  }
+  controlRate = numSamples;
+}
+
+
+// ****************************************************************************
+/// Enables or disables the temporal coherence of the calculations of the
+/// vocal tract in add(). The normals of the center line are then partly
+/// taken from the previous call, which speeds up the calculation of 
+/// consecutive, similar shapes.
+// ****************************************************************************
+
+void Synthesizer::setTemporalCoherence(bool enabled)
+{
+  temporalCoherence = enabled;
+  if (vocalTract != NULL)
+  {
+    vocalTract->setTemporalCoherence(enabled);
+  }
+}
+
+
 // ****************************************************************************
 /// Static function that takes the samples of type double of the source signal
 /// and copies them to the position startPosInTarget in the target signal with
@@ -296,114 +352,74 @@ void Synthesizer::synthesizeGesturalScore(GesturalScore *gesturalScore,
 */
 
 // ****************************************************************************
-/// Synthesis (blocking) of a tube sequence from the data in a TXT file.
+/// Synthesis (blocking) of a tube sequence from the data in a TXT file or
+/// in a binary sequence file (see TractSequenceFile.h).
 // ****************************************************************************
 
 bool Synthesizer::synthesizeTubeSequence(string fileName,
   Glottis *glottis, TdsModel *tdsModel, vector<double> &audio)
 {
   // ****************************************************************
-  // Open the file.
+  // Open the file (text or binary) and read the glottis model type
+  // and the number of states.
   // ****************************************************************
 
-  ifstream file(fileName);
+  int numGlottisParams = (int)glottis->controlParam.size();
+  SequenceFileReader file;
+  string error;
 
-  if (file.is_open() == false)
+  if (file.open(fileName, TUBE_SEQUENCE, numGlottisParams, error) == false)
   {
-    printf("Error in synthesizeTubeSequence(): File could not be opened.\n");
+    printf("Error in synthesizeTubeSequence(): %s\n", error.c_str());
     return false;
   }
 
-  // ****************************************************************
-  // Save the current state of the glottis.
-  // ****************************************************************
-
-  glottis->storeControlParams();
-
-  // ****************************************************************
-  // Read the 11 comment lines, the glottis model type, and the 
-  // number of states.
-  // ****************************************************************
-
-  int i, k;
-  string line;
-
-  for (i = 0; i < 10; i++)
-  {
-    getline(file, line);
-  }
-
-  // Read the type of glottis model.
-  
-  getline(file, line);
-
-  if (line != glottis->getName())
+  if (file.glottisName() != glottis->getName())
   {
     printf("Error in synthesizeTubeSequence(): The selected glottis model does not correspond to the one used in the file.\n");
     return false;
   }
 
-  // Read the number of states.
-  
-  double temp = 0.0;
-  getline(file, line);
-  if (parseTextLine(line, 1, &temp) == false)
-  {
-    printf("Error in synthesizeTubeSequence(): Invalid number of states.\n");
-    return false;
-  }
+  int numStates = file.numStates();
+
+  // ****************************************************************
+  // Save the current state of the glottis.
+  // ****************************************************************
 
-  int numStates = (int)temp;
+  glottis->storeControlParams();
 
   // ****************************************************************
   // Generate the audio signal.
   // ****************************************************************
 
+  int i, k;
   vector<double> signalPart;
-  int numGlottisParams = (int)glottis->controlParam.size();
   Tube tube;
   double incisorPos = 0.0;
   double velumOpening = 0.0;
   double tongueTipSideElevation = 0.0;
 
+  const int N = Tube::NUM_PHARYNX_MOUTH_SECTIONS;
   double glottisParams[Glottis::MAX_CONTROL_PARAMS];
-  double miscData[3];    // For incisor position, nasal port area, and tongue tip side elevation.
-  double tubeArea[Tube::NUM_PHARYNX_MOUTH_SECTIONS];
-  double tubeLength[Tube::NUM_PHARYNX_MOUTH_SECTIONS];
-  double tubeArticulatorDouble[Tube::NUM_PHARYNX_MOUTH_SECTIONS];
+  // The incisor position, nasal port area, and tongue tip side elevation,
+  // followed by the areas, lengths and articulators of the sections.
+  double stateValues[3 + 3 * N];
+  double *miscData = stateValues;
+  double *tubeArea = &stateValues[3];
+  double *tubeLength = &stateValues[3 + N];
+  double *tubeArticulatorDouble = &stateValues[3 + 2 * N];
   Tube::Articulator tubeArticulator[Tube::NUM_PHARYNX_MOUTH_SECTIONS];
   
-  bool glottisParamsOk = true;
-  bool miscDataOk = true;
-  bool tubeAreaOk = true;
-  bool tubeLengthOk = true;
-  bool tubeArticulatorOk = true;
   bool stateOk = true;
 
   Synthesizer *synth = new Synthesizer();
   synth->init(glottis, NULL, tdsModel);     // Vocal tract model is not needed here (= NULL).
   audio.resize(0);
+  audio.reserve((size_t)numStates * NUM_CHUNCK_SAMPLES);
 
   for (i = 0; (i < numStates) && (stateOk); i++)
   {
-    getline(file, line);
-    glottisParamsOk = parseTextLine(line, numGlottisParams, glottisParams);
-
-    getline(file, line);
-    miscDataOk = parseTextLine(line, 3, miscData);
-
-    getline(file, line);
-    tubeAreaOk = parseTextLine(line, Tube::NUM_PHARYNX_MOUTH_SECTIONS, tubeArea);
-
-    getline(file, line);
-    tubeLengthOk = parseTextLine(line, Tube::NUM_PHARYNX_MOUTH_SECTIONS, tubeLength);
-
-    getline(file, line);
-    tubeArticulatorOk = parseTextLine(line, Tube::NUM_PHARYNX_MOUTH_SECTIONS, tubeArticulatorDouble);
-
-    // **************************************************************
-
-    if ((glottisParamsOk) && (miscDataOk) && (tubeAreaOk) && (tubeLengthOk) && (tubeArticulatorOk))
+    if (file.readState(glottisParams, stateValues))
     {
       stateOk = true;
 
@@ -457,65 +473,42 @@ bool Synthesizer::synthesizeTubeSequence(string fileName,
 
 // ****************************************************************************
 /// Synthesis (blocking) of a sequence of glottis and vocal tract parameters
-/// from the data in a TXT file.
+/// from the data in a TXT file or in a binary sequence file (see 
+/// TractSequenceFile.h).
 // ****************************************************************************
 
 bool Synthesizer::synthesizeTractSequence(string fileName,
   Glottis *glottis, VocalTract *vocalTract, TdsModel *tdsModel, vector<double> &audio)
 {
   // ****************************************************************
-  // Open the file.
+  // Open the file (text or binary) and read the type of the glottis
+  // model and the number of states.
   // ****************************************************************
 
-  ifstream file(fileName);
+  int numGlottisParams = (int)glottis->controlParam.size();
+  SequenceFileReader file;
+  string error;
 
-  if (file.is_open() == false)
+  if (file.open(fileName, TRACT_SEQUENCE, numGlottisParams, error) == false)
   {
-    printf("Error in synthesizeTractSequence(): File could not be opened.\n");
+    printf("Error in synthesizeTractSequence(): %s\n", error.c_str());
     return false;
   }
 
-  // ****************************************************************
-  // Save the current state of the glottis and the vocal tract.
-  // ****************************************************************
-
-  glottis->storeControlParams();
-  vocalTract->storeControlParams();
-
-  // ****************************************************************
-  // Read the six comment lines, the type of the glottis model, and
-  // the number of states.
-  // ****************************************************************
-
-  string line;
-
-  getline(file, line);
-  getline(file, line);
-  getline(file, line);
-  getline(file, line);
-  getline(file, line);
-  getline(file, line);
-
-  // Read the type of glottis model.
-  getline(file, line);
-
-  if (line != glottis->getName())
+  if (file.glottisName() != glottis->getName())
   {
     printf("Error in synthesizeTractSequence(): The selected glottis model does not correspond to the one used in the file.\n");
     return false;
   }
 
-  // Read the number of states.
+  int numStates = file.numStates();
 
-  double temp = 0.0;
-  getline(file, line);
-  if (parseTextLine(line, 1, &temp) == false)
-  {
-    printf("Error in synthesizeTractSequence(): Invalid number of states.\n");
-    return false;
-  }
+  // ****************************************************************
+  // Save the current state of the glottis and the vocal tract.
+  // ****************************************************************
 
-  int numStates = (int)temp;
+  glottis->storeControlParams();
+  vocalTract->storeControlParams();
 
   // ****************************************************************
   // Generate the audio signal.
@@ -525,24 +518,16 @@ bool Synthesizer::synthesizeTractSequence(string fileName,
   vector<double> signalPart;
   double tractParams[VocalTract::NUM_PARAMS];
   double glottisParams[Glottis::MAX_CONTROL_PARAMS];
-  int numGlottisParams = (int)glottis->controlParam.size();
-  bool glottisParamsOk = false;
-  bool tractParamsOk = false;
   bool stateOk = true;
 
   Synthesizer *synth = new Synthesizer();
   synth->init(glottis, vocalTract, tdsModel);
   audio.resize(0);
+  audio.reserve((size_t)numStates * NUM_CHUNCK_SAMPLES);
 
   for (i = 0; (i < numStates) && (stateOk); i++)
   {
-    getline(file, line);
-    glottisParamsOk = parseTextLine(line, numGlottisParams, glottisParams);
-
-    getline(file, line);
-    tractParamsOk = parseTextLine(line, VocalTract::NUM_PARAMS, tractParams);
-
-    if ((glottisParamsOk) && (tractParamsOk))
+    if (file.readState(glottisParams, tractParams))
     {
       stateOk = true;
       synth->add(glottisParams, tractParams, NUM_CHUNCK_SAMPLES, signalPart);
@@ -720,25 +705,4 @@ bool Synthesizer::gesturalScoreToTubeSequenceFile(GesturalScore *gesturalScore,
 */
 
 // ****************************************************************************
-/// Parse a text line (string) and obtain the space-separated numeric values.
-// ****************************************************************************
-
-bool Synthesizer::parseTextLine(string line, int numValues, double *values)
-{
-  int i;
-  bool ok = true;
-  istringstream iss(line);
-
-  for (i = 0; (i < numValues) && (ok); i++)
-  {
-    if (!(iss >> values[i]))
-    {
-      ok = false;
-    }
-  }
-
-  return ok;
-}
-
-// ****************************************************************************
 
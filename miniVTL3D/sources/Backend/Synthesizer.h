@@ -64,6 +64,11 @@ public:
   void reset();
   void add(double *newGlottisParams, double *newTractParams, int numSamples, vector<double> &audio);
   void add(double *newGlottisParams, Tube *newTube, int numSamples, vector<double> &audio);
+  void setControlRate(int numSamples);
+  int getControlRate() { return controlRate; }
+  // Calculates the vocal tract passed to init() with temporal coherence
+  // between the calls of add() (see VocalTract::setTemporalCoherence()).
+  void setTemporalCoherence(bool enabled);
 
   // **************************************************************************
 
@@ -98,7 +103,13 @@ private:
 
   Tube prevTube;
   Tube tube;
+  // Tube of the vocal tract shape passed to add() (scratch of each instance,
+  // so that several synthesizers can run in parallel)
+  Tube tractTube;
   double prevGlottisParams[Glottis::MAX_CONTROL_PARAMS];
+  /// Number of samples between two updates of the interpolated tube
+  int controlRate;
+  bool temporalCoherence;
 
   static const int TDS_BUFFER_LENGTH = 256;
   static const int TDS_BUFFER_MASK = 255;
@@ -107,14 +118,6 @@ private:
   double *outputPressure;
   IirFilter outputPressureFilter;
   bool initialShapesSet;
-
-  // **************************************************************************
-  // Private functions.
-  // **************************************************************************
-
-private:
-  static bool parseTextLine(string line, int numValues, double *values);
-
 };
 
 #endif
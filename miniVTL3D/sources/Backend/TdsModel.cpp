@@ -41,6 +41,14 @@ const double TdsModel::MIN_AREA_CM2 = 0.01E-2; // = 0.01 mm^2;
 // Cutoff-freq. of the low-pass filter for the flow that induces friction
 const double TdsModel::NOISE_CUTOFF_FREQ = 500.0;     
 
+// Relaxation factors of the SOR method (the initial value is the optimum
+// determined experimentally for the fixed relaxation)
+const double TdsModel::SOR_INITIAL_OMEGA = 1.25;
+const double TdsModel::SOR_MIN_OMEGA = 1.0;
+const double TdsModel::SOR_MAX_OMEGA = 1.9;
+const double TdsModel::SOR_INITIAL_OMEGA_STEP = 0.05;
+const double TdsModel::SOR_MIN_OMEGA_STEP = 0.01;
+
 
 // ****************************************************************************
 /// Constructor.
@@ -50,6 +58,13 @@ TdsModel::TdsModel()
 {
   constrictionBuffer = new Constriction[CONSTRICTION_BUFFER_SIZE];
   constrictionMonitorTubeSection = 0;
+  constrictionsValid = false;
+  tubeAreasSettled = false;
+  statisticsEnabled = false;
+  resetStatistics();
+
+  sorMaxIterations = 100;
+  adaptiveSor = true;
 
   // ****************************************************************
   // Acoustic options
@@ -62,7 +77,8 @@ TdsModel::TdsModel()
   options.piriformFossa = true;
   options.innerLengthCorrections = false;
   options.transvelarCoupling = false;
-  options.solverType = CHOLESKY_FACTORIZATION; // CHOLESKY_FACTORIZATION | SOR_GAUSS_SEIDEL
+  options.monitorConstrictions = false;
+  options.solverType = SKYLINE_CHOLESKY_FACTORIZATION; // SKYLINE_CHOLESKY_FACTORIZATION | CHOLESKY_FACTORIZATION | SOR_GAUSS_SEIDEL
 
   // ****************************************************************
 
@@ -92,6 +108,7 @@ void TdsModel::initModel()
   int i, j, k;
 
   SORIterations = 0;
+  SORResidualNorm = 0.0;
   timeStep = 1.0 / (double)SAMPLING_RATE;
 
   // The network components of the static tube segments must be
@@ -379,6 +396,148 @@ void TdsModel::initModel()
     }
   }
 
+  // ****************************************************************
+  // Init the help structures for the cholesky factorization in 
+  // skyline storage.
+  // ****************************************************************
+
+  prepareSkylineFactorization();
+}
+
+
+// ****************************************************************************
+/// Symbolic analysis for the cholesky factorization in skyline storage.
+/// The sparsity pattern of the matrix only depends on the topology of the
+/// branch currents, so that the ordering of the unknowns and the profile of
+/// the factor are determined once here, and each time step only needs the
+/// numeric factorization in solveEquationsSkyline().
+/// Must be called after the help variables for Gauss-Seidel were set.
+// ****************************************************************************
+
+void TdsModel::prepareSkylineFactorization()
+{
+  int i, j, k, v;
+  bool adjacent[NUM_BRANCH_CURRENTS][NUM_BRANCH_CURRENTS];
+  int degree[NUM_BRANCH_CURRENTS];
+  int newIndex[NUM_BRANCH_CURRENTS];
+
+  // ****************************************************************
+  // Symmetric adjacency of the unknowns from the non-zero places of 
+  // the matrix.
+  // ****************************************************************
+
+  for (i = 0; i < NUM_BRANCH_CURRENTS; i++)
+  {
+    for (j = 0; j < NUM_BRANCH_CURRENTS; j++)
+    {
+      adjacent[i][j] = false;
+    }
+  }
+
+  for (i = 0; i < NUM_BRANCH_CURRENTS; i++)
+  {
+    for (k = 0; k < numFilledRowValues[i]; k++)
+    {
+      j = filledRowIndex[i][k];
+      adjacent[i][j] = true;
+      adjacent[j][i] = true;
+    }
+  }
+
+  for (i = 0; i < NUM_BRANCH_CURRENTS; i++)
+  {
+    degree[i] = 0;
+    newIndex[i] = -1;
+    for (j = 0; j < NUM_BRANCH_CURRENTS; j++)
+    {
+      if (adjacent[i][j]) { degree[i]++; }
+    }
+  }
+
+  // ****************************************************************
+  // Cuthill-McKee ordering: breadth-first search starting from an
+  // unknown of minimal degree of each connected component, visiting 
+  // the neighbours by increasing degree.
+  // ****************************************************************
+
+  int numOrdered = 0;
+  while (numOrdered < NUM_BRANCH_CURRENTS)
+  {
+    int start = -1;
+    for (i = 0; i < NUM_BRANCH_CURRENTS; i++)
+    {
+      if ((newIndex[i] == -1) && ((start == -1) || (degree[i] < degree[start])))
+      {
+        start = i;
+      }
+    }
+
+    int queueStart = numOrdered;
+    newIndex[start] = numOrdered;
+    skylineOrder[numOrdered++] = start;
+
+    for (; queueStart < numOrdered; queueStart++)
+    {
+      i = skylineOrder[queueStart];
+      int firstNeighbour = numOrdered;
+
+      for (j = 0; j < NUM_BRANCH_CURRENTS; j++)
+      {
+        if ((adjacent[i][j]) && (newIndex[j] == -1))
+        {
+          newIndex[j] = numOrdered;
+          skylineOrder[numOrdered++] = j;
+        }
+      }
+
+      // Sort the new neighbours by increasing degree (insertion sort).
+      for (k = firstNeighbour + 1; k < numOrdered; k++)
+      {
+        int current = skylineOrder[k];
+        for (v = k - 1; (v >= firstNeighbour) && (degree[skylineOrder[v]] > degree[current]); v--)
+        {
+          skylineOrder[v + 1] = skylineOrder[v];
+        }
+        skylineOrder[v + 1] = current;
+      }
+    }
+  }
+
+  // Reverse the ordering, which gives a smaller fill-in of the factor.
+
+  for (i = 0; i < NUM_BRANCH_CURRENTS / 2; i++)
+  {
+    j = skylineOrder[i];
+    skylineOrder[i] = skylineOrder[NUM_BRANCH_CURRENTS - 1 - i];
+    skylineOrder[NUM_BRANCH_CURRENTS - 1 - i] = j;
+  }
+
+  for (i = 0; i < NUM_BRANCH_CURRENTS; i++)
+  {
+    newIndex[skylineOrder[i]] = i;
+  }
+
+  // ****************************************************************
+  // Profile of the renumbered matrix: each row of the lower triangle
+  // is stored from its first non-zero column to the main diagonal.
+  // The factor has no fill-in outside of this profile.
+  // ****************************************************************
+
+  numSkylineElements = 0;
+  for (i = 0; i < NUM_BRANCH_CURRENTS; i++)
+  {
+    skylineFirstColumn[i] = i;
+    for (j = 0; j < NUM_BRANCH_CURRENTS; j++)
+    {
+      if ((adjacent[skylineOrder[i]][j]) && (newIndex[j] < skylineFirstColumn[i]))
+      {
+        skylineFirstColumn[i] = newIndex[j];
+      }
+    }
+
+    skylineRowOffset[i] = numSkylineElements - skylineFirstColumn[i];
+    numSkylineElements += i - skylineFirstColumn[i] + 1;
+  }
 }
 
 
@@ -390,7 +549,6 @@ void TdsModel::resetMotion()
 {
   const double Q = 0.5;
   TubeSection *ts;
-  BranchCurrent *bc;
   int i, k;
 
   // ****************************************************************
@@ -408,21 +566,23 @@ void TdsModel::resetMotion()
   {
     ts = &tubeSection[i];
 
-    ts->pressure         = 0.0;
-    ts->pressureRate     = 0.0;
-    ts->wallCurrent      = 0.0;
-    ts->wallCurrentRate  = 0.0;
-    ts->wallCurrentRate2 = 0.0;
+    sectionPressure[i]     = 0.0;
+    sectionPressureRate[i] = 0.0;
+    wallCurrent[i]         = 0.0;
+    wallCurrentRate[i]     = 0.0;
+    wallCurrentRate2[i]    = 0.0;
     
     // Intermediate values ********************************
     ts->L                = 0.0;
     ts->C                = 0.0;
     ts->R[0] = ts->R[1]  = 0.0;
     ts->S                = 0.0;
-    ts->alpha            = 0.0;
-    ts->beta             = 0.0;
-    ts->D                = 0.0;
-    ts->E                = 0.0;
+    ts->Lw               = 0.0;
+    ts->Rw               = 0.0;
+    wallAlpha[i]         = 0.0;
+    wallBeta[i]          = 0.0;
+    sectionD[i]          = 0.0;
+    sectionE[i]          = 0.0;
 
     // Set the noise sources to 0 ***********************************
 
@@ -470,11 +630,9 @@ void TdsModel::resetMotion()
 
   for (i=0; i < NUM_BRANCH_CURRENTS; i++)
   {
-    bc = &branchCurrent[i];
-
-    bc->magnitude = 0.0;
-    bc->magnitudeRate = 0.0;
-    bc->noiseMagnitude = 0.0;
+    currentMagnitude[i] = 0.0;
+    currentMagnitudeRate[i] = 0.0;
+    currentNoiseMagnitude[i] = 0.0;
   }
 
   flowSourceAmp = 0.0;
@@ -482,6 +640,8 @@ void TdsModel::resetMotion()
   position = 0;             // The internal position counter
 
   numConstrictions = 0;
+  constrictionsValid = false;
+  tubeAreasSettled = false;
 
   aspirationStrength_dB = Tube::DEFAULT_ASPIRATION_STRENGTH_DB;
 
@@ -494,8 +654,16 @@ void TdsModel::resetMotion()
   for (i=0; i < NUM_BRANCH_CURRENTS; i++) 
   { 
     flowVector[i] = 0.0; 
+    prevCurrentMagnitude[i] = 0.0;
   }
 
+  sorOmega = SOR_INITIAL_OMEGA;
+  sorOmegaStep = SOR_INITIAL_OMEGA_STEP;
+  sorRateSum = 0.0;
+  sorPrevRate = 0.0;
+  numSorRateSteps = 0;
+  numSorHistorySteps = 0;
+
   transglottalPressureFilter.createChebyshev(50.0 / (double)SAMPLING_RATE, false, 4);
   transglottalPressureFilter.resetBuffers();
 
@@ -571,9 +739,12 @@ void TdsModel::resetMotion()
   // Reset the constriction data in the constriction buffer.
   // ****************************************************************
 
-  for (i = 0; i < CONSTRICTION_BUFFER_SIZE; i++)
+  if (options.monitorConstrictions)
   {
-    resetConstriction(&constrictionBuffer[i]);
+    for (i = 0; i < CONSTRICTION_BUFFER_SIZE; i++)
+    {
+      resetConstriction(&constrictionBuffer[i]);
+    }
   }
 }
 
@@ -584,7 +755,7 @@ void TdsModel::resetMotion()
 
 bool TdsModel::saveConstrictionBuffer(std::string fileName)
 {
-  if (fileName.empty())
+  if ((fileName.empty()) || (options.monitorConstrictions == false))
   {
     return false;
   }
@@ -642,21 +813,183 @@ bool TdsModel::saveConstrictionBuffer(std::string fileName)
 }
 
 
+// ****************************************************************************
+/// Clears the counters of the simulation.
+// ****************************************************************************
+
+void TdsModel::resetStatistics()
+{
+  int i;
+
+  statistics.numTimeSteps = 0;
+  statistics.prepareTime_s = 0.0;
+  statistics.matrixTime_s = 0.0;
+  statistics.solveTime_s = 0.0;
+  statistics.updateTime_s = 0.0;
+
+  statistics.numSorTimeSteps = 0;
+  statistics.numSorIterations = 0;
+  statistics.maxSorIterations = 0;
+  statistics.sumSorResidualNorm = 0.0;
+  statistics.maxSorResidualNorm = 0.0;
+
+  statistics.envelopeSize = 0;
+  statistics.skylineSize = 0;
+
+  statistics.numConstrictions = 0;
+  statistics.numActiveNoiseSources = 0;
+  statistics.maxActiveNoiseSources = 0;
+
+  for (i = 0; i < NUM_STATISTICS_BINS; i++)
+  {
+    statistics.sorIterationHistogram[i] = 0;
+    statistics.sorResidualHistogram[i] = 0;
+    statistics.noiseSourceHistogram[i] = 0;
+  }
+
+  for (i = 0; i <= MAX_CONSTRICTIONS; i++)
+  {
+    statistics.constrictionHistogram[i] = 0;
+  }
+}
+
+
+// ****************************************************************************
+/// Returns the counters accumulated since the last call of resetStatistics().
+// ****************************************************************************
+
+TdsModel::Statistics TdsModel::getStatistics()
+{
+  // The storage of the factorizations only depends on the topology of the
+  // network and is determined in initModel().
+
+  statistics.envelopeSize = NUM_BRANCH_CURRENTS;
+  for (int i = 0; i < NUM_BRANCH_CURRENTS; i++)
+  {
+    statistics.envelopeSize += numFilledRowValuesSymmetricEnvelope[i];
+  }
+  statistics.skylineSize = numSkylineElements;
+
+  return statistics;
+}
+
+
+// ****************************************************************************
+/// Writes the counters and histograms of the simulation to a text file.
+// ****************************************************************************
+
+bool TdsModel::writeStatistics(const string &fileName)
+{
+  ofstream os(fileName);
+
+  if (!os)
+  {
+    std::cout << "ERROR: Could not open " << fileName << " for writing." << endl;
+    return false;
+  }
+
+  Statistics s = getStatistics();
+  double numSteps = (s.numTimeSteps > 0) ? (double)s.numTimeSteps : 1.0;
+  double numSorSteps = (s.numSorTimeSteps > 0) ? (double)s.numSorTimeSteps : 1.0;
+  int i;
+
+  os << "Time steps: " << s.numTimeSteps << endl;
+  os << "Time per step (us): prepareTimeStep " << 1e6 * s.prepareTime_s / numSteps
+    << " calcMatrix " << 1e6 * s.matrixTime_s / numSteps
+    << " solve " << 1e6 * s.solveTime_s / numSteps
+    << " updateVariables " << 1e6 * s.updateTime_s / numSteps << endl;
+  os << "Stored matrix elements: envelope " << s.envelopeSize 
+    << " skyline " << s.skylineSize << endl;
+  os << "SOR time steps: " << s.numSorTimeSteps << endl;
+  os << "SOR iterations: mean " << (double)s.numSorIterations / numSorSteps 
+    << " max " << s.maxSorIterations << endl;
+  os << "SOR residual norm: mean " << s.sumSorResidualNorm / numSorSteps 
+    << " max " << s.maxSorResidualNorm << endl;
+  os << "Constrictions: mean " << (double)s.numConstrictions / numSteps << endl;
+  os << "Active noise sources: mean " << (double)s.numActiveNoiseSources / numSteps
+    << " max " << s.maxActiveNoiseSources << endl;
+
+  os << endl << "SOR iterations (bin lower_bound time_steps)" << endl;
+  for (i = 0; i < NUM_STATISTICS_BINS; i++)
+  {
+    os << i << " " << ((i == 0) ? 0 : 1 << (i - 1)) << " " << s.sorIterationHistogram[i] << endl;
+  }
+
+  os << endl << "SOR residual norm (bin lower_bound time_steps)" << endl;
+  for (i = 0; i < NUM_STATISTICS_BINS; i++)
+  {
+    os << i << " " << pow(10.0, i - 12) << " " << s.sorResidualHistogram[i] << endl;
+  }
+
+  os << endl << "Constrictions (number time_steps)" << endl;
+  for (i = 0; i <= MAX_CONSTRICTIONS; i++)
+  {
+    os << i << " " << s.constrictionHistogram[i] << endl;
+  }
+
+  os << endl << "Active noise sources (bin lower_bound time_steps)" << endl;
+  for (i = 0; i < NUM_STATISTICS_BINS; i++)
+  {
+    os << i << " " << ((i == 0) ? 0 : 1 << (i - 1)) << " " << s.noiseSourceHistogram[i] << endl;
+  }
+
+  return true;
+}
+
+
+// ****************************************************************************
+/// Returns the bin of the value n >= 0 in the histograms of the statistics:
+/// 0 for n = 0 and k for 2^(k-1) <= n < 2^k.
+// ****************************************************************************
+
+int TdsModel::getStatisticsBin(int n)
+{
+  int bin = 0;
+  while ((n > 0) && (bin < NUM_STATISTICS_BINS - 1))
+  {
+    n >>= 1;
+    bin++;
+  }
+  return bin;
+}
+
+
 // ****************************************************************************
 // ****************************************************************************
 
-void TdsModel::setTube(Tube *tube, bool filtering)
+void TdsModel::setTube(Tube *tube, bool filtering, bool onlyGlottisChanged)
 {
   int i;
   TubeSection *target = NULL;
   Tube::Section *source = NULL;
   double oldArea_cm2 = 0.0;
   double newArea_cm2 = 0.0;
+  double oldPos_cm, oldLength_cm;
+  Tube::Articulator oldArticulator;
+
+  // When only the glottis changed (and with it the positions of the 
+  // trachea sections) and the smoothed areas reached the areas of the 
+  // tube, the sections above the glottis would be set to their current 
+  // values again.
+
+  int numSections = Tube::NUM_SECTIONS;
+  if ((onlyGlottisChanged) && (tubeAreasSettled))
+  {
+    numSections = Tube::UPPER_GLOTTIS_SECTION + 1;
+  }
+  else
+  {
+    tubeAreasSettled = true;
+  }
 
-  for (i = 0; i < Tube::NUM_SECTIONS; i++)
+  for (i = 0; i < numSections; i++)
   {
     source = tube->section[i];
     target = &tubeSection[i];
+    oldPos_cm = target->pos;
+    oldArea_cm2 = target->area;
+    oldLength_cm = target->length;
+    oldArticulator = target->articulator;
 
     // If the new tube comes from a continuous sequence (filtering = true)
     // and the tube section belongs to the pharyngeal or oral cavity
@@ -718,6 +1051,11 @@ void TdsModel::setTube(Tube *tube, bool filtering)
         }
       }
 
+      if (newArea_cm2 != source->area_cm2)
+      {
+        tubeAreasSettled = false;
+      }
+
       target->pos = source->pos_cm;
       target->area = newArea_cm2;
       target->length = source->length_cm;
@@ -756,6 +1094,23 @@ void TdsModel::setTube(Tube *tube, bool filtering)
     }
 
     target->articulator = source->articulator;
+
+    // The constrictions for the noise sources are determined again,
+    // when the pharyngeal or oral geometry has changed.
+
+    if ((i >= Tube::FIRST_PHARYNX_SECTION) && (i <= Tube::LAST_MOUTH_SECTION) &&
+      ((target->pos != oldPos_cm) || (target->area != oldArea_cm2) || 
+       (target->length != oldLength_cm) || (target->articulator != oldArticulator)))
+    {
+      constrictionsValid = false;
+    }
+  }
+
+  if ((teethPosition != tube->teethPosition_cm) || 
+    (aspirationStrength_dB != tube->aspirationStrength_dB) ||
+    (tongueTipSideElevation != tube->tongueTipSideElevation))
+  {
+    constrictionsValid = false;
   }
 
   // Set the teeth position
@@ -849,15 +1204,27 @@ void TdsModel::setPressureSource(double pressure_dPa, int section)
 double TdsModel::proceedTimeStep(double& mouthFlow_cm3_s, double& nostrilFlow_cm3_s,
   double& skinFlow_cm3_s, const string &matrixFileName)
 {
-  TubeSection *ts = NULL;
+  typedef std::chrono::steady_clock Clock;
+  Clock::time_point prepareStart, matrixStart, solveStart, updateStart;
+
+  if (statisticsEnabled) { prepareStart = Clock::now(); }
 
   // Calculation of resistors and other values.
   prepareTimeStep();
   
+  if (statisticsEnabled) { matrixStart = Clock::now(); }
+
   // Calculation of the matrix coefficients.
   calcMatrix();
 
-  if (options.solverType == CHOLESKY_FACTORIZATION)
+  if (statisticsEnabled) { solveStart = Clock::now(); }
+
+  if (options.solverType == SKYLINE_CHOLESKY_FACTORIZATION)
+  {
+    // Solve the system of eqs. with cholesky factorization in skyline storage
+    solveEquationsSkyline();
+  }
+  else if (options.solverType == CHOLESKY_FACTORIZATION)
   {
     // Solve the system of eqs. with cholesky factorization
     solveEquationsCholesky();
@@ -868,9 +1235,41 @@ double TdsModel::proceedTimeStep(double& mouthFlow_cm3_s, double& nostrilFlow_cm
     solveEquationsSor(matrixFileName);
   }
 
+  if (statisticsEnabled) { updateStart = Clock::now(); }
+
   // Recalculate all currents, pressures and their derivatives.
   updateVariables();
 
+  if (statisticsEnabled)
+  {
+    Clock::time_point updateEnd = Clock::now();
+    statistics.prepareTime_s += std::chrono::duration<double>(matrixStart - prepareStart).count();
+    statistics.matrixTime_s += std::chrono::duration<double>(solveStart - matrixStart).count();
+    statistics.solveTime_s += std::chrono::duration<double>(updateStart - solveStart).count();
+    statistics.updateTime_s += std::chrono::duration<double>(updateEnd - updateStart).count();
+    statistics.numTimeSteps++;
+
+    // The constrictions are only determined with the noise sources.
+    int n = options.generateNoiseSources ? numConstrictions : 0;
+    statistics.numConstrictions += n;
+    statistics.constrictionHistogram[n]++;
+  }
+
+  return getRadiatedFlow(mouthFlow_cm3_s, nostrilFlow_cm3_s, skinFlow_cm3_s);
+}
+
+
+// ****************************************************************************
+/// Returns the flows radiated at the mouth, the nostrils and the skin after
+/// the variables of the time step have been updated, and increments the 
+/// sampling position.
+// ****************************************************************************
+
+double TdsModel::getRadiatedFlow(double &mouthFlow_cm3_s, 
+  double &nostrilFlow_cm3_s, double &skinFlow_cm3_s)
+{
+  TubeSection *ts = NULL;
+
   // ****************************************************************
   // Get the radiated flow.
   // ****************************************************************
@@ -878,14 +1277,14 @@ double TdsModel::proceedTimeStep(double& mouthFlow_cm3_s, double& nostrilFlow_cm
   mouthFlow_cm3_s = 0.0;
 
   ts = &tubeSection[Tube::LAST_MOUTH_SECTION];
-  if (ts->currentOut[0] != -1) { mouthFlow_cm3_s += branchCurrent[ ts->currentOut[0] ].magnitude; }
-  if (ts->currentOut[1] != -1) { mouthFlow_cm3_s += branchCurrent[ ts->currentOut[1] ].magnitude; }
+  if (ts->currentOut[0] != -1) { mouthFlow_cm3_s += currentMagnitude[ ts->currentOut[0] ]; }
+  if (ts->currentOut[1] != -1) { mouthFlow_cm3_s += currentMagnitude[ ts->currentOut[1] ]; }
 
   nostrilFlow_cm3_s = 0.0;
 
   ts = &tubeSection[Tube::LAST_NOSE_SECTION];
-  if (ts->currentOut[0] != -1) { nostrilFlow_cm3_s += branchCurrent[ ts->currentOut[0] ].magnitude; }
-  if (ts->currentOut[1] != -1) { nostrilFlow_cm3_s += branchCurrent[ ts->currentOut[1] ].magnitude; }
+  if (ts->currentOut[0] != -1) { nostrilFlow_cm3_s += currentMagnitude[ ts->currentOut[0] ]; }
+  if (ts->currentOut[1] != -1) { nostrilFlow_cm3_s += currentMagnitude[ ts->currentOut[1] ]; }
 
   // ****************************************************************
   // Consider the sound radiation from the skin near the glottis.
@@ -895,8 +1294,7 @@ double TdsModel::proceedTimeStep(double& mouthFlow_cm3_s, double& nostrilFlow_cm
 
   if (options.radiationFromSkin)
   {
-    ts = &tubeSection[Tube::FIRST_PHARYNX_SECTION];
-    skinFlow_cm3_s = glottalToneFilter.getOutputSample(ts->pressure);
+    skinFlow_cm3_s = glottalToneFilter.getOutputSample(sectionPressure[Tube::FIRST_PHARYNX_SECTION]);
   }
   
   // Increase the internal position counter to the next sample.
@@ -935,6 +1333,31 @@ void TdsModel::prepareTimeStep()
     }
 
     ts->S = 0.0;      // No pressure source at the inlet of the section
+
+    // **************************************************************
+    // The components L, C, the viscous resistance and the wall 
+    // components only depend on the geometry and the wall properties.
+    // Between the updates of the tube geometry, only the sections 
+    // that changed (e.g., the glottis) are recalculated.
+    // **************************************************************
+
+    if ((doNetworkInitialization == false) && (options.softWalls == staticSoftWalls) &&
+      (ts->area == ts->staticArea) && (ts->length == ts->staticLength) &&
+      (ts->volume == ts->staticVolume) && (ts->Mw == ts->staticMw) &&
+      (ts->Bw == ts->staticBw) && (ts->Kw == ts->staticKw))
+    {
+      ts->R[0] = ts->staticR;
+      ts->R[1] = ts->staticR;
+      continue;
+    }
+
+    ts->staticArea = ts->area;
+    ts->staticLength = ts->length;
+    ts->staticVolume = ts->volume;
+    ts->staticMw = ts->Mw;
+    ts->staticBw = ts->Bw;
+    ts->staticKw = ts->Kw;
+
     circ = 2.0*sqrt(ts->area*M_PI);
 
     // **************************************************************
@@ -977,13 +1400,16 @@ void TdsModel::prepareTimeStep()
       ts->R[1] = ts->R[0];
     }
 
+    ts->staticR = ts->R[0];
+
     // **************************************************************
-    // The alpha and beta values for the incorporation of wall 
-    // vibration.
+    // The alpha value and the wall components for the incorporation 
+    // of wall vibration (beta is calculated below for all sections).
     // **************************************************************
 
-    ts->alpha = 0.0;
-    ts->beta = 0.0;
+    wallAlpha[i] = 0.0;
+    ts->Lw = 0.0;
+    ts->Rw = 0.0;
 
   	if ((options.softWalls) && (i != Tube::LOWER_GLOTTIS_SECTION) && (i != Tube::UPPER_GLOTTIS_SECTION))
   	{
@@ -1005,13 +1431,10 @@ void TdsModel::prepareTimeStep()
       Rw = ts->Bw / surface;
       Lw = ts->Mw / surface;
       Cw = surface / ts->Kw;
+      ts->Rw = Rw;
+      ts->Lw = Lw;
 
-      ts->alpha = 1.0 / (Lw / (timeStep*timeStep*THETA*THETA) + Rw / (timeStep*THETA) + 1.0/Cw);
-      ts->beta = ts->alpha*(
-        ts->wallCurrent*(Lw/(timeStep*timeStep*THETA*THETA) + Rw/(timeStep*THETA)) +
-        ts->wallCurrentRate*(Lw*(THETA1/THETA + 1.0)/(timeStep*THETA) + Rw*(THETA1/THETA)) +
-        ts->wallCurrentRate2*Lw*(THETA1/THETA)
-        );
+      wallAlpha[i] = 1.0 / (Lw / (timeStep*timeStep*THETA*THETA) + Rw / (timeStep*THETA) + 1.0/Cw);
   	}
 
   }
@@ -1022,6 +1445,23 @@ void TdsModel::prepareTimeStep()
   // ****************************************************************
 
   doNetworkInitialization = false;  
+  staticSoftWalls = options.softWalls;
+
+  // ****************************************************************
+  // The beta values for the incorporation of wall vibration, which
+  // depend on the state of the walls (beta = 0 for alpha = 0).
+  // ****************************************************************
+
+  for (i=0; i < Tube::NUM_SECTIONS; i++)
+  {
+    Lw = tubeSection[i].Lw;
+    Rw = tubeSection[i].Rw;
+    wallBeta[i] = wallAlpha[i]*(
+      wallCurrent[i]*(Lw/(timeStep*timeStep*THETA*THETA) + Rw/(timeStep*THETA)) +
+      wallCurrentRate[i]*(Lw*(THETA1/THETA + 1.0)/(timeStep*THETA) + Rw*(THETA1/THETA)) +
+      wallCurrentRate2[i]*Lw*(THETA1/THETA)
+      );
+  }
 
   // ****************************************************************
   // If a wide tube section follows a narrow tube section,
@@ -1136,8 +1576,8 @@ void TdsModel::prepareTimeStep()
   {
     // The extra flow is calculated from the filtered pressures 
     // below and above the velum.
-    double p1 = tubeSection[Tube::FIRST_MOUTH_SECTION + 2].pressure;
-    double p2 = tubeSection[Tube::FIRST_NOSE_SECTION + 2].pressure;
+    double p1 = sectionPressure[Tube::FIRST_MOUTH_SECTION + 2];
+    double p2 = sectionPressure[Tube::FIRST_NOSE_SECTION + 2];
 
     transvelarCouplingFlow = transvelarCouplingFilter1.getOutputSample(p1) + transvelarCouplingFilter2.getOutputSample(p2);
   }
@@ -1146,28 +1586,24 @@ void TdsModel::prepareTimeStep()
   // Calculate D and E for each tube section.
   // ****************************************************************
 
-  double sourceAmp;
-
   for (i=0; i < Tube::NUM_SECTIONS; i++)
   {
-    ts = &tubeSection[i];
-
-    sourceAmp = ts->monopoleSource.sample;
+    sectionSourceAmp[i] = tubeSection[i].monopoleSource.sample;
+  }
 
-    if (i == Tube::FIRST_NOSE_SECTION + 2) 
-    { 
-      sourceAmp += transvelarCouplingFlow; 
-    }
+  sectionSourceAmp[Tube::FIRST_NOSE_SECTION + 2] += transvelarCouplingFlow; 
 
-    if (i == flowSourceSection) 
-    { 
-      sourceAmp += flowSourceAmp; 
-    }
+  if ((flowSourceSection >= 0) && (flowSourceSection < Tube::NUM_SECTIONS))
+  { 
+    sectionSourceAmp[flowSourceSection] += flowSourceAmp; 
+  }
 
-    d = timeStep*THETA / (ts->C + ts->alpha);
-    ts->E = d;
-    ts->D = ts->pressure + timeStep*THETA1*ts->pressureRate - 
-            d*(ts->beta - sourceAmp);
+  for (i=0; i < Tube::NUM_SECTIONS; i++)
+  {
+    d = timeStep*THETA / (tubeSection[i].C + wallAlpha[i]);
+    sectionE[i] = d;
+    sectionD[i] = sectionPressure[i] + timeStep*THETA1*sectionPressureRate[i] - 
+                  d*(wallBeta[i] - sectionSourceAmp[i]);
   }
 
 }
@@ -1196,18 +1632,19 @@ void TdsModel::resetConstriction(Constriction *c)
 
 // ****************************************************************************
 /// Calculate the positions and amplitudes of the noise sources.
+/// The constrictions and the place-dependent parameters of their sources
+/// only depend on the tube geometry. They are determined again by 
+/// findConstrictions() only when setTube() has changed the geometry, and
+/// only the flow-dependent amplitudes are calculated for every sample.
 // ****************************************************************************
 
 void TdsModel::calcNoiseSources()
 {
   const double MAX_CONSTRICTION_AREA = 1.0;   // 1.0 cm^2
-  const double MAX_DELTA_AREA = 0.2;          // 0.2 cm^2
-  const double MAX_TEETH_DISTANCE = 2.0;      // = 2 cm
 
   Constriction *cons = NULL;
   int i, k;
   TubeSection *ts = NULL;
-  NoiseSource *s = NULL;
 
   // ****************************************************************
   // Reset the target amplitude of all noise sources.
@@ -1220,31 +1657,257 @@ void TdsModel::calcNoiseSources()
   }
   lipsDipoleSource.targetAmp1kHz = 0.0;
 
-  // ****************************************************************
-  // The noise source right above the glottis is always there.
-  // ****************************************************************
-
-  numConstrictions = 1;
-  cons = &constriction[0];
-
-  resetConstriction(cons);
-  
-  cons->firstSection = Tube::LOWER_GLOTTIS_SECTION;
-  cons->lastSection = Tube::UPPER_GLOTTIS_SECTION;
-  // Always take the upper glottis section as the "narrowest" section
-  // to avoid flipping of the two sections all the time.
-  cons->narrowestSection = Tube::UPPER_GLOTTIS_SECTION;
-  cons->obstaclePos = 1.5;   // 1.5 cm above the glottis.
-  cons->articulator = Tube::VOCAL_FOLDS;
+  if (constrictionsValid == false)
+  {
+    findConstrictions();
+    constrictionsValid = true;
+  }
 
-  
   // ****************************************************************
-  // Determine the most constricted parts made with the tongue.
+  // Determine the parameters of the dipole noise source(s) for all
+  // individual constrictions.
+  // Always use two dipole sources: One at the upstream end of the
+  // tube section with the constriction, and one at the downstream 
+  // end. The amplitude of both sources is scaled in relation to the
+  // distances of both tube ends to the constriction location.
   // ****************************************************************
+  for (k=0; k < numConstrictions; k++)
+  {
+    cons = &constriction[k];
 
-  double minTongueAreaForTeethSource = 1000000.0;   // Extremely high area.
-  double minTongueArea = 1000000.0;   // Extremely high area.
-  int minTongueSection = -1;
+    // ************************************************************
+    // Determine and restrict the cross-sectional area of the 
+    // constriction.
+    // ************************************************************
+
+    ts = &tubeSection[cons->narrowestSection];
+    cons->area = ts->area;
+
+    if (cons->area < MIN_AREA_CM2)
+    {
+      cons->area = MIN_AREA_CM2;
+    }
+
+    // ************************************************************
+    // Determine the flow and particle velocity in the constriction.
+    // ************************************************************
+
+    cons->flow = 0.0;
+
+    if (ts->currentOut[0] != -1)
+    {
+      cons->flow += currentNoiseMagnitude[ts->currentOut[0]];
+    }
+    if (ts->currentOut[1] != -1)
+    {
+      cons->flow += currentNoiseMagnitude[ts->currentOut[1]];
+    }
+
+    // Generate noise sources only for outgoing flow.
+    // Otherwise we might get click artifacts.
+
+    if (cons->flow < 0.0)
+    {
+      cons->flow = 0.0;
+    }
+
+    cons->velocity = cons->flow / cons->area;
+    cons->gain = cons->baseGain;
+
+    // ************************************************************
+    // Smoothly reduce the gain to zero for areas between 0.5 cm^2 
+    // and 1.0 cm^2 in order to prevent a potential click artifact
+    // when the noise source is suddenly turned off at 1 cm^2.
+    // ************************************************************
+
+    const double TAPER_START_AREA = 0.5;   // cm^2
+    if (cons->area >= TAPER_START_AREA)
+    {
+      // d in [0, 1]
+      double d = (cons->area - TAPER_START_AREA) / (MAX_CONSTRICTION_AREA - TAPER_START_AREA);
+      cons->gain *= (1.0 - d);
+    }
+
+    // ************************************************************
+    // Also reduce the gain linearly down to zero when A_c becomes 
+    // smaller than 0.15 cm^2. This helps to prevent noise 
+    // artifacts during implosions (e.g. /t/ in /baUte/) and makes
+    // the noise amplitude of fricatives more uniform, e.g. at the
+    // borders of /sh/ in /asha/. On the other hand, it does not
+    // affect the release bust noise of plosives, because at the
+    // time of the burst, A_c is normally already >= 0.15 cm^2.
+    // ************************************************************
+
+    if (cons->area < 0.15)
+    {
+      // d in [0, 1]
+      double d = cons->area / 0.15;
+      cons->gain *= d;
+    }
+
+    // ************************************************************
+    // Calc. the level (RMS value) of the noise source.
+    // ************************************************************
+
+    cons->fullAmp = cons->gain*fabs(cons->velocity)*
+      cons->velocity*cons->velocity*sqrt(cons->area);   // Stevens' book
+
+    // **************************************************************
+    // Put the noise source in the tube section with the obstacle 
+    // (splitted in two sources).
+    // **************************************************************
+
+    if (cons->obstacleSection != -1)
+    {
+      // Set the parameters of the two noise sources.
+
+      NoiseSource *upstreamSource = NULL;
+      NoiseSource *downstreamSource = NULL;
+
+      if (cons->obstacleSection < Tube::LAST_MOUTH_SECTION)
+      {
+        upstreamSource = &tubeSection[cons->obstacleSection].dipoleSource;
+        downstreamSource = &tubeSection[cons->obstacleSection + 1].dipoleSource;
+      }
+      else
+      {
+        upstreamSource = &tubeSection[cons->obstacleSection].dipoleSource;
+        downstreamSource = &lipsDipoleSource;
+      }
+
+      // Factors between 0 and 1 for the contributions of the two sources.
+      double downstreamFactor = cons->downstreamFactor;
+      double upstreamFactor = 1.0 - downstreamFactor;
+
+      upstreamSource->targetAmp1kHz = upstreamFactor * cons->fullAmp;
+      upstreamSource->isFirstOrder = false;
+      upstreamSource->cutoffFreq = cons->cutoffFreq;
+
+      downstreamSource->targetAmp1kHz = downstreamFactor * cons->fullAmp;
+      downstreamSource->isFirstOrder = false;
+      downstreamSource->cutoffFreq = cons->cutoffFreq;
+    }
+  }
+
+
+  // ****************************************************************
+  // This is just for monitoring or debugging (only when the option
+  // monitorConstrictions is set).
+  // Find the constriction that is nearest to the 
+  // constrictionMonitorTubeSection, and add it to the constriction
+  // buffer (which can be saved to a text file later).
+  // ****************************************************************
+
+  if (options.monitorConstrictions)
+  {
+    const int TOLERANCE = 5;
+    int nearestConstriction = -1;
+    int minDistance = 1000000;
+    int middleSection = 0;
+    int distance = 0;
+  
+    for (k = 0; k < numConstrictions; k++)
+    {
+      cons = &constriction[k];
+      middleSection = (int)((cons->firstSection + cons->lastSection) / 2);
+      distance = abs(middleSection - constrictionMonitorTubeSection);
+      if ((distance < minDistance) &&
+        (constrictionMonitorTubeSection >= cons->firstSection - TOLERANCE) &&
+        (constrictionMonitorTubeSection <= cons->lastSection + TOLERANCE))
+      {
+        minDistance = distance;
+        nearestConstriction = k;
+      }
+    }
+
+    if (nearestConstriction != -1)
+    {
+      cons = &constriction[nearestConstriction];
+      constrictionBuffer[position & CONSTRICTION_BUFFER_SIZE_MASK] = *cons;
+    }
+    else
+    {
+      // Add an empty constriction to the buffer.
+      Constriction c;
+      resetConstriction(&c);
+      constrictionBuffer[position & CONSTRICTION_BUFFER_SIZE_MASK] = c;
+    }
+  }
+
+  // ****************************************************************
+  // Calculate the new noise samples at the positions of the sources.
+  // ****************************************************************
+
+  const double MIN_MONOPOLE_AMP = 0.001;          // cm^3/s
+  const double MIN_DIPOLE_AMP = 0.001;          // deci-Pascal
+
+  // Run through all tube sections.
+
+  for (i = Tube::FIRST_PHARYNX_SECTION; i <= Tube::LAST_MOUTH_SECTION; i++)
+  {
+    ts = &tubeSection[i];
+    calcNoiseSample(&ts->monopoleSource, MIN_MONOPOLE_AMP);
+    calcNoiseSample(&ts->dipoleSource, MIN_DIPOLE_AMP);
+  }
+  calcNoiseSample(&lipsDipoleSource, MIN_DIPOLE_AMP);
+
+  if (statisticsEnabled)
+  {
+    // Sources below the threshold are switched off by calcNoiseSample().
+    int numActive = (lipsDipoleSource.currentAmp1kHz > 0.0) ? 1 : 0;
+    for (i = Tube::FIRST_PHARYNX_SECTION; i <= Tube::LAST_MOUTH_SECTION; i++)
+    {
+      ts = &tubeSection[i];
+      if (ts->monopoleSource.currentAmp1kHz > 0.0) { numActive++; }
+      if (ts->dipoleSource.currentAmp1kHz > 0.0) { numActive++; }
+    }
+    statistics.numActiveNoiseSources += numActive;
+    if (numActive > statistics.maxActiveNoiseSources) { statistics.maxActiveNoiseSources = numActive; }
+    statistics.noiseSourceHistogram[getStatisticsBin(numActive)]++;
+  }
+}
+
+
+// ****************************************************************************
+/// Determines the constrictions of the current tube geometry, the cutoff 
+/// frequency and gain of their noise sources depending on the place of 
+/// articulation, and the tube sections of the sources.
+// ****************************************************************************
+
+void TdsModel::findConstrictions()
+{
+  const double MAX_CONSTRICTION_AREA = 1.0;   // 1.0 cm^2
+  const double MAX_DELTA_AREA = 0.2;          // 0.2 cm^2
+  const double MAX_TEETH_DISTANCE = 2.0;      // = 2 cm
+
+  Constriction *cons = NULL;
+  int i, k;
+
+  // ****************************************************************
+  // The noise source right above the glottis is always there.
+  // ****************************************************************
+
+  numConstrictions = 1;
+  cons = &constriction[0];
+
+  resetConstriction(cons);
+  
+  cons->firstSection = Tube::LOWER_GLOTTIS_SECTION;
+  cons->lastSection = Tube::UPPER_GLOTTIS_SECTION;
+  // Always take the upper glottis section as the "narrowest" section
+  // to avoid flipping of the two sections all the time.
+  cons->narrowestSection = Tube::UPPER_GLOTTIS_SECTION;
+  cons->obstaclePos = 1.5;   // 1.5 cm above the glottis.
+  cons->articulator = Tube::VOCAL_FOLDS;
+
+  
+  // ****************************************************************
+  // Determine the most constricted parts made with the tongue.
+  // ****************************************************************
+
+  double minTongueAreaForTeethSource = 1000000.0;   // Extremely high area.
+  double minTongueArea = 1000000.0;   // Extremely high area.
+  int minTongueSection = -1;
 
   for (i = Tube::FIRST_PHARYNX_SECTION; i <= Tube::LAST_MOUTH_SECTION; i++)
   {
@@ -1446,66 +2109,21 @@ void TdsModel::calcNoiseSources()
 
     
   // ****************************************************************
-  // Determine the parameters of the dipole noise source(s) for all
-  // individual constrictions.
-  // Always use two dipole sources: One at the upstream end of the
-  // tube section with the constriction, and one at the downstream 
-  // end. The amplitude of both sources is scaled in relation to the
-  // distances of both tube ends to the constriction location.
+  // Determine the place-dependent parameters of the noise sources
+  // of the constrictions.
   // ****************************************************************
 
   for (k=0; k < numConstrictions; k++)
   {
     cons = &constriction[k];
 
-    // ************************************************************
-    // Determine and restrict the cross-sectional area and
-    // the diameter of the constriction.
-    // ************************************************************
-
-    ts = &tubeSection[cons->narrowestSection];
-    cons->area = ts->area;
-
-    if (cons->area < MIN_AREA_CM2)
-    {
-      cons->area = MIN_AREA_CM2;
-    }
-
-    double diameter_cm = sqrt(4.0 * cons->area / M_PI);
-
-    // ************************************************************
-    // Determine the flow and particle velocity in the constriction.
-    // This may be needed for the calc. of the cutoff frequency.
-    // ************************************************************
-
-    cons->flow = 0.0;
-
-    if (ts->currentOut[0] != -1)
-    {
-      cons->flow += branchCurrent[ts->currentOut[0]].noiseMagnitude;
-    }
-    if (ts->currentOut[1] != -1)
-    {
-      cons->flow += branchCurrent[ts->currentOut[1]].noiseMagnitude;
-    }
-
-    // Generate noise sources only for outgoing flow.
-    // Otherwise we might get click artifacts.
-
-    if (cons->flow < 0.0)
-    {
-      cons->flow = 0.0;
-    }
-
-    cons->velocity = cons->flow / cons->area;
-
     // ************************************************************
     // Determine the cutoff frequency of the noise shaping filter
     // and the gain, depending on the place of articulation.
     // ************************************************************
 
     cons->cutoffFreq = 1000.0;    // Default value.
-    cons->gain = 0.0;
+    cons->baseGain = 0.0;
 
     if (cons->articulator == Tube::LOWER_LIP)
     {
@@ -1535,7 +2153,7 @@ void TdsModel::calcNoiseSources()
 
       if (d > 1.0) { d = 1.0; }
 
-      cons->gain = d * gain_f + (1.0 - d) * gain_p;
+      cons->baseGain = d * gain_f + (1.0 - d) * gain_p;
       cons->cutoffFreq = d * cutoffFreq_f + (1.0 - d) * cutoffFreq_p;
     }
     else
@@ -1543,7 +2161,7 @@ void TdsModel::calcNoiseSources()
     if (cons->articulator == Tube::VOCAL_FOLDS)
     {
       // The gain can vary by 40 dB for different degrees of aspiration.
-      cons->gain = 1.0e-6 * pow(10.0, aspirationStrength_dB / 20.0);
+      cons->baseGain = 1.0e-6 * pow(10.0, aspirationStrength_dB / 20.0);
 
       // According to Badin et al. (1994), the aspiration noise source
       // spectrum is essentially flat -> very high f_c.
@@ -1573,7 +2191,7 @@ void TdsModel::calcNoiseSources()
         if (d < 0.0) { d = 0.0; }   // d < 0 means lateral passages.
         if (d > 1.0) { d = 1.0; }
 
-        cons->gain = d * gain_fricatives + (1.0 - d) * gain_plosives;
+        cons->baseGain = d * gain_fricatives + (1.0 - d) * gain_plosives;
         cons->cutoffFreq = d * cutoffFreq_fricatives + (1.0 - d) * cutoffFreq_plosives;
 
         // Prevent a noise source for lateral passages.
@@ -1582,55 +2200,17 @@ void TdsModel::calcNoiseSources()
 
         if (tongueTipSideElevation < 0.0)
         {
-          cons->gain = 0.0;
+          cons->baseGain = 0.0;
         }
       }
       else
       // The case for a wall source for /x, k/.
       {
-        cons->gain = 0.4e-6;
+        cons->baseGain = 0.4e-6;
         cons->cutoffFreq = 800.0;
       }
     }
 
-    // ************************************************************
-    // Smoothly reduce the gain to zero for areas between 0.5 cm^2 
-    // and 1.0 cm^2 in order to prevent a potential click artifact
-    // when the noise source is suddenly turned off at 1 cm^2.
-    // ************************************************************
-
-    const double TAPER_START_AREA = 0.5;   // cm^2
-    if (cons->area >= TAPER_START_AREA)
-    {
-      // d in [0, 1]
-      double d = (cons->area - TAPER_START_AREA) / (MAX_CONSTRICTION_AREA - TAPER_START_AREA);
-      cons->gain *= (1.0 - d);
-    }
-
-    // ************************************************************
-    // Also reduce the gain linearly down to zero when A_c becomes 
-    // smaller than 0.15 cm^2. This helps to prevent noise 
-    // artifacts during implosions (e.g. /t/ in /baUte/) and makes
-    // the noise amplitude of fricatives more uniform, e.g. at the
-    // borders of /sh/ in /asha/. On the other hand, it does not
-    // affect the release bust noise of plosives, because at the
-    // time of the burst, A_c is normally already >= 0.15 cm^2.
-    // ************************************************************
-
-    if (cons->area < 0.15)
-    {
-      // d in [0, 1]
-      double d = cons->area / 0.15;
-      cons->gain *= d;
-    }
-
-    // ************************************************************
-    // Calc. the level (RMS value) of the noise source.
-    // ************************************************************
-
-    cons->fullAmp = cons->gain*fabs(cons->velocity)*
-      cons->velocity*cons->velocity*sqrt(cons->area);   // Stevens' book
-
     // Safety check for the cutoff frequency.
 
     if (cons->cutoffFreq > 10000.0)
@@ -1668,96 +2248,15 @@ void TdsModel::calcNoiseSources()
       }
     }
 
+    // Factors between 0 and 1 for the contributions of the two sources.
+
+    cons->downstreamFactor = 0.0;
     if (cons->obstacleSection != -1)
     {
-      // Set the parameters of the two noise sources.
-
-      NoiseSource *upstreamSource = NULL;
-      NoiseSource *downstreamSource = NULL;
-
-      if (cons->obstacleSection < Tube::LAST_MOUTH_SECTION)
-      {
-        upstreamSource = &tubeSection[cons->obstacleSection].dipoleSource;
-        downstreamSource = &tubeSection[cons->obstacleSection + 1].dipoleSource;
-      }
-      else
-      {
-        upstreamSource = &tubeSection[cons->obstacleSection].dipoleSource;
-        downstreamSource = &lipsDipoleSource;
-      }
-
-      // Factors between 0 and 1 for the contributions of the two sources.
-      double downstreamFactor = (cons->obstaclePos - tubeSection[cons->obstacleSection].pos) /
+      cons->downstreamFactor = (cons->obstaclePos - tubeSection[cons->obstacleSection].pos) /
         tubeSection[cons->obstacleSection].length;
-      double upstreamFactor = 1.0 - downstreamFactor;
-
-      upstreamSource->targetAmp1kHz = upstreamFactor * cons->fullAmp;
-      upstreamSource->isFirstOrder = false;
-      upstreamSource->cutoffFreq = cons->cutoffFreq;
-
-      downstreamSource->targetAmp1kHz = downstreamFactor * cons->fullAmp;
-      downstreamSource->isFirstOrder = false;
-      downstreamSource->cutoffFreq = cons->cutoffFreq;
     }
   }
-
-
-  // ****************************************************************
-  // This is just for monitoring or debugging.
-  // Find the constriction that is nearest to the 
-  // constrictionMonitorTubeSection, and add it to the constriction
-  // buffer (which can be saved to a text file later).
-  // ****************************************************************
-
-  const int TOLERANCE = 5;
-  int nearestConstriction = -1;
-  int minDistance = 1000000;
-  int middleSection = 0;
-  int distance = 0;
-  
-  for (k = 0; k < numConstrictions; k++)
-  {
-    cons = &constriction[k];
-    middleSection = (int)((cons->firstSection + cons->lastSection) / 2);
-    distance = abs(middleSection - constrictionMonitorTubeSection);
-    if ((distance < minDistance) &&
-      (constrictionMonitorTubeSection >= cons->firstSection - TOLERANCE) &&
-      (constrictionMonitorTubeSection <= cons->lastSection + TOLERANCE))
-    {
-      minDistance = distance;
-      nearestConstriction = k;
-    }
-  }
-
-  if (nearestConstriction != -1)
-  {
-    cons = &constriction[nearestConstriction];
-    constrictionBuffer[position & CONSTRICTION_BUFFER_SIZE_MASK] = *cons;
-  }
-  else
-  {
-    // Add an empty constriction to the buffer.
-    Constriction c;
-    resetConstriction(&c);
-    constrictionBuffer[position & CONSTRICTION_BUFFER_SIZE_MASK] = c;
-  }
-
-  // ****************************************************************
-  // Calculate the new noise samples at the positions of the sources.
-  // ****************************************************************
-
-  const double MIN_MONOPOLE_AMP = 0.001;          // cm^3/s
-  const double MIN_DIPOLE_AMP = 0.001;          // deci-Pascal
-
-  // Run through all tube sections.
-
-  for (i = Tube::FIRST_PHARYNX_SECTION; i <= Tube::LAST_MOUTH_SECTION; i++)
-  {
-    ts = &tubeSection[i];
-    calcNoiseSample(&ts->monopoleSource, MIN_MONOPOLE_AMP);
-    calcNoiseSample(&ts->dipoleSource, MIN_DIPOLE_AMP);
-  }
-  calcNoiseSample(&lipsDipoleSource, MIN_DIPOLE_AMP);
 }
 
 
@@ -1824,18 +2323,32 @@ void TdsModel::calcNoiseSample(NoiseSource *s, double ampThreshold)
   // The source is active.
   // ****************************************************************
   
-  // Setup the IIR-filter to get the filter coefficients.
-  IirFilter filter;
+  // Setup the IIR-filter to get the filter coefficients, when the 
+  // cutoff frequency or the order of the filter have changed.
 
-  if (s->isFirstOrder)
+  if ((s->cutoffFreq != s->filterCutoffFreq) || (s->isFirstOrder != s->filterIsFirstOrder))
   {
-    filter.createSinglePoleLowpass(s->cutoffFreq*timeStep);
-  }
-  else
-  {
-    // Always assume a critically damped 2nd order low-pass filter.
-    const double Q = 1.0 / sqrt(2.0);
-    filter.createSecondOrderLowpass(s->cutoffFreq * timeStep, Q);
+    IirFilter filter;
+
+    if (s->isFirstOrder)
+    {
+      filter.createSinglePoleLowpass(s->cutoffFreq*timeStep);
+    }
+    else
+    {
+      // Always assume a critically damped 2nd order low-pass filter.
+      const double Q = 1.0 / sqrt(2.0);
+      filter.createSecondOrderLowpass(s->cutoffFreq * timeStep, Q);
+    }
+
+    s->filterCutoffFreq = s->cutoffFreq;
+    s->filterIsFirstOrder = s->isFirstOrder;
+    s->filterOrder = filter.order;
+    for (int k = 0; k <= filter.order; k++)
+    {
+      s->filterA[k] = filter.a[k];
+      s->filterB[k] = filter.b[k];
+    }
   }
 
   // ****************************************************************
@@ -1872,12 +2385,12 @@ void TdsModel::calcNoiseSample(NoiseSource *s, double ampThreshold)
   while ((inputSample < -1.0) || (inputSample > 1.0));
   
   s->inputBuffer[position & NOISE_BUFFER_MASK] = inputSample;
-  double sum = filter.a[0] * inputSample;
+  double sum = s->filterA[0] * inputSample;
   int k;
-  for (k = 1; k <= filter.order; k++)
+  for (k = 1; k <= s->filterOrder; k++)
   {
-    sum += filter.a[k] * s->inputBuffer[(position - k) & NOISE_BUFFER_MASK];
-    sum += filter.b[k] * s->outputBuffer[(position - k) & NOISE_BUFFER_MASK];
+    sum += s->filterA[k] * s->inputBuffer[(position - k) & NOISE_BUFFER_MASK];
+    sum += s->filterB[k] * s->outputBuffer[(position - k) & NOISE_BUFFER_MASK];
   }
   s->outputBuffer[position & NOISE_BUFFER_MASK] = sum;
   s->sample = sum * filterGain;      // Resulting magnitude
@@ -1905,8 +2418,7 @@ double TdsModel::getSectionPressure(int sectionIndex)
     return 0.0;
   }
 
-  TubeSection *ts = &tubeSection[sectionIndex];
-  return ts->pressure;
+  return sectionPressure[sectionIndex];
 }
 
 
@@ -1999,6 +2511,19 @@ void TdsModel::calcMatrix()
       targetTs = NULL; 
     }
 
+    // The coefficients of the pressure eqs. of both sections
+    double sourceD = 0.0, sourceE = 0.0, targetD = 0.0, targetE = 0.0;
+    if (sourceTs != NULL) 
+    { 
+      sourceD = sectionD[bc->sourceSection]; 
+      sourceE = sectionE[bc->sourceSection]; 
+    }
+    if (targetTs != NULL) 
+    { 
+      targetD = sectionD[bc->targetSection]; 
+      targetE = sectionE[bc->targetSection]; 
+    }
+
     // **************************************************************
     // Both the source and the target section are INvalid.
     // **************************************************************
@@ -2030,10 +2555,10 @@ void TdsModel::calcMatrix()
       int resistanceCurrent  = sourceTs->currentOut[0];
       int inductivityCurrent = sourceTs->currentOut[1];
 
-      double uR = branchCurrent[resistanceCurrent].magnitude;
-      double uL = branchCurrent[inductivityCurrent].magnitude;
-      double uR_rate = branchCurrent[resistanceCurrent].magnitudeRate;
-      double uL_rate = branchCurrent[inductivityCurrent].magnitudeRate;
+      double uR = currentMagnitude[resistanceCurrent];
+      double uL = currentMagnitude[inductivityCurrent];
+      double uR_rate = currentMagnitudeRate[resistanceCurrent];
+      double uL_rate = currentMagnitudeRate[inductivityCurrent];
 
       double L_A = sourceTs->L;
       double R_A = sourceTs->R[1];
@@ -2077,13 +2602,13 @@ void TdsModel::calcMatrix()
       }
 
       // Inflowing currents
-      if (sourceTs->currentIn != -1) { matrix[i][sourceTs->currentIn] = sourceTs->E; }
+      if (sourceTs->currentIn != -1) { matrix[i][sourceTs->currentIn] = sourceE; }
         
       // Branch currents through the inductivity and the resistance
-      matrix[i][resistanceCurrent]  = -sourceTs->E - F;
-      matrix[i][inductivityCurrent] = -sourceTs->E - G;
+      matrix[i][resistanceCurrent]  = -sourceE - F;
+      matrix[i][inductivityCurrent] = -sourceE - G;
 
-      solutionVector[i] = H - sourceTs->D;
+      solutionVector[i] = H - sourceD;
     }
 
     else
@@ -2136,36 +2661,36 @@ void TdsModel::calcMatrix()
 
       if (branchingOffCurrent != -1)
       {
-        double uB      = bc->magnitude;
-        double uB_rate = bc->magnitudeRate;
+        double uB      = currentMagnitude[i];
+        double uB_rate = currentMagnitudeRate[i];
         double uD;
         double uD_rate;
 
-        uD      = branchCurrent[branchingOffCurrent].magnitude;
-        uD_rate = branchCurrent[branchingOffCurrent].magnitudeRate;
+        uD      = currentMagnitude[branchingOffCurrent];
+        uD_rate = currentMagnitudeRate[branchingOffCurrent];
 
         F = L_AB/(timeStep*THETA) + R_AB;
         G = L_A/(timeStep*THETA)  + R_A;
         H = - (1.0/(timeStep*THETA))*(L_AB*uB + L_A*uD)
             - (THETA1/THETA)*(L_AB*uB_rate + L_A*uD_rate) + S;
 
-        matrix[i][branchingOffCurrent] = -sourceTs->E - G;    // the parallel current.
+        matrix[i][branchingOffCurrent] = -sourceE - G;    // the parallel current.
 
         // In A inflowing currents
         if (sourceTs != NULL)
         {
-          if (sourceTs->currentIn != -1) { matrix[i][sourceTs->currentIn] = sourceTs->E; }
+          if (sourceTs->currentIn != -1) { matrix[i][sourceTs->currentIn] = sourceE; }
         }
 
         // This current
-        matrix[i][i] = -targetTs->E - sourceTs->E - F;
+        matrix[i][i] = -targetE - sourceE - F;
 
         // From B outflowing currents
-        if (targetTs->currentOut[0] != -1) { matrix[i][targetTs->currentOut[0]] = targetTs->E; }
-        if (targetTs->currentOut[1] != -1) { matrix[i][targetTs->currentOut[1]] = targetTs->E; }
+        if (targetTs->currentOut[0] != -1) { matrix[i][targetTs->currentOut[0]] = targetE; }
+        if (targetTs->currentOut[1] != -1) { matrix[i][targetTs->currentOut[1]] = targetE; }
 
         // Solution value
-        solutionVector[i] = H + targetTs->D - sourceTs->D;
+        solutionVector[i] = H + targetD - sourceD;
       }
       else
 
@@ -2174,8 +2699,8 @@ void TdsModel::calcMatrix()
       // ************************************************************
 
       {
-        double u      = bc->magnitude;
-        double u_rate = bc->magnitudeRate;
+        double u      = currentMagnitude[i];
+        double u_rate = currentMagnitudeRate[i];
 
         // Apply the "inner tube length correction" to the junction 
         // between these two sections in terms of an additional
@@ -2193,20 +2718,20 @@ void TdsModel::calcMatrix()
         // In A inflowing currents
         if (sourceTs != NULL)
         {
-          if (sourceTs->currentIn != -1) { matrix[i][sourceTs->currentIn] = sourceTs->E; }
+          if (sourceTs->currentIn != -1) { matrix[i][sourceTs->currentIn] = sourceE; }
         }
 
         // This current
-        matrix[i][i] = -targetTs->E - G;
-        if (sourceTs != NULL) { matrix[i][i]-= sourceTs->E; }
+        matrix[i][i] = -targetE - G;
+        if (sourceTs != NULL) { matrix[i][i]-= sourceE; }
 
         // From B outflowing currents
-        if (targetTs->currentOut[0] != -1) { matrix[i][targetTs->currentOut[0]] = targetTs->E; }
-        if (targetTs->currentOut[1] != -1) { matrix[i][targetTs->currentOut[1]] = targetTs->E; }
+        if (targetTs->currentOut[0] != -1) { matrix[i][targetTs->currentOut[0]] = targetE; }
+        if (targetTs->currentOut[1] != -1) { matrix[i][targetTs->currentOut[1]] = targetE; }
 
         // Solution value
-        solutionVector[i] = H + targetTs->D;
-        if (sourceTs != NULL) { solutionVector[i]-= sourceTs->D; }
+        solutionVector[i] = H + targetD;
+        if (sourceTs != NULL) { solutionVector[i]-= sourceD; }
       }
 
     }
@@ -2222,8 +2747,6 @@ void TdsModel::calcMatrix()
 void TdsModel::updateVariables()
 {
   int i;
-  TubeSection *ts = NULL;
-  BranchCurrent *bc = NULL;
 
   double oldPressure;
   double oldCurrent;
@@ -2238,37 +2761,41 @@ void TdsModel::updateVariables()
 
   for (i=0; i < NUM_BRANCH_CURRENTS; i++)
   {
-    bc = &branchCurrent[i];
-    oldCurrent = bc->magnitude;
-    oldCurrentRate = bc->magnitudeRate;
+    oldCurrent = currentMagnitude[i];
 
-    bc->magnitude = flowVector[i];
-    bc->magnitudeRate = (bc->magnitude - oldCurrent)/(timeStep*THETA) - (THETA1/THETA)*bc->magnitudeRate;
-    bc->noiseMagnitude = (1.0-noiseFilterCoeff)*bc->magnitude + noiseFilterCoeff*bc->noiseMagnitude;
+    currentMagnitude[i] = flowVector[i];
+    currentMagnitudeRate[i] = (currentMagnitude[i] - oldCurrent)/(timeStep*THETA) - (THETA1/THETA)*currentMagnitudeRate[i];
+    currentNoiseMagnitude[i] = (1.0-noiseFilterCoeff)*currentMagnitude[i] + noiseFilterCoeff*currentNoiseMagnitude[i];
   }
 
   // ****************************************************************
   // The new pressures and their derivatives
   // ****************************************************************
 
+  // The net flows into the sections are gathered first, so that the
+  // following loop only runs over contiguous arrays.
+
   for (i=0; i < Tube::NUM_SECTIONS; i++)
   {
-    ts = &tubeSection[i];
+    sectionNetFlow[i] = getCurrentIn(&tubeSection[i]) - getCurrentOut(&tubeSection[i]);
+  }
 
-    netFlow = getCurrentIn(ts) - getCurrentOut(ts);
+  for (i=0; i < Tube::NUM_SECTIONS; i++)
+  {
+    netFlow = sectionNetFlow[i];
 
-    oldPressure = ts->pressure;
-    ts->pressure = ts->D + ts->E*netFlow;
-    ts->pressureRate = (ts->pressure - oldPressure)/(timeStep*THETA) - ts->pressureRate*(THETA1/THETA);
+    oldPressure = sectionPressure[i];
+    sectionPressure[i] = sectionD[i] + sectionE[i]*netFlow;
+    sectionPressureRate[i] = (sectionPressure[i] - oldPressure)/(timeStep*THETA) - sectionPressureRate[i]*(THETA1/THETA);
 
     // The current "into the wall".
 
-    oldCurrent = ts->wallCurrent;
-    oldCurrentRate = ts->wallCurrentRate;
+    oldCurrent = wallCurrent[i];
+    oldCurrentRate = wallCurrentRate[i];
     
-    ts->wallCurrent = ts->pressureRate*ts->alpha + ts->beta;
-    ts->wallCurrentRate  = (ts->wallCurrent - oldCurrent)/(timeStep*THETA) - oldCurrentRate*(THETA1/THETA);
-    ts->wallCurrentRate2 = (ts->wallCurrentRate - oldCurrentRate)/(timeStep*THETA) - ts->wallCurrentRate2*(THETA1/THETA);
+    wallCurrent[i] = sectionPressureRate[i]*wallAlpha[i] + wallBeta[i];
+    wallCurrentRate[i]  = (wallCurrent[i] - oldCurrent)/(timeStep*THETA) - oldCurrentRate*(THETA1/THETA);
+    wallCurrentRate2[i] = (wallCurrentRate[i] - oldCurrentRate)/(timeStep*THETA) - wallCurrentRate2[i]*(THETA1/THETA);
   }
 
 }
@@ -2281,12 +2808,12 @@ void TdsModel::updateVariables()
 
 void TdsModel::solveEquationsSor(const string &matrixFileName)
 {
-  const int MAX_ITERATIONS = 100; // 100 is the original;
   const double EPSILON = 0.1;    // 0.01 = Original
 
-  // OMEGA=1 corresponds to the Gauss-Seidel-method; The Optimum for OMEGA
-  // with 1 <= OMEGA <= 2 must be determined experimetally
-  const double OMEGA = 1.25;   // Relaxation parameter
+  // OMEGA=1 corresponds to the Gauss-Seidel-method; with 1 <= OMEGA <= 2,
+  // the optimum is either fixed (SOR_INITIAL_OMEGA) or estimated online
+  // with adaptiveSor.
+  const double OMEGA = adaptiveSor ? sorOmega : SOR_INITIAL_OMEGA;
 
   int i, j, k;
   int iteration;
@@ -2294,6 +2821,7 @@ void TdsModel::solveEquationsSor(const string &matrixFileName)
   TubeSection *ts = NULL;
   double d;
   double residualNorm;      // The magnitude of the residuum squared
+  double firstResidualNorm = 0.0;
   bool isActive[NUM_BRANCH_CURRENTS];
 
   // ****************************************************************
@@ -2318,15 +2846,37 @@ void TdsModel::solveEquationsSor(const string &matrixFileName)
     }
   }
   
-  // The initial solution vector.
+  // ****************************************************************
+  // The initial solution vector. With adaptiveSor, the flows are 
+  // linearly extrapolated from the last two time steps (currentMagnitude
+  // still holds the flows of the last time step). The inactive currents
+  // are kept at zero.
+  // ****************************************************************
+
+  if ((adaptiveSor) && (numSorHistorySteps >= 2))
+  {
+    for (i=0; i < NUM_BRANCH_CURRENTS; i++) 
+    { 
+      flowVector[i] = isActive[i] ? 2.0*currentMagnitude[i] - prevCurrentMagnitude[i] : 0.0;
+    }
+  }
+  else
+  {
+    for (i=0; i < NUM_BRANCH_CURRENTS; i++) 
+    { 
+      flowVector[i] = 0.0; 
+    }
+  }
 
   for (i=0; i < NUM_BRANCH_CURRENTS; i++) 
   { 
-    flowVector[i] = 0.0; 
+    prevCurrentMagnitude[i] = currentMagnitude[i];
   }
+  if (numSorHistorySteps < 2) { numSorHistorySteps++; }
 
   // Perform a couple of iterations *********************************
   iteration = 0;
+  residualNorm = 0.0;
 
   do
   {
@@ -2353,14 +2903,71 @@ void TdsModel::solveEquationsSor(const string &matrixFileName)
       }
     }
 
+    if (iteration == 0) { firstResidualNorm = residualNorm; }
     iteration++;
   }
-  while ((iteration < MAX_ITERATIONS) && (residualNorm > EPSILON*EPSILON));
+  while ((iteration < sorMaxIterations) && (residualNorm > EPSILON*EPSILON));
+
+  // ****************************************************************
+  // Adapt the relaxation factor to the measured convergence rate: the
+  // mean log. reduction of the residuum per iteration is averaged over
+  // blocks of SOR_ADAPTATION_STEPS time steps, and the relaxation factor
+  // is moved by sorOmegaStep after each block. The direction is reversed
+  // (and the step halved) when the rate got worse than in the last block.
+  // The network matrix is not consistently ordered, so that the optimum 
+  // cannot be derived from the SOR theory for such matrices.
+  // ****************************************************************
+
+  if ((adaptiveSor) && (iteration >= 2) && (firstResidualNorm > 0.0) && (residualNorm > 0.0))
+  {
+    sorRateSum += 0.5*log(residualNorm / firstResidualNorm) / (double)(iteration - 1);
+    numSorRateSteps++;
+
+    if (numSorRateSteps >= SOR_ADAPTATION_STEPS)
+    {
+      double rate = sorRateSum / (double)numSorRateSteps;
+      if ((sorPrevRate < 0.0) && (rate > sorPrevRate))
+      {
+        sorOmegaStep = -0.5*sorOmegaStep;
+        if (fabs(sorOmegaStep) < SOR_MIN_OMEGA_STEP) 
+        { 
+          sorOmegaStep = (sorOmegaStep < 0.0) ? -SOR_MIN_OMEGA_STEP : SOR_MIN_OMEGA_STEP; 
+        }
+      }
+      sorPrevRate = rate;
+      sorRateSum = 0.0;
+      numSorRateSteps = 0;
+
+      sorOmega += sorOmegaStep;
+      if (sorOmega < SOR_MIN_OMEGA) { sorOmega = SOR_MIN_OMEGA; }
+      if (sorOmega > SOR_MAX_OMEGA) { sorOmega = SOR_MAX_OMEGA; }
+    }
+  }
 
 
   // For an external evaluation only.
  
   SORIterations = iteration;
+  SORResidualNorm = sqrt(residualNorm);
+
+  if (statisticsEnabled)
+  {
+    statistics.numSorTimeSteps++;
+    statistics.numSorIterations += iteration;
+    if (iteration > statistics.maxSorIterations) { statistics.maxSorIterations = iteration; }
+    statistics.sorIterationHistogram[getStatisticsBin(iteration)]++;
+
+    statistics.sumSorResidualNorm += SORResidualNorm;
+    if (SORResidualNorm > statistics.maxSorResidualNorm) { statistics.maxSorResidualNorm = SORResidualNorm; }
+    int bin = 0;
+    if (SORResidualNorm > 0.0)
+    {
+      bin = (int)floor(log10(SORResidualNorm)) + 12;
+      if (bin < 0) { bin = 0; }
+      if (bin > NUM_STATISTICS_BINS - 1) { bin = NUM_STATISTICS_BINS - 1; }
+    }
+    statistics.sorResidualHistogram[bin]++;
+  }
 
   // **************************************************************************
   // If matrixFileName != NULL, write the coefficient matrix, the solution vector,
@@ -2491,6 +3098,102 @@ void TdsModel::solveEquationsCholesky()
 }
 
 
+// ****************************************************************************
+/// Solve the linear system of equations using the Cholesky factorization
+/// in skyline storage, with the ordering and the profile determined in
+/// prepareSkylineFactorization(). The inner products of the factorization
+/// and the substitutions run over contiguous parts of the rows.
+// ****************************************************************************
+
+void TdsModel::solveEquationsSkyline()
+{
+  int i, j, k;
+  int first;
+  double sum;
+  double *L = skylineMatrix;
+
+  // ****************************************************************
+  // Gather the negated lower triangle of the renumbered matrix and
+  // the negated right-hand side.
+  // ****************************************************************
+
+  for (i = 0; i < NUM_BRANCH_CURRENTS; i++)
+  {
+    int row = skylineOrder[i];
+    int rowOffset = skylineRowOffset[i];
+
+    for (j = skylineFirstColumn[i]; j < i; j++)
+    {
+      int column = skylineOrder[j];
+      L[rowOffset + j] = (row > column) ? -matrix[row][column] : -matrix[column][row];
+    }
+    L[rowOffset + i] = -matrix[row][row];
+    skylineVector[i] = -solutionVector[row];
+  }
+
+  // ****************************************************************
+  // Cholesky factorization row by row
+  // ****************************************************************
+
+  for (i = 0; i < NUM_BRANCH_CURRENTS; i++)
+  {
+    int rowOffset = skylineRowOffset[i];
+    first = skylineFirstColumn[i];
+
+    for (j = first; j < i; j++)
+    {
+      int columnOffset = skylineRowOffset[j];
+      sum = L[rowOffset + j];
+      for (k = max(first, skylineFirstColumn[j]); k < j; k++)
+      {
+        sum -= L[rowOffset + k] * L[columnOffset + k];
+      }
+      L[rowOffset + j] = sum * skylineInverseDiagonal[j];
+    }
+
+    sum = L[rowOffset + i];
+    for (k = first; k < i; k++)
+    {
+      sum -= L[rowOffset + k] * L[rowOffset + k];
+    }
+
+    if (sum < 0) printf("Error: Cholesky factorization: Matrix is not positive definite!\n");
+    L[rowOffset + i] = sqrt(sum);
+    skylineInverseDiagonal[i] = 1.0 / L[rowOffset + i];
+  }
+
+  // ****************************************************************
+  // forward substitution
+  // ****************************************************************
+
+  for (i = 0; i < NUM_BRANCH_CURRENTS; i++)
+  {
+    int rowOffset = skylineRowOffset[i];
+    sum = skylineVector[i];
+    for (k = skylineFirstColumn[i]; k < i; k++)
+    {
+      sum -= L[rowOffset + k] * skylineVector[k];
+    }
+    skylineVector[i] = sum * skylineInverseDiagonal[i];
+  }
+
+  // ****************************************************************
+  // backward substitution (column by column of the transposed factor)
+  // ****************************************************************
+
+  for (i = NUM_BRANCH_CURRENTS - 1; i >= 0; --i)
+  {
+    int rowOffset = skylineRowOffset[i];
+    double x = skylineVector[i] * skylineInverseDiagonal[i];
+    for (k = skylineFirstColumn[i]; k < i; k++)
+    {
+      skylineVector[k] -= L[rowOffset + k] * x;
+    }
+    flowVector[skylineOrder[i]] = x;
+  }
+}
+
+
 // ****************************************************************************
 /// Returns the volume velocity into the given tube section.
 /// \param section The tube section
@@ -2504,7 +3207,7 @@ double TdsModel::getCurrentIn(const int section)
     TubeSection *ts = &tubeSection[section];
     if (ts->currentIn != -1) 
     { 
-      flow+= branchCurrent[ts->currentIn].magnitude; 
+      flow+= currentMagnitude[ts->currentIn]; 
     }
   }
   return flow;
@@ -2521,8 +3224,8 @@ double TdsModel::getCurrentOut(const int section)
   if ((section >= 0) && (section < Tube::NUM_SECTIONS))
   {
     TubeSection *ts = &tubeSection[section];
-    if (ts->currentOut[0] != -1) { flow+= branchCurrent[ts->currentOut[0]].magnitude; }
-    if (ts->currentOut[1] != -1) { flow+= branchCurrent[ts->currentOut[1]].magnitude; }
+    if (ts->currentOut[0] != -1) { flow+= currentMagnitude[ts->currentOut[0]]; }
+    if (ts->currentOut[1] != -1) { flow+= currentMagnitude[ts->currentOut[1]]; }
   }
   return flow;
 }
@@ -2539,7 +3242,7 @@ double TdsModel::getCurrentIn(const TubeSection *ts)
   {
     if (ts->currentIn != -1) 
     { 
-      flow+= branchCurrent[ts->currentIn].magnitude; 
+      flow+= currentMagnitude[ts->currentIn]; 
     }
   }
   return flow;
@@ -2555,8 +3258,8 @@ double TdsModel::getCurrentOut(const TubeSection *ts)
   double flow = 0.0;
   if (ts != NULL)
   {
-    if (ts->currentOut[0] != -1) { flow+= branchCurrent[ts->currentOut[0]].magnitude; }
-    if (ts->currentOut[1] != -1) { flow+= branchCurrent[ts->currentOut[1]].magnitude; }
+    if (ts->currentOut[0] != -1) { flow+= currentMagnitude[ts->currentOut[0]]; }
+    if (ts->currentOut[1] != -1) { flow+= currentMagnitude[ts->currentOut[1]]; }
   }
   return flow;
 }
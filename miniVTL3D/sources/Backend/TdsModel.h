@@ -25,6 +25,7 @@
 #include <cmath>
 #include <string>
 #include <random>
+#include <chrono>
 
 #include "Dsp.h"
 #include "Geometry.h"
@@ -43,6 +44,9 @@
 
 class TdsModel
 {
+  // Advances several models in lockstep with a shared solver
+  friend class TdsModelBatch;
+
 public:
 
   // ************************************************************************
@@ -57,6 +61,7 @@ public:
   static const int MAX_CONSTRICTIONS = 4;
   static const int CONSTRICTION_BUFFER_SIZE = 65536;    // For more than 1 s
   static const int CONSTRICTION_BUFFER_SIZE_MASK = 65535;
+  static const int NUM_STATISTICS_BINS = 16;
 
   static const int NUM_NOISE_BUFFER_SAMPLES = 8;
   static const int NOISE_BUFFER_MASK = 7;
@@ -66,6 +71,9 @@ public:
   // Max. number of non-zero places per	column in the matrix when it is saved in symmetric envelope structure (for cholesky factorization)
   static const int MAX_CONCERNED_MATRIX_ROWS_SYMMETRIC_ENVELOPE = 10;
 
+  // Max. number of elements of the lower triangle of the matrix in skyline storage
+  static const int MAX_SKYLINE_ELEMENTS = NUM_BRANCH_CURRENTS*(NUM_BRANCH_CURRENTS + 1) / 2;
+
   // Max. number of non-zero places per row in the symmetric saved matrix
   static const int MAX_CONCERNED_MATRIX_COLUMNS_SYMMETRIC = 3;
   // Max. number of non-zero places per	column the symmetric saved matrix
@@ -78,6 +86,14 @@ public:
   static const double MIN_AREA_CM2;
   static const double NOISE_CUTOFF_FREQ;
 
+  // Relaxation factors of the SOR method
+  static const double SOR_INITIAL_OMEGA;
+  static const double SOR_MIN_OMEGA;
+  static const double SOR_MAX_OMEGA;
+  static const double SOR_INITIAL_OMEGA_STEP;
+  static const double SOR_MIN_OMEGA_STEP;
+  static const int SOR_ADAPTATION_STEPS = 256;
+
 
   // ************************************************************************
   /// Some options
@@ -87,6 +103,7 @@ public:
   {
     SOR_GAUSS_SEIDEL,
     CHOLESKY_FACTORIZATION,
+    SKYLINE_CHOLESKY_FACTORIZATION,
     NUM_SOLVER_TYPES
   };
 
@@ -99,6 +116,7 @@ public:
     bool piriformFossa;           ///< Include the piriform fossa
     bool innerLengthCorrections;  ///< Additional inductivities between adjacent sections
     bool transvelarCoupling;      ///< Sound transmission through the velum tissue?
+    bool monitorConstrictions;    ///< Write the monitored constriction into the constriction buffer
     SolverType solverType;
   };
 
@@ -116,6 +134,13 @@ public:
     double inputBuffer[NUM_NOISE_BUFFER_SAMPLES];
     double outputBuffer[NUM_NOISE_BUFFER_SAMPLES];
     double sample;        ///< The current sampling point of the noise source
+    // Coefficients of the spectral shaping filter, which are only
+    // calculated again when the cutoff frequency or the order change
+    double filterCutoffFreq = -1.0;
+    bool filterIsFirstOrder = false;
+    int filterOrder = 0;
+    double filterA[3] = { 0.0, 0.0, 0.0 };
+    double filterB[3] = { 0.0, 0.0, 0.0 };
   };
 
   // ************************************************************************
@@ -134,30 +159,78 @@ public:
     double velocity;      // in cm / s
     double cutoffFreq;   // in Hz
     double gain;
+    double baseGain;      // Gain before the tapering with the area
     double fullAmp;
+    double downstreamFactor;  // Contribution of the downstream source
     Tube::Articulator articulator;
   };
 
+  // ************************************************************************
+  /// Counters of the simulation to compare the solvers on a workload. They
+  /// are accumulated over the time steps while they are enabled with 
+  /// setStatisticsEnabled(). The histograms with NUM_STATISTICS_BINS bins
+  /// count the time steps with 0 in bin 0 and with 2^(k-1) <= n < 2^k in 
+  /// bin k (the last bin takes all greater values).
+  // ************************************************************************
+
+  struct Statistics
+  {
+    long long numTimeSteps;
+    /// \name Time spent in the phases of proceedTimeStep() in seconds
+    /// @{
+    double prepareTime_s;
+    double matrixTime_s;
+    double solveTime_s;
+    double updateTime_s;
+    /// @}
+    /// \name Time steps solved with SOR
+    /// @{
+    long long numSorTimeSteps;
+    long long numSorIterations;
+    int maxSorIterations;
+    double sumSorResidualNorm;  ///< Norm of the residuum of the last iteration
+    double maxSorResidualNorm;
+    long long sorIterationHistogram[NUM_STATISTICS_BINS];
+    /// Bin k counts 10^(k-12) <= residual norm < 10^(k-11) (including the 
+    /// values out of range in the first and last bin)
+    long long sorResidualHistogram[NUM_STATISTICS_BINS];
+    /// @}
+    /// \name Stored elements of the lower triangle of the matrix (including
+    /// the main diagonal) in the symmetric envelope of the Cholesky 
+    /// factorization and in the skyline storage
+    /// @{
+    int envelopeSize;
+    int skylineSize;
+    /// @}
+    /// \name Constrictions and active noise sources of the time steps 
+    /// @{
+    long long numConstrictions;
+    long long constrictionHistogram[MAX_CONSTRICTIONS + 1];
+    long long numActiveNoiseSources;
+    int maxActiveNoiseSources;
+    long long noiseSourceHistogram[NUM_STATISTICS_BINS];
+    /// @}
+  };
+
 
   // ************************************************************************
   /// Structure for one individual branch current in the electrical
   /// network. The identity of a branch current is defined by the
   /// indices of the tube sections from where it comes and where
-  /// it goes.
+  /// it goes. The magnitudes of the currents are kept in the arrays
+  /// currentMagnitude etc. of the class.
   // ************************************************************************
 
   struct BranchCurrent
   {
     int sourceSection;
     int targetSection;
-
-    double magnitude;
-    double magnitudeRate;
-    double noiseMagnitude;    ///< The flow low-pass filtered at 1000 Hz
   };
 
   // ************************************************************************
-  /// An individual short homogeneous tube section.
+  /// An individual short homogeneous tube section. The pressure, the wall
+  /// currents and the coefficients of the time integration are kept in 
+  /// the arrays sectionPressure etc. of the class.
   // ************************************************************************
 
   struct TubeSection
@@ -173,9 +246,6 @@ public:
     NoiseSource monopoleSource; ///< Is created in the center of the tube section
     NoiseSource dipoleSource;   ///< Is created at the entrance of the tube section
 
-    double pressure;
-    double pressureRate;
-
     /// \name Indices of the inflowing and outflowing currents
     /// @{
     int currentIn;
@@ -189,25 +259,25 @@ public:
     double Kw;    ///< Stiffness per unit-area
     /// @}
 
-    /// \name Wall currents
-    /// @{
-    double wallCurrent;       ///< Current flow "into" the walls
-    double wallCurrentRate;   ///< 1st derivative of the wall-flow
-    double wallCurrentRate2;  ///< 2nd derivative of the wall-flow
-    /// @}
-
     double L;        ///< Inductivity
     double C;        ///< Capacity
     double R[2];     ///< Ohm's resistance left and right
     double S;        ///< Pressure source at the inlet of the section (A constant in the pressure-difference eq.)
 
-    // For the wall vibration
-    double alpha;
-    double beta;
-
-    // Temporary values
-    double D;
-    double E;
+    /// \name Components that only depend on the geometry and the wall 
+    /// properties, and the values they were calculated for. They are only
+    /// recalculated in prepareTimeStep() when these values change.
+    /// @{
+    double staticArea;
+    double staticLength;
+    double staticVolume;
+    double staticMw;
+    double staticBw;
+    double staticKw;
+    double staticR;  ///< Viscous resistance
+    double Lw;       ///< Wall inductivity
+    double Rw;       ///< Wall resistance
+    /// @}
   };
 
   // ************************************************************************
@@ -224,6 +294,27 @@ public:
   TubeSection tubeSection[Tube::NUM_SECTIONS];
   BranchCurrent branchCurrent[NUM_BRANCH_CURRENTS];
 
+  /// \name State of the branch currents, stored as structure of arrays so
+  /// that the state integration in updateVariables() can be vectorized.
+  /// @{
+  double currentMagnitude[NUM_BRANCH_CURRENTS];
+  double currentMagnitudeRate[NUM_BRANCH_CURRENTS];
+  double currentNoiseMagnitude[NUM_BRANCH_CURRENTS];   ///< The flow low-pass filtered at NOISE_CUTOFF_FREQ
+  /// @}
+
+  /// \name State of the tube sections (structure of arrays)
+  /// @{
+  double sectionPressure[Tube::NUM_SECTIONS];
+  double sectionPressureRate[Tube::NUM_SECTIONS];
+  double wallCurrent[Tube::NUM_SECTIONS];       ///< Current flow "into" the walls
+  double wallCurrentRate[Tube::NUM_SECTIONS];   ///< 1st derivative of the wall-flow
+  double wallCurrentRate2[Tube::NUM_SECTIONS];  ///< 2nd derivative of the wall-flow
+  double wallAlpha[Tube::NUM_SECTIONS];         ///< For the wall vibration
+  double wallBeta[Tube::NUM_SECTIONS];
+  double sectionD[Tube::NUM_SECTIONS];          ///< Temporary values of the pressure eq.
+  double sectionE[Tube::NUM_SECTIONS];
+  /// @}
+
   // Help variables to effectively solve the system of eqs. with Gauss-Seidel
   int numFilledRowValues[NUM_BRANCH_CURRENTS];
   int filledRowIndex[NUM_BRANCH_CURRENTS][MAX_CONCERNED_MATRIX_COLUMNS];
@@ -234,7 +325,22 @@ public:
   int numFilledColumnValuesSymmetricEnvelope[NUM_BRANCH_CURRENTS];
   int filledColumnIndexSymmetricEnvelope[NUM_BRANCH_CURRENTS][MAX_CONCERNED_MATRIX_ROWS_SYMMETRIC_ENVELOPE];
 
+  // Help variables to solve the system of eqs. with the cholesky factorization
+  // in skyline storage. The unknowns are renumbered once in initModel() by the
+  // reverse Cuthill-McKee ordering to reduce the profile of the matrix, and
+  // the rows of the lower triangle are stored contiguously from their first 
+  // non-zero column to the main diagonal.
+  int skylineOrder[NUM_BRANCH_CURRENTS];        ///< Branch current of each renumbered unknown
+  int skylineFirstColumn[NUM_BRANCH_CURRENTS];  ///< First column of the profile of each row
+  int skylineRowOffset[NUM_BRANCH_CURRENTS];    ///< Index in skylineMatrix of the element (i, 0)
+  int numSkylineElements;
+  double skylineMatrix[MAX_SKYLINE_ELEMENTS];
+  double skylineVector[NUM_BRANCH_CURRENTS];
+  double skylineInverseDiagonal[NUM_BRANCH_CURRENTS];
+
   bool doNetworkInitialization;
+  /// Value of options.softWalls for the static components of the sections
+  bool staticSoftWalls;
   double timeStep;
   /// Aspiration strength from -40 dB to 0 dB.
   double aspirationStrength_dB;
@@ -245,6 +351,16 @@ public:
   double flowVector[NUM_BRANCH_CURRENTS];
 
   int SORIterations;      ///< For external evaluation of the iterations needed to solve the system of eqs.
+  double SORResidualNorm; ///< Norm of the residuum after the last iteration
+
+  /// \name Parameters of solveEquationsSor()
+  /// @{
+  int sorMaxIterations;   ///< Budget of iterations per time step (e.g., for real-time use)
+  /// Estimate the relaxation factor from the convergence rate and start the
+  /// iterations from the flows extrapolated from the last two time steps
+  bool adaptiveSor;
+  double sorOmega;        ///< Current relaxation factor (1 <= OMEGA < 2)
+  /// @}
 
   IirFilter glottalToneFilter;
   IirFilter transglottalPressureFilter;
@@ -255,12 +371,34 @@ public:
 
   Constriction constriction[MAX_CONSTRICTIONS];
   int numConstrictions;
+  /// False when the tube geometry has changed since the constrictions
+  /// were determined
+  bool constrictionsValid;
+  /// True when the areas of the pharynx and mouth sections reached the 
+  /// areas of the tube in the last call of setTube(), despite the filtering
+  bool tubeAreasSettled;
   
   // The constriction that is nearest to this tube section will be
   // monitored (constriction data are written to the buffer).
   int constrictionMonitorTubeSection;
   Constriction *constrictionBuffer;
 
+  bool statisticsEnabled;
+  Statistics statistics;
+
+  /// Branch currents of the time step before the last one for the initial
+  /// guess of the adaptive SOR, and the number of time steps since 
+  /// resetMotion() (up to 2) that it can be extrapolated from
+  double prevCurrentMagnitude[NUM_BRANCH_CURRENTS];
+  int numSorHistorySteps;
+  /// \name Adaptation of the relaxation factor of the SOR method
+  /// @{
+  double sorOmegaStep;      ///< Change of sorOmega after the current block
+  double sorRateSum;        ///< Sum of the log. convergence rates of the block
+  double sorPrevRate;       ///< Mean log. convergence rate of the last block (0 = none)
+  int numSorRateSteps;
+  /// @}
+
   Options options;
 
 
@@ -280,7 +418,7 @@ public:
   /// \name These functions should be called for each time step
   // **************************************************************
   /// @{
-  void setTube(Tube *tube, bool filtering = false);
+  void setTube(Tube *tube, bool filtering = false, bool onlyGlottisChanged = false);
   void getTube(Tube *tube);
   void setFlowSource(double flow_cm3_s, int section);
   void setPressureSource(double pressure_dPa, int section = Tube::FIRST_TRACHEA_SECTION);
@@ -292,6 +430,7 @@ public:
 
   void solveEquationsSor(const string &matrixFileName = "");
   void solveEquationsCholesky();
+  void solveEquationsSkyline();
   int getSampleIndex() { return position; }
   void getSectionFlow(int sectionIndex, double &inflow, double &outflow);
   double getSectionPressure(int sectionIndex);
@@ -299,6 +438,17 @@ public:
   void calcNoiseSample(NoiseSource* s, double ampThreshold);
   void incrementPosition() { position++; }
 
+  // **************************************************************
+  /// \name Counters of the simulation (disabled by default)
+  // **************************************************************
+  /// @{
+  void setStatisticsEnabled(bool enabled) { statisticsEnabled = enabled; }
+  bool isStatisticsEnabled() { return statisticsEnabled; }
+  void resetStatistics();
+  Statistics getStatistics();
+  bool writeStatistics(const string &fileName);
+  /// @}
+
   // ************************************************************************
   // Private data.
   // ************************************************************************
@@ -310,6 +460,10 @@ private:
   double tongueTipSideElevation;
   std::mt19937 randomNumberGenerator;
 
+  // Work arrays of prepareTimeStep() and updateVariables()
+  double sectionSourceAmp[Tube::NUM_SECTIONS];
+  double sectionNetFlow[Tube::NUM_SECTIONS];
+
   // ************************************************************************
   // Private functions.
   // ************************************************************************
@@ -320,10 +474,15 @@ private:
   double getJunctionInductance(double A1_cm2, double A2_cm2);
 
   void calcMatrix();
+  void prepareSkylineFactorization();
   void updateVariables();
+  double getRadiatedFlow(double &mouthFlow_cm3_s, double &nostrilFlow_cm3_s,
+    double &skinFlow_cm3_s);
   
   void resetConstriction(Constriction *c);
   void calcNoiseSources();
+  void findConstrictions();
+  static int getStatisticsBin(int n);
 
   double getCurrentIn(const int section);
   double getCurrentOut(const int section);
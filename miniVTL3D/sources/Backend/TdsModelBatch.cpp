@@ -0,0 +1,247 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#include "TdsModelBatch.h"
+#include "ParallelLoop.h"
+#include <algorithm>
+#include <memory>
+#include <cstdio>
+
+
+// ****************************************************************************
+/// Constructor. Creates and initializes the models of the voices.
+// ****************************************************************************
+
+TdsModelBatch::TdsModelBatch(int numVoices)
+{
+  for (int i = 0; i < numVoices; i++)
+  {
+    voice.push_back(new TdsModel());
+  }
+}
+
+
+// ****************************************************************************
+/// Destructor.
+// ****************************************************************************
+
+TdsModelBatch::~TdsModelBatch()
+{
+  for (int i = 0; i < (int)voice.size(); i++)
+  {
+    delete voice[i];
+  }
+}
+
+
+// ****************************************************************************
+/// Resets the motion of all voices.
+// ****************************************************************************
+
+void TdsModelBatch::resetMotion()
+{
+  for (int i = 0; i < (int)voice.size(); i++)
+  {
+    voice[i]->resetMotion();
+  }
+}
+
+
+// ****************************************************************************
+/// Advances all voices by numSteps time steps. Each group of LANE_WIDTH
+/// voices runs the whole block of steps on one thread, so that the threads
+/// only synchronize at the end of the block.
+// ****************************************************************************
+
+void TdsModelBatch::proceedTimeSteps(int numSteps, const InputCallback &setInputs,
+  double *radiatedFlow, int numThreads)
+{
+  int numVoices = (int)voice.size();
+  int numGroups = (numVoices + LANE_WIDTH - 1) / LANE_WIDTH;
+
+  parallelLoop(numGroups, numThreads, [&](int g)
+    {
+      int first = g * LANE_WIDTH;
+      proceedGroup(first, min(LANE_WIDTH, numVoices - first), numSteps,
+        setInputs, radiatedFlow);
+    });
+}
+
+
+// ****************************************************************************
+/// Advances the voices firstVoice ... firstVoice + numVoices - 1 in
+/// lockstep.
+// ****************************************************************************
+
+void TdsModelBatch::proceedGroup(int firstVoice, int numVoices, int numSteps,
+  const InputCallback &setInputs, double *radiatedFlow)
+{
+  unique_ptr<LaneWorkspace> ws(new LaneWorkspace);
+  double mouthFlow_cm3_s, nostrilFlow_cm3_s, skinFlow_cm3_s;
+  int v, k;
+
+  for (k = 0; k < numSteps; k++)
+  {
+    for (v = firstVoice; v < firstVoice + numVoices; v++)
+    {
+      setInputs(v, voice[v]);
+      voice[v]->prepareTimeStep();
+      voice[v]->calcMatrix();
+    }
+
+    solveEquationsSkyline(firstVoice, numVoices, *ws);
+
+    for (v = firstVoice; v < firstVoice + numVoices; v++)
+    {
+      TdsModel *model = voice[v];
+      model->updateVariables();
+      if (model->statisticsEnabled) { model->statistics.numTimeSteps++; }
+      radiatedFlow[(long long)v * numSteps + k] =
+        model->getRadiatedFlow(mouthFlow_cm3_s, nostrilFlow_cm3_s, skinFlow_cm3_s);
+    }
+  }
+}
+
+
+// ****************************************************************************
+/// Solves the systems of equations of the voices firstVoice ... firstVoice +
+/// numVoices - 1 as TdsModel::solveEquationsSkyline() does, with the
+/// ordering and profile of the first voice. Element e of the voice l is
+/// stored at e*LANE_WIDTH + l. The unused lanes get the identity matrix,
+/// so that all the lanes can be processed by the same loops.
+// ****************************************************************************
+
+void TdsModelBatch::solveEquationsSkyline(int firstVoice, int numVoices,
+  LaneWorkspace &ws)
+{
+  const int N = TdsModel::NUM_BRANCH_CURRENTS;
+  const int W = LANE_WIDTH;
+  const TdsModel *pattern = voice[firstVoice];
+  const int *order = pattern->skylineOrder;
+  const int *firstColumn = pattern->skylineFirstColumn;
+  const int *rowOffset = pattern->skylineRowOffset;
+  double *L = ws.matrix;
+  double *b = ws.vector;
+  double *invDiag = ws.inverseDiagonal;
+  double sum[W];
+  int i, j, k, l;
+
+  // ****************************************************************
+  // Gather the negated lower triangles of the renumbered matrices and
+  // the negated right-hand sides.
+  // ****************************************************************
+
+  for (l = 0; l < W; l++)
+  {
+    if (l >= numVoices)
+    {
+      for (i = 0; i < N; i++)
+      {
+        for (j = firstColumn[i]; j < i; j++) { L[(rowOffset[i] + j)*W + l] = 0.0; }
+        L[(rowOffset[i] + i)*W + l] = 1.0;
+        b[i*W + l] = 0.0;
+      }
+      continue;
+    }
+
+    const TdsModel *model = voice[firstVoice + l];
+    for (i = 0; i < N; i++)
+    {
+      int row = order[i];
+      for (j = firstColumn[i]; j < i; j++)
+      {
+        int column = order[j];
+        L[(rowOffset[i] + j)*W + l] = (row > column) ?
+          -model->matrix[row][column] : -model->matrix[column][row];
+      }
+      L[(rowOffset[i] + i)*W + l] = -model->matrix[row][row];
+      b[i*W + l] = -model->solutionVector[row];
+    }
+  }
+
+  // ****************************************************************
+  // Cholesky factorization row by row
+  // ****************************************************************
+
+  for (i = 0; i < N; i++)
+  {
+    int ri = rowOffset[i]*W;
+    int first = firstColumn[i];
+
+    for (j = first; j < i; j++)
+    {
+      int rj = rowOffset[j]*W;
+      for (l = 0; l < W; l++) { sum[l] = L[ri + j*W + l]; }
+      for (k = max(first, firstColumn[j]); k < j; k++)
+      {
+        for (l = 0; l < W; l++) { sum[l] -= L[ri + k*W + l] * L[rj + k*W + l]; }
+      }
+      for (l = 0; l < W; l++) { L[ri + j*W + l] = sum[l] * invDiag[j*W + l]; }
+    }
+
+    for (l = 0; l < W; l++) { sum[l] = L[ri + i*W + l]; }
+    for (k = first; k < i; k++)
+    {
+      for (l = 0; l < W; l++) { sum[l] -= L[ri + k*W + l] * L[ri + k*W + l]; }
+    }
+
+    for (l = 0; l < W; l++)
+    {
+      if (sum[l] < 0) { printf("Error: Cholesky factorization: Matrix is not positive definite!\n"); }
+      L[ri + i*W + l] = sqrt(sum[l]);
+      invDiag[i*W + l] = 1.0 / L[ri + i*W + l];
+    }
+  }
+
+  // ****************************************************************
+  // forward substitution
+  // ****************************************************************
+
+  for (i = 0; i < N; i++)
+  {
+    int ri = rowOffset[i]*W;
+    for (l = 0; l < W; l++) { sum[l] = b[i*W + l]; }
+    for (k = firstColumn[i]; k < i; k++)
+    {
+      for (l = 0; l < W; l++) { sum[l] -= L[ri + k*W + l] * b[k*W + l]; }
+    }
+    for (l = 0; l < W; l++) { b[i*W + l] = sum[l] * invDiag[i*W + l]; }
+  }
+
+  // ****************************************************************
+  // backward substitution (column by column of the transposed factor)
+  // and scattering of the flows
+  // ****************************************************************
+
+  for (i = N - 1; i >= 0; --i)
+  {
+    int ri = rowOffset[i]*W;
+    for (l = 0; l < W; l++) { sum[l] = b[i*W + l] * invDiag[i*W + l]; }
+    for (k = firstColumn[i]; k < i; k++)
+    {
+      for (l = 0; l < W; l++) { b[k*W + l] -= L[ri + k*W + l] * sum[l]; }
+    }
+    for (l = 0; l < numVoices; l++)
+    {
+      voice[firstVoice + l]->flowVector[order[i]] = sum[l];
+    }
+  }
+}
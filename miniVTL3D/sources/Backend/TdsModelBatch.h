@@ -0,0 +1,87 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#ifndef __TDS_MODEL_BATCH_H__
+#define __TDS_MODEL_BATCH_H__
+
+#include "TdsModel.h"
+#include <vector>
+#include <functional>
+
+using namespace std;
+
+// ****************************************************************************
+/// Time-domain simulation of several voices with the same tube topology
+/// (e.g., to synthesize the utterances of a data set), advanced in lockstep.
+///
+/// The voices are processed in groups of LANE_WIDTH voices, each group on a
+/// thread of the pool (see ParallelLoop.h). For each time step, the network
+/// components and the matrices of the voices of a group are calculated one
+/// voice after the other, and the systems of equations of the group are
+/// solved together with the Cholesky factorization in skyline storage.
+/// Since the sparsity pattern of the matrix only depends on the topology of
+/// the tube, the voices share the ordering and the profile of the factor,
+/// which are stored interleaved with the voice innermost, so that the
+/// factorization and the substitutions are vectorized across the voices.
+/// The voices always use this solver, whatever their option solverType.
+// ****************************************************************************
+
+class TdsModelBatch
+{
+public:
+  /// Number of voices whose equations are solved together
+  static const int LANE_WIDTH = 8;
+
+  /// Sets the inputs of a voice (tube, sources) before its next time step,
+  /// the index of the step being given by getSampleIndex() of the voice
+  typedef function<void(int voice, TdsModel *model)> InputCallback;
+
+public:
+  TdsModelBatch(int numVoices);
+  ~TdsModelBatch();
+
+  int getNumVoices() { return (int)voice.size(); }
+  TdsModel *getVoice(int index) { return voice[index]; }
+  void resetMotion();
+
+  /// Advances all voices by numSteps time steps on numThreads threads. The
+  /// radiated flow of the step k of the voice v is written in
+  /// radiatedFlow[v*numSteps + k].
+  void proceedTimeSteps(int numSteps, const InputCallback &setInputs,
+    double *radiatedFlow, int numThreads);
+
+private:
+  /// Factorization and substitution workspace of a group of voices
+  struct LaneWorkspace
+  {
+    double matrix[TdsModel::MAX_SKYLINE_ELEMENTS*LANE_WIDTH];
+    double vector[TdsModel::NUM_BRANCH_CURRENTS*LANE_WIDTH];
+    double inverseDiagonal[TdsModel::NUM_BRANCH_CURRENTS*LANE_WIDTH];
+  };
+
+  void proceedGroup(int firstVoice, int numVoices, int numSteps,
+    const InputCallback &setInputs, double *radiatedFlow);
+  void solveEquationsSkyline(int firstVoice, int numVoices, LaneWorkspace &ws);
+
+  vector<TdsModel*> voice;
+};
+
+#endif
@@ -0,0 +1,311 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#include "TfLibrary.h"
+#include "Acoustic3dSimulation.h"
+#include "ModesCache.h"
+#include "Logger.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <cmath>
+
+static const char TF_LIBRARY_MAGIC[8] = { 'V', 'T', 'L', '3', 'D', 'T', 'F', 'L' };
+
+// ****************************************************************************
+
+vector<VocalTract::Shape> interpolatedShapes(const VocalTract::Shape& a,
+  const VocalTract::Shape& b, int numRatios)
+{
+  vector<VocalTract::Shape> shapes;
+  for (int r(0); r < numRatios; r++)
+  {
+    double ratio((numRatios == 1) ? 0. : (double)r / (double)(numRatios - 1));
+    VocalTract::Shape s;
+    ostringstream name;
+    name << a.name << "-" << b.name << "-" << ratio;
+    s.name = name.str();
+    for (int i(0); i < VocalTract::NUM_PARAMS; i++)
+    {
+      s.param[i] = (1. - ratio) * a.param[i] + ratio * b.param[i];
+    }
+    shapes.push_back(s);
+  }
+  return shapes;
+}
+
+// ****************************************************************************
+
+bool buildTfLibrary(VocalTract* tract, const vector<VocalTract::Shape>& shapes,
+  const struct simulationSetup& setup, const string& cacheDirectory,
+  struct tfLibrary& library, const progressCallback& progress)
+{
+  LogStream log;
+  log << "Transfer function library of " << shapes.size() << " shapes" << endl;
+
+  double storedParams[VocalTract::NUM_PARAMS];
+  for (int i(0); i < VocalTract::NUM_PARAMS; i++) { storedParams[i] = tract->param[i].x; }
+
+  library.spectrumLgthExponent = setup.simuParams.spectrumLgthExponent;
+  library.freqs.clear();
+  library.entries.clear();
+  bool success(true);
+
+  for (int s(0); s < shapes.size(); s++)
+  {
+    for (int i(0); i < VocalTract::NUM_PARAMS; i++) { tract->param[i].x = shapes[s].param[i]; }
+    tract->calculateAll();
+
+    // the radiation impedance is shared by the shapes with the same exit
+    // contour through the cache directory
+    Acoustic3dSimulation simu;
+    simu.setCacheDirectory(cacheDirectory);
+    applySimulationSetup(simu, setup);
+    simu.setContourInterpolationMethod(AREA);
+    simu.setGeometryImported(false);
+    simu.requestReloadGeometry();
+    if (!simu.importGeometry(tract) || (simu.numberOfSegments() == 0))
+    {
+      log << "Library: cannot create the geometry of the shape "
+        << shapes[s].name << endl;
+      success = false;
+      break;
+    }
+
+    simu.computeTransferFunction(tract);
+
+    struct tfLibraryEntry entry;
+    entry.name = shapes[s].name;
+    entry.params.assign(shapes[s].param, shapes[s].param + VocalTract::NUM_PARAMS);
+    entry.glottalTF = simu.glottalSourceTF().cast<complex<float>>();
+    entry.noiseTF = simu.noiseSourceTF().cast<complex<float>>();
+    if (library.entries.empty()) { library.freqs = simu.tfFreqs(); }
+    library.entries.push_back(entry);
+
+    log << "Library: shape " << s + 1 << "/" << shapes.size() << " "
+      << shapes[s].name << " computed" << endl;
+
+    if (progress && !progress(s + 1, shapes.size()))
+    {
+      success = false;
+      break;
+    }
+  }
+
+  for (int i(0); i < VocalTract::NUM_PARAMS; i++) { tract->param[i].x = storedParams[i]; }
+  tract->calculateAll();
+
+  log.close();
+  return success;
+}
+
+// ****************************************************************************
+// Binary input/output
+
+static void writeString(ostream& os, const string& str)
+{
+  writeBinary(os, (int)str.size());
+  os.write(str.data(), str.size());
+}
+
+static bool readString(istream& is, string& str)
+{
+  int size;
+  if (!readBinary(is, size) || (size < 0)) { return false; }
+  str.resize(size);
+  is.read(&str[0], size);
+  return (bool)is;
+}
+
+// the complex matrices are written as their size followed by the interleaved
+// real and imaginary parts in column-major order
+
+static void writeMatrix(ostream& os, const Eigen::MatrixXcf& mat)
+{
+  writeBinary(os, (int)mat.rows());
+  writeBinary(os, (int)mat.cols());
+  os.write((const char*)mat.data(), mat.size() * sizeof(complex<float>));
+}
+
+static bool readMatrix(istream& is, Eigen::MatrixXcf& mat)
+{
+  int rows, cols;
+  if (!readBinary(is, rows) || !readBinary(is, cols) || (rows < 0) || (cols < 0))
+  {
+    return false;
+  }
+  mat.resize(rows, cols);
+  is.read((char*)mat.data(), mat.size() * sizeof(complex<float>));
+  return (bool)is;
+}
+
+// ****************************************************************************
+
+bool writeTfLibrary(const string& fileName, const struct tfLibrary& library)
+{
+  ofstream os(fileName, ios::binary);
+  if (!os.is_open()) { return false; }
+
+  os.write(TF_LIBRARY_MAGIC, 8);
+  writeBinary(os, TF_LIBRARY_VERSION);
+  writeBinary(os, library.spectrumLgthExponent);
+  writeBinary(os, library.freqs);
+  writeBinary(os, (int)library.entries.size());
+  for (auto& entry : library.entries)
+  {
+    writeString(os, entry.name);
+    writeBinary(os, entry.params);
+    writeMatrix(os, entry.glottalTF);
+    writeMatrix(os, entry.noiseTF);
+  }
+
+  return (bool)os;
+}
+
+// ****************************************************************************
+
+bool readTfLibrary(const string& fileName, struct tfLibrary& library)
+{
+  ifstream is(fileName, ios::binary);
+  if (!is.is_open()) { return false; }
+
+  char magic[8];
+  int version, numEntries;
+  is.read(magic, 8);
+  if (!is || !equal(magic, magic + 8, TF_LIBRARY_MAGIC)) { return false; }
+  if (!readBinary(is, version) || (version != TF_LIBRARY_VERSION)) { return false; }
+
+  struct tfLibrary newLibrary;
+  if (!readBinary(is, newLibrary.spectrumLgthExponent) ||
+    !readBinary(is, newLibrary.freqs) || !readBinary(is, numEntries) ||
+    (numEntries < 0))
+  {
+    return false;
+  }
+  newLibrary.entries.resize(numEntries);
+  for (auto& entry : newLibrary.entries)
+  {
+    if (!readString(is, entry.name) || !readBinary(is, entry.params) ||
+      !readMatrix(is, entry.glottalTF) || !readMatrix(is, entry.noiseTF))
+    {
+      return false;
+    }
+  }
+
+  library = newLibrary;
+  return true;
+}
+
+// ****************************************************************************
+// Interpolation of the log-magnitude and of the phase unwrapped along the
+// frequencies of the transfer functions of several entries
+
+static void interpolateTf(const vector<const Eigen::MatrixXcf*>& tfs,
+  const vector<double>& weights, Eigen::MatrixXcd& tf)
+{
+  int numFreqs(tfs[0]->rows()), numPoints(tfs[0]->cols());
+  tf.resize(numFreqs, numPoints);
+
+  for (int p(0); p < numPoints; p++)
+  {
+    vector<double> phase(tfs.size(), 0.), lastPhase(tfs.size(), 0.);
+    for (int i(0); i < numFreqs; i++)
+    {
+      double logMag(0.), interpPhase(0.);
+      for (int n(0); n < tfs.size(); n++)
+      {
+        complex<double> value((*tfs[n])(i, p));
+        double ph(arg(value));
+        if (i > 0)
+        {
+          phase[n] += remainder(ph - lastPhase[n], 2. * M_PI);
+        }
+        else
+        {
+          phase[n] = ph;
+        }
+        lastPhase[n] = ph;
+        logMag += weights[n] * log(max(abs(value), 1e-30));
+        interpPhase += weights[n] * phase[n];
+      }
+      tf(i, p) = polar(exp(logMag), interpPhase);
+    }
+  }
+}
+
+// ****************************************************************************
+
+bool interpolateTfLibrary(const struct tfLibrary& library, const double* params,
+  int numParams, Eigen::MatrixXcd& glottalTF, Eigen::MatrixXcd& noiseTF)
+{
+  int numEntries(library.entries.size());
+  if ((numEntries == 0) || (library.entries[0].params.size() != numParams))
+  {
+    return false;
+  }
+
+  // range of the parameters in the library
+  vector<double> minParams(library.entries[0].params), maxParams(minParams);
+  for (auto& entry : library.entries)
+  {
+    for (int j(0); j < numParams; j++)
+    {
+      minParams[j] = min(minParams[j], entry.params[j]);
+      maxParams[j] = max(maxParams[j], entry.params[j]);
+    }
+  }
+
+  vector<pair<double, int>> distances(numEntries);
+  for (int n(0); n < numEntries; n++)
+  {
+    double d(0.);
+    for (int j(0); j < numParams; j++)
+    {
+      double range(maxParams[j] - minParams[j]);
+      if (range > 0.) { d += pow((params[j] - library.entries[n].params[j]) / range, 2); }
+    }
+    distances[n] = { d, n };
+  }
+
+  int numNeighbours(min(numEntries, TF_LIBRARY_NEIGHBOURS));
+  partial_sort(distances.begin(), distances.begin() + numNeighbours, distances.end());
+
+  // inverse squared distance weights, the closest entry is taken as it is
+  // if the shape coincides with it
+  vector<const Eigen::MatrixXcf*> glottalTfs, noiseTfs;
+  vector<double> weights;
+  double sumWeights(0.);
+  for (int k(0); k < numNeighbours; k++)
+  {
+    const struct tfLibraryEntry& entry(library.entries[distances[k].second]);
+    glottalTfs.push_back(&entry.glottalTF);
+    noiseTfs.push_back(&entry.noiseTF);
+    weights.push_back((distances[k].first < 1e-12) ? 1. : 1. / distances[k].first);
+    sumWeights += weights.back();
+    if (distances[k].first < 1e-12) { break; }
+  }
+  for (auto& w : weights) { w /= sumWeights; }
+
+  interpolateTf(glottalTfs, weights, glottalTF);
+  interpolateTf(noiseTfs, weights, noiseTF);
+
+  return true;
+}
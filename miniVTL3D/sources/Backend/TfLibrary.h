@@ -0,0 +1,88 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#ifndef __TF_LIBRARY_H__
+#define __TF_LIBRARY_H__
+
+#include "SimulationParametersFile.h"
+#include "ParallelLoop.h"
+#include "VocalTract.h"
+#include <string>
+#include <vector>
+#include <complex>
+#include <Eigen/Dense>
+
+using namespace std;
+
+// version of the format of the library files
+const int TF_LIBRARY_VERSION = 1;
+// number of entries closest to the queried shape which are interpolated
+const int TF_LIBRARY_NEIGHBOURS = 4;
+
+// ****************************************************************************
+// Library of the 3D transfer functions of a set of vocal tract shapes, which
+// is computed offline and interpolated at runtime for the intermediate
+// shapes, so that a shape can be synthesized without running the 3D
+// simulation. The entries are indexed by the parameters of the vocal tract
+// model and their glottal and noise source transfer functions are stored in
+// single precision. The transfer functions of a shape are interpolated on
+// the log-magnitude and the unwrapped phase with inverse distance weights of
+// the TF_LIBRARY_NEIGHBOURS closest entries, the distance being measured on
+// the parameters normalised by their range in the library.
+// ****************************************************************************
+
+struct tfLibraryEntry
+{
+  string name;
+  vector<double> params;        // parameters of the vocal tract model
+  Eigen::MatrixXcf glottalTF;   // frequencies x transfer function points
+  Eigen::MatrixXcf noiseTF;
+};
+
+struct tfLibrary
+{
+  int spectrumLgthExponent;     // of the simulations of the entries
+  vector<double> freqs;         // computed frequencies
+  vector<struct tfLibraryEntry> entries;
+};
+
+// shapes between the shapes a and b, with numRatios interpolation ratios
+// from 0 (a) to 1 (b)
+vector<VocalTract::Shape> interpolatedShapes(const VocalTract::Shape& a,
+  const VocalTract::Shape& b, int numRatios);
+
+// compute the transfer functions of the shapes one after the other with the
+// given setup (the threads of the setup are used for the frequency sweep),
+// the parameters of the vocal tract are restored at the end, the progress
+// callback receives the number of shapes computed
+bool buildTfLibrary(VocalTract* tract, const vector<VocalTract::Shape>& shapes,
+  const struct simulationSetup& setup, const string& cacheDirectory,
+  struct tfLibrary& library, const progressCallback& progress = progressCallback());
+
+bool writeTfLibrary(const string& fileName, const struct tfLibrary& library);
+bool readTfLibrary(const string& fileName, struct tfLibrary& library);
+
+// transfer functions of the shape with the given parameters (false if the
+// library is empty or the number of parameters does not match)
+bool interpolateTfLibrary(const struct tfLibrary& library, const double* params,
+  int numParams, Eigen::MatrixXcd& glottalTF, Eigen::MatrixXcd& noiseTF);
+
+#endif
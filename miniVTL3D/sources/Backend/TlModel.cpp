@@ -25,6 +25,7 @@
 const double TlModel::MIN_AREA_CM2  = 0.01e-2; // = 0.01 mm^2
 const double TlModel::MIN_FREQ_RAD = 0.0001;
 
+static const double NASALITY_THRESHOLD_CM2 = 0.01;   // = 1 mm^2
 static const double RS_FACTOR = sqrt(AMBIENT_DENSITY_CGS*AIR_VISCOSITY_CGS*0.5);
 static const double LS_FACTOR = AMBIENT_DENSITY_CGS;
 static const double CP_FACTOR = 1.0 / (AMBIENT_DENSITY_CGS*SOUND_VELOCITY_CGS*SOUND_VELOCITY_CGS);
@@ -224,6 +225,45 @@ void TlModel::getSpectrum(SpectrumType type, ComplexSignal *spectrum, int spectr
 }
 
 
+// ****************************************************************************
+/// Calculates the magnitudes of the flow source transfer function from the 
+/// glottis to the lips at arbitrary frequencies. The matrix products are 
+/// calculated for these frequencies only, so that the next call of 
+/// getSpectrum() must recalculate them for its frequency raster.
+/// \param freq_Hz The frequencies in Hz
+/// \param numValues Number of frequencies
+/// \param magnitude Return values of the magnitudes
+// ****************************************************************************
+
+void TlModel::getFlowSourceMagnitudes(const double *freq_Hz, int numValues, double *magnitude)
+{
+  int i;
+
+  if (numValues > MAX_NUM_FREQ - 1) 
+  { 
+    numValues = MAX_NUM_FREQ - 1; 
+  }
+
+  // Index 0 is reserved for the frequency 0 Hz, which is treated like 
+  // index 1 by the transfer functions.
+  numFreq = numValues + 1;
+  discreteOmega[0] = 0.0;
+  for (i=0; i < numValues; i++)
+  {
+    discreteOmega[i+1] = 2.0*M_PI*freq_Hz[i];
+  }
+
+  calcMatrixProducts();
+
+  for (i=0; i < numValues; i++)
+  {
+    magnitude[i] = abs(getFlowSourceTF(i+1, Tube::FIRST_PHARYNX_SECTION));
+  }
+
+  resetCalculations = true;
+}
+
+
 // ****************************************************************************
 /// Returns the index of the most constricted tube section in the vocal tract.
 // ****************************************************************************
@@ -430,6 +470,198 @@ void TlModel::getFormants(double *formantFreq, double *formantBW, int &numForman
     }
   }
 
+  // ****************************************************************
+  // Is there a closure, a critical constriction or a coupled nasal
+  // cavity ?
+  // ****************************************************************
+
+  getTubeConditions(formantFreq, formantAmp, numFormants, frictionNoise, isClosure, isNasal);
+}
+
+
+// ****************************************************************************
+/// Returns the formants like getFormants(), but with much less evaluations of
+/// the transfer function, as needed in optimization loops. The transfer
+/// function is evaluated on a coarse frequency raster (twice the spacing 
+/// of getFormants()) to bracket the resonances, which must pass the same 
+/// tests as in getFormants(). Each resonance is then refined by successive 
+/// parabolic interpolation of 1/|H(f)|^2, which is a parabola in the 
+/// vicinity of an isolated pole p = F + j*B/2:
+/// 1/|H(f)|^2 ~ a*((f-F)^2 + (B/2)^2). The formant frequency F and the 
+/// bandwidth B are hence taken from the vertex and the curvature of the 
+/// final parabola.
+/// With a coupled nasal cavity, the spectrum has pole-zero pairs for which
+/// this does not hold, and the formants are determined by getFormants().
+/// The parameters are the same as for getFormants().
+// ****************************************************************************
+
+void TlModel::getFormantsFast(double *formantFreq, double *formantBW, int &numFormants, 
+  const int MAX_FORMANTS, bool &frictionNoise, bool &isClosure, bool &isNasal)
+{
+  const int MAX_PEAKS = 32;       // Expect not more than 32 formant peaks
+  const int NUM_ITERATIONS = 2;
+  const double ABS_MIN_THRESHOLD = 0.316;  // Absolute threshold of -10 dB for all peaks
+  const double df = 2.0*(double)SAMPLING_RATE / (double)(1 << 11);
+  
+  int firstSample = (int)(150.0 / df);    // Minimum frequency = 150 Hz
+  int lastSample = (int)(7000.0 / df);    // Maximum frequency = 7000 Hz
+  int numSamples = lastSample - firstSample + 2;
+
+  double freq[3*MAX_PEAKS + MAX_NUM_FREQ / 4];
+  double mag[3*MAX_PEAKS + MAX_NUM_FREQ / 4];
+  double x[MAX_PEAKS][3];
+  double g[MAX_PEAKS][3];
+  double formantAmp[MAX_PEAKS];
+  double a0, a1, a2;
+  double currHeight, threshold;
+  double a, c, den, delta;
+  bool leftOK, rightOK;
+  int i, k, n, iteration;
+  int numPeaks = 0;
+
+  if (tube.section[Tube::FIRST_NOSE_SECTION]->area_cm2 > NASALITY_THRESHOLD_CM2)
+  {
+    getFormants(formantFreq, formantBW, numFormants, MAX_FORMANTS, frictionNoise, isClosure, isNasal);
+    return;
+  }
+
+  numFormants = 0;
+
+  // ****************************************************************
+  // Magnitudes on the coarse raster: mag[i] belongs to the sample
+  // firstSample - 1 + i.
+  // ****************************************************************
+
+  for (i=0; i < numSamples; i++)
+  {
+    freq[i] = df*(double)(firstSample - 1 + i);
+  }
+  getFlowSourceMagnitudes(freq, numSamples, mag);
+
+  // ****************************************************************
+  // Bracket the resonances. A local maximum is accepted, when the
+  // magnitude drops 1 dB to the left and the right without higher
+  // magnitudes inbetween (like in getFormants()).
+  // ****************************************************************
+
+  for (i=1; (i < numSamples - 1) && (numPeaks < MAX_FORMANTS) && (numPeaks < MAX_PEAKS); i++)
+  {
+    a0 = mag[i-1];
+    a1 = mag[i];
+    a2 = mag[i+1];
+
+    if ((a1 >= a0) && (a1 > a2) && (a1 >= ABS_MIN_THRESHOLD))
+    {
+      leftOK = false;
+      rightOK = false;
+      currHeight = a1;
+      threshold = currHeight*0.891;     // Factor for -1 dB
+
+      k = i-1;
+      while ((k > 1) && (mag[k] <= currHeight) && (mag[k] > threshold)) { k--; }
+      if (mag[k] <= threshold) { leftOK = true; }
+
+      k = i+1;
+      while ((k < numSamples - 1) && (mag[k] <= currHeight) && (mag[k] > threshold)) { k++; }
+      if (mag[k] <= threshold) { rightOK = true; }
+
+      if ((leftOK) && (rightOK))
+      {
+        for (k=0; k < 3; k++)
+        {
+          x[numPeaks][k] = freq[i - 1 + k];
+          g[numPeaks][k] = 1.0 / (mag[i - 1 + k]*mag[i - 1 + k]);
+        }
+        numPeaks++;
+      }
+    }
+  }
+
+  // ****************************************************************
+  // Refine all resonances together by successive parabolic 
+  // interpolation of 1/|H|^2.
+  // ****************************************************************
+
+  for (iteration=0; iteration <= NUM_ITERATIONS; iteration++)
+  {
+    for (n=0; n < numPeaks; n++)
+    {
+      // The parabola through the three points of the peak
+
+      den = (x[n][1] - x[n][0])*(g[n][1] - g[n][2]) - (x[n][1] - x[n][2])*(g[n][1] - g[n][0]);
+      a = ((g[n][2] - g[n][1]) / (x[n][2] - x[n][1]) - (g[n][1] - g[n][0]) / (x[n][1] - x[n][0])) / 
+        (x[n][2] - x[n][0]);
+
+      if ((a > 0.0) && (den != 0.0))
+      {
+        formantFreq[n] = x[n][1] - 0.5*((x[n][1] - x[n][0])*(x[n][1] - x[n][0])*(g[n][1] - g[n][2]) - 
+          (x[n][1] - x[n][2])*(x[n][1] - x[n][2])*(g[n][1] - g[n][0])) / den;
+        // Keep the vertex within the bracket of the peak
+        if (formantFreq[n] < x[n][0]) { formantFreq[n] = x[n][0]; }
+        if (formantFreq[n] > x[n][2]) { formantFreq[n] = x[n][2]; }
+        c = g[n][1] - a*(x[n][1] - formantFreq[n])*(x[n][1] - formantFreq[n]);
+        if (c <= 0.0) { c = g[n][1]; }
+        formantBW[n] = 2.0*sqrt(c / a);
+        formantAmp[n] = 1.0 / sqrt(c);
+      }
+      else
+      {
+        // The error case: keep the middle point
+        formantFreq[n] = x[n][1];
+        formantBW[n] = 100.0;     // Default value for the error case
+        formantAmp[n] = 1.0 / sqrt(g[n][1]);
+      }
+
+      // The points for the next iteration are placed at a distance of
+      // half the bandwidth around the vertex.
+
+      delta = 0.5*formantBW[n];
+      if (delta > df) { delta = df; }
+      if (delta < 0.5) { delta = 0.5; }
+
+      for (k=0; k < 3; k++)
+      {
+        x[n][k] = formantFreq[n] + (double)(k - 1)*delta;
+        freq[3*n + k] = x[n][k];
+      }
+    }
+
+    if ((iteration < NUM_ITERATIONS) && (numPeaks > 0))
+    {
+      getFlowSourceMagnitudes(freq, 3*numPeaks, mag);
+      for (n=0; n < numPeaks; n++)
+      {
+        for (k=0; k < 3; k++)
+        {
+          g[n][k] = 1.0 / (mag[3*n + k]*mag[3*n + k]);
+        }
+      }
+    }
+  }
+
+  numFormants = numPeaks;
+
+  // ****************************************************************
+  // Is there a closure, a critical constriction or a coupled nasal
+  // cavity ?
+  // ****************************************************************
+
+  getTubeConditions(formantFreq, formantAmp, numFormants, frictionNoise, isClosure, isNasal);
+}
+
+
+// ****************************************************************************
+/// Determines from the formants and the tube geometry wheather the vocal 
+/// tract has a closure, a critical constriction or a coupled nasal cavity
+/// (see getFormants()).
+/// \param formantAmp The magnitudes of the transfer function at the formants
+// ****************************************************************************
+
+void TlModel::getTubeConditions(const double *formantFreq, const double *formantAmp, 
+  int numFormants, bool &frictionNoise, bool &isClosure, bool &isNasal)
+{
+  int i, k;
+
   // ****************************************************************
   // Is there a closure in the vocal tract tube ? Assume that, when
   // only one or no formant peaks are above 0 dB below 4 kHz!
@@ -476,7 +708,6 @@ void TlModel::getFormants(double *formantFreq, double *formantBW, int &numForman
   // Is the nasal port open ?
   // ****************************************************************
 
-  const double NASALITY_THRESHOLD_CM2 = 0.01;   // = 1 mm^2
   if (tube.section[Tube::FIRST_NOSE_SECTION]->area_cm2 > NASALITY_THRESHOLD_CM2) 
   { 
     isNasal = true; 
@@ -510,12 +741,7 @@ double TlModel::getCircumference(double area)
 
 void TlModel::prepareCalculations()
 {
-  int i, k, m;
-  double omega;
-  Matrix2x2 M, K;
-  Tube::Section *ts = NULL;
-  ComplexValue fossaInputImpedance;
-  ComplexValue inputImpedance;
+  int i;
 
   // ****************************************************************
   // Keep in mind the current options and tube geometry
@@ -537,9 +763,26 @@ void TlModel::prepareCalculations()
 
   for (i=0; i < numFreq; i++)
   {
-    omega = 2.0*M_PI*f0*(double)i;
-    
-    discreteOmega[i] = omega;
+    discreteOmega[i] = 2.0*M_PI*f0*(double)i;
+  }
+
+  calcMatrixProducts();
+}
+
+
+// ****************************************************************************
+/// Calculates the frequency data and the matrix products of the tube sections
+/// for the numFreq angular frequencies in discreteOmega[].
+// ****************************************************************************
+
+void TlModel::calcMatrixProducts()
+{
+  int i, k, m;
+  double omega;
+
+  for (i=0; i < numFreq; i++)
+  {
+    omega = discreteOmega[i];
     mouthRadiationImpedance[i]  = getRadiationImpedance(omega, tube.section[Tube::LAST_MOUTH_SECTION]->area_cm2);
     noseRadiationImpedance[i] = getRadiationImpedance(omega, tube.section[Tube::LAST_NOSE_SECTION]->area_cm2);
     lungTerminationImpedance[i] = 0.0;
@@ -567,139 +810,151 @@ void TlModel::prepareCalculations()
   }
 
   // ****************************************************************
-  // Calculate the product matrices for the tube sections.
+  // Calculate the product matrices for the tube sections. The
+  // matrices of a tube section are calculated for all frequencies
+  // at once and multiplied with the running product of the branch.
   // ****************************************************************
 
   for (i=0; i < numFreq; i++)
   {
     omega = discreteOmega[i];
-
-    // **************************************************************
-    // Input impedance of the piriform fossa.
-    // **************************************************************
-
-    K.unitMatrix();
-    for (k = Tube::FIRST_FOSSA_SECTION; k <= Tube::LAST_FOSSA_SECTION; k++)
-    {
-      ts = tube.section[k];
-      K*= getSectionMatrix(omega, k);
-      matrixProduct[k][i] = K;
+    if (omega < MIN_FREQ_RAD) 
+    { 
+      omega = MIN_FREQ_RAD; 
     }
-    fossaInputImpedance = K.A / K.C;
+    limitedOmega[i] = omega;
+    sqrtLimitedOmega[i] = sqrt(omega);
+  }
 
-    // **************************************************************
-    // The matrix products of the subglottal system and pharynx.
-    // **************************************************************
+  // ****************************************************************
+  // Input admittance of the piriform fossa.
+  // ****************************************************************
 
-    K.unitMatrix();
+  MatrixArray &K = productMatrices;
+  MatrixArray &M = sectionMatrices;
+  double re, im, den;
 
-    for (k=Tube::FIRST_TRACHEA_SECTION; k <= Tube::LAST_PHARYNX_SECTION; k++)   
-    {
-      ts = tube.section[k];
+  setUnitMatrices(K);
+  for (k = Tube::FIRST_FOSSA_SECTION; k <= Tube::LAST_FOSSA_SECTION; k++)
+  {
+    getSectionMatrices(k, M);
+    multiplyMatrices(K, M);
+    storeMatrixProducts(K, k);
+  }
 
-      // Add an "inner length correction" (additional inductivity)
-      // between the previous and the current tube section as
-      // described in Sondhi (1983).
-      if ((k > Tube::FIRST_PHARYNX_SECTION) && (k <= Tube::LAST_MOUTH_SECTION) && (options.innerLengthCorrections))
-      {
-        M.unitMatrix();
-        M.B = getJunctionImpedance(omega, tube.section[k-1]->area_cm2, tube.section[k]->area_cm2);
-        K*= M;
-      }
+  // Y = C / A
+  for (i=0; i < numFreq; i++)
+  {
+    den = K.reA[i]*K.reA[i] + K.imA[i]*K.imA[i];
+    reFossaAdmittance[i] = (K.reC[i]*K.reA[i] + K.imC[i]*K.imA[i]) / den;
+    imFossaAdmittance[i] = (K.imC[i]*K.reA[i] - K.reC[i]*K.imA[i]) / den;
+  }
 
-      K*= getSectionMatrix(omega, k);
-      matrixProduct[k][i] = K;
+  // ****************************************************************
+  // The matrix products of the subglottal system and pharynx.
+  // ****************************************************************
 
-      // Add the differential small-signal resistance at the glottis
+  setUnitMatrices(K);
 
-      if ((k == Tube::LAST_TRACHEA_SECTION) && (options.staticPressureDrops))
-      {
-        M.unitMatrix();
-        M.B = AMBIENT_DENSITY_CGS*meanFlow / (A_g*A_g);
-        K*= M;
-      }
+  for (k=Tube::FIRST_TRACHEA_SECTION; k <= Tube::LAST_PHARYNX_SECTION; k++)   
+  {
+    // Add an "inner length correction" (additional inductivity)
+    // between the previous and the current tube section as
+    // described in Sondhi (1983).
+    if ((k > Tube::FIRST_PHARYNX_SECTION) && (k <= Tube::LAST_MOUTH_SECTION) && (options.innerLengthCorrections))
+    {
+      multiplySeriesElement(K, 0.0, 
+        getJunctionImpedance(1.0, tube.section[k-1]->area_cm2, tube.section[k]->area_cm2).imag());
+    }
 
-      // Put a small-signal flow resistance at the entrance of the supraglottal constriction
+    getSectionMatrices(k, M);
+    multiplyMatrices(K, M);
+    storeMatrixProducts(K, k);
 
-      if ((k == minAreaSection-1) && (options.staticPressureDrops))
-      {
-        M.unitMatrix();
-        M.B = AMBIENT_DENSITY_CGS*meanFlow / (A_c*A_c);
-        K*= M;
-      }
+    // Add the differential small-signal resistance at the glottis
 
-      // Consider the piriform fossa as a side branch.
-      
-      if ((k == Tube::FIRST_PHARYNX_SECTION + Tube::FOSSA_COUPLING_SECTION) && (options.piriformFossa))
-      {
-        M.unitMatrix();
-        M.C = 1.0 / fossaInputImpedance;
-        K*= M;
-      }
-    }       // Loop for the sections of the trachea + glottis + pharynx
+    if ((k == Tube::LAST_TRACHEA_SECTION) && (options.staticPressureDrops))
+    {
+      multiplySeriesElement(K, AMBIENT_DENSITY_CGS*meanFlow / (A_g*A_g), 0.0);
+    }
 
-    // **************************************************************
-    // The matrix products of the mouth cavity.
-    // **************************************************************
+    // Put a small-signal flow resistance at the entrance of the supraglottal constriction
 
-    K.unitMatrix();
-    for (k = Tube::FIRST_MOUTH_SECTION; k <= Tube::LAST_MOUTH_SECTION; k++)
+    if ((k == minAreaSection-1) && (options.staticPressureDrops))
     {
-      ts = tube.section[k];
+      multiplySeriesElement(K, AMBIENT_DENSITY_CGS*meanFlow / (A_c*A_c), 0.0);
+    }
 
-      // Add an "inner length correction" (additional inductivity)
-      // between the previous and the current tube section as
-      // described in Sondhi (1983).
-      if ((k > Tube::FIRST_PHARYNX_SECTION) && (k <= Tube::LAST_MOUTH_SECTION) && (options.innerLengthCorrections))
-      {
-        M.unitMatrix();
-        M.B = getJunctionImpedance(omega, tube.section[k-1]->area_cm2, tube.section[k]->area_cm2);
-        K*= M;
-      }
+    // Consider the piriform fossa as a side branch.
+    
+    if ((k == Tube::FIRST_PHARYNX_SECTION + Tube::FOSSA_COUPLING_SECTION) && (options.piriformFossa))
+    {
+      multiplyParallelElement(K, reFossaAdmittance, imFossaAdmittance);
+    }
+  }       // Loop for the sections of the trachea + glottis + pharynx
 
-      K*= getSectionMatrix(omega, k);
-      matrixProduct[k][i] = K;
+  // ****************************************************************
+  // The matrix products of the mouth cavity.
+  // ****************************************************************
 
-      // Put a small-signal flow resistance at the entrance of the supraglottal constriction
+  setUnitMatrices(K);
+  for (k = Tube::FIRST_MOUTH_SECTION; k <= Tube::LAST_MOUTH_SECTION; k++)
+  {
+    // Add an "inner length correction" (additional inductivity)
+    // between the previous and the current tube section as
+    // described in Sondhi (1983).
+    if ((k > Tube::FIRST_PHARYNX_SECTION) && (k <= Tube::LAST_MOUTH_SECTION) && (options.innerLengthCorrections))
+    {
+      multiplySeriesElement(K, 0.0, 
+        getJunctionImpedance(1.0, tube.section[k-1]->area_cm2, tube.section[k]->area_cm2).imag());
+    }
 
-      if ((k == minAreaSection-1) && (options.staticPressureDrops))
-      {
-        M.unitMatrix();
-        M.B = AMBIENT_DENSITY_CGS*meanFlow / (A_c*A_c);
-        K*= M;
-      }
-    }     // Loop for the mouth sections
+    getSectionMatrices(k, M);
+    multiplyMatrices(K, M);
+    storeMatrixProducts(K, k);
 
-    // **************************************************************
-    // The matrix products of the nasal cavity.
-    // **************************************************************
+    // Put a small-signal flow resistance at the entrance of the supraglottal constriction
 
-    K.unitMatrix();
-    for (k = Tube::FIRST_NOSE_SECTION; k <= Tube::LAST_NOSE_SECTION; k++)   
+    if ((k == minAreaSection-1) && (options.staticPressureDrops))
     {
-      ts = tube.section[k];
-      K*= getSectionMatrix(omega, k);
-      matrixProduct[k][i] = K;
+      multiplySeriesElement(K, AMBIENT_DENSITY_CGS*meanFlow / (A_c*A_c), 0.0);
+    }
+  }     // Loop for the mouth sections
+
+  // ****************************************************************
+  // The matrix products of the nasal cavity.
+  // ****************************************************************
 
-      // Coupling of the paranasal sinuses ? ************************
+  setUnitMatrices(K);
+  for (k = Tube::FIRST_NOSE_SECTION; k <= Tube::LAST_NOSE_SECTION; k++)   
+  {
+    getSectionMatrices(k, M);
+    multiplyMatrices(K, M);
+    storeMatrixProducts(K, k);
 
-      if (options.paranasalSinuses)
+    // Coupling of the paranasal sinuses ? **************************
+
+    if (options.paranasalSinuses)
+    {
+      for (m=0; m < Tube::NUM_SINUS_SECTIONS; m++)
       {
-        for (m=0; m < Tube::NUM_SINUS_SECTIONS; m++)
+        if (k == Tube::FIRST_NOSE_SECTION + Tube::SINUS_COUPLING_SECTION[m])
         {
-          if (k == Tube::FIRST_NOSE_SECTION + Tube::SINUS_COUPLING_SECTION[m])
+          // The input admittance of the sinus is Y = C / A.
+          getSectionMatrices(Tube::FIRST_SINUS_SECTION + m, M);
+          for (i=0; i < numFreq; i++)
           {
-            M = getSectionMatrix(omega, Tube::FIRST_SINUS_SECTION + m);
-            inputImpedance = M.A / M.C;
-            M.unitMatrix();
-            M.C = 1.0 / inputImpedance;
-            K*= M;
+            den = M.reA[i]*M.reA[i] + M.imA[i]*M.imA[i];
+            re = (M.reC[i]*M.reA[i] + M.imC[i]*M.imA[i]) / den;
+            im = (M.imC[i]*M.reA[i] - M.reC[i]*M.imA[i]) / den;
+            reSinusAdmittance[i] = re;
+            imSinusAdmittance[i] = im;
           }
+          multiplyParallelElement(K, reSinusAdmittance, imSinusAdmittance);
         }
       }
-    }     // Loop for the nose sections
-
-  }   // Loop for the frequencies
+    }
+  }     // Loop for the nose sections
 }
 
 
@@ -959,6 +1214,204 @@ Matrix2x2 TlModel::getSectionMatrix(double omega, int section)
 }
 
 
+// ****************************************************************************
+/// Calculates the 2x2 matrices of a tube section for all discrete 
+/// frequencies (see getSectionMatrix()). The matrices of the lumped 
+/// elements are calculated for all frequencies in vectorizable loops. The 
+/// matrices of the Helmholtz resonators and of the real wave propagation 
+/// are calculated frequency by frequency.
+/// \param section Section index
+/// \param M Return value for the matrices
+// ****************************************************************************
+
+void TlModel::getSectionMatrices(int section, MatrixArray &M)
+{
+  int i;
+  Matrix2x2 S;
+
+  if (((section >= Tube::FIRST_SINUS_SECTION) && (section <= Tube::LAST_SINUS_SECTION)) ||
+    (options.lumpedElements == false))
+  {
+    for (i=0; i < numFreq; i++)
+    {
+      S = getSectionMatrix(limitedOmega[i], section);
+      M.reA[i] = S.A.real();  M.imA[i] = S.A.imag();
+      M.reB[i] = S.B.real();  M.imB[i] = S.B.imag();
+      M.reC[i] = S.C.real();  M.imC[i] = S.C.imag();
+      M.reD[i] = S.D.real();  M.imD[i] = S.D.imag();
+    }
+    return;
+  }
+
+  // ****************************************************************
+  // Lumped elements (see getLumpedSectionImpedances()). With the 
+  // series impedance Za and the parallel admittance Y = 1/Zb, the
+  // matrix elements are A = D = 1 + Za*Y, B = Za*(Za*Y + 2), C = Y.
+  // ****************************************************************
+
+  Tube::Section *ts = tube.section[section];
+
+  double area = ts->area_cm2;
+  if (area < MIN_AREA_CM2)  
+  { 
+    area = MIN_AREA_CM2; 
+  }
+  
+  double circ = getCircumference(area);
+  double length = ts->length_cm;
+
+  // Frequency-independent factors of the elements
+  double Rs = options.boundaryLayer ? RS_FACTOR*(0.5*length*circ) / (area*area) : 0.0;
+  double Ls = LS_FACTOR*(0.5*length) / (area);
+  double Cp = CP_FACTOR*length*area;
+  double Gp = options.heatConduction ? GP_FACTOR*length*circ : 0.0;
+  double Rf = options.hagenResistance ? (4.0*AIR_VISCOSITY_CGS*length*M_PI) / (area*area) : 0.0;
+
+  double wallR = ts->wallResistance_cgs;
+  double wallM = ts->wallMass_cgs;
+  double wallK = ts->wallStiffness_cgs;
+  double wallFactor = options.softWalls ? length*circ : 0.0;
+
+  double omega, reZa, imZa, reY, imY, x, reZaY, imZaY;
+
+  for (i=0; i < numFreq; i++)
+  {
+    omega = limitedOmega[i];
+
+    reZa = Rs*sqrtLimitedOmega[i] + Rf;
+    imZa = omega*Ls;
+
+    // Admittance of the walls = length*circ / (R + j(omega*M - K/omega))
+    x = omega*wallM - wallK / omega;
+    reY = wallFactor*wallR / (wallR*wallR + x*x);
+    imY = -wallFactor*x / (wallR*wallR + x*x);
+
+    reY+= Gp*sqrtLimitedOmega[i];
+    imY+= omega*Cp;
+
+    reZaY = reZa*reY - imZa*imY;
+    imZaY = reZa*imY + imZa*reY;
+
+    M.reA[i] = M.reD[i] = 1.0 + reZaY;
+    M.imA[i] = M.imD[i] = imZaY;
+    M.reB[i] = reZa*(reZaY + 2.0) - imZa*imZaY;
+    M.imB[i] = reZa*imZaY + imZa*(reZaY + 2.0);
+    M.reC[i] = reY;
+    M.imC[i] = imY;
+  }
+}
+
+
+// ****************************************************************************
+/// Sets the matrices for all discrete frequencies to the unit matrix.
+// ****************************************************************************
+
+void TlModel::setUnitMatrices(MatrixArray &K)
+{
+  int i;
+
+  for (i=0; i < numFreq; i++)
+  {
+    K.reA[i] = 1.0;  K.imA[i] = 0.0;
+    K.reB[i] = 0.0;  K.imB[i] = 0.0;
+    K.reC[i] = 0.0;  K.imC[i] = 0.0;
+    K.reD[i] = 1.0;  K.imD[i] = 0.0;
+  }
+}
+
+
+// ****************************************************************************
+/// Multiplies the matrices K from the right with the matrices M (K = K*M) 
+/// for all discrete frequencies.
+// ****************************************************************************
+
+void TlModel::multiplyMatrices(MatrixArray &K, const MatrixArray &M)
+{
+  int i;
+  double reA, imA, reB, imB, reC, imC, reD, imD;
+
+  for (i=0; i < numFreq; i++)
+  {
+    reA = K.reA[i]*M.reA[i] - K.imA[i]*M.imA[i] + K.reB[i]*M.reC[i] - K.imB[i]*M.imC[i];
+    imA = K.reA[i]*M.imA[i] + K.imA[i]*M.reA[i] + K.reB[i]*M.imC[i] + K.imB[i]*M.reC[i];
+    reB = K.reA[i]*M.reB[i] - K.imA[i]*M.imB[i] + K.reB[i]*M.reD[i] - K.imB[i]*M.imD[i];
+    imB = K.reA[i]*M.imB[i] + K.imA[i]*M.reB[i] + K.reB[i]*M.imD[i] + K.imB[i]*M.reD[i];
+    reC = K.reC[i]*M.reA[i] - K.imC[i]*M.imA[i] + K.reD[i]*M.reC[i] - K.imD[i]*M.imC[i];
+    imC = K.reC[i]*M.imA[i] + K.imC[i]*M.reA[i] + K.reD[i]*M.imC[i] + K.imD[i]*M.reC[i];
+    reD = K.reC[i]*M.reB[i] - K.imC[i]*M.imB[i] + K.reD[i]*M.reD[i] - K.imD[i]*M.imD[i];
+    imD = K.reC[i]*M.imB[i] + K.imC[i]*M.reB[i] + K.reD[i]*M.imD[i] + K.imD[i]*M.reD[i];
+
+    K.reA[i] = reA;  K.imA[i] = imA;
+    K.reB[i] = reB;  K.imB[i] = imB;
+    K.reC[i] = reC;  K.imC[i] = imC;
+    K.reD[i] = reD;  K.imD[i] = imD;
+  }
+}
+
+
+// ****************************************************************************
+/// Multiplies the matrices K from the right with the matrices of a series
+/// impedance Z = R + j*omega*L, i.e. K = K*(1 Z 0 1), for all discrete 
+/// frequencies.
+// ****************************************************************************
+
+void TlModel::multiplySeriesElement(MatrixArray &K, double R, double L)
+{
+  int i;
+  double X;
+
+  for (i=0; i < numFreq; i++)
+  {
+    X = discreteOmega[i]*L;
+    K.reB[i]+= K.reA[i]*R - K.imA[i]*X;
+    K.imB[i]+= K.reA[i]*X + K.imA[i]*R;
+    K.reD[i]+= K.reC[i]*R - K.imC[i]*X;
+    K.imD[i]+= K.reC[i]*X + K.imC[i]*R;
+  }
+}
+
+
+// ****************************************************************************
+/// Multiplies the matrices K from the right with the matrices of a parallel
+/// admittance Y, i.e. K = K*(1 0 Y 1), for all discrete frequencies.
+/// \param reY Real parts of the admittance for all frequencies
+/// \param imY Imaginary parts of the admittance for all frequencies
+// ****************************************************************************
+
+void TlModel::multiplyParallelElement(MatrixArray &K, const double *reY, const double *imY)
+{
+  int i;
+
+  for (i=0; i < numFreq; i++)
+  {
+    K.reA[i]+= K.reB[i]*reY[i] - K.imB[i]*imY[i];
+    K.imA[i]+= K.reB[i]*imY[i] + K.imB[i]*reY[i];
+    K.reC[i]+= K.reD[i]*reY[i] - K.imD[i]*imY[i];
+    K.imC[i]+= K.reD[i]*imY[i] + K.imD[i]*reY[i];
+  }
+}
+
+
+// ****************************************************************************
+/// Stores the matrices K for all discrete frequencies as the matrix products
+/// of the given tube section.
+// ****************************************************************************
+
+void TlModel::storeMatrixProducts(const MatrixArray &K, int section)
+{
+  int i;
+  Matrix2x2 *P = matrixProduct[section];
+
+  for (i=0; i < numFreq; i++)
+  {
+    P[i].A = ComplexValue(K.reA[i], K.imA[i]);
+    P[i].B = ComplexValue(K.reB[i], K.imB[i]);
+    P[i].C = ComplexValue(K.reC[i], K.imC[i]);
+    P[i].D = ComplexValue(K.reD[i], K.imD[i]);
+  }
+}
+
+
 // ****************************************************************************
 /// Calculates the junction impedance between two adjacent tube sections with
 /// the given areas according to SONDHI (1983).
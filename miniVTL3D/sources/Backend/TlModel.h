@@ -89,8 +89,11 @@ public:
   int getMostConstrictedSection();
   double getMeanFlow(double lungPressure_dPa);
   void setLungPressure(double lungPressure_dPa);
+  double getLungPressure() { return lungPressure_dPa; }
   void getFormants(double *formantFreq, double *formantBW, int &numFormants, 
     const int MAX_FORMANTS, bool &frictionNoise, bool &isClosure, bool &isNasal);
+  void getFormantsFast(double *formantFreq, double *formantBW, int &numFormants, 
+    const int MAX_FORMANTS, bool &frictionNoise, bool &isClosure, bool &isNasal);
 
   static double getCircumference(double area);
 
@@ -111,6 +114,25 @@ private:
   /// The product of the tube section matrices within a branch.
   Matrix2x2 matrixProduct[Tube::NUM_SECTIONS][MAX_NUM_FREQ];
 
+  /// 2x2 matrices for all discrete frequencies, with the real and imaginary
+  /// parts of each element in a separate array (structure of arrays), so 
+  /// that the loops over the frequencies can be vectorized.
+  struct MatrixArray
+  {
+    double reA[MAX_NUM_FREQ], imA[MAX_NUM_FREQ];
+    double reB[MAX_NUM_FREQ], imB[MAX_NUM_FREQ];
+    double reC[MAX_NUM_FREQ], imC[MAX_NUM_FREQ];
+    double reD[MAX_NUM_FREQ], imD[MAX_NUM_FREQ];
+  };
+
+  // Work data of prepareCalculations()
+  MatrixArray sectionMatrices;    ///< Matrices of a single tube section
+  MatrixArray productMatrices;    ///< Running product of the matrices in a branch
+  double limitedOmega[MAX_NUM_FREQ];      ///< Angular frequencies >= MIN_FREQ_RAD
+  double sqrtLimitedOmega[MAX_NUM_FREQ];
+  double reFossaAdmittance[MAX_NUM_FREQ], imFossaAdmittance[MAX_NUM_FREQ];
+  double reSinusAdmittance[MAX_NUM_FREQ], imSinusAdmittance[MAX_NUM_FREQ];
+
   bool resetCalculations;   ///< Must the calculations be reset, because some parameter has changed
   double f0;                ///< Current frequency resolution
   int numFreq;
@@ -129,11 +151,21 @@ private:
 
 private:
   void prepareCalculations();
+  void calcMatrixProducts();
+  void getFlowSourceMagnitudes(const double *freq_Hz, int numValues, double *magnitude);
+  void getTubeConditions(const double *formantFreq, const double *formantAmp, 
+    int numFormants, bool &frictionNoise, bool &isClosure, bool &isNasal);
 
   ComplexValue getRadiationCharacteristic(double omega);
   ComplexValue getRadiationImpedance(double omega, double radiationArea_cm2);
   void getLumpedSectionImpedances(double omega, Tube::Section *ts, ComplexValue &Za, ComplexValue &Zb);
   Matrix2x2 getSectionMatrix(double omega, int section);
+  void getSectionMatrices(int section, MatrixArray &M);
+  void setUnitMatrices(MatrixArray &K);
+  void multiplyMatrices(MatrixArray &K, const MatrixArray &M);
+  void multiplySeriesElement(MatrixArray &K, double R, double L);
+  void multiplyParallelElement(MatrixArray &K, const double *reY, const double *imY);
+  void storeMatrixProducts(const MatrixArray &K, int section);
   ComplexValue getJunctionImpedance(double omega, double A1_cm2, double A2_cm2);
 
   ComplexValue getInputImpedance(int freqIndex, int section);
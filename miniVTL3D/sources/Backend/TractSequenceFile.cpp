@@ -0,0 +1,448 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#include "TractSequenceFile.h"
+#include "VocalTract.h"
+#include "Tube.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+// magic number at the beginning of the binary sequence files
+static const char SEQUENCE_MAGIC[8] = { 'V', 'T', 'L', 'S', 'E', 'Q', 'B', 'N' };
+
+static const int GLOTTIS_NAME_LENGTH = 32;
+
+// number of comment lines at the beginning of the text files
+static const int NUM_TRACT_COMMENT_LINES = 6;
+static const int NUM_TUBE_COMMENT_LINES = 10;
+
+static const char* TRACT_COMMENT_LINES[NUM_TRACT_COMMENT_LINES] =
+{
+  "# The first two lines (below the comment lines) indicate the name of the vocal fold model and the number of states.",
+  "# The following lines contain the control parameters of the vocal folds and the vocal tract (states)",
+  "# in steps of 110 audio samples (corresponding to about 2.5 ms for the sampling rate of 44100 Hz).",
+  "# For every step, there is one line with the vocal fold parameters followed by",
+  "# one line with the vocal tract parameters.",
+  "# "
+};
+
+static const char* TUBE_COMMENT_LINES[NUM_TUBE_COMMENT_LINES] =
+{
+  "# The first two lines (below the comment lines) indicate the name of the vocal fold model and the number of states.",
+  "# The following lines contain a sequence of states of the vocal folds and the tube geometry",
+  "# in steps of 110 audio samples (corresponding to about 2.5 ms for the sampling rate of 44100 Hz).",
+  "# Each state is represented in terms of five lines:",
+  "# Line 1: glottis_param_0 glottis_param_1 ...",
+  "# Line 2: incisor_position_in_cm, velo_pharyngeal_opening_in_cm^2, tongue_tip_side_elevation[-1...1]",
+  "# Line 3: area0 area1 area2 area3 ... (areas of the tube sections in cm^2 from glottis to mouth)",
+  "# Line 4: length0 length1 length2 length3 ... (lengths of the tube sections in cm from glottis to mouth)",
+  "# Line 5: artic0 artic1 artic2 artic3 ... (articulators of the tube sections: 1 = tongue; 2 = lower incisors; 3 = lower lip; 4 = other)",
+  "# "
+};
+
+// ****************************************************************************
+// Number of values of each text line of the vocal tract or tube of a state
+
+static vector<int> stateLineValues(sequenceType type)
+{
+  if (type == TRACT_SEQUENCE)
+  {
+    return vector<int>(1, VocalTract::NUM_PARAMS);
+  }
+  vector<int> lines(4, Tube::NUM_PHARYNX_MOUTH_SECTIONS);
+  lines[0] = 3;
+  return lines;
+}
+
+// ****************************************************************************
+// Parses numValues space separated numbers of a line, and returns the number
+// of values found if numValues is 0.
+
+static int parseValues(const string& line, int numValues, double* values)
+{
+  const char* str = line.c_str();
+  char* end;
+  int i;
+
+  for (i = 0; (numValues == 0) || (i < numValues); i++)
+  {
+    double value = strtod(str, &end);
+    if (end == str) { break; }
+    if (numValues > 0) { values[i] = value; }
+    str = end;
+  }
+
+  return i;
+}
+
+// ****************************************************************************
+
+static void removeCarriageReturn(string& line)
+{
+  if (!line.empty() && (line.back() == '\r')) { line.pop_back(); }
+}
+
+// ****************************************************************************
+
+int sequenceStateValues(sequenceType type)
+{
+  return (type == TRACT_SEQUENCE) ? VocalTract::NUM_PARAMS :
+    3 + 3 * Tube::NUM_PHARYNX_MOUTH_SECTIONS;
+}
+
+// ****************************************************************************
+
+bool isBinarySequenceFile(const string& fileName)
+{
+  ifstream ifs(fileName, ios::binary);
+  char magic[8];
+  ifs.read(magic, 8);
+  return ifs && equal(magic, magic + 8, SEQUENCE_MAGIC);
+}
+
+// ****************************************************************************
+// Reader
+// ****************************************************************************
+
+SequenceFileReader::SequenceFileReader() :
+  m_type(TRACT_SEQUENCE),
+  m_binaryFile(NULL),
+  m_lineRead(false),
+  m_numStates(0),
+  m_numGlottisParams(0),
+  m_numStateValues(0)
+{
+}
+
+// ****************************************************************************
+
+SequenceFileReader::~SequenceFileReader()
+{
+  close();
+}
+
+// ****************************************************************************
+
+bool SequenceFileReader::open(const string& fileName, sequenceType type,
+  int numGlottisParams, string& error)
+{
+  close();
+  m_type = type;
+  m_numStateValues = sequenceStateValues(type);
+
+  if (isBinarySequenceFile(fileName))
+  {
+    m_binaryFile = fopen(fileName.c_str(), "rb");
+    if (m_binaryFile == NULL)
+    {
+      error = "File could not be opened.";
+      return false;
+    }
+    // read the states by large blocks
+    setvbuf(m_binaryFile, NULL, _IOFBF, 1 << 16);
+
+    char magic[8];
+    int32_t version;
+    uint32_t fileType;
+    char name[GLOTTIS_NAME_LENGTH + 1] = { 0 };
+    uint32_t sizes[4];
+    if ((fread(magic, 1, 8, m_binaryFile) != 8) ||
+      (fread(&version, sizeof(version), 1, m_binaryFile) != 1) ||
+      (fread(&fileType, sizeof(fileType), 1, m_binaryFile) != 1) ||
+      (fread(name, 1, GLOTTIS_NAME_LENGTH, m_binaryFile) != GLOTTIS_NAME_LENGTH) ||
+      (fread(sizes, sizeof(uint32_t), 4, m_binaryFile) != 4))
+    {
+      error = "The header of the binary sequence file is truncated.";
+      close();
+      return false;
+    }
+    if (version != SEQUENCE_FILE_VERSION)
+    {
+      error = "Unsupported version of the binary sequence file.";
+      close();
+      return false;
+    }
+    if ((fileType != (uint32_t)type) || (sizes[1] != (uint32_t)m_numStateValues))
+    {
+      error = (type == TRACT_SEQUENCE) ? "The file is not a tract sequence file." :
+        "The file is not a tube sequence file.";
+      close();
+      return false;
+    }
+    if ((numGlottisParams > 0) && (sizes[0] != (uint32_t)numGlottisParams))
+    {
+      error = "The number of glottis parameters does not correspond to the glottis model.";
+      close();
+      return false;
+    }
+
+    m_glottisName = name;
+    m_numGlottisParams = (int)sizes[0];
+    m_numStates = (int)sizes[2];
+    m_buffer.resize(m_numGlottisParams + m_numStateValues);
+    return true;
+  }
+
+  // ****************************************************************
+  // Text file: read the comment lines, the type of the glottis 
+  // model, and the number of states.
+  // ****************************************************************
+
+  m_textFile.open(fileName);
+  if (!m_textFile.is_open())
+  {
+    error = "File could not be opened.";
+    return false;
+  }
+
+  int numCommentLines = (type == TRACT_SEQUENCE) ?
+    NUM_TRACT_COMMENT_LINES : NUM_TUBE_COMMENT_LINES;
+  string line;
+  for (int i(0); i < numCommentLines; i++)
+  {
+    getline(m_textFile, line);
+  }
+
+  getline(m_textFile, m_glottisName);
+  removeCarriageReturn(m_glottisName);
+
+  double numStates;
+  getline(m_textFile, line);
+  if (parseValues(line, 1, &numStates) != 1)
+  {
+    error = "Invalid number of states.";
+    close();
+    return false;
+  }
+  m_numStates = (int)numStates;
+
+  m_numGlottisParams = numGlottisParams;
+  if ((m_numGlottisParams <= 0) && (m_numStates > 0))
+  {
+    getline(m_textFile, m_line);
+    m_lineRead = true;
+    m_numGlottisParams = parseValues(m_line, 0, NULL);
+  }
+
+  return true;
+}
+
+// ****************************************************************************
+
+void SequenceFileReader::close()
+{
+  if (m_binaryFile != NULL)
+  {
+    fclose(m_binaryFile);
+    m_binaryFile = NULL;
+  }
+  if (m_textFile.is_open())
+  {
+    m_textFile.close();
+  }
+  m_textFile.clear();
+  m_lineRead = false;
+  m_numStates = 0;
+}
+
+// ****************************************************************************
+
+bool SequenceFileReader::readTextLine(int numValues, double* values)
+{
+  if (!m_lineRead)
+  {
+    if (!getline(m_textFile, m_line)) { return false; }
+  }
+  m_lineRead = false;
+  return parseValues(m_line, numValues, values) == numValues;
+}
+
+// ****************************************************************************
+
+bool SequenceFileReader::readState(double* glottisParams, double* values)
+{
+  if (m_binaryFile != NULL)
+  {
+    if (fread(m_buffer.data(), sizeof(double), m_buffer.size(), m_binaryFile) !=
+      m_buffer.size())
+    {
+      return false;
+    }
+    copy(m_buffer.begin(), m_buffer.begin() + m_numGlottisParams, glottisParams);
+    copy(m_buffer.begin() + m_numGlottisParams, m_buffer.end(), values);
+    return true;
+  }
+
+  if (!readTextLine(m_numGlottisParams, glottisParams)) { return false; }
+
+  vector<int> lines(stateLineValues(m_type));
+  for (int i(0); i < (int)lines.size(); i++)
+  {
+    if (!readTextLine(lines[i], values)) { return false; }
+    values += lines[i];
+  }
+  return true;
+}
+
+// ****************************************************************************
+// Writer
+// ****************************************************************************
+
+SequenceFileWriter::SequenceFileWriter() :
+  m_type(TRACT_SEQUENCE),
+  m_binary(false),
+  m_numGlottisParams(0),
+  m_numStateValues(0)
+{
+}
+
+// ****************************************************************************
+
+SequenceFileWriter::~SequenceFileWriter()
+{
+  close();
+}
+
+// ****************************************************************************
+
+bool SequenceFileWriter::open(const string& fileName, sequenceType type, 
+  bool binary, const string& glottisName, int numGlottisParams, int numStates)
+{
+  m_type = type;
+  m_binary = binary;
+  m_numGlottisParams = numGlottisParams;
+  m_numStateValues = sequenceStateValues(type);
+
+  if (binary)
+  {
+    m_file.open(fileName, ios::binary | ios::trunc);
+    if (!m_file.is_open()) { return false; }
+
+    int32_t version(SEQUENCE_FILE_VERSION);
+    uint32_t fileType((uint32_t)type);
+    char name[GLOTTIS_NAME_LENGTH] = { 0 };
+    strncpy(name, glottisName.c_str(), GLOTTIS_NAME_LENGTH - 1);
+    uint32_t sizes[4] = { (uint32_t)numGlottisParams, (uint32_t)m_numStateValues,
+      (uint32_t)numStates, 0 };
+    m_file.write(SEQUENCE_MAGIC, 8);
+    m_file.write((const char*)&version, sizeof(version));
+    m_file.write((const char*)&fileType, sizeof(fileType));
+    m_file.write(name, GLOTTIS_NAME_LENGTH);
+    m_file.write((const char*)sizes, sizeof(sizes));
+  }
+  else
+  {
+    m_file.open(fileName, ios::trunc);
+    if (!m_file.is_open()) { return false; }
+
+    int numCommentLines = (type == TRACT_SEQUENCE) ?
+      NUM_TRACT_COMMENT_LINES : NUM_TUBE_COMMENT_LINES;
+    const char** commentLines = (type == TRACT_SEQUENCE) ?
+      TRACT_COMMENT_LINES : TUBE_COMMENT_LINES;
+    for (int i(0); i < numCommentLines; i++)
+    {
+      m_file << commentLines[i] << "\n";
+    }
+    m_file << glottisName << "\n" << numStates << "\n";
+  }
+
+  return !m_file.fail();
+}
+
+// ****************************************************************************
+
+bool SequenceFileWriter::writeState(const double* glottisParams, const double* values)
+{
+  if (m_binary)
+  {
+    m_file.write((const char*)glottisParams, m_numGlottisParams * sizeof(double));
+    m_file.write((const char*)values, m_numStateValues * sizeof(double));
+    return !m_file.fail();
+  }
+
+  char number[32];
+  vector<int> lines(1, m_numGlottisParams);
+  vector<int> stateLines(stateLineValues(m_type));
+  lines.insert(lines.end(), stateLines.begin(), stateLines.end());
+
+  for (int i(0); i < (int)lines.size(); i++)
+  {
+    const double* lineValues = (i == 0) ? glottisParams : values;
+    for (int j(0); j < lines[i]; j++)
+    {
+      snprintf(number, sizeof(number), "%.10g ", lineValues[j]);
+      m_file << number;
+    }
+    m_file << "\n";
+    if (i > 0) { values += lines[i]; }
+  }
+
+  return !m_file.fail();
+}
+
+// ****************************************************************************
+
+bool SequenceFileWriter::close()
+{
+  if (!m_file.is_open()) { return true; }
+  m_file.close();
+  bool ok = !m_file.fail();
+  m_file.clear();
+  return ok;
+}
+
+// ****************************************************************************
+// Converts a sequence file of either format into the binary or text format
+
+bool convertSequenceFile(const string& inputFileName, const string& outputFileName,
+  sequenceType type, bool binaryOutput, string& error)
+{
+  SequenceFileReader reader;
+  if (!reader.open(inputFileName, type, 0, error)) { return false; }
+
+  SequenceFileWriter writer;
+  if (!writer.open(outputFileName, type, binaryOutput, reader.glottisName(),
+    reader.numGlottisParams(), reader.numStates()))
+  {
+    error = "The output file could not be opened.";
+    return false;
+  }
+
+  vector<double> glottisParams(max(reader.numGlottisParams(), 1));
+  vector<double> values(reader.numStateValues());
+  for (int i(0); i < reader.numStates(); i++)
+  {
+    if (!reader.readState(glottisParams.data(), values.data()))
+    {
+      error = "The sequence file was corrupted.";
+      return false;
+    }
+    writer.writeState(glottisParams.data(), values.data());
+  }
+
+  if (!writer.close())
+  {
+    error = "The output file could not be written.";
+    return false;
+  }
+  return true;
+}
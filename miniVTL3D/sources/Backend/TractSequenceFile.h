@@ -0,0 +1,158 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#ifndef __TRACT_SEQUENCE_FILE_H__
+#define __TRACT_SEQUENCE_FILE_H__
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdio>
+#include <cstdint>
+
+using namespace std;
+
+// version of the binary sequence format, to increment when the layout of 
+// the files changes
+const int SEQUENCE_FILE_VERSION = 1;
+
+// ****************************************************************************
+// Tract and tube sequence files: a sequence of states of the glottis and of
+// the vocal tract (tract sequence) or of the tube (tube sequence), every
+// Synthesizer::NUM_CHUNCK_SAMPLES samples.
+//
+// In the text format, each state is made of one line of glottis parameters
+// followed by one line of vocal tract parameters, or by four lines for the 
+// tube (incisor position, velum opening and tongue tip side elevation; 
+// areas; lengths; articulators of the sections).
+//
+// The binary format contains the same values as doubles in native (little 
+// endian) byte order, so that the states are read without any parsing:
+//
+//   char[8]   magic "VTLSEQBN"
+//   int32     version
+//   uint32    type (0: tract sequence, 1: tube sequence)
+//   char[32]  name of the glottis model (zero padded)
+//   uint32    number of glottis parameters G
+//   uint32    number of values V of the vocal tract or tube per state
+//   uint32    number of states S
+//   uint32    unused (0)
+//   double    states [S*(G + V)], each made of the G glottis parameters 
+//             followed by the V values in the order of the text lines
+//
+// The readers read the files state by state, so that long sequences are 
+// not loaded in memory.
+// ****************************************************************************
+
+enum sequenceType
+{
+  TRACT_SEQUENCE,
+  TUBE_SEQUENCE
+};
+
+// number of values of the vocal tract or the tube in a state
+int sequenceStateValues(sequenceType type);
+
+// true if the file starts with the magic number of the binary format
+bool isBinarySequenceFile(const string& fileName);
+
+// ****************************************************************************
+// Reads a tract or tube sequence file of either format state by state
+// ****************************************************************************
+
+class SequenceFileReader
+{
+public:
+
+  SequenceFileReader();
+  ~SequenceFileReader();
+
+  // numGlottisParams: number of glottis parameters of a state, or 0 to 
+  // take it from the file (from the first state for the text format)
+  bool open(const string& fileName, sequenceType type, int numGlottisParams,
+    string& error);
+  void close();
+
+  bool isBinary() const { return m_binaryFile != NULL; }
+  const string& glottisName() const { return m_glottisName; }
+  int numStates() const { return m_numStates; }
+  int numGlottisParams() const { return m_numGlottisParams; }
+  int numStateValues() const { return m_numStateValues; }
+
+  // reads the next state, returns false at the end of the file or if the
+  // state is corrupted
+  bool readState(double* glottisParams, double* values);
+
+private:
+
+  SequenceFileReader(const SequenceFileReader&);
+  SequenceFileReader& operator=(const SequenceFileReader&);
+
+  bool readTextLine(int numValues, double* values);
+
+  sequenceType m_type;
+  FILE* m_binaryFile;
+  ifstream m_textFile;
+  // line read in advance to count the glottis parameters
+  string m_line;
+  bool m_lineRead;
+  vector<double> m_buffer;
+
+  string m_glottisName;
+  int m_numStates;
+  int m_numGlottisParams;
+  int m_numStateValues;
+};
+
+// ****************************************************************************
+// Writes a tract or tube sequence file state by state
+// ****************************************************************************
+
+class SequenceFileWriter
+{
+public:
+
+  SequenceFileWriter();
+  ~SequenceFileWriter();
+
+  bool open(const string& fileName, sequenceType type, bool binary,
+    const string& glottisName, int numGlottisParams, int numStates);
+  bool writeState(const double* glottisParams, const double* values);
+  // returns false if a write failed
+  bool close();
+
+private:
+
+  SequenceFileWriter(const SequenceFileWriter&);
+  SequenceFileWriter& operator=(const SequenceFileWriter&);
+
+  sequenceType m_type;
+  bool m_binary;
+  ofstream m_file;
+  int m_numGlottisParams;
+  int m_numStateValues;
+};
+
+// Converts a sequence file of either format into the binary or text format
+bool convertSequenceFile(const string& inputFileName, const string& outputFileName,
+  sequenceType type, bool binaryOutput, string& error);
+
+#endif
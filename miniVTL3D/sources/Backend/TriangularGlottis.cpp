@@ -123,6 +123,9 @@ TriangularGlottis::TriangularGlottis()
 
   shape.push_back(s);
 
+  // Force the first calculation of the tension and geometry.
+  tensionGeometry.f0 = -1.0;
+
   // ****************************************************************
   // Stop the motion and calculate the geometry.
   // ****************************************************************
@@ -392,9 +395,10 @@ void TriangularGlottis::calcGeometry()
   // ****************************************************************
   // ****************************************************************
 
-  double Q = getTensionParameter( controlParam[FREQUENCY].x );
-  double cordLength;
-  double thickness[2];
+  updateTensionGeometry();
+  double Q = tensionGeometry.Q;
+  double cordLength = tensionGeometry.cordLength;
+  double *thickness = tensionGeometry.thickness;
   double area[2];
   double openLength[2];
   double contactLength[2];
@@ -402,7 +406,6 @@ void TriangularGlottis::calcGeometry()
   double meanContactZ[2];
   double contactArea;
 
-  getLengthAndThickness(Q, cordLength, thickness);
   getOpenCloseDimensions(openLength, contactLength, meanOpenWidth, meanContactZ);
   area[0] = openLength[0]*meanOpenWidth[0] + chinkArea;
   area[1] = openLength[1]*meanOpenWidth[1] + chinkArea;
@@ -497,6 +500,37 @@ void TriangularGlottis::getLengthAndThickness(const double Q, double &length_cm,
   thickness[1] = staticParam[REST_THICKNESS_2].x / factor;
 }
 
+// ****************************************************************************
+/// Recalculates the tension parameter, length and thickness for the f0 
+/// control parameter, when this or one of the involved static parameters 
+/// has changed since the last call.
+// ****************************************************************************
+
+void TriangularGlottis::updateTensionGeometry()
+{
+  TensionGeometry &g = tensionGeometry;
+  
+  if ((g.f0 == controlParam[FREQUENCY].x) && 
+    (g.naturalF0 == staticParam[NATURAL_F0].x) && 
+    (g.f0DivQ == staticParam[F0_DIV_Q].x) && 
+    (g.restLength == staticParam[REST_LENGTH].x) &&
+    (g.restThickness[0] == staticParam[REST_THICKNESS_1].x) && 
+    (g.restThickness[1] == staticParam[REST_THICKNESS_2].x))
+  {
+    return;
+  }
+
+  g.f0 = controlParam[FREQUENCY].x;
+  g.naturalF0 = staticParam[NATURAL_F0].x;
+  g.f0DivQ = staticParam[F0_DIV_Q].x;
+  g.restLength = staticParam[REST_LENGTH].x;
+  g.restThickness[0] = staticParam[REST_THICKNESS_1].x;
+  g.restThickness[1] = staticParam[REST_THICKNESS_2].x;
+
+  g.Q = getTensionParameter(g.f0);
+  getLengthAndThickness(g.Q, g.cordLength, g.thickness);
+}
+
 // ****************************************************************************
 /// Returns some measures of the triangular glottis.
 // ****************************************************************************
@@ -505,12 +539,10 @@ void TriangularGlottis::getOpenCloseDimensions(double openLength[], double conta
   double meanOpenWidth[], double meanContactZ[])
 {
   int i;
-  double Q = getTensionParameter( controlParam[FREQUENCY].x );
-  double cordLength;
-  double thickness[2];
 
-  // Get the current length and thickness of the masses.
-  getLengthAndThickness(Q, cordLength, thickness);
+  // Get the current length of the vocal folds.
+  updateTensionGeometry();
+  double cordLength = tensionGeometry.cordLength;
 
   // Absolute displacements the the frontal and dorsal ends.
   double restX[2];
@@ -623,6 +655,13 @@ double TriangularGlottis::getContactArea(double backX[], double frontX[], double
   double area = 0.0;
   double denom;
 
+  // Without a negative displacement, the vocal folds are not in contact.
+
+  if ((backX[0] > 0.0) && (backX[1] > 0.0) && (frontX[0] > 0.0) && (frontX[1] > 0.0))
+  {
+    return 0.0;
+  }
+
   // Run through several thin slices in vertical direction.
 
   for (i=0; i < NUM_SLICES; i++)
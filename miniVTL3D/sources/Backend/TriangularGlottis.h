@@ -115,11 +115,28 @@ public:
     double meanOpenWidth[], double meanContactZ[]);
   double getContactArea(double backX[], double frontX[], double length, double thickness);
 
+  // **************************************************************************
+  // Private functions.
+  // **************************************************************************
+
+private:
+  void updateTensionGeometry();
+
   // **************************************************************************
   // Private data.
   // **************************************************************************
 
 private:
+  /// Tension, length and thickness for the f0 control parameter (without 
+  /// flutter). They only change at the control rate and are recalculated 
+  /// when one of the parameters they were calculated from has changed.
+  struct TensionGeometry
+  {
+    double f0, naturalF0, f0DivQ, restLength, restThickness[2];
+    double Q, cordLength, thickness[2];
+  };
+  TensionGeometry tensionGeometry;
+
   static const int BUFFER_LENGTH = 4;
   static const int BUFFER_MASK = 3;
 
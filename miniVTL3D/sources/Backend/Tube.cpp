@@ -416,7 +416,8 @@ void Tube::setGlottisGeometry(const double *length_cm, const double *area_cm2)
     pos_cm+= ts->length_cm;
   }
 
-  calcPositions();
+  // Only the positions below the glottis depend on the glottis sections.
+  calcSubglottalPositions();
 }
 
 
@@ -625,27 +626,11 @@ void Tube::calcPositions()
   double pos;
   const double REFERENCE_POS = 0.0;
 
-  pos = REFERENCE_POS;
-
-  // ****************************************************************
-  // The two glottal tube sections.
-  // ****************************************************************
-
-  pos-= glottisSection[1].length_cm;
-  glottisSection[1].pos_cm = pos;
-
-  pos-= glottisSection[0].length_cm;
-  glottisSection[0].pos_cm = pos;
-
   // ****************************************************************
-  // Trachea sections.
+  // The glottal and trachea sections.
   // ****************************************************************
 
-  for (i = NUM_TRACHEA_SECTIONS-1; i >= 0; i--)
-  {
-    pos-= tracheaSection[i].length_cm;
-    tracheaSection[i].pos_cm = pos;
-  }
+  calcSubglottalPositions();
 
   // ****************************************************************
   // Pharynx and mouth segments.
@@ -696,6 +681,35 @@ void Tube::calcPositions()
 
 }
 
+
+// ****************************************************************************
+/// Calculates the positions of the glottal and trachea sections, which are
+/// counted backwards from the lower end of the pharynx.
+// ****************************************************************************
+
+void Tube::calcSubglottalPositions()
+{
+  int i;
+  const double REFERENCE_POS = 0.0;
+  double pos = REFERENCE_POS;
+
+  // The two glottal tube sections.
+
+  pos-= glottisSection[1].length_cm;
+  glottisSection[1].pos_cm = pos;
+
+  pos-= glottisSection[0].length_cm;
+  glottisSection[0].pos_cm = pos;
+
+  // Trachea sections.
+
+  for (i = NUM_TRACHEA_SECTIONS-1; i >= 0; i--)
+  {
+    pos-= tracheaSection[i].length_cm;
+    tracheaSection[i].pos_cm = pos;
+  }
+}
+
 // ****************************************************************************
 // ****************************************************************************
 
@@ -185,6 +185,7 @@ private:
 
 private:
   void createSectionList();
+  void calcSubglottalPositions();
 
 };
 
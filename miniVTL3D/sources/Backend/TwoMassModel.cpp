@@ -127,6 +127,9 @@ TwoMassModel::TwoMassModel()
 
   shape.push_back(s);
 
+  // Force the first calculation of the tension and geometry.
+  tensionGeometry.f0 = -1.0;
+
   // ****************************************************************
   // Stop the motion and calculate the geometry.
   // ****************************************************************
@@ -428,11 +431,10 @@ void TwoMassModel::calcGeometry()
   // ****************************************************************
   // ****************************************************************
 
-  double Q = getTensionParameter( controlParam[FREQUENCY].x );
-  double cordLength;
-  double thickness[2];
-
-  getLengthAndThickness(Q, cordLength, thickness);
+  updateTensionGeometry();
+  double Q = tensionGeometry.Q;
+  double cordLength = tensionGeometry.cordLength;
+  double *thickness = tensionGeometry.thickness;
 
   double area[2];
   area[0] = 2.0*cordLength*absX[0] + chinkArea;
@@ -524,3 +526,34 @@ void TwoMassModel::getLengthAndThickness(const double Q, double &length_cm, doub
 }
 
 // ****************************************************************************
+/// Recalculates the tension parameter, length and thickness for the f0 
+/// control parameter, when this or one of the involved static parameters 
+/// has changed since the last call.
+// ****************************************************************************
+
+void TwoMassModel::updateTensionGeometry()
+{
+  TensionGeometry &g = tensionGeometry;
+  
+  if ((g.f0 == controlParam[FREQUENCY].x) && 
+    (g.naturalF0 == staticParam[NATURAL_F0].x) && 
+    (g.f0DivQ == staticParam[F0_DIV_Q].x) && 
+    (g.restLength == staticParam[REST_LENGTH].x) &&
+    (g.restThickness[0] == staticParam[REST_THICKNESS_1].x) && 
+    (g.restThickness[1] == staticParam[REST_THICKNESS_2].x))
+  {
+    return;
+  }
+
+  g.f0 = controlParam[FREQUENCY].x;
+  g.naturalF0 = staticParam[NATURAL_F0].x;
+  g.f0DivQ = staticParam[F0_DIV_Q].x;
+  g.restLength = staticParam[REST_LENGTH].x;
+  g.restThickness[0] = staticParam[REST_THICKNESS_1].x;
+  g.restThickness[1] = staticParam[REST_THICKNESS_2].x;
+
+  g.Q = getTensionParameter(g.f0);
+  getLengthAndThickness(g.Q, g.cordLength, g.thickness);
+}
+
+// ****************************************************************************
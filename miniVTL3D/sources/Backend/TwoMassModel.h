@@ -116,11 +116,28 @@ public:
   double getTensionParameter(double f0);
   void getLengthAndThickness(const double Q, double &length_cm, double thickness[]);
 
+  // **************************************************************************
+  // Private functions.
+  // **************************************************************************
+
+private:
+  void updateTensionGeometry();
+
   // **************************************************************************
   // Private data.
   // **************************************************************************
 
 private:
+  /// Tension, length and thickness for the f0 control parameter (without 
+  /// flutter). They only change at the control rate and are recalculated 
+  /// when one of the parameters they were calculated from has changed.
+  struct TensionGeometry
+  {
+    double f0, naturalF0, f0DivQ, restLength, restThickness[2];
+    double Q, cordLength, thickness[2];
+  };
+  TensionGeometry tensionGeometry;
+
   static const int BUFFER_LENGTH = 4;
   static const int BUFFER_MASK = 3;
 
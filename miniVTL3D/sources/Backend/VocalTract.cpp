@@ -23,6 +23,7 @@
 #include "Dsp.h"
 #include "Geometry.h"
 #include "XmlHelper.h"
+#include "MeshFile.h"
 
 #include <iomanip>
 #include <iostream>
@@ -44,9 +45,96 @@ const double VocalTract::INVALID_PROFILE_SAMPLE = 1000000.0;
 const double VocalTract::MIN_PROFILE_VALUE = -2.75;  // cm; Should not be smaller.
 const double VocalTract::MAX_PROFILE_VALUE = 10.0;  // Must be so high, so that the upper cover is always intersected !!
 const double VocalTract::EXTREME_PROFILE_VALUE = 1000000.0;
+const double VocalTract::ADAPTIVE_PROFILE_TOLERANCE = 0.005;  // cm
 
 static bool makeFasterIntersections = true;
 
+// The surfaces that only depend on the anatomy (see SurfaceSet).
+static const int referenceSurfaceIndex[VocalTract::NUM_REFERENCE_SURFACES] =
+{
+  VocalTract::PALATE, VocalTract::MANDIBLE, VocalTract::LOWER_TEETH_ORIGINAL,
+  VocalTract::LOW_VELUM, VocalTract::MID_VELUM, VocalTract::HIGH_VELUM,
+  VocalTract::NARROW_LARYNX_FRONT, VocalTract::NARROW_LARYNX_BACK,
+  VocalTract::WIDE_LARYNX_FRONT, VocalTract::WIDE_LARYNX_BACK,
+  VocalTract::UVULA_ORIGINAL, VocalTract::EPIGLOTTIS_ORIGINAL
+};
+
+
+// ****************************************************************************
+// Set of surfaces whose reference surfaces may be shared with other vocal 
+// tracts.
+// ****************************************************************************
+
+bool VocalTract::isReferenceSurface(int index)
+{
+  for (int i = 0; i < NUM_REFERENCE_SURFACES; i++)
+  {
+    if (referenceSurfaceIndex[i] == index) { return true; }
+  }
+  return false;
+}
+
+// ****************************************************************************
+
+VocalTract::SurfaceSet::SurfaceSet() : reference(new ReferenceSurfaces())
+{
+  linkSurfaces();
+}
+
+// ****************************************************************************
+/// Points the surface indexes to the own and to the reference surfaces 
+/// (in the order of the indexes).
+// ****************************************************************************
+
+void VocalTract::SurfaceSet::linkSurfaces()
+{
+  int numOwn = 0;
+  int numReference = 0;
+
+  for (int i = 0; i < NUM_SURFACES; i++)
+  {
+    if (isReferenceSurface(i))
+    {
+      surfacePtr[i] = &reference->surface[numReference++];
+    }
+    else
+    {
+      surfacePtr[i] = &ownSurface[numOwn++];
+    }
+  }
+}
+
+// ****************************************************************************
+
+void VocalTract::SurfaceSet::shareReferenceSurfaces(const SurfaceSet &set)
+{
+  reference = set.reference;
+  linkSurfaces();
+}
+
+// ****************************************************************************
+
+void VocalTract::SurfaceSet::detachReferenceSurfaces()
+{
+  if (reference.use_count() <= 1) { return; }
+
+  shared_ptr<ReferenceSurfaces> copy(new ReferenceSurfaces());
+  for (int i = 0; i < NUM_REFERENCE_SURFACES; i++)
+  {
+    const Surface &s = reference->surface[i];
+    Surface &c = copy->surface[i];
+    c.init(s.numRibs, s.numRibPoints);
+    c.creaseAngle_deg = s.creaseAngle_deg;
+    for (int k = 0; k < s.numVertices; k++)
+    {
+      c.vertex[k].coord = s.vertex[k].coord;
+    }
+  }
+
+  reference = copy;
+  linkSurfaces();
+}
+
 
 // ****************************************************************************
 // Constructor.
@@ -54,6 +142,8 @@ static bool makeFasterIntersections = true;
 
 VocalTract::VocalTract()
 {
+  surfaceVersion = 0;
+  temporalCoherence = false;
   init();
 }
 
@@ -74,6 +164,10 @@ VocalTract::~VocalTract()
 
 void VocalTract::init()
 {
+  isCalculationCached = false;
+  isPrevCenterLineValid = false;
+  surfaceVersion++;
+
   // ****************************************************************
   // Init all sufaces.
   // ****************************************************************
@@ -241,6 +335,9 @@ void VocalTract::init()
 
 void VocalTract::initSurfaceGrids()
 {
+  // The reference surfaces of other vocal tracts are not re-initialized.
+  surface.detachReferenceSurfaces();
+
   // ****************************************************************
   // Allocate memory for all surfaces.
   // ****************************************************************
@@ -343,12 +440,45 @@ void VocalTract::initSurfaceGrids()
 }
 
 
+// ****************************************************************************
+/// Makes this vocal tract a copy of the model of the given vocal tract, i.e.,
+/// of its anatomy, parameters, shapes, and EMA points. This allows to 
+/// evaluate different shapes of the same speaker on several models in 
+/// parallel. The reference surfaces, which only depend on the anatomy, are
+/// shared with the given vocal tract instead of being recalculated.
+// ****************************************************************************
+
+void VocalTract::copyModelFrom(VocalTract *tract)
+{
+  int i;
+
+  anatomy = tract->anatomy;
+  for (i = 0; i < NUM_PARAMS; i++)
+  {
+    param[i] = tract->param[i];
+  }
+  shapes = tract->shapes;
+  emaPoints = tract->emaPoints;
+
+  surface.shareReferenceSurfaces(tract->surface);
+  isCalculationCached = false;
+  isPrevCenterLineValid = false;
+  calculateAll();
+}
+
+
 // ****************************************************************************
 /// Must be called after any of the anatomy parameters was changed.
 // ****************************************************************************
 
 void VocalTract::initReferenceSurfaces()
 {
+  isCalculationCached = false;
+  isPrevCenterLineValid = false;
+
+  // The reference surfaces shared with other vocal tracts are kept for them.
+  surface.detachReferenceSurfaces();
+
   initLarynx();
   initJaws();
   initVelum();
@@ -1660,7 +1790,32 @@ void VocalTract::readFromXml(const string &speakerFileName)
     throw std::string("Error parsing the file ") + speakerFileName + ".";
   }
 
-  XmlNode *vocalTractNode = rootNode->getChildElement("vocal_tract_model");
+  try
+  {
+    readFromXml(rootNode, speakerFileName);
+  }
+  catch (std::string st)
+  {
+    delete rootNode;
+    throw;
+  }
+
+  // Delete the XML-tree.
+
+  delete rootNode;
+}
+
+
+// ****************************************************************************
+/// Read the speaker anatomy and vocal tract shape list from the <speaker> 
+/// node of an already parsed speaker file, so that the callers that also
+/// read the glottis models do not parse the file twice. The file name is
+/// only used for the error messages.
+// ****************************************************************************
+
+void VocalTract::readFromXml(XmlNode *speakerNode, const string &speakerFileName)
+{
+  XmlNode *vocalTractNode = speakerNode->getChildElement("vocal_tract_model");
   if (vocalTractNode == NULL)
   {
     throw std::string("The file ") + speakerFileName + " has no <vocal_tract_model> element!";
@@ -1701,10 +1856,6 @@ void VocalTract::readFromXml(const string &speakerFileName)
   {
     throw;
   }
-
-  // Delete the XML-tree.
-
-  delete rootNode;
 }
 
 
@@ -2255,13 +2406,15 @@ bool VocalTract::saveAsObjFile(const string &fileName, bool saveBothSides)
   // Open the file and output the name of the material file.
   // ****************************************************************
 
-  ofstream file(fileName);
-  if (!file) 
+  // The lines are formatted like with a stream (%g is the default
+  // format of a double) into a buffer written by large blocks.
+  BufferedTextFile file;
+  if (!file.open(fileName)) 
   { 
     return false; 
   }
 
-  file << "mtllib " << shortMtlFileName << endl;
+  file.print("mtllib %s\n", shortMtlFileName.c_str());
 
   // ****************************************************************
   // Output the vertices.
@@ -2274,10 +2427,8 @@ bool VocalTract::saveAsObjFile(const string &fileName, bool saveBothSides)
     {
       for (i=0; i < numVertices[k]; i++)
       {
-        file << "v  "
-          << (double)s->vertex[i].coord.x << "  " 
-          << (double)s->vertex[i].coord.y << "  " 
-          << (double)s->vertex[i].coord.z << endl;
+        file.print("v  %g  %g  %g\n", (double)s->vertex[i].coord.x,
+          (double)s->vertex[i].coord.y, (double)s->vertex[i].coord.z);
       }
     }
   }
@@ -2294,10 +2445,8 @@ bool VocalTract::saveAsObjFile(const string &fileName, bool saveBothSides)
       for (i=0; i < numVertices[k]; i++)
       {
         normal = s->getNormal(s->vertex[i].rib, s->vertex[i].ribPoint);
-        file << "vn  "
-          << (double)normal.x << "  " 
-          << (double)normal.y << "  " 
-          << (double)normal.z << endl;
+        file.print("vn  %g  %g  %g\n", (double)normal.x, (double)normal.y, 
+          (double)normal.z);
       }
     }
   }
@@ -2313,8 +2462,8 @@ bool VocalTract::saveAsObjFile(const string &fileName, bool saveBothSides)
     s = exportSurface[k];
     if (s != NULL)
     {
-      file << "g " << groupName[k] << endl;
-      file << "usemtl " << mtlName[k] << endl;
+      file.print("g %s\n", groupName[k].c_str());
+      file.print("usemtl %s\n", mtlName[k].c_str());
 
       for (i=0; i < s->numTriangles; i++)
       {
@@ -2322,18 +2471,15 @@ bool VocalTract::saveAsObjFile(const string &fileName, bool saveBothSides)
         index1 = 1 + firstVertex[k] + s->triangle[i].vertex[1];
         index2 = 1 + firstVertex[k] + s->triangle[i].vertex[2];
 
-        file << "f  "
-          << index0 << "//" << index0 << "  " 
-          << index1 << "//" << index1 << "  " 
-          << index2 << "//" << index2 << endl;
+        file.print("f  %d//%d  %d//%d  %d//%d\n", index0, index0, 
+          index1, index1, index2, index2);
       }
     }
   }
 
-  file << endl;
+  file.print("\n");
 
-  // The file is closed automatically.
-  return true;
+  return file.close();
 }
 
 
@@ -2353,6 +2499,10 @@ void VocalTract::setParams(double *controlParams)
 
 // ****************************************************************************
 /// Calculates all surfaces, the center line, and the area functions.
+/// All parameters act on the surfaces (the tongue is restricted against
+/// the other articulators), which in turn define the center line and the
+/// cross-sections, so that the whole chain of calculations is skipped only
+/// when the parameters did not change since the last call.
 // ****************************************************************************
 
 void VocalTract::calculateAll()
@@ -2370,6 +2520,31 @@ void VocalTract::calculateAll()
     param[i].limitedX = param[i].x;
   }
 
+  // ****************************************************************
+  // Nothing to do for the same parameters as in the last call, apart
+  // from restoring the values modified by the tongue restriction.
+  // ****************************************************************
+
+  if (isCalculationCached)
+  {
+    for (i = 0; (i < NUM_PARAMS) && (param[i].x == cachedInputParams[i]); i++);
+
+    if (i == NUM_PARAMS)
+    {
+      for (i = 0; i < NUM_PARAMS; i++)
+      {
+        param[i].x = cachedParams[i];
+        param[i].limitedX = cachedLimitedParams[i];
+      }
+      return;
+    }
+  }
+
+  for (i = 0; i < NUM_PARAMS; i++)
+  {
+    cachedInputParams[i] = param[i].x;
+  }
+
   // ****************************************************************
   // Do the calculations.
   // ****************************************************************
@@ -2378,6 +2553,29 @@ void VocalTract::calculateAll()
   calcCenterLine();
   calcCrossSections();
   crossSectionsToTubeSections();
+
+  for (i = 0; i < NUM_PARAMS; i++)
+  {
+    cachedParams[i] = param[i].x;
+    cachedLimitedParams[i] = param[i].limitedX;
+  }
+  isCalculationCached = true;
+}
+
+
+// ****************************************************************************
+/// Enables or disables the temporal coherence between consecutive calls of
+/// calculateAll(): the normals of the center line points that moved less 
+/// than a tolerance (together with their neighbours) since the previous 
+/// call, and the limits of their cut vectors, are taken from the previous 
+/// call instead of being intersected with the outlines and corrected again.
+/// This is meant for the small changes between the frames of a synthesis.
+// ****************************************************************************
+
+void VocalTract::setTemporalCoherence(bool enabled)
+{
+  temporalCoherence = enabled;
+  isPrevCenterLineValid = false;
 }
 
 
@@ -2413,6 +2611,7 @@ void VocalTract::calcSurfaces()
   {
     intersectionsPrepared[i] = false;
   }
+  surfaceVersion++;
 
   // ****************************************************************
   // Restrict the parameter values.
@@ -5346,10 +5545,44 @@ void VocalTract::calcCenterLine()
     centerLine[i].normal.normalize();
   }
 
+  // ****************************************************************
+  // With temporal coherence, keep the normals and limits of the
+  // points that did not move since the previous calculation.
+  // ****************************************************************
+
+  const double COHERENCE_TOLERANCE_CM = 0.001;
+  bool isPointKept[NUM_CENTERLINE_POINTS];
+
+  for (i=0; i < NUM_CENTERLINE_POINTS; i++)
+  {
+    isPointKept[i] = false;
+    if ((temporalCoherence) && (isPrevCenterLineValid))
+    {
+      isPointKept[i] = true;
+      for (k = max(i-1, 0); (k <= min(i+1, NUM_CENTERLINE_POINTS-1)) && (isPointKept[i]); k++)
+      {
+        if ((centerLine[k].point - prevCenterLine[k].point).magnitude() >= COHERENCE_TOLERANCE_CM)
+        {
+          isPointKept[i] = false;
+        }
+      }
+    }
+
+    if (isPointKept[i])
+    {
+      centerLine[i].normal = prevCenterLine[i].normal;
+      centerLine[i].min = prevCenterLine[i].min;
+      centerLine[i].max = prevCenterLine[i].max;
+      centerLine[i].reserved = 0.0;
+    }
+  }
+
   // Calc. the min- and max-parameters for each cut vector.
 
   for (i=0; i < NUM_CENTERLINE_POINTS; i++)
   {
+    if (isPointKept[i]) { continue; }
+
     centerLine[i].reserved = 0.0;   // The cutting line is ok.
 
     Point2D P = centerLine[i].point;
@@ -5416,6 +5649,8 @@ void VocalTract::calcCenterLine()
   {
     for (i = 1; i < NUM_CENTERLINE_POINTS; i++)
     {
+      // The kept normals were already corrected against each other.
+      if ((isPointKept[i]) && (isPointKept[i - 1])) { continue; }
       verifyCenterLineNormal(i, i - 1, scaling);
     }
 
@@ -5470,9 +5705,20 @@ void VocalTract::calcCenterLine()
     }
 
     cnt++;
-    nbIntersect = numNormalsIntersected(scaling);
+    if (cnt < maxIter)
+    {
+      nbIntersect = numNormalsIntersected(scaling);
+    }
   }
 
+  if (temporalCoherence)
+  {
+    for (i = 0; i < NUM_CENTERLINE_POINTS; i++)
+    {
+      prevCenterLine[i] = centerLine[i];
+    }
+    isPrevCenterLineValid = true;
+  }
 }
 
 // ****************************************************************************
@@ -6661,9 +6907,35 @@ void VocalTract::getCrossProfiles(Point2D P, Point2D v, double *upperProfile,
 
 }
 
+// ****************************************************************************
+// Assign the triangles of all surfaces to their tiles for the fast 
+// intersection method. Afterwards, the surfaces are only read by the 
+// overload of getCrossProfiles that returns the surface indexes, which can 
+// then be called concurrently.
+// ****************************************************************************
+
+void VocalTract::prepareIntersections()
+{
+  if (makeFasterIntersections == false) { return; }
+
+  for (int i = 0; i < NUM_SURFACES; i++)
+  {
+    // The reference surfaces are not intersected (and may be shared).
+    if (isReferenceSurface(i)) { continue; }
+
+    if (intersectionsPrepared[i] == false)
+    {
+      surface[i].prepareIntersections();
+      intersectionsPrepared[i] = true;
+    }
+  }
+}
+
 // ****************************************************************************
 // Overload of getCrossProfiles that returns the indexes of the surfaces
 // constituting the contour
+// The intersections are computed with a local intersection state, so that
+// the surfaces are not modified once the intersections are prepared.
 // ****************************************************************************
 
 void VocalTract::getCrossProfiles(Point2D P, Point2D v, double* upperProfile,
@@ -6687,6 +6959,7 @@ void VocalTract::getCrossProfiles(Point2D P, Point2D v, double* upperProfile,
   int left, right;
   int localIndex, globalIndex;
   bool rightOrientation;
+  Surface::IntersectionState intersection;
 
   // Handle all upper-posterior surfaces first, and then the other
   // surfaces.
@@ -6764,12 +7037,12 @@ void VocalTract::getCrossProfiles(Point2D P, Point2D v, double* upperProfile,
           intersectionsPrepared[globalIndex] = true;
         }
 
-        s->prepareIntersection(P, v);
-        s->getTriangleList(indexList, numListEntries, MAX_LIST_ENTRIES);
+        s->prepareIntersection(P, v, intersection);
+        s->getTriangleList(intersection, indexList, numListEntries, MAX_LIST_ENTRIES);
 
         for (i = 0; i < numListEntries; i++)
         {
-          if ((s->getTriangleIntersection(indexList[i], P0, P1, n)) && (numCuts < MAX_CUTS) &&
+          if ((s->getTriangleIntersection(indexList[i], P0, P1, n, intersection)) && (numCuts < MAX_CUTS) &&
             (P0.y < MAX_PROFILE_VALUE) && (P1.y < MAX_PROFILE_VALUE) &&
             (P1.y > MIN_PROFILE_VALUE) && (P1.y > MIN_PROFILE_VALUE))
           {
@@ -6787,11 +7060,11 @@ void VocalTract::getCrossProfiles(Point2D P, Point2D v, double* upperProfile,
         // The "normal", slower intersection method.
 
       {
-        s->prepareIntersection(P, v);
+        s->prepareIntersection(P, v, intersection);
 
         for (i = 0; i < s->numTriangles; i++)
         {
-          if ((s->getTriangleIntersection(i, P0, P1, n)) && (numCuts < MAX_CUTS) &&
+          if ((s->getTriangleIntersection(i, P0, P1, n, intersection)) && (numCuts < MAX_CUTS) &&
             (P0.y < MAX_PROFILE_VALUE) && (P1.y < MAX_PROFILE_VALUE) &&
             (P1.y > MIN_PROFILE_VALUE) && (P1.y > MIN_PROFILE_VALUE))
           {
@@ -7668,6 +7941,106 @@ void VocalTract::insertLowerCoverProfileLine(Point2D P0, Point2D P1, int surface
 }
 
 
+// ****************************************************************************
+/// Selects the samples of the profiles (as returned by getCrossProfiles())
+/// that are needed to describe them: keepSample[i] is set to true for the
+/// samples where a profile changes rapidly or switches the surface, at the
+/// borders of the contours, and for as few samples as possible in the
+/// regions in between, so that the skipped samples deviate by less than
+/// ADAPTIVE_PROFILE_TOLERANCE from the line between the kept samples.
+/// Between two kept samples, the profiles change by less than one sample 
+/// length per sample and stay on the same surfaces.
+/// Returns the number of kept samples.
+// ****************************************************************************
+
+int VocalTract::getAdaptiveProfileSamples(const double *upperProfile, const double *lowerProfile,
+  const int *upperProfileSurface, const int *lowerProfileSurface, bool *keepSample)
+{
+  const int N = NUM_PROFILE_SAMPLES;
+  const double INVALID = INVALID_PROFILE_SAMPLE;
+  int i, j;
+
+  // ****************************************************************
+  // The samples that are always kept.
+  // ****************************************************************
+
+  for (i = 0; i < N; i++)
+  {
+    keepSample[i] = false;
+  }
+  keepSample[0] = true;
+  keepSample[N - 1] = true;
+
+  for (i = 0; i < N; i++)
+  {
+    if ((upperProfile[i] == INVALID) || (lowerProfile[i] == INVALID) ||
+      (upperProfile[i] == lowerProfile[i]))
+    {
+      keepSample[max(i - 1, 0)] = true;
+      keepSample[i] = true;
+      keepSample[min(i + 1, N - 1)] = true;
+    }
+  }
+
+  for (i = 0; i < N - 1; i++)
+  {
+    if ((upperProfileSurface[i] != upperProfileSurface[i + 1]) ||
+      (lowerProfileSurface[i] != lowerProfileSurface[i + 1]) ||
+      (fabs(upperProfile[i + 1] - upperProfile[i]) > PROFILE_SAMPLE_LENGTH) ||
+      (fabs(lowerProfile[i + 1] - lowerProfile[i]) > PROFILE_SAMPLE_LENGTH))
+    {
+      keepSample[i] = true;
+      keepSample[i + 1] = true;
+    }
+  }
+
+  // ****************************************************************
+  // Between these samples, a sample is skipped if the line from the
+  // last kept sample to the next sample approximates both profiles
+  // at all the samples in between.
+  // ****************************************************************
+
+  int anchor = 0;
+  int numKept = 1;
+
+  for (i = 1; i < N; i++)
+  {
+    if (keepSample[i])
+    {
+      anchor = i;
+      numKept++;
+      continue;
+    }
+
+    // The last sample is always kept, so that i + 1 < N.
+    double length = (double)(i + 1 - anchor);
+    bool linear = true;
+
+    for (j = anchor + 1; (j <= i) && (linear); j++)
+    {
+      double t = (double)(j - anchor) / length;
+      double upper = upperProfile[anchor] + t*(upperProfile[i + 1] - upperProfile[anchor]);
+      double lower = lowerProfile[anchor] + t*(lowerProfile[i + 1] - lowerProfile[anchor]);
+
+      if ((fabs(upperProfile[j] - upper) > ADAPTIVE_PROFILE_TOLERANCE) ||
+        (fabs(lowerProfile[j] - lower) > ADAPTIVE_PROFILE_TOLERANCE))
+      {
+        linear = false;
+      }
+    }
+
+    if (!linear)
+    {
+      keepSample[i] = true;
+      anchor = i;
+      numKept++;
+    }
+  }
+
+  return numKept;
+}
+
+
 // ****************************************************************************
 /// Given the upper and lower profile of a cross-section, the area and
 /// perimeter are calculated.
@@ -8624,7 +8997,7 @@ void VocalTract::restoreControlParams()
 /// Write a STL file contianing the vocal tract geometry
 // ****************************************************************************
 
-bool VocalTract::exportVocalTractToSTL(const string& fileName)
+bool VocalTract::exportVocalTractToSTL(const string& fileName, bool binary)
 {
   double upperProfile[2][NUM_PROFILE_SAMPLES];
   double lowerProfile[2][NUM_PROFILE_SAMPLES];
@@ -8640,16 +9013,15 @@ bool VocalTract::exportVocalTractToSTL(const string& fileName)
 
   // ****************************************************************
 
-  ofstream os(fileName);
-  if (!os)
-  {
-    return false;
-  }
-
   // Write STL file header
   size_t lastBackSlash = fileName.find_last_of("/\\");
   size_t lastDot = fileName.find_last_of(".");
-  os << "solid " << fileName.substr(lastBackSlash+1, lastDot - lastBackSlash -1) << endl;
+  StlFileWriter stl;
+  if (!stl.open(fileName, fileName.substr(lastBackSlash+1, 
+    lastDot - lastBackSlash -1), binary))
+  {
+    return false;
+  }
 
   // ****************************************************************
   // Compute the 3D coordinates of the profile points
@@ -8729,28 +9101,28 @@ bool VocalTract::exportVocalTractToSTL(const string& fileName)
         P[1].set(xUp[0][1], yUp[0][1], zProfile[p + 1]);
         P[2].set(xUp[1][0], yUp[1][0], zProfile[p]);
         triangle.set(P[0], P[1], P[2]);
-        os << triangle.stringSTLformat();
+        stl.addTriangle(triangle);
 
         // upper profile triangle 2
         P[0].set(xUp[0][1], yUp[0][1], zProfile[p+1]);
         P[1].set(xUp[1][1], yUp[1][1], zProfile[p + 1]);
         P[2].set(xUp[1][0], yUp[1][0], zProfile[p]);
         triangle.set(P[0], P[1], P[2]);
-        os << triangle.stringSTLformat();
+        stl.addTriangle(triangle);
 
         // lower profile triangle 1
         P[0].set(xLo[1][0], yLo[1][0], zProfile[p]);
         P[1].set(xLo[0][1], yLo[0][1], zProfile[p + 1]);
         P[2].set(xLo[0][0], yLo[0][0], zProfile[p]);
         triangle.set(P[0], P[1], P[2]);
-        os << triangle.stringSTLformat();
+        stl.addTriangle(triangle);
 
         // lower profile triangle 2
         P[0].set(xLo[1][0], yLo[1][0], zProfile[p]);
         P[1].set(xLo[1][1], yLo[1][1], zProfile[p + 1]);
         P[2].set(xLo[0][1], yLo[0][1], zProfile[p+1]);
         triangle.set(P[0], P[1], P[2]);
-        os << triangle.stringSTLformat();
+        stl.addTriangle(triangle);
         break;
       case 2:
         //    +
@@ -8761,28 +9133,28 @@ bool VocalTract::exportVocalTractToSTL(const string& fileName)
         P[1].set(xUp[1][1], yUp[1][1], zProfile[p + 1]);
         P[2].set(xUp[1][0], yUp[1][0], zProfile[p]);
         triangle.set(P[0], P[1], P[2]);
-        os << triangle.stringSTLformat();
+        stl.addTriangle(triangle);
 
         // lower profile triangle
         P[0].set(xLo[1][0], yLo[1][0], zProfile[p]);
         P[1].set(xLo[1][1], yLo[1][1], zProfile[p + 1]);
         P[2].set(xLo[0][1], yLo[0][1], zProfile[p+1]);
         triangle.set(P[0], P[1], P[2]);
-        os << triangle.stringSTLformat();
+        stl.addTriangle(triangle);
 
         // link between profiles, triangle 1
         P[0].set(xLo[0][1], yLo[0][1], zProfile[p+1]);
         P[1].set(xUp[0][1], yUp[0][1], zProfile[p + 1]);
         P[2].set(xUp[1][0], yUp[1][0], zProfile[p]);
         triangle.set(P[0], P[1], P[2]);
-        os << triangle.stringSTLformat();
+        stl.addTriangle(triangle);
 
         // link between profiles, triangle 2
         P[0].set(xLo[1][0], yLo[1][0], zProfile[p]);
         P[1].set(xLo[0][1], yLo[0][1], zProfile[p + 1]);
         P[2].set(xUp[1][0], yUp[1][0], zProfile[p]);
         triangle.set(P[0], P[1], P[2]);
-        os << triangle.stringSTLformat();
+        stl.addTriangle(triangle);
         break;
       case 7:
         // +   +
@@ -8793,28 +9165,28 @@ bool VocalTract::exportVocalTractToSTL(const string& fileName)
         P[1].set(xUp[0][1], yUp[0][1], zProfile[p + 1]);
         P[2].set(xUp[1][1], yUp[1][1], zProfile[p+1]);
         triangle.set(P[0], P[1], P[2]);
-        os << triangle.stringSTLformat();
+        stl.addTriangle(triangle);
 
         // lower profile triangle
         P[0].set(xLo[1][1], yLo[1][1], zProfile[p+1]);
         P[1].set(xLo[0][1], yLo[0][1], zProfile[p + 1]);
         P[2].set(xLo[0][0], yLo[0][0], zProfile[p]);
         triangle.set(P[0], P[1], P[2]);
-        os << triangle.stringSTLformat();
+        stl.addTriangle(triangle);
                                            
         // link between profiles, triangle 1
         P[0].set(xUp[0][0], yUp[0][0], zProfile[p]);
         P[1].set(xUp[1][1], yUp[1][1], zProfile[p + 1]);
         P[2].set(xLo[1][1], yLo[1][1], zProfile[p+1]);
         triangle.set(P[0], P[1], P[2]);
-        os << triangle.stringSTLformat();
+        stl.addTriangle(triangle);
 
         // link between profiles, triangle 2
         P[0].set(xLo[1][1], yLo[1][1], zProfile[p + 1]);
         P[1].set(xLo[0][0], yLo[0][0], zProfile[p]);
         P[2].set(xUp[0][0], yUp[0][0], zProfile[p]);
         triangle.set(P[0], P[1], P[2]);
-        os << triangle.stringSTLformat();
+        stl.addTriangle(triangle);
    
 
         break;
@@ -8827,28 +9199,28 @@ bool VocalTract::exportVocalTractToSTL(const string& fileName)
         P[1].set(xUp[0][1], yUp[0][1], zProfile[p + 1]);
         P[2].set(xUp[1][0], yUp[1][0], zProfile[p]);
         triangle.set(P[0], P[1], P[2]);
-        os << triangle.stringSTLformat();
+        stl.addTriangle(triangle);
 
         // lower profile triangle
         P[0].set(xLo[1][0], yLo[1][0], zProfile[p]);
         P[1].set(xLo[0][1], yLo[0][1], zProfile[p + 1]);
         P[2].set(xLo[0][0], yLo[0][0], zProfile[p]);
         triangle.set(P[0], P[1], P[2]);
-        os << triangle.stringSTLformat();
+        stl.addTriangle(triangle);
 
         // link between profiles, triangle 1
         P[0].set(xUp[1][0], yUp[1][0], zProfile[p]);
         P[1].set(xUp[0][1], yUp[0][1], zProfile[p + 1]);
         P[2].set(xLo[1][0], yLo[1][0], zProfile[p]);
         triangle.set(P[0], P[1], P[2]);
-        os << triangle.stringSTLformat();
+        stl.addTriangle(triangle);
 
         // link between profiles, triangle 2
         P[0].set(xLo[0][1], yLo[0][1], zProfile[p+1]);
         P[1].set(xLo[1][0], yLo[1][0], zProfile[p]);
         P[2].set(xUp[0][1], yUp[0][1], zProfile[p+1]);
         triangle.set(P[0], P[1], P[2]);
-        os << triangle.stringSTLformat();
+        stl.addTriangle(triangle);
                                          
         break;
       case 3:
@@ -8860,28 +9232,28 @@ bool VocalTract::exportVocalTractToSTL(const string& fileName)
         P[1].set(xUp[1][1], yUp[1][1], zProfile[p + 1]);
         P[2].set(xUp[1][0], yUp[1][0], zProfile[p]);
         triangle.set(P[0], P[1], P[2]);
-        os << triangle.stringSTLformat();
+        stl.addTriangle(triangle);
 
         // lower profile triangle
         P[0].set(xLo[1][0], yLo[1][0], zProfile[p]);
         P[1].set(xLo[1][1], yLo[1][1], zProfile[p + 1]);
         P[2].set(xLo[0][0], yLo[0][0], zProfile[p]);
         triangle.set(P[0], P[1], P[2]);
-        os << triangle.stringSTLformat();
+        stl.addTriangle(triangle);
 
         // link between profiles, triangle 1
         P[0].set(xLo[0][0], yLo[0][0], zProfile[p]);
         P[1].set(xUp[1][1], yUp[1][1], zProfile[p + 1]);
         P[2].set(xUp[0][0], yUp[0][0], zProfile[p]);
         triangle.set(P[0], P[1], P[2]);
-        os << triangle.stringSTLformat();
+        stl.addTriangle(triangle);
 
         // link between profiles, triangle 2
         P[0].set(xUp[1][1], yUp[1][1], zProfile[p+1]);
         P[1].set(xLo[0][0], yLo[0][0], zProfile[p]);
         P[2].set(xLo[1][1], yLo[1][1], zProfile[p+1]);
         triangle.set(P[0], P[1], P[2]);
-        os << triangle.stringSTLformat();
+        stl.addTriangle(triangle);
 
         break;
       case 35:
@@ -8893,14 +9265,14 @@ bool VocalTract::exportVocalTractToSTL(const string& fileName)
         P[1].set(xUp[0][1], yUp[0][1], zProfile[p + 1]);
         P[2].set(xLo[0][0], yLo[0][0], zProfile[p]);
         triangle.set(P[0], P[1], P[2]);
-        os << triangle.stringSTLformat();
+        stl.addTriangle(triangle);
 
         // link between profiles, triangle 2
         P[0].set(xUp[0][1], yUp[0][1], zProfile[p+1]);
         P[1].set(xLo[0][1], yLo[0][1], zProfile[p+1]);
         P[2].set(xLo[0][0], yLo[0][0], zProfile[p]);
         triangle.set(P[0], P[1], P[2]);
-        os << triangle.stringSTLformat();
+        stl.addTriangle(triangle);
 
         break;
       case 6:
@@ -8912,14 +9284,14 @@ bool VocalTract::exportVocalTractToSTL(const string& fileName)
         P[1].set(xUp[1][1], yUp[1][1], zProfile[p + 1]);
         P[2].set(xUp[1][0], yUp[1][0], zProfile[p]);
         triangle.set(P[0], P[1], P[2]);
-        os << triangle.stringSTLformat();
+        stl.addTriangle(triangle);
 
         // link between profiles, triangle 2
         P[0].set(xLo[1][0], yLo[1][0], zProfile[p]);
         P[1].set(xLo[1][1], yLo[1][1], zProfile[p+1]);
         P[2].set(xUp[1][1], yUp[1][1], zProfile[p+1]);
         triangle.set(P[0], P[1], P[2]);
-        os << triangle.stringSTLformat();
+        stl.addTriangle(triangle);
 
         break;
       case 15:
@@ -8931,14 +9303,14 @@ bool VocalTract::exportVocalTractToSTL(const string& fileName)
         P[1].set(xUp[1][0], yUp[1][0], zProfile[p]);
         P[2].set(xUp[0][0], yUp[0][0], zProfile[p]);
         triangle.set(P[0], P[1], P[2]);
-        os << triangle.stringSTLformat();
+        stl.addTriangle(triangle);
 
         // link between profiles, triangle 2
         P[0].set(xUp[0][0], yUp[0][0], zProfile[p]);
         P[1].set(xLo[0][0], yLo[0][0], zProfile[p]);
         P[2].set(xLo[1][0], yLo[1][0], zProfile[p]);
         triangle.set(P[0], P[1], P[2]);
-        os << triangle.stringSTLformat();
+        stl.addTriangle(triangle);
 
         break;
       case 14:
@@ -8950,7 +9322,7 @@ bool VocalTract::exportVocalTractToSTL(const string& fileName)
         P[1].set(xUp[1][1], yUp[1][1], zProfile[p+1]);
         P[2].set(xLo[1][1], yLo[1][1], zProfile[p+1]);
         triangle.set(P[0], P[1], P[2]);
-        os << triangle.stringSTLformat();
+        stl.addTriangle(triangle);
 
         // link between profiles, triangle 2
         P[0].set(xLo[1][1], yLo[1][1], zProfile[p+1]);
@@ -8965,9 +9337,9 @@ bool VocalTract::exportVocalTractToSTL(const string& fileName)
   }
 
   // ****************************************************************
-  // Close the file.
+  // Close the file (this sets the number of triangles of a binary
+  // file).
   // ****************************************************************
 
-  os.close();
-  return true;
+  return stl.close();
 }
@@ -23,6 +23,7 @@
 #define __VOCALTRACT_H__
 
 #include <string>
+#include <memory>
 #include "Surface.h"
 #include "Splines.h"
 #include "Tube.h"
@@ -90,6 +91,8 @@ public:
   static const double MIN_PROFILE_VALUE;
   static const double MAX_PROFILE_VALUE;
   static const double EXTREME_PROFILE_VALUE;
+  /// Max. deviation of a profile sample from the line between the adaptive samples
+  static const double ADAPTIVE_PROFILE_TOLERANCE;
 
   // ****************************************************************
   // Other constants.
@@ -135,6 +138,47 @@ public:
     NUM_SURFACES
   };
 
+  // ****************************************************************
+  // The reference surfaces (larynx, palate, mandible, velum and the
+  // original teeth, uvula and epiglottis) only depend on the anatomy.
+  // They are shared by the vocal tracts copied with copyModelFrom(), 
+  // and copied on write by initReferenceSurfaces(), so that only the 
+  // surfaces deformed by the parameters are owned by each vocal 
+  // tract. The surfaces are accessed by their index as an array.
+  // ****************************************************************
+
+  static const int NUM_REFERENCE_SURFACES = 12;
+  static bool isReferenceSurface(int index);
+
+  class SurfaceSet
+  {
+  public:
+    SurfaceSet();
+    Surface &operator[](int index) { return *surfacePtr[index]; }
+    const Surface &operator[](int index) const { return *surfacePtr[index]; }
+
+    /// Share the reference surfaces of another set.
+    void shareReferenceSurfaces(const SurfaceSet &set);
+    /// Copy the reference surfaces if they are shared, before they are 
+    /// modified.
+    void detachReferenceSurfaces();
+    bool isSharingReferenceSurfaces() const { return reference.use_count() > 1; }
+
+  private:
+    struct ReferenceSurfaces
+    {
+      Surface surface[NUM_REFERENCE_SURFACES];
+    };
+
+    Surface ownSurface[NUM_SURFACES - NUM_REFERENCE_SURFACES];
+    shared_ptr<ReferenceSurfaces> reference;
+    Surface *surfacePtr[NUM_SURFACES];
+
+    void linkSurfaces();
+    SurfaceSet(const SurfaceSet &);
+    SurfaceSet &operator=(const SurfaceSet &);
+  };
+
   // ****************************************************************
   // Time-variant vocal tract parameters.
   // ****************************************************************
@@ -321,13 +365,17 @@ public:
   // Variables.
   // ****************************************************************
 
-  Surface surface[NUM_SURFACES];
+  SurfaceSet surface;
   Param param[NUM_PARAMS];
   vector<Shape> shapes;
   vector<EmaPoint> emaPoints;
 
   TongueRib tongueRib[MAX_TONGUE_RIBS_GLOBAL];
 
+  // Incremented each time the surfaces are (re-)calculated, so that copies
+  // of the surfaces (e.g., for the rendering) can be updated only when needed
+  int surfaceVersion;
+
   // Guiding lines for the lip corners.
   LineStrip3D wideLipCornerPath;
   LineStrip3D narrowLipCornerPath;
@@ -376,6 +424,7 @@ public:
   void initJaws();
   void initVelum();
   void setDefaultEmaPoints();
+  void copyModelFrom(VocalTract *tract);
   Point3D getEmaPointCoord(int index);
   void getEmaSurfaceVertexRange(int emaSurface, int *min, int *max);
 
@@ -386,6 +435,7 @@ public:
   void readAnatomyXml(XmlNode *anatomyNode);
   void readShapesXml(XmlNode *shapeListNode);
   void readFromXml(const string &speakerFileName);
+  void readFromXml(XmlNode *speakerNode, const string &speakerFileName);
   void writeAnatomyXml(std::ostream &os, int indent);
   void writeShapesXml(std::ostream &os, int indent);
   void writeToXml(std::ostream &os, int indent);
@@ -398,6 +448,10 @@ public:
 
   void setParams(double *controlParams);
   void calculateAll();
+  // With temporal coherence (for consecutive frames of a synthesis), the
+  // corrected normals and the limits of the cut vectors of the previous 
+  // calculation are kept where the center line did not move.
+  void setTemporalCoherence(bool enabled);
   
   // ****************************************************************
   // Calculate all geometric surfaces.
@@ -435,6 +489,9 @@ public:
 void getCrossProfiles(Point2D P, Point2D v, double* upperProfile, double* lowerProfile,
 	  int* upperProfileSurface, int* lowerProfileSurface,
 	  bool considerTongue, Tube::Articulator& articulator, bool debug = false);							
+  // Prepare the intersections of all surfaces, so that the overload of
+  // getCrossProfiles() with the surface indexes can be called concurrently.
+  void prepareIntersections();
   void insertUpperProfileLine(Point2D P0, Point2D P1, int surfaceIndex, 
     double *upperProfile, int *upperProfileSurface);
   void insertLowerProfileLine(Point2D P0, Point2D P1, int surfaceIndex, 
@@ -442,9 +499,12 @@ void getCrossProfiles(Point2D P, Point2D v, double* upperProfile, double* lowerP
   void insertLowerCoverProfileLine(Point2D P0, Point2D P1, int surfaceIndex,
     double *upperProfile, int *upperProfileSurface, double *lowerProfile, int *lowerProfileSurface);
   void getCrossSection(double *upperProfile, double *lowerProfile, CrossSection *section);
+  // Select the profile samples needed to describe the profiles.
+  static int getAdaptiveProfileSamples(const double *upperProfile, const double *lowerProfile,
+    const int *upperProfileSurface, const int *lowerProfileSurface, bool *keepSample);
   
   bool exportCrossSections(const string &fileName);
-  bool exportVocalTractToSTL(const string &fileName);
+  bool exportVocalTractToSTL(const string &fileName, bool binary = false);
   bool exportTractContourSvg(const string &fileName, bool addCenterLine, bool addCutVectors);
   void addRibPointsSvg(ostream &os, Surface *s, int rib, int firstRibPoint, int lastRibPoint);
   void addRibsSvg(ostream &os, Surface *s, int firstRib, int lastRib, int ribPoint);
@@ -481,6 +541,20 @@ private:
   bool hasStoredControlParams;
   double storedControlParams[NUM_PARAMS];
 
+  // The parameter values of the last call of calculateAll() before and
+  // after the restriction of the tongue, to skip the recalculation of the
+  // model for unchanged parameters.
+  bool isCalculationCached;
+  double cachedInputParams[NUM_PARAMS];
+  double cachedParams[NUM_PARAMS];
+  double cachedLimitedParams[NUM_PARAMS];
+
+  // The center line of the previous calculation in the temporal coherence
+  // mode (see setTemporalCoherence()).
+  bool temporalCoherence;
+  bool isPrevCenterLineValid;
+  CenterLinePoint prevCenterLine[NUM_CENTERLINE_POINTS];
+
   LineStrip2D upperOutline;
   LineStrip2D lowerOutline;
   LineStrip2D tongueOutline;
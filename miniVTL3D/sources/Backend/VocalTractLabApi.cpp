@@ -22,7 +22,7 @@
 #include "VocalTractLabApi.h"
 #include "Dsp.h"
 #include "SoundLib.h"
-#include "AudioFile.h"
+#include "WaveFile.h"
 #include "Synthesizer.h"
 // #include "SegmentSequence.h" // Removed
 
@@ -35,10 +35,16 @@
 // #include "GesturalScore.h" // Removed
 #include "XmlHelper.h"
 #include "XmlNode.h"
+#include "SpeakerCache.h"
 #include "TlModel.h"
+#include "TractSequenceFile.h"
 
 #include <iostream>
 #include <fstream>
+#include "ParallelLoop.h"
+#include <thread>
+#include <atomic>
+#include <memory>
 
 enum GlottisModel
 {
@@ -48,15 +54,34 @@ enum GlottisModel
   NUM_GLOTTIS_MODELS
 };
 
-static Glottis *glottis[NUM_GLOTTIS_MODELS];
-static int selectedGlottis;
+// ****************************************************************************
+// The models and the synthesis state of a session. Each context owns its
+// models, so that several contexts can synthesize concurrently in different
+// threads (one context must only be used by one thread at a time).
+// ****************************************************************************
+
+struct VtlContext
+{
+  Glottis *glottis[NUM_GLOTTIS_MODELS];
+  int selectedGlottis;
+
+  VocalTract *vocalTract;
+  TdsModel *tdsModel;
+  Synthesizer *synthesizer;
+  Tube *tube;
+
+  // The speaker file the models were loaded from (to create the contexts
+  // of the workers of the batch functions).
+  string speakerFileName;
+};
 
-static VocalTract *vocalTract = NULL;
-static TdsModel *tdsModel = NULL;
-static Synthesizer *synthesizer = NULL;
-static Tube *tube = NULL;
+// The context used by the functions without context argument (NULL as long
+// as the API is not initialized).
+static VtlContext *defaultContext = NULL;
 
-static bool vtlApiInitialized = false;
+// When true, the speaker data are restored from the binary snapshot next to
+// the speaker file (see vtlUseSpeakerCache()).
+static atomic<bool> useSpeakerCache(false);
 
 
 #if defined(WIN32) && defined(_USRDLL) 
@@ -94,12 +119,39 @@ bool vtlLoadSpeaker(const char *speakerFileName, VocalTract *vocalTract,
   Glottis *glottis[], int &selectedGlottis)
 {
 
+  // ****************************************************************
+  // Read the speaker file and restore its data from the snapshot, if
+  // there is a valid one for this text.
+  // ****************************************************************
+
+  string speakerText;
+  if (xmlReadFile(string(speakerFileName), speakerText) == false)
+  {
+    printf("Error: File %s could not be opened!\n", speakerFileName);
+    return false;
+  }
+
+  string cacheFileName = string(speakerFileName) + ".cache";
+  uint64_t speakerHash = 0;
+  bool cacheEnabled = useSpeakerCache;
+
+  if (cacheEnabled)
+  {
+    speakerHash = speakerFileHash(speakerText);
+    if (readSpeakerCache(cacheFileName, speakerHash, vocalTract, glottis, 
+      NUM_GLOTTIS_MODELS, selectedGlottis))
+    {
+      vocalTract->calculateAll();
+      return true;
+    }
+  }
+
   // ****************************************************************
   // Load the XML data from the speaker file.
   // ****************************************************************
 
   vector<XmlError> xmlErrors;
-  XmlNode *rootNode = xmlParseFile(string(speakerFileName), "speaker", &xmlErrors);
+  XmlNode *rootNode = xmlParseString(speakerText, "speaker", &xmlErrors);
   if (rootNode == NULL)
   {
     xmlPrintErrors(xmlErrors);
@@ -152,125 +204,258 @@ bool vtlLoadSpeaker(const char *speakerFileName, VocalTract *vocalTract,
     printf("Warning: No glottis model data found in the speaker file %s!\n", speakerFileName);
   }
 
-  // Free the memory of the XML tree !
-  delete rootNode;
-
   // ****************************************************************
-  // Load the vocal tract anatomy and vocal tract shapes.
+  // Load the vocal tract anatomy and vocal tract shapes from the 
+  // same XML tree.
   // ****************************************************************
 
   try
   {
-    vocalTract->readFromXml(string(speakerFileName));
-    vocalTract->calculateAll();
+    vocalTract->readFromXml(rootNode, string(speakerFileName));
   }
   catch (std::string st)
   {
     printf("%s\n", st.c_str());
     printf("Error reading the anatomy data from %s.\n", speakerFileName);
+    delete rootNode;
     return false;
   }
 
+  // Free the memory of the XML tree !
+  delete rootNode;
+
+  // Save the snapshot for the next time. A failure to write it (e.g., a 
+  // read-only folder) is not an error.
+  if (cacheEnabled)
+  {
+    writeSpeakerCache(cacheFileName, speakerHash, vocalTract, glottis, 
+      NUM_GLOTTIS_MODELS, selectedGlottis);
+  }
+
+  vocalTract->calculateAll();
+
   return true;
 }
 
 
 // ****************************************************************************
-// Init. the synthesis with the given speaker file name, e.g. "JD2.speaker".
-// This function should be called before any other function of this API.
-// Return values:
-// 0: success.
-// 1: Loading the speaker file failed.
+// Returns true if the context was created, and prints an error otherwise.
+// This function is not visible in the interface.
 // ****************************************************************************
 
-int vtlInitialize(const char *speakerFileName)
+static bool vtlCheckContext(VtlContext *context)
 {
-  if (vtlApiInitialized)
+  if (context == NULL)
   {
-    vtlClose();
+    printf("Error: The API has not been initialized.\n");
+    return false;
   }
+  return true;
+}
+
+
+// ****************************************************************************
+// Returns the number of threads of a batch function for numThreads requested 
+// threads (all the workers of the pool for numThreads <= 0) and numItems 
+// items.
+// ****************************************************************************
+
+static int getNumBatchThreads(int numThreads, int numItems)
+{
+  if (numThreads <= 0)
+  {
+    numThreads = threadPoolSize();
+  }
+  return max(1, min(numThreads, numItems));
+}
+
+
+// ****************************************************************************
+// Runs task(workerContext, i, t) for the items i = 0 ... numItems-1 on 
+// numThreads threads, where t is the index of the thread. Each thread creates
+// its own context with the speaker of the given context at its first item.
+// The result of the task (1 if the context of the thread could not be 
+// created) is written in results[i] if results is not NULL.
+// Returns the number of items with a nonzero result.
+// ****************************************************************************
+
+static int runOnWorkerContexts(VtlContext *context, int numItems, int numThreads,
+  int *results, const function<int(VtlContext*, int, int)> &task)
+{
+  atomic<int> numFailed(0);
+  const string speakerFileName = context->speakerFileName;
+  vector<VtlContext*> workerContexts(numThreads, NULL);
+  vector<char> contextCreated(numThreads, false);
+
+  parallelLoopIndexed(numItems, numThreads, [&](int i, int t)
+    {
+      if (!contextCreated[t])
+      {
+        workerContexts[t] = vtlCreateContext(speakerFileName.c_str());
+        contextCreated[t] = true;
+      }
+
+      int result = 1;
+      if (workerContexts[t] != NULL)
+      {
+        result = task(workerContexts[t], i, t);
+      }
+      if (result != 0) { numFailed++; }
+      if (results != NULL) { results[i] = result; }
+    });
+
+  for (auto workerContext : workerContexts)
+  {
+    if (workerContext != NULL)
+    {
+      vtlCloseContext(workerContext);
+    }
+  }
+
+  return numFailed;
+}
+
+
+// ****************************************************************************
+// Creates a synthesis context with the models of the given speaker file, 
+// e.g. "JD2.speaker". The context must be released with vtlCloseContext().
+// Return value: the new context, or NULL if loading the speaker file failed.
+// ****************************************************************************
+
+VtlContext *vtlCreateContext(const char *speakerFileName)
+{
+  VtlContext *context = new VtlContext();
 
   // ****************************************************************
   // Init the vocal tract.
   // ****************************************************************
 
-  vocalTract = new VocalTract();
-  vocalTract->calculateAll();
+  // The geometry is calculated when the speaker was loaded.
+  context->vocalTract = new VocalTract();
 
   // ****************************************************************
   // Init the list with glottis models
   // ****************************************************************
 
-  glottis[GEOMETRIC_GLOTTIS] = new GeometricGlottis();
-  glottis[TWO_MASS_MODEL] = new TwoMassModel();
-  glottis[TRIANGULAR_GLOTTIS] = new TriangularGlottis();
+  context->glottis[GEOMETRIC_GLOTTIS] = new GeometricGlottis();
+  context->glottis[TWO_MASS_MODEL] = new TwoMassModel();
+  context->glottis[TRIANGULAR_GLOTTIS] = new TriangularGlottis();
   
-  selectedGlottis = GEOMETRIC_GLOTTIS;
+  context->selectedGlottis = GEOMETRIC_GLOTTIS;
 
-  bool ok = vtlLoadSpeaker(speakerFileName, vocalTract, glottis, selectedGlottis);
+  bool ok = vtlLoadSpeaker(speakerFileName, context->vocalTract, 
+    context->glottis, context->selectedGlottis);
 
   if (ok == false)
   {
     int i;
     for (i = 0; i < NUM_GLOTTIS_MODELS; i++)
     {
-      delete glottis[i];
+      delete context->glottis[i];
     }
-    delete vocalTract;
+    delete context->vocalTract;
+    delete context;
 
-    printf("Error in vtlInitialize(): vtlLoadSpeaker() failed.\n");
-    return 1;
+    printf("Error in vtlCreateContext(): vtlLoadSpeaker() failed.\n");
+    return NULL;
   }
 
   // ****************************************************************
   // Init the object for the time domain simulation.
   // ****************************************************************
 
-  tdsModel = new TdsModel();
+  context->tdsModel = new TdsModel();
 
   // ****************************************************************
   // Init the Synthesizer object.
   // ****************************************************************
 
-  synthesizer = new Synthesizer();
-  synthesizer->init(glottis[selectedGlottis], vocalTract, tdsModel);
+  context->synthesizer = new Synthesizer();
+  context->synthesizer->init(context->glottis[context->selectedGlottis], 
+    context->vocalTract, context->tdsModel);
 
-  tube = new Tube();
+  context->tube = new Tube();
+  context->speakerFileName = string(speakerFileName);
 
-  // We are now initialized!
-  vtlApiInitialized = true;
-
-  return 0;
+  return context;
 }
 
 
 // ****************************************************************************
-// Clean up the memory and shut down the synthesizer.
+// Releases the models of a context created with vtlCreateContext().
 // Return values:
 // 0: success.
-// 1: The API was not initialized.
+// 1: The context is NULL.
 // ****************************************************************************
 
-int vtlClose()
+int vtlCloseContext(VtlContext *context)
 {
-  if (!vtlApiInitialized)
+  if (!vtlCheckContext(context))
   {
-    printf("Error: The API was not initialized.\n");
     return 1;
   }
 
-  delete synthesizer;
-  delete tdsModel;
+  delete context->synthesizer;
+  delete context->tdsModel;
+  delete context->tube;
 
   int i;
   for (i = 0; i < NUM_GLOTTIS_MODELS; i++)
   {
-    delete glottis[i];
+    delete context->glottis[i];
   }
 
-  delete vocalTract;
+  delete context->vocalTract;
+  delete context;
+
+  return 0;
+}
 
-  vtlApiInitialized = false;
+
+// ****************************************************************************
+// Init. the synthesis with the given speaker file name, e.g. "JD2.speaker".
+// This function should be called before any other function of this API.
+// Return values:
+// 0: success.
+// 1: Loading the speaker file failed.
+// ****************************************************************************
+
+int vtlInitialize(const char *speakerFileName)
+{
+  if (defaultContext != NULL)
+  {
+    vtlClose();
+  }
+
+  defaultContext = vtlCreateContext(speakerFileName);
+
+  if (defaultContext == NULL)
+  {
+    printf("Error in vtlInitialize(): vtlLoadSpeaker() failed.\n");
+    return 1;
+  }
+
+  return 0;
+}
+
+
+// ****************************************************************************
+// Clean up the memory and shut down the synthesizer.
+// Return values:
+// 0: success.
+// 1: The API was not initialized.
+// ****************************************************************************
+
+int vtlClose()
+{
+  if (defaultContext == NULL)
+  {
+    printf("Error: The API was not initialized.\n");
+    return 1;
+  }
+
+  vtlCloseContext(defaultContext);
+  defaultContext = NULL;
   
   return 0;
 }
@@ -299,24 +484,35 @@ void vtlGetVersion(char *version)
 // 1: The API has not been initialized.
 // ****************************************************************************
 
-int vtlGetConstants(int *audioSamplingRate, int *numTubeSections,
+int vtlGetConstantsCtx(VtlContext *context, int *audioSamplingRate, int *numTubeSections,
   int *numVocalTractParams, int *numGlottisParams)
 {
-  if (!vtlApiInitialized)
+  if (!vtlCheckContext(context))
   {
-    printf("Error: The API has not been initialized.\n");
     return 1;
   }
 
   *audioSamplingRate = SAMPLING_RATE;
   *numTubeSections = Tube::NUM_PHARYNX_MOUTH_SECTIONS;
   *numVocalTractParams = VocalTract::NUM_PARAMS;
-  *numGlottisParams = (int)glottis[selectedGlottis]->controlParam.size();
+  *numGlottisParams = (int)context->glottis[context->selectedGlottis]->controlParam.size();
 
   return 0;
 }
 
 
+// ****************************************************************************
+// Same as vtlGetConstantsCtx() for the context of vtlInitialize().
+// ****************************************************************************
+
+int vtlGetConstants(int *audioSamplingRate, int *numTubeSections,
+  int *numVocalTractParams, int *numGlottisParams)
+{
+  return vtlGetConstantsCtx(defaultContext, audioSamplingRate, numTubeSections,
+    numVocalTractParams, numGlottisParams);
+}
+
+
 // ****************************************************************************
 // Returns for each vocal tract parameter the minimum value, the maximum value,
 // and the neutral value. Each vector passed to this function must have at 
@@ -329,11 +525,11 @@ int vtlGetConstants(int *audioSamplingRate, int *numTubeSections,
 // 1: The API has not been initialized.
 // ****************************************************************************
 
-int vtlGetTractParamInfo(char *names, double *paramMin, double *paramMax, double *paramNeutral)
+int vtlGetTractParamInfoCtx(VtlContext *context, char *names, double *paramMin, 
+  double *paramMax, double *paramNeutral)
 {
-  if (!vtlApiInitialized)
+  if (!vtlCheckContext(context))
   {
-    printf("Error: The API has not been initialized.\n");
     return 1;
   }
 
@@ -343,21 +539,32 @@ int vtlGetTractParamInfo(char *names, double *paramMin, double *paramMax, double
 
   for (i=0; i < VocalTract::NUM_PARAMS; i++)
   {
-    strcat(names, vocalTract->param[i].abbr.c_str());
+    strcat(names, context->vocalTract->param[i].abbr.c_str());
     if (i != VocalTract::NUM_PARAMS - 1)
     {
       strcat(names, " ");
     }
 
-    paramMin[i] = vocalTract->param[i].min;
-    paramMax[i] = vocalTract->param[i].max;
-    paramNeutral[i] = vocalTract->param[i].neutral;
+    paramMin[i] = context->vocalTract->param[i].min;
+    paramMax[i] = context->vocalTract->param[i].max;
+    paramNeutral[i] = context->vocalTract->param[i].neutral;
   }
 
   return 0;
 }
 
 
+// ****************************************************************************
+// Same as vtlGetTractParamInfoCtx() for the context of vtlInitialize().
+// ****************************************************************************
+
+int vtlGetTractParamInfo(char *names, double *paramMin, double *paramMax, double *paramNeutral)
+{
+  return vtlGetTractParamInfoCtx(defaultContext, names, paramMin, paramMax,
+    paramNeutral);
+}
+
+
 // ****************************************************************************
 // Returns for each glottis model parameter the minimum value, the maximum value,
 // and the neutral value. Each vector passed to this function must have at 
@@ -370,36 +577,48 @@ int vtlGetTractParamInfo(char *names, double *paramMin, double *paramMax, double
 // 1: The API has not been initialized.
 // ****************************************************************************
 
-int vtlGetGlottisParamInfo(char *names, double *paramMin, double *paramMax, double *paramNeutral)
+int vtlGetGlottisParamInfoCtx(VtlContext *context, char *names, double *paramMin, 
+  double *paramMax, double *paramNeutral)
 {
-  if (!vtlApiInitialized)
+  if (!vtlCheckContext(context))
   {
-    printf("Error: The API has not been initialized.\n");
     return 1;
   }
 
   int i;
-  int numGlottisParams = (int)glottis[selectedGlottis]->controlParam.size();
+  Glottis *glottis = context->glottis[context->selectedGlottis];
+  int numGlottisParams = (int)glottis->controlParam.size();
 
   strcpy(names, "");
 
   for (i=0; i < numGlottisParams; i++)
   {
-    strcat(names, glottis[selectedGlottis]->controlParam[i].abbr.c_str());
+    strcat(names, glottis->controlParam[i].abbr.c_str());
     if (i != VocalTract::NUM_PARAMS - 1)
     {
       strcat(names, " ");
     }
 
-    paramMin[i] = glottis[selectedGlottis]->controlParam[i].min;
-    paramMax[i] = glottis[selectedGlottis]->controlParam[i].max;
-    paramNeutral[i] = glottis[selectedGlottis]->controlParam[i].neutral;
+    paramMin[i] = glottis->controlParam[i].min;
+    paramMax[i] = glottis->controlParam[i].max;
+    paramNeutral[i] = glottis->controlParam[i].neutral;
   }
 
   return 0;
 }
 
 
+// ****************************************************************************
+// Same as vtlGetGlottisParamInfoCtx() for the context of vtlInitialize().
+// ****************************************************************************
+
+int vtlGetGlottisParamInfo(char *names, double *paramMin, double *paramMax, double *paramNeutral)
+{
+  return vtlGetGlottisParamInfoCtx(defaultContext, names, paramMin, paramMax,
+    paramNeutral);
+}
+
+
 // ****************************************************************************
 // Returns the vocal tract parameters for the given shape as defined in the
 // speaker file.
@@ -412,15 +631,14 @@ int vtlGetGlottisParamInfo(char *names, double *paramMin, double *paramMax, doub
 // 2: A shape with the given name does not exist.
 // ****************************************************************************
 
-int vtlGetTractParams(const char *shapeName, double *param)
+int vtlGetTractParamsCtx(VtlContext *context, const char *shapeName, double *param)
 {
-  if (!vtlApiInitialized)
+  if (!vtlCheckContext(context))
   {
-    printf("Error: The API has not been initialized.\n");
     return 1;
   }
 
-  int index = vocalTract->getShapeIndex(string(shapeName));
+  int index = context->vocalTract->getShapeIndex(string(shapeName));
   if (index == -1)
   {
     return 2;
@@ -429,13 +647,23 @@ int vtlGetTractParams(const char *shapeName, double *param)
   int i;
   for (i=0; i < VocalTract::NUM_PARAMS; i++)
   {
-    param[i] = vocalTract->shapes[index].param[i];
+    param[i] = context->vocalTract->shapes[index].param[i];
   }
 
   return 0;
 }
 
 
+// ****************************************************************************
+// Same as vtlGetTractParamsCtx() for the context of vtlInitialize().
+// ****************************************************************************
+
+int vtlGetTractParams(const char *shapeName, double *param)
+{
+  return vtlGetTractParamsCtx(defaultContext, shapeName, param);
+}
+
+
 // ****************************************************************************
 // Exports the vocal tract contours for the given vector of vocal tract
 // parameters as a SVG file (scalable vector graphics).
@@ -446,33 +674,32 @@ int vtlGetTractParams(const char *shapeName, double *param)
 // 2: Writing the SVG file failed.
 // ****************************************************************************
 
-int vtlExportTractSvg(double *tractParams, const char *fileName)
+int vtlExportTractSvgCtx(VtlContext *context, double *tractParams, const char *fileName)
 {
-  if (!vtlApiInitialized)
+  if (!vtlCheckContext(context))
   {
-    printf("Error: The API has not been initialized.\n");
     return 1;
   }
 
   // Store the current control parameter values.
-  vocalTract->storeControlParams();
+  context->vocalTract->storeControlParams();
 
   // Set the given vocal tract parameters.
   int i;
   for (i = 0; i < VocalTract::NUM_PARAMS; i++)
   {
-    vocalTract->param[i].x = tractParams[i];
+    context->vocalTract->param[i].x = tractParams[i];
   }
-  vocalTract->calculateAll();
+  context->vocalTract->calculateAll();
   
   // Save the contour as SVG file.
-  bool ok = vocalTract->exportTractContourSvg(string(fileName), false, false);
+  bool ok = context->vocalTract->exportTractContourSvg(string(fileName), false, false);
   
   // Restore the previous control parameter values and 
   // recalculate the vocal tract shape.
 
-  vocalTract->restoreControlParams();
-  vocalTract->calculateAll();
+  context->vocalTract->restoreControlParams();
+  context->vocalTract->calculateAll();
 
   if (ok)
   {
@@ -486,33 +713,190 @@ int vtlExportTractSvg(double *tractParams, const char *fileName)
 
 
 // ****************************************************************************
-// Provides the tube data (especially the area function) for the given vector
-// of tractParams. The vectors tubeLength_cm, tubeArea_cm2, and tubeArticulator, 
-// must each have as many elements as tube sections.
-// The values incisorPos_cm, tongueTipSideElevation, and velumOpening_cm2 are 
-// one double value each.
+// Same as vtlExportTractSvgCtx() for the context of vtlInitialize().
+// ****************************************************************************
+
+int vtlExportTractSvg(double *tractParams, const char *fileName)
+{
+  return vtlExportTractSvgCtx(defaultContext, tractParams, fileName);
+}
+
+
+// ****************************************************************************
+// Writes the mesh of the current vocal tract shape in the given format
+// (0: ASCII STL, 1: binary STL, 2: Wavefront OBJ).
+// ****************************************************************************
+
+static bool exportTractMesh(VocalTract *vocalTract, const char *fileName, int format)
+{
+  switch (format)
+  {
+  case 0: return vocalTract->exportVocalTractToSTL(string(fileName), false);
+  case 1: return vocalTract->exportVocalTractToSTL(string(fileName), true);
+  case 2: return vocalTract->saveAsObjFile(string(fileName));
+  default: return false;
+  }
+}
+
+
+// ****************************************************************************
+// Exports the vocal tract surfaces for the given vector of vocal tract 
+// parameters as a mesh file.
+//
+// Parameters:
+// o tractParams (in): The vocal tract parameters.
+// o fileName (in): The name of the mesh file.
+// o format (in): 0: ASCII STL, 1: binary STL, 2: Wavefront OBJ (with the 
+//     material file of the same name with the extension .mtl).
 //
 // Function return value:
 // 0: success.
 // 1: The API has not been initialized.
+// 2: Writing the file failed.
+// 3: The format is unknown.
 // ****************************************************************************
 
-int vtlTractToTube(double *tractParams,
-  double *tubeLength_cm, double *tubeArea_cm2, int *tubeArticulator,
-  double *incisorPos_cm, double *tongueTipSideElevation, double *velumOpening_cm2)
+int vtlExportTractMeshCtx(VtlContext *context, double *tractParams, 
+  const char *fileName, int format)
 {
-  if (!vtlApiInitialized)
+  if (!vtlCheckContext(context))
   {
-    printf("Error: The API has not been initialized.\n");
     return 1;
   }
 
-  // ****************************************************************
+  if ((format < 0) || (format > 2))
+  {
+    return 3;
+  }
+
   // Store the current control parameter values.
-  // ****************************************************************
+  context->vocalTract->storeControlParams();
+
+  // Set the given vocal tract parameters.
+  int i;
+  for (i = 0; i < VocalTract::NUM_PARAMS; i++)
+  {
+    context->vocalTract->param[i].x = tractParams[i];
+  }
+  context->vocalTract->calculateAll();
+
+  bool ok = exportTractMesh(context->vocalTract, fileName, format);
+
+  // Restore the previous control parameter values and 
+  // recalculate the vocal tract shape.
+
+  context->vocalTract->restoreControlParams();
+  context->vocalTract->calculateAll();
+
+  if (ok)
+  {
+    return 0;
+  }
+  else
+  {
+    return 2;
+  }
+}
+
 
-  vocalTract->storeControlParams();
+// ****************************************************************************
+// Same as vtlExportTractMeshCtx() for the context of vtlInitialize().
+// ****************************************************************************
+
+int vtlExportTractMesh(double *tractParams, const char *fileName, int format)
+{
+  return vtlExportTractMeshCtx(defaultContext, tractParams, fileName, format);
+}
+
+
+// ****************************************************************************
+// Exports the meshes of a sequence of vocal tract shapes (e.g. the frames of
+// an animation) like vtlExportTractMesh() on a pool of worker threads. Each 
+// worker creates its own context with the speaker of the given context, so 
+// that the shapes are calculated and written in parallel.
+//
+// Parameters:
+// o tractParams (in): The numFrames vectors of vocal tract parameters, 
+//     one after the other.
+// o numFrames (in): The number of meshes to export.
+// o fileNames (in): The names of the numFrames mesh files.
+// o format (in): The format of the files like for vtlExportTractMesh().
+// o numThreads (in): The number of worker threads. For numThreads <= 0, 
+//     all the workers of the thread pool are used (see vtlSetThreadPool()).
+// o results (out): If not NULL, receives for each frame the return value of
+//     vtlExportTractMesh(). The array must have numFrames elements.
+//
+// Function return value:
+// 0: success.
+// 1: The API was not initialized.
+// 2: The export of at least one frame failed.
+// 3: The format is unknown.
+// ****************************************************************************
+
+int vtlExportTractMeshesCtx(VtlContext *context, double *tractParams, 
+  int numFrames, const char **fileNames, int format, int numThreads, int *results)
+{
+  if (!vtlCheckContext(context))
+  {
+    return 1;
+  }
+
+  if ((format < 0) || (format > 2))
+  {
+    return 3;
+  }
+
+  numThreads = getNumBatchThreads(numThreads, numFrames);
+
+  int numFailed = runOnWorkerContexts(context, numFrames, numThreads, results,
+    [&](VtlContext *workerContext, int i, int)
+    {
+      int k;
 
+      // The worker context is not shared, so that its control 
+      // parameters need not be restored.
+      for (k = 0; k < VocalTract::NUM_PARAMS; k++)
+      {
+        workerContext->vocalTract->param[k].x = 
+          tractParams[i * VocalTract::NUM_PARAMS + k];
+      }
+      workerContext->vocalTract->calculateAll();
+      return exportTractMesh(workerContext->vocalTract, fileNames[i], 
+        format) ? 0 : 2;
+    });
+
+  if (numFailed > 0)
+  {
+    printf("Error in vtlExportTractMeshes(): The export of %d of %d frames failed.\n",
+      numFailed, numFrames);
+    return 2;
+  }
+
+  return 0;
+}
+
+
+// ****************************************************************************
+// Same as vtlExportTractMeshesCtx() for the context of vtlInitialize().
+// ****************************************************************************
+
+int vtlExportTractMeshes(double *tractParams, int numFrames, 
+  const char **fileNames, int format, int numThreads, int *results)
+{
+  return vtlExportTractMeshesCtx(defaultContext, tractParams, numFrames, 
+    fileNames, format, numThreads, results);
+}
+
+
+// ****************************************************************************
+// Sets the given vocal tract parameters and copies the tube data of the new
+// vocal tract shape to the user arrays (without restoring the parameters).
+// ****************************************************************************
+
+static void getTubeData(VocalTract *vocalTract, double *tractParams,
+  double *tubeLength_cm, double *tubeArea_cm2, int *tubeArticulator,
+  double *incisorPos_cm, double *tongueTipSideElevation, double *velumOpening_cm2)
+{
   // ****************************************************************
   // Set the given vocal tract parameters.
   // ****************************************************************
@@ -548,19 +932,163 @@ int vtlTractToTube(double *tractParams,
   *incisorPos_cm = tube.teethPosition_cm;
   *tongueTipSideElevation = tube.tongueTipSideElevation;
   *velumOpening_cm2 = tube.getVelumOpening_cm2();
+}
+
+
+// ****************************************************************************
+// Provides the tube data (especially the area function) for the given vector
+// of tractParams. The vectors tubeLength_cm, tubeArea_cm2, and tubeArticulator, 
+// must each have as many elements as tube sections.
+// The values incisorPos_cm, tongueTipSideElevation, and velumOpening_cm2 are 
+// one double value each.
+//
+// Function return value:
+// 0: success.
+// 1: The API has not been initialized.
+// ****************************************************************************
+
+int vtlTractToTubeCtx(VtlContext *context, double *tractParams,
+  double *tubeLength_cm, double *tubeArea_cm2, int *tubeArticulator,
+  double *incisorPos_cm, double *tongueTipSideElevation, double *velumOpening_cm2)
+{
+  if (!vtlCheckContext(context))
+  {
+    return 1;
+  }
+
+  // ****************************************************************
+  // Store the current control parameter values.
+  // ****************************************************************
+
+  context->vocalTract->storeControlParams();
+
+  getTubeData(context->vocalTract, tractParams, tubeLength_cm, tubeArea_cm2,
+    tubeArticulator, incisorPos_cm, tongueTipSideElevation, velumOpening_cm2);
 
   // ****************************************************************
   // Restore the previous control parameter values and 
   // recalculate the vocal tract shape.
   // ****************************************************************
 
-  vocalTract->restoreControlParams();
-  vocalTract->calculateAll();
+  context->vocalTract->restoreControlParams();
+  context->vocalTract->calculateAll();
 
   return 0;
 }
 
 
+// ****************************************************************************
+// Same as vtlTractToTubeCtx() for the context of vtlInitialize().
+// ****************************************************************************
+
+int vtlTractToTube(double *tractParams,
+  double *tubeLength_cm, double *tubeArea_cm2, int *tubeArticulator,
+  double *incisorPos_cm, double *tongueTipSideElevation, double *velumOpening_cm2)
+{
+  return vtlTractToTubeCtx(defaultContext, tractParams, tubeLength_cm,
+    tubeArea_cm2, tubeArticulator, incisorPos_cm, tongueTipSideElevation,
+    velumOpening_cm2);
+}
+
+
+// ****************************************************************************
+// Provides the tube data like vtlTractToTube() for numVectors vectors of 
+// tract parameters, computed in parallel on numThreads worker threads with
+// their own contexts. The data of the vector i are written at the index 
+// i*numTubeSections of tubeLength_cm, tubeArea_cm2, and tubeArticulator, and
+// at the index i of incisorPos_cm, tongueTipSideElevation, and 
+// velumOpening_cm2.
+//
+// Function return value:
+// 0: success.
+// 1: The API has not been initialized.
+// 2: The worker contexts could not be created.
+// ****************************************************************************
+
+int vtlTractsToTubesCtx(VtlContext *context, double *tractParams, 
+  int numVectors, double *tubeLength_cm, double *tubeArea_cm2, 
+  int *tubeArticulator, double *incisorPos_cm, double *tongueTipSideElevation, 
+  double *velumOpening_cm2, int numThreads)
+{
+  if (!vtlCheckContext(context))
+  {
+    return 1;
+  }
+
+  numThreads = getNumBatchThreads(numThreads, numVectors);
+  const int N = Tube::NUM_PHARYNX_MOUTH_SECTIONS;
+
+  int numFailed = runOnWorkerContexts(context, numVectors, numThreads, NULL,
+    [&](VtlContext *workerContext, int i, int)
+    {
+      getTubeData(workerContext->vocalTract, 
+        &tractParams[i * VocalTract::NUM_PARAMS], &tubeLength_cm[i * N],
+        &tubeArea_cm2[i * N], &tubeArticulator[i * N], &incisorPos_cm[i],
+        &tongueTipSideElevation[i], &velumOpening_cm2[i]);
+      return 0;
+    });
+
+  if (numFailed > 0)
+  {
+    printf("Error in vtlTractsToTubes(): %d of %d vectors were not processed.\n",
+      numFailed, numVectors);
+    return 2;
+  }
+
+  return 0;
+}
+
+
+// ****************************************************************************
+// Same as vtlTractsToTubesCtx() for the context of vtlInitialize().
+// ****************************************************************************
+
+int vtlTractsToTubes(double *tractParams, int numVectors,
+  double *tubeLength_cm, double *tubeArea_cm2, int *tubeArticulator,
+  double *incisorPos_cm, double *tongueTipSideElevation, double *velumOpening_cm2,
+  int numThreads)
+{
+  return vtlTractsToTubesCtx(defaultContext, tractParams, numVectors,
+    tubeLength_cm, tubeArea_cm2, tubeArticulator, incisorPos_cm,
+    tongueTipSideElevation, velumOpening_cm2, numThreads);
+}
+
+
+// ****************************************************************************
+// Calculates the transfer function of the vocal tract shape of the given
+// parameters with the given TL model (numSpectrumSamples >= 16).
+// ****************************************************************************
+
+static void calcTransferFunction(VocalTract *vocalTract, TlModel *tlModel,
+  double *tractParams, int numSpectrumSamples, double *magnitude, double *phase_rad)
+{
+  int i;
+  ComplexSignal s;
+
+  // Calculate the vocal tract shape from the vocal tract parameters.
+
+  for (i = 0; i < VocalTract::NUM_PARAMS; i++)
+  {
+    vocalTract->param[i].x = tractParams[i];
+  }
+  vocalTract->calculateAll();
+
+  // Calculate the transfer function.
+
+  vocalTract->getTube(&tlModel->tube);
+  tlModel->tube.setGlottisArea(0.0);
+  tlModel->getSpectrum(TlModel::FLOW_SOURCE_TF, &s, numSpectrumSamples, Tube::FIRST_PHARYNX_SECTION);
+
+  // Separate the transfer function into magnitude and phase.
+
+  for (i = 0; i < numSpectrumSamples; i++)
+  {
+    magnitude[i] = s.getMagnitude(i);
+    phase_rad[i] = s.getPhase(i);
+  }
+}
+
+
 // ****************************************************************************
 // Calculates the volume velocity transfer function of the vocal tract between 
 // the glottis and the lips for the given vector of vocal tract parameters and
@@ -592,49 +1120,104 @@ int vtlTractToTube(double *tractParams,
 // 1: The API has not been initialized.
 // ****************************************************************************
 
+int vtlGetTransferFunctionCtx(VtlContext *context, double *tractParams, 
+  int numSpectrumSamples, double *magnitude, double *phase_rad)
+{
+  if (!vtlCheckContext(context))
+  {
+    return 1;
+  }
+
+  if (numSpectrumSamples < 16)
+  {
+    numSpectrumSamples = 16;
+  }
+
+  TlModel *tlModel = new TlModel();
+  calcTransferFunction(context->vocalTract, tlModel, tractParams, 
+    numSpectrumSamples, magnitude, phase_rad);
+  delete tlModel;
+
+  return 0;
+}
+
+
+// ****************************************************************************
+// Same as vtlGetTransferFunctionCtx() for the context of vtlInitialize().
+// ****************************************************************************
+
 int vtlGetTransferFunction(double *tractParams, int numSpectrumSamples,
   double *magnitude, double *phase_rad)
 {
-  if (!vtlApiInitialized)
+  return vtlGetTransferFunctionCtx(defaultContext, tractParams,
+    numSpectrumSamples, magnitude, phase_rad);
+}
+
+
+// ****************************************************************************
+// Calculates the transfer functions like vtlGetTransferFunction() for 
+// numVectors vectors of tract parameters, computed in parallel on numThreads
+// worker threads with their own contexts and TL models. The spectrum of the
+// vector i is written at the index i*numSpectrumSamples of magnitude and 
+// phase_rad (numSpectrumSamples must be at least 16).
+//
+// Function return value:
+// 0: success.
+// 1: The API has not been initialized.
+// 2: The worker contexts could not be created.
+// 3: numSpectrumSamples is less than 16.
+// ****************************************************************************
+
+int vtlGetTransferFunctionsCtx(VtlContext *context, double *tractParams, 
+  int numVectors, int numSpectrumSamples, double *magnitude, double *phase_rad,
+  int numThreads)
+{
+  if (!vtlCheckContext(context))
   {
-    printf("Error: The API has not been initialized.\n");
     return 1;
   }
 
-  int i;
-  ComplexSignal s;
-
+  // the spectra are stored one after the other
   if (numSpectrumSamples < 16)
   {
-    numSpectrumSamples = 16;
+    return 3;
   }
 
-  // Calculate the vocal tract shape from the vocal tract parameters.
+  numThreads = getNumBatchThreads(numThreads, numVectors);
+  // one TL model per thread, so that its tables are allocated only once
+  vector<unique_ptr<TlModel>> tlModels(numThreads);
 
-  for (i = 0; i < VocalTract::NUM_PARAMS; i++)
+  int numFailed = runOnWorkerContexts(context, numVectors, numThreads, NULL,
+    [&](VtlContext *workerContext, int i, int t)
+    {
+      if (!tlModels[t]) { tlModels[t].reset(new TlModel()); }
+      long long offset = (long long)i * numSpectrumSamples;
+      calcTransferFunction(workerContext->vocalTract, tlModels[t].get(),
+        &tractParams[i * VocalTract::NUM_PARAMS], numSpectrumSamples,
+        &magnitude[offset], &phase_rad[offset]);
+      return 0;
+    });
+
+  if (numFailed > 0)
   {
-    vocalTract->param[i].x = tractParams[i];
+    printf("Error in vtlGetTransferFunctions(): %d of %d vectors were not processed.\n",
+      numFailed, numVectors);
+    return 2;
   }
-  vocalTract->calculateAll();
-
-  // Calculate the transfer function.
-
-  TlModel *tlModel = new TlModel();
-  vocalTract->getTube(&tlModel->tube);
-  tlModel->tube.setGlottisArea(0.0);
-  tlModel->getSpectrum(TlModel::FLOW_SOURCE_TF, &s, numSpectrumSamples, Tube::FIRST_PHARYNX_SECTION);
 
-  // Separate the transfer function into magnitude and phase.
+  return 0;
+}
 
-  for (i = 0; i < numSpectrumSamples; i++)
-  {
-    magnitude[i] = s.getMagnitude(i);
-    phase_rad[i] = s.getPhase(i);
-  }
 
-  delete tlModel;
+// ****************************************************************************
+// Same as vtlGetTransferFunctionsCtx() for the context of vtlInitialize().
+// ****************************************************************************
 
-  return 0;
+int vtlGetTransferFunctions(double *tractParams, int numVectors, 
+  int numSpectrumSamples, double *magnitude, double *phase_rad, int numThreads)
+{
+  return vtlGetTransferFunctionsCtx(defaultContext, tractParams, numVectors,
+    numSpectrumSamples, magnitude, phase_rad, numThreads);
 }
 
 
@@ -653,11 +1236,11 @@ int vtlGetTransferFunction(double *tractParams, int numSpectrumSamples,
 // 1: The API has not been initialized.
 // ****************************************************************************
 
-int vtlInputTractToLimitedTract(double* inTractParams, double* outTractParams)
+int vtlInputTractToLimitedTractCtx(VtlContext *context, double* inTractParams, 
+  double* outTractParams)
 {
-    if (!vtlApiInitialized)
+    if (!vtlCheckContext(context))
     {
-        printf("Error: The API has not been initialized.\n");
         return 1;
     }
 
@@ -665,19 +1248,30 @@ int vtlInputTractToLimitedTract(double* inTractParams, double* outTractParams)
     int i;
     for (i = 0; i < VocalTract::NUM_PARAMS; i++)
     {
-        vocalTract->param[i].x = inTractParams[i];
+        context->vocalTract->param[i].x = inTractParams[i];
     }
-    vocalTract->calculateAll();
+    context->vocalTract->calculateAll();
 
     for (i = 0; i < VocalTract::NUM_PARAMS; i++)
     {
-        outTractParams[i] = vocalTract->param[i].limitedX;
+        outTractParams[i] = context->vocalTract->param[i].limitedX;
     }
 
     return 0;
 }
 
 
+// ****************************************************************************
+// Same as vtlInputTractToLimitedTractCtx() for the context of vtlInitialize().
+// ****************************************************************************
+
+int vtlInputTractToLimitedTract(double* inTractParams, double* outTractParams)
+{
+  return vtlInputTractToLimitedTractCtx(defaultContext, inTractParams,
+    outTractParams);
+}
+
+
 // ****************************************************************************
 // Resets the time-domain synthesis of continuous speech (using the functions
 // vtlSynthesisAddTube() or vtlSynthesisAddTract()). This function must be 
@@ -688,21 +1282,30 @@ int vtlInputTractToLimitedTract(double* inTractParams, double* outTractParams)
 // 1: The API has not been initialized.
 // ****************************************************************************
 
-int vtlSynthesisReset()
+int vtlSynthesisResetCtx(VtlContext *context)
 {
-  if (!vtlApiInitialized)
+  if (!vtlCheckContext(context))
   {
-    printf("Error: The API has not been initialized.\n");
     return 1;
   }
 
-  synthesizer->reset();
-  tube->resetDynamicPart();
+  context->synthesizer->reset();
+  context->tube->resetDynamicPart();
 
   return 0;
 }
 
 
+// ****************************************************************************
+// Same as vtlSynthesisResetCtx() for the context of vtlInitialize().
+// ****************************************************************************
+
+int vtlSynthesisReset()
+{
+  return vtlSynthesisResetCtx(defaultContext);
+}
+
+
 // ****************************************************************************
 // Synthesize a part of a speech signal with numNewSamples samples, during 
 // which the vocal tract tube changes linearly from the tube shape passed to
@@ -733,14 +1336,13 @@ int vtlSynthesisReset()
 //    numNewSamples != 0 during the first call of this function after reset).
 // ****************************************************************************
 
-int vtlSynthesisAddTube(int numNewSamples, double* audio,
+int vtlSynthesisAddTubeCtx(VtlContext *context, int numNewSamples, double* audio,
   double* tubeLength_cm, double* tubeArea_cm2, int* tubeArticulator,
   double incisorPos_cm, double velumOpening_cm2, double tongueTipSideElevation,
   double* newGlottisParams)
 {
-  if (!vtlApiInitialized)
+  if (!vtlCheckContext(context))
   {
-    printf("Error: The API has not been initialized.\n");
     return 1;
   }
 
@@ -753,17 +1355,17 @@ int vtlSynthesisAddTube(int numNewSamples, double* audio,
 
   // Set the properties of the target tube.
 
-  tube->setPharynxMouthGeometry(tubeLength_cm, tubeArea_cm2, articulator, 
+  context->tube->setPharynxMouthGeometry(tubeLength_cm, tubeArea_cm2, articulator, 
     incisorPos_cm, tongueTipSideElevation);
-  tube->setVelumOpening(velumOpening_cm2);
+  context->tube->setVelumOpening(velumOpening_cm2);
   // The aspiration strength will be set based on the glottis parameters
   // in synthesizer->add(...) below.
-  tube->setAspirationStrength(0.0);
+  context->tube->setAspirationStrength(0.0);
 
   // Synthesize the speech signal part.
 
   vector<double> audioVector;
-  synthesizer->add(newGlottisParams, tube, numNewSamples, audioVector);
+  context->synthesizer->add(newGlottisParams, context->tube, numNewSamples, audioVector);
 
   if ((int)audioVector.size() != numNewSamples)
   {
@@ -782,6 +1384,21 @@ int vtlSynthesisAddTube(int numNewSamples, double* audio,
 }
 
 
+// ****************************************************************************
+// Same as vtlSynthesisAddTubeCtx() for the context of vtlInitialize().
+// ****************************************************************************
+
+int vtlSynthesisAddTube(int numNewSamples, double* audio,
+  double* tubeLength_cm, double* tubeArea_cm2, int* tubeArticulator,
+  double incisorPos_cm, double velumOpening_cm2, double tongueTipSideElevation,
+  double* newGlottisParams)
+{
+  return vtlSynthesisAddTubeCtx(defaultContext, numNewSamples, audio,
+    tubeLength_cm, tubeArea_cm2, tubeArticulator, incisorPos_cm, velumOpening_cm2,
+    tongueTipSideElevation, newGlottisParams);
+}
+
+
 // ****************************************************************************
 // Synthesize a part of a speech signal with numNewSamples samples, during 
 // which the vocal tract changes linearly from the tract shape passed to
@@ -804,17 +1421,16 @@ int vtlSynthesisAddTube(int numNewSamples, double* audio,
 //    numNewSamples != 0 during the first call of this function after reset).
 // ****************************************************************************
 
-int vtlSynthesisAddTract(int numNewSamples, double *audio,
+int vtlSynthesisAddTractCtx(VtlContext *context, int numNewSamples, double *audio,
   double *tractParams, double *glottisParams)
 {
-  if (!vtlApiInitialized)
+  if (!vtlCheckContext(context))
   {
-    printf("Error: The API has not been initialized.\n");
     return 1;
   }
 
   vector<double> audioVector;
-  synthesizer->add(glottisParams, tractParams, numNewSamples, audioVector);
+  context->synthesizer->add(glottisParams, tractParams, numNewSamples, audioVector);
 
   if ((int)audioVector.size() != numNewSamples)
   {
@@ -834,6 +1450,18 @@ int vtlSynthesisAddTract(int numNewSamples, double *audio,
 }
 
 
+// ****************************************************************************
+// Same as vtlSynthesisAddTractCtx() for the context of vtlInitialize().
+// ****************************************************************************
+
+int vtlSynthesisAddTract(int numNewSamples, double *audio,
+  double *tractParams, double *glottisParams)
+{
+  return vtlSynthesisAddTractCtx(defaultContext, numNewSamples, audio,
+    tractParams, glottisParams);
+}
+
+
 // ****************************************************************************
 // Synthesize speech with a given sequence of vocal tract model states and 
 // glottis model states, and return the corresponding audio signal.
@@ -860,37 +1488,36 @@ int vtlSynthesisAddTract(int numNewSamples, double *audio,
 // 1: The API has not been initialized.
 // ****************************************************************************
 
-int vtlSynthBlock(double *tractParams, double *glottisParams,
+int vtlSynthBlockCtx(VtlContext *context, double *tractParams, double *glottisParams,
   int numFrames, int frameStep_samples, double *audio, int enableConsoleOutput)
 {
-  if (!vtlApiInitialized)
+  if (!vtlCheckContext(context))
   {
-    printf("Error: The API has not been initialized.\n");
     return 1;
   }
 
   int i;
   int samplePos = 0;
-  int numGlottisParams = (int)glottis[selectedGlottis]->controlParam.size();
+  int numGlottisParams = (int)context->glottis[context->selectedGlottis]->controlParam.size();
 
   if (enableConsoleOutput != 0)
   {
     printf("Block synthesis in progress ...");
   }
 
-  vtlSynthesisReset();
+  vtlSynthesisResetCtx(context);
 
   for (i = 0; i < numFrames; i++)
   {
     if (i == 0)
     {
       // Only set the initial state of the vocal tract and glottis without generating audio.
-      vtlSynthesisAddTract(0, &audio[0],
+      vtlSynthesisAddTractCtx(context, 0, &audio[0],
         &tractParams[i*VocalTract::NUM_PARAMS], &glottisParams[i*numGlottisParams]);
     }
     else
     {
-      vtlSynthesisAddTract(frameStep_samples, &audio[samplePos],
+      vtlSynthesisAddTractCtx(context, frameStep_samples, &audio[samplePos],
         &tractParams[i*VocalTract::NUM_PARAMS], &glottisParams[i*numGlottisParams]);
       samplePos += frameStep_samples;
     }
@@ -910,6 +1537,207 @@ int vtlSynthBlock(double *tractParams, double *glottisParams,
 }
 
 
+// ****************************************************************************
+// Same as vtlSynthBlockCtx() for the context of vtlInitialize().
+// ****************************************************************************
+
+int vtlSynthBlock(double *tractParams, double *glottisParams,
+  int numFrames, int frameStep_samples, double *audio, int enableConsoleOutput)
+{
+  return vtlSynthBlockCtx(defaultContext, tractParams, glottisParams, numFrames,
+    frameStep_samples, audio, enableConsoleOutput);
+}
+
+
+// ****************************************************************************
+// Sets the number of audio samples between two updates of the tube geometry
+// during the synthesis (the control rate). The glottis is updated for each
+// sample in any case. The default value 1 updates the tube for each sample.
+// Greater values (e.g., 32 or 110) speed up the synthesis at the cost of a
+// piecewise constant instead of linear interpolation of the tube shape 
+// between the frames.
+//
+// Function return value:
+// 0: success.
+// 1: The API has not been initialized.
+// ****************************************************************************
+
+int vtlSetControlRateCtx(VtlContext *context, int numSamples)
+{
+  if (!vtlCheckContext(context))
+  {
+    return 1;
+  }
+
+  context->synthesizer->setControlRate(numSamples);
+
+  return 0;
+}
+
+
+// ****************************************************************************
+// Same as vtlSetControlRateCtx() for the context of vtlInitialize().
+// ****************************************************************************
+
+int vtlSetControlRate(int numSamples)
+{
+  return vtlSetControlRateCtx(defaultContext, numSamples);
+}
+
+
+// ****************************************************************************
+// Enables (enabled != 0) or disables the counters of the time domain 
+// simulation and clears them. The counters are accumulated by all following
+// syntheses until they are enabled again. They are disabled by default.
+//
+// Function return value:
+// 0: success.
+// 1: The API has not been initialized.
+// ****************************************************************************
+
+int vtlEnableTdsStatisticsCtx(VtlContext *context, int enabled)
+{
+  if (!vtlCheckContext(context))
+  {
+    return 1;
+  }
+
+  context->tdsModel->resetStatistics();
+  context->tdsModel->setStatisticsEnabled(enabled != 0);
+
+  return 0;
+}
+
+
+// ****************************************************************************
+// Same as vtlEnableTdsStatisticsCtx() for the context of vtlInitialize().
+// ****************************************************************************
+
+int vtlEnableTdsStatistics(int enabled)
+{
+  return vtlEnableTdsStatisticsCtx(defaultContext, enabled);
+}
+
+
+// ****************************************************************************
+// Returns the counters of the time domain simulation accumulated since 
+// vtlEnableTdsStatistics(), to compare the solvers on a workload.
+//
+// Parameters (in/out):
+// o counters (out): Array of 13 values: 
+//     0: number of simulated time steps,
+//     1-4: time (s) of the calculation of the network components, of the 
+//       matrix, of the solution of the system of equations and of the 
+//       update of the variables,
+//     5, 6: mean and max. number of SOR iterations per time step,
+//     7, 8: mean and max. norm of the residuum of the last SOR iteration,
+//     9, 10: number of stored matrix elements in the symmetric envelope of
+//       the Cholesky factorization and in the skyline storage,
+//     11: mean number of constrictions per time step, 
+//     12: mean number of active noise sources per time step.
+//     The SOR values are zero unless the SOR solver is selected.
+// o histogramFileName (in): Text file for the histograms of the counters 
+//     over the time steps, or NULL or "" to write no file.
+//
+// Function return value:
+// 0: success.
+// 1: The API has not been initialized.
+// 2: The histogram file could not be written.
+// ****************************************************************************
+
+int vtlGetTdsStatisticsCtx(VtlContext *context, double *counters, 
+  const char *histogramFileName)
+{
+  if (!vtlCheckContext(context))
+  {
+    return 1;
+  }
+
+  TdsModel::Statistics s = context->tdsModel->getStatistics();
+  double numSteps = (s.numTimeSteps > 0) ? (double)s.numTimeSteps : 1.0;
+  double numSorSteps = (s.numSorTimeSteps > 0) ? (double)s.numSorTimeSteps : 1.0;
+
+  counters[0] = (double)s.numTimeSteps;
+  counters[1] = s.prepareTime_s;
+  counters[2] = s.matrixTime_s;
+  counters[3] = s.solveTime_s;
+  counters[4] = s.updateTime_s;
+  counters[5] = (double)s.numSorIterations / numSorSteps;
+  counters[6] = (double)s.maxSorIterations;
+  counters[7] = s.sumSorResidualNorm / numSorSteps;
+  counters[8] = s.maxSorResidualNorm;
+  counters[9] = (double)s.envelopeSize;
+  counters[10] = (double)s.skylineSize;
+  counters[11] = (double)s.numConstrictions / numSteps;
+  counters[12] = (double)s.numActiveNoiseSources / numSteps;
+
+  if ((histogramFileName != NULL) && (histogramFileName[0] != '\0'))
+  {
+    if (context->tdsModel->writeStatistics(histogramFileName) == false)
+    {
+      return 2;
+    }
+  }
+
+  return 0;
+}
+
+
+// ****************************************************************************
+// Same as vtlGetTdsStatisticsCtx() for the context of vtlInitialize().
+// ****************************************************************************
+
+int vtlGetTdsStatistics(double *counters, const char *histogramFileName)
+{
+  return vtlGetTdsStatisticsCtx(defaultContext, counters, histogramFileName);
+}
+
+
+// ****************************************************************************
+// Enables or disables the binary snapshot of the speaker data for the 
+// speaker files loaded afterwards (by vtlInitialize() and vtlCreateContext()).
+// When enabled, the data of a speaker file "name.speaker" are saved to 
+// "name.speaker.cache" when the file is loaded from XML, and restored from 
+// there as long as the text of the speaker file does not change.
+// It is disabled by default.
+// Function return value:
+// 0: success.
+// ****************************************************************************
+
+int vtlUseSpeakerCache(int enabled)
+{
+  useSpeakerCache = (enabled != 0);
+  return 0;
+}
+
+
+// ****************************************************************************
+// Sets the pool of worker threads shared by all the parallel computations of
+// the library (see ParallelLoop.h).
+//
+// Parameters:
+// o numWorkers (in): The number of worker threads. For numWorkers <= 0, 
+//     one thread per hardware thread is used (default).
+// o pinWorkers (in): If not 0, each worker is bound to its own logical core.
+// o nestedParallelism (in): If not 0 (default), the parallel loops started 
+//     inside a parallel loop share the idle workers, else they run in 
+//     sequence in the calling thread.
+//
+// Function return value:
+// 0: success.
+// ****************************************************************************
+
+int vtlSetThreadPool(int numWorkers, int pinWorkers, int nestedParallelism)
+{
+  threadPoolSettings settings;
+  settings.numWorkers = numWorkers;
+  settings.pinWorkers = (pinWorkers != 0);
+  settings.nested = (nestedParallelism != 0) ? NESTED_IDLE_WORKERS : NESTED_SEQUENTIAL;
+  setThreadPoolSettings(settings);
+  return 0;
+}
+
+
 // ****************************************************************************
 // Test function for this API.
 // Audio should contain at least 44100 double values.
@@ -1149,7 +1977,9 @@ int vtlGetGesturalScoreDuration(const char* gesFileName, int* numAudioSamples,
 // ****************************************************************************
 // This function converts a tract sequence file into an audio signal or file.
 // Parameters:
-// o tractSequenceFileName (in): Name of the tract sequence file to synthesize.
+// o tractSequenceFileName (in): Name of the tract sequence file to synthesize,
+//     in the text format or in the binary format (see 
+//     vtlConvertSequenceFile()).
 // o wavFileName (in): Name of the audio file with the resulting speech signal.
 //     This can be the empty string "" if you do not want to save a WAV file.
 // o audio (out): The resulting audio signal with sample values in the range 
@@ -1166,12 +1996,11 @@ int vtlGetGesturalScoreDuration(const char* gesFileName, int* numAudioSamples,
 // 3: The WAV file could not be saved.
 // ****************************************************************************
 
-int vtlTractSequenceToAudio(const char* tractSequenceFileName, const char* wavFileName,
-  double* audio, int* numSamples)
+int vtlTractSequenceToAudioCtx(VtlContext *context, const char* tractSequenceFileName, 
+  const char* wavFileName, double* audio, int* numSamples)
 {
-  if (!vtlApiInitialized)
+  if (!vtlCheckContext(context))
   {
-    printf("Error: The API has not been initialized.\n");
     return 1;
   }
 
@@ -1179,7 +2008,8 @@ int vtlTractSequenceToAudio(const char* tractSequenceFileName, const char* wavFi
   vector<double> audioVector;
 
   bool ok = Synthesizer::synthesizeTractSequence(string(tractSequenceFileName),
-    glottis[selectedGlottis], vocalTract, tdsModel, audioVector);
+    context->glottis[context->selectedGlottis], context->vocalTract, context->tdsModel, 
+    audioVector);
 
   if (ok == false)
   {
@@ -1216,17 +2046,11 @@ int vtlTractSequenceToAudio(const char* tractSequenceFileName, const char* wavFi
 
   if (wavFileName[0] != '\0')
   {
-    AudioFile<double> audioFile;
-    audioFile.setAudioBufferSize(1, numVectorSamples);
-    audioFile.setBitDepth(16);
-    audioFile.setSampleRate(SAMPLING_RATE);
-
-    for (i = 0; i < numVectorSamples; i++)
-    {
-      audioFile.samples[0][i] = audioVector[i];
-    }
+    WaveFileWriter audioFile;
 
-    if (audioFile.save(string(wavFileName)) == false)
+    if ((audioFile.open(string(wavFileName), SAMPLING_RATE, 1) == false) ||
+      (audioFile.writeSamples(audioVector.data(), numVectorSamples) == false) ||
+      (audioFile.close() == false))
     {
       printf("Error in vtlTractSequenceToAudio(): The WAV file could not be saved!\n");
       return 3;
@@ -1238,4 +2062,112 @@ int vtlTractSequenceToAudio(const char* tractSequenceFileName, const char* wavFi
   return 0;
 }
 
+
+// ****************************************************************************
+// Same as vtlTractSequenceToAudioCtx() for the context of vtlInitialize().
+// ****************************************************************************
+
+int vtlTractSequenceToAudio(const char* tractSequenceFileName, const char* wavFileName,
+  double* audio, int* numSamples)
+{
+  return vtlTractSequenceToAudioCtx(defaultContext, tractSequenceFileName,
+    wavFileName, audio, numSamples);
+}
+
+
+// ****************************************************************************
+// Synthesizes a list of tract sequence files like vtlTractSequenceToAudio()
+// on a pool of worker threads. Each worker creates its own context with the
+// speaker of the given context, so that the files are rendered in parallel.
+//
+// Parameters:
+// o tractSequenceFileNames (in): The names of the numFiles tract sequence 
+//     files.
+// o wavFileNames (in): The names of the numFiles WAV files to write.
+// o numFiles (in): The number of files to synthesize.
+// o numThreads (in): The number of worker threads. For numThreads <= 0, 
+//     all the workers of the thread pool are used (see vtlSetThreadPool()).
+// o results (out): If not NULL, receives for each file the return value of
+//     vtlTractSequenceToAudio(). The array must have numFiles elements.
+//
+// Function return value:
+// 0: success.
+// 1: The API was not initialized.
+// 2: The synthesis of at least one file failed.
+// ****************************************************************************
+
+int vtlTractSequencesToAudioCtx(VtlContext *context, const char **tractSequenceFileNames,
+  const char **wavFileNames, int numFiles, int numThreads, int *results)
+{
+  if (!vtlCheckContext(context))
+  {
+    return 1;
+  }
+
+  numThreads = getNumBatchThreads(numThreads, numFiles);
+
+  int numFailed = runOnWorkerContexts(context, numFiles, numThreads, results,
+    [&](VtlContext *workerContext, int i, int)
+    {
+      return vtlTractSequenceToAudioCtx(workerContext,
+        tractSequenceFileNames[i], wavFileNames[i], NULL, NULL);
+    });
+
+  if (numFailed > 0)
+  {
+    printf("Error in vtlTractSequencesToAudio(): The synthesis of %d of %d files failed.\n",
+      numFailed, numFiles);
+    return 2;
+  }
+
+  return 0;
+}
+
+
+// ****************************************************************************
+// Same as vtlTractSequencesToAudioCtx() for the context of vtlInitialize().
+// ****************************************************************************
+
+int vtlTractSequencesToAudio(const char **tractSequenceFileNames, 
+  const char **wavFileNames, int numFiles, int numThreads, int *results)
+{
+  return vtlTractSequencesToAudioCtx(defaultContext, tractSequenceFileNames,
+    wavFileNames, numFiles, numThreads, results);
+}
+
+
+// ****************************************************************************
+// Converts a tract or tube sequence file between the text format and the 
+// binary format.
+//
+// Function return value:
+// 0: success.
+// 1: The input file could not be opened.
+// 2: The input file is corrupted or the output file could not be written.
+// ****************************************************************************
+
+int vtlConvertSequenceFile(const char *inputFileName, const char *outputFileName,
+  int isTubeSequence, int binaryOutput)
+{
+  SequenceFileReader reader;
+  string error;
+  sequenceType type = isTubeSequence ? TUBE_SEQUENCE : TRACT_SEQUENCE;
+
+  if (!reader.open(inputFileName, type, 0, error))
+  {
+    printf("Error in vtlConvertSequenceFile(): %s\n", error.c_str());
+    return 1;
+  }
+  reader.close();
+
+  if (!convertSequenceFile(inputFileName, outputFileName, type, 
+    binaryOutput != 0, error))
+  {
+    printf("Error in vtlConvertSequenceFile(): %s\n", error.c_str());
+    return 2;
+  }
+
+  return 0;
+}
+
 // ****************************************************************************
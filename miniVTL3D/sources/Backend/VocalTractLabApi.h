@@ -43,6 +43,10 @@ extern "C"{ /* start extern "C" */
   #define C_EXPORT
 #endif  // WIN32
 
+// Opaque handle of a synthesis context (see vtlCreateContext()).
+
+typedef struct VtlContext VtlContext;
+
 // ****************************************************************************
 // The exported C-compatible functions.
 // IMPORTANT: 
@@ -153,6 +157,54 @@ C_EXPORT int vtlGetTractParams(const char *shapeName, double *param);
 C_EXPORT int vtlExportTractSvg(double *tractParams, const char *fileName);
 
 
+// ****************************************************************************
+// Exports the vocal tract surfaces for the given vector of vocal tract 
+// parameters as a mesh file.
+//
+// Parameters:
+// o tractParams (in): The vocal tract parameters.
+// o fileName (in): The name of the mesh file.
+// o format (in): 0: ASCII STL, 1: binary STL, 2: Wavefront OBJ (with the 
+//     material file of the same name with the extension .mtl).
+//
+// Function return value:
+// 0: success.
+// 1: The API has not been initialized.
+// 2: Writing the file failed.
+// 3: The format is unknown.
+// ****************************************************************************
+
+C_EXPORT int vtlExportTractMesh(double *tractParams, const char *fileName, 
+  int format);
+
+
+// ****************************************************************************
+// Exports the meshes of a sequence of vocal tract shapes (e.g. the frames of
+// an animation) like vtlExportTractMesh() on a pool of worker threads. Each 
+// worker creates its own context with the speaker of the current context.
+//
+// Parameters:
+// o tractParams (in): The numFrames vectors of vocal tract parameters, 
+//     one after the other.
+// o numFrames (in): The number of meshes to export.
+// o fileNames (in): The names of the numFrames mesh files.
+// o format (in): The format of the files like for vtlExportTractMesh().
+// o numThreads (in): The number of worker threads. For numThreads <= 0, 
+//     all the workers of the thread pool are used (see vtlSetThreadPool()).
+// o results (out): If not NULL, receives for each frame the return value of
+//     vtlExportTractMesh(). The array must have numFrames elements.
+//
+// Function return value:
+// 0: success.
+// 1: The API was not initialized.
+// 2: The export of at least one frame failed.
+// 3: The format is unknown.
+// ****************************************************************************
+
+C_EXPORT int vtlExportTractMeshes(double *tractParams, int numFrames, 
+  const char **fileNames, int format, int numThreads, int *results);
+
+
 // ****************************************************************************
 // Provides the tube data (especially the area function) for the given vector
 // of tractParams. The vectors tubeLength_cm, tubeArea_cm2, and tubeArticulator, 
@@ -170,6 +222,36 @@ C_EXPORT int vtlTractToTube(double* tractParams,
   double* incisorPos_cm, double* tongueTipSideElevation, double* velumOpening_cm2);
 
 
+// ****************************************************************************
+// Provides the tube data like vtlTractToTube() for many vectors of tract
+// parameters in one call, e.g. for the inversion of the articulation. The
+// vectors are processed in parallel by worker threads, each with its own
+// context.
+//
+// Parameters:
+// o tractParams (in): The numVectors vectors of vocal tract parameters one 
+//     after the other (numVectors*numVocalTractParams elements).
+// o numVectors (in): The number of parameter vectors.
+// o tubeLength_cm, tubeArea_cm2, tubeArticulator (out): The data of the tube
+//     sections of each vector one after the other (numVectors*numTubeSections
+//     elements each).
+// o incisorPos_cm, tongueTipSideElevation, velumOpening_cm2 (out): One 
+//     value per vector (numVectors elements each).
+// o numThreads (in): The number of worker threads. For numThreads <= 0, 
+//     all the workers of the thread pool are used (see vtlSetThreadPool()).
+//
+// Function return value:
+// 0: success.
+// 1: The API has not been initialized.
+// 2: The worker contexts could not be created.
+// ****************************************************************************
+
+C_EXPORT int vtlTractsToTubes(double *tractParams, int numVectors,
+  double *tubeLength_cm, double *tubeArea_cm2, int *tubeArticulator,
+  double *incisorPos_cm, double *tongueTipSideElevation, double *velumOpening_cm2,
+  int numThreads);
+
+
 // ****************************************************************************
 // Calculates the volume velocity transfer function of the vocal tract between 
 // the glottis and the lips for the given vector of vocal tract parameters and
@@ -205,6 +287,33 @@ C_EXPORT int vtlGetTransferFunction(double *tractParams, int numSpectrumSamples,
   double *magnitude, double *phase_rad);
 
 
+// ****************************************************************************
+// Calculates the transfer functions like vtlGetTransferFunction() for many
+// vectors of tract parameters in one call. The vectors are processed in 
+// parallel by worker threads, each with its own context and TL model.
+//
+// Parameters:
+// o tractParams (in): The numVectors vectors of vocal tract parameters one 
+//     after the other (numVectors*numVocalTractParams elements).
+// o numVectors (in): The number of parameter vectors.
+// o numSpectrumSamples (in): The number of samples of each spectrum, as for
+//     vtlGetTransferFunction(), but at least 16.
+// o magnitude, phase_rad (out): The spectra of the vectors one after the 
+//     other (numVectors*numSpectrumSamples elements each).
+// o numThreads (in): The number of worker threads. For numThreads <= 0, 
+//     all the workers of the thread pool are used (see vtlSetThreadPool()).
+//
+// Function return value:
+// 0: success.
+// 1: The API has not been initialized.
+// 2: The worker contexts could not be created.
+// 3: numSpectrumSamples is less than 16.
+// ****************************************************************************
+
+C_EXPORT int vtlGetTransferFunctions(double *tractParams, int numVectors, 
+  int numSpectrumSamples, double *magnitude, double *phase_rad, int numThreads);
+
+
 // ****************************************************************************
 // Calculates the real limited tract params (the ones that are actually used
 // in the synthesis) from a given arbitrary set of tract parameters
@@ -328,6 +437,96 @@ C_EXPORT int vtlSynthBlock(double *tractParams, double *glottisParams,
   int numFrames, int frameStep_samples, double *audio, int enableConsoleOutput);
 
 
+// ****************************************************************************
+// Sets the number of audio samples between two updates of the tube geometry
+// during the synthesis (the control rate). The glottis is updated for each
+// sample in any case. The default value 1 updates the tube for each sample.
+// Greater values (e.g., 32 or 110) speed up the synthesis at the cost of a
+// piecewise constant instead of linear interpolation of the tube shape 
+// between the frames.
+//
+// Function return value:
+// 0: success.
+// 1: The API has not been initialized.
+// ****************************************************************************
+
+C_EXPORT int vtlSetControlRate(int numSamples);
+
+
+// ****************************************************************************
+// Enables (enabled != 0) or disables the counters of the time domain 
+// simulation and clears them. The counters are accumulated by all following
+// syntheses until they are enabled again. They are disabled by default.
+//
+// Function return value:
+// 0: success.
+// 1: The API has not been initialized.
+// ****************************************************************************
+
+C_EXPORT int vtlEnableTdsStatistics(int enabled);
+
+
+// ****************************************************************************
+// Returns the counters of the time domain simulation accumulated since 
+// vtlEnableTdsStatistics(), to compare the solvers on a workload.
+//
+// Parameters (in/out):
+// o counters (out): Array of 13 values: 
+//     0: number of simulated time steps,
+//     1-4: time (s) of the calculation of the network components, of the 
+//       matrix, of the solution of the system of equations and of the 
+//       update of the variables,
+//     5, 6: mean and max. number of SOR iterations per time step,
+//     7, 8: mean and max. norm of the residuum of the last SOR iteration,
+//     9, 10: number of stored matrix elements in the symmetric envelope of
+//       the Cholesky factorization and in the skyline storage,
+//     11: mean number of constrictions per time step, 
+//     12: mean number of active noise sources per time step.
+//     The SOR values are zero unless the SOR solver is selected.
+// o histogramFileName (in): Text file for the histograms of the counters 
+//     over the time steps, or NULL or "" to write no file.
+//
+// Function return value:
+// 0: success.
+// 1: The API has not been initialized.
+// 2: The histogram file could not be written.
+// ****************************************************************************
+
+C_EXPORT int vtlGetTdsStatistics(double *counters, const char *histogramFileName);
+
+
+// ****************************************************************************
+// Enables (enabled != 0) or disables the binary snapshot of the speaker data 
+// for the speaker files loaded afterwards. When enabled, the data of a 
+// speaker file "name.speaker" are saved to "name.speaker.cache" when the file
+// is loaded, and restored from there as long as the text of the speaker file
+// does not change. It is disabled by default.
+// Function return value:
+// 0: success.
+// ****************************************************************************
+
+C_EXPORT int vtlUseSpeakerCache(int enabled);
+
+
+// ****************************************************************************
+// Sets the pool of worker threads shared by all the parallel computations of
+// the library (batch synthesis, mesh export, 3D simulations...).
+//
+// Parameters:
+// o numWorkers (in): The number of worker threads. For numWorkers <= 0, 
+//     one thread per hardware thread is used (default).
+// o pinWorkers (in): If not 0, each worker is bound to its own logical core.
+// o nestedParallelism (in): If not 0 (default), the parallel loops started 
+//     inside a parallel loop share the idle workers, else they run in 
+//     sequence in the calling thread.
+//
+// Function return value:
+// 0: success.
+// ****************************************************************************
+
+C_EXPORT int vtlSetThreadPool(int numWorkers, int pinWorkers, int nestedParallelism);
+
+
 // ****************************************************************************
 // Test function for this API.
 // Audio should contain at least 44100 double values.
@@ -427,7 +626,9 @@ C_EXPORT int vtlGetGesturalScoreDuration(const char* gesFileName, int* numAudioS
 // ****************************************************************************
 // This function converts a tract sequence file into an audio signal or file.
 // Parameters:
-// o tractSequenceFileName (in): Name of the tract sequence file to synthesize.
+// o tractSequenceFileName (in): Name of the tract sequence file to synthesize,
+//     in the text format or in the binary format (see 
+//     vtlConvertSequenceFile()).
 // o wavFileName (in): Name of the audio file with the resulting speech signal.
 //     This can be the empty string "" if you do not want to save a WAV file.
 // o audio (out): The resulting audio signal with sample values in the range 
@@ -448,6 +649,153 @@ C_EXPORT int vtlTractSequenceToAudio(const char* tractSequenceFileName,
   const char* wavFileName, double* audio, int* numSamples);
 
 
+// ****************************************************************************
+// Synthesizes a list of tract sequence files like vtlTractSequenceToAudio()
+// on a pool of worker threads. Each worker creates its own context with the
+// speaker of vtlInitialize(), so that the files are rendered in parallel.
+//
+// Parameters:
+// o tractSequenceFileNames (in): The names of the numFiles tract sequence 
+//     files.
+// o wavFileNames (in): The names of the numFiles WAV files to write.
+// o numFiles (in): The number of files to synthesize.
+// o numThreads (in): The number of worker threads. For numThreads <= 0, 
+//     all the workers of the thread pool are used (see vtlSetThreadPool()).
+// o results (out): If not NULL, receives for each file the return value of
+//     vtlTractSequenceToAudio(). The array must have numFiles elements.
+//
+// Function return value:
+// 0: success.
+// 1: The API was not initialized.
+// 2: The synthesis of at least one file failed.
+// ****************************************************************************
+
+C_EXPORT int vtlTractSequencesToAudio(const char **tractSequenceFileNames,
+  const char **wavFileNames, int numFiles, int numThreads, int *results);
+
+
+// ****************************************************************************
+// Converts a tract or tube sequence file between the text format and the 
+// binary format. The binary format contains the parameters of the states as
+// doubles, so that long sequences are read much faster than the text files.
+// Both formats are accepted by vtlTractSequenceToAudio().
+//
+// Parameters:
+// o inputFileName (in): The sequence file to convert, in either format.
+// o outputFileName (in): The file to write.
+// o isTubeSequence (in): 1 for a tube sequence, 0 for a tract sequence.
+// o binaryOutput (in): 1 to write the binary format, 0 for the text format.
+//
+// Function return value:
+// 0: success.
+// 1: The input file could not be opened.
+// 2: The input file is corrupted or the output file could not be written.
+// ****************************************************************************
+
+C_EXPORT int vtlConvertSequenceFile(const char *inputFileName, 
+  const char *outputFileName, int isTubeSequence, int binaryOutput);
+
+
+// ****************************************************************************
+// Context handle API.
+// The functions above work on a single context created by vtlInitialize().
+// The functions below do the same on a context created by vtlCreateContext(),
+// which owns its own vocal tract, glottis models, TDS model and synthesizer.
+// Different contexts can be used concurrently in different threads, but a 
+// context must only be used by one thread at a time.
+// The functions with the suffix Ctx return the same values as the 
+// corresponding functions without suffix, with the value 1 for a NULL 
+// context.
+// ****************************************************************************
+
+// ****************************************************************************
+// Creates a context with the given speaker file name, e.g. "JD2.speaker".
+// Return value: the new context, or NULL if loading the speaker file failed.
+// ****************************************************************************
+
+C_EXPORT VtlContext *vtlCreateContext(const char *speakerFileName);
+
+
+// ****************************************************************************
+// Releases the models of a context created with vtlCreateContext().
+// Return values:
+// 0: success.
+// 1: The context is NULL.
+// ****************************************************************************
+
+C_EXPORT int vtlCloseContext(VtlContext *context);
+
+
+C_EXPORT int vtlGetConstantsCtx(VtlContext *context, int *audioSamplingRate, 
+  int *numTubeSections, int *numVocalTractParams, int *numGlottisParams);
+
+C_EXPORT int vtlGetTractParamInfoCtx(VtlContext *context, char *names, 
+  double *paramMin, double *paramMax, double *paramNeutral);
+
+C_EXPORT int vtlGetGlottisParamInfoCtx(VtlContext *context, char *names, 
+  double *paramMin, double *paramMax, double *paramNeutral);
+
+C_EXPORT int vtlGetTractParamsCtx(VtlContext *context, const char *shapeName, 
+  double *param);
+
+C_EXPORT int vtlExportTractSvgCtx(VtlContext *context, double *tractParams, 
+  const char *fileName);
+
+C_EXPORT int vtlExportTractMeshCtx(VtlContext *context, double *tractParams, 
+  const char *fileName, int format);
+
+C_EXPORT int vtlExportTractMeshesCtx(VtlContext *context, double *tractParams, 
+  int numFrames, const char **fileNames, int format, int numThreads, int *results);
+
+C_EXPORT int vtlTractToTubeCtx(VtlContext *context, double* tractParams,
+  double* tubeLength_cm, double* tubeArea_cm2, int* tubeArticulator,
+  double* incisorPos_cm, double* tongueTipSideElevation, double* velumOpening_cm2);
+
+C_EXPORT int vtlTractsToTubesCtx(VtlContext *context, double *tractParams, 
+  int numVectors, double *tubeLength_cm, double *tubeArea_cm2, 
+  int *tubeArticulator, double *incisorPos_cm, double *tongueTipSideElevation, 
+  double *velumOpening_cm2, int numThreads);
+
+C_EXPORT int vtlGetTransferFunctionCtx(VtlContext *context, double *tractParams, 
+  int numSpectrumSamples, double *magnitude, double *phase_rad);
+
+C_EXPORT int vtlGetTransferFunctionsCtx(VtlContext *context, double *tractParams, 
+  int numVectors, int numSpectrumSamples, double *magnitude, double *phase_rad,
+  int numThreads);
+
+C_EXPORT int vtlInputTractToLimitedTractCtx(VtlContext *context, 
+  double* inTractParams, double* outTractParams);
+
+C_EXPORT int vtlSynthesisResetCtx(VtlContext *context);
+
+C_EXPORT int vtlSynthesisAddTubeCtx(VtlContext *context, int numNewSamples, 
+  double *audio, double* tubeLength_cm, double* tubeArea_cm2, int* tubeArticulator,
+  double incisorPos_cm, double velumOpening_cm2, double tongueTipSideElevation,
+  double* newGlottisParams);
+
+C_EXPORT int vtlSynthesisAddTractCtx(VtlContext *context, int numNewSamples, 
+  double *audio, double *tractParams, double *glottisParams);
+
+C_EXPORT int vtlSetControlRateCtx(VtlContext *context, int numSamples);
+
+C_EXPORT int vtlEnableTdsStatisticsCtx(VtlContext *context, int enabled);
+
+C_EXPORT int vtlGetTdsStatisticsCtx(VtlContext *context, double *counters, 
+  const char *histogramFileName);
+
+C_EXPORT int vtlSynthBlockCtx(VtlContext *context, double *tractParams, 
+  double *glottisParams, int numFrames, int frameStep_samples, double *audio, 
+  int enableConsoleOutput);
+
+C_EXPORT int vtlTractSequenceToAudioCtx(VtlContext *context, 
+  const char* tractSequenceFileName, const char* wavFileName, double* audio, 
+  int* numSamples);
+
+C_EXPORT int vtlTractSequencesToAudioCtx(VtlContext *context, 
+  const char **tractSequenceFileNames, const char **wavFileNames, int numFiles, 
+  int numThreads, int *results);
+
+
 // ****************************************************************************
 
 #ifdef __cplusplus
@@ -21,7 +21,9 @@
 
 #include "VoiceQualityEstimator.h"
 #include "Constants.h"
+#include "ParallelLoop.h"
 #include <cstdio>
+#include <thread>
 
 const double VoiceQualityEstimator::SLICE_STEP_S = 0.01;    // = 10 ms
 const double VoiceQualityEstimator::MIN_PEAK_SLOPE = -10.0;
@@ -32,11 +34,15 @@ const double VoiceQualityEstimator::MAX_PEAK_SLOPE = 0.0;
 
 VoiceQualityEstimator::VoiceQualityEstimator()
 {
+  int i, k, N;
+
   timeStep_s = 0.01;    // 10 ms
+  numThreads = max(1, (int)thread::hardware_concurrency());
 
   firstRoiSlice = 0;
   numRoiSlices = 0;
   nextSlice = 0;
+  initStream();
 
   // Init the wavelets for the six center frequencies.
   calcWavelet(wavelet8000, 1);
@@ -45,6 +51,25 @@ VoiceQualityEstimator::VoiceQualityEstimator()
   calcWavelet(wavelet1000, 8);
   calcWavelet(wavelet500, 16);
   calcWavelet(wavelet250, 32);
+
+  wavelet[0] = &wavelet250;
+  wavelet[1] = &wavelet500;
+  wavelet[2] = &wavelet1000;
+  wavelet[3] = &wavelet2000;
+  wavelet[4] = &wavelet4000;
+  wavelet[5] = &wavelet8000;
+
+  // The filtering with a wavelet is the convolution with the time-reversed
+  // wavelet. The block length of the convolution is at least the wavelet
+  // length, so that the impulse response is a single partition.
+
+  for (i=0; i < NUM_BANDS; i++)
+  {
+    N = wavelet[i]->N;
+    Signal reversedWavelet(N);
+    for (k=0; k < N; k++) { reversedWavelet.x[k] = wavelet[i]->x[N - 1 - k]; }
+    convolver[i].init(reversedWavelet, N, max(8, getFrameLengthExponent(N)));
+  }
 }
 
 
@@ -125,24 +150,30 @@ void VoiceQualityEstimator::init(Signal16 *signal, int firstRoiSample, int numRo
 
 bool VoiceQualityEstimator::processChunk(int numChunkSamples)
 {
-  const int NUM_CHUNCK_SLICES = 1;
-  int i;
-  bool finished = false;
+  // The number of slices with about numChunkSamples samples.
+  int numChunkSlices = (int)((double)numChunkSamples / (SLICE_STEP_S*(double)SAMPLING_RATE));
+  if (numChunkSlices < 1)
+  {
+    numChunkSlices = 1;
+  }
 
-  for (i=0; (i < NUM_CHUNCK_SLICES) && (finished == false); i++)
+  int endSlice = firstRoiSlice + numRoiSlices;
+  if (endSlice > (int)slices.size())
   {
-    if ((nextSlice < (int)slices.size()) && (nextSlice < firstRoiSlice + numRoiSlices))
-    {
-      calcSlicePeaks(nextSlice);
-      nextSlice++;
-    }
-    else
-    {
-      finished = true;
-    }    
+    endSlice = (int)slices.size();
+  }
+  if (nextSlice + numChunkSlices < endSlice)
+  {
+    endSlice = nextSlice + numChunkSlices;
+  }
+
+  if (nextSlice < endSlice)
+  {
+    calcSlicePeaks(nextSlice, endSlice - 1);
+    nextSlice = endSlice;
   }
 
-  return finished;
+  return ((nextSlice >= (int)slices.size()) || (nextSlice >= firstRoiSlice + numRoiSlices));
 }
 
 
@@ -174,6 +205,134 @@ vector<double> VoiceQualityEstimator::finish()
 }
 
 
+// ****************************************************************************
+/// Starts the estimation for a stream of samples, e.g., from a microphone or
+/// a file that is read block by block. The stream is passed in blocks of any
+/// length to processStream(...), which returns the voice quality values
+/// every timeStep_s seconds from the beginning of the stream on, as soon as
+/// the slices around them are complete. The value at the time t is hence
+/// returned when the samples up to about t + 52 ms are passed (three and a
+/// half slices and half of the longest wavelet). Only the slices of the 
+/// frame of the next value and the samples of the next slice with the 
+/// margin of the wavelets are kept in memory. finishStream(...) returns the
+/// remaining values at the end of the stream. The values are the same as 
+/// those of finish() for the whole signal.
+// ****************************************************************************
+
+void VoiceQualityEstimator::initStream()
+{
+  streamSignal.clear();
+  streamFirstSample = 0;
+  streamNumSamples = 0;
+  streamSlices.clear();
+  streamFirstSlice = 0;
+  streamNextSlice = 0;
+  streamNextValue = 0;
+}
+
+
+// ****************************************************************************
+/// Processes the next numSamples samples of the stream started with 
+/// initStream() and appends the new voice quality values to vqValues.
+// ****************************************************************************
+
+void VoiceQualityEstimator::processStream(const double *samples, int numSamples,
+  vector<double> &vqValues)
+{
+  int i;
+
+  if (numSamples < 1)
+  {
+    return;
+  }
+
+  streamSignal.insert(streamSignal.end(), samples, samples + numSamples);
+  streamNumSamples+= numSamples;
+
+  // ****************************************************************
+  // Calculate the slices whose samples are complete under the 
+  // longest wavelet (at 250 Hz) and the values of the frames whose
+  // slices are complete.
+  // ****************************************************************
+
+  int N = wavelet[0]->N;
+  int lastSliceIndex = streamNextSlice - 1;
+  while ((int)(SLICE_STEP_S*(double)(lastSliceIndex + 2)*SAMPLING_RATE) - 1 + N - N/2 <= streamNumSamples)
+  {
+    lastSliceIndex++;
+  }
+  calcStreamSlices(lastSliceIndex, streamNumSamples);
+
+  double centerTime_s = (double)streamNextValue*timeStep_s;
+  while ((int)(centerTime_s / SLICE_STEP_S) + 3 < streamNextSlice)
+  {
+    vqValues.push_back(calcPeakSlope(streamSlices.data(), streamFirstSlice, 
+      streamNextSlice, centerTime_s, false));
+    streamNextValue++;
+    centerTime_s = (double)streamNextValue*timeStep_s;
+  }
+
+  // ****************************************************************
+  // Remove the slices and samples that are no longer needed.
+  // ****************************************************************
+
+  int firstSlice = (int)(centerTime_s / SLICE_STEP_S) - 3;
+  if (firstSlice > streamFirstSlice)
+  {
+    i = min(firstSlice, streamNextSlice) - streamFirstSlice;
+    streamSlices.erase(streamSlices.begin(), streamSlices.begin() + i);
+    streamFirstSlice+= i;
+  }
+
+  int firstSample = (int)(SLICE_STEP_S*(double)streamNextSlice*SAMPLING_RATE) - N/2;
+  if (firstSample > streamFirstSample)
+  {
+    streamSignal.erase(streamSignal.begin(), streamSignal.begin() + (firstSample - streamFirstSample));
+    streamFirstSample = firstSample;
+  }
+}
+
+
+// ****************************************************************************
+/// Processes the remaining slices at the end of the stream and appends the 
+/// remaining voice quality values to vqValues.
+// ****************************************************************************
+
+void VoiceQualityEstimator::finishStream(vector<double> &vqValues)
+{
+  int numSlices = (int)(((double)streamNumSamples / (double)SAMPLING_RATE) / SLICE_STEP_S);
+  calcStreamSlices(numSlices - 1, streamNumSamples);
+
+  int numVqValues = (int)(streamNumSamples / ((double)SAMPLING_RATE * timeStep_s));
+  for (; streamNextValue < numVqValues; streamNextValue++)
+  {
+    vqValues.push_back(calcPeakSlope(streamSlices.data(), streamFirstSlice, 
+      numSlices, (double)streamNextValue*timeStep_s, false));
+  }
+}
+
+
+// ****************************************************************************
+/// Appends the slices from streamNextSlice to lastSliceIndex of the stream
+/// to the stream slices. The stream ends after signalLength samples.
+// ****************************************************************************
+
+void VoiceQualityEstimator::calcStreamSlices(int lastSliceIndex, int signalLength)
+{
+  int numNewSlices = lastSliceIndex - streamNextSlice + 1;
+  if (numNewSlices < 1)
+  {
+    return;
+  }
+
+  int firstIndex = (int)streamSlices.size();
+  streamSlices.resize(firstIndex + numNewSlices);
+  calcSlicePeaks(streamNextSlice, lastSliceIndex, &streamSignal[0], streamFirstSample,
+    signalLength, &streamSlices[firstIndex]);
+  streamNextSlice = lastSliceIndex + 1;
+}
+
+
 // ****************************************************************************
 // ****************************************************************************
 
@@ -195,6 +354,19 @@ void VoiceQualityEstimator::printData(int pos_pt)
 // ****************************************************************************
 
 double VoiceQualityEstimator::calcPeakSlope(double centerTime_s, bool debug)
+{
+  return calcPeakSlope(slices.data(), 0, (int)slices.size(), centerTime_s, debug);
+}
+
+
+// ****************************************************************************
+/// Calculates the peak slope parameter around the given time from the 
+/// slices from firstDataSlice on in sliceData, for a signal with numSlices
+/// slices.
+// ****************************************************************************
+
+double VoiceQualityEstimator::calcPeakSlope(const Slice *sliceData, int firstDataSlice,
+  int numSlices, double centerTime_s, bool debug)
 {
   // Take the peaks in seven consecutive slices as one frame (= 70 ms).
   int centerSlice = (int)(centerTime_s / SLICE_STEP_S);
@@ -204,13 +376,13 @@ double VoiceQualityEstimator::calcPeakSlope(double centerTime_s, bool debug)
   {
     firstSlice = 0;
   }
-  if (lastSlice >= (int)slices.size())
+  if (lastSlice >= numSlices)
   {
-    lastSlice = (int)slices.size() - 1;    
+    lastSlice = numSlices - 1;    
   }
 
   Slice frame;
-  Slice *s;
+  const Slice *s;
   int i;
 
   frame.peak250 = 0.0;
@@ -222,7 +394,7 @@ double VoiceQualityEstimator::calcPeakSlope(double centerTime_s, bool debug)
 
   for (i=firstSlice; i <= lastSlice; i++)
   {
-    s = &slices[i];
+    s = &sliceData[i - firstDataSlice];
     
     if (s->peak250 > frame.peak250)
     {
@@ -328,64 +500,89 @@ double VoiceQualityEstimator::calcPeakSlope(double centerTime_s, bool debug)
 
 void VoiceQualityEstimator::calcSlicePeaks(int sliceIndex)
 {
-  if ((sliceIndex < 0) || (sliceIndex >= (int)slices.size()))
+  calcSlicePeaks(sliceIndex, sliceIndex);
+}
+
+
+// ****************************************************************************
+/// Calculates the maximum in each of the six frequency bands within the 
+/// slices from firstSliceIndex to lastSliceIndex. The signal of the slices is
+/// filtered at once in each band by FFT convolution, and the bands are 
+/// distributed on numThreads threads.
+// ****************************************************************************
+
+void VoiceQualityEstimator::calcSlicePeaks(int firstSliceIndex, int lastSliceIndex)
+{
+  if (firstSliceIndex < 0)
+  {
+    firstSliceIndex = 0;
+  }
+  if (lastSliceIndex >= (int)slices.size())
+  {
+    lastSliceIndex = (int)slices.size() - 1;
+  }
+  if (firstSliceIndex > lastSliceIndex)
   {
     return;
   }
 
-  double startTime_s = SLICE_STEP_S*(double)sliceIndex;
-  double endTime_s   = SLICE_STEP_S*(double)(sliceIndex + 1);
+  calcSlicePeaks(firstSliceIndex, lastSliceIndex, origSignal.x, 0, origSignal.N,
+    &slices[firstSliceIndex]);
+}
+
 
-  int firstSample = (int)(startTime_s*SAMPLING_RATE);
-  int lastSample  = (int)(endTime_s*SAMPLING_RATE) - 1;
+// ****************************************************************************
+/// Calculates the peaks of the slices from firstSliceIndex to lastSliceIndex
+/// of the signal of length signalLength, whose samples from firstX on are in
+/// x[], and writes them into result[].
+// ****************************************************************************
+
+void VoiceQualityEstimator::calcSlicePeaks(int firstSliceIndex, int lastSliceIndex, 
+  const double *x, int firstX, int signalLength, Slice *result)
+{
+  int numSlices = lastSliceIndex - firstSliceIndex + 1;
+  int firstSample = (int)(SLICE_STEP_S*(double)firstSliceIndex*SAMPLING_RATE);
+  int lastSample  = (int)(SLICE_STEP_S*(double)(lastSliceIndex + 1)*SAMPLING_RATE) - 1;
+  int numSamples = lastSample - firstSample + 1;
   int i;
-  double d;
-  Slice *s = &slices[sliceIndex];
 
-  s->peak250 = 0.0;
-  s->peak500 = 0.0;
-  s->peak1000 = 0.0;
-  s->peak2000 = 0.0;
-  s->peak4000 = 0.0;
-  s->peak8000 = 0.0;
+  // The peaks of the slices in each band.
+  vector<double> peaks(NUM_BANDS*numSlices, 0.0);
 
-  for (i=firstSample; i <= lastSample; i++)
+  auto processBand = [&](int band)
   {
-    d = getFilteredSample(i, &wavelet250);
-    if (d > s->peak250)
-    {
-      s->peak250 = d;
-    }
-
-    d = getFilteredSample(i, &wavelet500);
-    if (d > s->peak500)
-    {
-      s->peak500 = d;
-    }
+    vector<double> filtered(numSamples);
+    int sliceIndex, k, first, last;
+    double *peak;
 
-    d = getFilteredSample(i, &wavelet1000);
-    if (d > s->peak1000)
-    {
-      s->peak1000 = d;
-    }
+    getFilteredSignal(x, firstX, signalLength, firstSample, numSamples, band, &filtered[0]);
 
-    d = getFilteredSample(i, &wavelet2000);
-    if (d > s->peak2000)
+    for (sliceIndex=firstSliceIndex; sliceIndex <= lastSliceIndex; sliceIndex++)
     {
-      s->peak2000 = d;
+      first = (int)(SLICE_STEP_S*(double)sliceIndex*SAMPLING_RATE);
+      last  = (int)(SLICE_STEP_S*(double)(sliceIndex + 1)*SAMPLING_RATE) - 1;
+      peak = &peaks[band*numSlices + sliceIndex - firstSliceIndex];
+      for (k=first; k <= last; k++)
+      {
+        if (filtered[k - firstSample] > *peak)
+        {
+          *peak = filtered[k - firstSample];
+        }
+      }
     }
+  };
 
-    d = getFilteredSample(i, &wavelet4000);
-    if (d > s->peak4000)
-    {
-      s->peak4000 = d;
-    }
+  parallelLoop(NUM_BANDS, numThreads, processBand);
 
-    d = getFilteredSample(i, &wavelet8000);
-    if (d > s->peak8000)
-    {
-      s->peak8000 = d;
-    }
+  for (i=0; i < numSlices; i++)
+  {
+    Slice *s = &result[i];
+    s->peak250 = peaks[0*numSlices + i];
+    s->peak500 = peaks[1*numSlices + i];
+    s->peak1000 = peaks[2*numSlices + i];
+    s->peak2000 = peaks[3*numSlices + i];
+    s->peak4000 = peaks[4*numSlices + i];
+    s->peak8000 = peaks[5*numSlices + i];
   }
 }
 
@@ -417,6 +614,64 @@ double VoiceQualityEstimator::getFilteredSample(int pos_pt, Signal *wavelet)
 }
 
 
+// ****************************************************************************
+/// Writes the numSamples samples of the original signal from firstSample on,
+/// filtered with the wavelet of the given band, into filtered[]. The result
+/// is the same as with getFilteredSample(...) for each sample, but is 
+/// calculated by FFT convolution, so that the cost per sample grows only 
+/// with the logarithm of the wavelet length.
+// ****************************************************************************
+
+void VoiceQualityEstimator::getFilteredSignal(int firstSample, int numSamples, 
+  int band, double *filtered)
+{
+  getFilteredSignal(origSignal.x, 0, origSignal.N, firstSample, numSamples, band, filtered);
+}
+
+
+// ****************************************************************************
+/// Filters the samples like getFilteredSignal(...) above in a signal of 
+/// length signalLength, whose samples from firstX on are in x[].
+// ****************************************************************************
+
+void VoiceQualityEstimator::getFilteredSignal(const double *x, int firstX, 
+  int signalLength, int firstSample, int numSamples, int band, double *filtered)
+{
+  int N = wavelet[band]->N;
+  int startPos = firstSample - N/2;
+  int segmentLength = numSamples + N - 1;
+  int i, k;
+
+  // The segment of the signal that covers the wavelets at all samples.
+  // The result at a sample is y[k + N - 1] when the segment starts at the
+  // first sample under the wavelet at the sample k.
+
+  vector<double> segment(segmentLength), y(segmentLength);
+  for (i=0; i < segmentLength; i++)
+  {
+    k = startPos + i;
+    segment[i] = ((k >= 0) && (k < signalLength)) ? x[k - firstX] : 0.0;
+  }
+
+  convolver[band].resetBuffers();
+  convolver[band].convolve(&segment[0], &y[0], segmentLength);
+
+  for (i=0; i < numSamples; i++)
+  {
+    // Condition at the beginning and end of the signal.
+    k = startPos + i;
+    if ((k < 0) || (k + N > signalLength))
+    {
+      filtered[i] = 0.0;
+    }
+    else
+    {
+      filtered[i] = y[i + N - 1];
+    }
+  }
+}
+
+
 // ****************************************************************************
 /// Calculates a symmetrical wavelet with the given length factor (=1,2,4,8,16,
 /// 32) with respect to the 8 kHz mother wavelet.
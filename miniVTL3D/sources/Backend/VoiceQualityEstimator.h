@@ -58,8 +58,11 @@ public:
   static const double SLICE_STEP_S;
   static const double MIN_PEAK_SLOPE;
   static const double MAX_PEAK_SLOPE;
+  static const int NUM_BANDS = 6;
 
   double timeStep_s;
+  /// Number of threads that filter the bands of a chunk in parallel
+  int numThreads;
   Signal wavelet250;
   Signal wavelet500;
   Signal wavelet1000;
@@ -67,7 +70,7 @@ public:
   Signal wavelet4000;
   Signal wavelet8000;
 
-  // A vector of 10 ms slices.
+  // A vector of 10 ms slices (not used by the streaming mode).
   vector<Slice> slices;
 
   // **************************************************************************
@@ -81,10 +84,16 @@ public:
   bool processChunk(int numChunkSamples);
   vector<double> finish();
 
+  void initStream();
+  void processStream(const double *samples, int numSamples, vector<double> &vqValues);
+  void finishStream(vector<double> &vqValues);
+
   void printData(int pos_pt);
   double calcPeakSlope(double centerTime_s, bool debug = false);
   void calcSlicePeaks(int sliceIndex);
+  void calcSlicePeaks(int firstSliceIndex, int lastSliceIndex);
   double getFilteredSample(int pos_pt, Signal *wavelet);
+  void getFilteredSignal(int firstSample, int numSamples, int band, double *filtered);
 
   // **************************************************************************
   // Private data.
@@ -95,6 +104,26 @@ private:
   int firstRoiSlice;
   int numRoiSlices;
   int nextSlice;
+  /// The wavelets of the bands from 250 Hz to 8000 Hz
+  Signal *wavelet[NUM_BANDS];
+  /// FFT convolvers with the time-reversed wavelets
+  FftConvolver convolver[NUM_BANDS];
+
+  // State of the streaming mode. The indices of the samples and slices
+  // are counted from the beginning of the stream.
+
+  /// The samples from streamFirstSample on
+  vector<double> streamSignal;
+  int streamFirstSample;
+  /// Number of samples received so far
+  int streamNumSamples;
+  /// The slices from streamFirstSlice on
+  vector<Slice> streamSlices;
+  int streamFirstSlice;
+  /// Next slice to be calculated
+  int streamNextSlice;
+  /// Next voice quality value to be returned
+  int streamNextValue;
 
   // **************************************************************************
   // Private functions.
@@ -102,6 +131,13 @@ private:
 
 private:
   void calcWavelet(Signal &wavelet, int lengthFactor);
+  double calcPeakSlope(const Slice *sliceData, int firstDataSlice, int numSlices,
+    double centerTime_s, bool debug);
+  void calcSlicePeaks(int firstSliceIndex, int lastSliceIndex, const double *x, 
+    int firstX, int signalLength, Slice *result);
+  void getFilteredSignal(const double *x, int firstX, int signalLength, 
+    int firstSample, int numSamples, int band, double *filtered);
+  void calcStreamSlices(int lastSliceIndex, int signalLength);
 
 };
 
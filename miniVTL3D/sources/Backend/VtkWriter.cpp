@@ -0,0 +1,185 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+
+#include "VtkWriter.h"
+#include <fstream>
+#include <sstream>
+#include <cstdint>
+
+// ****************************************************************************
+// Description of the arrays appended after the XML and their offsets from 
+// the start of the appended data (each array is preceded by its size)
+
+class appendedArrays
+{
+public:
+
+  appendedArrays() : m_offset(0) {}
+
+  template<class T> string add(const string& type, const string& name, 
+    int numComponents, const vector<T>& values)
+  {
+    stringstream xml;
+    xml << "<DataArray type=\"" << type << "\"";
+    if (name != "") { xml << " Name=\"" << name << "\""; }
+    xml << " NumberOfComponents=\"" << numComponents 
+      << "\" format=\"appended\" offset=\"" << m_offset << "\"/>";
+
+    uint64_t size(values.size() * sizeof(T));
+    m_data.append((const char*)&size, sizeof(size));
+    m_data.append((const char*)values.data(), size);
+    m_offset += sizeof(size) + size;
+
+    return xml.str();
+  }
+
+  void write(ostream& os) const
+  {
+    os << "  <AppendedData encoding=\"raw\">" << endl << "   _";
+    os.write(m_data.data(), m_data.size());
+    os << endl << "  </AppendedData>" << endl;
+  }
+
+private:
+
+  string m_data;
+  uint64_t m_offset;
+};
+
+// ****************************************************************************
+
+static void writeHeader(ostream& os, const string& type)
+{
+  os << "<?xml version=\"1.0\"?>" << endl;
+  os << "<VTKFile type=\"" << type << "\" version=\"1.0\" "
+    << "byte_order=\"LittleEndian\" header_type=\"UInt64\">" << endl;
+}
+
+// ****************************************************************************
+
+static string dataArraysXml(const string& tag, const vector<vtkDataArray>& data,
+  appendedArrays& appended)
+{
+  stringstream xml;
+  xml << "   <" << tag << ">" << endl;
+  for (auto& array : data)
+  {
+    xml << "    " << appended.add("Float64", array.name, array.numComponents,
+      array.values) << endl;
+  }
+  xml << "   </" << tag << ">" << endl;
+  return xml.str();
+}
+
+// ****************************************************************************
+
+bool writeVtkTriangleMesh(const string& fileName, 
+  const vector<array<double, 3>>& points, const vector<array<int, 3>>& triangles,
+  const vector<vtkDataArray>& pointData, const vector<vtkDataArray>& cellData)
+{
+  ofstream os(fileName, ios::out | ios::binary | ios::trunc);
+  if (!os.is_open()) { return false; }
+
+  int numTriangles(triangles.size());
+  vector<double> coords;
+  vector<int64_t> connectivity, offsets;
+  vector<uint8_t> types(numTriangles, 5);   // VTK_TRIANGLE
+  coords.reserve(3 * points.size());
+  for (auto& pt : points) { coords.insert(coords.end(), pt.begin(), pt.end()); }
+  connectivity.reserve(3 * numTriangles);
+  offsets.reserve(numTriangles);
+  for (auto& tri : triangles)
+  {
+    connectivity.insert(connectivity.end(), tri.begin(), tri.end());
+    offsets.push_back(connectivity.size());
+  }
+
+  appendedArrays appended;
+  writeHeader(os, "UnstructuredGrid");
+  os << " <UnstructuredGrid>" << endl;
+  os << "  <Piece NumberOfPoints=\"" << points.size() << "\" NumberOfCells=\""
+    << numTriangles << "\">" << endl;
+  os << dataArraysXml("PointData", pointData, appended);
+  os << dataArraysXml("CellData", cellData, appended);
+  os << "   <Points>" << endl << "    " 
+    << appended.add("Float64", "", 3, coords) << endl << "   </Points>" << endl;
+  os << "   <Cells>" << endl; 
+  os << "    " << appended.add("Int64", "connectivity", 1, connectivity) << endl;
+  os << "    " << appended.add("Int64", "offsets", 1, offsets) << endl;
+  os << "    " << appended.add("UInt8", "types", 1, types) << endl;
+  os << "   </Cells>" << endl;
+  os << "  </Piece>" << endl;
+  os << " </UnstructuredGrid>" << endl;
+  appended.write(os);
+  os << "</VTKFile>" << endl;
+
+  return (bool)os;
+}
+
+// ****************************************************************************
+
+bool writeVtkImageData(const string& fileName, const array<int, 3>& dims,
+  const array<double, 3>& origin, const array<double, 3>& spacing,
+  const vector<vtkDataArray>& pointData)
+{
+  ofstream os(fileName, ios::out | ios::binary | ios::trunc);
+  if (!os.is_open()) { return false; }
+
+  stringstream extent;
+  extent << "0 " << dims[0] - 1 << " 0 " << dims[1] - 1 << " 0 " << dims[2] - 1;
+
+  appendedArrays appended;
+  os.precision(17);
+  writeHeader(os, "ImageData");
+  os << " <ImageData WholeExtent=\"" << extent.str() << "\" Origin=\"" 
+    << origin[0] << " " << origin[1] << " " << origin[2] << "\" Spacing=\""
+    << spacing[0] << " " << spacing[1] << " " << spacing[2] << "\">" << endl;
+  os << "  <Piece Extent=\"" << extent.str() << "\">" << endl;
+  os << dataArraysXml("PointData", pointData, appended);
+  os << "  </Piece>" << endl;
+  os << " </ImageData>" << endl;
+  appended.write(os);
+  os << "</VTKFile>" << endl;
+
+  return (bool)os;
+}
+
+// ****************************************************************************
+
+bool writeVtkMultiBlock(const string& fileName, const vector<string>& blockNames,
+  const vector<string>& blockFiles)
+{
+  ofstream os(fileName, ios::out | ios::trunc);
+  if (!os.is_open()) { return false; }
+
+  writeHeader(os, "vtkMultiBlockDataSet");
+  os << " <vtkMultiBlockDataSet>" << endl;
+  for (int i(0); i < blockFiles.size(); i++)
+  {
+    os << "  <DataSet index=\"" << i << "\" name=\"" << blockNames[i] 
+      << "\" file=\"" << blockFiles[i] << "\"/>" << endl;
+  }
+  os << " </vtkMultiBlockDataSet>" << endl;
+  os << "</VTKFile>" << endl;
+
+  return (bool)os;
+}
@@ -0,0 +1,64 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+
+#ifndef __VTK_WRITER_H__
+#define __VTK_WRITER_H__
+
+#include <string>
+#include <vector>
+#include <array>
+
+using namespace std;
+
+// ****************************************************************************
+// Writer of VTK XML files (readable by ParaView) whose arrays are appended 
+// in raw binary after the XML description, little endian with 64 bit 
+// headers, so that large meshes and fields are written and read without 
+// text conversion:
+// - writeVtkTriangleMesh writes a surface of triangles in 3D (.vtu) with
+//   arrays of values at its points and at its triangles
+// - writeVtkImageData writes values on a regular grid (.vti)
+// - writeVtkMultiBlock writes a collection of such files (.vtm), opened at
+//   once in ParaView; the file names are relative to the collection file.
+// ****************************************************************************
+
+struct vtkDataArray
+{
+  string name;
+  int numComponents;
+  vector<double> values;  // numComponents values per point or cell
+};
+
+bool writeVtkTriangleMesh(const string& fileName, 
+  const vector<array<double, 3>>& points, const vector<array<int, 3>>& triangles,
+  const vector<vtkDataArray>& pointData, const vector<vtkDataArray>& cellData);
+
+// the values of the point data are ordered with the x index varying first, 
+// then the y index, then the z index
+bool writeVtkImageData(const string& fileName, const array<int, 3>& dims,
+  const array<double, 3>& origin, const array<double, 3>& spacing,
+  const vector<vtkDataArray>& pointData);
+
+bool writeVtkMultiBlock(const string& fileName, const vector<string>& blockNames,
+  const vector<string>& blockFiles);
+
+#endif
@@ -0,0 +1,509 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#include "WaveFile.h"
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// format tags of the "fmt " chunk
+static const int WAVE_FORMAT_PCM = 1;
+static const int WAVE_FORMAT_IEEE_FLOAT = 3;
+static const int WAVE_FORMAT_EXTENSIBLE = 0xFFFE;
+
+// size of the header written by WaveFileWriter
+static const int WAVE_HEADER_SIZE = 44;
+
+// ****************************************************************************
+// Little endian values at the position p of the file (not necessarily 
+// aligned).
+// ****************************************************************************
+
+static uint32_t readUint32(const char* p)
+{
+  const unsigned char* b = (const unsigned char*)p;
+  return (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) | 
+    ((uint32_t)b[3] << 24);
+}
+
+// ****************************************************************************
+
+static int readUint16(const char* p)
+{
+  const unsigned char* b = (const unsigned char*)p;
+  return (int)b[0] | ((int)b[1] << 8);
+}
+
+// ****************************************************************************
+
+static void writeUint32(char* p, uint32_t value)
+{
+  int i;
+  for (i = 0; i < 4; i++) { p[i] = (char)((value >> (8 * i)) & 0xFF); }
+}
+
+// ****************************************************************************
+
+static void writeUint16(char* p, int value)
+{
+  p[0] = (char)(value & 0xFF);
+  p[1] = (char)((value >> 8) & 0xFF);
+}
+
+// ****************************************************************************
+// ****************************************************************************
+
+MappedWaveFile::MappedWaveFile() :
+  m_data(NULL), m_size(0),
+#ifdef _WIN32
+  m_file(INVALID_HANDLE_VALUE), m_mapping(NULL),
+#else
+  m_file(-1),
+#endif
+  m_sampleRate(0), m_numChannels(0), m_bitDepth(0), m_isFloat(false),
+  m_bytesPerFrame(0), m_numFrames(0), m_samples(NULL)
+{
+}
+
+// ****************************************************************************
+
+MappedWaveFile::~MappedWaveFile()
+{
+  close();
+}
+
+// ****************************************************************************
+/// Maps the file in memory and locates the format and data chunks. The 
+/// samples are not read.
+// ****************************************************************************
+
+bool MappedWaveFile::open(const string& fileName, string& error)
+{
+  close();
+
+  //****************************************************
+  // map the file
+  //****************************************************
+
+#ifdef _WIN32
+  m_file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  LARGE_INTEGER fileSize;
+  if ((m_file == INVALID_HANDLE_VALUE) || !GetFileSizeEx(m_file, &fileSize))
+  {
+    error = "Cannot open " + fileName;
+    close();
+    return false;
+  }
+  m_size = (size_t)fileSize.QuadPart;
+  if (m_size < 12)
+  {
+    error = fileName + " is not a wave file";
+    close();
+    return false;
+  }
+  m_mapping = CreateFileMappingA(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (m_mapping != NULL)
+  {
+    m_data = (const char*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+  }
+#else
+  m_file = ::open(fileName.c_str(), O_RDONLY);
+  struct stat fileStat;
+  if ((m_file < 0) || (fstat(m_file, &fileStat) != 0))
+  {
+    error = "Cannot open " + fileName;
+    close();
+    return false;
+  }
+  m_size = (size_t)fileStat.st_size;
+  if (m_size < 12)
+  {
+    error = fileName + " is not a wave file";
+    close();
+    return false;
+  }
+  void* data(mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, m_file, 0));
+  if (data != MAP_FAILED) 
+  { 
+    m_data = (const char*)data; 
+    // the samples are mostly read in sequence
+    madvise(data, m_size, MADV_SEQUENTIAL);
+  }
+#endif
+
+  if (m_data == NULL)
+  {
+    error = "Cannot map " + fileName;
+    close();
+    return false;
+  }
+
+  if (!parseChunks(error))
+  {
+    error = fileName + ": " + error;
+    close();
+    return false;
+  }
+
+  return true;
+}
+
+// ****************************************************************************
+
+void MappedWaveFile::close()
+{
+#ifdef _WIN32
+  if (m_data != NULL) { UnmapViewOfFile(m_data); }
+  if (m_mapping != NULL) { CloseHandle(m_mapping); }
+  if (m_file != INVALID_HANDLE_VALUE) { CloseHandle(m_file); }
+  m_mapping = NULL;
+  m_file = INVALID_HANDLE_VALUE;
+#else
+  if (m_data != NULL) { munmap((void*)m_data, m_size); }
+  if (m_file >= 0) { ::close(m_file); }
+  m_file = -1;
+#endif
+
+  m_data = NULL;
+  m_size = 0;
+  m_sampleRate = 0;
+  m_numChannels = 0;
+  m_bitDepth = 0;
+  m_isFloat = false;
+  m_bytesPerFrame = 0;
+  m_numFrames = 0;
+  m_samples = NULL;
+}
+
+// ****************************************************************************
+/// Walks through the chunks of the RIFF file to find the "fmt " and "data"
+/// chunks. A data chunk extending beyond the end of the file (e.g. from an
+/// interrupted recording) is cut at the end of the file.
+// ****************************************************************************
+
+bool MappedWaveFile::parseChunks(string& error)
+{
+  if ((memcmp(m_data, "RIFF", 4) != 0) || (memcmp(m_data + 8, "WAVE", 4) != 0))
+  {
+    error = "not a wave file";
+    return false;
+  }
+
+  bool fmtFound = false;
+  int formatTag = 0;
+  size_t dataOffset = 0;
+  size_t dataSize = 0;
+  size_t pos = 12;
+
+  while ((pos + 8 <= m_size) && (m_samples == NULL))
+  {
+    const char* chunk = m_data + pos;
+    size_t chunkSize = readUint32(chunk + 4);
+
+    if ((memcmp(chunk, "fmt ", 4) == 0) && (chunkSize >= 16) && (pos + 8 + chunkSize <= m_size))
+    {
+      formatTag = readUint16(chunk + 8);
+      m_numChannels = readUint16(chunk + 10);
+      m_sampleRate = (int)readUint32(chunk + 12);
+      m_bitDepth = readUint16(chunk + 22);
+      // the actual format of the extensible format is in the first bytes of 
+      // the sub-format GUID
+      if ((formatTag == WAVE_FORMAT_EXTENSIBLE) && (chunkSize >= 40))
+      {
+        formatTag = readUint16(chunk + 32);
+      }
+      fmtFound = true;
+    }
+    else if (memcmp(chunk, "data", 4) == 0)
+    {
+      dataOffset = pos + 8;
+      dataSize = min(chunkSize, m_size - dataOffset);
+      m_samples = m_data + dataOffset;
+    }
+
+    // the chunks are aligned on 2 bytes
+    pos += 8 + chunkSize + (chunkSize & 1);
+  }
+
+  if ((fmtFound == false) || (m_samples == NULL))
+  {
+    error = "the format or the data chunk is missing";
+    return false;
+  }
+
+  m_isFloat = (formatTag == WAVE_FORMAT_IEEE_FLOAT);
+  if (((formatTag != WAVE_FORMAT_PCM) && (m_isFloat == false)) ||
+    ((m_isFloat) && (m_bitDepth != 32)) ||
+    ((m_bitDepth != 8) && (m_bitDepth != 16) && (m_bitDepth != 24) && (m_bitDepth != 32)) ||
+    (m_numChannels < 1))
+  {
+    error = "unsupported sample format";
+    return false;
+  }
+
+  m_bytesPerFrame = m_numChannels * (m_bitDepth / 8);
+  m_numFrames = (int64_t)(dataSize / m_bytesPerFrame);
+
+  return true;
+}
+
+// ****************************************************************************
+
+const signed short* MappedWaveFile::pcm16Data() const
+{
+  if ((m_bitDepth != 16) || (((uintptr_t)m_samples % sizeof(signed short)) != 0))
+  {
+    return NULL;
+  }
+  return (const signed short*)m_samples;
+}
+
+// ****************************************************************************
+
+const float* MappedWaveFile::floatData() const
+{
+  if ((m_isFloat == false) || (((uintptr_t)m_samples % sizeof(float)) != 0))
+  {
+    return NULL;
+  }
+  return (const float*)m_samples;
+}
+
+// ****************************************************************************
+/// Returns the sample index of the given channel converted to 16 bit. The 
+/// float values are scaled like in AudioFile, i.e., by 32767.
+// ****************************************************************************
+
+signed short MappedWaveFile::getSample16(int channel, int64_t index) const
+{
+  const char* p = m_samples + index * m_bytesPerFrame + channel * (m_bitDepth / 8);
+  const unsigned char* b = (const unsigned char*)p;
+
+  if (m_isFloat)
+  {
+    float value;
+    memcpy(&value, p, sizeof(float));
+    value = max(-1.0f, min(1.0f, value));
+    return (signed short)(value * 32767.0f);
+  }
+
+  switch (m_bitDepth)
+  {
+  case 8:  return (signed short)(((int)b[0] - 128) * 256);
+  case 16: return (signed short)readUint16(p);
+  case 24: return (signed short)(b[1] | (b[2] << 8));
+  default: return (signed short)(b[2] | (b[3] << 8));
+  }
+}
+
+// ****************************************************************************
+/// Converts numSamples samples of the given channel to 16 bit, starting at
+/// the sample firstSample. The samples beyond the end of the file are zero.
+/// Returns the number of samples that were in the file.
+// ****************************************************************************
+
+int MappedWaveFile::readRegion(int channel, int64_t firstSample, int numSamples, 
+  Signal16& s) const
+{
+  int i;
+  int numRead = 0;
+
+  if (s.N < numSamples) { s.reset(numSamples); }
+  if ((channel < 0) || (channel >= m_numChannels) || (firstSample < 0))
+  {
+    memset(s.x, 0, numSamples * sizeof(signed short));
+    return 0;
+  }
+
+  numRead = (int)max((int64_t)0, min((int64_t)numSamples, m_numFrames - firstSample));
+
+  // mono 16 bit data are copied as a block
+  const signed short* pcm16 = pcm16Data();
+  if ((pcm16 != NULL) && (m_numChannels == 1))
+  {
+    memcpy(s.x, pcm16 + firstSample, numRead * sizeof(signed short));
+  }
+  else
+  {
+    for (i = 0; i < numRead; i++)
+    {
+      s.x[i] = getSample16(channel, firstSample + i);
+    }
+  }
+
+  for (i = numRead; i < numSamples; i++)
+  {
+    s.x[i] = 0;
+  }
+
+  return numRead;
+}
+
+// ****************************************************************************
+// ****************************************************************************
+
+WaveFileWriter::WaveFileWriter() :
+  m_file(NULL), m_numChannels(0), m_numFrames(0), m_failed(false)
+{
+}
+
+// ****************************************************************************
+
+WaveFileWriter::~WaveFileWriter()
+{
+  close();
+}
+
+// ****************************************************************************
+/// Creates the file and writes a header with empty sizes.
+// ****************************************************************************
+
+bool WaveFileWriter::open(const string& fileName, int sampleRate, int numChannels)
+{
+  close();
+
+  if (numChannels < 1)
+  {
+    return false;
+  }
+
+  m_file = fopen(fileName.c_str(), "wb");
+  if (m_file == NULL)
+  {
+    return false;
+  }
+
+  m_numChannels = numChannels;
+  m_numFrames = 0;
+  m_failed = false;
+
+  char header[WAVE_HEADER_SIZE];
+  memcpy(header, "RIFF", 4);
+  writeUint32(header + 4, 0);
+  memcpy(header + 8, "WAVEfmt ", 8);
+  writeUint32(header + 16, 16);
+  writeUint16(header + 20, WAVE_FORMAT_PCM);
+  writeUint16(header + 22, numChannels);
+  writeUint32(header + 24, (uint32_t)sampleRate);
+  writeUint32(header + 28, (uint32_t)(sampleRate * numChannels * 2));
+  writeUint16(header + 32, numChannels * 2);
+  writeUint16(header + 34, 16);
+  memcpy(header + 36, "data", 4);
+  writeUint32(header + 40, 0);
+
+  if (fwrite(header, 1, WAVE_HEADER_SIZE, m_file) != WAVE_HEADER_SIZE)
+  {
+    m_failed = true;
+  }
+
+  return (m_failed == false);
+}
+
+// ****************************************************************************
+
+bool WaveFileWriter::writeSamples(const signed short* samples, int numFrames)
+{
+  if ((m_file == NULL) || (numFrames <= 0))
+  {
+    return (m_file != NULL);
+  }
+
+  size_t numValues = (size_t)numFrames * m_numChannels;
+  if (fwrite(samples, sizeof(signed short), numValues, m_file) != numValues)
+  {
+    m_failed = true;
+  }
+  m_numFrames += numFrames;
+
+  return (m_failed == false);
+}
+
+// ****************************************************************************
+/// Writes samples in the range [-1, 1]. They are converted like in 
+/// AudioFile (clipped and scaled by 32767) by blocks, so that no buffer of 
+/// the size of the signal is needed.
+// ****************************************************************************
+
+bool WaveFileWriter::writeSamples(const double* samples, int numFrames)
+{
+  const int BLOCK_LENGTH = 4096;
+  signed short block[BLOCK_LENGTH];
+  int numValues = numFrames * m_numChannels;
+  int i, k;
+  int blockLength;
+  bool ok = (m_file != NULL);
+
+  for (i = 0; (i < numValues) && ok; i += blockLength)
+  {
+    blockLength = min(BLOCK_LENGTH - BLOCK_LENGTH % m_numChannels, numValues - i);
+    for (k = 0; k < blockLength; k++)
+    {
+      block[k] = (signed short)(max(-1.0, min(1.0, samples[i + k])) * 32767.0);
+    }
+    ok = writeSamples(block, blockLength / m_numChannels);
+  }
+
+  return ok;
+}
+
+// ****************************************************************************
+/// Writes the sizes of the chunks in the header and closes the file.
+// ****************************************************************************
+
+bool WaveFileWriter::close()
+{
+  if (m_file == NULL)
+  {
+    return false;
+  }
+
+  uint32_t dataSize = (uint32_t)(m_numFrames * m_numChannels * 2);
+  char size[4];
+
+  writeUint32(size, dataSize + WAVE_HEADER_SIZE - 8);
+  if ((fseek(m_file, 4, SEEK_SET) != 0) || (fwrite(size, 1, 4, m_file) != 4))
+  {
+    m_failed = true;
+  }
+  writeUint32(size, dataSize);
+  if ((fseek(m_file, 40, SEEK_SET) != 0) || (fwrite(size, 1, 4, m_file) != 4))
+  {
+    m_failed = true;
+  }
+
+  if (fclose(m_file) != 0)
+  {
+    m_failed = true;
+  }
+  m_file = NULL;
+
+  return (m_failed == false);
+}
@@ -0,0 +1,136 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#ifndef __WAVE_FILE_H__
+#define __WAVE_FILE_H__
+
+#include "Signal.h"
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+// ****************************************************************************
+// Reading and writing of RIFF wave files without intermediate buffers.
+//
+// MappedWaveFile maps a wave file in memory and only locates the "fmt " and
+// "data" chunks when it is opened, so that opening a long recording of a 
+// corpus costs the same as opening a short one. The samples stay in the 
+// mapped file: 16 bit and 32 bit float PCM data are exposed as typed views, 
+// and the regions that are needed are converted to 16 bit on demand. 
+// Supported formats are 8, 16, 24 and 32 bit integer PCM and 32 bit float, 
+// plain or in the extensible format.
+//
+// WaveFileWriter writes a 16 bit PCM wave file by blocks of samples, so that
+// a synthesis can be saved while it is running. The sizes in the header are
+// set when the file is closed.
+// ****************************************************************************
+
+class MappedWaveFile
+{
+public:
+
+  MappedWaveFile();
+  ~MappedWaveFile();
+
+  // map the file and locate its format and data chunks
+  bool open(const string& fileName, string& error);
+  void close();
+
+  int sampleRate() const { return m_sampleRate; }
+  int numChannels() const { return m_numChannels; }
+  int bitDepth() const { return m_bitDepth; }
+  bool isFloat() const { return m_isFloat; }
+  int64_t numSamplesPerChannel() const { return m_numFrames; }
+
+  // interleaved samples of the mapped file, or NULL when the samples are 
+  // not in this format (or are not aligned in the file)
+  const signed short* pcm16Data() const;
+  const float* floatData() const;
+
+  // sample of a channel converted to 16 bit
+  signed short getSample16(int channel, int64_t index) const;
+  // convert numSamples samples of a channel to 16 bit, starting at 
+  // firstSample; returns the number of samples in the file
+  int readRegion(int channel, int64_t firstSample, int numSamples, Signal16& s) const;
+
+private:
+
+  // not copyable since it owns the mapping
+  MappedWaveFile(const MappedWaveFile&);
+  MappedWaveFile& operator=(const MappedWaveFile&);
+
+  bool parseChunks(string& error);
+
+  const char* m_data;
+  size_t m_size;
+#ifdef _WIN32
+  void* m_file;
+  void* m_mapping;
+#else
+  int m_file;
+#endif
+
+  int m_sampleRate;
+  int m_numChannels;
+  int m_bitDepth;
+  bool m_isFloat;
+  int m_bytesPerFrame;
+  int64_t m_numFrames;
+  const char* m_samples;
+};
+
+// ****************************************************************************
+// Streaming writer of 16 bit PCM wave files
+// ****************************************************************************
+
+class WaveFileWriter
+{
+public:
+
+  WaveFileWriter();
+  ~WaveFileWriter();
+
+  bool open(const string& fileName, int sampleRate, int numChannels);
+  // write numFrames frames of interleaved samples
+  bool writeSamples(const signed short* samples, int numFrames);
+  // the values are in the range [-1, 1]
+  bool writeSamples(const double* samples, int numFrames);
+  // set the sizes of the chunks and close the file
+  bool close();
+
+  bool isOpen() const { return m_file != NULL; }
+
+private:
+
+  // not copyable since it owns the file
+  WaveFileWriter(const WaveFileWriter&);
+  WaveFileWriter& operator=(const WaveFileWriter&);
+
+  FILE* m_file;
+  int m_numChannels;
+  int64_t m_numFrames;
+  bool m_failed;
+};
+
+#endif
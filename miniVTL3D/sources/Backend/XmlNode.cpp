@@ -35,7 +35,8 @@ static void parseStartTag(const string &input, int startPos, int endPos, XmlNode
 static string getNextToken(const string &input, int &pos, int endPos, vector<XmlError> *errors);
 static bool isValidName(const string &st);
 static bool isWhiteSpaceChar(char ch);
-static string condenseWhiteSpace(const string &input);
+static string condenseWhiteSpace(const string &input, int startPos, int endPos);
+static void addTextNode(const string &input, int startPos, int endPos, XmlNode *node);
 static void decodeErrorPositions(const string &input, vector<XmlError> &errors);
 
 
@@ -119,19 +120,9 @@ XmlNode *xmlParseString(const string &input, const string &tag, vector<XmlError>
 
 XmlNode *xmlParseFile(const string &fileName, const string &tag, vector<XmlError> *errors)
 {
-  ifstream file(fileName.c_str());
-  if (file)
+  string text;
+  if (xmlReadFile(fileName, text))
   {
-    string text;
-    string buffer;
-
-    while (!file.eof())
-    {
-      getline(file, buffer);
-      text+= buffer + "\n";
-    }
-    file.close();
-
     return xmlParseString(text, tag, errors);
   }
   else
@@ -142,6 +133,35 @@ XmlNode *xmlParseFile(const string &fileName, const string &tag, vector<XmlError
 }
 
 
+// ****************************************************************************
+/// Reads the whole content of the given file into text with a single read
+/// operation. Returns false if the file could not be opened.
+// ****************************************************************************
+
+bool xmlReadFile(const string &fileName, string &text)
+{
+  ifstream file(fileName.c_str(), ios::binary);
+  if (!file)
+  {
+    return false;
+  }
+
+  file.seekg(0, ios::end);
+  streamoff fileSize = file.tellg();
+  file.seekg(0, ios::beg);
+
+  text.resize(fileSize > 0 ? (size_t)fileSize : 0);
+  if (text.empty() == false)
+  {
+    file.read(&text[0], text.size());
+    text.resize((size_t)file.gcount());
+  }
+  file.close();
+
+  return true;
+}
+
+
 // ****************************************************************************
 /// Prints the list with errors encountered during parsing an XML document.
 // ****************************************************************************
@@ -353,8 +373,9 @@ static XmlNode *parseElement(const string &input, int &pos, XmlNode *parent, vec
   // element.
   // ****************************************************************
 
-  string text;
-  text.reserve(1024);   // Reserve some space to save time.
+  // The text chars are not copied while they are collected. Only the 
+  // position of the first char of the current text is kept.
+  int textStartPos = pos;
 
   while ((pos+1 < inputLength) && 
          ((input[pos] != '<') || (input[pos+1] != '/')))
@@ -364,14 +385,7 @@ static XmlNode *parseElement(const string &input, int &pos, XmlNode *parent, vec
     if (input[pos] == '<')
     {
       // Check if we have to write out a text child node.
-      text = condenseWhiteSpace(text);
-      if (text.empty() == false)
-      {
-        XmlNode *textNode = new XmlNode( XmlNode::TEXT, node );
-        textNode->text = text;
-        node->child.push_back(textNode);
-        text.clear();
-      }
+      addTextNode(input, textStartPos, pos, node);
 
       // Parse the child element node.
       XmlNode *childNode = parseElement(input, pos, node, errors);
@@ -379,25 +393,19 @@ static XmlNode *parseElement(const string &input, int &pos, XmlNode *parent, vec
       {
         node->child.push_back(childNode);
       }
+      textStartPos = pos;
     }
     else
 
     // Collect normal text chars for text child nodes.
     {
-      text+= input[pos];
       pos++;
     }
   }
 
   // Check if we have to write out a final text child node.
 
-  text = condenseWhiteSpace(text);
-  if (text.empty() == false)
-  {
-    XmlNode *textNode = new XmlNode( XmlNode::TEXT, node );
-    textNode->text = text;
-    node->child.push_back(textNode);
-  }
+  addTextNode(input, textStartPos, min(pos, inputLength), node);
 
   // Make a separate list of childs that contain only sub-elements
 
@@ -593,9 +601,9 @@ static string getNextToken(const string &input, int &pos, int endPos, vector<Xml
     return string("");
   }
 
+  // The chars of the token are copied at once at the end.
   string token;
-  // Reserve some space for the expected characters for performance reasons
-  token.reserve(256);   
+  int tokenStartPos;
 
   // ****************************************************************
   // The token is the equality sign.
@@ -618,11 +626,12 @@ static string getNextToken(const string &input, int &pos, int endPos, vector<Xml
     // Got to the char after the leading quote.
     pos++;
     // Collect all characters up to the next single quote.
+    tokenStartPos = pos;
     while ((pos <= endPos) && (input[pos] != '\''))
     {
-      token+= input[pos];
       pos++;
     }
+    token.assign(input, tokenStartPos, min(pos, endPos + 1) - tokenStartPos);
 
     if ((pos > endPos) && (errors != NULL))
     {
@@ -647,11 +656,12 @@ static string getNextToken(const string &input, int &pos, int endPos, vector<Xml
     // Got to the char after the leading quote.
     pos++;
     // Collect all characters up to the next qouble quote.
+    tokenStartPos = pos;
     while ((pos <= endPos) && (input[pos] != '"'))
     {
-      token+= input[pos];
       pos++;
     }
+    token.assign(input, tokenStartPos, min(pos, endPos + 1) - tokenStartPos);
 
     if ((pos > endPos) && (errors != NULL))
     {
@@ -672,6 +682,7 @@ static string getNextToken(const string &input, int &pos, int endPos, vector<Xml
   // ****************************************************************
   {
     // Collect chars until we find the next white space or reserved char
+    tokenStartPos = pos;
     while ((pos <= endPos) && 
       (isWhiteSpaceChar(input[pos]) == false) && 
       (input[pos] != '=') &&
@@ -679,9 +690,9 @@ static string getNextToken(const string &input, int &pos, int endPos, vector<Xml
       (input[pos] != '>') &&
       (input[pos] != '/'))
     {
-      token+= input[pos];
       pos++;
     }
+    token.assign(input, tokenStartPos, pos - tokenStartPos);
   }
 
   return token;
@@ -764,26 +775,25 @@ static bool isWhiteSpaceChar(char ch)
 
 // ****************************************************************************
 /// This function reduces all sequences of two or more white space characters
-/// between normal text characters to exactly one space character.
-/// White space at the beginning and the end of the input text is completely
+/// between normal text characters of the input text from startPos to 
+/// endPos - 1 to exactly one space character.
+/// White space at the beginning and the end of the text is completely
 /// removed.
 // ****************************************************************************
 
-static string condenseWhiteSpace(const string &input)
+static string condenseWhiteSpace(const string &input, int startPos, int endPos)
 {
   int i;
-  int inputLength = (int)input.length();
   bool normalCharSeen = false;
   
   string output;
-  output.reserve(1024);
 
-  for (i=0; i < inputLength; i++)
+  for (i=startPos; i < endPos; i++)
   {
     // We are on a non-white-space char.
     if (isWhiteSpaceChar( input[i] ) == false)
     {
-      if (i == 0)
+      if (i == startPos)
       {
         output+= input[i];
       }
@@ -805,6 +815,30 @@ static string condenseWhiteSpace(const string &input)
 }
 
 
+// ****************************************************************************
+/// Appends a text child node to the given node for the text of the input 
+/// from startPos to endPos - 1, unless it only contains white space (e.g.,
+/// the indentation between elements), which is the most frequent case.
+// ****************************************************************************
+
+static void addTextNode(const string &input, int startPos, int endPos, XmlNode *node)
+{
+  int i = startPos;
+  while ((i < endPos) && (isWhiteSpaceChar(input[i])))
+  {
+    i++;
+  }
+  if (i >= endPos)
+  {
+    return;
+  }
+
+  XmlNode *textNode = new XmlNode( XmlNode::TEXT, node );
+  textNode->text = condenseWhiteSpace(input, startPos, endPos);
+  node->child.push_back(textNode);
+}
+
+
 // ****************************************************************************
 /// This function transforms the linear character positions of the errors into
 /// line and column numbers for the given input string.
@@ -46,6 +46,7 @@ class XmlNode;
 
 XmlNode *xmlParseString(const string &input, const string &tag, vector<XmlError> *errors = NULL);
 XmlNode *xmlParseFile(const string &fileName, const string &tag, vector<XmlError> *errors = NULL);
+bool xmlReadFile(const string &fileName, string &text);
 void xmlPrintErrors(vector<XmlError> &errors);
 void xmlTest();
 
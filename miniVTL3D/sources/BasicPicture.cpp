@@ -20,6 +20,7 @@
 // ****************************************************************************
 
 #include "BasicPicture.h"
+#include "GuiTimings.h"
 
 
 // ****************************************************************************
@@ -107,6 +108,39 @@ void BasicPicture::OnPaint(wxPaintEvent &event)
 
   // Draw on the device context.
   draw(dc);
+
+  if (GuiTimings::getInstance().isEnabled())
+  {
+    drawTimingOverlay(dc);
+  }
+}
+
+
+// ****************************************************************************
+/// Draws the duration of the last and the slowest paint of this picture in
+/// the lower left corner. The paint currently drawn is only counted in the
+/// next overlay, since it is timed until the end of the event handler.
+// ****************************************************************************
+
+void BasicPicture::drawTimingOverlay(wxDC &dc)
+{
+  GuiTimings::handlerStats stats;
+  if (!GuiTimings::getInstance().get(
+    GuiTimings::handlerName(this, "paint"), stats)) { return; }
+
+  wxString text = wxString::Format("paint %.1f ms (max %.1f ms, %ld)",
+    stats.last * 1000.0, stats.max * 1000.0, stats.calls);
+
+  int w, h, textWidth, textHeight;
+  this->GetSize(&w, &h);
+  dc.SetFont(*wxSMALL_FONT);
+  dc.GetTextExtent(text, &textWidth, &textHeight);
+
+  dc.SetPen(*wxBLACK_PEN);
+  dc.SetBrush(*wxWHITE_BRUSH);
+  dc.DrawRectangle(0, h - textHeight - 4, textWidth + 6, textHeight + 4);
+  dc.SetTextForeground(*wxBLACK);
+  dc.DrawText(text, 3, h - textHeight - 2);
 }
 
 
@@ -54,6 +54,7 @@ private:
 private:
   void OnPaint(wxPaintEvent &event);
   void OnEraseBackground(wxEraseEvent &event);
+  void drawTimingOverlay(wxDC &dc);
 
   // ****************************************************************************
   // Declare the event table right at the end
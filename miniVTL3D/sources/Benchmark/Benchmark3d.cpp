@@ -0,0 +1,333 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#include "../Backend/Acoustic3dSimulation.h"
+#include "../Backend/Profiler.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <functional>
+#include <cstdlib>
+
+using namespace std;
+
+// ****************************************************************************
+// Headless benchmark of the kernels of the 3D acoustic simulation.
+// It imports a geometry csv file (for example the hollow cylinder or the 
+// tapered elbow generated by helper/02-stl-to-csv), times the computation of 
+// the modes, junction matrices, radiation impedance, the propagation at 
+// several numbers of modes and a transfer function sweep, and writes the 
+// results in a JSON file. The test scenarios of runTest and the cone 
+// concatenation simulation can be timed too, so that the validation cases 
+// double as performance regression tests.
+// ****************************************************************************
+
+struct benchmarkResult
+{
+  string name;
+  double time;        // mean time of a repetition (s)
+  int repetitions;
+  int numModes;       // total number of modes of the segments (-1 if irrelevant)
+};
+
+// ****************************************************************************
+// Time the mean duration of a function with a monotonic clock
+
+static double timeFunction(const function<void()>& func, int repetitions)
+{
+  auto start = chrono::steady_clock::now();
+  for (int i(0); i < repetitions; i++) { func(); }
+  auto end = chrono::steady_clock::now();
+  return chrono::duration<double>(end - start).count() / (double)repetitions;
+}
+
+// ****************************************************************************
+
+static int totalNumberOfModes(Acoustic3dSimulation& simu)
+{
+  int numModes(0);
+  for (int i(0); i < simu.numberOfSegments(); i++)
+  {
+    numModes += simu.crossSection(i)->numberOfModes();
+  }
+  return numModes;
+}
+
+// ****************************************************************************
+
+static void setSimulationParameters(Acoustic3dSimulation& simu,
+  const struct simulationParameters& params)
+{
+  simu.setSimulationParameters(simu.meshDensity(), simu.idxSecNoiseSource(),
+    params, simu.mouthBoundaryCond(), simu.contInterpMeth());
+}
+
+// ****************************************************************************
+
+static void computeModesAndJunctions(Acoustic3dSimulation& simu)
+{
+  for (int i(0); i < simu.numberOfSegments(); i++)
+  {
+    simu.crossSection(i)->setModesNumber(0);
+  }
+  simu.computeMeshAndModes();
+  simu.computeAllJunctionMatrices();
+}
+
+// ****************************************************************************
+
+static bool writeResults(const string& fileName, const string& geometry,
+  int numThreads, const vector<benchmarkResult>& results)
+{
+  ofstream ofs(fileName);
+  if (!ofs.is_open()) { return false; }
+
+  ofs << "{" << endl;
+  ofs << "  \"geometry\": \"" << geometry << "\"," << endl;
+  ofs << "  \"threads\": " << numThreads << "," << endl;
+  ofs << "  \"results\": [" << endl;
+  for (int i(0); i < results.size(); i++)
+  {
+    ofs << "    { \"name\": \"" << results[i].name << "\", \"time\": " 
+      << results[i].time << ", \"repetitions\": " << results[i].repetitions;
+    if (results[i].numModes >= 0)
+    {
+      ofs << ", \"modes\": " << results[i].numModes;
+    }
+    ofs << " }" << (i < results.size() - 1 ? "," : "") << endl;
+  }
+  ofs << "  ]" << endl << "}" << endl;
+  ofs.close();
+
+  return true;
+}
+
+// ****************************************************************************
+
+static void printUsage()
+{
+  cout << "Usage: Benchmark3d geometry.csv [options]" << endl
+    << "  --output file      JSON file of the results (default benchmark.json)" << endl
+    << "  --threads n        number of threads" << endl
+    << "  --repetitions n    repetitions of the propagation (default 5)" << endl
+    << "  --max-freq f       maximal frequency of the transfer function (Hz)" << endl
+    << "  --no-tf            skip the transfer function sweep" << endl
+    << "  --run-tests        time the test scenarios of runTest" << endl
+    << "  --cone file        time the cone concatenation simulation of file" << endl
+    << "  --single-precision n  deviation of the single precision propagation at n frequencies" << endl
+    << "  --trace file       export the profiler timeline in Chrome trace format" << endl
+    << "  --profile file     export the profiler statistics of the phases in JSON" << endl;
+}
+
+// ****************************************************************************
+
+int main(int argc, char* argv[])
+{
+  if (argc < 2) { printUsage(); return 1; }
+
+  string geometryFile(argv[1]);
+  string outputFile("benchmark.json"), traceFile, profileFile, coneFile;
+  int numThreads(-1), repetitions(5);
+  double maxFreq(-1.);
+  bool computeTf(true), runTests(false);
+  int precisionFreqs(0);
+
+  for (int i(2); i < argc; i++)
+  {
+    string arg(argv[i]);
+    if ((arg == "--output") && (i + 1 < argc)) { outputFile = argv[++i]; }
+    else if ((arg == "--threads") && (i + 1 < argc)) { numThreads = atoi(argv[++i]); }
+    else if ((arg == "--repetitions") && (i + 1 < argc)) { repetitions = max(1, atoi(argv[++i])); }
+    else if ((arg == "--max-freq") && (i + 1 < argc)) { maxFreq = atof(argv[++i]); }
+    else if ((arg == "--trace") && (i + 1 < argc)) { traceFile = argv[++i]; }
+    else if ((arg == "--profile") && (i + 1 < argc)) { profileFile = argv[++i]; }
+    else if ((arg == "--cone") && (i + 1 < argc)) { coneFile = argv[++i]; }
+    else if (arg == "--no-tf") { computeTf = false; }
+    else if (arg == "--run-tests") { runTests = true; }
+    else if ((arg == "--single-precision") && (i + 1 < argc)) { precisionFreqs = atoi(argv[++i]); }
+    else { printUsage(); return 1; }
+  }
+
+  Acoustic3dSimulation simu;
+  vector<benchmarkResult> results;
+  struct simulationParameters params(simu.simuParams());
+  if (numThreads > 0) { params.numThreads = numThreads; }
+  if (maxFreq > 0.) { params.maxComputedFreq = maxFreq; }
+  setSimulationParameters(simu, params);
+  simu.generateLogFileHeader(true);
+  if ((traceFile != "") || (profileFile != "")) 
+  { 
+    Profiler::getInstance().setEnabled(true); 
+  }
+
+  //*********************************************************
+  // import the geometry (the vocal tract is not used for an
+  // imported geometry)
+  //*********************************************************
+
+  bool imported(false);
+  simu.requestReloadGeometry();
+  simu.setGeometryImported(true);
+  simu.setContourInterpolationMethod(FROM_FILE);
+  simu.setGeometryFile(geometryFile);
+  results.push_back({ "importGeometry", timeFunction([&]() 
+    { imported = simu.importGeometry(NULL); }, 1), 1, -1 });
+  if (!imported || (simu.numberOfSegments() == 0))
+  {
+    cerr << "Cannot import the geometry " << geometryFile << endl;
+    return 1;
+  }
+  int lastSec(simu.numberOfSegments() - 1);
+
+  //*********************************************************
+  // modes, junction matrices and radiation impedance
+  //*********************************************************
+
+  for (int i(0); i < simu.numberOfSegments(); i++)
+  {
+    simu.crossSection(i)->setModesNumber(0);
+  }
+  results.push_back({ "computeModes", timeFunction([&]() 
+    { simu.computeMeshAndModes(); }, 1), 1, -1 });
+  results.back().numModes = totalNumberOfModes(simu);
+
+  results.push_back({ "computeJunctionMatrices", timeFunction([&]() 
+    { simu.computeAllJunctionMatrices(); }, 1), 1, totalNumberOfModes(simu) });
+
+  if (simu.mouthBoundaryCond() == RADIATION)
+  {
+    results.push_back({ "radiationImpedance", timeFunction([&]() 
+      { simu.preComputeRadiationMatrices(16, lastSec); }, 1), 1,
+      simu.crossSection(lastSec)->numberOfModes() });
+  }
+
+  //*********************************************************
+  // propagation at several numbers of modes (set through 
+  // the maximal cut-on frequency)
+  //*********************************************************
+
+  double maxCutOnFreqs[3] = { params.maxCutOnFreq / 2., params.maxCutOnFreq, 
+    params.maxCutOnFreq * 2. };
+  std::chrono::duration<double> timePropa(0.), timeExp(0.);
+  for (int c(0); c < 3; c++)
+  {
+    struct simulationParameters propaParams(params);
+    propaParams.maxCutOnFreq = maxCutOnFreqs[c];
+    setSimulationParameters(simu, propaParams);
+    computeModesAndJunctions(simu);
+    if (simu.mouthBoundaryCond() == RADIATION)
+    {
+      simu.preComputeRadiationMatrices(16, lastSec);
+    }
+
+    stringstream name;
+    name << "propagateMagnus maxCutOnFreq " << maxCutOnFreqs[c];
+    results.push_back({ name.str(), timeFunction([&]() 
+      { simu.solveWaveProblem(NULL, 1000., timePropa, &timeExp); }, repetitions),
+      repetitions, totalNumberOfModes(simu) });
+  }
+
+  //*********************************************************
+  // transfer function sweep
+  //*********************************************************
+
+  if (computeTf)
+  {
+    setSimulationParameters(simu, params);
+    simu.requestModesAndJunctionComputation();
+    results.push_back({ "transferFunction", timeFunction([&]()
+      { simu.computeTransferFunction(NULL); }, 1), 1, -1 });
+    results.back().numModes = totalNumberOfModes(simu);
+  }
+
+  //*********************************************************
+  // transfer functions with the single precision propagation
+  // (the deviation from double precision is in the log file)
+  //*********************************************************
+
+  if (precisionFreqs > 0)
+  {
+    struct simulationParameters singleParams(params);
+    singleParams.singlePrecisionPropagation = true;
+    setSimulationParameters(simu, singleParams);
+    simu.requestModesAndJunctionComputation();
+    double deviation(0.);
+    results.push_back({ "singlePrecisionDeviation", timeFunction([&]()
+      { deviation = simu.singlePrecisionDeviation(NULL, precisionFreqs); }, 1), 1, -1 });
+    cout << "Single precision propagation maximal deviation: " << deviation 
+      << " dB" << endl;
+    setSimulationParameters(simu, params);
+  }
+
+  //*********************************************************
+  // test scenarios
+  //*********************************************************
+
+  if (runTests)
+  {
+    pair<enum testType, string> tests[4] = { {MATRIX_E, "runTest MATRIX_E"},
+      {DISCONTINUITY, "runTest DISCONTINUITY"}, 
+      {ELEPHANT_TRUNK, "runTest ELEPHANT_TRUNK"},
+      {SCALE_RAD_IMP, "runTest SCALE_RAD_IMP"} };
+    for (auto& test : tests)
+    {
+      results.push_back({ test.second, timeFunction([&]() 
+        { simu.runTest(test.first, ""); }, 1), 1, -1 });
+    }
+  }
+
+  if (coneFile != "")
+  {
+    results.push_back({ "coneConcatenationSimulation", timeFunction([&]() 
+      { simu.coneConcatenationSimulation(coneFile); }, 1), 1, -1 });
+  }
+
+  //*********************************************************
+  // export the results
+  //*********************************************************
+
+  for (auto& res : results)
+  {
+    cout << res.name << ": " << res.time << " s" << endl;
+  }
+
+  if (!writeResults(outputFile, geometryFile, simu.simuParams().numThreads, results))
+  {
+    cerr << "Cannot write the results in " << outputFile << endl;
+    return 1;
+  }
+  if ((traceFile != "") && !Profiler::getInstance().exportChromeTrace(traceFile))
+  {
+    cerr << "Cannot write the trace in " << traceFile << endl;
+    return 1;
+  }
+  if ((profileFile != "") && !Profiler::getInstance().exportJson(profileFile))
+  {
+    cerr << "Cannot write the profile in " << profileFile << endl;
+    return 1;
+  }
+  Logger::getInstance().flush();
+
+  return 0;
+}
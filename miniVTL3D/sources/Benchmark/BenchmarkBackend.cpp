@@ -0,0 +1,389 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+
+#include "../Backend/VocalTractLabApi.h"
+#include "../Backend/Synthesizer.h"
+#include "../Backend/TdsModel.h"
+#include "../Backend/VocalTract.h"
+#include "../Backend/GeometricGlottis.h"
+#include "../Backend/TwoMassModel.h"
+#include "../Backend/TriangularGlottis.h"
+#include "../Backend/F0EstimatorYin.h"
+#include "../Backend/VoiceQualityEstimator.h"
+#include "../Backend/Dsp.h"
+#include "../Backend/Signal.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+
+using namespace std;
+
+// ****************************************************************************
+// Headless benchmark of the backend apart from the time-domain simulation 
+// (see BenchmarkTds.cpp) and the 3D simulation (see Benchmark3d.cpp). It 
+// measures the latency of vtlInitialize(), the real-time factor of 
+// Synthesizer::synthesizeTractSequence(), the time of complexFFT() and 
+// realFFT() for each length exponent, and the throughput of the F0 and 
+// voice quality estimation. The inputs are generated from the default 
+// models (speaker file, tract sequence and the audio signal synthesized 
+// from it), so that no data file is needed, and each result comes with a 
+// check value to compare the outputs of two builds. The results are written
+// in a JSON file.
+// ****************************************************************************
+
+struct benchmarkResult
+{
+  string name;
+  double value;
+  string unit;
+  double check;       // value depending on the output of the computation
+};
+
+static double elapsed(chrono::steady_clock::time_point start)
+{
+  return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// ****************************************************************************
+// Write the speaker file of the default vocal tract and glottis models
+
+static bool writeDefaultSpeaker(const string& fileName)
+{
+  ofstream os(fileName);
+  if (!os.is_open()) { return false; }
+
+  VocalTract *vocalTract = new VocalTract();
+  GeometricGlottis geometricGlottis;
+  TwoMassModel twoMassModel;
+  TriangularGlottis triangularGlottis;
+  Glottis* glottis[3] = { &geometricGlottis, &twoMassModel, &triangularGlottis };
+
+  os << "<speaker>" << endl;
+  vocalTract->writeToXml(os, 2);
+  os << "  <glottis_models>" << endl;
+  for (int i(0); i < 3; i++) { glottis[i]->writeToXml(os, 4, i == 0); }
+  os << "  </glottis_models>" << endl;
+  os << "</speaker>" << endl;
+  delete vocalTract;
+
+  return (bool)os;
+}
+
+// ****************************************************************************
+// Write a tract sequence file of numStates states (one every 
+// Synthesizer::NUM_CHUNCK_SAMPLES samples). The vocal tract parameters 
+// oscillate around their neutral values and the glottis keeps its
+// neutral parameters.
+
+static bool writeTractSequence(const string& fileName, Glottis* glottis,
+  VocalTract* vocalTract, int numStates)
+{
+  ofstream os(fileName);
+  if (!os.is_open()) { return false; }
+
+  for (int i(0); i < 6; i++) { os << "# Tract sequence of BenchmarkBackend" << endl; }
+  os << glottis->getName() << endl;
+  os << numStates << endl;
+
+  for (int s(0); s < numStates; s++)
+  {
+    for (auto& param : glottis->controlParam) { os << param.neutral << " "; }
+    os << endl;
+
+    double phase(2. * M_PI * (double)s / 100.);
+    for (int i(0); i < VocalTract::NUM_PARAMS; i++)
+    {
+      const VocalTract::Param& param(vocalTract->param[i]);
+      double value(param.neutral + 0.2 * (param.max - param.min) * sin(phase + i));
+      os << max(param.min, min(param.max, value)) << " ";
+    }
+    os << endl;
+  }
+
+  return (bool)os;
+}
+
+// ****************************************************************************
+
+static benchmarkResult timeInitialize(const string& speakerFile, bool useCache,
+  int repetitions)
+{
+  vtlUseSpeakerCache(useCache ? 1 : 0);
+  if (useCache)
+  {
+    // the first call writes the cache
+    vtlInitialize(speakerFile.c_str());
+    vtlClose();
+  }
+
+  double time(0.);
+  int failures(0);
+  for (int r(0); r < repetitions; r++)
+  {
+    auto start = chrono::steady_clock::now();
+    if (vtlInitialize(speakerFile.c_str()) != 0) { failures++; }
+    time += elapsed(start);
+    vtlClose();
+  }
+  vtlUseSpeakerCache(0);
+
+  return { useCache ? "vtlInitialize cached" : "vtlInitialize",
+    1000. * time / (double)repetitions, "ms", (double)failures };
+}
+
+// ****************************************************************************
+
+static benchmarkResult timeTractSequence(const string& sequenceFile,
+  Glottis* glottis, VocalTract* vocalTract, int repetitions, vector<double>& audio)
+{
+  TdsModel tdsModel;
+  double time(0.);
+
+  for (int r(0); r < repetitions; r++)
+  {
+    auto start = chrono::steady_clock::now();
+    Synthesizer::synthesizeTractSequence(sequenceFile, glottis, vocalTract,
+      &tdsModel, audio);
+    time += elapsed(start);
+  }
+
+  double sum(0.);
+  for (auto& x : audio) { sum += x * x; }
+  double duration_s((double)audio.size() / (double)SAMPLING_RATE);
+
+  return { "synthesizeTractSequence", 
+    (duration_s > 0.) ? time / (double)repetitions / duration_s : 0., 
+    "real-time factor", audio.empty() ? 0. : sqrt(sum / (double)audio.size()) };
+}
+
+// ****************************************************************************
+// Time of one transform of the length 2^lengthExponent (the number of 
+// transforms is chosen so that about 2^24 values are transformed)
+
+static benchmarkResult timeFft(int lengthExponent, bool real)
+{
+  int N(1 << lengthExponent);
+  int numTransforms(max(1, (1 << 24) / N));
+  ComplexSignal s(N);
+  double check(0.);
+
+  srand(1);
+  for (int i(0); i < N; i++)
+  {
+    s.re[i] = (double)rand() / (double)RAND_MAX - 0.5;
+    s.im[i] = real ? 0. : (double)rand() / (double)RAND_MAX - 0.5;
+  }
+
+  // the normalized transforms followed by the inverse ones keep the signal
+  auto start = chrono::steady_clock::now();
+  for (int t(0); t < numTransforms; t++)
+  {
+    if (real) { realFFT(s, lengthExponent, true); }
+    else { complexFFT(s, lengthExponent, true); }
+    complexIFFT(s, lengthExponent, false);
+    if (real) { for (int i(0); i < N; i++) { s.im[i] = 0.; } }
+  }
+  double time(elapsed(start));
+
+  for (int i(0); i < N; i++) { check += s.re[i] * s.re[i] + s.im[i] * s.im[i]; }
+
+  return { string(real ? "realFFT " : "complexFFT ") + to_string(lengthExponent), 
+    1e6 * time / (double)numTransforms, "us per transform and inverse", check };
+}
+
+// ****************************************************************************
+
+template<class Estimator> static benchmarkResult timeEstimator(const string& name,
+  Signal16& signal, int repetitions)
+{
+  vector<double> values;
+  double time(0.);
+
+  for (int r(0); r < repetitions; r++)
+  {
+    Estimator estimator;
+    auto start = chrono::steady_clock::now();
+    estimator.init(&signal, 0, signal.N);
+    while (estimator.processChunk(SAMPLING_RATE / 2) == false) {}
+    values = estimator.finish();
+    time += elapsed(start);
+  }
+
+  double sum(0.);
+  for (auto& v : values) { sum += v; }
+
+  return { name, (double)repetitions * (double)signal.N / time, "samples/s",
+    values.empty() ? 0. : sum / (double)values.size() };
+}
+
+// ****************************************************************************
+
+static bool writeResults(const string& fileName, const vector<benchmarkResult>& results)
+{
+  ofstream ofs(fileName);
+  if (!ofs.is_open()) { return false; }
+
+  ofs.precision(12);
+  ofs << "{" << endl;
+  ofs << "  \"results\": [" << endl;
+  for (int i(0); i < results.size(); i++)
+  {
+    ofs << "    { \"name\": \"" << results[i].name << "\", \"value\": " 
+      << results[i].value << ", \"unit\": \"" << results[i].unit 
+      << "\", \"check\": " << results[i].check << " }" 
+      << (i < results.size() - 1 ? "," : "") << endl;
+  }
+  ofs << "  ]" << endl << "}" << endl;
+  ofs.close();
+
+  return true;
+}
+
+// ****************************************************************************
+
+static void printUsage()
+{
+  cout << "Usage: BenchmarkBackend [options]" << endl
+    << "  --output file      JSON file of the results (default benchmark_backend.json)" << endl
+    << "  --speaker file     speaker file of vtlInitialize (default: the default" << endl
+    << "                     models written in benchmark_backend.speaker)" << endl
+    << "  --duration s       duration of the tract sequence (default 1 s)" << endl
+    << "  --repetitions n    repetitions of each measure (default 3)" << endl;
+}
+
+// ****************************************************************************
+
+int main(int argc, char* argv[])
+{
+  string outputFile("benchmark_backend.json");
+  string speakerFile;
+  string sequenceFile("benchmark_backend_tract_sequence.txt");
+  double duration_s(1.);
+  int repetitions(3);
+
+  for (int i(1); i < argc; i++)
+  {
+    string arg(argv[i]);
+    if ((arg == "--output") && (i + 1 < argc)) { outputFile = argv[++i]; }
+    else if ((arg == "--speaker") && (i + 1 < argc)) { speakerFile = argv[++i]; }
+    else if ((arg == "--duration") && (i + 1 < argc)) { duration_s = atof(argv[++i]); }
+    else if ((arg == "--repetitions") && (i + 1 < argc)) { repetitions = max(1, atoi(argv[++i])); }
+    else { printUsage(); return 1; }
+  }
+
+  vector<benchmarkResult> results;
+
+  //*********************************************************
+  // latency of vtlInitialize
+  //*********************************************************
+
+  bool defaultSpeaker(speakerFile.empty());
+  if (defaultSpeaker)
+  {
+    speakerFile = "benchmark_backend.speaker";
+    if (!writeDefaultSpeaker(speakerFile))
+    {
+      cerr << "Cannot write the speaker file " << speakerFile << endl;
+      return 1;
+    }
+  }
+  results.push_back(timeInitialize(speakerFile, false, repetitions));
+  results.push_back(timeInitialize(speakerFile, true, repetitions));
+
+  //*********************************************************
+  // synthesis of a tract sequence
+  //*********************************************************
+
+  VocalTract *vocalTract = new VocalTract();
+  vocalTract->calculateAll();
+  GeometricGlottis glottis;
+  int numStates(max(1, (int)(duration_s * (double)SAMPLING_RATE) / 
+    Synthesizer::NUM_CHUNCK_SAMPLES));
+  if (!writeTractSequence(sequenceFile, &glottis, vocalTract, numStates))
+  {
+    cerr << "Cannot write the tract sequence " << sequenceFile << endl;
+    delete vocalTract;
+    return 1;
+  }
+
+  vector<double> audio;
+  results.push_back(timeTractSequence(sequenceFile, &glottis, vocalTract, 
+    repetitions, audio));
+  delete vocalTract;
+
+  //*********************************************************
+  // FFT
+  //*********************************************************
+
+  for (int e(6); e <= 16; e++)
+  {
+    results.push_back(timeFft(e, false));
+    results.push_back(timeFft(e, true));
+  }
+
+  //*********************************************************
+  // F0 and voice quality estimation of the synthesized audio
+  //*********************************************************
+
+  double maxAmp(1e-12);
+  for (auto& x : audio) { maxAmp = max(maxAmp, abs(x)); }
+  Signal16 signal((int)audio.size());
+  for (int i(0); i < signal.N; i++)
+  {
+    signal.x[i] = (signed short)(30000. * audio[i] / maxAmp);
+  }
+
+  results.push_back(timeEstimator<F0EstimatorYin>("F0EstimatorYin", signal, repetitions));
+  results.push_back(timeEstimator<VoiceQualityEstimator>("VoiceQualityEstimator", 
+    signal, repetitions));
+
+  //*********************************************************
+  // export the results
+  //*********************************************************
+
+  remove(sequenceFile.c_str());
+  if (defaultSpeaker)
+  {
+    remove(speakerFile.c_str());
+    remove((speakerFile + ".cache").c_str());
+  }
+
+  for (auto& res : results)
+  {
+    cout << res.name << ": " << res.value << " " << res.unit << " (check " 
+      << res.check << ")" << endl;
+  }
+
+  if (!writeResults(outputFile, results))
+  {
+    cerr << "Cannot write the results in " << outputFile << endl;
+    return 1;
+  }
+
+  return 0;
+}
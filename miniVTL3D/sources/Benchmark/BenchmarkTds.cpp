@@ -0,0 +1,329 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+
+#include "../Backend/TdsModel.h"
+#include "../Backend/TdsModelBatch.h"
+#include "../Backend/ParallelLoop.h"
+#include "../Backend/VocalTract.h"
+#include "../Backend/GeometricGlottis.h"
+#include "../Backend/StaticPhone.h"
+#include "../Backend/VowelLf.h"
+#include "../Backend/LfPulse.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+
+using namespace std;
+
+// ****************************************************************************
+// Headless benchmark of the time-domain simulation (TdsModel). It 
+// synthesizes a static phone (with the geometric glottis) and a static vowel
+// (with the LF flow source) of the neutral vocal tract shape, and reports 
+// the number of simulated samples per second for each solver, together with
+// the RMS value of the radiated flow, so that the results of two builds can
+// be compared. With --voices, the static phone is also synthesized for 
+// several voices, one after the other and in lockstep with TdsModelBatch.
+// The results are written in a JSON file.
+// ****************************************************************************
+
+struct benchmarkResult
+{
+  string name;
+  double samplesPerSecond;
+  int numSamples;
+  double rmsFlow;       // RMS value of the radiated flow (cm^3/s)
+};
+
+// ****************************************************************************
+// Set the tube and the sources of the current sample of a tube sequence and
+// move the sequence to the next sample
+
+static void setSequenceInputs(TubeSequence *sequence, TdsModel *tdsModel, Tube &tube)
+{
+  double flowSource_cm3_s, pressureSource_dPa;
+  int flowSourceSection, pressureSourceSection;
+  double pressure_dPa[4];
+
+  sequence->getTube(tube);
+  sequence->getFlowSource(flowSource_cm3_s, flowSourceSection);
+  sequence->getPressureSource(pressureSource_dPa, pressureSourceSection);
+
+  tdsModel->setTube(&tube, tdsModel->getSampleIndex() > 0);
+  tdsModel->setFlowSource(flowSource_cm3_s, flowSourceSection);
+  tdsModel->setPressureSource(pressureSource_dPa, pressureSourceSection);
+
+  // subglottal, lower glottis, upper glottis, supraglottal pressure
+  pressure_dPa[0] = tdsModel->getSectionPressure(Tube::LAST_TRACHEA_SECTION);
+  pressure_dPa[1] = tdsModel->getSectionPressure(Tube::LOWER_GLOTTIS_SECTION);
+  pressure_dPa[2] = tdsModel->getSectionPressure(Tube::UPPER_GLOTTIS_SECTION);
+  pressure_dPa[3] = tdsModel->getSectionPressure(Tube::FIRST_PHARYNX_SECTION);
+  sequence->incPos(pressure_dPa);
+}
+
+// ****************************************************************************
+// Run the time-domain simulation of a tube sequence and return the 
+// simulation time in seconds
+
+static double synthesizeSequence(TubeSequence *sequence, TdsModel *tdsModel,
+  vector<double> &flow)
+{
+  Tube tube;
+  double mouthFlow_cm3_s, nostrilFlow_cm3_s, skinFlow_cm3_s;
+
+  sequence->resetSequence();
+  tdsModel->resetMotion();
+  int numSamples(sequence->getDuration_pt());
+  flow.assign(numSamples, 0.);
+
+  auto start = chrono::steady_clock::now();
+  for (int i(0); i < numSamples; i++)
+  {
+    setSequenceInputs(sequence, tdsModel, tube);
+    flow[i] = tdsModel->proceedTimeStep(mouthFlow_cm3_s, nostrilFlow_cm3_s, skinFlow_cm3_s);
+  }
+  auto end = chrono::steady_clock::now();
+
+  return chrono::duration<double>(end - start).count();
+}
+
+// ****************************************************************************
+
+static benchmarkResult timeSequence(const string &name, TubeSequence *sequence,
+  TdsModel *tdsModel, int repetitions)
+{
+  vector<double> flow;
+  double time(0.);
+
+  for (int r(0); r < repetitions; r++)
+  {
+    time += synthesizeSequence(sequence, tdsModel, flow);
+  }
+
+  double sum(0.);
+  for (int i(0); i < flow.size(); i++) { sum += flow[i] * flow[i]; }
+
+  benchmarkResult result;
+  result.name = name;
+  result.numSamples = (int)flow.size();
+  result.samplesPerSecond = (double)(repetitions * flow.size()) / time;
+  result.rmsFlow = (flow.size() > 0) ? sqrt(sum / (double)flow.size()) : 0.;
+  return result;
+}
+
+// ****************************************************************************
+// Synthesize the static phone for numVoices voices, one after the other with
+// the skyline solver (batch = false) or in lockstep (batch = true)
+
+static benchmarkResult timeVoices(const Tube &tube, int numVoices, bool batch,
+  int duration_samples, int repetitions)
+{
+  vector<unique_ptr<GeometricGlottis>> glottis;
+  vector<unique_ptr<StaticPhone>> phones;
+  for (int v(0); v < numVoices; v++)
+  {
+    glottis.emplace_back(new GeometricGlottis());
+    phones.emplace_back(new StaticPhone());
+    phones[v]->setup(tube, glottis[v].get(), duration_samples);
+  }
+
+  TdsModelBatch voices(numVoices);
+  vector<Tube> tubes(numVoices);
+  vector<double> flow((size_t)numVoices * duration_samples);
+  double time(0.);
+
+  for (int r(0); r < repetitions; r++)
+  {
+    for (int v(0); v < numVoices; v++) { phones[v]->resetSequence(); }
+    voices.resetMotion();
+
+    auto start = chrono::steady_clock::now();
+    if (batch)
+    {
+      voices.proceedTimeSteps(duration_samples, [&](int v, TdsModel *model)
+        {
+          setSequenceInputs(phones[v].get(), model, tubes[v]);
+        }, flow.data(), threadPoolSize());
+    }
+    else
+    {
+      double mouthFlow_cm3_s, nostrilFlow_cm3_s, skinFlow_cm3_s;
+      for (int v(0); v < numVoices; v++)
+      {
+        TdsModel *model = voices.getVoice(v);
+        model->options.solverType = TdsModel::SKYLINE_CHOLESKY_FACTORIZATION;
+        for (int i(0); i < duration_samples; i++)
+        {
+          setSequenceInputs(phones[v].get(), model, tubes[v]);
+          flow[(size_t)v * duration_samples + i] = 
+            model->proceedTimeStep(mouthFlow_cm3_s, nostrilFlow_cm3_s, skinFlow_cm3_s);
+        }
+      }
+    }
+    time += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  }
+
+  double sum(0.);
+  for (int i(0); i < flow.size(); i++) { sum += flow[i] * flow[i]; }
+
+  benchmarkResult result;
+  result.name = "StaticPhone " + to_string(numVoices) + 
+    (batch ? " voices lockstep" : " voices sequential");
+  result.numSamples = (int)flow.size();
+  result.samplesPerSecond = (double)(repetitions * flow.size()) / time;
+  result.rmsFlow = (flow.size() > 0) ? sqrt(sum / (double)flow.size()) : 0.;
+  return result;
+}
+
+// ****************************************************************************
+
+static bool writeResults(const string& fileName, const vector<benchmarkResult>& results)
+{
+  ofstream ofs(fileName);
+  if (!ofs.is_open()) { return false; }
+
+  ofs.precision(12);
+  ofs << "{" << endl;
+  ofs << "  \"results\": [" << endl;
+  for (int i(0); i < results.size(); i++)
+  {
+    ofs << "    { \"name\": \"" << results[i].name << "\", \"samplesPerSecond\": " 
+      << results[i].samplesPerSecond << ", \"samples\": " << results[i].numSamples
+      << ", \"rmsFlow\": " << results[i].rmsFlow << " }" 
+      << (i < results.size() - 1 ? "," : "") << endl;
+  }
+  ofs << "  ]" << endl << "}" << endl;
+  ofs.close();
+
+  return true;
+}
+
+// ****************************************************************************
+
+static void printUsage()
+{
+  cout << "Usage: BenchmarkTds [options]" << endl
+    << "  --output file      JSON file of the results (default benchmark_tds.json)" << endl
+    << "  --duration s       duration of the synthesized phones (default 0.6 s)" << endl
+    << "  --repetitions n    repetitions of each synthesis (default 3)" << endl
+    << "  --solver name      sor, cholesky or skyline (default: all solvers)" << endl
+    << "  --voices n         also synthesize the static phone for n voices" << endl;
+}
+
+// ****************************************************************************
+
+int main(int argc, char* argv[])
+{
+  string outputFile("benchmark_tds.json");
+  double duration_s(0.6);
+  int repetitions(3);
+  int numVoices(0);
+  vector<TdsModel::SolverType> solvers = { TdsModel::SOR_GAUSS_SEIDEL,
+    TdsModel::CHOLESKY_FACTORIZATION, TdsModel::SKYLINE_CHOLESKY_FACTORIZATION };
+  const string solverNames[TdsModel::NUM_SOLVER_TYPES] = { "sor", "cholesky", "skyline" };
+
+  for (int i(1); i < argc; i++)
+  {
+    string arg(argv[i]);
+    if ((arg == "--output") && (i + 1 < argc)) { outputFile = argv[++i]; }
+    else if ((arg == "--duration") && (i + 1 < argc)) { duration_s = atof(argv[++i]); }
+    else if ((arg == "--repetitions") && (i + 1 < argc)) { repetitions = max(1, atoi(argv[++i])); }
+    else if ((arg == "--voices") && (i + 1 < argc)) { numVoices = max(0, atoi(argv[++i])); }
+    else if ((arg == "--solver") && (i + 1 < argc))
+    {
+      string name(argv[++i]);
+      solvers.clear();
+      for (int s(0); s < TdsModel::NUM_SOLVER_TYPES; s++)
+      {
+        if (name == solverNames[s]) { solvers.push_back((TdsModel::SolverType)s); }
+      }
+      if (solvers.empty()) { printUsage(); return 1; }
+    }
+    else { printUsage(); return 1; }
+  }
+
+  //*********************************************************
+  // the tube of the neutral vocal tract shape
+  //*********************************************************
+
+  VocalTract *vocalTract = new VocalTract();
+  Tube tube;
+  vocalTract->calculateAll();
+  vocalTract->getTube(&tube);
+
+  GeometricGlottis glottis;
+  int duration_samples((int)(duration_s * (double)SAMPLING_RATE));
+
+  StaticPhone staticPhone;
+  staticPhone.setup(tube, &glottis, duration_samples);
+
+  LfPulse lfPulse;
+  VowelLf vowelLf;
+  vowelLf.setup(tube, lfPulse, duration_samples);
+
+  //*********************************************************
+  // synthesis with each solver
+  //*********************************************************
+
+  TdsModel *tdsModel = new TdsModel();
+  vector<benchmarkResult> results;
+
+  for (auto solver : solvers)
+  {
+    tdsModel->options.solverType = solver;
+    results.push_back(timeSequence("StaticPhone " + solverNames[solver], 
+      &staticPhone, tdsModel, repetitions));
+    results.push_back(timeSequence("VowelLf " + solverNames[solver], 
+      &vowelLf, tdsModel, repetitions));
+  }
+
+  if (numVoices > 0)
+  {
+    results.push_back(timeVoices(tube, numVoices, false, duration_samples, repetitions));
+    results.push_back(timeVoices(tube, numVoices, true, duration_samples, repetitions));
+  }
+
+  //*********************************************************
+  // export the results
+  //*********************************************************
+
+  for (auto& res : results)
+  {
+    cout << res.name << ": " << res.samplesPerSecond << " samples/s (rms flow " 
+      << res.rmsFlow << " cm^3/s)" << endl;
+  }
+
+  delete tdsModel;
+  delete vocalTract;
+
+  if (!writeResults(outputFile, results))
+  {
+    cerr << "Cannot write the results in " << outputFile << endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,860 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and Rmi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#include "../Backend/Acoustic3dSimulation.h"
+#include "../Backend/SimulationParametersFile.h"
+#include "../Backend/BatchSimulation.h"
+#include "../Backend/TfLibrary.h"
+#include "../Backend/SimulationServer.h"
+#include "../Backend/ConvergenceStudy.h"
+#include "../Backend/ModesCache.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstdlib>
+#include <algorithm>
+#include <sstream>
+
+using namespace std;
+
+// ****************************************************************************
+// Command line driver of the 3D acoustic simulation, linking only the 
+// backend. It imports a geometry csv file, sets the simulation parameters 
+// from a parameter file (see SimulationParametersFile.h) and computes the 
+// transfer functions and/or the acoustic field, which are exported in the 
+// same text formats as in the GUI, or written in NPY files while they are
+// computed. It can also compute the transfer functions of a batch of 
+// geometries (see BatchSimulation.h), build a library of the transfer 
+// functions of vocal tract shapes (see TfLibrary.h), run as a server of
+// jobs keeping the speakers and the simulations loaded (see 
+// SimulationServer.h) and study the convergence of the solver settings of a
+// geometry (see ConvergenceStudy.h).
+// ****************************************************************************
+
+static void printUsage()
+{
+  cout << "Usage: Vocal3dCli geometry.csv parameters.txt [options]" << endl
+    << "  --tf file            export the glottal source transfer function" << endl
+    << "  --noise-tf file      export the noise source transfer function" << endl
+    << "  --noise-sources-tf file  export the transfer functions of the noise" << endl
+    << "                       sources given by the keys noiseSourceSection" << endl
+    << "  --glottis-conds-tf file  export the noise sources transfer functions" << endl
+    << "                       with the conditions of the keys" << endl
+    << "                       extraGlottisBoundaryCond" << endl
+    << "  --input-imped file   export the input impedance" << endl
+    << "  --tf-rational file n delay  export a rational model with n poles of the"
+    << " glottal source transfer function of the first point (delay in samples)" << endl
+    << "  --impulse-responses file  export the impulse responses of the glottal" << endl
+    << "                       and noise sources at all the points (.wav or" << endl
+    << "                       binary 32 bit floats, one channel per point and source)" << endl
+    << "  --field file         compute and export the acoustic field" << endl
+    << "  --vtk file.vtm       export the meshes and modes of the segments and" << endl
+    << "                       the acoustic field (if computed) in VTK files" << endl
+    << "  --tf-stream file     write the transfer functions in a NPY file" << endl
+    << "                       during the frequency sweep" << endl
+    << "  --field-stream file  write the complex acoustic field in a NPY file" << endl
+    << "                       during its computation" << endl
+    << "  --field-spectrum file fmin fmax n  write the complex acoustic field at" << endl
+    << "                       n frequencies from fmin to fmax (Hz) in a NPY file" << endl
+    << "                       of n * ny rows" << endl
+    << "  --field-volume file f nx ny nz xmin xmax ymin ymax zmin zmax  write the" << endl
+    << "                       complex acoustic field at f (Hz) on a grid of" << endl
+    << "                       nx * ny * nz points of the box in a NPY file of" << endl
+    << "                       nz * ny rows" << endl
+    << "  --tf-points file     csv file of the transfer function points" << endl
+    << "  --threads n          number of threads (overrides the parameter file)" << endl
+    << "  --log file           log file (default log.txt)" << endl
+    << "  --cache directory    cache of the modes and junction matrices" << endl
+    << "  --resume             restore the frequencies computed by an interrupted" << endl
+    << "                       sweep from the checkpoint of the cache directory" << endl
+    << "  --distributed dir    distribute the frequency sweep over the processes" << endl
+    << "                       sharing the directory dir and gather the transfer" << endl
+    << "                       functions (dir is the default cache directory)" << endl
+    << "  --worker dir         compute blocks of the frequency sweep distributed" << endl
+    << "                       by the process run with --distributed dir" << endl
+    << "  --shared-cache file  map the cache pack file read-only and shared with" << endl
+    << "                       the other processes, and read the cached modes," << endl
+    << "                       junction matrices and radiation impedances from it" << endl
+    << "  --write-params file  write the parameters used in a file" << endl
+    << "The parameter file \"-\" keeps the default parameters." << endl
+    << "Geometry conversion: Vocal3dCli --convert-geometry geometry.csv geometry.vtg"
+    << endl
+    << "Cache pack: Vocal3dCli --publish-cache cacheDirectory pack.vcp" << endl
+    << "  writes the cached modes, junction matrices and radiation impedances of" << endl
+    << "  the directory in a pack file to be mapped with --shared-cache" << endl
+    << "Batch of transfer functions: Vocal3dCli --batch geometries.txt parameters.txt"
+    << " outputDirectory [options]" << endl
+    << "  geometries.txt lists one geometry file per line, the transfer functions" << endl
+    << "  of each geometry are written in outputDirectory/name.npy and the log of" << endl
+    << "  its simulation in outputDirectory/name.log" << endl
+    << "  --jobs n             number of geometries computed concurrently (default 1)" << endl
+    << "  --threads n          total number of threads (overrides the parameter file)" << endl
+    << "  --log file           log file (default log.txt)" << endl
+    << "  --cache directory    cache shared by the geometries (default outputDirectory)" << endl
+    << "Parameter variants: Vocal3dCli --variants geometry.csv parameters.txt"
+    << " variants.txt outputDirectory [options]" << endl
+    << "  variants.txt lists one parameter file per line, read over parameters.txt," << endl
+    << "  the transfer functions of each variant are written in outputDirectory/name.npy" << endl
+    << "  and the log of its simulation in outputDirectory/name.log" << endl
+    << "  --jobs n             number of variants computed concurrently (default 1)" << endl
+    << "  --threads n          total number of threads (overrides the parameter file)" << endl
+    << "  --log file           log file (default log.txt)" << endl
+    << "  --cache directory    cache of the modes and junction matrices (default outputDirectory)" << endl
+    << "Transfer function library: Vocal3dCli --tf-library speaker.speaker parameters.txt"
+    << " library.tfl [options]" << endl
+    << "  computes the transfer functions of the shapes of the speaker file" << endl
+    << "  --shapes a,b,...     shapes of the library (default all the shapes)" << endl
+    << "  --between a b n      add n shapes interpolated between the shapes a and b" << endl
+    << "  --threads n          number of threads (overrides the parameter file)" << endl
+    << "  --log file           log file (default log.txt)" << endl
+    << "  --cache directory    cache of the modes and junction matrices" << endl
+    << "Simulation server: Vocal3dCli --server address [options]" << endl
+    << "  answers the jobs (synthesize, tf, field, stats, clear, quit, shutdown," << endl
+    << "  see SimulationServer.h) sent line by line on the local socket address," << endl
+    << "  or on the standard input for the address -, the log of each job is" << endl
+    << "  written next to its output file with the extension .log" << endl
+    << "  --cache-size n       number of cached speakers and simulations (default 4)" << endl
+    << "  --log file           log file (default log.txt)" << endl
+    << "Convergence study: Vocal3dCli --convergence geometry.csv parameters.txt [options]" << endl
+    << "  coarsens the solver settings of parameters.txt (the reference) and" << endl
+    << "  recommends the cheapest ones within the tolerance" << endl
+    << "  --probe-band fmax e  band 0 - fmax Hz with the frequency step of" << endl
+    << "                       spectrumLgthExponent e (default 5000 10)" << endl
+    << "  --formants n         number of formants compared (default 4)" << endl
+    << "  --levels n           number of levels of each setting (default 3)" << endl
+    << "  --tolerance f b m    tolerance on the formants (%), the bandwidths (%)" << endl
+    << "                       and the magnitude (dB) (default 1 5 1)" << endl
+    << "  --output file        write the results in a file (default standard output)" << endl
+    << "  --write-params file  write the parameters with the recommended settings" << endl
+    << "  --threads n          number of threads (overrides the parameter file)" << endl
+    << "  --log file           log file (default log.txt)" << endl
+    << "Thread pool shared by all the computations (any mode):" << endl
+    << "  --pool-workers n     number of worker threads (default one per hardware" << endl
+    << "                       thread)" << endl
+    << "  --pin-threads        bind each worker thread to its own core" << endl
+    << "  --sequential-nested  run the loops nested in a parallel loop in sequence" << endl
+    << "                       instead of sharing the idle workers" << endl;
+}
+
+// ****************************************************************************
+// Remove the options of the thread pool from the arguments and apply them
+
+static void applyThreadPoolOptions(int& argc, char* argv[])
+{
+  threadPoolSettings settings(getThreadPoolSettings());
+  int numArgs(1);
+  for (int i(1); i < argc; i++)
+  {
+    string arg(argv[i]);
+    if ((arg == "--pool-workers") && (i + 1 < argc)) { settings.numWorkers = atoi(argv[++i]); }
+    else if (arg == "--pin-threads") { settings.pinWorkers = true; }
+    else if (arg == "--sequential-nested") { settings.nested = NESTED_SEQUENTIAL; }
+    else { argv[numArgs++] = argv[i]; }
+  }
+  argc = numArgs;
+  setThreadPoolSettings(settings);
+}
+
+// ****************************************************************************
+// Read the non empty lines of a file listing one file name per line
+
+static bool readFileList(const string& listFile, vector<string>& files)
+{
+  ifstream list(listFile);
+  if (!list.is_open())
+  {
+    cerr << "Cannot open " << listFile << endl;
+    return false;
+  }
+  string line;
+  while (getline(list, line))
+  {
+    if (!line.empty() && (line.back() == '\r')) { line.pop_back(); }
+    if (line != "") { files.push_back(line); }
+  }
+  return true;
+}
+
+// ****************************************************************************
+// Compute the transfer functions of the geometries listed in a file
+
+static int runBatch(int argc, char* argv[])
+{
+  if (argc < 5) { printUsage(); return 1; }
+
+  string listFile(argv[2]), paramFile(argv[3]), outputDirectory(argv[4]);
+  string logFile("log.txt"), cacheDirectory(outputDirectory);
+  int numThreads(-1), numJobs(1);
+
+  for (int i(5); i < argc; i++)
+  {
+    string arg(argv[i]);
+    if ((arg == "--jobs") && (i + 1 < argc)) { numJobs = max(1, atoi(argv[++i])); }
+    else if ((arg == "--threads") && (i + 1 < argc)) { numThreads = atoi(argv[++i]); }
+    else if ((arg == "--log") && (i + 1 < argc)) { logFile = argv[++i]; }
+    else if ((arg == "--cache") && (i + 1 < argc)) { cacheDirectory = argv[++i]; }
+    else { printUsage(); return 1; }
+  }
+
+  vector<string> geometryFiles;
+  if (!readFileList(listFile, geometryFiles)) { return 1; }
+
+  Logger::getInstance().setFile(logFile);
+  Acoustic3dSimulation simu;
+  struct simulationSetup setup(getSimulationSetup(simu));
+  string error;
+  if ((paramFile != "-") && !readSimulationParametersFile(paramFile, setup, error))
+  {
+    cerr << error << endl;
+    return 1;
+  }
+  if (numThreads > 0) { setup.simuParams.numThreads = numThreads; }
+
+  vector<struct batchResult> results(computeBatchTransferFunctions(geometryFiles,
+    setup, outputDirectory, cacheDirectory, numJobs, [](int done, int total)
+    {
+      cout << done << " / " << total << " geometries computed" << endl;
+      return true;
+    }));
+
+  int status(0);
+  for (auto& res : results)
+  {
+    if (!res.success)
+    {
+      cerr << "Cannot compute the transfer functions of " << res.geometryFile << endl;
+      status = 1;
+    }
+  }
+  Logger::getInstance().flush();
+
+  return status;
+}
+
+// ****************************************************************************
+// Compute the transfer functions of a geometry for the parameter variants 
+// listed in a file, sharing the modes and the junction matrices
+
+static int runVariants(int argc, char* argv[])
+{
+  if (argc < 6) { printUsage(); return 1; }
+
+  string geometryFile(argv[2]), paramFile(argv[3]), listFile(argv[4]), 
+    outputDirectory(argv[5]);
+  string logFile("log.txt"), cacheDirectory(outputDirectory);
+  int numThreads(-1), numJobs(1);
+
+  for (int i(6); i < argc; i++)
+  {
+    string arg(argv[i]);
+    if ((arg == "--jobs") && (i + 1 < argc)) { numJobs = max(1, atoi(argv[++i])); }
+    else if ((arg == "--threads") && (i + 1 < argc)) { numThreads = atoi(argv[++i]); }
+    else if ((arg == "--log") && (i + 1 < argc)) { logFile = argv[++i]; }
+    else if ((arg == "--cache") && (i + 1 < argc)) { cacheDirectory = argv[++i]; }
+    else { printUsage(); return 1; }
+  }
+
+  vector<string> variantFiles;
+  if (!readFileList(listFile, variantFiles)) { return 1; }
+
+  Logger::getInstance().setFile(logFile);
+  Acoustic3dSimulation simu;
+  struct simulationSetup setup(getSimulationSetup(simu));
+  string error;
+  if ((paramFile != "-") && !readSimulationParametersFile(paramFile, setup, error))
+  {
+    cerr << error << endl;
+    return 1;
+  }
+  if (numThreads > 0) { setup.simuParams.numThreads = numThreads; }
+
+  // each variant only gives the parameters which differ from the base setup
+  vector<struct simulationSetup> variants(variantFiles.size(), setup);
+  for (int i(0); i < variantFiles.size(); i++)
+  {
+    if (!readSimulationParametersFile(variantFiles[i], variants[i], error))
+    {
+      cerr << error << endl;
+      return 1;
+    }
+  }
+
+  vector<struct batchResult> results(computeParameterVariantsTransferFunctions(
+    geometryFile, setup, variants, variantFiles, outputDirectory, cacheDirectory,
+    numJobs, [](int done, int total)
+    {
+      cout << done << " / " << total << " variants computed" << endl;
+      return true;
+    }));
+
+  int status(0);
+  for (auto& res : results)
+  {
+    if (!res.success)
+    {
+      cerr << "Cannot compute the transfer functions of " << res.geometryFile << endl;
+      status = 1;
+    }
+  }
+  Logger::getInstance().flush();
+
+  return status;
+}
+
+// ****************************************************************************
+// Compute the transfer functions of vocal tract shapes of a speaker file and
+// write them in a library file
+
+static int runTfLibrary(int argc, char* argv[])
+{
+  if (argc < 5) { printUsage(); return 1; }
+
+  string speakerFile(argv[2]), paramFile(argv[3]), libraryFile(argv[4]);
+  string logFile("log.txt"), cacheDirectory;
+  vector<string> shapeNames;
+  vector<pair<pair<string, string>, int>> betweenShapes;
+  int numThreads(-1);
+
+  for (int i(5); i < argc; i++)
+  {
+    string arg(argv[i]);
+    if ((arg == "--shapes") && (i + 1 < argc))
+    {
+      stringstream names(argv[++i]);
+      string name;
+      while (getline(names, name, ',')) { if (name != "") { shapeNames.push_back(name); } }
+    }
+    else if ((arg == "--between") && (i + 3 < argc))
+    {
+      string a(argv[++i]), b(argv[++i]);
+      betweenShapes.push_back({ {a, b}, max(2, atoi(argv[++i])) });
+    }
+    else if ((arg == "--threads") && (i + 1 < argc)) { numThreads = atoi(argv[++i]); }
+    else if ((arg == "--log") && (i + 1 < argc)) { logFile = argv[++i]; }
+    else if ((arg == "--cache") && (i + 1 < argc)) { cacheDirectory = argv[++i]; }
+    else { printUsage(); return 1; }
+  }
+
+  VocalTract tract;
+  try
+  {
+    tract.readFromXml(speakerFile);
+  }
+  catch (std::string st)
+  {
+    cerr << st << endl;
+    return 1;
+  }
+  tract.calculateAll();
+
+  // the shapes of the library
+  vector<VocalTract::Shape> shapes;
+  if (shapeNames.empty() && betweenShapes.empty()) { shapes = tract.shapes; }
+  for (auto& name : shapeNames)
+  {
+    int idx(tract.getShapeIndex(name));
+    if (idx < 0)
+    {
+      cerr << "Unknown shape " << name << endl;
+      return 1;
+    }
+    shapes.push_back(tract.shapes[idx]);
+  }
+  for (auto& between : betweenShapes)
+  {
+    int idxA(tract.getShapeIndex(between.first.first)),
+      idxB(tract.getShapeIndex(between.first.second));
+    if ((idxA < 0) || (idxB < 0))
+    {
+      cerr << "Unknown shape " << ((idxA < 0) ? between.first.first :
+        between.first.second) << endl;
+      return 1;
+    }
+    vector<VocalTract::Shape> ratios(interpolatedShapes(tract.shapes[idxA],
+      tract.shapes[idxB], between.second));
+    shapes.insert(shapes.end(), ratios.begin(), ratios.end());
+  }
+
+  Logger::getInstance().setFile(logFile);
+  Acoustic3dSimulation simu;
+  struct simulationSetup setup(getSimulationSetup(simu));
+  string error;
+  if ((paramFile != "-") && !readSimulationParametersFile(paramFile, setup, error))
+  {
+    cerr << error << endl;
+    return 1;
+  }
+  if (numThreads > 0) { setup.simuParams.numThreads = numThreads; }
+
+  struct tfLibrary library;
+  bool success(buildTfLibrary(&tract, shapes, setup, cacheDirectory, library,
+    [](int done, int total)
+    {
+      cout << done << " / " << total << " shapes computed" << endl;
+      return true;
+    }));
+
+  int status(0);
+  if (!success)
+  {
+    cerr << "Cannot compute the transfer functions of all the shapes" << endl;
+    status = 1;
+  }
+  else if (!writeTfLibrary(libraryFile, library))
+  {
+    cerr << "Cannot write the library in " << libraryFile << endl;
+    status = 1;
+  }
+  Logger::getInstance().flush();
+
+  return status;
+}
+
+// ****************************************************************************
+// Answer the jobs of the clients of a socket or of the standard input
+
+static int runServer(int argc, char* argv[])
+{
+  string address(argv[2]), logFile("log.txt");
+  int cacheSize(4);
+
+  for (int i(3); i < argc; i++)
+  {
+    string arg(argv[i]);
+    if ((arg == "--cache-size") && (i + 1 < argc)) { cacheSize = max(1, atoi(argv[++i])); }
+    else if ((arg == "--log") && (i + 1 < argc)) { logFile = argv[++i]; }
+    else { printUsage(); return 1; }
+  }
+
+  Logger::getInstance().setFile(logFile);
+  SimulationServer server(cacheSize);
+  string error;
+  bool success(server.run(address, error));
+  Logger::getInstance().flush();
+  if (!success)
+  {
+    cerr << error << endl;
+    return 1;
+  }
+  return 0;
+}
+
+// ****************************************************************************
+// Study the convergence of the solver settings of a geometry
+
+static int runConvergence(int argc, char* argv[])
+{
+  if (argc < 4) { printUsage(); return 1; }
+
+  string geometryFile(argv[2]), paramFile(argv[3]);
+  string logFile("log.txt"), outputFile, writeParamsFile;
+  int numThreads(-1);
+
+  Acoustic3dSimulation simu;
+  struct simulationSetup setup(getSimulationSetup(simu));
+  string error;
+  if ((paramFile != "-") && !readSimulationParametersFile(paramFile, setup, error))
+  {
+    cerr << error << endl;
+    return 1;
+  }
+  struct convergenceStudyParameters params(defaultConvergenceStudyParameters(setup));
+
+  for (int i(4); i < argc; i++)
+  {
+    string arg(argv[i]);
+    if ((arg == "--probe-band") && (i + 2 < argc))
+    {
+      params.maxFreq = atof(argv[++i]);
+      params.spectrumLgthExponent = max(1, min(20, atoi(argv[++i])));
+    }
+    else if ((arg == "--formants") && (i + 1 < argc)) { params.numFormants = max(1, atoi(argv[++i])); }
+    else if ((arg == "--levels") && (i + 1 < argc)) { params.numLevels = max(1, atoi(argv[++i])); }
+    else if ((arg == "--tolerance") && (i + 3 < argc))
+    {
+      params.formantTolerance = atof(argv[++i]);
+      params.bandwidthTolerance = atof(argv[++i]);
+      params.magnitudeTolerance = atof(argv[++i]);
+    }
+    else if ((arg == "--output") && (i + 1 < argc)) { outputFile = argv[++i]; }
+    else if ((arg == "--write-params") && (i + 1 < argc)) { writeParamsFile = argv[++i]; }
+    else if ((arg == "--threads") && (i + 1 < argc)) { numThreads = atoi(argv[++i]); }
+    else if ((arg == "--log") && (i + 1 < argc)) { logFile = argv[++i]; }
+    else { printUsage(); return 1; }
+  }
+  if (params.maxFreq <= 0.) { printUsage(); return 1; }
+  if (numThreads > 0) { setup.simuParams.numThreads = numThreads; }
+
+  Logger::getInstance().setFile(logFile);
+  struct convergenceStudy study;
+  bool success(computeConvergenceStudy(geometryFile, setup, params, study,
+    [](int done, int total)
+    {
+      cout << done << " / " << total << " runs computed" << endl;
+      return true;
+    }));
+  Logger::getInstance().flush();
+  if (!success)
+  {
+    cerr << "Cannot compute the reference transfer function of " << geometryFile << endl;
+    return 1;
+  }
+
+  if (outputFile != "")
+  {
+    ofstream ofs(outputFile);
+    if (!ofs.is_open())
+    {
+      cerr << "Cannot write the results in " << outputFile << endl;
+      return 1;
+    }
+    writeConvergenceStudy(ofs, study, params);
+  }
+  else
+  {
+    writeConvergenceStudy(cout, study, params);
+  }
+
+  if (writeParamsFile != "")
+  {
+    setSolverSettings(setup, study.runs[study.recommended].settings);
+    if (!writeSimulationParametersFile(writeParamsFile, setup))
+    {
+      cerr << "Cannot write the parameters in " << writeParamsFile << endl;
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+// ****************************************************************************
+
+int main(int argc, char* argv[])
+{
+  applyThreadPoolOptions(argc, argv);
+  if (argc < 3) { printUsage(); return 1; }
+
+  // conversion of a csv geometry file into the binary format
+  if (string(argv[1]) == "--convert-geometry")
+  {
+    if (argc != 4) { printUsage(); return 1; }
+    Acoustic3dSimulation simu;
+    bool converted(simu.convertGeometryCsvToBinary(argv[2], argv[3]));
+    Logger::getInstance().flush();
+    if (!converted)
+    {
+      cerr << "Cannot convert " << argv[2] << " into " << argv[3] << endl;
+      return 1;
+    }
+    return 0;
+  }
+
+  // pack of the cache entries shared by the processes
+  if (string(argv[1]) == "--publish-cache")
+  {
+    if (argc != 4) { printUsage(); return 1; }
+    string error;
+    if (!writeCachePack(argv[2], argv[3], error))
+    {
+      cerr << error << endl;
+      return 1;
+    }
+    return 0;
+  }
+
+  if (string(argv[1]) == "--batch") { return runBatch(argc, argv); }
+  if (string(argv[1]) == "--variants") { return runVariants(argc, argv); }
+  if (string(argv[1]) == "--tf-library") { return runTfLibrary(argc, argv); }
+  if (string(argv[1]) == "--server") { return runServer(argc, argv); }
+  if (string(argv[1]) == "--convergence") { return runConvergence(argc, argv); }
+
+  string geometryFile(argv[1]), paramFile(argv[2]);
+  string tfFile, noiseTfFile, noiseSourcesTfFile, inputImpedFile, fieldFile, tfPointsFile;
+  string glottisCondsTfFile;
+  string tfStreamFile, fieldStreamFile, fieldSpectrumFile, tfRationalFile, vtkFile;
+  string impulseResponsesFile;
+  int tfRationalPoles(0), tfRationalDelay(0);
+  vector<double> fieldSpectrumFreqs;
+  string fieldVolumeFile;
+  double fieldVolumeFreq(0.);
+  array<int, 3> fieldVolumeNumPts;
+  double fieldVolumeBox[6];
+  string logFile("log.txt"), cacheDirectory, writeParamFile;
+  int numThreads(-1);
+  bool resume(false);
+  string distributedDirectory, workerDirectory, sharedCacheFile;
+
+  for (int i(3); i < argc; i++)
+  {
+    string arg(argv[i]);
+    if ((arg == "--tf") && (i + 1 < argc)) { tfFile = argv[++i]; }
+    else if ((arg == "--noise-tf") && (i + 1 < argc)) { noiseTfFile = argv[++i]; }
+    else if ((arg == "--noise-sources-tf") && (i + 1 < argc)) { noiseSourcesTfFile = argv[++i]; }
+    else if ((arg == "--glottis-conds-tf") && (i + 1 < argc)) { glottisCondsTfFile = argv[++i]; }
+    else if ((arg == "--input-imped") && (i + 1 < argc)) { inputImpedFile = argv[++i]; }
+    else if ((arg == "--tf-rational") && (i + 3 < argc))
+    {
+      tfRationalFile = argv[++i];
+      tfRationalPoles = atoi(argv[++i]);
+      tfRationalDelay = max(0, atoi(argv[++i]));
+    }
+    else if ((arg == "--impulse-responses") && (i + 1 < argc)) { impulseResponsesFile = argv[++i]; }
+    else if ((arg == "--field") && (i + 1 < argc)) { fieldFile = argv[++i]; }
+    else if ((arg == "--vtk") && (i + 1 < argc)) { vtkFile = argv[++i]; }
+    else if ((arg == "--tf-stream") && (i + 1 < argc)) { tfStreamFile = argv[++i]; }
+    else if ((arg == "--field-stream") && (i + 1 < argc)) { fieldStreamFile = argv[++i]; }
+    else if ((arg == "--field-spectrum") && (i + 4 < argc))
+    {
+      fieldSpectrumFile = argv[++i];
+      double fmin(atof(argv[++i])), fmax(atof(argv[++i]));
+      int numFreqs(max(1, atoi(argv[++i])));
+      for (int f(0); f < numFreqs; f++)
+      {
+        fieldSpectrumFreqs.push_back((numFreqs == 1) ? fmin :
+          fmin + (fmax - fmin) * (double)f / (double)(numFreqs - 1));
+      }
+    }
+    else if ((arg == "--field-volume") && (i + 11 < argc))
+    {
+      fieldVolumeFile = argv[++i];
+      fieldVolumeFreq = atof(argv[++i]);
+      for (int d(0); d < 3; d++) { fieldVolumeNumPts[d] = max(1, atoi(argv[++i])); }
+      for (int d(0); d < 6; d++) { fieldVolumeBox[d] = atof(argv[++i]); }
+    }
+    else if ((arg == "--tf-points") && (i + 1 < argc)) { tfPointsFile = argv[++i]; }
+    else if ((arg == "--threads") && (i + 1 < argc)) { numThreads = atoi(argv[++i]); }
+    else if ((arg == "--log") && (i + 1 < argc)) { logFile = argv[++i]; }
+    else if ((arg == "--cache") && (i + 1 < argc)) { cacheDirectory = argv[++i]; }
+    else if ((arg == "--write-params") && (i + 1 < argc)) { writeParamFile = argv[++i]; }
+    else if (arg == "--resume") { resume = true; }
+    else if ((arg == "--distributed") && (i + 1 < argc)) { distributedDirectory = argv[++i]; }
+    else if ((arg == "--worker") && (i + 1 < argc)) { workerDirectory = argv[++i]; }
+    else if ((arg == "--shared-cache") && (i + 1 < argc)) { sharedCacheFile = argv[++i]; }
+    else { printUsage(); return 1; }
+  }
+
+  bool computeTf((tfFile != "") || (noiseTfFile != "") || (noiseSourcesTfFile != "") ||
+    (glottisCondsTfFile != "") || (inputImpedFile != "") || (tfStreamFile != "") || (tfRationalFile != "") ||
+    (impulseResponsesFile != ""));
+  bool computeField((fieldFile != "") || (fieldStreamFile != ""));
+  if (!computeTf && !computeField && (fieldSpectrumFile == "") && (fieldVolumeFile == "") &&
+    (writeParamFile == "") && (vtkFile == "") && (workerDirectory == ""))
+  {
+    cerr << "Nothing to compute: give at least one output file" << endl;
+    return 1;
+  }
+
+  // the processes of a distributed sweep share the modes, the junction 
+  // matrices and the radiation impedance through the cache
+  if (cacheDirectory == "") 
+  { 
+    cacheDirectory = (workerDirectory != "") ? workerDirectory : distributedDirectory; 
+  }
+
+  // the entries missing in the shared pack are written next to it
+  if ((sharedCacheFile != "") && (cacheDirectory == ""))
+  {
+    size_t pos(sharedCacheFile.find_last_of("/\\"));
+    cacheDirectory = (pos == string::npos) ? "." : sharedCacheFile.substr(0, pos);
+  }
+
+  string error;
+  if ((sharedCacheFile != "") && !mapCachePack(sharedCacheFile, error))
+  {
+    cerr << error << endl;
+    return 1;
+  }
+
+  Logger::getInstance().setFile(logFile);
+  Acoustic3dSimulation simu;
+  if (cacheDirectory != "") { simu.setCacheDirectory(cacheDirectory); }
+  else if (resume)
+  {
+    cerr << "The checkpoint of the sweep is in the cache directory: give --cache" << endl;
+    return 1;
+  }
+  simu.setResumeTransferFunction(resume);
+  simu.setDistributedSweepDirectory(
+    (workerDirectory != "") ? workerDirectory : distributedDirectory);
+  simu.setTfStreamFile(tfStreamFile);
+  simu.setFieldStreamFile(fieldStreamFile);
+
+  //*********************************************************
+  // simulation parameters
+  //*********************************************************
+
+  struct simulationSetup setup(getSimulationSetup(simu));
+  if ((paramFile != "-") && !readSimulationParametersFile(paramFile, setup, error))
+  {
+    cerr << error << endl;
+    return 1;
+  }
+  if (numThreads > 0) { setup.simuParams.numThreads = numThreads; }
+  applySimulationSetup(simu, setup);
+
+  if ((tfPointsFile != "") && !simu.setTFPointsFromCsvFile(tfPointsFile))
+  {
+    cerr << "Cannot read the transfer function points in " << tfPointsFile << endl;
+    return 1;
+  }
+
+  //*********************************************************
+  // import the geometry (the vocal tract is not used for an
+  // imported geometry)
+  //*********************************************************
+
+  simu.requestReloadGeometry();
+  simu.setGeometryImported(true);
+  simu.setContourInterpolationMethod(FROM_FILE);
+  simu.setGeometryFile(geometryFile);
+  if (!simu.importGeometry(NULL) || (simu.numberOfSegments() == 0))
+  {
+    cerr << "Cannot import the geometry " << geometryFile << endl;
+    return 1;
+  }
+
+  // the import sets the bounding box of the field to the one of the geometry
+  if (setup.bboxSpecified)
+  {
+    pair<Point2D, Point2D> bbox(
+      Point2D(setup.simuParams.bbox[0].x(), setup.simuParams.bbox[0].y()),
+      Point2D(setup.simuParams.bbox[1].x(), setup.simuParams.bbox[1].y()));
+    simu.setBoundingBox(bbox);
+  }
+
+  struct simulationSetup usedSetup(getSimulationSetup(simu));
+  usedSetup.bboxSpecified = true;
+  if ((writeParamFile != "") && 
+    !writeSimulationParametersFile(writeParamFile, usedSetup))
+  {
+    cerr << "Cannot write the parameters in " << writeParamFile << endl;
+    return 1;
+  }
+
+  //*********************************************************
+  // transfer functions
+  //*********************************************************
+
+  if (workerDirectory != "")
+  {
+    bool success(simu.computeTransferFunctionBlocks(NULL));
+    Logger::getInstance().flush();
+    if (!success)
+    {
+      cerr << "The distributed sweep of " << workerDirectory
+        << " has another geometry or other parameters" << endl;
+    }
+    return success ? 0 : 1;
+  }
+
+  int status(0);
+
+  if (computeTf)
+  {
+    simu.computeTransferFunction(NULL);
+
+    pair<string, enum tfType> outputs[3] = { {tfFile, GLOTTAL}, 
+      {noiseTfFile, NOISE}, {inputImpedFile, INPUT_IMPED} };
+    for (auto& output : outputs)
+    {
+      if ((output.first != "") && 
+        !simu.exportTransferFucntions(output.first, output.second))
+      {
+        cerr << "Cannot export the transfer function in " << output.first << endl;
+        status = 1;
+      }
+    }
+    if ((noiseSourcesTfFile != "") && 
+      !simu.exportNoiseSourcesTransferFunctions(noiseSourcesTfFile))
+    {
+      cerr << "Cannot export the transfer functions in " << noiseSourcesTfFile << endl;
+      status = 1;
+    }
+    if ((glottisCondsTfFile != "") && 
+      !simu.exportGlottisConditionsTransferFunctions(glottisCondsTfFile))
+    {
+      cerr << "Cannot export the transfer functions in " << glottisCondsTfFile << endl;
+      status = 1;
+    }
+    if ((tfRationalFile != "") && !simu.exportRationalModel(tfRationalFile, GLOTTAL,
+      0, tfRationalPoles, tfRationalDelay))
+    {
+      cerr << "Cannot export the rational model in " << tfRationalFile << endl;
+      status = 1;
+    }
+    if ((impulseResponsesFile != "") && !simu.exportImpulseResponses(impulseResponsesFile))
+    {
+      cerr << "Cannot export the impulse responses in " << impulseResponsesFile << endl;
+      status = 1;
+    }
+  }
+
+  //*********************************************************
+  // acoustic field
+  //*********************************************************
+
+  if (computeField)
+  {
+    simu.computeAcousticField(NULL);
+    if ((fieldFile != "") && !simu.exportAcousticField(fieldFile))
+    {
+      cerr << "Cannot export the acoustic field in " << fieldFile << endl;
+      status = 1;
+    }
+  }
+
+  if ((fieldSpectrumFile != "") && 
+    !simu.computeAcousticFieldSpectrum(NULL, fieldSpectrumFreqs, fieldSpectrumFile))
+  {
+    cerr << "Cannot write the acoustic field spectrum in " << fieldSpectrumFile << endl;
+    status = 1;
+  }
+
+  if ((fieldVolumeFile != "") && 
+    !simu.computeAcousticFieldVolume(NULL, fieldVolumeFreq, 
+      Point_3(fieldVolumeBox[0], fieldVolumeBox[2], fieldVolumeBox[4]),
+      Point_3(fieldVolumeBox[1], fieldVolumeBox[3], fieldVolumeBox[5]),
+      fieldVolumeNumPts, fieldVolumeFile))
+  {
+    cerr << "Cannot write the acoustic field volume in " << fieldVolumeFile << endl;
+    status = 1;
+  }
+
+  //*********************************************************
+  // VTK files of the meshes, modes and field
+  //*********************************************************
+
+  if (vtkFile != "")
+  {
+    // the modes are computed by the transfer functions and the field
+    if (!computeTf && !computeField) { simu.computeMeshAndModes(); }
+    if (!simu.exportVtk(vtkFile))
+    {
+      cerr << "Cannot export the VTK files " << vtkFile << endl;
+      status = 1;
+    }
+  }
+
+  Logger::getInstance().flush();
+
+  return status;
+}
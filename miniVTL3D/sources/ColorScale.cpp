@@ -422,6 +422,69 @@ ColorMap ColorScale::getColorMap() {
 	return &colorMap;
 }
 
+// ****************************************************************************
+/// Converts the width x height values of a field, stored row by row, into
+/// an image colored with the color map. The scale is selected once for the
+/// whole image, so that the conversion is a single pass over the values
+/// followed by a lookup into the static color map. The NaN values (pixels
+/// outside of the field) are drawn in white. The image can be drawn as a 
+/// bitmap or saved in a file.
+// ****************************************************************************
+
+template <typename Normalize>
+static void fieldToRgb(const double* values, int numValues, Normalize normalize,
+  unsigned char* rgb)
+{
+  ColorMap colorMap = ColorScale::getColorMap();
+  int idx;
+
+  for (int i(0); i < numValues; i++, rgb += 3)
+  {
+    if (isnan(values[i]))
+    {
+      rgb[0] = 254;
+      rgb[1] = 254;
+      rgb[2] = 254;
+    }
+    else
+    {
+      // the clamping is done before the cast to handle the infinite values
+      idx = (int)fmin(255., fmax(1., 256. * normalize(values[i]) - 1.));
+      rgb[0] = (unsigned char)(*colorMap)[idx][0];
+      rgb[1] = (unsigned char)(*colorMap)[idx][1];
+      rgb[2] = (unsigned char)(*colorMap)[idx][2];
+    }
+  }
+}
+
+wxImage ColorScale::fieldToImage(const double* values, int width, int height,
+  fieldColorScale scale, double offset, double range)
+{
+  wxImage image(width, height, false);
+  unsigned char* rgb(image.GetData());
+  int numValues(width * height);
+
+  switch (scale)
+  {
+  case LINEAR_COLOR_SCALE:
+    fieldToRgb(values, numValues, [offset, range](double value)
+      { return (value - offset) / range; }, rgb);
+    break;
+
+  case SYMMETRIC_COLOR_SCALE:
+    fieldToRgb(values, numValues, [range](double value)
+      { return (value / range + 1.) / 2.; }, rgb);
+    break;
+
+  case DB_COLOR_SCALE:
+    fieldToRgb(values, numValues, [offset, range](double value)
+      { return (20. * log10(value) - offset) / range; }, rgb);
+    break;
+  }
+
+  return image;
+}
+
 // ****************************************************************************																			   
 /// Unit tests.
 // ****************************************************************************
@@ -41,6 +41,16 @@ public:
   static void getYellowBlueScale(int numColors, wxColor scale[]);
   static ColorMap getColorMap();							
 
+  // scales of the values converted into colors by fieldToImage
+  enum fieldColorScale
+  {
+    LINEAR_COLOR_SCALE,     // (value - offset) / range in [0, 1]
+    SYMMETRIC_COLOR_SCALE,  // value / range in [-1, 1], 0 in the middle
+    DB_COLOR_SCALE          // (20 log10(value) - offset) / range in [0, 1]
+  };
+  static wxImage fieldToImage(const double* values, int width, int height,
+    fieldColorScale scale, double offset, double range);
+
   static void test();
 
   // ****************************************************************
@@ -35,6 +35,8 @@
 #include "Backend/SoundLib.h"
 #include "Backend/Synthesizer.h"
 #include "Backend/Acoustic3dSimulation.h"
+#include "Backend/Profiler.h"
+#include "Backend/ParallelLoop.h"
 
 
 // Define a custom event type to be used for command events.
@@ -47,6 +49,9 @@ const int UPDATE_PICTURES_AND_CONTROLS = 3;
 // Special message from the vocal tract dialog to the event receiver to signal
 // that a vocal tract parameter changed.
 const int UPDATE_VOCAL_TRACT = 4;
+// Exponent of the maximal block length of the FFT convolution of the sources 
+// with the impulse responses of the 3D simulation.
+const int CONVOLUTION_BLOCK_EXPONENT = 10;
 
 // For vowels, the minimum area should always be greater than 0.25 cm^2,
 // because otherwise the glottis model might fail to oscillate.
@@ -92,6 +97,7 @@ Data *Data::getInstance()
 void Data::init(const wxString &arg0)
 {
   std::cout << "[DATA_DEBUG_INIT] Data::init() ENTRY." << std::endl;
+  ScopedTimer initTimer("startup/data init");
   int i;
 
   // ****************************************************************
@@ -109,18 +115,20 @@ void Data::init(const wxString &arg0)
 
   // ****************************************************************
 
-  vocalTract = new VocalTract();
+  {
+    ScopedTimer timer("startup/data init/vocal tract");
+    vocalTract = new VocalTract();
+  }
   std::cout << "[DATA_DEBUG_INIT] Data::init() - new VocalTract() done." << std::endl;
   // vocalTract->calculateAll(); // Intentionally commented out - expect geometry from speaker file or CSV
   std::cout << "[DATA_DEBUG_INIT] Data::init() - First vocalTract->calculateAll() WAS SKIPPED." << std::endl;
 
-  tlModel = new TlModel();
+  // The transmission line model is only needed for the 1D spectra and
+  // syntheses: it is created by getTlModel() when it is first used.
+  tlModel = NULL;
   // poleZeroPlan = new PoleZeroPlan(); // Already commented out or removed in previous steps
   // anatomyParams = new AnatomyParams(); // Removed
 
-  updateTlModelGeometry(vocalTract);
-  std::cout << "[DATA_DEBUG_INIT] Data::init() - updateTlModelGeometry() done." << std::endl;
-
   // Phonetic parameters; The range of all these parameters is
   // between 0 and 1.
 
@@ -134,7 +142,8 @@ void Data::init(const wxString &arg0)
 
   transitionPos = 0.0;    // 0 <= x <= 1
 
-  formantOptimizationDialog = new FormantOptimizationDialog(NULL, vocalTract);
+  // Created by getFormantOptimizationDialog() when it is first used.
+  formantOptimizationDialog = NULL;
 
 
   // ****************************************************************
@@ -199,9 +208,11 @@ void Data::init(const wxString &arg0)
   // Some classes for analysis tasks
   
   f0EstimatorYin = new F0EstimatorYin();
+  formantEstimatorLpc = new FormantEstimatorLpc();
   voiceQualityEstimator = new VoiceQualityEstimator();
 
   f0TimeStep_s = f0EstimatorYin->timeStep_s;
+  formantTimeStep_s = formantEstimatorLpc->timeStep_s;
   voiceQualityTimeStep_s = voiceQualityEstimator->timeStep_s;
 
   // Data for the user spectrum calculation
@@ -210,6 +221,7 @@ void Data::init(const wxString &arg0)
   userSpectrumType = NORMAL_SPECTRUM;
   averageSpectrumTimeStep_ms = 10.0;
   userSpectrum = new ComplexSignal(512);
+  radiatedNoiseSourceValid = false;
 
   // For the spectra calculated from the impulse responses in the time domain.
   tdsSpectrum = new ComplexSignal(512);
@@ -315,11 +327,13 @@ void Data::init(const wxString &arg0)
 
   std::cout << "[DATA_DEBUG_INIT] Data::init() - About to call loadSpeaker()." << std::endl;
   speakerFileName = programPath + "JD2.speaker";
-  loadSpeaker(speakerFileName);
+  {
+    ScopedTimer timer("startup/data init/speaker");
+    loadSpeaker(speakerFileName);
+  }
   std::cout << "[DATA_DEBUG_INIT] Data::init() - loadSpeaker() finished." << std::endl;
 
-  updateTlModelGeometry(vocalTract);
-  std::cout << "[DATA_DEBUG_INIT] Data::init() - updateTlModelGeometry() done." << std::endl;
+  // The geometry of the transmission line model is set when it is created.
 
   // ****************************************************************
   // Call some initialization functions.
@@ -331,13 +345,47 @@ void Data::init(const wxString &arg0)
   // Create the configuration object and read the configuration.
   // ****************************************************************
 
-  config = new wxFileConfig("VocalTractLab", "Birkholz",  
-    programPath + "config.ini", "", wxCONFIG_USE_LOCAL_FILE);
-  readConfig();
+  {
+    ScopedTimer timer("startup/data init/config");
+    config = new wxFileConfig("VocalTractLab", "Birkholz",  
+      programPath + "config.ini", "", wxCONFIG_USE_LOCAL_FILE);
+    readConfig();
+  }
   std::cout << "[DATA_DEBUG_INIT] Data::init() EXIT." << std::endl;
 }
 
 
+// ****************************************************************************
+/// Returns the transmission line model, which is created on the first call
+/// with the tube of the current vocal tract.
+// ****************************************************************************
+
+TlModel *Data::getTlModel()
+{
+  if (tlModel == NULL)
+  {
+    tlModel = new TlModel();
+    updateTlModelGeometry(vocalTract);
+  }
+  return tlModel;
+}
+
+
+// ****************************************************************************
+/// Returns the dialog for the formant optimization, which is created on the
+/// first call.
+// ****************************************************************************
+
+FormantOptimizationDialog *Data::getFormantOptimizationDialog()
+{
+  if (formantOptimizationDialog == NULL)
+  {
+    formantOptimizationDialog = new FormantOptimizationDialog(NULL, vocalTract);
+  }
+  return formantOptimizationDialog;
+}
+
+
 // ****************************************************************************
 /// Reads the data from the program configuration into the variables.
 // ****************************************************************************
@@ -552,7 +600,7 @@ int Data::synthesizeVowelFormantLf(LfPulse &lfPulse, int startPos, bool isLongVo
     poleZeroSpectrum*= hpc;
   }
 
-  tlModel->getSpectrum(TlModel::RADIATION, &radiationSpectrum, IMPULSE_RESPONSE_LENGTH, 0);
+  getTlModel()->getSpectrum(TlModel::RADIATION, &radiationSpectrum, IMPULSE_RESPONSE_LENGTH, 0);
   poleZeroSpectrum*= radiationSpectrum; 
 
   // Apply a low-pass filter at 6 kHz.
@@ -817,19 +865,16 @@ int Data::synthesizeVowelLf(Acoustic3dSimulation *simu3d,
 {
   const int NUM_F0_NODES = 4;
   const int NUM_AMP_NODES = 4;
-  const int BUFFER_LENGTH = 2048;
-  const int BUFFER_MASK = 2047;
 
   TimeFunction ampTimeFunction;
   TimeFunction f0TimeFunction;
   double duration_ms;
   Signal window(simu3d->spectrum.N);
   Signal singlePulse;
-  Signal pulseSignal(BUFFER_LENGTH);
-  Signal velocitySignal(BUFFER_LENGTH);
-  Signal noiseSignal(BUFFER_LENGTH);
-  Signal pressureSignal(BUFFER_LENGTH);
-  Signal noisePressureSignal(BUFFER_LENGTH);
+  Signal pulseSignal;
+  Signal noiseSignal;
+  Signal pressureSignal;
+  Signal noisePressureSignal;
   Signal vocalFoldSignal;
   Signal noiseSourceSignal;
   ComplexSignal transferFunction(simu3d->spectrum.N);
@@ -837,14 +882,12 @@ int Data::synthesizeVowelLf(Acoustic3dSimulation *simu3d,
   int nextPulsePos = 10;   // Get the first pulse shape at sample number 10
   int pulseLength;
   double t_s, t_ms;
-  double sum, sumN; //sumC;
   double filteredValue;
   double areaConst(simu3d->crossSection(0)->area());
   double attenuation(pow(10., -20 / 20));
 
   // Memorize the pulse params to restore them at the end of the function
   LfPulse origLfPulse = lfPulse;
-  double envelop;
 
   // ****************************************************************
   // Init the time functions for F0 and glottal pulse amplitude.
@@ -902,6 +945,10 @@ int Data::synthesizeVowelLf(Acoustic3dSimulation *simu3d,
   int length = (int)((duration_ms / 1000.0) * (double)SAMPLING_RATE);
   vocalFoldSignal.setNewLength(length);
   noiseSourceSignal.setNewLength(length);
+  pulseSignal.setNewLength(length);
+  noiseSignal.setNewLength(length);
+  pressureSignal.setNewLength(length);
+  noisePressureSignal.setNewLength(length);
 
   // Init the low-pass filter
 
@@ -922,7 +969,7 @@ int Data::synthesizeVowelLf(Acoustic3dSimulation *simu3d,
   Signal impulseResponse(IMPULSE_RESPONSE_LENGTH);
   Signal impulseResponseNoise(IMPULSE_RESPONSE_LENGTH);
 
-  tlModel->getImpulseResponseWindow(&window, IMPULSE_RESPONSE_LENGTH);
+  getTlModel()->getImpulseResponseWindow(&window, IMPULSE_RESPONSE_LENGTH);
   
   // impulse response of glottis->outside transfer function
   transferFunction = simu3d->spectrum;
@@ -943,7 +990,8 @@ int Data::synthesizeVowelLf(Acoustic3dSimulation *simu3d,
   }
 
   // ****************************************************************
-  // Calc. the speech signal samples.
+  // Calc. the source signals (glottal flow and noise modulated by the
+  // volume velocity at the constriction).
   // ****************************************************************
 
   // Generate noise source
@@ -951,7 +999,6 @@ int Data::synthesizeVowelLf(Acoustic3dSimulation *simu3d,
   noiseSource.isFirstOrder = false;
   noiseSource.cutoffFreq = 5000.;
   
-  //sig.open("sig.txt");
   for (i = 0; i < length; i++)
   {
     t_s = (double)i / (double)SAMPLING_RATE;
@@ -959,7 +1006,7 @@ int Data::synthesizeVowelLf(Acoustic3dSimulation *simu3d,
 
     noiseSource.targetAmp1kHz = ampTimeFunction.getValue(t_ms);
     tdsModel->calcNoiseSample(&noiseSource, 0.001);
-    noiseSignal.x[i & BUFFER_MASK] = noiseSource.sample;
+    noiseSignal.x[i] = noiseSource.sample;
     tdsModel->incrementPosition();
 
     // **************************************************************
@@ -981,27 +1028,16 @@ int Data::synthesizeVowelLf(Acoustic3dSimulation *simu3d,
 
       pulseLength = (int)((double)SAMPLING_RATE / lfPulse.F0);
       lfPulse.getPulse(singlePulse, pulseLength, false);
-      for (k = 0; k < pulseLength; k++)
+      for (k = 0; (k < pulseLength) && (i + k < length); k++)
       {
-        pulseSignal.x[(i + k) & BUFFER_MASK] = singlePulse.getValue(k);
+        pulseSignal.x[i + k] = singlePulse.getValue(k);
       }
 
       nextPulsePos += pulseLength;
     }
 
-    // **************************************************************
-    // Do the convolution.
-    // **************************************************************
-
-    sum = 0.0; 
-    sumN = 0.0; 
-    for (k = 0; k < IMPULSE_RESPONSE_LENGTH; k++)
-    {
-      sum += impulseResponse.x[k] * pulseSignal.x[(i - k) & BUFFER_MASK];
-    }
-
     // low pass filter the volume velocity at the constriction
-    filteredValue = filterNoiseSrc.getOutputSample(pulseSignal.x[i & BUFFER_MASK]);
+    filteredValue = filterNoiseSrc.getOutputSample(pulseSignal.x[i]);
     // keep only positive values
     if (filteredValue > 0)
     {
@@ -1012,25 +1048,30 @@ int Data::synthesizeVowelLf(Acoustic3dSimulation *simu3d,
     {
         filteredValue = 0.;
     }
-    envelop = filteredValue;
-    velocitySignal.x[i & BUFFER_MASK] = filteredValue;
 
-    // convolute noise signal multiplying by the power of the sound source
+    // the noise signal is multiplied by the power of the sound source 
     // computed from the velocity 
-    for (k = 0; k < IMPULSE_RESPONSE_LENGTH; k++)
-    {
-      sumN += impulseResponseNoise.x[k] * noiseSignal.x[(i - k) & BUFFER_MASK]
-            * velocitySignal.x[(i - k) & BUFFER_MASK];
-    }
+    noiseSignal.x[i] *= filteredValue;
+  }
 
-    pressureSignal.x[i & BUFFER_MASK] = sum;
-    noisePressureSignal.x[i & BUFFER_MASK] = sumN;
+  // ****************************************************************
+  // Convolve the sources with the impulse responses and calc. the 
+  // speech signal samples.
+  // ****************************************************************
 
-    filteredValue = 2000.0 * filter.getOutputSample(pressureSignal.getValue(i));
-    vocalFoldSignal.setValue(i, filteredValue);
+  FftConvolver convolver;
+  int blockLengthExponent = min(IMPULSE_RESPONSE_EXPONENT - 1, CONVOLUTION_BLOCK_EXPONENT);
+  convolver.init(impulseResponse, IMPULSE_RESPONSE_LENGTH, blockLengthExponent);
+  convolver.convolve(pulseSignal.x, pressureSignal.x, length);
+  convolver.init(impulseResponseNoise, IMPULSE_RESPONSE_LENGTH, blockLengthExponent);
+  convolver.convolve(noiseSignal.x, noisePressureSignal.x, length);
 
-    filteredValue = 2000.0 * filterNoise.getOutputSample(noisePressureSignal.getValue(i));
-    noiseSourceSignal.setValue(i, filteredValue);
+  filter.process(pressureSignal.x, pressureSignal.x, length);
+  filterNoise.process(noisePressureSignal.x, noisePressureSignal.x, length);
+  for (i = 0; i < length; i++)
+  {
+    vocalFoldSignal.setValue(i, 2000.0 * pressureSignal.x[i]);
+    noiseSourceSignal.setValue(i, 2000.0 * noisePressureSignal.x[i]);
   }
 
   // normalise the signals 
@@ -1066,18 +1107,17 @@ int Data::synthesizeVowelLf(Acoustic3dSimulation *simu3d,
 int Data::synthesizeNoiseSource(Acoustic3dSimulation* simu3d, int startPos)
 {
   const int NUM_AMP_NODES = 4;
-  const int BUFFER_LENGTH = 2048;
-  const int BUFFER_MASK = 2047;
   TimeFunction ampTimeFunction;
   ComplexSignal transferFunction(simu3d->spectrumNoise.N);
   const int IMPULSE_RESPONSE_EXPONENT = simu3d->oldSpectrumLgthExponent();
   const int IMPULSE_RESPONSE_LENGTH = 1 << (IMPULSE_RESPONSE_EXPONENT - 1);
   Signal impulseResponseNoise(IMPULSE_RESPONSE_LENGTH);
-  Signal noiseSignal(BUFFER_LENGTH);
-  Signal pressureSignal(BUFFER_LENGTH);
+  Signal noiseSignal;
+  Signal pressureSignal;
   Signal window(simu3d->spectrumNoise.N / 2);
   IirFilter filter;
-  double duration_ms = 650.0, t_ms, sum, filteredValue;
+  FftConvolver convolver;
+  double duration_ms = 650.0, t_ms;
 
   ofstream sig;
 
@@ -1101,7 +1141,7 @@ int Data::synthesizeNoiseSource(Acoustic3dSimulation* simu3d, int startPos)
 
   transferFunction = simu3d->spectrumNoise;
   complexIFFT(transferFunction, IMPULSE_RESPONSE_EXPONENT, true);
-  tlModel->getImpulseResponseWindow(&window, IMPULSE_RESPONSE_LENGTH);
+  getTlModel()->getImpulseResponseWindow(&window, IMPULSE_RESPONSE_LENGTH);
   for (int i(0); i < IMPULSE_RESPONSE_LENGTH; i++)
   {
       impulseResponseNoise.x[i] = transferFunction.re[i]*window.x[i];
@@ -1119,6 +1159,8 @@ int Data::synthesizeNoiseSource(Acoustic3dSimulation* simu3d, int startPos)
   filter.createChebyshev(20000. / (double)SAMPLING_RATE, false, (int)NUM_LOWPASS_POLES);
 
   int length = (int)((duration_ms / 1000.0) * (double)SAMPLING_RATE);
+  noiseSignal.setNewLength(length);
+  pressureSignal.setNewLength(length);
 
   for (int i(0); i < length; i++)
   {
@@ -1126,24 +1168,54 @@ int Data::synthesizeNoiseSource(Acoustic3dSimulation* simu3d, int startPos)
 
     noiseSource.targetAmp1kHz = ampTimeFunction.getValue(t_ms) / 2.;
     tdsModel->calcNoiseSample(&noiseSource, 0.001);
-    noiseSignal.x[i & BUFFER_MASK] = noiseSource.sample;
+    noiseSignal.x[i] = noiseSource.sample;
     tdsModel->incrementPosition();
+  }
 
-    sum = 0.0;
-    for (int k(0); k < IMPULSE_RESPONSE_LENGTH; k++)
-    {
-        sum += impulseResponseNoise.x[k] * noiseSignal.x[(i - k) & BUFFER_MASK];
-    }
+  // ****************************************************************
+  // Convolve the noise with the impulse response
+  // ****************************************************************
 
-    pressureSignal.x[i & BUFFER_MASK] = sum * 0.2;
+  convolver.init(impulseResponseNoise, IMPULSE_RESPONSE_LENGTH, 
+    min(IMPULSE_RESPONSE_EXPONENT - 1, CONVOLUTION_BLOCK_EXPONENT));
+  convolver.convolve(noiseSignal.x, pressureSignal.x, length);
 
-    filteredValue = 2000.0 * filter.getOutputSample(pressureSignal.getValue(i));
-    track[MAIN_TRACK]->setValue(startPos + i, filteredValue);
+  pressureSignal *= 0.2;
+  filter.process(pressureSignal.x, pressureSignal.x, length);
+  for (int i(0); i < length; i++)
+  {
+    track[MAIN_TRACK]->setValue(startPos + i, 2000.0 * pressureSignal.x[i]);
   }
 
   return (int)(duration_ms + 50.0);   // 50 ms more
 }
 
+// ****************************************************************************
+/// Sets the transfer functions of the 3D simulation to the ones interpolated
+/// in the library of 3D transfer functions for the current shape of the 
+/// vocal tract, so that the shape can be synthesized with 
+/// synthesizeVowelLf(simu3d, ...) without running the simulation.
+/// Returns false if no library is loaded or if it was computed with another
+/// spectrum length.
+// ****************************************************************************
+
+bool Data::setTransferFunctionsFromLibrary(Acoustic3dSimulation* simu3d, VocalTract* tract)
+{
+  double params[VocalTract::NUM_PARAMS];
+  Eigen::MatrixXcd glottalTF, noiseTF;
+
+  for (int i(0); i < VocalTract::NUM_PARAMS; i++) { params[i] = tract->param[i].x; }
+
+  if (!interpolateTfLibrary(tfLibrary3d, params, VocalTract::NUM_PARAMS, 
+    glottalTF, noiseTF))
+  {
+    return false;
+  }
+
+  return simu3d->setTransferFunctions(tfLibrary3d.freqs, glottalTF, noiseTF,
+    tfLibrary3d.spectrumLgthExponent);
+}
+
 // ****************************************************************************
 /// Calculates the user spectrum that is obtained from the signal in the main
 /// track and displayed in the simple spectrum picture.
@@ -1153,6 +1225,41 @@ void Data::calcUserSpectrum()
 {
   int i;
 
+  // ****************************************************************
+  // The spectrum is only recalculated when the samples it is 
+  // calculated from or the analysis parameters changed.
+  // ****************************************************************
+
+  int firstSample = mark_pt - spectrumWindowLength_pt/2;
+  int lastSample = mark_pt + max(spectrumWindowLength_pt, 512);
+  if (userSpectrumType == AVERAGE_SPECTRUM)
+  {
+    firstSample = selectionMark_pt[0];
+    lastSample = selectionMark_pt[1];
+  }
+  firstSample = max(firstSample, 0);
+  lastSample = min(lastSample, track[MAIN_TRACK]->N - 1);
+
+  CacheKey key;
+  key.add(userSpectrumType);
+  key.add(mark_pt);
+  key.add(spectrumWindowLength_pt);
+  key.add(selectionMark_pt[0]);
+  key.add(selectionMark_pt[1]);
+  key.add(averageSpectrumTimeStep_ms);
+  key.add(firstSample);
+  if (lastSample >= firstSample)
+  {
+    key.add(&track[MAIN_TRACK]->x[firstSample], 
+      (lastSample - firstSample + 1) * sizeof(track[MAIN_TRACK]->x[0]));
+  }
+
+  if (key == userSpectrumKey)
+  {
+    return;
+  }
+  userSpectrumKey = key;
+
   // ****************************************************************
   // An ordinary short-time spectrum
   // ****************************************************************
@@ -1223,6 +1330,7 @@ void Data::calcUserSpectrum()
   {
     if (isValidSelection() == false)
     {
+      userSpectrumKey = CacheKey();
       wxMessageBox("You must select a region of the main signal for the analysis!", 
         "Invalid selection");
       return;
@@ -1231,6 +1339,7 @@ void Data::calcUserSpectrum()
     int regionLength_pt = selectionMark_pt[1] - selectionMark_pt[0] + 1;
     if (spectrumWindowLength_pt > regionLength_pt)
     {
+      userSpectrumKey = CacheKey();
       wxMessageBox("The length of the selected region must be at least the window length!", 
         "Length of selected region to short");
       return;
@@ -1315,8 +1424,51 @@ bool Data::calcRadiatedNoiseSpectrum(double noiseSourcePos_cm, double noiseFilte
   int spectrumLength, ComplexSignal *spectrum)
 {
   int i;
+  TlModel *tlModel = getTlModel();
   Tube *tube = &tlModel->tube;
 
+  // ************************************************************
+  // The spectrum is only recalculated when the tube geometry, the
+  // options of the TL model or the parameters changed.
+  // ************************************************************
+
+  CacheKey key;
+  key.add(noiseSourcePos_cm);
+  key.add(noiseFilterCutoffFreq);
+  key.add(spectrumLength);
+  key.add(tube->teethPosition_cm);
+  key.add(tube->tongueTipSideElevation);
+  for (i = 0; i < Tube::NUM_SECTIONS; i++)
+  {
+    Tube::Section *s = tube->section[i];
+    key.add(s->pos_cm);
+    key.add(s->area_cm2);
+    key.add(s->length_cm);
+    key.add(s->volume_cm3);
+    key.add(s->wallMass_cgs);
+    key.add(s->wallStiffness_cgs);
+    key.add(s->wallResistance_cgs);
+    key.add((int)s->articulator);
+  }
+  const TlModel::Options &options = tlModel->options;
+  key.add((int)options.radiation);
+  key.add(options.boundaryLayer);
+  key.add(options.heatConduction);
+  key.add(options.softWalls);
+  key.add(options.hagenResistance);
+  key.add(options.innerLengthCorrections);
+  key.add(options.lumpedElements);
+  key.add(options.paranasalSinuses);
+  key.add(options.piriformFossa);
+  key.add(options.staticPressureDrops);
+
+  if (key == radiatedNoiseSpectrumKey)
+  {
+    *spectrum = radiatedNoiseSpectrum;
+    return radiatedNoiseSourceValid;
+  }
+  radiatedNoiseSpectrumKey = key;
+
 
   // ************************************************************
   // Find the tube section of the noise source.
@@ -1355,6 +1507,8 @@ bool Data::calcRadiatedNoiseSpectrum(double noiseSourcePos_cm, double noiseFilte
     {
       spectrum->setValue(i, 1.0);
     }
+    radiatedNoiseSpectrum = *spectrum;
+    radiatedNoiseSourceValid = false;
     return false;
   }
 
@@ -1409,6 +1563,8 @@ bool Data::calcRadiatedNoiseSpectrum(double noiseSourcePos_cm, double noiseFilte
   (*spectrum) *= radiationSpectrum;
   (*spectrum) *= 30000.0;           // Arbitrary scaling
 
+  radiatedNoiseSpectrum = *spectrum;
+  radiatedNoiseSourceValid = true;
   return true;
 }
 
@@ -1890,6 +2046,108 @@ void Data::calcTongueRootData()
 }
 
 
+// ****************************************************************************
+/// Makes sure that there is a vocal tract and TL model for each thread that
+/// evaluates trial shapes, and makes them copies of the given vocal tract
+/// and of the options and lung pressure of the TL model (the lung pressure 
+/// changes the small-signal resistances and thereby the formants).
+// ****************************************************************************
+
+void Data::prepareTrialModels(VocalTract *tract)
+{
+  const int MAX_TRIAL_THREADS = 16;
+  int i;
+
+  int numThreads = threadPoolSize();
+  if (numThreads > MAX_TRIAL_THREADS)
+  {
+    numThreads = MAX_TRIAL_THREADS;
+  }
+
+  while ((int)trialTracts.size() < numThreads)
+  {
+    trialTracts.push_back(new VocalTract());
+    trialTlModels.push_back(new TlModel());
+  }
+
+  for (i=0; i < (int)trialTracts.size(); i++)
+  {
+    trialTracts[i]->copyModelFrom(tract);
+    trialTlModels[i]->options = getTlModel()->options;
+    trialTlModels[i]->setLungPressure(getTlModel()->getLungPressure());
+  }
+}
+
+
+// ****************************************************************************
+/// Evaluates the given trial shapes in parallel on the models of 
+/// prepareTrialModels(...), which must be called first. The function 
+/// evaluate(...) is called with the vocal tract of a thread, already set to 
+/// the parameters of the trial, and must only use this vocal tract and the 
+/// TL model of the thread. Shapes that are already in the cache are not 
+/// evaluated again, and the new results are added to the cache.
+// ****************************************************************************
+
+void Data::evaluateShapeTrials(vector<ShapeTrial> &trials, 
+  map<vector<double>, ShapeTrial> &cache,
+  const function<void(VocalTract*, TlModel*, ShapeTrial&)> &evaluate)
+{
+  int i;
+  vector<int> pendingTrials;
+  map<vector<double>, ShapeTrial>::iterator it;
+
+  // ****************************************************************
+  // Take the results of the known shapes from the cache.
+  // ****************************************************************
+
+  for (i=0; i < (int)trials.size(); i++)
+  {
+    it = cache.find(vector<double>(trials[i].param, trials[i].param + VocalTract::NUM_PARAMS));
+    if (it != cache.end())
+    {
+      trials[i] = it->second;
+    }
+    else
+    {
+      pendingTrials.push_back(i);
+    }
+  }
+
+  // ****************************************************************
+  // Evaluate the other shapes. The trials are distributed on the 
+  // threads of the pool, each thread using its own vocal tract and TL 
+  // model.
+  // ****************************************************************
+
+  int numPendingTrials = (int)pendingTrials.size();
+
+  parallelLoopIndexed(numPendingTrials, (int)trialTracts.size(), [&](int n, int t)
+    {
+      VocalTract *vt = trialTracts[t];
+      ShapeTrial &trial = trials[pendingTrials[n]];
+      int k;
+
+      for (k=0; k < VocalTract::NUM_PARAMS; k++)
+      {
+        vt->param[k].x = trial.param[k];
+      }
+
+      trial.F1_Hz = 0.0;
+      trial.F2_Hz = 0.0;
+      trial.F3_Hz = 0.0;
+      trial.minArea_cm2 = 0.0;
+      trial.valid = false;
+      evaluate(vt, trialTlModels[t], trial);
+    });
+
+  for (i=0; i < numPendingTrials; i++)
+  {
+    ShapeTrial &trial = trials[pendingTrials[i]];
+    cache[vector<double>(trial.param, trial.param + VocalTract::NUM_PARAMS)] = trial;
+  }
+}
+
+
 // ****************************************************************************
 /// Optimize the parameters of the given vocal tract so that the formants
 /// match the given formant target values as well as possible.
@@ -1905,16 +2163,22 @@ void Data::optimizeFormantsVowel(wxWindow *updateParent, VocalTract *tract,
   double minArea_cm2;
   double changeStep[VocalTract::NUM_PARAMS];
   int stepsTaken[VocalTract::NUM_PARAMS];   // Cummulated steps gone by a parameter
-  double currParamValue;
   double bestError;
   double currError;
   double newError;
   double bestParamChange;
   int bestParam;
-  int i;
+  int i, k;
   char st[1024];
   wxCommandEvent event(updateRequestEvent);
 
+  // The trial shapes of a run, with the changed parameter and its change.
+  vector<ShapeTrial> trials;
+  vector<int> trialParam;
+  vector<double> trialChange;
+  map<vector<double>, ShapeTrial> trialCache;
+  ShapeTrial trial;
+
   // VocalTractDialog *vocalTractDialog = VocalTractDialog::getInstance(NULL); // Removed
 
 
@@ -2016,6 +2280,8 @@ void Data::optimizeFormantsVowel(wxWindow *updateParent, VocalTract *tract,
   bool doContinue = false;
   int runCounter = 0;
 
+  prepareTrialModels(tract);
+
   do
   {
     paramChanged = false;
@@ -2024,62 +2290,66 @@ void Data::optimizeFormantsVowel(wxWindow *updateParent, VocalTract *tract,
 
     // **************************************************************
     // Find out the improvement of the error when each parameter is 
-    // changed individually by a positive changeStep[i] starting 
-    // from the current configuration.
+    // changed individually by a positive and a negative changeStep[i]
+    // starting from the current configuration. All trial shapes are
+    // evaluated in parallel.
     // **************************************************************
     
-    bestError = currError;
-    bestParam = -1;
-    bestParamChange = 0.0;
+    trials.clear();
+    trialParam.clear();
+    trialChange.clear();
 
-    for (i=0; i < VocalTract::NUM_PARAMS; i++)
+    for (k=0; k < VocalTract::NUM_PARAMS; k++)
     {
-      currParamValue = tract->param[i].x;
+      trial.param[k] = tract->param[k].x;
+    }
 
+    for (i=0; i < VocalTract::NUM_PARAMS; i++)
+    {
       if (changeStep[i] > 0.0)
       {
-        // Apply a POSITIVE change to parameter i.
-        
+        // A POSITIVE change of parameter i.
         if (stepsTaken[i] < maxSteps)
         {
-          tract->param[i].x = currParamValue + changeStep[i];
-          getVowelFormants(tract, F1, F2, F3, minArea_cm2);
-          
-          // Check that the minimum area stays above the threshold.
-          if (minArea_cm2 >= minAdvisedArea_cm2)
-          {
-            newError = getFormantError(F1, F2, F3, targetF1, targetF2, targetF3);
-            if (newError < bestError)
-            {
-              bestError = newError;
-              bestParam = i;
-              bestParamChange = changeStep[i];
-            }
-          }
+          trials.push_back(trial);
+          trials.back().param[i]+= changeStep[i];
+          trialParam.push_back(i);
+          trialChange.push_back(changeStep[i]);
         }
 
-        // Apply a NEGATIVE change to parameter i.
-
+        // A NEGATIVE change of parameter i.
         if (stepsTaken[i] > -maxSteps)
         {
-          tract->param[i].x = currParamValue - changeStep[i];
-          getVowelFormants(tract, F1, F2, F3, minArea_cm2);
-          
-          // Check that the minimum area stays above the threshold.
-          if (minArea_cm2 >= minAdvisedArea_cm2)
-          {
-            newError = getFormantError(F1, F2, F3, targetF1, targetF2, targetF3);
-            if (newError < bestError)
-            {
-              bestError = newError;
-              bestParam = i;
-              bestParamChange = -changeStep[i];
-            }
-          }
+          trials.push_back(trial);
+          trials.back().param[i]-= changeStep[i];
+          trialParam.push_back(i);
+          trialChange.push_back(-changeStep[i]);
         }
+      }
+    }
 
-        // Set the parameter value back to its original value.
-        tract->param[i].x = currParamValue;
+    evaluateShapeTrials(trials, trialCache, [this](VocalTract *vt, TlModel *model, ShapeTrial &t)
+      {
+        t.valid = getVowelFormants(vt, model, t.F1_Hz, t.F2_Hz, t.F3_Hz, t.minArea_cm2);
+      });
+
+    bestError = currError;
+    bestParam = -1;
+    bestParamChange = 0.0;
+
+    for (i=0; i < (int)trials.size(); i++)
+    {
+      // Check that the minimum area stays above the threshold.
+      if (trials[i].minArea_cm2 >= minAdvisedArea_cm2)
+      {
+        newError = getFormantError(trials[i].F1_Hz, trials[i].F2_Hz, trials[i].F3_Hz, 
+          targetF1, targetF2, targetF3);
+        if (newError < bestError)
+        {
+          bestError = newError;
+          bestParam = trialParam[i];
+          bestParamChange = trialChange[i];
+        }
       }
     }
 
@@ -2176,7 +2446,6 @@ void Data::optimizeFormantsConsonant(wxWindow *updateParent, VocalTract *tract,
   double F1, F2, F3;
   double changeStep[VocalTract::NUM_PARAMS];
   int stepsTaken[VocalTract::NUM_PARAMS];   // Cummulated steps gone by a parameter
-  double currParamValue;
   double bestError;
   double currError;
   double newError;
@@ -2186,6 +2455,13 @@ void Data::optimizeFormantsConsonant(wxWindow *updateParent, VocalTract *tract,
   char st[1024];
   wxCommandEvent event(updateRequestEvent);
 
+  // The trial shapes of a run, with the changed parameter and its change.
+  vector<ShapeTrial> trials;
+  vector<int> trialParam;
+  vector<double> trialChange;
+  map<vector<double>, ShapeTrial> trialCache;
+  ShapeTrial trial;
+
   // VocalTractDialog *vocalTractDialog = VocalTractDialog::getInstance(NULL); // Removed
 
 
@@ -2343,6 +2619,8 @@ void Data::optimizeFormantsConsonant(wxWindow *updateParent, VocalTract *tract,
   bool doContinue = false;
   int runCounter = 0;
 
+  prepareTrialModels(tract);
+
   do
   {
     paramChanged = false;
@@ -2351,74 +2629,78 @@ void Data::optimizeFormantsConsonant(wxWindow *updateParent, VocalTract *tract,
 
     // **************************************************************
     // Find out the improvement of the error when each parameter is 
-    // changed individually by a positive changeStep[i] starting 
-    // from the current configuration.
+    // changed individually by a positive and a negative changeStep[i]
+    // starting from the current configuration. All trial shapes are
+    // evaluated in parallel.
     // **************************************************************
     
-    bestError = currError;
-    bestParam = -1;
-    bestParamChange = 0.0;
+    trials.clear();
+    trialParam.clear();
+    trialChange.clear();
 
-    for (i=0; (i < VocalTract::NUM_PARAMS) && (progressDialog.Update(runCounter)); i++)
+    for (k=0; k < VocalTract::NUM_PARAMS; k++)
     {
-      currParamValue = tract->param[i].x;
+      trial.param[k] = tract->param[k].x;
+    }
 
+    for (i=0; i < VocalTract::NUM_PARAMS; i++)
+    {
       if (changeStep[i] > 0.0)
       {
-        // Apply a POSITIVE change to parameter i.
-        
-        if (stepsTaken[i] < maxSteps)
+        // A POSITIVE change of parameter i, but not when the VO 
+        // parameter is changed above the threshold (velum open).
+        if ((stepsTaken[i] < maxSteps) &&
+          ((i != VocalTract::VO) || (trial.param[i] + changeStep[i] <= 0.0)))
         {
-          tract->param[i].x = currParamValue + changeStep[i];
-
-          // Do nothing when the VO parameter is changed above the threshold (velum open).
-          if ((i == VocalTract::VO) && (tract->param[i].x > 0.0))
-          {
-            // do nothing.
-          }
-          else
-          {
-            if ((getMinAreaOutsideConstriction_cm2(tract, constrictionStartPos_cm, constrictionEndPos_cm) >= minArea_cm2) &&
-                (getConsonantFormants(tract, contextVowel, releaseArea_cm2, F1, F2, F3)))
-            {
-              newError = getFormantError(F1, F2, F3, targetF1, targetF2, targetF3);
-              if (newError < bestError)
-              {
-                bestError = newError;
-                bestParam = i;
-                bestParamChange = changeStep[i];
-              }
-            }
-          }
-
+          trials.push_back(trial);
+          trials.back().param[i]+= changeStep[i];
+          trialParam.push_back(i);
+          trialChange.push_back(changeStep[i]);
         }
 
-        // Apply a NEGATIVE change to parameter i.
-
+        // A NEGATIVE change of parameter i.
         if (stepsTaken[i] > -maxSteps)
         {
-          tract->param[i].x = currParamValue - changeStep[i];
-          if ((getMinAreaOutsideConstriction_cm2(tract, constrictionStartPos_cm, constrictionEndPos_cm) >= minArea_cm2) &&
-              (getConsonantFormants(tract, contextVowel, releaseArea_cm2, F1, F2, F3)))
-          {
-            newError = getFormantError(F1, F2, F3, targetF1, targetF2, targetF3);
-            if (newError < bestError)
-            {
-              bestError = newError;
-              bestParam = i;
-              bestParamChange = -changeStep[i];
-            }
-          }
+          trials.push_back(trial);
+          trials.back().param[i]-= changeStep[i];
+          trialParam.push_back(i);
+          trialChange.push_back(-changeStep[i]);
         }
+      }
+    }
+
+    if (progressDialog.Update(runCounter))
+    {
+      evaluateShapeTrials(trials, trialCache, [&](VocalTract *vt, TlModel *model, ShapeTrial &t)
+        {
+          t.valid = 
+            (getMinAreaOutsideConstriction_cm2(vt, constrictionStartPos_cm, constrictionEndPos_cm) >= minArea_cm2) &&
+            (getConsonantFormants(vt, model, contextVowel, releaseArea_cm2, t.F1_Hz, t.F2_Hz, t.F3_Hz));
+        });
+    }
+    else
+    {
+      trials.clear();
+    }
 
-        // Set the parameter value back to its original value.
-        tract->param[i].x = currParamValue;
+    bestError = currError;
+    bestParam = -1;
+    bestParamChange = 0.0;
 
-        // Some progress displaying...
-        wxPrintf(".");
+    for (i=0; i < (int)trials.size(); i++)
+    {
+      if (trials[i].valid)
+      {
+        newError = getFormantError(trials[i].F1_Hz, trials[i].F2_Hz, trials[i].F3_Hz, 
+          targetF1, targetF2, targetF3);
+        if (newError < bestError)
+        {
+          bestError = newError;
+          bestParam = trialParam[i];
+          bestParamChange = trialChange[i];
+        }
       }
     }
-    wxPrintf("\n");   // A line break after all the points.
 
     // **************************************************************
     // Change the parameter with the best error reduction.
@@ -2674,11 +2956,18 @@ void Data::createMinVocalTractArea(wxWindow *updateParent, VocalTract *tract, do
   int bestParam = -1;
   double bestParamChange = 0.0;
   double bestAreaChange = 0.0;
-  double currParamValue = 0.0;
   double currMinArea_cm2 = 0.0;
   double deltaMinArea_cm2 = 0.0;
   char st[1024];
   wxCommandEvent event(updateRequestEvent);
+
+  // The trial shapes of a run, with the changed parameter and its change.
+  vector<ShapeTrial> trials;
+  vector<int> trialParam;
+  vector<double> trialChange;
+  map<vector<double>, ShapeTrial> trialCache;
+  ShapeTrial trial;
+  int k;
   
   // VocalTractDialog *vocalTractDialog = VocalTractDialog::getInstance(NULL); // Removed
 
@@ -2734,6 +3023,8 @@ void Data::createMinVocalTractArea(wxWindow *updateParent, VocalTract *tract, do
   minArea_cm2 = getMinAreaOutsideConstriction_cm2(tract, skipRegionStart_cm, skipRegionEnd_cm);
   //getVowelFormants(tract, F1, F2, F3, minArea_cm2);
 
+  prepareTrialModels(tract);
+
   while ((minArea_cm2 < minAdvisedArea_cm2) && (numRuns < MAX_RUNS) && (doContinue))
   {
     currMinArea_cm2 = minArea_cm2;
@@ -2743,46 +3034,51 @@ void Data::createMinVocalTractArea(wxWindow *updateParent, VocalTract *tract, do
     // of both directions gives the most increae of the minimal area.
     // **************************************************************
 
-    bestParam = -1;
-    bestParamChange = 0.0;
-    bestAreaChange = 0.0;
+    trials.clear();
+    trialParam.clear();
+    trialChange.clear();
 
-    for (i=0; i < VocalTract::NUM_PARAMS; i++)
+    for (k=0; k < VocalTract::NUM_PARAMS; k++)
     {
-      currParamValue = tract->param[i].x;
+      trial.param[k] = tract->param[k].x;
+    }
 
+    for (i=0; i < VocalTract::NUM_PARAMS; i++)
+    {
       if (changeStep[i] > 0.0)
       {
-        // Apply a POSITIVE change to parameter i.
-        
-        tract->param[i].x = currParamValue + changeStep[i];
-//        getVowelFormants(tract, F1, F2, F3, minArea_cm2);
-        minArea_cm2 = getMinAreaOutsideConstriction_cm2(tract, skipRegionStart_cm, skipRegionEnd_cm);
-        deltaMinArea_cm2 = minArea_cm2 - currMinArea_cm2;
-
-        if (deltaMinArea_cm2 > bestAreaChange)
-        {
-          bestParam = i;
-          bestParamChange = changeStep[i];
-          bestAreaChange = deltaMinArea_cm2;
-        }
+        // A POSITIVE change of parameter i.
+        trials.push_back(trial);
+        trials.back().param[i]+= changeStep[i];
+        trialParam.push_back(i);
+        trialChange.push_back(changeStep[i]);
+
+        // A NEGATIVE change of parameter i.
+        trials.push_back(trial);
+        trials.back().param[i]-= changeStep[i];
+        trialParam.push_back(i);
+        trialChange.push_back(-changeStep[i]);
+      }
+    }
 
-        // Apply a NEGATIVE change to parameter i.
-        
-        tract->param[i].x = currParamValue - changeStep[i];
-//        getVowelFormants(tract, F1, F2, F3, minArea_cm2);
-        minArea_cm2 = getMinAreaOutsideConstriction_cm2(tract, skipRegionStart_cm, skipRegionEnd_cm);
-        deltaMinArea_cm2 = minArea_cm2 - currMinArea_cm2;
+    evaluateShapeTrials(trials, trialCache, [&](VocalTract *vt, TlModel *, ShapeTrial &t)
+      {
+        t.minArea_cm2 = getMinAreaOutsideConstriction_cm2(vt, skipRegionStart_cm, skipRegionEnd_cm);
+      });
 
-        if (deltaMinArea_cm2 > bestAreaChange)
-        {
-          bestParam = i;
-          bestParamChange = -changeStep[i];
-          bestAreaChange = deltaMinArea_cm2;
-        }
+    bestParam = -1;
+    bestParamChange = 0.0;
+    bestAreaChange = 0.0;
 
-        // Set the parameter value back to its original value.
-        tract->param[i].x = currParamValue;
+    for (i=0; i < (int)trials.size(); i++)
+    {
+      deltaMinArea_cm2 = trials[i].minArea_cm2 - currMinArea_cm2;
+
+      if (deltaMinArea_cm2 > bestAreaChange)
+      {
+        bestParam = trialParam[i];
+        bestParamChange = trialChange[i];
+        bestAreaChange = deltaMinArea_cm2;
       }
     }
 
@@ -2900,6 +3196,18 @@ double Data::getFormantError(double currentF1, double currentF2,
 // ****************************************************************************
 
 bool Data::getVowelFormants(VocalTract *tract, double &F1_Hz, double &F2_Hz, double &F3_Hz, double &minArea_cm2)
+{
+  return getVowelFormants(tract, getTlModel(), F1_Hz, F2_Hz, F3_Hz, minArea_cm2);
+}
+
+
+// ****************************************************************************
+/// Same as getVowelFormants(...) above, but with the given TL model instead
+/// of the TL model of the program.
+// ****************************************************************************
+
+bool Data::getVowelFormants(VocalTract *tract, TlModel *model, double &F1_Hz, double &F2_Hz, 
+  double &F3_Hz, double &minArea_cm2)
 {
   const int MAX_FORMANTS = 3;
   double formantFreq[MAX_FORMANTS];
@@ -2926,7 +3234,8 @@ bool Data::getVowelFormants(VocalTract *tract, double &F1_Hz, double &F2_Hz, dou
   tract->calculateAll();
 
   // Set the latest vocal tract geometry for the transmission line model.   
-  updateTlModelGeometry(tract);
+  tract->getTube(&model->tube);
+  model->tube.setGlottisArea(0.0);
 
   // Find the minimum cross-sectional area.
   minArea_cm2 = 10000.0;    // = extremely high
@@ -2939,7 +3248,7 @@ bool Data::getVowelFormants(VocalTract *tract, double &F1_Hz, double &F2_Hz, dou
   }
 
   // Get the formant data.
-  tlModel->getFormants(formantFreq, formantBw, numFormants, MAX_FORMANTS, frictionNoise, isClosure, isNasal);
+  model->getFormantsFast(formantFreq, formantBw, numFormants, MAX_FORMANTS, frictionNoise, isClosure, isNasal);
   if (numFormants < MAX_FORMANTS)
   {
     return false;
@@ -2961,6 +3270,18 @@ bool Data::getVowelFormants(VocalTract *tract, double &F1_Hz, double &F2_Hz, dou
 
 bool Data::getConsonantFormants(VocalTract *tract, const wxString &contextVowel, 
   double releaseArea_cm2,  double &F1_Hz, double &F2_Hz, double &F3_Hz)
+{
+  return getConsonantFormants(tract, getTlModel(), contextVowel, releaseArea_cm2, F1_Hz, F2_Hz, F3_Hz);
+}
+
+
+// ****************************************************************************
+/// Same as getConsonantFormants(...) above, but with the given TL model 
+/// instead of the TL model of the program.
+// ****************************************************************************
+
+bool Data::getConsonantFormants(VocalTract *tract, TlModel *model, const wxString &contextVowel, 
+  double releaseArea_cm2, double &F1_Hz, double &F2_Hz, double &F3_Hz)
 {
   int i;
   double consonantParams[VocalTract::NUM_PARAMS];
@@ -3040,10 +3361,11 @@ bool Data::getConsonantFormants(VocalTract *tract, const wxString &contextVowel,
   tract->calculateAll();
 
   // Set the latest vocal tract geometry for the transmission line model.   
-  updateTlModelGeometry(tract);
+  tract->getTube(&model->tube);
+  model->tube.setGlottisArea(0.0);
 
   // Get the formant data.
-  tlModel->getFormants(formantFreq, formantBw, numFormants, MAX_FORMANTS, frictionNoise, isClosure, isNasal);
+  model->getFormantsFast(formantFreq, formantBw, numFormants, MAX_FORMANTS, frictionNoise, isClosure, isNasal);
 
   // Set back the original parameters in the vocal tract model.
 
@@ -3242,8 +3564,9 @@ void Data::selectGlottis(int index)
 
 void Data::updateTlModelGeometry(VocalTract *tract)
 {
-  tract->getTube(&tlModel->tube);
-  tlModel->tube.setGlottisArea(0.0);
+  TlModel *model = getTlModel();
+  tract->getTube(&model->tube);
+  model->tube.setGlottisArea(0.0);
 }
 
 
@@ -3646,17 +3969,15 @@ bool Data::loadSpeaker(const wxString &fileName)
     wxPrintf("Warning: No glottis model data found in the speaker file %s!\n", fileName.c_str());
   }
 
-  // Free the memory of the XML tree !
-  delete rootNode;
-
   // ****************************************************************
-  // Load the vocal tract anatomy and vocal tract shapes.
+  // Load the vocal tract anatomy and vocal tract shapes from the 
+  // same XML tree.
   // ****************************************************************
 
   try
   {
     std::cout << "[DATA_DEBUG_LOADSPEAKER] About to call vocalTract->readFromXml()." << std::endl;
-    vocalTract->readFromXml(fileName.ToStdString()); // Reads anatomy and shapes
+    vocalTract->readFromXml(rootNode, fileName.ToStdString()); // Reads anatomy and shapes
     std::cout << "[DATA_DEBUG_LOADSPEAKER] vocalTract->readFromXml() done." << std::endl;
     // vocalTract->calculateAll(); // Intentionally commented out - CSV pathway is prioritized
     std::cout << "[DATA_DEBUG_LOADSPEAKER] vocalTract->calculateAll() (based on speaker file) WAS SKIPPED to prioritize CSV." << std::endl;
@@ -3666,6 +3987,10 @@ bool Data::loadSpeaker(const wxString &fileName)
     wxMessageBox(wxString(st), 
       wxString("Error reading the anatomy data from ") + fileName + wxString("."));
   }
+
+  // Free the memory of the XML tree !
+  delete rootNode;
+
   std::cout << "[DATA_DEBUG_LOADSPEAKER] Data::loadSpeaker() EXIT." << std::endl;
   return true;
 }
@@ -3818,6 +4143,103 @@ void Data::estimateF0(wxWindow *parent, int trackIndex)
 }
 
 
+// ****************************************************************************
+/// Performs the estimation of the formant tracks.
+// ****************************************************************************
+
+void Data::estimateFormants(wxWindow *parent, int trackIndex)
+{
+  // ****************************************************************
+  // If no proper track index is given, let the user select for which 
+  // track to estimate the formants.
+  // ****************************************************************
+
+  if ((trackIndex < 0) || (trackIndex >= NUM_TRACKS))
+  {
+    trackIndex = selectTrack(parent, wxString("For which track do you want to estimate the formants?"));
+    if (trackIndex == -1)
+    {
+      return;
+    }
+  }
+
+  // ****************************************************************
+  // Determine the "region of interest", where the signal is != 0.
+  // ****************************************************************
+
+  int N = track[trackIndex]->N;
+  int firstRoiSample = 0;
+  int lastRoiSample = N-1;
+  int numRoiSamples = 0;
+
+  while ((firstRoiSample < N) && (track[trackIndex]->x[firstRoiSample] == 0))
+  {
+    firstRoiSample++;
+  }
+
+  while ((lastRoiSample >= firstRoiSample) && (track[trackIndex]->x[lastRoiSample] == 0))
+  {
+    lastRoiSample--;
+  }
+
+  // Is the whole signal zero ?
+  if (firstRoiSample >= lastRoiSample)
+  {
+    wxPrintf("Signal is all zero -> no need for formant estimation.\n");
+    return;
+  }
+
+  numRoiSamples = lastRoiSample - firstRoiSample;
+
+  wxPrintf("Formant estimation started...\n");
+  wxPrintf("The region of interest is %2.3f to %2.3f s.\n",
+    (double)firstRoiSample / (double)SAMPLING_RATE, 
+    (double)(firstRoiSample + numRoiSamples) / (double)SAMPLING_RATE);
+
+  // ****************************************************************
+  // Do the estimation with a progress dialog.
+  // ****************************************************************
+
+  // Do the pre-processing for the formant estimation.
+  
+  formantEstimatorLpc->init(track[trackIndex], firstRoiSample, numRoiSamples);
+  int numChunkSamples = SAMPLING_RATE / 2;
+
+  // Show the progress dialog
+
+  wxGenericProgressDialog dialog("Please wait", "Please wait for the formant estimation to finish.",
+    numRoiSamples/numChunkSamples, parent, 
+    wxPD_CAN_ABORT | wxPD_APP_MODAL | wxPD_ELAPSED_TIME | wxPD_AUTO_HIDE);
+  
+  // Process chunks of numChunkSamples samples.
+  
+  bool finished = false;
+  bool cont = true;
+  int chunkCounter = 1;
+
+  do
+  {
+    finished = formantEstimatorLpc->processChunk(numChunkSamples);
+    cont = dialog.Update(chunkCounter);
+    chunkCounter++;
+  } while ((finished == false) && (cont));
+
+  // Do the dynamic programming and get the vectors of formant estimates.
+
+  if (finished)
+  {
+    formantEstimatorLpc->finish(formantSignal[trackIndex]);
+    // Take over the time step of the formant signals.
+    formantTimeStep_s = formantEstimatorLpc->timeStep_s;
+    wxPrintf("Formant estimation finished.\n");
+  }
+  else
+  {
+    wxPrintf("Formant estimation aborted.\n");
+  }
+}
+
+
 // ****************************************************************************
 /// Performs the voice quality estimation.
 // ****************************************************************************
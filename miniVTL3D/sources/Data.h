@@ -24,6 +24,9 @@
 
 #include <wx/wx.h>
 #include <string>
+#include <vector>
+#include <map>
+#include <functional>
 #include <wx/fileconf.h>
 #include <wx/tokenzr.h>
 
@@ -42,6 +45,7 @@
 #include "Backend/TriangularGlottis.h"
 
 #include "Backend/F0EstimatorYin.h"
+#include "Backend/FormantEstimatorLpc.h"
 #include "Backend/VoiceQualityEstimator.h"
 
 #include "Backend/TubeSequence.h"
@@ -51,6 +55,8 @@
 // #include "Backend/SegmentSequence.h" // Removed
 // #include "Backend/AnatomyParams.h" // Removed
 #include "Backend/Acoustic3dSimulation.h"
+#include "Backend/TfLibrary.h"
+#include "Backend/ModesCache.h"
 
 #include "Graph.h"
 #include "ColorScale.h"
@@ -189,7 +195,7 @@ public:
   // ****************************************************************
 
   VocalTract *vocalTract;
-  TlModel *tlModel;
+  TlModel *tlModel;     ///< Created on first use: use getTlModel()
   PoleZeroPlan *poleZeroPlan;
   // AnatomyParams *anatomyParams; // Removed
 
@@ -211,6 +217,7 @@ public:
   double phoneticParamValue[NUM_PHONETIC_PARAMS];
   static const wxString phoneticParamName[NUM_PHONETIC_PARAMS];
 
+  ///< Created on first use: use getFormantOptimizationDialog()
   FormantOptimizationDialog *formantOptimizationDialog;
 
   // ****************************************************************
@@ -220,6 +227,10 @@ public:
   LfPulse lfPulse;
   bool showPulseDerivative;
 
+  // library of 3D transfer functions interpolated for the current vocal
+  // tract shape (empty if no library is loaded)
+  struct tfLibrary tfLibrary3d;
+
   TdsModel *tdsModel;
 
   SynthesisType synthesisType;
@@ -299,6 +310,7 @@ public:
   // Analysis objects.
 
   F0EstimatorYin *f0EstimatorYin;
+  FormantEstimatorLpc *formantEstimatorLpc;
   VoiceQualityEstimator *voiceQualityEstimator;
 
   // Samples for the F0 track.
@@ -306,6 +318,11 @@ public:
   double f0TimeStep_s;
   vector<double> f0Signal[NUM_TRACKS];
 
+  // Samples for the tracks of F1, F2, F3 (0 where no formants were found).
+
+  double formantTimeStep_s;
+  vector<double> formantSignal[NUM_TRACKS][FormantEstimatorLpc::NUM_FORMANTS];
+
   // Samples for the voice quality track
 
   double voiceQualityTimeStep_s;
@@ -319,6 +336,13 @@ public:
   ComplexSignal *userSpectrum;
   ComplexSignal *tdsSpectrum;
 
+  // Keys of the inputs of the last calculated user spectrum and radiated
+  // noise spectrum: the spectra are only recalculated when they change
+  CacheKey userSpectrumKey;
+  CacheKey radiatedNoiseSpectrumKey;
+  ComplexSignal radiatedNoiseSpectrum;
+  bool radiatedNoiseSourceValid;
+
   // ****************************************************************
   // Spectrogram variables
   // ****************************************************************
@@ -364,6 +388,8 @@ public:
 public:
   static Data *getInstance();
   void init(const wxString &arg0);
+  TlModel *getTlModel();
+  FormantOptimizationDialog *getFormantOptimizationDialog();
   void readConfig();
   void writeConfig();
 
@@ -373,6 +399,7 @@ public:
   int synthesizeVowelLf(TlModel *tlModel, LfPulse &lfPulse, int startPos, bool isLongVowel);
   int synthesizeVowelLf(Acoustic3dSimulation* simu3d, LfPulse& lfPulse, int startPos, bool isLongVowel);
   int synthesizeNoiseSource(Acoustic3dSimulation* simu3d, int startPos);
+  bool setTransferFunctionsFromLibrary(Acoustic3dSimulation* simu3d, VocalTract* tract);
 
   void calcUserSpectrum();
   bool calcRadiatedNoiseSpectrum(double noiseSourcePos_cm, double noiseFilterCutoffFreq,
@@ -384,6 +411,22 @@ public:
   bool exportCrossSectionsFromScore(const wxString& folderName);
   void calcTongueRootData();
   
+  /// A trial shape of the optimizations and the result of its evaluation.
+  struct ShapeTrial
+  {
+    double param[VocalTract::NUM_PARAMS];
+    double F1_Hz;
+    double F2_Hz;
+    double F3_Hz;
+    double minArea_cm2;
+    bool valid;
+  };
+
+  void prepareTrialModels(VocalTract *tract);
+  void evaluateShapeTrials(std::vector<ShapeTrial> &trials, 
+    std::map<std::vector<double>, ShapeTrial> &cache,
+    const std::function<void(VocalTract*, TlModel*, ShapeTrial&)> &evaluate);
+
   void optimizeFormantsVowel(wxWindow *updateParent, VocalTract *tract, 
     double targetF1, double targetF2, double targetF3, 
     double maxParamChange_cm, double minAdvisedArea_cm2, bool paramFixed[]);
@@ -400,8 +443,12 @@ public:
   double getFormantError(double currentF1, double currentF2, double currentF3, 
     double targetF1, double targetF2, double targetF3);
   bool getVowelFormants(VocalTract *tract, double &F1_Hz, double &F2_Hz, double &F3_Hz, double &minArea_cm2);
+  bool getVowelFormants(VocalTract *tract, TlModel *model, double &F1_Hz, double &F2_Hz, 
+    double &F3_Hz, double &minArea_cm2);
   bool getConsonantFormants(VocalTract *tract, const wxString &contextVowel, double releaseArea_cm2,
 	  double &F1_Hz, double &F2_Hz, double &F3_Hz);
+  bool getConsonantFormants(VocalTract *tract, TlModel *model, const wxString &contextVowel, 
+    double releaseArea_cm2, double &F1_Hz, double &F2_Hz, double &F3_Hz);
   double getMinArea_cm2(VocalTract *tract, double startPos_cm, double endPos_cm);
   double getMinAreaOutsideConstriction_cm2(VocalTract *tract, double constrictionStartPos_cm, double constrictionEndPos_cm);
 
@@ -421,6 +468,7 @@ public:
   bool saveSpeaker(const wxString &fileName);
 
   void estimateF0(wxWindow *parent, int trackIndex = -1);
+  void estimateFormants(wxWindow *parent, int trackIndex = -1);
   void estimateVoiceQuality(wxWindow *parent, int trackIndex = -1);
 
   void calcTriangularGlottisF0Params();
@@ -435,6 +483,11 @@ private:
   /// getSelectedGlottis(...)
   int selectedGlottis;
 
+  /// Vocal tract and TL models of the threads that evaluate the trial
+  /// shapes of the optimizations (see evaluateShapeTrials(...)).
+  std::vector<VocalTract*> trialTracts;
+  std::vector<TlModel*> trialTlModels;
+
   // **************************************************************************
   // Private functions.
   // **************************************************************************
@@ -88,7 +88,7 @@ FdsOptionsDialog::FdsOptionsDialog(wxWindow *parent) :
   // Init the variables first.
   // ****************************************************************
 
-  model = Data::getInstance()->tlModel;
+  model = Data::getInstance()->getTlModel();
 
   // ****************************************************************
   // Init and update the widgets.
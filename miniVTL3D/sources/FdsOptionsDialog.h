@@ -40,6 +40,8 @@ class FdsOptionsDialog : public wxDialog
 
 public:
   static FdsOptionsDialog *getInstance();
+  // True when the dialog was already created (by getInstance()).
+  static bool hasInstance() { return instance != NULL; }
 
   // **************************************************************************
   // Private data.
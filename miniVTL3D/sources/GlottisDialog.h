@@ -42,6 +42,8 @@ class GlottisDialog : public wxDialog
 
 public:
   static GlottisDialog *getInstance();
+  // True when the dialog was already created (by getInstance()).
+  static bool hasInstance() { return instance != NULL; }
   void updateWidgets();
 
   // **************************************************************************
@@ -21,6 +21,7 @@
 
 #include "Graph.h"
 #include <cmath>
+#include <algorithm>
 
 const double Graph::EPSILON = 0.000001;
 
@@ -1087,3 +1088,179 @@ void Graph::getZoomFactors(LinearDomain *domain, double& positiveZoomFactor, dou
 }
 
 // ****************************************************************************
+/// Constructor.
+// ****************************************************************************
+
+DecimatedCurve::DecimatedCurve()
+{
+  isValid = false;
+}
+
+// ****************************************************************************
+/// Paints the curve of the given samples, and builds its polyline first if
+/// the samples or the scales of the graph are not the ones of the cached 
+/// polyline. With logInterpolation, the samples are interpolated linearly 
+/// on a log scale.
+// ****************************************************************************
+
+void DecimatedCurve::paint(wxDC &dc, Graph &graph, const std::vector<double> &values,
+  double x0, double dx, bool logInterpolation)
+{
+  int graphX, graphY, graphW, graphH;
+  graph.getDimensions(graphX, graphY, graphW, graphH);
+
+  CacheKey newKey;
+  if (!values.empty())
+  {
+    newKey.add(values.data(), values.size() * sizeof(double));
+  }
+  newKey.add((int)values.size());
+  newKey.add(x0);
+  newKey.add(dx);
+  newKey.add(logInterpolation);
+  newKey.add(graphX);
+  newKey.add(graphY);
+  newKey.add(graphW);
+  newKey.add(graphH);
+  newKey.add(graph.abscissa.reference);
+  newKey.add(graph.abscissa.negativeLimit);
+  newKey.add(graph.abscissa.positiveLimit);
+  newKey.add(graph.isLinearOrdinate);
+  newKey.add(graph.linearOrdinate.reference);
+  newKey.add(graph.linearOrdinate.negativeLimit);
+  newKey.add(graph.linearOrdinate.positiveLimit);
+  newKey.add(graph.logOrdinate.reference);
+  newKey.add(graph.logOrdinate.lowerLevel);
+  newKey.add(graph.logOrdinate.upperLevel);
+
+  if ((!isValid) || (newKey != key))
+  {
+    build(graph, values, x0, dx, logInterpolation);
+    key = newKey;
+    isValid = true;
+  }
+
+  for (auto &stroke : strokes)
+  {
+    if (stroke.size() > 1)
+    {
+      dc.DrawLines((int)stroke.size(), &stroke[0]);
+    }
+  }
+}
+
+// ****************************************************************************
+/// Builds the polyline with one or two points per pixel column.
+// ****************************************************************************
+
+void DecimatedCurve::build(Graph &graph, const std::vector<double> &values,
+  double x0, double dx, bool logInterpolation)
+{
+  int i, k;
+  int graphX, graphY, graphW, graphH;
+  int numValues = (int)values.size();
+  std::vector<wxPoint> stroke;
+
+  graph.getDimensions(graphX, graphY, graphW, graphH);
+  strokes.clear();
+  if ((numValues < 2) || (dx <= 0.0))
+  {
+    return;
+  }
+
+  // Value interpolated at the abscissa x, false outside of the samples.
+  auto interpolate = [&](double x, double &value)
+  {
+    double pos = (x - x0) / dx;
+    int k0 = (int)floor(pos);
+    if ((k0 < 0) || (k0 + 1 >= numValues) || 
+      (std::isnan(values[k0])) || (std::isnan(values[k0 + 1])))
+    {
+      return false;
+    }
+    double ratio = pos - (double)k0;
+    if ((logInterpolation) && (values[k0] > 0.0) && (values[k0 + 1] > 0.0))
+    {
+      double d0 = log10(values[k0]);
+      double d1 = log10(values[k0 + 1]);
+      value = pow(10.0, d0 + (d1 - d0)*ratio);
+    }
+    else
+    {
+      value = values[k0] + (values[k0 + 1] - values[k0])*ratio;
+    }
+    return true;
+  };
+
+  auto getYPos = [&](double value)
+  {
+    int y = graph.getYPos(value);
+    if (y < graphY) { y = graphY; }
+    if (y >= graphY + graphH) { y = graphY + graphH - 1; }
+    return y;
+  };
+
+  auto endStroke = [&]()
+  {
+    if (stroke.size() > 1)
+    {
+      strokes.push_back(stroke);
+    }
+    stroke.clear();
+  };
+
+  double xLeft = graph.getAbsXValue(graphX);
+  for (i = 0; i < graphW; i++)
+  {
+    double xRight = graph.getAbsXValue(graphX + i + 1);
+    double value;
+
+    if (!interpolate(xLeft, value))
+    {
+      endStroke();
+      xLeft = xRight;
+      continue;
+    }
+
+    // Samples in the column [xLeft, xRight[
+    int kFirst = std::max(0, (int)ceil((xLeft - x0) / dx));
+    int kLast = std::min(numValues - 1, (int)ceil((xRight - x0) / dx) - 1);
+
+    if (kLast > kFirst)
+    {
+      double minValue = value;
+      double maxValue = value;
+      for (k = kFirst; k <= kLast; k++)
+      {
+        if (!std::isnan(values[k]))
+        {
+          minValue = std::min(minValue, values[k]);
+          maxValue = std::max(maxValue, values[k]);
+        }
+      }
+
+      // Start with the extremum closest to the previous point.
+      int yTop = getYPos(maxValue);
+      int yBottom = getYPos(minValue);
+      if ((!stroke.empty()) && 
+        (abs(stroke.back().y - yTop) > abs(stroke.back().y - yBottom)))
+      {
+        std::swap(yTop, yBottom);
+      }
+      stroke.push_back(wxPoint(graphX + i, yTop));
+      if (yBottom != yTop)
+      {
+        stroke.push_back(wxPoint(graphX + i, yBottom));
+      }
+    }
+    else
+    {
+      stroke.push_back(wxPoint(graphX + i, getYPos(value)));
+    }
+
+    xLeft = xRight;
+  }
+  endStroke();
+}
+
+// ****************************************************************************
@@ -23,6 +23,8 @@
 #define __GRAPH_H__
 
 #include <wx/wx.h>
+#include <vector>
+#include "Backend/ModesCache.h"
 
 // ****************************************************************************
 // Internally, all numerical values for the quantities are in CGS units!
@@ -208,4 +210,30 @@ private:
   void getZoomFactors(LinearDomain *domain, double& positiveZoomFactor, double& negativeZoomFactor);
 };
 
+// ****************************************************************************
+/// Polyline of a curve sampled at the abscissa values x0 + k*dx, decimated to
+/// the pixel columns of a graph: a column which contains several samples is 
+/// drawn from their minimum to their maximum (so that narrow peaks remain 
+/// visible), and the samples are interpolated for the other columns. The
+/// polyline is cached and only built again when the samples, the zoom or
+/// the size of the graph changed. NAN samples interrupt the curve.
+// ****************************************************************************
+
+class DecimatedCurve
+{
+public:
+  DecimatedCurve();
+  void paint(wxDC &dc, Graph &graph, const std::vector<double> &values, 
+    double x0, double dx, bool logInterpolation = false);
+  void invalidate() { isValid = false; }
+
+private:
+  bool isValid;
+  CacheKey key;
+  std::vector< std::vector<wxPoint> > strokes;
+
+  void build(Graph &graph, const std::vector<double> &values, double x0, 
+    double dx, bool logInterpolation);
+};
+
 #endif
\ No newline at end of file
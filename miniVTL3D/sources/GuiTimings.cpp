@@ -0,0 +1,167 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and R�mi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#include "GuiTimings.h"
+#include <algorithm>
+#include <typeinfo>
+#ifdef __GNUG__
+#include <cxxabi.h>
+#include <cstdlib>
+#endif
+
+// ****************************************************************************
+/// Returns the single instance of the registry.
+// ****************************************************************************
+
+GuiTimings& GuiTimings::getInstance()
+{
+  static GuiTimings instance;
+  return instance;
+}
+
+// ****************************************************************************
+/// Records a call of a handler.
+// ****************************************************************************
+
+void GuiTimings::add(const string& name, double duration_s)
+{
+  map<string, handlerStats>::iterator it = m_handlers.find(name);
+  if (it == m_handlers.end())
+  {
+    handlerStats stats = { duration_s, duration_s, duration_s, 1 };
+    m_handlers[name] = stats;
+  }
+  else
+  {
+    it->second.last = duration_s;
+    it->second.max = max(it->second.max, duration_s);
+    it->second.total += duration_s;
+    it->second.calls++;
+  }
+}
+
+// ****************************************************************************
+/// Returns false if the handler has never been timed.
+// ****************************************************************************
+
+bool GuiTimings::get(const string& name, handlerStats& stats) const
+{
+  map<string, handlerStats>::const_iterator it = m_handlers.find(name);
+  if (it == m_handlers.end()) { return false; }
+  stats = it->second;
+  return true;
+}
+
+// ****************************************************************************
+
+vector<pair<string, GuiTimings::handlerStats>> GuiTimings::slowest(int num) const
+{
+  vector<pair<string, handlerStats>> handlers(m_handlers.begin(), m_handlers.end());
+  sort(handlers.begin(), handlers.end(),
+    [](const pair<string, handlerStats>& a, const pair<string, handlerStats>& b)
+    {
+      return a.second.max > b.second.max;
+    });
+  if ((int)handlers.size() > num) { handlers.resize(num); }
+  return handlers;
+}
+
+// ****************************************************************************
+
+void GuiTimings::printSlowest(int num) const
+{
+  vector<pair<string, handlerStats>> handlers(slowest(num));
+
+  wxPrintf("Slowest GUI handlers (max / mean / last, calls):\n");
+  for (int i(0); i < handlers.size(); i++)
+  {
+    const handlerStats& s(handlers[i].second);
+    wxPrintf("  %s: %.1f / %.1f / %.1f ms, %ld\n", handlers[i].first.c_str(),
+      s.max * 1000.0, s.total * 1000.0 / (double)s.calls, s.last * 1000.0,
+      s.calls);
+  }
+}
+
+// ****************************************************************************
+/// The events which are frequent or can be slow have readable names, the
+/// other ones are named by their type number.
+// ****************************************************************************
+
+string GuiTimings::handlerName(wxEvtHandler* handler, const wxEvent& event)
+{
+  wxEventType type(event.GetEventType());
+  string eventName;
+
+  if (type == wxEVT_PAINT) { eventName = "paint"; }
+  else if (type == wxEVT_SIZE) { eventName = "size"; }
+  else if (type == wxEVT_BUTTON) { eventName = "button " + to_string(event.GetId()); }
+  else if (type == wxEVT_MENU) { eventName = "menu " + to_string(event.GetId()); }
+  else if (type == wxEVT_CHECKBOX) { eventName = "checkbox " + to_string(event.GetId()); }
+  else if (type == wxEVT_THREAD) { eventName = "thread " + to_string(event.GetId()); }
+  else if (type == wxEVT_MOTION) { eventName = "mouse motion"; }
+  else if (event.IsKindOf(wxCLASSINFO(wxMouseEvent))) { eventName = "mouse"; }
+  else if (event.IsKindOf(wxCLASSINFO(wxKeyEvent))) { eventName = "key"; }
+  else { eventName = "event " + to_string((int)type); }
+
+  return handlerName(handler, eventName);
+}
+
+// ****************************************************************************
+
+string GuiTimings::handlerName(wxEvtHandler* handler, const string& eventName)
+{
+  string className(typeid(*handler).name());
+
+#ifdef __GNUG__
+  int status;
+  char* demangled = abi::__cxa_demangle(className.c_str(), NULL, NULL, &status);
+  if (status == 0) { className = demangled; }
+  free(demangled);
+#else
+  // MSVC returns "class Name"
+  if (className.compare(0, 6, "class ") == 0) { className = className.substr(6); }
+#endif
+
+  return className + "/" + eventName;
+}
+
+// ****************************************************************************
+
+GuiTimer::GuiTimer(const string& name) :
+  m_enabled(GuiTimings::getInstance().isEnabled())
+{
+  if (m_enabled)
+  {
+    m_name = name;
+    m_start = chrono::steady_clock::now();
+  }
+}
+
+// ****************************************************************************
+
+GuiTimer::~GuiTimer()
+{
+  if (m_enabled)
+  {
+    GuiTimings::getInstance().add(m_name,
+      chrono::duration<double>(chrono::steady_clock::now() - m_start).count());
+  }
+}
@@ -0,0 +1,96 @@
+// ****************************************************************************
+// This file is part of VocalTractLab3D.
+// Copyright (C) 2022, Peter Birkholz, Dresden, Germany
+// www.vocaltractlab.de
+// author: Peter Birkholz and R�mi Blandin
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+// ****************************************************************************
+
+#ifndef __GUI_TIMINGS_H__
+#define __GUI_TIMINGS_H__
+
+#include <wx/wx.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+
+using namespace std;
+
+// ****************************************************************************
+/// Registry of the times spent in the event handlers of the GUI, to find the
+/// handlers and pictures which make the GUI unresponsive. All the handlers
+/// are timed by Application::HandleEvent() and named after the class of the
+/// handler and the type of the event, e.g. "SegmentsPicture/paint". Further
+/// code can be timed with a GuiTimer. The registry is disabled by default
+/// and then costs only the test of a flag. When it is enabled (F12 in the
+/// main window), the pictures display their last paint time in an overlay,
+/// and Shift+F12 prints the slowest handlers on the console.
+// ****************************************************************************
+
+class GuiTimings
+{
+public:
+  struct handlerStats
+  {
+    double last;    ///< Duration of the last call in s
+    double max;
+    double total;
+    long calls;
+  };
+
+  static GuiTimings& getInstance();
+
+  void setEnabled(bool enabled) { m_enabled = enabled; }
+  bool isEnabled() const { return m_enabled; }
+  void clear() { m_handlers.clear(); }
+
+  void add(const string& name, double duration_s);
+  bool get(const string& name, handlerStats& stats) const;
+  /// The num handlers with the longest maximal durations
+  vector<pair<string, handlerStats>> slowest(int num) const;
+  void printSlowest(int num) const;
+
+  /// Name of the handler of an event, made of the class of the handler
+  static string handlerName(wxEvtHandler* handler, const wxEvent& event);
+  static string handlerName(wxEvtHandler* handler, const string& eventName);
+
+private:
+  GuiTimings() : m_enabled(false) {}
+
+  bool m_enabled;
+  // the handlers are only called from the main thread
+  map<string, handlerStats> m_handlers;
+};
+
+// ****************************************************************************
+/// Measures the time from the construction to the destruction in the
+/// registry of the GUI timings, if it is enabled.
+// ****************************************************************************
+
+class GuiTimer
+{
+public:
+  GuiTimer(const string& name);
+  ~GuiTimer();
+
+private:
+  string m_name;
+  bool m_enabled;
+  chrono::steady_clock::time_point m_start;
+};
+
+#endif
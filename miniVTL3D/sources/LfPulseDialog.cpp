@@ -44,6 +44,7 @@ const double LfPulseDialog::PARAM_MAX[LfPulseDialog::NUM_PARAMS] =
 
 // The single instance of this class.
 LfPulseDialog *LfPulseDialog::instance = NULL;
+wxWindow *LfPulseDialog::updateRequestReceiver = NULL;
 
 
 // ****************************************************************************
@@ -63,13 +64,28 @@ LfPulseDialog *LfPulseDialog::getInstance()
 {
   if (instance == NULL)
   {
-    instance = new LfPulseDialog(NULL);
+    instance = new LfPulseDialog(updateRequestReceiver);
   }
 
   return instance;
 }
 
 
+// ****************************************************************************
+/// Sets the parent window of the dialog, that receives the update requests.
+/// When the dialog was not created yet, it will be created with this parent.
+// ****************************************************************************
+
+void LfPulseDialog::setUpdateRequestReceiver(wxWindow *receiver)
+{
+  updateRequestReceiver = receiver;
+  if (instance != NULL)
+  {
+    instance->SetParent(receiver);
+  }
+}
+
+
 // ****************************************************************************
 /// Private constructor.
 // ****************************************************************************
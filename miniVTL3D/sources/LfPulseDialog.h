@@ -48,6 +48,11 @@ public:
 
 public:
   static LfPulseDialog *getInstance();
+  // True when the dialog was already created (by getInstance()).
+  static bool hasInstance() { return instance != NULL; }
+  // The parent window receives the update requests. It can be set 
+  // before the dialog is created.
+  static void setUpdateRequestReceiver(wxWindow *receiver);
 
   // **************************************************************************
   // Private data.
@@ -69,6 +74,7 @@ private:
 
   // The single instance of this Singleton
   static LfPulseDialog *instance;
+  static wxWindow *updateRequestReceiver;
 
   Data *data;
   LfPulse *lfPulse;
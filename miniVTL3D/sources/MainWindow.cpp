@@ -23,11 +23,13 @@
 #include "IconsXpm.h"
 #include "SilentMessageBox.h"
 #include "Backend/SoundLib.h"
-#include "Backend/AudioFile.h"
+#include "Backend/WaveFile.h"
 #include "Backend/Dsp.h"
 #include "Backend/TimeFunction.h"
 #include "Backend/XmlNode.h"
 #include "Backend/Synthesizer.h"
+#include "Backend/Profiler.h"
+#include "GuiTimings.h"
 
 #include <iostream>
 #include <wx/choicdlg.h>
@@ -111,6 +113,8 @@ static const int IDM_CLEAR_ANALYSIS_TRACKS  = 1307;
 // static const int IDK_F9                     = 1911; // Removed
 // static const int IDK_F11                    = 1912; // Removed
 // static const int IDK_F12                    = 1913; // Removed
+static const int IDK_TOGGLE_GUI_TIMINGS     = 1914;
+static const int IDK_PRINT_GUI_TIMINGS      = 1915;
 
 
 // ****************************************************************************
@@ -193,6 +197,8 @@ BEGIN_EVENT_TABLE(MainWindow, wxFrame)
   // EVT_MENU(IDK_F9, MainWindow::OnKeyF9) // Removed
   // EVT_MENU(IDK_F11, MainWindow::OnKeyF11) // Removed
   // EVT_MENU(IDK_F12, MainWindow::OnKeyF12) // Removed
+  EVT_MENU(IDK_TOGGLE_GUI_TIMINGS, MainWindow::OnToggleGuiTimings)
+  EVT_MENU(IDK_PRINT_GUI_TIMINGS, MainWindow::OnPrintGuiTimings)
 END_EVENT_TABLE()
 
 
@@ -204,7 +210,10 @@ MainWindow::MainWindow()
   // Init the audio device
   
   printf("Trying to initialize sound ... ");
-  initSound(SAMPLING_RATE);
+  {
+    ScopedTimer timer("startup/main window/sound");
+    initSound(SAMPLING_RATE);
+  }
   printf("done.\n");
   
   // ****************************************************************
@@ -245,7 +254,10 @@ MainWindow::MainWindow()
 
   // VocalTractDialog *vocalTractDialog = VocalTractDialog::getInstance(); // Removed
 
-  initWidgets();
+  {
+    ScopedTimer timer("startup/main window/widgets");
+    initWidgets();
+  }
 
   // Make the main window double buffered to avoid any flickering
   // of the child-windows and during resizing.
@@ -293,6 +305,14 @@ void MainWindow::initWidgets()
   // wxAcceleratorTable accel(numAccels, entries); // Removed
   // this->SetAcceleratorTable(accel); // Removed
 
+  // F12 toggles the timings of the GUI handlers, Shift+F12 prints the
+  // slowest handlers on the console.
+  wxAcceleratorEntry entries[2];
+  entries[0].Set(wxACCEL_NORMAL, WXK_F12, IDK_TOGGLE_GUI_TIMINGS);
+  entries[1].Set(wxACCEL_SHIFT, WXK_F12, IDK_PRINT_GUI_TIMINGS);
+  wxAcceleratorTable accel(2, entries);
+  this->SetAcceleratorTable(accel);
+
 
   // ****************************************************************
   // Set properties of this window.
@@ -520,7 +540,7 @@ void MainWindow::updateWidgets()
   // shown.
   // ****************************************************************
 
-  if (data->currentPage != prevPage)
+  if ((data->currentPage != prevPage) && (AnalysisResultsDialog::hasInstance()))
   {
     AnalysisResultsDialog *dialog = AnalysisResultsDialog::getInstance();
     if (dialog->IsShown())
@@ -722,22 +742,23 @@ void MainWindow::OnCloseWindow(wxCloseEvent &event)
     delete data->config;
 
     // **************************************************************
-    // Close all hidden dialogs.
+    // Close all hidden dialogs (only those that were created, 
+    // because they are created on first use).
     // **************************************************************
 
-    VocalTractShapesDialog::getInstance()->Close(true);
-    PhoneticParamsDialog::getInstance()->Close(true);
+    if (VocalTractShapesDialog::hasInstance()) { VocalTractShapesDialog::getInstance()->Close(true); }
+    if (PhoneticParamsDialog::hasInstance()) { PhoneticParamsDialog::getInstance()->Close(true); }
 //    AnatomyParamsDialog::getInstance()->Close(true);
-    LfPulseDialog::getInstance()->Close(true);
-    TdsOptionsDialog::getInstance()->Close(true);
-    FdsOptionsDialog::getInstance()->Close(true);
+    if (LfPulseDialog::hasInstance()) { LfPulseDialog::getInstance()->Close(true); }
+    if (TdsOptionsDialog::hasInstance()) { TdsOptionsDialog::getInstance()->Close(true); }
+    if (FdsOptionsDialog::hasInstance()) { FdsOptionsDialog::getInstance()->Close(true); }
     // SpectrumOptionsDialog::getInstance(NULL)->Close(true); // Already Commented
-    GlottisDialog::getInstance()->Close(true);
+    if (GlottisDialog::hasInstance()) { GlottisDialog::getInstance()->Close(true); }
     // VocalTractDialog::getInstance(this)->Close(true); // Removed
-    AnalysisResultsDialog::getInstance()->Close(true);
+    if (AnalysisResultsDialog::hasInstance()) { AnalysisResultsDialog::getInstance()->Close(true); }
     // AnnotationDialog::getInstance(NULL)->Close(true); // Already Commented
-    PoleZeroDialog::getInstance()->Close(true);
-    TransitionDialog::getInstance()->Close(true);
+    if (PoleZeroDialog::hasInstance()) { PoleZeroDialog::getInstance()->Close(true); }
+    if (TransitionDialog::hasInstance()) { TransitionDialog::getInstance()->Close(true); }
     // AnatomyParamsDialog::getInstance()->Close(true); // Add this to ensure it's commented
 
     this->Destroy();
@@ -769,14 +790,15 @@ void MainWindow::OnLoadWavEgg(wxCommandEvent &event)
   {
     audioFileName = wxFileName(name);
 
-    AudioFile<double> audioFile;
-    if (!audioFile.load(audioFileName.GetFullPath().ToStdString()))
+    MappedWaveFile audioFile;
+    string errorMessage;
+    if (!audioFile.open(audioFileName.GetFullPath().ToStdString(), errorMessage))
     {
       wxMessageBox("Error in loading the file.", "Error!");
       return;
     }
 
-    if (audioFile.isStereo() == false)
+    if (audioFile.numChannels() != 2)
     {
       wxMessageBox("Error: The audio file must be stereo.");
       return;
@@ -805,8 +827,8 @@ void MainWindow::OnLoadWavEgg(wxCommandEvent &event)
     if (answer != wxCANCEL)
     {
       int i;
-      int sourceSamplingRate = audioFile.getSampleRate();
-      int numSourceSamples = audioFile.getNumSamplesPerChannel();
+      int sourceSamplingRate = audioFile.sampleRate();
+      int numSourceSamples = (int)audioFile.numSamplesPerChannel();
       int numTargetSamples = numSourceSamples * (double)SAMPLING_RATE / (double)sourceSamplingRate;
       int sourceIndex = 0;
 
@@ -818,8 +840,8 @@ void MainWindow::OnLoadWavEgg(wxCommandEvent &event)
         {
           sourceIndex = numSourceSamples - 1;
         }
-        data->track[Data::MAIN_TRACK]->setValue(targetPos + i, audioFile.samples[0][sourceIndex] * 32767.0);
-        data->track[Data::EGG_TRACK]->setValue(targetPos + i, audioFile.samples[1][sourceIndex] * 32767.0);
+        data->track[Data::MAIN_TRACK]->setValue(targetPos + i, audioFile.getSample16(0, sourceIndex));
+        data->track[Data::EGG_TRACK]->setValue(targetPos + i, audioFile.getSample16(1, sourceIndex));
       }
       updateWidgets();
     }
@@ -853,19 +875,19 @@ void MainWindow::OnSaveWavEgg(wxCommandEvent &event)
 
     // Create and save the audio file.
 
-    AudioFile<double> audioFile;
+    WaveFileWriter audioFile;
     int numSamples = rightPos - leftPos + 1;
-    audioFile.setAudioBufferSize(2, numSamples);
-    audioFile.setBitDepth(16);
-    audioFile.setSampleRate(SAMPLING_RATE);
+    vector<signed short> samples(2 * numSamples);
     int i;
     for (i = 0; i < numSamples; i++)
     {
-      audioFile.samples[0][i] = (double)data->track[Data::MAIN_TRACK]->x[leftPos + i] / 32768.0;
-      audioFile.samples[1][i] = (double)data->track[Data::EGG_TRACK]->x[leftPos + i] / 32768.0;
+      samples[2 * i] = data->track[Data::MAIN_TRACK]->x[leftPos + i];
+      samples[2 * i + 1] = data->track[Data::EGG_TRACK]->x[leftPos + i];
     }
 
-    if (audioFile.save(audioFileName.GetFullPath().ToStdString()) == false)
+    if ((audioFile.open(audioFileName.GetFullPath().ToStdString(), SAMPLING_RATE, 2) == false) ||
+      (audioFile.writeSamples(samples.data(), numSamples) == false) ||
+      (audioFile.close() == false))
     {
       wxMessageBox("Error saving the file.", "Error!");
     }
@@ -893,14 +915,15 @@ void MainWindow::OnLoadWav(wxCommandEvent &event)
 
     if (trackIndex != -1)
     {
-      AudioFile<double> audioFile;
-      if (!audioFile.load(audioFileName.GetFullPath().ToStdString()))
+      MappedWaveFile audioFile;
+      string errorMessage;
+      if (!audioFile.open(audioFileName.GetFullPath().ToStdString(), errorMessage))
       {
         wxMessageBox("Error in loading the file.", "Error!");
         return;
       }
 
-      if (audioFile.isMono() == false)
+      if (audioFile.numChannels() != 1)
       {
         wxMessageBox("Error: The audio file must be mono.");
         return;
@@ -927,8 +950,8 @@ void MainWindow::OnLoadWav(wxCommandEvent &event)
 
       if (answer != wxCANCEL)
       {
-        int sourceSamplingRate = audioFile.getSampleRate();
-        int numSourceSamples = audioFile.getNumSamplesPerChannel();
+        int sourceSamplingRate = audioFile.sampleRate();
+        int numSourceSamples = (int)audioFile.numSamplesPerChannel();
         int numTargetSamples = numSourceSamples * (double)SAMPLING_RATE / (double)sourceSamplingRate;
         int sourceIndex = 0;
         int i;
@@ -941,7 +964,7 @@ void MainWindow::OnLoadWav(wxCommandEvent &event)
           {
             sourceIndex = numSourceSamples - 1;
           }
-          data->track[trackIndex]->setValue(targetPos + i, audioFile.samples[0][sourceIndex] * 32767.0);
+          data->track[trackIndex]->setValue(targetPos + i, audioFile.getSample16(0, sourceIndex));
         }
 
         updateWidgets();
@@ -981,18 +1004,14 @@ void MainWindow::OnSaveWav(wxCommandEvent &event)
     {
       // Create and save the audio file.
 
-      AudioFile<double> audioFile;
+      // The samples of the track are written directly.
+
+      WaveFileWriter audioFile;
       int numSamples = rightPos - leftPos + 1;
-      audioFile.setAudioBufferSize(1, numSamples);
-      audioFile.setBitDepth(16);
-      audioFile.setSampleRate(SAMPLING_RATE);
-      int i;
-      for (i = 0; i < numSamples; i++)
-      {
-        audioFile.samples[0][i] = (double)data->track[trackIndex]->x[leftPos + i] / 32768.0;
-      }
 
-      if (audioFile.save(audioFileName.GetFullPath().ToStdString()) == false)
+      if ((audioFile.open(audioFileName.GetFullPath().ToStdString(), SAMPLING_RATE, 1) == false) ||
+        (audioFile.writeSamples(data->track[trackIndex]->x + leftPos, numSamples) == false) ||
+        (audioFile.close() == false))
       {
         wxMessageBox("Error saving the file.", "Error!");
       }
@@ -1681,12 +1700,16 @@ void MainWindow::OnExportVocalTractToSTL(wxCommandEvent& event)
 {
 	wxFileDialog dialog(this, "save geometry under stl format",
 		exportFileName.GetPath(), exportFileName.GetFullName(),
-		"vocal tract geometry (*.stl)|*.stl", wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+		"vocal tract geometry (*.stl)|*.stl|vocal tract geometry, binary (*.stl)|*.stl", 
+		wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
 
 	if (dialog.ShowModal() == wxID_OK)
 	{
 		exportFileName = wxFileName(dialog.GetPath());
-		if (data->vocalTract->exportVocalTractToSTL(exportFileName.GetFullPath().ToStdString()) == false)
+		// the second filter writes the much smaller binary STL files
+		bool binary = (dialog.GetFilterIndex() == 1);
+		if (data->vocalTract->exportVocalTractToSTL(exportFileName.GetFullPath().ToStdString(), 
+			binary) == false)
 		{
 			wxMessageBox("failed to export vocal tract geometry.", "error");
 		}
@@ -2018,7 +2041,7 @@ void MainWindow::OnTubeSequenceFileToAudio(wxCommandEvent &event)
   wxFileName fileName(tubeSequenceFileName);
 
   wxString name = wxFileSelector("Load tube sequence file", fileName.GetPath(),
-    fileName.GetFullName(), ".txt", "Tube sequence files (*.txt)|*.txt",
+    fileName.GetFullName(), ".txt", "Tube sequence files (*.txt;*.bin)|*.txt;*.bin",
     wxFD_OPEN | wxFD_FILE_MUST_EXIST, this);
 
   if (name.empty())
@@ -2071,7 +2094,7 @@ void MainWindow::OnTractSequenceFileToAudio(wxCommandEvent &event)
   wxFileName fileName(tractSequenceFileName);
 
   wxString name = wxFileSelector("Load tract sequence file", fileName.GetPath(),
-    fileName.GetFullName(), ".txt", "Tract sequence files (*.txt)|*.txt",
+    fileName.GetFullName(), ".txt", "Tract sequence files (*.txt;*.bin)|*.txt;*.bin",
     wxFD_OPEN | wxFD_FILE_MUST_EXIST, this);
 
   if (name.empty())
@@ -2204,6 +2227,41 @@ void MainWindow::OnAbout(wxCommandEvent &event)
 }
 
 
+// ****************************************************************************
+/// Enables the timings of the GUI handlers anew, or disables them after 
+/// printing the slowest handlers. The pictures are refreshed to show or 
+/// hide their overlays of the paint times.
+// ****************************************************************************
+
+void MainWindow::OnToggleGuiTimings(wxCommandEvent &event)
+{
+  GuiTimings &timings = GuiTimings::getInstance();
+
+  if (timings.isEnabled())
+  {
+    timings.printSlowest(20);
+    timings.setEnabled(false);
+    wxPrintf("GUI timings disabled.\n");
+  }
+  else
+  {
+    timings.clear();
+    timings.setEnabled(true);
+    wxPrintf("GUI timings enabled (Shift+F12 prints the slowest handlers).\n");
+  }
+  Refresh();
+}
+
+
+// ****************************************************************************
+// ****************************************************************************
+
+void MainWindow::OnPrintGuiTimings(wxCommandEvent &event)
+{
+  GuiTimings::getInstance().printSlowest(20);
+}
+
+
 // ****************************************************************************
 // ****************************************************************************
 
@@ -2308,6 +2366,7 @@ void MainWindow::OnClearMainTrack(wxCommandEvent &event)
   data->track[i]->setZero();
   data->f0Signal[i].clear();
   data->voiceQualitySignal[i].clear();
+  for (int k = 0; k < FormantEstimatorLpc::NUM_FORMANTS; k++) { data->formantSignal[i][k].clear(); }
 
   updateWidgets();
 }
@@ -2323,6 +2382,7 @@ void MainWindow::OnClearEggTrack(wxCommandEvent &event)
   data->track[i]->setZero();
   data->f0Signal[i].clear();
   data->voiceQualitySignal[i].clear();
+  for (int k = 0; k < FormantEstimatorLpc::NUM_FORMANTS; k++) { data->formantSignal[i][k].clear(); }
 
   updateWidgets();
 }
@@ -2338,6 +2398,7 @@ void MainWindow::OnClearExtraTrack(wxCommandEvent &event)
   data->track[i]->setZero();
   data->f0Signal[i].clear();
   data->voiceQualitySignal[i].clear();
+  for (int k = 0; k < FormantEstimatorLpc::NUM_FORMANTS; k++) { data->formantSignal[i][k].clear(); }
 
   updateWidgets();
 }
@@ -2379,6 +2440,7 @@ void MainWindow::OnClearAnalysisTracks(wxCommandEvent &event)
   { 
     data->f0Signal[i].clear();
     data->voiceQualitySignal[i].clear();
+    for (int k = 0; k < FormantEstimatorLpc::NUM_FORMANTS; k++) { data->formantSignal[i][k].clear(); }
   }
 
   updateWidgets();
@@ -171,6 +171,10 @@ private:
   
   void OnHertzToSemitones(wxCommandEvent &event);
 
+  // Timings of the GUI handlers
+  void OnToggleGuiTimings(wxCommandEvent &event);
+  void OnPrintGuiTimings(wxCommandEvent &event);
+
   void OnAbout(wxCommandEvent &event);
 
   // Toolbar functions
@@ -23,6 +23,8 @@
 #include "Data.h"
 #include <fstream>
 #include "Backend/Constants.h"
+#include "Backend/ConvergenceStudy.h"
+#include <sstream>
 #include <wx/filename.h>
 #include <wx/statline.h>
 
@@ -56,6 +58,8 @@ static const int IDB_LOAD_TF_POINTS   = 4018;
 static const int IDE_WALL_ADMIT_REAL       = 4019;
 static const int IDE_WALL_ADMIT_IMAG    = 4020;
 
+static const int IDE_POOL_WORKERS       = 4021;
+
 static const int IDB_CHK_FDEP_LOSSES	= 5001;
 static const int IDB_CHK_WALL_LOSSES    = 5002;
 static const int IDB_CHK_WALL_ADMITTANCE = 5003;
@@ -68,6 +72,8 @@ static const int IDB_CHK_VAR_AREA		= 5007;
 static const int IDB_CHK_MULTI_TF_PTS = 5008;
 
 static const int IDB_COMPUTE_RAD_FIELD = 5009;
+static const int IDB_CHK_PIN_THREADS = 5010;
+static const int IDB_CHK_NESTED_LOOPS = 5011;
 
 static const int IDL_SCALING_FAC_METHOD = 6000;
 static const int IDL_MOUTH_BCOND = 6001;
@@ -78,6 +84,7 @@ static const int IDL_AMPLITUDE_PHASE = 6004;
 static const int IDB_SET_DEFAULT_PARAMS_FAST = 7002;
 static const int IDB_SET_DEFAULT_PARAMS_ACCURATE = 7003;
 static const int IDB_CLOSE = 7004;
+static const int IDB_CONVERGENCE_STUDY = 7005;
 
 // ****************************************************************************
 // The event table.
@@ -98,6 +105,7 @@ EVT_TEXT_ENTER(IDE_BBOX_MIN_X, ParamSimu3DDialog::OnBboxMinX)
 EVT_TEXT_ENTER(IDE_BBOX_MIN_Y, ParamSimu3DDialog::OnBboxMinY)
 EVT_TEXT_ENTER(IDE_BBOX_MAX_X, ParamSimu3DDialog::OnBboxMaxX)
 EVT_TEXT_ENTER(IDE_BBOX_MAX_Y, ParamSimu3DDialog::OnBboxMaxY)
+EVT_TEXT_ENTER(IDE_POOL_WORKERS, ParamSimu3DDialog::OnPoolWorkers)
 
 EVT_TEXT_ENTER(IDE_TF_POINT_X, ParamSimu3DDialog::OnTfPointX)
 EVT_TEXT_ENTER(IDE_TF_POINT_Y, ParamSimu3DDialog::OnTfPointY)
@@ -116,6 +124,8 @@ EVT_CHECKBOX(IDB_CHK_CURV, ParamSimu3DDialog::OnChkCurv)
 EVT_CHECKBOX(IDB_CHK_VAR_AREA, ParamSimu3DDialog::OnChkVarArea)
 EVT_CHECKBOX(IDB_CHK_MULTI_TF_PTS, ParamSimu3DDialog::OnChkMultiTFPts)
 EVT_CHECKBOX(IDB_COMPUTE_RAD_FIELD, ParamSimu3DDialog::OnChkComputeRad)
+EVT_CHECKBOX(IDB_CHK_PIN_THREADS, ParamSimu3DDialog::OnChkPinThreads)
+EVT_CHECKBOX(IDB_CHK_NESTED_LOOPS, ParamSimu3DDialog::OnChkNestedLoops)
 
 EVT_COMBOBOX(IDL_SCALING_FAC_METHOD, ParamSimu3DDialog::OnScalingFactMethod)
 EVT_COMBOBOX(IDL_MOUTH_BCOND, ParamSimu3DDialog::OnMouthBcond)
@@ -126,11 +136,13 @@ EVT_COMBOBOX(IDL_AMPLITUDE_PHASE, ParamSimu3DDialog::OnAmplitudePhase)
 EVT_BUTTON(IDB_SET_DEFAULT_PARAMS_FAST, ParamSimu3DDialog::OnSetDefaultParamsFast)
 EVT_BUTTON(IDB_SET_DEFAULT_PARAMS_ACCURATE, ParamSimu3DDialog::OnSetDefaultParamsAccurate)
 EVT_BUTTON(IDB_CLOSE, ParamSimu3DDialog::OnClose)
+EVT_BUTTON(IDB_CONVERGENCE_STUDY, ParamSimu3DDialog::OnConvergenceStudy)
 
 END_EVENT_TABLE()
 
 // The single instance of this class.
 ParamSimu3DDialog *ParamSimu3DDialog::instance = NULL;
+wxWindow* ParamSimu3DDialog::updateRequestReceiver = NULL;
 
 // ****************************************************************************
 /// Returns the single instance of this dialog.
@@ -361,6 +373,12 @@ void ParamSimu3DDialog::updateWidgets()
 
   chkComputeRad->SetValue(m_simuParams.computeRadiatedField);
 
+  // the thread pool is shared by the whole program
+  threadPoolSettings pool(getThreadPoolSettings());
+  txtPoolWorkers->SetValue(wxString::Format("%d", threadPoolSize()));
+  chkPinThreads->SetValue(pool.pinWorkers);
+  chkNestedLoops->SetValue(pool.nested == NESTED_IDLE_WORKERS);
+
   m_simu3d->setSimulationParameters(m_meshDensity, m_secNoiseSource, 
 		m_simuParams, m_mouthBoundaryCond, m_contInterpMeth);
 }
@@ -986,6 +1004,33 @@ void ParamSimu3DDialog::initWidgets()
 
   topLevelSizer->Add(sz, 0, wxLEFT | wxRIGHT | wxEXPAND, 10);
 
+  ///////////////////////////////////////////////////////////////////
+  // Thread pool options
+  ///////////////////////////////////////////////////////////////////
+
+  topLevelSizer->AddSpacer(10);
+  sz = new wxStaticBoxSizer(wxVERTICAL, this, "Threads");
+
+  lineSizer = new wxBoxSizer(wxHORIZONTAL);
+
+  label = new wxStaticText(this, wxID_ANY, "Worker threads");
+  lineSizer->Add(label, 0, wxALL | wxALIGN_CENTER, 3);
+
+  txtPoolWorkers = new wxTextCtrl(this, IDE_POOL_WORKERS, "", wxDefaultPosition,
+    wxSize(40, -1), wxTE_PROCESS_ENTER);
+  lineSizer->Add(txtPoolWorkers, 0, wxALL, 3);
+
+  chkPinThreads = new wxCheckBox(this, IDB_CHK_PIN_THREADS, "Pin threads to cores");
+  lineSizer->Add(chkPinThreads, 0, wxALL | wxALIGN_CENTER, 3);
+
+  chkNestedLoops = new wxCheckBox(this, IDB_CHK_NESTED_LOOPS, 
+    "Parallel nested loops");
+  lineSizer->Add(chkNestedLoops, 0, wxALL | wxALIGN_CENTER, 3);
+
+  sz->Add(lineSizer, 0, wxLEFT | wxRIGHT, 10);
+
+  topLevelSizer->Add(sz, 0, wxLEFT | wxRIGHT | wxEXPAND, 10);
+
   // ****************************************************************
   // Set the default parameters
   // ****************************************************************
@@ -1003,6 +1048,10 @@ void ParamSimu3DDialog::initWidgets()
     "Default (accurate)");
   lineSizer->Add(button, 1,  wxALL, 3);
 
+  button = new wxButton(this, IDB_CONVERGENCE_STUDY,
+    "Convergence study");
+  lineSizer->Add(button, 1,  wxALL, 3);
+
   lineSizer->AddStretchSpacer();
 
   button = new wxButton(this, IDB_CLOSE, "Close");
@@ -1179,6 +1228,24 @@ void ParamSimu3DDialog::OnResolutionField(wxCommandEvent& event)
 // ****************************************************************************
 // ****************************************************************************
 
+void ParamSimu3DDialog::OnPoolWorkers(wxCommandEvent& event)
+{
+  long x(0);
+  wxString st = txtPoolWorkers->GetValue();
+  if ((st.ToLong(&x)) && (x >= 1) && (x <= 1024))
+  {
+    threadPoolSettings pool(getThreadPoolSettings());
+    pool.numWorkers = (int)x;
+    setThreadPoolSettings(pool);
+    // the simulation uses all the workers of the pool
+    m_simuParams.numThreads = (int)x;
+  }
+  updateWidgets();
+}
+
+// ****************************************************************************
+// ****************************************************************************
+
 void ParamSimu3DDialog::OnBboxMinX(wxCommandEvent& event)
 {
   double x(0.);
@@ -1294,7 +1361,7 @@ void ParamSimu3DDialog::OnLoadTfPts(wxCommandEvent& event)
   fileName.GetFullName(), ".csv", "Points file (*.csv)|*.csv",
   wxFD_OPEN | wxFD_FILE_MUST_EXIST, this);
 
-  ofstream log("log.txt", ofstream::app);
+  LogStream log;
   log << "Load tf points from file:" << endl;
   log << name.ToStdString() << endl;
   bool success = m_simu3d->setTFPointsFromCsvFile(name.ToStdString());
@@ -1454,6 +1521,29 @@ void ParamSimu3DDialog::OnChkComputeRad(wxCommandEvent& event)
 // ****************************************************************************
 // ****************************************************************************
 
+void ParamSimu3DDialog::OnChkPinThreads(wxCommandEvent& event)
+{
+  threadPoolSettings pool(getThreadPoolSettings());
+  pool.pinWorkers = !pool.pinWorkers;
+  setThreadPoolSettings(pool);
+  updateWidgets();
+}
+
+// ****************************************************************************
+// ****************************************************************************
+
+void ParamSimu3DDialog::OnChkNestedLoops(wxCommandEvent& event)
+{
+  threadPoolSettings pool(getThreadPoolSettings());
+  pool.nested = (pool.nested == NESTED_IDLE_WORKERS) ? NESTED_SEQUENTIAL : 
+    NESTED_IDLE_WORKERS;
+  setThreadPoolSettings(pool);
+  updateWidgets();
+}
+
+// ****************************************************************************
+// ****************************************************************************
+
 void ParamSimu3DDialog::OnScalingFactMethod(wxCommandEvent& event)
 {
   auto res = lstScalingFacMethods->GetSelection();
@@ -1660,6 +1750,69 @@ void ParamSimu3DDialog::SetDefaultParams(bool fast)
   updateGeometry();
 }
 
+// ****************************************************************************
+// Coarsen the solver settings of the current geometry while its transfer 
+// function stays within the default tolerance of the one computed with the
+// current settings (see ConvergenceStudy.h), and propose to apply the 
+// cheapest settings found
+// ****************************************************************************
+
+void ParamSimu3DDialog::OnConvergenceStudy(wxCommandEvent& event)
+{
+  if (m_simu3d->numberOfSegments() == 0)
+  {
+    wxMessageBox("The geometry has not been created.", "Convergence study");
+    return;
+  }
+
+  // the study imports the geometry from a file as the command line driver
+  wxString geometryFile = wxFileName::CreateTempFileName("vtl3d");
+  if (!m_simu3d->exportGeoInCsv(geometryFile.ToStdString()))
+  {
+    wxMessageBox("The geometry could not be exported.", "Convergence study");
+    return;
+  }
+
+  struct simulationSetup setup(getSimulationSetup(*m_simu3d));
+  struct convergenceStudyParameters params(defaultConvergenceStudyParameters(setup));
+  struct convergenceStudy study;
+  bool success;
+  {
+    wxBusyCursor busy;
+    success = computeConvergenceStudy(geometryFile.ToStdString(), setup, 
+      params, study);
+  }
+  wxRemoveFile(geometryFile);
+
+  if (!success)
+  {
+    wxMessageBox("The reference transfer function could not be computed.", 
+      "Convergence study");
+    return;
+  }
+
+  ostringstream os;
+  writeConvergenceStudy(os, study, params);
+  os << endl << "Apply the recommended settings?";
+  wxMessageDialog dialog(this, os.str(), "Convergence study", 
+    wxYES_NO | wxICON_QUESTION);
+  if (dialog.ShowModal() != wxID_YES) { return; }
+
+  const struct solverSettings& best(study.runs[study.recommended].settings);
+  setMeshDensity(best.meshDensity);
+  setMaxCutOnFreq(best.maxCutOnFreq);
+  m_simuParamsMagnus.numIntegrationStep = best.numIntegrationStep;
+  m_simuParams.orderMagnusScheme = best.orderMagnusScheme;
+  if (best.radImpedGridDensity != m_simuParams.radImpedGridDensity)
+  {
+    m_simuParams.radImpedPrecomputed = false;
+    m_simuParams.radImpedGridDensity = best.radImpedGridDensity;
+  }
+
+  updateWidgets();
+  updateGeometry();
+}
+
 // ****************************************************************************
 // ****************************************************************************
 
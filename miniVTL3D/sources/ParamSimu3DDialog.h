@@ -38,7 +38,8 @@ public:
     static ParamSimu3DDialog* getInstance(wxWindow *parent = NULL);
     void updateWidgets();
     void updateParams();
-    void setUpdateRequestReceiver(wxWindow* receiver);
+    // the receiver is kept when the dialog is created later
+    static void setUpdateRequestReceiver(wxWindow* receiver);
 
     void updateGeometry();
     void updatePictures();
@@ -49,7 +50,7 @@ public:
 
 private:
   static ParamSimu3DDialog *instance;
-  wxWindow* updateRequestReceiver;
+  static wxWindow* updateRequestReceiver;
 
   wxTextCtrl* txtTemperature;
   wxTextCtrl* txtSndSpeed;
@@ -71,6 +72,9 @@ private:
   wxTextCtrl* txtBboxMaxX;
   wxTextCtrl* txtBboxMaxY;
 
+  // thread pool
+  wxTextCtrl* txtPoolWorkers;
+
   // transfer function point
   wxTextCtrl* txtTfPointX;
   wxTextCtrl* txtTfPointY;
@@ -87,6 +91,8 @@ private:
 	wxCheckBox* chkVarArea;
   wxCheckBox* chkMultiTFPts;
   wxCheckBox* chkComputeRad;
+  wxCheckBox* chkPinThreads;
+  wxCheckBox* chkNestedLoops;
 
   // lists
   wxComboBox* lstScalingFacMethods;
@@ -138,6 +144,7 @@ private:
   void OnBboxMinY(wxCommandEvent& event);
   void OnBboxMaxX(wxCommandEvent& event);
   void OnBboxMaxY(wxCommandEvent& event);
+  void OnPoolWorkers(wxCommandEvent& event);
 
   void OnTfPointX(wxCommandEvent& event);
   void OnTfPointY(wxCommandEvent& event);
@@ -155,6 +162,8 @@ private:
 	void OnChkVarArea(wxCommandEvent& event);
   void OnChkMultiTFPts(wxCommandEvent& event);
   void OnChkComputeRad(wxCommandEvent& event);
+  void OnChkPinThreads(wxCommandEvent& event);
+  void OnChkNestedLoops(wxCommandEvent& event);
 
   void OnScalingFactMethod(wxCommandEvent& event);
   void OnMouthBcond(wxCommandEvent& event);
@@ -164,6 +173,7 @@ private:
 
   void OnSetDefaultParamsFast(wxCommandEvent& event);
   void OnSetDefaultParamsAccurate(wxCommandEvent& event);
+  void OnConvergenceStudy(wxCommandEvent& event);
   void SetDefaultParams(bool fast);
 
   void OnClose(wxCommandEvent& event);
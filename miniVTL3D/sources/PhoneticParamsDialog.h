@@ -46,6 +46,8 @@ public:
 
 public:
   static PhoneticParamsDialog *getInstance(wxWindow *parent = NULL);
+  // True when the dialog was already created (by getInstance()).
+  static bool hasInstance() { return instance != NULL; }
   void updateWidgets();
   void setUpdateRequestReceiver(wxWindow *receiver);
 
@@ -48,6 +48,8 @@ public:
 
 public:
   static PoleZeroDialog *getInstance();
+  // True when the dialog was already created (by getInstance()).
+  static bool hasInstance() { return instance != NULL; }
   void updateWidgets();
   void setSpectrumPicture(wxPanel *spectrumPicture);
 
@@ -66,6 +66,111 @@ EVT_MENU(IDM_EXPORT_ACOUSTIC_FIELD, PropModesPicture::OnExportAcousticField)
 EVT_MENU(IDM_EXPORT_CONTOUR, PropModesPicture::OnExportContour)
 END_EVENT_TABLE()
 
+// ****************************************************************************
+/// Fills a rectangle of the bitmap data with a color. The parts of the 
+/// rectangle outside of the bitmap are ignored.
+// ****************************************************************************
+
+static void fillRectangle(wxNativePixelData& data, int x, int y, int w, int h,
+  int red, int green, int blue)
+{
+  int xStart(max(0, x)), xEnd(min(data.GetWidth(), x + w));
+  int yStart(max(0, y)), yEnd(min(data.GetHeight(), y + h));
+  if ((xStart >= xEnd) || (yStart >= yEnd)) { return; }
+
+  wxNativePixelData::Iterator p(data);
+  p.MoveTo(data, xStart, yStart);
+  for (int i(yStart); i < yEnd; i++)
+  {
+    wxNativePixelData::Iterator rowStart = p;
+    for (int j(xStart); j < xEnd; j++, ++p)
+    {
+      p.Red() = red;
+      p.Green() = green;
+      p.Blue() = blue;
+    }
+    p = rowStart;
+    p.OffsetY(data, 1);
+  }
+}
+
+// ****************************************************************************
+/// Rasterises the values defined at the vertexes of a mesh in width x height
+/// pixels with a scanline algorithm. For each triangle, the rows of pixels 
+/// whose centers are inside the triangle are filled, the values being 
+/// linearly interpolated at the centers of the pixels. Since a pixel 
+/// center belongs to only one of two adjacent triangles, each pixel is 
+/// written once. The pixels are stored row by row in pixels, the ones 
+/// outside of the mesh being NaN, so that they can be converted into an
+/// image by ColorScale::fieldToImage. If field is not NULL, the 
+/// interpolated values are also written in it, with the rows in the 
+/// reverse order.
+// ****************************************************************************
+
+static void rasterizeMesh(const vector<array<double, 2>>& pts,
+  const vector<array<int, 3>>& triangles, const Vec& values, double zoom,
+  double centerX, double centerY, int width, int height, 
+  vector<double>& pixels, Matrix* field)
+{
+  double px[3], py[3], val[3];
+  double det, yc, xc, xLeft, xRight, x, l1, l2, value;
+  int yStart, yEnd, xStart, xEnd, a, b;
+
+  pixels.assign(width * height, NAN);
+
+  for (int it(0); it < triangles.size(); ++it)
+  {
+    // coordinates of the vertexes in pixels
+    for (int v(0); v < 3; v++)
+    {
+      px[v] = zoom * pts[triangles[it][v]][0] + centerX;
+      py[v] = centerY - zoom * pts[triangles[it][v]][1];
+      val[v] = values(triangles[it][v]);
+    }
+    det = (px[1] - px[0]) * (py[2] - py[0]) - (px[2] - px[0]) * (py[1] - py[0]);
+    if (abs(det) < 1e-12) { continue; }
+
+    // rows whose centers are between the minimal and maximal y
+    yStart = max(0, (int)ceil(min(py[0], min(py[1], py[2])) - 0.5));
+    yEnd = min(height - 1, (int)ceil(max(py[0], max(py[1], py[2])) - 0.5) - 1);
+
+    for (int i(yStart); i <= yEnd; i++)
+    {
+      // intersect the row with the edges of the triangle
+      yc = (double)i + 0.5;
+      xLeft = INFINITY;
+      xRight = -INFINITY;
+      for (a = 0; a < 3; a++)
+      {
+        b = (a + 1) % 3;
+        if (((py[a] <= yc) && (py[b] > yc)) || ((py[b] <= yc) && (py[a] > yc)))
+        {
+          x = px[a] + (yc - py[a]) * (px[b] - px[a]) / (py[b] - py[a]);
+          xLeft = min(xLeft, x);
+          xRight = max(xRight, x);
+        }
+      }
+      if (xLeft > xRight) { continue; }
+
+      xStart = max(0, (int)ceil(xLeft - 0.5));
+      xEnd = min(width - 1, (int)ceil(xRight - 0.5) - 1);
+      if (xStart > xEnd) { continue; }
+
+      for (int j(xStart); j <= xEnd; j++)
+      {
+        // barycentric coordinates of the center of the pixel
+        xc = (double)j + 0.5;
+        l1 = ((xc - px[0]) * (py[2] - py[0]) - (px[2] - px[0]) * (yc - py[0])) / det;
+        l2 = ((px[1] - px[0]) * (yc - py[0]) - (xc - px[0]) * (py[1] - py[0])) / det;
+        value = val[0] + l1 * (val[1] - val[0]) + l2 * (val[2] - val[0]);
+
+        pixels[i * width + j] = value;
+        if (field != NULL) { (*field)(height - i - 1, j) = value; }
+      }
+    }
+  }
+}
+
 // ****************************************************************************
 /// Constructor. Passes the parent parameter.
 // ****************************************************************************
@@ -192,8 +297,8 @@ void PropModesPicture::draw(wxDC& dc)
 			array<int, 3> tri;
 
 			int numFaces = seg->numberOfFaces();
-			vector<array<double, 2>> pts = seg->getPoints();
-			vector<array<int, 3>> triangles = seg->getTriangles();
+			const vector<array<double, 2>>& pts = seg->getPoints();
+			const vector<array<int, 3>>& triangles = seg->getTriangles();
 
 			auto start = std::chrono::system_clock::now();
 			auto end = std::chrono::system_clock::now();
@@ -238,107 +343,35 @@ void PropModesPicture::draw(wxDC& dc)
 
 		case TRANSVERSE_MODE: {
 
-			auto start = std::chrono::system_clock::now();
-			auto end = std::chrono::system_clock::now();
-			std::chrono::duration<double> elapsed_seconds = end - start;
-
-			int normAmp;
 			double maxAmp(0.);
 			double minAmp(0.);
-			Point3D vecTri[3];
-			Point3D pointToDraw;
-			int numPtSide;
-			double alpha;
-			double beta;
-			double maxDist;
 
 			// check if the mode index is in the range of the number
 			// of modes
 			m_modeIdx = max(0, min(seg->numberOfModes()-1, m_modeIdx));
 
-			ColorMap colorMap = ColorScale::getColorMap();
-
-			// initialise white bitmap
-			wxBitmap bmp(width, height, 24);
-			wxNativePixelData data(bmp);
-			wxNativePixelData::Iterator p(data);
-			for (int i = 0; i < height; ++i)
-			{
-				wxNativePixelData::Iterator rowStart = p;
-				for (int j = 0; j < width; ++j, ++p)
-				{
-					p.Red() = 254;
-					p.Green() = 254;
-					p.Blue() = 254;
-				}
-				p = rowStart;
-				p.OffsetY(data, 1);
-			}
-
-			int numFaces = seg->numberOfFaces();
-			int numVertex = seg->numberOfVertices();
-			vector<array<double, 2>> pts = seg->getPoints();
-			vector<array<int, 3>> triangles = seg->getTriangles();
-			Matrix modes = seg->getModes();
+			const vector<array<double, 2>>& pts = seg->getPoints();
+			const vector<array<int, 3>>& triangles = seg->getTriangles();
+			Vec amplitudes(seg->getModes().col(m_modeIdx));
 
 			// extract the maximum and minimum of amplitude
 			maxAmp = seg->getMaxAmplitude(m_modeIdx);
 			minAmp = seg->getMinAmplitude(m_modeIdx);
+			double normAmp(max(maxAmp, -minAmp));
 
+			// rasterise the mode only if it is not in the cache
+			bool upToDate;
+			cachedImage& image = getCachedImage(TRANSVERSE_MODE, sectionIdx, m_modeIdx,
+				width, height, { m_zoom, maxAmp, minAmp, (double)amplitudes.size(), 
+				amplitudes.sum(), amplitudes.squaredNorm() }, upToDate);
 
-			// draw the propagation mode
-			//
-			// The triangles are interpolated by adding the the fraction a and b 
-			// of the vector formed by two sides and the corresponding vertex amplitude.
-			// The corresponding values are attributed to the location of the nearest 
-			// pixel in the bitmap grid. 
-			// This avoid searching to which triangle a pixel belongs, which has a higher
-			// computational cost.
-			//
-			//
-			//   ^ P1
-			//   |
-			//   |   P?
-			//   |________\ P2
-			//  O         /
-			//
-			//  P = a*P1 + b*P2 + (1 - a - b)*O 
-			//  
-			//  with 0 <= a <= 1 and 0 <= b <= 1
-			std::chrono::duration<double> tPt3, tCalc;
-			tPt3.zero(); tCalc.zero();
-			auto big = std::chrono::system_clock::now();
-			auto fin = std::chrono::system_clock::now();
-
-			for (int it(0); it < numFaces; ++it)
+			if (!upToDate)
 			{
-				for (int i(0); i < 3; i++)
-				{
-					vecTri[i] = Point3D(pts[triangles[it][i]][0], pts[triangles[it][i]][1],
-						modes(triangles[it][i], m_modeIdx));
-				}
-
-				big = std::chrono::system_clock::now();
-				maxDist = max(sqrt(pow(vecTri[1].x - vecTri[0].x, 2) + pow(vecTri[1].y - vecTri[0].y, 2)),
-					max(sqrt(pow(vecTri[2].x - vecTri[0].x, 2) + pow(vecTri[2].y - vecTri[0].y, 2)),
-						sqrt(pow(vecTri[1].x - vecTri[2].x, 2) + pow(vecTri[1].y - vecTri[2].y, 2))));
-				numPtSide = (int)ceil(maxDist * m_zoom) + 1;
-
-				for (int i(0); i < numPtSide; i++)
-				{
-					for (int j(0); j < (numPtSide - i); j++)
-					{
-						alpha = ((double)(i) / (double)(numPtSide - 1));
-						beta = ((double)(j) / (double)(numPtSide - 1));
-						pointToDraw = alpha * vecTri[1] + beta * vecTri[2] +
-							(1. - alpha - beta) * vecTri[0];
-						normAmp = max(1, (int)(256 * (pointToDraw.z / max(maxAmp, -minAmp) + 1.) / 2.) - 1);
-						p.MoveTo(data, (int)(m_zoom* pointToDraw.x + m_centerX), (int)(m_centerY - m_zoom * pointToDraw.y));
-						p.Red() = (*colorMap)[normAmp][0];
-						p.Green() = (*colorMap)[normAmp][1];
-						p.Blue() = (*colorMap)[normAmp][2];
-					}
-				}
+				vector<double> pixels;
+				rasterizeMesh(pts, triangles, amplitudes, m_zoom, m_centerX, m_centerY,
+					width, height, pixels, NULL);
+				image.bmp = wxBitmap(ColorScale::fieldToImage(pixels.data(), width, 
+					height, ColorScale::SYMMETRIC_COLOR_SCALE, 0., normAmp), 24);
 			}
 
 			// write informations about the mode
@@ -349,7 +382,7 @@ void PropModesPicture::draw(wxDC& dc)
       tbText.addCell("Cutoff freq (Hz)",
         seg->eigenFrequency(m_modeIdx));
 
-			dc.DrawBitmap(bmp, 0, 0, 0);
+			dc.DrawBitmap(image.bmp, 0, 0, 0);
 		}
 		break;
 
@@ -358,7 +391,7 @@ void PropModesPicture::draw(wxDC& dc)
     // ****************************************************************
 
 		case JUNCTION_MATRIX: {
-			vector<Matrix> F = seg->getMatrixF();
+			const vector<Matrix>& F = seg->getMatrixF();
 			int numCont(F.size());
 			int maxNumF(0);
 
@@ -371,52 +404,56 @@ void PropModesPicture::draw(wxDC& dc)
 			int widthSquare, numCols, numRows, normAmp;
 			double maxF, minF, normF;
 			ColorMap colorMap = ColorScale::getColorMap();
-			wxColor color;
-
 
-			// loop over junction matrices
+			// the signature contains the sizes and sums of the matrices
+			vector<double> signature;
 			for (int n(0); n < F.size(); n++)
 			{
-				numCols = F[n].cols();
-				numRows = F[n].rows();
-				// compute the width of the squares displaying the values of the matrix
-				widthSquare = (int)(widthFn / (double)numCols);
-
-				// search for the maximal and minimal values of the matrix
-				maxF = 0.; minF = 0.;
-				// loop over rows
-				for (int r(0); r < numRows; r++)
-				{
-					// loop over columns
-					for (int c(0); c < numCols; c++)
-					{
-						maxF = max(maxF, F[n](r, c));
-						minF = min(minF, F[n](r, c));
-					}
-				}
-				maxF = max(maxF, 1.);
-				minF = min(minF, -1.);
-				normF = 1. / (maxF - minF);
+				signature.push_back((double)F[n].rows());
+				signature.push_back((double)F[n].cols());
+				signature.push_back(F[n].sum());
+				signature.push_back(F[n].squaredNorm());
+			}
+
+			bool upToDate;
+			cachedImage& image = getCachedImage(JUNCTION_MATRIX, sectionIdx, -1,
+				width, height, signature, upToDate);
 
-				// loop over rows
-				for (int r(0); r < numRows; r++)
+			if (!upToDate)
+			{
+				image.bmp = wxBitmap(width, height, 24);
+				wxNativePixelData data(image.bmp);
+				fillRectangle(data, 0, 0, width, height, 255, 255, 255);
+
+				// loop over junction matrices
+				for (int n(0); n < F.size(); n++)
 				{
-					// loop over columns
-					for (int c(0); c < numCols; c++)
+					numCols = F[n].cols();
+					numRows = F[n].rows();
+					// compute the width of the squares displaying the values of the matrix
+					widthSquare = (int)(widthFn / (double)numCols);
+
+					// search for the maximal and minimal values of the matrix
+					maxF = max(F[n].maxCoeff(), 1.);
+					minF = min(F[n].minCoeff(), -1.);
+					normF = 1. / (maxF - minF);
+					// loop over rows
+					for (int r(0); r < numRows; r++)
 					{
-
-						normAmp = max(0, (int)(255. * normF * (F[n](r, c) - minF)));
-						color = wxColor((*colorMap)[normAmp][0], (*colorMap)[normAmp][1],
-							(*colorMap)[normAmp][2]);
-						dc.SetPen(color);
-						dc.SetBrush(color);
-						dc.DrawRectangle(margin + min(width, height) / maxNumF + c * widthSquare, 
-							topMargin + n* min(width, height) / maxNumF + r * widthSquare, 
-							widthSquare, widthSquare);
+						// loop over columns
+						for (int c(0); c < numCols; c++)
+						{
+							normAmp = max(0, (int)(255. * normF * (F[n](r, c) - minF)));
+							fillRectangle(data, margin + min(width, height) / maxNumF + c * widthSquare,
+								topMargin + n * min(width, height) / maxNumF + r * widthSquare,
+								widthSquare, widthSquare, (*colorMap)[normAmp][0], 
+								(*colorMap)[normAmp][1], (*colorMap)[normAmp][2]);
+						}
 					}
 				}
 			}
 
+			dc.DrawBitmap(image.bmp, 0, 0, 0);
 			}
 		break;
 
@@ -428,47 +465,14 @@ void PropModesPicture::draw(wxDC& dc)
 
       if (seg->Pout().rows() > 0)
       {
-        ColorMap colorMap = ColorScale::getColorMap();
         double maxAmp;
         double minAmp;
         // to avoid singular values when the field is displayed in dB
         double dbShift(0.5);
-        Point3D vecTri[3];
-        Point3D pointToDraw;
-        int numPtSide;
-        double alpha;
-        double beta;
-        double maxDist;
-        int normAmp;
-
-        m_field.resize(height, width);
-        m_field.setConstant(NAN);
-
-        int idxI, idxJ;
-
-        // initialise white bitmap
-        wxBitmap bmp(width, height, 24);
-        wxNativePixelData data(bmp);
-        wxNativePixelData::Iterator p(data);
-        for (int i = 0; i < height; ++i)
-        {
-          wxNativePixelData::Iterator rowStart = p;
-          for (int j = 0; j < width; ++j, ++p)
-          {
-            p.Red() = 254;
-            p.Green() = 254;
-            p.Blue() = 254;
-          }
-          p = rowStart;
-          p.OffsetY(data, 1);
-        }
 
-        int numFaces = seg->numberOfFaces();
-        int numVertex = seg->numberOfVertices();
-        vector<array<double, 2>> pts = seg->getPoints();
-        vector<array<int, 3>> triangles = seg->getTriangles();
-        Matrix modes = seg->getModes();
-        int mn(modes.cols());
+        const vector<array<double, 2>>& pts = seg->getPoints();
+        const vector<array<int, 3>>& triangles = seg->getTriangles();
+        const Matrix& modes = seg->getModes();
 
         Eigen::MatrixXcd modesAmpl;
         switch (m_simu3d->fieldPhysicalQuantity())
@@ -513,67 +517,39 @@ void PropModesPicture::draw(wxDC& dc)
           minAmp += M_PI;
         }
 
-        // draw the acoustic field
-        //
-        // The triangles are interpolated by adding the the fraction a and b 
-        // of the vector formed by two sides and the corresponding vertex amplitude.
-        // The corresponding values are attributed to the location of the nearest 
-        // pixel in the bitmap grid. 
-        // This avoid searching to which triangle a pixel belongs, which has a higher
-        // computational cost.
-        //
-        //
-        //   ^ P1
-        //   |
-        //   |   P?
-        //   |________\ P2
-        //  O         /
-        //
-        //  P = a*P1 + b*P2 + (1 - a - b)*O 
-        //  
-        //  with 0 <= a <= 1 and 0 <= b <= 1
-
-        for (int it(0); it < numFaces; ++it)
+        // rasterise the field only if it is not in the cache
+        bool fieldIndB(m_simu3d->fieldIndB());
+        double normAmp(max(maxAmp, abs(minAmp)));
+        bool upToDate;
+        cachedImage& image = getCachedImage(ACOUSTIC_FIELD, sectionIdx, -1,
+          width, height, { m_zoom, maxAmp, minAmp, (double)fieldIndB, 
+          (double)amplitudes.size(), amplitudes.sum(), amplitudes.squaredNorm() }, 
+          upToDate);
+
+        if (!upToDate)
         {
-          for (int i(0); i < 3; i++)
+          vector<double> pixels;
+          image.field.resize(height, width);
+          image.field.setConstant(NAN);
+          rasterizeMesh(pts, triangles, amplitudes, m_zoom, m_centerX, m_centerY,
+            width, height, pixels, &image.field);
+          if (fieldIndB)
           {
-            vecTri[i] = Point3D(pts[triangles[it][i]][0], pts[triangles[it][i]][1],
-              amplitudes(triangles[it][i]));
+            image.bmp = wxBitmap(ColorScale::fieldToImage(pixels.data(), width,
+              height, ColorScale::DB_COLOR_SCALE, minAmp - dbShift, normAmp), 24);
           }
-
-          maxDist = max(sqrt(pow(vecTri[1].x - vecTri[0].x, 2) + pow(vecTri[1].y - vecTri[0].y, 2)),
-            max(sqrt(pow(vecTri[2].x - vecTri[0].x, 2) + pow(vecTri[2].y - vecTri[0].y, 2)),
-              sqrt(pow(vecTri[1].x - vecTri[2].x, 2) + pow(vecTri[1].y - vecTri[2].y, 2))));
-          numPtSide = (int)ceil(maxDist * m_zoom) + 1;
-
-          for (int i(0); i < numPtSide; i++)
+          else
           {
-            for (int j(0); j < (numPtSide - i); j++)
-            {
-              alpha = ((double)(i) / (double)(numPtSide - 1));
-              beta = ((double)(j) / (double)(numPtSide - 1));
-              pointToDraw = alpha * vecTri[1] + beta * vecTri[2] +
-                (1. - alpha - beta) * vecTri[0];
-              idxI = min((int)(m_zoom * pointToDraw.x + m_centerX), width - 1);
-              idxJ = min((int)(m_centerY - m_zoom * pointToDraw.y), height - 1);
-              m_field(height - idxJ -1, idxI) = pointToDraw.z;
-              if (m_simu3d->fieldIndB())
-              {
-                pointToDraw.z = 20. * log10(pointToDraw.z) - minAmp + dbShift;
-              }
-              normAmp = min(255, max(1, (int)(256. * pointToDraw.z / max(maxAmp, abs(minAmp))) - 1));
-
-              p.MoveTo(data, idxI, idxJ);
-              p.Red() = (*colorMap)[normAmp][0];
-              p.Green() = (*colorMap)[normAmp][1];
-              p.Blue() = (*colorMap)[normAmp][2];
-            }
+            image.bmp = wxBitmap(ColorScale::fieldToImage(pixels.data(), width,
+              height, ColorScale::LINEAR_COLOR_SCALE, 0., normAmp), 24);
           }
         }
+        m_field = image.field;
+
         // write informations
         tbText.addCell("Frequency (Hz)", m_simu3d->lastFreqComputed());
 
-        dc.DrawBitmap(bmp, 0, 0, 0);
+        dc.DrawBitmap(image.bmp, 0, 0, 0);
         break;
       }
     }
@@ -674,7 +650,7 @@ double PropModesPicture::getScaling()
 void PropModesPicture::drawContour(int sectionIdx, vector<int> &surf, wxDC& dc)
 {
   CrossSection2d* seg = m_simu3d->crossSection(sectionIdx);
-  Polygon_2 contour = seg->contour();
+  const Polygon_2& contour = seg->contour();
   CGAL::Polygon_2<K>::Edge_const_iterator vit;
   int s, xBig, yBig, xEnd, yEnd;
   double scaling(getScaling());
@@ -730,6 +706,38 @@ void PropModesPicture::drawContour(int sectionIdx, vector<int> &surf, wxDC& dc)
   }
 }
 
+// ****************************************************************************
+/// Returns the cached image of an object. upToDate is false if the image 
+/// was not in the cache or if its signature changed, in which case the 
+/// image must be rasterised again. The cache is emptied when it contains 
+/// too many images.
+// ****************************************************************************
+
+PropModesPicture::cachedImage& PropModesPicture::getCachedImage(
+  enum objectToDisplay object, int segment, int mode, int width, int height, 
+  const vector<double>& signature, bool& upToDate)
+{
+  const int MAX_CACHED_IMAGES = 16;
+
+  auto key(make_tuple((int)object, segment, mode, width, height));
+  auto it(m_imageCache.find(key));
+  if ((it != m_imageCache.end()) && (it->second.signature == signature))
+  {
+    upToDate = true;
+    return it->second;
+  }
+
+  if ((it == m_imageCache.end()) && (m_imageCache.size() >= MAX_CACHED_IMAGES))
+  {
+    m_imageCache.clear();
+  }
+
+  cachedImage& image = m_imageCache[key];
+  image.signature = signature;
+  upToDate = false;
+  return image;
+}
+
 // ****************************************************************************
 
 void PropModesPicture::OnMouseEvent(wxMouseEvent& event)
@@ -757,7 +765,7 @@ void PropModesPicture::OnExportAcousticField(wxCommandEvent& event)
   ofs << regex_replace(txtField.str(), regex("-nan\\(ind\\)"), "nan");
   ofs.close();
 
-  ofstream log("log.txt", ofstream::app);
+  LogStream log;
   log << "Transverse acoustic field of segment " 
     << m_segPic->activeSegment() << " saved in file:" << endl;
   log << name.ToStdString() << endl;
@@ -785,7 +793,7 @@ void PropModesPicture::OnExportContour(wxCommandEvent& event)
     }
     ofs.close();
 
-    ofstream log("log.txt", ofstream::app);
+    LogStream log;
     log << "Contour of segment " 
       << m_segPic->activeSegment() << " saved in file:\n"
       << name.ToStdString() << endl;
@@ -26,6 +26,8 @@
 #include "VocalTractPicture.h"
 #include "SegmentsPicture.h"
 #include "Backend/Acoustic3dSimulation.h"
+#include <map>
+#include <tuple>
 
 
 // ****************************************************************************
@@ -86,6 +88,18 @@ private:
 
   Matrix m_field;
 
+  // Rasterised images of the modes, junction matrices and acoustic fields,
+  // indexed by object, segment, mode and size of the picture, so that a
+  // repaint only blits them. The signature gathers the values the image
+  // depends on, to detect when it must be rasterised again.
+  struct cachedImage
+  {
+    vector<double> signature;
+    wxBitmap bmp;
+    Matrix field;
+  };
+  map<tuple<int, int, int, int, int>, cachedImage> m_imageCache;
+
 	Acoustic3dSimulation* m_simu3d;
   SegmentsPicture* m_segPic;
 
@@ -97,6 +111,8 @@ private:
 
   double getScaling();
   void drawContour(int sectionIdx, vector<int>& surf, wxDC& dc);
+  cachedImage& getCachedImage(enum objectToDisplay object, int segment, int mode,
+    int width, int height, const vector<double>& signature, bool& upToDate);
 
   void OnMouseEvent(wxMouseEvent& event);
   void OnExportAcousticField(wxCommandEvent& event);
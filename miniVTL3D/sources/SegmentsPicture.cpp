@@ -25,6 +25,7 @@
 #include "Acoustic3dPage.h"
 #include "ColorScale.h"
 #include "ParamSimu3DDialog.h"
+#include "Backend/Profiler.h"
 
 #include <wx/rawbmp.h>
 
@@ -51,6 +52,37 @@ static const int IDM_EXPORT_ACOUSTIC_FIELD    = 1003;
 static const int IDM_DEFINE_NOISE_SRC_SEG     = 1004;
 static const int IDM_EXPORT_GEO_AS_CSV        = 1005;
 static const int IDM_EXPORT_SEGMENT_PIC       = 1006;
+// one item per segmentCostType, in the same order
+static const int IDM_SHOW_NO_COST             = 1007;
+static const int IDM_SHOW_MESH_SIZE_COST      = 1008;
+static const int IDM_SHOW_MODES_COST          = 1009;
+static const int IDM_SHOW_MODE_SOLVE_COST     = 1010;
+static const int IDM_SHOW_JUNCTIONS_COST      = 1011;
+static const int IDM_SHOW_PROPAGATION_COST    = 1012;
+
+// ****************************************************************************
+// Names and units of the costs of the segments, and value of a cost (the 
+// times are displayed in ms).
+// ****************************************************************************
+
+static const char* costNames[SegmentsPicture::NUM_COST_TYPES] = { "", "Mesh size",
+  "Number of modes", "Mode computation", "Junctions computation",
+  "Propagation per frequency" };
+static const char* costUnits[SegmentsPicture::NUM_COST_TYPES] = { "", "faces",
+  "modes", "ms", "ms", "ms" };
+
+static double costValue(const segmentCost& cost, SegmentsPicture::segmentCostType type)
+{
+  switch (type)
+  {
+  case SegmentsPicture::MESH_SIZE_COST: return (double)cost.meshFaces;
+  case SegmentsPicture::MODES_COST: return (double)cost.modes;
+  case SegmentsPicture::MODE_SOLVE_COST: return 1000. * cost.modeSolve;
+  case SegmentsPicture::JUNCTIONS_COST: return 1000. * cost.junctions;
+  case SegmentsPicture::PROPAGATION_COST: return 1000. * cost.propagation;
+  default: return 0.;
+  }
+}
 
 // ****************************************************************************
 // The event table.
@@ -65,6 +97,7 @@ EVT_MENU(IDM_EXPORT_ACOUSTIC_FIELD, SegmentsPicture::OnExportAcousticField)
 EVT_MENU(IDM_DEFINE_NOISE_SRC_SEG, SegmentsPicture::OnDefineNoiseSourceSeg)
 EVT_MENU(IDM_EXPORT_GEO_AS_CSV, SegmentsPicture::OnEXportGeoAsCsv)
 EVT_MENU(IDM_EXPORT_SEGMENT_PIC, SegmentsPicture::OnExportSegPic)
+EVT_MENU_RANGE(IDM_SHOW_NO_COST, IDM_SHOW_PROPAGATION_COST, SegmentsPicture::OnShowSegmentCost)
 END_EVENT_TABLE()
 
 // ****************************************************************************
@@ -79,6 +112,7 @@ SegmentsPicture::SegmentsPicture(wxWindow* parent, Acoustic3dSimulation* simu3d,
   m_showField(false),
   m_showTfPts(true),
   m_showSndSourceSeg(true),
+  m_costType(NO_COST),
   //m_interpolateField(true),
   m_oldWidth(0),
   m_oldHeight(0),
@@ -98,6 +132,14 @@ SegmentsPicture::SegmentsPicture(wxWindow* parent, Acoustic3dSimulation* simu3d,
   m_contextMenu->Append(IDM_EXPORT_GEO_AS_CSV, "Export geometry in a csv file");
   m_contextMenu->Append(IDM_EXPORT_SEGMENT_PIC, "Export segment picture");
 
+  wxMenu* costMenu = new wxMenu();
+  costMenu->AppendRadioItem(IDM_SHOW_NO_COST, "None");
+  for (int i(MESH_SIZE_COST); i < NUM_COST_TYPES; i++)
+  {
+    costMenu->AppendRadioItem(IDM_SHOW_NO_COST + i, costNames[i]);
+  }
+  m_contextMenu->AppendSubMenu(costMenu, "Colour the segments by their cost");
+
   getZoomAndBbox();
 }
 
@@ -148,10 +190,7 @@ void SegmentsPicture::draw(wxDC& dc)
       {
         if (m_simu3d->computeFieldImage())
         {
-          ColorMap colorMap = ColorScale::getColorMap();
-
           Matrix field;
-          int normAmp;
           m_maxAmp = m_simu3d->maxAmpField();
           m_minAmp = m_simu3d->minAmpField();
           double diffAmp(m_maxAmp);
@@ -177,7 +216,11 @@ void SegmentsPicture::draw(wxDC& dc)
           }
 
           m_simu3d->interpolateAcousticField(coordX, coordY, field);
-          if (m_simu3d->fieldIndB()) { field = 20. * field.array().log10() - m_minAmp + dbShift; }
+          // the amplitude is already returned in dB
+          if (m_simu3d->fieldIndB() && m_simu3d->showFieldAmplitude())
+          {
+            field.array() += dbShift - m_minAmp;
+          }
 
           // if the phase is displayed, ad pi so that only positive values are displayed
           if (!m_simu3d->showFieldAmplitude())
@@ -188,34 +231,12 @@ void SegmentsPicture::draw(wxDC& dc)
             diffAmp = m_maxAmp - m_minAmp;
           }
 
-          // initialise white bitmap
-          m_fieldImage = wxBitmap(m_width, m_height, 24);
-          wxNativePixelData data(m_fieldImage);
-          wxNativePixelData::Iterator p(data);
-          for (int i(0); i < m_height; ++i)
-          {
-            wxNativePixelData::Iterator rowStart = p;
-            for (int j(0); j < m_width; ++j, ++p)
-            {
-              if (field(i, j) > 0.)
-              {
-                normAmp = max(1, (int)(256. * field(i, j) / diffAmp));
-
-                p.Red() = (*colorMap)[normAmp][0];
-                p.Green() = (*colorMap)[normAmp][1];
-                p.Blue() = (*colorMap)[normAmp][2];
-              }
-              else
-              {
-                p.Red() = 254;
-                p.Green() = 254;
-                p.Blue() = 254;
-              }
-
-            }
-            p = rowStart;
-            p.OffsetY(data, 1);
-          }
+          // the points outside of the field are white, and the image
+          // is converted from the pixels stored row by row
+          Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
+            pixels((field.array() > 0.).select(field.array(), NAN));
+          m_fieldImage = wxBitmap(ColorScale::fieldToImage(pixels.data(),
+            m_width, m_height, ColorScale::LINEAR_COLOR_SCALE, 0., diffAmp), 24);
 
           m_simu3d->setFieldImageComputation(false);
         }
@@ -316,6 +337,8 @@ void SegmentsPicture::draw(wxDC& dc)
 
     if (m_showSegments)
     {
+      // the outlines are drawn over the colours of the costs
+      if (m_costType != NO_COST) { drawSegmentCosts(dc); }
 
       auto sec = m_simu3d->crossSection(0);
       auto bbox = sec->contour().bbox();
@@ -637,6 +660,104 @@ void SegmentsPicture::drawSegment(CrossSection2d *sec, CGAL::Bbox_2& bbox, wxDC&
 
 // ****************************************************************************
 
+void SegmentsPicture::fillSegment(CrossSection2d* sec, CGAL::Bbox_2& bbox, wxDC& dc)
+{
+  Point ptInMin, ptInMax, ptOutMin, ptOutMax;
+
+  getSegmentPts(sec, bbox, ptInMin, ptInMax, ptOutMin, ptOutMax);
+
+  wxPoint corners[4] = {
+    wxPoint(getPixelCoordX(ptInMin.x()), getPixelCoordY(ptInMin.y())),
+    wxPoint(getPixelCoordX(ptInMax.x()), getPixelCoordY(ptInMax.y())),
+    wxPoint(getPixelCoordX(ptOutMax.x()), getPixelCoordY(ptOutMax.y())),
+    wxPoint(getPixelCoordX(ptOutMin.x()), getPixelCoordY(ptOutMin.y())) };
+  dc.SetPen(*wxTRANSPARENT_PEN);
+  dc.DrawPolygon(4, corners);
+}
+
+// ****************************************************************************
+// Colour the segments by their cost relative to the most costly segment, 
+// draw the colorbar of the costs (unless the one of the acoustic field is 
+// displayed) and write the costs of the active segment at the top.
+// ****************************************************************************
+
+void SegmentsPicture::drawSegmentCosts(wxDC& dc)
+{
+  vector<segmentCost> costs(m_simu3d->segmentCosts());
+  int numSeg(costs.size());
+  if (numSeg == 0) { return; }
+
+  double maxValue(0.);
+  for (int i(0); i < numSeg; i++) { maxValue = max(maxValue, costValue(costs[i], m_costType)); }
+
+  ColorMap colorMap = ColorScale::getColorMap();
+  CrossSection2d* sec;
+  CGAL::Bbox_2 bbox;
+  int idxColor;
+
+  for (int i(0); i < numSeg; i++)
+  {
+    sec = m_simu3d->crossSection(i);
+    bbox = sec->contour().bbox();
+    idxColor = (maxValue > 0.) ? 
+      max(1, min(255, (int)(255. * costValue(costs[i], m_costType) / maxValue))) : 1;
+    dc.SetBrush(wxBrush(wxColor((*colorMap)[idxColor][0], (*colorMap)[idxColor][1],
+      (*colorMap)[idxColor][2])));
+    fillSegment(sec, bbox, dc);
+  }
+  dc.SetBrush(*wxTRANSPARENT_BRUSH);
+
+  ostringstream ost;
+  wxCoord w, h;
+  dc.SetBackgroundMode(wxTRANSPARENT);
+  dc.SetFont(wxFont(9, wxFONTFAMILY_DEFAULT, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_NORMAL));
+
+  // ****************************************************************
+  // draw the colorbar
+  // ****************************************************************
+
+  if (!m_showField || (m_simu3d->acousticFieldSize() == 0))
+  {
+    int yBig(m_height - 14);
+    for (int i(15); i < m_height - 14; ++i)
+    {
+      idxColor = max(1, 255 * (i - 15) / (m_height - 30));
+      dc.SetPen(wxPen(wxColor((*colorMap)[idxColor][0], (*colorMap)[idxColor][1],
+        (*colorMap)[idxColor][2]), 1));
+      yBig--;
+      dc.DrawLine(0, yBig, 15, yBig);
+    }
+
+    double graduations[5] = { 0., 0.25, 0.5, 0.75, 1. };
+    ost << setprecision((m_costType >= MODE_SOLVE_COST) ? 1 : 0) << fixed;
+    for (int i(0); i < 5; i++)
+    {
+      ost << "-  " << graduations[i] * maxValue << " " << costUnits[m_costType];
+      dc.GetTextExtent(ost.str(), &w, &h);
+      dc.DrawText(ost.str(), 13, (1. - graduations[i]) * (m_height - 30) + 14 - h / 2);
+      ost.str("");
+    }
+  }
+
+  // ****************************************************************
+  // costs of the active segment
+  // ****************************************************************
+
+  const segmentCost& active(costs[min(m_activeSegment, numSeg - 1)]);
+  ost << "Segment " << m_activeSegment << ": " << active.meshFaces << " faces, "
+    << active.modes << " modes";
+  if (Profiler::getInstance().isEnabled())
+  {
+    ost << setprecision(1) << fixed << ", mode solve " << 1000. * active.modeSolve 
+      << " ms, junctions " << 1000. * active.junctions << " ms, propagation "
+      << 1000. * active.propagation << " ms per frequency";
+  }
+  dc.SetTextForeground(*wxBLACK);
+  dc.DrawText(ost.str(), m_widthColorbar, 0);
+}
+
+// ****************************************************************************
+
 void SegmentsPicture::OnUpdateBbox(wxCommandEvent& event)
 {
   m_simu3d->updateBoundingBox();
@@ -696,7 +817,7 @@ void SegmentsPicture::OnExportAcousticField(wxCommandEvent& event)
 
 void SegmentsPicture::OnDefineNoiseSourceSeg(wxCommandEvent& event)
 {
-  ofstream log("log.txt", ofstream::app);
+  LogStream log;
   m_simu3d->setIdxSecNoiseSource(m_activeSegment);
   log << "Segment " << m_activeSegment << " defined as active segment" << endl;
   log.close();
@@ -712,12 +833,16 @@ void SegmentsPicture::OnEXportGeoAsCsv(wxCommandEvent& event)
 {
   wxFileName fileName;
   wxString name = wxFileSelector("Save acoustic field", fileName.GetPath(),
-    fileName.GetFullName(), ".csv", "(*.csv)|*.csv",
+    fileName.GetFullName(), ".csv", "(*.csv)|*.csv|Binary geometry (*.vtg)|*.vtg",
     wxFD_SAVE | wxFD_OVERWRITE_PROMPT, this);
 
-  ofstream log("log.txt", ofstream::app);
+  LogStream log;
 
-  if (m_simu3d->exportGeoInCsv(name.ToStdString()))
+  // the binary format is chosen from the extension of the file
+  bool exported(name.Lower().EndsWith(".vtg") ? 
+    m_simu3d->exportGeoInBinary(name.ToStdString()) :
+    m_simu3d->exportGeoInCsv(name.ToStdString()));
+  if (exported)
   {
     log << "Geometry exported to file:\n" << name.ToStdString() << endl;
   }
@@ -738,7 +863,7 @@ void SegmentsPicture::OnExportSegPic(wxCommandEvent& event)
   Point ptInMin, ptInMax, ptOutMin, ptOutMax;
 
   ofstream of(name.ToStdString());
-  ofstream log("log.txt", ofstream::app);
+  LogStream log;
 
   if (of.is_open())
   {
@@ -770,3 +895,16 @@ void SegmentsPicture::OnExportSegPic(wxCommandEvent& event)
   of.close();
   log.close();
 }
+
+// ****************************************************************************
+// The times of the costs are only measured when the profiler is enabled: 
+// they are displayed after the next computation of the modes and of the 
+// acoustic field or of the transfer functions.
+// ****************************************************************************
+
+void SegmentsPicture::OnShowSegmentCost(wxCommandEvent& event)
+{
+  m_costType = (segmentCostType)(event.GetId() - IDM_SHOW_NO_COST);
+  Profiler::getInstance().setEnabled(m_costType >= MODE_SOLVE_COST);
+  Refresh();
+}
@@ -33,6 +33,18 @@ class SegmentsPicture : public BasicPicture
 
 public:
 
+  // cost by which the segments are coloured (see segmentCost)
+  enum segmentCostType
+  {
+    NO_COST,
+    MESH_SIZE_COST,
+    MODES_COST,
+    MODE_SOLVE_COST,
+    JUNCTIONS_COST,
+    PROPAGATION_COST,
+    NUM_COST_TYPES
+  };
+
   SegmentsPicture(wxWindow* parent, Acoustic3dSimulation* simu3d, wxWindow* updateEventReceiver);
 
   virtual void draw(wxDC& dc);
@@ -51,6 +63,7 @@ public:
   bool showSegements() const { return m_showSegments; }
   bool showField() const { return m_showField; }
   bool showTfPts() const { return m_showTfPts; }
+  segmentCostType costType() const { return m_costType; }
 
 // **************************************************************************
 // Private data.
@@ -71,6 +84,7 @@ private:
   bool m_showTfPts;
   bool m_showSndSourceSeg;
   int m_idxPtTf;
+  segmentCostType m_costType;
 
   int m_width;
   int m_height;
@@ -107,6 +121,8 @@ private:
   void drawSegment(CrossSection2d *sec, CGAL::Bbox_2 &bbox, wxDC& dc);
   void getSegmentPts(CrossSection2d* sec, CGAL::Bbox_2& bbox,
     Point& ptInMin, Point& ptInMax, Point& ptOutMin, Point& ptOutMax);
+  void fillSegment(CrossSection2d* sec, CGAL::Bbox_2& bbox, wxDC& dc);
+  void drawSegmentCosts(wxDC& dc);
 
   void OnUpdateBbox(wxCommandEvent& event);
   void OnDefineBboxLowerCorner(wxCommandEvent& event);
@@ -115,6 +131,7 @@ private:
   void OnDefineNoiseSourceSeg(wxCommandEvent& event);
   void OnEXportGeoAsCsv(wxCommandEvent& event);
   void OnExportSegPic(wxCommandEvent& event);
+  void OnShowSegmentCost(wxCommandEvent& event);
 
  // ****************************************************************************
  // Declare the event table right at the end
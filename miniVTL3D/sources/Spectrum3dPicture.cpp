@@ -49,7 +49,8 @@ END_EVENT_TABLE()
 
 Spectrum3dPicture::Spectrum3dPicture(wxWindow *parent, 
     Acoustic3dSimulation *simu3d): BasicPicture(parent),
-  m_idxPtTf(0)
+  m_idxPtTf(0),
+  m_previewFreqStep(0.)
 {
   // ****************************************************************
   // Init the variables
@@ -136,19 +137,40 @@ void Spectrum3dPicture::paintSpectrum(wxDC &dc)
   {
     drawTf(dc, INPUT_IMPED);
   }
+
+  if (m_showGlottalTf && !m_previewMagnitudes.empty())
+  {
+    dc.SetPen(wxPen(*wxLIGHT_GREY, lineWidth, wxPENSTYLE_SHORT_DASH));
+    m_previewCurve.paint(dc, graph, m_previewMagnitudes, 0., 
+      m_previewFreqStep, true);
+  }
 }
 
 // ****************************************************************************
 // ****************************************************************************
 
-void Spectrum3dPicture::drawTf(wxDC& dc, enum tfType type)
+void Spectrum3dPicture::setPreviewTf(const vector<double>& magnitudes, 
+  double freqStep)
 {
-  int graphX, graphY, graphW, graphH, y, lastY;
-  double val;
+  m_previewMagnitudes = magnitudes;
+  m_previewFreqStep = freqStep;
+  m_previewCurve.invalidate();
+}
 
-  graph.getDimensions(graphX, graphY, graphW, graphH);
-  lastY = graphY;
+// ****************************************************************************
+// ****************************************************************************
 
+void Spectrum3dPicture::clearPreviewTf()
+{
+  m_previewMagnitudes.clear();
+  m_previewCurve.invalidate();
+}
+
+// ****************************************************************************
+// ****************************************************************************
+
+void Spectrum3dPicture::drawTf(wxDC& dc, enum tfType type)
+{
   switch (type)
   {
   case GLOTTAL:
@@ -162,39 +184,12 @@ void Spectrum3dPicture::drawTf(wxDC& dc, enum tfType type)
     break;
   }
 
-  // create the frequency vector
-  vector<double> freqs;
-  freqs.reserve(graphW);
-  for (int i(0); i < graphW; i++)
-  {
-    freqs.push_back(graph.getAbsXValue(graphX + i));
-  }
-
-  // interpolate the transfer function
-  vector<complex<double>> interpolatedTF;
-  simu3d->interpolateTransferFunction(freqs, m_idxPtTf, type, interpolatedTF);
-
-  // draw the transfer function curve
-  for (int i(0); i < graphW; i++)
-  {
-    val = abs(interpolatedTF[i]);
-    y = graph.getYPos(val);
-
-    if (y < graphY)
-    {
-      y = graphY;
-    }
-    if (y >= graphY + graphH)
-    {
-      y = graphY + graphH - 1;
-    }
-
-    if (isnan(val)) { y = NAN; }
-
-    dc.DrawLine(graphX + i - 1, lastY, graphX + i, y);
-
-    lastY = y;
-  }
+  // the curve is only decimated again when the transfer function, the 
+  // point or the zoom changed
+  vector<double> magnitudes;
+  double freqStep;
+  simu3d->transferFunctionMagnitudes(m_idxPtTf, type, magnitudes, freqStep);
+  m_tfCurves[type].paint(dc, graph, magnitudes, 0., freqStep, true);
 }
 
 // ****************************************************************************
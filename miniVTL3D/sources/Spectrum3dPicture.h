@@ -47,6 +47,11 @@ public:
   void setShowNoiseTf(bool show) { m_showNoiseTf = show; }
   void setShowInputImped(bool show) { m_showInputImped = show; }
   void setIdxTfPoint(int idx) { m_idxPtTf = idx; }
+  // glottal transfer function of a preview (magnitudes with the frequency 
+  // step freqStep) drawn as a dashed line until it is cleared
+  void setPreviewTf(const vector<double>& magnitudes, double freqStep);
+  void clearPreviewTf();
+  bool hasPreviewTf() const { return !m_previewMagnitudes.empty(); }
 
   // accessors
   bool showGlottalTf() const { return m_showGlottalTf; }
@@ -73,6 +78,12 @@ private:
   int m_lastMousePosY;
 
   int m_idxPtTf;
+  // decimated curves of the glottal and noise transfer functions and of the
+  // input impedance
+  DecimatedCurve m_tfCurves[3];
+  vector<double> m_previewMagnitudes;
+  double m_previewFreqStep;
+  DecimatedCurve m_previewCurve;
 
   // **************************************************************************
   // Private functions.
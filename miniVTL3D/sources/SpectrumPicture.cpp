@@ -188,7 +188,7 @@ void SpectrumPicture::draw(wxDC &dc)
 
   if (showModelSpectrum)
   {
-    TlModel *tlModel = data->tlModel;
+    TlModel *tlModel = data->getTlModel();
 
     // ****************************************************************
     // Vocal tract transfer function.
@@ -454,7 +454,7 @@ void SpectrumPicture::draw(wxDC &dc)
 
     if (modelSpectrumType == SPECTRUM_PU) 
     { 
-      TlModel *tlModel = data->tlModel;
+      TlModel *tlModel = data->getTlModel();
       tlModel->getSpectrum(TlModel::RADIATION, &radiationSpectrum, SPECTRUM_LENGTH, 0);
       poleZeroSpectrum*= radiationSpectrum; 
       poleZeroSpectrum*= 10.0;
@@ -500,11 +500,8 @@ void SpectrumPicture::paintContinualSpectrum(wxDC &dc, ComplexSignal *spectrum,
   double freq;
   int h0, h1;
   double d0, d1;
-  double d;
   int numHarmonics = spectrum->N/2 - 1;
   double F0 = (double)SAMPLING_RATE / (double)spectrum->N;
-  int y;
-  int lastY;
   wxPen magnitudePen(color, LINE_WIDTH);
   wxPen phasePen(wxColor(0, 0, 255), LINE_WIDTH);
 
@@ -516,40 +513,16 @@ void SpectrumPicture::paintContinualSpectrum(wxDC &dc, ComplexSignal *spectrum,
 
   if (showMagnitude)
   {
-    dc.SetPen(magnitudePen);
-
-    for (i=0; i < graphW; i++)
+    // The harmonics are linearly interpolated, or reduced to their minimum
+    // and maximum in the pixel columns which contain several of them.
+    vector<double> magnitudes(max(numHarmonics, 0));
+    for (i=0; i < numHarmonics; i++)
     {
-      freq = graph.getAbsXValue(graphX + i);
-      h0 = (int)(freq / F0);
-      h1 = h0 + 1;
-
-      // Linear interpolation between the two harmonics
-      if ((h0 >= 0) && (h1 < numHarmonics))
-      {
-        d0 = spectrum->getMagnitude(h0);
-        d1 = spectrum->getMagnitude(h1);
-        d = d0 + ((d1 - d0)*(freq - h0*F0)) / F0;
-
-        y = graph.getYPos(d*ampFactor);
-
-        if (y < graphY) 
-        { 
-          y = graphY; 
-        }
-        if (y >= graphY + graphH) 
-        { 
-          y = graphY + graphH - 1; 
-        }
-
-        if (i > 0) 
-        { 
-          dc.DrawLine(graphX+i-1, lastY, graphX+i, y); 
-        }
-
-        lastY = y;
-      }
+      magnitudes[i] = spectrum->getMagnitude(i)*ampFactor;
     }
+
+    dc.SetPen(magnitudePen);
+    magnitudeCurves[spectrum].paint(dc, graph, magnitudes, 0.0, F0);
   }
 
   // ****************************************************************
@@ -745,7 +718,7 @@ void SpectrumPicture::OnLeftButtonDown(wxMouseEvent &event)
 
 void SpectrumPicture::OnRightButtonDown(wxMouseEvent &event)
 {
-  TlModel *model = Data::getInstance()->tlModel;
+  TlModel *model = Data::getInstance()->getTlModel();
 
   const int MAX_FORMANTS = 10;
   double formantFreq[MAX_FORMANTS];
@@ -26,6 +26,7 @@
 #include "VocalTractPicture.h"
 #include "Graph.h"
 #include "Backend/Signal.h"
+#include <map>
 
 // ****************************************************************************
 // ****************************************************************************
@@ -116,6 +117,8 @@ private:
   wxString spectrumFileName;
   VocalTractPicture *picVocalTract;
   int lineWidth{ this->FromDIP(1) };
+  // Decimated magnitude curves of the continual spectra
+  std::map<const ComplexSignal*, DecimatedCurve> magnitudeCurves;
 
   // **************************************************************************
   // Private functions.
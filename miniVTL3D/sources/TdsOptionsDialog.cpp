@@ -142,7 +142,8 @@ void TdsOptionsDialog::initWidgets()
   const wxString SOLVER_CHOICES[NUM_SOLVER_CHOICES] =
   {
     "Gauss-Seidel SOR",
-    "Cholesky factorization"
+    "Cholesky factorization",
+    "Cholesky factorization (skyline)"
   };
 
   radSolverOptions = new wxRadioBox(this, IDR_SOLVER_OPTIONS, "Numeric solver options",
@@ -266,7 +267,7 @@ void TdsOptionsDialog::OnSolverOptions(wxCommandEvent &event)
 
 void TdsOptionsDialog::OnAdaptFromFds(wxCommandEvent &event)
 {
-  TlModel *tlModel = Data::getInstance()->tlModel;
+  TlModel *tlModel = Data::getInstance()->getTlModel();
 
   model->options.turbulenceLosses = tlModel->options.staticPressureDrops;
   model->options.softWalls        = tlModel->options.softWalls;
@@ -45,6 +45,8 @@ public:
 
 public:
   static TdsOptionsDialog *getInstance();
+  // True when the dialog was already created (by getInstance()).
+  static bool hasInstance() { return instance != NULL; }
 
   // **************************************************************************
   // Private data.
@@ -21,9 +21,11 @@
 
 #include "VocalTractPicture.h"
 #include "Data.h"
+#include "GuiTimings.h"
 
 #include <cmath>
 #include <fstream>
+#include <algorithm>
 #include <string>
 #include <wx/image.h>
 #include <wx/tipwin.h>
@@ -118,6 +120,19 @@ VocalTractPicture::VocalTractPicture(wxWindow *parent, VocalTract *vocalTract,
   selectedControlPoint = -1;
   showEmaPoints = false;
 
+  // Vertex arrays (they are filled at the first rendering)
+
+  solidArraysVersion = -1;
+  solidArraysBothSides = renderBothSides;
+  wireArraysVersion = -1;
+  wireArraysBothSides = renderBothSides;
+  isInteracting = false;
+  lodArraysVersion = -1;
+  lodArraysBothSides = renderBothSides;
+  for (int i = 0; i < 16; i++)
+  {
+    sortedModelViewMatrix[i] = 0.0;
+  }
 }
 
 
@@ -237,6 +252,7 @@ void VocalTractPicture::drawTestImage()
 
 void VocalTractPicture::display()
 {
+  GuiTimer timer("VocalTractPicture::display");
   const double INVALID = VocalTract::INVALID_PROFILE_SAMPLE;
   int i;
 
@@ -2463,7 +2479,6 @@ void VocalTractPicture::setLights()
 
 void VocalTractPicture::renderSolid()
 {
-  Point3D *V, *N;
   Point3D P, Q;
   int i, k;
 
@@ -2500,44 +2515,11 @@ void VocalTractPicture::renderSolid()
   GLfloat coverMaterialDiffuse[]   = { 0.8f, 0.8f, 0.8f, transCover };
   GLfloat coverMaterialAmbient[]   = { 0.5f, 0.5f, 0.5f, 1.0f };
 
-  // ****************************************************************
-  // Render the tongue two-sided without transparency
-  // ****************************************************************
-
-  Surface *tongue = &tract->surface[VocalTract::TONGUE];
-
-  glMaterialfv(GL_FRONT, GL_AMBIENT, frontTongueMaterialDiffuse);
-  glMaterialfv(GL_FRONT, GL_DIFFUSE, frontTongueMaterialDiffuse);
-
-  glMaterialfv(GL_BACK, GL_AMBIENT, backTongueMaterialDiffuse);
-  glMaterialfv(GL_BACK, GL_DIFFUSE, backTongueMaterialDiffuse);
-  
-  glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, tongueMaterialSpecular);
-  glMaterialfv(GL_FRONT_AND_BACK, GL_SHININESS, tongueMaterialShininess);
-
-  glDisable(GL_BLEND);
-  glDepthMask(GL_TRUE);    // z-buffer is read and write
-
-  tongue->calculateNormals();
-
-  glBegin(GL_TRIANGLES);
-  for (i=0; i < tongue->numTriangles; i++)
-  {
-    for (k=0; k < 3; k++)
-    {
-      N = &tongue->triangle[i].cornerNormal[k];
-      V = &tongue->vertex[ tongue->triangle[i].vertex[k] ].coord;
-      glNormal3d(N->x, N->y, N->z);
-      glVertex3d(V->x, V->y, V->z);
-    }
-  }
-  glEnd();
-
   // ****************************************************************
   // Create an array with all transparent surfaces.
   // ****************************************************************
 
-  const int NUM_TRANSPARENT_SURFACES = 10;
+  const int NUM_TRANSPARENT_SURFACES = NUM_SOLID_SURFACES - 1;
   enum { 
     UPPER_TEETH = 0, LOWER_TEETH = 1, UPPER_LIP = 2, LOWER_LIP = 3, 
     UPPER_COVER = 4, LOWER_COVER = 5, LEFT_COVER = 6, RIGHT_COVER = 7,
@@ -2573,176 +2555,326 @@ void VocalTractPicture::renderSolid()
     transSurface[UVULA]       = &tract->surface[VocalTract::UVULA];
   }
 
+  Surface *tongue = &tract->surface[VocalTract::TONGUE];
+
   // ****************************************************************
-  // Calculate the order of the triangles within each surface and the 
-  // plane normals.
+  // The normals and the vertex arrays only need to be calculated 
+  // again when the surfaces of the model changed. During an 
+  // interaction, the decimated arrays are used.
   // ****************************************************************
 
-  for (i=0; i < NUM_TRANSPARENT_SURFACES; i++)
+  bool lowDetail = isInteracting;
+  SurfaceArrays *arrays = lowDetail ? lodArrays : solidArrays;
+
+  bool surfacesChanged = lowDetail ?
+    ((lodArraysVersion != tract->surfaceVersion) || (lodArraysBothSides != renderBothSides)) :
+    ((solidArraysVersion != tract->surfaceVersion) || (solidArraysBothSides != renderBothSides));
+
+  if (surfacesChanged)
   {
-    if (transSurface[i] != NULL)
+    tongue->calculateNormals();
+    for (i=0; i < NUM_TRANSPARENT_SURFACES; i++)
     {
-      transSurface[i]->calculateNormals();
-      transSurface[i]->calculatePaintSequence(modelViewMatrix);
+      if (transSurface[i] != NULL) { transSurface[i]->calculateNormals(); }
     }
-  }
 
-  // ****************************************************************
-  // Some plane normals must be adjusted in order to avoid sharp 
-  // edges.
-  // ****************************************************************
-
-  // Normals at the interface between the upper and lower cover *****
+    // **************************************************************
+    // Some plane normals must be adjusted in order to avoid sharp 
+    // edges.
+    // **************************************************************
 
-  int numRibs = VocalTract::NUM_LARYNX_RIBS + VocalTract::NUM_PHARYNX_RIBS;
-  Surface *upperCover = transSurface[UPPER_COVER];
-  Surface *lowerCover = transSurface[LOWER_COVER];
+    // Normals at the interface between the upper and lower cover ***
 
-  for (i=0; i < numRibs; i++)
-  {
-    P = upperCover->getNormal(i, 0) + lowerCover->getNormal(i, 0);
-    P.normalize();
-    upperCover->setNormal(i, 0, P);
-    lowerCover->setNormal(i, 0, P);
+    int numRibs = VocalTract::NUM_LARYNX_RIBS + VocalTract::NUM_PHARYNX_RIBS;
+    Surface *upperCover = transSurface[UPPER_COVER];
+    Surface *lowerCover = transSurface[LOWER_COVER];
 
-    if (renderBothSides) 
-    { 
-      P = upperCover->getNormal(i, upperCover->numRibPoints-1) + 
-          lowerCover->getNormal(i, lowerCover->numRibPoints-1);
+    for (i=0; i < numRibs; i++)
+    {
+      P = upperCover->getNormal(i, 0) + lowerCover->getNormal(i, 0);
       P.normalize();
-      upperCover->setNormal(i, upperCover->numRibPoints-1, P); 
-      lowerCover->setNormal(i, lowerCover->numRibPoints-1, P);
+      upperCover->setNormal(i, 0, P);
+      lowerCover->setNormal(i, 0, P);
+
+      if (renderBothSides) 
+      { 
+        P = upperCover->getNormal(i, upperCover->numRibPoints-1) + 
+            lowerCover->getNormal(i, lowerCover->numRibPoints-1);
+        P.normalize();
+        upperCover->setNormal(i, upperCover->numRibPoints-1, P); 
+        lowerCover->setNormal(i, lowerCover->numRibPoints-1, P);
+      }
     }
-  }
 
-  // Normals at the edge of the filling surfaces ********************
+    // Normals at the edge of the filling surfaces ******************
 
-  Surface *leftCover = transSurface[LEFT_COVER];
-  Surface *rightCover = transSurface[RIGHT_COVER];
+    Surface *leftCover = transSurface[LEFT_COVER];
+    Surface *rightCover = transSurface[RIGHT_COVER];
 
-  int firstRib = VocalTract::NUM_LARYNX_RIBS + VocalTract::NUM_PHARYNX_RIBS - 1;
-  int lastRib  = VocalTract::NUM_LARYNX_RIBS + VocalTract::NUM_PHARYNX_RIBS + VocalTract::NUM_VELUM_RIBS-1;
+    int firstRib = VocalTract::NUM_LARYNX_RIBS + VocalTract::NUM_PHARYNX_RIBS - 1;
+    int lastRib  = VocalTract::NUM_LARYNX_RIBS + VocalTract::NUM_PHARYNX_RIBS + VocalTract::NUM_VELUM_RIBS-1;
 
-  if (leftCover != NULL)
-  {
-    P = upperCover->getNormal(firstRib, 0);
-    for (i=firstRib; i <= lastRib; i++) { upperCover->setNormal(i, 0, P); }
-    leftCover->setNormal(0, 0, P);
-    leftCover->setNormal(0, 1, P);
-    leftCover->setNormal(0, 2, P);
-    leftCover->setNormal(0, 3, P);
+    if (leftCover != NULL)
+    {
+      P = upperCover->getNormal(firstRib, 0);
+      for (i=firstRib; i <= lastRib; i++) { upperCover->setNormal(i, 0, P); }
+      leftCover->setNormal(0, 0, P);
+      leftCover->setNormal(0, 1, P);
+      leftCover->setNormal(0, 2, P);
+      leftCover->setNormal(0, 3, P);
     
-    leftCover->setNormal(1, 0, P);
-    leftCover->setNormal(1, 1, P);
+      leftCover->setNormal(1, 0, P);
+      leftCover->setNormal(1, 1, P);
 
-    P = lowerCover->getNormal(VocalTract::NUM_LARYNX_RIBS + VocalTract::NUM_THROAT_RIBS, 0);
-    leftCover->setNormal(1, 2, P);
-    leftCover->setNormal(1, 3, P);
-  }
+      P = lowerCover->getNormal(VocalTract::NUM_LARYNX_RIBS + VocalTract::NUM_THROAT_RIBS, 0);
+      leftCover->setNormal(1, 2, P);
+      leftCover->setNormal(1, 3, P);
+    }
 
-  if (rightCover != NULL)
-  {
-    P = upperCover->getNormal(firstRib, upperCover->numRibPoints-1);
-    for (i=firstRib; i <= lastRib; i++) { upperCover->setNormal(i, upperCover->numRibPoints-1, P); }
-    rightCover->setNormal(0, 0, P);
-    rightCover->setNormal(0, 1, P);
-    rightCover->setNormal(0, 2, P);
-    rightCover->setNormal(0, 3, P);
+    if (rightCover != NULL)
+    {
+      P = upperCover->getNormal(firstRib, upperCover->numRibPoints-1);
+      for (i=firstRib; i <= lastRib; i++) { upperCover->setNormal(i, upperCover->numRibPoints-1, P); }
+      rightCover->setNormal(0, 0, P);
+      rightCover->setNormal(0, 1, P);
+      rightCover->setNormal(0, 2, P);
+      rightCover->setNormal(0, 3, P);
     
-    rightCover->setNormal(1, 0, P);
-    rightCover->setNormal(1, 1, P);
+      rightCover->setNormal(1, 0, P);
+      rightCover->setNormal(1, 1, P);
 
-    P = lowerCover->getNormal(VocalTract::NUM_LARYNX_RIBS + VocalTract::NUM_THROAT_RIBS, lowerCover->numRibPoints-1);
-    rightCover->setNormal(1, 2, P);
-    rightCover->setNormal(1, 3, P);
-  }
+      P = lowerCover->getNormal(VocalTract::NUM_LARYNX_RIBS + VocalTract::NUM_THROAT_RIBS, lowerCover->numRibPoints-1);
+      rightCover->setNormal(1, 2, P);
+      rightCover->setNormal(1, 3, P);
+    }
   
-  // Beginning and end of the uvula ribs ****************************
+    // Beginning and end of the uvula ribs **************************
 
-  if ((renderBothSides) && (transSurface[UVULA] != NULL))
-  {
-    Surface *s = transSurface[UVULA];
-    for (i=0; i < s->numRibs; i++)
+    if ((renderBothSides) && (transSurface[UVULA] != NULL))
     {
-      P = s->getNormal(i, 0) + s->getNormal(i, s->numRibPoints-1);
-      P.normalize();
-      s->setNormal(i, 0, P);
-      s->setNormal(i, s->numRibPoints-1, P);
+      Surface *s = transSurface[UVULA];
+      for (i=0; i < s->numRibs; i++)
+      {
+        P = s->getNormal(i, 0) + s->getNormal(i, s->numRibPoints-1);
+        P.normalize();
+        s->setNormal(i, 0, P);
+        s->setNormal(i, s->numRibPoints-1, P);
+      }
     }
-  }
 
-  // Beginning and end of the epiglottis ribs ***********************
+    // Beginning and end of the epiglottis ribs *********************
 
-  if ((renderBothSides) && (transSurface[EPIGLOTTIS] != NULL))
-  {
-    Surface *s = transSurface[EPIGLOTTIS];
-    for (i=0; i < s->numRibs; i++)
+    if ((renderBothSides) && (transSurface[EPIGLOTTIS] != NULL))
     {
-      P = s->getNormal(i, 0) + s->getNormal(i, s->numRibPoints-1);
-      P.normalize();
-      s->setNormal(i, 0, P);
-      s->setNormal(i, s->numRibPoints-1, P);
+      Surface *s = transSurface[EPIGLOTTIS];
+      for (i=0; i < s->numRibs; i++)
+      {
+        P = s->getNormal(i, 0) + s->getNormal(i, s->numRibPoints-1);
+        P.normalize();
+        s->setNormal(i, 0, P);
+        s->setNormal(i, s->numRibPoints-1, P);
+      }
+    }
+
+    // Copy the triangles into the vertex arrays ********************
+
+    if (lowDetail == false)
+    {
+      copyTriangles(tongue, solidArrays[0]);
+      for (i=0; i < NUM_TRANSPARENT_SURFACES; i++)
+      {
+        copyTriangles(transSurface[i], solidArrays[i + 1]);
+      }
+
+      solidArraysVersion = tract->surfaceVersion;
+      solidArraysBothSides = renderBothSides;
+    }
+    else
+    {
+      // The lips and the filling surfaces are small and some of their
+      // triangles are not drawn, so they are copied in full detail.
+
+      copyDecimatedTriangles(tongue, lodArrays[0]);
+      lodBatches.clear();
+      int lipTriangles = (transSurface[UPPER_LIP]->numRibPoints-1)*2;
+
+      for (k=0; k < NUM_TRANSPARENT_SURFACES; k++)
+      {
+        Surface *s = transSurface[k];
+        bool fullDetail = ((k == UPPER_LIP) || (k == LOWER_LIP) || 
+          (k == LEFT_COVER) || (k == RIGHT_COVER));
+
+        if (fullDetail) 
+        { 
+          copyTriangles(s, lodArrays[k + 1]); 
+        }
+        else 
+        { 
+          copyDecimatedTriangles(s, lodArrays[k + 1]); 
+        }
+        if (s == NULL) { continue; }
+
+        lodBatches.push_back(TriangleBatch());
+        lodBatches.back().surface = k;
+        int numTriangles = (int)(lodArrays[k + 1].coord.size() / 9);
+
+        for (i=0; i < numTriangles; i++)
+        {
+          if (((k == RIGHT_COVER) && (i > 5)) ||
+              ((k == LEFT_COVER) && (i > 5))) { continue; }
+
+          if (((k == UPPER_LIP) && ((i % lipTriangles) < 2)) ||
+              ((k == LOWER_LIP) && ((i % lipTriangles) < 2))) { continue; }
+
+          lodBatches.back().index.push_back((GLuint)(3*i + 0));
+          lodBatches.back().index.push_back((GLuint)(3*i + 1));
+          lodBatches.back().index.push_back((GLuint)(3*i + 2));
+        }
+      }
+
+      lodArraysVersion = tract->surfaceVersion;
+      lodArraysBothSides = renderBothSides;
     }
   }
 
+  glEnableClientState(GL_VERTEX_ARRAY);
+  glEnableClientState(GL_NORMAL_ARRAY);
+
   // ****************************************************************
-  // Draw the transparent surfaces using merge sort for the 
-  // individually sorted surfaces.
+  // Render the tongue two-sided without transparency
   // ****************************************************************
 
-  int nextIndex[NUM_TRANSPARENT_SURFACES] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
-  int numTriangles[NUM_TRANSPARENT_SURFACES] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
-  int winningSurface;
-  double z, minZ;
-  Surface *s;
-  bool drawTriangle;
+  glMaterialfv(GL_FRONT, GL_AMBIENT, frontTongueMaterialDiffuse);
+  glMaterialfv(GL_FRONT, GL_DIFFUSE, frontTongueMaterialDiffuse);
+
+  glMaterialfv(GL_BACK, GL_AMBIENT, backTongueMaterialDiffuse);
+  glMaterialfv(GL_BACK, GL_DIFFUSE, backTongueMaterialDiffuse);
+  
+  glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, tongueMaterialSpecular);
+  glMaterialfv(GL_FRONT_AND_BACK, GL_SHININESS, tongueMaterialShininess);
 
-  for (i=0; i < NUM_TRANSPARENT_SURFACES; i++)
+  glDisable(GL_BLEND);
+  glDepthMask(GL_TRUE);    // z-buffer is read and write
+
+  if (arrays[0].coord.size() > 0)
   {
-    if (transSurface[i] != NULL) { numTriangles[i] = transSurface[i]->numTriangles; }
+    glVertexPointer(3, GL_FLOAT, 0, arrays[0].coord.data());
+    glNormalPointer(GL_FLOAT, 0, arrays[0].normal.data());
+    glDrawArrays(GL_TRIANGLES, 0, (GLsizei)(arrays[0].coord.size() / 3));
   }
 
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);  // Blending function
-  glEnable(GL_BLEND);                                 // Enable blending
-  glDepthMask(GL_FALSE);                              // z-buffer is read-only
-
-  // Main loop ******************************************************
+  // ****************************************************************
+  // Sort the transparent triangles of all surfaces from back to front 
+  // and group the consecutive triangles of the same surface into
+  // batches. This is only needed when the view or the surfaces changed,
+  // and not during an interaction.
+  // ****************************************************************
 
-  while ((nextIndex[0] < numTriangles[0]) || (nextIndex[1] < numTriangles[1]) ||
-         (nextIndex[2] < numTriangles[2]) || (nextIndex[3] < numTriangles[3]) ||
-		     (nextIndex[4] < numTriangles[4]) || (nextIndex[5] < numTriangles[5]) ||
-         (nextIndex[6] < numTriangles[6]) || (nextIndex[7] < numTriangles[7]) ||
-         (nextIndex[8] < numTriangles[8]) || (nextIndex[9] < numTriangles[9]))
+  bool viewChanged = false;
+  for (i=0; i < 16; i++)
   {
-    // Choose, from which surface to draw the next triangle **********
+    if (sortedModelViewMatrix[i] != modelViewMatrix[i]) { viewChanged = true; }
+  }
 
-    winningSurface = -1;
-    minZ = 100000000.0;
+  if ((lowDetail == false) && ((surfacesChanged) || (viewChanged)))
+  {
+    struct SortedTriangle { double distance; int surface; int triangle; };
+    vector<SortedTriangle> sorted;
+    int lipTriangles = (transSurface[UPPER_LIP]->numRibPoints-1)*2;
+    bool drawTriangle;
 
-    for (i=0; i < NUM_TRANSPARENT_SURFACES; i++)
+    for (k=0; k < NUM_TRANSPARENT_SURFACES; k++)
     {
-      if ((transSurface[i] != NULL) && (nextIndex[i] < numTriangles[i]))
+      Surface *s = transSurface[k];
+      if (s == NULL) { continue; }
+      s->calculateDistances(modelViewMatrix);
+
+      for (i=0; i < s->numTriangles; i++)
       {
-        z = transSurface[i]->triangle[ transSurface[i]->sequence[nextIndex[i]] ].distance;
-        if (z < minZ)
-        {
-		      winningSurface = i;
-          minZ = z;
+        // Some triangles of the filling surfaces shall not be drawn
+
+        drawTriangle = true;
+        if (((k == RIGHT_COVER) && (i > 5)) ||
+            ((k == LEFT_COVER) && (i > 5))) { drawTriangle = false; }
+
+        if (((k == UPPER_LIP) && ((i % lipTriangles) < 2)) ||
+            ((k == LOWER_LIP) && ((i % lipTriangles) < 2))) { drawTriangle = false; }
+
+        if (drawTriangle) 
+        { 
+          sorted.push_back({ s->triangle[i].distance, k, i }); 
         }
       }
     }
 
-    // Draw the triangle from the choosen surface *******************
+    // The triangle with the smallest z-value is painted first. For the 
+    // same z-value, the surface with the smaller index comes first.
+    sort(sorted.begin(), sorted.end(), 
+      [](const SortedTriangle &a, const SortedTriangle &b)
+      {
+        return (a.distance < b.distance) || 
+          ((a.distance == b.distance) && (a.surface < b.surface));
+      });
+
+    transparentBatches.clear();
+    for (i=0; i < (int)sorted.size(); i++)
+    {
+      if ((transparentBatches.empty()) || (transparentBatches.back().surface != sorted[i].surface))
+      {
+        transparentBatches.push_back(TriangleBatch());
+        transparentBatches.back().surface = sorted[i].surface;
+      }
+      for (k=0; k < 3; k++)
+      {
+        transparentBatches.back().index.push_back((GLuint)(3*sorted[i].triangle + k));
+      }
+    }
+
+    for (i=0; i < 16; i++)
+    {
+      sortedModelViewMatrix[i] = modelViewMatrix[i];
+    }
+  }
+
+  // ****************************************************************
+  // Draw the transparent surfaces batch by batch.
+  // ****************************************************************
+
+  int lastMaterial = -1;
+  int material;
+  enum { COVER_MATERIAL, TEETH_MATERIAL, LIP_MATERIAL };
+
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);  // Blending function
+  glEnable(GL_BLEND);                                 // Enable blending
+  glDepthMask(GL_FALSE);                              // z-buffer is read-only
+
+  vector<TriangleBatch> &batches = lowDetail ? lodBatches : transparentBatches;
+
+  for (i=0; i < (int)batches.size(); i++)
+  {
+    TriangleBatch &batch = batches[i];
+    int surface = batch.surface;
+
+	  // Set the material of the surface ******************************
 
-    if ((winningSurface != -1) && (transSurface[winningSurface] != NULL))
+    if ((surface == UPPER_TEETH) || (surface == LOWER_TEETH))
+    {
+      material = TEETH_MATERIAL;
+    }
+    else
+    if ((surface == UPPER_LIP) || (surface == LOWER_LIP))
+    {
+      material = LIP_MATERIAL;
+    }
+    else
+    {
+      material = COVER_MATERIAL;
+    }
+
+    if (material != lastMaterial)
     {
-      s = transSurface[winningSurface];
-      i = s->sequence[ nextIndex[winningSurface] ];
-		
 	    // Cover ******************************************************
-	    if ((winningSurface == UPPER_COVER) || (winningSurface == LOWER_COVER) ||
-		      (winningSurface == LEFT_COVER)  || (winningSurface == RIGHT_COVER) ||
-		      (winningSurface == EPIGLOTTIS)  || (winningSurface == UVULA))
+      if (material == COVER_MATERIAL)
 	    {
 		    glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, coverMaterialAmbient);
 		    glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, coverMaterialDiffuse);
@@ -2751,7 +2883,7 @@ void VocalTractPicture::renderSolid()
 	    }
 
 	    // Teeth ******************************************************
-	    if ((winningSurface == UPPER_TEETH) || (winningSurface == LOWER_TEETH))
+      if (material == TEETH_MATERIAL)
 	    {
 		    glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, teethMaterialAmbient);
 		    glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, teethMaterialDiffuse);
@@ -2760,7 +2892,7 @@ void VocalTractPicture::renderSolid()
 	    }
 
 	    // Lips *******************************************************
-	    if ((winningSurface == UPPER_LIP) || (winningSurface == LOWER_LIP))
+      if (material == LIP_MATERIAL)
 	    {
 		    glMaterialfv(GL_FRONT, GL_AMBIENT, frontLipMaterialDiffuse);
 		    glMaterialfv(GL_FRONT, GL_DIFFUSE, frontLipMaterialDiffuse);
@@ -2771,36 +2903,138 @@ void VocalTractPicture::renderSolid()
 		    glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, lipMaterialSpecular);
 		    glMaterialfv(GL_FRONT_AND_BACK, GL_SHININESS, lipMaterialShininess);
 	    }
+      lastMaterial = material;
+    }
+
+    glVertexPointer(3, GL_FLOAT, 0, arrays[surface + 1].coord.data());
+    glNormalPointer(GL_FLOAT, 0, arrays[surface + 1].normal.data());
+    glDrawElements(GL_TRIANGLES, (GLsizei)batch.index.size(), GL_UNSIGNED_INT, 
+      batch.index.data());
+  }
+
+  glDisableClientState(GL_NORMAL_ARRAY);
+  glDisableClientState(GL_VERTEX_ARRAY);
+
+  glDepthMask(GL_TRUE);   // z-buffer is read and write enabled
+}
 
-      // Some triangles of the filling surfaces shall not be drawn
 
-      drawTriangle = true;
-      if (((winningSurface == RIGHT_COVER) && (i > 5)) ||
-          ((winningSurface == LEFT_COVER) && (i > 5))) { drawTriangle = false; }
+// ****************************************************************************
+/// Copies the corners and corner normals of the triangles of the surface 
+/// into the vertex arrays (three vertices per triangle). The arrays are 
+/// emptied for a NULL surface.
+// ****************************************************************************
+
+void VocalTractPicture::copyTriangles(::Surface *s, SurfaceArrays &arrays)
+{
+  int i, k;
+  Point3D *V, *N;
+
+  arrays.coord.clear();
+  arrays.normal.clear();
+  if (s == NULL) 
+  { 
+    return; 
+  }
 
-      k = (transSurface[UPPER_LIP]->numRibPoints-1)*2;
-      if (((winningSurface == UPPER_LIP) && ((i % k) < 2)) ||
-          ((winningSurface == LOWER_LIP) && ((i % k) < 2))) { drawTriangle = false; }
+  arrays.coord.reserve(9 * s->numTriangles);
+  arrays.normal.reserve(9 * s->numTriangles);
 
-      if (drawTriangle)
+  for (i=0; i < s->numTriangles; i++)
+  {
+    for (k=0; k < 3; k++)
+    {
+      N = &s->triangle[i].cornerNormal[k];
+      V = &s->vertex[ s->triangle[i].vertex[k] ].coord;
+      arrays.normal.push_back((GLfloat)N->x);
+      arrays.normal.push_back((GLfloat)N->y);
+      arrays.normal.push_back((GLfloat)N->z);
+      arrays.coord.push_back((GLfloat)V->x);
+      arrays.coord.push_back((GLfloat)V->y);
+      arrays.coord.push_back((GLfloat)V->z);
+    }
+  }
+}
+
+
+// ****************************************************************************
+/// Copies the triangles of the surface decimated to every other rib and rib 
+/// point (the last rib and rib point are always kept) into the vertex arrays,
+/// with the averaged vertex normals. The orientation of the triangles of the
+/// surface is kept. The arrays are emptied for a NULL surface.
+// ****************************************************************************
+
+void VocalTractPicture::copyDecimatedTriangles(::Surface *s, SurfaceArrays &arrays)
+{
+  const int STEP = 2;
+  int i, j, k;
+
+  arrays.coord.clear();
+  arrays.normal.clear();
+  if ((s == NULL) || (s->numTriangles < 2))
+  { 
+    return; 
+  }
+
+  vector<int> ribs;
+  vector<int> ribPoints;
+  for (i=0; i < s->numRibs - 1; i+= STEP) { ribs.push_back(i); }
+  ribs.push_back(s->numRibs - 1);
+  for (j=0; j < s->numRibPoints - 1; j+= STEP) { ribPoints.push_back(j); }
+  ribPoints.push_back(s->numRibPoints - 1);
+
+  // The corners of the first triangle are swapped when the orientation of
+  // the surface was swapped.
+  bool swapped = (s->triangle[0].vertex[0] != s->getVertexIndex(0, 0));
+
+  int numQuads = (int)((ribs.size() - 1)*(ribPoints.size() - 1));
+  arrays.coord.reserve(18 * numQuads);
+  arrays.normal.reserve(18 * numQuads);
+
+  auto addVertex = [&](int rib, int ribPoint)
+  {
+    Point3D V = s->getVertex(rib, ribPoint);
+    Point3D N = s->getNormal(rib, ribPoint);
+    arrays.normal.push_back((GLfloat)N.x);
+    arrays.normal.push_back((GLfloat)N.y);
+    arrays.normal.push_back((GLfloat)N.z);
+    arrays.coord.push_back((GLfloat)V.x);
+    arrays.coord.push_back((GLfloat)V.y);
+    arrays.coord.push_back((GLfloat)V.z);
+  };
+
+  // Same triangulation of the quads as in Surface::init().
+  for (i=0; i < (int)ribs.size() - 1; i++)
+  {
+    for (j=0; j < (int)ribPoints.size() - 1; j++)
+    {
+      int r0 = ribs[i];
+      int r1 = ribs[i + 1];
+      int p0 = ribPoints[j];
+      int p1 = ribPoints[j + 1];
+      int corner[2][3][2] =
+      {
+        { { r0, p0 }, { r1, p1 }, { r0, p1 } },
+        { { r0, p0 }, { r1, p0 }, { r1, p1 } }
+      };
+
+      for (k=0; k < 2; k++)
       {
-        glBegin(GL_TRIANGLES);
-        for (k=0; k < 3; k++)
+        if (swapped)
         {
-          N = &s->triangle[i].cornerNormal[k];
-          V = &s->vertex[ s->triangle[i].vertex[k] ].coord;
-          glNormal3d(N->x, N->y, N->z);
-          glVertex3d(V->x, V->y, V->z);
+          addVertex(corner[k][2][0], corner[k][2][1]);
+          addVertex(corner[k][1][0], corner[k][1][1]);
+          addVertex(corner[k][0][0], corner[k][0][1]);
+        }
+        else
+        {
+          addVertex(corner[k][0][0], corner[k][0][1]);
+          addVertex(corner[k][1][0], corner[k][1][1]);
+          addVertex(corner[k][2][0], corner[k][2][1]);
         }
-        glEnd();
       }
-
-      nextIndex[winningSurface]++;
     }
-
   }
-
-  glDepthMask(GL_TRUE);   // z-buffer is read and write enabled
 }
 
 
@@ -3186,7 +3420,7 @@ void VocalTractPicture::render2D()
 
 void VocalTractPicture::renderWireFrame()
 {
-  const int NUM_SURFACES = 9;
+  const int NUM_SURFACES = NUM_WIRE_SURFACES;
   int i, k, n;
   Surface *surface[NUM_SURFACES];
   Surface *s;
@@ -3261,13 +3495,39 @@ void VocalTractPicture::renderWireFrame()
   glFogf(GL_FOG_START, (GLfloat)(-zMax - 0.0*(zMax - zMin)));
   glFogf(GL_FOG_END,   (GLfloat)(-zMin + 0.5*(zMax - zMin)));
 
+  // ****************************************************************
+  // Copy the vertices into the vertex arrays when the surfaces 
+  // changed. The vertices of a rib are consecutive in the arrays.
+  // ****************************************************************
+
+  if ((wireArraysVersion != tract->surfaceVersion) || (wireArraysBothSides != renderBothSides))
+  {
+    for (n=0; n < NUM_SURFACES; n++)
+    {
+      s = surface[n];
+      wireArrays[n].coord.resize(3 * s->numVertices);
+      for (i=0; i < s->numVertices; i++)
+      {
+        wireArrays[n].coord[3*i + 0] = (GLfloat)s->vertex[i].coord.x;
+        wireArrays[n].coord[3*i + 1] = (GLfloat)s->vertex[i].coord.y;
+        wireArrays[n].coord[3*i + 2] = (GLfloat)s->vertex[i].coord.z;
+      }
+    }
+    wireArraysVersion = tract->surfaceVersion;
+    wireArraysBothSides = renderBothSides;
+  }
+
   // ****************************************************************
   // The 3D-vocal tract model.
   // ****************************************************************
 
+  vector<GLuint> crossLine;
+  glEnableClientState(GL_VERTEX_ARRAY);
+
   for (n=0; n < NUM_SURFACES; n++)
   {
     s = surface[n];
+    glVertexPointer(3, GL_FLOAT, 0, wireArrays[n].coord.data());
 
     // Determine the grid color. ************************************
 
@@ -3298,27 +3558,22 @@ void VocalTractPicture::renderWireFrame()
 
     for (i=0; i < s->numRibs; i++)
     {
-      glBegin(GL_LINE_STRIP);
-      for (k=0; k < s->numRibPoints; k++)
-      {
-        P = s->getVertex(i, k);
-        glVertex3d(P.x, P.y, P.z);
-      }
-      glEnd();
+      glDrawArrays(GL_LINE_STRIP, s->getVertexIndex(i, 0), s->numRibPoints);
     }
 
+    crossLine.resize(s->numRibs);
     for (i=0; i < s->numRibPoints; i++)
     {
-      glBegin(GL_LINE_STRIP);
       for (k=0; k < s->numRibs; k++)
       {
-        P = s->getVertex(k, i);
-        glVertex3d(P.x, P.y, P.z);
+        crossLine[k] = (GLuint)s->getVertexIndex(k, i);
       }
-      glEnd();
+      glDrawElements(GL_LINE_STRIP, s->numRibs, GL_UNSIGNED_INT, crossLine.data());
     }
   }
 
+  glDisableClientState(GL_VERTEX_ARRAY);
+
   // ****************************************************************
   // Paint the radiation semi-sphere.
   // ****************************************************************
@@ -3658,6 +3913,8 @@ void VocalTractPicture::OnMouseChanged(wxMouseEvent &event)
 
     if (event.LeftIsDown())
     {
+      isInteracting = true;
+
       if (selectedControlPoint != -1)
       {
 #ifdef __linux__
@@ -3734,6 +3991,8 @@ void VocalTractPicture::OnMouseChanged(wxMouseEvent &event)
 
     if (event.RightIsDown())
     {
+      isInteracting = true;
+
       if ((poster != NULL) && (showPoster) && (posterEditing))
       {
         posterScalingFactor+= (my - lastMy)*0.004;          
@@ -3763,6 +4022,17 @@ void VocalTractPicture::OnMouseChanged(wxMouseEvent &event)
 
   }
 
+  // ****************************************************************
+  // The buttons were released after an interaction -> render the 
+  // model in full detail again.
+  // ****************************************************************
+
+  if ((isInteracting) && (event.LeftIsDown() == false) && (event.RightIsDown() == false))
+  {
+    isInteracting = false;
+    this->Refresh();
+  }
+
   lastMx = mx;
   lastMy = my;
 }
@@ -25,6 +25,7 @@
 #include <GL/glu.h>
 #include <fstream>
 #include <sstream>
+#include <vector>
 #include "Backend/VocalTract.h"
 
 #ifndef __VOCALTRACT_PICTURE_H__
@@ -173,6 +174,45 @@ private:
   double modelViewMatrix[16];
   double inverseModelViewMatrix[16];
 
+  // Vertex arrays of the rendered surfaces *************************
+
+  // The coordinates and normals of the triangles of a surface (three
+  // vertices per triangle), copied only when the surfaces change.
+  struct SurfaceArrays
+  {
+    std::vector<GLfloat> coord;
+    std::vector<GLfloat> normal;
+  };
+
+  // A sequence of transparent triangles of the same surface, that are
+  // drawn with a single call.
+  struct TriangleBatch
+  {
+    int surface;
+    std::vector<GLuint> index;
+  };
+
+  static const int NUM_SOLID_SURFACES = 11;   // Tongue + transparent surfaces
+  static const int NUM_WIRE_SURFACES = 9;
+
+  SurfaceArrays solidArrays[NUM_SOLID_SURFACES];
+  SurfaceArrays wireArrays[NUM_WIRE_SURFACES];
+  std::vector<TriangleBatch> transparentBatches;
+  int solidArraysVersion;       // surfaceVersion of the tract for the arrays
+  bool solidArraysBothSides;
+
+  // While the model is dragged or turned with the mouse, the solid model is 
+  // rendered with decimated surfaces and without sorting the transparent
+  // triangles (one batch per surface).
+  bool isInteracting;
+  SurfaceArrays lodArrays[NUM_SOLID_SURFACES];
+  std::vector<TriangleBatch> lodBatches;
+  int lodArraysVersion;
+  bool lodArraysBothSides;
+  int wireArraysVersion;
+  bool wireArraysBothSides;
+  double sortedModelViewMatrix[16];   // Matrix of the batches
+
   // **************************************************************************
   // Private functions.
   // **************************************************************************
@@ -183,6 +223,8 @@ private:
   void renderSolid();
   void render2D();
   void renderWireFrame();
+  void copyTriangles(::Surface *s, SurfaceArrays &arrays);
+  void copyDecimatedTriangles(::Surface *s, SurfaceArrays &arrays);
   wxString getToolTipText(int controlPointIndex);
   int getControlPointUnderMouse(int mx, int my);
   int getEmaPointUnderMouse(int mx, int my);
@@ -45,6 +45,12 @@ static const int IDB_RENAME             = 4103;
 static const int IDB_SELECT             = 4104;
 static const int IDB_MOVE_UP            = 4105;
 static const int IDB_MOVE_DOWN          = 4106;
+static const int IDC_REAL_TIME_SYNTHESIS = 4107;
+static const int IDT_REAL_TIME_TIMER    = 4108;
+
+// Interval (ms) between two updates of the parameters of the real-time 
+// synthesis.
+static const int REAL_TIME_UPDATE_INTERVAL_MS = 10;
 
 // ****************************************************************************
 // The event table.
@@ -60,12 +66,16 @@ BEGIN_EVENT_TABLE(VocalTractShapesDialog, wxDialog)
   EVT_BUTTON(IDB_MOVE_DOWN, VocalTractShapesDialog::OnMoveItemDown)
   EVT_LISTBOX(IDL_SHAPES, VocalTractShapesDialog::OnItemSelected)
   EVT_LISTBOX_DCLICK(IDL_SHAPES, VocalTractShapesDialog::OnItemActivated)
+  EVT_CHECKBOX(IDC_REAL_TIME_SYNTHESIS, VocalTractShapesDialog::OnRealTimeSynthesis)
+  EVT_TIMER(IDT_REAL_TIME_TIMER, VocalTractShapesDialog::OnRealTimeTimer)
 
   EVT_CLOSE(VocalTractShapesDialog::OnClose)
 END_EVENT_TABLE()
 
 // The single instance of this class.
 VocalTractShapesDialog *VocalTractShapesDialog::instance = NULL;
+wxWindow *VocalTractShapesDialog::updateRequestReceiver1 = NULL;
+wxWindow *VocalTractShapesDialog::updateRequestReceiver2 = NULL;
 
 
 // ****************************************************************************
@@ -127,7 +137,7 @@ void VocalTractShapesDialog::fillShapeList()
 
 // ****************************************************************************
 /// Set the windows that receive an update request message when a vocal tract
-/// parameter was changed.
+/// parameter was changed. This can be called before the dialog is created.
 // ****************************************************************************
 
 void VocalTractShapesDialog::setUpdateRequestReceiver(wxWindow *receiver1, wxWindow* receiver2)
@@ -143,7 +153,9 @@ void VocalTractShapesDialog::setUpdateRequestReceiver(wxWindow *receiver1, wxWin
 VocalTractShapesDialog::VocalTractShapesDialog(wxWindow *parent) : 
   wxDialog(parent, wxID_ANY, wxString("Vocal tract shapes"), 
     wxDefaultPosition, wxDefaultSize, 
-    wxDEFAULT_DIALOG_STYLE | wxFRAME_FLOAT_ON_PARENT | wxRESIZE_BORDER)
+    wxDEFAULT_DIALOG_STYLE | wxFRAME_FLOAT_ON_PARENT | wxRESIZE_BORDER),
+  realTimeTimer(this, IDT_REAL_TIME_TIMER),
+  realTimeGlottis(NULL)
 {
   this->Move(50, 0);
   // Enable automatic scroll bars when screen is to small for dialog size.
@@ -155,8 +167,6 @@ VocalTractShapesDialog::VocalTractShapesDialog(wxWindow *parent) :
 
   data = Data::getInstance();
   tract = data->vocalTract;
-  updateRequestReceiver1 = NULL;
-  updateRequestReceiver2 = NULL;
 
   // ****************************************************************
   // Init and update the widgets.
@@ -286,6 +296,12 @@ void VocalTractShapesDialog::initWidgets()
   bottomSizer->Add(button, 0, wxALL, 3);
 
   topLevelSizer->Add(bottomSizer, 0, wxGROW);
+
+  chkRealTimeSynthesis = new wxCheckBox(scrolledWindow, IDC_REAL_TIME_SYNTHESIS, 
+    "Real-time synthesis");
+  chkRealTimeSynthesis->SetToolTip(
+    "Synthesize the current shape continuously while it is being changed.");
+  topLevelSizer->Add(chkRealTimeSynthesis, 0, wxALL, 3);
   topLevelSizer->AddSpacer(10);
 
   // ****************************************************************
@@ -404,6 +420,13 @@ void VocalTractShapesDialog::updateVocalTract()
     simu3d->setContourInterpolationMethod(AREA);
   }
 
+  // the transfer functions of the shape are interpolated in the library of
+  // 3D transfer functions if one is loaded, so that it can be played at once
+  if (!data->tfLibrary3d.entries.empty())
+  {
+    data->setTransferFunctionsFromLibrary(simu3d, tract);
+  }
+
   // Refresh the pictures of the parent window.
   if (updateRequestReceiver1 != NULL)
   {
@@ -739,8 +762,61 @@ void VocalTractShapesDialog::OnListKeyDown(wxKeyEvent &event)
 
 void VocalTractShapesDialog::OnClose(wxCloseEvent &event)
 {
+  stopRealTimeSynthesis();
   event.Skip();
 }
 
 // ****************************************************************************
+/// Starts or stops the real-time synthesis with the selected glottis model.
+// ****************************************************************************
+
+void VocalTractShapesDialog::OnRealTimeSynthesis(wxCommandEvent &event)
+{
+  if (chkRealTimeSynthesis->GetValue())
+  {
+    realTimeGlottis = data->glottis[data->getSelectedGlottisIndex()];
+    if (realTimeSynthesizer.start(tract, realTimeGlottis, data->tdsModel))
+    {
+      realTimeTimer.Start(REAL_TIME_UPDATE_INTERVAL_MS);
+    }
+    else
+    {
+      chkRealTimeSynthesis->SetValue(false);
+      wxMessageBox("Playing failed.", "Attention!");
+    }
+  }
+  else
+  {
+    stopRealTimeSynthesis();
+  }
+}
+
+// ****************************************************************************
+/// Passes the current parameters to the real-time synthesis. The synthesis 
+/// stops by itself when another sound is played.
+// ****************************************************************************
+
+void VocalTractShapesDialog::OnRealTimeTimer(wxTimerEvent &event)
+{
+  if (realTimeSynthesizer.isRunning())
+  {
+    realTimeSynthesizer.setParams(tract, realTimeGlottis);
+  }
+  else
+  {
+    stopRealTimeSynthesis();
+  }
+}
+
+// ****************************************************************************
+// ****************************************************************************
+
+void VocalTractShapesDialog::stopRealTimeSynthesis()
+{
+  realTimeTimer.Stop();
+  realTimeSynthesizer.stop();
+  chkRealTimeSynthesis->SetValue(false);
+}
+
+// ****************************************************************************
 
@@ -24,8 +24,10 @@
 
 #include <wx/wx.h>
 #include <wx/dialog.h>
+#include <wx/timer.h>
 
 #include "Data.h"
+#include "Backend/RealTimeSynthesizer.h"
 
 // ****************************************************************************
 /// This dialog lets the user select, edit and add vocal tract configurations
@@ -46,9 +48,11 @@ public:
 
 public:
   static VocalTractShapesDialog *getInstance(wxWindow *parent = NULL);
+  // True when the dialog was already created (by getInstance()).
+  static bool hasInstance() { return instance != NULL; }
   void updateWidgets();
   void fillShapeList();
-  void setUpdateRequestReceiver(wxWindow* receiver1, wxWindow* receiver2);
+  static void setUpdateRequestReceiver(wxWindow* receiver1, wxWindow* receiver2);
 
   // **************************************************************************
   // Private data.
@@ -59,11 +63,20 @@ private:
 
   Data *data;
   VocalTract *tract;
-  wxWindow *updateRequestReceiver1;
-  wxWindow* updateRequestReceiver2;
+  // Static, so that they can be set before the dialog is created.
+  static wxWindow *updateRequestReceiver1;
+  static wxWindow* updateRequestReceiver2;
 
   wxListBox *lstShapes;
   wxTextCtrl *txtValue[VocalTract::NUM_PARAMS];
+  wxCheckBox *chkRealTimeSynthesis;
+
+  // Real-time synthesis of the current vocal tract shape, whose parameters
+  // are passed on each tick of the timer (so that the changes made in any
+  // window are heard).
+  RealTimeSynthesizer realTimeSynthesizer;
+  wxTimer realTimeTimer;
+  Glottis *realTimeGlottis;
 
   // **************************************************************************
   // Private functions.
@@ -92,6 +105,10 @@ private:
   void OnItemActivated(wxCommandEvent &event);
   void OnListKeyDown(wxKeyEvent &event);
 
+  void OnRealTimeSynthesis(wxCommandEvent &event);
+  void OnRealTimeTimer(wxTimerEvent &event);
+  void stopRealTimeSynthesis();
+
   void OnClose(wxCloseEvent &event);
 
   // **************************************************************************